@@ -0,0 +1,137 @@
+# Copyright 2019 The MLIR Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Autotuning of the loop transformations applied to EDSC-built kernels.
+
+A kernel is described by a function building it into a fresh MLIRModule.  For
+each combination of the tile sizes, unroll factors and vector sizes to try, the
+kernel is built, transformed by the corresponding passes, JIT-compiled and
+timed on the given arrays, all within the process:
+
+  def build(module):
+    with module.function_context("kernel", [memrefType] * 3, []) as fun:
+      ...
+
+  result = autotune.tune(build, "kernel", [A, B, C],
+                         tile_sizes=[16, 32, 64], unroll_factors=[1, 4])
+  print(result.best, result.seconds)
+
+The arrays are passed to the kernel without copy, see `MLIRModule.invoke`, and
+are overwritten by each run.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+import itertools
+import timeit
+
+import google_mlir.bindings.python.pybind as E
+
+# The parameters of a variant of a kernel.  A None parameter disables the
+# corresponding transformation.
+Config = collections.namedtuple("Config",
+                                ["tile_size", "unroll_factor", "vector_size"])
+
+# The outcome of `tune`: the fastest configuration and its best run time in
+# seconds, and the best time of each configuration, or None for those that
+# failed to compile.
+Result = collections.namedtuple("Result", ["best", "seconds", "timings"])
+
+
+def get_passes(config):
+  """Returns the passes and the pass options implementing `config`."""
+  passes = []
+  options = []
+  if config.tile_size is not None:
+    passes.append("loop-tile")
+    options.append("-tile-size=%d" % config.tile_size)
+  if config.vector_size is not None:
+    passes.append("vectorize")
+    options += [
+        "-virtual-vector-size=%d" % config.vector_size,
+        "-test-fastest-varying=0"
+    ]
+  if config.unroll_factor is not None:
+    passes.append("loop-unroll")
+    options.append("-unroll-factor=%d" % config.unroll_factor)
+  if passes:
+    passes.append("canonicalize")
+  return passes, options
+
+
+def compile_variant(build, config, opt_level=3, cache_dir=""):
+  """Builds a kernel with `build`, transformed according to `config`, and
+  returns the compiled MLIRModule."""
+  passes, options = get_passes(config)
+  E.set_options(options)
+  module = E.MLIRModule()
+  build(module)
+  module.compile(opt_level=opt_level, passes=passes, cache_dir=cache_dir)
+  return module
+
+
+def time_variant(module, function, arrays, repeats=5):
+  """Returns the best time in seconds of `repeats` runs of `function`, after a
+  first run warming up the caches."""
+  module.invoke(function, *arrays)
+  best = None
+  for _ in range(repeats):
+    start = timeit.default_timer()
+    module.invoke(function, *arrays)
+    elapsed = timeit.default_timer() - start
+    best = elapsed if best is None else min(best, elapsed)
+  return best
+
+
+def tune(build,
+         function,
+         arrays,
+         tile_sizes=(None,),
+         unroll_factors=(None,),
+         vector_sizes=(None,),
+         opt_level=3,
+         repeats=5,
+         cache_dir="",
+         verbose=False):
+  """Times `function`, built by `build`, on `arrays` for each combination of
+  the given parameters, and returns a `Result`.
+
+  The configurations that fail to compile are skipped.  If `cache_dir` is set,
+  the object code of each variant is cached in this directory, so that tuning
+  the same kernel again only compiles the new variants.
+  """
+  timings = collections.OrderedDict()
+  best = None
+  for params in itertools.product(tile_sizes, unroll_factors, vector_sizes):
+    config = Config(*params)
+    try:
+      module = compile_variant(build, config, opt_level, cache_dir)
+    except RuntimeError as e:
+      if verbose:
+        print("%s: failed to compile: %s" % (config, e))
+      timings[config] = None
+      continue
+    seconds = time_variant(module, function, arrays, repeats)
+    if verbose:
+      print("%s: %.6fs" % (config, seconds))
+    timings[config] = seconds
+    if best is None or seconds < timings[best]:
+      best = config
+  E.set_options([])
+  if best is None:
+    raise RuntimeError("no configuration could be compiled")
+  return Result(best, timings[best], timings)
@@ -18,9 +18,12 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstddef>
+#include <mutex>
+#include <stdexcept>
 #include <unordered_map>
 
 #include "mlir-c/Core.h"
@@ -28,11 +31,16 @@
 #include "mlir/EDSC/Helpers.h"
 #include "mlir/EDSC/Intrinsics.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/MemRefUtils.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
 #include "mlir/IR/Types.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
 #include "mlir/Target/LLVMIR.h"
 #include "mlir/Transforms/Passes.h"
 #include "pybind11/pybind11.h"
@@ -42,6 +50,7 @@
 static bool inited = [] {
   llvm::InitializeNativeTarget();
   llvm::InitializeNativeTargetAsmPrinter();
+  mlir::initializeLLVMPasses();
   return true;
 }();
 
@@ -185,15 +194,11 @@ struct PythonMLIRModule {
   // Create a boolean attribute.
   PythonAttribute boolAttr(bool value);
 
-  void compile() {
-    auto created = mlir::ExecutionEngine::create(module.get());
-    llvm::handleAllErrors(created.takeError(),
-                          [](const llvm::ErrorInfoBase &b) {
-                            b.log(llvm::errs());
-                            assert(false);
-                          });
-    engine = std::move(*created);
-  }
+  // Run the MLIR passes registered as `passes` on the module, then lower it
+  // to LLVM IR, optimize it at `optLevel` and compile it into an engine.  If
+  // `cacheDir` is not empty, the compiled objects are cached in it.
+  void compile(unsigned optLevel, const std::vector<std::string> &passes,
+               const std::string &cacheDir);
 
   std::string getIR() {
     std::string res;
@@ -202,11 +207,17 @@ struct PythonMLIRModule {
     return res;
   }
 
+  // Invoke the JIT-compiled function `name` on the buffers in `arguments`,
+  // which are wrapped as memref descriptors without being copied.
+  void invoke(const std::string &name, py::args arguments);
+
   uint64_t getEngineAddress() {
     assert(engine && "module must be compiled into engine first");
     return reinterpret_cast<uint64_t>(reinterpret_cast<void *>(engine.get()));
   }
 
+  mlir::Module *getModule() { return module.get(); }
+
   PythonFunction getNamedFunction(const std::string &name) {
     return module->getNamedFunction(name);
   }
@@ -217,12 +228,68 @@ struct PythonMLIRModule {
                       const py::kwargs &attributes);
 
 private:
+  // A function looked up in the engine, with the descriptors of its arguments,
+  // which are rebound at each invocation.  The mutex serializes the
+  // invocations sharing these descriptors, which run without the GIL.
+  struct InvocableFunction {
+    InvocableFunction(mlir::JITFunction function,
+                      mlir::MemRefArgumentPack arguments)
+        : function(function), arguments(std::move(arguments)) {}
+
+    mlir::JITFunction function;
+    mlir::MemRefArgumentPack arguments;
+    std::mutex mutex;
+  };
+
+  // Return the function `name` of the engine, looking it up on first use.
+  InvocableFunction &getInvocableFunction(const std::string &name);
+
   mlir::MLIRContext mlirContext;
   // One single module in a python-exposed MLIRContext for now.
   std::unique_ptr<mlir::Module> module;
   std::unique_ptr<mlir::ExecutionEngine> engine;
+  // The types of the functions defined in the module before its compilation.
+  std::unordered_map<std::string, mlir::FunctionType> functionTypes;
+  std::unordered_map<std::string, std::unique_ptr<InvocableFunction>>
+      invocableFunctions;
 };
 
+/// Wrapper of a PassManager, to which the passes are added by the argument of
+/// their registration in mlir-opt.
+struct PythonPassManager {
+  explicit PythonPassManager(bool verifyPasses) : manager(verifyPasses) {}
+
+  void addPass(const std::string &name) {
+    const auto *entry = mlir::lookupPassRegistryEntry(name);
+    if (!entry)
+      throw std::invalid_argument("unknown pass '" + name + "'");
+    entry->addToPipeline(manager);
+  }
+
+  void enableTiming() { manager.enableTiming(); }
+
+  void run(PythonMLIRModule &module) {
+    if (failed(manager.run(module.getModule())))
+      throw std::runtime_error("pass pipeline failed");
+  }
+
+  mlir::PassManager manager;
+};
+
+// Parse `options` as if they were passed on the command line of mlir-opt, e.g.
+// "-tile-size=32", to set the options of the passes subsequently created.  The
+// options that are not listed are reset to their default value.
+static void setOptions(const std::vector<std::string> &options) {
+  std::vector<const char *> argv = {"pybind"};
+  for (const auto &option : options)
+    argv.push_back(option.c_str());
+  std::string errors;
+  llvm::raw_string_ostream os(errors);
+  llvm::cl::ResetAllOptionOccurrences();
+  if (!llvm::cl::ParseCommandLineOptions(argv.size(), argv.data(), "", &os))
+    throw std::invalid_argument(os.str());
+}
+
 struct PythonFunctionContext {
   PythonFunctionContext(PythonFunction f) : function(f) {}
   PythonFunctionContext(PythonMLIRModule &module, const std::string &name,
@@ -583,6 +650,135 @@ PythonMLIRModule::declareFunction(const std::string &name,
   return func;
 }
 
+void PythonMLIRModule::compile(unsigned optLevel,
+                               const std::vector<std::string> &passes,
+                               const std::string &cacheDir) {
+  // The module is lowered to the LLVM IR dialect in place, so the memref
+  // signatures of its functions are recorded first for `invoke`.
+  functionTypes.clear();
+  invocableFunctions.clear();
+  for (auto &function : *module)
+    if (!function.isExternal())
+      functionTypes.emplace(function.getName().strref().str(),
+                            function.getType());
+
+  // The passes are created with the GIL held, as they read the options that
+  // `set_options` writes.  The module is then only accessed by this thread.
+  PythonPassManager manager(/*verifyPasses=*/true);
+  for (const auto &pass : passes)
+    manager.addPass(pass);
+
+  std::function<llvm::Error(llvm::Module *)> transformer;
+  if (optLevel != 0)
+    transformer = mlir::makeOptimizingTransformer(optLevel, /*sizeLevel=*/0);
+  mlir::ExecutionEngineOptions options;
+  options.objectCacheDir = cacheDir;
+  options.transformerKey = "O" + std::to_string(optLevel);
+
+  py::gil_scoped_release release;
+  if (!passes.empty())
+    manager.run(*this);
+  auto created =
+      mlir::ExecutionEngine::create(module.get(), transformer, options);
+  if (!created)
+    throw std::runtime_error(llvm::toString(created.takeError()));
+  engine = std::move(*created);
+}
+
+PythonMLIRModule::InvocableFunction &
+PythonMLIRModule::getInvocableFunction(const std::string &name) {
+  auto it = invocableFunctions.find(name);
+  if (it != invocableFunctions.end())
+    return *it->second;
+
+  auto typeIt = functionTypes.find(name);
+  if (typeIt == functionTypes.end())
+    throw std::invalid_argument("no function named '" + name +
+                                "' was compiled in the module");
+  auto expectedFunction = engine->getFunction(name);
+  if (!expectedFunction)
+    throw std::runtime_error(llvm::toString(expectedFunction.takeError()));
+  auto expectedArguments = mlir::MemRefArgumentPack::create(typeIt->second);
+  if (!expectedArguments)
+    throw std::invalid_argument(llvm::toString(expectedArguments.takeError()));
+  if (expectedArguments->getNumResults() != 0)
+    throw std::invalid_argument("functions returning a memref cannot be "
+                                "invoked, their outputs must be written to "
+                                "arguments");
+
+  auto *invocable = new InvocableFunction(*expectedFunction,
+                                          std::move(*expectedArguments));
+  invocableFunctions[name].reset(invocable);
+  return *invocable;
+}
+
+// Each argument must expose a writable, C-contiguous buffer through the buffer
+// protocol, e.g. a NumPy array, whose rank, element size and static sizes
+// match the corresponding memref.  The GIL is released while the function runs.
+void PythonMLIRModule::invoke(const std::string &name, py::args arguments) {
+  if (!engine)
+    throw std::runtime_error("module must be compiled into engine first");
+  InvocableFunction &invocable = getInvocableFunction(name);
+  auto type = functionTypes.find(name)->second;
+  if (arguments.size() != type.getNumInputs())
+    throw std::invalid_argument("expected " +
+                                std::to_string(type.getNumInputs()) +
+                                " arguments");
+
+  // The buffer views are released when `buffers` is destroyed, after the
+  // invocation, which requires the GIL.
+  std::vector<py::buffer_info> buffers;
+  std::vector<SmallVector<int64_t, 4>> dynamicSizes(arguments.size());
+  buffers.reserve(arguments.size());
+  for (unsigned i = 0, e = arguments.size(); i < e; ++i) {
+    std::string position = "argument " + std::to_string(i);
+    if (!py::isinstance<py::buffer>(arguments[i]))
+      throw std::invalid_argument(position + " does not support the buffer "
+                                             "protocol");
+    buffers.push_back(
+        arguments[i].cast<py::buffer>().request(/*writable=*/true));
+    const py::buffer_info &buffer = buffers.back();
+
+    auto memRefType = type.getInput(i).cast<MemRefType>();
+    auto shape = memRefType.getShape();
+    if (buffer.ndim != static_cast<py::ssize_t>(shape.size()))
+      throw std::invalid_argument(position + " has rank " +
+                                  std::to_string(buffer.ndim) + ", expected " +
+                                  std::to_string(shape.size()));
+    if (buffer.itemsize !=
+        static_cast<py::ssize_t>(mlir::getMemRefElementSize(memRefType)))
+      throw std::invalid_argument(position + " has elements of " +
+                                  std::to_string(buffer.itemsize) +
+                                  " bytes, which do not match the element "
+                                  "type of the memref");
+
+    // The memref descriptors have no strides, so the buffers must be laid out
+    // in row-major order.  The strides of the unit dimensions don't matter.
+    py::ssize_t stride = buffer.itemsize;
+    for (int d = buffer.ndim - 1; d >= 0; --d) {
+      if (buffer.shape[d] != 1 && buffer.strides[d] != stride)
+        throw std::invalid_argument(position + " is not C-contiguous");
+      stride *= buffer.shape[d];
+    }
+    for (unsigned d = 0, rank = shape.size(); d < rank; ++d) {
+      if (shape[d] == -1)
+        dynamicSizes[i].push_back(buffer.shape[d]);
+      else if (shape[d] != buffer.shape[d])
+        throw std::invalid_argument(position + " has size " +
+                                    std::to_string(buffer.shape[d]) +
+                                    " along dimension " + std::to_string(d) +
+                                    ", expected " + std::to_string(shape[d]));
+    }
+  }
+
+  py::gil_scoped_release release;
+  std::lock_guard<std::mutex> lock(invocable.mutex);
+  for (unsigned i = 0, e = buffers.size(); i < e; ++i)
+    llvm::cantFail(
+        invocable.arguments.setArgument(i, buffers[i].ptr, dynamicSizes[i]));
+  invocable.function(invocable.arguments.getPackedArguments().data());
+}
+
 PythonAttributedType PythonType::attachAttributeDict(
     const std::unordered_map<std::string, PythonAttribute> &attrs) const {
   return PythonAttributedType(*this, attrs);
@@ -739,12 +935,13 @@ PYBIND11_MODULE(pybind, m) {
       "compilation of a single mlir::Module into an ExecutionEngine backed by "
       "the LLVM ORC JIT. A typical flow consists in creating an MLIRModule, "
       "adding functions, compiling the module to obtain an ExecutionEngine on "
-      "which named functions may be called. For now the only means to retrieve "
-      "the ExecutionEngine is by calling `get_engine_address`. This mode of "
-      "execution is limited to passing the pointer to C++ where the function "
-      "is called. Extending the API to allow calling JIT compiled functions "
-      "directly require integration with a tensor library (e.g. numpy). This "
-      "is left as the prerogative of libraries and frameworks for now.")
+      "which named functions may be called. The functions taking memrefs may "
+      "be called directly with `invoke` on objects supporting the buffer "
+      "protocol, e.g. numpy arrays. Alternatively, the address of the "
+      "ExecutionEngine returned by `get_engine_address` may be passed to C++ "
+      "where the function is called. Each MLIRModule owns its MLIRContext and "
+      "the EDSC contexts are kept per thread, so several Python threads may "
+      "build and compile their own MLIRModule concurrently.")
       .def(py::init<>())
       .def("boolAttr", &PythonMLIRModule::boolAttr,
            "Creates an mlir::BoolAttr with the given value")
@@ -785,19 +982,58 @@ PYBIND11_MODULE(pybind, m) {
            "denote symbolic dimensions in the resulting memref shape.")
       .def("make_index_type", &PythonMLIRModule::makeIndexType,
            "Returns an mlir::IndexType")
-      .def("compile", &PythonMLIRModule::compile,
+      .def("compile", &PythonMLIRModule::compile, py::arg("opt_level") = 0,
+           py::arg("passes") = std::vector<std::string>(),
+           py::arg("cache_dir") = "",
            "Compiles the mlir::Module to LLVMIR a creates new opaque "
-           "ExecutionEngine backed by the ORC JIT.")
+           "ExecutionEngine backed by the ORC JIT. The MLIR passes named in "
+           "`passes` by their mlir-opt argument, e.g. \"loop-tile\", "
+           "\"vectorize\" or \"loop-fusion\", are run first, and the LLVM "
+           "IR is optimized at `opt_level` (0 to 3). If `cache_dir` is set, "
+           "the object code is cached in this directory, so that compiling "
+           "the same module again with the same passes only loads it. The GIL "
+           "is released while the passes run and the module is compiled. "
+           "Raises RuntimeError if the module cannot be compiled.")
       .def("get_ir", &PythonMLIRModule::getIR,
+           py::call_guard<py::gil_scoped_release>(),
            "Returns a dump of the MLIR representation of the module. This is "
            "used for serde to support out-of-process execution as well as "
            "debugging purposes.")
+      .def("invoke", &PythonMLIRModule::invoke,
+           "Invokes the compiled function with the given name on the given "
+           "writable, C-contiguous buffers, e.g. numpy arrays, one per memref "
+           "argument. The buffers are passed without being copied, and the "
+           "GIL is released while the function runs. The function is looked "
+           "up once and cached for the subsequent invocations.")
       .def("get_engine_address", &PythonMLIRModule::getEngineAddress,
            "Returns the address of the compiled ExecutionEngine. This is used "
            "for in-process execution.")
       .def("__str__", &PythonMLIRModule::getIR,
+           py::call_guard<py::gil_scoped_release>(),
            "Get the string representation of the module");
 
+  py::class_<PythonPassManager>(
+      m, "PassManager",
+      "A pipeline of MLIR passes, designated by their mlir-opt argument, e.g. "
+      "\"cse\" or \"loop-tile\", which runs on the module of an MLIRModule "
+      "in place.")
+      .def(py::init<bool>(), py::arg("verify_passes") = true)
+      .def("add_pass", &PythonPassManager::addPass,
+           "Appends the registered pass or pass pipeline with the given "
+           "argument to the pipeline.")
+      .def("enable_timing", &PythonPassManager::enableTiming,
+           "Reports the time spent in each pass on stderr after each run.")
+      .def("run", &PythonPassManager::run,
+           py::call_guard<py::gil_scoped_release>(),
+           "Runs the pipeline on the module of the given MLIRModule, with the "
+           "GIL released.");
+
+  m.def("set_options", &setOptions,
+        "Sets the options of the passes, given as a list of mlir-opt command "
+        "line options, e.g. [\"-tile-size=32\"]. The options apply to the "
+        "passes created afterwards, and those not listed are reset to their "
+        "default value.");
+
   py::class_<PythonFunctionContext>(
       m, "FunctionContext", "A wrapper around mlir::edsc::ScopedContext")
       .def(py::init<PythonFunction>())
@@ -18,8 +18,15 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import threading
 import unittest
 
+try:
+  import numpy as np
+except ImportError:
+  np = None
+
+import google_mlir.bindings.python.autotune as autotune
 import google_mlir.bindings.python.pybind as E
 
 class EdscTest(unittest.TestCase):
@@ -478,5 +485,129 @@ class EdscTest(unittest.TestCase):
     self.assertNotEqual(self.module.get_engine_address(), 0)
 
 
+  def testPassManager(self):
+    memrefType = self.module.make_memref_type(self.f32Type, [32])
+    with self.module.function_context("copy", [memrefType, memrefType],
+                                      []) as fun:
+      A = E.IndexedValue(fun.arg(0))
+      B = E.IndexedValue(fun.arg(1))
+      with E.LoopContext(E.constant_index(0), E.constant_index(32), 1) as i:
+        B.store([i], A.load([i]))
+      E.ret([])
+
+    pm = E.PassManager()
+    pm.add_pass("lower-affine")
+    pm.add_pass("cse")
+    with self.assertRaises(ValueError):
+      pm.add_pass("no-such-pass")
+    pm.run(self.module)
+    self.assertNotIn("affine.for", str(self.module))
+
+  def testCompileWithPasses(self):
+    memrefType = self.module.make_memref_type(self.f32Type, [32, 32])
+    with self.module.function_context("transpose", [memrefType, memrefType],
+                                      []) as fun:
+      A = E.IndexedValue(fun.arg(0))
+      B = E.IndexedValue(fun.arg(1))
+      c0 = E.constant_index(0)
+      c32 = E.constant_index(32)
+      with E.LoopNestContext([c0, c0], [c32, c32], [1, 1]) as (i, j):
+        B.store([j, i], A.load([i, j]))
+      E.ret([])
+
+    E.set_options(["-tile-size=8"])
+    self.module.compile(opt_level=3, passes=["loop-tile", "canonicalize"])
+    self.assertNotEqual(self.module.get_engine_address(), 0)
+
+  # Invoke a compiled function on numpy arrays, which it writes in place.
+  @unittest.skipIf(np is None, "numpy is not available")
+  def testInvoke(self):
+    memrefType = self.module.make_memref_type(self.f32Type, [2, 3])
+    with self.module.function_context("double", [memrefType, memrefType],
+                                      []) as fun:
+      A = E.IndexedValue(fun.arg(0))
+      B = E.IndexedValue(fun.arg(1))
+      c0 = E.constant_index(0)
+      with E.LoopNestContext([c0, c0], [E.constant_index(2),
+                                        E.constant_index(3)], [1, 1]) as (i, j):
+        B.store([i, j], A.load([i, j]) + A.load([i, j]))
+      E.ret([])
+
+    self.module.compile()
+    inputs = np.arange(6, dtype=np.float32).reshape(2, 3)
+    outputs = np.zeros((2, 3), dtype=np.float32)
+    self.module.invoke("double", inputs, outputs)
+    np.testing.assert_array_equal(outputs, inputs * 2)
+
+    # The arrays must match the memref types and be laid out in row-major
+    # order, as they are not copied.
+    with self.assertRaises(ValueError):
+      self.module.invoke("double", inputs, np.zeros((3, 2), dtype=np.float32))
+    with self.assertRaises(ValueError):
+      self.module.invoke("double", inputs, np.zeros((2, 3), dtype=np.float64))
+    with self.assertRaises(ValueError):
+      self.module.invoke("double", inputs, np.zeros((3, 2), np.float32).T)
+    with self.assertRaises(ValueError):
+      self.module.invoke("missing")
+
+  @unittest.skipIf(np is None, "numpy is not available")
+  def testAutotune(self):
+
+    def build(module):
+      memrefType = module.make_memref_type(
+          module.make_scalar_type("f32"), [64, 64])
+      with module.function_context("scale", [memrefType, memrefType],
+                                   []) as fun:
+        A = E.IndexedValue(fun.arg(0))
+        B = E.IndexedValue(fun.arg(1))
+        c0 = E.constant_index(0)
+        c64 = E.constant_index(64)
+        with E.LoopNestContext([c0, c0], [c64, c64], [1, 1]) as (i, j):
+          B.store([i, j], A.load([i, j]) + A.load([i, j]))
+        E.ret([])
+
+    inputs = np.ones((64, 64), dtype=np.float32)
+    outputs = np.zeros((64, 64), dtype=np.float32)
+    result = autotune.tune(
+        build, "scale", [inputs, outputs], tile_sizes=[None, 8, 32],
+        unroll_factors=[None, 4], repeats=1)
+    self.assertEqual(len(result.timings), 6)
+    self.assertIn(result.best, result.timings)
+    self.assertEqual(result.seconds, result.timings[result.best])
+    np.testing.assert_array_equal(outputs, inputs * 2)
+
+  # Build and compile one module per thread, each in its own EDSC contexts.
+  def testConcurrentCompilation(self):
+    errors = []
+
+    def buildAndCompile(index):
+      try:
+        module = E.MLIRModule()
+        f32Type = module.make_scalar_type("f32")
+        memrefType = module.make_memref_type(f32Type, [16, 16])
+        with module.function_context("copy%d" % index,
+                                     [memrefType, memrefType], []) as fun:
+          A = E.IndexedValue(fun.arg(0))
+          B = E.IndexedValue(fun.arg(1))
+          c0 = E.constant_index(0)
+          c16 = E.constant_index(16)
+          with E.LoopNestContext([c0, c0], [c16, c16], [1, 1]) as (i, j):
+            B.store([i, j], A.load([i, j]))
+          E.ret([])
+        module.compile(opt_level=2, passes=["canonicalize"])
+        if module.get_engine_address() == 0:
+          errors.append("module %d was not compiled" % index)
+      except Exception as e:
+        errors.append(str(e))
+
+    threads = [
+        threading.Thread(target=buildAndCompile, args=(i,)) for i in range(4)
+    ]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(errors, [])
+
 if __name__ == "__main__":
   unittest.main()
@@ -18,12 +18,34 @@
 #ifndef LINALG_CONVERTTOLLVMDIALECT_H_
 #define LINALG_CONVERTTOLLVMDIALECT_H_
 
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/Allocator.h"
+
+#include <functional>
+
 namespace mlir {
+class DialectOpConversion;
+class MLIRContext;
 class Module;
+class Type;
 } // end namespace mlir
 
 namespace linalg {
-void convertToLLVM(mlir::Module &module);
+/// Returns the LLVM IR dialect type of a Linalg, MemRef, index, integer or F32
+/// type, e.g. the descriptor of a view.
+mlir::Type convertLinalgType(mlir::Type t);
+
+/// Allocates in the given allocator the conversions to the LLVM IR dialect of
+/// operations not defined by Linalg1, e.g. the ones of the later chapters,
+/// which operate on the converted descriptors of the views.
+using ConversionsBuilder =
+    std::function<llvm::DenseSet<mlir::DialectOpConversion *>(
+        llvm::BumpPtrAllocator *, mlir::MLIRContext *)>;
+
+/// Converts `module` to the LLVM IR dialect, applying `extraConversions`
+/// along with the conversions of the Linalg1 operations.
+void convertToLLVM(mlir::Module &module,
+                   const ConversionsBuilder &extraConversions = nullptr);
 } // end namespace linalg
 
 #endif // LINALG_CONVERTTOLLVMDIALECT_H_
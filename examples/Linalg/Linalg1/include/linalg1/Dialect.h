@@ -30,6 +30,9 @@ public:
   /// relevant types and operations.
   explicit LinalgDialect(mlir::MLIRContext *context);
 
+  /// The namespace of the dialect, under which it is registered.
+  static llvm::StringRef getDialectNamespace() { return "linalg"; }
+
   /// Parse a type registered to this dialect.
   mlir::Type parseType(llvm::StringRef spec, mlir::Location loc) const override;
 
@@ -28,6 +28,7 @@
 #include "mlir/LLVMIR/LLVMDialect.h"
 #include "mlir/LLVMIR/Transforms.h"
 #include "mlir/Pass/PassManager.h"
+#include "mlir/StandardOps/Ops.h"
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/Passes.h"
@@ -151,6 +152,8 @@ LLVM::LLVMType convertType(Type t) {
   llvm_unreachable("unsupported type");
 }
 
+Type linalg::convertLinalgType(Type t) { return convertType(t); }
+
 // Create an array attribute containing integer attributes with values provided
 // in `position`.
 static ArrayAttr makePositionAttr(FuncBuilder &builder,
@@ -431,6 +434,49 @@ public:
   }
 };
 
+// DimOp of a memref is converted along with the Linalg operations: once the
+// function signatures are converted, the memref arguments are descriptors that
+// the standard conversion running next no longer recognizes.
+class DimOpConversion : public DialectOpConversion {
+public:
+  explicit DimOpConversion(MLIRContext *context)
+      : DialectOpConversion(DimOp::getOperationName(), 1, context) {}
+
+  PatternMatchResult match(Operation *op) const override {
+    if (op->isa<DimOp>())
+      return matchSuccess();
+    return matchFailure();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto dimOp = op->cast<DimOp>();
+    auto memrefType = dimOp.getOperand()->getType().cast<MemRefType>();
+    auto indexTy = convertType(rewriter.getIndexType());
+    auto shape = memrefType.getShape();
+    unsigned dim = dimOp.getIndex();
+
+    using namespace intrinsics;
+    auto context = edsc::ScopedContext(rewriter, op->getLoc());
+
+    // Static sizes are constants, dynamic ones are stored in the descriptor
+    // after the data pointer, in the order of the dynamic dimensions.
+    Value *size;
+    if (shape[dim] != -1) {
+      size = constant(indexTy,
+                      IntegerAttr::get(rewriter.getIndexType(), shape[dim]));
+    } else {
+      int dynamicDimPos = 0;
+      for (unsigned i = 0; i < dim; ++i)
+        if (shape[i] == -1)
+          ++dynamicDimPos;
+      size = extractvalue(indexTy, operands[0],
+                          makePositionAttr(rewriter, 1 + dynamicDimPos));
+    }
+    return {size};
+  }
+};
+
 // When converting the "some_consumer" operation, don't emit anything and
 // effectively drop it.
 class DropConsumer : public DialectOpConversion {
@@ -453,17 +499,23 @@ public:
 // The conversion class from Linalg to LLVMIR.
 class Lowering : public DialectConversion {
 public:
-  Lowering() {}
+  explicit Lowering(const linalg::ConversionsBuilder &extraConversions)
+      : extraConversions(extraConversions) {}
 
 protected:
   // Initialize the list of converters.
   llvm::DenseSet<DialectOpConversion *>
   initConverters(MLIRContext *context) override {
     converterSotrage.Reset();
-    return ConversionListBuilder<DropConsumer, RangeOpConversion,
-                                 SliceOpConversion,
-                                 ViewOpConversion>::build(&converterSotrage,
-                                                          context);
+    auto converters =
+        ConversionListBuilder<DimOpConversion, DropConsumer,
+                              RangeOpConversion, SliceOpConversion,
+                              ViewOpConversion>::build(&converterSotrage,
+                                                       context);
+    if (extraConversions)
+      for (auto *converter : extraConversions(&converterSotrage, context))
+        converters.insert(converter);
+    return converters;
   }
 
   // This gets called for block and region arguments, and attributes.
@@ -497,9 +549,12 @@ protected:
 private:
   // Storage for individual converters.
   llvm::BumpPtrAllocator converterSotrage;
+  // Builder of the converters of the operations of the later chapters.
+  linalg::ConversionsBuilder extraConversions;
 };
 
-void linalg::convertToLLVM(mlir::Module &module) {
+void linalg::convertToLLVM(mlir::Module &module,
+                           const ConversionsBuilder &extraConversions) {
   // Remove affine constructs if any by using an existing pass.
   PassManager pm;
   pm.addPass(createLowerAffinePass());
@@ -509,7 +564,7 @@ void linalg::convertToLLVM(mlir::Module &module) {
 
   // Convert Linalg ops to the LLVM IR dialect using the converter defined
   // above.
-  auto r = Lowering().convert(&module);
+  auto r = Lowering(extraConversions).convert(&module);
   (void)r;
   assert(succeeded(r) && "conversion failed");
 
@@ -27,7 +27,7 @@
 using namespace linalg;
 
 LinalgDialect::LinalgDialect(mlir::MLIRContext *context)
-    : Dialect("linalg", context) {
+    : Dialect(getDialectNamespace(), context) {
   addTypes<RangeType, ViewType>();
   addOperations<DotOp, MatvecOp, MatmulOp, RangeOp, SliceOp, ViewOp>();
 }
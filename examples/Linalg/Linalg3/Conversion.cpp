@@ -0,0 +1,101 @@
+//===- Conversion.cpp - Linalg to LLVM conversion -------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// RUN: %p/conversion | FileCheck %s
+
+#include "TestHarness.h"
+#include "linalg1/Common.h"
+#include "linalg2/Intrinsics.h"
+#include "linalg3/ConvertToLLVMDialect.h"
+#include "linalg3/Ops.h"
+#include "linalg3/Transforms.h"
+#include "mlir/IR/OpImplementation.h"
+
+using llvm::StringRef;
+
+using namespace mlir;
+using namespace mlir::edsc;
+using namespace mlir::edsc::intrinsics;
+using namespace linalg;
+using namespace linalg::common;
+using namespace linalg::intrinsics;
+
+Function *makeFunctionWithAMatmulOp(Module &module, StringRef name) {
+  MLIRContext *context = module.getContext();
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, name,
+      {dynamic2DMemRefType, dynamic2DMemRefType, dynamic2DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    N = dim(f->getArgument(2), 1),
+    K = dim(f->getArgument(0), 1),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rN = range(constant_index(0), N, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vB = view(f->getArgument(1), {rK, rN}),
+    vC = view(f->getArgument(2), {rM, rN});
+  matmul(vA, vB, vC);
+  ret();
+  // clang-format on
+
+  return f;
+}
+
+TEST_FUNC(matmul_as_dot_vectorized) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithAMatmulOp(module, "matmul_as_dot_vectorized");
+  lowerToFinerGrainedTensorContraction(f);
+  lowerToFinerGrainedTensorContraction(f);
+  composeSliceOps(f);
+  convertLinalg3ToLLVM(module);
+  // clang-format off
+  // CHECK-LABEL: func @matmul_as_dot_vectorized
+  //       CHECK:   llvm.call @linalg_dot_f32(%{{.*}}, %{{.*}}, %{{.*}}) : (!llvm<"{ float*, i64, [1 x i64], [1 x i64] }">, !llvm<"{ float*, i64, [1 x i64], [1 x i64] }">, !llvm<"{ float*, i64, [0 x i64], [0 x i64] }">) -> ()
+  //       CHECK: func @linalg_dot_f32(%arg0: !llvm<"{ float*, i64, [1 x i64], [1 x i64] }">, %arg1: !llvm<"{ float*, i64, [1 x i64], [1 x i64] }">, %arg2: !llvm<"{ float*, i64, [0 x i64], [0 x i64] }">) {
+  //       CHECK:   %[[n:.*]] = llvm.extractvalue %arg0[2, 0] : !llvm<"{ float*, i64, [1 x i64], [1 x i64] }">
+  //       CHECK:   %[[rem:.*]] = llvm.srem %[[n]], %{{.*}} : !llvm<"i64">
+  //       CHECK:   %[[nv:.*]] = llvm.select %{{.*}}, %{{.*}}, %{{.*}} : !llvm<"i1">, !llvm<"i64">
+  //       CHECK:   llvm.br ^bb1(%{{.*}}, %{{.*}} : !llvm<"i64">, !llvm<"<8 x float>">)
+  //       CHECK: ^bb1(%[[i:.*]]: !llvm<"i64">, %[[vacc:.*]]: !llvm<"<8 x float>">):
+  //       CHECK:   llvm.cond_br %{{.*}}, ^bb2, ^bb3
+  //       CHECK: ^bb2:
+  //       CHECK:   llvm.bitcast %{{.*}} : !llvm<"float*"> to !llvm<"<8 x float>*">
+  //       CHECK:   llvm.load %{{.*}} {alignment = 4 : i64} : !llvm<"<8 x float>*">
+  //       CHECK:   "llvm.intr.fmuladd"(%{{.*}}, %{{.*}}, %[[vacc]]) : (!llvm<"<8 x float>">, !llvm<"<8 x float>">, !llvm<"<8 x float>">) -> !llvm<"<8 x float>">
+  //       CHECK: ^bb3:
+  //       CHECK:   "llvm.intr.vector.reduce.fadd"(%{{.*}}, %[[vacc]])
+  //       CHECK:   llvm.br ^bb4(%[[nv]], %{{.*}} : !llvm<"i64">, !llvm<"float">)
+  //       CHECK: ^bb5:
+  //       CHECK:   "llvm.intr.fmuladd"(%{{.*}}, %{{.*}}, %{{.*}}) : (!llvm<"float">, !llvm<"float">, !llvm<"float">) -> !llvm<"float">
+  //       CHECK: ^bb6:
+  //       CHECK:   llvm.store %{{.*}}, %{{.*}} : !llvm<"float*">
+  //  CHECK-NEXT:   llvm.return
+  // clang-format on
+  module.print(llvm::outs());
+}
+
+int main() {
+  RUN_TESTS();
+  return 0;
+}
@@ -0,0 +1,215 @@
+//===- Execution.cpp - Execution of the Linalg code lowered to LLVM -------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// RUN: %p/execution | FileCheck %s
+
+#include "TestHarness.h"
+#include "linalg1/Common.h"
+#include "linalg2/Intrinsics.h"
+#include "linalg3/ConvertToLLVMDialect.h"
+#include "linalg3/Ops.h"
+#include "linalg3/Transforms.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/Module.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <vector>
+
+using llvm::StringRef;
+
+using namespace mlir;
+using namespace mlir::edsc;
+using namespace mlir::edsc::intrinsics;
+using namespace linalg;
+using namespace linalg::common;
+using namespace linalg::intrinsics;
+
+namespace {
+/// The descriptors of the memref<?xf32> and memref<?x?xf32> passed to the
+/// compiled functions, see linalg1/ConvertToLLVMDialect.cpp.
+struct MemRef1D {
+  float *data;
+  int64_t size;
+};
+
+struct MemRef2D {
+  float *data;
+  int64_t rows;
+  int64_t columns;
+};
+} // end anonymous namespace
+
+// The sizes of the matrices, such that the dot products of 19 elements run two
+// iterations of the vector loop of 8 elements, then 3 scalar iterations.
+static constexpr int64_t kM = 3, kN = 2, kK = 19;
+
+// Computes y = A * x[1:], where the view of x skips its first element, so that
+// neither the rows of A nor the view of x are aligned on vectors.
+Function *makeFunctionWithAMatvecOp(Module &module, StringRef name) {
+  MLIRContext *context = module.getContext();
+  auto dynamic1DMemRefType = floatMemRefType<1>(context);
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, name,
+      {dynamic2DMemRefType, dynamic1DMemRefType, dynamic1DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    K = dim(f->getArgument(0), 1),
+    X = dim(f->getArgument(1), 0),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    rX = range(constant_index(1), X, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vx = view(f->getArgument(1), {rX}),
+    vy = view(f->getArgument(2), {rM});
+  matvec(vA, vx, vy);
+  ret();
+  // clang-format on
+
+  return f;
+}
+
+Function *makeFunctionWithAMatmulOp(Module &module, StringRef name) {
+  MLIRContext *context = module.getContext();
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, name,
+      {dynamic2DMemRefType, dynamic2DMemRefType, dynamic2DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    N = dim(f->getArgument(2), 1),
+    K = dim(f->getArgument(0), 1),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rN = range(constant_index(0), N, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vB = view(f->getArgument(1), {rK, rN}),
+    vC = view(f->getArgument(2), {rM, rN});
+  matmul(vA, vB, vC);
+  ret();
+  // clang-format on
+
+  return f;
+}
+
+// Returns the MxK matrix A with A[i][j] = (i + j) mod 5.
+static std::vector<float> makeMatrixA() {
+  std::vector<float> a(kM * kK);
+  for (int64_t i = 0; i < kM; ++i)
+    for (int64_t j = 0; j < kK; ++j)
+      a[i * kK + j] = (i + j) % 5;
+  return a;
+}
+
+// JIT-compiles `module`, lowered to the LLVM IR dialect, and calls its
+// function `name` on `args`.  Prints the error and returns false on failure.
+template <typename... Args>
+static bool compileAndInvoke(Module &module, StringRef name, Args &... args) {
+  auto engine = ExecutionEngine::create(&module);
+  if (!engine) {
+    llvm::errs() << "failed to compile: " << llvm::toString(engine.takeError())
+                 << '\n';
+    return false;
+  }
+  if (auto error = (*engine)->invoke(name, args...)) {
+    llvm::errs() << "failed to invoke: " << llvm::toString(std::move(error))
+                 << '\n';
+    return false;
+  }
+  return true;
+}
+
+static void printValues(ArrayRef<float> values) {
+  for (auto value : values)
+    llvm::outs() << llvm::format("%.1f", value) << '\n';
+}
+
+TEST_FUNC(matvec_as_vectorized_dots) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithAMatvecOp(module, "matvec_as_vectorized_dots");
+  lowerToFinerGrainedTensorContraction(f);
+  composeSliceOps(f);
+  convertLinalg3ToLLVM(module);
+
+  // x[0] is not part of the view, its value would show in y otherwise.
+  std::vector<float> a = makeMatrixA(), x(kK + 1), y(kM, -1.0f);
+  x[0] = 100.0f;
+  for (int64_t j = 0; j < kK; ++j)
+    x[j + 1] = j % 4;
+  MemRef2D memrefA{a.data(), kM, kK};
+  MemRef1D memrefX{x.data(), kK + 1};
+  MemRef1D memrefY{y.data(), kM};
+  llvm::outs() << "matvec_as_vectorized_dots\n";
+  if (!compileAndInvoke(module, "matvec_as_vectorized_dots", memrefA, memrefX,
+                        memrefY))
+    return;
+  printValues(y);
+  // CHECK-LABEL: matvec_as_vectorized_dots
+  //  CHECK-NEXT: 48.0
+  //  CHECK-NEXT: 60.0
+  //  CHECK-NEXT: 57.0
+}
+
+// The columns of B, and the dot products on them, have a stride of N: they
+// are computed by the scalar loop only.
+TEST_FUNC(matmul_as_strided_dots) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithAMatmulOp(module, "matmul_as_strided_dots");
+  lowerToFinerGrainedTensorContraction(f);
+  lowerToFinerGrainedTensorContraction(f);
+  composeSliceOps(f);
+  convertLinalg3ToLLVM(module);
+
+  std::vector<float> a = makeMatrixA(), b(kK * kN), c(kM * kN, -1.0f);
+  for (int64_t j = 0; j < kK; ++j)
+    for (int64_t n = 0; n < kN; ++n)
+      b[j * kN + n] = (j + 2 * n) % 3;
+  MemRef2D memrefA{a.data(), kM, kK};
+  MemRef2D memrefB{b.data(), kK, kN};
+  MemRef2D memrefC{c.data(), kM, kN};
+  llvm::outs() << "matmul_as_strided_dots\n";
+  if (!compileAndInvoke(module, "matmul_as_strided_dots", memrefA, memrefB,
+                        memrefC))
+    return;
+  printValues(c);
+  // CHECK-LABEL: matmul_as_strided_dots
+  //  CHECK-NEXT: 35.0
+  //  CHECK-NEXT: 38.0
+  //  CHECK-NEXT: 38.0
+  //  CHECK-NEXT: 43.0
+  //  CHECK-NEXT: 41.0
+  //  CHECK-NEXT: 38.0
+}
+
+int main() {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  RUN_TESTS();
+  return 0;
+}
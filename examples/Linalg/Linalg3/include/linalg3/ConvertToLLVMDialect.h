@@ -0,0 +1,37 @@
+//===- ConvertToLLVMDialect.h - conversion from Linalg to LLVM --*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef LINALG3_CONVERTTOLLVMDIALECT_H_
+#define LINALG3_CONVERTTOLLVMDIALECT_H_
+
+namespace mlir {
+class Module;
+} // end namespace mlir
+
+namespace linalg {
+/// Converts `module` to the LLVM IR dialect like `convertToLLVM` does, along
+/// with the linalg.load and linalg.store operations, after replacing each
+/// linalg.dot with a call to a function defined per element type,
+/// "linalg_dot_f32" for f32.  This function multiplies and accumulates
+/// the elements of unit-stride views with vector loads and multiply-adds of
+/// `vectorWidth` elements, adds up the vector lanes with a horizontal
+/// reduction, and handles the remaining elements, or strided views, with
+/// scalar code.
+void convertLinalg3ToLLVM(mlir::Module &module, unsigned vectorWidth = 8);
+} // end namespace linalg
+
+#endif // LINALG3_CONVERTTOLLVMDIALECT_H_
@@ -19,9 +19,14 @@
 #define LINALG3_TRANSFORMS_H_
 
 #include "linalg2/Transforms.h"
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace mlir {
+class AffineMap;
 class Function;
+class Value;
 } // namespace mlir
 
 namespace linalg {
@@ -41,6 +46,31 @@ void lowerToFinerGrainedTensorContraction(mlir::Function *f);
 /// Traverses `f` and rewrites linalg operations in loop form.
 void lowerToLoops(mlir::Function *f);
 
+/// The bounds and steps of a list of linalg.range, which must all be defined
+/// by RangeOp.
+struct RangeParts {
+  explicit RangeParts(unsigned reserved);
+  RangeParts(llvm::ArrayRef<mlir::Value *> ranges);
+
+  /// Creates a linalg.range for each (min, max, step) triple.
+  llvm::SmallVector<mlir::Value *, 4> makeRanges();
+
+  llvm::SmallVector<mlir::Value *, 4> mins;
+  llvm::SmallVector<mlir::Value *, 4> maxes;
+  llvm::SmallVector<mlir::Value *, 4> steps;
+};
+
+/// Returns the ranges of the loops enclosing a tensor contraction, given the
+/// `ranges` of its operands and the map from them to the loops returned by
+/// `operandRangesToLoopsMap`.
+/// If `tileSizes` is specified, only the ranges of the first
+/// `tileSizes->size()` loops are returned, with their step multiplied by the
+/// corresponding tile size, which must be a constant index.
+llvm::SmallVector<mlir::Value *, 4> makeGenericLoopRanges(
+    mlir::AffineMap operandRangesToLoopsMap,
+    llvm::ArrayRef<mlir::Value *> ranges,
+    llvm::Optional<llvm::ArrayRef<mlir::Value *>> tileSizes = llvm::None);
+
 } // namespace linalg
 
 #endif // LINALG3_TRANSFORMS_H_
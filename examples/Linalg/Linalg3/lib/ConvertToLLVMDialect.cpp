@@ -0,0 +1,400 @@
+//===- ConvertToLLVMDialect.cpp - conversion from Linalg to LLVM dialect --===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/LLVMIR/LLVMDialect.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/DialectConversion.h"
+
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "linalg1/ConvertToLLVMDialect.h"
+#include "linalg1/ViewType.h"
+#include "linalg3/ConvertToLLVMDialect.h"
+#include "linalg3/Ops.h"
+
+using namespace mlir;
+
+// Create an array attribute containing integer attributes with values provided
+// in `position`.
+static ArrayAttr makePositionAttr(Builder &builder, ArrayRef<int> position) {
+  SmallVector<Attribute, 4> attrs;
+  attrs.reserve(position.size());
+  for (auto p : position)
+    attrs.push_back(builder.getIntegerAttr(builder.getIntegerType(64), p));
+  return builder.getArrayAttr(attrs);
+}
+
+// Emits the computation of the address of the element of the view described by
+// `viewDescriptor` at `indices`:
+//   base_ptr + base_offset + sum_i indices[i] * strides[i]
+static Value *obtainDataPtr(Location loc, Type viewType, Value *viewDescriptor,
+                            ArrayRef<Value *> indices, FuncBuilder &rewriter) {
+  auto elementType = viewType.cast<linalg::ViewType>().getElementType();
+  auto elementPtrType = rewriter.getType<LLVM::LLVMType>(
+      linalg::convertLinalgType(elementType)
+          .cast<LLVM::LLVMType>()
+          .getUnderlyingType()
+          ->getPointerTo());
+  auto int64Ty = linalg::convertLinalgType(rewriter.getIntegerType(64));
+  auto pos = [&rewriter](ArrayRef<int> values) {
+    return makePositionAttr(rewriter, values);
+  };
+
+  Value *offset = rewriter.create<LLVM::ExtractValueOp>(
+      loc, int64Ty, viewDescriptor, pos(1));
+  for (int i = 0, e = indices.size(); i < e; ++i) {
+    Value *stride = rewriter.create<LLVM::ExtractValueOp>(
+        loc, int64Ty, viewDescriptor, pos({3, i}));
+    Value *product = rewriter.create<LLVM::MulOp>(
+        loc, int64Ty, ArrayRef<Value *>{indices[i], stride},
+        ArrayRef<NamedAttribute>{});
+    offset = rewriter.create<LLVM::AddOp>(loc, int64Ty,
+                                          ArrayRef<Value *>{offset, product},
+                                          ArrayRef<NamedAttribute>{});
+  }
+  Value *base = rewriter.create<LLVM::ExtractValueOp>(
+      loc, elementPtrType, viewDescriptor, pos(0));
+  return rewriter.create<LLVM::GEPOp>(loc, elementPtrType,
+                                      ArrayRef<Value *>{base, offset},
+                                      ArrayRef<NamedAttribute>{});
+}
+
+namespace {
+// A linalg.load is converted into a load from the address of the element.
+class LoadOpConversion : public DialectOpConversion {
+public:
+  explicit LoadOpConversion(MLIRContext *context)
+      : DialectOpConversion(linalg::LoadOp::getOperationName(), 1, context) {}
+
+  PatternMatchResult match(Operation *op) const override {
+    if (op->isa<linalg::LoadOp>())
+      return matchSuccess();
+    return matchFailure();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto loadOp = op->cast<linalg::LoadOp>();
+    auto elementType =
+        linalg::convertLinalgType(loadOp.getResult()->getType());
+    Value *ptr = obtainDataPtr(op->getLoc(), loadOp.getView()->getType(),
+                               operands[0], operands.drop_front(), rewriter);
+    Value *element = rewriter.create<LLVM::LoadOp>(
+        op->getLoc(), elementType, ArrayRef<Value *>{ptr},
+        ArrayRef<NamedAttribute>{});
+    return {element};
+  }
+};
+
+// A linalg.store is converted into a store to the address of the element.
+class StoreOpConversion : public DialectOpConversion {
+public:
+  explicit StoreOpConversion(MLIRContext *context)
+      : DialectOpConversion(linalg::StoreOp::getOperationName(), 1, context) {}
+
+  PatternMatchResult match(Operation *op) const override {
+    if (op->isa<linalg::StoreOp>())
+      return matchSuccess();
+    return matchFailure();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto storeOp = op->cast<linalg::StoreOp>();
+    Value *ptr = obtainDataPtr(op->getLoc(), storeOp.getView()->getType(),
+                               operands[1], operands.drop_front(2), rewriter);
+    rewriter.create<LLVM::StoreOp>(op->getLoc(),
+                                   ArrayRef<Value *>{operands[0], ptr},
+                                   ArrayRef<NamedAttribute>{});
+    return {};
+  }
+};
+} // end anonymous namespace
+
+// Returns the name of the function implementing linalg.dot on views of
+// `elementType`.
+static std::string getDotFunctionName(Type elementType) {
+  std::string name;
+  llvm::raw_string_ostream os(name);
+  os << "linalg_dot_" << elementType;
+  return os.str();
+}
+
+// Replaces the linalg.dot operations of `module` with calls to a function per
+// element type, taking the views of the operation.  Returns the functions
+// declared, along with their element type; the functions that `module` already
+// has are called as is.
+static SmallVector<std::pair<Function *, Type>, 2>
+replaceDotOpsWithCalls(Module &module) {
+  SmallVector<Operation *, 8> dotOps;
+  for (auto &f : module)
+    f.walk(
+        [&dotOps](linalg::DotOp op) { dotOps.push_back(op.getOperation()); });
+
+  SmallVector<std::pair<Function *, Type>, 2> declared;
+  for (auto *op : dotOps) {
+    auto elementType =
+        op->getOperand(0)->getType().cast<linalg::ViewType>().getElementType();
+    auto name = getDotFunctionName(elementType);
+    Function *callee = module.getNamedFunction(name);
+    if (!callee) {
+      SmallVector<Type, 3> types;
+      for (auto *operand : op->getOperands())
+        types.push_back(operand->getType());
+      callee = new Function(op->getLoc(), name,
+                            FunctionType::get(types, {}, op->getContext()));
+      module.getFunctions().push_back(callee);
+      declared.push_back({callee, elementType});
+    }
+    SmallVector<Value *, 3> operands(op->getOperands());
+    FuncBuilder builder(op);
+    builder.create<CallOp>(op->getLoc(), callee, operands);
+    op->erase();
+  }
+  return declared;
+}
+
+// Defines in the LLVM IR dialect the body of `f`, which computes the dot
+// product of the 1-D views of `elementType` described by its first two
+// arguments into the 0-D view described by the third one.  When both inputs
+// have a unit stride, the elements are multiplied and accumulated by vectors
+// of `vectorWidth` elements, which are added up horizontally after the loop.
+// The remaining elements, or all of them for strided inputs, are then
+// accumulated one at a time.
+//
+//   entry:
+//     %nv = select(%unitStrides, %n - %n srem W, 0)
+//     llvm.br ^vectorCond(0, dense<0.0>)
+//   ^vectorCond(%i, %vacc):
+//     llvm.cond_br (%i < %nv), ^vectorBody, ^reduce
+//   ^vectorBody:
+//     %vacc' = fmuladd(load <W x T> A[%i], load <W x T> B[%i], %vacc)
+//     llvm.br ^vectorCond(%i + W, %vacc')
+//   ^reduce:
+//     llvm.br ^scalarCond(%nv, vector.reduce.fadd(0.0, %vacc))
+//   ^scalarCond(%j, %acc):
+//     llvm.cond_br (%j < %n), ^scalarBody, ^exit
+//   ^scalarBody:
+//     llvm.br ^scalarCond(%j + 1, fmuladd(A[%j], B[%j], %acc))
+//   ^exit:
+//     C[] = %acc
+static void emitVectorizedDot(Function *f, Type elementType,
+                              unsigned vectorWidth) {
+  MLIRContext *context = f->getContext();
+  auto *dialect =
+      static_cast<LLVM::LLVMDialect *>(context->getRegisteredDialect("llvm"));
+  auto llvmType = [context](llvm::Type *type) {
+    return LLVM::LLVMType::get(context, type);
+  };
+  auto loc = f->getLoc();
+
+  // The view descriptors are { T*, i64 offset, [R x i64] sizes,
+  // [R x i64] strides }, see linalg1/ConvertToLLVMDialect.cpp.
+  auto *descriptorTy = f->getArgument(0)
+                           ->getType()
+                           .cast<LLVM::LLVMType>()
+                           .getUnderlyingType();
+  auto *elementPtrTy =
+      llvm::cast<llvm::PointerType>(descriptorTy->getStructElementType(0));
+  auto *elementTy = elementPtrTy->getElementType();
+  auto *vectorTy = llvm::VectorType::get(elementTy, vectorWidth);
+  auto i1Ty = llvmType(llvm::Type::getInt1Ty(dialect->getLLVMContext()));
+  auto i64Ty = llvmType(llvm::Type::getInt64Ty(dialect->getLLVMContext()));
+  auto elementLLVMTy = llvmType(elementTy);
+  auto vectorLLVMTy = llvmType(vectorTy);
+  auto elementPtrLLVMTy = llvmType(elementPtrTy);
+  auto vectorPtrLLVMTy = llvmType(vectorTy->getPointerTo());
+  int64_t alignment =
+      dialect->getLLVMModule().getDataLayout().getABITypeAlignment(elementTy);
+
+  f->addEntryBlock();
+  Block *entry = &f->front();
+  auto addBlock = [f](ArrayRef<Type> argTypes) {
+    Block *block = new Block();
+    for (auto type : argTypes)
+      block->addArgument(type);
+    f->getBlocks().push_back(block);
+    return block;
+  };
+  Block *vectorCond = addBlock({i64Ty, vectorLLVMTy});
+  Block *vectorBody = addBlock({});
+  Block *reduce = addBlock({});
+  Block *scalarCond = addBlock({i64Ty, elementLLVMTy});
+  Block *scalarBody = addBlock({});
+  Block *exitBlock = addBlock({});
+
+  FuncBuilder b(entry);
+  auto i64Constant = [&b, loc, i64Ty](int64_t value) -> Value * {
+    return b.create<LLVM::ConstantOp>(
+        loc, i64Ty, b.getIntegerAttr(b.getIndexType(), value));
+  };
+  auto extract = [&b, loc](Type type, Value *descriptor,
+                           ArrayRef<int64_t> position) -> Value * {
+    SmallVector<Attribute, 2> attrs;
+    for (auto p : position)
+      attrs.push_back(b.getI64IntegerAttr(p));
+    return b.create<LLVM::ExtractValueOp>(loc, type, descriptor,
+                                          b.getArrayAttr(attrs));
+  };
+  auto add = [&b, loc, i64Ty](Value *lhs, Value *rhs) -> Value * {
+    return b.create<LLVM::AddOp>(loc, i64Ty, ArrayRef<Value *>{lhs, rhs},
+                                 ArrayRef<NamedAttribute>{});
+  };
+  auto mul = [&b, loc, i64Ty](Value *lhs, Value *rhs) -> Value * {
+    return b.create<LLVM::MulOp>(loc, i64Ty, ArrayRef<Value *>{lhs, rhs},
+                                 ArrayRef<NamedAttribute>{});
+  };
+  auto icmp = [&b, loc, i1Ty](CmpIPredicate predicate, Value *lhs,
+                              Value *rhs) -> Value * {
+    auto predicateAttr = b.getNamedAttr(
+        "predicate", b.getI64IntegerAttr(static_cast<int64_t>(predicate)));
+    return b.create<LLVM::ICmpOp>(loc, i1Ty, ArrayRef<Value *>{lhs, rhs},
+                                  predicateAttr);
+  };
+  auto gep = [&b, loc, elementPtrLLVMTy](Value *base,
+                                         Value *index) -> Value * {
+    return b.create<LLVM::GEPOp>(loc, elementPtrLLVMTy,
+                                 ArrayRef<Value *>{base, index},
+                                 ArrayRef<NamedAttribute>{});
+  };
+  auto br = [&b, loc](Block *dest, ArrayRef<Value *> operands) {
+    b.create<LLVM::BrOp>(loc, ArrayRef<Value *>{}, dest, operands);
+  };
+  auto condBr = [&b, loc](Value *condition, Block *trueDest,
+                          Block *falseDest) {
+    ArrayRef<Value *> noOperands;
+    b.create<LLVM::CondBrOp>(loc, condition,
+                             ArrayRef<Block *>{trueDest, falseDest},
+                             ArrayRef<ArrayRef<Value *>>{noOperands,
+                                                         noOperands});
+  };
+
+  // The first element of each input, its stride, and the number of elements.
+  Value *a = f->getArgument(0), *bView = f->getArgument(1);
+  Value *c = f->getArgument(2);
+  Value *baseA = gep(extract(elementPtrLLVMTy, a, 0), extract(i64Ty, a, 1));
+  Value *baseB =
+      gep(extract(elementPtrLLVMTy, bView, 0), extract(i64Ty, bView, 1));
+  Value *strideA = extract(i64Ty, a, {3, 0});
+  Value *strideB = extract(i64Ty, bView, {3, 0});
+  Value *size = extract(i64Ty, a, {2, 0});
+
+  // Only the inputs with unit strides are loaded by vectors: the vector loop
+  // covers the largest multiple of `vectorWidth` elements in that case, and no
+  // element otherwise.
+  Value *zero = i64Constant(0), *one = i64Constant(1);
+  Value *width = i64Constant(vectorWidth);
+  Value *unitStrides = b.create<LLVM::AndOp>(
+      loc, i1Ty,
+      ArrayRef<Value *>{icmp(CmpIPredicate::EQ, strideA, one),
+                        icmp(CmpIPredicate::EQ, strideB, one)},
+      ArrayRef<NamedAttribute>{});
+  Value *remainder = b.create<LLVM::SRemOp>(loc, i64Ty,
+                                            ArrayRef<Value *>{size, width},
+                                            ArrayRef<NamedAttribute>{});
+  Value *multiple = b.create<LLVM::SubOp>(loc, i64Ty,
+                                          ArrayRef<Value *>{size, remainder},
+                                          ArrayRef<NamedAttribute>{});
+  Value *vectorSize = b.create<LLVM::SelectOp>(
+      loc, i64Ty, ArrayRef<Value *>{unitStrides, multiple, zero},
+      ArrayRef<NamedAttribute>{});
+  auto zeroAttr = FloatAttr::get(elementType, 0.0);
+  Value *zeroVector = b.create<LLVM::ConstantOp>(
+      loc, vectorLLVMTy,
+      SplatElementsAttr::get(
+          VectorType::get({static_cast<int64_t>(vectorWidth)}, elementType),
+          zeroAttr));
+  br(vectorCond, {zero, zeroVector});
+
+  b.setInsertionPointToEnd(vectorCond);
+  Value *i = vectorCond->getArgument(0);
+  Value *vectorAcc = vectorCond->getArgument(1);
+  condBr(icmp(CmpIPredicate::SLT, i, vectorSize), vectorBody, reduce);
+
+  // The vector loads are only aligned as the elements are.
+  b.setInsertionPointToEnd(vectorBody);
+  auto vectorLoad = [&](Value *base) -> Value * {
+    Value *ptr = b.create<LLVM::BitcastOp>(
+        loc, vectorPtrLLVMTy, ArrayRef<Value *>{gep(base, i)},
+        ArrayRef<NamedAttribute>{});
+    auto load = b.create<LLVM::LoadOp>(loc, vectorLLVMTy,
+                                       ArrayRef<Value *>{ptr},
+                                       ArrayRef<NamedAttribute>{});
+    load.getOperation()->setAttr("alignment",
+                                 b.getI64IntegerAttr(alignment));
+    return load;
+  };
+  Value *newVectorAcc = b.create<LLVM::FMulAddOp>(
+      loc, vectorLLVMTy,
+      ArrayRef<Value *>{vectorLoad(baseA), vectorLoad(baseB), vectorAcc},
+      ArrayRef<NamedAttribute>{});
+  br(vectorCond, {add(i, width), newVectorAcc});
+
+  b.setInsertionPointToEnd(reduce);
+  Value *zeroScalar =
+      b.create<LLVM::ConstantOp>(loc, elementLLVMTy, zeroAttr);
+  Value *sum = b.create<LLVM::VectorReduceFAddOp>(
+      loc, elementLLVMTy, ArrayRef<Value *>{zeroScalar, vectorAcc},
+      ArrayRef<NamedAttribute>{});
+  br(scalarCond, {vectorSize, sum});
+
+  b.setInsertionPointToEnd(scalarCond);
+  Value *j = scalarCond->getArgument(0);
+  Value *acc = scalarCond->getArgument(1);
+  condBr(icmp(CmpIPredicate::SLT, j, size), scalarBody, exitBlock);
+
+  b.setInsertionPointToEnd(scalarBody);
+  auto scalarLoad = [&](Value *base, Value *stride) -> Value * {
+    return b.create<LLVM::LoadOp>(loc, elementLLVMTy,
+                                  ArrayRef<Value *>{gep(base, mul(j, stride))},
+                                  ArrayRef<NamedAttribute>{});
+  };
+  Value *newAcc = b.create<LLVM::FMulAddOp>(
+      loc, elementLLVMTy,
+      ArrayRef<Value *>{scalarLoad(baseA, strideA), scalarLoad(baseB, strideB),
+                        acc},
+      ArrayRef<NamedAttribute>{});
+  br(scalarCond, {add(j, one), newAcc});
+
+  b.setInsertionPointToEnd(exitBlock);
+  Value *baseC = gep(extract(elementPtrLLVMTy, c, 0), extract(i64Ty, c, 1));
+  b.create<LLVM::StoreOp>(loc, ArrayRef<Value *>{acc, baseC},
+                          ArrayRef<NamedAttribute>{});
+  b.create<LLVM::ReturnOp>(loc, ArrayRef<Value *>{}, ArrayRef<Block *>{});
+}
+
+void linalg::convertLinalg3ToLLVM(Module &module, unsigned vectorWidth) {
+  assert(vectorWidth > 0 && "expected a positive vector width");
+  auto dotFunctions = replaceDotOpsWithCalls(module);
+
+  // Lower the views, the loads and stores, and the calls, along with the
+  // signatures of the dot functions, whose arguments become view descriptors.
+  convertToLLVM(module, [](llvm::BumpPtrAllocator *allocator,
+                           MLIRContext *context) {
+    return ConversionListBuilder<LoadOpConversion,
+                                 StoreOpConversion>::build(allocator, context);
+  });
+
+  for (auto &function : dotFunctions)
+    emitVectorizedDot(function.first, function.second, vectorWidth);
+}
@@ -28,7 +28,7 @@
 using namespace linalg;
 
 LinalgDialect::LinalgDialect(mlir::MLIRContext *context)
-    : Dialect("linalg", context) {
+    : Dialect(getDialectNamespace(), context) {
   addTypes<RangeType, ViewType>();
   addOperations<DotOp, LoadOp, MatvecOp, MatmulOp, RangeOp, SliceOp, StoreOp,
                 ViewOp>();
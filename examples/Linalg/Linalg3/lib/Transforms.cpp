@@ -33,7 +33,7 @@ using namespace linalg;
 using namespace linalg::intrinsics;
 
 void linalg::composeSliceOps(mlir::Function *f) {
-  f->walkPostOrder<SliceOp>([](SliceOp sliceOp) {
+  f->walkPostOrder([](SliceOp sliceOp) {
     auto *sliceResult = sliceOp.getResult();
     auto viewOp = createFullyComposedView(sliceResult);
     sliceResult->replaceAllUsesWith(viewOp.getResult());
@@ -80,18 +80,7 @@ static Value *makeFoldedComposedAffineApply(AffineMap map,
   return b->create<AffineApplyOp>(loc, map, operands).getResult();
 }
 
-struct RangeParts {
-  explicit RangeParts(unsigned reserved);
-  RangeParts(ArrayRef<Value *> ranges);
-
-  SmallVector<Value *, 4> makeRanges();
-
-  SmallVector<Value *, 4> mins;
-  SmallVector<Value *, 4> maxes;
-  SmallVector<Value *, 4> steps;
-};
-
-RangeParts::RangeParts(unsigned reserved) {
+linalg::RangeParts::RangeParts(unsigned reserved) {
   mins.reserve(reserved);
   maxes.reserve(reserved);
   steps.reserve(reserved);
@@ -109,12 +98,12 @@ extractFromRanges(ArrayRef<Value *> ranges,
   return res;
 }
 
-RangeParts::RangeParts(ArrayRef<Value *> ranges)
+linalg::RangeParts::RangeParts(ArrayRef<Value *> ranges)
     : mins(extractFromRanges(ranges, [](RangeOp r) { return r.getMin(); })),
       maxes(extractFromRanges(ranges, [](RangeOp r) { return r.getMax(); })),
       steps(extractFromRanges(ranges, [](RangeOp r) { return r.getStep(); })) {}
 
-SmallVector<Value *, 4> RangeParts::makeRanges() {
+SmallVector<Value *, 4> linalg::RangeParts::makeRanges() {
   SmallVector<Value *, 4> res;
   res.reserve(mins.size());
   for (auto z : llvm::zip(mins, maxes, steps)) {
@@ -146,9 +135,10 @@ SmallVector<Value *, 4> makeGenericRanges(AffineMap map,
   return makeGenericRangeParts(map, ranges).makeRanges();
 }
 
-static SmallVector<Value *, 4> makeGenericLoopRanges(
-    AffineMap operandRangesToLoopsMap, ArrayRef<Value *> ranges,
-    llvm::Optional<ArrayRef<Value *>> tileSizes = llvm::None) {
+SmallVector<Value *, 4>
+linalg::makeGenericLoopRanges(AffineMap operandRangesToLoopsMap,
+                              ArrayRef<Value *> ranges,
+                              llvm::Optional<ArrayRef<Value *>> tileSizes) {
   RangeParts res = makeGenericRangeParts(operandRangesToLoopsMap, ranges);
   if (!tileSizes.hasValue())
     return res.makeRanges();
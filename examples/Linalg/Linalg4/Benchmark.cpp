@@ -0,0 +1,304 @@
+//===- Benchmark.cpp - Benchmark of the Linalg matmul code generation -----===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This is a command line utility that builds a linalg.matmul on dynamically
+// sized memrefs, tiles it and lowers it to the LLVM IR dialect as configured,
+// JIT-compiles it with the ExecutionEngine, and times it on a sweep of matrix
+// sizes.  It prints a JSON report of the GFLOP/s of the compiled matmul and of
+// a naive C++ reference, whose result is also compared to the one of the
+// compiled matmul, to track the performance of the structured ops code
+// generation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "linalg1/Common.h"
+#include "linalg2/Intrinsics.h"
+#include "linalg3/ConvertToLLVMDialect.h"
+#include "linalg3/Ops.h"
+#include "linalg3/Transforms.h"
+#include "linalg4/Transforms.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Support/Benchmark.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace mlir;
+using namespace mlir::edsc;
+using namespace mlir::edsc::intrinsics;
+using namespace linalg;
+using namespace linalg::intrinsics;
+
+namespace {
+enum class ContractionLowering { Loops, Dot };
+} // end anonymous namespace
+
+static llvm::cl::list<std::string>
+    shapes("shapes",
+           llvm::cl::desc("Comma-separated list of the MxNxK sizes of the "
+                          "matrices, e.g. 128x256x64"),
+           llvm::cl::CommaSeparated);
+
+static llvm::cl::list<unsigned>
+    tileSizes("tile-sizes",
+              llvm::cl::desc("Comma-separated list of the tile sizes of the M "
+                             "and N loops, which must divide the sizes of the "
+                             "matrices; no tiling if empty"),
+              llvm::cl::CommaSeparated);
+
+static llvm::cl::opt<ContractionLowering> lowering(
+    "lowering", llvm::cl::desc("How the (tiled) matmul is lowered"),
+    llvm::cl::values(clEnumValN(ContractionLowering::Loops, "loops",
+                                "Scalar loops"),
+                     clEnumValN(ContractionLowering::Dot, "dot",
+                                "Loops of vectorized dot products")),
+    llvm::cl::init(ContractionLowering::Dot));
+
+static llvm::cl::opt<unsigned>
+    vectorWidth("vector-width",
+                llvm::cl::desc("Number of elements of the vectors of the dot "
+                               "products"),
+                llvm::cl::init(8));
+
+static llvm::cl::opt<unsigned>
+    optLevel("opt-level", llvm::cl::desc("LLVM IR optimization level"),
+             llvm::cl::init(3));
+
+static llvm::cl::opt<unsigned>
+    warmup("warmup", llvm::cl::desc("Number of untimed runs of each size"),
+           llvm::cl::init(1));
+
+static llvm::cl::opt<unsigned>
+    iterations("iterations",
+               llvm::cl::desc("Number of timed runs of each size"),
+               llvm::cl::init(5));
+
+namespace {
+/// The descriptor of a memref<?x?xf32> passed to the compiled function, see
+/// linalg1/ConvertToLLVMDialect.cpp.
+struct MemRef2D {
+  float *data;
+  int64_t rows;
+  int64_t columns;
+};
+
+/// The sizes of a matmul C(M, N) = A(M, K) * B(K, N).
+struct Shape {
+  int64_t m, n, k;
+};
+} // end anonymous namespace
+
+// Parse a shape spelled MxNxK.
+static llvm::Optional<Shape> parseShape(StringRef spelling) {
+  SmallVector<StringRef, 3> sizes;
+  spelling.split(sizes, 'x');
+  Shape shape;
+  if (sizes.size() != 3 || sizes[0].getAsInteger(10, shape.m) ||
+      sizes[1].getAsInteger(10, shape.n) || sizes[2].getAsInteger(10, shape.k))
+    return llvm::None;
+  return shape;
+}
+
+// Build the function "matmul" computing C = A * B on its memref arguments.
+static void makeMatmulFunction(Module &module) {
+  MLIRContext *context = module.getContext();
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, "matmul",
+      {dynamic2DMemRefType, dynamic2DMemRefType, dynamic2DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    N = dim(f->getArgument(2), 1),
+    K = dim(f->getArgument(0), 1),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rN = range(constant_index(0), N, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vB = view(f->getArgument(1), {rK, rN}),
+    vC = view(f->getArgument(2), {rM, rN});
+  matmul(vA, vB, vC);
+  ret();
+  // clang-format on
+}
+
+// Tile and lower the functions of `module` to the LLVM IR dialect as
+// configured.  The tiles are promoted to local buffers, so that the lowered
+// contractions iterate over views starting at zero.
+static void lowerModule(Module &module) {
+  SmallVector<int64_t, 2> sizes(tileSizes.begin(), tileSizes.end());
+  for (auto &f : module) {
+    if (!sizes.empty())
+      tileAndPromote(&f, sizes);
+    if (lowering == ContractionLowering::Dot) {
+      lowerToFinerGrainedTensorContraction(&f);
+      lowerToFinerGrainedTensorContraction(&f);
+    } else {
+      lowerToLoops(&f);
+    }
+  }
+  convertLinalg3ToLLVM(module, vectorWidth);
+}
+
+// Return `count` deterministic real values spread over [-1, 1].
+static std::vector<float> getRealValues(size_t count, unsigned seed) {
+  std::vector<float> values(count);
+  for (size_t i = 0; i < count; ++i)
+    values[i] = float(int64_t((i * 7919 + seed) % 2001) - 1000) / 1000.0f;
+  return values;
+}
+
+// Compute C = A * B with the textbook triple loop.
+static void referenceMatmul(const Shape &shape, const float *a, const float *b,
+                            float *c) {
+  for (int64_t i = 0; i < shape.m; ++i)
+    for (int64_t j = 0; j < shape.n; ++j) {
+      float sum = 0.0f;
+      for (int64_t k = 0; k < shape.k; ++k)
+        sum += a[i * shape.k + k] * b[k * shape.n + j];
+      c[i * shape.n + j] = sum;
+    }
+}
+
+// Return the best time of the configured number of runs of `run`, in
+// milliseconds, after the warm-up runs.
+template <typename Fn> static double timeRuns(Fn run) {
+  for (unsigned i = 0; i < warmup; ++i)
+    run();
+  double best = 0.0;
+  for (unsigned i = 0; i < iterations; ++i) {
+    auto start = BenchmarkClock::now();
+    run();
+    double elapsed = getElapsedMs(start);
+    best = i == 0 ? elapsed : std::min(best, elapsed);
+  }
+  return best;
+}
+
+// Return the GFLOP/s of a matmul of `shape` running in `ms` milliseconds.
+static double getGFlops(const Shape &shape, double ms) {
+  double flops = 2.0 * shape.m * shape.n * shape.k;
+  return ms > 0 ? flops / (ms * 1e6) : 0.0;
+}
+
+// Time the compiled `matmul` and the reference on matrices of `shape`, and
+// return the JSON report of the comparison.
+static llvm::json::Object runShape(const JITFunction &matmul,
+                                   const Shape &shape) {
+  std::vector<float> a = getRealValues(shape.m * shape.k, 0);
+  std::vector<float> b = getRealValues(shape.k * shape.n, 1);
+  std::vector<float> c(shape.m * shape.n), expected(shape.m * shape.n);
+  MemRef2D memrefA{a.data(), shape.m, shape.k};
+  MemRef2D memrefB{b.data(), shape.k, shape.n};
+  MemRef2D memrefC{c.data(), shape.m, shape.n};
+
+  double ms = timeRuns([&]() { matmul(memrefA, memrefB, memrefC); });
+  double referenceMs = timeRuns(
+      [&]() { referenceMatmul(shape, a.data(), b.data(), expected.data()); });
+
+  // The compiled matmul may accumulate in a different order.
+  double maxError = 0.0;
+  for (size_t i = 0, e = c.size(); i < e; ++i)
+    maxError = std::max(maxError, double(std::fabs(c[i] - expected[i])));
+  bool correct = maxError <= 1e-4 * shape.k;
+
+  return llvm::json::Object{
+      {"shape", llvm::formatv("{0}x{1}x{2}", shape.m, shape.n, shape.k).str()},
+      {"min_ms", ms},
+      {"gflops", getGFlops(shape, ms)},
+      {"reference_min_ms", referenceMs},
+      {"reference_gflops", getGFlops(shape, referenceMs)},
+      {"speedup", ms > 0 ? referenceMs / ms : 0.0},
+      {"max_abs_error", maxError},
+      {"correct", correct}};
+}
+
+int main(int argc, char **argv) {
+  llvm::PrettyStackTraceProgram x(argc, argv);
+  llvm::InitLLVM y(argc, argv);
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  initializeLLVMPasses();
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "Linalg matmul code generation "
+                                    "benchmark\n");
+
+  std::vector<std::string> spellings(shapes.begin(), shapes.end());
+  if (spellings.empty())
+    spellings = {"64x64x64", "128x128x128", "256x256x256", "512x512x512"};
+  SmallVector<Shape, 4> parsedShapes;
+  for (auto &spelling : spellings) {
+    auto shape = parseShape(spelling);
+    if (!shape) {
+      llvm::errs() << "invalid shape '" << spelling << "', expected MxNxK\n";
+      return 1;
+    }
+    int64_t parallelSizes[] = {shape->m, shape->n};
+    for (unsigned i = 0, e = std::min<size_t>(tileSizes.size(), 2); i < e; ++i)
+      if (tileSizes[i] == 0 || parallelSizes[i] % tileSizes[i] != 0) {
+        llvm::errs() << "tile size " << tileSizes[i] << " does not divide "
+                     << spelling << '\n';
+        return 1;
+      }
+    parsedShapes.push_back(*shape);
+  }
+
+  // The matmul is compiled once for all the sizes.
+  MLIRContext context;
+  Module module(&context);
+  makeMatmulFunction(module);
+  lowerModule(module);
+  if (failed(module.verify())) {
+    llvm::errs() << "the lowered module is invalid\n";
+    return 1;
+  }
+  auto engine = ExecutionEngine::create(
+      &module, makeOptimizingTransformer(optLevel, /*sizeLevel=*/0));
+  if (!engine) {
+    llvm::errs() << "failed to compile: "
+                 << llvm::toString(engine.takeError()) << '\n';
+    return 1;
+  }
+  auto matmul = (*engine)->getFunction("matmul");
+  if (!matmul) {
+    llvm::errs() << llvm::toString(matmul.takeError()) << '\n';
+    return 1;
+  }
+
+  llvm::json::Array reports;
+  bool allCorrect = true;
+  for (auto &shape : parsedShapes) {
+    auto report = runShape(*matmul, shape);
+    allCorrect &= *report.getBoolean("correct");
+    reports.push_back(std::move(report));
+  }
+  llvm::outs() << llvm::formatv("{0:2}", llvm::json::Value(std::move(reports)))
+               << '\n';
+  return allCorrect ? 0 : 1;
+}
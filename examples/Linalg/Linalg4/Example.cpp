@@ -0,0 +1,236 @@
+//===- Example.cpp - Our running example ----------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+// RUN: %p/test | FileCheck %s
+
+#include "TestHarness.h"
+#include "linalg1/Common.h"
+#include "linalg2/Intrinsics.h"
+#include "linalg3/Ops.h"
+#include "linalg4/Transforms.h"
+#include "mlir/IR/OpImplementation.h"
+
+using llvm::StringRef;
+
+using namespace mlir;
+using namespace mlir::edsc;
+using namespace mlir::edsc::intrinsics;
+using namespace linalg;
+using namespace linalg::common;
+using namespace linalg::intrinsics;
+
+Function *makeFunctionWithAMatmulOp(Module &module, StringRef name) {
+  MLIRContext *context = module.getContext();
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, name,
+      {dynamic2DMemRefType, dynamic2DMemRefType, dynamic2DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    N = dim(f->getArgument(2), 1),
+    K = dim(f->getArgument(0), 1),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rN = range(constant_index(0), N, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vB = view(f->getArgument(1), {rK, rN}),
+    vC = view(f->getArgument(2), {rM, rN});
+  matmul(vA, vB, vC);
+  ret();
+  // clang-format on
+
+  return f;
+}
+
+// Computes E = (A * B) * D, through the temporary C = A * B.
+Function *makeFunctionWithTwoMatmulOps(Module &module, StringRef name) {
+  MLIRContext *context = module.getContext();
+  auto dynamic2DMemRefType = floatMemRefType<2>(context);
+  mlir::Function *f = linalg::common::makeFunction(
+      module, name,
+      {dynamic2DMemRefType, dynamic2DMemRefType, dynamic2DMemRefType,
+       dynamic2DMemRefType, dynamic2DMemRefType}, {});
+
+  ScopedContext scope(f);
+  // clang-format off
+  ValueHandle
+    M = dim(f->getArgument(0), 0),
+    K = dim(f->getArgument(0), 1),
+    N = dim(f->getArgument(1), 1),
+    P = dim(f->getArgument(3), 1),
+    rM = range(constant_index(0), M, constant_index(1)),
+    rK = range(constant_index(0), K, constant_index(1)),
+    rN = range(constant_index(0), N, constant_index(1)),
+    rP = range(constant_index(0), P, constant_index(1)),
+    vA = view(f->getArgument(0), {rM, rK}),
+    vB = view(f->getArgument(1), {rK, rN}),
+    vC = view(f->getArgument(2), {rM, rN}),
+    vD = view(f->getArgument(3), {rN, rP}),
+    vE = view(f->getArgument(4), {rM, rP});
+  matmul(vA, vB, vC);
+  matmul(vC, vD, vE);
+  ret();
+  // clang-format on
+
+  return f;
+}
+
+TEST_FUNC(matmul_tiled_views) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f = makeFunctionWithAMatmulOp(module, "matmul_tiled_views");
+  lowerToTiledViews(f, {8, 9});
+  // clang-format off
+  // CHECK-LABEL: func @matmul_tiled_views(%arg0: memref<?x?xf32>, %arg1: memref<?x?xf32>, %arg2: memref<?x?xf32>) {
+  //       CHECK: %[[M:.*]] = dim %arg0, 0 : memref<?x?xf32>
+  //       CHECK: %[[N:.*]] = dim %arg2, 1 : memref<?x?xf32>
+  //       CHECK: %[[vA:.*]] = linalg.view %arg0[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vB:.*]] = linalg.view %arg1[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vC:.*]] = linalg.view %arg2[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: affine.for %i0 = 0 to (d0) -> (d0)(%[[M]]) step 8 {
+  //  CHECK-NEXT:   affine.for %i1 = 0 to (d0) -> (d0)(%[[N]]) step 9 {
+  //       CHECK:     %[[ri:.*]] = linalg.range %i0:{{.*}} : !linalg<"range">
+  //       CHECK:     %[[rj:.*]] = linalg.range %i1:{{.*}} : !linalg<"range">
+  //       CHECK:     %[[sA:.*]] = linalg.slice %[[vA]][%[[ri]].., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:     %[[sB:.*]] = linalg.slice %[[vB]][*, %[[rj]]..] { dim : 1 } : !linalg<"view<f32xf32>">
+  //       CHECK:     %[[sC0:.*]] = linalg.slice %[[vC]][%[[ri]].., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:     %[[sC:.*]] = linalg.slice %[[sC0]][*, %[[rj]]..] { dim : 1 } : !linalg<"view<f32xf32>">
+  //       CHECK:     linalg.matmul {%[[sA]], %[[sB]]} -> {%[[sC]]}
+  // clang-format on
+  cleanupAndPrintFunction(f);
+}
+
+TEST_FUNC(matmul_tile_and_fuse) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithTwoMatmulOps(module, "matmul_tile_and_fuse");
+  tileAndFuse(f, {8});
+  // clang-format off
+  // CHECK-LABEL: func @matmul_tile_and_fuse(%arg0: memref<?x?xf32>, %arg1: memref<?x?xf32>, %arg2: memref<?x?xf32>, %arg3: memref<?x?xf32>, %arg4: memref<?x?xf32>) {
+  //       CHECK: %[[M:.*]] = dim %arg0, 0 : memref<?x?xf32>
+  //       CHECK: %[[vA:.*]] = linalg.view %arg0[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vB:.*]] = linalg.view %arg1[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vC:.*]] = linalg.view %arg2[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vD:.*]] = linalg.view %arg3[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vE:.*]] = linalg.view %arg4[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //   CHECK-NOT: linalg.matmul
+  //       CHECK: affine.for %i0 = 0 to (d0) -> (d0)(%[[M]]) step 8 {
+  //       CHECK:   %[[ri:.*]] = linalg.range %i0:{{.*}} : !linalg<"range">
+  //       CHECK:   %[[sA:.*]] = linalg.slice %[[vA]][%[[ri]].., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:   %[[sC:.*]] = linalg.slice %[[vC]][%[[ri]].., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:   linalg.matmul {%[[sA]], %[[vB]]} -> {%[[sC]]}
+  //       CHECK:   %[[sE:.*]] = linalg.slice %[[vE]][%[[ri]].., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:   linalg.matmul {%[[sC]], %[[vD]]} -> {%[[sE]]}
+  //   CHECK-NOT: linalg.matmul
+  // clang-format on
+  cleanupAndPrintFunction(f);
+}
+
+TEST_FUNC(matmul_tile_and_promote) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithAMatmulOp(module, "matmul_tile_and_promote");
+  tileAndPromote(f, {8, 9});
+  // clang-format off
+  // CHECK-LABEL: func @matmul_tile_and_promote(%arg0: memref<?x?xf32>, %arg1: memref<?x?xf32>, %arg2: memref<?x?xf32>) {
+  //       CHECK: %[[M:.*]] = dim %arg0, 0 : memref<?x?xf32>
+  //       CHECK: %[[N:.*]] = dim %arg2, 1 : memref<?x?xf32>
+  //       CHECK: %[[K:.*]] = dim %arg0, 1 : memref<?x?xf32>
+  //       CHECK: %[[vA:.*]] = linalg.view %arg0[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vB:.*]] = linalg.view %arg1[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[bufA:.*]] = alloc(%[[K]]) : memref<8x?xf32>
+  //       CHECK: %[[pA:.*]] = linalg.view %[[bufA]][{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[bufB:.*]] = alloc(%[[K]]) : memref<?x9xf32>
+  //       CHECK: %[[pB:.*]] = linalg.view %[[bufB]][{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: affine.for %i0 = 0 to (d0) -> (d0)(%[[M]]) step 8 {
+  //       CHECK:   %[[sA:.*]] = linalg.slice %[[vA]][{{.*}}.., *] { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:   affine.for %[[a0:.*]] = 0 to 8 {
+  //  CHECK-NEXT:     affine.for %[[a1:.*]] = 0 to (d0) -> (d0)(%[[K]]) {
+  //  CHECK-NEXT:       %[[a:.*]] = linalg.load %[[sA]][%[[a0]], %[[a1]]] : !linalg<"view<f32xf32>">
+  //  CHECK-NEXT:       linalg.store %[[a]], %[[pA]][%[[a0]], %[[a1]]] : !linalg<"view<f32xf32>">
+  //       CHECK:   affine.for %{{.*}} = 0 to (d0) -> (d0)(%[[N]]) step 9 {
+  //       CHECK:     %[[sB:.*]] = linalg.slice %[[vB]][*, {{.*}}..] { dim : 1 } : !linalg<"view<f32xf32>">
+  //       CHECK:     affine.for %[[b0:.*]] = 0 to (d0) -> (d0)(%[[K]]) {
+  //  CHECK-NEXT:       affine.for %[[b1:.*]] = 0 to 9 {
+  //  CHECK-NEXT:         %[[b:.*]] = linalg.load %[[sB]][%[[b0]], %[[b1]]] : !linalg<"view<f32xf32>">
+  //  CHECK-NEXT:         linalg.store %[[b]], %[[pB]][%[[b0]], %[[b1]]] : !linalg<"view<f32xf32>">
+  //       CHECK:     linalg.matmul {%[[pA]], %[[pB]]} -> {%{{.*}}}
+  //       CHECK: dealloc %[[bufB]] : memref<?x9xf32>
+  //  CHECK-NEXT: dealloc %[[bufA]] : memref<8x?xf32>
+  // clang-format on
+  cleanupAndPrintFunction(f);
+}
+
+// Registers an 8x8xK f32 matmul micro-kernel, after one for 4x4xK tiles, and
+// a wrapper around sgemm for all the other f32 matmuls.
+static MicroKernelRegistry makeMatmulKernelRegistry(MLIRContext *context) {
+  MicroKernelRegistry registry;
+  Type f32 = FloatType::getF32(context);
+  registry.registerKernel("matmul_4x4xK", MatmulOp::getOperationName(), f32,
+                          {4, 4, -1});
+  registry.registerKernel("matmul_8x8xK", MatmulOp::getOperationName(), f32,
+                          {8, 8, -1});
+  registry.registerKernel("sgemm", MatmulOp::getOperationName(), f32,
+                          {-1, -1, -1});
+  return registry;
+}
+
+TEST_FUNC(matmul_tiled_micro_kernel) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f =
+      makeFunctionWithAMatmulOp(module, "matmul_tiled_micro_kernel");
+  lowerToTiledViews(f, {8, 8});
+  lowerToMicroKernels(f, makeMatmulKernelRegistry(&context));
+  // clang-format off
+  // CHECK-LABEL: func @matmul_tiled_micro_kernel(%arg0: memref<?x?xf32>, %arg1: memref<?x?xf32>, %arg2: memref<?x?xf32>) {
+  //       CHECK: affine.for %i0 = 0 to (d0) -> (d0)(%{{.*}}) step 8 {
+  //  CHECK-NEXT:   affine.for %i1 = 0 to (d0) -> (d0)(%{{.*}}) step 8 {
+  //       CHECK:     %[[sA:.*]] = linalg.slice {{.*}} { dim : 0 } : !linalg<"view<f32xf32>">
+  //       CHECK:     %[[sB:.*]] = linalg.slice {{.*}} { dim : 1 } : !linalg<"view<f32xf32>">
+  //       CHECK:     %[[sC:.*]] = linalg.slice {{.*}} { dim : 1 } : !linalg<"view<f32xf32>">
+  //  CHECK-NEXT:     call @matmul_8x8xK(%[[sA]], %[[sB]], %[[sC]]) : (!linalg<"view<f32xf32>">, !linalg<"view<f32xf32>">, !linalg<"view<f32xf32>">) -> ()
+  //   CHECK-NOT: linalg.matmul
+  // clang-format on
+  cleanupAndPrintFunction(f);
+}
+
+TEST_FUNC(matmul_sgemm) {
+  MLIRContext context;
+  Module module(&context);
+  mlir::Function *f = makeFunctionWithAMatmulOp(module, "matmul_sgemm");
+  lowerToMicroKernels(f, makeMatmulKernelRegistry(&context));
+  // clang-format off
+  // CHECK-LABEL: func @matmul_sgemm(%arg0: memref<?x?xf32>, %arg1: memref<?x?xf32>, %arg2: memref<?x?xf32>) {
+  //       CHECK: %[[vA:.*]] = linalg.view %arg0[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vB:.*]] = linalg.view %arg1[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //       CHECK: %[[vC:.*]] = linalg.view %arg2[{{.*}}, {{.*}}] : !linalg<"view<f32xf32>">
+  //  CHECK-NEXT: call @sgemm(%[[vA]], %[[vB]], %[[vC]]) : (!linalg<"view<f32xf32>">, !linalg<"view<f32xf32>">, !linalg<"view<f32xf32>">) -> ()
+  //   CHECK-NOT: linalg.matmul
+  // clang-format on
+  cleanupAndPrintFunction(f);
+}
+
+int main() {
+  RUN_TESTS();
+  return 0;
+}
@@ -0,0 +1,131 @@
+//===- Transforms.h - Linalg dialect Transformations definition -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#ifndef LINALG4_TRANSFORMS_H_
+#define LINALG4_TRANSFORMS_H_
+
+#include "linalg3/Transforms.h"
+#include "mlir/IR/Types.h"
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/Optional.h"
+
+#include <string>
+#include <vector>
+
+namespace mlir {
+class AffineForOp;
+class Function;
+class Operation;
+} // namespace mlir
+
+namespace linalg {
+
+/// Rewrites the tensor contraction `op` as a nest of loops over tiles of its
+/// parallel dimensions, whose body applies the contraction to linalg.slice of
+/// its views.  The i-th tile size applies to the i-th parallel loop; the
+/// reduction loops, and the parallel loops beyond `tileSizes`, are not tiled,
+/// so that the tiles of the output are fully reduced.  The tile sizes are
+/// expected to divide the sizes of the views.
+/// The contractions in `producers` write an input view of `op` and are
+/// recomputed in each tile, on the slices of their views that compute the
+/// tile of the input, see `tileAndFuse`.
+/// Returns the tile loops, or llvm::None if `op` has no loop to tile, in which
+/// case the IR is unchanged.  `op` and `producers` are not erased.
+llvm::Optional<llvm::SmallVector<mlir::AffineForOp, 4>>
+writeAsTiledViews(mlir::Operation *op, llvm::ArrayRef<int64_t> tileSizes,
+                  llvm::ArrayRef<mlir::Operation *> producers = {});
+
+/// Traverses `f` and rewrites the linalg tensor contractions as tiled loops
+/// over linalg.slice of their views.
+void lowerToTiledViews(mlir::Function *f, llvm::ArrayRef<int64_t> tileSizes);
+
+/// Traverses `f` backwards, and tiles each linalg tensor contraction as
+/// `lowerToTiledViews` does, after fusing into its tiles the contractions that
+/// produce its inputs: a contraction writing the very view that a later one
+/// reads is computed tile by tile in the loops of its consumer, and its
+/// original instance is erased.  The producer must be in the same block as
+/// the consumer, with no operation in between that may access the memrefs of
+/// the producer.
+void tileAndFuse(mlir::Function *f, llvm::ArrayRef<int64_t> tileSizes);
+
+/// Copies the tiles that the tensor contraction `op` reads through linalg.slice
+/// into local buffers of the size of the tiles, in which the elements of a
+/// tile are contiguous, and rewrites `op` to read the copies.  The buffers are
+/// allocated before the outermost loop enclosing `op` and deallocated after
+/// it.  The copy of a tile is hoisted out of the enclosing loops whose
+/// iterations do not change the tile and do not write its memref, e.g. the
+/// tile of A in a matmul tiled along M and N is copied once per tile of M.
+/// The tiles must have unit steps, and their sizes across the enclosing loops
+/// must be constants or defined before these loops.
+void promoteTiles(mlir::Operation *op);
+
+/// Traverses `f` and tiles the linalg tensor contractions as
+/// `lowerToTiledViews` does, then promotes the input tiles of the tiled
+/// contractions to local buffers with `promoteTiles`.
+void tileAndPromote(mlir::Function *f, llvm::ArrayRef<int64_t> tileSizes);
+
+/// A hand-optimized implementation of a linalg tensor contraction, provided
+/// by an external library, e.g. an 8x8xK f32 matmul micro-kernel, or a wrapper
+/// around BLAS sgemm for the larger shapes.  The external function takes the
+/// views of the contraction in the order of its operands, which the lowering
+/// to the LLVM IR dialect passes as view descriptors, and returns nothing.
+struct MicroKernel {
+  /// The name of the external function.
+  std::string name;
+  /// The name of the contraction implemented, e.g. "linalg.matmul".
+  std::string opName;
+  /// The element type of the views.
+  mlir::Type elementType;
+  /// The number of iterations of each loop of the contraction, in the order of
+  /// its loops, or -1 for the loops of any size.
+  llvm::SmallVector<int64_t, 4> loopSizes;
+};
+
+/// A list of micro-kernels, in decreasing order of priority: a contraction is
+/// implemented by the first kernel that supports its operation, element type
+/// and loop sizes.  A kernel accepting any size registered last, e.g. for
+/// sgemm, catches the contractions that no specialized kernel supports.
+class MicroKernelRegistry {
+public:
+  void registerKernel(llvm::StringRef name, llvm::StringRef opName,
+                      mlir::Type elementType,
+                      llvm::ArrayRef<int64_t> loopSizes);
+
+  /// Returns the first kernel implementing the tensor contraction `op`, or
+  /// nullptr if there is none.  The sizes of the loops of `op` are known when
+  /// the ranges of its views fold to constant sizes with unit steps, as they
+  /// do for the tiles produced by `lowerToTiledViews` and `promoteTiles`.
+  const MicroKernel *lookup(mlir::Operation *op) const;
+
+private:
+  std::vector<MicroKernel> kernels;
+};
+
+/// Replaces the tensor contraction `op` with a call to `kernel` on its views,
+/// and declares the external function of the kernel in the module if it is
+/// not already.  `op` is erased.
+void writeAsMicroKernelCall(mlir::Operation *op, const MicroKernel &kernel);
+
+/// Traverses `f` and replaces each linalg tensor contraction for which
+/// `registry` has a kernel with a call to that kernel.  The other
+/// contractions are left unchanged, to be lowered to loops by `lowerToLoops`.
+void lowerToMicroKernels(mlir::Function *f,
+                         const MicroKernelRegistry &registry);
+
+} // namespace linalg
+
+#endif // LINALG4_TRANSFORMS_H_
@@ -0,0 +1,573 @@
+//===- Transforms.cpp - Implementation of the linalg Transformations ------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the tiling of the linalg tensor contractions at the
+// level of views, the fusion of the producers of their inputs into their
+// tiles, the promotion of their input tiles to local buffers, and the
+// dispatch of the contractions to external micro-kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#include "linalg4/Transforms.h"
+#include "linalg1/Analysis.h"
+#include "linalg1/Common.h"
+#include "linalg1/Utils.h"
+#include "linalg3/Intrinsics.h"
+#include "linalg3/Ops.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/OpImplementation.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/StandardOps/Ops.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+
+using namespace mlir;
+using namespace mlir::edsc;
+using namespace mlir::edsc::intrinsics;
+using namespace linalg;
+using namespace linalg::intrinsics;
+
+static bool isContraction(Operation *op) {
+  return op->isa<MatmulOp>() || op->isa<MatvecOp>() || op->isa<DotOp>();
+}
+
+static bool isConstantIndex(Value *value, int64_t constant) {
+  auto *def = value->getDefiningOp();
+  if (!def || !def->isa<ConstantIndexOp>())
+    return false;
+  return def->cast<ConstantIndexOp>().getValue() == constant;
+}
+
+static unsigned getNumParallelDims(Operation *op) {
+  if (op->isa<MatmulOp>())
+    return MatmulOp::numParallelDims;
+  if (op->isa<MatvecOp>())
+    return MatvecOp::numParallelDims;
+  return DotOp::numParallelDims;
+}
+
+static AffineMap getLoopsToOperandRangesMap(Operation *op) {
+  if (auto matmulOp = op->dyn_cast<MatmulOp>())
+    return matmulOp.loopsToOperandRangesMap();
+  if (auto matvecOp = op->dyn_cast<MatvecOp>())
+    return matvecOp.loopsToOperandRangesMap();
+  return op->cast<DotOp>().loopsToOperandRangesMap();
+}
+
+// Returns the position of the loop iterating over the range that is the
+// `result`-th result of `loopsToOperandRangesMap`.
+static unsigned getLoopPosition(AffineMap loopsToOperandRangesMap,
+                                unsigned result) {
+  return loopsToOperandRangesMap.getResult(result)
+      .cast<AffineDimExpr>()
+      .getPosition();
+}
+
+template <class ContractionOp>
+static SmallVector<Value *, 4>
+makeTiledLoopRanges(ContractionOp contraction, ArrayRef<Value *> tileSizes) {
+  return makeGenericLoopRanges(operandRangesToLoopsMap(contraction),
+                               getRanges(contraction), tileSizes);
+}
+
+static SmallVector<Value *, 4>
+makeTiledLoopRanges(Operation *op, ArrayRef<Value *> tileSizes) {
+  if (auto matmulOp = op->dyn_cast<MatmulOp>())
+    return makeTiledLoopRanges(matmulOp, tileSizes);
+  if (auto matvecOp = op->dyn_cast<MatvecOp>())
+    return makeTiledLoopRanges(matvecOp, tileSizes);
+  return makeTiledLoopRanges(op->cast<DotOp>(), tileSizes);
+}
+
+// Slices `view` along each of its dimensions that a loop with a range in
+// `tileRanges` iterates over.  The ranges of the dimensions of `view` are the
+// results of `loopsToOperandRangesMap` starting at `firstResult`.
+static Value *sliceView(Value *view, AffineMap loopsToOperandRangesMap,
+                        unsigned firstResult, ArrayRef<Value *> tileRanges) {
+  for (unsigned d = 0, rank = getViewRank(view); d < rank; ++d) {
+    unsigned loop = getLoopPosition(loopsToOperandRangesMap, firstResult + d);
+    if (tileRanges[loop])
+      view = slice(view, tileRanges[loop], d);
+  }
+  return view;
+}
+
+// Emits, at the current insertion point, the contraction `op` applied to the
+// slices of its views along the loops that have a range in `tileRanges`.
+static void emitTiledContraction(Operation *op, ArrayRef<Value *> tileRanges) {
+  AffineMap map = getLoopsToOperandRangesMap(op);
+  SmallVector<Value *, 4> views;
+  unsigned firstResult = 0;
+  for (auto *operand : op->getOperands()) {
+    views.push_back(sliceView(operand, map, firstResult, tileRanges));
+    firstResult += getViewRank(operand);
+  }
+  OperationState state(op->getContext(), ScopedContext::getLocation(),
+                       op->getName());
+  state.addOperands(views);
+  ScopedContext::getBuilder()->createOperation(state);
+}
+
+// Returns the tile ranges of the loops of `producer` that compute the tile of
+// its output view read by `consumer`, given the `tileRanges` of the loops of
+// `consumer`.
+static SmallVector<Value *, 4>
+getProducerTileRanges(Operation *producer, Operation *consumer,
+                      ArrayRef<Value *> tileRanges) {
+  Value *view = producer->getOperand(producer->getNumOperands() - 1);
+  AffineMap producerMap = getLoopsToOperandRangesMap(producer);
+  AffineMap consumerMap = getLoopsToOperandRangesMap(consumer);
+  unsigned rank = getViewRank(view);
+  unsigned producerFirstResult = producerMap.getNumResults() - rank;
+  unsigned consumerFirstResult = 0;
+  for (auto *operand : consumer->getOperands()) {
+    if (operand == view)
+      break;
+    consumerFirstResult += getViewRank(operand);
+  }
+
+  SmallVector<Value *, 4> res(producerMap.getNumDims(), nullptr);
+  for (unsigned d = 0; d < rank; ++d) {
+    unsigned producerLoop =
+        getLoopPosition(producerMap, producerFirstResult + d);
+    unsigned consumerLoop =
+        getLoopPosition(consumerMap, consumerFirstResult + d);
+    res[producerLoop] = tileRanges[consumerLoop];
+  }
+  return res;
+}
+
+Optional<SmallVector<AffineForOp, 4>>
+linalg::writeAsTiledViews(Operation *op, ArrayRef<int64_t> tileSizes,
+                          ArrayRef<Operation *> producers) {
+  assert(isContraction(op) && "expected a tensor contraction");
+  unsigned numTiledLoops =
+      std::min<unsigned>(tileSizes.size(), getNumParallelDims(op));
+  if (numTiledLoops == 0)
+    return llvm::None;
+
+  ScopedContext scope(FuncBuilder(op), op->getLoc());
+  SmallVector<Value *, 4> tileSizeValues;
+  tileSizeValues.reserve(numTiledLoops);
+  for (auto tileSize : tileSizes.take_front(numTiledLoops))
+    tileSizeValues.push_back(constant_index(tileSize));
+  auto loopRanges = makeTiledLoopRanges(op, tileSizeValues);
+  unsigned numLoops = getLoopsToOperandRangesMap(op).getNumDims();
+
+  SmallVector<IndexHandle, 4> ivs(numTiledLoops);
+  auto pivs = IndexHandle::makeIndexHandlePointers(ivs);
+  // clang-format off
+  using linalg::common::LoopNestRangeBuilder;
+  LoopNestRangeBuilder(pivs, loopRanges)({
+    [op, producers, numLoops, &ivs, &loopRanges]() {
+      using edsc::op::operator+;
+      using edsc::op::operator-;
+      // The views are sliced with ranges of offsets from their beginning, so
+      // the tile of a loop starts at the distance of its iv from the lower
+      // bound of the loop, i.e. at the iv itself for loops starting at 0, and
+      // spans one (tiled) step of the loop.
+      SmallVector<Value *, 4> tileRanges(numLoops, nullptr);
+      for (unsigned i = 0, e = ivs.size(); i < e; ++i) {
+        auto loopRange = loopRanges[i]->getDefiningOp()->cast<RangeOp>();
+        ValueHandle offset =
+            isConstantIndex(loopRange.getMin(), 0)
+                ? ValueHandle(ivs[i])
+                : ivs[i] - ValueHandle(loopRange.getMin());
+        tileRanges[i] = range(offset, offset + ValueHandle(loopRange.getStep()),
+                              constant_index(1));
+      }
+      for (auto *producer : producers)
+        emitTiledContraction(
+            producer, getProducerTileRanges(producer, op, tileRanges));
+      emitTiledContraction(op, tileRanges);
+      /// NestedBuilders expect handles, we thus return an IndexHandle.
+      return IndexHandle();
+    }()
+  });
+  // clang-format on
+
+  SmallVector<AffineForOp, 4> res;
+  res.reserve(numTiledLoops);
+  for (auto iv : ivs)
+    res.push_back(getForInductionVarOwner(iv.getValue()));
+  return res;
+}
+
+// Collects the tensor contractions of `f` in order.  They are collected before
+// being rewritten, as the rewrites create new contractions in the tile loops.
+static SmallVector<Operation *, 8> getContractions(Function *f) {
+  SmallVector<Operation *, 8> contractions;
+  f->walk([&contractions](Operation *op) {
+    if (isContraction(op))
+      contractions.push_back(op);
+  });
+  return contractions;
+}
+
+void linalg::lowerToTiledViews(Function *f, ArrayRef<int64_t> tileSizes) {
+  for (auto *op : getContractions(f))
+    if (writeAsTiledViews(op, tileSizes))
+      op->erase();
+}
+
+// Returns the memref that `value` is, or is a view of, or null.
+static Value *getAccessedMemRef(Value *value) {
+  if (value->getType().isa<ViewType>())
+    return getViewSupportingMemRef(value);
+  if (value->getType().isa<MemRefType>())
+    return value;
+  return nullptr;
+}
+
+// Returns the contraction writing the `input` view of `consumer` that may be
+// recomputed in the tiles of `consumer`, or null if there is none.  Recomputing
+// the producer after the operations that follow it must not change what these
+// operations, nor the producer itself, read and write.
+static Operation *getFusableProducer(Operation *consumer, Value *input) {
+  Operation *producer = nullptr;
+  Block *block = consumer->getBlock();
+  for (auto it = Block::iterator(consumer); it != block->begin();) {
+    Operation &candidate = *--it;
+    if (isContraction(&candidate) &&
+        candidate.getOperand(candidate.getNumOperands() - 1) == input) {
+      producer = &candidate;
+      break;
+    }
+  }
+  if (!producer)
+    return nullptr;
+
+  SmallPtrSet<Value *, 4> memRefs;
+  for (auto *operand : producer->getOperands())
+    memRefs.insert(getViewSupportingMemRef(operand));
+  auto accessesProducerMemRefs = [&memRefs](Operation &op) {
+    return llvm::any_of(op.getOperands(), [&memRefs](Value *operand) {
+      return memRefs.count(getAccessedMemRef(operand)) != 0;
+    });
+  };
+  for (auto it = std::next(Block::iterator(producer)),
+            end = Block::iterator(consumer);
+       it != end; ++it) {
+    if (it->hasNoSideEffect())
+      continue;
+    if (it->getNumRegions() != 0 || accessesProducerMemRefs(*it))
+      return nullptr;
+  }
+
+  // The tiles of the producer are computed after the first tiles of the
+  // consumer, which must therefore not overwrite the memrefs of the producer.
+  Value *output = consumer->getOperand(consumer->getNumOperands() - 1);
+  if (memRefs.count(getViewSupportingMemRef(output)))
+    return nullptr;
+  return producer;
+}
+
+void linalg::tileAndFuse(Function *f, ArrayRef<int64_t> tileSizes) {
+  // Visit the consumers before their producers, so that the producers fused
+  // into the tiles of a consumer can be skipped once they are erased.
+  auto contractions = getContractions(f);
+  SmallPtrSet<Operation *, 8> fused;
+  for (auto *op : llvm::reverse(contractions)) {
+    if (fused.count(op))
+      continue;
+    SmallVector<Operation *, 2> producers;
+    for (unsigned i = 0, e = op->getNumOperands() - 1; i < e; ++i) {
+      auto *producer = getFusableProducer(op, op->getOperand(i));
+      if (producer && !llvm::is_contained(producers, producer))
+        producers.push_back(producer);
+    }
+    if (!writeAsTiledViews(op, tileSizes, producers))
+      continue;
+    op->erase();
+    for (auto *producer : producers) {
+      producer->erase();
+      fused.insert(producer);
+    }
+  }
+}
+
+// Returns `max - min` if it folds to a constant, or -1.
+static int64_t getConstantSize(Value *min, Value *max) {
+  auto *context = min->getType().getContext();
+  auto map = AffineMap::get(
+      2, 0, getAffineDimExpr(1, context) - getAffineDimExpr(0, context), {});
+  SmallVector<Value *, 4> operands{min, max};
+  fullyComposeAffineMapAndOperands(&map, &operands);
+  canonicalizeMapAndOperands(&map, &operands);
+  auto expr = simplifyAffineExpr(map.getResult(0), map.getNumDims(),
+                                 map.getNumSymbols());
+  if (auto constant = expr.dyn_cast<AffineConstantExpr>())
+    return constant.getValue();
+  return -1;
+}
+
+// Collects in `defs`, after the operations they depend on, the operations
+// nested in `loop` that `value` transitively depends on.
+static void getDefsInLoop(Value *value, AffineForOp loop,
+                          llvm::SetVector<Operation *> &defs) {
+  auto *def = value->getDefiningOp();
+  if (!def || defs.count(def) ||
+      !loop.getBody()->findAncestorInstInBlock(*def))
+    return;
+  for (auto *operand : def->getOperands())
+    getDefsInLoop(operand, loop, defs);
+  defs.insert(def);
+}
+
+// Returns true if an operation nested in `loop`, other than `reader`, may
+// write `memRef`.
+static bool mayWriteInLoop(AffineForOp loop, Value *memRef,
+                           Operation *reader) {
+  bool mayWrite = false;
+  loop.getOperation()->walk([&](Operation *op) {
+    if (op == reader || op->hasNoSideEffect() || op->getNumRegions() != 0 ||
+        op->isa<linalg::LoadOp>())
+      return;
+    if (isContraction(op)) {
+      Value *output = op->getOperand(op->getNumOperands() - 1);
+      mayWrite |= getViewSupportingMemRef(output) == memRef;
+      return;
+    }
+    mayWrite |= llvm::any_of(op->getOperands(), [memRef](Value *operand) {
+      return getAccessedMemRef(operand) == memRef;
+    });
+  });
+  return mayWrite;
+}
+
+// Copies the tile that the `index`-th operand of `op` is into a local buffer,
+// as described in `promoteTiles`, or leaves the IR unchanged if the tile
+// cannot be promoted.  `loops` are the loops enclosing `op`, outermost first.
+static void promoteTile(Operation *op, unsigned index,
+                        ArrayRef<AffineForOp> loops) {
+  Value *tile = op->getOperand(index);
+  unsigned rank = getViewRank(tile);
+  auto baseViewOp = getViewBaseViewOp(tile);
+  if (rank == 0 || rank != getViewRank(baseViewOp.getResult()))
+    return;
+  for (auto *range : baseViewOp.getRanges())
+    if (!isConstantIndex(range->getDefiningOp()->cast<RangeOp>().getStep(), 1))
+      return;
+
+  // The ranges of the tile are offsets from the beginning of its base view,
+  // the number of elements of a dimension is therefore `max - min`.
+  SmallVector<Value *, 4> ranges;
+  ranges.reserve(rank);
+  for (unsigned d = 0; d < rank; ++d)
+    ranges.push_back(getViewRootIndexing(tile, d).first);
+  RangeParts parts(ranges);
+  SmallVector<int64_t, 4> shape;
+  shape.reserve(rank);
+  for (unsigned d = 0; d < rank; ++d) {
+    if (!isConstantIndex(parts.steps[d], 1))
+      return;
+    shape.push_back(getConstantSize(parts.mins[d], parts.maxes[d]));
+    if (shape.back() < 0 &&
+        (!isValidSymbol(parts.mins[d]) || !isValidSymbol(parts.maxes[d])))
+      return;
+  }
+
+  // Hoist the copy out of the innermost loops that neither change the tile
+  // nor write its memref, along with the computation of the tile.
+  Value *memRef = getViewSupportingMemRef(tile);
+  Operation *insertionPoint = op;
+  llvm::SetVector<Operation *> hoistedDefs;
+  for (auto loop : llvm::reverse(loops)) {
+    llvm::SetVector<Operation *> defs;
+    getDefsInLoop(tile, loop, defs);
+    auto *iv = loop.getInductionVar();
+    bool isInvariant = llvm::all_of(defs, [iv](Operation *def) {
+      return def->hasNoSideEffect() &&
+             !llvm::is_contained(def->getOperands(), iv);
+    });
+    if (!isInvariant || mayWriteInLoop(loop, memRef, op))
+      break;
+    insertionPoint = loop.getOperation();
+    hoistedDefs = std::move(defs);
+  }
+  for (auto *def : hoistedDefs)
+    def->moveBefore(insertionPoint);
+
+  // Allocate the buffer and its view before the loops, with the sizes of the
+  // tile.
+  auto *outermostLoop = loops.front().getOperation();
+  ScopedContext scope(FuncBuilder(outermostLoop), op->getLoc());
+  ValueHandle zero = constant_index(0), one = constant_index(1);
+  SmallVector<ValueHandle, 4> sizes;
+  SmallVector<ValueHandle, 4> dynamicSizes;
+  SmallVector<Value *, 4> bufferRanges;
+  for (unsigned d = 0; d < rank; ++d) {
+    using edsc::op::operator-;
+    if (shape[d] < 0) {
+      // Tiles spanning a whole dimension start at 0, whose size is then the
+      // upper bound itself rather than an identity affine.apply of it.
+      sizes.push_back(isConstantIndex(parts.mins[d], 0)
+                          ? ValueHandle(parts.maxes[d])
+                          : ValueHandle(parts.maxes[d]) -
+                                ValueHandle(parts.mins[d]));
+      dynamicSizes.push_back(sizes.back());
+    } else {
+      sizes.push_back(constant_index(shape[d]));
+    }
+    bufferRanges.push_back(range(zero, sizes.back(), one));
+  }
+  auto elementType = tile->getType().cast<ViewType>().getElementType();
+  ValueHandle buffer = alloc(MemRefType::get(shape, elementType, {}, 0),
+                             ArrayRef<ValueHandle>(dynamicSizes));
+  Value *localView = view(buffer, bufferRanges);
+  {
+    ScopedContext deallocScope(
+        FuncBuilder(outermostLoop->getBlock(),
+                    std::next(Block::iterator(outermostLoop))),
+        op->getLoc());
+    dealloc(buffer);
+  }
+
+  // Copy the tile element by element.
+  {
+    using IndexedValue = TemplatedIndexedValue<linalg::intrinsics::load,
+                                               linalg::intrinsics::store>;
+    ScopedContext copyScope(FuncBuilder(insertionPoint), op->getLoc());
+    SmallVector<IndexHandle, 4> ivs(rank);
+    auto pivs = IndexHandle::makeIndexHandlePointers(ivs);
+    SmallVector<ValueHandle, 4> lbs(rank, zero);
+    SmallVector<int64_t, 4> steps(rank, 1);
+    IndexedValue source(tile), destination(localView);
+    LoopNestBuilder(pivs, lbs, sizes, steps)({
+      destination(ivs) = source(ivs)
+    });
+  }
+  op->setOperand(index, localView);
+}
+
+void linalg::promoteTiles(Operation *op) {
+  assert(isContraction(op) && "expected a tensor contraction");
+  SmallVector<AffineForOp, 4> loops;
+  getLoopIVs(*op, &loops);
+  if (loops.empty())
+    return;
+  // The output is neither promoted, nor are the inputs aliasing it.
+  Value *output = op->getOperand(op->getNumOperands() - 1);
+  Value *outputMemRef = getViewSupportingMemRef(output);
+  for (unsigned i = 0, e = op->getNumOperands() - 1; i < e; ++i) {
+    Value *input = op->getOperand(i);
+    if (input->getDefiningOp()->isa<SliceOp>() &&
+        getViewSupportingMemRef(input) != outputMemRef)
+      promoteTile(op, i, loops);
+  }
+}
+
+void linalg::tileAndPromote(Function *f, ArrayRef<int64_t> tileSizes) {
+  for (auto *op : getContractions(f)) {
+    auto loops = writeAsTiledViews(op, tileSizes);
+    if (!loops)
+      continue;
+    op->erase();
+    // The tiled contraction is the last operation before the terminator of
+    // the innermost loop.
+    Block *body = loops->back().getBody();
+    promoteTiles(&*std::prev(body->end(), 2));
+  }
+}
+
+void linalg::MicroKernelRegistry::registerKernel(StringRef name,
+                                                 StringRef opName,
+                                                 Type elementType,
+                                                 ArrayRef<int64_t> loopSizes) {
+  MicroKernel kernel;
+  kernel.name = name;
+  kernel.opName = opName;
+  kernel.elementType = elementType;
+  kernel.loopSizes.assign(loopSizes.begin(), loopSizes.end());
+  kernels.push_back(std::move(kernel));
+}
+
+// Returns the number of iterations of each loop of the contraction `op`, or -1
+// for the loops whose size is not a constant.  The size of a loop is the one of
+// any view dimension it iterates over, provided this dimension has a unit step
+// and is not rank-reduced.
+static SmallVector<int64_t, 4> getLoopSizes(Operation *op) {
+  AffineMap map = getLoopsToOperandRangesMap(op);
+  SmallVector<int64_t, 4> sizes(map.getNumDims(), -1);
+  unsigned result = 0;
+  for (auto *view : op->getOperands()) {
+    unsigned rank = getViewRank(view);
+    bool isRankReduced =
+        rank != getViewRank(getViewBaseViewOp(view).getResult());
+    for (unsigned d = 0; d < rank; ++d, ++result) {
+      unsigned loop = getLoopPosition(map, result);
+      if (isRankReduced || sizes[loop] >= 0)
+        continue;
+      auto *def = getViewRootIndexing(view, d).first->getDefiningOp();
+      if (!def || !def->isa<RangeOp>())
+        continue;
+      auto range = def->cast<RangeOp>();
+      if (isConstantIndex(range.getStep(), 1))
+        sizes[loop] = getConstantSize(range.getMin(), range.getMax());
+    }
+  }
+  return sizes;
+}
+
+const MicroKernel *linalg::MicroKernelRegistry::lookup(Operation *op) const {
+  assert(isContraction(op) && "expected a tensor contraction");
+  Value *output = op->getOperand(op->getNumOperands() - 1);
+  auto elementType = output->getType().cast<ViewType>().getElementType();
+  auto sizes = getLoopSizes(op);
+  for (auto &kernel : kernels) {
+    if (kernel.opName != op->getName().getStringRef() ||
+        kernel.elementType != elementType ||
+        kernel.loopSizes.size() != sizes.size())
+      continue;
+    bool matches = true;
+    for (unsigned i = 0, e = sizes.size(); i < e; ++i)
+      matches &= kernel.loopSizes[i] < 0 || kernel.loopSizes[i] == sizes[i];
+    if (matches)
+      return &kernel;
+  }
+  return nullptr;
+}
+
+void linalg::writeAsMicroKernelCall(Operation *op, const MicroKernel &kernel) {
+  Module *module = op->getFunction()->getModule();
+  SmallVector<Value *, 4> operands(op->getOperands());
+  SmallVector<Type, 4> types;
+  for (auto *operand : operands)
+    types.push_back(operand->getType());
+  auto type = FunctionType::get(types, {}, op->getContext());
+  Function *callee = module->getNamedFunction(kernel.name);
+  if (!callee) {
+    callee = new Function(op->getLoc(), kernel.name, type);
+    module->getFunctions().push_back(callee);
+  }
+  assert(callee->getType() == type &&
+         "micro-kernel declared with a different signature");
+  FuncBuilder builder(op);
+  builder.create<CallOp>(op->getLoc(), callee, operands);
+  op->erase();
+}
+
+void linalg::lowerToMicroKernels(Function *f,
+                                 const MicroKernelRegistry &registry) {
+  for (auto *op : getContractions(f))
+    if (auto *kernel = registry.lookup(op))
+      writeAsMicroKernelCall(op, *kernel);
+}
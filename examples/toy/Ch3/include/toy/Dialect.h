@@ -45,6 +45,9 @@ class ToyDialect : public mlir::Dialect {
 public:
   explicit ToyDialect(mlir::MLIRContext *ctx);
 
+  /// The namespace of the dialect, under which it is registered.
+  static llvm::StringRef getDialectNamespace() { return "toy"; }
+
   /// Parse a type registered to this dialect. Overridding this method is
   /// required for dialects that have custom types.
   /// Technically this is only needed to be able to round-trip to textual IR.
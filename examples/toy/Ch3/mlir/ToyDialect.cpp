@@ -94,7 +94,8 @@ ArrayRef<int64_t> ToyArrayType::getShape() { return getImpl()->getShape(); }
 
 /// Dialect creation, the instance will be owned by the context. This is the
 /// point of registration of custom types and operations for the dialect.
-ToyDialect::ToyDialect(mlir::MLIRContext *ctx) : mlir::Dialect("toy", ctx) {
+ToyDialect::ToyDialect(mlir::MLIRContext *ctx)
+    : mlir::Dialect(getDialectNamespace(), ctx) {
   addOperations<ConstantOp, GenericCallOp, PrintOp, TransposeOp, ReshapeOp,
                 MulOp, AddOp, ReturnOp>();
   addTypes<ToyArrayType>();
@@ -0,0 +1,38 @@
+//===- Passes.h - Toy Passes Definition -----------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file exposes the entry points to create compiler passes for Toy.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_TUTORIAL_TOY_PASSES_H
+#define MLIR_TUTORIAL_TOY_PASSES_H
+
+namespace mlir {
+class ModulePassBase;
+} // namespace mlir
+
+namespace toy {
+
+/// Create a pass that specializes the generic functions for the shapes of the
+/// arrays they are called with, starting from `main`, and infers the shape of
+/// every array in the specialized functions.
+mlir::ModulePassBase *createShapeInferencePass();
+
+} // namespace toy
+
+#endif // MLIR_TUTORIAL_TOY_PASSES_H
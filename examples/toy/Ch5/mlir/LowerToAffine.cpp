@@ -0,0 +1,447 @@
+//===- LowerToAffine.cpp - Lower Toy operations to Affine loop nests ------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a partial lowering of the Toy operations to loop nests
+// of the Affine dialect operating on buffers of the Standard dialect. Each Toy
+// array becomes a statically shaped memref, and each operation computing an
+// array becomes an allocation and a loop nest filling it, which the affine
+// transformations (fusion, tiling, ...) can then optimize. The resulting module
+// only uses the Affine and Standard dialects, which MLIR lowers to the LLVM IR
+// dialect.
+//
+//===----------------------------------------------------------------------===//
+
+#include "toy/Dialect.h"
+#include "toy/Passes.h"
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/DialectConversion.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/Allocator.h"
+
+#include <algorithm>
+#include <functional>
+
+using llvm::ArrayRef;
+using llvm::SmallVector;
+using llvm::StringRef;
+
+using namespace toy;
+
+/// The runtime functions printing the arrays, see toyc.cpp.
+static constexpr const char *kPrintElementFunctionName = "toy_print_f64";
+static constexpr const char *kPrintNewlineFunctionName = "toy_print_newline";
+
+namespace {
+using LoopNestBodyBuilder =
+    std::function<void(mlir::FuncBuilder &, ArrayRef<mlir::Value *>)>;
+} // end anonymous namespace
+
+/// Convert a Toy array type, whose shape must be known, to a memref with the
+/// same shape.
+static mlir::MemRefType convertArrayType(ToyArrayType type) {
+  return mlir::MemRefType::get(type.getShape(), type.getElementType());
+}
+
+/// Create a buffer for the result of `op`.
+/// The buffers are never freed: their lifetime would have to be inferred
+/// across the calls, and the Toy programs are short-lived.
+static mlir::Value *allocateResult(mlir::Operation *op,
+                                   mlir::FuncBuilder &rewriter) {
+  auto type = op->getResult(0)->getType().cast<ToyArrayType>();
+  return rewriter.create<mlir::AllocOp>(op->getLoc(), convertArrayType(type))
+      .getResult();
+}
+
+/// Create a nest of affine.for loops iterating over `shape` at the insertion
+/// point of `builder`, and call `bodyBuilder` with a builder inserting in the
+/// innermost loop and the induction variables, outermost first.
+static void buildLoopNest(mlir::FuncBuilder &builder, mlir::Location loc,
+                          ArrayRef<int64_t> shape,
+                          const LoopNestBodyBuilder &bodyBuilder) {
+  SmallVector<mlir::Value *, 4> ivs;
+  mlir::FuncBuilder nestedBuilder = builder;
+  for (auto size : shape) {
+    auto loop = nestedBuilder.create<mlir::AffineForOp>(loc, 0, size);
+    ivs.push_back(loop.getInductionVar());
+    nestedBuilder = loop.getBodyBuilder();
+  }
+  bodyBuilder(nestedBuilder, ivs);
+}
+
+/// Return the shape of the Toy array `value`.
+static ArrayRef<int64_t> getShape(mlir::Value *value) {
+  return value->getType().cast<ToyArrayType>().getShape();
+}
+
+namespace {
+
+/// Base class of the conversions of the Toy operations: matches an operation
+/// of type `Op`.
+template <typename Op>
+class ToyOpConversion : public mlir::DialectOpConversion {
+public:
+  explicit ToyOpConversion(mlir::MLIRContext *context)
+      : DialectOpConversion(Op::getOperationName(), 1, context) {}
+
+  mlir::PatternMatchResult match(mlir::Operation *op) const override {
+    if (op->isa<Op>())
+      return matchSuccess();
+    return matchFailure();
+  }
+};
+
+/// Lower `toy.constant` to a buffer in which each element is stored by a
+/// separate store. For example:
+///
+///   %0 = "toy.constant"() {value: dense<tensor<2xf64>, [1.0, 2.0]>}
+///
+/// becomes:
+///
+///   %0 = alloc() : memref<2xf64>
+///   store %cst, %0[%c0] : memref<2xf64>
+///   store %cst_0, %0[%c1] : memref<2xf64>
+///
+class ConstantOpConversion : public ToyOpConversion<ConstantOp> {
+public:
+  using ToyOpConversion<ConstantOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    auto shape = getShape(op->getResult(0));
+    auto value = op->getAttrOfType<mlir::DenseElementsAttr>("value");
+    mlir::Value *buffer = allocateResult(op, rewriter);
+
+    // Create the index constants once, up to the largest dimension.
+    SmallVector<mlir::Value *, 8> indexConstants;
+    int64_t maxDim = *std::max_element(shape.begin(), shape.end());
+    for (int64_t i = 0; i < maxDim; ++i)
+      indexConstants.push_back(
+          rewriter.create<mlir::ConstantIndexOp>(loc, i).getResult());
+
+    // The elements are in row-major order: the last index varies the fastest.
+    auto elementType =
+        op->getResult(0)->getType().cast<ToyArrayType>().getElementType();
+    SmallVector<int64_t, 4> position(shape.size(), 0);
+    SmallVector<mlir::Value *, 4> indices(shape.size());
+    for (auto element : value.getFloatValues()) {
+      for (unsigned i = 0, e = shape.size(); i < e; ++i)
+        indices[i] = indexConstants[position[i]];
+      auto constant = rewriter.create<mlir::ConstantFloatOp>(
+          loc, element, elementType.cast<mlir::FloatType>());
+      rewriter.create<mlir::StoreOp>(loc, constant, buffer, indices);
+      for (int i = shape.size() - 1; i >= 0; --i) {
+        if (++position[i] < shape[i])
+          break;
+        position[i] = 0;
+      }
+    }
+    return {buffer};
+  }
+};
+
+/// Lower `toy.transpose` to a loop nest copying the elements of its operand to
+/// the transposed positions.
+class TransposeOpConversion : public ToyOpConversion<TransposeOp> {
+public:
+  using ToyOpConversion<TransposeOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    mlir::Value *buffer = allocateResult(op, rewriter);
+    mlir::Value *input = operands[0];
+    buildLoopNest(
+        rewriter, loc, getShape(op->getResult(0)),
+        [=](mlir::FuncBuilder &builder, ArrayRef<mlir::Value *> ivs) {
+          SmallVector<mlir::Value *, 4> reversedIvs(ivs.rbegin(), ivs.rend());
+          auto element = builder.create<mlir::LoadOp>(loc, input, reversedIvs);
+          builder.create<mlir::StoreOp>(loc, element, buffer, ivs);
+        });
+    return {buffer};
+  }
+};
+
+/// Lower `toy.reshape` to a loop nest copying the elements of its operand in
+/// row-major order, or broadcasting it if it has a single element. Reshaping
+/// an array to its own shape is a no-op.
+class ReshapeOpConversion : public ToyOpConversion<ReshapeOp> {
+public:
+  using ToyOpConversion<ReshapeOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    auto inputShape = getShape(op->getOperand(0));
+    auto resultShape = getShape(op->getResult(0));
+    mlir::Value *input = operands[0];
+    if (inputShape == resultShape)
+      return {input};
+
+    // Compute the index of each dimension of the input from the position of
+    // the element in the result: linearize the indices of the result, then
+    // delinearize them following the shape of the input. When the input has a
+    // single element, all the indices are zero.
+    auto *context = op->getContext();
+    mlir::AffineExpr linearIndex = mlir::getAffineConstantExpr(0, context);
+    for (unsigned i = 0, e = resultShape.size(); i < e; ++i)
+      linearIndex =
+          linearIndex * resultShape[i] + mlir::getAffineDimExpr(i, context);
+    SmallVector<mlir::AffineMap, 4> inputIndexMaps;
+    int64_t stride = 1;
+    for (int i = inputShape.size() - 1; i >= 0; --i) {
+      auto index = linearIndex.floorDiv(stride) % inputShape[i];
+      inputIndexMaps.push_back(
+          mlir::AffineMap::get(resultShape.size(), 0, index, {}));
+      stride *= inputShape[i];
+    }
+    std::reverse(inputIndexMaps.begin(), inputIndexMaps.end());
+
+    mlir::Value *buffer = allocateResult(op, rewriter);
+    buildLoopNest(
+        rewriter, loc, resultShape,
+        [=](mlir::FuncBuilder &builder, ArrayRef<mlir::Value *> ivs) {
+          SmallVector<mlir::Value *, 4> inputIndices;
+          for (auto map : inputIndexMaps)
+            inputIndices.push_back(
+                builder.create<mlir::AffineApplyOp>(loc, map, ivs).getResult());
+          auto element = builder.create<mlir::LoadOp>(loc, input, inputIndices);
+          builder.create<mlir::StoreOp>(loc, element, buffer, ivs);
+        });
+    return {buffer};
+  }
+};
+
+/// Lower `toy.add` to a loop nest adding the elements of its operands.
+class AddOpConversion : public ToyOpConversion<AddOp> {
+public:
+  using ToyOpConversion<AddOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    mlir::Value *buffer = allocateResult(op, rewriter);
+    mlir::Value *lhs = operands[0], *rhs = operands[1];
+    buildLoopNest(
+        rewriter, loc, getShape(op->getResult(0)),
+        [=](mlir::FuncBuilder &builder, ArrayRef<mlir::Value *> ivs) {
+          auto lhsElement = builder.create<mlir::LoadOp>(loc, lhs, ivs);
+          auto rhsElement = builder.create<mlir::LoadOp>(loc, rhs, ivs);
+          auto sum = builder.create<mlir::AddFOp>(loc, lhsElement, rhsElement);
+          builder.create<mlir::StoreOp>(loc, sum, buffer, ivs);
+        });
+    return {buffer};
+  }
+};
+
+/// Lower `toy.mul` to a loop nest accumulating the products of the elements of
+/// its operands in the result: a matrix multiplication for 2-D arrays, and a
+/// dot product, whose result has a single element, for 1-D arrays.
+class MulOpConversion : public ToyOpConversion<MulOp> {
+public:
+  using ToyOpConversion<MulOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    auto lhsShape = getShape(op->getOperand(0));
+    bool isMatmul = lhsShape.size() == 2;
+    auto elementType = op->getResult(0)
+                           ->getType()
+                           .cast<ToyArrayType>()
+                           .getElementType()
+                           .cast<mlir::FloatType>();
+    mlir::Value *buffer = allocateResult(op, rewriter);
+    mlir::Value *lhs = operands[0], *rhs = operands[1];
+
+    // The dot product iterates over its single result element directly.
+    SmallVector<int64_t, 2> parallelShape;
+    if (isMatmul)
+      parallelShape.assign({lhsShape[0], getShape(op->getOperand(1))[1]});
+    buildLoopNest(
+        rewriter, loc, parallelShape,
+        [=](mlir::FuncBuilder &builder, ArrayRef<mlir::Value *> ivs) {
+          SmallVector<mlir::Value *, 2> resultIndices(ivs.begin(), ivs.end());
+          if (!isMatmul)
+            resultIndices.push_back(
+                builder.create<mlir::ConstantIndexOp>(loc, 0));
+          auto zero = builder.create<mlir::ConstantFloatOp>(
+              loc, llvm::APFloat(0.0), elementType);
+          builder.create<mlir::StoreOp>(loc, zero, buffer, resultIndices);
+
+          auto reduction = builder.create<mlir::AffineForOp>(
+              loc, 0, lhsShape[isMatmul ? 1 : 0]);
+          auto reductionBuilder = reduction.getBodyBuilder();
+          mlir::Value *k = reduction.getInductionVar();
+          SmallVector<mlir::Value *, 2> lhsIndices, rhsIndices;
+          if (isMatmul) {
+            lhsIndices.assign({ivs[0], k});
+            rhsIndices.assign({k, ivs[1]});
+          } else {
+            lhsIndices.assign({k});
+            rhsIndices.assign({k});
+          }
+          auto lhsElement =
+              reductionBuilder.create<mlir::LoadOp>(loc, lhs, lhsIndices);
+          auto rhsElement =
+              reductionBuilder.create<mlir::LoadOp>(loc, rhs, rhsIndices);
+          auto product = reductionBuilder.create<mlir::MulFOp>(
+              loc, lhsElement, rhsElement);
+          auto accumulator =
+              reductionBuilder.create<mlir::LoadOp>(loc, buffer, resultIndices);
+          auto sum =
+              reductionBuilder.create<mlir::AddFOp>(loc, accumulator, product);
+          reductionBuilder.create<mlir::StoreOp>(loc, sum, buffer,
+                                                 resultIndices);
+        });
+    return {buffer};
+  }
+};
+
+/// Lower `toy.print` to a loop nest calling the runtime to print each element,
+/// followed by a newline at the end of each row.
+class PrintOpConversion : public ToyOpConversion<PrintOp> {
+public:
+  using ToyOpConversion<PrintOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto loc = op->getLoc();
+    auto *module = op->getFunction()->getModule();
+    auto *printElement = module->getNamedFunction(kPrintElementFunctionName);
+    auto *printNewline = module->getNamedFunction(kPrintNewlineFunctionName);
+    auto shape = getShape(op->getOperand(0));
+    mlir::Value *input = operands[0];
+    buildLoopNest(
+        rewriter, loc, shape.drop_back(),
+        [=](mlir::FuncBuilder &builder, ArrayRef<mlir::Value *> ivs) {
+          auto row = builder.create<mlir::AffineForOp>(loc, 0, shape.back());
+          auto rowBuilder = row.getBodyBuilder();
+          SmallVector<mlir::Value *, 4> indices(ivs.begin(), ivs.end());
+          indices.push_back(row.getInductionVar());
+          mlir::Value *element =
+              rowBuilder.create<mlir::LoadOp>(loc, input, indices);
+          rowBuilder.create<mlir::CallOp>(loc, printElement, element);
+          builder.create<mlir::CallOp>(loc, printNewline,
+                                       ArrayRef<mlir::Value *>{});
+        });
+    return {};
+  }
+};
+
+/// Lower `toy.return` to `std.return`.
+class ReturnOpConversion : public ToyOpConversion<ReturnOp> {
+public:
+  using ToyOpConversion<ReturnOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    rewriter.create<mlir::ReturnOp>(op->getLoc(), operands);
+    return {};
+  }
+};
+
+/// Recreate the calls to the specialized functions, whose signatures operate
+/// on memrefs once converted.
+class CallOpConversion : public ToyOpConversion<mlir::CallOp> {
+public:
+  using ToyOpConversion<mlir::CallOp>::ToyOpConversion;
+
+  SmallVector<mlir::Value *, 4>
+  rewrite(mlir::Operation *op, ArrayRef<mlir::Value *> operands,
+          mlir::FuncBuilder &rewriter) const override {
+    auto call = rewriter.create<mlir::CallOp>(
+        op->getLoc(), op->cast<mlir::CallOp>().getCallee(), operands);
+    return SmallVector<mlir::Value *, 4>(call.getOperation()->getResults());
+  }
+};
+
+/// Converts the Toy operations and arrays of a module to the Affine and
+/// Standard dialects.
+class ToyToAffineConversion : public mlir::DialectConversion {
+protected:
+  llvm::DenseSet<mlir::DialectOpConversion *>
+  initConverters(mlir::MLIRContext *context) override {
+    return mlir::ConversionListBuilder<
+        ConstantOpConversion, TransposeOpConversion, ReshapeOpConversion,
+        AddOpConversion, MulOpConversion, PrintOpConversion,
+        ReturnOpConversion, CallOpConversion>::build(&allocator, context);
+  }
+
+  /// Convert the Toy arrays to memrefs of the same shape. The arrays of unknown
+  /// shape can't be converted: the shapes must be inferred first.
+  mlir::Type convertType(mlir::Type t) override {
+    auto arrayType = t.dyn_cast<ToyArrayType>();
+    if (!arrayType)
+      return t;
+    if (arrayType.isGeneric())
+      return {};
+    return convertArrayType(arrayType);
+  }
+
+private:
+  llvm::BumpPtrAllocator allocator;
+};
+
+/// Declares the runtime functions used by the lowering and converts the
+/// module.
+class LowerToAffinePass : public mlir::ModulePass<LowerToAffinePass> {
+public:
+  void runOnModule() override {
+    auto &module = getModule();
+    auto *context = module.getContext();
+    auto f64Type = mlir::FloatType::getF64(context);
+    declareFunction(kPrintElementFunctionName,
+                    mlir::FunctionType::get(f64Type, {}, context));
+    declareFunction(kPrintNewlineFunctionName,
+                    mlir::FunctionType::get({}, {}, context));
+    if (failed(ToyToAffineConversion().convert(&module)))
+      signalPassFailure();
+  }
+
+private:
+  /// Declare the external function `name` in the module unless it exists.
+  void declareFunction(StringRef name, mlir::FunctionType type) {
+    auto &module = getModule();
+    if (module.getNamedFunction(name))
+      return;
+    module.getFunctions().push_back(new mlir::Function(
+        mlir::UnknownLoc::get(module.getContext()), name, type));
+  }
+};
+} // end anonymous namespace
+
+namespace toy {
+mlir::ModulePassBase *createLowerToAffinePass() {
+  return new LowerToAffinePass();
+}
+} // namespace toy
@@ -0,0 +1,305 @@
+//===- ShapeInferencePass.cpp - Toy Shape Inference / Func Specialization -===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a Module level pass performing interprocedural
+// propagation of array shapes through function specialization.
+//
+//===----------------------------------------------------------------------===//
+
+#include "toy/Dialect.h"
+#include "toy/Passes.h"
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
+
+using llvm::ArrayRef;
+using llvm::raw_string_ostream;
+using llvm::SmallVector;
+using llvm::StringRef;
+using llvm::Twine;
+
+using namespace toy;
+
+namespace {
+
+/// The Toy functions are generic: the shapes of their arguments and results
+/// are unknown until the functions are called. This pass starts from the
+/// functions that aren't generic, like `main`, and walks their operations in
+/// order, computing the shape of the result of each operation from the shapes
+/// of its operands. When it reaches a call to a generic function, it creates a
+/// clone of the callee specialized for the shapes of the arguments, named
+/// after them (e.g. `multiply_transpose_2x3_2x3`), infers the shapes in the
+/// clone the same way, and replaces the `toy.generic_call` with a direct call
+/// to the clone. The generic functions are removed from the module once all
+/// the calls have been specialized, so that every array has a known shape and
+/// the module can be lowered to loops over statically sized buffers.
+class ShapeInferencePass : public mlir::ModulePass<ShapeInferencePass> {
+public:
+  void runOnModule() override {
+    auto &module = getModule();
+    specializations.clear();
+    inProgress.clear();
+
+    // Collect the entry points first: the specializations created along the
+    // way are processed when they are created.
+    SmallVector<mlir::Function *, 4> entryPoints;
+    SmallVector<mlir::Function *, 4> genericFunctions;
+    for (auto &function : module) {
+      if (function.getAttr("toy.generic"))
+        genericFunctions.push_back(&function);
+      else
+        entryPoints.push_back(&function);
+    }
+
+    for (auto *function : entryPoints) {
+      if (failed(inferShapes(function))) {
+        signalPassFailure();
+        return;
+      }
+    }
+
+    // All the calls now target specializations, the generic functions are
+    // dead.
+    for (auto *function : genericFunctions)
+      function->erase();
+  }
+
+private:
+  /// The specializations created so far, by name.
+  llvm::StringMap<mlir::Function *> specializations;
+
+  /// The functions whose shapes are being inferred, used to detect recursion.
+  llvm::DenseSet<mlir::Function *> inProgress;
+
+  /// Infer the shape of every array in `function`, whose arguments have a known
+  /// shape.
+  mlir::LogicalResult inferShapes(mlir::Function *function) {
+    inProgress.insert(function);
+    // Toy functions have a single block, whose operations are in the order of
+    // their data dependences.
+    auto &block = function->front();
+    for (auto it = block.begin(), e = block.end(); it != e;) {
+      // Calls are replaced, so advance to the next operation first.
+      mlir::Operation &op = *it++;
+      if (failed(inferShape(&op)))
+        return mlir::failure();
+    }
+    inProgress.erase(function);
+    return mlir::success();
+  }
+
+  /// Set the shape of the result of `op`, whose operands have a known shape.
+  mlir::LogicalResult inferShape(mlir::Operation *op) {
+    for (auto *operand : op->getOperands()) {
+      auto arrayType = operand->getType().dyn_cast<ToyArrayType>();
+      if (arrayType && arrayType.isGeneric())
+        return op->emitError("shape inference failed: operand with an "
+                             "unknown shape");
+    }
+
+    // The constants carry their shape, and printing doesn't produce any value.
+    if (op->isa<ConstantOp>() || op->isa<PrintOp>())
+      return mlir::success();
+
+    if (auto reshape = op->dyn_cast<ReshapeOp>()) {
+      // The result type is set by the reshape, only check that the array can
+      // take it: it must have as many elements, or a single one broadcast to
+      // the new shape.
+      auto numElements = getNumElements(getShape(reshape.getOperand()));
+      auto numResultElements = getNumElements(getShape(reshape.getResult()));
+      if (numElements != 1 && numElements != numResultElements)
+        return op->emitError("shape mismatch: can't reshape an array of " +
+                             Twine(numElements) + " elements to " +
+                             Twine(numResultElements) + " elements");
+      return mlir::success();
+    }
+
+    if (auto transpose = op->dyn_cast<TransposeOp>()) {
+      auto shape = getShape(transpose.getOperand());
+      SmallVector<int64_t, 2> dims(shape.rbegin(), shape.rend());
+      setResultShape(op, dims);
+      return mlir::success();
+    }
+
+    if (auto mul = op->dyn_cast<MulOp>()) {
+      auto lhs = getShape(mul.getLHS());
+      auto rhs = getShape(mul.getRHS());
+      if (lhs.size() != rhs.size())
+        return op->emitError("shape mismatch: LHS and RHS must have the same "
+                             "rank for multiplication, got " +
+                             Twine(lhs.size()) + " vs " + Twine(rhs.size()));
+      if (lhs.size() == 1) {
+        // Dot product, the result is an array holding a single element.
+        if (lhs[0] != rhs[0])
+          return op->emitError("shape mismatch: the operands of the dot "
+                               "product must have the same size");
+        setResultShape(op, {1});
+        return mlir::success();
+      }
+      if (lhs.size() != 2)
+        return op->emitError("shape mismatch: expect rank 1 or 2 for "
+                             "multiplication operands, got " +
+                             Twine(lhs.size()));
+      if (lhs[1] != rhs[0])
+        return op->emitError("shape mismatch: the number of columns of the "
+                             "LHS of the matrix multiplication must be the "
+                             "number of rows of its RHS");
+      setResultShape(op, {lhs[0], rhs[1]});
+      return mlir::success();
+    }
+
+    if (auto add = op->dyn_cast<AddOp>()) {
+      auto lhs = getShape(add.getLHS());
+      if (lhs != getShape(add.getRHS()))
+        return op->emitError("shape mismatch: the operands of an addition "
+                             "must have the same shape");
+      setResultShape(op, lhs);
+      return mlir::success();
+    }
+
+    if (auto call = op->dyn_cast<GenericCallOp>())
+      return specializeCall(call);
+
+    if (auto ret = op->dyn_cast<ReturnOp>()) {
+      // The function returns the type of the returned array, if any.
+      auto *function = op->getFunction();
+      SmallVector<mlir::Type, 1> results;
+      if (ret.hasOperand())
+        results.push_back(ret.getOperand()->getType());
+      function->setType(mlir::FunctionType::get(
+          function->getType().getInputs(), results, function->getContext()));
+      return mlir::success();
+    }
+
+    return op->emitError("shape inference failed: unsupported operation");
+  }
+
+  /// Replace `call` with a call to the specialization of its callee for the
+  /// shapes of its arguments, which is created if it doesn't exist yet.
+  mlir::LogicalResult specializeCall(GenericCallOp call) {
+    auto &module = getModule();
+    StringRef calleeName = call.getCalleeName();
+    auto *callee = module.getNamedFunction(calleeName);
+    if (!callee)
+      return call.emitError("shape inference failed: call to unknown "
+                            "function '" +
+                            calleeName + "'");
+    if (callee->getNumArguments() != call.getNumOperands())
+      return call.emitError("shape inference failed: wrong number of "
+                            "arguments in the call to '" +
+                            calleeName + "'");
+
+    // Mangle the name of the specialization after the shapes of the arguments.
+    SmallVector<mlir::Value *, 4> operands(call.getOperation()->getOperands());
+    std::string name;
+    raw_string_ostream os(name);
+    os << calleeName;
+    for (auto *operand : operands) {
+      os << "_";
+      auto shape = getShape(operand);
+      for (unsigned i = 0, e = shape.size(); i < e; ++i)
+        os << (i == 0 ? "" : "x") << shape[i];
+    }
+    os.flush();
+
+    auto *specialization = specializations.lookup(name);
+    if (!specialization) {
+      specialization = createSpecialization(callee, operands, name);
+      specializations[name] = specialization;
+      if (failed(inferShapes(specialization)))
+        return mlir::failure();
+    } else if (inProgress.count(specialization)) {
+      return call.emitError("shape inference failed: recursive calls are not "
+                            "supported");
+    }
+
+    mlir::FuncBuilder builder(call.getOperation());
+    auto newCall =
+        builder.create<mlir::CallOp>(call.getLoc(), specialization, operands);
+    if (newCall.getOperation()->getNumResults() == 0) {
+      if (!call.getResult()->use_empty())
+        return call.emitError("shape inference failed: '" + calleeName +
+                              "' doesn't return a value");
+    } else {
+      call.getResult()->replaceAllUsesWith(
+          newCall.getOperation()->getResult(0));
+    }
+    call.erase();
+    return mlir::success();
+  }
+
+  /// Create a clone of `callee` named `name` that takes the types of
+  /// `operands` as arguments.
+  mlir::Function *createSpecialization(mlir::Function *callee,
+                                       ArrayRef<mlir::Value *> operands,
+                                       StringRef name) {
+    auto *context = callee->getContext();
+    SmallVector<mlir::Type, 4> argTypes;
+    for (auto *operand : operands)
+      argTypes.push_back(operand->getType());
+    auto *specialization = new mlir::Function(
+        callee->getLoc(), name, mlir::FunctionType::get(argTypes, {}, context));
+    getModule().getFunctions().push_back(specialization);
+    specialization->addEntryBlock();
+
+    // Clone the body of the callee with its arguments replaced by the ones of
+    // the specialization, and merge its entry block into the new one.
+    mlir::BlockAndValueMapping mapper;
+    for (unsigned i = 0, e = operands.size(); i < e; ++i)
+      mapper.map(callee->getArgument(i), specialization->getArgument(i));
+    callee->cloneInto(specialization, mapper);
+    auto &entryBlock = specialization->front();
+    auto *clonedEntryBlock = mapper.lookupOrNull(&callee->front());
+    entryBlock.getOperations().splice(entryBlock.end(),
+                                      clonedEntryBlock->getOperations());
+    clonedEntryBlock->eraseFromFunction();
+    specialization->removeAttr(mlir::Identifier::get("toy.generic", context));
+    return specialization;
+  }
+
+  /// Return the shape of `value`, a Toy array.
+  static ArrayRef<int64_t> getShape(mlir::Value *value) {
+    return value->getType().cast<ToyArrayType>().getShape();
+  }
+
+  /// Return the number of elements of an array of shape `shape`.
+  static int64_t getNumElements(ArrayRef<int64_t> shape) {
+    int64_t numElements = 1;
+    for (auto dim : shape)
+      numElements *= dim;
+    return numElements;
+  }
+
+  /// Set the type of the result of `op` to a Toy array of shape `dims`.
+  static void setResultShape(mlir::Operation *op, ArrayRef<int64_t> dims) {
+    op->getResult(0)->setType(ToyArrayType::get(op->getContext(), dims));
+  }
+};
+} // end anonymous namespace
+
+namespace toy {
+mlir::ModulePassBase *createShapeInferencePass() {
+  return new ShapeInferencePass();
+}
+} // namespace toy
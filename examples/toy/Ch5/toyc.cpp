@@ -0,0 +1,235 @@
+//===- toyc.cpp - The Toy Compiler ----------------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the entry point for the Toy compiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "toy/Dialect.h"
+#include "toy/MLIRGen.h"
+#include "toy/Parser.h"
+#include "toy/Passes.h"
+#include <memory>
+
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/LLVMIR/Transforms.h"
+#include "mlir/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Transforms/Passes.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace toy;
+namespace cl = llvm::cl;
+
+static cl::opt<std::string> inputFilename(cl::Positional,
+                                          cl::desc("<input toy file>"),
+                                          cl::init("-"),
+                                          cl::value_desc("filename"));
+
+namespace {
+enum InputType { Toy, MLIR };
+}
+static cl::opt<enum InputType> inputType(
+    "x", cl::init(Toy), cl::desc("Decided the kind of output desired"),
+    cl::values(clEnumValN(Toy, "toy", "load the input file as a Toy source.")),
+    cl::values(clEnumValN(MLIR, "mlir",
+                          "load the input file as an MLIR file")));
+
+namespace {
+enum Action { None, DumpAST, DumpMLIR, DumpMLIRAffine, DumpMLIRLLVM, RunJIT };
+}
+static cl::opt<enum Action> emitAction(
+    "emit", cl::desc("Select the kind of output desired"),
+    cl::values(clEnumValN(DumpAST, "ast", "output the AST dump")),
+    cl::values(clEnumValN(DumpMLIR, "mlir", "output the MLIR dump")),
+    cl::values(clEnumValN(DumpMLIRAffine, "mlir-affine",
+                          "output the MLIR dump after affine lowering")),
+    cl::values(clEnumValN(DumpMLIRLLVM, "mlir-llvm",
+                          "output the MLIR dump after llvm lowering")),
+    cl::values(
+        clEnumValN(RunJIT, "jit",
+                   "JIT the code and run it by invoking the main function")));
+
+static cl::opt<bool>
+    EnableOpt("opt", cl::desc("Enable optimizations: infer the shapes of the "
+                             "arrays by specializing the generic functions, "
+                             "and fuse the loops once lowered"));
+
+/// Runtime functions called by the code lowered from `toy.print`. They are
+/// resolved by the JIT among the symbols exported by toyc.
+extern "C" void toy_print_f64(double value) {
+  llvm::outs() << llvm::format("%f ", value);
+}
+extern "C" void toy_print_newline() { llvm::outs() << "\n"; }
+
+/// Returns a Toy AST resulting from parsing the file or a nullptr on error.
+std::unique_ptr<toy::ModuleAST> parseInputFile(llvm::StringRef filename) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileOrErr =
+      llvm::MemoryBuffer::getFileOrSTDIN(filename);
+  if (std::error_code EC = FileOrErr.getError()) {
+    llvm::errs() << "Could not open input file: " << EC.message() << "\n";
+    return nullptr;
+  }
+  auto buffer = FileOrErr.get()->getBuffer();
+  LexerBuffer lexer(buffer.begin(), buffer.end(), filename);
+  Parser parser(lexer);
+  return parser.ParseModule();
+}
+
+/// Load the input file, either a Toy source or an MLIR file, into an MLIR
+/// module. Returns nullptr on error.
+std::unique_ptr<mlir::Module> loadMLIR(mlir::MLIRContext &context) {
+  if (inputType == InputType::MLIR ||
+      llvm::StringRef(inputFilename).endswith(".mlir")) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> fileOrErr =
+        llvm::MemoryBuffer::getFileOrSTDIN(inputFilename);
+    if (std::error_code EC = fileOrErr.getError()) {
+      llvm::errs() << "Could not open input file: " << EC.message() << "\n";
+      return nullptr;
+    }
+    llvm::SourceMgr sourceMgr;
+    sourceMgr.AddNewSourceBuffer(std::move(*fileOrErr), llvm::SMLoc());
+    std::unique_ptr<mlir::Module> module(
+        mlir::parseSourceFile(sourceMgr, &context));
+    if (!module) {
+      llvm::errs() << "Error can't load file " << inputFilename << "\n";
+      return nullptr;
+    }
+    if (failed(module->verify())) {
+      llvm::errs() << "Error verifying MLIR module\n";
+      return nullptr;
+    }
+    return module;
+  }
+  auto moduleAST = parseInputFile(inputFilename);
+  if (!moduleAST)
+    return nullptr;
+  return mlirGen(context, *moduleAST);
+}
+
+/// Run the passes needed by the requested action on `module`: the shapes are
+/// always inferred before lowering, since the lowering only handles arrays of
+/// known shape.
+mlir::LogicalResult optimizeAndLower(mlir::Module &module) {
+  bool isLoweringToAffine = emitAction >= Action::DumpMLIRAffine;
+  bool isLoweringToLLVM = emitAction == Action::DumpMLIRLLVM;
+  if (!EnableOpt && !isLoweringToAffine)
+    return mlir::success();
+
+  mlir::PassManager pm;
+  // Specialize the generic functions and infer the shape of every array.
+  pm.addPass(createShapeInferencePass());
+  if (isLoweringToAffine) {
+    // Lower to loop nests on buffers, where the affine transformations apply.
+    pm.addPass(createLowerToAffinePass());
+    pm.addPass(mlir::createCanonicalizerPass());
+    if (EnableOpt) {
+      pm.addPass(mlir::createLoopFusionPass());
+      pm.addPass(mlir::createMemRefDataFlowOptPass());
+      pm.addPass(mlir::createCanonicalizerPass());
+      pm.addPass(mlir::createCSEPass());
+    }
+  }
+  if (isLoweringToLLVM) {
+    // The JIT performs the same lowering itself.
+    pm.addPass(mlir::createLowerAffinePass());
+    pm.addPass(mlir::createConvertToLLVMIRPass());
+  }
+  return pm.run(&module);
+}
+
+int runJit(mlir::Module *module) {
+  // Initialize LLVM targets.
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  mlir::initializeLLVMPasses();
+
+  // An optimization pipeline to use within the execution engine.
+  auto optPipeline = mlir::makeOptimizingTransformer(
+      /*optLevel=*/EnableOpt ? 3 : 0, /*sizeLevel=*/0);
+
+  // Create an MLIR execution engine. The execution engine eagerly JIT-compiles
+  // the module.
+  auto maybeEngine = mlir::ExecutionEngine::create(module, optPipeline);
+  if (!maybeEngine) {
+    llvm::errs() << "Failed to construct an execution engine: "
+                 << llvm::toString(maybeEngine.takeError()) << "\n";
+    return -1;
+  }
+  auto &engine = maybeEngine.get();
+
+  // Invoke the JIT-compiled function.
+  if (auto error = engine->invoke("main")) {
+    llvm::errs() << "JIT invocation failed: "
+                 << llvm::toString(std::move(error)) << "\n";
+    return -1;
+  }
+  return 0;
+}
+
+int dumpAST() {
+  if (inputType == InputType::MLIR) {
+    llvm::errs() << "Can't dump a Toy AST when the input is MLIR\n";
+    return 5;
+  }
+
+  auto moduleAST = parseInputFile(inputFilename);
+  if (!moduleAST)
+    return 1;
+
+  dump(*moduleAST);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "toy compiler\n");
+
+  if (emitAction == Action::DumpAST)
+    return dumpAST();
+  if (emitAction == Action::None) {
+    llvm::errs() << "No action specified (parsing only?), use -emit=<action>\n";
+    return 0;
+  }
+
+  // Register our Dialect with MLIR
+  mlir::registerDialect<ToyDialect>();
+
+  mlir::MLIRContext context;
+  auto module = loadMLIR(context);
+  if (!module)
+    return 1;
+  if (failed(optimizeAndLower(*module))) {
+    llvm::errs() << "Module lowering failed\n";
+    return 6;
+  }
+
+  if (emitAction == Action::RunJIT)
+    return runJit(module.get());
+  module->dump();
+  return 0;
+}
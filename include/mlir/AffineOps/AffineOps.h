@@ -40,6 +40,9 @@ bool isTopLevelSymbol(Value *value);
 class AffineOpsDialect : public Dialect {
 public:
   AffineOpsDialect(MLIRContext *context);
+
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "affine"; }
 };
 
 /// The "affine.apply" operation applies an affine map to a list of operands,
@@ -305,8 +308,11 @@ public:
   using Op::Op;
 
   // Hooks to customize behavior of this op.
+  /// Builds an 'affine.if' with a 'then' block, and an 'else' block if
+  /// 'withElseRegion' is set, both ending with a terminator.
   static void build(Builder *builder, OperationState *result,
-                    IntegerSet condition, ArrayRef<Value *> conditionOperands);
+                    IntegerSet condition, ArrayRef<Value *> conditionOperands,
+                    bool withElseRegion = false);
 
   static StringRef getOperationName() { return "affine.if"; }
   static StringRef getConditionAttrName() { return "condition"; }
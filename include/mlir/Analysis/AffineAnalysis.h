@@ -26,6 +26,7 @@
 
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 
@@ -35,6 +36,7 @@ class AffineApplyOp;
 class AffineForOp;
 class AffineValueMap;
 class FlatAffineConstraints;
+class Function;
 class Operation;
 class Value;
 
@@ -54,20 +56,22 @@ void getReachableAffineApplyOps(
 LogicalResult getIndexSet(llvm::MutableArrayRef<AffineForOp> forOps,
                           FlatAffineConstraints *domain);
 
-/// Encapsulates a memref load or store access information.
+/// Encapsulates a memref load or store access information. The access of a
+/// vector transfer is the one of the first element it transfers.
 struct MemRefAccess {
   Value *memref;
   Operation *opInst;
   llvm::SmallVector<Value *, 4> indices;
 
-  /// Constructs a MemRefAccess from a load or store operation.
+  /// Constructs a MemRefAccess from a load, store or vector transfer
+  /// operation.
   // TODO(b/119949820): add accessors to standard op's load, store, DMA op's to
   // return MemRefAccess, i.e., loadOp->getAccess(), dmaOp->getRead/WriteAccess.
   explicit MemRefAccess(Operation *opInst);
 
   // Returns the rank of the memref associated with this access.
   unsigned getRank() const;
-  // Returns true if this access is of a store op.
+  // Returns true if this access is of a store op or a vector transfer write.
   bool isStore() const;
 
   /// Populates 'accessMap' with composition of AffineApplyOps reachable from
@@ -104,6 +108,45 @@ bool checkMemrefAccessDependence(
     unsigned loopDepth, FlatAffineConstraints *dependenceConstraints,
     llvm::SmallVector<DependenceComponent, 2> *dependenceComponents,
     bool allowRAR = false);
+
+/// A memoized view of checkMemrefAccessDependence for the accesses of a
+/// function, available through the AnalysisManager. The results are cached per
+/// pair of accesses and loop depth, along with the dependence components when
+/// they were requested. The cached results are only valid as long as the loops
+/// surrounding the accesses are left untouched: a pass that transforms or
+/// erases loops while using this analysis must invalidate them, and the pass
+/// manager discards the whole cache after any pass that does not preserve it.
+class DependenceAnalysis {
+public:
+  explicit DependenceAnalysis(Function *function) {}
+
+  /// Returns the result of checkMemrefAccessDependence for the accesses of
+  /// 'srcOpInst' and 'dstOpInst' at 'loopDepth', and the dependence components
+  /// in 'dependenceComponents' if it is non-null.
+  bool checkDependence(
+      Operation *srcOpInst, Operation *dstOpInst, unsigned loopDepth,
+      llvm::SmallVector<DependenceComponent, 2> *dependenceComponents = nullptr,
+      bool allowRAR = false);
+
+  /// Drops the cached results involving an access nested in 'op', which must
+  /// be called before 'op' is erased or after the loops it contains change.
+  void invalidate(Operation *op);
+
+  /// Drops all of the cached results.
+  void clear() { cache.clear(); }
+
+private:
+  struct Result {
+    bool hasDependence;
+    bool hasComponents;
+    llvm::SmallVector<DependenceComponent, 2> components;
+  };
+
+  /// The cache is keyed by the pair of accesses, and by the loop depth and the
+  /// 'allowRAR' flag combined as '2 * loopDepth + allowRAR'.
+  using Key = std::pair<std::pair<Operation *, Operation *>, unsigned>;
+  llvm::DenseMap<Key, Result> cache;
+};
 } // end namespace mlir
 
 #endif // MLIR_ANALYSIS_AFFINE_ANALYSIS_H
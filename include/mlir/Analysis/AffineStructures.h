@@ -310,11 +310,13 @@ public:
   /// intersection with no simplification of any sort attempted.
   void append(const FlatAffineConstraints &other);
 
-  // Checks for emptiness by performing variable elimination on all identifiers,
-  // running the GCD test on each equality constraint, and checking for invalid
+  // Checks for emptiness with the simplex method, followed by a bounded branch
+  // and bound search for an integer point. If the search is inconclusive,
+  // falls back to performing variable elimination on all identifiers, running
+  // the GCD test on each equality constraint, and checking for invalid
   // constraints.
-  // Returns true if the GCD test fails for any equality, or if any invalid
-  // constraints are discovered on any row. Returns false otherwise.
+  // Returns true if the set was found to have no integer point, and false
+  // otherwise.
   bool isEmpty() const;
 
   // Runs the GCD test on all equality constraints. Returns 'true' if this test
@@ -756,8 +758,34 @@ private:
   // don't expect an identifier to have more than 32 lower/upper/equality
   // constraints. This is conservatively set low and can be raised if needed.
   constexpr static unsigned kExplosionFactor = 32;
+
+  /// The maximum number of branches explored by the branch and bound search
+  /// of isEmpty() before it falls back to Fourier-Motzkin elimination.
+  constexpr static unsigned kMaxBranchAndBoundNodes = 64;
+};
+
+/// Counters of the work done by all the FlatAffineConstraints of the process,
+/// accumulated across threads.  They track the cost of the polyhedral analyses,
+/// e.g. in the benchmarks of the affine passes.
+struct FlatAffineConstraintsStats {
+  /// Number of identifiers eliminated by Gaussian elimination.
+  uint64_t numGaussianEliminations = 0;
+  /// Number of identifiers eliminated by Fourier-Motzkin elimination.
+  uint64_t numFourierMotzkinEliminations = 0;
+  /// Number of calls to FlatAffineConstraints::isEmpty.
+  uint64_t numEmptinessChecks = 0;
+  /// Largest number of constraints of a system input to or produced by a
+  /// Fourier-Motzkin elimination.
+  uint64_t maxNumConstraints = 0;
 };
 
+/// Returns the counters accumulated since the start of the process or the last
+/// call to resetFlatAffineConstraintsStats.
+FlatAffineConstraintsStats getFlatAffineConstraintsStats();
+
+/// Resets the counters returned by getFlatAffineConstraintsStats to zero.
+void resetFlatAffineConstraintsStats();
+
 /// Simplify an affine expression by flattening and some amount of
 /// simple analysis. This has complexity linear in the number of nodes in
 /// 'expr'. Returns the simplified expression, which is the same as the input
@@ -792,6 +820,11 @@ LogicalResult getFlattenedAffineExprs(
     IntegerSet set, std::vector<llvm::SmallVector<int64_t, 8>> *flattenedExprs,
     FlatAffineConstraints *cst = nullptr);
 
+/// Simplify 'set': if it has no integer points, return the canonical empty set
+/// of the same space, and 'set' itself otherwise.  The results are memoized in
+/// the context, so each uniqued set is only analyzed once.
+IntegerSet simplifyIntegerSet(IntegerSet set);
+
 } // end namespace mlir.
 
 #endif // MLIR_ANALYSIS_AFFINE_STRUCTURES_H
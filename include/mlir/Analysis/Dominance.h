@@ -33,6 +33,11 @@ template <bool IsPostDom> class DominanceInfoBase {
   using base = llvm::DominatorTreeBase<Block, IsPostDom>;
 
 public:
+  /// An update of the CFG of a region, i.e. the insertion or the deletion of
+  /// an edge between two of its blocks.
+  using UpdateKind = typename base::UpdateKind;
+  using UpdateType = typename base::UpdateType;
+
   DominanceInfoBase(Function *function) { recalculate(function); }
   DominanceInfoBase(DominanceInfoBase &&) = default;
   DominanceInfoBase &operator=(DominanceInfoBase &&) = default;
@@ -43,10 +48,36 @@ public:
   /// Recalculate the dominance info for the provided function.
   void recalculate(Function *function);
 
+  /// Recalculate the dominance info of a single region, leaving that of the
+  /// other regions untouched, e.g. after the region was created or heavily
+  /// restructured.
+  void recalculate(Region *region);
+
+  /// Update the dominance info after the given edges were inserted in or
+  /// deleted from the CFG.  The IR must already reflect the updates, and the
+  /// blocks of each update must be within the same region.  This is much
+  /// cheaper than a recalculation when a few edges of a large CFG change, e.g.
+  /// when a block is split, which allows passes making such changes to keep
+  /// the analysis preserved.
+  void applyUpdates(ArrayRef<UpdateType> updates);
+
+  /// Update the dominance info after an edge from 'from' to 'to' was inserted
+  /// in the CFG.
+  void insertEdge(Block *from, Block *to) {
+    applyUpdates(UpdateType(UpdateKind::Insert, from, to));
+  }
+
+  /// Update the dominance info after the edge from 'from' to 'to' was deleted
+  /// from the CFG.
+  void deleteEdge(Block *from, Block *to) {
+    applyUpdates(UpdateType(UpdateKind::Delete, from, to));
+  }
+
   /// Get the root dominance node of the given region.
   DominanceInfoNode *getRootNode(Region *region) {
-    assert(dominanceInfos.count(region) != 0);
-    return dominanceInfos[region]->getRootNode();
+    auto it = dominanceInfos.find(region);
+    assert(it != dominanceInfos.end() && "region info not found");
+    return it->second->getRootNode();
   }
 
 protected:
@@ -0,0 +1,117 @@
+//===- IntegerRangeAnalysis.h - Ranges of index values ----------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines an analysis computing the ranges of the values that
+// index SSA values may take, from the affine and standard ops defining them.
+// It is a cheap alternative to building FlatAffineConstraints for the common
+// questions of whether an index is non-negative or within some bounds.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_INTEGER_RANGE_ANALYSIS_H
+#define MLIR_ANALYSIS_INTEGER_RANGE_ANALYSIS_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+
+namespace mlir {
+
+class AffineExpr;
+class Function;
+class Operation;
+class Value;
+
+/// A bound of the form 'symbol + offset' on an index value, where 'symbol' is
+/// a value the bounded value is derived from, e.g. the upper bound of a loop.
+struct SymbolicBound {
+  Value *symbol;
+  int64_t offset;
+};
+
+/// The range of an index value. Both the constant and the symbolic bounds are
+/// inclusive, and are missing when unknown.
+struct IntegerRange {
+  /// Returns the range holding 'value' only.
+  static IntegerRange getConstant(int64_t value);
+
+  /// Returns the range of a value that isn't derived from other values, which
+  /// is only bounded by itself.
+  static IntegerRange getSelf(Value *value);
+
+  /// Returns true if the range holds a single constant.
+  bool isConstant() const { return lower && upper && *lower == *upper; }
+
+  /// Returns true if all the values of the range are in [min, max].
+  bool isWithin(int64_t min, int64_t max) const {
+    return lower && upper && *lower >= min && *upper <= max;
+  }
+
+  Optional<int64_t> lower, upper;
+  Optional<SymbolicBound> symbolicLower, symbolicUpper;
+};
+
+/// Computes the ranges of index values from the ops defining them:
+/// constants, affine.apply and the bounds of affine.for ops, addi, subi, muli
+/// and dim. Any other value is unbounded, except by itself, so that the values
+/// derived from a loop with a symbolic upper bound are bounded in terms of this
+/// symbol. The ranges are computed on demand, in a single traversal of the
+/// use-def chains of the value, and memoized.
+///
+/// The analysis is available through the AnalysisManager. The cached ranges
+/// stay valid as long as the ops defining the values, and those they are
+/// derived from, are left untouched: a pass changing such ops must invalidate
+/// them.
+class IntegerRangeAnalysis {
+public:
+  explicit IntegerRangeAnalysis(Function *function) {}
+
+  /// Returns the range of 'value', which is unbounded if it isn't an index.
+  IntegerRange getRange(Value *value);
+
+  /// Returns the range of 'expr' evaluated on 'operands', which are the dims
+  /// then the symbols of 'expr'.
+  IntegerRange getRange(AffineExpr expr, ArrayRef<Value *> operands,
+                        unsigned numDims);
+
+  /// Returns true if 'value' is known to be non-negative.
+  bool isNonNegative(Value *value) {
+    auto lower = getRange(value).lower;
+    return lower && *lower >= 0;
+  }
+
+  /// Drops the cached ranges of the values defined by 'op' and the ops nested
+  /// in it, which must be called before 'op' is erased or modified.
+  void invalidate(Operation *op);
+
+  /// Drops all of the cached ranges.
+  void clear() { ranges.clear(); }
+
+private:
+  /// Computes the range of 'value' from the cached ranges of the values it
+  /// depends on.
+  IntegerRange computeRange(Value *value);
+
+  /// Returns the cached range of 'value', or an unbounded range.
+  IntegerRange lookup(Value *value) const;
+
+  llvm::DenseMap<Value *, IntegerRange> ranges;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_INTEGER_RANGE_ANALYSIS_H
@@ -25,6 +25,7 @@
 #include "mlir/Support/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace mlir {
 
@@ -85,6 +86,10 @@ bool isAccessInvariant(Value *iv, Value *index);
 llvm::DenseSet<Value *, llvm::DenseMapInfo<Value *>>
 getInvariantAccesses(Value *iv, llvm::ArrayRef<Value *> indices);
 
+/// Returns true if 'value' is defined outside of 'loop', and is thus invariant
+/// along it.
+bool isDefinedOutsideOfLoop(Value *value, AffineForOp loop);
+
 using VectorizableLoopFun = std::function<bool(AffineForOp)>;
 
 /// Checks whether the loop is structurally vectorizable; i.e.:
@@ -100,6 +105,43 @@ bool isVectorizableLoopBody(AffineForOp loop);
 ///      is found, it is written into `memRefDim`.
 bool isVectorizableLoopBody(AffineForOp loop, int *memRefDim);
 
+/// Summarizes how the load and store operations nested under a loop vary along
+/// its induction variable, which determines the cost of vectorizing the loop.
+struct AccessContiguity {
+  /// Number of accesses invariant along the loop.
+  unsigned numInvariant = 0;
+  /// Number of accesses varying along their k-th fastest varying memref
+  /// dimension only, at index k.
+  SmallVector<unsigned, 4> numVaryingAlongDim;
+  /// Number of accesses varying along several memref dimensions or through a
+  /// non-trivial layout map.
+  unsigned numNonContiguous = 0;
+};
+
+/// Returns how the load and store operations nested under 'loop' vary along
+/// its induction variable, with the same restrictions as
+/// isVectorizableLoopBody(loop, memRefDim) on the accesses.
+AccessContiguity getAccessContiguity(AffineForOp loop);
+
+/// A reduction carried by a loop through memory: every iteration loads the
+/// element at a location invariant along the loop, combines it with a value
+/// computed in the iteration and stores the result back to the same location.
+struct MemRefReduction {
+  /// The load of the accumulator.
+  Operation *load;
+  /// The addf, mulf, addi or muli combining the accumulator.
+  Operation *combiner;
+  /// The store of the accumulator.
+  Operation *store;
+};
+
+/// Returns true if the innermost loop 'loop' carries a reduction through
+/// memory, which is then written into 'reduction'. The reduction must be the
+/// only store in the loop, its indices must be defined outside of the loop and
+/// the loop must not access the reduced memref otherwise, so that reassociating
+/// the combiner is the only change needed to run the iterations in parallel.
+bool getMemRefReduction(AffineForOp loop, MemRefReduction *reduction);
+
 /// Checks where SSA dominance would be violated if a for op's body
 /// operations are shifted by the specified shifts. This method checks if a
 /// 'def' and all its uses have the same shift factor.
@@ -0,0 +1,115 @@
+//===- LoopProfile.h - Runtime profiles of loops and functions --*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines the profiles of the loops and functions measured by
+// the code instrumented by the -instrument-loops pass, which the profile
+// runtime of the ExecutionEngine writes to the file named by the
+// MLIR_PROFILE_FILE environment variable, and the queries the loop
+// transformations make on the profile given with -loop-profile.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_LOOPPROFILE_H
+#define MLIR_ANALYSIS_LOOPPROFILE_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include <memory>
+#include <string>
+
+namespace mlir {
+
+class AffineForOp;
+class Function;
+
+/// The counters measured for a loop or function.
+struct ProfileCounters {
+  /// The number of times the region was entered.
+  uint64_t entries = 0;
+  /// The total number of iterations of a loop, or the number of calls to a
+  /// function.
+  uint64_t iterations = 0;
+  /// The total time spent in the region, in nanoseconds.
+  int64_t nanoseconds = 0;
+};
+
+/// The profile of the loops and functions of a program, keyed by the names of
+/// the regions given by getProfileRegionName.  The profile is a text file with
+/// one region per line:
+///
+///   <entries> <iterations> <nanoseconds> <name>
+///
+/// The empty lines and the lines starting with '#' are ignored.
+class LoopProfile {
+public:
+  /// Parses a profile from 'buffer'.  Returns null and sets 'errorMessage' if
+  /// the buffer is not a valid profile.
+  static std::unique_ptr<LoopProfile> parse(StringRef buffer,
+                                            std::string *errorMessage);
+
+  /// Reads a profile from the file 'filename'.  Returns null and sets
+  /// 'errorMessage' if the file cannot be read or is not a valid profile.
+  static std::unique_ptr<LoopProfile> readFile(StringRef filename,
+                                               std::string *errorMessage);
+
+  /// Returns the counters of the region named 'name', or null if it was never
+  /// entered.
+  const ProfileCounters *lookup(StringRef name) const;
+  const ProfileCounters *lookup(AffineForOp forOp) const;
+  const ProfileCounters *lookup(Function &function) const;
+
+  /// Returns true if 'forOp' was never entered while the function containing
+  /// it was called, or if the time spent in it is below 'coldThreshold' times
+  /// the time spent in the most expensive region of the profile.  Returns
+  /// false if the profile does not cover the function containing 'forOp'.
+  bool isCold(AffineForOp forOp, double coldThreshold) const;
+
+  /// Returns the average number of iterations of 'forOp' per entry, rounded
+  /// to the nearest integer, or None if it was never entered.
+  Optional<uint64_t> getAverageTripCount(AffineForOp forOp) const;
+
+private:
+  llvm::StringMap<ProfileCounters> regions;
+  /// The time spent in the most expensive region.
+  int64_t maxNanoseconds = 0;
+};
+
+/// Returns the name under which the profile records 'forOp':
+/// "affine.for @<function> <location>".
+std::string getProfileRegionName(AffineForOp forOp);
+
+/// Returns the name under which the profile records 'function':
+/// "func @<function> <location>".
+std::string getProfileRegionName(Function &function);
+
+/// Returns the profile given with -loop-profile, read on first use, or null if
+/// none was given or it could not be read.
+const LoopProfile *getLoopProfile();
+
+/// Returns true if the profile given with -loop-profile shows 'forOp' to be
+/// cold, with the threshold given with -loop-profile-cold-threshold.  The loop
+/// transformations leave the cold loop nests alone.
+bool isColdLoop(AffineForOp forOp);
+
+/// Returns the trip count of 'forOp' if it is a constant, or otherwise its
+/// average trip count in the profile given with -loop-profile, if any.
+Optional<uint64_t> getEstimatedTripCount(AffineForOp forOp);
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_LOOPPROFILE_H
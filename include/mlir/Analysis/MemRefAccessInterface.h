@@ -0,0 +1,35 @@
+//===- MemRefAccessInterface.h - MemRef access interface --------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the interface of the ops accessing an element of a
+// memref, generated from MemRefAccessInterface.td.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_MEMREFACCESSINTERFACE_H
+#define MLIR_ANALYSIS_MEMREFACCESSINTERFACE_H
+
+#include "mlir/IR/OpDefinition.h"
+#include "mlir/IR/StandardTypes.h"
+
+namespace mlir {
+
+#include "mlir/Analysis/MemRefAccessInterface.h.inc"
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_MEMREFACCESSINTERFACE_H
@@ -0,0 +1,68 @@
+//===- MemRefBoundsAnalysis.h - Accesses proven in bounds -------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines an analysis proving the memref accesses of a
+// function to stay within the bounds of their memref, which the
+// -memref-bound-check pass reports on and the -annotate-memref-bounds pass
+// exports to the lowering to the LLVM IR dialect.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_MEMREF_BOUNDS_ANALYSIS_H
+#define MLIR_ANALYSIS_MEMREF_BOUNDS_ANALYSIS_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <vector>
+
+namespace mlir {
+
+class Function;
+class Operation;
+
+/// Proves the loads, stores and vector transfers of a function to access their
+/// memref in bounds for any iteration of the surrounding loops. An access is
+/// first checked against the ranges of its indices computed by the
+/// IntegerRangeAnalysis, which also bounds the indices of the dynamic
+/// dimensions by the size of the memref, and only then against the
+/// FlatAffineConstraints of the region it accesses, which requires a static
+/// shape.
+///
+/// The analysis is available through the AnalysisManager. It stays valid as
+/// long as the accesses and the ops defining their indices are left untouched.
+class MemRefBoundsAnalysis {
+public:
+  explicit MemRefBoundsAnalysis(Function *function);
+
+  /// Returns true if 'op' is an access proven to be in bounds.
+  bool isInBounds(Operation *op) const { return inBoundsAccesses.count(op); }
+
+  /// Returns the loads and stores that could not be proven in bounds, in the
+  /// order of a walk of the function.
+  ArrayRef<Operation *> getUnprovenAccesses() const {
+    return unprovenAccesses;
+  }
+
+private:
+  llvm::DenseSet<Operation *> inBoundsAccesses;
+  std::vector<Operation *> unprovenAccesses;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_MEMREF_BOUNDS_ANALYSIS_H
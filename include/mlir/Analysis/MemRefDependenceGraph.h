@@ -0,0 +1,256 @@
+//===- MemRefDependenceGraph.h - Memref dependence graph --------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines a graph of the memref dependences between the
+// top-level operations of a function, which transformations such as loop
+// fusion keep up to date incrementally as they restructure the function.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_MEMREFDEPENDENCEGRAPH_H
+#define MLIR_ANALYSIS_MEMREFDEPENDENCEGRAPH_H
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include <functional>
+
+namespace mlir {
+
+class Function;
+class Operation;
+class Value;
+
+/// LoopNestStateCollector walks loop nests and collects load and store
+/// operations, and whether or not a region other than an 'affine.for' was
+/// encountered in the loop nest.
+struct LoopNestStateCollector {
+  SmallVector<AffineForOp, 4> forOps;
+  SmallVector<Operation *, 4> loadOpInsts;
+  SmallVector<Operation *, 4> storeOpInsts;
+  bool hasNonForRegion = false;
+
+  void collect(Operation *opToWalk);
+};
+
+/// MemRefDependenceGraph is a graph data structure where graph nodes are
+/// top-level operations in a Function which contain load/store ops, and edges
+/// are memref dependences between the nodes.
+///
+/// The graph keeps indices from operations to nodes, from memrefs to the nodes
+/// accessing them, and from node pairs to the edges between them, so that the
+/// queries and the incremental updates performed after each transformation
+/// only visit the nodes and edges that they affect.
+// TODO(andydavis) Add a more flexible dependece graph representation.
+// TODO(andydavis) Add a depth parameter to dependence graph construction.
+struct MemRefDependenceGraph {
+public:
+  // Node represents a node in the graph. A Node is either an entire loop nest
+  // rooted at the top level which contains loads/stores, or a top level
+  // load/store.
+  struct Node {
+    // The unique identifier of this node in the graph.
+    unsigned id;
+    // The top-level statment which is (or contains) loads/stores.
+    Operation *op;
+    // List of load operations.
+    SmallVector<Operation *, 4> loads;
+    // List of store op insts.
+    SmallVector<Operation *, 4> stores;
+    // The memrefs under which this node is recorded in 'memrefAccesses'. They
+    // are kept apart from 'loads' and 'stores', since those ops may have been
+    // erased by the time the node is updated or removed.
+    SmallPtrSet<Value *, 4> memrefs;
+    Node(unsigned id, Operation *op) : id(id), op(op) {}
+
+    // Returns the load op count for 'memref'.
+    unsigned getLoadOpCount(Value *memref);
+
+    // Returns the store op count for 'memref'.
+    unsigned getStoreOpCount(Value *memref);
+
+    // Returns all store ops in 'storeOps' which access 'memref'.
+    void getStoreOpsForMemref(Value *memref,
+                              SmallVectorImpl<Operation *> *storeOps);
+
+    // Returns all load ops in 'loadOps' which access 'memref'.
+    void getLoadOpsForMemref(Value *memref,
+                             SmallVectorImpl<Operation *> *loadOps);
+
+    // Returns all memrefs in 'loadAndStoreMemrefSet' for which this node
+    // has at least one load and store operation.
+    void getLoadAndStoreMemrefSet(DenseSet<Value *> *loadAndStoreMemrefSet);
+  };
+
+  // Edge represents a data dependece between nodes in the graph.
+  struct Edge {
+    // The id of the node at the other end of the edge.
+    // If this edge is stored in Edge = Node.inEdges[i], then
+    // 'Node.inEdges[i].id' is the identifier of the source node of the edge.
+    // If this edge is stored in Edge = Node.outEdges[i], then
+    // 'Node.outEdges[i].id' is the identifier of the dest node of the edge.
+    unsigned id;
+    // The SSA value on which this edge represents a dependence.
+    // If the value is a memref, then the dependence is between graph nodes
+    // which contain accesses to the same memref 'value'. If the value is a
+    // non-memref value, then the dependence is between a graph node which
+    // defines an SSA value and another graph node which uses the SSA value
+    // (e.g. a constant operation defining a value which is used inside a loop
+    // nest).
+    Value *value;
+  };
+
+  // Map from node id to Node.
+  DenseMap<unsigned, Node> nodes;
+  // Map from node id to list of input edges.
+  DenseMap<unsigned, SmallVector<Edge, 2>> inEdges;
+  // Map from node id to list of output edges.
+  DenseMap<unsigned, SmallVector<Edge, 2>> outEdges;
+  // Map from memref to a count on the dependence edges associated with that
+  // memref.
+  DenseMap<Value *, unsigned> memrefEdgeCount;
+  // The next unique identifier to use for newly created graph nodes.
+  unsigned nextNodeId = 0;
+
+  MemRefDependenceGraph() {}
+
+  // Initializes the dependence graph based on operations in 'f'.
+  // Returns true on success, false otherwise.
+  bool init(Function &f);
+
+  // Returns the graph node for 'id'.
+  Node *getNode(unsigned id) {
+    auto it = nodes.find(id);
+    assert(it != nodes.end());
+    return &it->second;
+  }
+
+  // Returns the graph node for 'forOp', or nullptr if there is none.
+  Node *getForOpNode(AffineForOp forOp);
+
+  // Adds a node with 'op' to the graph and returns its unique identifier.
+  unsigned addNode(Operation *op);
+
+  // Remove node 'id' (and its associated edges) from graph.
+  void removeNode(unsigned id);
+
+  // Returns true if node 'id' writes to any memref which escapes (or is an
+  // argument to) the function/block. Returns false otherwise.
+  bool writesToLiveInOrEscapingMemrefs(unsigned id);
+
+  // Returns true if node 'id' can be removed from the graph. Returns false
+  // otherwise. A node can be removed from the graph iff the following
+  // conditions are met:
+  // *) The node does not write to any memref which escapes (or is a
+  //    function/block argument).
+  // *) The node has no successors in the dependence graph.
+  bool canRemoveNode(unsigned id);
+
+  // Returns true iff there is an edge from node 'srcId' to node 'dstId' which
+  // is for 'value' if non-null, or for any value otherwise. Returns false
+  // otherwise.
+  bool hasEdge(unsigned srcId, unsigned dstId, Value *value = nullptr);
+
+  // Adds an edge from node 'srcId' to node 'dstId' for 'value'.
+  void addEdge(unsigned srcId, unsigned dstId, Value *value);
+
+  // Removes an edge from node 'srcId' to node 'dstId' for 'value'.
+  void removeEdge(unsigned srcId, unsigned dstId, Value *value);
+
+  // Returns true if there is a path in the dependence graph from node 'srcId'
+  // to node 'dstId'. Returns false otherwise.
+  bool hasDependencePath(unsigned srcId, unsigned dstId);
+
+  // Returns the input edge count for node 'id' and 'memref' from src nodes
+  // which access 'memref' with a store operation.
+  unsigned getIncomingMemRefAccesses(unsigned id, Value *memref);
+
+  // Returns the output edge count for node 'id' and 'memref' (if non-null),
+  // otherwise returns the total output edge count from node 'id'.
+  unsigned getOutEdgeCount(unsigned id, Value *memref = nullptr);
+
+  // Computes and returns an insertion point operation, before which the
+  // the fused <srcId, dstId> loop nest can be inserted while preserving
+  // dependences. Returns nullptr if no such insertion point is found.
+  Operation *getFusedLoopNestInsertionPoint(unsigned srcId, unsigned dstId);
+
+  // Computes and returns an insertion point operation, before which the loop
+  // nest fusing all the nodes 'srcIds' into node 'dstId' can be inserted while
+  // preserving dependences. Returns nullptr if no such insertion point is
+  // found.
+  Operation *getFusedLoopNestInsertionPoint(ArrayRef<unsigned> srcIds,
+                                            unsigned dstId);
+
+  // Updates edge mappings from node 'srcId' to node 'dstId' after 'oldMemRef'
+  // has been replaced in node at 'dstId' by a private memref.
+  void updateEdges(unsigned srcId, unsigned dstId, Value *oldMemRef);
+
+  // Update edge mappings for nodes 'sibId' and 'dstId' to reflect fusion
+  // of sibling node 'sidId' into node 'dstId'.
+  void updateEdges(unsigned sibId, unsigned dstId);
+
+  // Replaces the load and store ops of node 'id' with 'loads' and 'stores',
+  // after the loop nest of the node has been transformed. Only the entries of
+  // the memrefs accessed before or after the transformation are updated.
+  void updateNodeAccesses(unsigned id, ArrayRef<Operation *> loads,
+                          ArrayRef<Operation *> stores);
+
+  // Calls 'callback' for each input edge incident to node 'id' which carries a
+  // memref dependence.
+  void forEachMemRefInputEdge(unsigned id,
+                              const std::function<void(Edge)> &callback);
+  // Calls 'callback' for each output edge from node 'id' which carries a
+  // memref dependence.
+  void forEachMemRefOutputEdge(unsigned id,
+                               const std::function<void(Edge)> &callback);
+  // Calls 'callback' for each edge in 'edges' which carries a memref
+  // dependence.
+  void forEachMemRefEdge(ArrayRef<Edge> edges,
+                         const std::function<void(Edge)> &callback);
+
+  void print(raw_ostream &os) const;
+  void dump() const;
+
+private:
+  // Records that node 'id' accesses the memrefs of its loads and stores.
+  void addMemRefAccesses(unsigned id);
+  // Removes the records that node 'id' accesses memrefs.
+  void removeMemRefAccesses(unsigned id);
+  // Returns true if 'memref' is a block argument or has a use which is not a
+  // dereferencing op. The result is cached, since fusion only introduces
+  // dereferencing uses of existing memrefs.
+  bool isLiveInOrEscapingMemRef(Value *memref);
+
+  // Map from the operation of each node to its id.
+  DenseMap<Operation *, unsigned> opToNodeId;
+  // Map from memref to the ids of the nodes which load or store it.
+  DenseMap<Value *, SetVector<unsigned>> memrefAccesses;
+  // The set of <src id, dst id, value> triples which have an edge.
+  DenseSet<std::pair<std::pair<unsigned, unsigned>, Value *>> edgeSet;
+  // Map from <src id, dst id> to the number of edges between the two nodes.
+  DenseMap<std::pair<unsigned, unsigned>, unsigned> numEdgesBetween;
+  // Cached results of isLiveInOrEscapingMemRef.
+  DenseMap<Value *, bool> liveInOrEscapingMemRefs;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_MEMREFDEPENDENCEGRAPH_H
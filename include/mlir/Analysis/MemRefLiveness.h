@@ -0,0 +1,84 @@
+//===- MemRefLiveness.h - Live ranges of buffers ----------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines an analysis of the live ranges of the buffers
+// allocated by the 'alloc' operations of a function, which tells whether two
+// buffers may be live at the same time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_MEMREFLIVENESS_H
+#define MLIR_ANALYSIS_MEMREFLIVENESS_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+
+namespace mlir {
+
+class AllocOp;
+class Function;
+class Operation;
+
+/// The live ranges of the buffers allocated in a function, available through
+/// the AnalysisManager. The operations of the function are numbered in the
+/// order of a pre-order walk, so that the operations nested in an operation
+/// have the numbers following its own. The live range of a buffer starts at
+/// its 'alloc' and ends after the last operation of the block of the 'alloc'
+/// that uses it or contains a use of it: a buffer used in a loop is thus live
+/// during all of the iterations of the loop. A buffer accessed by a 'dma_start'
+/// is live until the 'dma_wait's on the tag of the transfer. An 'alloc'
+/// executed several times, e.g. in the body of a loop, defines a new buffer
+/// every time, and the buffers of two executions of an 'alloc' are never live
+/// at the same time if its uses are all within its block.
+///
+/// The live range of a buffer is only known when all of its uses are nested in
+/// the block of its 'alloc'. Within a block of a CFG, it then ends before the
+/// control leaves the block, and the live ranges of buffers allocated in
+/// different blocks never overlap. The analysis doesn't track the memrefs
+/// derived from a buffer: a pass using it must check that the buffers it
+/// considers are only used directly.
+class MemRefLiveness {
+public:
+  /// The range of the numbers of the operations during which a buffer is live.
+  struct LiveRange {
+    unsigned start, end;
+
+    /// Returns true if the two ranges have an operation in common.
+    bool overlaps(const LiveRange &other) const {
+      return start <= other.end && other.start <= end;
+    }
+  };
+
+  explicit MemRefLiveness(Function *function);
+
+  /// Returns the live range of the buffer allocated by 'allocOp', or None if
+  /// some of its uses are not nested in the block of 'allocOp'.
+  Optional<LiveRange> getLiveRange(AllocOp allocOp) const;
+
+  /// Returns true if the buffers allocated by 'allocA' and 'allocB' may be live
+  /// at the same time, which is conservatively the case if either live range
+  /// is unknown.
+  bool mayInterfere(AllocOp allocA, AllocOp allocB) const;
+
+private:
+  llvm::DenseMap<Operation *, LiveRange> liveRanges;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_MEMREFLIVENESS_H
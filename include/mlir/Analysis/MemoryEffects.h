@@ -0,0 +1,64 @@
+//===- MemoryEffects.h - Memory effects of operations -----------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the model of the effects of operations on memory, and the
+// interface of the ops describing their effects, generated from
+// MemoryEffects.td.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_MEMORYEFFECTS_H
+#define MLIR_ANALYSIS_MEMORYEFFECTS_H
+
+#include "mlir/IR/OpDefinition.h"
+
+namespace mlir {
+
+/// An effect of an operation on a memref.
+struct MemoryEffect {
+  enum Kind {
+    /// The operation reads elements of the memref.
+    Read,
+    /// The operation writes elements of the memref.
+    Write,
+    /// The operation allocates the memref, which is one of its results.
+    Allocate,
+    /// The operation deallocates the memref.
+    Free,
+  };
+
+  MemoryEffect(Kind kind, Value *memref) : kind(kind), memref(memref) {}
+
+  /// Returns true if the effect may change the content of the memref.
+  bool mayWrite() const { return kind == Write || kind == Free; }
+
+  Kind kind;
+  Value *memref;
+};
+
+#include "mlir/Analysis/MemoryEffects.h.inc"
+
+/// Appends the memory effects of `op` to `effects` and returns true if they are
+/// known, i.e. if `op` has no side effect or implements
+/// MemoryEffectsOpInterface.  Returns false otherwise, in which case `op` may
+/// have any effect on memory.  The effects of the operations nested in the
+/// regions of `op` are not included.
+bool getMemoryEffects(Operation *op, SmallVectorImpl<MemoryEffect> &effects);
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_MEMORYEFFECTS_H
@@ -103,15 +103,23 @@ struct NestedPattern {
   NestedPattern &operator=(const NestedPattern &) = default;
 
   /// Returns all the top-level matches in `func`.
-  void match(Function *func, SmallVectorImpl<NestedMatch> *matches) {
+  void match(Function *func, SmallVectorImpl<NestedMatch> *matches) const {
     func->walkPostOrder([&](Operation *op) { matchOne(op, matches); });
   }
 
   /// Returns all the top-level matches in `op`.
-  void match(Operation *op, SmallVectorImpl<NestedMatch> *matches) {
+  void match(Operation *op, SmallVectorImpl<NestedMatch> *matches) const {
     op->walkPostOrder([&](Operation *child) { matchOne(child, matches); });
   }
 
+  /// Returns all the top-level matches of each of `patterns` in `func` or
+  /// `op`, in a single walk of the IR: `matches[i]` is filled with the matches
+  /// of `patterns[i]`, in the same order as `patterns[i].match` would.
+  static void match(Function *func, ArrayRef<NestedPattern> patterns,
+                    ArrayRef<SmallVectorImpl<NestedMatch> *> matches);
+  static void match(Operation *op, ArrayRef<NestedPattern> patterns,
+                    ArrayRef<SmallVectorImpl<NestedMatch> *> matches);
+
   /// Returns the depth of the pattern.
   unsigned getDepth() const;
 
@@ -125,7 +133,11 @@ private:
 
   /// Matches this pattern against a single `op` and fills matches with the
   /// result.
-  void matchOne(Operation *op, SmallVectorImpl<NestedMatch> *matches);
+  void matchOne(Operation *op, SmallVectorImpl<NestedMatch> *matches) const;
+
+  /// Matches each of `patterns` against a single `op`.
+  static void matchOne(Operation *op, ArrayRef<NestedPattern> patterns,
+                       ArrayRef<SmallVectorImpl<NestedMatch> *> matches);
 
   /// Nested patterns to be matched.
   ArrayRef<NestedPattern> nestedPatterns;
@@ -38,6 +38,10 @@ FunctionPassBase *createMemRefDependenceCheckPass();
 /// Creates a pass to test parallelism detection; emits note for parallel loops.
 FunctionPassBase *createParallelismDetectionTestPass();
 
+/// Creates a pass to test the analysis of the ranges of index values; emits a
+/// note with the range of each index value.
+FunctionPassBase *createIntegerRangeTestPass();
+
 } // end namespace mlir
 
 #endif // MLIR_ANALYSIS_PASSES_H
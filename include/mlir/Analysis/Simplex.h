@@ -0,0 +1,218 @@
+//===- Simplex.h - MLIR Simplex Class ---------------------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// A simplex tableau over the rationals, used to answer emptiness and
+// optimization queries on systems of affine constraints.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_ANALYSIS_SIMPLEX_H
+#define MLIR_ANALYSIS_SIMPLEX_H
+
+#include "mlir/Support/LogicalResult.h"
+#include "mlir/Support/MathExtras.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace mlir {
+
+class FlatAffineConstraints;
+
+/// A rational number, represented by a numerator and a positive denominator.
+struct Fraction {
+  Fraction(int64_t num = 0, int64_t den = 1) : num(num), den(den) {
+    assert(den > 0 && "expected a positive denominator");
+  }
+
+  /// Returns the largest integer smaller than or equal to this fraction.
+  int64_t floor() const { return floorDiv(num, den); }
+
+  /// Returns the smallest integer greater than or equal to this fraction.
+  int64_t ceil() const { return ceilDiv(num, den); }
+
+  bool isIntegral() const { return num % den == 0; }
+
+  int64_t num, den;
+};
+
+/// A simplex tableau over a fixed number of rational variables, to which
+/// equality and inequality constraints can be added incrementally. The
+/// constraints have the same layout as the rows of FlatAffineConstraints:
+/// coeffs[0]*x_0 + ... + coeffs[n-1]*x_{n-1} + coeffs[n] >= 0 (or == 0).
+///
+/// The tableau expresses the unknowns that are in rows (the basis) as affine
+/// functions of the unknowns that are in columns, whose values are zero in the
+/// current sample point. The unknowns are the variables, which are
+/// unrestricted in sign, and the constraints, which are restricted to be
+/// non-negative. Each row stores a positive denominator, a constant term and
+/// the coefficients of the column unknowns, all as integers, so that the
+/// arithmetic is exact. An intermediate overflow is detected and recorded, in
+/// which case the queries are inconclusive.
+///
+/// Adding a constraint keeps the sample point feasible by pivoting, like the
+/// dual simplex method, so that the emptiness of the constraints is known
+/// after each addition. Pivots follow Bland's rule, which cannot cycle.
+///
+/// The rational queries are exact. The integer emptiness check is a branch
+/// and bound search on top of them, which is bounded in size and may be
+/// inconclusive.
+class Simplex {
+public:
+  enum class Direction { Up, Down };
+
+  /// Constructs a tableau with `numVars` variables and no constraints.
+  explicit Simplex(unsigned numVars);
+
+  /// Constructs a tableau with the equalities and the inequalities of `cst`,
+  /// with a variable for each of its identifiers.
+  explicit Simplex(const FlatAffineConstraints &cst);
+
+  unsigned getNumVariables() const { return var.size(); }
+
+  /// Adds the inequality sum(coeffs[i] * x_i) + coeffs[n] >= 0.
+  void addInequality(ArrayRef<int64_t> coeffs);
+
+  /// Adds the equality sum(coeffs[i] * x_i) + coeffs[n] == 0.
+  void addEquality(ArrayRef<int64_t> coeffs);
+
+  /// Returns true if the constraints have no rational solution.
+  bool isEmpty() const { return empty; }
+
+  /// Returns true if an intermediate result overflowed, in which case the
+  /// results of the queries are meaningless.
+  bool hasOverflowed() const { return overflowed; }
+
+  /// Returns the maximum (Direction::Up) or the minimum (Direction::Down) of
+  /// the affine expression sum(coeffs[i] * x_i) + coeffs[n] over the rational
+  /// solutions of the constraints. Returns None if the constraints are empty,
+  /// if the expression is unbounded, or on overflow.
+  Optional<Fraction> computeOptimum(Direction direction,
+                                    ArrayRef<int64_t> coeffs) const;
+
+  /// Returns the lexicographically smallest (Direction::Down) or largest
+  /// (Direction::Up) rational solution of the constraints. Returns None if the
+  /// constraints are empty, if the lexicographic optimum is unbounded, or on
+  /// overflow.
+  Optional<SmallVector<Fraction, 8>>
+  computeRationalLexOptimum(Direction direction) const;
+
+  /// Returns true if the constraints have no integer solution, and false if an
+  /// integer solution was found. The search explores at most `maxNodes`
+  /// branches; None is returned if this limit is reached, or on overflow.
+  Optional<bool> isIntegerEmpty(unsigned maxNodes) const;
+
+  /// Returns the value of the `varIndex`^th variable in the current sample
+  /// point, which satisfies all of the constraints when they are not empty.
+  Fraction getSampleValue(unsigned varIndex) const;
+
+  void print(raw_ostream &os) const;
+  void dump() const;
+
+private:
+  /// An unknown of the tableau: either a variable or a constraint. `pos` is
+  /// the position of its row if it is in the basis, and of its column
+  /// otherwise.
+  struct Unknown {
+    Unknown(bool isRow, bool isRestricted, unsigned pos)
+        : isRow(isRow), isRestricted(isRestricted), pos(pos) {}
+
+    bool isRow;
+    /// Restricted unknowns must be non-negative.
+    bool isRestricted;
+    unsigned pos;
+  };
+
+  /// Returns the entry of the tableau at the specified row and column. The
+  /// first column holds the denominators and the second one the constant
+  /// terms of the rows.
+  int64_t &at(unsigned row, unsigned col) { return tableau[row * nCol + col]; }
+  int64_t at(unsigned row, unsigned col) const {
+    return tableau[row * nCol + col];
+  }
+
+  /// The unknowns are indexed by a non-negative index for the constraints and
+  /// by the complement of their index for the variables.
+  Unknown &unknownFromIndex(int index) {
+    return index >= 0 ? con[index] : var[~index];
+  }
+  const Unknown &unknownFromIndex(int index) const {
+    return index >= 0 ? con[index] : var[~index];
+  }
+
+  /// Returns the rank of the unknown with the given index in the order used
+  /// by Bland's rule, i.e., the variables come first then the constraints.
+  unsigned getRank(int index) const {
+    return index >= 0 ? var.size() + index : ~index;
+  }
+
+  /// Adds a row for the constraint sum(coeffs[i] * x_i) + coeffs[n], which
+  /// is restricted to be non-negative if `isRestricted` is set, and returns
+  /// its position.
+  unsigned addRow(ArrayRef<int64_t> coeffs, bool isRestricted);
+
+  /// Exchanges the unknown of `pivotRow` with the unknown of `pivotCol`, and
+  /// updates the expressions of the other rows accordingly.
+  void pivot(unsigned pivotRow, unsigned pivotCol);
+
+  /// Returns a column whose unknown can be moved so that the value of the
+  /// unknown of `row` changes in `direction`, following Bland's rule.
+  /// Returns None if the value of `row` is optimal in that direction.
+  Optional<unsigned> findPivotCol(unsigned row, Direction direction) const;
+
+  /// Returns the restricted row, other than `skipRow`, whose value first
+  /// reaches zero when the unknown of `col` moves so that the value of
+  /// `skipRow` changes in `direction`. Returns None if no row bounds the move.
+  Optional<unsigned> findPivotRow(unsigned skipRow, Direction direction,
+                                  unsigned col);
+
+  /// Pivots until the restricted unknown of `row` is non-negative in the
+  /// sample point. Returns failure if this is not possible, i.e., if the
+  /// constraints are empty.
+  LogicalResult restoreRow(unsigned row);
+
+  /// Divides the entries of `row` by their greatest common divisor.
+  void normalizeRow(unsigned row);
+
+  /// Arithmetic operations that record the overflows.
+  int64_t add(int64_t a, int64_t b);
+  int64_t mul(int64_t a, int64_t b);
+
+  /// Implements isIntegerEmpty, decrementing `remainingNodes` for each
+  /// explored branch.
+  Optional<bool> isIntegerEmptyImpl(unsigned &remainingNodes) const;
+
+  /// The number of rows and columns of the tableau.
+  unsigned nRow, nCol;
+
+  /// The entries of the tableau, stored row by row.
+  SmallVector<int64_t, 64> tableau;
+
+  /// The indices of the unknowns of the rows and of the columns. The first
+  /// two columns do not have an unknown.
+  SmallVector<int, 8> rowUnknown, colUnknown;
+
+  /// The constraints and the variables of the tableau.
+  SmallVector<Unknown, 8> con, var;
+
+  bool empty = false;
+  bool overflowed = false;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_ANALYSIS_SIMPLEX_H
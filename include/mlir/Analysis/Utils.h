@@ -30,6 +30,7 @@
 #include "mlir/IR/Block.h"
 #include "mlir/IR/Location.h"
 #include "mlir/Support/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
 #include <memory>
 
@@ -37,7 +38,9 @@ namespace mlir {
 
 class AffineForOp;
 class Block;
+class DependenceAnalysis;
 class FlatAffineConstraints;
+class Function;
 class Location;
 class MemRefAccess;
 class Operation;
@@ -227,6 +230,22 @@ template <typename LoadOrStoreOpPointer>
 LogicalResult boundCheckLoadOrStoreOp(LoadOrStoreOpPointer loadOrStoreOp,
                                       bool emitError = true);
 
+/// Returns true if the element accessed by the load or store op
+/// 'loadOrStoreOp' provably lies within the static bounds of its memref for any
+/// iteration of the surrounding loops.  Unlike boundCheckLoadOrStoreOp, which
+/// only fails for the accesses that may be out of bounds, this fails whenever
+/// the access can't be analyzed.
+template <typename LoadOrStoreOpPointer>
+bool isLoadOrStoreInBounds(LoadOrStoreOpPointer loadOrStoreOp);
+
+/// Returns true if all the elements accessed by the vector transfer 'transfer'
+/// provably lie within the static bounds of its memref, i.e., if the start
+/// positions of 'transfer' extended by the vector along the memref dimensions
+/// selected by its permutation map are in bounds for any iteration of the
+/// surrounding loops.
+template <typename VectorTransferOpTy>
+bool isVectorTransferInBounds(VectorTransferOpTy transfer);
+
 /// Returns the number of surrounding loops common to both A and B.
 unsigned getNumCommonSurroundingLoops(Operation &A, Operation &B);
 
@@ -235,8 +254,121 @@ unsigned getNumCommonSurroundingLoops(Operation &A, Operation &B);
 Optional<int64_t> getMemoryFootprintBytes(AffineForOp forOp,
                                           int memorySpace = -1);
 
-/// Returns true if `forOp' is a parallel loop.
-bool isLoopParallel(AffineForOp forOp);
+/// Gets the memory footprint of all data touched in the specified memory space
+/// in bytes by a single execution of 'block', i.e., for fixed values of the
+/// IVs of the loops surrounding it.
+Optional<int64_t> getMemoryFootprintBytes(Block &block, int memorySpace = -1);
+
+/// Gets the memory footprint of all data touched in the specified memory space
+/// in bytes by the loop nest rooted at 'forOp' when the loops of 'sliceState'
+/// only run the iterations within its bounds, e.g. a single tile of a band.
+Optional<int64_t> getMemoryFootprintBytes(AffineForOp forOp,
+                                          ComputationSliceState *sliceState,
+                                          int memorySpace = -1);
+
+/// A memoized view of the memory footprints of the loop nests of a function,
+/// available through the AnalysisManager. The regions accessed by a loop nest
+/// and their total size are cached per loop and loop depth. The cached results
+/// are only valid as long as the loop nests are left untouched: a pass that
+/// transforms loops or the accesses they contain while using this analysis
+/// must invalidate them.
+class MemoryFootprintAnalysis {
+public:
+  /// The union of the regions accessed per memref by a loop nest, and their
+  /// total size in bytes if known.
+  struct Footprint {
+    SmallVector<std::unique_ptr<MemRefRegion>, 4> regions;
+    Optional<int64_t> sizeInBytes;
+  };
+
+  explicit MemoryFootprintAnalysis(Function *function) {}
+
+  /// Returns the footprint of the accesses nested in 'forOp', with regions
+  /// symbolic in the IVs of the 'loopDepth' outermost loops surrounding them,
+  /// or null if a region can't be computed. At the nesting depth of 'forOp',
+  /// this is the footprint of the loop nest; one level deeper, the one of a
+  /// single iteration of its body.
+  const Footprint *getFootprint(AffineForOp forOp, unsigned loopDepth);
+
+  /// Returns the footprint in bytes of the loop nest rooted at 'forOp', like
+  /// getMemoryFootprintBytes.
+  Optional<int64_t> getFootprintBytes(AffineForOp forOp);
+
+  /// Returns the footprint in bytes of a single iteration of the body of
+  /// 'forOp', like getMemoryFootprintBytes on this body.
+  Optional<int64_t> getBodyFootprintBytes(AffineForOp forOp);
+
+  /// Drops the cached footprints of the loops nested in 'op' and of those
+  /// surrounding it, which must be called before 'op' is erased or after it or
+  /// the loops it contains change.
+  void invalidate(Operation *op);
+
+  /// Drops all of the cached footprints.
+  void clear() { footprints.clear(); }
+
+private:
+  using Key = std::pair<Operation *, unsigned>;
+  llvm::DenseMap<Key, std::unique_ptr<Footprint>> footprints;
+};
+
+/// Returns true if `forOp' is a parallel loop. The dependences are checked
+/// through 'dependences' if it is provided, so that its cached results are
+/// reused.
+bool isLoopParallel(AffineForOp forOp,
+                    DependenceAnalysis *dependences = nullptr);
+
+/// Finds the parallel loops of a function, along with the dependences carried
+/// by the others, in a single pass over the pairs of loads and stores of the
+/// function, instead of checking all the pairs nested in each loop as
+/// isLoopParallel does. The dependence of every pair of accesses is first
+/// solved once for all their common loops, without ordering the accesses: only
+/// the loops for which the dependence distance may be non-zero are then checked
+/// exactly. A loop is parallel under the same conditions as for isLoopParallel.
+///
+/// The analysis is available through the AnalysisManager. It is computed
+/// eagerly, and must not be queried for the loops created after it.
+class LoopParallelismAnalysis {
+public:
+  /// A dependence from the access of the first op to the access of the second.
+  using Dependence = std::pair<Operation *, Operation *>;
+
+  explicit LoopParallelismAnalysis(Function *function);
+
+  /// Returns true if 'forOp' doesn't carry any dependence.
+  bool isParallel(AffineForOp forOp) const;
+
+  /// Returns the dependences carried by 'forOp'.
+  ArrayRef<Dependence> getCarriedDependences(AffineForOp forOp) const;
+
+private:
+  /// Records the dependences between 'opA' and 'opB', in either direction, in
+  /// the loops carrying them.
+  void addCarriedDependences(Operation *opA, Operation *opB);
+
+  llvm::DenseMap<Operation *, SmallVector<Dependence, 2>> carriedDependences;
+};
+
+/// Returns true if 'memref' is allocated in its function and is only loaded
+/// from, stored to, or deallocated, i.e., if no other memref may alias it.
+bool isLocalMemRef(Value *memref);
+
+/// Returns true if the load/store op's 'opA' and 'opB' access the same memref
+/// element in any given iteration of their surrounding loops, i.e., if their
+/// access functions composed with the affine.apply op's feeding them are
+/// identical.
+bool haveSameMemRefAccess(Operation *opA, Operation *opB);
+
+/// Returns true if there is a dependence from the load/store op 'srcOpInst' to
+/// the load/store op 'dstOpInst' at a loop depth greater than 'minLoopDepth'.
+bool hasMemRefDependence(Operation *srcOpInst, Operation *dstOpInst,
+                         unsigned minLoopDepth);
+
+/// Returns true if a store executing after the op 'srcOpInst' and before the
+/// load 'loadOpInst', which 'srcOpInst' must dominate, may write to the memref
+/// element read by the load. Conservatively returns true if what executes in
+/// between can't be determined, i.e., if the load isn't nested in the block of
+/// 'srcOpInst'.
+bool isWrittenBetween(Operation *srcOpInst, Operation *loadOpInst);
 
 } // end namespace mlir
 
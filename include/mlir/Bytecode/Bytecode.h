@@ -0,0 +1,57 @@
+//===- Bytecode.h - MLIR binary module format -------------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the entry points for reading and writing MLIR modules in
+// the binary bytecode format.  The bytecode format is a compact, versioned
+// alternative to the textual form produced by the AsmPrinter: types,
+// attributes, identifiers and locations are uniqued into tables, operands are
+// encoded as variable-width value references, and each function body is
+// stored in its own section.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_BYTECODE_BYTECODE_H
+#define MLIR_BYTECODE_BYTECODE_H
+
+namespace llvm {
+class MemoryBufferRef;
+class raw_ostream;
+} // end namespace llvm
+
+namespace mlir {
+class MLIRContext;
+class Module;
+
+/// Write the given module to `os` in the bytecode format.
+void writeBytecodeFile(Module *module, llvm::raw_ostream &os);
+
+/// Returns true if the given buffer starts with the bytecode magic number.
+bool isBytecodeFile(llvm::MemoryBufferRef buffer);
+
+/// This reads the bytecode held in the given buffer and returns an MLIR module
+/// if it was valid.  If not, the error message is emitted through the error
+/// handler registered in the context, and a null pointer is returned.
+///
+/// If 'lazyLoadBodies' is true, the functions of the module are left
+/// materializable and their bodies are only read when first accessed.  In this
+/// case the buffer, which is typically memory-mapped, must outlive the module.
+Module *readBytecodeFile(llvm::MemoryBufferRef buffer, MLIRContext *context,
+                         bool lazyLoadBodies = false);
+
+} // end namespace mlir
+
+#endif // MLIR_BYTECODE_BYTECODE_H
@@ -48,6 +48,9 @@ class ValueHandle;
 /// scoped fashion. This abstracts away all the boilerplate related to
 /// checking proper usage of captures, NestedBuilders as well as handling the
 /// setting and restoring of insertion points.
+/// The stack of ScopedContexts is kept per thread, so that several threads may
+/// build functions concurrently, as long as they build them in different
+/// MLIRContexts or only use the thread-safe uniquing of a shared one.
 class ScopedContext {
 public:
   /// Sets location to fun->getLoc() in case the provided Loction* is null.
@@ -203,6 +206,27 @@ private:
   SmallVector<LoopBuilder, 4> loops;
 };
 
+/// A LoopNestBuilder whose loops are asserted to carry no dependences.
+/// Every AffineForOp of the nest is given the "llvm.loop.parallel" loop hint,
+/// which the affine lowering moves to the back-edge of the lowered loop so
+/// that it ends up in the loop metadata of the LLVM IR. No dependence check
+/// is performed: this is meant for generators that know their loops to be
+/// parallel by construction.
+///
+/// Usage:
+///
+/// ```c++
+///    ParallelLoopNestBuilder({&i, &j}, {lb, lb}, {ub, ub}, {1, 1})({
+///      ...
+///    });
+/// ```
+class ParallelLoopNestBuilder : public LoopNestBuilder {
+public:
+  ParallelLoopNestBuilder(ArrayRef<ValueHandle *> ivs,
+                          ArrayRef<ValueHandle> lbs, ArrayRef<ValueHandle> ubs,
+                          ArrayRef<int64_t> steps);
+};
+
 // This class exists solely to handle the C++ vexing parse case when
 // trying to enter a Block that has already been constructed.
 class Append {};
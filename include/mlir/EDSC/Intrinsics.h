@@ -171,6 +171,11 @@ using load = ValueBuilder<LoadOp>;
 using ret = OperationBuilder<ReturnOp>;
 using select = ValueBuilder<SelectOp>;
 using store = OperationBuilder<StoreOp>;
+using vector_broadcast = ValueBuilder<VectorBroadcastOp>;
+using vector_outerproduct = ValueBuilder<VectorOuterProductOp>;
+using vector_shape_cast = ValueBuilder<VectorShapeCastOp>;
+using vector_transfer_read = ValueBuilder<VectorTransferReadOp>;
+using vector_transfer_write = OperationBuilder<VectorTransferWriteOp>;
 using vector_type_cast = ValueBuilder<VectorTypeCastOp>;
 
 /// Branches into the mlir::Block* captured by BlockHandle `b` with `operands`.
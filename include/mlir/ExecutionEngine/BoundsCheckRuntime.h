@@ -0,0 +1,36 @@
+//===- BoundsCheckRuntime.h - Runtime support for bounds checks -*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the runtime function called by the bounds checks that the
+// -annotate-memref-bounds pass inserts before the memref accesses it can't
+// prove in bounds.  The ExecutionEngine makes it available to the JIT-compiled
+// code.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_EXECUTIONENGINE_BOUNDSCHECKRUNTIME_H_
+#define MLIR_EXECUTIONENGINE_BOUNDSCHECKRUNTIME_H_
+
+#include <cstdint>
+
+extern "C" {
+/// Abort the execution with an error message unless `index` is within
+/// [0, `size`), the range of the indices of a dimension of `size` elements.
+void mlir_memref_bounds_check(intptr_t index, intptr_t size);
+}
+
+#endif // MLIR_EXECUTIONENGINE_BOUNDSCHECKRUNTIME_H_
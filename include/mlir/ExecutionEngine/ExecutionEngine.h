@@ -26,8 +26,11 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/Error.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace llvm {
 template <typename T> class Expected;
@@ -36,12 +39,157 @@ class Module;
 
 namespace mlir {
 
+class MLIRContext;
 class Module;
 
 namespace impl {
 class OrcJIT;
+class TieredCompilation;
 } // end namespace impl
 
+/// Options controlling how an ExecutionEngine compiles its module.
+struct ExecutionEngineOptions {
+  /// The CPU and the comma-separated list of additional features to generate
+  /// code for.  By default, code is generated for the host CPU and all of the
+  /// features it supports.  See `createHostTargetMachineBuilder`.
+  std::string targetCPU;
+  std::string targetFeatures;
+
+  /// If not empty, compiled object files are cached in this directory, keyed
+  /// by the fingerprint of the module, the host target and `transformerKey`.
+  /// The latter must uniquely identify the effect of the transformer, e.g. the
+  /// optimization level.  When the cache already holds an object for the
+  /// module, it is loaded directly instead of lowering and compiling the
+  /// module, in which case the module is left untouched.  The cache is only
+  /// used when the module is compiled as a whole, i.e. without the options
+  /// below.
+  std::string objectCacheDir;
+  std::string transformerKey;
+
+  /// If true, all of the floating point operations of the module are compiled
+  /// with all of the fast-math flags, as if they carried a "fastmath"
+  /// attribute with the "fast" flag, and the code generator may relax the
+  /// floating point semantics of its functions.
+  bool enableFastMath = false;
+
+  /// If greater than one, the LLVM module is split into this many parts that
+  /// are compiled in parallel on the thread pool of the MLIRContext.
+  unsigned numCompileThreads = 1;
+
+  /// If true, the LLVM module is split into one part per function, and each
+  /// part is only compiled the first time one of its symbols is needed, i.e.
+  /// when a function is looked up or when a compiled function refers to it.
+  bool lazyCompilation = false;
+
+  /// If true, the module is only lowered to the LLVM dialect upfront, and each
+  /// function is translated to LLVM IR and compiled the first time it is
+  /// needed, i.e. when it is looked up or when a compiled function refers to
+  /// it.  This avoids translating functions that are never called, but
+  /// requires the module to outlive the engine.  This takes precedence over
+  /// the options above.
+  bool lazyTranslation = false;
+
+  /// If true, the GPU kernels of the module, see `createOutlineGPUKernelsPass`,
+  /// are translated to PTX for the GPU architecture `gpuArch` and registered
+  /// with the GPU runtime, which launches them on the GPU if it was built with
+  /// MLIR_CUDA_RUNTIME_ENABLED.  The kernels are otherwise executed on the
+  /// host.  The object cache is not used when this is set.
+  bool enableGPU = false;
+  std::string gpuArch = "sm_35";
+
+  /// The options below make the JIT-compiled code visible to debuggers and
+  /// profilers.  The compiled functions have the names of the MLIR functions
+  /// they are compiled from, e.g. `foo`, while their packed wrappers are named
+  /// `_mlir_foo`.
+
+  /// If true, the objects loaded by the JIT are registered with GDB through
+  /// its JIT interface, so that it can symbolize and debug the compiled code.
+  bool enableGDBNotificationListener = false;
+
+  /// If true, the objects loaded by the JIT are reported to the perf JIT event
+  /// listener of LLVM, which writes the jitdump files that `perf inject` reads.
+  /// This has no effect unless LLVM is built with LLVM_USE_PERF.
+  bool enablePerfNotificationListener = false;
+
+  /// If true, the address range and the name of each function loaded by the
+  /// JIT are appended to a perf map file, which `perf report`, VTune and other
+  /// profilers read to symbolize JIT-compiled code.  The file is
+  /// `/tmp/perf-<pid>.map`, as those profilers expect, unless `perfMapFile`
+  /// is set.
+  bool enablePerfMap = false;
+  std::string perfMapFile;
+};
+
+/// A callable handle to a JIT-compiled function with the packed interface
+/// described below.  The handle is resolved once, so calling it involves no
+/// lookup nor allocation.  The code generated by the engine doesn't hold any
+/// state, so a handle can be called from several threads concurrently, and
+/// reentrantly, as long as the invocations don't write to the same memory
+/// through their arguments.  The handle is only valid as long as the engine
+/// that created it.
+class JITFunction {
+public:
+  using PackedFunctionPtr = void (*)(void **);
+
+  explicit JITFunction(PackedFunctionPtr fptr = nullptr) : fptr(fptr) {}
+
+  /// Invoke the function with the given list of type-erased pointers to its
+  /// arguments, followed by a pointer to its result.
+  void operator()(void **args) const { fptr(args); }
+
+  /// Invoke the function passing it the list of arguments.  The arguments are
+  /// accepted by lvalue-reference since the packed function interface expects
+  /// a list of non-null pointers.
+  template <typename... Args> void operator()(Args &... args) const {
+    // Reserve one more slot so that the array isn't empty for nullary calls.
+    void *packedArgs[sizeof...(Args) + 1] = {static_cast<void *>(&args)...};
+    fptr(packedArgs);
+  }
+
+  PackedFunctionPtr getPointer() const { return fptr; }
+  explicit operator bool() const { return fptr; }
+
+private:
+  PackedFunctionPtr fptr;
+};
+
+/// A callable handle to a function of an engine created with
+/// `ExecutionEngine::createTiered`.  The handle calls the quickly-compiled
+/// version of the function until the optimized version is swapped in, and the
+/// optimized version afterwards; the calls running when the versions are
+/// swapped complete in the quick version.  Like `JITFunction`, calling the
+/// handle involves no lookup nor allocation, it can be done concurrently, and
+/// the handle is only valid as long as the engine that created it.
+class TieredFunction {
+public:
+  using PackedFunctionPtr = JITFunction::PackedFunctionPtr;
+
+  explicit TieredFunction(const std::atomic<PackedFunctionPtr> *slot = nullptr)
+      : slot(slot) {}
+
+  /// Invoke the current version of the function with the given list of
+  /// type-erased pointers to its arguments, followed by a pointer to its
+  /// result.
+  void operator()(void **args) const { getPointer()(args); }
+
+  /// Invoke the current version of the function passing it the list of
+  /// arguments, accepted by lvalue-reference like in `JITFunction`.
+  template <typename... Args> void operator()(Args &... args) const {
+    // Reserve one more slot so that the array isn't empty for nullary calls.
+    void *packedArgs[sizeof...(Args) + 1] = {static_cast<void *>(&args)...};
+    getPointer()(packedArgs);
+  }
+
+  /// Returns the pointer to the current version of the function.
+  PackedFunctionPtr getPointer() const {
+    return slot->load(std::memory_order_acquire);
+  }
+  explicit operator bool() const { return slot; }
+
+private:
+  const std::atomic<PackedFunctionPtr> *slot;
+};
+
 /// JIT-backed execution engine for MLIR modules.  Assumes the module can be
 /// converted to LLVM IR.  For each function, creates a wrapper function with
 /// the fixed interface
@@ -58,15 +206,67 @@ public:
 
   /// Creates an execution engine for the given module.  If `transformer` is
   /// provided, it will be called on the LLVM module during JIT-compilation and
-  /// can be used, e.g., for reporting or optimization.
+  /// can be used, e.g., for reporting or optimization.  When the module is
+  /// split into parts, see `ExecutionEngineOptions`, it is called on each of
+  /// the parts.
   static llvm::Expected<std::unique_ptr<ExecutionEngine>>
-  create(Module *m,
-         std::function<llvm::Error(llvm::Module *)> transformer = {});
+  create(Module *m, std::function<llvm::Error(llvm::Module *)> transformer = {},
+         const ExecutionEngineOptions &options = {});
+
+  /// Creates an execution engine compiling its functions in two tiers.  The
+  /// engine is first created like `create` does for `m` with `transformer`,
+  /// which should favor compilation speed, e.g. with no optimization at all.
+  /// A second engine is then created for `optimizedModule` with
+  /// `optimizedTransformer` on a background thread, and its functions are
+  /// swapped in for the later calls through `TieredFunction` handles, and for
+  /// the later lookups, once it is fully compiled.  As creating an engine
+  /// lowers its module, the two versions are compiled from two modules
+  /// holding the same functions, e.g. parsed twice, of which only
+  /// `optimizedModule` may have been optimized at the MLIR level.  It must
+  /// outlive the background compilation and not be used in the meantime.  The
+  /// object cache is not used by tiered engines.
+  static llvm::Expected<std::unique_ptr<ExecutionEngine>>
+  createTiered(Module *m, Module *optimizedModule,
+               std::function<llvm::Error(llvm::Module *)> transformer,
+               std::function<llvm::Error(llvm::Module *)> optimizedTransformer,
+               const ExecutionEngineOptions &options = {});
+
+  /// Lowers the given module like `create` does and compiles it for the host
+  /// into a relocatable object file written to `filename`, instead of JIT
+  /// compiling it.  The object defines the same `_mlir_funcName` packed
+  /// wrappers as the JIT-compiled code, so a shared library linked from it can
+  /// be loaded and invoked without LLVM in the process.  If `transformer` is
+  /// provided, it is called on the LLVM module before code generation.  Only
+  /// the target and fast-math options of `options` are used.
+  static llvm::Error
+  emitObjectFile(Module *m, StringRef filename,
+                 std::function<llvm::Error(llvm::Module *)> transformer = {},
+                 const ExecutionEngineOptions &options = {});
 
   /// Looks up a packed-argument function with the given name and returns a
   /// pointer to it.  Propagates errors in case of failure.
   llvm::Expected<void (*)(void **)> lookup(StringRef name) const;
 
+  /// Looks up a packed-argument function with the given name and returns a
+  /// handle to it, which should be preferred over `invoke` for functions that
+  /// are called repeatedly.  Lookups may be performed concurrently.
+  llvm::Expected<JITFunction> getFunction(StringRef name) const;
+
+  /// Looks up a packed-argument function with the given name in an engine
+  /// created with `createTiered`, and returns a handle calling its optimized
+  /// version once it's available.  The handles to a function share their
+  /// state, so getting one is only expensive the first time.
+  llvm::Expected<TieredFunction> getTieredFunction(StringRef name) const;
+
+  /// Returns true if the engine was created with `createTiered` and its
+  /// optimized version was swapped in.
+  bool isOptimized() const;
+
+  /// Waits for the compilation of the optimized version of an engine created
+  /// with `createTiered`, if any, and returns its error if it failed, in which
+  /// case the engine keeps on using the quick version.
+  llvm::Error waitForOptimization();
+
   /// Invokes the function with the given name passing it the list of arguments.
   /// The arguments are accepted by lvalue-reference since the packed function
   /// interface expects a list of non-null pointers.
@@ -78,12 +278,41 @@ public:
   /// the templated `invoke`.
   llvm::Error invoke(StringRef name, MutableArrayRef<void *> args);
 
+  /// Invokes the function with the given name once for each of the given
+  /// lists of type-erased argument pointers, in parallel on the thread pool of
+  /// `context`.  See `JITFunction` for the requirements on the invocations.
+  llvm::Error invokeMany(StringRef name, ArrayRef<void **> argumentPacks,
+                         MLIRContext *context);
+
 private:
+  friend class impl::TieredCompilation;
+
   // Ordering of llvmContext and jit is important for destruction purposes: the
   // jit must be destroyed before the context.
   llvm::LLVMContext llvmContext;
   // Private implementation of the JIT (PIMPL)
   std::unique_ptr<impl::OrcJIT> jit;
+  // The state of the tiered compilation, if any.  It must be destroyed, which
+  // waits for the background compilation, before the jit.
+  std::unique_ptr<impl::TieredCompilation> tiered;
+  // The host functions launching the GPU kernels registered with the GPU
+  // runtime, which are unregistered when the engine is destroyed.
+  std::vector<void (*)(void **)> gpuKernels;
+
+  // Implements `create`.  If `translateToOwnContexts` is set, the module is
+  // translated like when compiled on several threads, into LLVM modules with
+  // their own contexts, so that it can be done concurrently with the
+  // translations of other modules of the MLIRContext.
+  static llvm::Expected<std::unique_ptr<ExecutionEngine>>
+  createImpl(Module *m,
+             std::function<llvm::Error(llvm::Module *)> transformer,
+             const ExecutionEngineOptions &options,
+             bool translateToOwnContexts);
+
+  // Translates the GPU kernels of `m`, lowered to the LLVM dialect, to PTX and
+  // registers them with the GPU runtime if `options` enables it.
+  llvm::Error registerGPUKernels(Module *m,
+                                 const ExecutionEngineOptions &options);
 };
 
 template <typename... Args>
@@ -0,0 +1,66 @@
+//===- GPURuntime.h - Runtime support for GPU kernels -----------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the runtime functions called by the code generated for
+// the kernels outlined by the -outline-gpu-kernels pass.  The kernels whose PTX
+// was registered are launched on the first CUDA device through the CUDA driver
+// API, when the runtime is built with MLIR_CUDA_RUNTIME_ENABLED.  The other
+// kernels are executed on the host, one block at a time per thread of the
+// parallel runtime, which is also how the kernels run without a GPU.  The
+// ExecutionEngine makes these functions available to the JIT-compiled code and
+// registers the PTX of the kernels when compiling for a GPU.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_EXECUTIONENGINE_GPURUNTIME_H_
+#define MLIR_EXECUTIONENGINE_GPURUNTIME_H_
+
+#include <cstdint>
+
+extern "C" {
+/// Execute a kernel over a grid of `gridX` x `gridY` x `gridZ` blocks of
+/// `blockX` x `blockY` x `blockZ` threads, and return once all of them are
+/// done.  `kernel` is the host function calling the kernel with the parameters
+/// pointed to by the elements of `params`, which also identifies the kernel.
+/// Nothing is executed if the grid is empty.
+void mlir_gpu_launch(void (*kernel)(void **), intptr_t gridX, intptr_t gridY,
+                     intptr_t gridZ, intptr_t blockX, intptr_t blockY,
+                     intptr_t blockZ, void **params);
+
+/// Register `ptx`, the PTX assembly defining the kernel named `name`, so that
+/// the launches of `kernel` run on the GPU.  The strings are copied.
+void mlir_gpu_register_kernel(void (*kernel)(void **), const char *name,
+                              const char *ptx);
+
+/// Forget the PTX registered for `kernel`, whose code is about to be freed.
+void mlir_gpu_unregister_kernel(void (*kernel)(void **));
+
+/// Return the ids of the thread executing a kernel on the host, and the
+/// dimensions of its block.  On the GPU, the kernels read the corresponding
+/// special registers instead.
+intptr_t mlir_gpu_thread_id_x();
+intptr_t mlir_gpu_thread_id_y();
+intptr_t mlir_gpu_thread_id_z();
+intptr_t mlir_gpu_block_id_x();
+intptr_t mlir_gpu_block_id_y();
+intptr_t mlir_gpu_block_id_z();
+intptr_t mlir_gpu_block_dim_x();
+intptr_t mlir_gpu_block_dim_y();
+intptr_t mlir_gpu_block_dim_z();
+}
+
+#endif // MLIR_EXECUTIONENGINE_GPURUNTIME_H_
@@ -0,0 +1,52 @@
+//===- MathRuntime.h - Vectorized math functions for JIT code ---*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the math runtime linked into the code compiled by the
+// MLIR ExecutionEngine.  The runtime provides polynomial approximations of
+// elementary functions on f32 scalars and vectors, emitted as LLVM IR in the
+// modules that use them so that they get inlined and vectorized along with
+// their callers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_EXECUTIONENGINE_MATHRUNTIME_H_
+#define MLIR_EXECUTIONENGINE_MATHRUNTIME_H_
+
+namespace llvm {
+class Module;
+} // namespace llvm
+
+namespace mlir {
+
+/// Define the functions of the math runtime that are declared in `module`.
+/// The runtime functions are named after the function they compute and the
+/// number of lanes of their f32 vector argument, or no suffix for scalars:
+///
+///   func @mlir_expf(f32) -> f32
+///   func @mlir_expf8(vector<8xf32>) -> vector<8xf32>
+///
+/// The supported functions are `mlir_expf`, `mlir_logf` and `mlir_tanhf`, for
+/// any number of lanes; the widths of 4, 8 and 16 lanes map to the SSE, AVX
+/// and AVX-512 registers.  The approximations are accurate to a few units in
+/// the last place over the domain of the functions.  Declarations with a name
+/// or a type that doesn't match these are left untouched.  The definitions
+/// have internal linkage.
+void linkMathRuntime(llvm::Module &module);
+
+} // end namespace mlir
+
+#endif // MLIR_EXECUTIONENGINE_MATHRUNTIME_H_
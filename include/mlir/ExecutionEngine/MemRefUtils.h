@@ -24,14 +24,17 @@
 #define MLIR_EXECUTIONENGINE_MEMREFUTILS_H_
 
 #include "mlir/Support/LLVM.h"
+#include "llvm/Support/Error.h"
 
-namespace llvm {
-template <typename T> class Expected;
-}
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace mlir {
 
 class Function;
+class FunctionType;
+class MemRefType;
 
 /// Simple memref descriptor class compatible with the ABI of functions emitted
 /// by MLIR to LLVM IR conversion for statically-shaped memrefs of float type.
@@ -50,6 +53,107 @@ allocateMemRefArguments(Function *func, float initialValue = 0.0);
 /// element type f32.
 void freeMemRefArguments(ArrayRef<void *> args);
 
+/// Return the size in bytes of the elements of the given memref type in
+/// memory, or 0 if the element type is neither an integer nor a float.
+size_t getMemRefElementSize(MemRefType type);
+
+/// Return the shape of the given memref type, with its dynamic dimensions
+/// taken in order from the front of `dynamicSizes`, which is updated to drop
+/// them.
+llvm::Expected<SmallVector<int64_t, 4>>
+resolveMemRefShape(MemRefType type, ArrayRef<int64_t> &dynamicSizes);
+
+/// A reusable list of packed arguments for invoking a JIT-compiled MLIR
+/// function that takes and returns memrefs of any integer or floating-point
+/// element type.  The memref arguments wrap buffers owned by the caller, which
+/// are never copied.  The descriptors are laid out as expected by the MLIR to
+/// LLVM IR conversion: statically-shaped memrefs are passed as a pointer to
+/// their data, and the others as a structure holding the data pointer followed
+/// by the sizes of their dynamic dimensions, as pointer-sized integers.  The
+/// storage of the descriptors is allocated once, so the pack can be rebound
+/// and invoked repeatedly without allocating.
+class MemRefArgumentPack {
+public:
+  /// Create a pack for the arguments and results of `func`, which must be
+  /// memrefs with an integer or floating-point element type.
+  static llvm::Expected<MemRefArgumentPack> create(Function *func);
+
+  /// Create a pack for the arguments and results of a function of `type`,
+  /// e.g. the type of a function recorded before the lowering of its module to
+  /// the LLVM IR dialect.
+  static llvm::Expected<MemRefArgumentPack> create(FunctionType type);
+
+  /// The packed arguments point into the storage of the descriptors: a pack
+  /// may be moved, which keeps that storage, but not copied.
+  MemRefArgumentPack(MemRefArgumentPack &&) = default;
+  MemRefArgumentPack &operator=(MemRefArgumentPack &&) = default;
+  MemRefArgumentPack(const MemRefArgumentPack &) = delete;
+  MemRefArgumentPack &operator=(const MemRefArgumentPack &) = delete;
+
+  unsigned getNumArguments() const { return numArguments; }
+  unsigned getNumResults() const { return descriptors.size() - numArguments; }
+
+  /// Bind the argument at `index` to the buffer `data`, whose elements must
+  /// have the same size as the element type of the memref.  The sizes of the
+  /// dynamic dimensions of the memref, if any, are given by `dynamicSizes`.
+  template <typename T>
+  llvm::Error setArgument(unsigned index, T *data,
+                          ArrayRef<int64_t> dynamicSizes = {}) {
+    return setArgumentImpl(index, data, sizeof(T), dynamicSizes);
+  }
+
+  /// Bind the argument at `index` to the untyped buffer `data`, whose elements
+  /// are assumed to match the element type of the memref.
+  llvm::Error setArgument(unsigned index, void *data,
+                          ArrayRef<int64_t> dynamicSizes = {}) {
+    return setArgumentImpl(index, data, /*elementSize=*/0, dynamicSizes);
+  }
+
+  /// Return the data pointer of the result at `index`, as written by the last
+  /// invocation.  This may alias the buffer of an argument.
+  template <typename T> T *getResultData(unsigned index) {
+    return reinterpret_cast<T *>(getDescriptor(numArguments + index)[0]);
+  }
+
+  /// Return the sizes of the dynamic dimensions of the result at `index`, as
+  /// written by the last invocation.
+  ArrayRef<intptr_t> getResultDynamicSizes(unsigned index) {
+    auto &descriptor = descriptors[numArguments + index];
+    return {&storage[descriptor.offset + 1], descriptor.numDynamicSizes};
+  }
+
+  /// Return the type-erased pointers to the descriptors of the arguments
+  /// followed by the results, to be passed to `ExecutionEngine::invoke`.
+  MutableArrayRef<void *> getPackedArguments() { return packedArguments; }
+
+private:
+  struct Descriptor {
+    /// The offset of this descriptor in the storage, and the number of
+    /// dynamic sizes following its data pointer.
+    size_t offset;
+    size_t numDynamicSizes;
+    /// The size in bytes of the elements of the memref in memory.
+    size_t elementSize;
+  };
+
+  MemRefArgumentPack() = default;
+
+  llvm::Error setArgumentImpl(unsigned index, void *data, size_t elementSize,
+                              ArrayRef<int64_t> dynamicSizes);
+
+  intptr_t *getDescriptor(unsigned index) {
+    return &storage[descriptors[index].offset];
+  }
+
+  /// The descriptors of the arguments followed by those of the results.
+  std::vector<Descriptor> descriptors;
+  unsigned numArguments = 0;
+
+  /// The storage of all of the descriptors, and pointers to each of them.
+  std::vector<intptr_t> storage;
+  std::vector<void *> packedArguments;
+};
+
 } // namespace mlir
 
 #endif // MLIR_EXECUTIONENGINE_MEMREFUTILS_H_
@@ -23,6 +23,7 @@
 #ifndef MLIR_EXECUTIONENGINE_OPTUTILS_H_
 #define MLIR_EXECUTIONENGINE_OPTUTILS_H_
 
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
 #include "llvm/Pass.h"
 
 #include <functional>
@@ -31,6 +32,7 @@
 namespace llvm {
 class Module;
 class Error;
+class TargetMachine;
 } // namespace llvm
 
 namespace mlir {
@@ -39,20 +41,35 @@ namespace mlir {
 /// ExecutionEngine.
 void initializeLLVMPasses();
 
+/// Create a builder of target machines for the host.  If `cpu` is empty, the
+/// machines target the host CPU along with the features it supports, otherwise
+/// they target `cpu` with its default features.  `features` is a
+/// comma-separated list of features to enable ("+feature") or disable
+/// ("-feature") on top of these, as accepted by the -mattr option of llc.
+llvm::Expected<llvm::orc::JITTargetMachineBuilder>
+createHostTargetMachineBuilder(llvm::StringRef cpu = "",
+                               llvm::StringRef features = "");
+
 /// Create a module transformer function for MLIR ExecutionEngine that runs
 /// LLVM IR passes corresponding to the given speed and size optimization
-/// levels (e.g. -O2 or -Os).
+/// levels (e.g. -O2 or -Os).  If `targetMachine` is provided, the passes use
+/// its cost model, e.g. to pick vectorization factors suited to its CPU.  It
+/// must outlive the transformer, which only uses copies of it, so that the
+/// transformer can be called on several modules concurrently.
 std::function<llvm::Error(llvm::Module *)>
-makeOptimizingTransformer(unsigned optLevel, unsigned sizeLevel);
+makeOptimizingTransformer(unsigned optLevel, unsigned sizeLevel,
+                          llvm::TargetMachine *targetMachine = nullptr);
 
 /// Create a module transformer function for MLIR ExecutionEngine that runs
 /// LLVM IR passes explicitly specified, plus an optional optimization level,
 /// Any optimization passes, if present, will be inserted before the pass at
-/// position optPassesInsertPos.
+/// position optPassesInsertPos.  `targetMachine` is used as in
+/// `makeOptimizingTransformer`.
 std::function<llvm::Error(llvm::Module *)>
 makeLLVMPassesTransformer(llvm::ArrayRef<const llvm::PassInfo *> llvmPasses,
                           llvm::Optional<unsigned> mbOptLevel,
-                          unsigned optPassesInsertPos = 0);
+                          unsigned optPassesInsertPos = 0,
+                          llvm::TargetMachine *targetMachine = nullptr);
 
 } // end namespace mlir
 
@@ -0,0 +1,41 @@
+//===- ParallelRuntime.h - Runtime support for parallel loops ---*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the runtime functions called by the code generated for
+// the loops outlined by the -outline-parallel-loops pass.  The ExecutionEngine
+// makes them available to the JIT-compiled code.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_EXECUTIONENGINE_PARALLELRUNTIME_H_
+#define MLIR_EXECUTIONENGINE_PARALLELRUNTIME_H_
+
+#include <cstdint>
+
+extern "C" {
+/// Execute the iterations `lowerBound`, `lowerBound + step`, ... up to
+/// `upperBound` (excluded) of a parallel loop on the threads of a process-wide
+/// thread pool, and return once all of them are done.  The iterations are split
+/// into contiguous chunks, and `body` is called with the bounds of each chunk
+/// and with `context`.  Parallel loops nested in `body` are executed
+/// sequentially by the calling thread.
+void mlir_parallel_for(void (*body)(intptr_t, intptr_t, void *),
+                       intptr_t lowerBound, intptr_t upperBound, intptr_t step,
+                       void *context);
+}
+
+#endif // MLIR_EXECUTIONENGINE_PARALLELRUNTIME_H_
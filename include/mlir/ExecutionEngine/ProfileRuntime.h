@@ -0,0 +1,54 @@
+//===- ProfileRuntime.h - Runtime support for loop profiling ----*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the runtime functions called by the code instrumented by
+// the -instrument-loops pass.  They accumulate, for each instrumented loop and
+// function, the number of times it was entered, the number of iterations it
+// executed and the time spent in it, and print them to the standard error when
+// the process exits, or write them to the file named by the MLIR_PROFILE_FILE
+// environment variable.  The ExecutionEngine makes them available to the
+// JIT-compiled code and registers the names of the instrumented regions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_EXECUTIONENGINE_PROFILERUNTIME_H_
+#define MLIR_EXECUTIONENGINE_PROFILERUNTIME_H_
+
+#include <cstdint>
+
+extern "C" {
+/// Return a monotonic timestamp, in nanoseconds, marking the entry into an
+/// instrumented region.
+int64_t mlir_profile_timestamp();
+
+/// Record an execution of the loop identified by `region`, entered at the
+/// timestamp `start`, iterating from `lowerBound` to `upperBound` (excluded)
+/// by `step`.
+void mlir_profile_record_loop(int64_t region, int64_t start,
+                              intptr_t lowerBound, intptr_t upperBound,
+                              intptr_t step);
+
+/// Record a call to the function identified by `region`, entered at the
+/// timestamp `start`.
+void mlir_profile_record_function(int64_t region, int64_t start);
+
+/// Set the name under which the counters of `region` are printed.  The regions
+/// recorded without a name are printed with their identifier.
+void mlir_profile_register_region(int64_t region, const char *name);
+}
+
+#endif // MLIR_EXECUTIONENGINE_PROFILERUNTIME_H_
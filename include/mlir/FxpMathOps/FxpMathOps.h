@@ -28,6 +28,9 @@ namespace fxpmath {
 class FxpMathOpsDialect : public Dialect {
 public:
   FxpMathOpsDialect(MLIRContext *context);
+
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "fxpmath"; }
 };
 
 #define GET_OP_CLASSES
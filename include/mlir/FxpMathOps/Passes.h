@@ -24,6 +24,7 @@
 
 namespace mlir {
 class FunctionPassBase;
+class ModulePassBase;
 
 namespace fxpmath {
 
@@ -33,6 +34,14 @@ namespace fxpmath {
 /// floating point form.
 FunctionPassBase *createLowerUniformRealMathPass();
 
+/// Creates a pass that lowers the integer matmul and conv ops, of static
+/// shapes, to affine loop nests.
+FunctionPassBase *createLowerIntegerContractionsPass();
+
+/// Creates a pass that lowers the fixed-point ops on integers and vectors of
+/// integers, along with the Standard ops, to the LLVM IR dialect.
+ModulePassBase *createConvertFxpMathToLLVMPass();
+
 } // namespace fxpmath
 } // namespace mlir
 
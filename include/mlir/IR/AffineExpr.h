@@ -161,6 +161,12 @@ public:
 
   friend ::llvm::hash_code hash_value(AffineExpr arg);
 
+  /// Return the storage of this instance as an opaque pointer, identifying it
+  /// within its context.
+  const void *getAsOpaquePointer() const {
+    return static_cast<const void *>(expr);
+  }
+
 protected:
   ImplType *expr;
 };
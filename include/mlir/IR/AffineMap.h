@@ -26,6 +26,7 @@
 #include "mlir/Support/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/SmallVector.h"
 
 namespace mlir {
 
@@ -120,6 +121,12 @@ public:
   LogicalResult constantFold(ArrayRef<Attribute> operandConstants,
                              SmallVectorImpl<Attribute> &results) const;
 
+  /// Returns the values of the results of this map applied to 'operands', the
+  /// values of its dimensions then symbols.  The results are evaluated from a
+  /// flattened form computed when the map is uniqued, so that evaluating the
+  /// same map on many operands is cheap.
+  SmallVector<int64_t, 4> evaluate(ArrayRef<int64_t> operands) const;
+
   /// Returns the AffineMap resulting from composing `this` with `map`.
   /// The resulting AffineMap has as many AffineDimExpr as `map` and as many
   /// AffineSymbolExpr as the concatenation of `this` and `map` (in which case
@@ -141,6 +148,12 @@ public:
 
   friend ::llvm::hash_code hash_value(AffineMap arg);
 
+  /// Return the storage of this instance as an opaque pointer, identifying it
+  /// within its context.
+  const void *getAsOpaquePointer() const {
+    return static_cast<const void *>(map);
+  }
+
 private:
   ImplType *map;
 };
@@ -21,6 +21,10 @@
 #include "mlir/Support/LLVM.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/iterator.h"
+#include "llvm/ADT/iterator_range.h"
+#include <cstring>
+#include <type_traits>
 
 namespace mlir {
 class AffineMap;
@@ -371,6 +375,53 @@ public:
   static bool kindof(Kind kind) { return kind == Kind::SplatElements; }
 };
 
+namespace detail {
+/// The base of the random access iterators over the elements of a dense
+/// elements attribute, which read the current element from the raw data of the
+/// attribute when dereferenced. The raw data of a splat only holds its first
+/// element, which all of the positions then refer to.
+template <typename ConcreteT, typename T>
+class DenseElementIteratorBase
+    : public llvm::iterator_facade_base<ConcreteT,
+                                        std::random_access_iterator_tag, T,
+                                        std::ptrdiff_t, T, T> {
+  using BaseT =
+      llvm::iterator_facade_base<ConcreteT, std::random_access_iterator_tag, T,
+                                 std::ptrdiff_t, T, T>;
+
+public:
+  using BaseT::operator-;
+
+  bool operator==(const ConcreteT &rhs) const { return index == rhs.index; }
+  bool operator<(const ConcreteT &rhs) const { return index < rhs.index; }
+  std::ptrdiff_t operator-(const ConcreteT &rhs) const {
+    return index - rhs.index;
+  }
+  ConcreteT &operator+=(std::ptrdiff_t offset) {
+    index += offset;
+    return static_cast<ConcreteT &>(*this);
+  }
+  ConcreteT &operator-=(std::ptrdiff_t offset) {
+    index -= offset;
+    return static_cast<ConcreteT &>(*this);
+  }
+
+protected:
+  DenseElementIteratorBase(const char *rawData, bool isSplat,
+                           std::ptrdiff_t index)
+      : rawData(rawData), isSplat(isSplat), index(index) {}
+
+  /// Returns the index of the current element within the raw data.
+  std::ptrdiff_t getDataIndex() const { return isSplat ? 0 : index; }
+
+  /// The raw data of the attribute, whether it is a splat, and the index of the
+  /// current element.
+  const char *rawData;
+  bool isSplat;
+  std::ptrdiff_t index;
+};
+} // namespace detail
+
 /// An attribute that represents a reference to a dense vector or tensor object.
 ///
 class DenseElementsAttr : public ElementsAttr {
@@ -378,10 +429,95 @@ public:
   using ElementsAttr::ElementsAttr;
   using ImplType = detail::DenseElementsAttributeStorage;
 
+  /// An iterator over the elements as values of the C++ integer or floating
+  /// point type 'T' they are stored as, see 'isStoredAs'.
+  template <typename T>
+  class ElementIterator
+      : public detail::DenseElementIteratorBase<ElementIterator<T>, T> {
+  public:
+    ElementIterator(const char *rawData, bool isSplat, std::ptrdiff_t index)
+        : detail::DenseElementIteratorBase<ElementIterator<T>, T>(
+              rawData, isSplat, index) {}
+
+    T operator*() const {
+      T value;
+      std::memcpy(&value, this->rawData + this->getDataIndex() * sizeof(T),
+                  sizeof(T));
+      return value;
+    }
+  };
+
+  /// An iterator over the elements of any integer type as APInts.
+  class IntElementIterator
+      : public detail::DenseElementIteratorBase<IntElementIterator, APInt> {
+  public:
+    IntElementIterator(const char *rawData, bool isSplat, std::ptrdiff_t index,
+                       size_t bitWidth)
+        : DenseElementIteratorBase(rawData, isSplat, index),
+          bitWidth(bitWidth) {}
+
+    APInt operator*() const {
+      return readBits(rawData, getDataIndex() * bitWidth, bitWidth);
+    }
+
+  private:
+    size_t bitWidth;
+  };
+
+  /// An iterator over the elements of any floating point type as APFloats.
+  class FloatElementIterator
+      : public detail::DenseElementIteratorBase<FloatElementIterator, APFloat> {
+  public:
+    FloatElementIterator(const char *rawData, bool isSplat,
+                         std::ptrdiff_t index, size_t bitWidth,
+                         const llvm::fltSemantics &semantics)
+        : DenseElementIteratorBase(rawData, isSplat, index),
+          bitWidth(bitWidth), semantics(&semantics) {}
+
+    APFloat operator*() const {
+      return APFloat(*semantics,
+                     readBits(rawData, getDataIndex() * bitWidth, bitWidth));
+    }
+
+  private:
+    size_t bitWidth;
+    const llvm::fltSemantics *semantics;
+  };
+
   /// It assumes the elements in the input array have been truncated to the bits
-  /// width specified by the element type.
+  /// width specified by the element type. If all of the elements are equal,
+  /// only the first one is kept, see 'isSplat'.
   static DenseElementsAttr get(VectorOrTensorType type, ArrayRef<char> data);
 
+  /// Constructs a dense elements attribute all the elements of which are equal
+  /// to the one whose raw data is 'elementData'.
+  static DenseElementsAttr getSplat(VectorOrTensorType type,
+                                    ArrayRef<char> elementData);
+
+  /// Constructs a dense elements attribute referring to the raw data 'data'
+  /// held outside of the context, e.g. in a memory mapped file, without copying
+  /// it. The data must outlive the context, be 64-bit aligned, and be readable
+  /// up to the next multiple of 64 bits. Such attributes are uniqued on the
+  /// address of their data rather than on its content, so that they are created
+  /// in constant time, and don't compare equal to the attributes holding the
+  /// same elements in the context.
+  static DenseElementsAttr getExternal(VectorOrTensorType type,
+                                       ArrayRef<char> data);
+
+  /// Constructs a dense elements attribute holding the raw data at byte
+  /// 'offset' of the file 'filename', which is mapped in memory once for the
+  /// lifetime of the context rather than read. The data is referred to in
+  /// place, see 'getExternal', if it is 64-bit aligned and padded to a whole
+  /// word in the file, and copied into the context otherwise. Emits an error at
+  /// 'location' and returns null if the file can't be mapped or is too short.
+  static DenseElementsAttr getFromFile(VectorOrTensorType type,
+                                       StringRef filename, uint64_t offset,
+                                       Location location);
+
+  /// Returns the name of the file and the byte offset in it of the raw data, if
+  /// it is held in a file mapped by 'getFromFile'.
+  Optional<std::pair<StringRef, uint64_t>> getFileLocation() const;
+
   // Constructs a dense elements attribute from an array of element values. Each
   // element attribute value is expected to be an element of 'type'.
   static DenseElementsAttr get(VectorOrTensorType type,
@@ -393,6 +529,53 @@ public:
 
   void getValues(SmallVectorImpl<Attribute> &values) const;
 
+  /// Returns true if the elements are stored as values of the C++ integer or
+  /// floating point type 'T', i.e. if they are integers or floats of the same
+  /// size. The elements may then be read and constructed as such.
+  template <typename T> bool isStoredAs() const {
+    static_assert(std::is_arithmetic<T>::value,
+                  "expected an integer or floating point type");
+    return !std::is_same<T, bool>::value &&
+           isStoredAs(sizeof(T), std::is_integral<T>::value);
+  }
+
+  /// Returns the elements as values of the C++ type 'T', read directly from the
+  /// raw data without materializing them. 'isStoredAs<T>()' must hold.
+  template <typename T>
+  llvm::iterator_range<ElementIterator<T>> getValues() const {
+    assert(isStoredAs<T>() && "elements aren't stored as values of type T");
+    const char *rawData = getRawData().data();
+    bool splat = isSplat();
+    return {ElementIterator<T>(rawData, splat, 0),
+            ElementIterator<T>(rawData, splat, getNumElements())};
+  }
+
+  /// Returns the elements of an integer attribute as APInts, read from the raw
+  /// data when iterated over.
+  llvm::iterator_range<IntElementIterator> getIntValues() const;
+
+  /// Returns the elements of a floating point attribute as APFloats, read from
+  /// the raw data when iterated over.
+  llvm::iterator_range<FloatElementIterator> getFloatValues() const;
+
+  /// Constructs a dense elements attribute from an array of values of the C++
+  /// type 'T' the elements of 'type' are stored as, without converting them
+  /// one by one. This is instantiated for the fixed width integer types, float
+  /// and double.
+  template <typename T>
+  static DenseElementsAttr get(VectorOrTensorType type, ArrayRef<T> values);
+
+  /// Returns the number of elements.
+  size_t getNumElements() const;
+
+  /// Returns true if all of the elements are equal, in which case the raw data
+  /// only holds the first one.
+  bool isSplat() const;
+
+  /// Returns true if the raw data is held outside of the context, see
+  /// 'getExternal'.
+  bool isExternal() const;
+
   ArrayRef<char> getRawData() const;
 
   /// Writes value to the bit position `bitPos` in array `rawData`. 'rawData' is
@@ -417,6 +600,11 @@ protected:
   /// Parses the raw integer internal value for each dense element into
   /// 'values'.
   void getRawValues(SmallVectorImpl<APInt> &values) const;
+
+private:
+  /// Returns true if the elements are stored as values of 'size' bytes, which
+  /// are integers if 'isInteger' is set and floating point values otherwise.
+  bool isStoredAs(size_t size, bool isInteger) const;
 };
 
 /// An attribute that represents a reference to a dense integer vector or tensor
@@ -535,6 +723,11 @@ public:
   /// Return the value of the element at the given index.
   Attribute getValue(ArrayRef<uint64_t> index) const;
 
+  /// Gets the offset of each stored element into the row-major elements of the
+  /// statically shaped type, in the order of the stored values. This reads the
+  /// indices from their raw data rather than densifying the attribute.
+  void getLinearIndices(SmallVectorImpl<uint64_t> &offsets) const;
+
   /// Method for support type inquiry through isa, cast and dyn_cast.
   static bool kindof(Kind kind) { return kind == Kind::SparseElements; }
 };
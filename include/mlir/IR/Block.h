@@ -23,6 +23,7 @@
 #define MLIR_IR_BLOCK_H
 
 #include "mlir/IR/Value.h"
+#include "mlir/IR/Visitors.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
@@ -138,8 +139,10 @@ public:
   /// Add one argument to the argument list for each type specified in the list.
   llvm::iterator_range<args_iterator> addArguments(ArrayRef<Type> types);
 
-  /// Erase the argument at 'index' and remove it from the argument list.
-  void eraseArgument(unsigned index);
+  /// Erase the argument at 'index' and remove it from the argument list. If
+  /// 'updatePredTerms' is set to true, this argument is also removed from the
+  /// terminators of each predecessor to this block.
+  void eraseArgument(unsigned index, bool updatePredTerms = true);
 
   unsigned getNumArguments() { return arguments.size(); }
   BlockArgument *getArgument(unsigned i) { return arguments[i]; }
@@ -246,22 +249,50 @@ public:
   //===--------------------------------------------------------------------===//
 
   /// Walk the operations of this block in preorder, calling the callback for
-  /// each operation.
-  void walk(const std::function<void(Operation *)> &callback);
+  /// each operation. See Operation::walk for the callbacks accepted.
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walk(FnT &&callback) {
+    return walk(begin(), end(), std::forward<FnT>(callback));
+  }
 
   /// Walk the operations in the specified [begin, end) range of
   /// this block, calling the callback for each operation.
-  void walk(Block::iterator begin, Block::iterator end,
-            const std::function<void(Operation *)> &callback);
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walk(Block::iterator begin, Block::iterator end, FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(
+        walkOperations(begin, end, visit, WalkOrder::PreOrder));
+  }
 
   /// Walk the operations in this block in postorder, calling the callback for
   /// each operation.
-  void walkPostOrder(const std::function<void(Operation *)> &callback);
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walkPostOrder(FnT &&callback) {
+    return walkPostOrder(begin(), end(), std::forward<FnT>(callback));
+  }
 
   /// Walk the operations in the specified [begin, end) range of this block
   /// in postorder, calling the callback for each operation.
-  void walkPostOrder(Block::iterator begin, Block::iterator end,
-                     const std::function<void(Operation *)> &callback);
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walkPostOrder(Block::iterator begin, Block::iterator end,
+                     FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(
+        walkOperations(begin, end, visit, WalkOrder::PostOrder));
+  }
+
+  /// Walk the operations in the [begin, end) range of a block and the
+  /// operations nested in them in the given order, until 'callback' returns
+  /// an interrupted result, which is then returned. This implements all the
+  /// operation walkers. The traversal uses a worklist instead of recursion, so
+  /// that deeply nested regions do not exhaust the stack.
+  static WalkResult walkOperations(iterator begin, iterator end,
+                                   detail::WalkCallback callback,
+                                   WalkOrder order);
 
   //===--------------------------------------------------------------------===//
   // Other
@@ -0,0 +1,108 @@
+//===- Diagnostics.h - MLIR Diagnostic Utilities ----------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file defines utilities for working with the diagnostics emitted through
+// an MLIRContext.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_IR_DIAGNOSTICS_H
+#define MLIR_IR_DIAGNOSTICS_H
+
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Mutex.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class PrettyStackTraceEntry;
+} // end namespace llvm
+
+namespace mlir {
+
+/// A utility class to ensure that diagnostics emitted from multiple threads are
+/// emitted in a deterministic order.  While this handler is alive, it replaces
+/// the diagnostic handler of the context.  Each thread must set the id of the
+/// unit of work it is processing, e.g. the position of a function within its
+/// module, and the diagnostics are re-emitted to the previous handler ordered
+/// by this id once the handler is destroyed.  Any diagnostics that are still
+/// held are also dumped in the event of a crash.
+class ParallelDiagnosticHandler {
+public:
+  explicit ParallelDiagnosticHandler(MLIRContext &ctx);
+  ~ParallelDiagnosticHandler();
+
+  /// Set the order id for the current thread.  Diagnostics emitted by this
+  /// thread are ordered by this id.
+  void setOrderIDForThread(size_t orderID);
+
+  /// Returns true if there are no held diagnostics.
+  bool empty() const { return diagnostics.empty(); }
+
+  /// Drop the held diagnostics emitted for an order id greater than
+  /// 'orderID'.
+  void eraseDiagnosticsAfter(size_t orderID);
+
+  /// Utility method to emit any held diagnostics, ordered by the id that was
+  /// set for the emitting thread.
+  void emitDiagnostics(
+      std::function<void(Location, StringRef, MLIRContext::DiagnosticKind)>
+          emitFn);
+
+private:
+  struct ThreadDiagnostic {
+    ThreadDiagnostic(size_t id, Location loc, StringRef msg,
+                     MLIRContext::DiagnosticKind kind)
+        : id(id), loc(loc), msg(msg), kind(kind) {}
+    bool operator<(const ThreadDiagnostic &rhs) const { return id < rhs.id; }
+
+    /// The order id for this diagnostic.
+    size_t id;
+
+    /// Information for the diagnostic.
+    Location loc;
+    std::string msg;
+    MLIRContext::DiagnosticKind kind;
+  };
+
+  /// The previous context diagnostic handler.
+  MLIRContext::DiagnosticHandlerTy prevHandler;
+
+  /// A smart mutex to lock access to the internal state.
+  llvm::sys::SmartMutex<true> mutex;
+
+  /// A mapping between the thread id and the current order id.
+  DenseMap<uint64_t, size_t> threadToOrderID;
+
+  /// An unordered list of diagnostics that were emitted.
+  std::vector<ThreadDiagnostic> diagnostics;
+
+  /// The context to emit the diagnostics to.
+  MLIRContext &context;
+
+  /// A stack trace entry that dumps any dangling diagnostics in the event of a
+  /// crash.
+  std::unique_ptr<llvm::PrettyStackTraceEntry> crashEntry;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_IR_DIAGNOSTICS_H
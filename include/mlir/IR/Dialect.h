@@ -61,9 +61,10 @@ public:
   /// if non-constant.  If constant folding is successful, this fills in the
   /// `results` vector.  If not, this returns failure and `results` is
   /// unspecified.
-  DialectConstantFoldHook constantFoldHook =
-      [](Operation *op, ArrayRef<Attribute> operands,
-         SmallVectorImpl<Attribute> &results) { return failure(); };
+  ///
+  /// The hook is unset by default, so that the operations without a folder of
+  /// their own can be skipped by the folding of the canonicalizer.
+  DialectConstantFoldHook constantFoldHook;
 
   /// Registered hook to decode opaque constants associated with this
   /// dialect. The hook function attempts to decode an opaque constant tensor
@@ -216,22 +217,38 @@ private:
   bool allowUnknownOps;
 };
 
-using DialectAllocatorFunction = std::function<void(MLIRContext *)>;
+using DialectAllocatorFunction = std::function<Dialect *(MLIRContext *)>;
 
-/// Registers a specific dialect creation function with the system, typically
-/// used through the DialectRegistration template.
-void registerDialectAllocator(const DialectAllocatorFunction &function);
+/// Registers a specific dialect creation function with the system under the
+/// namespace of the dialect, typically used through the DialectRegistration
+/// template. A context only constructs the dialect the first time its
+/// namespace is used in it, see MLIRContext::getRegisteredDialect. Dialects
+/// should be registered before the contexts that use them are created.
+void registerDialectAllocator(StringRef name,
+                              const DialectAllocatorFunction &function);
 
-/// Registers all dialects with the specified MLIRContext.
+/// Constructs all the registered dialects in the specified MLIRContext now,
+/// rather than on the first use of their namespace.
 void registerAllDialects(MLIRContext *context);
 
+namespace detail {
+/// Constructs the dialect registered under namespace 'name' in 'context' and
+/// sets the hooks registered for it. Returns null if no dialect is registered
+/// under 'name'. This is only meant to be called by the context, which makes
+/// sure that each dialect is constructed once.
+Dialect *constructRegisteredDialect(MLIRContext *context, StringRef name);
+} // namespace detail
+
 /// Utility to register a dialect. Client can register their dialect with the
-/// global registry by calling registerDialect<MyDialect>();
+/// global registry by calling registerDialect<MyDialect>(). The dialect class
+/// provides its namespace with a static getDialectNamespace() method.
 template <typename ConcreteDialect> void registerDialect() {
-  registerDialectAllocator([](MLIRContext *ctx) {
-    // Just allocate the dialect, the context takes ownership of it.
-    new ConcreteDialect(ctx);
-  });
+  registerDialectAllocator(ConcreteDialect::getDialectNamespace(),
+                           [](MLIRContext *ctx) -> Dialect * {
+                             // Just allocate the dialect, the context takes
+                             // ownership of it.
+                             return new ConcreteDialect(ctx);
+                           });
 }
 
 /// DialectRegistration provides a global initialiser that registers a Dialect
@@ -26,7 +26,7 @@
 #include "llvm/Support/raw_ostream.h"
 
 namespace mlir {
-using DialectHooksSetter = std::function<void(MLIRContext *)>;
+using DialectHooksSetter = std::function<void(Dialect *)>;
 
 /// Dialect hooks allow external components to register their functions to
 /// be called for specific tasks specialized per dialect, such as decoding
@@ -46,9 +46,11 @@ public:
   DialectExtractElementHook getExtractElementHook() { return nullptr; }
 };
 
-/// Registers a function that will set hooks in the registered dialects
-/// based on information coming from DialectHooksRegistration.
-void registerDialectHooksSetter(const DialectHooksSetter &function);
+/// Registers a function that will set hooks in the dialect with namespace
+/// 'dialectName' based on information coming from DialectHooksRegistration.
+/// The hooks are set whenever a context constructs the dialect.
+void registerDialectHooksSetter(StringRef dialectName,
+                                const DialectHooksSetter &function);
 
 /// DialectHooksRegistration provides a global initialiser that registers
 /// a dialect hooks setter routine.
@@ -58,13 +60,7 @@ void registerDialectHooksSetter(const DialectHooksSetter &function);
 ///   static DialectHooksRegistration<MyHooks, MyDialect> unused;
 template <typename ConcreteHooks> struct DialectHooksRegistration {
   DialectHooksRegistration(StringRef dialectName) {
-    registerDialectHooksSetter([dialectName](MLIRContext *ctx) {
-      Dialect *dialect = ctx->getRegisteredDialect(dialectName);
-      if (!dialect) {
-        llvm::errs() << "error: cannot register hooks for unknown dialect '"
-                     << dialectName << "'\n";
-        abort();
-      }
+    registerDialectHooksSetter(dialectName, [](Dialect *dialect) {
       // Set hooks.
       ConcreteHooks hooks;
       if (auto h = hooks.getConstantFoldHook())
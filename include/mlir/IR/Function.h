@@ -33,12 +33,24 @@
 
 namespace mlir {
 class BlockAndValueMapping;
+class DominanceInfo;
 class FunctionType;
 class MLIRContext;
 class Module;
 class ArgumentIterator;
 
 /// This is the base class for all of the MLIR function types.
+/// The invariants checked by the verifier.
+enum class VerificationLevel {
+  /// Only check the structure of the IR, i.e. everything but the dominance of
+  /// the operands over their uses. This is much cheaper than a full
+  /// verification, as it doesn't require computing dominance information.
+  Structural,
+
+  /// Check all of the invariants of the IR.
+  Full,
+};
+
 class Function : public llvm::ilist_node_with_parent<Function, Module> {
 public:
   Function(Location location, StringRef name, FunctionType type,
@@ -83,62 +95,82 @@ public:
   /// Unlink this function from its module and delete it.
   void erase();
 
-  /// Returns true if this function is external, i.e. it has no body.
-  bool isExternal() { return empty(); }
+  /// Delete the body of this function, which becomes external.  A body that
+  /// hasn't been materialized is dropped without being loaded.
+  void eraseBody();
+
+  /// Returns true if this function is external, i.e. it has no body.  This
+  /// does not materialize the body of the function.
+  bool isExternal() { return !materializable && body.empty(); }
+
+  //===--------------------------------------------------------------------===//
+  // Materialization
+  //===--------------------------------------------------------------------===//
+
+  /// Returns true if the body of this function has not been loaded yet.  Such
+  /// a body is materialized, through the materializer of the parent module,
+  /// the first time it is accessed.
+  bool isMaterializable() { return materializable; }
+
+  /// Mark the body of this function as being lazily loaded.  This requires
+  /// that the function is in a module with a materializer.
+  void setMaterializable(bool isMaterializable = true) {
+    materializable = isMaterializable;
+  }
+
+  /// Load the body of this function if it hasn't been materialized yet.  On
+  /// failure, this reports the error through the MLIRContext, leaves the body
+  /// empty, and returns failure.
+  LogicalResult materialize();
 
   //===--------------------------------------------------------------------===//
   // Body Handling
   //===--------------------------------------------------------------------===//
 
-  Region &getBody() { return body; }
+  Region &getBody() { return getMaterializedBody(); }
 
   /// This is the list of blocks in the function.
   using RegionType = llvm::iplist<Block>;
-  RegionType &getBlocks() { return body.getBlocks(); }
+  RegionType &getBlocks() { return getMaterializedBody().getBlocks(); }
 
   // Iteration over the block in the function.
   using iterator = RegionType::iterator;
   using reverse_iterator = RegionType::reverse_iterator;
 
-  iterator begin() { return body.begin(); }
-  iterator end() { return body.end(); }
-  reverse_iterator rbegin() { return body.rbegin(); }
-  reverse_iterator rend() { return body.rend(); }
+  iterator begin() { return getMaterializedBody().begin(); }
+  iterator end() { return getMaterializedBody().end(); }
+  reverse_iterator rbegin() { return getMaterializedBody().rbegin(); }
+  reverse_iterator rend() { return getMaterializedBody().rend(); }
 
-  bool empty() { return body.empty(); }
-  void push_back(Block *block) { body.push_back(block); }
-  void push_front(Block *block) { body.push_front(block); }
+  bool empty() { return getMaterializedBody().empty(); }
+  void push_back(Block *block) { getMaterializedBody().push_back(block); }
+  void push_front(Block *block) { getMaterializedBody().push_front(block); }
 
-  Block &back() { return body.back(); }
-  Block &front() { return body.front(); }
+  Block &back() { return getMaterializedBody().back(); }
+  Block &front() { return getMaterializedBody().front(); }
 
   //===--------------------------------------------------------------------===//
   // Operation Walkers
   //===--------------------------------------------------------------------===//
 
   /// Walk the operations in the function in preorder, calling the callback
-  /// for each operation.
-  void walk(const std::function<void(Operation *)> &callback);
-
-  /// Specialization of walk to only visit operations of 'OpTy'.
-  template <typename OpTy> void walk(std::function<void(OpTy)> callback) {
-    walk([&](Operation *opInst) {
-      if (auto op = opInst->dyn_cast<OpTy>())
-        callback(op);
-    });
+  /// for each operation. See Operation::walk for the callbacks accepted.
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walk(FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(walkOperations(visit, WalkOrder::PreOrder));
   }
 
   /// Walk the operations in the function in postorder, calling the callback
   /// for each operation.
-  void walkPostOrder(const std::function<void(Operation *)> &callback);
-
-  /// Specialization of walkPostOrder to only visit operations of 'OpTy'.
-  template <typename OpTy>
-  void walkPostOrder(std::function<void(OpTy)> callback) {
-    walkPostOrder([&](Operation *opInst) {
-      if (auto op = opInst->dyn_cast<OpTy>())
-        callback(op);
-    });
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walkPostOrder(FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(walkOperations(visit, WalkOrder::PostOrder));
   }
 
   //===--------------------------------------------------------------------===//
@@ -256,8 +288,11 @@ public:
 
   /// Perform (potentially expensive) checks of invariants, used to detect
   /// compiler bugs.  On error, this reports the error through the MLIRContext
-  /// and returns failure.
-  LogicalResult verify();
+  /// and returns failure.  If 'domInfo' is non-null, it is used to check
+  /// dominance instead of computing new dominance information, and must thus
+  /// be up to date with the body of this function.
+  LogicalResult verify(VerificationLevel level = VerificationLevel::Full,
+                       DominanceInfo *domInfo = nullptr);
 
   void print(raw_ostream &os);
   void dump();
@@ -297,6 +332,16 @@ public:
   void cloneInto(Function *dest, BlockAndValueMapping &mapper);
 
 private:
+  /// Implements the walkers of this function with the adapted callback.
+  WalkResult walkOperations(detail::WalkCallback callback, WalkOrder order);
+
+  /// Return the body of the function, materializing it if necessary.
+  Region &getMaterializedBody() {
+    if (materializable)
+      (void)materialize();
+    return body;
+  }
+
   /// The name of the function.
   Identifier name;
 
@@ -318,6 +363,10 @@ private:
   /// The body of the function.
   Region body;
 
+  /// This is true if the body of the function is yet to be loaded by the
+  /// materializer of the parent module.
+  bool materializable = false;
+
   void operator=(Function &) = delete;
   friend struct llvm::ilist_traits<Function>;
 };
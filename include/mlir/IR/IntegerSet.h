@@ -34,6 +34,7 @@
 
 #include "mlir/IR/AffineExpr.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
 
 namespace mlir {
 
@@ -101,6 +102,12 @@ public:
 
   friend ::llvm::hash_code hash_value(IntegerSet arg);
 
+  /// Return the storage of this instance as an opaque pointer, identifying it
+  /// within its context.
+  const void *getAsOpaquePointer() const {
+    return static_cast<const void *>(set);
+  }
+
 private:
   ImplType *set;
   /// Sets with constraints fewer than kUniquingThreshold are uniqued.
@@ -112,6 +119,15 @@ inline ::llvm::hash_code hash_value(IntegerSet arg) {
   return ::llvm::hash_value(arg.set);
 }
 
+/// Return the simplification of 'set' computed by 'simplifyFn'.  The
+/// simplifications are memoized in the context of 'set', so 'simplifyFn' is
+/// only called the first time 'set' is simplified, and may be called by several
+/// threads at once.  The sets are simplified by the affine analyses, see
+/// simplifyIntegerSet, which the IR does not depend on.
+IntegerSet
+getMemoizedSimplifiedSet(IntegerSet set,
+                         llvm::function_ref<IntegerSet()> simplifyFn);
+
 } // end namespace mlir
 namespace llvm {
 
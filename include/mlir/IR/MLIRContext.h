@@ -23,6 +23,10 @@
 #include <memory>
 #include <vector>
 
+namespace llvm {
+class ThreadPool;
+} // end namespace llvm
+
 namespace mlir {
 class AbstractOperation;
 class MLIRContextImpl;
@@ -42,16 +46,22 @@ public:
   explicit MLIRContext();
   ~MLIRContext();
 
-  /// Return information about all registered IR dialects.
+  /// Return information about all registered IR dialects. This constructs the
+  /// ones that were not used in this context yet.
   std::vector<Dialect *> getRegisteredDialects();
 
-  /// Get a registered IR dialect with the given namespace. If an exact match is
-  /// not found, then return nullptr.
+  /// Return the dialects constructed in this context so far. The registered
+  /// dialects are only constructed on the first use of their namespace.
+  std::vector<Dialect *> getLoadedDialects();
+
+  /// Get a registered IR dialect with the given namespace, constructing it if
+  /// it was not used in this context yet. If an exact match is not found, then
+  /// return nullptr.
   Dialect *getRegisteredDialect(StringRef name);
 
-  /// Return information about all registered operations.  This isn't very
-  /// efficient: typically you should ask the operations about their properties
-  /// directly.
+  /// Return information about all the operations registered by the dialects
+  /// constructed in this context.  This isn't very efficient: typically you
+  /// should ask the operations about their properties directly.
   std::vector<AbstractOperation *> getRegisteredOperations();
 
   /// This is the interpretation of a diagnostic that is emitted to the
@@ -89,6 +99,90 @@ public:
   /// the standard error stream otherwise and return true.
   bool emitError(Location location, const Twine &message);
 
+  /// Set the thread pool used by this context to run parallel work, e.g. the
+  /// parallel pass adaptor, parser and printer.  'poolSize' is the number of
+  /// threads of the pool.  The pool isn't owned by the context and must
+  /// outlive it, which allows for multiple contexts to share the same pool.
+  void setThreadPool(llvm::ThreadPool &pool, unsigned poolSize);
+
+  /// Return the thread pool used by this context to run parallel work.  If
+  /// none was set, a pool owned by this context is created on first use, with
+  /// as many threads as the maximum concurrency allows.
+  llvm::ThreadPool &getThreadPool();
+
+  /// Limit the number of threads, including the calling thread, that a single
+  /// parallel region uses.  Zero removes the limit, leaving the size of the
+  /// thread pool as the only bound.  This defaults to the value of the
+  /// -mlir-max-threads option.
+  void setMaxConcurrency(unsigned maxConcurrency);
+
+  /// Return the number of threads, including the calling thread, that a
+  /// single parallel region may use.  This is always at least one.
+  unsigned getMaxConcurrency();
+
+  /// Enable or disable the pooling of the memory of the operations created in
+  /// this context.  When enabled, the memory of a destroyed operation is kept
+  /// to be reused by the next operation of a similar size created on the same
+  /// thread, rather than returned to the system allocator, and is only
+  /// released with the context.  This is disabled by default.
+  void setOperationPoolingEnabled(bool enabled);
+
+  /// Return true if the memory of the operations created in this context is
+  /// pooled.
+  bool isOperationPoolingEnabled();
+
+  /// Enable or disable fast verification.  When enabled, the verifiers of the
+  /// operations defined in ODS skip the constraints marked as expensive, which
+  /// makes verifying after each pass cheaper at the cost of a weaker check.
+  /// This defaults to the value of the -mlir-fast-verify option.
+  void setFastVerifierEnabled(bool enabled);
+
+  /// Return true if the verifiers skip the expensive constraints.
+  bool isFastVerifierEnabled();
+
+  /// The number of instances uniqued in a context, and the memory allocated by
+  /// the context to hold them.
+  struct StorageStatistics {
+    size_t numTypes = 0;
+    size_t numAttributes = 0;
+    size_t numAffineMaps = 0;
+    size_t numAffineExprs = 0;
+    size_t numIntegerSets = 0;
+    size_t numLocations = 0;
+    size_t numIdentifiers = 0;
+
+    /// The number of bytes allocated for uniqued storage, identifiers and
+    /// filenames.
+    size_t allocatedBytes = 0;
+
+    /// The number of bytes allocated for the pooled memory of operations, see
+    /// 'setOperationPoolingEnabled'.
+    size_t pooledOperationBytes = 0;
+  };
+
+  /// Return the statistics of the storage uniqued in this context.  This takes
+  /// the lock of each uniquing table in turn, so it is meant to be called
+  /// between passes rather than while other threads create instances.
+  StorageStatistics getStorageStatistics();
+
+  /// Open a new scope for the storage uniqued in this context.  The types,
+  /// attributes, locations and affine constructs uniqued from now on, until
+  /// the matching call to 'popStorageScope', are allocated apart from the
+  /// instances uniqued before, so that they can be released together.  This
+  /// allows a long-running process to reuse a context, with its dialects
+  /// already constructed, for independent requests without its memory growing
+  /// with each request.  Scopes may be nested.  No other thread may use the
+  /// context while a scope is pushed or popped.
+  void pushStorageScope();
+
+  /// Release all the instances uniqued since the matching 'pushStorageScope'.
+  /// The instances uniqued before remain valid, while all the IR referring to
+  /// the released ones, e.g. the modules of the request, must have been
+  /// destroyed already, and no object outside of the context, e.g. a cache in
+  /// a dialect, may still hold them.  The identifiers and the filenames of
+  /// the locations are interned strings and are kept.
+  void popStorageScope();
+
   // This is effectively private given that only MLIRContext.cpp can see the
   // MLIRContextImpl type.
   MLIRContextImpl &getImpl() { return *impl.get(); }
@@ -99,6 +193,24 @@ private:
   MLIRContext(const MLIRContext &) = delete;
   void operator=(const MLIRContext &) = delete;
 };
+
+/// A scope for the storage uniqued in a context, typically spanning an
+/// independent request processed with a context reused across requests.  The
+/// instances uniqued in the context while the scope is alive are released with
+/// it, see MLIRContext::pushStorageScope.
+class StorageScope {
+public:
+  explicit StorageScope(MLIRContext *context) : context(context) {
+    context->pushStorageScope();
+  }
+  ~StorageScope() { context->popStorageScope(); }
+
+private:
+  MLIRContext *context;
+
+  StorageScope(const StorageScope &) = delete;
+  void operator=(const StorageScope &) = delete;
+};
 } // end namespace mlir
 
 #endif // MLIR_IR_MLIRCONTEXT_H
@@ -25,11 +25,25 @@
 #include "mlir/IR/Function.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/ilist.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/RWMutex.h"
+#include <memory>
 
 namespace mlir {
 
 class AffineMap;
 
+/// A function materializer is responsible for lazily loading the bodies of the
+/// functions within a module, e.g. out of a serialized buffer.
+class FunctionMaterializer {
+public:
+  virtual ~FunctionMaterializer();
+
+  /// Load the body of the given function.  On failure, this reports the error
+  /// through the MLIRContext and returns failure.
+  virtual LogicalResult materialize(Function *function) = 0;
+};
+
 class Module {
 public:
   explicit Module(MLIRContext *context);
@@ -52,21 +66,62 @@ public:
   // Interfaces for working with the symbol table.
 
   /// Look up a function with the specified name, returning null if no such
-  /// name exists.  Function names never include the @ on them.
+  /// name exists.  Function names never include the @ on them.  This is safe
+  /// to call concurrently with the functions being added to the module.
   Function *getNamedFunction(StringRef name);
 
   /// Look up a function with the specified name, returning null if no such
-  /// name exists.  Function names never include the @ on them.
+  /// name exists.  Function names never include the @ on them.  This is safe
+  /// to call concurrently with the functions being added to the module.
   Function *getNamedFunction(Identifier name);
 
+  // Interfaces for adding functions from multiple threads, e.g. from function
+  // passes run in parallel that outline or specialize functions.  Unlike the
+  // insertions into the function list, these are safe to call concurrently
+  // with each other and with the symbol table lookups.  No other thread may
+  // iterate over the function list or modify it directly meanwhile.
+
+  /// Append 'function' to the module and return it.  As with any insertion,
+  /// the function is renamed with a unique suffix if its name conflicts with
+  /// another function of the module.
+  Function *addFunction(Function *function);
+
+  /// Return the function named 'name' if there is one, otherwise append the
+  /// function returned by 'createFn', which must be named 'name', and return
+  /// it.  Concurrent calls for the same name all return the same function.
+  Function *getOrInsertFunction(StringRef name,
+                                llvm::function_ref<Function *()> createFn);
+
+  // Interfaces for lazily loaded function bodies.
+
+  /// Return the materializer used to load the bodies of materializable
+  /// functions, or null if there is none.
+  FunctionMaterializer *getMaterializer() { return materializer.get(); }
+
+  /// Set the materializer used to load the bodies of materializable functions.
+  void setMaterializer(std::unique_ptr<FunctionMaterializer> newMaterializer) {
+    materializer = std::move(newMaterializer);
+  }
+
+  /// Materialize the bodies of all of the functions within this module.
+  LogicalResult materializeAll();
+
   /// Perform (potentially expensive) checks of invariants, used to detect
   /// compiler bugs.  On error, this reports the error through the MLIRContext
-  /// and returns failure.
-  LogicalResult verify();
+  /// and returns failure.  The functions are verified in parallel when
+  /// multi-threading is enabled, but the diagnostics are the same as those of
+  /// a sequential verification: those of the functions up to the first one
+  /// that fails, in order.
+  LogicalResult verify(VerificationLevel level = VerificationLevel::Full);
 
   void print(raw_ostream &os);
   void dump();
 
+  /// Print this module to `os` like `print`, erasing the body of each function
+  /// once it is printed.  This bounds the memory held while printing a large
+  /// module, which is left with external functions only.
+  void printAndConsume(raw_ostream &os);
+
 private:
   friend struct llvm::ilist_traits<Function>;
 
@@ -80,9 +135,21 @@ private:
   /// This is a mapping from a name to the function with that name.
   llvm::DenseMap<Identifier, Function *> symbolTable;
 
+  /// Guards the symbol table, which is updated whenever a function is added
+  /// to or removed from the function list.
+  llvm::sys::SmartRWMutex<true> symbolTableMutex;
+
+  /// Serializes the insertions into the function list made by addFunction and
+  /// getOrInsertFunction.
+  llvm::sys::SmartMutex<true> functionListMutex;
+
   /// This is used when name conflicts are detected.
   unsigned uniquingCounter = 0;
 
+  /// The materializer for lazily loaded function bodies.  This is declared
+  /// before the function list, as it may hold data referenced by functions.
+  std::unique_ptr<FunctionMaterializer> materializer;
+
   /// This is the actual list of functions the module contains.
   FunctionListType functions;
 };
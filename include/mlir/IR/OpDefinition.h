@@ -158,6 +158,17 @@ inline bool operator!=(OpState lhs, OpState rhs) {
   return lhs.getOperation() != rhs.getOperation();
 }
 
+/// Returns true if `ConcreteType` declares its own constantFold or fold method,
+/// hiding the fallback implementation inherited from `Hook`: the type of a
+/// pointer to an inherited member is a pointer to a member of the base.
+template <typename ConcreteType, typename Hook>
+constexpr bool overridesFolders() {
+  return !std::is_same<decltype(&ConcreteType::constantFold),
+                       decltype(&Hook::constantFold)>::value ||
+         !std::is_same<decltype(&ConcreteType::fold),
+                       decltype(&Hook::fold)>::value;
+}
+
 /// This template defines the constantFoldHook and foldHook as used by
 /// AbstractOperation.
 ///
@@ -220,6 +231,15 @@ public:
   /// If not overridden, this fallback implementation always fails to fold.
   ///
   LogicalResult fold(SmallVectorImpl<Value *> &results) { return failure(); }
+
+  /// Returns the Foldable property if the concrete op overrides one of the
+  /// fallback implementations above.
+  static AbstractOperation::OperationProperties getFoldingProperties() {
+    return overridesFolders<ConcreteType, FoldingHook>()
+               ? static_cast<AbstractOperation::OperationProperties>(
+                     OperationProperty::Foldable)
+               : 0;
+  }
 };
 
 /// This template specialization defines the constantFoldHook and foldHook as
@@ -296,6 +316,15 @@ public:
   /// If not overridden, this fallback implementation always fails to fold.
   ///
   Value *fold() { return nullptr; }
+
+  /// Returns the Foldable property if the concrete op overrides one of the
+  /// fallback implementations above.
+  static AbstractOperation::OperationProperties getFoldingProperties() {
+    return overridesFolders<ConcreteType, FoldingHook>()
+               ? static_cast<AbstractOperation::OperationProperties>(
+                     OperationProperty::Foldable)
+               : 0;
+  }
 };
 
 //===----------------------------------------------------------------------===//
@@ -349,6 +378,8 @@ protected:
   static AbstractOperation::OperationProperties getTraitProperties() {
     return 0;
   }
+  static void
+  addTraitInterfaces(SmallVectorImpl<detail::InterfaceMap::Entry> &entries) {}
 };
 
 /// This class provides the API for ops that are known to have no
@@ -755,9 +786,17 @@ public:
   }
 
   // Returns the properties of an operation by combining the properties of the
-  // traits of the op.
+  // traits of the op, and whether it defines a folder.
   static AbstractOperation::OperationProperties getOperationProperties() {
-    return BaseProperties<Traits<ConcreteType>...>::getTraitProperties();
+    return BaseProperties<Traits<ConcreteType>...>::getTraitProperties() |
+           Op::getFoldingProperties();
+  }
+
+  // Returns the op interfaces implemented by the op, gathered from its traits.
+  static detail::InterfaceMap getInterfaceMap() {
+    SmallVector<detail::InterfaceMap::Entry, 2> interfaces;
+    BaseInterfaces<Traits<ConcreteType>...>::addTraitInterfaces(interfaces);
+    return detail::InterfaceMap(interfaces);
   }
 
   // TODO: Provide a dump() method.
@@ -805,6 +844,87 @@ private:
       return 0;
     }
   };
+
+  template <typename... Types> struct BaseInterfaces;
+
+  template <typename First, typename... Rest>
+  struct BaseInterfaces<First, Rest...> {
+    static void
+    addTraitInterfaces(SmallVectorImpl<detail::InterfaceMap::Entry> &entries) {
+      First::addTraitInterfaces(entries);
+      BaseInterfaces<Rest...>::addTraitInterfaces(entries);
+    }
+  };
+
+  template <typename...> struct BaseInterfaces {
+    static void
+    addTraitInterfaces(SmallVectorImpl<detail::InterfaceMap::Entry> &entries) {
+    }
+  };
+};
+
+//===----------------------------------------------------------------------===//
+// Operation Interface classes
+//===----------------------------------------------------------------------===//
+
+/// This is the base class of the op interfaces generated from the OpInterface
+/// definitions of ODS.  An op interface gives access to a set of methods on any
+/// op implementing them, without knowing the class of the op:
+///
+///   if (auto access = op->dyn_cast<MemRefAccessOpInterface>())
+///     ... access.getMemRef() ...
+///
+/// An op implements an interface by listing its `Trait` in its traits.  This
+/// registers in the AbstractOperation of the op the `Concept` of the
+/// interface for the op: a static table of pointers to functions calling the
+/// methods of the op, built by `Traits::Model<ConcreteOp>`.  The interface is
+/// looked up once when it is created from an operation, and its methods then
+/// call through the table, like virtual methods.
+template <typename ConcreteType, typename Traits>
+class OpInterface : public OpState {
+public:
+  using Concept = typename Traits::Concept;
+  template <typename ConcreteOp>
+  using Model = typename Traits::template Model<ConcreteOp>;
+
+  /// This is a public constructor.  Any interface can be initialized to null.
+  explicit OpInterface() : OpState(nullptr), impl(nullptr) {}
+
+  /// This constructor is used through the Operation::cast family of methods.
+  explicit OpInterface(Operation *op)
+      : OpState(op), impl(op ? getInterfaceFor(op) : nullptr) {
+    assert((!op || impl) && "op does not implement the interface");
+  }
+
+  /// Return true if the specified operation implements this interface.
+  static bool isClassFor(Operation *op) { return getInterfaceFor(op); }
+
+  /// Returns the unique identifier of this interface.
+  static TypeID *getInterfaceID() { return TypeID::getID<ConcreteType>(); }
+
+  /// The trait that the ops implementing this interface list in their traits.
+  template <typename ConcreteOp>
+  class Trait : public OpTrait::TraitBase<ConcreteOp, Trait> {
+  public:
+    static void
+    addTraitInterfaces(SmallVectorImpl<detail::InterfaceMap::Entry> &entries) {
+      entries.emplace_back(getInterfaceID(), Model<ConcreteOp>::getConcept());
+    }
+  };
+
+protected:
+  /// Returns the concept of the interface for the op.
+  Concept *getImpl() { return impl; }
+
+private:
+  static Concept *getInterfaceFor(Operation *op) {
+    if (auto *abstractOp = op->getAbstractOperation())
+      return abstractOp->getInterface<ConcreteType>();
+    return nullptr;
+  }
+
+  /// The concept of the interface for the op.
+  Concept *impl;
 };
 
 // These functions are out-of-line implementations of the methods in BinaryOp,
@@ -50,13 +50,15 @@ class Operation final
       private llvm::TrailingObjects<Operation, OpResult, BlockOperand, unsigned,
                                     Region, detail::OperandStorage> {
 public:
-  /// Create a new Operation with the specific fields.
+  /// Create a new Operation with the specific fields.  A resizable operand
+  /// list holds room for at least 'numReservedOperands' operands.
   static Operation *create(Location location, OperationName name,
                            ArrayRef<Value *> operands,
                            ArrayRef<Type> resultTypes,
                            ArrayRef<NamedAttribute> attributes,
                            ArrayRef<Block *> successors, unsigned numRegions,
-                           bool resizableOperandList, MLIRContext *context);
+                           bool resizableOperandList, MLIRContext *context,
+                           unsigned numReservedOperands = 0);
 
   /// Overload of create that takes an existing NamedAttributeList to avoid
   /// unnecessarily uniquing a list of attributes.
@@ -65,7 +67,8 @@ public:
                            ArrayRef<Type> resultTypes,
                            const NamedAttributeList &attributes,
                            ArrayRef<Block *> successors, unsigned numRegions,
-                           bool resizableOperandList, MLIRContext *context);
+                           bool resizableOperandList, MLIRContext *context,
+                           unsigned numReservedOperands = 0);
 
   /// Create a new Operation from the fields stored in `state`.
   static Operation *create(const OperationState &state);
@@ -133,6 +136,10 @@ public:
   /// Drop uses of all values defined by this operation or its nested regions.
   void dropAllDefinedValueUses();
 
+  /// Replace all uses of the results of this operation with the corresponding
+  /// values of 'values', which must hold one value per result.
+  void replaceAllUsesWith(ArrayRef<Value *> values);
+
   /// Unlink this operation from its current block and insert it right before
   /// `existingInst` which may be in the same or another block in the same
   /// function.
@@ -147,8 +154,23 @@ public:
   /// of the parent block.
   /// Note: This function has an average complexity of O(1), but worst case may
   /// take O(N) where N is the number of operations within the parent block.
+  /// The operations inserted in a block are numbered lazily between their
+  /// neighbours, which only renumbers the block when it is reordered.
   bool isBeforeInBlock(Operation *other);
 
+  /// Worklist-driven transformations may record the position of this operation
+  /// within their worklist on the operation itself, which provides O(1)
+  /// insertion, removal and membership checks without a side table.  An
+  /// operation can only be tracked by one worklist at a time, and the position
+  /// must be cleared when the operation leaves the worklist.
+  bool isInWorklist() { return worklistIndex != kNotInWorklist; }
+  unsigned getWorklistIndex() {
+    assert(isInWorklist() && "operation is not in a worklist");
+    return worklistIndex;
+  }
+  void setWorklistIndex(unsigned index) { worklistIndex = index; }
+  void clearWorklistIndex() { worklistIndex = kNotInWorklist; }
+
   void print(raw_ostream &os);
   void dump();
 
@@ -365,6 +387,10 @@ public:
     return getTerminatorStatus() == TerminatorStatus::NonTerminator;
   }
 
+  /// Returns whether this operation may be simplified by constantFold or fold:
+  /// whether its op defines a folder, or its dialect a constant fold hook.
+  bool isFoldable();
+
   /// Attempt to constant fold this operation with the specified constant
   /// operand values - the elements in "operands" will correspond directly to
   /// the operands of the operation, but may be null if non-constant.  If
@@ -404,29 +430,36 @@ public:
   // Operation Walkers
   //===--------------------------------------------------------------------===//
 
-  /// Walk the operations held by this operation in preorder, calling the
-  /// callback for each operation.
-  void walk(const std::function<void(Operation *)> &callback);
-
-  /// Specialization of walk to only visit operations of 'OpTy'.
-  template <typename OpTy> void walk(std::function<void(OpTy)> callback) {
-    walk([&](Operation *op) {
-      if (auto derivedOp = op->dyn_cast<OpTy>())
-        callback(derivedOp);
-    });
+  /// Walk this operation and the operations it holds in preorder, calling the
+  /// callback for each operation. The callback takes either an Operation * or
+  /// an op class such as AffineForOp, in which case only the operations of
+  /// that class are visited:
+  ///
+  /// ```c++
+  ///    op->walk([&](AffineForOp forOp) { ... });
+  /// ```
+  ///
+  /// The callback may return a WalkResult to stop the walk, or to not walk
+  /// into the operations nested in the one it visited; the walk then returns
+  /// the interrupted result if it was stopped. Callbacks returning void visit
+  /// every operation and the walk returns void.
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walk(FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(walkOperations(visit, WalkOrder::PreOrder));
   }
 
-  /// Walk the operations held by this function in postorder, calling the
-  /// callback for each operation.
-  void walkPostOrder(const std::function<void(Operation *)> &callback);
-
-  /// Specialization of walkPostOrder to only visit operations of 'OpTy'.
-  template <typename OpTy>
-  void walkPostOrder(std::function<void(OpTy)> callback) {
-    walkPostOrder([&](Operation *op) {
-      if (auto derivedOp = op->dyn_cast<OpTy>())
-        callback(derivedOp);
-    });
+  /// Walk the operations held by this operation and this operation itself in
+  /// postorder, calling the callback for each operation. The callback may
+  /// erase the operation it visits.
+  template <typename FnT, typename RetT = detail::walkResultType<FnT>>
+  RetT walkPostOrder(FnT &&callback) {
+    auto visit = [&](Operation *op) {
+      return detail::visitOperation(callback, op);
+    };
+    return static_cast<RetT>(walkOperations(visit, WalkOrder::PostOrder));
   }
 
   //===--------------------------------------------------------------------===//
@@ -468,6 +501,9 @@ private:
   // Provide a 'getParent' method for ilist_node_with_parent methods.
   Block *getParent() { return getBlock(); }
 
+  /// Implements the walkers of this operation with the adapted callback.
+  WalkResult walkOperations(detail::WalkCallback callback, WalkOrder order);
+
   /// The operation block that containts this operation.
   Block *block = nullptr;
 
@@ -475,12 +511,32 @@ private:
   /// or derived from.
   Location location;
 
+  /// Returns true if this operation has been given an order index since it was
+  /// inserted in its parent block.
+  bool hasValidOrder() { return orderIndex != kInvalidOrderIndex; }
+
+  /// Gives an order index to this operation if it has none, between those of
+  /// its neighbours. If they leave no room to it, the following operations are
+  /// renumbered until they do.
+  void updateOrderIfNecessary();
+
   /// Relative order of this operation in its parent block. Used for
-  /// O(1) local dominance checks between operations.
+  /// O(1) local dominance checks between operations. The indices are spaced
+  /// by 'kOrderStride' when the block is numbered, so that the operations
+  /// inserted later may be numbered between their neighbours.
+  enum : unsigned { kInvalidOrderIndex = ~0u, kOrderStride = 8 };
   mutable unsigned orderIndex = 0;
 
+  /// Position of this operation within the worklist tracking it, if any.
+  enum : unsigned { kNotInWorklist = ~0u };
+  unsigned worklistIndex = kNotInWorklist;
+
   const unsigned numResults, numSuccs, numRegions;
 
+  /// The size class of the pooled memory holding this operation, or zero if
+  /// it was allocated with malloc.
+  unsigned allocSizeClass = 0;
+
   /// This holds the name of the operation.
   OperationName name;
 
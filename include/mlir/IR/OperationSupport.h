@@ -32,6 +32,8 @@
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/Support/TrailingObjects.h"
+#include <algorithm>
+#include <functional>
 #include <memory>
 
 namespace mlir {
@@ -65,8 +67,44 @@ enum class OperationProperty {
   /// This bit is set for an operation if it is a terminator: that means
   /// an operation at the end of a block.
   Terminator = 0b100,
+
+  /// This bit is set for an operation if it defines a constant folder or a
+  /// folder: operations without it are never simplified by their fold hooks.
+  Foldable = 0b1000,
 };
 
+namespace detail {
+/// The op interfaces implemented by a registered operation, see OpInterface.
+/// This maps the identifier of each interface to its concept for the
+/// operation: the static table of the methods of the interface implemented by
+/// the op.  The entries are sorted by identifier, an op implements few
+/// interfaces so that looking one up is a short binary search.
+class InterfaceMap {
+public:
+  using Entry = std::pair<TypeID *, void *>;
+
+  explicit InterfaceMap(ArrayRef<Entry> entries)
+      : interfaces(entries.begin(), entries.end()) {
+    std::sort(interfaces.begin(), interfaces.end(), compare);
+  }
+
+  /// Returns the concept of the interface identified by `id`, or null if the
+  /// operation does not implement it.
+  void *lookup(TypeID *id) const {
+    auto it = std::lower_bound(interfaces.begin(), interfaces.end(),
+                               Entry(id, nullptr), compare);
+    return it != interfaces.end() && it->first == id ? it->second : nullptr;
+  }
+
+private:
+  static bool compare(const Entry &lhs, const Entry &rhs) {
+    return std::less<TypeID *>()(lhs.first, rhs.first);
+  }
+
+  SmallVector<Entry, 2> interfaces;
+};
+} // end namespace detail
+
 /// This is a "type erased" representation of a registered operation.  This
 /// should only be used by things like the AsmPrinter and other things that need
 /// to be parameterized by generic operation hooks.  Most user code should use
@@ -132,6 +170,13 @@ public:
     return opProperties & static_cast<OperationProperties>(property);
   }
 
+  /// Returns the concept of the op interface `T` for this operation, or null
+  /// if the operation does not implement the interface.
+  template <typename T> typename T::Concept *getInterface() const {
+    return reinterpret_cast<typename T::Concept *>(
+        interfaceMap.lookup(T::getInterfaceID()));
+  }
+
   /// Look up the specified operation in the specified MLIRContext and return a
   /// pointer to it if present.  Otherwise, return a null pointer.
   static const AbstractOperation *lookup(StringRef opName,
@@ -143,7 +188,8 @@ public:
     return AbstractOperation(
         T::getOperationName(), dialect, T::getOperationProperties(),
         T::isClassFor, T::parseAssembly, T::printAssembly, T::verifyInvariants,
-        T::constantFoldHook, T::foldHook, T::getCanonicalizationPatterns);
+        T::constantFoldHook, T::foldHook, T::getCanonicalizationPatterns,
+        T::getInterfaceMap());
   }
 
 private:
@@ -159,16 +205,20 @@ private:
       LogicalResult (&foldHook)(Operation *op,
                                 SmallVectorImpl<Value *> &results),
       void (&getCanonicalizationPatterns)(OwningRewritePatternList &results,
-                                          MLIRContext *context))
+                                          MLIRContext *context),
+      detail::InterfaceMap &&interfaceMap)
       : name(name), dialect(dialect), isClassFor(isClassFor),
         parseAssembly(parseAssembly), printAssembly(printAssembly),
         verifyInvariants(verifyInvariants), constantFoldHook(constantFoldHook),
         foldHook(foldHook),
         getCanonicalizationPatterns(getCanonicalizationPatterns),
-        opProperties(opProperties) {}
+        opProperties(opProperties), interfaceMap(std::move(interfaceMap)) {}
 
   /// The properties of the operation.
   const OperationProperties opProperties;
+
+  /// The op interfaces implemented by the operation.
+  detail::InterfaceMap interfaceMap;
 };
 
 class OperationName {
@@ -236,6 +286,9 @@ struct OperationState {
   SmallVector<std::unique_ptr<Region>, 1> regions;
   /// If the operation has a resizable operand list.
   bool resizableOperandList = false;
+  /// The number of operands a resizable operand list may hold without
+  /// allocating, if larger than the number of operands.
+  unsigned numReservedOperands = 0;
 
 public:
   OperationState(MLIRContext *context, Location location, StringRef name);
@@ -290,6 +343,14 @@ public:
   void setOperandListToResizable(bool isResizable = true) {
     resizableOperandList = isResizable;
   }
+
+  /// Reserves room for 'numOperands' operands in the storage of a resizable
+  /// operand list, so that operands may be added up to that number without
+  /// allocating separate storage.  This is meant for operations whose operand
+  /// list is known to grow, e.g. when their bounds are refined.
+  void reserveOperands(unsigned numOperands) {
+    numReservedOperands = numOperands;
+  }
 };
 
 namespace detail {
@@ -339,12 +400,15 @@ class OperandStorage final
     : private llvm::TrailingObjects<OperandStorage, ResizableStorage,
                                     OpOperand> {
 public:
-  OperandStorage(unsigned numOperands, bool resizable)
+  OperandStorage(unsigned numOperands, bool resizable,
+                 unsigned numReservedOperands = 0)
       : numOperands(numOperands), resizable(resizable) {
-    // Initialize the resizable storage.
+    // Initialize the resizable storage, whose inline capacity includes the
+    // reserved operands.
     if (resizable) {
       new (&getResizableStorage())
-          ResizableStorage(getTrailingObjects<OpOperand>(), numOperands);
+          ResizableStorage(getTrailingObjects<OpOperand>(),
+                           getInlineCapacity(numOperands, numReservedOperands));
     }
   }
 
@@ -373,16 +437,31 @@ public:
   /// Return the number of operands held in the storage.
   unsigned size() const { return numOperands; }
 
-  /// Returns the additional size necessary for allocating this object.
-  static size_t additionalAllocSize(unsigned numOperands, bool resizable) {
-    return additionalSizeToAlloc<ResizableStorage, OpOperand>(resizable ? 1 : 0,
-                                                              numOperands);
+  /// Returns the additional size necessary for allocating this object.  Only
+  /// resizable storage holds reserved operands.
+  static size_t additionalAllocSize(unsigned numOperands, bool resizable,
+                                    unsigned numReservedOperands = 0) {
+    if (!resizable)
+      return additionalSizeToAlloc<ResizableStorage, OpOperand>(0, numOperands);
+    return additionalSizeToAlloc<ResizableStorage, OpOperand>(
+        1, getInlineCapacity(numOperands, numReservedOperands));
   }
 
   /// Returns if this storage is resizable.
   bool isResizable() const { return resizable; }
 
+  /// Return the number of operands the storage may hold without allocating.
+  unsigned capacity() {
+    return resizable ? getResizableStorage().capacity : numOperands;
+  }
+
 private:
+  /// Return the number of operands held inline by a resizable storage.
+  static unsigned getInlineCapacity(unsigned numOperands,
+                                    unsigned numReservedOperands) {
+    return std::max(numOperands, numReservedOperands);
+  }
+
   /// Clear the storage and destroy the current operands held by the storage.
   void clear() { numOperands = 0; }
 
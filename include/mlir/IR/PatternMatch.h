@@ -19,6 +19,7 @@
 #define MLIR_PATTERNMATCHER_H
 
 #include "mlir/IR/Builders.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace mlir {
 
@@ -326,13 +327,14 @@ using OwningRewritePatternList = std::vector<std::unique_ptr<RewritePattern>>;
 ///
 class RewritePatternMatcher {
 public:
-  /// Create a RewritePatternMatcher with the specified set of patterns and
-  /// rewriter.
-  explicit RewritePatternMatcher(OwningRewritePatternList &&patterns,
-                                 PatternRewriter &rewriter);
+  /// Create a RewritePatternMatcher with the specified set of patterns.
+  explicit RewritePatternMatcher(OwningRewritePatternList &&patterns);
 
-  /// Try to match the given operation to a pattern and rewrite it.
-  void matchAndRewrite(Operation *op);
+  /// Try to match the given operation to a pattern and rewrite it with the
+  /// provided rewriter.  Returns true if a pattern was applied.  The matcher
+  /// itself is not modified, so this may be called concurrently on operations
+  /// in disjoint parts of the IR.
+  bool matchAndRewrite(Operation *op, PatternRewriter &rewriter) const;
 
 private:
   RewritePatternMatcher(const RewritePatternMatcher &) = delete;
@@ -342,14 +344,18 @@ private:
   /// matcher.
   OwningRewritePatternList patterns;
 
-  /// The rewriter used when applying matched patterns.
-  PatternRewriter &rewriter;
+  /// The patterns above bucketed by the name of their root operation. Each
+  /// bucket is sorted by benefit, and patterns that are impossible to match
+  /// are dropped.
+  llvm::DenseMap<OperationName, SmallVector<RewritePattern *, 2>>
+      patternsByRoot;
 };
 
 /// Rewrite the specified function by repeatedly applying the highest benefit
-/// patterns in a greedy work-list driven manner.
+/// patterns in a greedy work-list driven manner. Returns true if the rewrites
+/// converged, i.e. if no pattern applies to the rewritten function.
 ///
-void applyPatternsGreedily(Function &fn, OwningRewritePatternList &&patterns);
+bool applyPatternsGreedily(Function &fn, OwningRewritePatternList &&patterns);
 
 } // end namespace mlir
 
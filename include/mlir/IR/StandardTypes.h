@@ -20,6 +20,8 @@
 
 #include "mlir/IR/Types.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include <limits>
 
 namespace llvm {
 class fltSemantics;
@@ -412,8 +414,16 @@ public:
   /// static shape.
   bool hasStaticShape() const { return getNumDynamicDims() == 0; }
 
+  /// Returns the number of elements of a statically shaped memref.
+  int64_t getNumElements() const;
+
   static bool kindof(unsigned kind) { return kind == StandardTypes::MemRef; }
 
+  /// The value of a stride or offset of a strided layout that isn't known
+  /// statically.
+  static constexpr int64_t kDynamicStrideOrOffset =
+      std::numeric_limits<int64_t>::min();
+
 private:
   /// Get or create a new MemRefType defined by the arguments.  If the resulting
   /// type would be ill-formed, return nullptr.  If the location is provided,
@@ -423,6 +433,25 @@ private:
                             unsigned memorySpace, Optional<Location> location);
 };
 
+/// Computes the strides and the offset of the strided layout of `t`, in
+/// elements.  The strided layouts are:
+///   1. the empty or identity layout, whose strides are the row-major strides
+///      of the shape, and whose offset is zero;
+///   2. a single layout map with one result of the form
+///      `K + k0 * d0 + ... + kn * dn`, where the offset `K` and the strides
+///      `ki` are constants or symbols.
+/// A stride or offset that is a symbol, or that depends on a dynamic dimension
+/// of the shape, is kDynamicStrideOrOffset.  Returns failure if the layout of
+/// `t` is not strided.
+LogicalResult getStridesAndOffset(MemRefType t,
+                                  SmallVectorImpl<int64_t> &strides,
+                                  int64_t &offset);
+
+/// Returns the single-result layout map `offset + sum(strides[i] * di)`, where
+/// each dynamic stride or offset is a new symbol, the offset first.
+AffineMap makeStridedLinearLayoutMap(ArrayRef<int64_t> strides, int64_t offset,
+                                     MLIRContext *context);
+
 /// The 'complex' type represents a complex number with a parameterized element
 /// type, which is composed of a real and imaginary value of that element type.
 ///
@@ -0,0 +1,85 @@
+//===- StructuralHash.h - Stable IR fingerprints ----------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file defines utilities for computing structural fingerprints of IR.  A
+// fingerprint only depends on the structure of the IR: operation names,
+// attributes, types, the use-def structure of the values, and nested regions.
+// It doesn't depend on the addresses of the IR or on the locations attached to
+// it, so it is stable across processes and can be used as a cache key.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_IR_STRUCTURALHASH_H
+#define MLIR_IR_STRUCTURALHASH_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/Hashing.h"
+#include <cstdint>
+#include <string>
+
+namespace mlir {
+class Function;
+class Module;
+class Operation;
+class Region;
+
+/// A 128-bit structural fingerprint of a piece of IR.
+class Fingerprint {
+public:
+  Fingerprint() : low(0), high(0) {}
+  Fingerprint(uint64_t low, uint64_t high) : low(low), high(high) {}
+
+  uint64_t getLow() const { return low; }
+  uint64_t getHigh() const { return high; }
+
+  /// Returns the fingerprint as a string of 32 hexadecimal digits.
+  std::string str() const;
+
+  bool operator==(const Fingerprint &other) const {
+    return low == other.low && high == other.high;
+  }
+  bool operator!=(const Fingerprint &other) const { return !(*this == other); }
+
+private:
+  uint64_t low, high;
+};
+
+inline llvm::hash_code hash_value(const Fingerprint &fingerprint) {
+  return llvm::hash_combine(fingerprint.getLow(), fingerprint.getHigh());
+}
+
+/// Compute the fingerprint of the given operation, including its regions.
+/// Values defined above the operation are identified by their position in the
+/// operand lists.
+Fingerprint computeFingerprint(Operation *op);
+
+/// Compute the fingerprint of the given region. Values defined above the
+/// region are identified by the order in which they are first used.
+Fingerprint computeFingerprint(Region &region);
+
+/// Compute the fingerprint of the given function, including its name, type,
+/// attributes and body.
+Fingerprint computeFingerprint(Function *function);
+
+/// Compute the fingerprint of the given module. This combines the
+/// fingerprints of the functions of the module, in module order, which are
+/// computed in parallel if 'enableThreads' is true.
+Fingerprint computeFingerprint(Module *module, bool enableThreads = true);
+
+} // end namespace mlir
+
+#endif // MLIR_IR_STRUCTURALHASH_H
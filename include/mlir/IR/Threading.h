@@ -0,0 +1,60 @@
+//===- Threading.h - MLIR Threading Utilities -------------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file defines utilities for running parallel work on the thread pool of
+// an MLIRContext.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_IR_THREADING_H
+#define MLIR_IR_THREADING_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include <atomic>
+#include <iterator>
+
+namespace mlir {
+class MLIRContext;
+
+/// Invoke 'fn' concurrently on up to 'numWorkers' threads of the thread pool
+/// of the given context, passing each invocation a distinct worker index in
+/// [0, numWorkers). The number of workers is clamped to the maximum
+/// concurrency of the context. The calling thread always runs worker 0, and
+/// workers that haven't started by the time worker 0 returns are not run at
+/// all. This makes nested parallel regions safe on a shared pool, but it
+/// means that 'fn' must pull its work from a queue shared by all of the
+/// workers instead of relying on every worker index being run.
+void parallelForEachWorker(MLIRContext *context, unsigned numWorkers,
+                           function_ref<void(unsigned workerID)> fn);
+
+/// Invoke 'func' on each element of the range [begin, end), in parallel on
+/// the thread pool of the given context.
+template <typename IteratorT, typename FuncT>
+void parallelForEach(MLIRContext *context, IteratorT begin, IteratorT end,
+                     FuncT &&func) {
+  unsigned numElements = std::distance(begin, end);
+  std::atomic<unsigned> nextIndex(0);
+  parallelForEachWorker(context, numElements, [&](unsigned) {
+    for (unsigned index; (index = nextIndex++) < numElements;)
+      func(*std::next(begin, index));
+  });
+}
+
+} // end namespace mlir
+
+#endif // MLIR_IR_THREADING_H
@@ -110,9 +110,13 @@ using DefaultTypeStorage = TypeStorage;
 //===----------------------------------------------------------------------===//
 
 // This is a utility allocator used to allocate memory for instances of derived
-// Types.
+// Types. The memory is owned by the underlying bump pointer allocator, which is
+// provided by the context.
 class TypeStorageAllocator {
 public:
+  explicit TypeStorageAllocator(llvm::BumpPtrAllocator &allocator)
+      : allocator(allocator) {}
+
   /// Copy the specified array of elements into memory managed by our bump
   /// pointer allocator.  This assumes the elements are all PODs.
   template <typename T> ArrayRef<T> copyInto(ArrayRef<T> elements) {
@@ -140,7 +144,7 @@ public:
 
 private:
   /// The raw allocator for type storage objects.
-  llvm::BumpPtrAllocator allocator;
+  llvm::BumpPtrAllocator &allocator;
 };
 
 //===----------------------------------------------------------------------===//
@@ -166,18 +170,16 @@ public:
     unsigned hashValue = getHash<ImplType>(kind, derivedKey);
 
     // Generate an equality function for the derived storage.
-    std::function<bool(const TypeStorage *)> isEqual =
-        [&derivedKey](const TypeStorage *existing) {
-          return static_cast<const ImplType &>(*existing) == derivedKey;
-        };
+    auto isEqual = [&derivedKey](const TypeStorage *existing) {
+      return static_cast<const ImplType &>(*existing) == derivedKey;
+    };
 
     // Generate a constructor function for the derived storage.
-    std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn =
-        [&](TypeStorageAllocator &allocator) {
-          TypeStorage *storage = ImplType::construct(allocator, derivedKey);
-          storage->initializeTypeInfo(lookupDialectForType<T>(ctx), kind);
-          return storage;
-        };
+    auto constructorFn = [&](TypeStorageAllocator &allocator) {
+      TypeStorage *storage = ImplType::construct(allocator, derivedKey);
+      storage->initializeTypeInfo(lookupDialectForType<T>(ctx), kind);
+      return storage;
+    };
 
     // Get an instance for the derived storage.
     return T(getImpl(ctx, kind, hashValue, isEqual, constructorFn));
@@ -203,13 +205,15 @@ private:
   static TypeStorage *
   getImpl(MLIRContext *ctx, unsigned kind, unsigned hashValue,
           llvm::function_ref<bool(const TypeStorage *)> isEqual,
-          std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn);
+          llvm::function_ref<TypeStorage *(TypeStorageAllocator &)>
+              constructorFn);
 
   /// Implementation for getting/creating an instance of a derived type with
   /// default storage.
   static TypeStorage *
   getImpl(MLIRContext *ctx, unsigned kind,
-          std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn);
+          llvm::function_ref<TypeStorage *(TypeStorageAllocator &)>
+              constructorFn);
 
   /// Get the dialect that the type 'T' was registered with.
   template <typename T>
@@ -145,6 +145,9 @@ private:
   /// The operation owner of this operand.
   Operation *const owner;
 
+  // Allow the values to update their use-lists at once.
+  friend class IRObjectWithUseList;
+
   /// Operands are not copyable or assignable.
   IROperand(const IROperand &use) = delete;
   IROperand &operator=(const IROperand &use) = delete;
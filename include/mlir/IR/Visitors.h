@@ -0,0 +1,149 @@
+//===- Visitors.h - Utilities for walking operations ------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file defines the result of the callbacks of the operation walkers of
+// Operation, Block and Function, and the helpers that adapt the callbacks
+// given to the walkers to the single signature the traversal works with.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_IR_VISITORS_H
+#define MLIR_IR_VISITORS_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include <type_traits>
+
+namespace mlir {
+
+class Operation;
+
+/// The result of a callback of an operation walker. It tells the walker to
+/// continue the traversal, to skip the operations nested in the operation just
+/// visited, or to stop the traversal altogether.
+class WalkResult {
+  enum ResultEnum { Interrupt, Advance, Skip } result;
+
+public:
+  WalkResult(ResultEnum result) : result(result) {}
+
+  /// Stop the walk; the walker returns an interrupted result.
+  static WalkResult interrupt() { return {Interrupt}; }
+  /// Continue the walk.
+  static WalkResult advance() { return {Advance}; }
+  /// Continue the walk, but not into the operations nested in the operation
+  /// just visited. This is only meaningful for preorder walks: postorder walks
+  /// have already visited them and treat it as advance().
+  static WalkResult skip() { return {Skip}; }
+
+  bool wasInterrupted() const { return result == Interrupt; }
+  bool wasSkipped() const { return result == Skip; }
+};
+
+/// The order in which a walker visits an operation and its nested operations.
+enum class WalkOrder { PreOrder, PostOrder };
+
+namespace detail {
+/// Extracts the argument and result types of a callable taking one argument:
+/// a lambda, a function object or a function pointer.
+template <typename FnT>
+struct WalkCallbackTraits
+    : public WalkCallbackTraits<decltype(&FnT::operator())> {};
+template <typename ClassT, typename RetT, typename ArgT>
+struct WalkCallbackTraits<RetT (ClassT::*)(ArgT) const> {
+  using ArgType = typename std::decay<ArgT>::type;
+  using ResultType = RetT;
+};
+template <typename ClassT, typename RetT, typename ArgT>
+struct WalkCallbackTraits<RetT (ClassT::*)(ArgT)>
+    : public WalkCallbackTraits<RetT (ClassT::*)(ArgT) const> {};
+template <typename RetT, typename ArgT>
+struct WalkCallbackTraits<RetT (*)(ArgT)> {
+  using ArgType = typename std::decay<ArgT>::type;
+  using ResultType = RetT;
+};
+
+/// The type of the operations a callback of type 'FnT' visits.
+template <typename FnT>
+using walkArgType =
+    typename WalkCallbackTraits<typename std::decay<FnT>::type>::ArgType;
+/// The result type of a callback of type 'FnT'. It is also the result type of
+/// the walkers given such a callback: the walkers return void for callbacks
+/// that return void, and whether the walk was interrupted for callbacks that
+/// return a WalkResult.
+template <typename FnT>
+using walkResultType =
+    typename WalkCallbackTraits<typename std::decay<FnT>::type>::ResultType;
+
+/// The signature all the callbacks are adapted to. It is type-erased with a
+/// function_ref, which neither allocates nor copies the callback.
+using WalkCallback = llvm::function_ref<WalkResult(Operation *)>;
+
+/// Visits 'op' with a callback taking an Operation * and returning a
+/// WalkResult.
+template <typename FnT>
+typename std::enable_if<
+    std::is_same<walkArgType<FnT>, Operation *>::value &&
+        std::is_same<walkResultType<FnT>, WalkResult>::value,
+    WalkResult>::type
+visitOperation(FnT &callback, Operation *op) {
+  return callback(op);
+}
+
+/// Visits 'op' with a callback taking an Operation * and returning void.
+template <typename FnT>
+typename std::enable_if<
+    std::is_same<walkArgType<FnT>, Operation *>::value &&
+        std::is_void<walkResultType<FnT>>::value,
+    WalkResult>::type
+visitOperation(FnT &callback, Operation *op) {
+  callback(op);
+  return WalkResult::advance();
+}
+
+/// Visits 'op' with a callback taking a specific op class and returning a
+/// WalkResult. The operations of other classes are stepped over.
+template <typename FnT>
+typename std::enable_if<
+    !std::is_same<walkArgType<FnT>, Operation *>::value &&
+        std::is_same<walkResultType<FnT>, WalkResult>::value,
+    WalkResult>::type
+visitOperation(FnT &callback, Operation *op) {
+  using OpTy = walkArgType<FnT>;
+  if (!OpTy::isClassFor(op))
+    return WalkResult::advance();
+  return callback(OpTy(op));
+}
+
+/// Visits 'op' with a callback taking a specific op class and returning void.
+/// The operations of other classes are stepped over.
+template <typename FnT>
+typename std::enable_if<
+    !std::is_same<walkArgType<FnT>, Operation *>::value &&
+        std::is_void<walkResultType<FnT>>::value,
+    WalkResult>::type
+visitOperation(FnT &callback, Operation *op) {
+  using OpTy = walkArgType<FnT>;
+  if (OpTy::isClassFor(op))
+    callback(OpTy(op));
+  return WalkResult::advance();
+}
+} // end namespace detail
+
+} // end namespace mlir
+
+#endif // MLIR_IR_VISITORS_H
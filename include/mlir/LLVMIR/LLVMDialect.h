@@ -29,10 +29,12 @@
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/TypeSupport.h"
 #include "mlir/IR/Types.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/Mutex.h"
 
 namespace llvm {
 class Type;
@@ -69,8 +71,18 @@ public:
 class LLVMDialect : public Dialect {
 public:
   explicit LLVMDialect(MLIRContext *context);
+
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "llvm"; }
+
+  /// Get the LLVM context and module in which the types wrapped by the dialect
+  /// are created.  Neither is thread-safe: creating an LLVM type, or parsing
+  /// one in the module, requires holding the mutex returned by
+  /// getLLVMContextMutex() so that the dialect can be used by passes running
+  /// concurrently.  Wrapping or inspecting existing LLVM types does not.
   llvm::LLVMContext &getLLVMContext() { return llvmContext; }
   llvm::Module &getLLVMModule() { return module; }
+  llvm::sys::SmartMutex<true> &getLLVMContextMutex() { return mutex; }
 
   /// Parse a type registered to this dialect.
   Type parseType(StringRef tyData, Location loc) const override;
@@ -86,6 +98,14 @@ public:
 private:
   llvm::LLVMContext llvmContext;
   llvm::Module module;
+
+  /// Recursive mutex guarding the creation of types in the LLVM context, and
+  /// the cache of parsed types.
+  mutable llvm::sys::SmartMutex<true> mutex;
+
+  /// The LLVM types already parsed, keyed by their textual form, so that the
+  /// LLVM parser only runs once for the types repeated throughout the IR.
+  mutable llvm::StringMap<llvm::Type *> parsedTypes;
 };
 
 } // end namespace LLVM
@@ -0,0 +1,96 @@
+//===- LLVMLowering.h - Lowering to the LLVM IR dialect ---------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file declares the dialect converter from the Standard dialect to the
+// LLVM IR dialect, which other dialects extend with the conversions of their
+// own operations to lower them along with the Standard ones.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_LLVMIR_LLVMLOWERING_H_
+#define MLIR_LLVMIR_LLVMLOWERING_H_
+
+#include "mlir/Transforms/DialectConversion.h"
+#include "llvm/Support/Allocator.h"
+
+namespace llvm {
+class Module;
+} // namespace llvm
+
+namespace mlir {
+namespace LLVM {
+class LLVMDialect;
+} // namespace LLVM
+
+/// A dialect converter from the Standard dialect to the LLVM IR dialect.
+class LLVMLowering : public DialectConversion {
+public:
+  /// Convert types using the LLVM IR module of the dialect.
+  Type convertType(Type t) override;
+
+  /// Get the LLVM IR dialect, once the conversion started.
+  LLVM::LLVMDialect *getDialect() { return dialect; }
+
+  /// Get the function named `name` in `module`, declaring it with the given
+  /// type if it is not already present.  The patterns converting different
+  /// functions concurrently must declare functions with this method.
+  static Function *getOrInsertFunction(Module *module, StringRef name,
+                                       FunctionType type);
+
+protected:
+  /// Create a set of converters that live in the converter object by passing
+  /// them a reference to the LLVM IR dialect, along with the additional ones.
+  /// Store the module associated with the dialect for further type conversion.
+  llvm::DenseSet<DialectOpConversion *>
+  initConverters(MLIRContext *mlirContext) final;
+
+  /// Derived classes may reimplement this hook to add the conversions of the
+  /// operations of other dialects, typically allocated in `converterStorage`.
+  virtual llvm::DenseSet<DialectOpConversion *>
+  initAdditionalConverters(LLVM::LLVMDialect &llvmDialect) {
+    return {};
+  }
+
+  /// The patterns only create LLVM types while holding the mutex of the LLVM
+  /// context of the dialect, so the functions are converted concurrently.
+  /// Derived classes adding patterns that are not thread-safe must reimplement
+  /// this hook to return false.
+  bool isThreadSafe() override { return true; }
+
+  /// Convert function signatures using the LLVM IR module of the dialect.
+  FunctionType convertFunctionSignatureType(
+      FunctionType t, ArrayRef<NamedAttributeList> argAttrs,
+      SmallVectorImpl<NamedAttributeList> &convertedArgAttrs) override;
+
+  /// Storage for the conversion patterns.
+  llvm::BumpPtrAllocator converterStorage;
+
+private:
+  /// LLVM IR dialect and the module used to parse/create types.
+  LLVM::LLVMDialect *dialect = nullptr;
+  llvm::Module *module = nullptr;
+};
+
+/// Convert the functions in `m` to the LLVM IR dialect with `lowering`, which
+/// is the Standard to LLVM IR dialect converter or one extending it.  The
+/// functions declared by the patterns are sorted by name at the end of the
+/// module, so that the result doesn't depend on the order of the conversions.
+LogicalResult convertToLLVMDialect(Module *m, LLVMLowering &lowering);
+
+} // namespace mlir
+
+#endif // MLIR_LLVMIR_LLVMLOWERING_H_
@@ -22,12 +22,18 @@
 
 namespace mlir {
 class DialectConversion;
+class FunctionPassBase;
 class Module;
 class ModulePassBase;
 
 /// Creates a pass to convert Standard dialects into the LLVMIR dialect.
 ModulePassBase *createConvertToLLVMIRPass();
 
+/// Creates a pass rewriting the element pointers computed in the innermost
+/// loops of functions in the LLVM IR dialect into pointers carried by the loops
+/// and incremented in every iteration.
+FunctionPassBase *createLLVMLoopStrengthReducePass();
+
 /// Creates a dialect converter from the standard dialect to the LLVM IR
 /// dialect and transfers ownership to the caller.
 std::unique_ptr<DialectConversion> createStdToLLVMConverter();
@@ -29,8 +29,10 @@ class StringRef;
 } // end namespace llvm
 
 namespace mlir {
+class Attribute;
 class Module;
 class MLIRContext;
+class Type;
 
 /// This parses the file specified by the indicated SourceMgr and returns an
 /// MLIR module if it was valid.  If not, the error message is emitted through
@@ -47,6 +49,17 @@ Module *parseSourceFile(llvm::StringRef filename, MLIRContext *context);
 /// context, and a null pointer is returned.
 Module *parseSourceString(llvm::StringRef moduleStr, MLIRContext *context);
 
+/// This parses a single MLIR type from the given string.  The whole string must
+/// be consumed by the type.  If not, the error message is emitted through the
+/// error handler registered in the context, and a null type is returned.
+Type parseType(llvm::StringRef typeStr, MLIRContext *context);
+
+/// This parses a single MLIR attribute from the given string.  The whole string
+/// must be consumed by the attribute, which may not reference any functions.
+/// If not, the error message is emitted through the error handler registered
+/// in the context, and a null attribute is returned.
+Attribute parseAttribute(llvm::StringRef attrStr, MLIRContext *context);
+
 } // end namespace mlir
 
 #endif // MLIR_PARSER_H
@@ -22,6 +22,7 @@
 #include "mlir/Pass/PassInstrumentation.h"
 #include "mlir/Support/LLVM.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/TypeName.h"
 
@@ -151,6 +152,9 @@ public:
   /// Clear any held analyses.
   void clear() { analyses.clear(); }
 
+  /// Returns true if no analyses are held.
+  bool empty() const { return analyses.empty(); }
+
   /// Invalidate any cached analyses based upon the given set of preserved
   /// analyses.
   void invalidate(const detail::PreservedAnalyses &pa) {
@@ -169,6 +173,46 @@ private:
 
 } // namespace detail
 
+//===----------------------------------------------------------------------===//
+// Analysis Caching
+//===----------------------------------------------------------------------===//
+
+/// A cache of function analyses that persists across runs of a pass manager.
+/// The analyses of a function are reused by the next run if the fingerprint of
+/// the function didn't change in between. This requires that the analyses of
+/// a function only depend on the IR of that function.
+class AnalysisCache {
+public:
+  /// Compute the fingerprint of the given function. This hashes the
+  /// operations, blocks and values of the function along with their
+  /// addresses, so that analyses holding references to the IR are only reused
+  /// if all of the referenced entities are still the same. The blocks and
+  /// values are also hashed by their position in the function, so that the
+  /// fingerprint changes when an address is reused by another entity.
+  static llvm::hash_code computeFingerprint(Function *function);
+
+  /// Returns the number of functions with cached analyses.
+  size_t size() const { return entries.size(); }
+
+  /// Drop all of the cached analyses.
+  void clear() { entries.clear(); }
+
+private:
+  /// The analyses of a function when it was cached, and its fingerprint.
+  struct Entry {
+    Entry(llvm::hash_code fingerprint,
+          detail::AnalysisMap<Function> &&analyses)
+        : fingerprint(fingerprint), analyses(std::move(analyses)) {}
+
+    llvm::hash_code fingerprint;
+    detail::AnalysisMap<Function> analyses;
+  };
+  llvm::DenseMap<Function *, Entry> entries;
+
+  /// Allow access to the entries.
+  friend class ModuleAnalysisManager;
+};
+
 //===----------------------------------------------------------------------===//
 // Analysis Management
 //===----------------------------------------------------------------------===//
@@ -225,11 +269,61 @@ private:
   friend class ModuleAnalysisManager;
 };
 
+/// An analysis manager for a loop nest of a function, see LoopNestPass. The
+/// analyses of a loop nest are constructed from the function holding the nest
+/// while it is transformed. The runs of the passes on a loop nest aren't
+/// instrumented, so neither are the computations of its analyses.
+class LoopNestAnalysisManager {
+public:
+  LoopNestAnalysisManager(const FunctionAnalysisManager &parent,
+                          detail::AnalysisMap<Function> &impl)
+      : parent(&parent), impl(&impl) {}
+
+  // Query for a cached analysis on the parent function. The analysis may not
+  // exist and if it does it may be stale.
+  template <typename AnalysisT>
+  llvm::Optional<std::reference_wrapper<AnalysisT>>
+  getCachedFunctionAnalysis() const {
+    return parent->getCachedAnalysis<AnalysisT>();
+  }
+
+  // Query for the given analysis for the current loop nest.
+  template <typename AnalysisT> AnalysisT &getAnalysis() {
+    return impl->getAnalysis<AnalysisT>(/*pi=*/nullptr);
+  }
+
+  // Query for a cached entry of the given analysis on the current loop nest.
+  template <typename AnalysisT>
+  llvm::Optional<std::reference_wrapper<AnalysisT>> getCachedAnalysis() const {
+    return impl->getCachedAnalysis<AnalysisT>();
+  }
+
+  /// Invalidate any non preserved analyses,
+  void invalidate(const detail::PreservedAnalyses &pa) {
+    // If all analyses were preserved, then there is nothing to do here.
+    if (pa.isAll())
+      return;
+    impl->invalidate(pa);
+  }
+
+  /// Clear any held analyses.
+  void clear() { impl->clear(); }
+
+private:
+  /// A reference to the analysis manager of the parent function.
+  const FunctionAnalysisManager *parent;
+
+  /// A reference to the impl analysis map, owned by the loop nest pipeline.
+  detail::AnalysisMap<Function> *impl;
+};
+
 /// An analysis manager for a specific module instance.
 class ModuleAnalysisManager {
 public:
-  ModuleAnalysisManager(Module *module, PassInstrumentor *passInstrumentor)
-      : moduleAnalyses(module), passInstrumentor(passInstrumentor) {}
+  ModuleAnalysisManager(Module *module, PassInstrumentor *passInstrumentor,
+                        AnalysisCache *cache = nullptr)
+      : moduleAnalyses(module), passInstrumentor(passInstrumentor),
+        cache(cache) {}
   ModuleAnalysisManager(const ModuleAnalysisManager &) = delete;
   ModuleAnalysisManager &operator=(const ModuleAnalysisManager &) = delete;
 
@@ -268,10 +362,28 @@ public:
   /// Invalidate any non preserved analyses.
   void invalidate(const detail::PreservedAnalyses &pa);
 
+  /// Invalidate any non preserved analyses of the module, leaving the function
+  /// analyses untouched.
+  void invalidateModuleAnalyses(const detail::PreservedAnalyses &pa) {
+    if (!pa.isAll())
+      moduleAnalyses.invalidate(pa);
+  }
+
   /// Returns a pass instrumentation object for the current module. This value
   /// may be null.
   PassInstrumentor *getPassInstrumentor() const { return passInstrumentor; }
 
+  /// Returns true if the function analyses are kept in a cache across runs, in
+  /// which case they shouldn't be cleared after running a function pipeline.
+  bool isCachingFunctionAnalyses() const { return cache; }
+
+  /// Take the cached analyses of each function of the module whose fingerprint
+  /// didn't change since it was cached.
+  void restoreFromCache();
+
+  /// Replace the contents of the cache with the current function analyses.
+  void storeToCache();
+
 private:
   /// The cached analyses for functions within the current module.
   llvm::DenseMap<Function *, detail::AnalysisMap<Function>> functionAnalyses;
@@ -281,6 +393,9 @@ private:
 
   /// An optional instrumentation object.
   PassInstrumentor *passInstrumentor;
+
+  /// An optional cache used to retain function analyses across runs.
+  AnalysisCache *cache;
 };
 
 // Query for a cached analysis on the parent Module. The analysis may not exist
@@ -22,13 +22,30 @@
 #include "mlir/Pass/PassRegistry.h"
 #include "mlir/Support/LogicalResult.h"
 #include "llvm/ADT/PointerIntPair.h"
+#include <atomic>
+#include <chrono>
 
 namespace mlir {
+/// The compile-time budget of each run of a pass on an IR unit, e.g. of a
+/// function pass on each function, see 'Pass::consumeBudget'. A limit of zero
+/// means that the resource is unlimited.
+struct PassBudget {
+  /// The maximum number of work units consumed by a run, as counted by the
+  /// pass, e.g. one per candidate transformation evaluated.
+  uint64_t workUnits = 0;
+
+  /// The maximum wall time of a run, in milliseconds.
+  uint64_t milliseconds = 0;
+
+  /// Returns true if neither the work units nor the time are limited.
+  bool isUnlimited() const { return workUnits == 0 && milliseconds == 0; }
+};
+
 /// The abstract base pass class. This class contains information describing the
 /// derived pass object, e.g its kind and abstract PassInfo.
 class Pass {
 public:
-  enum class Kind { FunctionPass, ModulePass };
+  enum class Kind { FunctionPass, ModulePass, LoopNestPass };
 
   virtual ~Pass() = default;
 
@@ -50,20 +67,110 @@ public:
   /// Returns the derived pass name.
   virtual StringRef getName() = 0;
 
+  /// This class represents a single statistic of a pass, i.e. a thread-safe
+  /// counter of the work that it did. Statistics are declared as members of
+  /// the pass that they belong to, e.g.:
+  ///
+  ///   Statistic numFolded = {this, "num-folded", "Number of ops folded"};
+  ///
+  class Statistic {
+  public:
+    Statistic(Pass *owner, const char *name, const char *description)
+        : name(name), description(description), value(0) {
+      owner->statistics.push_back(this);
+    }
+
+    /// Copies of a statistic start from zero, see 'Pass::cloneStatistics'.
+    Statistic(const Statistic &other)
+        : name(other.name), description(other.description), value(0) {}
+
+    const char *getName() const { return name; }
+    const char *getDescription() const { return description; }
+    unsigned getValue() const { return value; }
+    operator unsigned() const { return value; }
+
+    Statistic &operator=(unsigned newValue) {
+      value = newValue;
+      return *this;
+    }
+    Statistic &operator+=(unsigned amount) {
+      value += amount;
+      return *this;
+    }
+    Statistic &operator++() {
+      ++value;
+      return *this;
+    }
+    unsigned operator++(int) { return value++; }
+
+  private:
+    const char *name;
+    const char *description;
+    std::atomic<unsigned> value;
+  };
+
+  /// Returns the statistics declared by this pass, in declaration order.
+  ArrayRef<Statistic *> getStatistics() const { return statistics; }
+
+  /// Add the values of the statistics of this pass to those of 'other', which
+  /// must be a clone of this pass, and reset the statistics of this pass.
+  void mergeStatisticsInto(Pass &other);
+
+  /// Set the budget of each run of this pass, see 'consumeBudget'. Copies of
+  /// the pass share the same budget.
+  void setBudget(const PassBudget &newBudget) { budget = newBudget; }
+  const PassBudget &getBudget() const { return budget; }
+
+  /// Consume 'workUnits' units of the budget of the current run of this pass.
+  /// Returns false once the budget of the run is exhausted, in work units or in
+  /// time: the pass should then stop searching for further transformations,
+  /// and leave the IR as transformed so far, which must be valid. Passes that
+  /// may take unbounded time on pathological inputs are expected to call this
+  /// before each unit of their search. The exhaustion of the budget is
+  /// reported to the instrumentations after the run, see
+  /// 'PassInstrumentation::runAfterPassBudgetExhausted'.
+  bool consumeBudget(uint64_t workUnits = 1);
+
+  /// Returns true if the current run of this pass exhausted its budget.
+  bool isBudgetExhausted() const { return budgetState.exhausted; }
+
 protected:
   Pass(const PassID *passID, Kind kind) : passIDAndKind(passID, kind) {}
 
+  /// Register the statistics of this pass, which was copy constructed from
+  /// 'original'. The statistics of the copy are the members at the same
+  /// positions as those of the original.
+  void cloneStatistics(const Pass &original);
+
+  /// Reset the budget state at the start of a run of this pass.
+  void startBudget();
+
 private:
   /// Out of line virtual method to ensure vtables and metadata are emitted to a
   /// single .o file.
   virtual void anchor();
 
   /// Represents a unique identifier for the pass and its kind.
-  llvm::PointerIntPair<const PassID *, 1, Kind> passIDAndKind;
+  llvm::PointerIntPair<const PassID *, 2, Kind> passIDAndKind;
+
+  /// The statistics declared by this pass.
+  std::vector<Statistic *> statistics;
+
+  /// The budget of each run of this pass.
+  PassBudget budget;
+
+  /// The state of the budget of the current run of this pass. Each copy of a
+  /// pass runs on a single thread at a time, so this isn't synchronized.
+  struct BudgetState {
+    uint64_t consumedWorkUnits = 0;
+    std::chrono::steady_clock::time_point deadline;
+    bool exhausted = false;
+  } budgetState;
 };
 
 namespace detail {
 class FunctionPassExecutor;
+class LoopNestPassExecutor;
 class ModulePassExecutor;
 
 /// The state for a single execution of a pass. This provides a unified
@@ -106,6 +213,15 @@ protected:
   /// A clone method to create a copy of this pass.
   virtual FunctionPassBase *clone() const = 0;
 
+  /// Returns true if running this pass again on the output of its last run
+  /// would leave the IR unchanged, e.g. because it reached a fixed point, and
+  /// if it has no effect other than on the IR. This is queried after each run
+  /// of the pass. The pass manager may then skip the next runs of this pass on
+  /// the function as long as it doesn't change, see
+  /// 'PassManager::enableSkippingUnchangedFunctions'. All of the instances of
+  /// such a pass are expected to behave the same.
+  virtual bool isIdempotent() const { return false; }
+
   /// Return the current function being transformed.
   Function &getFunction() {
     return *getPassState().irAndPassFailed.getPointer();
@@ -182,6 +298,60 @@ private:
   friend detail::ModulePassExecutor;
 };
 
+/// Pass to transform a loop nest, i.e. one of the top-level operations with
+/// regions and without results of a function, e.g. an 'affine.for' loop and the
+/// loops nested in it. Derived passes should not inherit from this class
+/// directly, and instead should use the CRTP LoopNestPass class.
+class LoopNestPassBase : public Pass {
+  using PassStateT =
+      detail::PassExecutionState<Function, LoopNestAnalysisManager>;
+
+public:
+  static bool classof(const Pass *pass) {
+    return pass->getKind() == Kind::LoopNestPass;
+  }
+
+protected:
+  explicit LoopNestPassBase(const PassID *id) : Pass(id, Kind::LoopNestPass) {}
+
+  /// The polymorphic API that runs the pass over the currently held loop nest.
+  virtual void runOnLoopNest() = 0;
+
+  /// A clone method to create a copy of this pass.
+  virtual LoopNestPassBase *clone() const = 0;
+
+  /// Return the function holding the current loop nest being transformed, see
+  /// LoopNestPass.
+  Function &getLoopNest() {
+    return *getPassState().irAndPassFailed.getPointer();
+  }
+
+  /// Return the MLIR context for the current loop nest being transformed.
+  MLIRContext &getContext() { return *getLoopNest().getContext(); }
+
+  /// Returns the current pass state.
+  PassStateT &getPassState() {
+    assert(passState && "pass state was never initialized");
+    return *passState;
+  }
+
+  /// Returns the current analysis manager.
+  LoopNestAnalysisManager &getAnalysisManager() {
+    return getPassState().analysisManager;
+  }
+
+private:
+  /// Forwarding function to execute this pass.
+  LLVM_NODISCARD
+  LogicalResult run(Function *nest, LoopNestAnalysisManager &nam);
+
+  /// The current execution state for the pass.
+  llvm::Optional<PassStateT> passState;
+
+  /// Allow access to 'run'.
+  friend detail::LoopNestPassExecutor;
+};
+
 //===----------------------------------------------------------------------===//
 // Pass Model Definitions
 //===----------------------------------------------------------------------===//
@@ -261,7 +431,48 @@ struct FunctionPass : public detail::PassModel<Function, T, FunctionPassBase> {
 
   /// A clone method to create a copy of this pass.
   FunctionPassBase *clone() const override {
-    return new T(*static_cast<const T *>(this));
+    auto *newPass = new T(*static_cast<const T *>(this));
+    newPass->cloneStatistics(*this);
+    return newPass;
+  }
+};
+
+/// A model for providing loop nest pass specific utilities.
+///
+/// The loop nests of a function are transformed concurrently when
+/// multi-threading is enabled, each by its own copy of the pass. For the
+/// duration of the loop nest pipeline, each nest is moved into a function of
+/// its own, outside of any module. The arguments of this function stand for the
+/// values used by the nest that are defined outside of it, and its entry block
+/// starts with copies of the constants that the nest uses. Once the pipeline
+/// ran, the operations of the function are moved back into place, except for
+/// the constants, which are moved to the entry block of the original function.
+///
+/// Loop nest passes may replace any operation of this function, e.g. to tile or
+/// unroll the outermost loop, as long as it keeps a single block, but must not:
+///   - read or modify any operation outside of this function, including the
+///     module and the original function, as other threads may be manipulating
+///     the other loop nests of the function.
+///   - rely on the identity of the values defined outside of the nest.
+///
+/// Derived loop nest passes are expected to provide the following:
+///   - A 'void runOnLoopNest()' method.
+template <typename T>
+struct LoopNestPass : public detail::PassModel<Function, T, LoopNestPassBase> {
+  /// Returns the analysis for the parent function if it exists. The analysis
+  /// describes the function as it was before the loop nest pipeline ran.
+  template <typename AnalysisT>
+  llvm::Optional<std::reference_wrapper<AnalysisT>>
+  getCachedFunctionAnalysis() {
+    return this->getAnalysisManager()
+        .template getCachedFunctionAnalysis<AnalysisT>();
+  }
+
+  /// A clone method to create a copy of this pass.
+  LoopNestPassBase *clone() const override {
+    auto *newPass = new T(*static_cast<const T *>(this));
+    newPass->cloneStatistics(*this);
+    return newPass;
   }
 };
 
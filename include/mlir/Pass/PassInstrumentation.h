@@ -53,6 +53,12 @@ public:
   /// that the ir unit may be in an invalid state.
   virtual void runAfterPassFailed(Pass *pass, const llvm::Any &ir) {}
 
+  /// A callback to run after a pass exhausted its budget on an IR unit, see
+  /// 'Pass::consumeBudget', before 'runAfterPass' or 'runAfterPassFailed'.
+  /// This function takes a pointer to the pass that was executed, as well as
+  /// an llvm::Any holding a pointer to the IR unit that was transformed.
+  virtual void runAfterPassBudgetExhausted(Pass *pass, const llvm::Any &ir) {}
+
   /// A callback to run before an analysis is computed. This function takes the
   /// name of the analysis to be computed, its AnalysisID, as well as an
   /// llvm::Any holding a pointer to the IR unit being analyzed on.
@@ -90,6 +96,12 @@ public:
     runAfterPassFailed(pass, llvm::Any(ir));
   }
 
+  /// See PassInstrumentation::runAfterPassBudgetExhausted for details.
+  template <typename IRUnitT>
+  void runAfterPassBudgetExhausted(Pass *pass, IRUnitT *ir) {
+    runAfterPassBudgetExhausted(pass, llvm::Any(ir));
+  }
+
   /// See PassInstrumentation::runBeforeAnalysis for details.
   template <typename IRUnitT>
   void runBeforeAnalysis(llvm::StringRef name, AnalysisID *id, IRUnitT *ir) {
@@ -116,6 +128,9 @@ private:
   /// See PassInstrumentation::runAfterPassFailed for details.
   void runAfterPassFailed(Pass *pass, const llvm::Any &ir);
 
+  /// See PassInstrumentation::runAfterPassBudgetExhausted for details.
+  void runAfterPassBudgetExhausted(Pass *pass, const llvm::Any &ir);
+
   /// See PassInstrumentation::runBeforeAnalysis for details.
   void runBeforeAnalysis(llvm::StringRef name, AnalysisID *id,
                          const llvm::Any &ir);
@@ -19,6 +19,7 @@
 #define MLIR_PASS_PASSMANAGER_H
 
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace llvm {
@@ -26,29 +27,40 @@ class Any;
 } // end namespace llvm
 
 namespace mlir {
+class AnalysisCache;
 class FunctionPassBase;
+class LoopNestPassBase;
 class Module;
 class ModulePassBase;
 class Pass;
+struct PassBudget;
 class PassInstrumentation;
 class PassInstrumentor;
+enum class VerificationLevel;
 
 namespace detail {
 class PassExecutor;
 class ModulePassExecutor;
 } // end namespace detail
 
-/// An enum describing the different display modes for the pass timing
-/// information within the pass manager.
-enum class PassTimingDisplayMode {
-  // In this mode the results are displayed in a list sorted by total time,
-  // with each pass/analysis instance aggregated into one unique result.
+/// An enum describing the different display modes for the information within
+/// the pass manager, e.g. pass timing and statistics.
+enum class PassDisplayMode {
+  // In this mode the results are displayed in a list sorted by total time or
+  // by name, with each pass/analysis instance aggregated into one unique
+  // result.
   List,
 
   // In this mode the results are displayed in a nested pipeline view that
   // mirrors the internal pass pipeline that is being executed in the pass
   // manager.
   Pipeline,
+
+  // In this mode the pass timing results are written as Chrome trace events,
+  // with one event per pass or analysis run on each function and thread.  This
+  // mode is only supported by pass timing, statistics are displayed as in the
+  // pipeline mode.
+  Trace,
 };
 
 /// The main pass manager and pipeline builder.
@@ -58,10 +70,39 @@ public:
   PassManager(bool verifyPasses = true);
   ~PassManager();
 
+  /// Set the invariants checked by the verifier runs added after each pass.
+  /// If this is less than a full verification, the module is fully verified
+  /// once after all of the passes have run successfully.  This only affects
+  /// the passes added after it is set.
+  void setVerificationLevel(VerificationLevel level);
+
   /// Run the passes within this manager on the provided module.
   LLVM_NODISCARD
   LogicalResult run(Module *module);
 
+  /// Keep the function analyses that are still valid at the end of 'run' in a
+  /// cache, and reuse them in the next call to 'run' for the functions that
+  /// weren't modified in between. This is intended for clients that
+  /// repeatedly run the same pipeline over a module that they incrementally
+  /// update.
+  void enableAnalysisCache();
+
+  /// Drop the analyses held by the analysis cache, if enabled.
+  void clearAnalysisCache();
+
+  /// Skip the runs of idempotent function passes, including the verifier, on
+  /// the functions that didn't change since the last run of the same pass on
+  /// them within the function pipeline. A change is detected through the
+  /// fingerprint of the function, unless the pass preserved all analyses.
+  void enableSkippingUnchangedFunctions();
+
+  /// Set the budget of each run of the passes within this manager on an IR
+  /// unit, including the passes added afterwards, see 'Pass::consumeBudget'.
+  /// The passes that consult their budget stop searching for transformations
+  /// once it is exhausted, which bounds the compile time on pathological
+  /// inputs.
+  void setPassBudget(const PassBudget &budget);
+
   //===--------------------------------------------------------------------===//
   // Pipeline Building
   //===--------------------------------------------------------------------===//
@@ -79,6 +120,23 @@ public:
   /// executor if necessary.
   void addPass(FunctionPassBase *pass);
 
+  /// Add a loop nest pass to the current manager. This takes ownership over the
+  /// provided pass pointer. Consecutive loop nest passes form a pipeline that
+  /// is run on each of the top-level operations holding regions of a function,
+  /// e.g. its outermost 'affine.for' loops, in parallel if multi-threading is
+  /// enabled, see LoopNestPass.
+  void addPass(LoopNestPassBase *pass);
+
+  /// Add a function pipeline made of the provided function passes that is
+  /// rerun on each function until the function stops changing, or for at most
+  /// 'maxIterations' iterations. Within the pipeline, the runs of idempotent
+  /// passes on a function that didn't change since they last ran are skipped,
+  /// see 'enableSkippingUnchangedFunctions', so the iteration detecting the
+  /// convergence is cheap. This takes ownership over the provided pass
+  /// pointers.
+  void addFixedPointPipeline(ArrayRef<FunctionPassBase *> passes,
+                             unsigned maxIterations = 10);
+
   //===--------------------------------------------------------------------===//
   // Instrumentations
   //===--------------------------------------------------------------------===//
@@ -99,14 +157,34 @@ public:
                         bool printModuleScope, raw_ostream &out);
 
   /// Add an instrumentation to time the execution of passes and the computation
-  /// of analyses.
+  /// of analyses. If 'numTopFunctionRuns' is not zero, the longest runs of a
+  /// function pass on a single function are reported as well, along with the
+  /// number of operations in the function before the pass ran.
   /// Note: Timing should be enabled after all other instrumentations to avoid
   /// any potential "ghost" timing from other instrumentations being
   /// unintentionally included in the timing results.
-  void enableTiming(
-      PassTimingDisplayMode displayMode = PassTimingDisplayMode::Pipeline);
+  void enableTiming(PassDisplayMode displayMode = PassDisplayMode::Pipeline,
+                    unsigned numTopFunctionRuns = 0);
+
+  /// Prompts the pass manager to print the statistics collected for each of
+  /// the held passes after each call to 'run'.
+  void
+  enableStatistics(PassDisplayMode displayMode = PassDisplayMode::Pipeline);
+
+  /// Add an instrumentation to report the number of operations and blocks
+  /// before and after each pass, along with the change in the number of types,
+  /// attributes and affine maps uniqued in the context, and in the memory
+  /// allocated for them, across each module pass.
+  void enableIRSizeReport();
+
+  /// Add an instrumentation to report the runs of the passes that exhausted
+  /// their budget, see 'setPassBudget', along with the IR units they ran on.
+  void enableBudgetReport();
 
 private:
+  /// Dump the statistics of the passes within this pass manager.
+  void printStatistics();
+
   /// A stack of nested pass executors on sub-module IR units, e.g. function.
   llvm::SmallVector<detail::PassExecutor *, 1> nestedExecutorStack;
 
@@ -116,9 +194,31 @@ private:
   /// Flag that specifies if the IR should be verified after each pass has run.
   bool verifyPasses : 1;
 
+  /// The invariants checked by the verifier runs after each pass.
+  VerificationLevel verificationLevel;
+
   /// Flag that specifies if pass timing is enabled.
   bool passTiming : 1;
 
+  /// Flag that specifies if the IR size report is enabled.
+  bool irSizeReport : 1;
+
+  /// Flag that specifies if the pass budget report is enabled.
+  bool budgetReport : 1;
+
+  /// Flag that specifies if the runs of idempotent function passes on
+  /// unchanged functions are skipped.
+  bool skipUnchangedFunctions : 1;
+
+  /// The display mode to use when printing pass statistics, if enabled.
+  llvm::Optional<PassDisplayMode> passStatisticsMode;
+
+  /// The budget of the passes, if set.
+  std::unique_ptr<PassBudget> passBudget;
+
+  /// The cache of function analyses retained across runs, if enabled.
+  std::unique_ptr<AnalysisCache> analysisCache;
+
   /// A manager for pass instrumentations.
   std::unique_ptr<PassInstrumentor> instrumentor;
 };
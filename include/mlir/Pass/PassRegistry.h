@@ -112,6 +112,10 @@ void registerPassPipeline(StringRef arg, StringRef description,
 void registerPass(StringRef arg, StringRef description, const PassID *passID,
                   const PassAllocatorFunction &function);
 
+/// Returns the registered pass or pass pipeline whose argument is `arg`, e.g.
+/// "cse", or null if there is none.
+const PassRegistryEntry *lookupPassRegistryEntry(StringRef arg);
+
 /// PassRegistration provides a global initializer that registers a Pass
 /// allocation routine for a concrete pass instance.
 ///
@@ -61,6 +61,16 @@ UniformQuantizedType fakeQuantAttrsToType(Location loc, unsigned numBits,
                                           double rmin, double rmax,
                                           bool narrowRange, Type expressedType);
 
+/// Converts per-axis FakeQuant attributes to the corresponding type, with one
+/// scale and zero point per slice along quantizedDimension derived from the
+/// corresponding rmins and rmaxs as by the per-layer variant.
+/// In the event that the parameters cannot be converted, returns a nullptr
+/// convertible Type and issues an appropriate error.
+UniformQuantizedPerAxisType
+fakeQuantAttrsToType(Location loc, unsigned numBits, int32_t quantizedDimension,
+                     ArrayRef<double> rmins, ArrayRef<double> rmaxs,
+                     bool narrowRange, Type expressedType);
+
 } // namespace quant
 } // namespace mlir
 
@@ -41,6 +41,13 @@ FunctionPassBase *createConvertSimulatedQuantPass();
 /// destructive and cannot be undone.
 FunctionPassBase *createConvertConstPass();
 
+/// Creates a pass that folds the redundant dequantization/quantization barrier
+/// pairs left between ops sharing quantized types, typically after
+/// converting simulated quantization. Requantizations to the same type are
+/// removed, and chains of requantizations whose intermediate steps are
+/// lossless are folded into a single requantization.
+FunctionPassBase *createFoldBarriersPass();
+
 } // namespace quant
 } // namespace mlir
 
@@ -80,7 +80,8 @@ public:
 
   /// Support method to enable LLVM-style type casting.
   static bool kindof(unsigned kind) {
-    return kind == QuantizationTypes::UniformQuantized;
+    return kind >= QuantizationTypes::UniformQuantized &&
+           kind <= QuantizationTypes::LAST_USED_QUANTIZATION_TYPE;
   }
 
   /// Gets the minimum possible stored by a storageType. storageTypeMin must
@@ -275,13 +276,13 @@ public:
 /// Syntax synopsis:
 ///   Per-axis, all parameters expressed:
 ///     !quant<uniform[StorageType:ExpressedType:QuantizedDim]{QuantParams}>
-///   Per-axis, optional parameters omitted:
-///     !quant<uniform[StorageType]{Scale}>
+///   Per-axis, zero points omitted:
+///     !quant<uniform[StorageType:ExpressedType:QuantizedDim]{Scale,Scale}>
 ///
 ///   StorageType: 'i'|'u' NumBits
 ///   ExpressedType: 'f16', 'f32', 'bf16', 'f64'
-///   QuantizedDim: An integer value
-///   QuantParams: (Scale ':' ZeroPoint)+
+///   QuantizedDim: A non-negative integer value
+///   QuantParams: (Scale ':' ZeroPoint) (',' Scale ':' ZeroPoint)*
 ///   Scale: A legal double value
 ///   ZeroPoint: An integer value
 class UniformQuantizedPerAxisType
@@ -339,6 +340,15 @@ public:
   ///   t[:, 2, :, :] will have scale[2]=3.0, zero_point[0]=3
   int32_t getQuantizedDimension() const;
 
+  /// Returns whether this type is compatible with the shape of
+  /// 'candidateType', i.e. if it isn't a ranked vector or tensor, or if its
+  /// quantized dimension is in range and has one slice per scale.
+  bool isCompatibleShape(Type candidateType) const;
+
+  /// Returns the per-layer quantized type equivalent to this type if all of
+  /// its scales and zero points are equal, and nullptr otherwise.
+  UniformQuantizedType getUniformQuantizedType() const;
+
   /// Fixed point values are real numbers divided by a scale.
   /// Currently, only signed storage types are treated as fixed point.
   /// A fixed point value can be obtained from an affine value by subtracting
@@ -348,7 +358,7 @@ public:
     if (!isSigned())
       return false;
     return llvm::all_of(getZeroPoints(),
-                        [](int64_t zeroPoint) { return zeroPoint != 0; });
+                        [](int64_t zeroPoint) { return zeroPoint == 0; });
   }
 };
 
@@ -357,6 +367,9 @@ class QuantizationDialect : public Dialect {
 public:
   QuantizationDialect(MLIRContext *context);
 
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "quant"; }
+
   /// Parse a type registered to this dialect.
   Type parseType(StringRef spec, Location loc) const override;
 
@@ -24,6 +24,10 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/APSInt.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace mlir {
 namespace quant {
@@ -45,7 +49,7 @@ struct ExpressedToUniformQuantizedConverter {
 
   /// Converts the inputType to be based on the given elemental type,
   /// returning the new type (or nullptr and emit an error on failure).
-  Type convert(UniformQuantizedType elementalType) const;
+  Type convert(QuantizedType elementalType) const;
 
   /// Whether the conversion is legal.
   explicit operator bool() const { return (bool)expressedType; }
@@ -79,6 +83,13 @@ public:
     assert(uniformType.getStorageType().isa<IntegerType>());
   }
 
+  UniformQuantizedValueConverter(double scale, double zeroPoint,
+                                 double clampMin, double clampMax,
+                                 uint32_t storageBitWidth, bool isSigned)
+      : scale(scale), zeroPoint(zeroPoint), clampMin(clampMin),
+        clampMax(clampMax), storageBitWidth(storageBitWidth),
+        isSigned(isSigned) {}
+
   virtual APInt quantizeFloatToInt(APFloat expressedValue) const {
     bool lossy;
     expressedValue.convert(scale.getSemantics(), APFloat::rmNearestTiesToEven,
@@ -102,6 +113,34 @@ public:
     return isSigned ? qValue.getSExtValue() : qValue.getZExtValue();
   }
 
+  /// Quantizes the 'numValues' values of the C++ floating point type 'RealT'
+  /// read from 'expressedValues' to values of the C++ integer type 'StorageT',
+  /// which must match the storage type, written to 'quantValues'. This computes
+  /// the same values as the default 'quantizeFloatToInt' with native double
+  /// precision arithmetic, in a loop free of calls that the compiler can
+  /// vectorize, and doesn't account for subclasses overriding it.
+  template <typename RealT, typename StorageT>
+  void quantizeFloatsToInts(const char *expressedValues, StorageT *quantValues,
+                            size_t numValues) const {
+    double scaleValue = scale.convertToDouble();
+    double zeroPointValue = zeroPoint.convertToDouble();
+    double clampMinValue = clampMin.convertToDouble();
+    double clampMaxValue = clampMax.convertToDouble();
+    for (size_t i = 0; i != numValues; ++i) {
+      RealT expressedValue;
+      std::memcpy(&expressedValue, expressedValues + i * sizeof(RealT),
+                  sizeof(RealT));
+      // std::nearbyint rounds half to even in the default rounding mode.
+      double scaled =
+          std::nearbyint(double(expressedValue) / scaleValue) + zeroPointValue;
+      double fixedpoint =
+          std::max(std::min(scaled, clampMaxValue), clampMinValue);
+      // NaNs are converted to zero, as by APFloat::convertToInteger.
+      quantValues[i] =
+          scaled == scaled ? static_cast<StorageT>(fixedpoint) : StorageT(0);
+    }
+  }
+
   virtual ~UniformQuantizedValueConverter() {}
 
 private:
@@ -113,6 +152,45 @@ private:
   const bool isSigned;
 };
 
+/// Converts real numbers to the values represented by a
+/// UniformQuantizedPerAxisType, with a UniformQuantizedValueConverter for each
+/// slice along the quantized dimension.
+class UniformQuantizedPerAxisValueConverter {
+public:
+  UniformQuantizedPerAxisValueConverter(
+      UniformQuantizedPerAxisType uniformType)
+      : quantizedDimension(uniformType.getQuantizedDimension()) {
+    assert(uniformType.getExpressedType().isa<FloatType>());
+    assert(uniformType.getStorageType().isa<IntegerType>());
+    ArrayRef<double> scales = uniformType.getScales();
+    ArrayRef<int64_t> zeroPoints = uniformType.getZeroPoints();
+    sliceConverters.reserve(scales.size());
+    for (unsigned i = 0, e = scales.size(); i < e; ++i) {
+      sliceConverters.emplace_back(
+          scales[i], static_cast<double>(zeroPoints[i]),
+          static_cast<double>(uniformType.getStorageTypeMin()),
+          static_cast<double>(uniformType.getStorageTypeMax()),
+          uniformType.getStorageTypeIntegralWidth(), uniformType.isSigned());
+    }
+  }
+
+  /// Gets the converter of the slice 'index' along the quantized dimension.
+  const UniformQuantizedValueConverter &
+  getSliceConverter(unsigned index) const {
+    return sliceConverters[index];
+  }
+
+  /// Gets the number of slices along the quantized dimension.
+  unsigned getNumSlices() const { return sliceConverters.size(); }
+
+  /// Gets the dimension that the slices are along.
+  int32_t getQuantizedDimension() const { return quantizedDimension; }
+
+private:
+  std::vector<UniformQuantizedValueConverter> sliceConverters;
+  const int32_t quantizedDimension;
+};
+
 } // namespace quant
 } // namespace mlir
 
@@ -23,6 +23,8 @@
 #ifndef MLIR_STANDARDOPS_OPS_H
 #define MLIR_STANDARDOPS_OPS_H
 
+#include "mlir/Analysis/MemRefAccessInterface.h"
+#include "mlir/Analysis/MemoryEffects.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/OpDefinition.h"
@@ -36,11 +38,18 @@ namespace detail {
 /// A custom binary operation printer that omits the "std." prefix from the
 /// operation names.
 void printStandardBinaryOp(Operation *op, OpAsmPrinter *p);
+
+/// Verify the optional "fastmath" attribute of the floating point arithmetic
+/// operations, which must be an array of fast-math flag names.
+LogicalResult verifyFastMathAttr(Operation *op);
 } // namespace detail
 
 class StandardOpsDialect : public Dialect {
 public:
   StandardOpsDialect(MLIRContext *context);
+
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "std"; }
 };
 
 #define GET_OP_CLASSES
@@ -66,7 +75,8 @@ public:
 /// This operation returns a single ssa value of memref type, which can be used
 /// by subsequent load and store operations.
 class AllocOp
-    : public Op<AllocOp, OpTrait::VariadicOperands, OpTrait::OneResult> {
+    : public Op<AllocOp, OpTrait::VariadicOperands, OpTrait::OneResult,
+                MemoryEffectsOpInterface::Trait> {
 public:
   using Op::Op;
 
@@ -83,6 +93,7 @@ public:
   void print(OpAsmPrinter *p);
   static void getCanonicalizationPatterns(OwningRewritePatternList &results,
                                           MLIRContext *context);
+  void getEffects(SmallVectorImpl<MemoryEffect> &effects);
 };
 
 /// The "br" operation represents a branch operation in a function.
@@ -454,7 +465,8 @@ public:
 ///   dealloc %0 : memref<8x64xf32, (d0, d1) -> (d0, d1), 1>
 ///
 class DeallocOp
-    : public Op<DeallocOp, OpTrait::OneOperand, OpTrait::ZeroResult> {
+    : public Op<DeallocOp, OpTrait::OneOperand, OpTrait::ZeroResult,
+                MemoryEffectsOpInterface::Trait> {
 public:
   using Op::Op;
 
@@ -470,6 +482,7 @@ public:
   void print(OpAsmPrinter *p);
   static void getCanonicalizationPatterns(OwningRewritePatternList &results,
                                           MLIRContext *context);
+  void getEffects(SmallVectorImpl<MemoryEffect> &effects);
 };
 
 /// The "dim" operation takes a memref or tensor operand and returns an
@@ -499,6 +512,8 @@ public:
   LogicalResult verify();
   static bool parse(OpAsmParser *parser, OperationState *result);
   void print(OpAsmPrinter *p);
+  static void getCanonicalizationPatterns(OwningRewritePatternList &results,
+                                          MLIRContext *context);
 };
 
 // DmaStartOp starts a non-blocking DMA operation that transfers data from a
@@ -507,14 +522,17 @@ public:
 // The operands include the source and destination memref's each followed by its
 // indices, size of the data transfer in terms of the number of elements (of the
 // elemental type of the memref), a tag memref with its indices, and optionally
-// at the end, a stride and a number_of_elements_per_stride arguments. The tag
-// location is used by a DmaWaitOp to check for completion. The indices of the
-// source memref, destination memref, and the tag memref have the same
-// restrictions as any load/store. The optional stride arguments should be of
-// 'index' type, and specify a stride for the slower memory space (memory space
-// with a lower memory space id), tranferring chunks of
+// at the end, one or more pairs of stride and number_of_elements_per_stride
+// arguments. The tag location is used by a DmaWaitOp to check for completion.
+// The indices of the source memref, destination memref, and the tag memref have
+// the same restrictions as any load/store. The optional stride arguments should
+// be of 'index' type, and specify a stride for the slower memory space (memory
+// space with a lower memory space id), tranferring chunks of
 // number_of_elements_per_stride every stride until %num_elements are
-// transferred. Either both or no stride arguments should be specified.
+// transferred. Each stride argument comes with its number of elements per
+// stride. When several pairs are specified, they are the stride levels from
+// the outermost to the innermost one: each chunk transferred at a level is in
+// turn transferred as per the next level.
 //
 // For example, a DmaStartOp operation that transfers 256 elements of a memref
 // '%src' in memory space 0 at indices [%i, %j] to memref '%dst' in memory space
@@ -535,11 +553,19 @@ public:
 //   dma_start %src[%i, %j], %dst[%k, %l], %num_elements, %tag[%idx], %stride,
 //             %num_elt_per_stride :
 //
+//   A 32 x 32 x 32 block of a 256 x 256 x 256 memref is transferred with two
+//   stride levels: 1024 elements every 65536 elements, each of these 1024
+//   elements being in turn transferred 32 elements every 256 elements.
+//
+//   dma_start %src[%i, %j, %k], %dst[%l, %m, %n], %c32768, %tag[%idx],
+//             %c65536, %c1024, %c256, %c32 :
+//
 // TODO(mlir-team): add additional operands to allow source and destination
-// striding, and multiple stride levels.
+// striding.
 // TODO(andydavis) Consider replacing src/dst memref indices with view memrefs.
 class DmaStartOp
-    : public Op<DmaStartOp, OpTrait::VariadicOperands, OpTrait::ZeroResult> {
+    : public Op<DmaStartOp, OpTrait::VariadicOperands, OpTrait::ZeroResult,
+                MemoryEffectsOpInterface::Trait> {
 public:
   using Op::Op;
 
@@ -549,6 +575,14 @@ public:
                     Value *tagMemRef, ArrayRef<Value *> tagIndices,
                     Value *stride = nullptr,
                     Value *elementsPerStride = nullptr);
+  // Builds a DMA with the stride levels 'strides' and 'elementsPerStride',
+  // from the outermost to the innermost.
+  static void build(Builder *builder, OperationState *result, Value *srcMemRef,
+                    ArrayRef<Value *> srcIndices, Value *destMemRef,
+                    ArrayRef<Value *> destIndices, Value *numElements,
+                    Value *tagMemRef, ArrayRef<Value *> tagIndices,
+                    ArrayRef<Value *> strides,
+                    ArrayRef<Value *> elementsPerStride);
 
   // Returns the source MemRefType for this DMA operation.
   Value *getSrcMemRef() { return getOperand(0); }
@@ -631,22 +665,34 @@ public:
 
   static void getCanonicalizationPatterns(OwningRewritePatternList &results,
                                           MLIRContext *context);
+  // The transfer is asynchronous, it is complete at the matching dma_wait,
+  // which has unknown memory effects.
+  void getEffects(SmallVectorImpl<MemoryEffect> &effects);
+
+  bool isStrided() { return getNumStrideLevels() != 0; }
 
-  bool isStrided() {
-    return getNumOperands() != 1 + getSrcMemRefRank() + 1 + getDstMemRefRank() +
-                                   1 + 1 + getTagMemRefRank();
+  // Returns the number of stride levels of this DMA operation.
+  unsigned getNumStrideLevels() {
+    unsigned numNonStrideOperands = 1 + getSrcMemRefRank() + 1 +
+                                    getDstMemRefRank() + 1 + 1 +
+                                    getTagMemRefRank();
+    return (getNumOperands() - numNonStrideOperands) / 2;
   }
 
-  Value *getStride() {
-    if (!isStrided())
+  // Returns the stride at stride level 'level', level 0 being the outermost.
+  Value *getStride(unsigned level = 0) {
+    if (level >= getNumStrideLevels())
       return nullptr;
-    return getOperand(getNumOperands() - 1 - 1);
+    return getOperand(getNumOperands() - 2 * (getNumStrideLevels() - level));
   }
 
-  Value *getNumElementsPerStride() {
-    if (!isStrided())
+  // Returns the number of elements transferred every stride at stride level
+  // 'level', level 0 being the outermost.
+  Value *getNumElementsPerStride(unsigned level = 0) {
+    if (level >= getNumStrideLevels())
       return nullptr;
-    return getOperand(getNumOperands() - 1);
+    return getOperand(getNumOperands() - 2 * (getNumStrideLevels() - level) +
+                      1);
   }
 };
 
@@ -739,8 +785,9 @@ public:
 ///
 ///   %3 = load %0[%1, %1] : memref<4x4xi32>
 ///
-class LoadOp
-    : public Op<LoadOp, OpTrait::VariadicOperands, OpTrait::OneResult> {
+class LoadOp : public Op<LoadOp, OpTrait::VariadicOperands, OpTrait::OneResult,
+                          MemRefAccessOpInterface::Trait,
+                          MemoryEffectsOpInterface::Trait> {
 public:
   using Op::Op;
 
@@ -765,6 +812,7 @@ public:
   void print(OpAsmPrinter *p);
   static void getCanonicalizationPatterns(OwningRewritePatternList &results,
                                           MLIRContext *context);
+  void getEffects(SmallVectorImpl<MemoryEffect> &effects);
 };
 
 /// The "memref_cast" operation converts a memref from one type to an equivalent
@@ -861,7 +909,9 @@ public:
 ///   store %v, %A[%i, %j] : memref<4x128xf32, (d0, d1) -> (d0, d1), 0>
 ///
 class StoreOp
-    : public Op<StoreOp, OpTrait::VariadicOperands, OpTrait::ZeroResult> {
+    : public Op<StoreOp, OpTrait::VariadicOperands, OpTrait::ZeroResult,
+                MemRefAccessOpInterface::Trait,
+                MemoryEffectsOpInterface::Trait> {
 public:
   using Op::Op;
 
@@ -890,6 +940,7 @@ public:
 
   static void getCanonicalizationPatterns(OwningRewritePatternList &results,
                                           MLIRContext *context);
+  void getEffects(SmallVectorImpl<MemoryEffect> &effects);
 };
 
 /// The "tensor_cast" operation converts a tensor from one type to an equivalent
@@ -916,6 +967,30 @@ public:
   LogicalResult verify();
 };
 
+/// The "view" operation defines a memref aliasing a part of the buffer of its
+/// operand, a memref with the identity layout.  The view has a static shape
+/// and a strided layout with static strides and offset, which place its
+/// elements in the buffer of the operand.  The element type and memory space
+/// of the view match those of its operand, and its elements must be within the
+/// operand if the operand is statically shaped.
+///
+///   %1 = view %0 : memref<256xf32>
+///            to memref<8x4xf32, (d0, d1) -> (d0 * 4 + d1 + 64)>
+///
+class ViewOp : public CastOp<ViewOp> {
+public:
+  using CastOp::CastOp;
+
+  static StringRef getOperationName() { return "std.view"; }
+
+  /// The result of a view is always a memref.
+  MemRefType getType() { return getResult()->getType().cast<MemRefType>(); }
+
+  void print(OpAsmPrinter *p);
+
+  LogicalResult verify();
+};
+
 /// Prints dimension and symbol list.
 void printDimAndSymbolList(Operation::operand_iterator begin,
                            Operation::operand_iterator end, unsigned numDims,
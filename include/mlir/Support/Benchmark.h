@@ -0,0 +1,76 @@
+//===- Benchmark.h - Support for the benchmark tools ------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// Common utilities of the benchmark tools: the timing of a piece of code, and
+// the driver running a set of benchmarks and printing a JSON report of their
+// latencies.  The driver, in the MLIRBenchmarkSupport library, registers the
+// -filter, -warmup and -iterations options of the tools linking it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_SUPPORT_BENCHMARK_H_
+#define MLIR_SUPPORT_BENCHMARK_H_
+
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/Support/JSON.h"
+#include <chrono>
+#include <functional>
+#include <string>
+
+namespace mlir {
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+/// Return the time elapsed since `start`, in milliseconds.
+inline double getElapsedMs(BenchmarkClock::time_point start) {
+  return std::chrono::duration<double, std::milli>(BenchmarkClock::now() -
+                                                   start)
+      .count();
+}
+
+/// A benchmark processing 'numItems' items on each run.
+struct Benchmark {
+  std::string name;
+  /// The number of items processed by each run, or 0 if the benchmark does
+  /// not report a throughput.
+  size_t numItems;
+  /// Runs the benchmark once, returning false if it failed.
+  std::function<bool()> run;
+  /// If set, prepares each run outside of the timed region, returning false
+  /// if it failed.
+  std::function<bool()> setUp;
+  /// If set, adds the entries specific to the benchmark to its report.
+  std::function<void(llvm::json::Object &)> addToReport;
+};
+
+/// Run `benchmark` `warmup` times, then `iterations` times measuring the
+/// latency of each run, and return a JSON report of the latencies, or None if
+/// a run failed.
+Optional<llvm::json::Object> runBenchmark(const Benchmark &benchmark,
+                                          unsigned warmup,
+                                          unsigned iterations);
+
+/// Run the benchmarks whose name contains the string given to -filter, as many
+/// times as given to -warmup and -iterations, and print the JSON array of
+/// their reports to `os`.  Return failure, after reporting the benchmark that
+/// failed on llvm::errs(), if a run failed.
+LogicalResult runBenchmarks(ArrayRef<Benchmark> benchmarks, raw_ostream &os);
+
+} // end namespace mlir
+
+#endif // MLIR_SUPPORT_BENCHMARK_H_
@@ -56,7 +56,8 @@ inline int64_t mod(int64_t lhs, int64_t rhs) {
 inline int64_t lcm(int64_t a, int64_t b) {
   uint64_t x = std::abs(a);
   uint64_t y = std::abs(b);
-  int64_t lcm = (x * y) / llvm::GreatestCommonDivisor64(x, y);
+  // Divide before multiplying, so that only the result itself can overflow.
+  int64_t lcm = (x / llvm::GreatestCommonDivisor64(x, y)) * y;
   assert((lcm >= a && lcm >= b) && "LCM overflow");
   return lcm;
 }
@@ -0,0 +1,74 @@
+//===- ToolServer.h - Serving the requests of a tool ------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// A server mode for the command line tools, which processes a stream of
+// requests in a single process instead of starting one process per input.
+// Each request is a header line followed by the input to process:
+//
+//   <id> <input size> [<argument>...]\n
+//   <input>
+//
+// where the id is an arbitrary token echoed in the response, the input size is
+// a number of bytes, and the arguments are separated by spaces.  The requests
+// are processed concurrently, and each response is written as soon as its
+// request is processed:
+//
+//   <id> <status> <output size> <diagnostics size>\n
+//   <output><diagnostics>
+//
+// where the status is 0 if the request succeeded and 1 otherwise.  The empty
+// lines between the requests are ignored.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_SUPPORT_TOOLSERVER_H_
+#define MLIR_SUPPORT_TOOLSERVER_H_
+
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+#include <cstdio>
+#include <functional>
+#include <memory>
+
+namespace llvm {
+class MemoryBuffer;
+class ThreadPool;
+class raw_ostream;
+} // namespace llvm
+
+namespace mlir {
+
+/// Processes `input`, the input of a request with the arguments `args`,
+/// writing its output to `os` and its diagnostics to `diagOS`.  Returns failure
+/// if the request failed.  The handler is called concurrently on the threads
+/// of the pool of the server.
+using ToolServerHandler = std::function<LogicalResult(
+    ArrayRef<StringRef> args, std::unique_ptr<llvm::MemoryBuffer> input,
+    llvm::raw_ostream &os, llvm::raw_ostream &diagOS)>;
+
+/// Reads requests from `input` until its end, processes them with `handler` on
+/// `threadPool` and writes the responses to `output`.  The input buffers of the
+/// requests are named "<stdin>", like the standard input of the tools.
+/// Returns failure, after writing the responses of the requests read so far,
+/// if a request header is malformed or an input is truncated.
+LogicalResult runToolServer(FILE *input, llvm::raw_ostream &output,
+                            llvm::ThreadPool &threadPool,
+                            const ToolServerHandler &handler);
+
+} // namespace mlir
+
+#endif // MLIR_SUPPORT_TOOLSERVER_H_
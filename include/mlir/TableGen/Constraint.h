@@ -56,6 +56,10 @@ public:
   // description is not provided, returns the TableGen def name.
   StringRef getDescription() const;
 
+  // Returns true if checking this constraint is expensive.  The op verifiers
+  // skip such constraints when fast verification is enabled.
+  bool isExpensive() const;
+
   // Constraint kind
   enum Kind { CK_Type, CK_Attr, CK_Uncategorized };
 
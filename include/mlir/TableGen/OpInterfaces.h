@@ -0,0 +1,95 @@
+//===- OpInterfaces.h - OpInterfaces wrapper class --------------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// OpInterface wrapper to simplify using TableGen Record defining an MLIR op
+// interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_TABLEGEN_OPINTERFACES_H_
+#define MLIR_TABLEGEN_OPINTERFACES_H_
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm {
+class Record;
+} // end namespace llvm
+
+namespace mlir {
+namespace tblgen {
+
+// Wrapper class with helper methods for accessing a method of an op interface
+// defined in TableGen.
+class InterfaceMethod {
+public:
+  // An argument of the method: its C++ type and its name.
+  struct Argument {
+    StringRef type;
+    StringRef name;
+  };
+
+  explicit InterfaceMethod(const llvm::Record *def);
+
+  // Returns the name of the method.
+  StringRef getName() const;
+
+  // Returns the C++ type returned by the method.
+  StringRef getReturnType() const;
+
+  // Returns the description of the method.
+  StringRef getDescription() const;
+
+  // Returns the arguments of the method.
+  ArrayRef<Argument> getArguments() const { return arguments; }
+
+private:
+  // The TableGen definition of the method.
+  const llvm::Record *def;
+
+  // The arguments of the method.
+  SmallVector<Argument, 4> arguments;
+};
+
+// Wrapper class with helper methods for accessing an op interface defined in
+// TableGen.
+class OpInterface {
+public:
+  explicit OpInterface(const llvm::Record *def);
+
+  // Returns the name of the C++ class of the interface.
+  StringRef getName() const;
+
+  // Returns the description of the interface.
+  StringRef getDescription() const;
+
+  // Returns the methods of the interface.
+  ArrayRef<InterfaceMethod> getMethods() const { return methods; }
+
+private:
+  // The TableGen definition of the interface.
+  const llvm::Record *def;
+
+  // The methods of the interface.
+  SmallVector<InterfaceMethod, 8> methods;
+};
+
+} // end namespace tblgen
+} // end namespace mlir
+
+#endif // MLIR_TABLEGEN_OPINTERFACES_H_
@@ -44,7 +44,9 @@ public:
     // OpTrait corresponding to predicate on operation.
     Pred,
     // OpTrait controlling op definition generator internals.
-    Internal
+    Internal,
+    // OpTrait corresponding to an op interface.
+    Interface
   };
 
   explicit OpTrait(Kind kind, const llvm::Record *def);
@@ -78,6 +80,10 @@ public:
   // Returns the description of what the predicate is verifying.
   StringRef getDescription() const;
 
+  // Returns true if checking the predicate is expensive.  The op verifiers
+  // skip such predicates when fast verification is enabled.
+  bool isExpensive() const;
+
   static bool classof(const OpTrait *t) { return t->getKind() == Kind::Pred; }
 };
 
@@ -92,6 +98,20 @@ public:
   }
 };
 
+// OpTrait corresponding to an op interface, see OpInterface.
+class InterfaceOpTrait : public OpTrait {
+public:
+  // Returns the trait that the ops implementing the interface derive from.
+  std::string getTrait() const;
+
+  // Returns the definition of the interface.
+  const llvm::Record &getDef() const { return *def; }
+
+  static bool classof(const OpTrait *t) {
+    return t->getKind() == Kind::Interface;
+  }
+};
+
 } // end namespace tblgen
 } // end namespace mlir
 
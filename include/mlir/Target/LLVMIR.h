@@ -15,23 +15,32 @@
 // limitations under the License.
 // =============================================================================
 //
-// This file declares the entry point for the MLIR to LLVM IR conversion.
+// This file declares the entry points for the MLIR to LLVM IR conversion, and
+// for the import of LLVM IR into the MLIR LLVM IR dialect.
 //
 //===----------------------------------------------------------------------===//
 
 #ifndef MLIR_TARGET_LLVMIR_H
 #define MLIR_TARGET_LLVMIR_H
 
+#include "mlir/Support/LLVM.h"
+#include "mlir/Support/LogicalResult.h"
+
 #include <memory>
+#include <string>
+#include <vector>
 
 // Forward-declare LLVM classses.
 namespace llvm {
 class LLVMContext;
+class MemoryBufferRef;
 class Module;
 } // namespace llvm
 
 namespace mlir {
 
+class Function;
+class MLIRContext;
 class Module;
 
 /// Convert the given MLIR module into LLVM IR.  Create an LLVM IR module in
@@ -41,6 +50,63 @@ class Module;
 std::unique_ptr<llvm::Module>
 convertModuleToLLVMIR(Module &module, llvm::LLVMContext &llvmContext);
 
+/// A part of an MLIR module translated to LLVM IR: an LLVM IR module, in its
+/// own LLVM context, defining some of the functions of the MLIR module and
+/// declaring the others.
+struct LLVMIRModulePart {
+  std::unique_ptr<llvm::LLVMContext> context;
+  std::unique_ptr<llvm::Module> module;
+};
+
+/// Translate the given MLIR module expressed in the LLVM IR dialect into
+/// `numParts` LLVM IR modules, or one per defined function if `numParts` is 0,
+/// which are translated concurrently on the thread pool of the MLIR context.
+/// The defined functions are balanced over the parts by their number of
+/// operations.  Since each part has its own LLVM context, the parts can then be
+/// compiled concurrently, or linked together.  In case of error, report it to
+/// the MLIR context and return failure.
+LogicalResult
+translateModuleToLLVMIRParts(Module &module, unsigned numParts,
+                             std::vector<LLVMIRModulePart> &parts);
+
+/// Translate the given functions of the MLIR module expressed in the LLVM IR
+/// dialect into a new LLVM IR module in `llvmContext`, which only declares the
+/// other functions of the module.  In case of error, report it to the MLIR
+/// context and return `nullptr`.
+std::unique_ptr<llvm::Module>
+translateFunctionsToLLVMIR(Module &module, ArrayRef<Function *> functions,
+                           llvm::LLVMContext &llvmContext);
+
+/// A GPU kernel translated to PTX assembly, which defines the kernel under the
+/// name of its function.
+struct PTXKernel {
+  std::string name;
+  std::string ptx;
+};
+
+/// Translate each GPU kernel of the given MLIR module expressed in the LLVM IR
+/// dialect, i.e. each function with the "gpu.kernel" attribute, to PTX assembly
+/// for the GPU architecture `gpuArch`, e.g. "sm_35", through the NVPTX backend
+/// of LLVM.  The calls to the mlir_gpu_* functions returning the thread and
+/// block ids are replaced with reads of the special registers of the GPU.  In
+/// case of error, e.g. if a kernel calls other functions or if LLVM was built
+/// without the NVPTX target, report it to the MLIR context and return failure.
+LogicalResult translateGPUKernelsToPTX(Module &module, StringRef gpuArch,
+                                       std::vector<PTXKernel> &kernels);
+
+/// Import the given LLVM IR module into a new MLIR module of `context`,
+/// expressed in the MLIR LLVM IR dialect.  The LLVM IR module must live in the
+/// LLVM context of the dialect registered in `context`.  In case of error,
+/// report it to `context` and return `nullptr`.
+std::unique_ptr<Module> convertLLVMIRToModule(llvm::Module &llvmModule,
+                                              MLIRContext *context);
+
+/// Parse the textual or bitcode LLVM IR in `buffer` in the LLVM context of the
+/// LLVM IR dialect registered in `context`, and import it into a new MLIR
+/// module.  In case of error, report it to `context` and return `nullptr`.
+std::unique_ptr<Module> parseLLVMIRToModule(llvm::MemoryBufferRef buffer,
+                                            MLIRContext *context);
+
 } // namespace mlir
 
 #endif // MLIR_TARGET_LLVMIR_H
@@ -128,24 +128,32 @@ template <typename Arg> struct ConversionListBuilder<Arg> {
 /// The module conversion proceeds as follows.
 /// 1. Call `initConverters` to obtain a set of conversions to apply, given the
 ///    current MLIR context.
-/// 2. For each function in the module do the following.
-//    a. Create a new function with the same name and convert its signature
-//    using `convertType`.
-//    b. For each block in the function, create a block in the function with
-//    its arguments converted using `convertType`.
-//    c. Traverse blocks in DFS-preorder of successors starting from the entry
+/// 2. Convert the signature of each function in the module using
+///    `convertFunctionSignatureType`.
+/// 3. For each function in the module do the following, concurrently on the
+///    thread pool of the context if `isThreadSafe` returns true.
+//    a. For each block in the function whose argument types change, add
+//    arguments of the types converted by `convertType`.
+//    b. Traverse blocks in DFS-preorder of successors starting from the entry
 //    block (if any), and convert individual operations as follows.  Pattern
-//    match against the list of conversions.  On the first match, call
-//    `rewriteTerminator` for terminator operations with successors and
-//    `rewrite` for other operations, and advance to the next iteration.  If no
-//    match is found, replicate the operation as is.  Note that if two patterns
-//    match the same operation, it is undefined which of them will be applied.
-/// 3. Update all attributes of function type to point to the new functions.
-/// 4. Replace old functions with new functions in the module.
+//    match against the conversions rooted at the operation, in decreasing
+//    order of benefit.  On the first match, call `rewriteTerminator` for
+//    terminator operations with successors and `rewrite` for other
+//    operations, and advance to the next iteration.  If no match is found,
+//    leave the operation as is.  Note that if two patterns with the same
+//    benefit match the same operation, it is undefined which of them will be
+//    applied.
+//    c. Replace the uses of the matched operations and of the original block
+//    arguments with the converted values, and erase them.
+/// The functions are converted in place, so only the operations matched by a
+/// pattern are rewritten.  While a pattern runs, the original operations and
+/// block arguments are still present with their original types, and the
+/// converted values are passed to the pattern separately.
 /// If any error happend during the conversion, the pass fails as soon as
 /// possible.
 ///
-/// If the conversion fails, the module is not modified.
+/// If a function signature can't be converted, the module is not modified.
+/// Errors in function bodies may leave the module partially converted.
 class DialectConversion {
   friend class impl::FunctionConversion;
 
@@ -179,6 +187,13 @@ protected:
   /// the pass failure.
   virtual Type convertType(Type t) { return t; }
 
+  /// Derived classes may reimplement this hook to return true if their
+  /// conversion patterns and `convertType` can be invoked concurrently on
+  /// different functions, in which case the function bodies are converted in
+  /// parallel.  This requires the patterns not to modify the module, e.g., by
+  /// declaring new functions.
+  virtual bool isThreadSafe() { return false; }
+
   /// Derived classes must reimplement this hook if they need to change the
   /// function signature during conversion.  This function will be called on
   /// a function type corresponding to a function signature and must produce the
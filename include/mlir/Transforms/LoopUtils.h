@@ -26,12 +26,17 @@
 
 #include "mlir/Support/LLVM.h"
 #include "mlir/Support/LogicalResult.h"
+#include <vector>
 
 namespace mlir {
 class AffineMap;
 class AffineForOp;
+class DependenceAnalysis;
+struct DependenceComponent;
 class Function;
 class FuncBuilder;
+class IntegerSet;
+class Operation;
 class Value;
 
 /// Unrolls this for operation completely if the trip count is known to be
@@ -41,6 +46,13 @@ LogicalResult loopUnrollFull(AffineForOp forOp);
 /// if the loop cannot be unrolled either due to restrictions or due to invalid
 /// unroll factors.
 LogicalResult loopUnrollByFactor(AffineForOp forOp, uint64_t unrollFactor);
+/// Unrolls this for operation by the specified unroll factor after versioning
+/// it on its trip count being a multiple of the factor (see
+/// versionLoopForTripCountMultiple), so that the unrolled fast version needs no
+/// cleanup loop. The fallback version is left as is. Falls back to
+/// loopUnrollByFactor if the loop needs no versioning or can't be versioned.
+LogicalResult loopUnrollByFactorVersioned(AffineForOp forOp,
+                                          uint64_t unrollFactor);
 /// Unrolls this loop by the specified unroll factor or its trip count,
 /// whichever is lower.
 LogicalResult loopUnrollUpToFactor(AffineForOp forOp, uint64_t unrollFactor);
@@ -81,11 +93,46 @@ LLVM_NODISCARD
 LogicalResult instBodySkew(AffineForOp forOp, ArrayRef<uint64_t> shifts,
                            bool unrollPrologueEpilogue = false);
 
+/// Versions 'forOp' on 'condition': creates an 'affine.if' on 'condition'
+/// applied to 'conditionOperands' right before 'forOp', moves 'forOp' into its
+/// 'then' block and clones it into its 'else' block. 'forOp' thus becomes the
+/// fast version, which transformations may specialize assuming 'condition'
+/// holds, and the clone is the generic fallback, which is returned. The
+/// condition operands are expected to be valid dimensions and symbols at the
+/// position of 'forOp'.
+AffineForOp versionLoop(AffineForOp forOp, IntegerSet condition,
+                        ArrayRef<Value *> conditionOperands);
+
+/// Versions 'forOp' (see versionLoop) on its trip count being a multiple of
+/// 'multiple'. Sets 'fallbackForOp', if non-null, to the fallback version.
+/// Returns failure if the trip count can't be expressed as a single affine
+/// expression, in which case 'forOp' is left unchanged.
+LogicalResult
+versionLoopForTripCountMultiple(AffineForOp forOp, uint64_t multiple,
+                                AffineForOp *fallbackForOp = nullptr);
+
 /// Tiles the specified band of perfectly nested loops creating tile-space loops
-/// and intra-tile loops. A band is a contiguous set of loops.
+/// and intra-tile loops. A band is a contiguous set of loops. If 'tiledNest' is
+/// non-null, it is set to the tile-space loops followed by the intra-tile
+/// loops.
+LLVM_NODISCARD
+LogicalResult tileCodeGen(MutableArrayRef<AffineForOp> band,
+                          ArrayRef<unsigned> tileSizes,
+                          SmallVectorImpl<AffineForOp> *tiledNest = nullptr);
+
+/// Tiles the specified band of perfectly nested loops with the symbolic tile
+/// sizes 'tileSizes', which are expected to be positive index values valid as
+/// symbols. The loops need unit steps and single result bounds that do not
+/// depend on each other. The full tiles are separated from the partial ones:
+/// the tile-space loops only iterate over the full tiles, whose intra-tile
+/// loops have no min bounds, and the remainder of each dimension is handled by
+/// a copy of the nest that follows its tile-space loop. If 'tiledNest' is
+/// non-null, it is set to the tile-space loops followed by the intra-tile
+/// loops of the full tiles.
 LLVM_NODISCARD
 LogicalResult tileCodeGen(MutableArrayRef<AffineForOp> band,
-                          ArrayRef<unsigned> tileSizes);
+                          ArrayRef<Value *> tileSizes,
+                          SmallVectorImpl<AffineForOp> *tiledNest = nullptr);
 
 /// Performs loop interchange on 'forOpA' and 'forOpB'. Requires that 'forOpA'
 /// and 'forOpB' are part of a perfectly nested sequence of loops.
@@ -96,6 +143,32 @@ void interchangeLoops(AffineForOp forOpA, AffineForOp forOpB);
 /// 'loopDepth' AffineForOps consecutively nested under it.
 void sinkLoop(AffineForOp forOp, unsigned loopDepth);
 
+/// Computes in 'depCompsVec' the dependences between the load/store ops 'ops'
+/// nested in the perfect nest 'loops' that are carried by one of its loops,
+/// each as its components along the loops of the nest, outermost first. If
+/// 'isParallelLoop' is non-null, it is set to whether each loop of the nest
+/// carries no dependence. The dependences are checked through 'dependences' if
+/// it is non-null, so that its cached results are reused.
+void getLoopNestDependenceComponents(
+    ArrayRef<AffineForOp> loops, ArrayRef<Operation *> ops,
+    std::vector<SmallVector<DependenceComponent, 2>> *depCompsVec,
+    SmallVectorImpl<bool> *isParallelLoop = nullptr,
+    DependenceAnalysis *dependences = nullptr);
+
+/// Returns true if moving each loop 'i' of a perfect nest to position
+/// 'loopPermMap[i]' keeps the dependences 'depCompsVec', as computed by
+/// getLoopNestDependenceComponents, lexicographically positive.
+bool isValidLoopInterchangePermutation(
+    ArrayRef<SmallVector<DependenceComponent, 2>> depCompsVec,
+    ArrayRef<unsigned> loopPermMap);
+
+/// Permutes the loops of the perfect nest 'loops' through a series of loop
+/// interchanges, moving each loop 'i' to position 'loopPermMap[i]', and returns
+/// the new root of the nest. The bounds of the loops must not depend on the
+/// induction variables of the nest.
+AffineForOp permuteLoops(ArrayRef<AffineForOp> loops,
+                         ArrayRef<unsigned> loopPermMap);
+
 /// Performs tiling fo imperfectly nested loops (with interchange) by
 /// strip-mining the `forOps` by `sizes` and sinking them, in their order of
 /// occurrence in `forOps`, under each of the `targets`.
@@ -26,12 +26,17 @@
 #include "mlir/Support/LLVM.h"
 #include <functional>
 #include <limits>
+#include <memory>
 
 namespace mlir {
 
 class AffineForOp;
 class FunctionPassBase;
+class LoopNestPassBase;
+class MLIRContext;
 class ModulePassBase;
+class OwningRewritePatternList;
+class TargetMemoryModel;
 
 /// Creates a constant folding pass.
 FunctionPassBase *createConstantFoldPass();
@@ -42,6 +47,11 @@ FunctionPassBase *createCanonicalizerPass();
 /// Creates a pass to perform common sub expression elimination.
 FunctionPassBase *createCSEPass();
 
+/// Creates a pass to perform global value numbering, which also merges
+/// commutative operations regardless of their operand order, equivalent
+/// affine.apply ops, and redundant loads.
+FunctionPassBase *createGVNPass();
+
 /// Creates a pass to vectorize loops, operations and data types using a
 /// target-independent, n-D super-vector abstraction.
 FunctionPassBase *
@@ -65,33 +75,129 @@ FunctionPassBase *createLoopUnrollPass(
     int unrollFactor = -1, int unrollFull = -1,
     const std::function<unsigned(AffineForOp)> &getUnrollFactor = nullptr);
 
+/// Creates a loop unrolling pass with the provided parameters, that unrolls the
+/// loops of each loop nest of a function concurrently, see LoopNestPass.
+LoopNestPassBase *createLoopNestUnrollPass(int unrollFactor = -1,
+                                           int unrollFull = -1);
+
 /// Creates a loop unroll jam pass to unroll jam by the specified factor. A
 /// factor of -1 lets the pass use the default factor or the one on the command
-/// line if provided.
-FunctionPassBase *createLoopUnrollAndJamPass(int unrollJamFactor = -1);
+/// line if provided. If 'selectFactors' is true, every loop surrounding other
+/// loops is instead unroll-jammed by a factor selected so that the values
+/// reused across the copies of the innermost loop bodies fit in the vector
+/// registers of `memoryModel`; the model set up from the command line is used
+/// if it is null.
+FunctionPassBase *createLoopUnrollAndJamPass(
+    int unrollJamFactor = -1, bool selectFactors = false,
+    std::shared_ptr<const TargetMemoryModel> memoryModel = nullptr);
 
 /// Creates an simplification pass for affine structures.
 FunctionPassBase *createSimplifyAffineStructuresPass();
 
 /// Creates a loop fusion pass which fuses loops. Buffers of size less than or
 /// equal to `localBufSizeThreshold` are promoted to memory space
-/// `fastMemorySpace'.
-FunctionPassBase *createLoopFusionPass(unsigned fastMemorySpace = 0,
-                                       uint64_t localBufSizeThreshold = 0,
-                                       bool maximalFusion = false);
+/// `fastMemorySpace'. Fusions that would increase the memory traffic estimated
+/// with `memoryModel` are rejected; the model set up from the command line is
+/// used if it is null.
+FunctionPassBase *createLoopFusionPass(
+    unsigned fastMemorySpace = 0, uint64_t localBufSizeThreshold = 0,
+    bool maximalFusion = false,
+    std::shared_ptr<const TargetMemoryModel> memoryModel = nullptr);
+
+/// Creates a pass permuting the loops of perfect affine.for nests for the
+/// locality of their accesses along the innermost loop and the parallelism of
+/// the outermost one.
+FunctionPassBase *createLoopInterchangePass();
+
+/// Creates a pass hoisting the operations of affine.for bodies that are
+/// invariant along the loop out of it.
+FunctionPassBase *createLoopInvariantCodeMotionPass();
+
+/// Creates a pass skewing the perfect affine.for nests none of whose loops is
+/// parallel so that their dependences become non-negative, tiling them by
+/// `tileSize`, and enumerating their tiles by wavefronts whose tiles are
+/// enumerated by parallel loops. A tile size of 0 enumerates the iterations by
+/// wavefronts without tiling, and one of -1 lets the pass use the one on the
+/// command line.
+FunctionPassBase *createLoopSkewingPass(int tileSize = -1);
 
 /// Creates a pass to pipeline explicit movement of data across levels of the
-/// memory hierarchy.
-FunctionPassBase *createPipelineDataTransferPass();
+/// memory hierarchy. Each pipelined transfer uses 'numBuffers' buffers; a value
+/// of -1 lets the pass use the one on the command line if provided, or double
+/// buffering otherwise.
+FunctionPassBase *createPipelineDataTransferPass(int numBuffers = -1);
 
 /// Lowers affine control flow operations (ForStmt, IfStmt and AffineApplyOp)
 /// to equivalent lower-level constructs (flow of basic blocks and arithmetic
 /// primitives).
 FunctionPassBase *createLowerAffinePass();
 
+/// Creates a pass outlining the outermost parallel loops into functions that
+/// are executed over several threads.  Each loop is replaced by a call to its
+/// outlined function marked with the "parallel.step" attribute, which the
+/// conversion to the LLVM IR dialect turns into a call to the parallel runtime
+/// of the ExecutionEngine.
+ModulePassBase *createOutlineParallelLoopsPass();
+
+/// Creates a pass outlining the outermost bands of up to three perfectly nested
+/// parallel loops into GPU kernels executing one iteration per thread, with
+/// blocks of `blockSize` threads along the innermost loop.  Each band is
+/// replaced by a call to its kernel marked with the "gpu.block_size" and
+/// "gpu.step" attributes, which the conversion to the LLVM IR dialect turns
+/// into a launch through the GPU runtime of the ExecutionEngine.  A block size
+/// of -1 lets the pass use the one on the command line.
+ModulePassBase *createOutlineGPUKernelsPass(int blockSize = -1);
+
+/// Creates a pass instrumenting the 'affine.for' operations and the functions
+/// with calls to the profile runtime of the ExecutionEngine, which counts the
+/// iterations of each loop and the time spent in it, keyed by the location of
+/// the loop, and prints them when the process exits.
+ModulePassBase *createInstrumentLoopsPass();
+
+/// Creates a pass marking the loads, stores and vector transfers that the
+/// MemRefBoundsAnalysis proves to stay within the bounds of their memref, so
+/// that the lowering to the LLVM IR dialect emits inbounds GEPs and unmasked
+/// vector accesses for them.  If `insertRuntimeChecks` is set, the other loads
+/// and stores are preceded by calls to the bounds check runtime, which aborts
+/// on an out-of-bounds index.
+ModulePassBase *
+createAnnotateMemRefBoundsPass(bool insertRuntimeChecks = false);
+
+/// Creates a pass inlining the direct calls to the functions containing at
+/// most `threshold` operations, bottom-up on the call graph.  A threshold of -1
+/// lets the pass use the one on the command line.
+ModulePassBase *createInlinerPass(int threshold = -1);
+
+/// Creates a pass cloning the callees of the direct calls passing constants or
+/// memrefs cast from a static shape, specialized for those arguments and
+/// canonicalized.  At most `maxSpecializations` clones of a function are
+/// created; a value of -1 lets the pass use the one on the command line.
+ModulePassBase *createSpecializeFunctionsPass(int maxSpecializations = -1);
+
+/// The policy deciding which floating point multiplications and additions may
+/// be contracted into multiply-adds: none of them, those allowing it with the
+/// "contract" or "fast" flag of their "fastmath" attribute, or all of them.
+enum class FPContractionPolicy { Off, On, Fast };
+
+/// Adds to `patterns` the pattern contracting the addf operations of a mulf
+/// operation without other users into fmaf operations, following `policy`
+/// unless the "fp_contract" attribute of the function ("off", "on" or "fast")
+/// overrides it.
+void populateFMAFormationPatterns(OwningRewritePatternList &patterns,
+                                  MLIRContext *context,
+                                  FPContractionPolicy policy);
+
+/// Creates a pass contracting floating point multiplications and additions
+/// into multiply-adds with `policy`.
+FunctionPassBase *createFMAFormationPass(FPContractionPolicy policy);
+
 /// Creates a pass to perform tiling on loop nests.
 FunctionPassBase *createLoopTilingPass(uint64_t cacheSizeBytes);
 
+/// Creates a pass to perform loop tiling for the last level cache of
+/// `memoryModel`.
+FunctionPassBase *createLoopTilingPass(const TargetMemoryModel &memoryModel);
+
 /// Promotes all accessed memref regions to the specified faster memory space
 /// while generating DMAs to move data.
 FunctionPassBase *createDmaGenerationPass(
@@ -99,6 +205,13 @@ FunctionPassBase *createDmaGenerationPass(
     int minDmaTransferSize = 1024,
     uint64_t fastMemCapacityBytes = std::numeric_limits<uint64_t>::max());
 
+/// Same as above, with the capacity of the fast memory space of
+/// `memoryModel`.
+FunctionPassBase *createDmaGenerationPass(unsigned slowMemorySpace,
+                                          unsigned fastMemorySpace,
+                                          int minDmaTransferSize,
+                                          const TargetMemoryModel &memoryModel);
+
 /// Creates a pass to lower VectorTransferReadOp and VectorTransferWriteOp.
 FunctionPassBase *createLowerVectorTransfersPass();
 
@@ -106,6 +219,11 @@ FunctionPassBase *createLowerVectorTransfersPass();
 /// store to load forwarding, elimination of dead stores, and dead allocs.
 FunctionPassBase *createMemRefDataFlowOptPass();
 
+/// Creates a pass to place the statically shaped buffers allocated in a
+/// function in arenas allocated once per function, so that the buffers never
+/// live at the same time share memory.
+FunctionPassBase *createMemoryPlanningPass();
+
 /// Creates a pass to strip debug information from a function.
 FunctionPassBase *createStripDebugInfoPass();
 
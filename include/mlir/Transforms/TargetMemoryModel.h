@@ -0,0 +1,102 @@
+//===- TargetMemoryModel.h - Memory hierarchy of a target -------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This header file defines a description of the memory hierarchy of a target,
+// which the loop transformations use to size their working sets.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_TRANSFORMS_TARGETMEMORYMODEL_H
+#define MLIR_TRANSFORMS_TARGETMEMORYMODEL_H
+
+#include "mlir/Support/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace mlir {
+
+/// Describes the vector registers and the caches of a target, from the fastest
+/// to the slowest, the bandwidth of the memory behind them, and the capacity of
+/// the fast memory space that is managed explicitly with DMAs. Targets can
+/// subclass it to refine the cost queries.
+class TargetMemoryModel {
+public:
+  /// A level of the cache hierarchy.
+  struct CacheLevel {
+    /// The capacity of the cache in bytes.
+    uint64_t capacityBytes;
+    /// The size of a cache line in bytes.
+    unsigned lineSizeBytes;
+    /// The bandwidth from this level to the one above it in bytes per cycle.
+    double bandwidthBytesPerCycle;
+  };
+
+  TargetMemoryModel(ArrayRef<CacheLevel> cacheLevels,
+                    double memoryBandwidthBytesPerCycle,
+                    uint64_t fastMemCapacityBytes,
+                    unsigned vectorWidthBytes = 32,
+                    unsigned numVectorRegisters = 16);
+  virtual ~TargetMemoryModel();
+
+  /// Returns the model set up with the -target-* command line options, whose
+  /// defaults describe a generic server core with unlimited fast memory.
+  static TargetMemoryModel getDefault();
+
+  ArrayRef<CacheLevel> getCacheLevels() const { return cacheLevels; }
+
+  /// Returns the last level cache, whose misses are served by the memory.
+  const CacheLevel &getLastLevelCache() const { return cacheLevels.back(); }
+
+  /// Returns the bandwidth of the memory in bytes per cycle.
+  double getMemoryBandwidth() const { return memoryBandwidthBytesPerCycle; }
+
+  /// Returns the capacity of the fast memory space in bytes.
+  uint64_t getFastMemoryCapacity() const { return fastMemCapacityBytes; }
+
+  /// Returns the width of a vector register in bytes.
+  unsigned getVectorWidth() const { return vectorWidthBytes; }
+
+  /// Returns the number of vector registers.
+  unsigned getNumVectorRegisters() const { return numVectorRegisters; }
+
+  /// Returns the number of bytes held by all the vector registers together.
+  uint64_t getRegisterFileCapacity() const {
+    return static_cast<uint64_t>(vectorWidthBytes) * numVectorRegisters;
+  }
+
+  /// Returns true if a working set of 'workingSetBytes' bytes stays resident
+  /// in the last level cache when it is reused.
+  virtual bool fitsInCache(uint64_t workingSetBytes) const;
+
+  /// Returns the number of bytes moved from the memory when a working set of
+  /// 'workingSetBytes' bytes is streamed once, rounded up to whole lines.
+  virtual uint64_t getStreamTraffic(uint64_t workingSetBytes) const;
+
+  /// Returns the number of cycles needed to move 'numBytes' bytes from the
+  /// memory.
+  virtual double getTransferCycles(uint64_t numBytes) const;
+
+private:
+  SmallVector<CacheLevel, 3> cacheLevels;
+  double memoryBandwidthBytesPerCycle;
+  uint64_t fastMemCapacityBytes;
+  unsigned vectorWidthBytes;
+  unsigned numVectorRegisters;
+};
+
+} // end namespace mlir
+
+#endif // MLIR_TRANSFORMS_TARGETMEMORYMODEL_H
@@ -34,6 +34,9 @@ namespace mlir {
 class VectorOpsDialect : public Dialect {
 public:
   VectorOpsDialect(MLIRContext *context);
+
+  /// The namespace of the dialect, under which it is registered.
+  static StringRef getDialectNamespace() { return "vector"; }
 };
 
 /// VectorTransferReadOp performs a blocking read from a scalar memref
@@ -202,6 +205,189 @@ public:
   LogicalResult verify();
 };
 
+/// VectorInsertElementOp inserts a scalar into a 1-D vector at a dynamic
+/// position, and returns the updated vector.  It is the counterpart of the
+/// "extract_element" op of the standard dialect.
+///
+/// Example:
+///
+/// ```mlir
+///   %1 = vector.insert_element %f, %0[%i] : vector<8xf32>
+/// ```
+class VectorInsertElementOp
+    : public Op<VectorInsertElementOp, OpTrait::NOperands<3>::Impl,
+                OpTrait::OneResult, OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.insert_element"; }
+  static void build(Builder *builder, OperationState *result, Value *value,
+                    Value *vector, Value *position);
+  Value *getValue() { return getOperand(0); }
+  Value *getVector() { return getOperand(1); }
+  Value *getPosition() { return getOperand(2); }
+  VectorType getVectorType() {
+    return getVector()->getType().cast<VectorType>();
+  }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
+/// VectorShuffleOp builds a 1-D vector from the elements of two 1-D vectors of
+/// the same type.  The "mask" attribute lists, for each element of the result,
+/// the position of its source element in the concatenation of both operands.
+///
+/// Example:
+///
+/// ```mlir
+///   %2 = vector.shuffle %0, %1 {mask: [0, 4, 1, 5]} : vector<4xf32>
+/// ```
+class VectorShuffleOp
+    : public Op<VectorShuffleOp, OpTrait::NOperands<2>::Impl,
+                OpTrait::OneResult, OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.shuffle"; }
+  static StringRef getMaskAttrName() { return "mask"; }
+  static void build(Builder *builder, OperationState *result, Value *v1,
+                    Value *v2, ArrayRef<int64_t> mask);
+  VectorType getVectorType() {
+    return getOperand(0)->getType().cast<VectorType>();
+  }
+  ArrayAttr getMask() { return getAttrOfType<ArrayAttr>(getMaskAttrName()); }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
+/// VectorReduceOp combines all the elements of a 1-D vector into a scalar of
+/// its element type.  The "kind" of the reduction is one of "add", "mul",
+/// "min" and "max", or one of "and", "or" and "xor" for integer vectors.
+/// Integers are compared as signed values.  The elements are combined in an
+/// unspecified order, so floating-point reductions are reassociated.
+///
+/// Example:
+///
+/// ```mlir
+///   %1 = vector.reduce "add", %0 : vector<8xf32>
+/// ```
+class VectorReduceOp
+    : public Op<VectorReduceOp, OpTrait::OneOperand, OpTrait::OneResult,
+                OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.reduce"; }
+  static StringRef getKindAttrName() { return "kind"; }
+  static void build(Builder *builder, OperationState *result, StringRef kind,
+                    Value *vector);
+  StringRef getKind() {
+    return getAttrOfType<StringAttr>(getKindAttrName()).getValue();
+  }
+  VectorType getVectorType() {
+    return getOperand()->getType().cast<VectorType>();
+  }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
+/// VectorBroadcastOp builds a vector whose elements are all equal to a scalar
+/// of its element type.  Unlike a splat constant, the scalar is an SSA value,
+/// e.g. a function argument or a value computed outside of a vectorized loop.
+///
+/// Example:
+///
+/// ```mlir
+///   %1 = vector.broadcast %f : f32, vector<4x8xf32>
+/// ```
+class VectorBroadcastOp
+    : public Op<VectorBroadcastOp, OpTrait::OneOperand, OpTrait::OneResult,
+                OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.broadcast"; }
+  static void build(Builder *builder, OperationState *result,
+                    VectorType vectorType, Value *value);
+  VectorType getVectorType() { return getType().cast<VectorType>(); }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
+/// VectorShapeCastOp reinterprets a vector as a vector of another shape with
+/// as many elements of the same type, in row-major order.  It changes the
+/// shape of a value in registers, e.g. between a super-vector and the 1-D
+/// vectors of the target, instead of storing and reloading it through a
+/// vector.type_cast memref.
+///
+/// Example:
+///
+/// ```mlir
+///   %1 = vector.shape_cast %0 : vector<4x8xf32>, vector<32xf32>
+/// ```
+class VectorShapeCastOp
+    : public Op<VectorShapeCastOp, OpTrait::OneOperand, OpTrait::OneResult,
+                OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.shape_cast"; }
+  static void build(Builder *builder, OperationState *result, Value *vector,
+                    VectorType resultType);
+  VectorType getSourceVectorType() {
+    return getOperand()->getType().cast<VectorType>();
+  }
+  VectorType getResultVectorType() { return getType().cast<VectorType>(); }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
+/// VectorOuterProductOp computes the outer product of two 1-D vectors, i.e.
+/// the 2-D vector whose element (i, j) is lhs[i] * rhs[j], and adds it to an
+/// optional accumulator of the same type.  It is the building block of the
+/// register-blocked matrix multiplication kernels: each step of the reduction
+/// updates a tile of the result held in registers with the outer product of a
+/// column of the LHS and a row of the RHS.  The accumulation is lowered to
+/// fused multiply-adds.
+///
+/// Example:
+///
+/// ```mlir
+///   %2 = vector.outerproduct %0, %1 : vector<4xf32>, vector<8xf32>
+///   %3 = vector.outerproduct %0, %1, %2 : vector<4xf32>, vector<8xf32>
+/// ```
+class VectorOuterProductOp
+    : public Op<VectorOuterProductOp, OpTrait::AtLeastNOperands<2>::Impl,
+                OpTrait::OneResult, OpTrait::HasNoSideEffect> {
+public:
+  using Op::Op;
+
+  static StringRef getOperationName() { return "vector.outerproduct"; }
+  static void build(Builder *builder, OperationState *result, Value *lhs,
+                    Value *rhs, Value *accumulator = nullptr);
+  Value *getLHS() { return getOperand(0); }
+  Value *getRHS() { return getOperand(1); }
+  /// Returns the accumulator, or null if there is none.
+  Value *getAccumulator() {
+    return getNumOperands() > 2 ? getOperand(2) : nullptr;
+  }
+  VectorType getLHSVectorType() {
+    return getLHS()->getType().cast<VectorType>();
+  }
+  VectorType getRHSVectorType() {
+    return getRHS()->getType().cast<VectorType>();
+  }
+  VectorType getResultVectorType() { return getType().cast<VectorType>(); }
+  static bool parse(OpAsmParser *parser, OperationState *result);
+  void print(OpAsmPrinter *p);
+  LogicalResult verify();
+};
+
 } // end namespace mlir
 
 #endif // MLIR_VECTOROPS_VECTOROPS_H
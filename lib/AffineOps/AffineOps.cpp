@@ -36,7 +36,7 @@ using llvm::dbgs;
 //===----------------------------------------------------------------------===//
 
 AffineOpsDialect::AffineOpsDialect(MLIRContext *context)
-    : Dialect(/*name=*/"affine", context) {
+    : Dialect(getDialectNamespace(), context) {
   addOperations<AffineApplyOp, AffineForOp, AffineIfOp, AffineTerminatorOp>();
 }
 
@@ -1210,14 +1210,20 @@ void mlir::extractForInductionVars(ArrayRef<AffineForOp> forInsts,
 
 void AffineIfOp::build(Builder *builder, OperationState *result,
                        IntegerSet condition,
-                       ArrayRef<Value *> conditionOperands) {
+                       ArrayRef<Value *> conditionOperands,
+                       bool withElseRegion) {
   result->addAttribute(getConditionAttrName(), IntegerSetAttr::get(condition));
   result->addOperands(conditionOperands);
 
-  // Reserve 2 regions, one for the 'then' and one for the 'else' regions.
+  // Reserve 2 regions, one for the 'then' and one for the 'else' regions. The
+  // latter is created even if it remains empty for the validity of the
+  // operation.
   result->regions.reserve(2);
-  result->addRegion(nullptr);
-  result->addRegion(nullptr);
+  Region *thenRegion = result->addRegion();
+  Region *elseRegion = result->addRegion();
+  ensureAffineTerminator(*thenRegion, *builder, result->location);
+  if (withElseRegion)
+    ensureAffineTerminator(*elseRegion, *builder, result->location);
 }
 
 LogicalResult AffineIfOp::verify() {
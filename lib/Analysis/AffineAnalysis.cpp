@@ -32,7 +32,9 @@
 #include "mlir/Support/MathExtras.h"
 #include "mlir/Support/STLExtras.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
 #define DEBUG_TYPE "affine-analysis"
@@ -41,6 +43,18 @@ using namespace mlir;
 
 using llvm::dbgs;
 
+STATISTIC(NumZIVIndependent,
+          "Number of access pairs shown independent by the ZIV test");
+STATISTIC(NumGCDIndependent,
+          "Number of access pairs shown independent by the GCD test");
+STATISTIC(NumRangeIndependent,
+          "Number of access pairs shown independent by the range test");
+STATISTIC(NumPolyhedralTests,
+          "Number of access pairs checked with a dependence polyhedron");
+STATISTIC(NumPolyhedralIndependent,
+          "Number of access pairs shown independent by a dependence "
+          "polyhedron");
+
 /// Returns the sequence of AffineApplyOp Operations operation in
 /// 'affineApplyOps', which are reachable via a search starting from 'operands',
 /// and ending at operands which are not defined by AffineApplyOps.
@@ -677,6 +691,129 @@ void MemRefAccess::getAccessMap(AffineValueMap *accessMap) const {
   accessMap->reset(map, operands);
 }
 
+// Computes in [lb, ub] the constant range of values that 'value' takes in the
+// iteration space, if 'value' is a constant or the induction variable of a
+// loop with constant bounds. Returns false otherwise.
+static bool getConstantValueRange(Value *value, int64_t &lb, int64_t &ub) {
+  if (auto *op = value->getDefiningOp()) {
+    if (auto constOp = op->dyn_cast<ConstantIndexOp>()) {
+      lb = ub = constOp.getValue();
+      return true;
+    }
+    return false;
+  }
+  auto forOp = getForInductionVarOwner(value);
+  if (!forOp || !forOp.hasConstantBounds())
+    return false;
+  lb = forOp.getConstantLowerBound();
+  ub = forOp.getConstantUpperBound() - 1;
+  return lb <= ub;
+}
+
+// Computes in [lb, ub] the constant range of the affine expression with the
+// coefficients 'coeffs' for 'operands' and the constant term 'constTerm'.
+// Returns false if an operand with a non-zero coefficient does not have a
+// constant range, or on overflow.
+static bool getConstantExprRange(ArrayRef<int64_t> coeffs, int64_t constTerm,
+                                 ArrayRef<Value *> operands, int64_t &lb,
+                                 int64_t &ub) {
+  lb = ub = constTerm;
+  bool overflow = false;
+  for (unsigned i = 0, e = operands.size(); i < e; ++i) {
+    int64_t coeff = coeffs[i];
+    if (coeff == 0)
+      continue;
+    int64_t operandLb, operandUb;
+    if (!getConstantValueRange(operands[i], operandLb, operandUb))
+      return false;
+    if (coeff < 0)
+      std::swap(operandLb, operandUb);
+    int64_t lbTerm, ubTerm;
+    overflow |= llvm::MulOverflow(coeff, operandLb, lbTerm);
+    overflow |= llvm::MulOverflow(coeff, operandUb, ubTerm);
+    overflow |= llvm::AddOverflow(lb, lbTerm, lb);
+    overflow |= llvm::AddOverflow(ub, ubTerm, ub);
+  }
+  return !overflow;
+}
+
+// Runs the cheap dependence tests on the access functions 'srcAccessMap' and
+// 'dstAccessMap', one result at a time. Returns true if one of the tests shows
+// that the accesses never access the same element, and false if they are
+// inconclusive. The tests are tried in increasing order of cost:
+// *) ZIV (zero index variable): both results are constants, which differ.
+// *) GCD: the difference of the constant terms is not a multiple of the
+//    greatest common divisor of the coefficients of the operands, so that the
+//    results are never equal for integer operands.
+// *) Range: the results have constant ranges given the constant loop bounds,
+//    and these ranges are disjoint.
+// All the operands are treated as independent integers, which over-approximates
+// the set of dependent iterations. In particular, SIV (single index variable)
+// accesses are covered by the GCD test for the divisibility of the dependence
+// distance and by the range test for its magnitude.
+static bool isIndependentByCheapTests(const AffineValueMap &srcAccessMap,
+                                      const AffineValueMap &dstAccessMap) {
+  if (srcAccessMap.getNumResults() == 0)
+    return false;
+  std::vector<SmallVector<int64_t, 8>> srcFlatExprs, dstFlatExprs;
+  if (failed(getFlattenedAffineExprs(srcAccessMap.getAffineMap(),
+                                     &srcFlatExprs)) ||
+      failed(getFlattenedAffineExprs(dstAccessMap.getAffineMap(),
+                                     &dstFlatExprs)))
+    return false;
+
+  // Returns true if 'flatExpr' has a non-zero coefficient for one of the local
+  // identifiers introduced for mod's and div's, which follow the operands.
+  auto hasLocalTerms = [](ArrayRef<int64_t> flatExpr, unsigned numOperands) {
+    return llvm::any_of(flatExpr.drop_back().drop_front(numOperands),
+                        [](int64_t coeff) { return coeff != 0; });
+  };
+
+  ArrayRef<Value *> srcOperands = srcAccessMap.getOperands();
+  ArrayRef<Value *> dstOperands = dstAccessMap.getOperands();
+  for (unsigned r = 0, e = srcFlatExprs.size(); r < e; ++r) {
+    ArrayRef<int64_t> srcExpr = srcFlatExprs[r];
+    ArrayRef<int64_t> dstExpr = dstFlatExprs[r];
+    if (hasLocalTerms(srcExpr, srcOperands.size()) ||
+        hasLocalTerms(dstExpr, dstOperands.size()))
+      continue;
+    // Drop the zero coefficients of the local identifiers.
+    srcExpr = srcExpr.take_front(srcOperands.size());
+    dstExpr = dstExpr.take_front(dstOperands.size());
+    int64_t srcConst = srcFlatExprs[r].back();
+    int64_t dstConst = dstFlatExprs[r].back();
+
+    int64_t gcd = 0;
+    for (int64_t coeff : srcExpr)
+      gcd = llvm::GreatestCommonDivisor64(gcd, std::abs(coeff));
+    for (int64_t coeff : dstExpr)
+      gcd = llvm::GreatestCommonDivisor64(gcd, std::abs(coeff));
+    int64_t constDiff;
+    if (llvm::SubOverflow(dstConst, srcConst, constDiff))
+      continue;
+    if (gcd == 0) {
+      if (constDiff != 0) {
+        ++NumZIVIndependent;
+        return true;
+      }
+      continue;
+    }
+    if (constDiff % gcd != 0) {
+      ++NumGCDIndependent;
+      return true;
+    }
+
+    int64_t srcLb, srcUb, dstLb, dstUb;
+    if (getConstantExprRange(srcExpr, srcConst, srcOperands, srcLb, srcUb) &&
+        getConstantExprRange(dstExpr, dstConst, dstOperands, dstLb, dstUb) &&
+        (srcUb < dstLb || dstUb < srcLb)) {
+      ++NumRangeIndependent;
+      return true;
+    }
+  }
+  return false;
+}
+
 // Builds a flat affine constraint system to check if there exists a dependence
 // between memref accesses 'srcAccess' and 'dstAccess'.
 // Returns 'false' if the accesses can be definitively shown not to access the
@@ -690,6 +827,9 @@ void MemRefAccess::getAccessMap(AffineValueMap *accessMap) const {
 //    using AffineValueMaps initialized with the indices from an access, then
 //    composed with AffineApplyOps reachable from operands of that access,
 //    until operands of the AffineValueMap are loop IVs or symbols.
+// *) Try the cheap ZIV, GCD and range tests on the access functions (see
+//    isIndependentByCheapTests), which return early when they show that the
+//    accesses are independent.
 // *) Build iteration domain constraints for each access. Iteration domain
 //    constraints are pairs of inequality contraints representing the
 //    upper/lower loop bounds for each AffineForOp in the loop nest associated
@@ -788,6 +928,12 @@ bool mlir::checkMemrefAccessDependence(
   AffineValueMap dstAccessMap;
   dstAccess.getAccessMap(&dstAccessMap);
 
+  // Avoid building the dependence polyhedron when a cheaper test suffices.
+  if (isIndependentByCheapTests(srcAccessMap, dstAccessMap)) {
+    LLVM_DEBUG(llvm::dbgs() << "Independent by the cheap tests\n");
+    return false;
+  }
+
   // Get iteration domain for the 'srcAccess' operation.
   FlatAffineConstraints srcDomain;
   if (failed(getInstIndexSet(srcAccess.opInst, &srcDomain)))
@@ -838,7 +984,9 @@ bool mlir::checkMemrefAccessDependence(
                        dependenceConstraints);
 
   // Return false if the solution space is empty: no dependence.
+  ++NumPolyhedralTests;
   if (dependenceConstraints->isEmpty()) {
+    ++NumPolyhedralIndependent;
     return false;
   }
 
@@ -852,3 +1000,52 @@ bool mlir::checkMemrefAccessDependence(
   LLVM_DEBUG(dependenceConstraints->dump());
   return true;
 }
+
+bool DependenceAnalysis::checkDependence(
+    Operation *srcOpInst, Operation *dstOpInst, unsigned loopDepth,
+    llvm::SmallVector<DependenceComponent, 2> *dependenceComponents,
+    bool allowRAR) {
+  Key key = {{srcOpInst, dstOpInst}, 2 * loopDepth + allowRAR};
+  auto it = cache.find(key);
+  bool isCached = it != cache.end() &&
+                  (!dependenceComponents || it->second.hasComponents);
+  if (isCached) {
+    if (dependenceComponents)
+      *dependenceComponents = it->second.components;
+    return it->second.hasDependence;
+  }
+
+  // Compute the components along with the dependence when they are requested,
+  // so that the later queries for the same pair can be answered either way.
+  MemRefAccess srcAccess(srcOpInst);
+  MemRefAccess dstAccess(dstOpInst);
+  FlatAffineConstraints dependenceConstraints;
+  Result &result = cache[key];
+  result.components.clear();
+  result.hasComponents = dependenceComponents != nullptr;
+  result.hasDependence = checkMemrefAccessDependence(
+      srcAccess, dstAccess, loopDepth, &dependenceConstraints,
+      dependenceComponents ? &result.components : nullptr, allowRAR);
+  if (dependenceComponents)
+    *dependenceComponents = result.components;
+  return result.hasDependence;
+}
+
+// Returns true if 'op' is 'ancestor' or is nested in its regions.
+static bool isNestedIn(Operation *op, Operation *ancestor) {
+  for (; op; op = op->getParentOp())
+    if (op == ancestor)
+      return true;
+  return false;
+}
+
+void DependenceAnalysis::invalidate(Operation *op) {
+  SmallVector<Key, 8> staleKeys;
+  for (auto &entry : cache) {
+    auto accesses = entry.first.first;
+    if (isNestedIn(accesses.first, op) || isNestedIn(accesses.second, op))
+      staleKeys.push_back(entry.first);
+  }
+  for (auto &key : staleKeys)
+    cache.erase(key);
+}
@@ -20,6 +20,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/AffineStructures.h"
+#include "mlir/Analysis/Simplex.h"
 #include "mlir/AffineOps/AffineOps.h"
 #include "mlir/IR/AffineExprVisitor.h"
 #include "mlir/IR/AffineMap.h"
@@ -30,7 +31,9 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 
 #define DEBUG_TYPE "affine-structures"
 
@@ -74,6 +77,57 @@ private:
 
 } // end anonymous namespace
 
+//===----------------------------------------------------------------------===//
+// FlatAffineConstraintsStats.
+//===----------------------------------------------------------------------===//
+
+namespace {
+// The counters behind getFlatAffineConstraintsStats.  They are updated with
+// relaxed atomics since the analyses run on several threads.
+struct AtomicStats {
+  std::atomic<uint64_t> numGaussianEliminations{0};
+  std::atomic<uint64_t> numFourierMotzkinEliminations{0};
+  std::atomic<uint64_t> numEmptinessChecks{0};
+  std::atomic<uint64_t> maxNumConstraints{0};
+};
+} // end anonymous namespace
+
+static AtomicStats stats;
+
+// Add `value` to `counter`.
+static void addToStat(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Raise `counter` to `value` if it is lower.
+static void maxToStat(std::atomic<uint64_t> &counter, uint64_t value) {
+  uint64_t current = counter.load(std::memory_order_relaxed);
+  while (current < value &&
+         !counter.compare_exchange_weak(current, value,
+                                        std::memory_order_relaxed))
+    ;
+}
+
+FlatAffineConstraintsStats mlir::getFlatAffineConstraintsStats() {
+  FlatAffineConstraintsStats result;
+  result.numGaussianEliminations =
+      stats.numGaussianEliminations.load(std::memory_order_relaxed);
+  result.numFourierMotzkinEliminations =
+      stats.numFourierMotzkinEliminations.load(std::memory_order_relaxed);
+  result.numEmptinessChecks =
+      stats.numEmptinessChecks.load(std::memory_order_relaxed);
+  result.maxNumConstraints =
+      stats.maxNumConstraints.load(std::memory_order_relaxed);
+  return result;
+}
+
+void mlir::resetFlatAffineConstraintsStats() {
+  stats.numGaussianEliminations.store(0, std::memory_order_relaxed);
+  stats.numFourierMotzkinEliminations.store(0, std::memory_order_relaxed);
+  stats.numEmptinessChecks.store(0, std::memory_order_relaxed);
+  stats.maxNumConstraints.store(0, std::memory_order_relaxed);
+}
+
 // Flattens the expressions in map. Returns failure if 'expr' was unable to be
 // flattened (i.e., semi-affine expressions not handled yet).
 static LogicalResult getFlattenedAffineExprs(
@@ -147,6 +201,15 @@ LogicalResult mlir::getFlattenedAffineExprs(
                                    localVarCst);
 }
 
+IntegerSet mlir::simplifyIntegerSet(IntegerSet set) {
+  return getMemoizedSimplifiedSet(set, [&]() -> IntegerSet {
+    if (FlatAffineConstraints(set).isEmpty())
+      return IntegerSet::getEmptySet(set.getNumDims(), set.getNumSymbols(),
+                                     set.getContext());
+    return set;
+  });
+}
+
 //===----------------------------------------------------------------------===//
 // MutableAffineMap.
 //===----------------------------------------------------------------------===//
@@ -422,11 +485,15 @@ void FlatAffineConstraints::addId(IdKind kind, unsigned pos, Value *id) {
 
   unsigned oldNumReservedCols = numReservedCols;
 
-  // Check if a resize is necessary.
+  // Check if a resize is necessary. The reserved columns grow geometrically so
+  // that adding identifiers one at a time doesn't relayout the coefficient
+  // buffers each time.
   if (getNumCols() + 1 > numReservedCols) {
-    equalities.resize(getNumEqualities() * (getNumCols() + 1));
-    inequalities.resize(getNumInequalities() * (getNumCols() + 1));
-    numReservedCols++;
+    unsigned newNumReservedCols =
+        std::max(getNumCols() + 1, 2 * numReservedCols);
+    equalities.resize(getNumEqualities() * newNumReservedCols);
+    inequalities.resize(getNumInequalities() * newNumReservedCols);
+    numReservedCols = newNumReservedCols;
   }
 
   unsigned absolutePos;
@@ -890,9 +957,23 @@ bool FlatAffineConstraints::hasInvalidConstraint() const {
   return check(/*isEq=*/false);
 }
 
+// Returns a * b + c * d, and sets 'overflow' if any of the intermediate results
+// does not fit in 64 bits.
+static int64_t mulAdd(int64_t a, int64_t b, int64_t c, int64_t d,
+                      bool &overflow) {
+  int64_t ab, cd, result;
+  overflow |= llvm::MulOverflow(a, b, ab);
+  overflow |= llvm::MulOverflow(c, d, cd);
+  overflow |= llvm::AddOverflow(ab, cd, result);
+  return result;
+}
+
 // Eliminate identifier from constraint at 'rowIdx' based on coefficient at
 // pivotRow, pivotCol. Columns in range [elimColStart, pivotCol) will not be
-// updated as they have already been eliminated.
+// updated as they have already been eliminated. If a coefficient of the
+// resulting constraint overflows, the constraint is replaced by the trivially
+// true 0 >= 0 (or 0 == 0), i.e., it is dropped; this over-approximates the set,
+// which is the conservative direction for the users of the eliminations.
 static void eliminateFromConstraint(FlatAffineConstraints *constraints,
                                     unsigned rowIdx, unsigned pivotRow,
                                     unsigned pivotCol, unsigned elimColStart,
@@ -914,15 +995,25 @@ static void eliminateFromConstraint(FlatAffineConstraints *constraints,
   int64_t rowMultiplier = lcm / std::abs(leadCoeff);
 
   unsigned numCols = constraints->getNumCols();
+  SmallVector<int64_t, 8> newRow(numCols, 0);
+  bool overflow = false;
   for (unsigned j = 0; j < numCols; ++j) {
     // Skip updating column 'j' if it was just eliminated.
     if (j >= elimColStart && j < pivotCol)
-      continue;
-    int64_t v = pivotMultiplier * constraints->atEq(pivotRow, j) +
-                rowMultiplier * at(rowIdx, j);
-    isEq ? constraints->atEq(rowIdx, j) = v
-         : constraints->atIneq(rowIdx, j) = v;
+      newRow[j] = at(rowIdx, j);
+    else
+      newRow[j] = mulAdd(pivotMultiplier, constraints->atEq(pivotRow, j),
+                         rowMultiplier, at(rowIdx, j), overflow);
+  }
+  if (overflow) {
+    LLVM_DEBUG(llvm::dbgs() << "overflow during elimination, dropping "
+                            << (isEq ? "equality " : "inequality ") << rowIdx
+                            << "\n");
+    std::fill(newRow.begin(), newRow.end(), 0);
   }
+  for (unsigned j = 0; j < numCols; ++j)
+    isEq ? constraints->atEq(rowIdx, j) = newRow[j]
+         : constraints->atIneq(rowIdx, j) = newRow[j];
 }
 
 // Remove coefficients in column range [colStart, colLimit) in place.
@@ -1027,14 +1118,28 @@ static unsigned getBestIdToEliminate(const FlatAffineConstraints &cst,
   return minLoc;
 }
 
-// Checks for emptiness of the set by eliminating identifiers successively and
-// using the GCD test (on all equality constraints) and checking for trivially
-// invalid constraints. Returns 'true' if the constraint system is found to be
-// empty; false otherwise.
+// Checks for emptiness of the set with the simplex method: the set is empty if
+// it has no rational point, and otherwise a bounded branch and bound search
+// looks for an integer point. When the search is inconclusive, the emptiness is
+// checked by eliminating identifiers successively and using the GCD test (on
+// all equality constraints) and checking for trivially invalid constraints.
+// Returns 'true' if the constraint system is found to be empty; false
+// otherwise.
 bool FlatAffineConstraints::isEmpty() const {
+  addToStat(stats.numEmptinessChecks, 1);
   if (isEmptyByGCDTest() || hasInvalidConstraint())
     return true;
 
+  Simplex simplex(*this);
+  if (!simplex.hasOverflowed()) {
+    if (simplex.isEmpty())
+      return true;
+    Optional<bool> isIntegerEmpty =
+        simplex.isIntegerEmpty(kMaxBranchAndBoundNodes);
+    if (isIntegerEmpty.hasValue())
+      return isIntegerEmpty.getValue();
+  }
+
   // First, eliminate as many identifiers as possible using Gaussian
   // elimination.
   FlatAffineConstraints tmpCst(*this);
@@ -1176,6 +1281,7 @@ unsigned FlatAffineConstraints::gaussianEliminateIds(unsigned posStart,
   posLimit = pivotCol;
   // Remove eliminated columns from all constraints.
   removeIdRange(posStart, posLimit);
+  addToStat(stats.numGaussianEliminations, posLimit - posStart);
   return posLimit - posStart;
 }
 
@@ -1984,6 +2090,38 @@ void FlatAffineConstraints::constantFoldIdRange(unsigned pos, unsigned num) {
 //       s0 + s1 + 16 <= d0 <= s0 + s1 + 31, returns 16.
 //       s0 - 7 <= 8*j <= s0 returns 1 with lb = s0, lbDivisor = 8 (since lb =
 //       ceil(s0 - 7 / 8) = floor(s0 / 8)).
+// Computes the extent of the pos^th identifier of 'cst' from its rational
+// minimum and maximum. This is only done in the absence of symbolic
+// identifiers, since the extent is then a constant. Returns None if 'cst' has
+// symbolic identifiers, or if the identifier is unbounded.
+static Optional<int64_t>
+getConstantBoundOnDimSizeBySimplex(const FlatAffineConstraints &cst,
+                                   unsigned pos, SmallVectorImpl<int64_t> *lb,
+                                   int64_t *lbFloorDivisor,
+                                   SmallVectorImpl<int64_t> *ub) {
+  if (cst.getNumSymbolIds() != 0)
+    return None;
+  Simplex simplex(cst);
+  if (simplex.hasOverflowed() || simplex.isEmpty())
+    return None;
+  SmallVector<int64_t, 8> coeffs(cst.getNumCols(), 0);
+  coeffs[pos] = 1;
+  auto min = simplex.computeOptimum(Simplex::Direction::Down, coeffs);
+  auto max = simplex.computeOptimum(Simplex::Direction::Up, coeffs);
+  if (!min || !max)
+    return None;
+  int64_t lbConst = min->ceil(), ubConst = max->floor();
+  if (lb) {
+    lb->assign(1, lbConst);
+    assert(lbFloorDivisor &&
+           "both lb and divisor or none should be provided");
+    *lbFloorDivisor = 1;
+    if (ub)
+      ub->assign(1, ubConst);
+  }
+  return std::max<int64_t>(ubConst - lbConst + 1, 0);
+}
+
 Optional<int64_t> FlatAffineConstraints::getConstantBoundOnDimSize(
     unsigned pos, SmallVectorImpl<int64_t> *lb, int64_t *lbFloorDivisor,
     SmallVectorImpl<int64_t> *ub) const {
@@ -2028,8 +2166,9 @@ Optional<int64_t> FlatAffineConstraints::getConstantBoundOnDimSize(
       break;
   }
   if (r == e)
-    // If it doesn't, there isn't a bound on it.
-    return None;
+    // If it doesn't, it may still be bounded through the other identifiers.
+    return getConstantBoundOnDimSizeBySimplex(*this, pos, lb, lbFloorDivisor,
+                                              ub);
 
   // Positions of constraints that are lower/upper bounds on the variable.
   SmallVector<unsigned, 4> lbIndices, ubIndices;
@@ -2108,6 +2247,10 @@ Optional<int64_t> FlatAffineConstraints::getConstantBoundOnDimSize(
     // the constant term for the lower bound.
     (*lb)[getNumSymbolIds()] += atIneq(minLbPosition, pos) - 1;
   }
+  if (!minDiff.hasValue())
+    // The bounds may still follow from a combination of the constraints.
+    return getConstantBoundOnDimSizeBySimplex(*this, pos, lb, lbFloorDivisor,
+                                              ub);
   return minDiff;
 }
 
@@ -2169,14 +2312,39 @@ FlatAffineConstraints::computeConstantLowerOrUpperBound(unsigned pos) {
   return minOrMaxConst;
 }
 
+// Computes the constant lower or upper bound of the pos^th identifier of 'cst'
+// from its rational minimum or maximum. Returns false if the simplex method is
+// inconclusive, i.e., if the constraints are empty or overflow its arithmetic.
+static bool computeConstantBoundBySimplex(const FlatAffineConstraints &cst,
+                                          unsigned pos, bool isLower,
+                                          Optional<int64_t> &bound) {
+  Simplex simplex(cst);
+  if (simplex.hasOverflowed() || simplex.isEmpty())
+    return false;
+  SmallVector<int64_t, 8> coeffs(cst.getNumCols(), 0);
+  coeffs[pos] = 1;
+  auto optimum = simplex.computeOptimum(
+      isLower ? Simplex::Direction::Down : Simplex::Direction::Up, coeffs);
+  bound = None;
+  if (optimum)
+    bound = isLower ? optimum->ceil() : optimum->floor();
+  return true;
+}
+
 Optional<int64_t>
 FlatAffineConstraints::getConstantLowerBound(unsigned pos) const {
+  Optional<int64_t> bound;
+  if (computeConstantBoundBySimplex(*this, pos, /*isLower=*/true, bound))
+    return bound;
   FlatAffineConstraints tmpCst(*this);
   return tmpCst.computeConstantLowerOrUpperBound</*isLower=*/true>(pos);
 }
 
 Optional<int64_t>
 FlatAffineConstraints::getConstantUpperBound(unsigned pos) const {
+  Optional<int64_t> bound;
+  if (computeConstantBoundBySimplex(*this, pos, /*isLower=*/false, bound))
+    return bound;
   FlatAffineConstraints tmpCst(*this);
   return tmpCst.computeConstantLowerOrUpperBound</*isLower=*/false>(pos);
 }
@@ -2427,6 +2595,9 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
     return;
   }
 
+  addToStat(stats.numFourierMotzkinEliminations, 1);
+  maxToStat(stats.maxNumConstraints, getNumConstraints());
+
   // Positions of constraints that are lower bounds on the variable.
   SmallVector<unsigned, 4> lbIndices;
   // Positions of constraints that are lower bounds on the variable.
@@ -2470,7 +2641,7 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
   assert(newFac.getIds().size() == newFac.getNumIds());
 
   // This will be used to check if the elimination was integer exact.
-  unsigned lcmProducts = 1;
+  bool allLcmsAreOne = true;
 
   // Let x be the variable we are eliminating.
   // For each lower bound, lb <= c_l*x, and each upper bound c_u*x <= ub, (note
@@ -2482,6 +2653,9 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
   // constraint correspond to integer points in the original system (i.e., they
   // have integer pre-images). Hence, if the lcm's are all 1, the elimination is
   // integer exact.
+  // A combination whose coefficients overflow is dropped, which
+  // over-approximates the projection.
+  unsigned numDropped = 0;
   for (auto ubPos : ubIndices) {
     for (auto lbPos : lbIndices) {
       SmallVector<int64_t, 4> ineq;
@@ -2491,20 +2665,28 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
       // coefficient in the canonical form as the view taken here is that of the
       // term being moved to the other size of '>='.
       int64_t ubCoeff = -atIneq(ubPos, pos);
+      assert(lbCoeff >= 1 && ubCoeff >= 1 && "bounds wrongly identified");
+      int64_t lcm = mlir::lcm(lbCoeff, ubCoeff);
+      allLcmsAreOne &= lcm == 1;
+      bool overflow = false;
       // TODO(bondhugula): refactor this loop to avoid all branches inside.
       for (unsigned l = 0, e = getNumCols(); l < e; l++) {
         if (l == pos)
           continue;
-        assert(lbCoeff >= 1 && ubCoeff >= 1 && "bounds wrongly identified");
-        int64_t lcm = mlir::lcm(lbCoeff, ubCoeff);
-        ineq.push_back(atIneq(ubPos, l) * (lcm / ubCoeff) +
-                       atIneq(lbPos, l) * (lcm / lbCoeff));
-        lcmProducts *= lcm;
+        ineq.push_back(mulAdd(atIneq(ubPos, l), lcm / ubCoeff,
+                              atIneq(lbPos, l), lcm / lbCoeff, overflow));
       }
       if (darkShadow) {
         // The dark shadow is a convex subset of the exact integer shadow. If
         // there is a point here, it proves the existence of a solution.
-        ineq[ineq.size() - 1] += lbCoeff * ubCoeff - lbCoeff - ubCoeff + 1;
+        int64_t shift = mulAdd(lbCoeff, ubCoeff, -1, lbCoeff + ubCoeff - 1,
+                               overflow);
+        overflow |= llvm::AddOverflow(ineq.back(), shift, ineq.back());
+      }
+      if (overflow) {
+        LLVM_DEBUG(llvm::dbgs() << "FM combination overflowed, dropping it\n");
+        ++numDropped;
+        continue;
       }
       // TODO: we need to have a way to add inequalities in-place in
       // FlatAffineConstraints instead of creating and copying over.
@@ -2512,7 +2694,7 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
     }
   }
 
-  if (lcmProducts == 1 && isResultIntegerExact)
+  if (allLcmsAreOne && numDropped == 0 && isResultIntegerExact)
     *isResultIntegerExact = 1;
 
   // Copy over the constraints not involving this variable.
@@ -2527,8 +2709,10 @@ void FlatAffineConstraints::FourierMotzkinEliminate(
     newFac.addInequality(ineq);
   }
 
-  assert(newFac.getNumConstraints() ==
+  assert(newFac.getNumConstraints() + numDropped ==
          lbIndices.size() * ubIndices.size() + nbIndices.size());
+  maxToStat(stats.maxNumConstraints,
+            newFac.getNumConstraints() + getNumEqualities());
 
   // Copy over the equalities.
   for (unsigned r = 0, e = getNumEqualities(); r < e; r++) {
@@ -22,6 +22,7 @@
 
 #include "mlir/Analysis/Dominance.h"
 #include "mlir/IR/Operation.h"
+#include "llvm/ADT/MapVector.h"
 #include "llvm/Support/GenericDomTreeConstruction.h"
 using namespace mlir;
 using namespace mlir::detail;
@@ -58,6 +59,44 @@ void DominanceInfoBase<IsPostDom>::recalculate(Function *function) {
   });
 }
 
+/// Recalculate the dominance info of a single region.
+template <bool IsPostDom>
+void DominanceInfoBase<IsPostDom>::recalculate(Region *region) {
+  // Empty regions have no dominance info.
+  if (region->empty()) {
+    dominanceInfos.erase(region);
+    return;
+  }
+  auto regionDominance = llvm::make_unique<base>();
+  regionDominance->recalculate(*region);
+  dominanceInfos[region] = std::move(regionDominance);
+}
+
+/// Update the dominance info after the given edges were inserted in or deleted
+/// from the CFG.
+template <bool IsPostDom>
+void DominanceInfoBase<IsPostDom>::applyUpdates(
+    ArrayRef<UpdateType> updates) {
+  // Group the updates by region, keeping their order within each region.
+  llvm::SmallMapVector<Region *, SmallVector<UpdateType, 4>, 1> regionUpdates;
+  for (auto &update : updates) {
+    auto *region = update.getFrom()->getParent();
+    assert(region == update.getTo()->getParent() &&
+           "expected an update between blocks of the same region");
+    regionUpdates[region].push_back(update);
+  }
+
+  for (auto &it : regionUpdates) {
+    // A region that was empty when the dominance info was computed has no
+    // dominator tree to update, so it is computed from scratch.
+    auto infoIt = dominanceInfos.find(it.first);
+    if (infoIt == dominanceInfos.end())
+      recalculate(it.first);
+    else
+      infoIt->second->applyUpdates(it.second);
+  }
+}
+
 /// Return true if the specified block A properly dominates block B.
 template <bool IsPostDom>
 bool DominanceInfoBase<IsPostDom>::properlyDominates(Block *a, Block *b) {
@@ -0,0 +1,362 @@
+//===- IntegerRangeAnalysis.cpp - Ranges of index values ------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the analysis of the ranges of index values.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/IntegerRangeAnalysis.h"
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Support/MathExtras.h"
+#include <algorithm>
+#include <limits>
+
+using namespace mlir;
+
+using Bound = Optional<int64_t>;
+
+IntegerRange IntegerRange::getConstant(int64_t value) {
+  IntegerRange range;
+  range.lower = value;
+  range.upper = value;
+  return range;
+}
+
+IntegerRange IntegerRange::getSelf(Value *value) {
+  IntegerRange range;
+  range.symbolicLower = SymbolicBound{value, 0};
+  range.symbolicUpper = SymbolicBound{value, 0};
+  return range;
+}
+
+// Returns 'lhs + rhs', or None if either is unknown or if the sum overflows.
+static Bound addBounds(Bound lhs, Bound rhs) {
+  if (!lhs || !rhs)
+    return llvm::None;
+  if ((*rhs > 0 && *lhs > std::numeric_limits<int64_t>::max() - *rhs) ||
+      (*rhs < 0 && *lhs < std::numeric_limits<int64_t>::min() - *rhs))
+    return llvm::None;
+  return *lhs + *rhs;
+}
+
+// Returns 'lhs * rhs', or None if either is unknown or if the product
+// overflows.
+static Bound mulBounds(Bound lhs, Bound rhs) {
+  if (!lhs || !rhs)
+    return llvm::None;
+  if (*lhs == 0 || *rhs == 0)
+    return 0;
+  auto min = std::numeric_limits<int64_t>::min();
+  if ((*lhs == -1 && *rhs == min) || (*rhs == -1 && *lhs == min))
+    return llvm::None;
+  // The product is computed on unsigned values, which wrap around.
+  auto product = static_cast<int64_t>(static_cast<uint64_t>(*lhs) *
+                                      static_cast<uint64_t>(*rhs));
+  if (product / *rhs != *lhs)
+    return llvm::None;
+  return product;
+}
+
+// Returns 'bound' shifted by 'offset', or None if either is unknown.
+static Optional<SymbolicBound> shift(Optional<SymbolicBound> bound,
+                                     Bound offset) {
+  if (!bound)
+    return llvm::None;
+  auto sum = addBounds(bound->offset, offset);
+  if (!sum)
+    return llvm::None;
+  return SymbolicBound{bound->symbol, *sum};
+}
+
+static IntegerRange add(const IntegerRange &lhs, const IntegerRange &rhs) {
+  IntegerRange result;
+  result.lower = addBounds(lhs.lower, rhs.lower);
+  result.upper = addBounds(lhs.upper, rhs.upper);
+  // A symbolic bound can only be shifted by a constant bound of the other side.
+  result.symbolicLower = shift(lhs.symbolicLower, rhs.lower);
+  if (!result.symbolicLower)
+    result.symbolicLower = shift(rhs.symbolicLower, lhs.lower);
+  result.symbolicUpper = shift(lhs.symbolicUpper, rhs.upper);
+  if (!result.symbolicUpper)
+    result.symbolicUpper = shift(rhs.symbolicUpper, lhs.upper);
+  return result;
+}
+
+static IntegerRange mul(const IntegerRange &range, int64_t factor) {
+  if (factor == 1)
+    return range;
+  if (factor == 0)
+    return IntegerRange::getConstant(0);
+  IntegerRange result;
+  auto lower = mulBounds(range.lower, factor);
+  auto upper = mulBounds(range.upper, factor);
+  result.lower = factor >= 0 ? lower : upper;
+  result.upper = factor >= 0 ? upper : lower;
+  return result;
+}
+
+static IntegerRange mul(const IntegerRange &lhs, const IntegerRange &rhs) {
+  if (rhs.isConstant())
+    return mul(lhs, *rhs.lower);
+  if (lhs.isConstant())
+    return mul(rhs, *lhs.lower);
+
+  IntegerRange result;
+  if (lhs.lower && lhs.upper && rhs.lower && rhs.upper) {
+    // The extrema of the product are products of the bounds.
+    Bound products[] = {
+        mulBounds(lhs.lower, rhs.lower), mulBounds(lhs.lower, rhs.upper),
+        mulBounds(lhs.upper, rhs.lower), mulBounds(lhs.upper, rhs.upper)};
+    if (llvm::all_of(products, [](Bound b) { return b.hasValue(); })) {
+      result.lower = result.upper = products[0];
+      for (auto product : products) {
+        result.lower = std::min(*result.lower, *product);
+        result.upper = std::max(*result.upper, *product);
+      }
+    }
+  } else if (lhs.lower && rhs.lower && *lhs.lower >= 0 && *rhs.lower >= 0) {
+    result.lower = mulBounds(lhs.lower, rhs.lower);
+  }
+  return result;
+}
+
+static IntegerRange floorDiv(const IntegerRange &range, int64_t divisor) {
+  if (divisor == 1)
+    return range;
+  IntegerRange result;
+  if (divisor <= 0)
+    return result;
+  if (range.lower)
+    result.lower = mlir::floorDiv(*range.lower, divisor);
+  if (range.upper)
+    result.upper = mlir::floorDiv(*range.upper, divisor);
+  return result;
+}
+
+static IntegerRange ceilDiv(const IntegerRange &range, int64_t divisor) {
+  if (divisor == 1)
+    return range;
+  IntegerRange result;
+  if (divisor <= 0)
+    return result;
+  if (range.lower)
+    result.lower = mlir::ceilDiv(*range.lower, divisor);
+  if (range.upper)
+    result.upper = mlir::ceilDiv(*range.upper, divisor);
+  return result;
+}
+
+static IntegerRange mod(const IntegerRange &range, int64_t divisor) {
+  if (divisor <= 0)
+    return IntegerRange();
+  if (range.isWithin(0, divisor - 1))
+    return range;
+  IntegerRange result;
+  result.lower = 0;
+  result.upper = divisor - 1;
+  return result;
+}
+
+// Returns the range of 'expr' evaluated on values in 'operands', which are the
+// ranges of its dims then of its symbols.
+static IntegerRange evaluate(AffineExpr expr, ArrayRef<IntegerRange> operands,
+                             unsigned numDims) {
+  switch (expr.getKind()) {
+  case AffineExprKind::Constant:
+    return IntegerRange::getConstant(
+        expr.cast<AffineConstantExpr>().getValue());
+  case AffineExprKind::DimId:
+    return operands[expr.cast<AffineDimExpr>().getPosition()];
+  case AffineExprKind::SymbolId:
+    return operands[numDims + expr.cast<AffineSymbolExpr>().getPosition()];
+  default:
+    break;
+  }
+
+  auto binaryExpr = expr.cast<AffineBinaryOpExpr>();
+  auto lhs = evaluate(binaryExpr.getLHS(), operands, numDims);
+  auto rhs = evaluate(binaryExpr.getRHS(), operands, numDims);
+  if (expr.getKind() == AffineExprKind::Add)
+    return add(lhs, rhs);
+  if (expr.getKind() == AffineExprKind::Mul)
+    return mul(lhs, rhs);
+  // Only divisions and modulos by constants are affine.
+  if (!rhs.isConstant())
+    return IntegerRange();
+  switch (expr.getKind()) {
+  case AffineExprKind::FloorDiv:
+    return floorDiv(lhs, *rhs.lower);
+  case AffineExprKind::CeilDiv:
+    return ceilDiv(lhs, *rhs.lower);
+  case AffineExprKind::Mod:
+    return mod(lhs, *rhs.lower);
+  default:
+    llvm_unreachable("unexpected affine expression kind");
+  }
+}
+
+// Appends to 'dependences' the values the range of 'value' is computed from.
+static void getDependences(Value *value,
+                           SmallVectorImpl<Value *> &dependences) {
+  if (auto forOp = getForInductionVarOwner(value)) {
+    auto lbOperands = forOp.getLowerBoundOperands();
+    auto ubOperands = forOp.getUpperBoundOperands();
+    dependences.append(lbOperands.begin(), lbOperands.end());
+    dependences.append(ubOperands.begin(), ubOperands.end());
+    return;
+  }
+  auto *op = value->getDefiningOp();
+  if (op && (op->isa<AffineApplyOp>() || op->isa<AddIOp>() ||
+             op->isa<SubIOp>() || op->isa<MulIOp>()))
+    dependences.append(op->operand_begin(), op->operand_end());
+}
+
+IntegerRange IntegerRangeAnalysis::getRange(Value *value) {
+  auto it = ranges.find(value);
+  if (it != ranges.end())
+    return it->second;
+
+  // Compute the ranges of the values 'value' depends on first, in post-order.
+  // The traversal uses an explicit stack since the use-def chains of index
+  // computations may be long. Each entry records whether the dependences of
+  // its value were pushed already.
+  SmallVector<std::pair<Value *, bool>, 8> stack;
+  SmallVector<Value *, 4> dependences;
+  stack.push_back({value, false});
+  while (!stack.empty()) {
+    Value *current = stack.back().first;
+    if (ranges.count(current)) {
+      stack.pop_back();
+      continue;
+    }
+    if (stack.back().second) {
+      stack.pop_back();
+      ranges[current] = computeRange(current);
+      continue;
+    }
+    stack.back().second = true;
+    dependences.clear();
+    getDependences(current, dependences);
+    for (auto *dependence : dependences)
+      if (!ranges.count(dependence))
+        stack.push_back({dependence, false});
+  }
+  return ranges[value];
+}
+
+IntegerRange IntegerRangeAnalysis::getRange(AffineExpr expr,
+                                            ArrayRef<Value *> operands,
+                                            unsigned numDims) {
+  SmallVector<IntegerRange, 4> operandRanges;
+  operandRanges.reserve(operands.size());
+  for (auto *operand : operands)
+    operandRanges.push_back(getRange(operand));
+  return evaluate(expr, operandRanges, numDims);
+}
+
+IntegerRange IntegerRangeAnalysis::lookup(Value *value) const {
+  auto it = ranges.find(value);
+  return it == ranges.end() ? IntegerRange() : it->second;
+}
+
+IntegerRange IntegerRangeAnalysis::computeRange(Value *value) {
+  if (!value->getType().isIndex())
+    return IntegerRange();
+
+  // An IV is at least the maximum of the lower bounds of its loop, hence at
+  // least any of them, and less than any of its upper bounds.
+  if (auto forOp = getForInductionVarOwner(value)) {
+    IntegerRange result;
+    auto evaluateBound = [&](AffineExpr expr, AffineMap map,
+                             Operation::operand_range operands) {
+      SmallVector<IntegerRange, 4> operandRanges;
+      for (auto *operand : operands)
+        operandRanges.push_back(lookup(operand));
+      return evaluate(expr, operandRanges, map.getNumDims());
+    };
+    auto lbMap = forOp.getLowerBoundMap();
+    for (auto expr : lbMap.getResults()) {
+      auto range = evaluateBound(expr, lbMap, forOp.getLowerBoundOperands());
+      if (range.lower && (!result.lower || *range.lower > *result.lower))
+        result.lower = range.lower;
+      if (!result.symbolicLower)
+        result.symbolicLower = range.symbolicLower;
+    }
+    auto ubMap = forOp.getUpperBoundMap();
+    for (auto expr : ubMap.getResults()) {
+      auto range = evaluateBound(expr, ubMap, forOp.getUpperBoundOperands());
+      auto upper = addBounds(range.upper, -1);
+      if (upper && (!result.upper || *upper < *result.upper))
+        result.upper = upper;
+      if (!result.symbolicUpper)
+        result.symbolicUpper = shift(range.symbolicUpper, -1);
+    }
+    return result;
+  }
+
+  auto *op = value->getDefiningOp();
+  if (!op)
+    return IntegerRange::getSelf(value);
+
+  if (auto constOp = op->dyn_cast<ConstantIndexOp>())
+    return IntegerRange::getConstant(constOp.getValue());
+
+  if (auto applyOp = op->dyn_cast<AffineApplyOp>()) {
+    SmallVector<IntegerRange, 4> operandRanges;
+    for (auto *operand : op->getOperands())
+      operandRanges.push_back(lookup(operand));
+    auto map = applyOp.getAffineMap();
+    return evaluate(map.getResult(0), operandRanges, map.getNumDims());
+  }
+
+  if (op->isa<AddIOp>())
+    return add(lookup(op->getOperand(0)), lookup(op->getOperand(1)));
+  if (op->isa<SubIOp>())
+    return add(lookup(op->getOperand(0)), mul(lookup(op->getOperand(1)), -1));
+  if (op->isa<MulIOp>())
+    return mul(lookup(op->getOperand(0)), lookup(op->getOperand(1)));
+
+  if (auto dimOp = op->dyn_cast<DimOp>()) {
+    auto type = dimOp.getOperand()->getType();
+    int64_t size = -1;
+    if (auto tensorType = type.dyn_cast<RankedTensorType>())
+      size = tensorType.getShape()[dimOp.getIndex()];
+    else if (auto memrefType = type.dyn_cast<MemRefType>())
+      size = memrefType.getShape()[dimOp.getIndex()];
+    if (size >= 0)
+      return IntegerRange::getConstant(size);
+    auto result = IntegerRange::getSelf(value);
+    result.lower = 0;
+    return result;
+  }
+
+  return IntegerRange::getSelf(value);
+}
+
+void IntegerRangeAnalysis::invalidate(Operation *op) {
+  op->walk([&](Operation *nestedOp) {
+    for (auto *result : nestedOp->getResults())
+      ranges.erase(result);
+    for (auto &region : nestedOp->getRegions())
+      for (auto &block : region)
+        for (auto *argument : block.getArguments())
+          ranges.erase(argument);
+  });
+}
@@ -24,6 +24,7 @@
 #include "mlir/AffineOps/AffineOps.h"
 #include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
+#include "mlir/Analysis/MemRefAccessInterface.h"
 #include "mlir/Analysis/NestedMatcher.h"
 #include "mlir/Analysis/VectorAnalysis.h"
 #include "mlir/IR/AffineMap.h"
@@ -36,7 +37,6 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallString.h"
-#include <type_traits>
 
 using namespace mlir;
 
@@ -74,12 +74,12 @@ void mlir::buildTripCountMapAndOperands(
   }
   SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
   SmallVector<Value *, 4> ubOperands(forOp.getUpperBoundOperands());
-  auto lb = b.create<AffineApplyOp>(forOp.getLoc(), lbMap, lbOperands);
+  auto lb = makeComposedAffineApply(&b, forOp.getLoc(), lbMap, lbOperands);
   SmallVector<Value *, 4> ubs;
   ubs.reserve(ubMap.getNumResults());
   for (auto ubExpr : ubMap.getResults())
-    ubs.push_back(b.create<AffineApplyOp>(
-        forOp.getLoc(),
+    ubs.push_back(makeComposedAffineApply(
+        &b, forOp.getLoc(),
         b.getAffineMap(ubMap.getNumDims(), ubMap.getNumSymbols(), {ubExpr}, {}),
         ubOperands));
 
@@ -212,7 +212,7 @@ mlir::getInvariantAccesses(Value *iv, llvm::ArrayRef<Value *> indices) {
 
 /// Given:
 ///   1. an induction variable `iv` of type AffineForOp;
-///   2. a `memoryOp` of type const LoadOp& or const StoreOp&;
+///   2. a `memoryOp` accessing a memref, e.g. a LoadOp or a StoreOp;
 /// determines whether `memoryOp` has a contiguous access along `iv`. Contiguous
 /// is defined as either invariant or varying only along a unique MemRef dim.
 /// Upon success, the unique MemRef dim is written in `memRefDim` (or -1 to
@@ -229,12 +229,8 @@ mlir::getInvariantAccesses(Value *iv, llvm::ArrayRef<Value *> indices) {
 /// layoutMap. This is conservative.
 ///
 // TODO(ntv): check strides.
-template <typename LoadOrStoreOp>
-static bool isContiguousAccess(Value *iv, LoadOrStoreOp memoryOp,
+static bool isContiguousAccess(Value *iv, MemRefAccessOpInterface memoryOp,
                                int *memRefDim) {
-  static_assert(std::is_same<LoadOrStoreOp, LoadOp>::value ||
-                    std::is_same<LoadOrStoreOp, StoreOp>::value,
-                "Must be called on either const LoadOp & or const StoreOp &");
   assert(memRefDim && "memRefDim == nullptr");
   auto memRefType = memoryOp.getMemRefType();
 
@@ -272,10 +268,9 @@ static bool isContiguousAccess(Value *iv, LoadOrStoreOp memoryOp,
   return true;
 }
 
-template <typename LoadOrStoreOpPointer>
-static bool isVectorElement(LoadOrStoreOpPointer memoryOp) {
+static bool isVectorElement(MemRefAccessOpInterface memoryOp) {
   auto memRefType = memoryOp.getMemRefType();
-  return memRefType.getElementType().template isa<VectorType>();
+  return memRefType.getElementType().isa<VectorType>();
 }
 
 static bool isVectorTransferReadOrWrite(Operation &op) {
@@ -291,42 +286,34 @@ isVectorizableLoopBodyWithOpCond(AffineForOp loop,
 
   // No vectorization across conditionals for now.
   auto conditionals = matcher::If();
-  SmallVector<NestedMatch, 8> conditionalsMatched;
-  conditionals.match(forOp, &conditionalsMatched);
-  if (!conditionalsMatched.empty()) {
-    return false;
-  }
-
   // No vectorization across unknown regions.
   auto regions = matcher::Op([](Operation &op) -> bool {
     return op.getNumRegions() != 0 &&
            !(op.isa<AffineIfOp>() || op.isa<AffineForOp>());
   });
-  SmallVector<NestedMatch, 8> regionsMatched;
-  regions.match(forOp, &regionsMatched);
-  if (!regionsMatched.empty()) {
-    return false;
-  }
-
   auto vectorTransfers = matcher::Op(isVectorTransferReadOrWrite);
+  auto loadAndStores = matcher::Op(matcher::isLoadOrStore);
+
+  // The body is walked once for all the patterns.
+  SmallVector<NestedMatch, 8> conditionalsMatched;
+  SmallVector<NestedMatch, 8> regionsMatched;
   SmallVector<NestedMatch, 8> vectorTransfersMatched;
-  vectorTransfers.match(forOp, &vectorTransfersMatched);
-  if (!vectorTransfersMatched.empty()) {
+  SmallVector<NestedMatch, 8> loadAndStoresMatched;
+  NestedPattern::match(forOp,
+                       {conditionals, regions, vectorTransfers, loadAndStores},
+                       {&conditionalsMatched, &regionsMatched,
+                        &vectorTransfersMatched, &loadAndStoresMatched});
+  if (!conditionalsMatched.empty() || !regionsMatched.empty() ||
+      !vectorTransfersMatched.empty()) {
     return false;
   }
 
-  auto loadAndStores = matcher::Op(matcher::isLoadOrStore);
-  SmallVector<NestedMatch, 8> loadAndStoresMatched;
-  loadAndStores.match(forOp, &loadAndStoresMatched);
   for (auto ls : loadAndStoresMatched) {
     auto *op = ls.getMatchedOperation();
-    auto load = op->dyn_cast<LoadOp>();
-    auto store = op->dyn_cast<StoreOp>();
     // Only scalar types are considered vectorizable, all load/store must be
     // vectorizable for a loop to qualify as vectorizable.
     // TODO(ntv): ponder whether we want to be more general here.
-    bool vector = load ? isVectorElement(load) : isVectorElement(store);
-    if (vector) {
+    if (isVectorElement(op->cast<MemRefAccessOpInterface>())) {
       return false;
     }
     if (isVectorizableOp && !isVectorizableOp(loop, *op)) {
@@ -338,10 +325,8 @@ isVectorizableLoopBodyWithOpCond(AffineForOp loop,
 
 bool mlir::isVectorizableLoopBody(AffineForOp loop, int *memRefDim) {
   VectorizableOpFun fun([memRefDim](AffineForOp loop, Operation &op) {
-    auto load = op.dyn_cast<LoadOp>();
-    auto store = op.dyn_cast<StoreOp>();
-    return load ? isContiguousAccess(loop.getInductionVar(), load, memRefDim)
-                : isContiguousAccess(loop.getInductionVar(), store, memRefDim);
+    return isContiguousAccess(loop.getInductionVar(),
+                              op.cast<MemRefAccessOpInterface>(), memRefDim);
   });
   return isVectorizableLoopBodyWithOpCond(loop, fun);
 }
@@ -350,6 +335,115 @@ bool mlir::isVectorizableLoopBody(AffineForOp loop) {
   return isVectorizableLoopBodyWithOpCond(loop, nullptr);
 }
 
+/// Records in 'contiguity' how 'memoryOp' varies along 'iv'.
+static void addAccessContiguity(Value *iv, MemRefAccessOpInterface memoryOp,
+                                AccessContiguity *contiguity) {
+  // Check the layout map first since isContiguousAccess reports an error on
+  // non-trivial ones.
+  auto layoutMap = memoryOp.getMemRefType().getAffineMaps();
+  Builder b(memoryOp.getContext());
+  if (layoutMap.size() >= 2 ||
+      (layoutMap.size() == 1 &&
+       !(layoutMap[0] ==
+         b.getMultiDimIdentityMap(layoutMap[0].getNumDims())))) {
+    ++contiguity->numNonContiguous;
+    return;
+  }
+  int memRefDim = -1;
+  if (!isContiguousAccess(iv, memoryOp, &memRefDim)) {
+    ++contiguity->numNonContiguous;
+    return;
+  }
+  if (memRefDim == -1) {
+    ++contiguity->numInvariant;
+    return;
+  }
+  if (contiguity->numVaryingAlongDim.size() <= unsigned(memRefDim))
+    contiguity->numVaryingAlongDim.resize(memRefDim + 1, 0);
+  ++contiguity->numVaryingAlongDim[memRefDim];
+}
+
+AccessContiguity mlir::getAccessContiguity(AffineForOp loop) {
+  AccessContiguity contiguity;
+  auto *iv = loop.getInductionVar();
+  loop.getOperation()->walk([&](Operation *op) {
+    if (auto memoryOp = op->dyn_cast<MemRefAccessOpInterface>())
+      addAccessContiguity(iv, memoryOp, &contiguity);
+  });
+  return contiguity;
+}
+
+/// Returns true if 'value' is defined outside of 'loop'.
+bool mlir::isDefinedOutsideOfLoop(Value *value, AffineForOp loop) {
+  auto *loopOp = loop.getOperation();
+  Operation *op = value->getDefiningOp();
+  if (!op)
+    op = cast<BlockArgument>(value)->getOwner()->getContainingOp();
+  for (; op; op = op->getParentOp())
+    if (op == loopOp)
+      return false;
+  return true;
+}
+
+bool mlir::getMemRefReduction(AffineForOp loop, MemRefReduction *reduction) {
+  auto *iv = loop.getInductionVar();
+  SmallVector<LoadOp, 8> loads;
+  SmallVector<StoreOp, 2> stores;
+  bool hasNestedRegions = false;
+  loop.getBody()->walk([&](Operation *op) {
+    if (op->getNumRegions() != 0)
+      hasNestedRegions = true;
+    if (auto load = op->dyn_cast<LoadOp>())
+      loads.push_back(load);
+    else if (auto store = op->dyn_cast<StoreOp>())
+      stores.push_back(store);
+  });
+  if (hasNestedRegions || stores.size() != 1)
+    return false;
+
+  // The stored location must be invariant along the loop.
+  auto store = stores.front();
+  auto *memref = store.getMemRef();
+  if (!store.getMemRefType().getElementType().isIntOrFloat())
+    return false;
+  for (auto *index : store.getIndices())
+    if (!isDefinedOutsideOfLoop(index, loop) || !isAccessInvariant(iv, index))
+      return false;
+
+  // The stored value must combine the value loaded from the same location with
+  // a value computed in the iteration.
+  auto *stored = store.getValueToStore();
+  auto *combiner = stored->getDefiningOp();
+  if (!combiner || combiner->getBlock() != loop.getBody() ||
+      !stored->hasOneUse() ||
+      !(combiner->isa<AddFOp>() || combiner->isa<MulFOp>() ||
+        combiner->isa<AddIOp>() || combiner->isa<MulIOp>()))
+    return false;
+  Operation *accumulatorLoad = nullptr;
+  for (auto load : loads) {
+    if (load.getMemRef() != memref)
+      continue;
+    // Any other access to the memref carries a dependence that the reduction
+    // does not account for.
+    if (accumulatorLoad || !load.getResult()->hasOneUse() ||
+        load.getResult()->use_begin()->getOwner() != combiner)
+      return false;
+    auto loadIndices = load.getIndices();
+    auto storeIndices = store.getIndices();
+    if (!std::equal(loadIndices.begin(), loadIndices.end(),
+                    storeIndices.begin()))
+      return false;
+    accumulatorLoad = load.getOperation();
+  }
+  if (!accumulatorLoad)
+    return false;
+
+  reduction->load = accumulatorLoad;
+  reduction->combiner = combiner;
+  reduction->store = store.getOperation();
+  return true;
+}
+
 /// Checks whether SSA dominance would be violated if a for op's body
 /// operations are shifted by the specified shifts. This method checks if a
 /// 'def' and all its uses have the same shift factor.
@@ -0,0 +1,177 @@
+//===- LoopProfile.cpp - Runtime profiles of loops and functions ----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the reading of the loop profiles and the queries made
+// on them by the loop transformations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/LoopProfile.h"
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/IR/Function.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+static llvm::cl::opt<std::string> clLoopProfile(
+    "loop-profile",
+    llvm::cl::desc("Profile of the loops, written by the code instrumented by "
+                   "-instrument-loops, guiding the loop transformations"),
+    llvm::cl::value_desc("<filename>"), llvm::cl::init(""));
+
+static llvm::cl::opt<double> clLoopProfileColdThreshold(
+    "loop-profile-cold-threshold",
+    llvm::cl::desc("Fraction of the time of the most expensive region of the "
+                   "loop profile below which a loop nest is cold"),
+    llvm::cl::init(0.01));
+
+std::unique_ptr<LoopProfile> LoopProfile::parse(StringRef buffer,
+                                                std::string *errorMessage) {
+  auto profile = llvm::make_unique<LoopProfile>();
+  unsigned lineNumber = 0;
+  while (!buffer.empty()) {
+    StringRef line;
+    std::tie(line, buffer) = buffer.split('\n');
+    ++lineNumber;
+    line = line.trim();
+    if (line.empty() || line.startswith("#"))
+      continue;
+
+    SmallVector<StringRef, 4> fields;
+    line.split(fields, ' ', /*MaxSplit=*/3, /*KeepEmpty=*/false);
+    ProfileCounters counters;
+    if (fields.size() != 4 || fields[0].getAsInteger(10, counters.entries) ||
+        fields[1].getAsInteger(10, counters.iterations) ||
+        fields[2].getAsInteger(10, counters.nanoseconds)) {
+      if (errorMessage)
+        *errorMessage = "line " + std::to_string(lineNumber) +
+                        ": expected '<entries> <iterations> <nanoseconds> "
+                        "<name>'";
+      return nullptr;
+    }
+
+    // Regions listed several times, e.g. in the concatenated profiles of
+    // several runs, add up their counters.
+    ProfileCounters &region = profile->regions[fields[3].trim()];
+    region.entries += counters.entries;
+    region.iterations += counters.iterations;
+    region.nanoseconds += counters.nanoseconds;
+    profile->maxNanoseconds =
+        std::max(profile->maxNanoseconds, region.nanoseconds);
+  }
+  return profile;
+}
+
+std::unique_ptr<LoopProfile>
+LoopProfile::readFile(StringRef filename, std::string *errorMessage) {
+  auto file = llvm::MemoryBuffer::getFile(filename);
+  if (!file) {
+    if (errorMessage)
+      *errorMessage = "cannot open loop profile '" + filename.str() +
+                      "': " + file.getError().message();
+    return nullptr;
+  }
+  std::string parseError;
+  auto profile = parse((*file)->getBuffer(), &parseError);
+  if (!profile && errorMessage)
+    *errorMessage = filename.str() + ": " + parseError;
+  return profile;
+}
+
+const ProfileCounters *LoopProfile::lookup(StringRef name) const {
+  auto it = regions.find(name);
+  return it == regions.end() ? nullptr : &it->second;
+}
+
+const ProfileCounters *LoopProfile::lookup(AffineForOp forOp) const {
+  return lookup(getProfileRegionName(forOp));
+}
+
+const ProfileCounters *LoopProfile::lookup(Function &function) const {
+  return lookup(getProfileRegionName(function));
+}
+
+bool LoopProfile::isCold(AffineForOp forOp, double coldThreshold) const {
+  if (const auto *counters = lookup(forOp))
+    return counters->nanoseconds < coldThreshold * maxNanoseconds;
+  // A loop that was never entered is only known to be cold if its function
+  // was profiled.
+  Function *function = forOp.getOperation()->getFunction();
+  return function && lookup(*function);
+}
+
+Optional<uint64_t> LoopProfile::getAverageTripCount(AffineForOp forOp) const {
+  const auto *counters = lookup(forOp);
+  if (!counters || counters->entries == 0)
+    return None;
+  return (counters->iterations + counters->entries / 2) / counters->entries;
+}
+
+// Return the name of the region of kind `kind` in `function` at `loc`.  The
+// file locations are printed without the quotes of the IR syntax.
+static std::string getRegionName(StringRef kind, Function &function,
+                                 Location loc) {
+  std::string name;
+  llvm::raw_string_ostream os(name);
+  os << kind << " @" << function.getName() << ' ';
+  if (auto fileLoc = loc.dyn_cast<FileLineColLoc>())
+    os << fileLoc->getFilename() << ':' << fileLoc->getLine() << ':'
+       << fileLoc->getColumn();
+  else
+    loc.print(os);
+  return os.str();
+}
+
+std::string mlir::getProfileRegionName(AffineForOp forOp) {
+  return getRegionName("affine.for", *forOp.getOperation()->getFunction(),
+                       forOp.getLoc());
+}
+
+std::string mlir::getProfileRegionName(Function &function) {
+  return getRegionName("func", function, function.getLoc());
+}
+
+const LoopProfile *mlir::getLoopProfile() {
+  static std::unique_ptr<LoopProfile> profile = []() {
+    std::unique_ptr<LoopProfile> profile;
+    if (clLoopProfile.empty())
+      return profile;
+    std::string errorMessage;
+    profile = LoopProfile::readFile(clLoopProfile, &errorMessage);
+    if (!profile)
+      llvm::errs() << "warning: ignoring the loop profile: " << errorMessage
+                   << '\n';
+    return profile;
+  }();
+  return profile.get();
+}
+
+bool mlir::isColdLoop(AffineForOp forOp) {
+  const LoopProfile *profile = getLoopProfile();
+  return profile && profile->isCold(forOp, clLoopProfileColdThreshold);
+}
+
+Optional<uint64_t> mlir::getEstimatedTripCount(AffineForOp forOp) {
+  if (auto tripCount = getConstantTripCount(forOp))
+    return tripCount;
+  if (const LoopProfile *profile = getLoopProfile())
+    return profile->getAverageTripCount(forOp);
+  return None;
+}
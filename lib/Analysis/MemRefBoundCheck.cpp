@@ -22,6 +22,7 @@
 
 #include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
+#include "mlir/Analysis/MemRefBoundsAnalysis.h"
 #include "mlir/Analysis/Passes.h"
 #include "mlir/Analysis/Utils.h"
 #include "mlir/IR/Builders.h"
@@ -47,14 +48,17 @@ FunctionPassBase *mlir::createMemRefBoundCheckPass() {
 }
 
 void MemRefBoundCheck::runOnFunction() {
-  getFunction().walk([](Operation *opInst) {
-    if (auto loadOp = opInst->dyn_cast<LoadOp>()) {
+  // Only the accesses that the analysis couldn't prove in bounds may be out of
+  // bounds: report those that are.
+  auto &bounds = getAnalysis<MemRefBoundsAnalysis>();
+  for (Operation *op : bounds.getUnprovenAccesses()) {
+    if (auto loadOp = op->dyn_cast<LoadOp>())
       boundCheckLoadOrStoreOp(loadOp);
-    } else if (auto storeOp = opInst->dyn_cast<StoreOp>()) {
-      boundCheckLoadOrStoreOp(storeOp);
-    }
+    else
+      boundCheckLoadOrStoreOp(op->cast<StoreOp>());
     // TODO(bondhugula): do this for DMA ops as well.
-  });
+  }
+  markAllAnalysesPreserved();
 }
 
 static PassRegistration<MemRefBoundCheck>
@@ -0,0 +1,102 @@
+//===- MemRefBoundsAnalysis.cpp - Accesses proven in bounds ---------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the analysis proving memref accesses to stay in bounds.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemRefBoundsAnalysis.h"
+#include "mlir/Analysis/IntegerRangeAnalysis.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Function.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/VectorOps/VectorOps.h"
+
+using namespace mlir;
+
+// Returns true if 'value' is the size of the dynamic dimension 'dim' of
+// 'memRef', either as a 'dim' op or as the operand of the 'alloc' op defining
+// 'memRef'.
+static bool isDynamicDimSize(Value *value, Value *memRef, unsigned dim) {
+  if (auto *def = value->getDefiningOp())
+    if (auto dimOp = def->dyn_cast<DimOp>())
+      return dimOp.getOperand() == memRef && dimOp.getIndex() == dim;
+
+  auto *def = memRef->getDefiningOp();
+  if (!def || !def->isa<AllocOp>())
+    return false;
+  // The operands of the alloc are the dynamic sizes, in order.
+  auto shape = def->cast<AllocOp>().getType().getShape();
+  unsigned position = llvm::count(shape.take_front(dim), -1);
+  return position < def->getNumOperands() &&
+         def->getOperand(position) == value;
+}
+
+// Returns true if the ranges of the indices of 'loadOrStoreOp' show that it
+// accesses its memref in bounds, which is cheaper than building the
+// constraints of the access.  An index along a dynamic dimension must be less
+// than the size of the dimension.
+template <typename LoadOrStoreOpPointer>
+static bool hasIndicesInRange(LoadOrStoreOpPointer loadOrStoreOp,
+                              IntegerRangeAnalysis &ranges) {
+  auto shape = loadOrStoreOp.getMemRefType().getShape();
+  unsigned dim = 0;
+  for (auto *index : loadOrStoreOp.getIndices()) {
+    auto range = ranges.getRange(index);
+    if (shape[dim] >= 0) {
+      if (!range.isWithin(0, shape[dim] - 1))
+        return false;
+    } else if (!range.lower || *range.lower < 0 || !range.symbolicUpper ||
+               range.symbolicUpper->offset > -1 ||
+               !isDynamicDimSize(range.symbolicUpper->symbol,
+                                 loadOrStoreOp.getMemRef(), dim)) {
+      return false;
+    }
+    ++dim;
+  }
+  return true;
+}
+
+// Returns true if 'loadOrStoreOp' is proven to access its memref in bounds.
+template <typename LoadOrStoreOpPointer>
+static bool isInBounds(LoadOrStoreOpPointer loadOrStoreOp,
+                       IntegerRangeAnalysis &ranges) {
+  return hasIndicesInRange(loadOrStoreOp, ranges) ||
+         isLoadOrStoreInBounds(loadOrStoreOp);
+}
+
+MemRefBoundsAnalysis::MemRefBoundsAnalysis(Function *function) {
+  IntegerRangeAnalysis ranges(function);
+  function->walk([&](Operation *op) {
+    bool inBounds;
+    if (auto loadOp = op->dyn_cast<LoadOp>())
+      inBounds = isInBounds(loadOp, ranges);
+    else if (auto storeOp = op->dyn_cast<StoreOp>())
+      inBounds = isInBounds(storeOp, ranges);
+    else if (auto readOp = op->dyn_cast<VectorTransferReadOp>())
+      inBounds = isVectorTransferInBounds(readOp);
+    else if (auto writeOp = op->dyn_cast<VectorTransferWriteOp>())
+      inBounds = isVectorTransferInBounds(writeOp);
+    else
+      return;
+
+    if (inBounds)
+      inBoundsAccesses.insert(op);
+    else if (op->isa<LoadOp>() || op->isa<StoreOp>())
+      unprovenAccesses.push_back(op);
+  });
+}
@@ -78,22 +78,22 @@ getDirectionVectorStr(bool ret, unsigned numCommonLoops, unsigned loopNestDepth,
 // For each access in 'loadsAndStores', runs a depence check between this
 // "source" access and all subsequent "destination" accesses in
 // 'loadsAndStores'. Emits the result of the dependence check as a note with
-// the source access.
-static void checkDependences(ArrayRef<Operation *> loadsAndStores) {
+// the source access. Each check consumes a unit of the budget of 'pass', and
+// the remaining checks are skipped once it is exhausted.
+static void checkDependences(ArrayRef<Operation *> loadsAndStores,
+                             DependenceAnalysis &dependences, Pass &pass) {
   for (unsigned i = 0, e = loadsAndStores.size(); i < e; ++i) {
     auto *srcOpInst = loadsAndStores[i];
-    MemRefAccess srcAccess(srcOpInst);
     for (unsigned j = 0; j < e; ++j) {
       auto *dstOpInst = loadsAndStores[j];
-      MemRefAccess dstAccess(dstOpInst);
 
       unsigned numCommonLoops =
           getNumCommonSurroundingLoops(*srcOpInst, *dstOpInst);
       for (unsigned d = 1; d <= numCommonLoops + 1; ++d) {
-        FlatAffineConstraints dependenceConstraints;
+        if (!pass.consumeBudget())
+          return;
         llvm::SmallVector<DependenceComponent, 2> dependenceComponents;
-        bool ret = checkMemrefAccessDependence(srcAccess, dstAccess, d,
-                                               &dependenceConstraints,
+        bool ret = dependences.checkDependence(srcOpInst, dstOpInst, d,
                                                &dependenceComponents);
         // TODO(andydavis) Print dependence type (i.e. RAW, etc) and print
         // distance vectors as: ([2, 3], [0, 10]). Also, shorten distance
@@ -118,7 +118,10 @@ void MemRefDependenceCheck::runOnFunction() {
       loadsAndStores.push_back(op);
   });
 
-  checkDependences(loadsAndStores);
+  checkDependences(loadsAndStores, getAnalysis<DependenceAnalysis>(), *this);
+
+  // The IR is left untouched, so the computed dependences remain valid.
+  markAllAnalysesPreserved();
 }
 
 static PassRegistration<MemRefDependenceCheck>
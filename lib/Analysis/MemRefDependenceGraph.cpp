@@ -0,0 +1,583 @@
+//===- MemRefDependenceGraph.cpp - Memref dependence graph ----------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the graph of memref dependences between the top-level
+// operations of a function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemRefDependenceGraph.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/StandardOps/Ops.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+void LoopNestStateCollector::collect(Operation *opToWalk) {
+  opToWalk->walk([&](Operation *op) {
+    if (op->isa<AffineForOp>())
+      forOps.push_back(op->cast<AffineForOp>());
+    else if (op->getNumRegions() != 0)
+      hasNonForRegion = true;
+    else if (op->isa<LoadOp>())
+      loadOpInsts.push_back(op);
+    else if (op->isa<StoreOp>())
+      storeOpInsts.push_back(op);
+  });
+}
+
+// TODO(b/117228571) Replace when this is modeled through side-effects/op traits
+static bool isMemRefDereferencingOp(Operation &op) {
+  if (op.isa<LoadOp>() || op.isa<StoreOp>() || op.isa<DmaStartOp>() ||
+      op.isa<DmaWaitOp>())
+    return true;
+  return false;
+}
+
+// Returns the memref accessed by the load or store op 'opInst'.
+static Value *getAccessedMemRef(Operation *opInst) {
+  if (auto loadOp = opInst->dyn_cast<LoadOp>())
+    return loadOp.getMemRef();
+  return opInst->cast<StoreOp>().getMemRef();
+}
+
+//===----------------------------------------------------------------------===//
+// MemRefDependenceGraph::Node
+//===----------------------------------------------------------------------===//
+
+unsigned MemRefDependenceGraph::Node::getLoadOpCount(Value *memref) {
+  unsigned loadOpCount = 0;
+  for (auto *loadOpInst : loads) {
+    if (memref == loadOpInst->cast<LoadOp>().getMemRef())
+      ++loadOpCount;
+  }
+  return loadOpCount;
+}
+
+unsigned MemRefDependenceGraph::Node::getStoreOpCount(Value *memref) {
+  unsigned storeOpCount = 0;
+  for (auto *storeOpInst : stores) {
+    if (memref == storeOpInst->cast<StoreOp>().getMemRef())
+      ++storeOpCount;
+  }
+  return storeOpCount;
+}
+
+void MemRefDependenceGraph::Node::getStoreOpsForMemref(
+    Value *memref, SmallVectorImpl<Operation *> *storeOps) {
+  for (auto *storeOpInst : stores) {
+    if (memref == storeOpInst->cast<StoreOp>().getMemRef())
+      storeOps->push_back(storeOpInst);
+  }
+}
+
+void MemRefDependenceGraph::Node::getLoadOpsForMemref(
+    Value *memref, SmallVectorImpl<Operation *> *loadOps) {
+  for (auto *loadOpInst : loads) {
+    if (memref == loadOpInst->cast<LoadOp>().getMemRef())
+      loadOps->push_back(loadOpInst);
+  }
+}
+
+void MemRefDependenceGraph::Node::getLoadAndStoreMemrefSet(
+    DenseSet<Value *> *loadAndStoreMemrefSet) {
+  llvm::SmallDenseSet<Value *, 2> loadMemrefs;
+  for (auto *loadOpInst : loads) {
+    loadMemrefs.insert(loadOpInst->cast<LoadOp>().getMemRef());
+  }
+  for (auto *storeOpInst : stores) {
+    auto *memref = storeOpInst->cast<StoreOp>().getMemRef();
+    if (loadMemrefs.count(memref) > 0)
+      loadAndStoreMemrefSet->insert(memref);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// MemRefDependenceGraph
+//===----------------------------------------------------------------------===//
+
+// Intializes the data dependence graph by walking operations in 'f'.
+// Assigns each node in the graph a node id based on program order in 'f'.
+// TODO(andydavis) Add support for taking a Block arg to construct the
+// dependence graph at a different depth.
+bool MemRefDependenceGraph::init(Function &f) {
+  // TODO: support multi-block functions.
+  if (f.getBlocks().size() != 1)
+    return false;
+
+  for (auto &op : f.front()) {
+    if (op.isa<AffineForOp>()) {
+      // Create graph node 'id' to represent top-level 'forOp' and record
+      // all loads and store accesses it contains.
+      LoopNestStateCollector collector;
+      collector.collect(&op);
+      // Return false if a non 'affine.for' region was found (not currently
+      // supported).
+      if (collector.hasNonForRegion)
+        return false;
+      unsigned id = addNode(&op);
+      updateNodeAccesses(id, collector.loadOpInsts, collector.storeOpInsts);
+    } else if (op.isa<LoadOp>()) {
+      // Create graph node for top-level load op.
+      updateNodeAccesses(addNode(&op), &op, {});
+    } else if (op.isa<StoreOp>()) {
+      // Create graph node for top-level store op.
+      updateNodeAccesses(addNode(&op), {}, &op);
+    } else if (op.getNumRegions() != 0) {
+      // Return false if another region is found (not currently supported).
+      return false;
+    } else if (op.getNumResults() > 0 && !op.use_empty()) {
+      // Create graph node for top-level producer of SSA values, which
+      // could be used by loop nest nodes.
+      addNode(&op);
+    }
+  }
+
+  // Add dependence edges between nodes which produce SSA values and their
+  // users.
+  for (auto &idAndNode : nodes) {
+    const Node &node = idAndNode.second;
+    if (!node.loads.empty() || !node.stores.empty())
+      continue;
+    auto *opInst = node.op;
+    for (auto *value : opInst->getResults()) {
+      for (auto &use : value->getUses()) {
+        SmallVector<AffineForOp, 4> loops;
+        getLoopIVs(*use.getOwner(), &loops);
+        if (loops.empty())
+          continue;
+        Node *userLoopNest = getForOpNode(loops[0]);
+        assert(userLoopNest != nullptr);
+        addEdge(node.id, userLoopNest->id, value);
+      }
+    }
+  }
+
+  // Walk memref access lists and add graph edges between dependent nodes.
+  for (auto &memrefAndList : memrefAccesses) {
+    unsigned n = memrefAndList.second.size();
+    for (unsigned i = 0; i < n; ++i) {
+      unsigned srcId = memrefAndList.second[i];
+      bool srcHasStore =
+          getNode(srcId)->getStoreOpCount(memrefAndList.first) > 0;
+      for (unsigned j = i + 1; j < n; ++j) {
+        unsigned dstId = memrefAndList.second[j];
+        bool dstHasStore =
+            getNode(dstId)->getStoreOpCount(memrefAndList.first) > 0;
+        if (srcHasStore || dstHasStore)
+          addEdge(srcId, dstId, memrefAndList.first);
+      }
+    }
+  }
+  return true;
+}
+
+MemRefDependenceGraph::Node *
+MemRefDependenceGraph::getForOpNode(AffineForOp forOp) {
+  auto it = opToNodeId.find(forOp.getOperation());
+  if (it == opToNodeId.end())
+    return nullptr;
+  return getNode(it->second);
+}
+
+unsigned MemRefDependenceGraph::addNode(Operation *op) {
+  Node node(nextNodeId++, op);
+  nodes.insert({node.id, node});
+  opToNodeId[op] = node.id;
+  return node.id;
+}
+
+void MemRefDependenceGraph::removeNode(unsigned id) {
+  // Remove each edge in 'inEdges[id]'.
+  if (inEdges.count(id) > 0) {
+    SmallVector<Edge, 2> oldInEdges = inEdges[id];
+    for (auto &inEdge : oldInEdges) {
+      removeEdge(inEdge.id, id, inEdge.value);
+    }
+  }
+  // Remove each edge in 'outEdges[id]'.
+  if (outEdges.count(id) > 0) {
+    SmallVector<Edge, 2> oldOutEdges = outEdges[id];
+    for (auto &outEdge : oldOutEdges) {
+      removeEdge(id, outEdge.id, outEdge.value);
+    }
+  }
+  // Erase remaining node state.
+  Node *node = getNode(id);
+  removeMemRefAccesses(id);
+  opToNodeId.erase(node->op);
+  inEdges.erase(id);
+  outEdges.erase(id);
+  nodes.erase(id);
+}
+
+bool MemRefDependenceGraph::isLiveInOrEscapingMemRef(Value *memref) {
+  auto it = liveInOrEscapingMemRefs.find(memref);
+  if (it != liveInOrEscapingMemRefs.end())
+    return it->second;
+
+  // A block argument is live in; otherwise check if any use of 'memref'
+  // escapes the function.
+  bool result = memref->getDefiningOp() == nullptr ||
+                llvm::any_of(memref->getUses(), [](OpOperand &use) {
+                  return !isMemRefDereferencingOp(*use.getOwner());
+                });
+  liveInOrEscapingMemRefs[memref] = result;
+  return result;
+}
+
+bool MemRefDependenceGraph::writesToLiveInOrEscapingMemrefs(unsigned id) {
+  Node *node = getNode(id);
+  return llvm::any_of(node->stores, [&](Operation *storeOpInst) {
+    return isLiveInOrEscapingMemRef(storeOpInst->cast<StoreOp>().getMemRef());
+  });
+}
+
+bool MemRefDependenceGraph::canRemoveNode(unsigned id) {
+  if (writesToLiveInOrEscapingMemrefs(id))
+    return false;
+  Node *node = getNode(id);
+  for (auto *storeOpInst : node->stores) {
+    // Return false if there exist out edges from 'id' on 'memref'.
+    if (getOutEdgeCount(id, storeOpInst->cast<StoreOp>().getMemRef()) > 0)
+      return false;
+  }
+  return true;
+}
+
+bool MemRefDependenceGraph::hasEdge(unsigned srcId, unsigned dstId,
+                                    Value *value) {
+  if (value)
+    return edgeSet.count({{srcId, dstId}, value}) > 0;
+  auto it = numEdgesBetween.find({srcId, dstId});
+  return it != numEdgesBetween.end() && it->second > 0;
+}
+
+void MemRefDependenceGraph::addEdge(unsigned srcId, unsigned dstId,
+                                    Value *value) {
+  if (!edgeSet.insert({{srcId, dstId}, value}).second)
+    return;
+  outEdges[srcId].push_back({dstId, value});
+  inEdges[dstId].push_back({srcId, value});
+  ++numEdgesBetween[{srcId, dstId}];
+  if (value->getType().isa<MemRefType>())
+    memrefEdgeCount[value]++;
+}
+
+void MemRefDependenceGraph::removeEdge(unsigned srcId, unsigned dstId,
+                                       Value *value) {
+  if (!edgeSet.erase({{srcId, dstId}, value}))
+    return;
+  assert(inEdges.count(dstId) > 0);
+  assert(outEdges.count(srcId) > 0);
+  if (value->getType().isa<MemRefType>()) {
+    assert(memrefEdgeCount.count(value) > 0);
+    memrefEdgeCount[value]--;
+  }
+  --numEdgesBetween[{srcId, dstId}];
+  // Remove 'srcId' from 'inEdges[dstId]'.
+  for (auto it = inEdges[dstId].begin(); it != inEdges[dstId].end(); ++it) {
+    if ((*it).id == srcId && (*it).value == value) {
+      inEdges[dstId].erase(it);
+      break;
+    }
+  }
+  // Remove 'dstId' from 'outEdges[srcId]'.
+  for (auto it = outEdges[srcId].begin(); it != outEdges[srcId].end(); ++it) {
+    if ((*it).id == dstId && (*it).value == value) {
+      outEdges[srcId].erase(it);
+      break;
+    }
+  }
+}
+
+bool MemRefDependenceGraph::hasDependencePath(unsigned srcId, unsigned dstId) {
+  // Worklist state is: <node-id, next-output-edge-index-to-visit>
+  SmallVector<std::pair<unsigned, unsigned>, 4> worklist;
+  // Nodes which have been pushed on the worklist, each of which only needs to
+  // be traversed once.
+  llvm::SmallDenseSet<unsigned, 16> visited;
+  worklist.push_back({srcId, 0});
+  visited.insert(srcId);
+  // Run DFS traversal to see if 'dstId' is reachable from 'srcId'.
+  while (!worklist.empty()) {
+    auto &idAndIndex = worklist.back();
+    // Return true if we have reached 'dstId'.
+    if (idAndIndex.first == dstId)
+      return true;
+    // Pop and continue if node has no out edges, or if all out edges have
+    // already been visited.
+    if (outEdges.count(idAndIndex.first) == 0 ||
+        idAndIndex.second == outEdges[idAndIndex.first].size()) {
+      worklist.pop_back();
+      continue;
+    }
+    // Get graph edge to traverse.
+    Edge edge = outEdges[idAndIndex.first][idAndIndex.second];
+    // Increment next output edge index for 'idAndIndex'.
+    ++idAndIndex.second;
+    // Add node at 'edge.id' to worklist if it has not been visited yet.
+    if (visited.insert(edge.id).second)
+      worklist.push_back({edge.id, 0});
+  }
+  return false;
+}
+
+unsigned MemRefDependenceGraph::getIncomingMemRefAccesses(unsigned id,
+                                                          Value *memref) {
+  unsigned inEdgeCount = 0;
+  if (inEdges.count(id) > 0)
+    for (auto &inEdge : inEdges[id])
+      if (inEdge.value == memref) {
+        Node *srcNode = getNode(inEdge.id);
+        // Only count in edges from 'srcNode' if 'srcNode' accesses 'memref'
+        if (srcNode->getStoreOpCount(memref) > 0)
+          ++inEdgeCount;
+      }
+  return inEdgeCount;
+}
+
+unsigned MemRefDependenceGraph::getOutEdgeCount(unsigned id, Value *memref) {
+  unsigned outEdgeCount = 0;
+  if (outEdges.count(id) > 0)
+    for (auto &outEdge : outEdges[id])
+      if (!memref || outEdge.value == memref)
+        ++outEdgeCount;
+  return outEdgeCount;
+}
+
+Operation *
+MemRefDependenceGraph::getFusedLoopNestInsertionPoint(unsigned srcId,
+                                                      unsigned dstId) {
+  return getFusedLoopNestInsertionPoint(ArrayRef<unsigned>(srcId), dstId);
+}
+
+Operation *MemRefDependenceGraph::getFusedLoopNestInsertionPoint(
+    ArrayRef<unsigned> srcIds, unsigned dstId) {
+  assert(!srcIds.empty() && "expected at least one src node");
+  Operation *dstNodeInst = getNode(dstId)->op;
+
+  // Collect the insts of the fused nodes, and the first src node inst.
+  SmallPtrSet<Operation *, 4> fusedInsts;
+  fusedInsts.insert(dstNodeInst);
+  Operation *srcNodeInst = nullptr;
+  for (unsigned srcId : srcIds) {
+    Operation *op = getNode(srcId)->op;
+    fusedInsts.insert(op);
+    if (srcNodeInst == nullptr || op->isBeforeInBlock(srcNodeInst))
+      srcNodeInst = op;
+  }
+
+  // Build set of insts in range (src, dst) which depend on a src node, and set
+  // of insts in range (src, dst) on which 'dstId' or a src node depends, since
+  // the src nodes move along with the fused loop nest.
+  SmallPtrSet<Operation *, 2> srcDepInsts;
+  SmallPtrSet<Operation *, 2> dstDepInsts;
+  for (unsigned srcId : srcIds) {
+    if (outEdges.count(srcId) > 0)
+      for (auto &outEdge : outEdges[srcId])
+        srcDepInsts.insert(getNode(outEdge.id)->op);
+    if (inEdges.count(srcId) > 0)
+      for (auto &inEdge : inEdges[srcId])
+        dstDepInsts.insert(getNode(inEdge.id)->op);
+  }
+  if (inEdges.count(dstId) > 0)
+    for (auto &inEdge : inEdges[dstId])
+      dstDepInsts.insert(getNode(inEdge.id)->op);
+
+  // Computing insertion point:
+  // *) Walk all operation positions in Block operation list in the
+  //    range (src, dst), skipping the fused nodes. For each operation 'op'
+  //    visited in this search:
+  //   *) Store in 'firstSrcDepPos' the first position where 'op' has a
+  //      dependence edge from a src node.
+  //   *) Store in 'lastDstDepPost' the last position where 'op' has a
+  //      dependence edge to 'dstNode' or to a src node.
+  // *) Compare 'firstSrcDepPos' and 'lastDstDepPost' to determine the
+  //    operation insertion point (or return null pointer if no such
+  //    insertion point exists: 'firstSrcDepPos' <= 'lastDstDepPos').
+  SmallVector<Operation *, 2> depInsts;
+  Optional<unsigned> firstSrcDepPos;
+  Optional<unsigned> lastDstDepPos;
+  unsigned pos = 0;
+  for (Block::iterator it = std::next(Block::iterator(srcNodeInst));
+       it != Block::iterator(dstNodeInst); ++it) {
+    Operation *op = &(*it);
+    if (fusedInsts.count(op) > 0)
+      continue;
+    if (srcDepInsts.count(op) > 0 && firstSrcDepPos == None)
+      firstSrcDepPos = pos;
+    if (dstDepInsts.count(op) > 0)
+      lastDstDepPos = pos;
+    depInsts.push_back(op);
+    ++pos;
+  }
+
+  if (firstSrcDepPos.hasValue()) {
+    if (lastDstDepPos.hasValue()) {
+      if (firstSrcDepPos.getValue() <= lastDstDepPos.getValue()) {
+        // No valid insertion point exists which preserves dependences.
+        return nullptr;
+      }
+    }
+    // Return the insertion point at 'firstSrcDepPos'.
+    return depInsts[firstSrcDepPos.getValue()];
+  }
+  // No dependence targets in range (or only dst deps in range), return
+  // 'dstNodInst' insertion point.
+  return dstNodeInst;
+}
+
+void MemRefDependenceGraph::updateEdges(unsigned srcId, unsigned dstId,
+                                        Value *oldMemRef) {
+  // For each edge in 'inEdges[srcId]': add new edge remaping to 'dstId'.
+  if (inEdges.count(srcId) > 0) {
+    SmallVector<Edge, 2> oldInEdges = inEdges[srcId];
+    for (auto &inEdge : oldInEdges) {
+      // Add edge from 'inEdge.id' to 'dstId' if not for 'oldMemRef'.
+      if (inEdge.value != oldMemRef)
+        addEdge(inEdge.id, dstId, inEdge.value);
+    }
+  }
+  // For each edge in 'outEdges[srcId]': remove edge from 'srcId' to 'dstId'.
+  if (outEdges.count(srcId) > 0) {
+    SmallVector<Edge, 2> oldOutEdges = outEdges[srcId];
+    for (auto &outEdge : oldOutEdges) {
+      // Remove any out edges from 'srcId' to 'dstId' across memrefs.
+      if (outEdge.id == dstId)
+        removeEdge(srcId, outEdge.id, outEdge.value);
+    }
+  }
+  // Remove any edges in 'inEdges[dstId]' on 'oldMemRef' (which is being
+  // replaced by a private memref). These edges could come from nodes
+  // other than 'srcId' which were removed in the previous step.
+  if (inEdges.count(dstId) > 0) {
+    SmallVector<Edge, 2> oldInEdges = inEdges[dstId];
+    for (auto &inEdge : oldInEdges)
+      if (inEdge.value == oldMemRef)
+        removeEdge(inEdge.id, dstId, inEdge.value);
+  }
+}
+
+void MemRefDependenceGraph::updateEdges(unsigned sibId, unsigned dstId) {
+  // For each edge in 'inEdges[sibId]':
+  // *) Add new edge from source node 'inEdge.id' to 'dstNode'.
+  // *) Remove edge from source node 'inEdge.id' to 'sibNode'.
+  if (inEdges.count(sibId) > 0) {
+    SmallVector<Edge, 2> oldInEdges = inEdges[sibId];
+    for (auto &inEdge : oldInEdges) {
+      addEdge(inEdge.id, dstId, inEdge.value);
+      removeEdge(inEdge.id, sibId, inEdge.value);
+    }
+  }
+
+  // For each edge in 'outEdges[sibId]' to node 'id'
+  // *) Add new edge from 'dstId' to 'outEdge.id'.
+  // *) Remove edge from 'sibId' to 'outEdge.id'.
+  if (outEdges.count(sibId) > 0) {
+    SmallVector<Edge, 2> oldOutEdges = outEdges[sibId];
+    for (auto &outEdge : oldOutEdges) {
+      addEdge(dstId, outEdge.id, outEdge.value);
+      removeEdge(sibId, outEdge.id, outEdge.value);
+    }
+  }
+}
+
+void MemRefDependenceGraph::updateNodeAccesses(unsigned id,
+                                               ArrayRef<Operation *> loads,
+                                               ArrayRef<Operation *> stores) {
+  // The previous loads and stores may have been erased by the transformation,
+  // e.g. when their memref was privatized: they must not be dereferenced.
+  removeMemRefAccesses(id);
+  Node *node = getNode(id);
+  node->loads.assign(loads.begin(), loads.end());
+  node->stores.assign(stores.begin(), stores.end());
+  addMemRefAccesses(id);
+}
+
+void MemRefDependenceGraph::addMemRefAccesses(unsigned id) {
+  Node *node = getNode(id);
+  auto addAccess = [&](Operation *opInst) {
+    auto *memref = getAccessedMemRef(opInst);
+    if (node->memrefs.insert(memref).second)
+      memrefAccesses[memref].insert(id);
+  };
+  for (auto *opInst : node->loads)
+    addAccess(opInst);
+  for (auto *opInst : node->stores)
+    addAccess(opInst);
+}
+
+void MemRefDependenceGraph::removeMemRefAccesses(unsigned id) {
+  Node *node = getNode(id);
+  for (auto *memref : node->memrefs) {
+    auto it = memrefAccesses.find(memref);
+    if (it != memrefAccesses.end())
+      it->second.remove(id);
+  }
+  node->memrefs.clear();
+}
+
+void MemRefDependenceGraph::forEachMemRefInputEdge(
+    unsigned id, const std::function<void(Edge)> &callback) {
+  if (inEdges.count(id) > 0)
+    forEachMemRefEdge(inEdges[id], callback);
+}
+
+void MemRefDependenceGraph::forEachMemRefOutputEdge(
+    unsigned id, const std::function<void(Edge)> &callback) {
+  if (outEdges.count(id) > 0)
+    forEachMemRefEdge(outEdges[id], callback);
+}
+
+void MemRefDependenceGraph::forEachMemRefEdge(
+    ArrayRef<Edge> edges, const std::function<void(Edge)> &callback) {
+  for (auto &edge : edges) {
+    // Skip if 'edge' is not a memref dependence edge.
+    if (!edge.value->getType().isa<MemRefType>())
+      continue;
+    assert(nodes.count(edge.id) > 0);
+    // Skip if 'edge.id' is not a loop nest.
+    if (!getNode(edge.id)->op->isa<AffineForOp>())
+      continue;
+    // Visit current input edge 'edge'.
+    callback(edge);
+  }
+}
+
+void MemRefDependenceGraph::print(raw_ostream &os) const {
+  os << "\nMemRefDependenceGraph\n";
+  os << "\nNodes:\n";
+  for (auto &idAndNode : nodes) {
+    os << "Node: " << idAndNode.first << "\n";
+    auto it = inEdges.find(idAndNode.first);
+    if (it != inEdges.end()) {
+      for (const auto &e : it->second)
+        os << "  InEdge: " << e.id << " " << e.value << "\n";
+    }
+    it = outEdges.find(idAndNode.first);
+    if (it != outEdges.end()) {
+      for (const auto &e : it->second)
+        os << "  OutEdge: " << e.id << " " << e.value << "\n";
+    }
+  }
+}
+
+void MemRefDependenceGraph::dump() const { print(llvm::errs()); }
@@ -0,0 +1,90 @@
+//===- MemRefLiveness.cpp - Live ranges of buffers ------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the analysis of the live ranges of the buffers of a
+// function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemRefLiveness.h"
+#include "mlir/IR/Function.h"
+#include "mlir/StandardOps/Ops.h"
+#include <algorithm>
+
+using namespace mlir;
+
+using OperationSpans = llvm::DenseMap<Operation *, MemRefLiveness::LiveRange>;
+
+// Number 'op' and the operations nested in it in pre-order from 'number', and
+// record the range of the numbers of each of them in 'spans'.
+static void numberOperations(Operation &op, unsigned &number,
+                             OperationSpans &spans) {
+  unsigned start = number++;
+  for (Region &region : op.getRegions())
+    for (Block &block : region)
+      for (Operation &nested : block)
+        numberOperations(nested, number, spans);
+  spans[&op] = {start, number - 1};
+}
+
+MemRefLiveness::MemRefLiveness(Function *function) {
+  OperationSpans spans;
+  unsigned number = 0;
+  for (Block &block : function->getBody())
+    for (Operation &op : block)
+      numberOperations(op, number, spans);
+
+  function->walk([&](AllocOp allocOp) {
+    Operation *allocInst = allocOp.getOperation();
+    Value *memref = allocOp.getResult();
+    SmallVector<Operation *, 8> users;
+    for (auto &use : memref->getUses()) {
+      users.push_back(use.getOwner());
+      // The transfers started by a 'dma_start' access the buffer until a
+      // 'dma_wait' on their tag completes them.
+      auto dmaStartOp = use.getOwner()->dyn_cast<DmaStartOp>();
+      if (!dmaStartOp || dmaStartOp.getTagMemRef() == memref)
+        continue;
+      for (auto &tagUse : dmaStartOp.getTagMemRef()->getUses())
+        if (tagUse.getOwner()->isa<DmaWaitOp>())
+          users.push_back(tagUse.getOwner());
+    }
+
+    Block *block = allocInst->getBlock();
+    LiveRange liveRange = spans[allocInst];
+    for (Operation *user : users) {
+      Operation *ancestor = block->findAncestorInstInBlock(*user);
+      if (!ancestor)
+        return;
+      liveRange.end = std::max(liveRange.end, spans[ancestor].end);
+    }
+    liveRanges[allocInst] = liveRange;
+  });
+}
+
+Optional<MemRefLiveness::LiveRange>
+MemRefLiveness::getLiveRange(AllocOp allocOp) const {
+  auto it = liveRanges.find(allocOp.getOperation());
+  if (it == liveRanges.end())
+    return None;
+  return it->second;
+}
+
+bool MemRefLiveness::mayInterfere(AllocOp allocA, AllocOp allocB) const {
+  auto liveRangeA = getLiveRange(allocA), liveRangeB = getLiveRange(allocB);
+  return !liveRangeA || !liveRangeB || liveRangeA->overlaps(*liveRangeB);
+}
@@ -0,0 +1,35 @@
+//===- MemoryEffects.cpp - Memory effects of operations -------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the queries of the effects of operations on memory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemoryEffects.h"
+
+using namespace mlir;
+
+bool mlir::getMemoryEffects(Operation *op,
+                            SmallVectorImpl<MemoryEffect> &effects) {
+  if (op->hasNoSideEffect())
+    return true;
+  if (auto effectsOp = op->dyn_cast<MemoryEffectsOpInterface>()) {
+    effectsOp.getEffects(effects);
+    return true;
+  }
+  return false;
+}
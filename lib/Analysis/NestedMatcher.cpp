@@ -80,7 +80,7 @@ unsigned NestedPattern::getDepth() const {
 ///   5. TODO(ntv) Optionally applies actions (lambda), in which case we will
 ///      want to traverse in post-order DFS to avoid invalidating iterators.
 void NestedPattern::matchOne(Operation *op,
-                             SmallVectorImpl<NestedMatch> *matches) {
+                             SmallVectorImpl<NestedMatch> *matches) const {
   if (skip == op) {
     return;
   }
@@ -110,6 +110,26 @@ void NestedPattern::matchOne(Operation *op,
   }
 }
 
+void NestedPattern::matchOne(Operation *op, ArrayRef<NestedPattern> patterns,
+                             ArrayRef<SmallVectorImpl<NestedMatch> *> matches) {
+  assert(patterns.size() == matches.size() &&
+         "expected a list of matches per pattern");
+  for (unsigned i = 0, e = patterns.size(); i != e; ++i)
+    patterns[i].matchOne(op, matches[i]);
+}
+
+void NestedPattern::match(Function *func, ArrayRef<NestedPattern> patterns,
+                          ArrayRef<SmallVectorImpl<NestedMatch> *> matches) {
+  func->walkPostOrder(
+      [&](Operation *op) { matchOne(op, patterns, matches); });
+}
+
+void NestedPattern::match(Operation *op, ArrayRef<NestedPattern> patterns,
+                          ArrayRef<SmallVectorImpl<NestedMatch> *> matches) {
+  op->walkPostOrder(
+      [&](Operation *child) { matchOne(child, patterns, matches); });
+}
+
 static bool isAffineForOp(Operation &op) { return op.isa<AffineForOp>(); }
 
 static bool isAffineIfOp(Operation &op) { return op.isa<AffineIfOp>(); }
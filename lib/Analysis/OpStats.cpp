@@ -15,17 +15,51 @@
 // limitations under the License.
 // =============================================================================
 
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/Module.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/OperationSupport.h"
 #include "mlir/Pass/Pass.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace mlir;
 
+static llvm::cl::OptionCategory clOptionsCategory("print-op-stats options");
+
+static llvm::cl::opt<bool> clPrintOpStatsJSON(
+    "print-op-stats-json",
+    llvm::cl::desc("Print a profile of the IR of the module as JSON, instead "
+                   "of the number of operations of each kind"),
+    llvm::cl::init(false), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned> clNumLargestConstants(
+    "print-op-stats-num-constants",
+    llvm::cl::desc("Number of the largest constants listed in the JSON "
+                   "profile"),
+    llvm::cl::init(10), llvm::cl::cat(clOptionsCategory));
+
 namespace {
+/// The profile of a function.
+struct FunctionProfile {
+  StringRef name;
+  int64_t numOps = 0, numBlocks = 0;
+  unsigned maxDepth = 0;
+};
+
+/// A constant operation, along with the size of its value.
+struct ConstantProfile {
+  Operation *op;
+  StringRef function;
+  size_t bytes;
+};
+
 struct PrintOpStatsPass : public ModulePass<PrintOpStatsPass> {
   explicit PrintOpStatsPass(llvm::raw_ostream &os = llvm::errs()) : os(os) {}
 
@@ -35,19 +69,138 @@ struct PrintOpStatsPass : public ModulePass<PrintOpStatsPass> {
   // Print summary of op stats.
   void printSummary();
 
+  // Print the profile of the IR as JSON.
+  void printJSONProfile();
+
 private:
+  /// Record the operations of 'region', nested 'depth' operations deep in the
+  /// current function.
+  void visitRegion(Region &region, unsigned depth);
+
+  /// Record the attributes of 'op', and its value if it is a constant.
+  void visitAttributes(Operation &op);
+
+  /// Record 'attr', and the attributes it refers to, if seen for the first
+  /// time.
+  void visitAttribute(Attribute attr);
+
   llvm::StringMap<int64_t> opCount;
   llvm::raw_ostream &os;
+
+  /// The additional data of the JSON profile.
+  std::vector<FunctionProfile> functions;
+  std::vector<int64_t> numOpsAtDepth;
+  int64_t numOperands = 0, numUses = 0;
+  llvm::DenseSet<Attribute> attributes;
+  size_t attributeBytes = 0;
+  std::vector<ConstantProfile> constants;
 };
 } // namespace
 
+/// Returns the number of bytes held by the storage of 'attr' for its value,
+/// excluding the other attributes it refers to and the fixed size part of the
+/// storage.
+static size_t getPayloadSize(Attribute attr) {
+  switch (attr.getKind()) {
+  case Attribute::Kind::String:
+    return attr.cast<StringAttr>().getValue().size();
+  case Attribute::Kind::Array:
+    return attr.cast<ArrayAttr>().getValue().size() * sizeof(Attribute);
+  case Attribute::Kind::DenseIntElements:
+  case Attribute::Kind::DenseFPElements:
+    return attr.cast<DenseElementsAttr>().getRawData().size();
+  case Attribute::Kind::OpaqueElements:
+    return attr.cast<OpaqueElementsAttr>().getValue().size();
+  default:
+    return 0;
+  }
+}
+
+/// Returns the number of bytes held by 'attr' for its value, including those
+/// of the attributes it refers to.
+static size_t getTotalPayloadSize(Attribute attr) {
+  size_t bytes = getPayloadSize(attr);
+  if (auto arrayAttr = attr.dyn_cast<ArrayAttr>()) {
+    for (auto element : arrayAttr.getValue())
+      bytes += getTotalPayloadSize(element);
+  } else if (auto sparseAttr = attr.dyn_cast<SparseElementsAttr>()) {
+    bytes += getTotalPayloadSize(sparseAttr.getIndices());
+    bytes += getTotalPayloadSize(sparseAttr.getValues());
+  }
+  return bytes;
+}
+
 void PrintOpStatsPass::runOnModule() {
   opCount.clear();
+  functions.clear();
+  numOpsAtDepth.clear();
+  numOperands = numUses = 0;
+  attributes.clear();
+  attributeBytes = 0;
+  constants.clear();
 
   // Compute the operation statistics for each function in the module.
-  for (auto &fn : getModule())
-    fn.walk([&](Operation *op) { ++opCount[op->getName().getStringRef()]; });
-  printSummary();
+  if (!clPrintOpStatsJSON) {
+    for (auto &fn : getModule())
+      fn.walk([&](Operation *op) { ++opCount[op->getName().getStringRef()]; });
+    return printSummary();
+  }
+
+  for (auto &fn : getModule()) {
+    if (fn.isExternal())
+      continue;
+    functions.emplace_back();
+    functions.back().name = fn.getName().strref();
+    visitRegion(fn.getBody(), /*depth=*/0);
+  }
+  printJSONProfile();
+}
+
+void PrintOpStatsPass::visitRegion(Region &region, unsigned depth) {
+  auto &function = functions.back();
+  function.maxDepth = std::max(function.maxDepth, depth);
+  if (numOpsAtDepth.size() <= depth)
+    numOpsAtDepth.resize(depth + 1);
+
+  for (auto &block : region) {
+    ++function.numBlocks;
+    for (auto &op : block) {
+      ++function.numOps;
+      ++numOpsAtDepth[depth];
+      ++opCount[op.getName().getStringRef()];
+      numOperands += op.getNumOperands();
+      for (auto *result : op.getResults())
+        numUses += std::distance(result->use_begin(), result->use_end());
+      visitAttributes(op);
+      for (auto &nestedRegion : op.getRegions())
+        visitRegion(nestedRegion, depth + 1);
+    }
+  }
+}
+
+void PrintOpStatsPass::visitAttributes(Operation &op) {
+  for (auto &namedAttr : op.getAttrs())
+    visitAttribute(namedAttr.second);
+
+  Attribute value;
+  if (op.getNumResults() != 1 ||
+      !matchPattern(op.getResult(0), m_Constant(&value)))
+    return;
+  if (size_t bytes = getTotalPayloadSize(value))
+    constants.push_back({&op, functions.back().name, bytes});
+}
+
+void PrintOpStatsPass::visitAttribute(Attribute attr) {
+  if (!attributes.insert(attr).second)
+    return;
+  attributeBytes += getPayloadSize(attr);
+  if (auto arrayAttr = attr.dyn_cast<ArrayAttr>()) {
+    for (auto element : arrayAttr.getValue())
+      visitAttribute(element);
+  } else if (auto sparseAttr = attr.dyn_cast<SparseElementsAttr>()) {
+    visitAttribute(sparseAttr.getIndices());
+    visitAttribute(sparseAttr.getValues());
+  }
 }
 
 void PrintOpStatsPass::printSummary() {
@@ -89,5 +242,69 @@ void PrintOpStatsPass::printSummary() {
   }
 }
 
+/// Print the profile of the IR of the module as a JSON object.
+void PrintOpStatsPass::printJSONProfile() {
+  // The dialect of an operation is identified by the prefix of its name, as for
+  // the summary.
+  int64_t numOps = 0;
+  llvm::json::Object operations, dialects;
+  llvm::StringMap<int64_t> dialectCount;
+  for (auto &it : opCount) {
+    numOps += it.second;
+    operations[it.first()] = it.second;
+    auto splitName = it.first().split('.');
+    dialectCount[splitName.second.empty() ? "" : splitName.first] += it.second;
+  }
+  for (auto &it : dialectCount)
+    dialects[it.first()] = it.second;
+
+  llvm::json::Array functionArray;
+  for (auto &function : functions)
+    functionArray.push_back(
+        llvm::json::Object{{"name", function.name},
+                           {"numOperations", function.numOps},
+                           {"numBlocks", function.numBlocks},
+                           {"maxNestingDepth", function.maxDepth}});
+
+  // Keep the largest constants, in the order of the module among those of the
+  // same size.
+  unsigned numConstants =
+      std::min<size_t>(clNumLargestConstants, constants.size());
+  std::stable_sort(constants.begin(), constants.end(),
+                   [](const ConstantProfile &lhs, const ConstantProfile &rhs) {
+                     return lhs.bytes > rhs.bytes;
+                   });
+  llvm::json::Array constantArray;
+  for (unsigned i = 0; i != numConstants; ++i) {
+    auto &constant = constants[i];
+    std::string type;
+    llvm::raw_string_ostream typeOS(type);
+    constant.op->getResult(0)->getType().print(typeOS);
+    constantArray.push_back(llvm::json::Object{
+        {"function", constant.function},
+        {"operation", constant.op->getName().getStringRef()},
+        {"type", std::move(typeOS.str())},
+        {"bytes", static_cast<int64_t>(constant.bytes)}});
+  }
+
+  auto getAverage = [&](int64_t total) {
+    return numOps ? double(total) / numOps : 0.0;
+  };
+  os << llvm::json::Value(llvm::json::Object{
+            {"numOperations", numOps},
+            {"operations", std::move(operations)},
+            {"dialects", std::move(dialects)},
+            {"functions", std::move(functionArray)},
+            {"nestingDepths", llvm::json::Array(numOpsAtDepth)},
+            {"averageOperands", getAverage(numOperands)},
+            {"averageUses", getAverage(numUses)},
+            {"attributes",
+             llvm::json::Object{
+                 {"numUnique", static_cast<int64_t>(attributes.size())},
+                 {"bytes", static_cast<int64_t>(attributeBytes)}}},
+            {"largestConstants", std::move(constantArray)}})
+     << "\n";
+}
+
 static PassRegistration<PrintOpStatsPass>
     pass("print-op-stats", "Print statistics of operations");
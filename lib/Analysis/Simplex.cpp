@@ -0,0 +1,367 @@
+//===- Simplex.cpp - MLIR Simplex Class -----------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// Implements a simplex tableau over the rationals, following the design of the
+// tableaux of isl and of the Omega library: the variables are not split into
+// non-negative parts, instead each unknown is marked as restricted in sign or
+// not.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/Simplex.h"
+#include "mlir/Analysis/AffineStructures.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+/// Returns the fraction num / den in lowest terms, with a positive `den`.
+static Fraction getReducedFraction(int64_t num, int64_t den) {
+  int64_t gcd = llvm::GreatestCommonDivisor64(std::abs(num), den);
+  return Fraction(num / gcd, den / gcd);
+}
+
+Simplex::Simplex(unsigned numVars) : nRow(0), nCol(numVars + 2) {
+  colUnknown.push_back(0);
+  colUnknown.push_back(0);
+  for (unsigned i = 0; i < numVars; ++i) {
+    var.push_back(Unknown(/*isRow=*/false, /*isRestricted=*/false, i + 2));
+    colUnknown.push_back(~static_cast<int>(i));
+  }
+}
+
+Simplex::Simplex(const FlatAffineConstraints &cst) : Simplex(cst.getNumIds()) {
+  for (unsigned i = 0, e = cst.getNumEqualities(); i < e; ++i)
+    addEquality(cst.getEquality(i));
+  for (unsigned i = 0, e = cst.getNumInequalities(); i < e; ++i)
+    addInequality(cst.getInequality(i));
+}
+
+int64_t Simplex::add(int64_t a, int64_t b) {
+  int64_t result;
+  if (llvm::AddOverflow(a, b, result))
+    overflowed = true;
+  return result;
+}
+
+int64_t Simplex::mul(int64_t a, int64_t b) {
+  int64_t result;
+  if (llvm::MulOverflow(a, b, result))
+    overflowed = true;
+  return result;
+}
+
+void Simplex::normalizeRow(unsigned row) {
+  uint64_t gcd = 0;
+  for (unsigned col = 0; col < nCol && gcd != 1; ++col)
+    gcd = llvm::GreatestCommonDivisor64(gcd, std::abs(at(row, col)));
+  if (gcd <= 1)
+    return;
+  for (unsigned col = 0; col < nCol; ++col)
+    at(row, col) /= static_cast<int64_t>(gcd);
+}
+
+unsigned Simplex::addRow(ArrayRef<int64_t> coeffs, bool isRestricted) {
+  assert(coeffs.size() == var.size() + 1 && "incorrect number of coefficients");
+  unsigned row = nRow++;
+  tableau.resize(nRow * nCol, 0);
+  rowUnknown.push_back(con.size());
+  con.push_back(Unknown(/*isRow=*/true, isRestricted, row));
+
+  at(row, 0) = 1;
+  at(row, 1) = coeffs.back();
+  for (unsigned i = 0, e = var.size(); i < e; ++i) {
+    if (coeffs[i] == 0)
+      continue;
+    const Unknown &u = var[i];
+    if (!u.isRow) {
+      at(row, u.pos) = add(at(row, u.pos), coeffs[i]);
+      continue;
+    }
+    // Substitute the expression of the variable, bringing both rows to the
+    // least common multiple of their denominators.
+    int64_t rowDen = at(row, 0), varDen = at(u.pos, 0);
+    int64_t gcd = llvm::GreatestCommonDivisor64(rowDen, varDen);
+    int64_t rowScale = varDen / gcd;
+    int64_t varScale = mul(coeffs[i], rowDen / gcd);
+    at(row, 0) = mul(rowDen, rowScale);
+    for (unsigned col = 1; col < nCol; ++col)
+      at(row, col) =
+          add(mul(at(row, col), rowScale), mul(at(u.pos, col), varScale));
+    normalizeRow(row);
+  }
+  return row;
+}
+
+void Simplex::pivot(unsigned pivotRow, unsigned pivotCol) {
+  assert(pivotCol >= 2 && "expected a column with an unknown");
+  int rowIndex = rowUnknown[pivotRow], colIndex = colUnknown[pivotCol];
+  Unknown &rowU = unknownFromIndex(rowIndex);
+  Unknown &colU = unknownFromIndex(colIndex);
+  rowU.isRow = false;
+  rowU.pos = pivotCol;
+  colU.isRow = true;
+  colU.pos = pivotRow;
+  rowUnknown[pivotRow] = colIndex;
+  colUnknown[pivotCol] = rowIndex;
+
+  // The row d * r = c + a * x + sum(b_j * y_j) becomes
+  // a * x = d * r - c - sum(b_j * y_j), the denominator being kept positive.
+  std::swap(at(pivotRow, 0), at(pivotRow, pivotCol));
+  if (at(pivotRow, 0) < 0) {
+    at(pivotRow, 0) = -at(pivotRow, 0);
+    at(pivotRow, pivotCol) = -at(pivotRow, pivotCol);
+  } else {
+    for (unsigned col = 1; col < nCol; ++col)
+      if (col != pivotCol)
+        at(pivotRow, col) = -at(pivotRow, col);
+  }
+  normalizeRow(pivotRow);
+
+  // Substitute the new expression of x in the other rows.
+  for (unsigned row = 0; row < nRow; ++row) {
+    if (row == pivotRow || at(row, pivotCol) == 0)
+      continue;
+    int64_t coeff = at(row, pivotCol);
+    at(row, 0) = mul(at(row, 0), at(pivotRow, 0));
+    for (unsigned col = 1; col < nCol; ++col) {
+      if (col == pivotCol)
+        continue;
+      at(row, col) = add(mul(at(row, col), at(pivotRow, 0)),
+                         mul(coeff, at(pivotRow, col)));
+    }
+    at(row, pivotCol) = mul(coeff, at(pivotRow, pivotCol));
+    normalizeRow(row);
+  }
+}
+
+Optional<unsigned> Simplex::findPivotCol(unsigned row,
+                                         Direction direction) const {
+  Optional<unsigned> pivotCol;
+  for (unsigned col = 2; col < nCol; ++col) {
+    int64_t coeff = at(row, col);
+    if (coeff == 0)
+      continue;
+    // The restricted column unknowns are zero, so they can only increase.
+    if (unknownFromIndex(colUnknown[col]).isRestricted &&
+        (coeff > 0) != (direction == Direction::Up))
+      continue;
+    if (!pivotCol || getRank(colUnknown[col]) < getRank(colUnknown[*pivotCol]))
+      pivotCol = col;
+  }
+  return pivotCol;
+}
+
+Optional<unsigned> Simplex::findPivotRow(unsigned skipRow, Direction direction,
+                                         unsigned col) {
+  // Whether the column unknown increases.
+  bool increases = (at(skipRow, col) > 0) == (direction == Direction::Up);
+  Optional<unsigned> pivotRow;
+  int64_t pivotValue = 0, pivotCoeff = 1;
+  for (unsigned row = 0; row < nRow; ++row) {
+    if (row == skipRow || !unknownFromIndex(rowUnknown[row]).isRestricted)
+      continue;
+    int64_t coeff = at(row, col);
+    if (coeff == 0 || (coeff < 0) != increases)
+      continue;
+    // The row reaches zero after a move of value / |coeff|; keep the smallest
+    // move, breaking the ties with Bland's rule.
+    int64_t value = at(row, 1);
+    coeff = std::abs(coeff);
+    if (pivotRow) {
+      int64_t lhs = mul(value, pivotCoeff), rhs = mul(pivotValue, coeff);
+      if (lhs > rhs || (lhs == rhs && getRank(rowUnknown[row]) >
+                                          getRank(rowUnknown[*pivotRow])))
+        continue;
+    }
+    pivotRow = row;
+    pivotValue = value;
+    pivotCoeff = coeff;
+  }
+  return pivotRow;
+}
+
+LogicalResult Simplex::restoreRow(unsigned row) {
+  int index = rowUnknown[row];
+  while (!overflowed) {
+    const Unknown &u = unknownFromIndex(index);
+    if (!u.isRow || at(u.pos, 1) >= 0)
+      return success();
+    Optional<unsigned> col = findPivotCol(u.pos, Direction::Up);
+    if (!col)
+      return failure();
+    // Pivot the row itself if it reaches zero before any other restricted
+    // row, and the blocking row otherwise.
+    Optional<unsigned> blockingRow = findPivotRow(u.pos, Direction::Up, *col);
+    if (blockingRow) {
+      int64_t blockingMove =
+          mul(at(*blockingRow, 1), std::abs(at(u.pos, *col)));
+      int64_t rowMove = mul(-at(u.pos, 1), std::abs(at(*blockingRow, *col)));
+      if (blockingMove < rowMove) {
+        pivot(*blockingRow, *col);
+        continue;
+      }
+    }
+    pivot(u.pos, *col);
+  }
+  // The tableau is meaningless after an overflow, which the queries check.
+  return success();
+}
+
+void Simplex::addInequality(ArrayRef<int64_t> coeffs) {
+  if (empty)
+    return;
+  unsigned row = addRow(coeffs, /*isRestricted=*/true);
+  if (failed(restoreRow(row)))
+    empty = true;
+}
+
+void Simplex::addEquality(ArrayRef<int64_t> coeffs) {
+  addInequality(coeffs);
+  SmallVector<int64_t, 8> negated;
+  negated.reserve(coeffs.size());
+  for (int64_t coeff : coeffs)
+    negated.push_back(-coeff);
+  addInequality(negated);
+}
+
+Fraction Simplex::getSampleValue(unsigned varIndex) const {
+  const Unknown &u = var[varIndex];
+  if (!u.isRow)
+    return Fraction(0, 1);
+  return getReducedFraction(at(u.pos, 1), at(u.pos, 0));
+}
+
+Optional<Fraction> Simplex::computeOptimum(Direction direction,
+                                           ArrayRef<int64_t> coeffs) const {
+  if (empty || overflowed)
+    return None;
+
+  // Optimize an unrestricted row for the expression in a copy of the tableau.
+  // Only the restricted rows are pivoted out of the basis, so the expression
+  // stays in its row.
+  Simplex tmp(*this);
+  unsigned row = tmp.addRow(coeffs, /*isRestricted=*/false);
+  while (!tmp.overflowed) {
+    Optional<unsigned> col = tmp.findPivotCol(row, direction);
+    if (!col)
+      break;
+    Optional<unsigned> pivotRow = tmp.findPivotRow(row, direction, *col);
+    if (!pivotRow)
+      return None;
+    tmp.pivot(*pivotRow, *col);
+  }
+  if (tmp.overflowed)
+    return None;
+  return getReducedFraction(tmp.at(row, 1), tmp.at(row, 0));
+}
+
+Optional<SmallVector<Fraction, 8>>
+Simplex::computeRationalLexOptimum(Direction direction) const {
+  // Optimize the variables one after the other, fixing each of them to its
+  // optimum before moving on to the next one.
+  Simplex tmp(*this);
+  SmallVector<Fraction, 8> optimum;
+  SmallVector<int64_t, 8> coeffs(var.size() + 1, 0);
+  for (unsigned i = 0, e = var.size(); i < e; ++i) {
+    coeffs[i] = 1;
+    Optional<Fraction> value = tmp.computeOptimum(direction, coeffs);
+    if (!value)
+      return None;
+    optimum.push_back(*value);
+    coeffs[i] = value->den;
+    coeffs.back() = -value->num;
+    tmp.addEquality(coeffs);
+    coeffs[i] = 0;
+    coeffs.back() = 0;
+  }
+  if (tmp.overflowed)
+    return None;
+  return optimum;
+}
+
+Optional<bool> Simplex::isIntegerEmpty(unsigned maxNodes) const {
+  unsigned remainingNodes = maxNodes;
+  return isIntegerEmptyImpl(remainingNodes);
+}
+
+Optional<bool> Simplex::isIntegerEmptyImpl(unsigned &remainingNodes) const {
+  if (overflowed)
+    return None;
+  if (empty)
+    return true;
+  if (remainingNodes == 0)
+    return None;
+  --remainingNodes;
+
+  // Branch on the first variable that has a fractional value in the sample
+  // point, which is an integer solution if there are none.
+  unsigned numVars = var.size();
+  unsigned branchVar = 0;
+  for (; branchVar < numVars; ++branchVar)
+    if (!getSampleValue(branchVar).isIntegral())
+      break;
+  if (branchVar == numVars)
+    return false;
+
+  // x <= floor(v), i.e., -x + floor(v) >= 0.
+  int64_t floor = getSampleValue(branchVar).floor();
+  SmallVector<int64_t, 8> coeffs(numVars + 1, 0);
+  coeffs[branchVar] = -1;
+  coeffs.back() = floor;
+  Simplex lower(*this);
+  lower.addInequality(coeffs);
+  Optional<bool> isLowerEmpty = lower.isIntegerEmptyImpl(remainingNodes);
+  if (!isLowerEmpty.hasValue() || !isLowerEmpty.getValue())
+    return isLowerEmpty;
+
+  // x >= floor(v) + 1, i.e., x - floor(v) - 1 >= 0.
+  coeffs[branchVar] = 1;
+  coeffs.back() = -floor - 1;
+  Simplex upper(*this);
+  upper.addInequality(coeffs);
+  return upper.isIntegerEmptyImpl(remainingNodes);
+}
+
+void Simplex::print(raw_ostream &os) const {
+  os << "rows = " << nRow << ", columns = " << nCol << "\n";
+  if (empty)
+    os << "Simplex marked empty!\n";
+  if (overflowed)
+    os << "Simplex overflowed!\n";
+  auto printUnknown = [&](int index) {
+    if (index >= 0)
+      os << "c" << index;
+    else
+      os << "x" << ~index;
+  };
+  os << "columns:";
+  for (unsigned col = 2; col < nCol; ++col) {
+    os << " ";
+    printUnknown(colUnknown[col]);
+  }
+  os << "\n";
+  for (unsigned row = 0; row < nRow; ++row) {
+    printUnknown(rowUnknown[row]);
+    os << ":";
+    for (unsigned col = 0; col < nCol; ++col)
+      os << " " << at(row, col);
+    os << "\n";
+  }
+}
+
+void Simplex::dump() const { print(llvm::errs()); }
@@ -27,7 +27,6 @@
 #include "mlir/Support/STLExtras.h"
 
 #include "llvm/ADT/SetVector.h"
-#include <type_traits>
 
 ///
 /// Implements Analysis functions specific to slicing in Function.
@@ -38,45 +37,98 @@ using namespace mlir;
 using llvm::DenseSet;
 using llvm::SetVector;
 
-static void getForwardSliceImpl(Operation *op,
-                                SetVector<Operation *> *forwardSlice,
-                                TransitiveFilter filter) {
-  if (!op) {
+namespace {
+/// An operation on the stack of an iterative DFS.  The children of the
+/// operation on top of the stack are the last ones of the list of children
+/// shared by the stack, from 'beginChild' on.
+struct DFSFrame {
+  Operation *op;
+  unsigned beginChild;
+  unsigned nextChild;
+};
+} // end anonymous namespace
+
+/// Visits the operations reachable from 'root' in DFS postorder, without
+/// recursion, so that long use-def chains don't overflow the stack.  The
+/// children of an operation are appended to a list by 'appendChildren'.  A
+/// child is only entered if 'shouldEnter' returns true when the DFS reaches it,
+/// i.e. after the previous children of its parent were visited, like in a
+/// recursive implementation checking it before each call.  The root is entered
+/// if 'shouldEnterRoot' is true.  'postVisit' is called on each entered
+/// operation once all its children are visited.
+template <typename AppendChildrenFn, typename ShouldEnterFn,
+          typename PostVisitFn>
+static void visitPostorder(Operation *root, bool shouldEnterRoot,
+                           AppendChildrenFn appendChildren,
+                           ShouldEnterFn shouldEnter, PostVisitFn postVisit) {
+  if (!shouldEnterRoot)
     return;
+  SmallVector<Operation *, 16> children;
+  SmallVector<DFSFrame, 16> stack;
+  auto enter = [&](Operation *op) {
+    unsigned beginChild = children.size();
+    appendChildren(op, children);
+    stack.push_back({op, beginChild, beginChild});
+  };
+
+  enter(root);
+  while (!stack.empty()) {
+    auto &frame = stack.back();
+    if (frame.nextChild == children.size()) {
+      Operation *op = frame.op;
+      children.resize(frame.beginChild);
+      stack.pop_back();
+      postVisit(op);
+      continue;
+    }
+    Operation *child = children[frame.nextChild++];
+    if (shouldEnter(child))
+      enter(child);
   }
+}
 
-  // Evaluate whether we should keep this use.
-  // This is useful in particular to implement scoping; i.e. return the
-  // transitive forwardSlice in the current scope.
-  if (!filter(op)) {
+// Appends to 'users' the users of the results of 'op', or of the induction
+// variable of 'op' if it is an affine.for.
+static void appendUsers(Operation *op, SmallVectorImpl<Operation *> &users) {
+  if (auto forOp = op->dyn_cast<AffineForOp>()) {
+    for (auto &u : forOp.getInductionVar()->getUses())
+      users.push_back(u.getOwner());
     return;
   }
+  for (auto *result : op->getResults())
+    for (auto &u : result->getUses())
+      users.push_back(u.getOwner());
+}
 
-  if (auto forOp = op->dyn_cast<AffineForOp>()) {
-    for (auto &u : forOp.getInductionVar()->getUses()) {
-      auto *ownerInst = u.getOwner();
-      if (forwardSlice->count(ownerInst) == 0) {
-        getForwardSliceImpl(ownerInst, forwardSlice, filter);
-      }
-    }
-  } else {
-    assert(op->getNumResults() <= 1 && "NYI: multiple results");
-    if (op->getNumResults() > 0) {
-      for (auto &u : op->getResult(0)->getUses()) {
-        auto *ownerInst = u.getOwner();
-        if (forwardSlice->count(ownerInst) == 0) {
-          getForwardSliceImpl(ownerInst, forwardSlice, filter);
-        }
-      }
-    }
-  }
+// Appends to 'defs' the operations defining the operands of 'op', or null for
+// the operands that are block arguments.
+static void appendDefs(Operation *op, SmallVectorImpl<Operation *> &defs) {
+  for (auto *operand : op->getOperands())
+    defs.push_back(operand->getDefiningOp());
+}
 
-  forwardSlice->insert(op);
+// Fills 'forwardSlice' with the transitive users of 'op' in postorder, not
+// going through the operations of 'processed', whose whole forward slice is
+// known to be in 'forwardSlice' already, if it is not null.
+static void getForwardSliceImpl(Operation *op,
+                                SetVector<Operation *> *forwardSlice,
+                                TransitiveFilter filter,
+                                const DenseSet<Operation *> *processed) {
+  // Evaluate whether we should keep each use.
+  // This is useful in particular to implement scoping; i.e. return the
+  // transitive forwardSlice in the current scope.
+  visitPostorder(
+      op, op && filter(op), appendUsers,
+      [&](Operation *user) {
+        return forwardSlice->count(user) == 0 &&
+               (!processed || processed->count(user) == 0) && filter(user);
+      },
+      [&](Operation *user) { forwardSlice->insert(user); });
 }
 
 void mlir::getForwardSlice(Operation *op, SetVector<Operation *> *forwardSlice,
                            TransitiveFilter filter) {
-  getForwardSliceImpl(op, forwardSlice, filter);
+  getForwardSliceImpl(op, forwardSlice, filter, /*processed=*/nullptr);
   // Don't insert the top level operation, we just queried on it and don't
   // want it in the results.
   forwardSlice->remove(op);
@@ -88,34 +140,29 @@ void mlir::getForwardSlice(Operation *op, SetVector<Operation *> *forwardSlice,
   forwardSlice->insert(v.rbegin(), v.rend());
 }
 
+// Fills 'backwardSlice' with the transitive definitions of 'op' in postorder,
+// not going through the operations of 'processed', whose whole backward slice
+// is known to be in 'backwardSlice' already, if it is not null.
 static void getBackwardSliceImpl(Operation *op,
                                  SetVector<Operation *> *backwardSlice,
-                                 TransitiveFilter filter) {
-  if (!op) {
-    return;
-  }
-
-  // Evaluate whether we should keep this def.
+                                 TransitiveFilter filter,
+                                 const DenseSet<Operation *> *processed) {
+  // Evaluate whether we should keep each def.
   // This is useful in particular to implement scoping; i.e. return the
   // transitive forwardSlice in the current scope.
-  if (!filter(op)) {
-    return;
-  }
-
-  for (auto *operand : op->getOperands()) {
-    auto *op = operand->getDefiningOp();
-    if (backwardSlice->count(op) == 0) {
-      getBackwardSliceImpl(op, backwardSlice, filter);
-    }
-  }
-
-  backwardSlice->insert(op);
+  visitPostorder(
+      op, op && filter(op), appendDefs,
+      [&](Operation *def) {
+        return def && backwardSlice->count(def) == 0 &&
+               (!processed || processed->count(def) == 0) && filter(def);
+      },
+      [&](Operation *def) { backwardSlice->insert(def); });
 }
 
 void mlir::getBackwardSlice(Operation *op,
                             SetVector<Operation *> *backwardSlice,
                             TransitiveFilter filter) {
-  getBackwardSliceImpl(op, backwardSlice, filter);
+  getBackwardSliceImpl(op, backwardSlice, filter, /*processed=*/nullptr);
 
   // Don't insert the top level operation, we just queried on it and don't
   // want it in the results.
@@ -128,6 +175,12 @@ SetVector<Operation *> mlir::getSlice(Operation *op,
   SetVector<Operation *> slice;
   slice.insert(op);
 
+  // The operations of the slice whose backward and forward slices were
+  // inserted in it.  The slices of the next operations don't need to go
+  // through them: all the operations they reach are in the slice already. This
+  // avoids traversing the same use-def chains for each operation of the slice,
+  // and yields the same slice in the same order.
+  DenseSet<Operation *> processed;
   unsigned currentIndex = 0;
   SetVector<Operation *> backwardSlice;
   SetVector<Operation *> forwardSlice;
@@ -135,69 +188,54 @@ SetVector<Operation *> mlir::getSlice(Operation *op,
     auto *currentInst = (slice)[currentIndex];
     // Compute and insert the backwardSlice starting from currentInst.
     backwardSlice.clear();
-    getBackwardSlice(currentInst, &backwardSlice, backwardFilter);
+    getBackwardSliceImpl(currentInst, &backwardSlice, backwardFilter,
+                         &processed);
+    backwardSlice.remove(currentInst);
     slice.insert(backwardSlice.begin(), backwardSlice.end());
 
     // Compute and insert the forwardSlice starting from currentInst.
     forwardSlice.clear();
-    getForwardSlice(currentInst, &forwardSlice, forwardFilter);
-    slice.insert(forwardSlice.begin(), forwardSlice.end());
+    getForwardSliceImpl(currentInst, &forwardSlice, forwardFilter, &processed);
+    forwardSlice.remove(currentInst);
+    slice.insert(forwardSlice.rbegin(), forwardSlice.rend());
+    processed.insert(currentInst);
     ++currentIndex;
   }
   return topologicalSort(slice);
 }
 
-namespace {
-/// DFS post-order implementation that maintains a global count to work across
-/// multiple invocations, to help implement topological sort on multi-root DAGs.
-/// We traverse all operations but only record the ones that appear in
-/// `toSort` for the final result.
-struct DFSState {
-  DFSState(const SetVector<Operation *> &set)
-      : toSort(set), topologicalCounts(), seen() {}
-  const SetVector<Operation *> &toSort;
-  SmallVector<Operation *, 16> topologicalCounts;
-  DenseSet<Operation *> seen;
-};
-} // namespace
-
-static void DFSPostorder(Operation *current, DFSState *state) {
-  assert(current->getNumResults() <= 1 && "NYI: multi-result");
-  if (current->getNumResults() > 0) {
-    for (auto &u : current->getResult(0)->getUses()) {
-      auto *op = u.getOwner();
-      DFSPostorder(op, state);
-    }
-  }
-  bool inserted;
-  using IterTy = decltype(state->seen.begin());
-  IterTy iter;
-  std::tie(iter, inserted) = state->seen.insert(current);
-  if (inserted) {
-    if (state->toSort.count(current) > 0) {
-      state->topologicalCounts.push_back(current);
-    }
-  }
-}
-
 SetVector<Operation *>
 mlir::topologicalSort(const SetVector<Operation *> &toSort) {
   if (toSort.empty()) {
     return toSort;
   }
 
-  // Run from each root with global count and `seen` set.
-  DFSState state(toSort);
+  // Run a DFS post-order from each root, with a `seen` set shared by all of
+  // them, so that each operation is visited once.  All the operations are
+  // traversed but only the ones that appear in `toSort` are recorded for the
+  // final result.
+  SmallVector<Operation *, 16> postorder;
+  DenseSet<Operation *> seen;
+  auto markSeen = [&](Operation *op) { return seen.insert(op).second; };
   for (auto *s : toSort) {
     assert(toSort.count(s) == 1 && "NYI: multi-sets not supported");
-    DFSPostorder(s, &state);
+    visitPostorder(
+        s, markSeen(s),
+        [](Operation *op, SmallVectorImpl<Operation *> &users) {
+          for (auto *result : op->getResults())
+            for (auto &u : result->getUses())
+              users.push_back(u.getOwner());
+        },
+        markSeen,
+        [&](Operation *op) {
+          if (toSort.count(op) > 0)
+            postorder.push_back(op);
+        });
   }
 
   // Reorder and return.
   SetVector<Operation *> res;
-  for (auto it = state.topologicalCounts.rbegin(),
-            eit = state.topologicalCounts.rend();
-       it != eit; ++it) {
+  for (auto it = postorder.rbegin(), eit = postorder.rend(); it != eit; ++it) {
     res.insert(*it);
   }
   return res;
@@ -0,0 +1,111 @@
+//===- TestIntegerRanges.cpp - Test the ranges of index values ------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass to test the analysis of the ranges of index
+// values.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/IntegerRangeAnalysis.h"
+#include "mlir/Analysis/Passes.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
+
+using namespace mlir;
+
+namespace {
+
+struct TestIntegerRanges : public FunctionPass<TestIntegerRanges> {
+  void runOnFunction() override;
+};
+
+} // end anonymous namespace
+
+FunctionPassBase *mlir::createIntegerRangeTestPass() {
+  return new TestIntegerRanges();
+}
+
+// Prints 'bound', naming its symbol after the function argument, the loop or
+// the op defining it.
+static void printBound(llvm::raw_ostream &os, Optional<SymbolicBound> bound) {
+  if (!bound) {
+    os << "?";
+    return;
+  }
+  auto *symbol = bound->symbol;
+  if (auto *arg = dyn_cast<BlockArgument>(symbol))
+    os << (isForInductionVar(arg) ? "iv" : "arg") << arg->getArgNumber();
+  else
+    os << symbol->getDefiningOp()->getName();
+  if (bound->offset != 0)
+    os << (bound->offset > 0 ? " + " : " - ") << std::abs(bound->offset);
+}
+
+// Prints 'range', with the symbolic bounds if they are bounds on other values
+// than 'value'.
+static void printRange(llvm::raw_ostream &os, const IntegerRange &range,
+                       Value *value) {
+  auto printConstant = [&](Optional<int64_t> bound) {
+    if (bound)
+      os << *bound;
+    else
+      os << "?";
+  };
+  os << "range [";
+  printConstant(range.lower);
+  os << ", ";
+  printConstant(range.upper);
+  os << "]";
+  auto isSelf = [&](Optional<SymbolicBound> bound) {
+    return !bound || bound->symbol == value;
+  };
+  if (isSelf(range.symbolicLower) && isSelf(range.symbolicUpper))
+    return;
+  os << " symbolic [";
+  printBound(os, range.symbolicLower);
+  os << ", ";
+  printBound(os, range.symbolicUpper);
+  os << "]";
+}
+
+// Emits a note with the range of the IV of each 'affine.for' op, and of the
+// index result of each op but the constants.
+void TestIntegerRanges::runOnFunction() {
+  auto &ranges = getAnalysis<IntegerRangeAnalysis>();
+  getFunction().walk([&](Operation *op) {
+    Value *value = nullptr;
+    if (auto forOp = op->dyn_cast<AffineForOp>())
+      value = forOp.getInductionVar();
+    else if (op->getNumResults() == 1 && !op->isa<ConstantOp>() &&
+             op->getResult(0)->getType().isIndex())
+      value = op->getResult(0);
+    if (!value)
+      return;
+    std::string message;
+    llvm::raw_string_ostream os(message);
+    printRange(os, ranges.getRange(value), value);
+    op->emitNote(os.str());
+  });
+  markAllAnalysesPreserved();
+}
+
+static PassRegistration<TestIntegerRanges>
+    pass("test-integer-ranges", "Test the ranges of index values");
@@ -45,8 +45,9 @@ FunctionPassBase *mlir::createParallelismDetectionTestPass() {
 void TestParallelismDetection::runOnFunction() {
   Function &f = getFunction();
   FuncBuilder b(f);
-  f.walk<AffineForOp>([&](AffineForOp forOp) {
-    if (isLoopParallel(forOp))
+  auto &parallelism = getAnalysis<LoopParallelismAnalysis>();
+  f.walk([&](AffineForOp forOp) {
+    if (parallelism.isParallel(forOp))
       forOp.emitNote("parallel loop");
   });
 }
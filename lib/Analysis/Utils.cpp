@@ -27,6 +27,7 @@
 #include "mlir/Analysis/AffineStructures.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/StandardOps/Ops.h"
+#include "mlir/VectorOps/VectorOps.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -175,7 +176,10 @@ LogicalResult MemRefRegion::unionBoundingBox(const MemRefRegion &other) {
 // (dma_start, dma_wait).
 LogicalResult MemRefRegion::compute(Operation *op, unsigned loopDepth,
                                     ComputationSliceState *sliceState) {
-  assert((op->isa<LoadOp>() || op->isa<StoreOp>()) && "load/store op expected");
+  assert((op->isa<LoadOp>() || op->isa<StoreOp>() ||
+          op->isa<VectorTransferReadOp>() ||
+          op->isa<VectorTransferWriteOp>()) &&
+         "load/store or vector transfer op expected");
 
   MemRefAccess access(op);
   memref = access.memref;
@@ -322,15 +326,16 @@ static unsigned getMemRefEltSizeInBytes(MemRefType memRefType) {
   return llvm::divideCeil(sizeInBits, 8);
 }
 
-// Returns the size of the region.
+// Returns the size of the region.  The region is in the index space of the
+// memref, so its size doesn't depend on a strided layout of the memref.
 Optional<int64_t> MemRefRegion::getRegionSize() {
   auto memRefType = memref->getType().cast<MemRefType>();
 
-  auto layoutMaps = memRefType.getAffineMaps();
-  if (layoutMaps.size() > 1 ||
-      (layoutMaps.size() == 1 && !layoutMaps[0].isIdentity())) {
-    LLVM_DEBUG(llvm::dbgs() << "Non-identity layout map not yet supported\n");
-    return false;
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memRefType, strides, offset))) {
+    LLVM_DEBUG(llvm::dbgs() << "Non-strided layout map not yet supported\n");
+    return None;
   }
 
   // Indices to use for the DmaStart op.
@@ -426,6 +431,67 @@ template LogicalResult mlir::boundCheckLoadOrStoreOp(LoadOp loadOp,
 template LogicalResult mlir::boundCheckLoadOrStoreOp(StoreOp storeOp,
                                                      bool emitError);
 
+// Returns true if the region of 'memRefType' accessed by 'op' at 'indices',
+// extended by 'extents' elements from each start position, provably lies
+// within the static bounds of the memref for any iteration of the surrounding
+// loops.
+static bool isAccessInBounds(Operation *op, Operation::operand_range indices,
+                             MemRefType memRefType, ArrayRef<int64_t> extents) {
+  if (!memRefType.hasStaticShape())
+    return false;
+  // MemRefRegion::compute expects affine indices.
+  for (auto *index : indices)
+    if (!isValidDim(index))
+      return false;
+
+  MemRefRegion region(op->getLoc());
+  if (failed(region.compute(op, /*loopDepth=*/0)))
+    return false;
+
+  // Check that no start position is negative or followed by fewer elements
+  // than the extent of the access.
+  for (unsigned r = 0, rank = memRefType.getRank(); r < rank; ++r) {
+    FlatAffineConstraints ucst(*region.getConstraints());
+    ucst.addConstantLowerBound(r, memRefType.getDimSize(r) - extents[r] + 1);
+    if (!ucst.isEmpty())
+      return false;
+    FlatAffineConstraints lcst(*region.getConstraints());
+    lcst.addConstantUpperBound(r, -1);
+    if (!lcst.isEmpty())
+      return false;
+  }
+  return true;
+}
+
+template <typename LoadOrStoreOpPointer>
+bool mlir::isLoadOrStoreInBounds(LoadOrStoreOpPointer loadOrStoreOp) {
+  auto memRefType = loadOrStoreOp.getMemRefType();
+  SmallVector<int64_t, 4> extents(memRefType.getRank(), 1);
+  return isAccessInBounds(loadOrStoreOp.getOperation(),
+                          loadOrStoreOp.getIndices(), memRefType, extents);
+}
+
+// Explicitly instantiate the template so that the compiler knows we need them!
+template bool mlir::isLoadOrStoreInBounds(LoadOp loadOp);
+template bool mlir::isLoadOrStoreInBounds(StoreOp storeOp);
+
+template <typename VectorTransferOpTy>
+bool mlir::isVectorTransferInBounds(VectorTransferOpTy transfer) {
+  // The extent of the vector along each memref dimension.
+  auto memRefType = transfer.getMemRefType();
+  SmallVector<int64_t, 4> extents(memRefType.getRank(), 1);
+  auto vectorShape = transfer.getVectorType().getShape();
+  for (auto en : llvm::enumerate(transfer.getPermutationMap().getResults()))
+    if (auto dim = en.value().template dyn_cast<AffineDimExpr>())
+      extents[dim.getPosition()] = vectorShape[en.index()];
+  return isAccessInBounds(transfer.getOperation(), transfer.getIndices(),
+                          memRefType, extents);
+}
+
+// Explicitly instantiate the template so that the compiler knows we need them!
+template bool mlir::isVectorTransferInBounds(VectorTransferReadOp transfer);
+template bool mlir::isVectorTransferInBounds(VectorTransferWriteOp transfer);
+
 // Returns in 'positions' the Block positions of 'op' in each ancestor
 // Block from the Block containing operation, stopping at 'limitBlock'.
 static void findInstPosition(Operation *op, Block *limitBlock,
@@ -629,6 +695,16 @@ MemRefAccess::MemRefAccess(Operation *loadOrStoreOpInst) {
     for (auto *index : loadOp.getIndices()) {
       indices.push_back(index);
     }
+  } else if (auto readOp =
+                 loadOrStoreOpInst->dyn_cast<VectorTransferReadOp>()) {
+    memref = readOp.getMemRef();
+    opInst = loadOrStoreOpInst;
+    indices.append(readOp.getIndices().begin(), readOp.getIndices().end());
+  } else if (auto writeOp =
+                 loadOrStoreOpInst->dyn_cast<VectorTransferWriteOp>()) {
+    memref = writeOp.getMemRef();
+    opInst = loadOrStoreOpInst;
+    indices.append(writeOp.getIndices().begin(), writeOp.getIndices().end());
   } else {
     assert(loadOrStoreOpInst->isa<StoreOp>() && "load/store op expected");
     auto storeOp = loadOrStoreOpInst->dyn_cast<StoreOp>();
@@ -646,7 +722,9 @@ unsigned MemRefAccess::getRank() const {
   return memref->getType().cast<MemRefType>().getRank();
 }
 
-bool MemRefAccess::isStore() const { return opInst->isa<StoreOp>(); }
+bool MemRefAccess::isStore() const {
+  return opInst->isa<StoreOp>() || opInst->isa<VectorTransferWriteOp>();
+}
 
 /// Returns the nesting depth of this statement, i.e., the number of loops
 /// surrounding this statement.
@@ -677,11 +755,14 @@ unsigned mlir::getNumCommonSurroundingLoops(Operation &A, Operation &B) {
   return numCommonLoops;
 }
 
-static Optional<int64_t> getMemoryFootprintBytes(Block &block,
-                                                 Block::iterator start,
-                                                 Block::iterator end,
-                                                 int memorySpace) {
-  SmallDenseMap<Value *, std::unique_ptr<MemRefRegion>, 4> regions;
+// Computes in 'regions' the union of the regions accessed per memref by the
+// loads and stores in [start, end) of 'block', symbolic in the IVs of the
+// 'loopDepth' outermost loops surrounding them.
+static LogicalResult
+getAccessedRegions(Block &block, Block::iterator start, Block::iterator end,
+                   unsigned loopDepth, ComputationSliceState *sliceState,
+                   SmallVectorImpl<std::unique_ptr<MemRefRegion>> &regions) {
+  SmallDenseMap<Value *, unsigned, 4> regionIndices;
 
   // Walk this 'affine.for' operation to gather all memory regions.
   bool error = false;
@@ -693,17 +774,16 @@ static Optional<int64_t> getMemoryFootprintBytes(Block &block,
 
     // Compute the memref region symbolic in any IVs enclosing this block.
     auto region = llvm::make_unique<MemRefRegion>(opInst->getLoc());
-    if (failed(
-            region->compute(opInst,
-                            /*loopDepth=*/getNestingDepth(*block.begin())))) {
+    if (failed(region->compute(opInst, loopDepth, sliceState))) {
       opInst->emitError("Error obtaining memory region\n");
       error = true;
       return;
     }
-    auto it = regions.find(region->memref);
-    if (it == regions.end()) {
-      regions[region->memref] = std::move(region);
-    } else if (failed(it->second->unionBoundingBox(*region))) {
+    auto it = regionIndices.find(region->memref);
+    if (it == regionIndices.end()) {
+      regionIndices[region->memref] = regions.size();
+      regions.push_back(std::move(region));
+    } else if (failed(regions[it->second]->unionBoundingBox(*region))) {
       opInst->emitWarning(
           "getMemoryFootprintBytes: unable to perform a union on a memory "
           "region");
@@ -711,13 +791,15 @@ static Optional<int64_t> getMemoryFootprintBytes(Block &block,
       return;
     }
   });
+  return failure(error);
+}
 
-  if (error)
-    return None;
-
+// Returns the total size in bytes of 'regions', or None if one is unknown.
+static Optional<int64_t>
+getRegionsSize(ArrayRef<std::unique_ptr<MemRefRegion>> regions) {
   int64_t totalSizeInBytes = 0;
   for (const auto &region : regions) {
-    Optional<int64_t> size = region.second->getRegionSize();
+    Optional<int64_t> size = region->getRegionSize();
     if (!size.hasValue())
       return None;
     totalSizeInBytes += size.getValue();
@@ -725,6 +807,18 @@ static Optional<int64_t> getMemoryFootprintBytes(Block &block,
   return totalSizeInBytes;
 }
 
+static Optional<int64_t>
+getMemoryFootprintBytes(Block &block, Block::iterator start,
+                        Block::iterator end, int memorySpace,
+                        ComputationSliceState *sliceState = nullptr) {
+  SmallVector<std::unique_ptr<MemRefRegion>, 4> regions;
+  if (failed(getAccessedRegions(block, start, end,
+                                /*loopDepth=*/getNestingDepth(*block.begin()),
+                                sliceState, regions)))
+    return None;
+  return getRegionsSize(regions);
+}
+
 Optional<int64_t> mlir::getMemoryFootprintBytes(AffineForOp forOp,
                                                 int memorySpace) {
   auto *forInst = forOp.getOperation();
@@ -733,6 +827,70 @@ Optional<int64_t> mlir::getMemoryFootprintBytes(AffineForOp forOp,
       std::next(Block::iterator(forInst)), memorySpace);
 }
 
+Optional<int64_t> mlir::getMemoryFootprintBytes(Block &block,
+                                                int memorySpace) {
+  if (block.empty())
+    return 0;
+  return ::getMemoryFootprintBytes(block, block.begin(), block.end(),
+                                   memorySpace);
+}
+
+Optional<int64_t>
+mlir::getMemoryFootprintBytes(AffineForOp forOp,
+                              ComputationSliceState *sliceState,
+                              int memorySpace) {
+  auto *forInst = forOp.getOperation();
+  return ::getMemoryFootprintBytes(
+      *forInst->getBlock(), Block::iterator(forInst),
+      std::next(Block::iterator(forInst)), memorySpace, sliceState);
+}
+
+const MemoryFootprintAnalysis::Footprint *
+MemoryFootprintAnalysis::getFootprint(AffineForOp forOp, unsigned loopDepth) {
+  auto key = std::make_pair(forOp.getOperation(), loopDepth);
+  auto it = footprints.find(key);
+  if (it != footprints.end())
+    return it->second.get();
+
+  auto *forInst = forOp.getOperation();
+  auto footprint = llvm::make_unique<Footprint>();
+  if (failed(getAccessedRegions(*forInst->getBlock(), Block::iterator(forInst),
+                                std::next(Block::iterator(forInst)), loopDepth,
+                                /*sliceState=*/nullptr, footprint->regions)))
+    footprint.reset();
+  else
+    footprint->sizeInBytes = getRegionsSize(footprint->regions);
+  // Failures are cached as well, so that their diagnostics are emitted once.
+  return (footprints[key] = std::move(footprint)).get();
+}
+
+Optional<int64_t>
+MemoryFootprintAnalysis::getFootprintBytes(AffineForOp forOp) {
+  auto *footprint =
+      getFootprint(forOp, getNestingDepth(*forOp.getOperation()));
+  return footprint ? footprint->sizeInBytes : None;
+}
+
+Optional<int64_t>
+MemoryFootprintAnalysis::getBodyFootprintBytes(AffineForOp forOp) {
+  auto *footprint =
+      getFootprint(forOp, getNestingDepth(*forOp.getOperation()) + 1);
+  return footprint ? footprint->sizeInBytes : None;
+}
+
+void MemoryFootprintAnalysis::invalidate(Operation *op) {
+  SmallPtrSet<Operation *, 8> loops;
+  op->walk([&](AffineForOp forOp) { loops.insert(forOp.getOperation()); });
+  for (auto *parentOp = op->getParentOp(); parentOp;
+       parentOp = parentOp->getParentOp())
+    loops.insert(parentOp);
+  for (auto it = footprints.begin(), e = footprints.end(); it != e;) {
+    auto current = it++;
+    if (loops.count(current->first.first))
+      footprints.erase(current);
+  }
+}
+
 /// Returns in 'sequentialLoops' all sequential loops in loop nest rooted
 /// at 'forOp'.
 void mlir::getSequentialLoops(
@@ -745,7 +903,8 @@ void mlir::getSequentialLoops(
 }
 
 /// Returns true if 'forOp' is parallel.
-bool mlir::isLoopParallel(AffineForOp forOp) {
+bool mlir::isLoopParallel(AffineForOp forOp,
+                          DependenceAnalysis *dependences) {
   // Collect all load and store ops in loop nest rooted at 'forOp'.
   SmallVector<Operation *, 8> loadAndStoreOpInsts;
   forOp.getOperation()->walk([&](Operation *opInst) {
@@ -757,16 +916,160 @@ bool mlir::isLoopParallel(AffineForOp forOp) {
   unsigned depth = getNestingDepth(*forOp.getOperation()) + 1;
 
   // Check dependences between all pairs of ops in 'loadAndStoreOpInsts'.
-  for (auto *srcOpInst : loadAndStoreOpInsts) {
+  auto hasDependence = [&](Operation *srcOpInst, Operation *dstOpInst) {
+    if (dependences)
+      return dependences->checkDependence(srcOpInst, dstOpInst, depth);
     MemRefAccess srcAccess(srcOpInst);
-    for (auto *dstOpInst : loadAndStoreOpInsts) {
-      MemRefAccess dstAccess(dstOpInst);
-      FlatAffineConstraints dependenceConstraints;
-      if (checkMemrefAccessDependence(srcAccess, dstAccess, depth,
-                                      &dependenceConstraints,
-                                      /*dependenceComponents=*/nullptr))
+    MemRefAccess dstAccess(dstOpInst);
+    FlatAffineConstraints dependenceConstraints;
+    return checkMemrefAccessDependence(srcAccess, dstAccess, depth,
+                                       &dependenceConstraints,
+                                       /*dependenceComponents=*/nullptr);
+  };
+  for (auto *srcOpInst : loadAndStoreOpInsts)
+    for (auto *dstOpInst : loadAndStoreOpInsts)
+      if (hasDependence(srcOpInst, dstOpInst))
         return false;
+  return true;
+}
+
+LoopParallelismAnalysis::LoopParallelismAnalysis(Function *function) {
+  // Every loop gets an entry, so that the loops created later are caught.
+  SmallVector<Operation *, 16> accesses;
+  function->walk([&](Operation *op) {
+    if (op->isa<AffineForOp>())
+      carriedDependences[op];
+    else if (op->isa<LoadOp>() || op->isa<StoreOp>())
+      accesses.push_back(op);
+  });
+  for (unsigned i = 0, e = accesses.size(); i < e; ++i)
+    for (unsigned j = i; j < e; ++j)
+      addCarriedDependences(accesses[i], accesses[j]);
+}
+
+bool LoopParallelismAnalysis::isParallel(AffineForOp forOp) const {
+  return getCarriedDependences(forOp).empty();
+}
+
+ArrayRef<LoopParallelismAnalysis::Dependence>
+LoopParallelismAnalysis::getCarriedDependences(AffineForOp forOp) const {
+  auto it = carriedDependences.find(forOp.getOperation());
+  assert(it != carriedDependences.end() && "loop created after the analysis");
+  return it->second;
+}
+
+void LoopParallelismAnalysis::addCarriedDependences(Operation *opA,
+                                                    Operation *opB) {
+  if (!opA->isa<StoreOp>() && !opB->isa<StoreOp>())
+    return;
+  MemRefAccess accessA(opA);
+  MemRefAccess accessB(opB);
+  if (accessA.memref != accessB.memref)
+    return;
+  unsigned numCommonLoops = getNumCommonSurroundingLoops(*opA, *opB);
+  if (numCommonLoops == 0)
+    return;
+  SmallVector<AffineForOp, 4> loops;
+  getLoopIVs(*opA, &loops);
+
+  // Without the ordering constraints, the dependence components bound the
+  // distances between the iterations of the common loops accessing the same
+  // element, whichever access comes first.
+  FlatAffineConstraints dependenceConstraints;
+  SmallVector<DependenceComponent, 2> components;
+  if (!checkMemrefAccessDependence(accessA, accessB, /*loopDepth=*/0,
+                                   &dependenceConstraints, &components))
+    return;
+  bool hasComponents = components.size() == numCommonLoops;
+
+  for (unsigned d = 0; d < numCommonLoops; ++d) {
+    // The loop at depth 'd' carries the dependence only if the accesses may
+    // happen in different iterations of this loop, and in the same iteration
+    // of the outer ones.
+    bool mayBeZero = true, mayBeNonZero = true;
+    if (hasComponents) {
+      auto &component = components[d];
+      mayBeZero = (!component.lb || *component.lb <= 0) &&
+                  (!component.ub || *component.ub >= 0);
+      mayBeNonZero = !component.lb || !component.ub || *component.lb != 0 ||
+                     *component.ub != 0;
     }
+    if (mayBeNonZero) {
+      auto checkCarried = [&](const MemRefAccess &src,
+                              const MemRefAccess &dst) {
+        FlatAffineConstraints carriedConstraints;
+        if (checkMemrefAccessDependence(src, dst, d + 1, &carriedConstraints,
+                                        /*dependenceComponents=*/nullptr))
+          carriedDependences[loops[d].getOperation()].push_back(
+              {src.opInst, dst.opInst});
+      };
+      checkCarried(accessA, accessB);
+      if (opA != opB)
+        checkCarried(accessB, accessA);
+    }
+    if (!mayBeZero)
+      break;
   }
-  return true;
+}
+
+bool mlir::isLocalMemRef(Value *memref) {
+  Operation *defInst = memref->getDefiningOp();
+  if (!defInst || !defInst->isa<AllocOp>())
+    return false;
+  return llvm::all_of(memref->getUses(), [&](OpOperand &use) {
+    auto *ownerInst = use.getOwner();
+    if (auto storeOp = ownerInst->dyn_cast<StoreOp>())
+      return storeOp.getValueToStore() != memref;
+    return ownerInst->isa<LoadOp>() || ownerInst->isa<DeallocOp>();
+  });
+}
+
+bool mlir::haveSameMemRefAccess(Operation *opA, Operation *opB) {
+  MemRefAccess accessA(opA), accessB(opB);
+  if (accessA.memref != accessB.memref)
+    return false;
+  AffineValueMap mapA, mapB;
+  accessA.getAccessMap(&mapA);
+  accessB.getAccessMap(&mapB);
+  return mapA.getAffineMap() == mapB.getAffineMap() &&
+         mapA.getOperands() == mapB.getOperands();
+}
+
+bool mlir::hasMemRefDependence(Operation *srcOpInst, Operation *dstOpInst,
+                               unsigned minLoopDepth) {
+  MemRefAccess srcAccess(srcOpInst);
+  MemRefAccess destAccess(dstOpInst);
+  unsigned nsLoops = getNumCommonSurroundingLoops(*srcOpInst, *dstOpInst);
+  for (unsigned d = nsLoops + 1; d > minLoopDepth; d--) {
+    FlatAffineConstraints dependenceConstraints;
+    if (checkMemrefAccessDependence(srcAccess, destAccess, d,
+                                    &dependenceConstraints,
+                                    /*dependenceComponents=*/nullptr))
+      return true;
+  }
+  return false;
+}
+
+bool mlir::isWrittenBetween(Operation *srcOpInst, Operation *loadOpInst) {
+  // Everything executing after 'srcOpInst' and before the load is nested in
+  // the op's following 'srcOpInst' in its block up to the one holding the
+  // load. Only the iterations of loops not surrounding 'srcOpInst' lie in
+  // between.
+  Operation *loadAncestor =
+      srcOpInst->getBlock()->findAncestorInstInBlock(*loadOpInst);
+  if (!loadAncestor)
+    return true;
+  Value *memref = loadOpInst->cast<LoadOp>().getMemRef();
+  unsigned srcLoopDepth = getNestingDepth(*srcOpInst);
+  bool isWritten = false;
+  for (auto it = std::next(Block::iterator(srcOpInst)),
+            e = std::next(Block::iterator(loadAncestor));
+       it != e && !isWritten; ++it) {
+    it->walk([&](Operation *opInst) {
+      if (!isWritten && opInst->isa<StoreOp>() &&
+          opInst->cast<StoreOp>().getMemRef() == memref)
+        isWritten = hasMemRefDependence(opInst, loadOpInst, srcLoopDepth);
+    });
+  }
+  return isWritten;
 }
@@ -35,13 +35,17 @@
 
 #include "mlir/Analysis/Dominance.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Module.h"
 #include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Regex.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace mlir;
 
@@ -111,13 +115,21 @@ public:
   LogicalResult verifyDominance(Block &block);
   LogicalResult verifyOpDominance(Operation &op);
 
-  explicit FuncVerifier(Function &fn)
-      : fn(fn), identifierRegex("^[a-zA-Z_][a-zA-Z_0-9\\.\\$]*$") {}
+  FuncVerifier(Function &fn, VerificationLevel level,
+               DominanceInfo *cachedDomInfo)
+      : fn(fn), level(level), cachedDomInfo(cachedDomInfo),
+        identifierRegex("^[a-zA-Z_][a-zA-Z_0-9\\.\\$]*$") {}
 
 private:
   /// The function being checked.
   Function &fn;
 
+  /// The invariants to check.
+  VerificationLevel level;
+
+  /// Dominance information for this function provided by the caller, if any.
+  DominanceInfo *cachedDomInfo;
+
   /// Dominance information for this function, when checking dominance.
   DominanceInfo *domInfo = nullptr;
 
@@ -208,13 +220,19 @@ LogicalResult FuncVerifier::verify() {
   for (auto &block : fn)
     if (failed(verifyBlock(block, /*isTopLevel=*/true)))
       return failure();
+  if (level == VerificationLevel::Structural)
+    return success();
 
   // Since everything looks structurally ok to this point, we do a dominance
   // check.  We do this as a second pass since malformed CFG's can cause
   // dominator analysis constructure to crash and we want the verifier to be
   // resilient to malformed code.
-  DominanceInfo theDomInfo(&fn);
-  domInfo = &theDomInfo;
+  llvm::Optional<DominanceInfo> theDomInfo;
+  domInfo = cachedDomInfo;
+  if (!domInfo) {
+    theDomInfo.emplace(&fn);
+    domInfo = theDomInfo.getPointer();
+  }
   for (auto &block : fn)
     if (failed(verifyDominance(block)))
       return failure();
@@ -372,16 +390,48 @@ LogicalResult FuncVerifier::verifyOpDominance(Operation &op) {
 /// Perform (potentially expensive) checks of invariants, used to detect
 /// compiler bugs.  On error, this reports the error through the MLIRContext and
 /// returns failure.
-LogicalResult Function::verify() { return FuncVerifier(*this).verify(); }
+LogicalResult Function::verify(VerificationLevel level,
+                               DominanceInfo *domInfo) {
+  return FuncVerifier(*this, level, domInfo).verify();
+}
 
 /// Perform (potentially expensive) checks of invariants, used to detect
 /// compiler bugs.  On error, this reports the error through the MLIRContext and
 /// returns failure.
-LogicalResult Module::verify() {
-  /// Check that each function is correct.
-  for (auto &fn : *this)
-    if (failed(fn.verify()))
-      return failure();
+LogicalResult Module::verify(VerificationLevel level) {
+  // Function materializers aren't required to be thread-safe, so the functions
+  // are verified sequentially if any of them still has to be loaded.
+  std::vector<Function *> functions;
+  bool verifyInParallel = llvm::llvm_is_multithreaded();
+  for (auto &fn : *this) {
+    functions.push_back(&fn);
+    verifyInParallel &= !fn.isMaterializable();
+  }
+  if (!verifyInParallel || functions.size() < 2) {
+    for (auto *fn : functions)
+      if (failed(fn->verify(level)))
+        return failure();
+    return success();
+  }
 
-  return success();
+  // Verify the functions in parallel, skipping those after the first function
+  // known to fail. The diagnostics of the functions after the first one that
+  // fails are dropped, so that they are the same as those of a sequential
+  // verification.
+  ParallelDiagnosticHandler diagHandler(*getContext());
+  std::atomic<size_t> firstFailure(functions.size());
+  auto indices = llvm::seq<size_t>(0, functions.size());
+  parallelForEach(getContext(), indices.begin(), indices.end(), [&](size_t i) {
+    if (i > firstFailure)
+      return;
+    diagHandler.setOrderIDForThread(i);
+    if (succeeded(functions[i]->verify(level)))
+      return;
+    size_t knownFailure = firstFailure;
+    while (i < knownFailure &&
+           !firstFailure.compare_exchange_weak(knownFailure, i))
+      ;
+  });
+  diagHandler.eraseDiagnosticsAfter(firstFailure);
+  return failure(firstFailure != functions.size());
 }
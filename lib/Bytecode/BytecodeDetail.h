@@ -0,0 +1,260 @@
+//===- BytecodeDetail.h - MLIR bytecode encoding details --------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file defines the constants and the low level encoding utilities shared
+// by the bytecode reader and writer.
+//
+// A bytecode file has the following layout, where every integer is encoded as
+// an unsigned LEB128 varint unless noted otherwise:
+//
+//   file            ::= magic version string-section type-section
+//                       symbol-section attribute-section location-section
+//                       function-section body-section
+//   magic           ::= 'M' 'L' 0xEF 'R'
+//   string-section  ::= count (length byte*)*
+//   type-section    ::= count string-id*               // textual type form
+//   symbol-section  ::= count (name-string-id type-id)*
+//   attribute-section ::= count attribute-entry*
+//   location-section  ::= count location-entry*
+//   function-section  ::= (location-id attr-list attr-list* offset size)*
+//   body-section    ::= size byte*
+//
+// Attribute and location entries may only refer to entries of the same table
+// with a smaller id, which allows the tables to be materialized in a single
+// forward scan.  Function bodies are stored out-of-line in the body section at
+// the offset recorded in their function-section entry:
+//
+//   function-body   ::= num-values region
+//   region          ::= num-blocks (num-args type-id*)* (num-ops operation*)*
+//   operation       ::= name-string-id location-id flags
+//                       num-results type-id* num-operands operand* attr-list
+//                       num-successors (block-id num-operands operand*)*
+//                       num-regions region*
+//   operand         ::= (value-id << 1 | is-forward-ref) type-id?
+//   attr-list       ::= count (name-string-id attribute-id)*
+//
+// Values are numbered in the order the reader defines them: the arguments of
+// all blocks in a region first, then the operations in order, where the
+// results of an operation are defined after its nested regions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef MLIR_BYTECODE_BYTECODEDETAIL_H_
+#define MLIR_BYTECODE_BYTECODEDETAIL_H_
+
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace mlir {
+namespace bytecode {
+
+/// The magic number that starts every bytecode file.
+static constexpr char kMagic[] = {'M', 'L', '\xEF', 'R'};
+
+/// The version of the bytecode format emitted by the writer.  The reader only
+/// accepts files of the same version.
+static constexpr uint64_t kVersion = 1;
+
+/// The kinds of entries within the attribute table.
+enum class AttributeKind : uint8_t {
+  Bool,
+  Integer,
+  Float,
+  String,
+  Type,
+  Array,
+  Function,
+  /// Dense elements are encoded as their type and the raw element data, in
+  /// host byte order.
+  DenseElements,
+  /// Any other attribute is encoded in its textual form.
+  Textual,
+  /// Dense elements that are all equal are encoded as their type and the raw
+  /// data of their first element.
+  DenseSplatElements,
+};
+
+/// The kinds of entries within the location table.
+enum class LocationKind : uint8_t { Unknown, FileLineCol, Name, CallSite, Fused };
+
+/// Flags attached to each encoded operation.
+enum OperationFlags : uint64_t {
+  /// The operation has a resizable operand list.
+  ResizableOperandList = 1 << 0,
+};
+
+/// This class encodes integers, bytes and strings into a byte buffer.
+class EncodingWriter {
+public:
+  explicit EncodingWriter(SmallVectorImpl<char> &buffer) : os(buffer) {}
+
+  void emitByte(uint8_t byte) { os << static_cast<char>(byte); }
+  void emitBytes(ArrayRef<char> bytes) { os.write(bytes.data(), bytes.size()); }
+  void emitVarInt(uint64_t value) { llvm::encodeULEB128(value, os); }
+  void emitSignedVarInt(int64_t value) { llvm::encodeSLEB128(value, os); }
+
+  /// Emit a string prefixed by its length.
+  void emitString(StringRef str) {
+    emitVarInt(str.size());
+    emitBytes(ArrayRef<char>(str.data(), str.size()));
+  }
+
+  /// Emit the given APInt.  Values that fit in 64 bits are emitted as a single
+  /// signed varint, larger values as their raw words.
+  void emitAPInt(const APInt &value) {
+    if (value.getBitWidth() <= 64)
+      return emitSignedVarInt(value.getSExtValue());
+    for (unsigned i = 0, e = value.getNumWords(); i != e; ++i)
+      emitVarInt(value.getRawData()[i]);
+  }
+
+  /// Return the current size of the encoded buffer.
+  uint64_t size() const { return os.tell(); }
+
+private:
+  llvm::raw_svector_ostream os;
+};
+
+/// This class decodes integers, bytes and strings from a byte buffer, emitting
+/// an error through the context when the buffer is malformed.
+class EncodingReader {
+public:
+  EncodingReader(ArrayRef<uint8_t> buffer, MLIRContext *context)
+      : buffer(buffer), pos(buffer.begin()), context(context) {}
+
+  /// Returns true if the entire buffer has been read.
+  bool empty() const { return pos == buffer.end(); }
+
+  /// Return the number of bytes that have been read so far.
+  size_t getOffset() const { return pos - buffer.begin(); }
+
+  /// Emit an error about the malformed buffer.  This always returns failure.
+  LogicalResult emitError(const Twine &message) {
+    context->emitError(UnknownLoc::get(context),
+                       "malformed bytecode: " + message);
+    return failure();
+  }
+
+  LogicalResult parseByte(uint8_t &value) {
+    if (empty())
+      return emitError("unexpected end of buffer");
+    value = *pos++;
+    return success();
+  }
+
+  LogicalResult parseBytes(size_t length, ArrayRef<uint8_t> &bytes) {
+    if (length > size_t(buffer.end() - pos))
+      return emitError("unexpected end of buffer");
+    bytes = ArrayRef<uint8_t>(pos, length);
+    pos += length;
+    return success();
+  }
+
+  LogicalResult parseVarInt(uint64_t &value) {
+    unsigned length = 0;
+    const char *error = nullptr;
+    value = llvm::decodeULEB128(pos, &length, buffer.end(), &error);
+    if (error)
+      return emitError(error);
+    pos += length;
+    return success();
+  }
+
+  /// Parse the number of entries of a list in which every entry takes at
+  /// least one byte.  Counts larger than the number of remaining bytes are
+  /// rejected before they can be used to size an allocation.
+  LogicalResult parseCount(uint64_t &count) {
+    if (failed(parseVarInt(count)))
+      return failure();
+    if (count > uint64_t(buffer.end() - pos))
+      return emitError("entry count " + Twine(count) + " exceeds the " +
+                       Twine(buffer.end() - pos) + " remaining bytes");
+    return success();
+  }
+
+  LogicalResult parseSignedVarInt(int64_t &value) {
+    unsigned length = 0;
+    const char *error = nullptr;
+    value = llvm::decodeSLEB128(pos, &length, buffer.end(), &error);
+    if (error)
+      return emitError(error);
+    pos += length;
+    return success();
+  }
+
+  /// Parse a string prefixed by its length.
+  LogicalResult parseString(StringRef &str) {
+    uint64_t length;
+    ArrayRef<uint8_t> bytes;
+    if (failed(parseVarInt(length)) || failed(parseBytes(length, bytes)))
+      return failure();
+    str = StringRef(reinterpret_cast<const char *>(bytes.data()), length);
+    return success();
+  }
+
+  /// Parse an APInt of the given bit width, as emitted by
+  /// EncodingWriter::emitAPInt.
+  LogicalResult parseAPInt(unsigned bitWidth, APInt &value) {
+    if (bitWidth <= 64) {
+      int64_t rawValue;
+      if (failed(parseSignedVarInt(rawValue)))
+        return failure();
+      value = APInt(bitWidth, rawValue, /*isSigned=*/true);
+      return success();
+    }
+    SmallVector<uint64_t, 4> words(APInt::getNumWords(bitWidth));
+    for (uint64_t &word : words)
+      if (failed(parseVarInt(word)))
+        return failure();
+    value = APInt(bitWidth, words);
+    return success();
+  }
+
+  /// Parse an index into the given table and return the referenced entry.
+  template <typename T>
+  LogicalResult parseEntry(ArrayRef<T> table, T &entry, StringRef tableName) {
+    uint64_t index;
+    if (failed(parseVarInt(index)))
+      return failure();
+    if (index >= table.size())
+      return emitError("invalid " + tableName + " index " + Twine(index));
+    entry = table[index];
+    return success();
+  }
+
+private:
+  /// The buffer being read.
+  ArrayRef<uint8_t> buffer;
+
+  /// The current read position within the buffer.
+  const uint8_t *pos;
+
+  /// The context used to emit errors.
+  MLIRContext *context;
+};
+
+} // end namespace bytecode
+} // end namespace mlir
+
+#endif // MLIR_BYTECODE_BYTECODEDETAIL_H_
@@ -0,0 +1,739 @@
+//===- BytecodeReader.cpp - MLIR bytecode reader --------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the reader for the MLIR bytecode format.  See
+// BytecodeDetail.h for a description of the encoding.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BytecodeDetail.h"
+#include "mlir/Bytecode/Bytecode.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Parser.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstring>
+
+using namespace mlir;
+using namespace mlir::bytecode;
+
+namespace {
+/// This class reads a module from the bytecode format.
+class BytecodeReader {
+public:
+  BytecodeReader(ArrayRef<uint8_t> buffer, MLIRContext *context,
+                 bool lazyLoadBodies)
+      : reader(buffer, context), context(context),
+        lazyLoadBodies(lazyLoadBodies) {}
+
+  /// Read the held buffer into a new module.  Returns null on failure.
+  Module *read();
+
+  /// Load the body of a function that was left materializable by 'read'.
+  LogicalResult materialize(Function *fn);
+
+private:
+  //===--------------------------------------------------------------------===//
+  // Sections
+  //===--------------------------------------------------------------------===//
+
+  LogicalResult parseHeader();
+  LogicalResult parseStringSection();
+  LogicalResult parseTypeSection();
+  LogicalResult parseSymbolSection(Module &module);
+  LogicalResult parseAttributeSection(Module &module);
+  LogicalResult parseLocationSection();
+  LogicalResult parseFunctionSection(Module &module);
+
+  /// Parse a named attribute list from the given reader.
+  LogicalResult parseAttributeList(EncodingReader &reader,
+                                   SmallVectorImpl<NamedAttribute> &attrs);
+
+  //===--------------------------------------------------------------------===//
+  // Function bodies
+  //===--------------------------------------------------------------------===//
+
+  LogicalResult parseFunctionBody(Function *fn, ArrayRef<uint8_t> body);
+  LogicalResult parseRegion(EncodingReader &reader, Region &region);
+  LogicalResult parseOperation(EncodingReader &reader, Block *block,
+                               ArrayRef<Block *> regionBlocks);
+  LogicalResult parseOperand(EncodingReader &reader, Value *&value);
+
+  /// Define the value with the given id, resolving any forward references to
+  /// it.
+  LogicalResult defineValue(EncodingReader &reader, uint64_t id, Value *value);
+
+  /// The reader for the top-level buffer.
+  EncodingReader reader;
+
+  /// The context being read into.
+  MLIRContext *context;
+
+  /// If true, function bodies are not read up front.  Instead the functions
+  /// are marked as materializable and their bodies are kept in
+  /// 'lazyFunctionBodies' until loaded.
+  bool lazyLoadBodies;
+  DenseMap<Function *, ArrayRef<uint8_t>> lazyFunctionBodies;
+
+  /// The uniqued tables of the file.
+  std::vector<StringRef> strings;
+  std::vector<Type> types;
+  std::vector<Function *> functions;
+  std::vector<Attribute> attributes;
+  std::vector<Location> locations;
+
+  /// The values of the function being read, indexed by value id, and the
+  /// placeholders created for forward references.
+  std::vector<Value *> values;
+  DenseMap<Value *, uint64_t> forwardRefPlaceholders;
+
+  /// The id of the next value to be defined in the function being read.
+  uint64_t nextValueID = 0;
+};
+} // end anonymous namespace
+
+//===----------------------------------------------------------------------===//
+// Sections
+//===----------------------------------------------------------------------===//
+
+LogicalResult BytecodeReader::parseHeader() {
+  ArrayRef<uint8_t> magic;
+  if (failed(reader.parseBytes(sizeof(kMagic), magic)) ||
+      std::memcmp(magic.data(), kMagic, sizeof(kMagic)) != 0)
+    return reader.emitError("invalid magic number");
+
+  uint64_t version;
+  if (failed(reader.parseVarInt(version)))
+    return failure();
+  if (version != kVersion)
+    return reader.emitError("unsupported version " + Twine(version) +
+                            ", expected " + Twine(kVersion));
+  return success();
+}
+
+LogicalResult BytecodeReader::parseStringSection() {
+  uint64_t numStrings;
+  if (failed(reader.parseCount(numStrings)))
+    return failure();
+  strings.resize(numStrings);
+  for (StringRef &str : strings)
+    if (failed(reader.parseString(str)))
+      return failure();
+  return success();
+}
+
+LogicalResult BytecodeReader::parseTypeSection() {
+  uint64_t numTypes;
+  if (failed(reader.parseCount(numTypes)))
+    return failure();
+  types.reserve(numTypes);
+  for (uint64_t i = 0; i != numTypes; ++i) {
+    StringRef typeStr;
+    if (failed(reader.parseEntry<StringRef>(strings, typeStr, "string")))
+      return failure();
+    Type type = parseType(typeStr, context);
+    if (!type)
+      return failure();
+    types.push_back(type);
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::parseSymbolSection(Module &module) {
+  uint64_t numFunctions;
+  if (failed(reader.parseCount(numFunctions)))
+    return failure();
+  functions.reserve(numFunctions);
+  for (uint64_t i = 0; i != numFunctions; ++i) {
+    StringRef name;
+    Type type;
+    if (failed(reader.parseEntry<StringRef>(strings, name, "string")) ||
+        failed(reader.parseEntry<Type>(types, type, "type")))
+      return failure();
+    auto fnType = type.dyn_cast<FunctionType>();
+    if (!fnType)
+      return reader.emitError("expected function type for '" + name + "'");
+
+    // The location and attributes of the function are filled in once the
+    // function section is read.
+    auto *fn = new Function(UnknownLoc::get(context), name, fnType);
+    module.getFunctions().push_back(fn);
+    if (fn->getName().strref() != name)
+      return reader.emitError("redefinition of function named '" + name + "'");
+    functions.push_back(fn);
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::parseAttributeSection(Module &module) {
+  uint64_t numAttributes;
+  if (failed(reader.parseCount(numAttributes)))
+    return failure();
+  attributes.reserve(numAttributes);
+  for (uint64_t i = 0; i != numAttributes; ++i) {
+    uint8_t kind;
+    if (failed(reader.parseByte(kind)))
+      return failure();
+
+    Attribute attr;
+    switch (static_cast<AttributeKind>(kind)) {
+    case AttributeKind::Bool: {
+      uint8_t value;
+      if (failed(reader.parseByte(value)))
+        return failure();
+      attr = BoolAttr::get(value != 0, context);
+      break;
+    }
+    case AttributeKind::Integer: {
+      Type type;
+      APInt value;
+      if (failed(reader.parseEntry<Type>(types, type, "type")))
+        return failure();
+      if (!type.isIntOrIndex())
+        return reader.emitError("expected integer or index type");
+      unsigned width = type.isIndex() ? 64 : type.getIntOrFloatBitWidth();
+      if (failed(reader.parseAPInt(width, value)))
+        return failure();
+      attr = IntegerAttr::get(type, value);
+      break;
+    }
+    case AttributeKind::Float: {
+      Type type;
+      APInt value;
+      if (failed(reader.parseEntry<Type>(types, type, "type")))
+        return failure();
+      auto floatType = type.dyn_cast<FloatType>();
+      if (!floatType)
+        return reader.emitError("expected float type");
+      const auto &semantics = floatType.getFloatSemantics();
+      if (failed(reader.parseAPInt(
+              APFloat::semanticsSizeInBits(semantics), value)))
+        return failure();
+      attr = FloatAttr::get(type, APFloat(semantics, value));
+      break;
+    }
+    case AttributeKind::String: {
+      StringRef value;
+      if (failed(reader.parseEntry<StringRef>(strings, value, "string")))
+        return failure();
+      attr = StringAttr::get(value, context);
+      break;
+    }
+    case AttributeKind::Type: {
+      Type value;
+      if (failed(reader.parseEntry<Type>(types, value, "type")))
+        return failure();
+      attr = TypeAttr::get(value, context);
+      break;
+    }
+    case AttributeKind::Array: {
+      uint64_t numElements;
+      if (failed(reader.parseCount(numElements)))
+        return failure();
+      SmallVector<Attribute, 8> elements(numElements);
+      for (Attribute &element : elements)
+        if (failed(reader.parseEntry<Attribute>(attributes, element,
+                                                "attribute")))
+          return failure();
+      attr = ArrayAttr::get(elements, context);
+      break;
+    }
+    case AttributeKind::Function: {
+      StringRef name;
+      if (failed(reader.parseEntry<StringRef>(strings, name, "string")))
+        return failure();
+      Function *fn = module.getNamedFunction(name);
+      if (!fn)
+        return reader.emitError("reference to undefined function '" + name +
+                                "'");
+      attr = FunctionAttr::get(fn, context);
+      break;
+    }
+    case AttributeKind::DenseElements:
+    case AttributeKind::DenseSplatElements: {
+      Type type;
+      StringRef data;
+      if (failed(reader.parseEntry<Type>(types, type, "type")) ||
+          failed(reader.parseString(data)))
+        return failure();
+      auto shapedType = type.dyn_cast<VectorOrTensorType>();
+      if (!shapedType)
+        return reader.emitError("expected vector or tensor type");
+      ArrayRef<char> rawData(data.data(), data.size());
+      if (kind == static_cast<uint8_t>(AttributeKind::DenseElements)) {
+        attr = DenseElementsAttr::get(shapedType, rawData);
+        break;
+      }
+      // BF16 elements are stored as doubles.
+      unsigned bitWidth = shapedType.getElementType().isBF16()
+                              ? 64
+                              : shapedType.getElementTypeBitWidth();
+      if (data.size() * CHAR_BIT < bitWidth)
+        return reader.emitError("splat element data is too short");
+      attr = DenseElementsAttr::getSplat(shapedType, rawData);
+      break;
+    }
+    case AttributeKind::Textual: {
+      StringRef attrStr;
+      if (failed(reader.parseEntry<StringRef>(strings, attrStr, "string")))
+        return failure();
+      if (!(attr = parseAttribute(attrStr, context)))
+        return failure();
+      break;
+    }
+    default:
+      return reader.emitError("unknown attribute kind " + Twine(kind));
+    }
+    attributes.push_back(attr);
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::parseLocationSection() {
+  uint64_t numLocations;
+  if (failed(reader.parseCount(numLocations)))
+    return failure();
+  locations.reserve(numLocations);
+  for (uint64_t i = 0; i != numLocations; ++i) {
+    uint8_t kind;
+    if (failed(reader.parseByte(kind)))
+      return failure();
+
+    switch (static_cast<LocationKind>(kind)) {
+    case LocationKind::Unknown:
+      locations.push_back(UnknownLoc::get(context));
+      break;
+    case LocationKind::FileLineCol: {
+      StringRef filename;
+      uint64_t line, column;
+      if (failed(reader.parseEntry<StringRef>(strings, filename, "string")) ||
+          failed(reader.parseVarInt(line)) ||
+          failed(reader.parseVarInt(column)))
+        return failure();
+      locations.push_back(
+          FileLineColLoc::get(UniquedFilename::get(filename, context), line,
+                              column, context));
+      break;
+    }
+    case LocationKind::Name: {
+      StringRef name;
+      if (failed(reader.parseEntry<StringRef>(strings, name, "string")))
+        return failure();
+      locations.push_back(
+          NameLoc::get(Identifier::get(name, context), context));
+      break;
+    }
+    case LocationKind::CallSite: {
+      // Copy the table entries, as pushing back may reallocate the table.
+      Location callee = UnknownLoc::get(context);
+      Location caller = UnknownLoc::get(context);
+      if (failed(reader.parseEntry<Location>(locations, callee, "location")) ||
+          failed(reader.parseEntry<Location>(locations, caller, "location")))
+        return failure();
+      locations.push_back(CallSiteLoc::get(callee, caller, context));
+      break;
+    }
+    case LocationKind::Fused: {
+      uint64_t numLocs, metadataID;
+      if (failed(reader.parseCount(numLocs)))
+        return failure();
+      SmallVector<Location, 4> fusedLocs(numLocs, UnknownLoc::get(context));
+      for (Location &loc : fusedLocs)
+        if (failed(reader.parseEntry<Location>(locations, loc, "location")))
+          return failure();
+
+      // A metadata id of zero signals that there is no metadata.
+      if (failed(reader.parseVarInt(metadataID)))
+        return failure();
+      if (metadataID > attributes.size())
+        return reader.emitError("invalid attribute index " +
+                                Twine(metadataID - 1));
+      Attribute metadata = metadataID ? attributes[metadataID - 1] : nullptr;
+      locations.push_back(FusedLoc::get(fusedLocs, metadata, context));
+      break;
+    }
+    default:
+      return reader.emitError("unknown location kind " + Twine(kind));
+    }
+  }
+  return success();
+}
+
+LogicalResult
+BytecodeReader::parseAttributeList(EncodingReader &reader,
+                                   SmallVectorImpl<NamedAttribute> &attrs) {
+  uint64_t numAttrs;
+  if (failed(reader.parseCount(numAttrs)))
+    return failure();
+  attrs.reserve(numAttrs);
+  for (uint64_t i = 0; i != numAttrs; ++i) {
+    StringRef name;
+    Attribute attr;
+    if (failed(reader.parseEntry<StringRef>(strings, name, "string")) ||
+        failed(reader.parseEntry<Attribute>(attributes, attr, "attribute")))
+      return failure();
+    attrs.push_back({Identifier::get(name, context), attr});
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::parseFunctionSection(Module &module) {
+  // Parse the index entries for each function.  The body section follows the
+  // index, so the ranges are only resolved once the index has been read.
+  std::vector<std::pair<uint64_t, uint64_t>> bodyRanges;
+  bodyRanges.reserve(functions.size());
+  for (Function *fn : functions) {
+    Location loc = UnknownLoc::get(context);
+    SmallVector<NamedAttribute, 4> attrs;
+    if (failed(reader.parseEntry<Location>(locations, loc, "location")) ||
+        failed(parseAttributeList(reader, attrs)))
+      return failure();
+    fn->setLoc(loc);
+    fn->setAttrs(attrs);
+
+    for (unsigned i = 0, e = fn->getNumArguments(); i != e; ++i) {
+      SmallVector<NamedAttribute, 2> argAttrs;
+      if (failed(parseAttributeList(reader, argAttrs)))
+        return failure();
+      fn->setArgAttrs(i, argAttrs);
+    }
+
+    uint64_t offset, size;
+    if (failed(reader.parseVarInt(offset)) || failed(reader.parseVarInt(size)))
+      return failure();
+    bodyRanges.emplace_back(offset, size);
+  }
+
+  uint64_t bodySectionSize;
+  ArrayRef<uint8_t> bodySection;
+  if (failed(reader.parseVarInt(bodySectionSize)) ||
+      failed(reader.parseBytes(bodySectionSize, bodySection)))
+    return failure();
+  if (!reader.empty())
+    return reader.emitError("unexpected trailing bytes");
+
+  for (unsigned i = 0, e = functions.size(); i != e; ++i) {
+    uint64_t offset = bodyRanges[i].first, size = bodyRanges[i].second;
+    if (size == 0)
+      continue;
+    if (offset > bodySection.size() || size > bodySection.size() - offset)
+      return reader.emitError("invalid body range for function '" +
+                              functions[i]->getName().strref() + "'");
+
+    ArrayRef<uint8_t> body = bodySection.slice(offset, size);
+    if (lazyLoadBodies) {
+      functions[i]->setMaterializable();
+      lazyFunctionBodies[functions[i]] = body;
+      continue;
+    }
+    if (failed(parseFunctionBody(functions[i], body)))
+      return failure();
+  }
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Function bodies
+//===----------------------------------------------------------------------===//
+
+LogicalResult BytecodeReader::parseFunctionBody(Function *fn,
+                                                ArrayRef<uint8_t> body) {
+  EncodingReader bodyReader(body, context);
+  uint64_t numValues;
+  if (failed(bodyReader.parseCount(numValues)))
+    return failure();
+  values.assign(numValues, nullptr);
+  nextValueID = 0;
+
+  LogicalResult result = parseRegion(bodyReader, fn->getBody());
+  if (succeeded(result) && !forwardRefPlaceholders.empty())
+    result = bodyReader.emitError("use of undefined value in function '" +
+                                  fn->getName().strref() + "'");
+  if (succeeded(result) && !bodyReader.empty())
+    result = bodyReader.emitError("unexpected trailing bytes in function '" +
+                                  fn->getName().strref() + "'");
+
+  // On failure, drop all of the references within the body so that the
+  // function and any remaining placeholders can be safely destroyed.
+  if (failed(result))
+    for (Block &block : *fn)
+      block.dropAllReferences();
+  for (auto &placeholder : forwardRefPlaceholders) {
+    placeholder.first->dropAllUses();
+    placeholder.first->getDefiningOp()->destroy();
+  }
+  forwardRefPlaceholders.clear();
+  return result;
+}
+
+LogicalResult BytecodeReader::parseRegion(EncodingReader &reader,
+                                          Region &region) {
+  uint64_t numBlocks;
+  if (failed(reader.parseCount(numBlocks)))
+    return failure();
+
+  // Create all of the blocks, and their arguments, up front so that successor
+  // references can be resolved directly.
+  SmallVector<Block *, 4> blocks;
+  blocks.reserve(numBlocks);
+  for (uint64_t i = 0; i != numBlocks; ++i) {
+    auto *block = new Block();
+    region.push_back(block);
+    blocks.push_back(block);
+
+    uint64_t numArgs;
+    if (failed(reader.parseCount(numArgs)))
+      return failure();
+    for (uint64_t argIdx = 0; argIdx != numArgs; ++argIdx) {
+      Type type;
+      if (failed(reader.parseEntry<Type>(types, type, "type")))
+        return failure();
+      uint64_t id = nextValueID++;
+      if (failed(defineValue(reader, id, block->addArgument(type))))
+        return failure();
+    }
+  }
+
+  for (Block *block : blocks) {
+    uint64_t numOps;
+    if (failed(reader.parseCount(numOps)))
+      return failure();
+    for (uint64_t i = 0; i != numOps; ++i)
+      if (failed(parseOperation(reader, block, blocks)))
+        return failure();
+  }
+  return success();
+}
+
+namespace {
+/// RAII-style guard for dropping the references held by the regions of an
+/// operation state that was never turned into an operation, so that the
+/// regions and any forward reference placeholders can be safely deleted.
+struct CleanupOpStateRegions {
+  ~CleanupOpStateRegions() {
+    for (auto &region : state.regions)
+      if (region)
+        for (auto &block : *region)
+          block.dropAllReferences();
+  }
+  OperationState &state;
+};
+} // end anonymous namespace
+
+LogicalResult BytecodeReader::parseOperation(EncodingReader &reader,
+                                             Block *block,
+                                             ArrayRef<Block *> regionBlocks) {
+  StringRef name;
+  Location loc = UnknownLoc::get(context);
+  uint64_t flags;
+  if (failed(reader.parseEntry<StringRef>(strings, name, "string")) ||
+      failed(reader.parseEntry<Location>(locations, loc, "location")) ||
+      failed(reader.parseVarInt(flags)))
+    return failure();
+
+  OperationState state(context, loc, name);
+  state.setOperandListToResizable(flags &
+                                  OperationFlags::ResizableOperandList);
+
+  uint64_t numResults;
+  if (failed(reader.parseCount(numResults)))
+    return failure();
+  state.types.resize(numResults);
+  for (Type &type : state.types)
+    if (failed(reader.parseEntry<Type>(types, type, "type")))
+      return failure();
+
+  uint64_t numOperands;
+  if (failed(reader.parseCount(numOperands)))
+    return failure();
+  state.operands.resize(numOperands);
+  for (Value *&operand : state.operands)
+    if (failed(parseOperand(reader, operand)))
+      return failure();
+
+  if (failed(parseAttributeList(reader, state.attributes)))
+    return failure();
+
+  uint64_t numSuccessors;
+  if (failed(reader.parseCount(numSuccessors)))
+    return failure();
+  for (uint64_t i = 0; i != numSuccessors; ++i) {
+    Block *successor;
+    uint64_t numSuccOperands;
+    if (failed(reader.parseEntry<Block *>(regionBlocks, successor, "block")) ||
+        failed(reader.parseCount(numSuccOperands)))
+      return failure();
+    SmallVector<Value *, 4> succOperands(numSuccOperands);
+    for (Value *&operand : succOperands)
+      if (failed(parseOperand(reader, operand)))
+        return failure();
+    state.addSuccessor(successor, succOperands);
+  }
+
+  uint64_t numRegions;
+  if (failed(reader.parseCount(numRegions)))
+    return failure();
+  CleanupOpStateRegions guard{state};
+  for (uint64_t i = 0; i != numRegions; ++i) {
+    // Create temporary regions with the function as parent.
+    state.regions.emplace_back(new Region(block->getFunction()));
+    if (failed(parseRegion(reader, *state.regions.back())))
+      return failure();
+  }
+
+  Operation *op = Operation::create(state);
+  block->push_back(op);
+  for (Value *result : op->getResults())
+    if (failed(defineValue(reader, nextValueID++, result)))
+      return failure();
+  return success();
+}
+
+LogicalResult BytecodeReader::parseOperand(EncodingReader &reader,
+                                           Value *&value) {
+  uint64_t encodedID;
+  if (failed(reader.parseVarInt(encodedID)))
+    return failure();
+  uint64_t id = encodedID >> 1;
+  bool isForwardRef = encodedID & 1;
+  if (id >= values.size())
+    return reader.emitError("invalid value index " + Twine(id));
+
+  if (!isForwardRef) {
+    if (!(value = values[id]))
+      return reader.emitError("use of undefined value " + Twine(id));
+    return success();
+  }
+
+  // Forward references always carry their type.  The first reference to the
+  // value creates a placeholder that is replaced when the value is defined.
+  Type type;
+  if (failed(reader.parseEntry<Type>(types, type, "type")))
+    return failure();
+  if ((value = values[id])) {
+    if (value->getType() != type)
+      return reader.emitError("forward reference to value " + Twine(id) +
+                              " has a mismatched type");
+    return success();
+  }
+  auto *placeholder = Operation::create(
+      UnknownLoc::get(context), OperationName("placeholder", context),
+      /*operands=*/{}, type, /*attributes=*/llvm::None, /*successors=*/{},
+      /*numRegions=*/0, /*resizableOperandList=*/false, context);
+  value = values[id] = placeholder->getResult(0);
+  forwardRefPlaceholders[value] = id;
+  return success();
+}
+
+LogicalResult BytecodeReader::defineValue(EncodingReader &reader, uint64_t id,
+                                          Value *value) {
+  if (id >= values.size())
+    return reader.emitError("invalid value index " + Twine(id));
+
+  if (Value *existing = values[id]) {
+    auto it = forwardRefPlaceholders.find(existing);
+    if (it == forwardRefPlaceholders.end())
+      return reader.emitError("redefinition of value " + Twine(id));
+    if (existing->getType() != value->getType())
+      return reader.emitError("forward reference to value " + Twine(id) +
+                              " has a mismatched type");
+    existing->replaceAllUsesWith(value);
+    forwardRefPlaceholders.erase(it);
+    existing->getDefiningOp()->destroy();
+  }
+  values[id] = value;
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Module
+//===----------------------------------------------------------------------===//
+
+Module *BytecodeReader::read() {
+  std::unique_ptr<Module> module(new Module(context));
+  if (failed(parseHeader()) || failed(parseStringSection()) ||
+      failed(parseTypeSection()) || failed(parseSymbolSection(*module)) ||
+      failed(parseAttributeSection(*module)) ||
+      failed(parseLocationSection()) || failed(parseFunctionSection(*module)))
+    return nullptr;
+
+  // Make sure the module has no other structural problems detected by the
+  // verifier.  Lazily loaded functions are verified when they are
+  // materialized.
+  if (!lazyLoadBodies && failed(module->verify()))
+    return nullptr;
+  return module.release();
+}
+
+LogicalResult BytecodeReader::materialize(Function *fn) {
+  auto it = lazyFunctionBodies.find(fn);
+  if (it == lazyFunctionBodies.end())
+    return success();
+  ArrayRef<uint8_t> body = it->second;
+  lazyFunctionBodies.erase(it);
+
+  if (failed(parseFunctionBody(fn, body))) {
+    // Leave the function external so that it may still be safely destroyed.
+    fn->getBlocks().clear();
+    return failure();
+  }
+  return fn->verify();
+}
+
+namespace {
+/// This class materializes the function bodies of a lazily loaded bytecode
+/// module.  It keeps the tables of the reader alive for as long as the module.
+class BytecodeMaterializer : public FunctionMaterializer {
+public:
+  BytecodeMaterializer(std::unique_ptr<BytecodeReader> reader)
+      : reader(std::move(reader)) {}
+
+  LogicalResult materialize(Function *function) override {
+    return reader->materialize(function);
+  }
+
+private:
+  std::unique_ptr<BytecodeReader> reader;
+};
+} // end anonymous namespace
+
+/// Returns true if the given buffer starts with the bytecode magic number.
+bool mlir::isBytecodeFile(llvm::MemoryBufferRef buffer) {
+  StringRef contents = buffer.getBuffer();
+  return contents.size() >= sizeof(kMagic) &&
+         std::memcmp(contents.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+/// This reads the bytecode held in the given buffer and returns an MLIR module
+/// if it was valid.  If not, it emits diagnostics and returns null.
+Module *mlir::readBytecodeFile(llvm::MemoryBufferRef buffer,
+                               MLIRContext *context, bool lazyLoadBodies) {
+  StringRef contents = buffer.getBuffer();
+  ArrayRef<uint8_t> bytes(reinterpret_cast<const uint8_t *>(contents.data()),
+                          contents.size());
+  auto reader = llvm::make_unique<BytecodeReader>(bytes, context,
+                                                  lazyLoadBodies);
+  Module *module = reader->read();
+  if (module && lazyLoadBodies)
+    module->setMaterializer(
+        llvm::make_unique<BytecodeMaterializer>(std::move(reader)));
+  return module;
+}
@@ -0,0 +1,56 @@
+//===- BytecodeTranslation.cpp - Bytecode translation registration --------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file registers translations between the textual and bytecode forms of
+// an MLIR module.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Bytecode/Bytecode.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Support/FileUtilities.h"
+#include "mlir/Translation.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+using namespace mlir;
+
+static TranslateFromMLIRRegistration
+    toBytecodeRegistration("mlir-to-bytecode",
+                           [](Module *module, llvm::StringRef outputFilename) {
+                             if (!module)
+                               return true;
+
+                             auto file = openOutputFile(outputFilename);
+                             if (!file)
+                               return true;
+
+                             writeBytecodeFile(module, file->os());
+                             file->keep();
+                             return false;
+                           });
+
+static TranslateToMLIRRegistration fromBytecodeRegistration(
+    "bytecode-to-mlir",
+    [](llvm::StringRef inputFilename,
+       MLIRContext *context) -> std::unique_ptr<Module> {
+      auto file = openInputFile(inputFilename);
+      if (!file)
+        return nullptr;
+      return std::unique_ptr<Module>(
+          readBytecodeFile(file->getMemBufferRef(), context));
+    });
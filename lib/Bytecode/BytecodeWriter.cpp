@@ -0,0 +1,434 @@
+//===- BytecodeWriter.cpp - MLIR bytecode writer --------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the writer for the MLIR bytecode format.  See
+// BytecodeDetail.h for a description of the encoding.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BytecodeDetail.h"
+#include "mlir/Bytecode/Bytecode.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+
+using namespace mlir;
+using namespace mlir::bytecode;
+
+namespace {
+/// This class writes a module to the bytecode format.  The function bodies are
+/// encoded first, which populates the uniqued string, type, attribute and
+/// location tables that precede them in the file.
+class BytecodeWriter {
+public:
+  explicit BytecodeWriter(Module *module) : module(module) {}
+
+  /// Write the held module to the given stream.
+  void write(raw_ostream &os);
+
+private:
+  //===--------------------------------------------------------------------===//
+  // Uniqued tables
+  //===--------------------------------------------------------------------===//
+
+  unsigned getStringID(StringRef str);
+  unsigned getTypeID(Type type);
+  unsigned getAttributeID(Attribute attr);
+  unsigned getLocationID(Location loc);
+
+  /// Emit a named attribute list to the given writer.
+  void writeAttributeList(ArrayRef<NamedAttribute> attrs,
+                          EncodingWriter &writer);
+
+  //===--------------------------------------------------------------------===//
+  // Function bodies
+  //===--------------------------------------------------------------------===//
+
+  void writeFunctionBody(Function &fn, EncodingWriter &writer);
+  void writeRegion(Region &region, EncodingWriter &writer);
+  void writeOperation(Operation *op, EncodingWriter &writer);
+  void writeOperand(Value *value, EncodingWriter &writer);
+
+  /// Assign a value id to each of the values defined within the given region,
+  /// in the order that the reader will define them.
+  void numberValues(Region &region);
+
+  /// The module being written.
+  Module *module;
+
+  /// The uniqued strings, and a mapping to their ids.
+  llvm::StringMap<unsigned> stringIDs;
+  std::vector<StringRef> strings;
+
+  /// The uniqued types, encoded as the id of their textual form.
+  DenseMap<Type, unsigned> typeIDs;
+  std::vector<unsigned> typeStrings;
+
+  /// The uniqued attributes and locations, along with their encoded entries.
+  DenseMap<Attribute, unsigned> attributeIDs;
+  SmallVector<char, 0> attributeEntries;
+  EncodingWriter attributeWriter{attributeEntries};
+
+  DenseMap<const void *, unsigned> locationIDs;
+  SmallVector<char, 0> locationEntries;
+  EncodingWriter locationWriter{locationEntries};
+
+  /// The ids of the values and blocks within the function being written.
+  DenseMap<Value *, unsigned> valueIDs;
+  DenseMap<Block *, unsigned> blockIDs;
+  unsigned numNumberedValues = 0;
+
+  /// The number of values that the reader will have defined at the current
+  /// position in the function being written.  Uses of values with an id
+  /// greater than or equal to this are forward references.
+  unsigned numDefinedValues = 0;
+};
+} // end anonymous namespace
+
+//===----------------------------------------------------------------------===//
+// Uniqued tables
+//===----------------------------------------------------------------------===//
+
+unsigned BytecodeWriter::getStringID(StringRef str) {
+  auto it = stringIDs.try_emplace(str, strings.size());
+  if (it.second)
+    strings.push_back(it.first->first());
+  return it.first->second;
+}
+
+unsigned BytecodeWriter::getTypeID(Type type) {
+  auto it = typeIDs.find(type);
+  if (it != typeIDs.end())
+    return it->second;
+
+  std::string typeStr;
+  llvm::raw_string_ostream os(typeStr);
+  type.print(os);
+  typeStrings.push_back(getStringID(os.str()));
+  return typeIDs[type] = typeStrings.size() - 1;
+}
+
+unsigned BytecodeWriter::getAttributeID(Attribute attr) {
+  auto it = attributeIDs.find(attr);
+  if (it != attributeIDs.end())
+    return it->second;
+
+  // Entries may only reference entries with a smaller id, so make sure that
+  // any nested attributes and types are numbered before this one is emitted.
+  // Note that this may grow the table, so the entry is emitted to a scratch
+  // buffer first.
+  SmallVector<char, 16> entry;
+  EncodingWriter writer(entry);
+  switch (attr.getKind()) {
+  case Attribute::Kind::Bool:
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Bool));
+    writer.emitByte(attr.cast<BoolAttr>().getValue());
+    break;
+  case Attribute::Kind::Integer: {
+    auto intAttr = attr.cast<IntegerAttr>();
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Integer));
+    writer.emitVarInt(getTypeID(intAttr.getType()));
+    writer.emitAPInt(intAttr.getValue());
+    break;
+  }
+  case Attribute::Kind::Float: {
+    auto floatAttr = attr.cast<FloatAttr>();
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Float));
+    writer.emitVarInt(getTypeID(floatAttr.getType()));
+    writer.emitAPInt(floatAttr.getValue().bitcastToAPInt());
+    break;
+  }
+  case Attribute::Kind::String:
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::String));
+    writer.emitVarInt(getStringID(attr.cast<StringAttr>().getValue()));
+    break;
+  case Attribute::Kind::Type:
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Type));
+    writer.emitVarInt(getTypeID(attr.cast<TypeAttr>().getValue()));
+    break;
+  case Attribute::Kind::Array: {
+    auto elements = attr.cast<ArrayAttr>().getValue();
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Array));
+    writer.emitVarInt(elements.size());
+    for (Attribute element : elements)
+      writer.emitVarInt(getAttributeID(element));
+    break;
+  }
+  case Attribute::Kind::Function: {
+    auto *function = attr.cast<FunctionAttr>().getValue();
+    assert(function && "cannot encode a reference to a deleted function");
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Function));
+    writer.emitVarInt(getStringID(function->getName()));
+    break;
+  }
+  case Attribute::Kind::DenseIntElements:
+  case Attribute::Kind::DenseFPElements: {
+    auto elementsAttr = attr.cast<DenseElementsAttr>();
+    writer.emitByte(static_cast<uint8_t>(elementsAttr.isSplat()
+                                             ? AttributeKind::DenseSplatElements
+                                             : AttributeKind::DenseElements));
+    writer.emitVarInt(getTypeID(elementsAttr.getType()));
+    writer.emitString(
+        StringRef(elementsAttr.getRawData().data(),
+                  elementsAttr.getRawData().size()));
+    break;
+  }
+  default: {
+    std::string attrStr;
+    llvm::raw_string_ostream os(attrStr);
+    attr.print(os);
+    writer.emitByte(static_cast<uint8_t>(AttributeKind::Textual));
+    writer.emitVarInt(getStringID(os.str()));
+    break;
+  }
+  }
+
+  attributeWriter.emitBytes(entry);
+  unsigned id = attributeIDs.size();
+  return attributeIDs[attr] = id;
+}
+
+unsigned BytecodeWriter::getLocationID(Location loc) {
+  auto it = locationIDs.find(loc.getAsOpaquePointer());
+  if (it != locationIDs.end())
+    return it->second;
+
+  SmallVector<char, 16> entry;
+  EncodingWriter writer(entry);
+  switch (loc.getKind()) {
+  case Location::Kind::Unknown:
+    writer.emitByte(static_cast<uint8_t>(LocationKind::Unknown));
+    break;
+  case Location::Kind::FileLineCol: {
+    auto fileLoc = loc.cast<FileLineColLoc>();
+    writer.emitByte(static_cast<uint8_t>(LocationKind::FileLineCol));
+    writer.emitVarInt(getStringID(fileLoc.getFilename()));
+    writer.emitVarInt(fileLoc.getLine());
+    writer.emitVarInt(fileLoc.getColumn());
+    break;
+  }
+  case Location::Kind::Name:
+    writer.emitByte(static_cast<uint8_t>(LocationKind::Name));
+    writer.emitVarInt(getStringID(loc.cast<NameLoc>().getName()));
+    break;
+  case Location::Kind::CallSite: {
+    auto callLoc = loc.cast<CallSiteLoc>();
+    writer.emitByte(static_cast<uint8_t>(LocationKind::CallSite));
+    writer.emitVarInt(getLocationID(callLoc.getCallee()));
+    writer.emitVarInt(getLocationID(callLoc.getCaller()));
+    break;
+  }
+  case Location::Kind::FusedLocation: {
+    auto fusedLoc = loc.cast<FusedLoc>();
+    writer.emitByte(static_cast<uint8_t>(LocationKind::Fused));
+    writer.emitVarInt(fusedLoc.getLocations().size());
+    for (Location childLoc : fusedLoc.getLocations())
+      writer.emitVarInt(getLocationID(childLoc));
+
+    // The metadata is optional, so offset the attribute id by one and reserve
+    // zero for a missing attribute.
+    Attribute metadata = fusedLoc.getMetadata();
+    writer.emitVarInt(metadata ? getAttributeID(metadata) + 1 : 0);
+    break;
+  }
+  }
+
+  locationWriter.emitBytes(entry);
+  unsigned id = locationIDs.size();
+  return locationIDs[loc.getAsOpaquePointer()] = id;
+}
+
+void BytecodeWriter::writeAttributeList(ArrayRef<NamedAttribute> attrs,
+                                        EncodingWriter &writer) {
+  writer.emitVarInt(attrs.size());
+  for (const NamedAttribute &attr : attrs) {
+    writer.emitVarInt(getStringID(attr.first));
+    writer.emitVarInt(getAttributeID(attr.second));
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Function bodies
+//===----------------------------------------------------------------------===//
+
+void BytecodeWriter::numberValues(Region &region) {
+  for (Block &block : region)
+    for (BlockArgument *arg : block.getArguments())
+      valueIDs[arg] = numNumberedValues++;
+
+  for (Block &block : region) {
+    for (Operation &op : block) {
+      for (Region &nestedRegion : op.getRegions())
+        numberValues(nestedRegion);
+      for (Value *result : op.getResults())
+        valueIDs[result] = numNumberedValues++;
+    }
+  }
+}
+
+void BytecodeWriter::writeFunctionBody(Function &fn, EncodingWriter &writer) {
+  valueIDs.clear();
+  numNumberedValues = numDefinedValues = 0;
+  numberValues(fn.getBody());
+
+  writer.emitVarInt(numNumberedValues);
+  writeRegion(fn.getBody(), writer);
+}
+
+void BytecodeWriter::writeRegion(Region &region, EncodingWriter &writer) {
+  // Emit all of the blocks, along with their arguments, before any of the
+  // operations so that successors are always defined.
+  unsigned numBlocks = 0;
+  for (Block &block : region)
+    blockIDs[&block] = numBlocks++;
+
+  writer.emitVarInt(numBlocks);
+  for (Block &block : region) {
+    writer.emitVarInt(block.getNumArguments());
+    for (BlockArgument *arg : block.getArguments())
+      writer.emitVarInt(getTypeID(arg->getType()));
+    numDefinedValues += block.getNumArguments();
+  }
+
+  for (Block &block : region) {
+    writer.emitVarInt(block.getOperations().size());
+    for (Operation &op : block)
+      writeOperation(&op, writer);
+  }
+}
+
+void BytecodeWriter::writeOperation(Operation *op, EncodingWriter &writer) {
+  writer.emitVarInt(getStringID(op->getName().getStringRef()));
+  writer.emitVarInt(getLocationID(op->getLoc()));
+
+  uint64_t flags = 0;
+  if (op->hasResizableOperandsList())
+    flags |= OperationFlags::ResizableOperandList;
+  writer.emitVarInt(flags);
+
+  writer.emitVarInt(op->getNumResults());
+  for (Value *result : op->getResults())
+    writer.emitVarInt(getTypeID(result->getType()));
+
+  // Emit the operands that don't belong to a successor.
+  unsigned numSuccessors = op->getNumSuccessors();
+  unsigned numOperands = numSuccessors ? op->getSuccessorOperandIndex(0)
+                                       : op->getNumOperands();
+  writer.emitVarInt(numOperands);
+  for (unsigned i = 0; i != numOperands; ++i)
+    writeOperand(op->getOperand(i), writer);
+
+  writeAttributeList(op->getAttrs(), writer);
+
+  writer.emitVarInt(numSuccessors);
+  for (unsigned i = 0; i != numSuccessors; ++i) {
+    writer.emitVarInt(blockIDs[op->getSuccessor(i)]);
+    writer.emitVarInt(op->getNumSuccessorOperands(i));
+    for (Value *operand : op->getSuccessorOperands(i))
+      writeOperand(operand, writer);
+  }
+
+  // Results are defined after any nested regions.
+  writer.emitVarInt(op->getNumRegions());
+  for (Region &region : op->getRegions())
+    writeRegion(region, writer);
+  numDefinedValues += op->getNumResults();
+}
+
+void BytecodeWriter::writeOperand(Value *value, EncodingWriter &writer) {
+  auto it = valueIDs.find(value);
+  assert(it != valueIDs.end() && "operand defined outside of the function");
+
+  // Forward references also encode their type, as the reader needs to create
+  // a placeholder for them.
+  bool isForwardRef = it->second >= numDefinedValues;
+  writer.emitVarInt((uint64_t(it->second) << 1) | isForwardRef);
+  if (isForwardRef)
+    writer.emitVarInt(getTypeID(value->getType()));
+}
+
+//===----------------------------------------------------------------------===//
+// Module
+//===----------------------------------------------------------------------===//
+
+void BytecodeWriter::write(raw_ostream &os) {
+  // Encode each of the function bodies, which populates the uniqued tables.
+  SmallVector<char, 0> bodies;
+  EncodingWriter bodyWriter(bodies);
+  std::vector<std::pair<uint64_t, uint64_t>> bodyRanges;
+  for (Function &fn : *module) {
+    uint64_t offset = bodyWriter.size();
+    if (!fn.isExternal())
+      writeFunctionBody(fn, bodyWriter);
+    bodyRanges.emplace_back(offset, bodyWriter.size() - offset);
+  }
+
+  // Encode the symbols and the function index.
+  SmallVector<char, 0> symbols, functions;
+  EncodingWriter symbolWriter(symbols), functionWriter(functions);
+  unsigned numFunctions = 0;
+  for (Function &fn : *module) {
+    symbolWriter.emitVarInt(getStringID(fn.getName()));
+    symbolWriter.emitVarInt(getTypeID(fn.getType()));
+
+    functionWriter.emitVarInt(getLocationID(fn.getLoc()));
+    writeAttributeList(fn.getAttrs(), functionWriter);
+    for (unsigned i = 0, e = fn.getNumArguments(); i != e; ++i)
+      writeAttributeList(fn.getArgAttrs(i), functionWriter);
+    functionWriter.emitVarInt(bodyRanges[numFunctions].first);
+    functionWriter.emitVarInt(bodyRanges[numFunctions].second);
+    ++numFunctions;
+  }
+
+  // Now that all of the tables are complete, emit the file.
+  SmallVector<char, 0> file;
+  EncodingWriter fileWriter(file);
+  fileWriter.emitBytes(kMagic);
+  fileWriter.emitVarInt(kVersion);
+
+  fileWriter.emitVarInt(strings.size());
+  for (StringRef str : strings)
+    fileWriter.emitString(str);
+
+  fileWriter.emitVarInt(typeStrings.size());
+  for (unsigned typeString : typeStrings)
+    fileWriter.emitVarInt(typeString);
+
+  fileWriter.emitVarInt(numFunctions);
+  fileWriter.emitBytes(symbols);
+
+  fileWriter.emitVarInt(attributeIDs.size());
+  fileWriter.emitBytes(attributeEntries);
+
+  fileWriter.emitVarInt(locationIDs.size());
+  fileWriter.emitBytes(locationEntries);
+
+  fileWriter.emitBytes(functions);
+
+  fileWriter.emitVarInt(bodies.size());
+  fileWriter.emitBytes(bodies);
+
+  os.write(file.data(), file.size());
+}
+
+/// Write the given module to `os` in the bytecode format.
+void mlir::writeBytecodeFile(Module *module, raw_ostream &os) {
+  BytecodeWriter(module).write(os);
+}
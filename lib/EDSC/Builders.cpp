@@ -224,6 +224,17 @@ mlir::edsc::LoopNestBuilder::operator()(ArrayRef<CapturableHandle> stmts) {
   return ValueHandle::null();
 }
 
+mlir::edsc::ParallelLoopNestBuilder::ParallelLoopNestBuilder(
+    ArrayRef<ValueHandle *> ivs, ArrayRef<ValueHandle> lbs,
+    ArrayRef<ValueHandle> ubs, ArrayRef<int64_t> steps)
+    : LoopNestBuilder(ivs, lbs, ubs, steps) {
+  auto *builder = ScopedContext::getBuilder();
+  for (auto *iv : ivs)
+    getForInductionVarOwner(iv->getValue())
+        .getOperation()
+        ->setAttr("llvm.loop.parallel", builder->getBoolAttr(true));
+}
+
 mlir::edsc::BlockBuilder::BlockBuilder(BlockHandle bh, Append) {
   assert(bh && "Expected already captured BlockHandle");
   enter(bh.getBlock());
@@ -0,0 +1,34 @@
+//===- BoundsCheckRuntime.cpp - Runtime support for bounds checks ---------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the runtime function called by the bounds checks of the
+// memref accesses.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/ExecutionEngine/BoundsCheckRuntime.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ErrorHandling.h"
+
+extern "C" void mlir_memref_bounds_check(intptr_t index, intptr_t size) {
+  if (index >= 0 && index < size)
+    return;
+  llvm::report_fatal_error(llvm::Twine("memref index ") +
+                           llvm::Twine(static_cast<int64_t>(index)) +
+                           " is out of bounds for a dimension of size " +
+                           llvm::Twine(static_cast<int64_t>(size)));
+}
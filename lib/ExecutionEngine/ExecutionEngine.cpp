@@ -20,14 +20,25 @@
 //
 //===----------------------------------------------------------------------===//
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/ExecutionEngine/BoundsCheckRuntime.h"
+#include "mlir/ExecutionEngine/GPURuntime.h"
+#include "mlir/ExecutionEngine/MathRuntime.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "mlir/ExecutionEngine/ParallelRuntime.h"
+#include "mlir/ExecutionEngine/ProfileRuntime.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Module.h"
+#include "mlir/IR/StructuralHash.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/LLVMIR/Transforms.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
+#include "mlir/StandardOps/Ops.h"
 #include "mlir/Target/LLVMIR.h"
 #include "mlir/Transforms/Passes.h"
 
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ExecutionEngine/JITEventListener.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
@@ -36,13 +47,35 @@
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Object/SymbolSize.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Target/TargetMachine.h"
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <thread>
 
 using namespace mlir;
 using llvm::Error;
 using llvm::Expected;
 
+// Wrap a string into an llvm::StringError.
+static inline Error make_string_error(const llvm::Twine &message) {
+  return llvm::make_error<llvm::StringError>(message.str(),
+                                             llvm::inconvertibleErrorCode());
+}
+
 namespace {
 // Memory manager for the JIT's objectLayer.  Its main goal is to fallback to
 // resolving functions in the current process if they cannot be resolved in the
@@ -71,10 +104,125 @@ public:
 private:
   llvm::orc::ExecutionSession &session;
 };
+
+// JIT event listener appending an entry for each function of the loaded objects
+// to a perf map file.  Each line of the file holds the start address and the
+// size of a function, in hexadecimal, followed by its name.
+class PerfMapListener : public llvm::JITEventListener {
+public:
+  explicit PerfMapListener(StringRef path) : path(path) {}
+
+  void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile &object,
+                          const llvm::RuntimeDyld::LoadedObjectInfo &info)
+      override {
+    // The debug object holds the addresses the symbols were loaded at.
+    auto debugObject = info.getObjectForDebug(object);
+    if (!debugObject.getBinary())
+      return;
+
+    std::string entries;
+    llvm::raw_string_ostream os(entries);
+    for (const auto &symbolAndSize :
+         llvm::object::computeSymbolSizes(*debugObject.getBinary())) {
+      const llvm::object::SymbolRef &symbol = symbolAndSize.first;
+      auto type = symbol.getType();
+      if (!type || *type != llvm::object::SymbolRef::ST_Function) {
+        llvm::consumeError(type.takeError());
+        continue;
+      }
+      auto name = symbol.getName();
+      auto address = symbol.getAddress();
+      if (!name || !address) {
+        llvm::consumeError(name.takeError());
+        llvm::consumeError(address.takeError());
+        continue;
+      }
+      os << llvm::format_hex_no_prefix(*address, 1) << ' '
+         << llvm::format_hex_no_prefix(symbolAndSize.second, 1) << ' ' << *name
+         << '\n';
+    }
+    if (os.str().empty())
+      return;
+
+    // The file is shared by all the engines of the process, which may load
+    // objects concurrently, so the entries of an object are appended at once.
+    static std::mutex fileMutex;
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::error_code error;
+    llvm::raw_fd_ostream file(path, error,
+                              llvm::sys::fs::F_Append | llvm::sys::fs::F_Text);
+    if (!error)
+      file << os.str();
+  }
+
+private:
+  std::string path;
+};
 } // end anonymous namespace
 
+// The functions of the GPU runtime returning the ids of the threads executing
+// the kernels on the host.
+static const std::pair<const char *, intptr_t (*)()> kGPUIdFunctions[] = {
+    {"mlir_gpu_thread_id_x", &mlir_gpu_thread_id_x},
+    {"mlir_gpu_thread_id_y", &mlir_gpu_thread_id_y},
+    {"mlir_gpu_thread_id_z", &mlir_gpu_thread_id_z},
+    {"mlir_gpu_block_id_x", &mlir_gpu_block_id_x},
+    {"mlir_gpu_block_id_y", &mlir_gpu_block_id_y},
+    {"mlir_gpu_block_id_z", &mlir_gpu_block_id_z},
+    {"mlir_gpu_block_dim_x", &mlir_gpu_block_dim_x},
+    {"mlir_gpu_block_dim_y", &mlir_gpu_block_dim_y},
+    {"mlir_gpu_block_dim_z", &mlir_gpu_block_dim_z}};
+
 namespace mlir {
 namespace impl {
+// A materialization unit for a single MLIR function, defining the symbols of
+// the function and of its packed wrapper.  The function is only translated to
+// LLVM IR when one of these symbols is first looked up, and the resulting
+// module is then emitted by the given IR layer.  Translations create modules
+// in the context of the LLVM dialect, so they are serialized with `mutex`.
+// This mutex is recursive because linking a function may look up, and thus
+// materialize, the functions it calls on the same thread.
+class LazyFunctionMaterializationUnit : public llvm::orc::MaterializationUnit {
+public:
+  using Translator =
+      std::function<Expected<std::unique_ptr<llvm::Module>>(Function &)>;
+
+  LazyFunctionMaterializationUnit(llvm::orc::SymbolFlagsMap symbols,
+                                  Function &function, llvm::orc::IRLayer &layer,
+                                  llvm::orc::ThreadSafeContext context,
+                                  std::recursive_mutex &mutex,
+                                  Translator translator)
+      : MaterializationUnit(std::move(symbols), llvm::orc::VModuleKey()),
+        function(function), layer(layer), context(std::move(context)),
+        mutex(mutex), translator(std::move(translator)) {}
+
+  StringRef getName() const override { return function.getName().strref(); }
+
+  void materialize(llvm::orc::MaterializationResponsibility resp) override {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto module = translator(function);
+    if (!module) {
+      layer.getExecutionSession().reportError(module.takeError());
+      resp.failMaterialization();
+      return;
+    }
+    layer.emit(std::move(resp),
+               llvm::orc::ThreadSafeModule(std::move(*module), context));
+  }
+
+private:
+  // The symbols of a function are never overridden, so there is nothing to
+  // discard.
+  void discard(const llvm::orc::JITDylib &,
+               const llvm::orc::SymbolStringPtr &) override {}
+
+  Function &function;
+  llvm::orc::IRLayer &layer;
+  llvm::orc::ThreadSafeContext context;
+  std::recursive_mutex &mutex;
+  Translator translator;
+};
+
 // Simple layered Orc JIT compilation engine.
 class OrcJIT {
 public:
@@ -86,25 +234,57 @@ public:
   // calls to library functions present in the process.
   OrcJIT(llvm::orc::JITTargetMachineBuilder machineBuilder,
          llvm::DataLayout layout, IRTransformer transform)
-      : irTransformer(transform),
+      : irTransformer(transform), targetMachineBuilder(machineBuilder),
         objectLayer(
             session,
             [this]() { return llvm::make_unique<MemoryManager>(session); }),
-        compileLayer(
-            session, objectLayer,
-            llvm::orc::ConcurrentIRCompiler(std::move(machineBuilder))),
+        compileLayer(session, objectLayer,
+                     makeCompileFunction(std::move(machineBuilder))),
         transformLayer(session, compileLayer, makeIRTransformFunction()),
         dataLayout(layout), mangler(session, this->dataLayout),
         threadSafeCtx(llvm::make_unique<llvm::LLVMContext>()) {
     session.getMainJITDylib().setGenerator(
         cantFail(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
             layout)));
+
+    // Make the parallel, profile, GPU and bounds check runtimes available to
+    // the compiled code, whether or not the host process exports their
+    // symbols.
+    llvm::orc::SymbolMap runtimeSymbols;
+    auto addRuntimeSymbol = [&](StringRef name,
+                                llvm::JITTargetAddress address) {
+      runtimeSymbols[mangler(name)] = llvm::JITEvaluatedSymbol(
+          address,
+          llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    };
+    addRuntimeSymbol("mlir_parallel_for",
+                     llvm::pointerToJITTargetAddress(&mlir_parallel_for));
+    addRuntimeSymbol("mlir_profile_timestamp",
+                     llvm::pointerToJITTargetAddress(&mlir_profile_timestamp));
+    addRuntimeSymbol(
+        "mlir_profile_record_loop",
+        llvm::pointerToJITTargetAddress(&mlir_profile_record_loop));
+    addRuntimeSymbol(
+        "mlir_profile_record_function",
+        llvm::pointerToJITTargetAddress(&mlir_profile_record_function));
+    addRuntimeSymbol("mlir_gpu_launch",
+                     llvm::pointerToJITTargetAddress(&mlir_gpu_launch));
+    for (auto &idFunction : kGPUIdFunctions)
+      addRuntimeSymbol(idFunction.first,
+                       llvm::pointerToJITTargetAddress(idFunction.second));
+    addRuntimeSymbol(
+        "mlir_memref_bounds_check",
+        llvm::pointerToJITTargetAddress(&mlir_memref_bounds_check));
+    cantFail(session.getMainJITDylib().define(
+        llvm::orc::absoluteSymbols(std::move(runtimeSymbols))));
   }
 
-  // Create a JIT engine for the current host.
+  // Create a JIT engine for the current host, targeting the given CPU and
+  // features, see `createHostTargetMachineBuilder`.
   static Expected<std::unique_ptr<OrcJIT>>
-  createDefault(IRTransformer transformer) {
-    auto machineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+  createDefault(IRTransformer transformer, StringRef cpu = "",
+                StringRef features = "") {
+    auto machineBuilder = createHostTargetMachineBuilder(cpu, features);
     if (!machineBuilder)
       return machineBuilder.takeError();
 
@@ -116,18 +296,138 @@ public:
                                      std::move(*dataLayout), transformer);
   }
 
-  // Add an LLVM module to the main library managed by the JIT engine.
-  Error addModule(std::unique_ptr<llvm::Module> M) {
+  // Add an LLVM module to the main library managed by the JIT engine.  If
+  // `objectCachePath` is not empty, the object file compiled for the module is
+  // written to that path.
+  Error addModule(std::unique_ptr<llvm::Module> M,
+                  StringRef objectCachePath = "") {
+    cachePath = objectCachePath;
     return transformLayer.add(
         session.getMainJITDylib(),
         llvm::orc::ThreadSafeModule(std::move(M), threadSafeCtx));
   }
 
+  // Add an already compiled object file to the main library managed by the JIT
+  // engine.
+  Error addObjectFile(std::unique_ptr<llvm::MemoryBuffer> object) {
+    return objectLayer.add(session.getMainJITDylib(), std::move(object));
+  }
+
+  // Add the given parts of a split module to the main library managed by the
+  // JIT engine.  Each part is compiled the first time one of its symbols is
+  // looked up.
+  Error addModuleParts(std::vector<llvm::orc::ThreadSafeModule> parts) {
+    for (auto &part : parts)
+      if (auto err = transformLayer.add(session.getMainJITDylib(),
+                                        std::move(part)))
+        return err;
+    return Error::success();
+  }
+
+  // Transform and compile the given parts of a split module in parallel, and
+  // add the resulting object files to the main library managed by the JIT
+  // engine.  Only code generation runs in parallel: linking happens lazily on
+  // lookup, like for any other object file.
+  Error compileModuleParts(std::vector<llvm::orc::ThreadSafeModule> parts,
+                           MLIRContext *context) {
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects(parts.size());
+    std::mutex errorMutex;
+    Error error = Error::success();
+    auto compilePart = [&](unsigned i) -> Error {
+      llvm::Module &module = *parts[i].getModule();
+      if (irTransformer)
+        if (auto err = irTransformer(&module))
+          return err;
+      auto machine = targetMachineBuilder.createTargetMachine();
+      if (!machine)
+        return machine.takeError();
+      objects[i] = llvm::orc::SimpleCompiler(**machine)(module);
+      if (!objects[i])
+        return make_string_error("could not compile module part");
+      return Error::success();
+    };
+
+    std::vector<unsigned> partIndices(parts.size());
+    std::iota(partIndices.begin(), partIndices.end(), 0);
+    parallelForEach(context, partIndices.begin(), partIndices.end(),
+                    [&](unsigned i) {
+                      if (auto err = compilePart(i)) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        error = llvm::joinErrors(std::move(error),
+                                                 std::move(err));
+                      }
+                    });
+    if (error)
+      return error;
+
+    for (auto &object : objects)
+      if (auto err = addObjectFile(std::move(object)))
+        return err;
+    return Error::success();
+  }
+
+  // Add the given MLIR function to the main library managed by the JIT engine,
+  // defining the symbols in `symbolNames`.  The function is translated with
+  // `translator` and compiled the first time one of these symbols is looked
+  // up.  The function must outlive the JIT engine.
+  Error
+  addLazyFunction(Function &function, ArrayRef<std::string> symbolNames,
+                  LazyFunctionMaterializationUnit::Translator translator) {
+    llvm::orc::SymbolFlagsMap symbols;
+    for (auto &name : symbolNames)
+      symbols[mangler(name)] =
+          llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+    return session.getMainJITDylib().define(
+        llvm::make_unique<LazyFunctionMaterializationUnit>(
+            std::move(symbols), function, transformLayer, threadSafeCtx,
+            lazyTranslationMutex, std::move(translator)));
+  }
+
   // Lookup a symbol in the main library managed by the JIT engine.
   Expected<llvm::JITEvaluatedSymbol> lookup(StringRef Name) {
     return session.lookup({&session.getMainJITDylib()}, mangler(Name.str()));
   }
 
+  // Report the objects loaded by the JIT engine to the debuggers and profilers
+  // enabled in `options`.  This must be called before any object is loaded.
+  void registerEventListeners(const ExecutionEngineOptions &options) {
+    if (options.enableGDBNotificationListener)
+      eventListeners.push_back(
+          llvm::JITEventListener::createGDBRegistrationListener());
+    if (options.enablePerfNotificationListener)
+      if (auto *listener = llvm::JITEventListener::createPerfJITEventListener())
+        eventListeners.push_back(listener);
+    if (options.enablePerfMap) {
+      std::string path = options.perfMapFile;
+      if (path.empty())
+        path = ("/tmp/perf-" + Twine(llvm::sys::Process::getProcessId()) +
+                ".map")
+                   .str();
+      perfMapListener = llvm::make_unique<PerfMapListener>(path);
+      eventListeners.push_back(perfMapListener.get());
+    }
+    if (eventListeners.empty())
+      return;
+
+    // The module keys given by the object layer are not unique, so each object
+    // gets its own key for the listeners to identify it when it is freed.
+    objectLayer.setNotifyLoaded(
+        [this](llvm::orc::VModuleKey, const llvm::object::ObjectFile &object,
+               const llvm::RuntimeDyld::LoadedObjectInfo &info) {
+          llvm::JITEventListener::ObjectKey key = ++numLoadedObjects;
+          for (auto *listener : eventListeners)
+            listener->notifyObjectLoaded(key, object, info);
+        });
+  }
+
+  // Tell the listeners that the loaded objects are freed with the engine.
+  ~OrcJIT() {
+    for (llvm::JITEventListener::ObjectKey key = 1; key <= numLoadedObjects;
+         ++key)
+      for (auto *listener : eventListeners)
+        listener->notifyFreeingObject(key);
+  }
+
 private:
   // Wrap the `irTransformer` into a function that can be called by the
   // IRTranformLayer.  If `irTransformer` is not set up, return the module as is
@@ -145,7 +445,47 @@ private:
     };
   }
 
+  // Create the function used by the IRCompileLayer to compile modules.  This
+  // compiles for the target host defined by `machineBuilder`, and writes the
+  // resulting object file to `cachePath` if set.
+  llvm::orc::IRCompileLayer::CompileFunction
+  makeCompileFunction(llvm::orc::JITTargetMachineBuilder machineBuilder) {
+    auto compiler = std::make_shared<llvm::orc::ConcurrentIRCompiler>(
+        std::move(machineBuilder));
+    return [this, compiler](llvm::Module &module)
+               -> Expected<std::unique_ptr<llvm::MemoryBuffer>> {
+      std::unique_ptr<llvm::MemoryBuffer> object = (*compiler)(module);
+      if (object && !cachePath.empty())
+        writeCachedObject(*object);
+      return std::move(object);
+    };
+  }
+
+  // Write the given object file to `cachePath`.  The cache is best effort, so
+  // failures are ignored.  The object is written to a temporary file first and
+  // then renamed, so that concurrent processes never observe a partial file.
+  void writeCachedObject(const llvm::MemoryBuffer &object) {
+    int fd;
+    llvm::SmallString<128> tempPath;
+    if (llvm::sys::fs::createUniqueFile(cachePath + ".%%%%%%.tmp", fd,
+                                        tempPath))
+      return;
+    {
+      llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+      os << object.getBuffer();
+      if (os.has_error()) {
+        os.clear_error();
+        llvm::sys::fs::remove(tempPath);
+        return;
+      }
+    }
+    if (llvm::sys::fs::rename(tempPath, cachePath))
+      llvm::sys::fs::remove(tempPath);
+  }
+
   IRTransformer irTransformer;
+  std::string cachePath;
+  llvm::orc::JITTargetMachineBuilder targetMachineBuilder;
   llvm::orc::ExecutionSession session;
   llvm::orc::RTDyldObjectLinkingLayer objectLayer;
   llvm::orc::IRCompileLayer compileLayer;
@@ -153,16 +493,50 @@ private:
   llvm::DataLayout dataLayout;
   llvm::orc::MangleAndInterner mangler;
   llvm::orc::ThreadSafeContext threadSafeCtx;
+  std::recursive_mutex lazyTranslationMutex;
+
+  // The listeners the loaded objects are reported to, and the number of
+  // objects reported so far, which are identified by their rank.  Only the
+  // perf map listener is owned, the others are singletons provided by LLVM.
+  std::vector<llvm::JITEventListener *> eventListeners;
+  std::unique_ptr<PerfMapListener> perfMapListener;
+  std::atomic<llvm::JITEventListener::ObjectKey> numLoadedObjects{0};
+};
+
+// The state of the tiered compilation of an engine: the engine compiling the
+// optimized version on a background thread, and the function pointers behind
+// the TieredFunction handles, which are swapped to the optimized version once
+// it is compiled.
+class TieredCompilation {
+public:
+  using PackedFunctionPtr = JITFunction::PackedFunctionPtr;
+
+  ~TieredCompilation() {
+    if (thread.joinable())
+      thread.join();
+  }
+
+  // Compile the optimized version and swap it in.  Runs on `thread`.
+  void compileOptimizedVersion(
+      Module *m, const std::function<Error(llvm::Module *)> &transformer,
+      const ExecutionEngineOptions &options);
+
+  // Guards the members below, except for `optimized` which may be read
+  // without it.
+  std::mutex mutex;
+  llvm::StringMap<std::unique_ptr<std::atomic<PackedFunctionPtr>>> functions;
+  std::unique_ptr<ExecutionEngine> optimizedEngine;
+  std::string errorMessage;
+  // Set once `optimizedEngine` is compiled and swapped in.
+  std::atomic<bool> optimized{false};
+
+  // Serializes the joins of `thread`.
+  std::mutex threadMutex;
+  std::thread thread;
 };
 } // end namespace impl
 } // namespace mlir
 
-// Wrap a string into an llvm::StringError.
-static inline Error make_string_error(const llvm::Twine &message) {
-  return llvm::make_error<llvm::StringError>(message.str(),
-                                             llvm::inconvertibleErrorCode());
-}
-
 // Given a list of PassRegistryEntry coming from a higher level, populates the
 // given pass manager and appends the default set of required passes to lower to
 // LLVMIR.
@@ -271,40 +645,373 @@ void packFunctionArguments(llvm::Module *module) {
 }
 
 // Out of line for PIMPL unique_ptr.
-ExecutionEngine::~ExecutionEngine() = default;
+ExecutionEngine::~ExecutionEngine() {
+  // The code of the kernels is freed along with the JIT.
+  for (auto kernel : gpuKernels)
+    mlir_gpu_unregister_kernel(kernel);
+}
 
 std::unique_ptr<llvm::Module> translateModuleToLLVMIR(Module &m);
+std::unique_ptr<llvm::Module> translateFunctionToLLVMIR(Function &f);
 
-Expected<std::unique_ptr<ExecutionEngine>> ExecutionEngine::create(
-    Module *m, std::function<llvm::Error(llvm::Module *)> transformer) {
-  auto engine = llvm::make_unique<ExecutionEngine>();
-  auto expectedJIT = impl::OrcJIT::createDefault(transformer);
-  if (!expectedJIT)
-    return expectedJIT.takeError();
-
-  // Construct and run the default MLIR pipeline.
+// Run the default MLIR pipeline on the given module, lowering it to the LLVM
+// dialect.
+static Error runDefaultPipeline(Module *m) {
   PassManager manager;
   getDefaultPasses(manager, {});
   if (failed(manager.run(m)))
     return make_string_error("passes failed");
+  return Error::success();
+}
 
-  auto llvmModule = translateModuleToLLVMIR(*m);
-  if (!llvmModule)
-    return make_string_error("could not convert to LLVM IR");
+// Set all of the fast-math flags on the floating point instructions of the
+// given module, and let the code generator relax the floating point semantics
+// of its functions accordingly.
+static void enableFastMath(llvm::Module *llvmModule) {
+  for (llvm::Function &function : *llvmModule) {
+    if (function.isDeclaration())
+      continue;
+    for (auto attr : {"unsafe-fp-math", "no-infs-fp-math", "no-nans-fp-math",
+                      "no-signed-zeros-fp-math"})
+      function.addFnAttr(attr, "true");
+    for (llvm::BasicBlock &block : function)
+      for (llvm::Instruction &inst : block)
+        if (llvm::isa<llvm::FPMathOperator>(inst))
+          inst.setFast(true);
+  }
+}
+
+// Finalize an LLVM module translated from MLIR by setting up its target and
+// adding the packed function interface.  The functions of the math runtime
+// are defined afterwards, so that they do not get a packed interface.
+static void finalizeLLVMModule(llvm::Module *llvmModule,
+                               const ExecutionEngineOptions &options) {
   // FIXME: the triple should be passed to the translation or dialect conversion
   // instead of this.  Currently, the LLVM module created above has no triple
   // associated with it.
-  setupTargetTriple(llvmModule.get());
-  packFunctionArguments(llvmModule.get());
+  setupTargetTriple(llvmModule);
+  if (options.enableFastMath)
+    enableFastMath(llvmModule);
+  packFunctionArguments(llvmModule);
+  linkMathRuntime(*llvmModule);
+}
 
-  if (auto err = (*expectedJIT)->addModule(std::move(llvmModule)))
+// Lower the given module to an LLVM module with the packed function
+// interface, using the default MLIR pipeline.
+static Expected<std::unique_ptr<llvm::Module>>
+lowerToLLVMModule(Module *m, const ExecutionEngineOptions &options) {
+  if (auto err = runDefaultPipeline(m))
+    return std::move(err);
+
+  auto llvmModule = translateModuleToLLVMIR(*m);
+  if (!llvmModule)
+    return make_string_error("could not convert to LLVM IR");
+  finalizeLLVMModule(llvmModule.get(), options);
+  return std::move(llvmModule);
+}
+
+// Translate the given function, lowered to the LLVM dialect, to an LLVM module
+// that defines it along with its packed wrapper, and only declares the other
+// functions of its module.
+static Expected<std::unique_ptr<llvm::Module>>
+translateLoweredFunction(Function &function,
+                         const ExecutionEngineOptions &options) {
+  auto llvmModule = translateFunctionToLLVMIR(function);
+  if (!llvmModule)
+    return make_string_error("could not convert function '" +
+                             function.getName().strref() + "' to LLVM IR");
+  finalizeLLVMModule(llvmModule.get(), options);
+  return std::move(llvmModule);
+}
+
+// The version of the object cache entries.  This must be bumped whenever the
+// lowering of modules changes in a way that isn't reflected in their
+// fingerprint, e.g. a change in the default pipeline or in the packed function
+// interface.
+static constexpr llvm::StringLiteral kObjectCacheVersion = "1";
+
+// Return the path of the object cache entry for the given module.
+static std::string getObjectCachePath(Module *m,
+                                      const ExecutionEngineOptions &options) {
+  llvm::MD5 hasher;
+  auto addToKey = [&](StringRef str) {
+    hasher.update(str);
+    hasher.update(StringRef("\0", 1));
+  };
+  addToKey(kObjectCacheVersion);
+  addToKey(computeFingerprint(m).str());
+  addToKey(llvm::sys::getDefaultTargetTriple());
+  addToKey(llvm::sys::getHostCPUName());
+  addToKey(options.targetCPU);
+  addToKey(options.targetFeatures);
+  addToKey(options.transformerKey);
+  addToKey(options.enableFastMath ? "fast-math" : "");
+
+  llvm::MD5::MD5Result result;
+  hasher.final(result);
+  auto digest = result.digest();
+  llvm::SmallString<128> path(options.objectCacheDir);
+  llvm::sys::path::append(path, digest.str() + ".o");
+  return path.str().str();
+}
+
+// Translate the given module, lowered to the LLVM dialect, to `numParts` LLVM
+// modules, or one per defined function if `numParts` is 0, that can be
+// compiled independently.  The parts are translated concurrently, each in its
+// own context, and get the packed interface of the functions they define.
+static Expected<std::vector<llvm::orc::ThreadSafeModule>>
+translateToModuleParts(Module *m, unsigned numParts,
+                       const ExecutionEngineOptions &options) {
+  std::vector<LLVMIRModulePart> translatedParts;
+  if (failed(translateModuleToLLVMIRParts(*m, numParts, translatedParts)))
+    return make_string_error("could not convert to LLVM IR");
+
+  std::vector<llvm::orc::ThreadSafeModule> parts;
+  parts.reserve(translatedParts.size());
+  for (auto &part : translatedParts) {
+    finalizeLLVMModule(part.module.get(), options);
+    parts.emplace_back(std::move(part.module),
+                       llvm::orc::ThreadSafeContext(std::move(part.context)));
+  }
+  return std::move(parts);
+}
+
+// Register with the profile runtime the names of the regions instrumented by
+// the -instrument-loops pass.  Each call recording a region carries its name in
+// the "profile.region" attribute, and its identifier as its first operand.
+static void registerProfiledRegions(Module *m) {
+  for (auto &function : *m) {
+    function.walk([](CallOp call) {
+      auto name = call.getAttrOfType<StringAttr>("profile.region");
+      if (!name || call.getNumOperands() == 0)
+        return;
+      auto *def = call.getOperand(0)->getDefiningOp();
+      if (!def)
+        return;
+      if (auto region = def->dyn_cast<ConstantIntOp>())
+        mlir_profile_register_region(region.getValue(),
+                                     name.getValue().str().c_str());
+    });
+  }
+}
+
+// Name of the attribute marking the GPU kernels, see
+// createOutlineGPUKernelsPass.
+static constexpr const char *kGPUKernelAttrName = "gpu.kernel";
+
+Error ExecutionEngine::registerGPUKernels(
+    Module *m, const ExecutionEngineOptions &options) {
+  if (!options.enableGPU)
+    return Error::success();
+  std::vector<PTXKernel> kernels;
+  if (failed(translateGPUKernelsToPTX(*m, options.gpuArch, kernels)))
+    return make_string_error("could not translate the GPU kernels to PTX");
+
+  // The kernels are identified by the host functions launching them, see the
+  // conversion of the launches to the LLVM IR dialect.
+  for (auto &kernel : kernels) {
+    auto thunk = jit->lookup(kernel.name + "_thunk");
+    if (!thunk)
+      return thunk.takeError();
+    auto *launcher = reinterpret_cast<void (*)(void **)>(thunk->getAddress());
+    mlir_gpu_register_kernel(launcher, kernel.name.c_str(),
+                             kernel.ptx.c_str());
+    gpuKernels.push_back(launcher);
+  }
+  return Error::success();
+}
+
+Expected<std::unique_ptr<ExecutionEngine>>
+ExecutionEngine::create(Module *m,
+                        std::function<llvm::Error(llvm::Module *)> transformer,
+                        const ExecutionEngineOptions &options) {
+  return createImpl(m, transformer, options, /*translateToOwnContexts=*/false);
+}
+
+Expected<std::unique_ptr<ExecutionEngine>> ExecutionEngine::createImpl(
+    Module *m, std::function<llvm::Error(llvm::Module *)> transformer,
+    const ExecutionEngineOptions &options, bool translateToOwnContexts) {
+  auto engine = llvm::make_unique<ExecutionEngine>();
+  auto expectedJIT = impl::OrcJIT::createDefault(
+      transformer, options.targetCPU, options.targetFeatures);
+  if (!expectedJIT)
+    return expectedJIT.takeError();
+  (*expectedJIT)->registerEventListeners(options);
+  registerProfiledRegions(m);
+
+  // When translating lazily, only lower the module to the LLVM dialect upfront
+  // and defer the translation of each function to its first lookup.
+  if (options.lazyTranslation && !translateToOwnContexts) {
+    if (auto err = runDefaultPipeline(m))
+      return std::move(err);
+    auto translator = [options](Function &function) {
+      return translateLoweredFunction(function, options);
+    };
+    for (auto &function : *m) {
+      if (function.isExternal())
+        continue;
+      std::string symbolNames[] = {
+          function.getName().strref().str(),
+          makePackedFunctionName(function.getName().strref())};
+      if (auto err = (*expectedJIT)->addLazyFunction(function, symbolNames,
+                                                     translator))
+        return std::move(err);
+    }
+    engine->jit = std::move(*expectedJIT);
+    if (auto err = engine->registerGPUKernels(m, options))
+      return std::move(err);
+    return std::move(engine);
+  }
+
+  bool splitModuleForCompilation = options.numCompileThreads > 1 ||
+                                   options.lazyCompilation ||
+                                   translateToOwnContexts;
+
+  // If an object was cached for this module, load it directly.  The cache is
+  // not used for GPU kernels, which are translated from the lowered module.
+  std::string objectCachePath;
+  if (!options.objectCacheDir.empty() && !splitModuleForCompilation &&
+      !options.enableGPU) {
+    objectCachePath = getObjectCachePath(m, options);
+    if (auto object = llvm::MemoryBuffer::getFile(objectCachePath)) {
+      if (auto err = (*expectedJIT)->addObjectFile(std::move(*object)))
+        return std::move(err);
+      engine->jit = std::move(*expectedJIT);
+      return std::move(engine);
+    }
+  }
+
+  if (!splitModuleForCompilation) {
+    auto llvmModule = lowerToLLVMModule(m, options);
+    if (!llvmModule)
+      return llvmModule.takeError();
+    if (auto err = (*expectedJIT)->addModule(std::move(*llvmModule),
+                                            objectCachePath))
+      return std::move(err);
+    engine->jit = std::move(*expectedJIT);
+    if (auto err = engine->registerGPUKernels(m, options))
+      return std::move(err);
+    return std::move(engine);
+  }
+
+  // Otherwise, translate the module to parts that are compiled independently:
+  // one per function when compiling lazily, or one per thread.
+  if (auto err = runDefaultPipeline(m))
+    return std::move(err);
+  unsigned numParts =
+      options.lazyCompilation ? 0 : std::max(options.numCompileThreads, 1u);
+  auto parts = translateToModuleParts(m, numParts, options);
+  if (!parts)
+    return parts.takeError();
+  if (auto err = options.lazyCompilation
+                     ? (*expectedJIT)->addModuleParts(std::move(*parts))
+                     : (*expectedJIT)->compileModuleParts(std::move(*parts),
+                                                          m->getContext()))
     return std::move(err);
   engine->jit = std::move(*expectedJIT);
+  if (auto err = engine->registerGPUKernels(m, options))
+    return std::move(err);
 
   return std::move(engine);
 }
 
+void impl::TieredCompilation::compileOptimizedVersion(
+    Module *m, const std::function<Error(llvm::Module *)> &transformer,
+    const ExecutionEngineOptions &options) {
+  // The module is translated to LLVM modules with their own contexts, as the
+  // quick version may meanwhile be compiled in the LLVM context of the
+  // dialect.
+  auto engine = ExecutionEngine::createImpl(m, transformer, options,
+                                            /*translateToOwnContexts=*/true);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!engine) {
+    errorMessage = llvm::toString(engine.takeError());
+    return;
+  }
+
+  // Look up all of the functions handed out before swapping any of them, so
+  // that they all keep on calling the quick version if one is missing.
+  std::vector<PackedFunctionPtr> optimizedPointers;
+  optimizedPointers.reserve(functions.size());
+  for (auto &function : functions) {
+    auto fptr = (*engine)->lookup(function.getKey());
+    if (!fptr) {
+      errorMessage = llvm::toString(fptr.takeError());
+      return;
+    }
+    optimizedPointers.push_back(*fptr);
+  }
+  auto fptrIt = optimizedPointers.begin();
+  for (auto &function : functions)
+    function.getValue()->store(*fptrIt++, std::memory_order_release);
+  optimizedEngine = std::move(*engine);
+  optimized.store(true, std::memory_order_release);
+}
+
+Expected<std::unique_ptr<ExecutionEngine>> ExecutionEngine::createTiered(
+    Module *m, Module *optimizedModule,
+    std::function<llvm::Error(llvm::Module *)> transformer,
+    std::function<llvm::Error(llvm::Module *)> optimizedTransformer,
+    const ExecutionEngineOptions &options) {
+  if (m == optimizedModule)
+    return make_string_error(
+        "the tiers must be compiled from different modules");
+  ExecutionEngineOptions tierOptions = options;
+  tierOptions.objectCacheDir.clear();
+  auto engine = create(m, transformer, tierOptions);
+  if (!engine)
+    return engine.takeError();
+
+  auto *tiered = new impl::TieredCompilation;
+  (*engine)->tiered.reset(tiered);
+  tiered->thread = std::thread([=]() {
+    tiered->compileOptimizedVersion(optimizedModule, optimizedTransformer,
+                                    tierOptions);
+  });
+  return engine;
+}
+
+Error ExecutionEngine::emitObjectFile(
+    Module *m, StringRef filename,
+    std::function<llvm::Error(llvm::Module *)> transformer,
+    const ExecutionEngineOptions &options) {
+  auto llvmModule = lowerToLLVMModule(m, options);
+  if (!llvmModule)
+    return llvmModule.takeError();
+  if (transformer)
+    if (auto err = transformer(llvmModule->get()))
+      return err;
+
+  // Create a target machine for the host.  The object is compiled as position
+  // independent code so that it can be linked into a shared library.
+  auto machineBuilder =
+      createHostTargetMachineBuilder(options.targetCPU, options.targetFeatures);
+  if (!machineBuilder)
+    return machineBuilder.takeError();
+  machineBuilder->setRelocationModel(llvm::Reloc::PIC_);
+  auto machine = machineBuilder->createTargetMachine();
+  if (!machine)
+    return machine.takeError();
+  (*llvmModule)->setDataLayout((*machine)->createDataLayout());
+
+  std::error_code error;
+  llvm::ToolOutputFile output(filename, error, llvm::sys::fs::F_None);
+  if (error)
+    return llvm::errorCodeToError(error);
+
+  llvm::legacy::PassManager codegenPasses;
+  if ((*machine)->addPassesToEmitFile(codegenPasses, output.os(), nullptr,
+                                      llvm::TargetMachine::CGFT_ObjectFile))
+    return make_string_error("target does not support object file emission");
+  codegenPasses.run(**llvmModule);
+  output.keep();
+  return Error::success();
+}
+
 Expected<void (*)(void **)> ExecutionEngine::lookup(StringRef name) const {
+  // Once swapped in, the optimized version of a tiered engine is used.
+  if (isOptimized())
+    return tiered->optimizedEngine->lookup(name);
   auto expectedSymbol = jit->lookup(makePackedFunctionName(name));
   if (!expectedSymbol)
     return expectedSymbol.takeError();
@@ -315,6 +1022,52 @@ Expected<void (*)(void **)> ExecutionEngine::lookup(StringRef name) const {
   return fptr;
 }
 
+Expected<JITFunction> ExecutionEngine::getFunction(StringRef name) const {
+  auto expectedFPtr = lookup(name);
+  if (!expectedFPtr)
+    return expectedFPtr.takeError();
+  return JITFunction(*expectedFPtr);
+}
+
+Expected<TieredFunction>
+ExecutionEngine::getTieredFunction(StringRef name) const {
+  if (!tiered)
+    return make_string_error("the engine was not created with createTiered");
+  // Holding the lock while looking up the function ensures that it is either
+  // looked up in the optimized version, or swapped to it.
+  std::lock_guard<std::mutex> lock(tiered->mutex);
+  auto &function = tiered->functions[name];
+  if (!function) {
+    auto expectedFPtr = lookup(name);
+    if (!expectedFPtr) {
+      tiered->functions.erase(name);
+      return expectedFPtr.takeError();
+    }
+    using PackedFunctionPtr = TieredFunction::PackedFunctionPtr;
+    function = llvm::make_unique<std::atomic<PackedFunctionPtr>>(*expectedFPtr);
+  }
+  return TieredFunction(function.get());
+}
+
+bool ExecutionEngine::isOptimized() const {
+  return tiered && tiered->optimized.load(std::memory_order_acquire);
+}
+
+Error ExecutionEngine::waitForOptimization() {
+  if (!tiered)
+    return Error::success();
+  {
+    std::lock_guard<std::mutex> lock(tiered->threadMutex);
+    if (tiered->thread.joinable())
+      tiered->thread.join();
+  }
+  std::lock_guard<std::mutex> lock(tiered->mutex);
+  if (!tiered->optimized)
+    return make_string_error("could not compile the optimized version: " +
+                             tiered->errorMessage);
+  return Error::success();
+}
+
 llvm::Error ExecutionEngine::invoke(StringRef name,
                                     MutableArrayRef<void *> args) {
   auto expectedFPtr = lookup(name);
@@ -326,3 +1079,16 @@ llvm::Error ExecutionEngine::invoke(StringRef name,
 
   return llvm::Error::success();
 }
+
+llvm::Error ExecutionEngine::invokeMany(StringRef name,
+                                        ArrayRef<void **> argumentPacks,
+                                        MLIRContext *context) {
+  auto expectedFunction = getFunction(name);
+  if (!expectedFunction)
+    return expectedFunction.takeError();
+  JITFunction function = *expectedFunction;
+
+  parallelForEach(context, argumentPacks.begin(), argumentPacks.end(),
+                  [function](void **args) { function(args); });
+  return llvm::Error::success();
+}
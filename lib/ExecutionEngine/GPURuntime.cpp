@@ -0,0 +1,215 @@
+//===- GPURuntime.cpp - Runtime support for GPU kernels -------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the runtime functions called by the code generated for
+// GPU kernels.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/ExecutionEngine/GPURuntime.h"
+#include "mlir/ExecutionEngine/ParallelRuntime.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <mutex>
+#include <string>
+
+#ifdef MLIR_CUDA_RUNTIME_ENABLED
+#include <cuda.h>
+#endif
+
+namespace {
+// A kernel registered with its PTX, and the CUDA function loaded from it the
+// first time it is launched.
+struct KernelImage {
+  std::string name;
+  std::string ptx;
+#ifdef MLIR_CUDA_RUNTIME_ENABLED
+  CUfunction function = nullptr;
+  bool loadFailed = false;
+#endif
+};
+
+// A launch of a kernel executed on the host.
+struct HostLaunch {
+  void (*kernel)(void **);
+  intptr_t grid[3];
+  intptr_t block[3];
+  void **params;
+};
+
+// The ids of the thread executing a kernel on the host.
+struct HostThread {
+  intptr_t threadId[3] = {0, 0, 0};
+  intptr_t blockId[3] = {0, 0, 0};
+  intptr_t blockDim[3] = {1, 1, 1};
+};
+} // end anonymous namespace
+
+static thread_local HostThread currentThread;
+
+// Get the registered kernels, keyed by the host functions launching them, and
+// the mutex guarding them.
+static llvm::DenseMap<void *, KernelImage> &getKernels() {
+  static llvm::DenseMap<void *, KernelImage> kernels;
+  return kernels;
+}
+static std::mutex &getKernelsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// Execute the blocks of linear ids `begin` to `end` (excluded) of the host
+// launch pointed to by `context`, one thread after the other.
+static void executeHostBlocks(intptr_t begin, intptr_t end, void *context) {
+  const HostLaunch &launch = *static_cast<HostLaunch *>(context);
+  HostThread saved = currentThread;
+  for (int dim = 0; dim < 3; ++dim)
+    currentThread.blockDim[dim] = launch.block[dim];
+  for (intptr_t block = begin; block < end; ++block) {
+    currentThread.blockId[0] = block % launch.grid[0];
+    currentThread.blockId[1] = block / launch.grid[0] % launch.grid[1];
+    currentThread.blockId[2] = block / (launch.grid[0] * launch.grid[1]);
+    for (intptr_t z = 0; z < launch.block[2]; ++z) {
+      currentThread.threadId[2] = z;
+      for (intptr_t y = 0; y < launch.block[1]; ++y) {
+        currentThread.threadId[1] = y;
+        for (intptr_t x = 0; x < launch.block[0]; ++x) {
+          currentThread.threadId[0] = x;
+          launch.kernel(launch.params);
+        }
+      }
+    }
+  }
+  currentThread = saved;
+}
+
+#ifdef MLIR_CUDA_RUNTIME_ENABLED
+// Report a failure of the CUDA driver API, and return true, if `result` is not
+// a success.
+static bool reportCUDAError(CUresult result, const char *call) {
+  if (result == CUDA_SUCCESS)
+    return false;
+  const char *message = nullptr;
+  cuGetErrorString(result, &message);
+  llvm::errs() << "mlir_gpu_launch: " << call << " failed: "
+               << (message ? message : "unknown error") << '\n';
+  return true;
+}
+
+// Make the primary context of the first CUDA device current on the calling
+// thread, initializing the driver on first use.  Return false if there is no
+// usable device.
+static bool setCUDAContext() {
+  static CUcontext context = [] {
+    CUdevice device;
+    CUcontext primaryContext = nullptr;
+    if (reportCUDAError(cuInit(0), "cuInit") ||
+        reportCUDAError(cuDeviceGet(&device, 0), "cuDeviceGet") ||
+        reportCUDAError(cuDevicePrimaryCtxRetain(&primaryContext, device),
+                        "cuDevicePrimaryCtxRetain"))
+      return CUcontext(nullptr);
+    return primaryContext;
+  }();
+  return context &&
+         !reportCUDAError(cuCtxSetCurrent(context), "cuCtxSetCurrent");
+}
+
+// Get the CUDA function of the kernel launched by `kernel`, loading its PTX
+// the first time, or null if the kernel has no PTX or it can't be loaded.  The
+// modules loaded are kept until the process exits.
+static CUfunction getCUDAFunction(void (*kernel)(void **)) {
+  std::lock_guard<std::mutex> lock(getKernelsMutex());
+  auto &kernels = getKernels();
+  auto it = kernels.find(reinterpret_cast<void *>(kernel));
+  if (it == kernels.end())
+    return nullptr;
+  KernelImage &image = it->second;
+  if (image.function || image.loadFailed || !setCUDAContext())
+    return image.function;
+
+  CUmodule module;
+  image.loadFailed =
+      reportCUDAError(cuModuleLoadData(&module, image.ptx.c_str()),
+                      "cuModuleLoadData") ||
+      reportCUDAError(
+          cuModuleGetFunction(&image.function, module, image.name.c_str()),
+          "cuModuleGetFunction");
+  return image.loadFailed ? nullptr : image.function;
+}
+
+// Launch `launch` on the GPU and wait for its completion.  Return false if the
+// kernel can't be launched on the GPU, in which case nothing was executed.
+static bool launchOnDevice(HostLaunch &launch) {
+  CUfunction function = getCUDAFunction(launch.kernel);
+  if (!function || !setCUDAContext())
+    return false;
+  if (reportCUDAError(cuLaunchKernel(function, launch.grid[0], launch.grid[1],
+                                     launch.grid[2], launch.block[0],
+                                     launch.block[1], launch.block[2],
+                                     /*sharedMemBytes=*/0, /*hStream=*/nullptr,
+                                     launch.params, /*extra=*/nullptr),
+                      "cuLaunchKernel"))
+    return false;
+  // The kernel may have partially run: a failure is not recoverable.
+  if (reportCUDAError(cuCtxSynchronize(), "cuCtxSynchronize"))
+    llvm::report_fatal_error("a GPU kernel failed");
+  return true;
+}
+#else
+static bool launchOnDevice(HostLaunch &) { return false; }
+#endif // MLIR_CUDA_RUNTIME_ENABLED
+
+extern "C" void mlir_gpu_launch(void (*kernel)(void **), intptr_t gridX,
+                                intptr_t gridY, intptr_t gridZ,
+                                intptr_t blockX, intptr_t blockY,
+                                intptr_t blockZ, void **params) {
+  if (gridX <= 0 || gridY <= 0 || gridZ <= 0)
+    return;
+  HostLaunch launch = {kernel, {gridX, gridY, gridZ}, {blockX, blockY, blockZ},
+                       params};
+  if (launchOnDevice(launch))
+    return;
+
+  // Otherwise, distribute the blocks over the threads of the parallel runtime.
+  mlir_parallel_for(executeHostBlocks, 0, gridX * gridY * gridZ, 1, &launch);
+}
+
+extern "C" void mlir_gpu_register_kernel(void (*kernel)(void **),
+                                         const char *name, const char *ptx) {
+  std::lock_guard<std::mutex> lock(getKernelsMutex());
+  KernelImage &image = getKernels()[reinterpret_cast<void *>(kernel)];
+  image = KernelImage();
+  image.name = name;
+  image.ptx = ptx;
+}
+
+extern "C" void mlir_gpu_unregister_kernel(void (*kernel)(void **)) {
+  std::lock_guard<std::mutex> lock(getKernelsMutex());
+  getKernels().erase(reinterpret_cast<void *>(kernel));
+}
+
+extern "C" intptr_t mlir_gpu_thread_id_x() { return currentThread.threadId[0]; }
+extern "C" intptr_t mlir_gpu_thread_id_y() { return currentThread.threadId[1]; }
+extern "C" intptr_t mlir_gpu_thread_id_z() { return currentThread.threadId[2]; }
+extern "C" intptr_t mlir_gpu_block_id_x() { return currentThread.blockId[0]; }
+extern "C" intptr_t mlir_gpu_block_id_y() { return currentThread.blockId[1]; }
+extern "C" intptr_t mlir_gpu_block_id_z() { return currentThread.blockId[2]; }
+extern "C" intptr_t mlir_gpu_block_dim_x() { return currentThread.blockDim[0]; }
+extern "C" intptr_t mlir_gpu_block_dim_y() { return currentThread.blockDim[1]; }
+extern "C" intptr_t mlir_gpu_block_dim_z() { return currentThread.blockDim[2]; }
@@ -0,0 +1,230 @@
+//===- MathRuntime.cpp - Vectorized math functions for JIT code -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the math runtime of the MLIR ExecutionEngine.  The
+// approximations follow the single precision functions of the Cephes library:
+// the argument is reduced to a small interval by exploiting the properties of
+// the function, a polynomial is evaluated on the reduced argument, and the
+// result is reconstructed.  All of the steps are branch-free, so that they
+// apply lane-wise to vectors.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/ExecutionEngine/MathRuntime.h"
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Module.h"
+
+#include <limits>
+
+using llvm::ArrayRef;
+using llvm::StringRef;
+using llvm::Value;
+
+namespace {
+// Emits the approximations on values of an f32 scalar or vector type.  The
+// constants are splat to the number of lanes of that type.
+class MathEmitter {
+public:
+  MathEmitter(llvm::IRBuilder<> &builder, llvm::Type *type)
+      : builder(builder), type(type), intType(builder.getInt32Ty()) {
+    if (type->isVectorTy())
+      intType = llvm::VectorType::get(intType, type->getVectorNumElements());
+  }
+
+  // exp(x) = 2^n * exp(r), with n = round(x / ln(2)) and r = x - n * ln(2).
+  Value *emitExp(Value *x) {
+    // Clamp the argument so that exp(x) is finite.  The clamping returns the
+    // bound for NaN, which is propagated to the result at the end instead.
+    Value *input = x;
+    x = builder.CreateMinNum(x, f(88.3762626647949));
+    x = builder.CreateMaxNum(x, f(-88.3762626647949));
+
+    Value *n = builder.CreateUnaryIntrinsic(
+        llvm::Intrinsic::floor, fma(x, f(1.44269504088896341), f(0.5)));
+    // Subtract n * ln(2) in two steps, the first product being exact.
+    Value *r = builder.CreateFSub(x, builder.CreateFMul(n, f(0.693359375)));
+    r = builder.CreateFSub(r, builder.CreateFMul(n, f(-2.12194440e-4)));
+
+    Value *y = polynomial(r, {1.9875691500E-4, 1.3981999507E-3,
+                              8.3334519073E-3, 4.1665795894E-2,
+                              1.6666665459E-1, 5.0000001201E-1});
+    y = fma(y, builder.CreateFMul(r, r), builder.CreateFAdd(r, f(1.0)));
+
+    // n is in [-127, 128], whose bounds are not the exponents of normal
+    // floats: multiply by 2^(n/2) and 2^(n - n/2), which are.
+    Value *exponent = builder.CreateFPToSI(n, intType);
+    Value *halfExponent = builder.CreateAShr(exponent, i(1));
+    y = builder.CreateFMul(y, exp2(halfExponent));
+    y = builder.CreateFMul(y, exp2(builder.CreateSub(exponent, halfExponent)));
+    return builder.CreateSelect(builder.CreateFCmpUNO(input, input), input, y);
+  }
+
+  // log(x) = log(m) + e * ln(2), with x = m * 2^e and m in
+  // [sqrt(1/2), sqrt(2)).
+  Value *emitLog(Value *x) {
+    // Flush the denormals to the smallest normal number, and split the
+    // argument into its exponent and its mantissa in [0.5, 1).
+    Value *normal = builder.CreateMaxNum(x, f(1.17549435e-38));
+    Value *bits = builder.CreateBitCast(normal, intType);
+    Value *e = builder.CreateSIToFP(
+        builder.CreateSub(builder.CreateLShr(bits, i(23)), i(126)), type);
+    bits = builder.CreateAnd(bits, i(~0x7f800000));
+    bits = builder.CreateOr(bits, i(0x3f000000));
+    Value *m = builder.CreateBitCast(bits, type);
+
+    // Move the mantissa to [sqrt(1/2), sqrt(2)) and compute m - 1.
+    Value *isSmall = builder.CreateFCmpOLT(m, f(0.707106781186547524));
+    e = builder.CreateFSub(e, builder.CreateSelect(isSmall, f(1.0), f(0.0)));
+    Value *extra = builder.CreateSelect(isSmall, m, f(0.0));
+    m = builder.CreateFAdd(builder.CreateFSub(m, f(1.0)), extra);
+
+    Value *z = builder.CreateFMul(m, m);
+    Value *y = polynomial(m, {7.0376836292E-2, -1.1514610310E-1,
+                              1.1676998740E-1, -1.2420140846E-1,
+                              1.4249322787E-1, -1.6668057665E-1,
+                              2.0000714765E-1, -2.4999993993E-1,
+                              3.3333331174E-1});
+    y = builder.CreateFMul(builder.CreateFMul(y, m), z);
+    y = fma(e, f(-2.12194440e-4), y);
+    y = builder.CreateFSub(y, builder.CreateFMul(z, f(0.5)));
+    Value *result = fma(e, f(0.693359375), builder.CreateFAdd(m, y));
+
+    // Handle the special values: log(+inf) = +inf, log(0) = -inf, and the
+    // result is NaN for negative numbers and NaN.
+    double infinity = std::numeric_limits<double>::infinity();
+    result =
+        builder.CreateSelect(builder.CreateFCmpOEQ(x, f(infinity)), x, result);
+    result = builder.CreateSelect(builder.CreateFCmpOEQ(x, f(0.0)),
+                                  f(-infinity), result);
+    return builder.CreateSelect(
+        builder.CreateFCmpULT(x, f(0.0)),
+        f(std::numeric_limits<double>::quiet_NaN()), result);
+  }
+
+  // tanh(x) is approximated by an odd polynomial for |x| < 0.625, and by
+  // sign(x) * (1 - 2 / (exp(2|x|) + 1)) otherwise.
+  Value *emitTanh(Value *x) {
+    Value *z = builder.CreateFMul(x, x);
+    Value *y = polynomial(z, {-5.70498872745E-3, 2.06390887954E-2,
+                              -5.37397155531E-2, 1.33314422036E-1,
+                              -3.33332819422E-1});
+    Value *small = fma(builder.CreateFMul(y, z), x, x);
+
+    Value *absX = builder.CreateUnaryIntrinsic(llvm::Intrinsic::fabs, x);
+    Value *exp = emitExp(builder.CreateFMul(absX, f(2.0)));
+    Value *large = builder.CreateFSub(
+        f(1.0), builder.CreateFDiv(f(2.0), builder.CreateFAdd(exp, f(1.0))));
+    large = builder.CreateBinaryIntrinsic(llvm::Intrinsic::copysign, large, x);
+
+    return builder.CreateSelect(builder.CreateFCmpOLT(absX, f(0.625)), small,
+                                large);
+  }
+
+private:
+  // Get a floating point or an integer constant of the type of the lanes.
+  Value *f(double value) { return llvm::ConstantFP::get(type, value); }
+  Value *i(int32_t value) {
+    return llvm::ConstantInt::get(intType, value, /*isSigned=*/true);
+  }
+
+  // Build 2^n from its exponent bits, for n the exponent of a normal float.
+  Value *exp2(Value *n) {
+    Value *bits = builder.CreateShl(builder.CreateAdd(n, i(127)), i(23));
+    return builder.CreateBitCast(bits, type);
+  }
+
+  // Compute a * b + c.
+  Value *fma(Value *a, Value *b, Value *c) {
+    return builder.CreateFAdd(builder.CreateFMul(a, b), c);
+  }
+
+  // Evaluate the polynomial with the given coefficients, starting from the
+  // highest degree, with Horner's scheme.
+  Value *polynomial(Value *x, ArrayRef<double> coefficients) {
+    Value *result = f(coefficients.front());
+    for (double coefficient : coefficients.drop_front())
+      result = fma(result, x, f(coefficient));
+    return result;
+  }
+
+  llvm::IRBuilder<> &builder;
+  llvm::Type *type;
+  llvm::Type *intType;
+};
+} // end anonymous namespace
+
+namespace {
+// A function of the runtime, identified by the prefix of the names of its
+// scalar and vector variants.
+struct MathFunction {
+  const char *name;
+  Value *(MathEmitter::*emit)(Value *);
+};
+} // end anonymous namespace
+
+static const MathFunction kMathFunctions[] = {
+    {"mlir_expf", &MathEmitter::emitExp},
+    {"mlir_logf", &MathEmitter::emitLog},
+    {"mlir_tanhf", &MathEmitter::emitTanh},
+};
+
+// Get the argument type expected for a variant of a runtime function with the
+// given name suffix, i.e. f32 for an empty suffix and a vector of f32 whose
+// number of lanes is the suffix otherwise.  Return nullptr if the suffix is
+// invalid.
+static llvm::Type *getArgumentType(llvm::LLVMContext &context,
+                                   StringRef suffix) {
+  llvm::Type *floatType = llvm::Type::getFloatTy(context);
+  if (suffix.empty())
+    return floatType;
+  unsigned numLanes;
+  if (suffix.getAsInteger(10, numLanes) || numLanes == 0)
+    return nullptr;
+  return llvm::VectorType::get(floatType, numLanes);
+}
+
+void mlir::linkMathRuntime(llvm::Module &module) {
+  for (llvm::Function &func : module) {
+    if (!func.isDeclaration())
+      continue;
+
+    for (const MathFunction &mathFunction : kMathFunctions) {
+      StringRef suffix = func.getName();
+      if (!suffix.consume_front(mathFunction.name))
+        continue;
+      llvm::Type *type = getArgumentType(module.getContext(), suffix);
+      llvm::FunctionType *funcType = func.getFunctionType();
+      if (!type || funcType->getReturnType() != type ||
+          funcType->getNumParams() != 1 || funcType->getParamType(0) != type)
+        continue;
+
+      auto *entry = llvm::BasicBlock::Create(module.getContext(), "", &func);
+      llvm::IRBuilder<> builder(entry);
+      MathEmitter emitter(builder, type);
+      builder.CreateRet((emitter.*mathFunction.emit)(&*func.arg_begin()));
+      func.setLinkage(llvm::GlobalValue::InternalLinkage);
+      func.setDoesNotAccessMemory();
+      func.setDoesNotThrow();
+      break;
+    }
+  }
+}
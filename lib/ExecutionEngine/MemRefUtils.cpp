@@ -26,6 +26,7 @@
 #include "mlir/Support/LLVM.h"
 
 #include "llvm/Support/Error.h"
+#include <algorithm>
 #include <numeric>
 
 using namespace mlir;
@@ -92,6 +93,100 @@ mlir::allocateMemRefArguments(Function *func, float initialValue) {
   return args;
 }
 
+size_t mlir::getMemRefElementSize(MemRefType type) {
+  auto elementType = type.getElementType();
+  if (!elementType.isIntOrFloat())
+    return 0;
+  return (elementType.getIntOrFloatBitWidth() + 7) / 8;
+}
+
+llvm::Expected<SmallVector<int64_t, 4>>
+mlir::resolveMemRefShape(MemRefType type, ArrayRef<int64_t> &dynamicSizes) {
+  unsigned numDynamicDims = type.getNumDynamicDims();
+  if (dynamicSizes.size() < numDynamicDims)
+    return make_string_error("expected " + llvm::Twine(numDynamicDims) +
+                             " more dynamic memref sizes");
+
+  SmallVector<int64_t, 4> shape;
+  for (int64_t size : type.getShape()) {
+    if (size < 0) {
+      size = dynamicSizes.front();
+      dynamicSizes = dynamicSizes.drop_front();
+      if (size < 0)
+        return make_string_error("negative memref size");
+    }
+    shape.push_back(size);
+  }
+  return shape;
+}
+
+llvm::Expected<MemRefArgumentPack>
+MemRefArgumentPack::create(Function *func) {
+  return create(func->getType());
+}
+
+llvm::Expected<MemRefArgumentPack>
+MemRefArgumentPack::create(FunctionType type) {
+  MemRefArgumentPack pack;
+  pack.numArguments = type.getNumInputs();
+  if (type.getNumResults() > 1)
+    return make_string_error("functions with more than 1 result not supported");
+
+  size_t storageSize = 0;
+  auto addDescriptor = [&](Type type) -> llvm::Error {
+    auto memRefType = type.dyn_cast<MemRefType>();
+    if (!memRefType)
+      return make_string_error("non-memref argument not supported");
+    size_t elementSize = getMemRefElementSize(memRefType);
+    if (elementSize == 0)
+      return make_string_error(
+          "memref with element other than integer or float not supported");
+
+    Descriptor descriptor;
+    descriptor.offset = storageSize;
+    descriptor.numDynamicSizes = memRefType.getNumDynamicDims();
+    descriptor.elementSize = elementSize;
+    pack.descriptors.push_back(descriptor);
+    storageSize += 1 + descriptor.numDynamicSizes;
+    return llvm::Error::success();
+  };
+  for (Type argType : type.getInputs())
+    if (auto err = addDescriptor(argType))
+      return std::move(err);
+  for (Type resType : type.getResults())
+    if (auto err = addDescriptor(resType))
+      return std::move(err);
+
+  // Allocate the storage once all of the descriptors are known, so that the
+  // packed pointers remain valid.
+  pack.storage.resize(storageSize);
+  pack.packedArguments.reserve(pack.descriptors.size());
+  for (unsigned i = 0, e = pack.descriptors.size(); i != e; ++i)
+    pack.packedArguments.push_back(pack.getDescriptor(i));
+  return std::move(pack);
+}
+
+llvm::Error
+MemRefArgumentPack::setArgumentImpl(unsigned index, void *data,
+                                    size_t elementSize,
+                                    ArrayRef<int64_t> dynamicSizes) {
+  if (index >= numArguments)
+    return make_string_error("argument index out of range");
+  auto &descriptor = descriptors[index];
+  if (elementSize != 0 && descriptor.elementSize != elementSize)
+    return make_string_error("buffer element size does not match the memref "
+                             "element type");
+  if (descriptor.numDynamicSizes != dynamicSizes.size())
+    return make_string_error("expected " +
+                             llvm::Twine(descriptor.numDynamicSizes) +
+                             " dynamic sizes");
+
+  intptr_t *slots = getDescriptor(index);
+  slots[0] = reinterpret_cast<intptr_t>(data);
+  std::copy(dynamicSizes.begin(), dynamicSizes.end(), slots + 1);
+  return llvm::Error::success();
+}
+
 // Because the function can return the same descriptor as passed in arguments,
 // we check that we don't attempt to free the underlying data twice.
 void mlir::freeMemRefArguments(ArrayRef<void *> args) {
@@ -23,6 +23,7 @@
 #include "mlir/ExecutionEngine/OptUtils.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/LegacyPassNameParser.h"
 #include "llvm/IR/Module.h"
@@ -31,7 +32,9 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/Host.h"
 #include "llvm/Support/StringSaver.h"
+#include "llvm/Target/TargetMachine.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include <climits>
@@ -65,11 +68,62 @@ void mlir::initializeLLVMPasses() {
   llvm::initializeVectorization(registry);
 }
 
+llvm::Expected<llvm::orc::JITTargetMachineBuilder>
+mlir::createHostTargetMachineBuilder(llvm::StringRef cpu,
+                                     llvm::StringRef features) {
+  auto machineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!machineBuilder)
+    return machineBuilder.takeError();
+
+  // The host features only make sense for the host CPU.
+  if (cpu.empty()) {
+    machineBuilder->setCPU(llvm::sys::getHostCPUName());
+  } else {
+    machineBuilder->setCPU(cpu);
+    machineBuilder->getFeatures() = llvm::SubtargetFeatures();
+  }
+
+  // Features that come later in the list override the earlier ones.
+  llvm::SmallVector<llvm::StringRef, 8> featureList;
+  features.split(featureList, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (auto feature : featureList)
+    machineBuilder->getFeatures().AddFeature(feature.trim());
+  return std::move(*machineBuilder);
+}
+
+// Create a copy of the given target machine.  The cost model of a target
+// machine caches per-function subtargets, so it cannot be shared by
+// concurrent pipelines.
+static std::unique_ptr<llvm::TargetMachine>
+cloneTargetMachine(const llvm::TargetMachine &targetMachine) {
+  return std::unique_ptr<llvm::TargetMachine>(
+      targetMachine.getTarget().createTargetMachine(
+          targetMachine.getTargetTriple().str(),
+          targetMachine.getTargetCPU(),
+          targetMachine.getTargetFeatureString(), targetMachine.Options,
+          targetMachine.getRelocationModel(), targetMachine.getCodeModel(),
+          targetMachine.getOptLevel()));
+}
+
+// Make the target-specific cost model of `targetMachine`, if provided,
+// available to the passes of both pass managers.
+static void addTargetAnalyses(llvm::legacy::PassManager &modulePM,
+                              llvm::legacy::FunctionPassManager &funcPM,
+                              llvm::TargetMachine *targetMachine) {
+  if (!targetMachine)
+    return;
+  modulePM.add(llvm::createTargetTransformInfoWrapperPass(
+      targetMachine->getTargetIRAnalysis()));
+  funcPM.add(llvm::createTargetTransformInfoWrapperPass(
+      targetMachine->getTargetIRAnalysis()));
+}
+
 // Populate pass managers according to the optimization and size levels.
 // This behaves similarly to LLVM opt.
 static void populatePassManagers(llvm::legacy::PassManager &modulePM,
                                  llvm::legacy::FunctionPassManager &funcPM,
-                                 unsigned optLevel, unsigned sizeLevel) {
+                                 unsigned optLevel, unsigned sizeLevel,
+                                 llvm::TargetMachine *targetMachine) {
   llvm::PassManagerBuilder builder;
   builder.OptLevel = optLevel;
   builder.SizeLevel = sizeLevel;
@@ -78,6 +132,8 @@ static void populatePassManagers(llvm::legacy::PassManager &modulePM,
   builder.LoopVectorize = optLevel > 1 && sizeLevel < 2;
   builder.SLPVectorize = optLevel > 1 && sizeLevel < 2;
   builder.DisableUnrollLoops = (optLevel == 0);
+  if (targetMachine)
+    targetMachine->adjustPassManager(builder);
 
   builder.populateModulePassManager(modulePM);
   builder.populateFunctionPassManager(funcPM);
@@ -86,12 +142,17 @@ static void populatePassManagers(llvm::legacy::PassManager &modulePM,
 // Create and return a lambda that uses LLVM pass manager builder to set up
 // optimizations based on the given level.
 std::function<llvm::Error(llvm::Module *)>
-mlir::makeOptimizingTransformer(unsigned optLevel, unsigned sizeLevel) {
-  return [optLevel, sizeLevel](llvm::Module *m) -> llvm::Error {
+mlir::makeOptimizingTransformer(unsigned optLevel, unsigned sizeLevel,
+                                llvm::TargetMachine *targetMachine) {
+  return [optLevel, sizeLevel, targetMachine](llvm::Module *m) -> llvm::Error {
+    std::unique_ptr<llvm::TargetMachine> machine;
+    if (targetMachine)
+      machine = cloneTargetMachine(*targetMachine);
 
     llvm::legacy::PassManager modulePM;
     llvm::legacy::FunctionPassManager funcPM(m);
-    populatePassManagers(modulePM, funcPM, optLevel, sizeLevel);
+    addTargetAnalyses(modulePM, funcPM, machine.get());
+    populatePassManagers(modulePM, funcPM, optLevel, sizeLevel, machine.get());
     runPasses(modulePM, funcPM, *m);
 
     return llvm::Error::success();
@@ -102,11 +163,17 @@ mlir::makeOptimizingTransformer(unsigned optLevel, unsigned sizeLevel) {
 // optional optimization level to pre-populate the pass manager.
 std::function<llvm::Error(llvm::Module *)> mlir::makeLLVMPassesTransformer(
     llvm::ArrayRef<const llvm::PassInfo *> llvmPasses,
-    llvm::Optional<unsigned> mbOptLevel, unsigned optPassesInsertPos) {
-  return [llvmPasses, mbOptLevel,
-          optPassesInsertPos](llvm::Module *m) -> llvm::Error {
+    llvm::Optional<unsigned> mbOptLevel, unsigned optPassesInsertPos,
+    llvm::TargetMachine *targetMachine) {
+  return [llvmPasses, mbOptLevel, optPassesInsertPos,
+          targetMachine](llvm::Module *m) -> llvm::Error {
+    std::unique_ptr<llvm::TargetMachine> machine;
+    if (targetMachine)
+      machine = cloneTargetMachine(*targetMachine);
+
     llvm::legacy::PassManager modulePM;
     llvm::legacy::FunctionPassManager funcPM(m);
+    addTargetAnalyses(modulePM, funcPM, machine.get());
 
     bool insertOptPasses = mbOptLevel.hasValue();
     for (unsigned i = 0, e = llvmPasses.size(); i < e; ++i) {
@@ -115,7 +182,8 @@ std::function<llvm::Error(llvm::Module *)> mlir::makeLLVMPassesTransformer(
         continue;
 
       if (insertOptPasses && optPassesInsertPos == i) {
-        populatePassManagers(modulePM, funcPM, mbOptLevel.getValue(), 0);
+        populatePassManagers(modulePM, funcPM, mbOptLevel.getValue(), 0,
+                             machine.get());
         insertOptPasses = false;
       }
 
@@ -128,7 +196,8 @@ std::function<llvm::Error(llvm::Module *)> mlir::makeLLVMPassesTransformer(
     }
 
     if (insertOptPasses)
-      populatePassManagers(modulePM, funcPM, mbOptLevel.getValue(), 0);
+      populatePassManagers(modulePM, funcPM, mbOptLevel.getValue(), 0,
+                           machine.get());
 
     runPasses(modulePM, funcPM, *m);
     return llvm::Error::success();
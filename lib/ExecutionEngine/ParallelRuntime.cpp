@@ -0,0 +1,82 @@
+//===- ParallelRuntime.cpp - Runtime support for parallel loops -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the runtime functions called by the code generated for
+// parallel loops.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/ExecutionEngine/ParallelRuntime.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Number of chunks created per thread, so that the threads that are done early
+// can pick up some of the work of the others.
+static constexpr intptr_t kChunksPerThread = 4;
+
+// Set while a thread executes chunks of a parallel loop.  Nested parallel loops
+// are executed sequentially, which avoids waiting on the thread pool from one
+// of its threads.
+static thread_local bool inParallelLoop = false;
+
+// Get the process-wide thread pool, created on first use with one thread per
+// hardware thread.
+static llvm::ThreadPool &getThreadPool() {
+  static llvm::ThreadPool threadPool;
+  return threadPool;
+}
+
+extern "C" void mlir_parallel_for(void (*body)(intptr_t, intptr_t, void *),
+                                  intptr_t lowerBound, intptr_t upperBound,
+                                  intptr_t step, void *context) {
+  if (lowerBound >= upperBound)
+    return;
+
+  intptr_t numIterations = (upperBound - lowerBound + step - 1) / step;
+  intptr_t numThreads = llvm::hardware_concurrency();
+  if (inParallelLoop || numThreads <= 1 || numIterations <= 1)
+    return body(lowerBound, upperBound, context);
+
+  intptr_t numChunks = std::min(numIterations, numThreads * kChunksPerThread);
+  intptr_t chunkSize = (numIterations + numChunks - 1) / numChunks * step;
+  numChunks = (upperBound - lowerBound + chunkSize - 1) / chunkSize;
+
+  // Each worker repeatedly picks the next chunk to execute.  The calling thread
+  // also works on the loop rather than just waiting for the others.
+  std::atomic<intptr_t> nextChunk(0);
+  auto worker = [&]() {
+    bool wasInParallelLoop = inParallelLoop;
+    inParallelLoop = true;
+    for (intptr_t chunk; (chunk = nextChunk++) < numChunks;) {
+      intptr_t chunkBegin = lowerBound + chunk * chunkSize;
+      body(chunkBegin, std::min(upperBound, chunkBegin + chunkSize), context);
+    }
+    inParallelLoop = wasInParallelLoop;
+  };
+
+  llvm::ThreadPool &threadPool = getThreadPool();
+  llvm::SmallVector<std::shared_future<void>, 8> futures;
+  for (intptr_t i = 1, e = std::min(numThreads, numChunks); i < e; ++i)
+    futures.push_back(threadPool.async(worker));
+  worker();
+  for (auto &future : futures)
+    future.wait();
+}
@@ -0,0 +1,155 @@
+//===- ProfileRuntime.cpp - Runtime support for loop profiling ------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the runtime functions called by the code instrumented
+// for profiling.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/ExecutionEngine/ProfileRuntime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+// The counters accumulated for an instrumented region.
+struct RegionCounters {
+  uint64_t entries = 0;
+  uint64_t iterations = 0;
+  int64_t nanoseconds = 0;
+};
+
+// The counters and names of all of the regions.  The instrumented regions may
+// be executed by the threads of the parallel runtime, hence the mutex.
+struct Profile {
+  std::mutex mutex;
+  std::unordered_map<int64_t, RegionCounters> counters;
+  std::unordered_map<int64_t, std::string> names;
+};
+} // end anonymous namespace
+
+static void printProfile();
+
+// Get the process-wide profile, created on first use.  It is never destroyed,
+// so that it is still alive when it is printed at exit.
+static Profile &getProfile() {
+  static Profile *profile = [] {
+    auto *newProfile = new Profile;
+    std::atexit(printProfile);
+    return newProfile;
+  }();
+  return *profile;
+}
+
+// Print the counters of the regions to the standard error, the region in which
+// the most time was spent first.  If the MLIR_PROFILE_FILE environment variable
+// is set, write them to the file it names instead, in the format read by the
+// -loop-profile option of the loop transformations.
+static void printProfile() {
+  Profile &profile = getProfile();
+  std::lock_guard<std::mutex> lock(profile.mutex);
+  if (profile.counters.empty())
+    return;
+
+  std::vector<std::pair<int64_t, RegionCounters>> regions(
+      profile.counters.begin(), profile.counters.end());
+  std::sort(regions.begin(), regions.end(),
+            [](const std::pair<int64_t, RegionCounters> &lhs,
+               const std::pair<int64_t, RegionCounters> &rhs) {
+              if (lhs.second.nanoseconds != rhs.second.nanoseconds)
+                return lhs.second.nanoseconds > rhs.second.nanoseconds;
+              return lhs.first < rhs.first;
+            });
+
+  if (const char *filename = getenv("MLIR_PROFILE_FILE")) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+      fprintf(stderr, "cannot write the profile file '%s'\n", filename);
+      return;
+    }
+    fprintf(file, "# <entries> <iterations> <nanoseconds> <name>\n");
+    for (auto &region : regions) {
+      auto name = profile.names.find(region.first);
+      if (name == profile.names.end())
+        continue;
+      fprintf(file, "%" PRIu64 " %" PRIu64 " %" PRId64 " %s\n",
+              region.second.entries, region.second.iterations,
+              region.second.nanoseconds, name->second.c_str());
+    }
+    fclose(file);
+    return;
+  }
+
+  fprintf(stderr, "===- MLIR execution profile -===\n");
+  fprintf(stderr, "%12s %12s %14s  %s\n", "time (ms)", "entries", "iterations",
+          "region");
+  for (auto &region : regions) {
+    auto name = profile.names.find(region.first);
+    std::string regionName = name != profile.names.end()
+                                 ? name->second
+                                 : "region " + std::to_string(region.first);
+    fprintf(stderr, "%12.3f %12" PRIu64 " %14" PRIu64 "  %s\n",
+            region.second.nanoseconds / 1e6, region.second.entries,
+            region.second.iterations, regionName.c_str());
+  }
+}
+
+// Add an execution of `region` entered at `start` and executing `iterations`
+// iterations to its counters.
+static void record(int64_t region, int64_t start, uint64_t iterations) {
+  int64_t end = mlir_profile_timestamp();
+  Profile &profile = getProfile();
+  std::lock_guard<std::mutex> lock(profile.mutex);
+  RegionCounters &counters = profile.counters[region];
+  ++counters.entries;
+  counters.iterations += iterations;
+  counters.nanoseconds += end - start;
+}
+
+extern "C" int64_t mlir_profile_timestamp() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+extern "C" void mlir_profile_record_loop(int64_t region, int64_t start,
+                                         intptr_t lowerBound,
+                                         intptr_t upperBound, intptr_t step) {
+  uint64_t iterations = 0;
+  if (step > 0 && upperBound > lowerBound)
+    iterations = (uint64_t(upperBound) - uint64_t(lowerBound) + step - 1) /
+                 uint64_t(step);
+  record(region, start, iterations);
+}
+
+extern "C" void mlir_profile_record_function(int64_t region, int64_t start) {
+  record(region, start, /*iterations=*/1);
+}
+
+extern "C" void mlir_profile_register_region(int64_t region,
+                                             const char *name) {
+  Profile &profile = getProfile();
+  std::lock_guard<std::mutex> lock(profile.mutex);
+  profile.names[region] = name;
+}
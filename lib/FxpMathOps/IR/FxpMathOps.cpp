@@ -26,11 +26,109 @@
 using namespace mlir;
 using namespace mlir::fxpmath;
 
+/// Returns whether the dimension sizes 'a' and 'b' may be equal, i.e. whether
+/// they are equal or any of them is dynamic.
+static bool isCompatibleDimSize(int64_t a, int64_t b) {
+  return a < 0 || b < 0 || a == b;
+}
+
+/// Verifies that 'value' is a memref of rank 'rank' whose elements are signed
+/// integer storage values of at most 8 bits, as expected for the operands of
+/// the integer contraction ops.
+static LogicalResult verifyContractionOperand(Operation *op, Value *value,
+                                              StringRef name, unsigned rank) {
+  auto type = value->getType().cast<MemRefType>();
+  if (type.getRank() != rank) {
+    return op->emitOpError("expected " + name + " of rank " + Twine(rank) +
+                           ", got " + Twine(type.getRank()));
+  }
+  if (type.getElementType().cast<IntegerType>().getWidth() > 8) {
+    return op->emitOpError("expected " + name +
+                           " elements of at most 8 bits");
+  }
+  return success();
+}
+
+static LogicalResult verifyMatMulAccumulateIOp(MatMulAccumulateIOp op) {
+  if (failed(verifyContractionOperand(op.getOperation(), op.lhs(), "lhs", 2)) ||
+      failed(verifyContractionOperand(op.getOperation(), op.rhs(), "rhs", 2))) {
+    return failure();
+  }
+  auto lhsShape = op.lhs()->getType().cast<MemRefType>().getShape();
+  auto rhsShape = op.rhs()->getType().cast<MemRefType>().getShape();
+  auto accType = op.acc()->getType().cast<MemRefType>();
+  if (accType.getRank() != 2) {
+    return op.emitOpError("expected acc of rank 2, got " +
+                          Twine(accType.getRank()));
+  }
+  auto accShape = accType.getShape();
+  if (!isCompatibleDimSize(lhsShape[1], rhsShape[0]) ||
+      !isCompatibleDimSize(accShape[0], lhsShape[0]) ||
+      !isCompatibleDimSize(accShape[1], rhsShape[1])) {
+    return op.emitOpError("expected MxK lhs, KxN rhs and MxN acc shapes");
+  }
+  return success();
+}
+
+static LogicalResult verifyConv2DAccumulateIOp(Conv2DAccumulateIOp op) {
+  Operation *operation = op.getOperation();
+  if (failed(verifyContractionOperand(operation, op.input(), "input", 4)) ||
+      failed(verifyContractionOperand(operation, op.filter(), "filter", 4))) {
+    return failure();
+  }
+  auto inputShape = op.input()->getType().cast<MemRefType>().getShape();
+  auto filterShape = op.filter()->getType().cast<MemRefType>().getShape();
+  auto accType = op.acc()->getType().cast<MemRefType>();
+  if (accType.getRank() != 4) {
+    return op.emitOpError("expected acc of rank 4, got " +
+                          Twine(accType.getRank()));
+  }
+  auto accShape = accType.getShape();
+
+  auto strides = op.strides();
+  if (strides.size() != 2) {
+    return op.emitOpError("expected 2 strides, got " + Twine(strides.size()));
+  }
+  int64_t strideValues[2];
+  for (unsigned i = 0; i < 2; ++i) {
+    auto stride = strides.getValue()[i].dyn_cast<IntegerAttr>();
+    if (!stride || stride.getInt() < 1) {
+      return op.emitOpError("expected positive integer strides");
+    }
+    strideValues[i] = stride.getInt();
+  }
+
+  if (!isCompatibleDimSize(accShape[0], inputShape[0]) ||
+      !isCompatibleDimSize(filterShape[2], inputShape[3]) ||
+      !isCompatibleDimSize(accShape[3], filterShape[3])) {
+    return op.emitOpError(
+        "expected NxHxWxC input, KHxKWxCxF filter and NxOHxOWxF acc shapes");
+  }
+  // The static spatial dimensions of the acc must be those of the output
+  // windows fitting in the input.
+  for (unsigned i = 0; i < 2; ++i) {
+    int64_t inputSize = inputShape[i + 1], filterSize = filterShape[i];
+    if (inputSize < 0 || filterSize < 0) {
+      continue;
+    }
+    if (filterSize > inputSize) {
+      return op.emitOpError("expected the filter to fit in the input");
+    }
+    int64_t numWindows = (inputSize - filterSize) / strideValues[i] + 1;
+    if (!isCompatibleDimSize(accShape[i + 1], numWindows)) {
+      return op.emitOpError("expected " + Twine(numWindows) +
+                            " output windows along spatial dimension " +
+                            Twine(i) + ", got " + Twine(accShape[i + 1]));
+    }
+  }
+  return success();
+}
+
 #define GET_OP_CLASSES
 #include "mlir/FxpMathOps/FxpMathOps.cpp.inc"
 
 FxpMathOpsDialect::FxpMathOpsDialect(MLIRContext *context)
-    : Dialect(/*name=*/"fxpmath", context) {
+    : Dialect(getDialectNamespace(), context) {
   addOperations<
 #define GET_OP_LIST
 #include "mlir/FxpMathOps/FxpMathOps.cpp.inc"
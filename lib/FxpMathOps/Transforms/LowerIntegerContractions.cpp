@@ -0,0 +1,359 @@
+//===- LowerIntegerContractions.cpp ---------------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass lowering the integer contraction ops of the
+// FxpMath dialect to affine loop nests. The zero points of the operands are
+// accounted for with correction terms, computed from the sums of the operands
+// along the contracted dimensions, so that the main loop nest is a plain
+// integer dot product that later passes can tile and vectorize.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/FxpMathOps/FxpMathOps.h"
+#include "mlir/FxpMathOps/Passes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+
+using namespace mlir;
+using namespace mlir::fxpmath;
+
+namespace {
+
+struct LowerIntegerContractionsPass
+    : public FunctionPass<LowerIntegerContractionsPass> {
+  void runOnFunction() override;
+};
+
+} // end anonymous namespace
+
+using LoopNestBodyBuilder =
+    llvm::function_ref<void(FuncBuilder &, ArrayRef<Value *>)>;
+
+/// Recursive helper of the buildLoopNest below, 'ivs' holding the induction
+/// variables of the enclosing loops of the nest.
+static void buildLoopNest(FuncBuilder &builder, Location loc,
+                          ArrayRef<int64_t> upperBounds,
+                          SmallVectorImpl<Value *> &ivs,
+                          LoopNestBodyBuilder buildBody) {
+  if (upperBounds.empty()) {
+    buildBody(builder, ivs);
+    return;
+  }
+  auto forOp = builder.create<AffineForOp>(loc, 0, upperBounds.front());
+  ivs.push_back(forOp.getInductionVar());
+  FuncBuilder bodyBuilder = forOp.getBodyBuilder();
+  buildLoopNest(bodyBuilder, loc, upperBounds.drop_front(), ivs, buildBody);
+  ivs.pop_back();
+}
+
+/// Builds a nest of affine.for loops from 0 to each of the 'upperBounds', the
+/// first one outermost, at the insertion point of 'builder'. 'buildBody' is
+/// called with a builder inserting in the innermost loop and the induction
+/// variables of the loops.
+static void buildLoopNest(FuncBuilder &builder, Location loc,
+                          ArrayRef<int64_t> upperBounds,
+                          LoopNestBodyBuilder buildBody) {
+  SmallVector<Value *, 8> ivs;
+  buildLoopNest(builder, loc, upperBounds, ivs, buildBody);
+}
+
+/// Creates a constant i32 of the given value, wrapped to 32 bits.
+static Value *createI32Constant(FuncBuilder &builder, Location loc,
+                                int64_t value) {
+  auto wrappedValue = static_cast<int32_t>(static_cast<uint32_t>(value));
+  return builder.create<ConstantIntOp>(loc, wrappedValue,
+                                       builder.getIntegerType(32));
+}
+
+/// Loads the element of 'memref' at 'indices', sign extended to i32.
+static Value *loadAsI32(FuncBuilder &builder, Location loc, Value *memref,
+                        ArrayRef<Value *> indices) {
+  Value *value = builder.create<LoadOp>(loc, memref, indices);
+  auto i32Type = builder.getIntegerType(32);
+  if (value->getType() == i32Type) {
+    return value;
+  }
+  return builder.create<ConvertISOp>(loc, i32Type, value);
+}
+
+/// Adds 'value' to the i32 element of 'memref' at 'indices'.
+static void accumulate(FuncBuilder &builder, Location loc, Value *value,
+                       Value *memref, ArrayRef<Value *> indices) {
+  Value *sum = builder.create<AddIOp>(
+      loc, builder.create<LoadOp>(loc, memref, indices), value);
+  builder.create<StoreOp>(loc, sum, memref, indices);
+}
+
+/// Returns the index of the input element of the output window at 'outputIv'
+/// along a spatial dimension, at the position 'filterIv' of the filter.
+static Value *getWindowIndex(FuncBuilder &builder, Location loc,
+                             Value *outputIv, Value *filterIv,
+                             int64_t stride) {
+  auto map = builder.getAffineMap(
+      2, 0,
+      {builder.getAffineDimExpr(0) * stride + builder.getAffineDimExpr(1)},
+      {});
+  return builder.create<AffineApplyOp>(loc, map,
+                                       ArrayRef<Value *>{outputIv, filterIv});
+}
+
+using SumIndicesFn = llvm::function_ref<SmallVector<Value *, 4>(
+    FuncBuilder &, ArrayRef<Value *>, ArrayRef<Value *>)>;
+
+/// Allocates a buffer of i32 of the static shape 'outerBounds', and builds the
+/// loops storing in each of its elements the sum of the elements of 'memref'
+/// spanned by the inner loops from 0 to each of the 'innerBounds'.
+/// 'getIndices' returns the indices in 'memref' for the induction variables of
+/// the outer and the inner loops.
+static Value *buildSums(FuncBuilder &builder, Location loc, Value *memref,
+                        ArrayRef<int64_t> outerBounds,
+                        ArrayRef<int64_t> innerBounds,
+                        SumIndicesFn getIndices) {
+  Value *zero = createI32Constant(builder, loc, 0);
+  auto sumsType = MemRefType::get(outerBounds, builder.getIntegerType(32));
+  Value *sums = builder.create<AllocOp>(loc, sumsType);
+  buildLoopNest(builder, loc, outerBounds,
+                [&](FuncBuilder &outerBuilder, ArrayRef<Value *> outerIvs) {
+                  outerBuilder.create<StoreOp>(loc, zero, sums, outerIvs);
+                  buildLoopNest(
+                      outerBuilder, loc, innerBounds,
+                      [&](FuncBuilder &innerBuilder,
+                          ArrayRef<Value *> innerIvs) {
+                        auto indices =
+                            getIndices(innerBuilder, outerIvs, innerIvs);
+                        accumulate(innerBuilder, loc,
+                                   loadAsI32(innerBuilder, loc, memref,
+                                             indices),
+                                   sums, outerIvs);
+                      });
+                });
+  return sums;
+}
+
+/// Builds the loops adding the zero point correction terms to the elements of
+/// 'acc' of the static shape 'accBounds':
+///   acc += constantTerm - lhsZeroPoint * rhsSums - rhsZeroPoint * lhsSums
+/// where the sums of the operands, if any, are loaded at the indices
+/// 'getLhsSumIndices' and 'getRhsSumIndices' return for the induction
+/// variables of the loops.
+static void buildZeroPointCorrection(
+    FuncBuilder &builder, Location loc, Value *acc, ArrayRef<int64_t> accBounds,
+    int64_t constantTerm, int64_t lhsZeroPoint, Value *lhsSums,
+    llvm::function_ref<SmallVector<Value *, 4>(ArrayRef<Value *>)>
+        getLhsSumIndices,
+    int64_t rhsZeroPoint, Value *rhsSums,
+    llvm::function_ref<SmallVector<Value *, 4>(ArrayRef<Value *>)>
+        getRhsSumIndices) {
+  Value *constantValue = createI32Constant(builder, loc, constantTerm);
+  Value *negLhsZeroPoint = createI32Constant(builder, loc, -lhsZeroPoint);
+  Value *negRhsZeroPoint = createI32Constant(builder, loc, -rhsZeroPoint);
+  buildLoopNest(
+      builder, loc, accBounds, [&](FuncBuilder &b, ArrayRef<Value *> ivs) {
+        Value *correction = constantValue;
+        if (lhsSums) {
+          Value *lhsSum = b.create<LoadOp>(loc, lhsSums, getLhsSumIndices(ivs));
+          correction = b.create<AddIOp>(
+              loc, correction, b.create<MulIOp>(loc, negRhsZeroPoint, lhsSum));
+        }
+        if (rhsSums) {
+          Value *rhsSum = b.create<LoadOp>(loc, rhsSums, getRhsSumIndices(ivs));
+          correction = b.create<AddIOp>(
+              loc, correction, b.create<MulIOp>(loc, negLhsZeroPoint, rhsSum));
+        }
+        accumulate(b, loc, correction, acc, ivs);
+      });
+  if (lhsSums) {
+    builder.create<DeallocOp>(loc, lhsSums);
+  }
+  if (rhsSums) {
+    builder.create<DeallocOp>(loc, rhsSums);
+  }
+}
+
+/// Returns whether all of the 'values' are memrefs of static shapes.
+static bool haveStaticShapes(ArrayRef<Value *> values) {
+  return llvm::all_of(values, [](Value *value) {
+    return value->getType().cast<MemRefType>().hasStaticShape();
+  });
+}
+
+//===----------------------------------------------------------------------===//
+// MatMul
+//===----------------------------------------------------------------------===//
+/// Lowers a matmul_accumulatei, using:
+///   sum_k (lhs[m, k] - zl) * (rhs[k, n] - zr) =
+///       sum_k lhs[m, k] * rhs[k, n] - zr * sum_k lhs[m, k]
+///       - zl * sum_k rhs[k, n] + K * zl * zr
+/// The loops of the dot products are ordered m, k, n so that the innermost
+/// loop accesses rhs and acc contiguously.
+static LogicalResult lowerMatMul(MatMulAccumulateIOp op) {
+  Value *lhs = op.lhs(), *rhs = op.rhs(), *acc = op.acc();
+  if (!haveStaticShapes({lhs, rhs, acc})) {
+    return op.emitOpError("expected static shapes to lower to loops");
+  }
+  auto lhsShape = lhs->getType().cast<MemRefType>().getShape();
+  auto rhsShape = rhs->getType().cast<MemRefType>().getShape();
+  int64_t m = lhsShape[0], k = lhsShape[1], n = rhsShape[1];
+  int64_t lhsZeroPoint = op.lhs_zero_point().getSExtValue();
+  int64_t rhsZeroPoint = op.rhs_zero_point().getSExtValue();
+
+  FuncBuilder builder(op.getOperation());
+  Location loc = op.getLoc();
+  buildLoopNest(builder, loc, {m, k, n},
+                [&](FuncBuilder &b, ArrayRef<Value *> ivs) {
+                  Value *lhsValue = loadAsI32(b, loc, lhs, {ivs[0], ivs[1]});
+                  Value *rhsValue = loadAsI32(b, loc, rhs, {ivs[1], ivs[2]});
+                  Value *product = b.create<MulIOp>(loc, lhsValue, rhsValue);
+                  accumulate(b, loc, product, acc, {ivs[0], ivs[2]});
+                });
+
+  if (lhsZeroPoint != 0 || rhsZeroPoint != 0) {
+    Value *lhsSums = nullptr, *rhsSums = nullptr;
+    if (rhsZeroPoint != 0) {
+      lhsSums = buildSums(builder, loc, lhs, {m}, {k},
+                          [](FuncBuilder &, ArrayRef<Value *> outerIvs,
+                             ArrayRef<Value *> innerIvs) {
+                            return SmallVector<Value *, 4>{outerIvs[0],
+                                                           innerIvs[0]};
+                          });
+    }
+    if (lhsZeroPoint != 0) {
+      rhsSums = buildSums(builder, loc, rhs, {n}, {k},
+                          [](FuncBuilder &, ArrayRef<Value *> outerIvs,
+                             ArrayRef<Value *> innerIvs) {
+                            return SmallVector<Value *, 4>{innerIvs[0],
+                                                           outerIvs[0]};
+                          });
+    }
+    buildZeroPointCorrection(
+        builder, loc, acc, {m, n}, k * lhsZeroPoint * rhsZeroPoint,
+        lhsZeroPoint, lhsSums,
+        [](ArrayRef<Value *> ivs) { return SmallVector<Value *, 4>{ivs[0]}; },
+        rhsZeroPoint, rhsSums,
+        [](ArrayRef<Value *> ivs) { return SmallVector<Value *, 4>{ivs[1]}; });
+  }
+
+  op.erase();
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Conv2D
+//===----------------------------------------------------------------------===//
+/// Lowers a conv2d_accumulatei like a matmul_accumulatei, the sums of the
+/// input being those of each of its windows and the sums of the filter those
+/// of each of its output channels. The loops of the dot products are ordered
+/// n, oh, ow, kh, kw, c, f so that the innermost loop accesses filter and acc
+/// contiguously.
+static LogicalResult lowerConv2D(Conv2DAccumulateIOp op) {
+  Value *input = op.input(), *filter = op.filter(), *acc = op.acc();
+  if (!haveStaticShapes({input, filter, acc})) {
+    return op.emitOpError("expected static shapes to lower to loops");
+  }
+  auto filterShape = filter->getType().cast<MemRefType>().getShape();
+  auto accShape = acc->getType().cast<MemRefType>().getShape();
+  int64_t n = accShape[0], oh = accShape[1], ow = accShape[2];
+  int64_t kh = filterShape[0], kw = filterShape[1], c = filterShape[2],
+          f = filterShape[3];
+  int64_t strideH = op.strides().getValue()[0].cast<IntegerAttr>().getInt();
+  int64_t strideW = op.strides().getValue()[1].cast<IntegerAttr>().getInt();
+  int64_t inputZeroPoint = op.input_zero_point().getSExtValue();
+  int64_t filterZeroPoint = op.filter_zero_point().getSExtValue();
+
+  FuncBuilder builder(op.getOperation());
+  Location loc = op.getLoc();
+  auto getInputIndices = [&](FuncBuilder &b, ArrayRef<Value *> outputIvs,
+                             ArrayRef<Value *> filterIvs) {
+    return SmallVector<Value *, 4>{
+        outputIvs[0],
+        getWindowIndex(b, loc, outputIvs[1], filterIvs[0], strideH),
+        getWindowIndex(b, loc, outputIvs[2], filterIvs[1], strideW),
+        filterIvs[2]};
+  };
+  buildLoopNest(
+      builder, loc, {n, oh, ow, kh, kw, c, f},
+      [&](FuncBuilder &b, ArrayRef<Value *> ivs) {
+        auto inputIndices = getInputIndices(b, ivs.take_front(3),
+                                            ivs.drop_front(3).take_front(3));
+        Value *inputValue = loadAsI32(b, loc, input, inputIndices);
+        Value *filterValue =
+            loadAsI32(b, loc, filter, {ivs[3], ivs[4], ivs[5], ivs[6]});
+        Value *product = b.create<MulIOp>(loc, inputValue, filterValue);
+        accumulate(b, loc, product, acc, {ivs[0], ivs[1], ivs[2], ivs[6]});
+      });
+
+  if (inputZeroPoint != 0 || filterZeroPoint != 0) {
+    Value *inputSums = nullptr, *filterSums = nullptr;
+    if (filterZeroPoint != 0) {
+      inputSums =
+          buildSums(builder, loc, input, {n, oh, ow}, {kh, kw, c},
+                    [&](FuncBuilder &b, ArrayRef<Value *> outerIvs,
+                        ArrayRef<Value *> innerIvs) {
+                      return getInputIndices(b, outerIvs, innerIvs);
+                    });
+    }
+    if (inputZeroPoint != 0) {
+      filterSums = buildSums(builder, loc, filter, {f}, {kh, kw, c},
+                             [](FuncBuilder &, ArrayRef<Value *> outerIvs,
+                                ArrayRef<Value *> innerIvs) {
+                               return SmallVector<Value *, 4>{
+                                   innerIvs[0], innerIvs[1], innerIvs[2],
+                                   outerIvs[0]};
+                             });
+    }
+    buildZeroPointCorrection(
+        builder, loc, acc, {n, oh, ow, f},
+        kh * kw * c * inputZeroPoint * filterZeroPoint, inputZeroPoint,
+        inputSums,
+        [](ArrayRef<Value *> ivs) {
+          return SmallVector<Value *, 4>{ivs[0], ivs[1], ivs[2]};
+        },
+        filterZeroPoint, filterSums,
+        [](ArrayRef<Value *> ivs) { return SmallVector<Value *, 4>{ivs[3]}; });
+  }
+
+  op.erase();
+  return success();
+}
+
+void LowerIntegerContractionsPass::runOnFunction() {
+  SmallVector<Operation *, 8> contractionOps;
+  getFunction().walk([&](Operation *op) {
+    if (op->isa<MatMulAccumulateIOp>() || op->isa<Conv2DAccumulateIOp>()) {
+      contractionOps.push_back(op);
+    }
+  });
+
+  for (Operation *op : contractionOps) {
+    LogicalResult result = op->isa<MatMulAccumulateIOp>()
+                               ? lowerMatMul(op->cast<MatMulAccumulateIOp>())
+                               : lowerConv2D(op->cast<Conv2DAccumulateIOp>());
+    if (failed(result)) {
+      signalPassFailure();
+    }
+  }
+}
+
+FunctionPassBase *mlir::fxpmath::createLowerIntegerContractionsPass() {
+  return new LowerIntegerContractionsPass();
+}
+
+static PassRegistration<LowerIntegerContractionsPass>
+    pass("fxpmath-lower-integer-contractions",
+         "Lowers integer matmul and conv ops to affine loop nests.");
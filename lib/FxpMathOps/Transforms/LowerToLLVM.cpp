@@ -0,0 +1,401 @@
+//===- LowerToLLVM.cpp - Lowers fixed-point ops to the LLVM IR dialect ----===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass lowering the fixed-point ops of the FxpMath
+// dialect on integers and vectors of integers to the LLVM IR dialect, along
+// with the Standard ops. The rescaling ops are expanded to integer arithmetic
+// in a wider type that LLVM vectorizes to the multiply-high instructions of the
+// target, or to the AArch64 NEON rounding multiply-high intrinsic, which
+// computes the saturating rounding doubling high multiplication exactly.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/FxpMathOps/FxpMathOps.h"
+#include "mlir/FxpMathOps/Passes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/LLVMIR/LLVMDialect.h"
+#include "mlir/LLVMIR/LLVMLowering.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <limits>
+#include <string>
+
+using namespace mlir;
+using namespace mlir::fxpmath;
+
+static llvm::cl::opt<bool> clUseNeonIntrinsics(
+    "fxpmath-llvm-neon",
+    llvm::cl::desc("Lower the saturating rounding doubling high "
+                   "multiplications to the AArch64 NEON sqrdmulh intrinsics"),
+    llvm::cl::init(false));
+
+/// Returns the element type of an integer or vector of integers 'type', or
+/// nullptr for other types.
+static IntegerType getIntegerElementType(Type type) {
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    return vectorType.getElementType().dyn_cast<IntegerType>();
+  }
+  return type.dyn_cast<IntegerType>();
+}
+
+/// Returns the integer or vector of integers of the shape of 'type' with
+/// elements of the given width.
+static Type getIntegerTypeOfWidth(Type type, unsigned width) {
+  auto elementType = IntegerType::get(width, type.getContext());
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    return VectorType::get(vectorType.getShape(), elementType);
+  }
+  return elementType;
+}
+
+namespace {
+
+/// Base class for the conversions of the fixed-point ops operating on integers
+/// or vectors of integers, which have LLVM IR equivalents, unlike tensors.
+/// The values are built with the original types of the op, which are converted
+/// to LLVM IR dialect types as the LLVM IR dialect ops are created.
+template <typename SourceOp>
+class FxpMathOpLowering : public DialectOpConversion {
+public:
+  FxpMathOpLowering(LLVM::LLVMDialect &dialect, LLVMLowering &lowering)
+      : DialectOpConversion(SourceOp::getOperationName(), 1,
+                            dialect.getContext()),
+        lowering(lowering) {}
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!op->isa<SourceOp>()) {
+      return matchFailure();
+    }
+    for (Value *operand : op->getOperands()) {
+      if (!getIntegerElementType(operand->getType())) {
+        return matchFailure();
+      }
+    }
+    if (!getIntegerElementType(op->getResult(0)->getType()) ||
+        !isSupported(op->cast<SourceOp>())) {
+      return matchFailure();
+    }
+    return matchSuccess();
+  }
+
+protected:
+  /// Derived classes may reimplement this hook to only match the ops of
+  /// supported parameters.
+  virtual bool isSupported(SourceOp op) const { return true; }
+
+  /// Creates a constant of the integer or vector of integers 'type', with all
+  /// of its elements set to 'value'.
+  Value *createConstant(FuncBuilder &builder, Location loc, Type type,
+                        int64_t value) const {
+    auto elementAttr =
+        builder.getIntegerAttr(getIntegerElementType(type), value);
+    Attribute attr = elementAttr;
+    if (auto vectorType = type.dyn_cast<VectorType>()) {
+      attr = builder.getSplatElementsAttr(vectorType, elementAttr);
+    }
+    return builder.create<LLVM::ConstantOp>(loc, convertType(type), attr);
+  }
+
+  /// Creates the comparison of 'lhs' and 'rhs' of type 'type'.
+  Value *createICmp(FuncBuilder &builder, Location loc, CmpIPredicate predicate,
+                    Type type, Value *lhs, Value *rhs) const {
+    auto predicateAttr = builder.getNamedAttr(
+        "predicate",
+        builder.getI64IntegerAttr(static_cast<int64_t>(predicate)));
+    return builder.create<LLVM::ICmpOp>(
+        loc, convertType(getIntegerTypeOfWidth(type, 1)),
+        ArrayRef<Value *>{lhs, rhs}, predicateAttr);
+  }
+
+  /// Creates the selection of 'trueValue' or 'falseValue' of type 'type'.
+  Value *createSelect(FuncBuilder &builder, Location loc, Type type,
+                      Value *condition, Value *trueValue,
+                      Value *falseValue) const {
+    return builder.create<LLVM::SelectOp>(
+        loc, convertType(type),
+        ArrayRef<Value *>{condition, trueValue, falseValue});
+  }
+
+  /// Creates the sign extension or truncation of 'value' from 'fromType' to
+  /// 'toType', or returns it if they have the same width.
+  Value *createSExtOrTrunc(FuncBuilder &builder, Location loc, Value *value,
+                           Type fromType, Type toType) const {
+    unsigned fromWidth = getIntegerElementType(fromType).getWidth();
+    unsigned toWidth = getIntegerElementType(toType).getWidth();
+    if (fromWidth < toWidth) {
+      return builder.create<LLVM::SExtOp>(loc, convertType(toType),
+                                          ArrayRef<Value *>(value));
+    }
+    if (fromWidth > toWidth) {
+      return builder.create<LLVM::TruncOp>(loc, convertType(toType),
+                                           ArrayRef<Value *>(value));
+    }
+    return value;
+  }
+
+  /// Creates the clamping of 'value' of type 'type' to [min, max].
+  Value *createClamp(FuncBuilder &builder, Location loc, Type type,
+                     Value *value, int64_t min, int64_t max) const {
+    Value *minValue = createConstant(builder, loc, type, min);
+    Value *maxValue = createConstant(builder, loc, type, max);
+    Value *isBelow =
+        createICmp(builder, loc, CmpIPredicate::SLT, type, value, minValue);
+    value = createSelect(builder, loc, type, isBelow, minValue, value);
+    Value *isAbove =
+        createICmp(builder, loc, CmpIPredicate::SGT, type, value, maxValue);
+    return createSelect(builder, loc, type, isAbove, maxValue, value);
+  }
+
+  template <typename TargetOp>
+  Value *createBinaryOp(FuncBuilder &builder, Location loc, Type type,
+                        Value *lhs, Value *rhs) const {
+    return builder.create<TargetOp>(loc, convertType(type),
+                                    ArrayRef<Value *>{lhs, rhs});
+  }
+
+  Type convertType(Type type) const { return lowering.convertType(type); }
+
+  LLVMLowering &lowering;
+};
+
+/// Lowers convertis to a sign extension or a truncation.
+struct ConvertISOpLowering : public FxpMathOpLowering<ConvertISOp> {
+  using FxpMathOpLowering::FxpMathOpLowering;
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    return {createSExtOrTrunc(rewriter, op->getLoc(), operands[0],
+                              op->getOperand(0)->getType(),
+                              op->getResult(0)->getType())};
+  }
+};
+
+/// Lowers rounding_divide_by_poti to an arithmetic right shift, incremented
+/// when the remainder is above half of the divisor, as in
+/// gemmlowp::RoundingDivideByPOT:
+///   mask = (1 << exponent) - 1
+///   threshold = (mask >> 1) + (x < 0 ? 1 : 0)
+///   y = (x >> exponent) + ((x & mask) > threshold ? 1 : 0)
+struct RoundingDivideByPotLowering
+    : public FxpMathOpLowering<RoundingDivideByPotFxpOp> {
+  using FxpMathOpLowering::FxpMathOpLowering;
+
+  bool isSupported(RoundingDivideByPotFxpOp op) const override {
+    // The shift must be smaller than the width of the elements.
+    return op.exponent().getSExtValue() <
+           getIntegerElementType(op.x()->getType()).getWidth();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    int64_t exponent =
+        op->cast<RoundingDivideByPotFxpOp>().exponent().getSExtValue();
+    Value *x = operands[0];
+    if (exponent == 0) {
+      return {x};
+    }
+
+    Location loc = op->getLoc();
+    Type type = op->getResult(0)->getType();
+    int64_t mask = (int64_t(1) << exponent) - 1;
+    Value *zero = createConstant(rewriter, loc, type, 0);
+    Value *one = createConstant(rewriter, loc, type, 1);
+    Value *remainder = createBinaryOp<LLVM::AndOp>(
+        rewriter, loc, type, x, createConstant(rewriter, loc, type, mask));
+    Value *isNegative =
+        createICmp(rewriter, loc, CmpIPredicate::SLT, type, x, zero);
+    Value *threshold = createSelect(
+        rewriter, loc, type, isNegative,
+        createConstant(rewriter, loc, type, (mask >> 1) + 1),
+        createConstant(rewriter, loc, type, mask >> 1));
+    Value *isAbove = createICmp(rewriter, loc, CmpIPredicate::SGT, type,
+                                remainder, threshold);
+    Value *shifted = createBinaryOp<LLVM::AShrOp>(
+        rewriter, loc, type, x, createConstant(rewriter, loc, type, exponent));
+    return {createBinaryOp<LLVM::AddOp>(
+        rewriter, loc, type, shifted,
+        createSelect(rewriter, loc, type, isAbove, one, zero))};
+  }
+};
+
+/// Lowers saturating_addi and saturating_subi to the addition or subtraction
+/// of the operands sign extended to twice their width, which can't overflow,
+/// clamped and truncated back.
+template <typename SourceOp, typename TargetOp>
+struct SaturatingBinaryOpLowering : public FxpMathOpLowering<SourceOp> {
+  using FxpMathOpLowering<SourceOp>::FxpMathOpLowering;
+
+  bool isSupported(SourceOp op) const override {
+    return getIntegerElementType(op.x()->getType()).getWidth() <= 32;
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto binaryOp = op->cast<SourceOp>();
+    Location loc = op->getLoc();
+    Type type = op->getResult(0)->getType();
+    Type wideType = getIntegerTypeOfWidth(
+        type, 2 * getIntegerElementType(type).getWidth());
+    Value *lhs =
+        this->createSExtOrTrunc(rewriter, loc, operands[0], type, wideType);
+    Value *rhs =
+        this->createSExtOrTrunc(rewriter, loc, operands[1], type, wideType);
+    Value *result = this->template createBinaryOp<TargetOp>(rewriter, loc,
+                                                            wideType, lhs, rhs);
+    result = this->createClamp(rewriter, loc, wideType, result,
+                               binaryOp.clamp_min().getSExtValue(),
+                               binaryOp.clamp_max().getSExtValue());
+    return {this->createSExtOrTrunc(rewriter, loc, result, wideType, type)};
+  }
+};
+
+using SaturatingAddLowering =
+    SaturatingBinaryOpLowering<SaturatingAddFxpOp, LLVM::AddOp>;
+using SaturatingSubLowering =
+    SaturatingBinaryOpLowering<SaturatingSubFxpOp, LLVM::SubOp>;
+
+/// Lowers vs_saturating_rounding_doubling_high_mulis on 32-bit integers, either
+/// to the AArch64 NEON sqrdmulh intrinsic, or to the 64-bit arithmetic of
+/// gemmlowp::SaturatingRoundingDoublingHighMul, which LLVM vectorizes to the
+/// widening multiply instructions of the target:
+///   ab = sext(x) * sext(b)
+///   nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30))
+///   y = trunc((ab + nudge) / (1 << 31))
+/// saturated to INT32_MAX in the only overflowing case, x = b = INT32_MIN.
+struct SaturatingRoundingDoublingHighMulLowering
+    : public FxpMathOpLowering<VecScalarSaturatingRoundingDoublingHighMulISOp> {
+  using FxpMathOpLowering::FxpMathOpLowering;
+
+  bool isSupported(
+      VecScalarSaturatingRoundingDoublingHighMulISOp op) const override {
+    return getIntegerElementType(op.x()->getType()).getWidth() == 32;
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    int64_t b = op->cast<VecScalarSaturatingRoundingDoublingHighMulISOp>()
+                    .b()
+                    .getSExtValue();
+    Location loc = op->getLoc();
+    Type type = op->getResult(0)->getType();
+    if (clUseNeonIntrinsics) {
+      if (Value *result =
+              createNeonIntrinsicCall(rewriter, op, operands[0], b)) {
+        return {result};
+      }
+    }
+
+    Type wideType = getIntegerTypeOfWidth(type, 64);
+    Value *x = createSExtOrTrunc(rewriter, loc, operands[0], type, wideType);
+    Value *ab = createBinaryOp<LLVM::MulOp>(
+        rewriter, loc, wideType, x, createConstant(rewriter, loc, wideType, b));
+    Value *isNonNegative =
+        createICmp(rewriter, loc, CmpIPredicate::SGE, wideType, ab,
+                   createConstant(rewriter, loc, wideType, 0));
+    Value *nudge = createSelect(
+        rewriter, loc, wideType, isNonNegative,
+        createConstant(rewriter, loc, wideType, int64_t(1) << 30),
+        createConstant(rewriter, loc, wideType, 1 - (int64_t(1) << 30)));
+    Value *high = createBinaryOp<LLVM::SDivOp>(
+        rewriter, loc, wideType,
+        createBinaryOp<LLVM::AddOp>(rewriter, loc, wideType, ab, nudge),
+        createConstant(rewriter, loc, wideType, int64_t(1) << 31));
+    Value *result = createSExtOrTrunc(rewriter, loc, high, wideType, type);
+    if (b != std::numeric_limits<int32_t>::min()) {
+      return {result};
+    }
+    Value *overflows = createICmp(
+        rewriter, loc, CmpIPredicate::EQ, type, operands[0],
+        createConstant(rewriter, loc, type,
+                       std::numeric_limits<int32_t>::min()));
+    return {createSelect(
+        rewriter, loc, type, overflows,
+        createConstant(rewriter, loc, type,
+                       std::numeric_limits<int32_t>::max()),
+        result)};
+  }
+
+  /// Creates the call to the sqrdmulh intrinsic of the type of 'op', declaring
+  /// it in the module if needed. Returns nullptr if there is none for that
+  /// type, i.e. for vectors other than the 64 and 128-bit ones.
+  Value *createNeonIntrinsicCall(FuncBuilder &rewriter, Operation *op,
+                                 Value *x, int64_t b) const {
+    Type type = op->getResult(0)->getType();
+    std::string name = "llvm.aarch64.neon.sqrdmulh.";
+    if (auto vectorType = type.dyn_cast<VectorType>()) {
+      if (vectorType.getRank() != 1 || (vectorType.getNumElements() != 2 &&
+                                        vectorType.getNumElements() != 4)) {
+        return nullptr;
+      }
+      name += "v" + std::to_string(vectorType.getNumElements()) + "i32";
+    } else {
+      name += "i32";
+    }
+
+    Type llvmType = convertType(type);
+    Function *intrinsic = LLVMLowering::getOrInsertFunction(
+        op->getFunction()->getModule(), name,
+        rewriter.getFunctionType({llvmType, llvmType}, llvmType));
+    return rewriter
+        .create<LLVM::CallOp>(
+            op->getLoc(), llvmType, rewriter.getFunctionAttr(intrinsic),
+            ArrayRef<Value *>{x, createConstant(rewriter, op->getLoc(), type,
+                                                b)})
+        .getResult(0);
+  }
+};
+
+/// A dialect converter lowering the Standard and the fixed-point ops to the
+/// LLVM IR dialect.
+class FxpMathLLVMLowering : public LLVMLowering {
+protected:
+  llvm::DenseSet<DialectOpConversion *>
+  initAdditionalConverters(LLVM::LLVMDialect &llvmDialect) override {
+    return ConversionListBuilder<
+        ConvertISOpLowering, RoundingDivideByPotLowering, SaturatingAddLowering,
+        SaturatingSubLowering,
+        SaturatingRoundingDoublingHighMulLowering>::build(&converterStorage,
+                                                          llvmDialect, *this);
+  }
+};
+
+class ConvertFxpMathToLLVMPass : public ModulePass<ConvertFxpMathToLLVMPass> {
+public:
+  void runOnModule() override {
+    if (failed(convertToLLVMDialect(&getModule(), lowering))) {
+      signalPassFailure();
+    }
+  }
+
+private:
+  FxpMathLLVMLowering lowering;
+};
+
+} // end anonymous namespace
+
+ModulePassBase *mlir::fxpmath::createConvertFxpMathToLLVMPass() {
+  return new ConvertFxpMathToLLVMPass();
+}
+
+static PassRegistration<ConvertFxpMathToLLVMPass>
+    pass("fxpmath-convert-to-llvmir",
+         "Converts the fixed-point ops on integers and vectors, along with the "
+         "Standard ops, to the LLVM IR dialect.");
@@ -20,8 +20,13 @@
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Quantization/UniformSupport.h"
+#include "mlir/StandardOps/Ops.h"
+#include "llvm/ADT/StringSwitch.h"
 
+#include <cmath>
 #include <functional>
+#include <limits>
+#include <vector>
 
 using namespace mlir;
 using namespace mlir::fxpmath;
@@ -34,9 +39,16 @@ struct LowerUniformRealMathPass
   void runOnFunction() override;
 };
 
+/// Returns the element type of 't' as a UniformQuantizedType. A per-axis type
+/// whose slices all have the same parameters is lowered like its per-layer
+/// equivalent.
 UniformQuantizedType getUniformElementType(Type t) {
-  return QuantizedType::getQuantizedElementType(t)
-      .dyn_cast_or_null<UniformQuantizedType>();
+  auto elementType = QuantizedType::getQuantizedElementType(t);
+  if (auto perAxisType =
+          elementType.dyn_cast_or_null<UniformQuantizedPerAxisType>()) {
+    return perAxisType.getUniformQuantizedType();
+  }
+  return elementType.dyn_cast_or_null<UniformQuantizedType>();
 }
 
 /// Computes the log2(x), rounded to an integral value. Returns whether 'x' can
@@ -51,6 +63,21 @@ template <typename F> bool integralLog2(F x, int &log2Result) {
   return std::abs(xLog2Frac) < 1e-6;
 }
 
+/// Returns 'type', an integer or a vector or tensor of integers, with its
+/// element type replaced by 'elementType'.
+Type castElementType(Type type, Type elementType) {
+  if (auto rankedType = type.dyn_cast<RankedTensorType>()) {
+    return RankedTensorType::get(rankedType.getShape(), elementType);
+  }
+  if (type.isa<UnrankedTensorType>()) {
+    return UnrankedTensorType::get(elementType);
+  }
+  if (auto vectorType = type.dyn_cast<VectorType>()) {
+    return VectorType::get(vectorType.getShape(), elementType);
+  }
+  return elementType;
+}
+
 /// Helper class for operating on binary operations where all operands
 /// and the result are a UniformQuantizedType.
 struct RealBinaryOpInfo {
@@ -71,6 +98,22 @@ struct RealBinaryOpInfo {
            rhsStorageType && resultStorageType;
   }
 
+  /// Returns whether the operands and the result have the same shape, which is
+  /// static, so that 32-bit intermediates and splat constants of that shape
+  /// can be created.
+  bool isSameStaticShape() const {
+    for (Type type : {lhsStorageType, rhsStorageType, resultStorageType}) {
+      auto vtType = type.dyn_cast<VectorOrTensorType>();
+      if (vtType && !vtType.hasStaticShape()) {
+        return false;
+      }
+    }
+    return castElementType(lhsStorageType, resultType.getStorageType()) ==
+               resultStorageType &&
+           castElementType(rhsStorageType, resultType.getStorageType()) ==
+               resultStorageType;
+  }
+
   /// Returns whether the storage type of all operands is identical.
   bool isSameStorageType() const {
     return lhsType.getStorageType() == rhsType.getStorageType() &&
@@ -137,16 +180,136 @@ struct RealBinaryOpInfo {
   Type resultStorageType;
 };
 
+/// Helper class for operating on unary operations where the operand and the
+/// result are a UniformQuantizedType.
+struct RealUnaryOpInfo {
+  RealUnaryOpInfo(Operation *op, Value *operand, Optional<APFloat> clampMin,
+                  Optional<APFloat> clampMax)
+      : op(op), operand(operand), clampMin(clampMin), clampMax(clampMax),
+        operandType(getUniformElementType(operand->getType())),
+        resultType(getUniformElementType(*op->result_type_begin())),
+        operandStorageType(
+            QuantizedType::castToStorageType(operand->getType())),
+        resultStorageType(
+            QuantizedType::castToStorageType(*op->result_type_begin())) {}
+
+  /// Returns whether this info is valid (all types defined, etc).
+  bool isValid() const {
+    return operandType && resultType && operandStorageType &&
+           resultStorageType;
+  }
+
+  Operation *op;
+  Value *operand;
+  Optional<APFloat> clampMin;
+  Optional<APFloat> clampMax;
+
+  // Element UniformQuantizedType for the operand/result.
+  UniformQuantizedType operandType;
+  UniformQuantizedType resultType;
+
+  // Full storage-based types.
+  Type operandStorageType;
+  Type resultStorageType;
+};
+
 } // end anonymous namespace
 
 //===----------------------------------------------------------------------===//
-// Elementwise add
+// Lookup tables
 //===----------------------------------------------------------------------===//
-/// Attempts to rewrite a fixed point power-of-two addition of two integers.
-/// This supports a limited number of cases, but when supported, represents
-/// the simplest computation.
-static LogicalResult tryRewriteFixedPOTAddEw(const RealBinaryOpInfo &constInfo,
-                                             PatternRewriter &rewriter) {
+
+/// The maximum number of bits indexing a lookup table, i.e. tables have at
+/// most 2^16 entries.
+static constexpr unsigned kMaxLookupTableIndexBits = 16;
+
+/// Returns the real value represented in 'type' by the storage value with the
+/// given bits, zero extended.
+static double getRealValue(UniformQuantizedType type, uint64_t bits) {
+  unsigned width = type.getStorageTypeIntegralWidth();
+  int64_t storageValue = type.isSigned() ? llvm::SignExtend64(bits, width)
+                                         : static_cast<int64_t>(bits);
+  return type.getScale() * (storageValue - type.getZeroPoint());
+}
+
+/// Builds the lookup table, indexed by 'numIndexBits' bits, mapping each index
+/// to the storage value in 'resultType' of the real value 'computeRealValue'
+/// returns for it, clamped to the optional real clamp range. Undefined results
+/// (NaNs) are mapped to the real value zero. The table is created as a
+/// constant, which the pattern driver uniques, so that the lookups of the same
+/// function with the same types share their table.
+static Value *
+buildLookupTable(PatternRewriter &rewriter, Location loc,
+                 UniformQuantizedType resultType, unsigned numIndexBits,
+                 Optional<APFloat> clampMin, Optional<APFloat> clampMax,
+                 llvm::function_ref<double(uint64_t)> computeRealValue) {
+  UniformQuantizedValueConverter converter(resultType);
+  uint64_t numEntries = uint64_t(1) << numIndexBits;
+  std::vector<APInt> entries;
+  entries.reserve(numEntries);
+  for (uint64_t index = 0; index < numEntries; ++index) {
+    double realValue = computeRealValue(index);
+    if (std::isnan(realValue)) {
+      realValue = 0.0;
+    }
+    if (clampMin) {
+      realValue = std::max(realValue, clampMin->convertToDouble());
+    }
+    if (clampMax) {
+      realValue = std::min(realValue, clampMax->convertToDouble());
+    }
+    entries.push_back(converter.quantizeFloatToInt(APFloat(realValue)));
+  }
+  auto tableType = RankedTensorType::get({static_cast<int64_t>(numEntries)},
+                                         resultType.getStorageType());
+  return rewriter.create<ConstantOp>(
+      loc, tableType, DenseIntElementsAttr::get(tableType, entries));
+}
+
+/// Rewrites a binary operation computing 'fn' element-wise into a lookup in
+/// the table of its results for every pair of operand storage values. This is
+/// exact, and supports any combination of types, but is limited to operands
+/// with few storage bits.
+static LogicalResult
+tryRewriteLookupTableBinaryEw(const RealBinaryOpInfo &info,
+                              llvm::function_ref<double(double, double)> fn,
+                              PatternRewriter &rewriter) {
+  unsigned lhsBits = info.lhsType.getStorageTypeIntegralWidth();
+  unsigned rhsBits = info.rhsType.getStorageTypeIntegralWidth();
+  if (lhsBits + rhsBits > kMaxLookupTableIndexBits) {
+    return failure();
+  }
+
+  Operation *mathOp = info.op;
+  uint64_t rhsMask = (uint64_t(1) << rhsBits) - 1;
+  Value *table = buildLookupTable(
+      rewriter, mathOp->getLoc(), info.resultType, lhsBits + rhsBits,
+      info.clampMin, info.clampMax, [&](uint64_t index) {
+        return fn(getRealValue(info.lhsType, index >> rhsBits),
+                  getRealValue(info.rhsType, index & rhsMask));
+      });
+
+  Value *lhsStorageValue = rewriter.create<StorageCastOp>(
+      mathOp->getLoc(), info.lhsStorageType, info.lhs);
+  Value *rhsStorageValue = rewriter.create<StorageCastOp>(
+      mathOp->getLoc(), info.rhsStorageType, info.rhs);
+  Value *resultStorageValue = rewriter.create<LookupTable2IOp>(
+      mathOp->getLoc(), info.resultStorageType, lhsStorageValue,
+      rhsStorageValue, table);
+  rewriter.replaceOpWithNewOp<StorageCastOp>(
+      mathOp, *mathOp->result_type_begin(), resultStorageValue);
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise add and sub
+//===----------------------------------------------------------------------===//
+/// Attempts to rewrite a fixed point power-of-two addition, or subtraction if
+/// 'isSub' is set, of two integers. This supports a limited number of cases,
+/// but when supported, represents the simplest computation.
+static LogicalResult
+tryRewriteFixedPOTAddSubEw(const RealBinaryOpInfo &constInfo, bool isSub,
+                           PatternRewriter &rewriter) {
   if (!constInfo.isSameStorageType()) {
     return failure();
   }
@@ -179,8 +342,11 @@ static LogicalResult tryRewriteFixedPOTAddEw(const RealBinaryOpInfo &constInfo,
   Type rhsStorageType = constInfo.rhsStorageType;
 
   // If the lhs operand is the one requiring a shift, swap it so that the shift
-  // happens the rhs operand.
+  // happens the rhs operand. The operands of a subtraction can't be swapped.
   if (lhsScaleShift != 0) {
+    if (isSub) {
+      return failure();
+    }
     std::swap(lhs, rhs);
     std::swap(lhsStorageType, rhsStorageType);
     std::swap(lhsScaleShift, rhsScaleShift);
@@ -206,10 +372,17 @@ static LogicalResult tryRewriteFixedPOTAddEw(const RealBinaryOpInfo &constInfo,
             .getResult();
   }
 
-  // Add.
-  Value *sumValue = rewriter.create<SaturatingAddFxpOp>(
-      mathOp->getLoc(), lhsStorageValue, rhsStorageValue, clampMinMax.first,
-      clampMinMax.second);
+  // Add or sub.
+  Value *sumValue;
+  if (isSub) {
+    sumValue = rewriter.create<SaturatingSubFxpOp>(
+        mathOp->getLoc(), lhsStorageValue, rhsStorageValue, clampMinMax.first,
+        clampMinMax.second);
+  } else {
+    sumValue = rewriter.create<SaturatingAddFxpOp>(
+        mathOp->getLoc(), lhsStorageValue, rhsStorageValue, clampMinMax.first,
+        clampMinMax.second);
+  }
 
   // Cast back for new result.
   rewriter.replaceOpWithNewOp<StorageCastOp>(
@@ -217,23 +390,274 @@ static LogicalResult tryRewriteFixedPOTAddEw(const RealBinaryOpInfo &constInfo,
   return success();
 }
 
+static LogicalResult rewriteAddEw(const RealBinaryOpInfo &info,
+                                  PatternRewriter &rewriter) {
+  if (succeeded(tryRewriteFixedPOTAddSubEw(info, /*isSub=*/false, rewriter))) {
+    return success();
+  }
+  return tryRewriteLookupTableBinaryEw(
+      info, [](double x, double y) { return x + y; }, rewriter);
+}
+
+static LogicalResult rewriteSubEw(const RealBinaryOpInfo &info,
+                                  PatternRewriter &rewriter) {
+  if (succeeded(tryRewriteFixedPOTAddSubEw(info, /*isSub=*/true, rewriter))) {
+    return success();
+  }
+  return tryRewriteLookupTableBinaryEw(
+      info, [](double x, double y) { return x - y; }, rewriter);
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise mul
+//===----------------------------------------------------------------------===//
+/// Decomposes the positive real 'multiplier', smaller than one, into a
+/// fixed-point 'quantizedMultiplier' in [2^30, 2^31) and a 'rightShift' such
+/// that multiplier ~= quantizedMultiplier * 2^-31 * 2^-rightShift. Returns
+/// false if the multiplier can't be represented this way.
+static bool quantizeMultiplierSmallerThanOne(double multiplier,
+                                             int32_t &quantizedMultiplier,
+                                             int &rightShift) {
+  if (!(multiplier > 0.0 && multiplier < 1.0)) {
+    return false;
+  }
+  int exponent;
+  const double significand = std::frexp(multiplier, &exponent);
+  int64_t fixedPoint = static_cast<int64_t>(
+      std::round(significand * static_cast<double>(int64_t(1) << 31)));
+  // Rounding the significand up may have reached 1.
+  if (fixedPoint == (int64_t(1) << 31)) {
+    fixedPoint /= 2;
+    ++exponent;
+  }
+  rightShift = -exponent;
+  if (rightShift < 0 || rightShift > 31) {
+    return false;
+  }
+  quantizedMultiplier = static_cast<int32_t>(fixedPoint);
+  return true;
+}
+
+/// Creates a constant of 'type', an integer or a statically shaped vector or
+/// tensor of integers, with all of its elements equal to 'value'.
+static Value *createSplatIntConstant(PatternRewriter &rewriter, Location loc,
+                                     Type type, int64_t value) {
+  auto vtType = type.dyn_cast<VectorOrTensorType>();
+  if (!vtType) {
+    return rewriter.create<ConstantIntOp>(loc, value, type);
+  }
+  auto elementAttr = rewriter.getIntegerAttr(vtType.getElementType(), value);
+  return rewriter.create<ConstantOp>(
+      loc, type, SplatElementsAttr::get(vtType, elementAttr));
+}
+
+/// Attempts to rewrite an affine multiplication of two signed integers, as
+/// 32-bit integer arithmetic: the operands, offset by their zero points, are
+/// multiplied and the product is rescaled to the result by a fixed-point
+/// multiplier and a rounding right shift, before its zero point is added.
+static LogicalResult
+tryRewriteAffineMulEwSigned(const RealBinaryOpInfo &constInfo,
+                            PatternRewriter &rewriter) {
+  // The storage values are sign extended to the 32-bit intermediates.
+  if (!constInfo.lhsType.isSigned() || !constInfo.rhsType.isSigned() ||
+      !constInfo.resultType.isSigned() || !constInfo.isSameStaticShape()) {
+    return failure();
+  }
+
+  // The product of the operands offset by their zero points must fit in the
+  // 32-bit intermediates.
+  auto getMaxOffsetMagnitude = [](UniformQuantizedType type) {
+    return std::max(
+        std::abs(double(type.getStorageTypeMin() - type.getZeroPoint())),
+        std::abs(double(type.getStorageTypeMax() - type.getZeroPoint())));
+  };
+  if (getMaxOffsetMagnitude(constInfo.lhsType) *
+          getMaxOffsetMagnitude(constInfo.rhsType) >
+      std::numeric_limits<int32_t>::max()) {
+    return failure();
+  }
+
+  // The product has the scale lhsScale * rhsScale, rescale it to the result.
+  int32_t quantizedMultiplier;
+  int rightShift;
+  if (!quantizeMultiplierSmallerThanOne(constInfo.lhsType.getScale() *
+                                            constInfo.rhsType.getScale() /
+                                            constInfo.resultType.getScale(),
+                                        quantizedMultiplier, rightShift)) {
+    return failure();
+  }
+
+  Operation *mathOp = constInfo.op;
+  Location loc = mathOp->getLoc();
+  const auto clampMinMax = constInfo.getClampMinMax();
+  auto i32Type = IntegerType::get(32, rewriter.getContext());
+  Type intermediateType =
+      castElementType(constInfo.resultStorageType, i32Type);
+
+  // Cast the operands to 32-bit storage values offset by their zero points.
+  auto castToOffsetIntermediate = [&](Value *operand, Type storageType,
+                                      int64_t zeroPoint) {
+    Value *storageValue =
+        rewriter.create<StorageCastOp>(loc, storageType, operand);
+    Value *value =
+        rewriter.create<ConvertISOp>(loc, intermediateType, storageValue);
+    if (zeroPoint != 0) {
+      value = rewriter.create<AddIOp>(
+          loc, value,
+          createSplatIntConstant(rewriter, loc, intermediateType, -zeroPoint));
+    }
+    return value;
+  };
+  Value *lhsValue =
+      castToOffsetIntermediate(constInfo.lhs, constInfo.lhsStorageType,
+                               constInfo.lhsType.getZeroPoint());
+  Value *rhsValue =
+      castToOffsetIntermediate(constInfo.rhs, constInfo.rhsStorageType,
+                               constInfo.rhsType.getZeroPoint());
+
+  // Multiply and rescale.
+  Value *productValue = rewriter.create<MulIOp>(loc, lhsValue, rhsValue);
+  productValue =
+      rewriter.create<VecScalarSaturatingRoundingDoublingHighMulISOp>(
+          loc, productValue, IntegerAttr::get(i32Type, quantizedMultiplier));
+  if (rightShift != 0) {
+    productValue = rewriter.create<RoundingDivideByPotFxpOp>(
+        loc, productValue, IntegerAttr::get(i32Type, rightShift));
+  }
+
+  // Add the result zero point, clamp, and narrow to the result storage type.
+  Value *resultValue = rewriter.create<SaturatingAddFxpOp>(
+      loc, productValue,
+      createSplatIntConstant(rewriter, loc, intermediateType,
+                             constInfo.resultType.getZeroPoint()),
+      clampMinMax.first, clampMinMax.second);
+  resultValue = rewriter.create<ConvertISOp>(loc, constInfo.resultStorageType,
+                                             resultValue);
+
+  // Cast back for new result.
+  rewriter.replaceOpWithNewOp<StorageCastOp>(
+      mathOp, *mathOp->result_type_begin(), resultValue);
+  return success();
+}
+
+static LogicalResult rewriteMulEw(const RealBinaryOpInfo &info,
+                                  PatternRewriter &rewriter) {
+  if (succeeded(tryRewriteAffineMulEwSigned(info, rewriter))) {
+    return success();
+  }
+  return tryRewriteLookupTableBinaryEw(
+      info, [](double x, double y) { return x * y; }, rewriter);
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise div
+//===----------------------------------------------------------------------===//
+/// Division is only lowered to a lookup table. Divisions by zero saturate to
+/// the extremes of the result range, or give zero for 0 / 0.
+static LogicalResult rewriteDivEw(const RealBinaryOpInfo &info,
+                                  PatternRewriter &rewriter) {
+  return tryRewriteLookupTableBinaryEw(
+      info, [](double x, double y) { return x / y; }, rewriter);
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise unary functions
+//===----------------------------------------------------------------------===//
+/// Returns the real function computed by the element-wise unary function 'fn'
+/// of a RealUnaryEwOp, or nullptr if it is unknown.
+using UnaryEwFn = double (*)(double);
+static UnaryEwFn getUnaryEwFn(StringRef fn) {
+  return llvm::StringSwitch<UnaryEwFn>(fn)
+      .Case("IDENTITY", [](double x) { return x; })
+      .Case("TANH", [](double x) { return std::tanh(x); })
+      .Case("SIGMOID", [](double x) { return 1.0 / (1.0 + std::exp(-x)); })
+      .Case("EXP", [](double x) { return std::exp(x); })
+      .Case("LOG", [](double x) { return std::log(x); })
+      .Case("NEG", [](double x) { return -x; })
+      .Case("RSQRT", [](double x) { return 1.0 / std::sqrt(x); })
+      .Case("SIN", [](double x) { return std::sin(x); })
+      .Case("SQUARE", [](double x) { return x * x; })
+      .Case("SQRT", [](double x) { return std::sqrt(x); })
+      .Case("CMPZ", [](double x) { return x == 0.0 ? 1.0 : 0.0; })
+      .Case("CMPNZ", [](double x) { return x != 0.0 ? 1.0 : 0.0; })
+      .Case("CMPLZ", [](double x) { return x < 0.0 ? 1.0 : 0.0; })
+      .Case("CMPGZ", [](double x) { return x > 0.0 ? 1.0 : 0.0; })
+      .Default(nullptr);
+}
+
+/// Rewrites an element-wise unary function into a lookup in the table of its
+/// results for every storage value of the operand.
+static LogicalResult tryRewriteLookupTableUnaryEw(const RealUnaryOpInfo &info,
+                                                  UnaryEwFn fn,
+                                                  PatternRewriter &rewriter) {
+  unsigned operandBits = info.operandType.getStorageTypeIntegralWidth();
+  if (operandBits > kMaxLookupTableIndexBits) {
+    return failure();
+  }
+
+  Operation *mathOp = info.op;
+  Value *table = buildLookupTable(
+      rewriter, mathOp->getLoc(), info.resultType, operandBits, info.clampMin,
+      info.clampMax, [&](uint64_t index) {
+        return fn(getRealValue(info.operandType, index));
+      });
+
+  Value *operandStorageValue = rewriter.create<StorageCastOp>(
+      mathOp->getLoc(), info.operandStorageType, info.operand);
+  Value *resultStorageValue = rewriter.create<LookupTableIOp>(
+      mathOp->getLoc(), info.resultStorageType, operandStorageValue, table);
+  rewriter.replaceOpWithNewOp<StorageCastOp>(
+      mathOp, *mathOp->result_type_begin(), resultStorageValue);
+  return success();
+}
+
 namespace {
 
-struct UniformRealAddEwPattern : public RewritePattern {
-  UniformRealAddEwPattern(MLIRContext *context)
-      : RewritePattern(RealAddEwOp::getOperationName(), 1, context) {}
+/// Lowers the element-wise binary real math op RealOp with 'tryRewrite'.
+template <typename RealOp>
+struct UniformRealBinaryEwPattern : public RewritePattern {
+  using RewriteFn = LogicalResult (*)(const RealBinaryOpInfo &,
+                                      PatternRewriter &);
+
+  UniformRealBinaryEwPattern(MLIRContext *context, RewriteFn tryRewrite)
+      : RewritePattern(RealOp::getOperationName(), 1, context),
+        tryRewrite(tryRewrite) {}
 
   PatternMatchResult matchAndRewrite(Operation *op,
                                      PatternRewriter &rewriter) const {
-    auto addOp = op->cast<RealAddEwOp>();
-    const RealBinaryOpInfo info(op, addOp.x(), addOp.y(), addOp.clamp_min(),
-                                addOp.clamp_max());
+    auto realOp = op->cast<RealOp>();
+    const RealBinaryOpInfo info(op, realOp.x(), realOp.y(), realOp.clamp_min(),
+                                realOp.clamp_max());
     if (!info.isValid()) {
       return matchFailure();
     }
 
     // Try all of the permutations we support.
-    if (succeeded(tryRewriteFixedPOTAddEw(info, rewriter))) {
+    if (succeeded(tryRewrite(info, rewriter))) {
+      return matchSuccess();
+    }
+
+    return matchFailure();
+  }
+
+  RewriteFn tryRewrite;
+};
+
+struct UniformRealUnaryEwPattern : public RewritePattern {
+  UniformRealUnaryEwPattern(MLIRContext *context)
+      : RewritePattern(RealUnaryEwOp::getOperationName(), 1, context) {}
+
+  PatternMatchResult matchAndRewrite(Operation *op,
+                                     PatternRewriter &rewriter) const {
+    auto unaryOp = op->cast<RealUnaryEwOp>();
+    const RealUnaryOpInfo info(op, unaryOp.x(), unaryOp.clamp_min(),
+                               unaryOp.clamp_max());
+    UnaryEwFn fn = getUnaryEwFn(unaryOp.fn());
+    if (!info.isValid() || !fn) {
+      return matchFailure();
+    }
+
+    if (succeeded(tryRewriteLookupTableUnaryEw(info, fn, rewriter))) {
       return matchSuccess();
     }
 
@@ -247,7 +671,19 @@ void LowerUniformRealMathPass::runOnFunction() {
   auto &fn = getFunction();
   OwningRewritePatternList patterns;
   auto *context = &getContext();
-  patterns.push_back(llvm::make_unique<UniformRealAddEwPattern>(context));
+  patterns.push_back(
+      llvm::make_unique<UniformRealBinaryEwPattern<RealAddEwOp>>(
+          context, rewriteAddEw));
+  patterns.push_back(
+      llvm::make_unique<UniformRealBinaryEwPattern<RealSubEwOp>>(
+          context, rewriteSubEw));
+  patterns.push_back(
+      llvm::make_unique<UniformRealBinaryEwPattern<RealMulEwOp>>(
+          context, rewriteMulEw));
+  patterns.push_back(
+      llvm::make_unique<UniformRealBinaryEwPattern<RealDivEwOp>>(
+          context, rewriteDivEw));
+  patterns.push_back(llvm::make_unique<UniformRealUnaryEwPattern>(context));
   applyPatternsGreedily(fn, std::move(patterns));
 }
 
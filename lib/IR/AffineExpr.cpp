@@ -544,14 +544,10 @@ int SimpleAffineExprFlattener::findLocalId(AffineExpr localExpr) {
   return it - localExprs.begin();
 }
 
-/// Simplify the affine expression by flattening it and reconstructing it.
-AffineExpr mlir::simplifyAffineExpr(AffineExpr expr, unsigned numDims,
-                                    unsigned numSymbols) {
-  // TODO(bondhugula): only pure affine for now. The simplification here can
-  // be extended to semi-affine maps in the future.
-  if (!expr.isPureAffine())
-    return expr;
-
+/// Simplify the pure affine expression 'expr' by flattening it and
+/// reconstructing it.
+static AffineExpr simplifyPureAffineExpr(AffineExpr expr, unsigned numDims,
+                                         unsigned numSymbols) {
   SimpleAffineExprFlattener flattener(numDims, numSymbols);
   flattener.walkPostOrder(expr);
   ArrayRef<int64_t> flattenedExpr = flattener.operandExprStack.back();
@@ -563,6 +559,21 @@ AffineExpr mlir::simplifyAffineExpr(AffineExpr expr, unsigned numDims,
   return simplifiedExpr;
 }
 
+/// Simplify the affine expression by flattening it and reconstructing it.
+AffineExpr mlir::simplifyAffineExpr(AffineExpr expr, unsigned numDims,
+                                    unsigned numSymbols) {
+  // TODO(bondhugula): only pure affine for now. The simplification here can
+  // be extended to semi-affine maps in the future.
+  if (!expr.isPureAffine())
+    return expr;
+
+  // The simplification only depends on uniqued inputs, so it is only computed
+  // the first time an expression is simplified.
+  return detail::getMemoizedSimplifiedExpr(expr, numDims, numSymbols, [&] {
+    return simplifyPureAffineExpr(expr, numDims, numSymbols);
+  });
+}
+
 // Flattens the expressions in map. Returns true on success or false
 // if 'expr' was unable to be flattened (i.e., semi-affine expressions not
 // handled yet).
@@ -26,6 +26,7 @@
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/MLIRContext.h"
 #include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/STLExtras.h"
 
 namespace mlir {
 
@@ -74,6 +75,14 @@ struct AffineConstantExprStorage : public AffineExprStorage {
   int64_t constant;
 };
 
+/// Return the simplification of 'expr' in a space of 'numDims' dimensions and
+/// 'numSymbols' symbols.  The simplifications are memoized in the context of
+/// 'expr', and 'simplifyFn' is only called to compute those not known yet.
+AffineExpr
+getMemoizedSimplifiedExpr(AffineExpr expr, unsigned numDims,
+                          unsigned numSymbols,
+                          llvm::function_ref<AffineExpr()> simplifyFn);
+
 } // end namespace detail
 } // end namespace mlir
 #endif // MLIR_IR_AFFINEEXPRDETAIL_H_
@@ -27,76 +27,85 @@
 
 using namespace mlir;
 
-namespace {
-
-// AffineExprConstantFolder evaluates an affine expression using constant
-// operands passed in 'operandConsts'. Returns an IntegerAttr attribute
-// representing the constant value of the affine expression evaluated on
-// constant 'operandConsts', or nullptr if it can't be folded.
-class AffineExprConstantFolder {
-public:
-  AffineExprConstantFolder(unsigned numDims, ArrayRef<Attribute> operandConsts)
-      : numDims(numDims), operandConsts(operandConsts) {}
-
-  /// Attempt to constant fold the specified affine expr, or return null on
-  /// failure.
-  IntegerAttr constantFold(AffineExpr expr) {
-    if (auto result = constantFoldImpl(expr))
-      return IntegerAttr::get(IndexType::get(expr.getContext()), *result);
-    return nullptr;
+/// Append the flattened form of 'results' to 'program', and return the size
+/// of the stack it needs.
+unsigned
+detail::flattenAffineMapResults(ArrayRef<AffineExpr> results, unsigned numDims,
+                                SmallVectorImpl<AffineMapEvalInstr> &program) {
+  unsigned stackDepth = 0, stackSize = 0;
+  for (auto result : results) {
+    // The expressions are walked in postorder, so the operands of a binary
+    // expression are on top of the stack when it is evaluated.
+    result.walk([&](AffineExpr expr) {
+      int64_t value = 0;
+      switch (expr.getKind()) {
+      case AffineExprKind::Constant:
+        value = expr.cast<AffineConstantExpr>().getValue();
+        break;
+      case AffineExprKind::DimId:
+        value = expr.cast<AffineDimExpr>().getPosition();
+        break;
+      case AffineExprKind::SymbolId:
+        value = numDims + expr.cast<AffineSymbolExpr>().getPosition();
+        break;
+      default:
+        // Binary expressions pop their operands and push their result.
+        --stackDepth;
+        program.push_back({expr.getKind(), value});
+        return;
+      }
+      program.push_back({expr.getKind(), value});
+      stackSize = std::max(stackSize, ++stackDepth);
+    });
   }
+  return stackSize;
+}
 
-private:
-  llvm::Optional<int64_t> constantFoldImpl(AffineExpr expr) {
-    switch (expr.getKind()) {
+/// Evaluate the results of the map of 'storage' on 'operands', the values of
+/// its dimensions then symbols, and append them to 'results'.  If
+/// 'isKnownOperand' is not empty, the evaluation fails if a result uses an
+/// operand that isn't known.
+static LogicalResult evaluate(const detail::AffineMapStorage &storage,
+                              ArrayRef<int64_t> operands,
+                              ArrayRef<bool> isKnownOperand,
+                              SmallVectorImpl<int64_t> &results) {
+  SmallVector<int64_t, 8> stack(storage.evalStackSize);
+  int64_t *top = stack.data() - 1;
+  for (auto &instr : storage.evalProgram) {
+    switch (instr.kind) {
+    case AffineExprKind::Constant:
+      *++top = instr.value;
+      continue;
+    case AffineExprKind::DimId:
+    case AffineExprKind::SymbolId:
+      if (!isKnownOperand.empty() && !isKnownOperand[instr.value])
+        return failure();
+      *++top = operands[instr.value];
+      continue;
     case AffineExprKind::Add:
-      return constantFoldBinExpr(
-          expr, [](int64_t lhs, int64_t rhs) { return lhs + rhs; });
+      top[-1] += top[0];
+      break;
     case AffineExprKind::Mul:
-      return constantFoldBinExpr(
-          expr, [](int64_t lhs, int64_t rhs) { return lhs * rhs; });
+      top[-1] *= top[0];
+      break;
     case AffineExprKind::Mod:
-      return constantFoldBinExpr(
-          expr, [](int64_t lhs, int64_t rhs) { return mod(lhs, rhs); });
+      top[-1] = mod(top[-1], top[0]);
+      break;
     case AffineExprKind::FloorDiv:
-      return constantFoldBinExpr(
-          expr, [](int64_t lhs, int64_t rhs) { return floorDiv(lhs, rhs); });
+      top[-1] = floorDiv(top[-1], top[0]);
+      break;
     case AffineExprKind::CeilDiv:
-      return constantFoldBinExpr(
-          expr, [](int64_t lhs, int64_t rhs) { return ceilDiv(lhs, rhs); });
-    case AffineExprKind::Constant:
-      return expr.cast<AffineConstantExpr>().getValue();
-    case AffineExprKind::DimId:
-      if (auto attr = operandConsts[expr.cast<AffineDimExpr>().getPosition()]
-                          .dyn_cast_or_null<IntegerAttr>())
-        return attr.getInt();
-      return llvm::None;
-    case AffineExprKind::SymbolId:
-      if (auto attr = operandConsts[numDims +
-                                    expr.cast<AffineSymbolExpr>().getPosition()]
-                          .dyn_cast_or_null<IntegerAttr>())
-        return attr.getInt();
-      return llvm::None;
+      top[-1] = ceilDiv(top[-1], top[0]);
+      break;
     }
+    --top;
   }
-
-  // TODO: Change these to operate on APInts too.
-  llvm::Optional<int64_t> constantFoldBinExpr(AffineExpr expr,
-                                              int64_t (*op)(int64_t, int64_t)) {
-    auto binOpExpr = expr.cast<AffineBinaryOpExpr>();
-    if (auto lhs = constantFoldImpl(binOpExpr.getLHS()))
-      if (auto rhs = constantFoldImpl(binOpExpr.getRHS()))
-        return op(*lhs, *rhs);
-    return llvm::None;
-  }
-
-  // The number of dimension operands in AffineMap containing this expression.
-  unsigned numDims;
-  // The constant valued operands used to evaluate this AffineExpr.
-  ArrayRef<Attribute> operandConsts;
-};
-
-} // end anonymous namespace
+  unsigned numResults = storage.results.size();
+  assert(top - stack.data() + 1 == numResults &&
+         "expected one value per result");
+  results.append(stack.begin(), stack.begin() + numResults);
+  return success();
+}
 
 /// Returns a single constant result affine map.
 AffineMap AffineMap::getConstantMap(int64_t val, MLIRContext *context) {
@@ -179,22 +188,35 @@ AffineMap::constantFold(ArrayRef<Attribute> operandConstants,
                         SmallVectorImpl<Attribute> &results) const {
   assert(getNumInputs() == operandConstants.size());
 
-  // Fold each of the result expressions.
-  AffineExprConstantFolder exprFolder(getNumDims(), operandConstants);
-  // Constant fold each AffineExpr in AffineMap and add to 'results'.
-  for (auto expr : getResults()) {
-    auto folded = exprFolder.constantFold(expr);
-    // If we didn't fold to a constant, then folding fails.
-    if (!folded)
-      return failure();
-
-    results.push_back(folded);
+  // Evaluate the results on the integer operands.  The folding fails if a
+  // result uses any other operand.
+  SmallVector<int64_t, 8> operands(operandConstants.size());
+  SmallVector<bool, 8> isKnownOperand(operandConstants.size());
+  for (unsigned i = 0, e = operandConstants.size(); i != e; ++i) {
+    if (auto attr = operandConstants[i].dyn_cast_or_null<IntegerAttr>()) {
+      operands[i] = attr.getInt();
+      isKnownOperand[i] = true;
+    }
   }
-  assert(results.size() == getNumResults() &&
-         "constant folding produced the wrong number of results");
+  SmallVector<int64_t, 4> values;
+  if (failed(::evaluate(*map, operands, isKnownOperand, values)))
+    return failure();
+
+  auto indexType = IndexType::get(getContext());
+  for (auto value : values)
+    results.push_back(IntegerAttr::get(indexType, value));
   return success();
 }
 
+/// Evaluate the results of this map on the values of its dimensions then
+/// symbols.
+SmallVector<int64_t, 4> AffineMap::evaluate(ArrayRef<int64_t> operands) const {
+  assert(getNumInputs() == operands.size());
+  SmallVector<int64_t, 4> results;
+  (void)::evaluate(*map, operands, /*isKnownOperand=*/{}, results);
+  return results;
+}
+
 /// Walk all of the AffineExpr's in this mapping.  The results are visited
 /// first, and then the range sizes (if present).  Each node in an expression
 /// tree is visited in postorder.
@@ -230,33 +252,43 @@ AffineMap AffineMap::replaceDimsAndSymbols(ArrayRef<AffineExpr> dimReplacements,
   return get(numResultDims, numResultSyms, results, resultRanges);
 }
 
-AffineMap AffineMap::compose(AffineMap map) {
-  assert(getNumDims() == map.getNumResults() && "Number of results mismatch");
-  assert(getRangeSizes().empty() && "TODO: support bounded AffineMap");
-  assert(map.getRangeSizes().empty() && "TODO: support bounded AffineMap");
+/// Compose 'lhs' with 'map', as described in AffineMap::compose.
+static AffineMap composeMaps(AffineMap lhs, AffineMap map) {
   // Prepare `map` by concatenating the symbols and rewriting its exprs.
   unsigned numDims = map.getNumDims();
-  unsigned numSymbolsThisMap = getNumSymbols();
+  unsigned numSymbolsThisMap = lhs.getNumSymbols();
   unsigned numSymbols = numSymbolsThisMap + map.getNumSymbols();
   SmallVector<AffineExpr, 8> newDims(numDims);
   for (unsigned idx = 0; idx < numDims; ++idx) {
-    newDims[idx] = getAffineDimExpr(idx, getContext());
+    newDims[idx] = getAffineDimExpr(idx, lhs.getContext());
   }
   SmallVector<AffineExpr, 8> newSymbols(numSymbols);
   for (unsigned idx = numSymbolsThisMap; idx < numSymbols; ++idx) {
     newSymbols[idx - numSymbolsThisMap] =
-        getAffineSymbolExpr(idx, getContext());
+        getAffineSymbolExpr(idx, lhs.getContext());
   }
   auto newMap =
       map.replaceDimsAndSymbols(newDims, newSymbols, numDims, numSymbols);
   SmallVector<AffineExpr, 8> exprs;
-  exprs.reserve(getResults().size());
-  for (auto expr : getResults())
+  exprs.reserve(lhs.getResults().size());
+  for (auto expr : lhs.getResults())
     exprs.push_back(expr.compose(newMap));
   return AffineMap::get(numDims, numSymbols, exprs, {});
 }
 
-AffineMap mlir::simplifyAffineMap(AffineMap map) {
+AffineMap AffineMap::compose(AffineMap map) {
+  assert(getNumDims() == map.getNumResults() && "Number of results mismatch");
+  assert(getRangeSizes().empty() && "TODO: support bounded AffineMap");
+  assert(map.getRangeSizes().empty() && "TODO: support bounded AffineMap");
+  // The composition only depends on uniqued maps, so it is only computed the
+  // first time the same maps are composed.
+  return detail::getMemoizedComposedMap(
+      *this, map, [&] { return composeMaps(*this, map); });
+}
+
+/// Simplify the results and the range sizes of 'map', as described in
+/// simplifyAffineMap.
+static AffineMap simplifyMap(AffineMap map) {
   SmallVector<AffineExpr, 8> exprs, sizes;
   for (auto e : map.getResults()) {
     exprs.push_back(
@@ -268,3 +300,10 @@ AffineMap mlir::simplifyAffineMap(AffineMap map) {
   }
   return AffineMap::get(map.getNumDims(), map.getNumSymbols(), exprs, sizes);
 }
+
+AffineMap mlir::simplifyAffineMap(AffineMap map) {
+  // The simplification only depends on the uniqued map, so it is only computed
+  // the first time a map is simplified.
+  return detail::getMemoizedSimplifiedMap(map,
+                                          [&] { return simplifyMap(map); });
+}
@@ -25,10 +25,23 @@
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/STLExtras.h"
 
 namespace mlir {
 namespace detail {
 
+/// An instruction of the flattened form of the results of an affine map, which
+/// evaluates them with a stack of values rather than by walking their trees.
+/// Dimension and symbol instructions push the operand at position 'value',
+/// where the symbols follow the dimensions, constant instructions push
+/// 'value', and binary instructions replace the two values on top of the
+/// stack with their result.
+struct AffineMapEvalInstr {
+  AffineExprKind kind;
+  int64_t value;
+};
+
 struct AffineMapStorage {
   unsigned numDims;
   unsigned numSymbols;
@@ -40,8 +53,32 @@ struct AffineMapStorage {
   /// The extents along each of the range dimensions if the map is bounded,
   /// nullptr otherwise.
   ArrayRef<AffineExpr> rangeSizes;
+
+  /// The flattened form of the results, each of them in postorder, and the
+  /// size of the stack it needs.  This leaves the values of the results on the
+  /// stack in order.
+  ArrayRef<AffineMapEvalInstr> evalProgram;
+  unsigned evalStackSize;
 };
 
+/// Append the flattened form of 'results', in a map of 'numDims' dimensions,
+/// to 'program'.  Returns the size of the stack it needs.
+unsigned flattenAffineMapResults(ArrayRef<AffineExpr> results,
+                                 unsigned numDims,
+                                 SmallVectorImpl<AffineMapEvalInstr> &program);
+
+/// Return the composition 'lhs.compose(rhs)'.  The compositions are memoized
+/// in the context of the maps, and 'composeFn' is only called to compute those
+/// not known yet.
+AffineMap getMemoizedComposedMap(AffineMap lhs, AffineMap rhs,
+                                 llvm::function_ref<AffineMap()> composeFn);
+
+/// Return the simplification of 'map' by simplifyAffineMap.  The
+/// simplifications are memoized in the context of the map, and 'simplifyFn' is
+/// only called to compute those not known yet.
+AffineMap getMemoizedSimplifiedMap(AffineMap map,
+                                   llvm::function_ref<AffineMap()> simplifyFn);
+
 } // end namespace detail
 } // end namespace mlir
 
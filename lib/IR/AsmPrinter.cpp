@@ -32,6 +32,7 @@
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/IR/StandardTypes.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/STLExtras.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/DenseMap.h"
@@ -41,6 +42,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Regex.h"
 using namespace mlir;
 
@@ -77,6 +79,18 @@ static llvm::cl::opt<bool>
                        llvm::cl::desc("Print the generic op form"),
                        llvm::cl::init(false), llvm::cl::Hidden);
 
+static llvm::cl::opt<int64_t> printElementsAttrWithHexIfLarger(
+    "mlir-print-elementsattrs-with-hex-if-larger",
+    llvm::cl::desc("Print the raw data of the dense elements attributes with "
+                   "more elements than this as a hex string, or never if "
+                   "negative"),
+    llvm::cl::init(100));
+
+static llvm::cl::opt<bool> enableThreads(
+    "experimental-mt-printer",
+    llvm::cl::desc("Enable experimental multithreading in the printer"),
+    llvm::cl::init(false));
+
 namespace {
 class ModuleState {
 public:
@@ -224,8 +238,9 @@ void ModuleState::initializeSymbolAliases() {
   // isn't used twice.
   llvm::StringSet<> usedAliases;
 
-  // Get the currently registered dialects.
-  auto dialects = context->getRegisteredDialects();
+  // Get the dialects constructed in the context, the others cannot have
+  // contributed anything to the IR being printed.
+  auto dialects = context->getLoadedDialects();
 
   // Collect the set of aliases from each dialect.
   SmallVector<std::pair<StringRef, AffineMap>, 8> affineMapAliases;
@@ -293,7 +308,7 @@ public:
     interleave(c.begin(), c.end(), each_fn, [&]() { os << ", "; });
   }
 
-  void print(Module *module);
+  void print(Module *module, bool consume = false);
   void printFunctionReference(Function *func);
   void printAttributeAndType(Attribute attr) {
     printAttributeOptionalType(attr, /*includeType=*/true);
@@ -327,6 +342,7 @@ protected:
   void printTrailingLocation(Location loc);
   void printLocationInternal(Location loc, bool pretty = false);
   void printDenseElementsAttr(DenseElementsAttr attr);
+  void printDenseElementsAttrAsHex(DenseElementsAttr attr);
 
   /// This enum is used to represent the binding stength of the enclosing
   /// context that an AffineExprStorage is being printed in, so we can
@@ -462,7 +478,7 @@ void ModulePrinter::printLocationInternal(Location loc, bool pretty) {
   }
 }
 
-void ModulePrinter::print(Module *module) {
+void ModulePrinter::print(Module *module, bool consume) {
   for (const auto &map : state.getAffineMapIds()) {
     StringRef alias = state.getAffineMapAlias(map);
     if (!alias.empty())
@@ -488,8 +504,47 @@ void ModulePrinter::print(Module *module) {
     if (!alias.empty())
       os << '!' << alias << " = type " << type << '\n';
   }
-  for (auto &fn : *module)
-    print(&fn);
+
+  // The preamble above is all the functions need from the module state, so
+  // they are streamed to the output one after the other, and consumed right
+  // after they are printed if requested.
+  if (!enableThreads) {
+    for (auto &fn : *module) {
+      print(&fn);
+      if (consume)
+        fn.eraseBody();
+    }
+    return;
+  }
+
+  // The module state is read-only once initialized, so the functions can be
+  // printed into separate buffers in parallel.  The buffers are then emitted
+  // in order, which keeps the output identical to printing sequentially.  They
+  // are printed by windows of a few functions per thread, so that the buffered
+  // output stays bounded whatever the size of the module.
+  auto *context = module->getContext();
+  size_t windowSize = 4 * context->getMaxConcurrency();
+  std::vector<std::pair<Function *, std::string>> functionBuffers;
+  auto flushWindow = [&] {
+    parallelForEach(
+        context, functionBuffers.begin(), functionBuffers.end(),
+        [&](std::pair<Function *, std::string> &functionBuffer) {
+          llvm::raw_string_ostream bufferOS(functionBuffer.second);
+          ModulePrinter(bufferOS, state).print(functionBuffer.first);
+        });
+    for (auto &functionBuffer : functionBuffers) {
+      os << functionBuffer.second;
+      if (consume)
+        functionBuffer.first->eraseBody();
+    }
+    functionBuffers.clear();
+  };
+  for (auto &fn : *module) {
+    functionBuffers.emplace_back(&fn, std::string());
+    if (functionBuffers.size() == windowSize)
+      flushWindow();
+  }
+  flushWindow();
 }
 
 /// Print a floating point value in a way that the parser will be able to
@@ -617,7 +672,20 @@ void ModulePrinter::printAttributeOptionalType(Attribute attr,
     os << "dense<";
     printType(eltsAttr.getType());
     os << ", ";
-    printDenseElementsAttr(eltsAttr);
+    // The data held in a file is referred to rather than printed, and large
+    // data is encoded at once rather than element by element. Splats hold a
+    // single element.
+    if (auto fileLocation = eltsAttr.getFileLocation()) {
+      os << '"';
+      printEscapedString(fileLocation->first, os);
+      os << "\", " << fileLocation->second;
+    } else if (printElementsAttrWithHexIfLarger >= 0 && !eltsAttr.isSplat() &&
+               eltsAttr.getNumElements() >
+                   static_cast<uint64_t>(printElementsAttrWithHexIfLarger)) {
+      printDenseElementsAttrAsHex(eltsAttr);
+    } else {
+      printDenseElementsAttr(eltsAttr);
+    }
     os << '>';
     break;
   }
@@ -644,6 +712,18 @@ void ModulePrinter::printAttributeOptionalType(Attribute attr,
   }
 }
 
+/// Prints the raw data of 'attr', without its padding, as a hex string.
+void ModulePrinter::printDenseElementsAttrAsHex(DenseElementsAttr attr) {
+  // FIXME(b/121118307): using 64 bits for BF16 because it is currently stored
+  // with double semantics.
+  auto eltType = attr.getType().getElementType();
+  size_t bitWidth = eltType.isBF16() ? 64 : eltType.getIntOrFloatBitWidth();
+  size_t numBytes =
+      llvm::alignTo(attr.getNumElements() * bitWidth, CHAR_BIT) / CHAR_BIT;
+  os << "\"0x" << llvm::toHex(StringRef(attr.getRawData().data(), numBytes))
+     << '"';
+}
+
 void ModulePrinter::printDenseElementsAttr(DenseElementsAttr attr) {
   auto type = attr.getType();
   auto shape = type.getShape();
@@ -1666,6 +1746,12 @@ void Module::print(raw_ostream &os) {
 
 void Module::dump() { print(llvm::errs()); }
 
+void Module::printAndConsume(raw_ostream &os) {
+  ModuleState state(getContext());
+  state.initialize(this);
+  ModulePrinter(os, state).print(this, /*consume=*/true);
+}
+
 void Location::print(raw_ostream &os) const {
   ModuleState state(nullptr);
   ModulePrinter(os, state).printLocation(*this);
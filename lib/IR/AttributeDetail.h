@@ -157,11 +157,20 @@ struct SplatElementsAttributeStorage : public ElementsAttributeStorage {
 };
 
 /// An attribute representing a reference to a dense vector or tensor object.
+/// The data of a splat only holds its first element. The hash value the
+/// attribute is uniqued on is cached, as it would otherwise be recomputed from
+/// the whole data whenever the uniquing table grows.
 struct DenseElementsAttributeStorage : public ElementsAttributeStorage {
   DenseElementsAttributeStorage(Attribute::Kind kind, VectorOrTensorType type,
-                                ArrayRef<char> data)
-      : ElementsAttributeStorage(kind, type), data(data) {}
+                                ArrayRef<char> data, bool isSplat,
+                                bool isExternal, unsigned hashValue)
+      : ElementsAttributeStorage(kind, type), data(data), isSplat(isSplat),
+        isExternal(isExternal), hashValue(hashValue) {}
   ArrayRef<char> data;
+  bool isSplat;
+  /// Set if 'data' is owned outside of the context rather than copied into it.
+  bool isExternal;
+  unsigned hashValue;
 };
 
 /// An attribute representing a reference to a tensor constant with opaque
@@ -22,6 +22,8 @@
 #include "mlir/IR/Function.h"
 #include "mlir/IR/IntegerSet.h"
 #include "mlir/IR/Types.h"
+#include "llvm/Support/MathExtras.h"
+#include <climits>
 
 using namespace mlir;
 using namespace mlir::detail;
@@ -190,6 +192,29 @@ Attribute SplatElementsAttr::getValue() const {
 
 /// DenseElementsAttr
 
+/// Returns the number of bits each element of type 'elementType' occupies in
+/// the raw data of a dense elements attribute.
+static size_t getDenseElementBitWidth(Type elementType) {
+  // FIXME(b/121118307): using 64 bits for BF16 because it is currently stored
+  // with double semantics.
+  return elementType.isBF16() ? 64 : elementType.getIntOrFloatBitWidth();
+}
+
+/// Returns true if elements of type 'elementType' are stored as values of
+/// 'size' bytes, which are integers if 'isInteger' is set and floating point
+/// values otherwise.
+static bool isElementTypeStoredAs(Type elementType, size_t size,
+                                  bool isInteger) {
+  if (isInteger)
+    return elementType.isa<IntegerType>() &&
+           elementType.getIntOrFloatBitWidth() == size * CHAR_BIT;
+  if (size == sizeof(float))
+    return elementType.isF32();
+  // BF16 is stored as a double, see getDenseElementBitWidth.
+  return size == sizeof(double) &&
+         (elementType.isF64() || elementType.isBF16());
+}
+
 /// Return the value at the given index. If index does not refer to a valid
 /// element, then a null attribute is returned.
 Attribute DenseElementsAttr::getValue(ArrayRef<uint64_t> index) const {
@@ -214,7 +239,10 @@ Attribute DenseElementsAttr::getValue(ArrayRef<uint64_t> index) const {
     dimMultiplier *= shape[i];
   }
 
-  // Return the element stored at the 1D index.
+  // Return the element stored at the 1D index, which is the first one of a
+  // splat.
+  if (isSplat())
+    valueIndex = 0;
 
   // FIXME(b/121118307): using 64 bits for BF16 because it is currently stored
   // with double semantics.
@@ -239,24 +267,17 @@ Attribute DenseElementsAttr::getValue(ArrayRef<uint64_t> index) const {
 
 void DenseElementsAttr::getValues(SmallVectorImpl<Attribute> &values) const {
   auto elementType = getType().getElementType();
+  values.reserve(values.size() + getNumElements());
   switch (getKind()) {
   case Attribute::Kind::DenseIntElements: {
-    // Get the raw APInt values.
-    SmallVector<APInt, 8> intValues;
-    cast<DenseIntElementsAttr>().getValues(intValues);
-
-    // Convert each to an IntegerAttr.
-    for (auto &intVal : intValues)
+    // Convert each raw APInt value to an IntegerAttr.
+    for (auto intVal : getIntValues())
       values.push_back(IntegerAttr::get(elementType, intVal));
     return;
   }
   case Attribute::Kind::DenseFPElements: {
-    // Get the raw APFloat values.
-    SmallVector<APFloat, 8> floatValues;
-    cast<DenseFPElementsAttr>().getValues(floatValues);
-
-    // Convert each to an FloatAttr.
-    for (auto &floatVal : floatValues)
+    // Convert each raw APFloat value to an FloatAttr.
+    for (auto floatVal : getFloatValues())
       values.push_back(FloatAttr::get(elementType, floatVal));
     return;
   }
@@ -265,10 +286,93 @@ void DenseElementsAttr::getValues(SmallVectorImpl<Attribute> &values) const {
   }
 }
 
+llvm::iterator_range<DenseElementsAttr::IntElementIterator>
+DenseElementsAttr::getIntValues() const {
+  assert(isa<DenseIntElementsAttr>() && "expected integer elements");
+  size_t bitWidth = getDenseElementBitWidth(getType().getElementType());
+  const char *rawData = getRawData().data();
+  bool splat = isSplat();
+  return {IntElementIterator(rawData, splat, 0, bitWidth),
+          IntElementIterator(rawData, splat, getNumElements(), bitWidth)};
+}
+
+llvm::iterator_range<DenseElementsAttr::FloatElementIterator>
+DenseElementsAttr::getFloatValues() const {
+  assert(isa<DenseFPElementsAttr>() && "expected floating point elements");
+  auto elementType = getType().getElementType();
+  size_t bitWidth = getDenseElementBitWidth(elementType);
+  const auto &semantics = elementType.cast<FloatType>().getFloatSemantics();
+  const char *rawData = getRawData().data();
+  bool splat = isSplat();
+  return {FloatElementIterator(rawData, splat, 0, bitWidth, semantics),
+          FloatElementIterator(rawData, splat, getNumElements(), bitWidth,
+                               semantics)};
+}
+
+bool DenseElementsAttr::isStoredAs(size_t size, bool isInteger) const {
+  return isElementTypeStoredAs(getType().getElementType(), size, isInteger);
+}
+
+size_t DenseElementsAttr::getNumElements() const {
+  return getType().getNumElements();
+}
+
+bool DenseElementsAttr::isSplat() const {
+  return static_cast<ImplType *>(attr)->isSplat;
+}
+
+bool DenseElementsAttr::isExternal() const {
+  return static_cast<ImplType *>(attr)->isExternal;
+}
+
 ArrayRef<char> DenseElementsAttr::getRawData() const {
   return static_cast<ImplType *>(attr)->data;
 }
 
+template <typename T>
+DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType type,
+                                         ArrayRef<T> values) {
+  assert(isElementTypeStoredAs(type.getElementType(), sizeof(T),
+                               std::is_integral<T>::value) &&
+         "expected the elements of 'type' to be stored as values of type T");
+  assert(values.size() == type.getNumElements() &&
+         "expected 'values' to contain the same number of elements as 'type'");
+
+  // The values already are the raw data, but for the padding of the storage to
+  // whole words, which is part of the key the attributes are uniqued on.
+  ArrayRef<char> data(reinterpret_cast<const char *>(values.data()),
+                      values.size() * sizeof(T));
+  size_t storageSize = llvm::alignTo(data.size(), APInt::APINT_WORD_SIZE);
+  if (storageSize == data.size())
+    return get(type, data);
+  std::vector<char> storage(storageSize);
+  std::copy(data.begin(), data.end(), storage.begin());
+  return get(type, storage);
+}
+
+// Instantiate the construction from values for the C++ types elements may be
+// stored as.
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<int8_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<uint8_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<int16_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<uint16_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<int32_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<uint32_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<int64_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<uint64_t>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<float>);
+template DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType,
+                                                  ArrayRef<double>);
+
 // Constructs a dense elements attribute from an array of raw APInt values.
 // Each APInt value is expected to have the same bitwidth as the element type
 // of 'type'.
@@ -302,6 +406,10 @@ void DenseElementsAttr::getRawValues(SmallVectorImpl<APInt> &values) const {
   size_t bitWidth =
       elementType.isBF16() ? 64 : elementType.getIntOrFloatBitWidth();
   const auto *rawData = getRawData().data();
+  if (isSplat()) {
+    values.append(elementNum, readBits(rawData, 0, bitWidth));
+    return;
+  }
   for (size_t i = 0, e = elementNum; i != e; ++i)
     values.push_back(readBits(rawData, i * bitWidth, bitWidth));
 }
@@ -372,6 +480,10 @@ DenseIntElementsAttr DenseIntElementsAttr::get(VectorOrTensorType type,
   auto eltType = type.getElementType();
   size_t bitWidth = eltType.isBF16() ? 64 : eltType.getIntOrFloatBitWidth();
 
+  // 64-bit values are stored as is.
+  if (bitWidth == 64 && eltType.isa<IntegerType>())
+    return DenseElementsAttr::get(type, values).cast<DenseIntElementsAttr>();
+
   // Convert the raw integer values to APInt.
   SmallVector<APInt, 8> apIntValues;
   apIntValues.reserve(values.size());
@@ -400,15 +512,8 @@ DenseFPElementsAttr DenseFPElementsAttr::get(VectorOrTensorType type,
 }
 
 void DenseFPElementsAttr::getValues(SmallVectorImpl<APFloat> &values) const {
-  // Get the raw APInt element values.
-  SmallVector<APInt, 8> intValues;
-  getRawValues(intValues);
-
-  // Convert each of the APInt values to an APFloat.
-  auto elementType = getType().getElementType().dyn_cast<FloatType>();
-  const auto &elementSemantics = elementType.getFloatSemantics();
-  for (auto &intValue : intValues)
-    values.push_back(APFloat(elementSemantics, intValue));
+  auto floatValues = getFloatValues();
+  values.append(floatValues.begin(), floatValues.end());
 }
 
 /// OpaqueElementsAttr
@@ -455,10 +560,18 @@ Attribute SparseElementsAttr::getValue(ArrayRef<uint64_t> index) const {
     return Attribute();
 
   // The sparse indices are 64-bit integers, so we can reinterpret the raw data
-  // as a 1-D index array.
+  // as a 1-D index array, unless it only holds the first index of a splat.
   auto sparseIndices = getIndices();
+  SmallVector<uint64_t, 8> splatIndexValues;
+  if (sparseIndices.isSplat()) {
+    auto indexValues = sparseIndices.getValues<uint64_t>();
+    splatIndexValues.assign(indexValues.begin(), indexValues.end());
+  }
   const uint64_t *sparseIndexValues =
-      reinterpret_cast<const uint64_t *>(sparseIndices.getRawData().data());
+      sparseIndices.isSplat()
+          ? splatIndexValues.data()
+          : reinterpret_cast<const uint64_t *>(
+                sparseIndices.getRawData().data());
 
   // Build a mapping between known indices and the offset of the stored element.
   llvm::SmallDenseMap<llvm::ArrayRef<uint64_t>, size_t> mappedIndices;
@@ -482,6 +595,25 @@ Attribute SparseElementsAttr::getValue(ArrayRef<uint64_t> index) const {
   return getValues().getValue(it->second);
 }
 
+/// Gets the offset of each stored element into the row-major elements of the
+/// type.
+void SparseElementsAttr::getLinearIndices(
+    SmallVectorImpl<uint64_t> &offsets) const {
+  auto type = getType();
+  assert(type.hasStaticShape() && "expected a statically shaped type");
+  auto shape = type.getShape();
+
+  // The indices are 64-bit integers holding one row of 'rank' values per
+  // stored element.
+  auto sparseIndices = getIndices();
+  auto numSparseIndices = sparseIndices.getType().getDimSize(0);
+  offsets.assign(numSparseIndices, 0);
+  auto indexIt = sparseIndices.getValues<uint64_t>().begin();
+  for (auto &offset : offsets)
+    for (int64_t dimSize : shape)
+      offset = offset * dimSize + *indexIt++;
+}
+
 /// NamedAttributeList
 
 NamedAttributeList::NamedAttributeList(MLIRContext *context,
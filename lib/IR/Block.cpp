@@ -118,6 +118,9 @@ bool Block::verifyInstOrder() {
 
   Operation *prev = nullptr;
   for (auto &i : *this) {
+    // The operations inserted since the block was numbered have no index yet.
+    if (!i.hasValidOrder())
+      continue;
     // The previous operation must have a smaller order index than the next as
     // it appears earlier in the list.
     if (prev && prev->orderIndex >= i.orderIndex)
@@ -131,11 +134,12 @@ bool Block::verifyInstOrder() {
 void Block::recomputeInstOrder() {
   parentValidInstOrderPair.setInt(true);
 
-  // TODO(riverriddle) Have non-congruent indices to reduce the number of times
-  // an insert invalidates the list.
+  // Leave room between the indices for the operations inserted later.
   unsigned orderIndex = 0;
-  for (auto &op : *this)
-    op.orderIndex = orderIndex++;
+  for (auto &op : *this) {
+    op.orderIndex = orderIndex;
+    orderIndex += Operation::kOrderStride;
+  }
 }
 
 Block *PredecessorIterator::operator*() const {
@@ -170,13 +174,17 @@ auto Block::addArguments(ArrayRef<Type> types)
   return {arguments.data() + initialSize, arguments.data() + arguments.size()};
 }
 
-void Block::eraseArgument(unsigned index) {
+void Block::eraseArgument(unsigned index, bool updatePredTerms) {
   assert(index < arguments.size());
 
   // Delete the argument.
   delete arguments[index];
   arguments.erase(arguments.begin() + index);
 
+  // If we aren't updating predecessors, there is nothing left to do.
+  if (!updatePredTerms)
+    return;
+
   // Erase this argument from each of the predecessor's terminator.
   for (auto predIt = pred_begin(), predE = pred_end(); predIt != predE;
        ++predIt) {
@@ -228,28 +236,81 @@ Block *Block::getSinglePredecessor() {
 // Operation Walkers
 //===----------------------------------------------------------------------===//
 
-void Block::walk(const std::function<void(Operation *)> &callback) {
-  walk(begin(), end(), callback);
-}
-
-void Block::walk(Block::iterator begin, Block::iterator end,
-                 const std::function<void(Operation *)> &callback) {
-  // Walk the operations within this block.
-  for (auto &op : llvm::make_early_inc_range(llvm::make_range(begin, end)))
-    op.walk(callback);
-}
-
-void Block::walkPostOrder(const std::function<void(Operation *)> &callback) {
-  walkPostOrder(begin(), end(), callback);
+// Walks the operations in [begin, end) and their nested operations in
+// preorder. The worklist holds the ranges of operations left to visit, the
+// innermost last. The iterator of a range is stepped over an operation before
+// the operation is visited, so that the callback may erase the operation as
+// long as it skips the operations nested in it.
+static WalkResult walkRangePreOrder(Block::iterator begin,
+                                    Block::iterator end,
+                                    detail::WalkCallback callback) {
+  SmallVector<std::pair<Block::iterator, Block::iterator>, 8> worklist;
+  worklist.emplace_back(begin, end);
+  while (!worklist.empty()) {
+    auto &range = worklist.back();
+    if (range.first == range.second) {
+      worklist.pop_back();
+      continue;
+    }
+    Operation &op = *range.first++;
+    auto result = callback(&op);
+    if (result.wasInterrupted())
+      return result;
+    if (result.wasSkipped())
+      continue;
+    // Push the blocks in reverse, so that they are visited in order.
+    for (auto &region : llvm::reverse(op.getRegions()))
+      for (auto &block : llvm::reverse(region))
+        worklist.emplace_back(block.begin(), block.end());
+  }
+  return WalkResult::advance();
+}
+
+namespace {
+// An entry of the worklist of a postorder walk: either a range of operations
+// left to walk, or an operation to visit once its nested operations have been.
+struct PostOrderEntry {
+  Operation *op;
+  Block::iterator begin, end;
+};
+} // end anonymous namespace
+
+// Walks the operations in [begin, end) and their nested operations in
+// postorder. The callback may erase the operation it visits.
+static WalkResult walkRangePostOrder(Block::iterator begin,
+                                     Block::iterator end,
+                                     detail::WalkCallback callback) {
+  SmallVector<PostOrderEntry, 8> worklist;
+  worklist.push_back({nullptr, begin, end});
+  while (!worklist.empty()) {
+    auto &entry = worklist.back();
+    if (auto *op = entry.op) {
+      worklist.pop_back();
+      if (callback(op).wasInterrupted())
+        return WalkResult::interrupt();
+      continue;
+    }
+    if (entry.begin == entry.end) {
+      worklist.pop_back();
+      continue;
+    }
+    Operation &op = *entry.begin++;
+    worklist.push_back({&op, Block::iterator(), Block::iterator()});
+    // The blocks pushed last are walked first, so the regions and their blocks
+    // are walked in reverse.
+    for (auto &region : op.getRegions())
+      for (auto &block : region)
+        worklist.push_back({nullptr, block.begin(), block.end()});
+  }
+  return WalkResult::advance();
 }
 
-/// Walk the operations in the specified [begin, end) range of this block
-/// in postorder, calling the callback for each operation.
-void Block::walkPostOrder(Block::iterator begin, Block::iterator end,
-                          const std::function<void(Operation *)> &callback) {
-  // Walk the operations within this block.
-  for (auto &op : llvm::make_early_inc_range(llvm::make_range(begin, end)))
-    op.walkPostOrder(callback);
+WalkResult Block::walkOperations(iterator begin, iterator end,
+                                 detail::WalkCallback callback,
+                                 WalkOrder order) {
+  if (order == WalkOrder::PreOrder)
+    return walkRangePreOrder(begin, end, callback);
+  return walkRangePostOrder(begin, end, callback);
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,133 @@
+//===- Diagnostics.cpp - MLIR Diagnostic Utilities ------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Diagnostics.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace mlir;
+
+//===----------------------------------------------------------------------===//
+// ParallelDiagnosticHandler
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A utility stack trace entry that dumps any dangling diagnostics held by a
+/// ParallelDiagnosticHandler in the event of a crash.
+struct PrettyStackTraceParallelDiagnosticEntry
+    : public llvm::PrettyStackTraceEntry {
+  PrettyStackTraceParallelDiagnosticEntry(
+      ParallelDiagnosticHandler &parallelHandler)
+      : parallelHandler(parallelHandler) {}
+
+  void print(raw_ostream &os) const override {
+    // Early exit if there are no diagnostics, this is the common case.
+    if (parallelHandler.empty())
+      return;
+
+    os << "In-Flight Diagnostics:\n";
+    parallelHandler.emitDiagnostics(
+        [&](Location loc, StringRef message, MLIRContext::DiagnosticKind kind) {
+          os.indent(4);
+
+          // Print each diagnostic with the format:
+          //   "<location>: <kind>: <msg>"
+          if (!loc.isa<UnknownLoc>())
+            os << loc << ": ";
+          switch (kind) {
+          case MLIRContext::DiagnosticKind::Error:
+            os << "error: ";
+            break;
+          case MLIRContext::DiagnosticKind::Warning:
+            os << "warning: ";
+            break;
+          case MLIRContext::DiagnosticKind::Note:
+            os << "note: ";
+            break;
+          }
+          os << message << '\n';
+        });
+  }
+
+  // A reference to the parallel handler to dump on the event of a crash.
+  ParallelDiagnosticHandler &parallelHandler;
+};
+} // end anonymous namespace
+
+ParallelDiagnosticHandler::ParallelDiagnosticHandler(MLIRContext &ctx)
+    : prevHandler(ctx.getDiagnosticHandler()), context(ctx),
+      crashEntry(new PrettyStackTraceParallelDiagnosticEntry(*this)) {
+  ctx.registerDiagnosticHandler([this](Location loc, StringRef message,
+                                       MLIRContext::DiagnosticKind kind) {
+    uint64_t tid = llvm::get_threadid();
+    llvm::sys::SmartScopedLock<true> lock(mutex);
+
+    // Append a new diagnostic.
+    diagnostics.emplace_back(threadToOrderID[tid], loc, message, kind);
+  });
+}
+
+ParallelDiagnosticHandler::~ParallelDiagnosticHandler() {
+  // Remove the crash entry, the diagnostics are about to be emitted.
+  crashEntry.reset();
+
+  // Restore the previous diagnostic handler.
+  context.registerDiagnosticHandler(prevHandler);
+
+  // Early exit if there are no diagnostics, this is the common case.
+  if (diagnostics.empty())
+    return;
+
+  // Emit the diagnostics back to the context.
+  emitDiagnostics(
+      [&](Location loc, StringRef message, MLIRContext::DiagnosticKind kind) {
+        return context.emitDiagnostic(loc, message, kind);
+      });
+}
+
+/// Set the order id for the current thread.
+void ParallelDiagnosticHandler::setOrderIDForThread(size_t orderID) {
+  uint64_t tid = llvm::get_threadid();
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  threadToOrderID[tid] = orderID;
+}
+
+/// Drop the held diagnostics emitted for an order id greater than 'orderID'.
+void ParallelDiagnosticHandler::eraseDiagnosticsAfter(size_t orderID) {
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  diagnostics.erase(std::remove_if(diagnostics.begin(), diagnostics.end(),
+                                   [&](const ThreadDiagnostic &diag) {
+                                     return diag.id > orderID;
+                                   }),
+                    diagnostics.end());
+}
+
+/// Utility method to emit any held diagnostics.
+void ParallelDiagnosticHandler::emitDiagnostics(
+    std::function<void(Location, StringRef, MLIRContext::DiagnosticKind)>
+        emitFn) {
+  // Stable sort all of the diagnostics that were emitted. This creates a
+  // deterministic ordering for the diagnostics based upon which unit of work
+  // they were emitted for.
+  std::stable_sort(diagnostics.begin(), diagnostics.end());
+
+  // Emit each diagnostic to the context again.
+  for (ThreadDiagnostic &diag : diagnostics)
+    emitFn(diag.loc, diag.msg, diag.kind);
+}
@@ -23,40 +23,69 @@
 #include "llvm/Support/Regex.h"
 using namespace mlir;
 
-// Registry for all dialect allocation functions.
-static llvm::ManagedStatic<SmallVector<DialectAllocatorFunction, 8>>
+// Registry for all dialect allocation functions, with the namespaces of the
+// dialects they allocate.
+static llvm::ManagedStatic<
+    SmallVector<std::pair<std::string, DialectAllocatorFunction>, 8>>
     dialectRegistry;
 
-// Registry for functions that set dialect hooks.
-static llvm::ManagedStatic<SmallVector<DialectHooksSetter, 8>>
+// Returns the allocation function registered for the dialect with namespace
+// `name`, or null if there is none.
+static const DialectAllocatorFunction *lookupDialectAllocator(StringRef name) {
+  for (const auto &entry : *dialectRegistry)
+    if (entry.first == name)
+      return &entry.second;
+  return nullptr;
+}
+
+// Registry for functions that set dialect hooks, with the namespaces of the
+// dialects they apply to.
+static llvm::ManagedStatic<
+    SmallVector<std::pair<std::string, DialectHooksSetter>, 8>>
     dialectHooksRegistry;
 
 /// Registers a specific dialect creation function with the system, typically
 /// used through the DialectRegistration template.
-void mlir::registerDialectAllocator(const DialectAllocatorFunction &function) {
+void mlir::registerDialectAllocator(StringRef name,
+                                    const DialectAllocatorFunction &function) {
   assert(function &&
          "Attempting to register an empty dialect initialize function");
-  dialectRegistry->push_back(function);
+  assert(!lookupDialectAllocator(name) &&
+         "a dialect with the given namespace has already been registered");
+  dialectRegistry->emplace_back(name.str(), function);
 }
 
 /// Registers a function to set specific hooks for a specific dialect, typically
 /// used through the DialectHooksRegistreation template.
-void mlir::registerDialectHooksSetter(const DialectHooksSetter &function) {
+void mlir::registerDialectHooksSetter(StringRef dialectName,
+                                      const DialectHooksSetter &function) {
   assert(
       function &&
       "Attempting to register an empty dialect hooks initialization function");
 
-  dialectHooksRegistry->push_back(function);
+  dialectHooksRegistry->emplace_back(dialectName.str(), function);
 }
 
-/// Registers all dialects and their const folding hooks with the specified
-/// MLIRContext.
+/// Constructs all the registered dialects in the specified MLIRContext, along
+/// with their const folding hooks.
 void mlir::registerAllDialects(MLIRContext *context) {
-  for (const auto &fn : *dialectRegistry)
-    fn(context);
-  for (const auto &fn : *dialectHooksRegistry) {
-    fn(context);
-  }
+  for (const auto &entry : *dialectRegistry)
+    context->getRegisteredDialect(entry.first);
+}
+
+Dialect *mlir::detail::constructRegisteredDialect(MLIRContext *context,
+                                                  StringRef name) {
+  auto *allocator = lookupDialectAllocator(name);
+  if (!allocator)
+    return nullptr;
+
+  Dialect *dialect = (*allocator)(context);
+  assert(dialect->getNamespace() == name &&
+         "dialect registered under another namespace than its own");
+  for (const auto &entry : *dialectHooksRegistry)
+    if (entry.first == name)
+      entry.second(dialect);
+  return dialect;
 }
 
 Dialect::Dialect(StringRef name, MLIRContext *context)
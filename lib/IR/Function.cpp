@@ -46,6 +46,18 @@ Function::~Function() {
 
 MLIRContext *Function::getContext() { return getType().getContext(); }
 
+/// Load the body of this function if it hasn't been materialized yet.
+LogicalResult Function::materialize() {
+  if (!materializable)
+    return success();
+
+  // Clear the flag first so that the materializer can populate the body.
+  materializable = false;
+  auto *materializer = module ? module->getMaterializer() : nullptr;
+  assert(materializer && "materializable function without a materializer");
+  return materializer->materialize(this);
+}
+
 Module *llvm::ilist_traits<Function>::getContainingModule() {
   size_t Offset(
       size_t(&((Module *)nullptr->*Module::getSublistAccess(nullptr))));
@@ -62,6 +74,7 @@ void llvm::ilist_traits<Function>::addNodeToList(Function *function) {
 
   // Add this function to the symbol table of the module, uniquing the name if
   // a conflict is detected.
+  llvm::sys::SmartScopedWriter<true> lock(module->symbolTableMutex);
   if (!module->symbolTable.insert({function->getName(), function}).second) {
     // If a conflict was detected, then the function will not have been added to
     // the symbol table.  Try suffixes until we get to a unique name that works.
@@ -87,7 +100,10 @@ void llvm::ilist_traits<Function>::removeNodeFromList(Function *function) {
   assert(function->module && "not already in a module!");
 
   // Remove the symbol table entry.
-  function->module->symbolTable.erase(function->getName());
+  {
+    llvm::sys::SmartScopedWriter<true> lock(function->module->symbolTableMutex);
+    function->module->symbolTable.erase(function->getName());
+  }
   function->module = nullptr;
 }
 
@@ -115,6 +131,16 @@ void Function::erase() {
   getModule()->getFunctions().erase(this);
 }
 
+/// Delete the body of this function, leaving it external.
+void Function::eraseBody() {
+  materializable = false;
+  // Operations may have cyclic references, which need to be dropped before we
+  // can start deleting them.
+  for (auto &block : body)
+    block.dropAllReferences();
+  body.getBlocks().clear();
+}
+
 /// Emit a note about this operation, reporting up to any diagnostic
 /// handlers that may be listening.
 void Function::emitNote(const Twine &message) {
@@ -156,7 +182,7 @@ void Function::cloneInto(Function *dest, BlockAndValueMapping &mapper) {
   dest->setAttrs(newAttrs.takeVector());
 
   // Clone the body.
-  body.cloneInto(&dest->body, mapper, getContext());
+  getBody().cloneInto(&dest->getBody(), mapper, getContext());
 }
 
 /// Create a deep copy of this function and all of its blocks, remapping
@@ -209,14 +235,20 @@ void Function::addEntryBlock() {
   entry->addArguments(type.getInputs());
 }
 
-void Function::walk(const std::function<void(Operation *)> &callback) {
-  // Walk each of the blocks within the function.
-  for (auto &block : getBlocks())
-    block.walk(callback);
-}
-
-void Function::walkPostOrder(const std::function<void(Operation *)> &callback) {
-  // Walk each of the blocks within the function.
-  for (auto &block : llvm::reverse(getBlocks()))
-    block.walkPostOrder(callback);
+WalkResult Function::walkOperations(detail::WalkCallback callback,
+                                    WalkOrder order) {
+  // Walk each of the blocks within the function, in reverse in postorder.
+  auto walkBlock = [&](Block &block) {
+    return Block::walkOperations(block.begin(), block.end(), callback, order);
+  };
+  if (order == WalkOrder::PreOrder) {
+    for (auto &block : getBlocks())
+      if (walkBlock(block).wasInterrupted())
+        return WalkResult::interrupt();
+  } else {
+    for (auto &block : llvm::reverse(getBlocks()))
+      if (walkBlock(block).wasInterrupted())
+        return WalkResult::interrupt();
+  }
+  return WalkResult::advance();
 }
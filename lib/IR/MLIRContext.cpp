@@ -21,6 +21,7 @@
 #include "AttributeDetail.h"
 #include "IntegerSetDetail.h"
 #include "LocationDetail.h"
+#include "OperationPool.h"
 #include "TypeDetail.h"
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
@@ -37,16 +38,38 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/RWMutex.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <cstring>
 #include <memory>
 
 using namespace mlir;
 using namespace mlir::detail;
 using namespace llvm;
 
+static llvm::cl::opt<unsigned> clMaxThreads(
+    "mlir-max-threads",
+    llvm::cl::desc("Limit the number of threads used by each parallel region "
+                   "of work, 0 means one per hardware thread"),
+    llvm::cl::init(0));
+
+static llvm::cl::opt<bool> clFastVerify(
+    "mlir-fast-verify",
+    llvm::cl::desc("Skip the constraints marked as expensive when verifying "
+                   "the operations"),
+    llvm::cl::init(false));
+
 /// A utility function to safely get or create a uniqued instance within the
-/// given set container.
+/// given set container.  The new instance is constructed outside of the lock,
+/// so 'constructorFn' must allocate from memory that does not need to be
+/// synchronized, e.g. a thread-local allocator of the context.  If another
+/// thread inserts an equivalent instance first, the new one is discarded.
 template <typename ValueT, typename DenseInfoT, typename KeyT,
           typename ConstructorFn>
 static ValueT safeGetOrCreate(DenseSet<ValueT, DenseInfoT> &container,
@@ -59,21 +82,19 @@ static ValueT safeGetOrCreate(DenseSet<ValueT, DenseInfoT> &container,
       return *it;
   }
 
-  // Aquire a writer-lock so that we can safely create the new instance.
-  llvm::sys::SmartScopedWriter<true> instanceLock(mutex);
-
-  // Check for an existing instance again here, because another writer thread
-  // may have already created one.
-  auto existing = container.insert_as(ValueT(), key);
-  if (!existing.second)
-    return *existing.first;
+  // Construct a new instance of the value before aquiring the writer-lock.
+  ValueT newValue = constructorFn();
 
-  // Otherwise, construct a new instance of the value.
-  return *existing.first = constructorFn();
+  // Aquire a writer-lock so that we can safely insert the new instance. This
+  // returns the existing instance if another writer thread has already
+  // inserted one.
+  llvm::sys::SmartScopedWriter<true> instanceLock(mutex);
+  return *container.insert_as(newValue, key).first;
 }
 
 /// A utility function to safely get or create a uniqued instance within the
-/// given map container.
+/// given map container.  As above, the new instance is constructed outside of
+/// the lock.
 template <typename ContainerTy, typename KeyT, typename ConstructorFn>
 static typename ContainerTy::mapped_type
 safeGetOrCreate(ContainerTy &container, KeyT &&key,
@@ -86,18 +107,141 @@ safeGetOrCreate(ContainerTy &container, KeyT &&key,
       return it->second;
   }
 
-  // Aquire a writer-lock so that we can safely create the new instance.
+  // Construct a new instance of the value before aquiring the writer-lock.
+  typename ContainerTy::mapped_type newValue = constructorFn();
+
+  // Aquire a writer-lock so that we can safely insert the new instance. This
+  // returns the existing instance if another writer thread has already
+  // inserted one.
   llvm::sys::SmartScopedWriter<true> instanceLock(mutex);
+  return container.try_emplace(key, newValue).first->second;
+}
 
-  // Check for an existing instance again here, because another writer thread
-  // may have already created one.
-  auto *&result = container[key];
-  if (result)
-    return result;
+namespace {
+/// A uniquing table that is split into a fixed number of shards, each with its
+/// own container and lock.  The shard of a key is selected by its hash value,
+/// so that threads creating unrelated instances do not contend on a single
+/// lock.
+template <typename ContainerT> struct ShardedUniquingTable {
+  enum { kLog2NumShards = 4, kNumShards = 1 << kLog2NumShards };
+
+  struct Shard {
+    ContainerT container;
+    llvm::sys::SmartRWMutex<true> mutex;
+  };
 
-  // Otherwise, construct a new instance of the value.
-  return result = constructorFn();
-}
+  /// Return the shard for the given hash value.  The low bits of the hash are
+  /// also used to select a bucket within the container of a shard, so the
+  /// shard is selected with the high bits of a multiplicative hash instead.
+  Shard &getShard(unsigned hashValue) {
+    return shards[(hashValue * 0x9E3779B9u) >> (32 - kLog2NumShards)];
+  }
+
+  /// Return the number of instances held by all shards.
+  size_t size() {
+    size_t numInstances = 0;
+    for (auto &shard : shards) {
+      llvm::sys::SmartScopedReader<true> lock(shard.mutex);
+      numInstances += shard.container.size();
+    }
+    return numInstances;
+  }
+
+  Shard shards[kNumShards];
+};
+
+/// A set of instances of 'T' owned by a context, with one instance for each
+/// thread that uses it.  This allows for using them without holding any lock.
+template <typename T> class ThreadLocalInstances {
+public:
+  ThreadLocalInstances() : id(nextID++) {}
+
+  /// Return the instance of the calling thread.
+  T &get() {
+    // Each thread caches the instance it used last.  The cache is keyed on an
+    // identifier that is never reused, so a stale entry can never match a
+    // different set of instances that happens to live at the same address.
+    static LLVM_THREAD_LOCAL uint64_t cachedID = 0;
+    static LLVM_THREAD_LOCAL T *cachedInstance = nullptr;
+    if (cachedID == id)
+      return *cachedInstance;
+
+    llvm::sys::SmartScopedLock<true> lock(mutex);
+    auto &instance = instances[llvm::get_threadid()];
+    if (!instance)
+      instance = llvm::make_unique<T>();
+    cachedID = id;
+    cachedInstance = instance.get();
+    return *instance;
+  }
+
+  /// Invoke 'fn' on the instance of each thread.  The instances may still be
+  /// in use by their threads, so 'fn' should only read coarse properties of
+  /// them, e.g. their memory usage.
+  template <typename FnT> void forEach(FnT &&fn) {
+    llvm::sys::SmartScopedLock<true> lock(mutex);
+    for (auto &it : instances)
+      fn(*it.second);
+  }
+
+private:
+  /// The identifier of this set of instances.
+  const uint64_t id;
+
+  /// The instances of each thread, keyed by thread id.
+  DenseMap<uint64_t, std::unique_ptr<T>> instances;
+  llvm::sys::SmartMutex<true> mutex;
+
+  /// The identifier to use for the next set of instances.  This starts from 1
+  /// so that it never matches an empty thread-local cache.
+  static std::atomic<uint64_t> nextID;
+};
+template <typename T> std::atomic<uint64_t> ThreadLocalInstances<T>::nextID(1);
+
+/// A set of bump pointer allocators owned by a context, with one allocator for
+/// each thread that creates uniqued storage within it.  This allows for
+/// constructing new storage instances without holding any lock, leaving only
+/// the insertion into a uniquing table to be synchronized.
+using ThreadLocalAllocators = ThreadLocalInstances<llvm::BumpPtrAllocator>;
+
+/// A pool of memory for the operations created by a thread.  The operations
+/// are carved out of slabs, and the memory of a destroyed operation is kept
+/// on the free list of its size class, to be reused by the next operation of
+/// the same size class.  The slabs are only released with the pool.
+class OperationPool {
+public:
+  /// Return memory for an operation of size class 'sizeClass'.
+  void *allocate(unsigned sizeClass) {
+    assert(sizeClass != 0 && sizeClass <= kNumOperationSizeClasses);
+    auto *&freeList = freeLists[sizeClass - 1];
+    if (!freeList)
+      return allocator.Allocate(sizeClass * kOperationSizeGranularity,
+                                alignof(Operation));
+    auto *mem = freeList;
+    freeList = freeList->next;
+    return mem;
+  }
+
+  /// Put the memory of an operation of size class 'sizeClass' on the free list
+  /// of that class.
+  void deallocate(void *mem, unsigned sizeClass) {
+    assert(sizeClass != 0 && sizeClass <= kNumOperationSizeClasses);
+    auto *&freeList = freeLists[sizeClass - 1];
+    freeList = new (mem) FreeNode{freeList};
+  }
+
+  /// Return the number of bytes of the slabs carved out by this pool.
+  size_t getBytesAllocated() const { return allocator.getBytesAllocated(); }
+
+private:
+  struct FreeNode {
+    FreeNode *next;
+  };
+
+  llvm::BumpPtrAllocator allocator;
+  FreeNode *freeLists[kNumOperationSizeClasses] = {};
+};
+} // end anonymous namespace
 
 namespace {
 /// A builtin dialect to define types/etc that are necessary for the
@@ -250,23 +394,34 @@ struct AttributeListKeyInfo : DenseMapInfo<AttributeListStorage *> {
 };
 
 struct DenseElementsAttrInfo : DenseMapInfo<DenseElementsAttributeStorage *> {
-  using KeyTy = std::pair<VectorOrTensorType, ArrayRef<char>>;
+  /// Dense elements attributes are uniqued based on their type and data. The
+  /// hash of the data is computed once, when the key is constructed, and then
+  /// cached in the storage.
+  struct KeyTy {
+    KeyTy(VectorOrTensorType type, ArrayRef<char> data, bool isSplat)
+        : type(type), data(data), isSplat(isSplat),
+          hashValue(hash_combine(
+              type, isSplat, hash_combine_range(data.begin(), data.end()))) {}
+
+    VectorOrTensorType type;
+    ArrayRef<char> data;
+    bool isSplat;
+    unsigned hashValue;
+  };
   using DenseMapInfo<DenseElementsAttributeStorage *>::isEqual;
 
   static unsigned getHashValue(DenseElementsAttributeStorage *key) {
-    return getHashValue(KeyTy(key->type, key->data));
+    return key->hashValue;
   }
 
-  static unsigned getHashValue(KeyTy key) {
-    return hash_combine(
-        key.first, hash_combine_range(key.second.begin(), key.second.end()));
-  }
+  static unsigned getHashValue(const KeyTy &key) { return key.hashValue; }
 
   static bool isEqual(const KeyTy &lhs,
                       const DenseElementsAttributeStorage *rhs) {
     if (rhs == getEmptyKey() || rhs == getTombstoneKey())
       return false;
-    return lhs == std::make_pair(rhs->type, rhs->data);
+    return lhs.hashValue == rhs->hashValue && lhs.type == rhs->type &&
+           lhs.isSplat == rhs->isSplat && lhs.data == rhs->data;
   }
 };
 
@@ -358,42 +513,52 @@ struct TypeUniquerImpl {
     TypeStorage *storage;
   };
 
-  /// Get or create an instance of a complex derived type.
+  /// Get or create an instance of a complex derived type.  New instances are
+  /// allocated from 'arena', which must be local to the calling thread.
   TypeStorage *getOrCreate(
       unsigned kind, unsigned hashValue,
       llvm::function_ref<bool(const TypeStorage *)> isEqual,
-      std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
+      llvm::function_ref<TypeStorage *(TypeStorageAllocator &)> constructorFn,
+      llvm::BumpPtrAllocator &arena) {
+    // Check the instances recently returned to this thread first.
+    TypeStorage *&recentType =
+        recentTypes.get()
+            .entries[hashValue & (RecentTypeCache::kNumEntries - 1)];
+    if (recentType && recentType->getKind() == kind && isEqual(recentType))
+      return recentType;
+
     TypeLookupKey lookupKey{kind, hashValue, isEqual};
+    auto &shard = storageTypes.getShard(hashValue);
 
     { // Check for an existing instance in read-only mode.
-      llvm::sys::SmartScopedReader<true> typeLock(typeMutex);
-      auto it = storageTypes.find_as(lookupKey);
-      if (it != storageTypes.end())
-        return it->storage;
+      llvm::sys::SmartScopedReader<true> typeLock(shard.mutex);
+      auto it = shard.container.find_as(lookupKey);
+      if (it != shard.container.end())
+        return recentType = it->storage;
     }
 
-    // Aquire a writer-lock so that we can safely create the new type instance.
-    llvm::sys::SmartScopedWriter<true> typeLock(typeMutex);
-
-    // Check for an existing instance again here, because another writer thread
-    // may have already created one.
-    auto existing = storageTypes.insert_as({}, lookupKey);
-    if (!existing.second)
-      return existing.first->storage;
-
     // Otherwise, construct and initialize the derived storage for this type
-    // instance.
-    TypeStorage *storage = constructorFn(allocator);
-    *existing.first = HashedStorageType{hashValue, storage};
-    return storage;
+    // instance before aquiring the writer-lock.
+    TypeStorageAllocator allocator(arena);
+    HashedStorageType newType{hashValue, constructorFn(allocator)};
+
+    // Aquire a writer-lock so that we can safely insert the new type instance.
+    // Another writer thread may have already inserted one, in which case the
+    // new instance is discarded.
+    llvm::sys::SmartScopedWriter<true> typeLock(shard.mutex);
+    return recentType =
+               shard.container.insert_as(newType, lookupKey).first->storage;
   }
 
   /// Get or create an instance of a simple derived type.
   TypeStorage *getOrCreate(
       unsigned kind,
-      std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
-    return safeGetOrCreate(simpleTypes, kind, typeMutex,
-                           [&] { return constructorFn(allocator); });
+      llvm::function_ref<TypeStorage *(TypeStorageAllocator &)> constructorFn,
+      llvm::BumpPtrAllocator &arena) {
+    return safeGetOrCreate(simpleTypes, kind, typeMutex, [&] {
+      TypeStorageAllocator allocator(arena);
+      return constructorFn(allocator);
+    });
   }
 
   //===--------------------------------------------------------------------===//
@@ -429,17 +594,28 @@ struct TypeUniquerImpl {
     }
   };
 
-  // Unique types with specific hashing or storage constraints.
+  // Unique types with specific hashing or storage constraints.  These are
+  // sharded by their hash value, each shard with its own lock.
   using StorageTypeSet = llvm::DenseSet<HashedStorageType, StorageKeyInfo>;
-  StorageTypeSet storageTypes;
+  ShardedUniquingTable<StorageTypeSet> storageTypes;
+
+  /// A small cache, owned by each thread, of the instances of complex types
+  /// last returned to that thread, indexed by their hash value.  Rewrites
+  /// tend to get the same few types over and over, e.g. the quantized types
+  /// of the values they rewrite, and a hit avoids locking a shard of
+  /// 'storageTypes'.  Uniqued instances are immutable and live as long as the
+  /// context or their storage scope, so the entries only need to be cleared
+  /// when a storage scope is popped.
+  struct RecentTypeCache {
+    enum { kNumEntries = 64 };
+    TypeStorage *entries[kNumEntries] = {};
+  };
+  ThreadLocalInstances<RecentTypeCache> recentTypes;
 
   // Unique types with just the kind.
   DenseMap<unsigned, TypeStorage *> simpleTypes;
 
-  // Allocator to use when constructing derived type instances.
-  TypeStorageAllocator allocator;
-
-  // A mutex to keep type uniquing thread-safe.
+  // A mutex to keep simple type uniquing thread-safe.
   llvm::sys::SmartRWMutex<true> typeMutex;
 };
 } // end anonymous namespace.
@@ -453,7 +629,7 @@ public:
   // Location uniquing
   //===--------------------------------------------------------------------===//
 
-  // Location allocator and mutex for thread safety.
+  // Location allocator, used for filenames, and mutex for thread safety.
   llvm::BumpPtrAllocator locationAllocator;
   llvm::sys::SmartRWMutex<true> locationMutex;
 
@@ -463,9 +639,10 @@ public:
   /// These are filename locations uniqued into this MLIRContext.
   llvm::StringMap<char, llvm::BumpPtrAllocator &> filenames;
 
-  /// FileLineColLoc uniquing.
-  DenseMap<std::tuple<const char *, unsigned, unsigned>,
-           FileLineColLocationStorage *>
+  /// FileLineColLoc uniquing.  This is sharded by the hash of the key, as these
+  /// are created at a high rate when parsing and transforming.
+  using FileLineColKey = std::tuple<const char *, unsigned, unsigned>;
+  ShardedUniquingTable<DenseMap<FileLineColKey, FileLineColLocationStorage *>>
       fileLineColLocs;
 
   /// NameLocation uniquing.
@@ -482,9 +659,20 @@ public:
   // Identifier uniquing
   //===--------------------------------------------------------------------===//
 
-  // Identifier allocator and mutex for thread safety.
-  llvm::BumpPtrAllocator identifierAllocator;
-  llvm::sys::SmartRWMutex<true> identifierMutex;
+  /// A shard of the identifier table, with its own allocator and mutex for
+  /// thread safety.
+  struct IdentifierShard {
+    IdentifierShard() : identifiers(allocator) {}
+
+    llvm::BumpPtrAllocator allocator;
+    llvm::StringMap<char, llvm::BumpPtrAllocator &> identifiers;
+    llvm::sys::SmartRWMutex<true> mutex;
+  };
+
+  /// These are identifiers uniqued into this MLIRContext, sharded by the hash
+  /// of the string.
+  enum { kLog2NumIdentifierShards = 4 };
+  IdentifierShard identifierShards[1 << kLog2NumIdentifierShards];
 
   //===--------------------------------------------------------------------===//
   // Other
@@ -502,6 +690,11 @@ public:
   /// The MLIRContext owns the objects.
   std::vector<std::unique_ptr<Dialect>> dialects;
 
+  /// A mutex serializing the construction of the registered dialects on their
+  /// first use, so that each is constructed once. It is recursive, since a
+  /// dialect may use another one while it is constructed.
+  llvm::sys::SmartMutex<true> dialectLoadingMutex;
+
   /// This is a mapping from operation name to AbstractOperation for registered
   /// operations.
   StringMap<AbstractOperation> registeredOperations;
@@ -509,29 +702,25 @@ public:
   /// This is a mapping from type identifier to Dialect for registered types.
   DenseMap<const TypeID *, Dialect *> registeredTypes;
 
-  /// These are identifiers uniqued into this MLIRContext.
-  llvm::StringMap<char, llvm::BumpPtrAllocator &> identifiers;
-
   //===--------------------------------------------------------------------===//
   // Affine uniquing
   //===--------------------------------------------------------------------===//
 
-  // Affine allocator and mutex for thread safety.
-  llvm::BumpPtrAllocator affineAllocator;
+  // Affine mutex for thread safety.
   llvm::sys::SmartRWMutex<true> affineMutex;
 
-  // Affine map uniquing.
+  // Affine map uniquing, sharded by the hash of the map.
   using AffineMapSet = DenseSet<AffineMap, AffineMapKeyInfo>;
-  AffineMapSet affineMaps;
+  ShardedUniquingTable<AffineMapSet> affineMaps;
 
   // Integer set uniquing.
   using IntegerSets = DenseSet<IntegerSet, IntegerSetKeyInfo>;
   IntegerSets integerSets;
 
-  // Affine binary op expression uniquing. Figure out uniquing of dimensional
-  // or symbolic identifiers.
-  DenseMap<std::tuple<unsigned, AffineExpr, AffineExpr>, AffineExpr>
-      affineExprs;
+  // Affine binary op expression uniquing, sharded by the hash of the
+  // expression. Figure out uniquing of dimensional or symbolic identifiers.
+  using AffineBinaryExprKey = std::tuple<unsigned, AffineExpr, AffineExpr>;
+  ShardedUniquingTable<DenseMap<AffineBinaryExprKey, AffineExpr>> affineExprs;
 
   // Uniqui'ing of AffineDimExpr, AffineSymbolExpr's by their position.
   std::vector<AffineDimExprStorage *> dimExprs;
@@ -540,6 +729,16 @@ public:
   // Uniqui'ing of AffineConstantExprStorage using constant value as key.
   DenseMap<int64_t, AffineConstantExprStorage *> constExprs;
 
+  // Memoized results of simplifyAffineExpr, AffineMap::compose,
+  // simplifyAffineMap and the simplifications of integer sets.  These only
+  // depend on uniqued inputs, so they stay valid as long as the context lives.
+  using SimplifiedAffineExprKey = std::tuple<AffineExpr, unsigned, unsigned>;
+  DenseMap<SimplifiedAffineExprKey, AffineExpr> simplifiedAffineExprs;
+  DenseMap<std::pair<AffineMap, AffineMap>, AffineMap> composedAffineMaps;
+  DenseMap<AffineMap, AffineMap> simplifiedAffineMaps;
+  DenseMap<IntegerSet, IntegerSet> simplifiedIntegerSets;
+  llvm::sys::SmartRWMutex<true> affineMemoMutex;
+
   //===--------------------------------------------------------------------===//
   // Type uniquing
   //===--------------------------------------------------------------------===//
@@ -549,8 +748,7 @@ public:
   // Attribute uniquing
   //===--------------------------------------------------------------------===//
 
-  // Attribute allocator and mutex for thread safety.
-  llvm::BumpPtrAllocator attributeAllocator;
+  // Attribute mutex for thread safety.
   llvm::sys::SmartRWMutex<true> attributeMutex;
 
   BoolAttributeStorage *boolAttrs[2] = {nullptr};
@@ -571,6 +769,15 @@ public:
   using DenseElementsAttrSet =
       DenseSet<DenseElementsAttributeStorage *, DenseElementsAttrInfo>;
   DenseElementsAttrSet denseElementsAttrs;
+  /// The dense elements attributes whose data is held outside of the context
+  /// are uniqued on its address and size rather than on its content.
+  DenseMap<std::tuple<Type, const char *, size_t>,
+           DenseElementsAttributeStorage *>
+      externalDenseElementsAttrs;
+  /// The files mapped in memory to hold the data of dense elements attributes,
+  /// keyed by their name.
+  StringMap<std::unique_ptr<llvm::MemoryBuffer>> mappedFiles;
+  llvm::sys::SmartRWMutex<true> mappedFilesMutex;
   using OpaqueElementsAttrSet =
       DenseSet<OpaqueElementsAttributeStorage *, OpaqueElementsAttrInfo>;
   OpaqueElementsAttrSet opaqueElementsAttrs;
@@ -578,19 +785,379 @@ public:
            SparseElementsAttributeStorage *>
       sparseElementsAttrs;
 
+  //===--------------------------------------------------------------------===//
+  // Storage allocation
+  //===--------------------------------------------------------------------===//
+
+  /// The allocators used for all uniqued storage, other than strings owned by
+  /// a StringMap.  Each thread allocates from its own arena so that new
+  /// instances can be constructed outside of the uniquing locks.
+  ThreadLocalAllocators threadLocalAllocators;
+
+  /// The allocators of each storage scope pushed on the context, innermost
+  /// last, and the allocators of the innermost scope, or null if no scope is
+  /// pushed.  See MLIRContext::pushStorageScope.
+  std::vector<std::unique_ptr<ThreadLocalAllocators>> storageScopes;
+  std::atomic<ThreadLocalAllocators *> innermostScopeAllocators{nullptr};
+
+  /// Return the allocator to use for new storage on the calling thread.
+  llvm::BumpPtrAllocator &getThreadLocalAllocator() {
+    if (auto *scopeAllocators = innermostScopeAllocators.load())
+      return scopeAllocators->get();
+    return threadLocalAllocators.get();
+  }
+
+  /// Whether the memory of the operations is pooled, and the pools of each
+  /// thread creating or destroying operations if so.
+  std::atomic<bool> operationPoolingEnabled{false};
+  ThreadLocalInstances<OperationPool> operationPools;
+
+  /// Whether the verifiers skip the expensive constraints.
+  std::atomic<bool> fastVerifierEnabled;
+
+  //===--------------------------------------------------------------------===//
+  // Threading
+  //===--------------------------------------------------------------------===//
+
+  /// The thread pool used for parallel work, and the size of that pool.  This
+  /// is lazily set to 'ownedThreadPool' if no external pool was provided.
+  llvm::ThreadPool *threadPool = nullptr;
+  unsigned threadPoolSize = 0;
+  std::unique_ptr<llvm::ThreadPool> ownedThreadPool;
+
+  /// The maximum number of threads used by a parallel region, or 0 if there
+  /// is no limit other than the size of the pool.
+  unsigned maxConcurrency;
+
+  /// A mutex guarding the threading state above.
+  llvm::sys::SmartMutex<true> threadingMutex;
+
 public:
   MLIRContextImpl()
-      : filenames(locationAllocator), identifiers(identifierAllocator) {}
+      : filenames(locationAllocator), fastVerifierEnabled(clFastVerify),
+        maxConcurrency(clMaxThreads) {}
 };
 } // end namespace mlir
 
 MLIRContext::MLIRContext() : impl(new MLIRContextImpl()) {
+  // The registered dialects are constructed on the first use of their
+  // namespace, see getRegisteredDialect.
   new BuiltinDialect(this);
-  registerAllDialects(this);
 }
 
 MLIRContext::~MLIRContext() {}
 
+/// Set the thread pool used by this context to run parallel work.
+void MLIRContext::setThreadPool(llvm::ThreadPool &pool, unsigned poolSize) {
+  assert(poolSize != 0 && "expected a non-empty thread pool");
+  llvm::sys::SmartScopedLock<true> lock(impl->threadingMutex);
+  impl->threadPool = &pool;
+  impl->threadPoolSize = poolSize;
+  impl->ownedThreadPool.reset();
+}
+
+/// Return the thread pool used by this context to run parallel work.
+llvm::ThreadPool &MLIRContext::getThreadPool() {
+  llvm::sys::SmartScopedLock<true> lock(impl->threadingMutex);
+  if (!impl->threadPool) {
+    unsigned poolSize = llvm::hardware_concurrency();
+    if (impl->maxConcurrency != 0)
+      poolSize = std::min(poolSize, impl->maxConcurrency);
+    impl->ownedThreadPool = llvm::make_unique<llvm::ThreadPool>(poolSize);
+    impl->threadPool = impl->ownedThreadPool.get();
+    impl->threadPoolSize = poolSize;
+  }
+  return *impl->threadPool;
+}
+
+/// Limit the number of threads that a single parallel region uses.
+void MLIRContext::setMaxConcurrency(unsigned maxConcurrency) {
+  llvm::sys::SmartScopedLock<true> lock(impl->threadingMutex);
+  impl->maxConcurrency = maxConcurrency;
+}
+
+/// Enable or disable the pooling of the memory of the operations.
+void MLIRContext::setOperationPoolingEnabled(bool enabled) {
+  impl->operationPoolingEnabled = enabled;
+}
+
+/// Return true if the memory of the operations is pooled.
+bool MLIRContext::isOperationPoolingEnabled() {
+  return impl->operationPoolingEnabled;
+}
+
+/// Enable or disable the skipping of the expensive constraints by verifiers.
+void MLIRContext::setFastVerifierEnabled(bool enabled) {
+  impl->fastVerifierEnabled = enabled;
+}
+
+/// Return true if the verifiers skip the expensive constraints.
+bool MLIRContext::isFastVerifierEnabled() {
+  return impl->fastVerifierEnabled;
+}
+
+namespace {
+/// The header preceding the memory of a pooled operation.  An operation may
+/// be destroyed by another thread than the one that created it, so this points
+/// to the pools of its context rather than to the pool it was allocated from.
+struct PooledOperationHeader {
+  ThreadLocalInstances<OperationPool> *pools;
+};
+} // end anonymous namespace
+
+/// Return memory for an operation of 'size' bytes created in 'context'.
+void *detail::allocateOperation(MLIRContext *context, size_t size,
+                                unsigned &sizeClass) {
+  auto &impl = context->getImpl();
+  size_t pooledSize = size + sizeof(PooledOperationHeader);
+  sizeClass = 0;
+  if (!impl.operationPoolingEnabled ||
+      pooledSize > kNumOperationSizeClasses * kOperationSizeGranularity)
+    return malloc(size);
+  sizeClass = llvm::alignTo(pooledSize, kOperationSizeGranularity) /
+              kOperationSizeGranularity;
+  auto &pools = impl.operationPools;
+  auto *header = new (pools.get().allocate(sizeClass))
+      PooledOperationHeader{&pools};
+  return header + 1;
+}
+
+/// Release the memory of an operation, given the size class returned by
+/// allocateOperation.  Pooled memory goes to the pool of the calling thread.
+void detail::deallocateOperation(void *mem, unsigned sizeClass) {
+  if (sizeClass == 0)
+    return free(mem);
+  auto *header = static_cast<PooledOperationHeader *>(mem) - 1;
+  header->pools->get().deallocate(header, sizeClass);
+}
+
+/// Return the number of instances uniqued in this context, and the number of
+/// bytes allocated to hold them.
+MLIRContext::StorageStatistics MLIRContext::getStorageStatistics() {
+  StorageStatistics stats;
+
+  {
+    auto &typeUniquer = impl->typeUniquer;
+    stats.numTypes = typeUniquer.storageTypes.size();
+    llvm::sys::SmartScopedReader<true> typeLock(typeUniquer.typeMutex);
+    stats.numTypes += typeUniquer.simpleTypes.size();
+  }
+
+  {
+    llvm::sys::SmartScopedReader<true> attributeLock(impl->attributeMutex);
+    stats.numAttributes =
+        llvm::count_if(impl->boolAttrs,
+                       [](BoolAttributeStorage *attr) { return attr; }) +
+        impl->integerAttrs.size() + impl->floatAttrs.size() +
+        impl->stringAttrs.size() + impl->arrayAttrs.size() +
+        impl->affineMapAttrs.size() + impl->integerSetAttrs.size() +
+        impl->typeAttrs.size() + impl->attributeLists.size() +
+        impl->functionAttrs.size() + impl->splatElementsAttrs.size() +
+        impl->denseElementsAttrs.size() +
+        impl->externalDenseElementsAttrs.size() +
+        impl->opaqueElementsAttrs.size() + impl->sparseElementsAttrs.size();
+  }
+
+  stats.numAffineMaps = impl->affineMaps.size();
+  stats.numAffineExprs = impl->affineExprs.size();
+  {
+    llvm::sys::SmartScopedReader<true> affineLock(impl->affineMutex);
+    stats.numIntegerSets = impl->integerSets.size();
+    stats.numAffineExprs += impl->dimExprs.size() + impl->symbolExprs.size() +
+                            impl->constExprs.size();
+  }
+
+  // The unknown location is not uniqued in a table, but is counted as well.
+  stats.numLocations = 1 + impl->fileLineColLocs.size();
+  {
+    llvm::sys::SmartScopedReader<true> locationLock(impl->locationMutex);
+    stats.numLocations += impl->nameLocs.size() + impl->callLocs.size() +
+                          impl->fusedLocs.size();
+    stats.allocatedBytes += impl->locationAllocator.getBytesAllocated();
+  }
+
+  for (auto &shard : impl->identifierShards) {
+    llvm::sys::SmartScopedReader<true> identifierLock(shard.mutex);
+    stats.numIdentifiers += shard.identifiers.size();
+    stats.allocatedBytes += shard.allocator.getBytesAllocated();
+  }
+
+  auto addAllocatedBytes = [&](llvm::BumpPtrAllocator &allocator) {
+    stats.allocatedBytes += allocator.getBytesAllocated();
+  };
+  impl->threadLocalAllocators.forEach(addAllocatedBytes);
+  for (auto &scopeAllocators : impl->storageScopes)
+    scopeAllocators->forEach(addAllocatedBytes);
+  impl->operationPools.forEach([&](OperationPool &pool) {
+    stats.pooledOperationBytes += pool.getBytesAllocated();
+  });
+  return stats;
+}
+
+//===----------------------------------------------------------------------===//
+// Storage scopes
+//===----------------------------------------------------------------------===//
+
+/// Open a new scope for the storage uniqued in this context.
+void MLIRContext::pushStorageScope() {
+  impl->storageScopes.push_back(llvm::make_unique<ThreadLocalAllocators>());
+  impl->innermostScopeAllocators = impl->storageScopes.back().get();
+}
+
+// Return the pointer identifying the storage of a uniqued instance.
+static const void *getStorage(const void *storage) { return storage; }
+static const void *getStorage(AffineExpr expr) {
+  return expr.getAsOpaquePointer();
+}
+static const void *getStorage(AffineMap map) {
+  return map.getAsOpaquePointer();
+}
+static const void *getStorage(IntegerSet set) {
+  return set.getAsOpaquePointer();
+}
+static const void *
+getStorage(const TypeUniquerImpl::HashedStorageType &hashedType) {
+  return hashedType.storage;
+}
+
+// Erase the elements of the uniquing set `set` whose storage satisfies
+// `isScoped`.
+template <typename SetT, typename PredT>
+static void eraseScopedElements(SetT &set, PredT &isScoped) {
+  for (auto it = set.begin(), e = set.end(); it != e;) {
+    auto current = it++;
+    if (isScoped(getStorage(*current)))
+      set.erase(current);
+  }
+}
+
+// Erase the entries of the uniquing map `map`, a DenseMap or a StringMap,
+// whose uniqued instance satisfies `isScoped`.
+template <typename MapT, typename PredT>
+static void eraseScopedValues(MapT &map, PredT &isScoped) {
+  for (auto it = map.begin(), e = map.end(); it != e;) {
+    auto current = it++;
+    if (isScoped(getStorage(current->second)))
+      map.erase(current);
+  }
+}
+
+// Reset the entries of `instances`, indexed by an integer key, whose storage
+// satisfies `isScoped`.
+template <typename StorageT, typename PredT>
+static void resetScopedInstances(MutableArrayRef<StorageT *> instances,
+                                 PredT &isScoped) {
+  for (auto *&instance : instances)
+    if (instance && isScoped(instance))
+      instance = nullptr;
+}
+
+/// Release all the instances uniqued since the matching 'pushStorageScope'.
+void MLIRContext::popStorageScope() {
+  auto &impl = getImpl();
+  assert(!impl.storageScopes.empty() && "no storage scope to pop");
+  std::unique_ptr<ThreadLocalAllocators> scopeAllocators =
+      std::move(impl.storageScopes.back());
+  impl.storageScopes.pop_back();
+  impl.innermostScopeAllocators =
+      impl.storageScopes.empty() ? nullptr : impl.storageScopes.back().get();
+
+  // All the instances uniqued within the scope were allocated by the
+  // allocators of the scope: erase them from the uniquing tables before the
+  // allocators release their memory.
+  SmallVector<llvm::BumpPtrAllocator *, 4> allocators;
+  scopeAllocators->forEach([&](llvm::BumpPtrAllocator &allocator) {
+    allocators.push_back(&allocator);
+  });
+  auto isScoped = [&](const void *storage) {
+    return llvm::any_of(allocators, [&](llvm::BumpPtrAllocator *allocator) {
+      return allocator->identifyObject(storage).hasValue();
+    });
+  };
+
+  // Locations.
+  for (auto &shard : impl.fileLineColLocs.shards) {
+    llvm::sys::SmartScopedWriter<true> lock(shard.mutex);
+    eraseScopedValues(shard.container, isScoped);
+  }
+  {
+    llvm::sys::SmartScopedWriter<true> locationLock(impl.locationMutex);
+    eraseScopedValues(impl.nameLocs, isScoped);
+    eraseScopedElements(impl.callLocs, isScoped);
+    eraseScopedElements(impl.fusedLocs, isScoped);
+  }
+
+  // Affine constructs.  The memoized results of the affine utilities may
+  // refer to the released instances through their keys or their values, and
+  // are simply recomputed on demand.
+  for (auto &shard : impl.affineMaps.shards) {
+    llvm::sys::SmartScopedWriter<true> lock(shard.mutex);
+    eraseScopedElements(shard.container, isScoped);
+  }
+  for (auto &shard : impl.affineExprs.shards) {
+    llvm::sys::SmartScopedWriter<true> lock(shard.mutex);
+    eraseScopedValues(shard.container, isScoped);
+  }
+  {
+    llvm::sys::SmartScopedWriter<true> affineLock(impl.affineMutex);
+    eraseScopedElements(impl.integerSets, isScoped);
+    resetScopedInstances<AffineDimExprStorage>(impl.dimExprs, isScoped);
+    resetScopedInstances<AffineSymbolExprStorage>(impl.symbolExprs, isScoped);
+    eraseScopedValues(impl.constExprs, isScoped);
+  }
+  {
+    llvm::sys::SmartScopedWriter<true> memoLock(impl.affineMemoMutex);
+    impl.simplifiedAffineExprs.clear();
+    impl.composedAffineMaps.clear();
+    impl.simplifiedAffineMaps.clear();
+    impl.simplifiedIntegerSets.clear();
+  }
+
+  // Types.
+  auto &typeUniquer = impl.typeUniquer;
+  for (auto &shard : typeUniquer.storageTypes.shards) {
+    llvm::sys::SmartScopedWriter<true> lock(shard.mutex);
+    eraseScopedElements(shard.container, isScoped);
+  }
+  typeUniquer.recentTypes.forEach([](TypeUniquerImpl::RecentTypeCache &cache) {
+    std::fill(std::begin(cache.entries), std::end(cache.entries), nullptr);
+  });
+  {
+    llvm::sys::SmartScopedWriter<true> typeLock(typeUniquer.typeMutex);
+    eraseScopedValues(typeUniquer.simpleTypes, isScoped);
+  }
+
+  // Attributes.
+  {
+    llvm::sys::SmartScopedWriter<true> attributeLock(impl.attributeMutex);
+    resetScopedInstances<BoolAttributeStorage>(impl.boolAttrs, isScoped);
+    eraseScopedElements(impl.integerAttrs, isScoped);
+    eraseScopedElements(impl.floatAttrs, isScoped);
+    eraseScopedValues(impl.stringAttrs, isScoped);
+    eraseScopedElements(impl.arrayAttrs, isScoped);
+    eraseScopedValues(impl.affineMapAttrs, isScoped);
+    eraseScopedValues(impl.integerSetAttrs, isScoped);
+    eraseScopedValues(impl.typeAttrs, isScoped);
+    eraseScopedElements(impl.attributeLists, isScoped);
+    eraseScopedValues(impl.functionAttrs, isScoped);
+    eraseScopedValues(impl.splatElementsAttrs, isScoped);
+    eraseScopedElements(impl.denseElementsAttrs, isScoped);
+    eraseScopedValues(impl.externalDenseElementsAttrs, isScoped);
+    eraseScopedElements(impl.opaqueElementsAttrs, isScoped);
+    eraseScopedValues(impl.sparseElementsAttrs, isScoped);
+  }
+}
+
+/// Return the number of threads that a single parallel region may use.
+unsigned MLIRContext::getMaxConcurrency() {
+  llvm::sys::SmartScopedLock<true> lock(impl->threadingMutex);
+  unsigned poolSize =
+      impl->threadPool ? impl->threadPoolSize : llvm::hardware_concurrency();
+  if (impl->maxConcurrency != 0)
+    poolSize = std::min(poolSize, impl->maxConcurrency);
+  return std::max(poolSize, 1u);
+}
+
 /// Copy the specified array of elements into memory managed by the provided
 /// bump pointer allocator.  This assumes the elements are all PODs.
 template <typename T>
@@ -676,6 +1243,12 @@ bool MLIRContext::emitError(Location location, const llvm::Twine &message) {
 
 /// Return information about all registered IR dialects.
 std::vector<Dialect *> MLIRContext::getRegisteredDialects() {
+  registerAllDialects(this);
+  return getLoadedDialects();
+}
+
+/// Return the dialects constructed in this context so far.
+std::vector<Dialect *> MLIRContext::getLoadedDialects() {
   // Lock access to the context registry.
   llvm::sys::SmartScopedReader<true> registryLock(getImpl().contextMutex);
 
@@ -686,17 +1259,33 @@ std::vector<Dialect *> MLIRContext::getRegisteredDialects() {
   return result;
 }
 
-/// Get a registered IR dialect with the given namespace. If none is found,
-/// then return nullptr.
-Dialect *MLIRContext::getRegisteredDialect(StringRef name) {
+// Return the dialect with namespace `name` if it was constructed in the
+// context, or nullptr.
+static Dialect *lookupLoadedDialect(MLIRContextImpl &impl, StringRef name) {
   // Lock access to the context registry.
-  llvm::sys::SmartScopedReader<true> registryLock(getImpl().contextMutex);
-  for (auto &dialect : getImpl().dialects)
+  llvm::sys::SmartScopedReader<true> registryLock(impl.contextMutex);
+  for (auto &dialect : impl.dialects)
     if (name == dialect->getNamespace())
       return dialect.get();
   return nullptr;
 }
 
+/// Get a registered IR dialect with the given namespace, constructing it on
+/// its first use. If none is found, then return nullptr.
+Dialect *MLIRContext::getRegisteredDialect(StringRef name) {
+  auto &impl = getImpl();
+  if (auto *dialect = lookupLoadedDialect(impl, name))
+    return dialect;
+
+  // Construct the dialect, unless another thread did it in the meantime. The
+  // registry lock cannot be held here, as the dialect registers its operations
+  // and types while it is constructed.
+  llvm::sys::SmartScopedLock<true> loadingLock(impl.dialectLoadingMutex);
+  if (auto *dialect = lookupLoadedDialect(impl, name))
+    return dialect;
+  return detail::constructRegisteredDialect(this, name);
+}
+
 /// Register this dialect object with the specified context.  The context
 /// takes ownership of the heap allocated dialect.
 void Dialect::registerDialect(MLIRContext *context) {
@@ -768,12 +1357,10 @@ void Dialect::addType(const TypeID *const typeID) {
   }
 }
 
-/// Look up the specified operation in the operation set and return a pointer
-/// to it if present.  Otherwise, return a null pointer.
-const AbstractOperation *AbstractOperation::lookup(StringRef opName,
-                                                   MLIRContext *context) {
-  auto &impl = context->getImpl();
-
+// Look up the operation named `opName` among the ones registered by the
+// dialects constructed in the context.
+static const AbstractOperation *
+lookupRegisteredOperation(MLIRContextImpl &impl, StringRef opName) {
   // Lock access to the context registry.
   llvm::sys::SmartScopedReader<true> registryLock(impl.contextMutex);
   auto it = impl.registeredOperations.find(opName);
@@ -782,6 +1369,24 @@ const AbstractOperation *AbstractOperation::lookup(StringRef opName,
   return nullptr;
 }
 
+/// Look up the specified operation in the operation set and return a pointer
+/// to it if present.  Otherwise, return a null pointer.
+const AbstractOperation *AbstractOperation::lookup(StringRef opName,
+                                                   MLIRContext *context) {
+  auto &impl = context->getImpl();
+  if (auto *opInfo = lookupRegisteredOperation(impl, opName))
+    return opInfo;
+
+  // The operation may belong to a registered dialect that was not used in
+  // this context yet: construct it and look again.
+  auto dialectName = opName.split('.').first;
+  if (dialectName.size() == opName.size() ||
+      lookupLoadedDialect(impl, dialectName) ||
+      !context->getRegisteredDialect(dialectName))
+    return nullptr;
+  return lookupRegisteredOperation(impl, opName);
+}
+
 //===----------------------------------------------------------------------===//
 // Identifier uniquing
 //===----------------------------------------------------------------------===//
@@ -794,16 +1399,23 @@ Identifier Identifier::get(StringRef str, MLIRContext *context) {
 
   auto &impl = context->getImpl();
 
+  // Select the shard for this identifier.  The hash used here is different
+  // from the one used internally by StringMap, so the strings within a shard
+  // are still evenly distributed.
+  unsigned hashValue = llvm::hash_value(str);
+  auto &shard = impl.identifierShards[(hashValue * 0x9E3779B9u) >>
+                                      (32 - impl.kLog2NumIdentifierShards)];
+
   { // Check for an existing identifier in read-only mode.
-    llvm::sys::SmartScopedReader<true> contextLock(impl.identifierMutex);
-    auto it = impl.identifiers.find(str);
-    if (it != impl.identifiers.end())
+    llvm::sys::SmartScopedReader<true> contextLock(shard.mutex);
+    auto it = shard.identifiers.find(str);
+    if (it != shard.identifiers.end())
       return Identifier(it->getKeyData());
   }
 
   // Aquire a writer-lock so that we can safely create the new instance.
-  llvm::sys::SmartScopedWriter<true> contextLock(impl.identifierMutex);
-  auto it = impl.identifiers.insert({str, char()}).first;
+  llvm::sys::SmartScopedWriter<true> contextLock(shard.mutex);
+  auto it = shard.identifiers.insert({str, char()}).first;
   return Identifier(it->getKeyData());
 }
 
@@ -830,8 +1442,11 @@ FileLineColLoc FileLineColLoc::get(UniquedFilename filename, unsigned line,
 
   // Safely get or create a location instance.
   auto key = std::make_tuple(filename.data(), line, column);
-  return safeGetOrCreate(impl.fileLineColLocs, key, impl.locationMutex, [&] {
-    return new (impl.locationAllocator.Allocate<FileLineColLocationStorage>())
+  auto &shard = impl.fileLineColLocs.getShard(
+      DenseMapInfo<MLIRContextImpl::FileLineColKey>::getHashValue(key));
+  return safeGetOrCreate(shard.container, key, shard.mutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
+    return new (allocator.Allocate<FileLineColLocationStorage>())
         FileLineColLocationStorage(filename, line, column);
   });
 }
@@ -841,7 +1456,8 @@ NameLoc NameLoc::get(Identifier name, MLIRContext *context) {
 
   // Safely get or create a location instance.
   return safeGetOrCreate(impl.nameLocs, name.data(), impl.locationMutex, [&] {
-    return new (impl.locationAllocator.Allocate<NameLocationStorage>())
+    auto &allocator = impl.getThreadLocalAllocator();
+    return new (allocator.Allocate<NameLocationStorage>())
         NameLocationStorage(name);
   });
 }
@@ -853,7 +1469,8 @@ CallSiteLoc CallSiteLoc::get(Location callee, Location caller,
   // Safely get or create a location instance.
   auto key = std::make_pair(callee, caller);
   return safeGetOrCreate(impl.callLocs, key, impl.locationMutex, [&] {
-    return new (impl.locationAllocator.Allocate<CallSiteLocationStorage>())
+    auto &allocator = impl.getThreadLocalAllocator();
+    return new (allocator.Allocate<CallSiteLocationStorage>())
         CallSiteLocationStorage(callee, caller);
   });
 }
@@ -906,10 +1523,10 @@ Location FusedLoc::get(ArrayRef<Location> locs, Attribute metadata,
   // Safely get or create a location instance.
   auto key = std::make_pair(locs, metadata);
   return safeGetOrCreate(impl.fusedLocs, key, impl.locationMutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
     auto byteSize =
         FusedLocationStorage::totalSizeToAlloc<Location>(locs.size());
-    auto rawMem = impl.locationAllocator.Allocate(
-        byteSize, alignof(FusedLocationStorage));
+    auto rawMem = allocator.Allocate(byteSize, alignof(FusedLocationStorage));
     auto result = new (rawMem) FusedLocationStorage(locs.size(), metadata);
 
     std::uninitialized_copy(locs.begin(), locs.end(),
@@ -927,26 +1544,41 @@ Location FusedLoc::get(ArrayRef<Location> locs, Attribute metadata,
 TypeStorage *TypeUniquer::getImpl(
     MLIRContext *ctx, unsigned kind, unsigned hashValue,
     llvm::function_ref<bool(const TypeStorage *)> isEqual,
-    std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
-  return ctx->getImpl().typeUniquer.getOrCreate(kind, hashValue, isEqual,
-                                                constructorFn);
+    llvm::function_ref<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
+  auto &impl = ctx->getImpl();
+  return impl.typeUniquer.getOrCreate(kind, hashValue, isEqual, constructorFn,
+                                      impl.getThreadLocalAllocator());
 }
 
 /// Implementation for getting/creating an instance of a derived type with
 /// default storage.
 TypeStorage *TypeUniquer::getImpl(
     MLIRContext *ctx, unsigned kind,
-    std::function<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
-  return ctx->getImpl().typeUniquer.getOrCreate(kind, constructorFn);
+    llvm::function_ref<TypeStorage *(TypeStorageAllocator &)> constructorFn) {
+  auto &impl = ctx->getImpl();
+  return impl.typeUniquer.getOrCreate(kind, constructorFn,
+                                      impl.getThreadLocalAllocator());
 }
 
 /// Get the dialect that registered the type with the provided typeid.
 const Dialect &TypeUniquer::lookupDialectForType(MLIRContext *ctx,
                                                  const TypeID *const typeID) {
   auto &impl = ctx->getImpl();
-  auto it = impl.registeredTypes.find(typeID);
-  assert(it != impl.registeredTypes.end() && "typeID is not registered.");
-  return *it->second;
+  auto lookup = [&]() -> Dialect * {
+    // Lock access to the context registry.
+    llvm::sys::SmartScopedReader<true> registryLock(impl.contextMutex);
+    auto it = impl.registeredTypes.find(typeID);
+    return it == impl.registeredTypes.end() ? nullptr : it->second;
+  };
+  if (auto *dialect = lookup())
+    return *dialect;
+
+  // The type may be created before its dialect is used in the context. The
+  // dialect registering it is then unknown, construct them all.
+  registerAllDialects(ctx);
+  auto *dialect = lookup();
+  assert(dialect && "typeID is not registered.");
+  return *dialect;
 }
 
 //===----------------------------------------------------------------------===//
@@ -962,18 +1594,20 @@ BoolAttr BoolAttr::get(bool value, MLIRContext *context) {
       return result;
   }
 
-  // Aquire the mutex in write mode so that we can safely construct the new
+  // Construct the new instance before aquiring the mutex.
+  auto &allocator = impl.getThreadLocalAllocator();
+  auto *newAttr = new (allocator.Allocate<BoolAttributeStorage>())
+      BoolAttributeStorage(IntegerType::get(1, context), value);
+
+  // Aquire the mutex in write mode so that we can safely insert the new
   // instance.
   llvm::sys::SmartScopedWriter<true> attributeLock(impl.attributeMutex);
 
   // Check for an existing instance again here, because another writer thread
   // may have already created one.
   auto *&result = impl.boolAttrs[value];
-  if (result)
-    return result;
-
-  result = impl.attributeAllocator.Allocate<BoolAttributeStorage>();
-  new (result) BoolAttributeStorage(IntegerType::get(1, context), value);
+  if (!result)
+    result = newAttr;
   return result;
 }
 
@@ -983,11 +1617,12 @@ IntegerAttr IntegerAttr::get(Type type, const APInt &value) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.integerAttrs, key, impl.attributeMutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
     auto elements = ArrayRef<uint64_t>(value.getRawData(), value.getNumWords());
 
     auto byteSize =
         IntegerAttributeStorage::totalSizeToAlloc<uint64_t>(elements.size());
-    auto rawMem = impl.attributeAllocator.Allocate(
+    auto rawMem = allocator.Allocate(
         byteSize, alignof(IntegerAttributeStorage));
     auto result = ::new (rawMem) IntegerAttributeStorage(type, elements.size());
     std::uninitialized_copy(elements.begin(), elements.end(),
@@ -1047,14 +1682,14 @@ FloatAttr FloatAttr::get(Type type, const APFloat &value) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.floatAttrs, key, impl.attributeMutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
     const auto &apint = value.bitcastToAPInt();
     // Here one word's bitwidth equals to that of uint64_t.
     auto elements = ArrayRef<uint64_t>(apint.getRawData(), apint.getNumWords());
 
     auto byteSize =
         FloatAttributeStorage::totalSizeToAlloc<uint64_t>(elements.size());
-    auto rawMem = impl.attributeAllocator.Allocate(
-        byteSize, alignof(FloatAttributeStorage));
+    auto rawMem = allocator.Allocate(byteSize, alignof(FloatAttributeStorage));
     auto result = ::new (rawMem)
         FloatAttributeStorage(value.getSemantics(), type, elements.size());
     std::uninitialized_copy(elements.begin(), elements.end(),
@@ -1083,7 +1718,10 @@ StringAttr StringAttr::get(StringRef bytes, MLIRContext *context) {
   if (it->second)
     return it->second;
 
-  auto result = new (impl.attributeAllocator.Allocate<StringAttributeStorage>())
+  // The storage refers to the string owned by the map, so it is constructed
+  // under the lock.
+  auto &allocator = impl.getThreadLocalAllocator();
+  auto result = new (allocator.Allocate<StringAttributeStorage>())
       StringAttributeStorage(it->first());
   return it->second = result;
 }
@@ -1093,10 +1731,11 @@ ArrayAttr ArrayAttr::get(ArrayRef<Attribute> value, MLIRContext *context) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.arrayAttrs, value, impl.attributeMutex, [&] {
-    auto *result = impl.attributeAllocator.Allocate<ArrayAttributeStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto *result = allocator.Allocate<ArrayAttributeStorage>();
 
     // Copy the elements into the bump pointer.
-    value = copyArrayRefInto(impl.attributeAllocator, value);
+    value = copyArrayRefInto(allocator, value);
 
     // Check to see if any of the elements have a function attr.
     bool hasFunctionAttr = false;
@@ -1117,7 +1756,8 @@ AffineMapAttr AffineMapAttr::get(AffineMap value) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.affineMapAttrs, value, impl.attributeMutex, [&] {
-    auto result = impl.attributeAllocator.Allocate<AffineMapAttributeStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto result = allocator.Allocate<AffineMapAttributeStorage>();
     return new (result) AffineMapAttributeStorage(value);
   });
 }
@@ -1128,8 +1768,8 @@ IntegerSetAttr IntegerSetAttr::get(IntegerSet value) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.integerSetAttrs, value, impl.attributeMutex, [&] {
-    auto result =
-        impl.attributeAllocator.Allocate<IntegerSetAttributeStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto result = allocator.Allocate<IntegerSetAttributeStorage>();
     return new (result) IntegerSetAttributeStorage(value);
   });
 }
@@ -1139,7 +1779,8 @@ TypeAttr TypeAttr::get(Type type, MLIRContext *context) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.typeAttrs, type, impl.attributeMutex, [&] {
-    auto result = impl.attributeAllocator.Allocate<TypeAttributeStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto result = allocator.Allocate<TypeAttributeStorage>();
     return new (result) TypeAttributeStorage(type);
   });
 }
@@ -1150,7 +1791,8 @@ FunctionAttr FunctionAttr::get(Function *value, MLIRContext *context) {
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.functionAttrs, value, impl.attributeMutex, [&] {
-    auto result = impl.attributeAllocator.Allocate<FunctionAttributeStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto result = allocator.Allocate<FunctionAttributeStorage>();
     return new (result) FunctionAttributeStorage(value);
   });
 }
@@ -1232,10 +1874,10 @@ AttributeListStorage *AttributeListStorage::get(ArrayRef<NamedAttribute> attrs,
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(impl.attributeLists, attrs, impl.attributeMutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
     auto byteSize =
         AttributeListStorage::totalSizeToAlloc<NamedAttribute>(attrs.size());
-    auto rawMem =
-        impl.attributeAllocator.Allocate(byteSize, alignof(NamedAttribute));
+    auto rawMem = allocator.Allocate(byteSize, alignof(NamedAttribute));
 
     //  Placement initialize the AggregateSymbolicValue.
     auto result = ::new (rawMem) AttributeListStorage(attrs.size());
@@ -1273,39 +1915,77 @@ SplatElementsAttr SplatElementsAttr::get(VectorOrTensorType type,
   std::pair<Type, Attribute> key(type, elt);
   return safeGetOrCreate(
       impl.splatElementsAttrs, key, impl.attributeMutex, [&] {
-        auto result =
-            impl.attributeAllocator.Allocate<SplatElementsAttributeStorage>();
+        auto &allocator = impl.getThreadLocalAllocator();
+        auto result = allocator.Allocate<SplatElementsAttributeStorage>();
         return new (result) SplatElementsAttributeStorage(type, elt);
       });
 }
 
-DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType type,
-                                         ArrayRef<char> data) {
-  auto bitsRequired = type.getSizeInBits();
-  (void)bitsRequired;
-  assert((bitsRequired <= data.size() * APInt::APINT_WORD_SIZE) &&
-         "Input data bit size should be larger than that type requires");
+/// Returns the kind of the dense elements attributes of type 'type'.
+static Attribute::Kind getDenseElementsAttrKind(VectorOrTensorType type) {
+  switch (type.getElementType().getKind()) {
+  case StandardTypes::BF16:
+  case StandardTypes::F16:
+  case StandardTypes::F32:
+  case StandardTypes::F64:
+    return Attribute::Kind::DenseFPElements;
+  case StandardTypes::Integer:
+    return Attribute::Kind::DenseIntElements;
+  default:
+    llvm_unreachable("unexpected element type");
+  }
+}
+
+/// Returns the number of bits each element of 'type' occupies in the raw data
+/// of a dense elements attribute.
+static size_t getDenseElementBitWidth(VectorOrTensorType type) {
+  // FIXME(b/121118307): using 64 bits for BF16 because it is currently stored
+  // with double semantics.
+  auto elementType = type.getElementType();
+  return elementType.isBF16() ? 64 : elementType.getIntOrFloatBitWidth();
+}
+
+/// Returns true if the 'numElements' elements of 'bitWidth' bits held in
+/// 'data' are all equal.
+static bool isSplatData(ArrayRef<char> data, size_t bitWidth,
+                        size_t numElements) {
+  if (numElements < 2)
+    return false;
+
+  // Byte aligned elements are compared as a whole.
+  if (bitWidth % CHAR_BIT == 0) {
+    size_t elementSize = bitWidth / CHAR_BIT;
+    for (size_t i = 1; i != numElements; ++i)
+      if (std::memcmp(data.data(), data.data() + i * elementSize, elementSize))
+        return false;
+    return true;
+  }
+
+  // Otherwise, compare the bits of each element with those of the first one.
+  auto getBit = [&](size_t bitPos) {
+    return (static_cast<unsigned char>(data[bitPos / CHAR_BIT]) >>
+            (bitPos % CHAR_BIT)) &
+           1;
+  };
+  for (size_t i = 1; i != numElements; ++i)
+    for (size_t bit = 0; bit != bitWidth; ++bit)
+      if (getBit(bit) != getBit(i * bitWidth + bit))
+        return false;
+  return true;
+}
 
+/// Gets or creates the dense elements attribute of type 'type' holding 'data'
+/// in the context, which only is its first element if 'isSplat' is set.
+static DenseElementsAttr getUniquedDenseElementsAttr(VectorOrTensorType type,
+                                                     ArrayRef<char> data,
+                                                     bool isSplat) {
   auto &impl = type.getContext()->getImpl();
-  DenseElementsAttrInfo::KeyTy key({type, data});
+  DenseElementsAttrInfo::KeyTy key(type, data, isSplat);
 
   // Safely get or create an attribute instance.
   return safeGetOrCreate(
       impl.denseElementsAttrs, key, impl.attributeMutex, [&] {
-        Attribute::Kind kind;
-        switch (type.getElementType().getKind()) {
-        case StandardTypes::BF16:
-        case StandardTypes::F16:
-        case StandardTypes::F32:
-        case StandardTypes::F64:
-          kind = Attribute::Kind::DenseFPElements;
-          break;
-        case StandardTypes::Integer:
-          kind = Attribute::Kind::DenseIntElements;
-          break;
-        default:
-          llvm_unreachable("unexpected element type");
-        }
+        auto &allocator = impl.getThreadLocalAllocator();
 
         // If the data buffer is non-empty, we copy it into the context.
         ArrayRef<char> copy;
@@ -1315,14 +1995,76 @@ DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType type,
           // APINT_WORD_SIZE each time.
           size_t sizeToAllocate =
               llvm::alignTo(data.size(), APInt::APINT_WORD_SIZE);
-          auto *rawCopy =
-              (char *)impl.attributeAllocator.Allocate(sizeToAllocate, 64);
+          auto *rawCopy = (char *)allocator.Allocate(sizeToAllocate, 64);
           std::uninitialized_copy(data.begin(), data.end(), rawCopy);
           copy = {rawCopy, data.size()};
         }
-        auto *result =
-            impl.attributeAllocator.Allocate<DenseElementsAttributeStorage>();
-        return new (result) DenseElementsAttributeStorage(kind, type, copy);
+        auto *result = allocator.Allocate<DenseElementsAttributeStorage>();
+        return new (result) DenseElementsAttributeStorage(
+            getDenseElementsAttrKind(type), type, copy, isSplat,
+            /*isExternal=*/false, key.hashValue);
+      });
+}
+
+DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType type,
+                                         ArrayRef<char> data) {
+  auto bitsRequired = type.getSizeInBits();
+  (void)bitsRequired;
+  assert((bitsRequired <= data.size() * APInt::APINT_WORD_SIZE) &&
+         "Input data bit size should be larger than that type requires");
+
+  // Only the first element of a splat is kept, so that it is neither stored
+  // nor hashed in full.
+  if (isSplatData(data, getDenseElementBitWidth(type), type.getNumElements()))
+    return getSplat(type, data);
+  return getUniquedDenseElementsAttr(type, data, /*isSplat=*/false);
+}
+
+DenseElementsAttr DenseElementsAttr::getSplat(VectorOrTensorType type,
+                                              ArrayRef<char> elementData) {
+  size_t bitWidth = getDenseElementBitWidth(type);
+  assert(bitWidth <= elementData.size() * CHAR_BIT &&
+         "Input data bit size should be larger than the element type requires");
+  auto numElements = type.getNumElements();
+  if (numElements == 0)
+    return getUniquedDenseElementsAttr(type, {}, /*isSplat=*/false);
+
+  // Keep the bits of the element only, padded to whole words like the data of
+  // the attributes constructed from element values, so that the splats of the
+  // same value are uniqued to the same attribute. A single element is not
+  // marked as a splat, as its data is then complete.
+  SmallVector<char, 8> data(elementData.begin(),
+                            elementData.begin() +
+                                llvm::alignTo(bitWidth, CHAR_BIT) / CHAR_BIT);
+  if (bitWidth % CHAR_BIT != 0)
+    data.back() &= (1 << (bitWidth % CHAR_BIT)) - 1;
+  data.resize(APInt::getNumWords(bitWidth) * APInt::APINT_WORD_SIZE, 0);
+  return getUniquedDenseElementsAttr(type, data,
+                                     /*isSplat=*/numElements > 1);
+}
+
+DenseElementsAttr DenseElementsAttr::getExternal(VectorOrTensorType type,
+                                                 ArrayRef<char> data) {
+  auto bitsRequired = type.getSizeInBits();
+  (void)bitsRequired;
+  assert((bitsRequired <= data.size() * APInt::APINT_WORD_SIZE) &&
+         "Input data bit size should be larger than that type requires");
+  assert(reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) == 0 &&
+         "expected 64-bit aligned external data");
+
+  auto &impl = type.getContext()->getImpl();
+  auto key = std::make_tuple(Type(type), data.data(), data.size());
+
+  // Safely get or create an attribute instance, referring to the data rather
+  // than copying it.
+  return safeGetOrCreate(
+      impl.externalDenseElementsAttrs, key, impl.attributeMutex, [&] {
+        auto &allocator = impl.getThreadLocalAllocator();
+        auto *result = allocator.Allocate<DenseElementsAttributeStorage>();
+        return new (result) DenseElementsAttributeStorage(
+            getDenseElementsAttrKind(type), type, data, /*isSplat=*/false,
+            /*isExternal=*/true,
+            hash_combine(type, data.data(), data.size()));
       });
 }
 
@@ -1367,6 +2109,85 @@ DenseElementsAttr DenseElementsAttr::get(VectorOrTensorType type,
   return get(type, data);
 }
 
+/// Returns the file 'filename' mapped in memory in the context, mapping it if
+/// it wasn't already. Returns null and sets 'error' if it can't be mapped.
+static const llvm::MemoryBuffer *getMappedFile(MLIRContextImpl &impl,
+                                               StringRef filename,
+                                               std::string &error) {
+  { // Check for an already mapped file in read-only mode.
+    llvm::sys::SmartScopedReader<true> fileLock(impl.mappedFilesMutex);
+    auto it = impl.mappedFiles.find(filename);
+    if (it != impl.mappedFiles.end())
+      return it->second.get();
+  }
+
+  // Map the file before aquiring the writer-lock, and keep the mapping another
+  // thread may have inserted in the meantime.
+  auto fileOrErr = llvm::MemoryBuffer::getFile(
+      filename, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  if (std::error_code errorCode = fileOrErr.getError()) {
+    error = errorCode.message();
+    return nullptr;
+  }
+  llvm::sys::SmartScopedWriter<true> fileLock(impl.mappedFilesMutex);
+  auto &file = impl.mappedFiles[filename];
+  if (!file)
+    file = std::move(*fileOrErr);
+  return file.get();
+}
+
+DenseElementsAttr DenseElementsAttr::getFromFile(VectorOrTensorType type,
+                                                 StringRef filename,
+                                                 uint64_t offset,
+                                                 Location location) {
+  auto *context = type.getContext();
+  std::string error;
+  auto *file = getMappedFile(context->getImpl(), filename, error);
+  if (!file) {
+    context->emitError(location,
+                       "cannot open file '" + filename + "': " + error);
+    return nullptr;
+  }
+
+  StringRef contents = file->getBuffer();
+  uint64_t dataSize =
+      llvm::alignTo(type.getNumElements() * getDenseElementBitWidth(type),
+                    CHAR_BIT) /
+      CHAR_BIT;
+  if (offset > contents.size() || contents.size() - offset < dataSize) {
+    context->emitError(location, "file '" + filename + "' holds fewer than " +
+                                     Twine(dataSize) + " bytes at offset " +
+                                     Twine(offset));
+    return nullptr;
+  }
+
+  // The data is only referred to in place if it may be read as whole words.
+  ArrayRef<char> data(contents.data() + offset, dataSize);
+  if (dataSize == 0 ||
+      reinterpret_cast<uintptr_t>(data.data()) % alignof(uint64_t) != 0 ||
+      contents.size() - offset <
+          llvm::alignTo(dataSize, APInt::APINT_WORD_SIZE))
+    return get(type, data);
+  return getExternal(type, data);
+}
+
+Optional<std::pair<StringRef, uint64_t>>
+DenseElementsAttr::getFileLocation() const {
+  if (!isExternal())
+    return llvm::None;
+
+  const char *data = getRawData().data();
+  auto &impl = getType().getContext()->getImpl();
+  llvm::sys::SmartScopedReader<true> fileLock(impl.mappedFilesMutex);
+  for (auto &file : impl.mappedFiles) {
+    StringRef contents = file.second->getBuffer();
+    if (data >= contents.begin() && data < contents.end())
+      return std::make_pair(file.first(),
+                            static_cast<uint64_t>(data - contents.begin()));
+  }
+  return llvm::None;
+}
+
 OpaqueElementsAttr OpaqueElementsAttr::get(Dialect *dialect,
                                            VectorOrTensorType type,
                                            StringRef bytes) {
@@ -1378,12 +2199,12 @@ OpaqueElementsAttr OpaqueElementsAttr::get(Dialect *dialect,
 
   return safeGetOrCreate(
       impl.opaqueElementsAttrs, key, impl.attributeMutex, [&] {
-        auto *result =
-            impl.attributeAllocator.Allocate<OpaqueElementsAttributeStorage>();
+        auto &allocator = impl.getThreadLocalAllocator();
+        auto *result = allocator.Allocate<OpaqueElementsAttributeStorage>();
 
         // TODO: Provide a way to avoid copying content of large opaque tensors
         // This will likely require a new reference attribute kind.
-        bytes = bytes.copy(impl.attributeAllocator);
+        bytes = bytes.copy(allocator);
         return new (result)
             OpaqueElementsAttributeStorage(type, dialect, bytes);
       });
@@ -1401,8 +2222,8 @@ SparseElementsAttr SparseElementsAttr::get(VectorOrTensorType type,
   // Safely get or create an attribute instance.
   return safeGetOrCreate(
       impl.sparseElementsAttrs, key, impl.attributeMutex, [&] {
-        return new (
-            impl.attributeAllocator.Allocate<SparseElementsAttributeStorage>())
+        auto &allocator = impl.getThreadLocalAllocator();
+        return new (allocator.Allocate<SparseElementsAttributeStorage>())
             SparseElementsAttributeStorage(type, indices, values);
       });
 }
@@ -1423,16 +2244,24 @@ AffineMap AffineMap::get(unsigned dimCount, unsigned symbolCount,
   auto key = std::make_tuple(dimCount, symbolCount, results, rangeSizes);
 
   // Safely get or create an AffineMap instance.
-  return safeGetOrCreate(impl.affineMaps, key, impl.affineMutex, [&] {
-    auto *res = impl.affineAllocator.Allocate<detail::AffineMapStorage>();
+  auto &shard = impl.affineMaps.getShard(AffineMapKeyInfo::getHashValue(key));
+  return safeGetOrCreate(shard.container, key, shard.mutex, [&] {
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto *res = allocator.Allocate<detail::AffineMapStorage>();
 
     // Copy the results and range sizes into the bump pointer.
-    results = copyArrayRefInto(impl.affineAllocator, results);
-    rangeSizes = copyArrayRefInto(impl.affineAllocator, rangeSizes);
+    results = copyArrayRefInto(allocator, results);
+    rangeSizes = copyArrayRefInto(allocator, rangeSizes);
+
+    // Flatten the results once, so that evaluating them doesn't walk them.
+    SmallVector<detail::AffineMapEvalInstr, 16> program;
+    unsigned stackSize =
+        detail::flattenAffineMapResults(results, dimCount, program);
+    auto evalProgram = copyArrayRefInto(allocator, llvm::makeArrayRef(program));
 
     // Initialize the memory using placement new.
-    new (res)
-        detail::AffineMapStorage{dimCount, symbolCount, results, rangeSizes};
+    new (res) detail::AffineMapStorage{dimCount,   symbolCount, results,
+                                       rangeSizes, evalProgram, stackSize};
     return AffineMap(res);
   });
 }
@@ -1640,11 +2469,14 @@ AffineExpr AffineBinaryOpExprStorage::get(AffineExprKind kind, AffineExpr lhs,
 
   // Check if we already have this affine expression, and return it if we do.
   auto keyValue = std::make_tuple((unsigned)kind, lhs, rhs);
+  auto &shard = impl.affineExprs.getShard(
+      DenseMapInfo<MLIRContextImpl::AffineBinaryExprKey>::getHashValue(
+          keyValue));
 
   { // Check for an existing instance in read-only mode.
-    llvm::sys::SmartScopedReader<true> affineLock(impl.affineMutex);
-    auto cached = impl.affineExprs.find(keyValue);
-    if (cached != impl.affineExprs.end())
+    llvm::sys::SmartScopedReader<true> affineLock(shard.mutex);
+    auto cached = shard.container.find(keyValue);
+    if (cached != shard.container.end())
       return cached->second;
   }
 
@@ -1674,19 +2506,49 @@ AffineExpr AffineBinaryOpExprStorage::get(AffineExprKind kind, AffineExpr lhs,
   if (simplified)
     return simplified;
 
-  // Aquire a writer-lock so that we can safely create the new instance.
-  llvm::sys::SmartScopedWriter<true> affineLock(impl.affineMutex);
+  // An expression with these operands will already be in the
+  // simplified/canonical form. Create it before aquiring the writer-lock.
+  auto &allocator = impl.getThreadLocalAllocator();
+  AffineExpr newExpr = new (allocator.Allocate<AffineBinaryOpExprStorage>())
+      AffineBinaryOpExprStorage{{kind, lhs.getContext()}, lhs, rhs};
+
+  // Aquire a writer-lock so that we can safely store the new instance. This
+  // returns the existing instance if another writer thread has already
+  // created one.
+  llvm::sys::SmartScopedWriter<true> affineLock(shard.mutex);
+  return shard.container.try_emplace(keyValue, newExpr).first->second;
+}
 
-  // Check for an existing instance again here, because another writer thread
-  // may have already created one.
-  auto &result = impl.affineExprs.insert({keyValue, nullptr}).first->second;
-  if (!result) {
-    // An expression with these operands will already be in the
-    // simplified/canonical form. Create and store it.
-    result = new (impl.affineAllocator.Allocate<AffineBinaryOpExprStorage>())
-        AffineBinaryOpExprStorage{{kind, lhs.getContext()}, lhs, rhs};
-  }
-  return result;
+AffineExpr detail::getMemoizedSimplifiedExpr(
+    AffineExpr expr, unsigned numDims, unsigned numSymbols,
+    llvm::function_ref<AffineExpr()> simplifyFn) {
+  auto &impl = expr.getContext()->getImpl();
+  return safeGetOrCreate(impl.simplifiedAffineExprs,
+                         std::make_tuple(expr, numDims, numSymbols),
+                         impl.affineMemoMutex, simplifyFn);
+}
+
+AffineMap detail::getMemoizedComposedMap(
+    AffineMap lhs, AffineMap rhs, llvm::function_ref<AffineMap()> composeFn) {
+  auto &impl = lhs.getContext()->getImpl();
+  return safeGetOrCreate(impl.composedAffineMaps, std::make_pair(lhs, rhs),
+                         impl.affineMemoMutex, composeFn);
+}
+
+AffineMap
+detail::getMemoizedSimplifiedMap(AffineMap map,
+                                 llvm::function_ref<AffineMap()> simplifyFn) {
+  auto &impl = map.getContext()->getImpl();
+  return safeGetOrCreate(impl.simplifiedAffineMaps, map, impl.affineMemoMutex,
+                         simplifyFn);
+}
+
+IntegerSet
+mlir::getMemoizedSimplifiedSet(IntegerSet set,
+                               llvm::function_ref<IntegerSet()> simplifyFn) {
+  auto &impl = set.getContext()->getImpl();
+  return safeGetOrCreate(impl.simplifiedIntegerSets, set, impl.affineMemoMutex,
+                         simplifyFn);
 }
 
 AffineExpr mlir::getAffineBinaryOpExpr(AffineExprKind kind, AffineExpr lhs,
@@ -1716,7 +2578,8 @@ AffineExpr mlir::getAffineDimExpr(unsigned position, MLIRContext *context) {
   if (result)
     return result;
 
-  result = impl.affineAllocator.Allocate<AffineDimExprStorage>();
+  auto &allocator = impl.getThreadLocalAllocator();
+  result = allocator.Allocate<AffineDimExprStorage>();
   // Initialize the memory using placement new.
   new (result) AffineDimExprStorage{{AffineExprKind::DimId, context}, position};
   return result;
@@ -1744,7 +2607,8 @@ AffineExpr mlir::getAffineSymbolExpr(unsigned position, MLIRContext *context) {
   if (result)
     return result;
 
-  result = impl.affineAllocator.Allocate<AffineSymbolExprStorage>();
+  auto &allocator = impl.getThreadLocalAllocator();
+  result = allocator.Allocate<AffineSymbolExprStorage>();
   // Initialize the memory using placement new.
   new (result)
       AffineSymbolExprStorage{{AffineExprKind::SymbolId, context}, position};
@@ -1756,7 +2620,8 @@ AffineExpr mlir::getAffineConstantExpr(int64_t constant, MLIRContext *context) {
 
   // Safely get or create an AffineConstantExpr instance.
   return safeGetOrCreate(impl.constExprs, constant, impl.affineMutex, [&] {
-    auto *result = impl.affineAllocator.Allocate<AffineConstantExprStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto *result = allocator.Allocate<AffineConstantExprStorage>();
     return new (result) AffineConstantExprStorage{
         {AffineExprKind::Constant, context}, constant};
   });
@@ -1778,11 +2643,12 @@ IntegerSet IntegerSet::get(unsigned dimCount, unsigned symbolCount,
 
   // A utility function to construct a new IntegerSetStorage instance.
   auto constructorFn = [&] {
-    auto *res = impl.affineAllocator.Allocate<detail::IntegerSetStorage>();
+    auto &allocator = impl.getThreadLocalAllocator();
+    auto *res = allocator.Allocate<detail::IntegerSetStorage>();
 
     // Copy the results and equality flags into the bump pointer.
-    constraints = copyArrayRefInto(impl.affineAllocator, constraints);
-    eqFlags = copyArrayRefInto(impl.affineAllocator, eqFlags);
+    constraints = copyArrayRefInto(allocator, constraints);
+    eqFlags = copyArrayRefInto(allocator, eqFlags);
 
     // Initialize the memory using placement new.
     new (res)
@@ -1798,8 +2664,7 @@ IntegerSet IntegerSet::get(unsigned dimCount, unsigned symbolCount,
                            constructorFn);
   }
 
-  // Otherwise, aquire a writer-lock so that we can safely create the new
-  // instance.
-  llvm::sys::SmartScopedWriter<true> affineLock(impl.affineMutex);
+  // Otherwise, the new instance is not shared with other threads and can be
+  // created without a lock.
   return constructorFn();
 }
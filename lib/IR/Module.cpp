@@ -18,8 +18,18 @@
 #include "mlir/IR/Module.h"
 using namespace mlir;
 
+FunctionMaterializer::~FunctionMaterializer() {}
+
 Module::Module(MLIRContext *context) : context(context) {}
 
+/// Materialize the bodies of all of the functions within this module.
+LogicalResult Module::materializeAll() {
+  for (auto &fn : *this)
+    if (failed(fn.materialize()))
+      return failure();
+  return success();
+}
+
 /// Look up a function with the specified name, returning null if no such
 /// name exists.  Function names never include the @ on them.
 Function *Module::getNamedFunction(StringRef name) {
@@ -29,6 +39,30 @@ Function *Module::getNamedFunction(StringRef name) {
 /// Look up a function with the specified name, returning null if no such
 /// name exists.  Function names never include the @ on them.
 Function *Module::getNamedFunction(Identifier name) {
+  llvm::sys::SmartScopedReader<true> lock(symbolTableMutex);
   auto it = symbolTable.find(name);
   return it != symbolTable.end() ? it->second : nullptr;
 }
+
+/// Append the given function to the module and return it.  This is safe to
+/// call from multiple threads at once.
+Function *Module::addFunction(Function *function) {
+  llvm::sys::SmartScopedLock<true> lock(functionListMutex);
+  functions.push_back(function);
+  return function;
+}
+
+/// Return the function with the specified name, or append the function
+/// created by 'createFn' if there is none.  This is safe to call from multiple
+/// threads at once.
+Function *Module::getOrInsertFunction(
+    StringRef name, llvm::function_ref<Function *()> createFn) {
+  llvm::sys::SmartScopedLock<true> lock(functionListMutex);
+  if (auto *function = getNamedFunction(name))
+    return function;
+  Function *function = createFn();
+  assert(function->getName().strref() == name &&
+         "created a function with another name than the requested one");
+  functions.push_back(function);
+  return function;
+}
@@ -16,6 +16,7 @@
 // =============================================================================
 
 #include "mlir/IR/Operation.h"
+#include "OperationPool.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Dialect.h"
 #include "mlir/IR/Function.h"
@@ -92,10 +93,11 @@ Operation *Operation::create(Location location, OperationName name,
                              ArrayRef<Type> resultTypes,
                              ArrayRef<NamedAttribute> attributes,
                              ArrayRef<Block *> successors, unsigned numRegions,
-                             bool resizableOperandList, MLIRContext *context) {
+                             bool resizableOperandList, MLIRContext *context,
+                             unsigned numReservedOperands) {
   return create(location, name, operands, resultTypes,
                 NamedAttributeList(context, attributes), successors, numRegions,
-                resizableOperandList, context);
+                resizableOperandList, context, numReservedOperands);
 }
 
 /// Create a new Operation from operation state.
@@ -103,7 +105,8 @@ Operation *Operation::create(const OperationState &state) {
   unsigned numRegions = state.regions.size();
   Operation *op = create(state.location, state.name, state.operands,
                          state.types, state.attributes, state.successors,
-                         numRegions, state.resizableOperandList, state.context);
+                         numRegions, state.resizableOperandList, state.context,
+                         state.numReservedOperands);
   for (unsigned i = 0; i < numRegions; ++i)
     if (state.regions[i])
       op->getRegion(i).takeBody(*state.regions[i]);
@@ -117,7 +120,8 @@ Operation *Operation::create(Location location, OperationName name,
                              ArrayRef<Type> resultTypes,
                              const NamedAttributeList &attributes,
                              ArrayRef<Block *> successors, unsigned numRegions,
-                             bool resizableOperandList, MLIRContext *context) {
+                             bool resizableOperandList, MLIRContext *context,
+                             unsigned numReservedOperands) {
   unsigned numSuccessors = successors.size();
 
   // Input operands are nullptr-separated for each successor, the null operands
@@ -129,15 +133,18 @@ Operation *Operation::create(Location location, OperationName name,
                                    detail::OperandStorage>(
       resultTypes.size(), numSuccessors, numSuccessors, numRegions,
       /*detail::OperandStorage*/ 1);
-  byteSize += llvm::alignTo(detail::OperandStorage::additionalAllocSize(
-                                numOperands, resizableOperandList),
-                            alignof(Operation));
-  void *rawMem = malloc(byteSize);
+  byteSize += llvm::alignTo(
+      detail::OperandStorage::additionalAllocSize(
+          numOperands, resizableOperandList, numReservedOperands),
+      alignof(Operation));
+  unsigned allocSizeClass;
+  void *rawMem = detail::allocateOperation(context, byteSize, allocSizeClass);
 
   // Create the new Operation.
   auto op =
       ::new (rawMem) Operation(location, name, resultTypes.size(),
                                numSuccessors, numRegions, attributes, context);
+  op->allocSizeClass = allocSizeClass;
 
   assert((numSuccessors == 0 || !op->isKnownNonTerminator()) &&
          "unexpected successors in a non-terminator operation");
@@ -148,7 +155,8 @@ Operation *Operation::create(Location location, OperationName name,
 
   // Initialize the results and operands.
   new (&op->getOperandStorage())
-      detail::OperandStorage(numOperands, resizableOperandList);
+      detail::OperandStorage(numOperands, resizableOperandList,
+                             numReservedOperands);
 
   auto instResults = op->getOpResults();
   for (unsigned i = 0, e = resultTypes.size(); i != e; ++i)
@@ -221,7 +229,7 @@ Operation::Operation(Location location, OperationName name, unsigned numResults,
       numRegions(numRegions), name(name), attrs(attributes) {}
 
 // Operations are deleted through the destroy() member because they are
-// allocated via malloc.
+// allocated via malloc or from the operation pools of their context.
 Operation::~Operation() {
   assert(block == nullptr && "operation destroyed but still in a block");
 
@@ -242,8 +250,9 @@ Operation::~Operation() {
 
 /// Destroy this operation or one of its subclasses.
 void Operation::destroy() {
+  unsigned sizeClass = allocSizeClass;
   this->~Operation();
-  free(this);
+  detail::deallocateOperation(this, sizeClass);
 }
 
 /// Return the context this operation is associated with.
@@ -285,25 +294,31 @@ Function *Operation::getFunction() {
 // Operation Walkers
 //===----------------------------------------------------------------------===//
 
-void Operation::walk(const std::function<void(Operation *)> &callback) {
-  // Visit the current operation.
-  callback(this);
-
-  // Visit any internal operations.
-  for (auto &region : getRegions())
-    for (auto &block : region)
-      block.walk(callback);
-}
+WalkResult Operation::walkOperations(detail::WalkCallback callback,
+                                     WalkOrder order) {
+  if (order == WalkOrder::PreOrder) {
+    // Visit the current operation, then any internal operations.
+    auto result = callback(this);
+    if (result.wasInterrupted())
+      return result;
+    if (result.wasSkipped())
+      return WalkResult::advance();
+    for (auto &region : getRegions())
+      for (auto &block : region)
+        if (Block::walkOperations(block.begin(), block.end(), callback, order)
+                .wasInterrupted())
+          return WalkResult::interrupt();
+    return WalkResult::advance();
+  }
 
-void Operation::walkPostOrder(
-    const std::function<void(Operation *)> &callback) {
-  // Visit any internal operations.
+  // Visit any internal operations in reverse, then the current operation.
   for (auto &region : llvm::reverse(getRegions()))
     for (auto &block : llvm::reverse(region))
-      block.walkPostOrder(callback);
-
-  // Visit the current operation.
-  callback(this);
+      if (Block::walkOperations(block.begin(), block.end(), callback, order)
+              .wasInterrupted())
+        return WalkResult::interrupt();
+  return callback(this).wasInterrupted() ? WalkResult::interrupt()
+                                         : WalkResult::advance();
 }
 
 //===----------------------------------------------------------------------===//
@@ -341,12 +356,58 @@ bool Operation::isBeforeInBlock(Operation *other) {
   assert(block && "Operations without parent blocks have no order.");
   assert(other && other->block == block &&
          "Expected other operation to have the same parent block.");
-  // Recompute the parent ordering if necessary.
-  if (!block->isInstOrderValid())
+  // Recompute the parent ordering if necessary, otherwise number the
+  // operations inserted since it was computed.
+  if (!block->isInstOrderValid()) {
     block->recomputeInstOrder();
+  } else {
+    updateOrderIfNecessary();
+    other->updateOrderIfNecessary();
+  }
   return orderIndex < other->orderIndex;
 }
 
+void Operation::updateOrderIfNecessary() {
+  if (hasValidOrder())
+    return;
+
+  // Find the run of operations without an index this one ends, and the
+  // numbered operation preceding it, if any.
+  Operation *first = this;
+  unsigned numOps = 1;
+  for (Operation *prev = getPrevNode(); prev && !prev->hasValidOrder();
+       prev = prev->getPrevNode()) {
+    first = prev;
+    ++numOps;
+  }
+  Operation *prev = first->getPrevNode();
+  int64_t prevIndex = prev ? prev->orderIndex : -1;
+
+  // Extend the run with the following operations until the next numbered one
+  // leaves room to space them evenly by at least two, so that an operation may
+  // later be inserted between any two of them. Any index is free past the end
+  // of the block.
+  Operation *end = getNextNode();
+  auto getStep = [&] {
+    return (static_cast<int64_t>(end->orderIndex) - prevIndex) / (numOps + 1);
+  };
+  while (end && (!end->hasValidOrder() || getStep() < 2)) {
+    end = end->getNextNode();
+    ++numOps;
+  }
+  int64_t step = end ? getStep() : kOrderStride;
+
+  // Renumber the whole block if the indices would overflow.
+  if (prevIndex + numOps * step >= kInvalidOrderIndex)
+    return block->recomputeInstOrder();
+
+  int64_t index = prevIndex;
+  for (Operation *op = first; op != end; op = op->getNextNode()) {
+    index += step;
+    op->orderIndex = index;
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // ilist_traits for Operation
 //===----------------------------------------------------------------------===//
@@ -393,8 +454,9 @@ void llvm::ilist_traits<::mlir::Operation>::addNodeToList(Operation *op) {
   assert(!op->getBlock() && "already in a operation block!");
   op->block = getContainingBlock();
 
-  // Invalidate the block ordering.
-  op->block->invalidateInstOrder();
+  // The operation is numbered lazily between its neighbours, which keeps the
+  // ordering of the block valid.
+  op->orderIndex = Operation::kInvalidOrderIndex;
 }
 
 /// This is a trait method invoked when a operation is removed from a block.
@@ -410,17 +472,12 @@ void llvm::ilist_traits<::mlir::Operation>::transferNodesFromList(
     ilist_traits<Operation> &otherList, op_iterator first, op_iterator last) {
   Block *curParent = getContainingBlock();
 
-  // Invalidate the ordering of the parent block.
-  curParent->invalidateInstOrder();
-
-  // If we are transferring operations within the same block, the block
-  // pointer doesn't need to be updated.
-  if (curParent == otherList.getContainingBlock())
-    return;
-
-  // Update the 'block' member of each operation.
-  for (; first != last; ++first)
+  // Update the 'block' member of each operation, and let them be numbered
+  // lazily at their new position, which keeps the ordering of the block valid.
+  for (; first != last; ++first) {
     first->block = curParent;
+    first->orderIndex = Operation::kInvalidOrderIndex;
+  }
 }
 
 /// Remove this operation (and its descendants) from its Block and delete
@@ -471,6 +528,14 @@ void Operation::dropAllDefinedValueUses() {
       block.dropAllDefinedValueUses();
 }
 
+/// Replace all uses of the results of this operation with 'values'.
+void Operation::replaceAllUsesWith(ArrayRef<Value *> values) {
+  assert(values.size() == getNumResults() &&
+         "incorrect number of replacement values");
+  for (unsigned i = 0, e = values.size(); i != e; ++i)
+    getResult(i)->replaceAllUsesWith(values[i]);
+}
+
 /// Return true if there are no users of any results of this operation.
 bool Operation::use_empty() {
   for (auto *result : getResults())
@@ -512,6 +577,18 @@ auto Operation::getSuccessorOperands(unsigned index) -> operand_range {
                            succOperandIndex + getNumSuccessorOperands(index))};
 }
 
+/// Returns whether this operation may be simplified by constantFold or fold.
+bool Operation::isFoldable() {
+  if (auto *abstractOp = getAbstractOperation())
+    return abstractOp->hasProperty(OperationProperty::Foldable) ||
+           abstractOp->dialect.constantFoldHook;
+
+  // Unregistered operations can only be folded by the hook of their dialect.
+  auto dialectPrefix = getName().getStringRef().split('.').first;
+  auto *dialect = getContext()->getRegisteredDialect(dialectPrefix);
+  return dialect && dialect->constantFoldHook;
+}
+
 /// Attempt to constant fold this operation with the specified constant
 /// operand values.  If successful, this fills in the results vector.  If not,
 /// results is unspecified.
@@ -524,14 +601,18 @@ LogicalResult Operation::constantFold(ArrayRef<Attribute> operands,
       return success();
 
     // Otherwise, fall back on the dialect hook to handle it.
-    return abstractOp->dialect.constantFoldHook(this, operands, results);
+    auto &dialect = abstractOp->dialect;
+    if (!dialect.constantFoldHook)
+      return failure();
+    return dialect.constantFoldHook(this, operands, results);
   }
 
   // If this operation hasn't been registered or doesn't have abstract
   // operation, fall back to a dialect which matches the prefix.
   auto opName = getName().getStringRef();
   auto dialectPrefix = opName.split('.').first;
-  if (auto *dialect = getContext()->getRegisteredDialect(dialectPrefix))
+  auto *dialect = getContext()->getRegisteredDialect(dialectPrefix);
+  if (dialect && dialect->constantFoldHook)
     return dialect->constantFoldHook(this, operands, results);
 
   return failure();
@@ -600,10 +681,11 @@ Operation *Operation::cloneWithoutRegions(BlockAndValueMapping &mapper,
   for (auto *result : getResults())
     resultTypes.push_back(result->getType());
 
+  // The clone keeps as much room for operands as this operation has.
   unsigned numRegions = getNumRegions();
-  auto *newOp = Operation::create(getLoc(), getName(), operands, resultTypes,
-                                  attrs, successors, numRegions,
-                                  hasResizableOperandsList(), context);
+  auto *newOp = Operation::create(
+      getLoc(), getName(), operands, resultTypes, attrs, successors, numRegions,
+      hasResizableOperandsList(), context, getOperandStorage().capacity());
 
   // Remember the mapping of any results.
   for (unsigned i = 0, e = getNumResults(); i != e; ++i)
@@ -0,0 +1,57 @@
+//===- OperationPool.h - MLIR Operation memory pooling ----------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This holds the interface between Operation and the pools of operation memory
+// owned by an MLIRContext.
+//
+//===----------------------------------------------------------------------===//
+#ifndef MLIR_IR_OPERATIONPOOL_H_
+#define MLIR_IR_OPERATIONPOOL_H_
+
+#include <cstddef>
+
+namespace mlir {
+
+class MLIRContext;
+
+namespace detail {
+
+/// The pooled operations are grouped in size classes that are multiples of
+/// 'kOperationSizeGranularity' bytes, up to 'kNumOperationSizeClasses' of
+/// them.  Larger operations are always allocated with malloc.
+enum : unsigned {
+  kOperationSizeGranularity = 16,
+  kNumOperationSizeClasses = 64
+};
+
+/// Return memory for an operation of 'size' bytes created in 'context'.  This
+/// comes from the pool of the calling thread if pooling is enabled in
+/// 'context', in which case 'sizeClass' is set to the size class of the
+/// operation, and from malloc otherwise, in which case 'sizeClass' is zero.
+void *allocateOperation(MLIRContext *context, size_t size,
+                        unsigned &sizeClass);
+
+/// Release the memory of an operation, given the size class returned by
+/// allocateOperation.  Pooled memory is kept by the context the operation was
+/// created in, to be reused by the next operations created by the calling
+/// thread.
+void deallocateOperation(void *mem, unsigned sizeClass);
+
+} // end namespace detail
+} // end namespace mlir
+
+#endif // MLIR_IR_OPERATIONPOOL_H_
@@ -75,10 +75,7 @@ void PatternRewriter::replaceOp(Operation *op, ArrayRef<Value *> newValues,
   // Notify the rewriter subclass that we're about to replace this root.
   notifyRootReplaced(op);
 
-  assert(op->getNumResults() == newValues.size() &&
-         "incorrect # of replacement values");
-  for (unsigned i = 0, e = newValues.size(); i != e; ++i)
-    op->getResult(i)->replaceAllUsesWith(newValues[i]);
+  op->replaceAllUsesWith(newValues);
 
   notifyOperationRemoved(op);
   op->erase();
@@ -123,27 +120,35 @@ void PatternRewriter::updatedRootInPlace(
 //===----------------------------------------------------------------------===//
 
 RewritePatternMatcher::RewritePatternMatcher(
-    OwningRewritePatternList &&patterns, PatternRewriter &rewriter)
-    : patterns(std::move(patterns)), rewriter(rewriter) {
+    OwningRewritePatternList &&patterns)
+    : patterns(std::move(patterns)) {
   // Sort the patterns by benefit to simplify the matching logic.
   std::stable_sort(this->patterns.begin(), this->patterns.end(),
                    [](const std::unique_ptr<RewritePattern> &l,
                       const std::unique_ptr<RewritePattern> &r) {
                      return r->getBenefit() < l->getBenefit();
                    });
+
+  // Bucket the patterns by their root operation, dropping the ones that can
+  // never match. The patterns are visited in benefit order, so each bucket
+  // remains sorted.
+  for (auto &pattern : this->patterns)
+    if (!pattern->getBenefit().isImpossibleToMatch())
+      patternsByRoot[pattern->getRootKind()].push_back(pattern.get());
 }
 
 /// Try to match the given operation to a pattern and rewrite it.
-void RewritePatternMatcher::matchAndRewrite(Operation *op) {
-  for (auto &pattern : patterns) {
-    // Ignore patterns that are for the wrong root or are impossible to match.
-    if (pattern->getRootKind() != op->getName() ||
-        pattern->getBenefit().isImpossibleToMatch())
-      continue;
+bool RewritePatternMatcher::matchAndRewrite(Operation *op,
+                                            PatternRewriter &rewriter) const {
+  auto it = patternsByRoot.find(op->getName());
+  if (it == patternsByRoot.end())
+    return false;
 
+  for (auto *pattern : it->second) {
     // Try to match and rewrite this pattern. The patterns are sorted by
     // benefit, so if we match we can immediately rewrite and return.
     if (pattern->matchAndRewrite(op, rewriter))
-      return;
+      return true;
   }
+  return false;
 }
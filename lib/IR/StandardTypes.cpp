@@ -17,6 +17,7 @@
 
 #include "mlir/IR/StandardTypes.h"
 #include "TypeDetail.h"
+#include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
 #include "mlir/Support/STLExtras.h"
 #include "llvm/ADT/APFloat.h"
@@ -376,6 +377,106 @@ unsigned MemRefType::getNumDynamicDims() const {
   return llvm::count_if(getShape(), [](int64_t i) { return i < 0; });
 }
 
+int64_t MemRefType::getNumElements() const {
+  assert(hasStaticShape() && "expected a statically shaped memref");
+  int64_t numElements = 1;
+  for (int64_t size : getShape())
+    numElements *= size;
+  return numElements;
+}
+
+constexpr int64_t MemRefType::kDynamicStrideOrOffset;
+
+/// Adds `value` to `accumulator`, if neither is dynamic.
+static void addStrideOrOffset(int64_t &accumulator, int64_t value) {
+  if (accumulator == MemRefType::kDynamicStrideOrOffset ||
+      value == MemRefType::kDynamicStrideOrOffset)
+    accumulator = MemRefType::kDynamicStrideOrOffset;
+  else
+    accumulator += value;
+}
+
+/// Adds the contribution of the term `expr` of a strided layout map to its
+/// `strides` and `offset`.  Returns failure if the term is not a constant, a
+/// symbol or a dimension multiplied by either.
+static LogicalResult addStridedTerm(AffineExpr expr,
+                                    MutableArrayRef<int64_t> strides,
+                                    int64_t &offset) {
+  if (expr.getKind() == AffineExprKind::Add) {
+    auto addExpr = expr.cast<AffineBinaryOpExpr>();
+    return failure(failed(addStridedTerm(addExpr.getLHS(), strides, offset)) ||
+                   failed(addStridedTerm(addExpr.getRHS(), strides, offset)));
+  }
+  if (auto constantExpr = expr.dyn_cast<AffineConstantExpr>()) {
+    addStrideOrOffset(offset, constantExpr.getValue());
+    return success();
+  }
+  if (expr.isSymbolicOrConstant()) {
+    offset = MemRefType::kDynamicStrideOrOffset;
+    return success();
+  }
+  if (auto dimExpr = expr.dyn_cast<AffineDimExpr>()) {
+    addStrideOrOffset(strides[dimExpr.getPosition()], 1);
+    return success();
+  }
+  if (expr.getKind() != AffineExprKind::Mul)
+    return failure();
+
+  // The right-hand side of a multiplication is always symbolic or constant.
+  auto mulExpr = expr.cast<AffineBinaryOpExpr>();
+  auto dimExpr = mulExpr.getLHS().dyn_cast<AffineDimExpr>();
+  if (!dimExpr)
+    return failure();
+  auto constantExpr = mulExpr.getRHS().dyn_cast<AffineConstantExpr>();
+  addStrideOrOffset(strides[dimExpr.getPosition()],
+                    constantExpr ? constantExpr.getValue()
+                                 : MemRefType::kDynamicStrideOrOffset);
+  return success();
+}
+
+LogicalResult mlir::getStridesAndOffset(MemRefType t,
+                                        SmallVectorImpl<int64_t> &strides,
+                                        int64_t &offset) {
+  auto maps = t.getAffineMaps();
+  unsigned rank = t.getRank();
+  strides.assign(rank, 0);
+  offset = 0;
+
+  // The row-major strides of the identity layout.
+  if (maps.empty()) {
+    int64_t stride = 1;
+    for (unsigned i = rank; i > 0; --i) {
+      strides[i - 1] = stride;
+      int64_t size = t.getDimSize(i - 1);
+      if (stride != MemRefType::kDynamicStrideOrOffset)
+        stride = size < 0 ? MemRefType::kDynamicStrideOrOffset : stride * size;
+    }
+    return success();
+  }
+
+  if (maps.size() != 1 || maps[0].getNumResults() != 1 ||
+      !maps[0].getRangeSizes().empty())
+    return failure();
+  return addStridedTerm(maps[0].getResult(0), strides, offset);
+}
+
+AffineMap mlir::makeStridedLinearLayoutMap(ArrayRef<int64_t> strides,
+                                           int64_t offset,
+                                           MLIRContext *context) {
+  unsigned numSymbols = 0;
+  auto getStrideOrOffsetExpr = [&](int64_t value) -> AffineExpr {
+    if (value == MemRefType::kDynamicStrideOrOffset)
+      return getAffineSymbolExpr(numSymbols++, context);
+    return getAffineConstantExpr(value, context);
+  };
+
+  AffineExpr expr = getStrideOrOffsetExpr(offset);
+  for (unsigned i = 0, e = strides.size(); i < e; ++i)
+    expr = expr +
+           getAffineDimExpr(i, context) * getStrideOrOffsetExpr(strides[i]);
+  return AffineMap::get(strides.size(), numSymbols, expr, {});
+}
+
 //===----------------------------------------------------------------------===//
 /// ComplexType
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,234 @@
+//===- StructuralHash.cpp - Stable IR fingerprints ------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/StructuralHash.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+std::string Fingerprint::str() const {
+  std::string result;
+  llvm::raw_string_ostream os(result);
+  os << llvm::format_hex_no_prefix(high, 16)
+     << llvm::format_hex_no_prefix(low, 16);
+  return os.str();
+}
+
+namespace {
+/// This class computes the fingerprint of a piece of IR. Values and blocks
+/// are identified by their position within the hashed IR, and types and
+/// attributes by their printed form, so that the result doesn't depend on the
+/// addresses of any of the hashed entities.
+class StructuralHasher {
+public:
+  /// Hash the given operation, including its regions.
+  void hashOperation(Operation *op) {
+    numberOperation(op);
+    hashOperationImpl(op);
+  }
+
+  /// Hash the given region.
+  void hashRegion(Region &region) {
+    numberRegion(region);
+    hashRegionImpl(region);
+  }
+
+  /// Hash the given function.
+  void hashFunction(Function *function) {
+    hashString(function->getName().strref());
+    hashType(function->getType());
+    hashAttributes(function->getAttrs());
+    for (unsigned i = 0, e = function->getNumArguments(); i != e; ++i)
+      hashAttributes(function->getArgAttrs(i));
+    hashRegion(function->getBody());
+  }
+
+  /// Hash a fingerprint that was computed separately.
+  void hashFingerprint(Fingerprint fingerprint) {
+    hashInt(fingerprint.getLow());
+    hashInt(fingerprint.getHigh());
+  }
+
+  /// Compute the fingerprint of everything that was hashed.
+  Fingerprint finish() {
+    llvm::MD5::MD5Result result;
+    md5.final(result);
+    return Fingerprint(result.low(), result.high());
+  }
+
+private:
+  /// Assign an id to each of the blocks and values defined within the given
+  /// operation and region. This is done before hashing so that references to
+  /// values and blocks defined later in the IR are hashed consistently.
+  void numberOperation(Operation *op) {
+    for (auto *result : op->getResults())
+      valueIDs.try_emplace(result, valueIDs.size());
+    for (auto &region : op->getRegions())
+      numberRegion(region);
+  }
+  void numberRegion(Region &region) {
+    for (auto &block : region) {
+      blockIDs.try_emplace(&block, blockIDs.size());
+      for (auto *arg : block.getArguments())
+        valueIDs.try_emplace(arg, valueIDs.size());
+      for (auto &op : block)
+        numberOperation(&op);
+    }
+  }
+
+  void hashOperationImpl(Operation *op) {
+    hashString(op->getName().getStringRef());
+    hashInt(op->getNumOperands());
+    for (auto *operand : op->getOperands())
+      hashValueRef(operand);
+    hashInt(op->getNumResults());
+    for (auto *result : op->getResults())
+      hashType(result->getType());
+    hashAttributes(op->getAttrs());
+    hashInt(op->getNumSuccessors());
+    for (unsigned i = 0, e = op->getNumSuccessors(); i != e; ++i) {
+      hashBlockRef(op->getSuccessor(i));
+      hashInt(op->getNumSuccessorOperands(i));
+    }
+    hashInt(op->getNumRegions());
+    for (auto &region : op->getRegions())
+      hashRegionImpl(region);
+  }
+
+  void hashRegionImpl(Region &region) {
+    for (auto &block : region) {
+      hashInt(kBlockMarker);
+      hashInt(block.getNumArguments());
+      for (auto *arg : block.getArguments())
+        hashType(arg->getType());
+      for (auto &op : block)
+        hashOperationImpl(&op);
+    }
+    hashInt(kRegionEndMarker);
+  }
+
+  /// Hash a reference to the given value or block. Values and blocks defined
+  /// above the hashed IR are identified by the order of their first use.
+  void hashValueRef(Value *value) {
+    hashInt(valueIDs.try_emplace(value, valueIDs.size()).first->second);
+  }
+  void hashBlockRef(Block *block) {
+    hashInt(blockIDs.try_emplace(block, blockIDs.size()).first->second);
+  }
+
+  void hashAttributes(ArrayRef<NamedAttribute> attrs) {
+    hashInt(attrs.size());
+    for (auto &attr : attrs) {
+      hashString(attr.first.strref());
+      hashPrintedForm(attr.second.getAsOpaquePointer(),
+                      [&](raw_ostream &os) { attr.second.print(os); });
+    }
+  }
+
+  void hashType(Type type) {
+    hashPrintedForm(type.getAsOpaquePointer(),
+                    [&](raw_ostream &os) { type.print(os); });
+  }
+
+  /// Hash the printed form of a type or attribute. Types and attributes are
+  /// uniqued, so the printed form is cached by the address of their storage.
+  void hashPrintedForm(const void *storage,
+                       llvm::function_ref<void(raw_ostream &)> print) {
+    auto it = printedForms.try_emplace(storage);
+    if (it.second) {
+      llvm::raw_string_ostream os(it.first->second);
+      print(os);
+      os.flush();
+    }
+    hashString(it.first->second);
+  }
+
+  void hashString(StringRef str) {
+    hashInt(str.size());
+    md5.update(str);
+  }
+
+  void hashInt(uint64_t value) {
+    uint8_t bytes[8];
+    for (unsigned i = 0; i != 8; ++i)
+      bytes[i] = uint8_t(value >> (i * 8));
+    md5.update(bytes);
+  }
+
+  /// Markers used to delimit the blocks and regions in the hashed stream.
+  enum : uint64_t { kBlockMarker = ~0ull, kRegionEndMarker = ~1ull };
+
+  llvm::MD5 md5;
+  llvm::DenseMap<Value *, unsigned> valueIDs;
+  llvm::DenseMap<Block *, unsigned> blockIDs;
+  llvm::DenseMap<const void *, std::string> printedForms;
+};
+} // end anonymous namespace
+
+Fingerprint mlir::computeFingerprint(Operation *op) {
+  StructuralHasher hasher;
+  hasher.hashOperation(op);
+  return hasher.finish();
+}
+
+Fingerprint mlir::computeFingerprint(Region &region) {
+  StructuralHasher hasher;
+  hasher.hashRegion(region);
+  return hasher.finish();
+}
+
+Fingerprint mlir::computeFingerprint(Function *function) {
+  StructuralHasher hasher;
+  hasher.hashFunction(function);
+  return hasher.finish();
+}
+
+Fingerprint mlir::computeFingerprint(Module *module, bool enableThreads) {
+  // Compute the fingerprints of each of the functions independently, which
+  // allows for doing so in parallel. Lazily loaded bodies are materialized
+  // up front, as function materializers aren't required to be thread-safe.
+  std::vector<std::pair<Function *, Fingerprint>> functions;
+  for (auto &fn : *module) {
+    (void)fn.materialize();
+    functions.emplace_back(&fn, Fingerprint());
+  }
+  auto computeFunctionFingerprint =
+      [](std::pair<Function *, Fingerprint> &function) {
+        function.second = computeFingerprint(function.first);
+      };
+  if (enableThreads) {
+    parallelForEach(module->getContext(), functions.begin(), functions.end(),
+                    computeFunctionFingerprint);
+  } else {
+    for (auto &function : functions)
+      computeFunctionFingerprint(function);
+  }
+
+  // Combine them in module order.
+  StructuralHasher hasher;
+  hasher.hashFingerprint(Fingerprint(functions.size(), 0));
+  for (auto &function : functions)
+    hasher.hashFingerprint(function.second);
+  return hasher.finish();
+}
@@ -0,0 +1,82 @@
+//===- Threading.cpp - MLIR Threading Utilities ---------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Threading.h"
+#include "mlir/IR/MLIRContext.h"
+#include "llvm/Support/ThreadPool.h"
+#include <condition_variable>
+#include <mutex>
+
+using namespace mlir;
+
+namespace {
+/// The state shared between the caller of 'parallelForEachWorker' and the
+/// workers that it enqueued on the thread pool. This is reference counted as
+/// the enqueued tasks may outlive the call when they never got to start.
+struct WorkerGroup {
+  WorkerGroup(function_ref<void(unsigned)> fn) : fn(fn) {}
+
+  /// Run the worker with the given index, unless the group was already closed.
+  void runWorker(unsigned workerID) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (closed)
+        return;
+      ++numActive;
+    }
+    fn(workerID);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--numActive == 0)
+      allDone.notify_all();
+  }
+
+  /// Prevent any worker from starting and wait for the active ones to finish.
+  void close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    allDone.wait(lock, [&] { return numActive == 0; });
+  }
+
+  function_ref<void(unsigned)> fn;
+  std::mutex mutex;
+  std::condition_variable allDone;
+  unsigned numActive = 0;
+  bool closed = false;
+};
+} // end anonymous namespace
+
+void mlir::parallelForEachWorker(MLIRContext *context, unsigned numWorkers,
+                                 function_ref<void(unsigned workerID)> fn) {
+  numWorkers = std::min(numWorkers, context->getMaxConcurrency());
+  if (numWorkers <= 1) {
+    if (numWorkers != 0)
+      fn(0);
+    return;
+  }
+
+  // Enqueue the other workers, and run the first one on the calling thread.
+  // Waiting only for the workers that actually started, instead of for all of
+  // the enqueued tasks, is what keeps nested parallel regions from
+  // deadlocking when every thread of the pool is blocked in an outer region.
+  auto group = std::make_shared<WorkerGroup>(fn);
+  llvm::ThreadPool &pool = context->getThreadPool();
+  for (unsigned i = 1; i != numWorkers; ++i)
+    pool.async([group, i] { group->runWorker(i); });
+  fn(0);
+  group->close();
+}
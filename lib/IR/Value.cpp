@@ -54,16 +54,35 @@ Location Value::getLoc() {
 /// there are zero uses of 'this'.
 void IRObjectWithUseList::replaceAllUsesWith(IRObjectWithUseList *newValue) {
   assert(this != newValue && "cannot RAUW a value with itself");
-  while (!use_empty()) {
-    use_begin()->set(newValue);
+  if (use_empty())
+    return;
+
+  // Rather than moving the uses one at a time, point them all to the new value
+  // and splice the whole use-list at the front of the one of the new value.
+  IROperand *lastUse = firstUse;
+  for (IROperand *use = firstUse; use; use = use->nextUse) {
+    use->value = newValue;
+    lastUse = use;
   }
+  lastUse->nextUse = newValue->firstUse;
+  if (lastUse->nextUse)
+    lastUse->nextUse->back = &lastUse->nextUse;
+  firstUse->back = &newValue->firstUse;
+  newValue->firstUse = firstUse;
+  firstUse = nullptr;
 }
 
 /// Drop all uses of this object from their respective owners.
 void IRObjectWithUseList::dropAllUses() {
-  while (!use_empty()) {
-    use_begin()->drop();
+  // The uses are unlinked from each other as well, so there is no need to
+  // maintain the use-list while walking it.
+  for (IROperand *use = firstUse, *next; use; use = next) {
+    next = use->nextUse;
+    use->value = nullptr;
+    use->nextUse = nullptr;
+    use->back = nullptr;
   }
+  firstUse = nullptr;
 }
 
 //===----------------------------------------------------------------------===//
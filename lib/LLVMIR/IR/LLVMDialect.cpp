@@ -162,13 +162,17 @@ static bool parseICmpOp(OpAsmParser *parser, OperationState *result) {
   // vectors.
   LLVMDialect *dialect = static_cast<LLVMDialect *>(
       builder.getContext()->getRegisteredDialect("llvm"));
-  llvm::Type *llvmResultType = llvm::Type::getInt1Ty(dialect->getLLVMContext());
   auto argType = type.dyn_cast<LLVM::LLVMType>();
   if (!argType)
     return parser->emitError(trailingTypeLoc, "expected LLVM IR dialect type");
-  if (argType.getUnderlyingType()->isVectorTy())
-    llvmResultType = llvm::VectorType::get(
-        llvmResultType, argType.getUnderlyingType()->getVectorNumElements());
+  llvm::Type *llvmResultType;
+  {
+    llvm::sys::SmartScopedLock<true> lock(dialect->getLLVMContextMutex());
+    llvmResultType = llvm::Type::getInt1Ty(dialect->getLLVMContext());
+    if (argType.getUnderlyingType()->isVectorTy())
+      llvmResultType = llvm::VectorType::get(
+          llvmResultType, argType.getUnderlyingType()->getVectorNumElements());
+  }
   auto resultType = builder.getType<LLVM::LLVMType>(llvmResultType);
 
   result->attributes = attrs;
@@ -357,17 +361,19 @@ static bool parseStoreOp(OpAsmParser *parser, OperationState *result) {
 }
 
 //===----------------------------------------------------------------------===//
-// Printing/parsing for LLVM::BitcastOp.
+// Printing/parsing for LLVM::BitcastOp and the other cast operations.
 //===----------------------------------------------------------------------===//
 
-static void printBitcastOp(OpAsmPrinter *p, BitcastOp &op) {
-  *p << op.getOperationName() << ' ' << *op.arg();
-  p->printOptionalAttrDict(op.getAttrs());
-  *p << " : " << op.arg()->getType() << " to " << op.getType();
+static void printCastOp(OpAsmPrinter *p, Operation *op) {
+  *p << op->getName().getStringRef() << ' ' << *op->getOperand(0);
+  p->printOptionalAttrDict(op->getAttrs());
+  *p << " : " << op->getOperand(0)->getType() << " to "
+     << op->getResult(0)->getType();
 }
 
-// <operation> ::= `llvm.bitcast` ssa-use attribute-dict? `:` type `to` type
-static bool parseBitcastOp(OpAsmParser *parser, OperationState *result) {
+// <operation> ::= (`llvm.bitcast` | `llvm.sext` | `llvm.zext` | `llvm.trunc`)
+//                 ssa-use attribute-dict? `:` type `to` type
+static bool parseCastOp(OpAsmParser *parser, OperationState *result) {
   SmallVector<NamedAttribute, 4> attrs;
   OpAsmParser::OperandType arg;
   Type sourceType, type;
@@ -490,6 +496,7 @@ static bool parseCallOp(OpAsmParser *parser, OperationState *result) {
     Builder &builder = parser->getBuilder();
     auto *llvmDialect = static_cast<LLVM::LLVMDialect *>(
         builder.getContext()->getRegisteredDialect("llvm"));
+    llvm::sys::SmartScopedLock<true> lock(llvmDialect->getLLVMContextMutex());
     llvm::Type *llvmResultType;
     Type wrappedResultType;
     if (funcType.getNumResults() == 0) {
@@ -751,8 +758,12 @@ static bool parseCondBrOp(OpAsmParser *parser, OperationState *result) {
   Builder &builder = parser->getBuilder();
   auto *llvmDialect = static_cast<LLVM::LLVMDialect *>(
       builder.getContext()->getRegisteredDialect("llvm"));
-  auto i1Type = builder.getType<LLVM::LLVMType>(
-      llvm::Type::getInt1Ty(llvmDialect->getLLVMContext()));
+  llvm::Type *llvmI1Type;
+  {
+    llvm::sys::SmartScopedLock<true> lock(llvmDialect->getLLVMContextMutex());
+    llvmI1Type = llvm::Type::getInt1Ty(llvmDialect->getLLVMContext());
+  }
+  auto i1Type = builder.getType<LLVM::LLVMType>(llvmI1Type);
 
   if (parser->parseOperand(condition) || parser->parseComma() ||
       parser->parseSuccessorAndUseList(trueDest, trueOperands) ||
@@ -865,7 +876,8 @@ static bool parseConstantOp(OpAsmParser *parser, OperationState *result) {
 //===----------------------------------------------------------------------===//
 
 LLVMDialect::LLVMDialect(MLIRContext *context)
-    : Dialect("llvm", context), module("LLVMDialectModule", llvmContext) {
+    : Dialect(getDialectNamespace(), context),
+      module("LLVMDialectModule", llvmContext) {
   addTypes<LLVMType>();
   addOperations<
 #define GET_OP_LIST
@@ -879,10 +891,20 @@ LLVMDialect::LLVMDialect(MLIRContext *context)
 #define GET_OP_CLASSES
 #include "mlir/LLVMIR/LLVMOps.cpp.inc"
 
-/// Parse a type registered to this dialect.
+/// Parse a type registered to this dialect.  The types that were already
+/// parsed are looked up in the cache instead of invoking the LLVM parser.
 Type LLVMDialect::parseType(StringRef tyData, Location loc) const {
   llvm::SMDiagnostic errorMessage;
-  llvm::Type *type = llvm::parseType(tyData, errorMessage, module);
+  llvm::Type *type;
+  {
+    llvm::sys::SmartScopedLock<true> lock(mutex);
+    auto it = parsedTypes.find(tyData);
+    if (it != parsedTypes.end())
+      return LLVMType::get(getContext(), it->second);
+    type = llvm::parseType(tyData, errorMessage, module);
+    if (type)
+      parsedTypes.try_emplace(tyData, type);
+  }
   if (!type)
     return (getContext()->emitError(loc, errorMessage.getMessage()), nullptr);
   return LLVMType::get(getContext(), type);
@@ -904,6 +926,21 @@ LogicalResult LLVMDialect::verifyFunctionArgAttribute(Function *func,
   if (argAttr.first == "llvm.noalias" && !argAttr.second.isa<BoolAttr>())
     return func->emitError(
         "llvm.noalias argument attribute of non boolean type");
+  // Check that llvm.align is a power of two integer attribute.
+  if (argAttr.first == "llvm.align") {
+    auto alignment = argAttr.second.dyn_cast<IntegerAttr>();
+    if (!alignment || alignment.getInt() <= 0 ||
+        !llvm::isPowerOf2_64(alignment.getInt()))
+      return func->emitError(
+          "llvm.align argument attribute must be a power of two integer");
+  }
+  // Check that llvm.dereferenceable is a positive integer attribute.
+  if (argAttr.first == "llvm.dereferenceable") {
+    auto bytes = argAttr.second.dyn_cast<IntegerAttr>();
+    if (!bytes || bytes.getInt() <= 0)
+      return func->emitError("llvm.dereferenceable argument attribute must be "
+                             "a positive integer");
+  }
   return success();
 }
 
@@ -25,6 +25,7 @@
 #include "mlir/IR/Module.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/LLVMIR/LLVMDialect.h"
+#include "mlir/LLVMIR/LLVMLowering.h"
 #include "mlir/LLVMIR/Transforms.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/StandardOps/Ops.h"
@@ -32,13 +33,56 @@
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Transforms/Utils.h"
+#include "mlir/VectorOps/VectorOps.h"
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
 
 using namespace mlir;
 
+static llvm::cl::OptionCategory clOptionsCategory("LLVM lowering options");
+
+static llvm::cl::opt<unsigned> clAllocAlignment(
+    "llvm-alloc-alignment",
+    llvm::cl::desc("Alignment in bytes of the buffers allocated by 'alloc' "
+                   "operations without an 'alignment' attribute (default: "
+                   "the alignment of malloc)"),
+    llvm::cl::init(0), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<std::string> clAllocFunction(
+    "llvm-alloc-fn",
+    llvm::cl::desc("Name of the runtime function called to allocate the "
+                   "buffers of 'alloc' operations, with the size and the "
+                   "alignment in bytes as index operands, instead of "
+                   "malloc/aligned_alloc"),
+    llvm::cl::init(""), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned> clAllocaMaxBytes(
+    "llvm-alloca-max-bytes",
+    llvm::cl::desc("Allocate the statically-shaped buffers of 'alloc' "
+                   "operations that are at most this many bytes large, and "
+                   "that cannot escape their function, on the stack "
+                   "(default: 0, never)"),
+    llvm::cl::init(0), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<bool> clNoAliasStaticMemRefArgs(
+    "llvm-noalias-static-memref-args",
+    llvm::cl::desc("Assume that the statically-shaped memref arguments of "
+                   "functions never alias, and mark the pointers they are "
+                   "lowered to as noalias"),
+    llvm::cl::init(false), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<std::string> clDeallocFunction(
+    "llvm-dealloc-fn",
+    llvm::cl::desc("Name of the runtime function called to release the "
+                   "buffers of 'dealloc' operations instead of free"),
+    llvm::cl::init(""), llvm::cl::cat(clOptionsCategory));
+
 namespace {
 // Type converter for the LLVM IR dialect.  Converts MLIR standard and builtin
 // types into equivalent LLVM IR dialect types.
@@ -70,10 +114,20 @@ public:
                                                llvm::Module &llvmModule);
 
 private:
-  // Construct a type converter.
+  // Construct a type converter, which holds the mutex of the LLVM context of
+  // the dialect for its lifetime.
   explicit TypeConverter(llvm::Module &llvmModule, MLIRContext *context)
-      : module(llvmModule), llvmContext(llvmModule.getContext()),
-        builder(llvmModule.getContext()), mlirContext(context) {}
+      : contextLock(getLLVMContextMutex(context)), module(llvmModule),
+        llvmContext(llvmModule.getContext()), builder(llvmModule.getContext()),
+        mlirContext(context) {}
+
+  // Get the mutex guarding the creation of types in the LLVM context.
+  static llvm::sys::SmartMutex<true> &
+  getLLVMContextMutex(MLIRContext *context) {
+    return static_cast<LLVM::LLVMDialect *>(
+               context->getRegisteredDialect("llvm"))
+        ->getLLVMContextMutex();
+  }
 
   // Convert a function type.  The arguments and results are converted one by
   // one.  Additionally, if the function returns more than one value, pack the
@@ -105,7 +159,8 @@ private:
   //   2. as many index types as memref has dynamic dimensions.
   Type convertMemRefType(MemRefType type);
 
-  // Convert a 1D vector type into an LLVM vector type.
+  // Convert a 1-D vector type into an LLVM vector type, and an n-D vector type
+  // into nested LLVM arrays of 1-D vectors.
   Type convertVectorType(VectorType type);
 
   // Convert a non-empty list of types into an LLVM structure type containing
@@ -138,6 +193,7 @@ private:
     return wrappedLLVMType.getUnderlyingType();
   }
 
+  llvm::sys::SmartScopedLock<true> contextLock;
   llvm::Module &module;
   llvm::LLVMContext &llvmContext;
   llvm::IRBuilder<> builder;
@@ -267,18 +323,18 @@ Type TypeConverter::convertMemRefType(MemRefType type) {
   return wrap(llvm::StructType::get(llvmContext, types));
 }
 
-// Convert a 1D vector type to an LLVM vector type.
+// Convert a 1-D vector type to an LLVM vector type, and an n-D vector type
+// to nested LLVM arrays of 1-D vectors, e.g. `vector<4x8xf32>` to
+// `[4 x <8 x float>]`.
 Type TypeConverter::convertVectorType(VectorType type) {
-  if (type.getRank() != 1) {
-    mlirContext->emitError(UnknownLoc::get(mlirContext),
-                           "only 1D vectors are supported");
-    return {};
-  }
-
   llvm::Type *elementType = unwrap(convertType(type.getElementType()));
-  return elementType
-             ? wrap(llvm::VectorType::get(elementType, type.getShape().front()))
-             : Type();
+  if (!elementType)
+    return {};
+  auto shape = type.getShape();
+  llvm::Type *converted = llvm::VectorType::get(elementType, shape.back());
+  for (int i = shape.size() - 2; i >= 0; --i)
+    converted = llvm::ArrayType::get(converted, shape[i]);
+  return wrap(converted);
 }
 
 // Dispatch based on the actual type.  Return null type on error.
@@ -322,6 +378,7 @@ Type TypeConverter::getMemRefElementPtrType(MemRefType t,
   if (!converted)
     return {};
   llvm::Type *llvmType = converted.cast<LLVM::LLVMType>().getUnderlyingType();
+  llvm::sys::SmartScopedLock<true> lock(getLLVMContextMutex(t.getContext()));
   return LLVM::LLVMType::get(t.getContext(), llvmType->getPointerTo());
 }
 
@@ -360,6 +417,7 @@ public:
   // Get the MLIR type wrapping the LLVM integer type whose bit width is defined
   // by the pointer size used in the LLVM module.
   LLVM::LLVMType getIndexType() const {
+    llvm::sys::SmartScopedLock<true> lock(dialect.getLLVMContextMutex());
     llvm::Type *llvmType = llvm::Type::getIntNTy(
         getContext(), getModule().getDataLayout().getPointerSizeInBits());
     return LLVM::LLVMType::get(dialect.getContext(), llvmType);
@@ -367,10 +425,27 @@ public:
 
   // Get the MLIR type wrapping the LLVM i8* type.
   LLVM::LLVMType getVoidPtrType() const {
+    llvm::sys::SmartScopedLock<true> lock(dialect.getLLVMContextMutex());
     return LLVM::LLVMType::get(dialect.getContext(),
                                llvm::Type::getInt8PtrTy(getContext()));
   }
 
+  // Get the MLIR type wrapping a pointer to the LLVM type wrapped by `type`.
+  LLVM::LLVMType getPointerType(Type type) const {
+    llvm::sys::SmartScopedLock<true> lock(dialect.getLLVMContextMutex());
+    return LLVM::LLVMType::get(
+        dialect.getContext(),
+        type.cast<LLVM::LLVMType>().getUnderlyingType()->getPointerTo());
+  }
+
+  // Get the function named `name` in the module of `op`, declaring it with the
+  // given type if it is not already present.
+  static Function *getOrInsertFunction(Operation *op, FuncBuilder &rewriter,
+                                       StringRef name, FunctionType type) {
+    return LLVMLowering::getOrInsertFunction(op->getFunction()->getModule(),
+                                             name, type);
+  }
+
   // Create an LLVM IR pseudo-operation defining the given index constant.
   Value *createIndexConstant(FuncBuilder &builder, Location loc,
                              uint64_t value) const {
@@ -389,6 +464,23 @@ public:
     return builder.getArrayAttr(attrs);
   }
 
+  // Broadcast `scalar` to all the elements of a value of `vectorType`.
+  Value *splat(FuncBuilder &rewriter, Location loc, Value *scalar,
+               LLVM::LLVMType vectorType) const {
+    auto *llvmVectorType =
+        cast<llvm::VectorType>(vectorType.getUnderlyingType());
+    unsigned numElements = llvmVectorType->getNumElements();
+    Value *undef = rewriter.create<LLVM::UndefOp>(loc, vectorType,
+                                                  ArrayRef<Value *>{});
+    Value *zero = createIndexConstant(rewriter, loc, 0);
+    Value *inserted = rewriter.create<LLVM::InsertElementOp>(
+        loc, vectorType, ArrayRef<Value *>{undef, scalar, zero});
+    SmallVector<int64_t, 8> zeros(numElements, 0);
+    return rewriter.create<LLVM::ShuffleVectorOp>(
+        loc, vectorType, ArrayRef<Value *>{inserted, undef},
+        rewriter.getNamedAttr("mask", getIntegerArrayAttr(rewriter, zeros)));
+  }
+
   // Extract raw data pointer value from a value representing a memref.
   static Value *extractMemRefElementPtr(FuncBuilder &builder, Location loc,
                                         Value *convertedMemRefValue,
@@ -426,6 +518,21 @@ struct OneToOneLLVMOpLowering : public LLVMLegalizationPattern<SourceOp> {
   using LLVMLegalizationPattern<SourceOp>::LLVMLegalizationPattern;
   using Super = OneToOneLLVMOpLowering<SourceOp, TargetOp>;
 
+  // The LLVM IR instructions only apply elementwise to 1-D vectors, the n-D
+  // vectors are converted to arrays.
+  PatternMatchResult match(Operation *op) const override {
+    if (!LLVMLegalizationPattern<SourceOp>::match(op))
+      return this->matchFailure();
+    auto isNDVector = [](Value *value) {
+      auto vectorType = value->getType().dyn_cast<VectorType>();
+      return vectorType && vectorType.getRank() > 1;
+    };
+    if (llvm::any_of(op->getOperands(), isNDVector) ||
+        llvm::any_of(op->getResults(), isNDVector))
+      return this->matchFailure();
+    return this->matchSuccess();
+  }
+
   // Convert the type of the result to an LLVM type, pass operands as is,
   // preserve attributes.
   SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
@@ -504,6 +611,10 @@ struct DivFOpLowering : public OneToOneLLVMOpLowering<DivFOp, LLVM::FDivOp> {
 struct RemFOpLowering : public OneToOneLLVMOpLowering<RemFOp, LLVM::FRemOp> {
   using Super::Super;
 };
+struct FmaFOpLowering
+    : public OneToOneLLVMOpLowering<FmaFOp, LLVM::FMulAddOp> {
+  using Super::Super;
+};
 struct CmpIOpLowering : public OneToOneLLVMOpLowering<CmpIOp, LLVM::ICmpOp> {
   using Super::Super;
 };
@@ -523,13 +634,76 @@ struct ConstLLVMOpLowering
   using Super::Super;
 };
 
-// Check if the MemRefType `type` is supported by the lowering. We currently do
-// not support memrefs with affine maps and non-default memory spaces.
+// Check if the MemRefType `type` is supported by the lowering. We currently
+// support the identity layout and the strided layouts whose strides and offset
+// are static, which are folded into the address computations so that the
+// descriptor is the same as for the identity layout.  We do not support other
+// affine maps and non-default memory spaces.
 static bool isSupportedMemRefType(MemRefType type) {
-  if (!type.getAffineMaps().empty())
-    return false;
   if (type.getMemorySpace() != 0)
     return false;
+  if (type.getAffineMaps().empty())
+    return true;
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(type, strides, offset)) ||
+      offset == MemRefType::kDynamicStrideOrOffset)
+    return false;
+  return llvm::none_of(strides, [](int64_t stride) {
+    return stride == MemRefType::kDynamicStrideOrOffset;
+  });
+}
+
+// Return the offset, in elements, of the layout of the supported memref type
+// `type`.
+static int64_t getLayoutOffset(MemRefType type) {
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  (void)getStridesAndOffset(type, strides, offset);
+  return offset;
+}
+
+// Return the size in bytes of an element of the given memref type.
+static uint64_t getElementSizeInBytes(MemRefType type) {
+  auto elementType = type.getElementType();
+  assert((elementType.isIntOrFloat() || elementType.isa<VectorType>()) &&
+         "invalid memref element type");
+  if (auto vectorType = elementType.dyn_cast<VectorType>())
+    return vectorType.getNumElements() *
+           llvm::divideCeil(vectorType.getElementTypeBitWidth(), 8);
+  return llvm::divideCeil(elementType.getIntOrFloatBitWidth(), 8);
+}
+
+// Return true if the buffer of `allocOp` may be allocated on the stack of its
+// function instead of the heap.  This is the case if it is statically shaped,
+// no larger than -llvm-alloca-max-bytes, without an explicit alignment, and
+// only used by loads, stores, dims and deallocs, so that it cannot escape the
+// function.  Such a buffer is allocated once in the entry block: since none of
+// its uses can carry it across blocks, the buffers of different executions of
+// the `alloc` are never live at the same time.
+static bool canPromoteToAlloca(AllocOp allocOp) {
+  MemRefType type = allocOp.getType();
+  if (clAllocaMaxBytes == 0 || !type.hasStaticShape() ||
+      !type.getAffineMaps().empty() ||
+      allocOp.getOperation()->getAttr("alignment"))
+    return false;
+  uint64_t size = getElementSizeInBytes(type);
+  for (int64_t dim : type.getShape())
+    size *= dim;
+  if (size > clAllocaMaxBytes)
+    return false;
+  for (auto &use : allocOp.getResult()->getUses()) {
+    Operation *user = use.getOwner();
+    if (user->isa<DimOp>() || user->isa<DeallocOp>())
+      continue;
+    if (auto loadOp = user->dyn_cast<LoadOp>())
+      if (loadOp.getMemRef() == allocOp.getResult())
+        continue;
+    if (auto storeOp = user->dyn_cast<StoreOp>())
+      if (storeOp.getMemRef() == allocOp.getResult())
+        continue;
+    return false;
+  }
   return true;
 }
 
@@ -538,21 +712,64 @@ static bool isSupportedMemRefType(MemRefType type) {
 // descriptor is of the LLVM structure type where the first element is a pointer
 // to the (typed) data buffer, and the remaining elements serve to store
 // dynamic sizes of the memref using LLVM-converted `index` type.
+// If the `alloc` has an `alignment` attribute, or if a default alignment is
+// set with -llvm-alloc-alignment, the buffer is allocated with `aligned_alloc`
+// instead, and its size is rounded up to a multiple of the alignment as this
+// function requires.  If -llvm-alloc-fn is set, the buffer is allocated by
+// calling the given runtime function with the size and alignment instead,
+// e.g. to reuse buffers from a pool.  Small buffers that cannot escape their
+// function are allocated with an `alloca` in the entry block instead if
+// -llvm-alloca-max-bytes is set, see `canPromoteToAlloca`.  The buffer of a
+// memref with a strided layout extends up to its last element.
 struct AllocOpLowering : public LLVMLegalizationPattern<AllocOp> {
   using LLVMLegalizationPattern<AllocOp>::LLVMLegalizationPattern;
 
+  // Return the requested alignment of the buffer allocated by `op`, or 0 to
+  // use the alignment of malloc.
+  static uint64_t getAlignment(Operation *op) {
+    if (auto alignment = op->getAttrOfType<IntegerAttr>("alignment"))
+      return alignment.getInt();
+    return clAllocAlignment;
+  }
+
   PatternMatchResult match(Operation *op) const override {
     if (!LLVMLegalizationPattern<AllocOp>::match(op))
       return matchFailure();
     auto allocOp = op->cast<AllocOp>();
     MemRefType type = allocOp.getType();
-    return isSupportedMemRefType(type) ? matchSuccess() : matchFailure();
+    uint64_t alignment = getAlignment(op);
+    if (alignment != 0 && !llvm::isPowerOf2_64(alignment))
+      return matchFailure();
+    if (!isSupportedMemRefType(type))
+      return matchFailure();
+    // The size of the buffer of a layout with negative strides or offset would
+    // not account for the elements before its start.
+    SmallVector<int64_t, 4> strides;
+    int64_t offset;
+    (void)getStridesAndOffset(type, strides, offset);
+    if (offset < 0 || llvm::any_of(strides, [](int64_t s) { return s < 0; }))
+      return matchFailure();
+    return matchSuccess();
   }
 
   SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
                                   FuncBuilder &rewriter) const override {
     auto allocOp = op->cast<AllocOp>();
     MemRefType type = allocOp.getType();
+    auto elementType = type.getElementType();
+    auto structElementType = TypeConverter::convert(elementType, getModule());
+    auto elementPtrType = getPointerType(structElementType);
+
+    // Allocate small buffers that cannot escape on the stack.  The `alloca` is
+    // placed in the entry block so that it is only executed once.
+    if (canPromoteToAlloca(allocOp)) {
+      Block *entryBlock = &rewriter.getInsertionBlock()->getParent()->front();
+      FuncBuilder entryBuilder(entryBlock, entryBlock->begin());
+      Value *numElements = createIndexConstant(entryBuilder, op->getLoc(),
+                                               type.getNumElements());
+      return {entryBuilder.create<LLVM::AllocaOp>(op->getLoc(), elementPtrType,
+                                                  numElements)};
+    }
 
     // Get actual sizes of the memref as values: static sizes are constant
     // values and dynamic sizes are passed to 'alloc' as operands.  In case of
@@ -567,53 +784,47 @@ struct AllocOpLowering : public LLVMLegalizationPattern<AllocOp> {
     if (sizes.empty())
       sizes.push_back(createIndexConstant(rewriter, op->getLoc(), 1));
 
-    // Compute the total number of memref elements.
+    // Compute the total number of memref elements.  With a strided layout, it
+    // is the number of elements up to the last one, at the position
+    //   offset + \sum_k (size_k - 1) * stride_k.
     Value *cumulativeSize = sizes.front();
-    for (unsigned i = 1, e = sizes.size(); i < e; ++i)
-      cumulativeSize = rewriter.create<LLVM::MulOp>(
-          op->getLoc(), getIndexType(),
-          ArrayRef<Value *>{cumulativeSize, sizes[i]});
-
+    if (type.getAffineMaps().empty()) {
+      for (unsigned i = 1, e = sizes.size(); i < e; ++i)
+        cumulativeSize = rewriter.create<LLVM::MulOp>(
+            op->getLoc(), getIndexType(),
+            ArrayRef<Value *>{cumulativeSize, sizes[i]});
+    } else {
+      SmallVector<int64_t, 4> strides;
+      int64_t offset;
+      (void)getStridesAndOffset(type, strides, offset);
+      Value *one = createIndexConstant(rewriter, op->getLoc(), 1);
+      cumulativeSize = createIndexConstant(rewriter, op->getLoc(), offset + 1);
+      for (unsigned i = 0, e = strides.size(); i < e; ++i) {
+        Value *lastIndex = rewriter.create<LLVM::SubOp>(
+            op->getLoc(), getIndexType(), ArrayRef<Value *>{sizes[i], one});
+        Value *extent = rewriter.create<LLVM::MulOp>(
+            op->getLoc(), getIndexType(),
+            ArrayRef<Value *>{
+                lastIndex,
+                createIndexConstant(rewriter, op->getLoc(), strides[i])});
+        cumulativeSize = rewriter.create<LLVM::AddOp>(
+            op->getLoc(), getIndexType(),
+            ArrayRef<Value *>{cumulativeSize, extent});
+      }
+    }
 
     // Compute the total amount of bytes to allocate.
-    auto elementType = type.getElementType();
-    assert((elementType.isIntOrFloat() || elementType.isa<VectorType>()) &&
-           "invalid memref element type");
-    uint64_t elementSize = 0;
-    if (auto vectorType = elementType.dyn_cast<VectorType>())
-      elementSize = vectorType.getNumElements() *
-                    llvm::divideCeil(vectorType.getElementTypeBitWidth(), 8);
-    else
-      elementSize = llvm::divideCeil(elementType.getIntOrFloatBitWidth(), 8);
+    uint64_t elementSize = getElementSizeInBytes(type);
     cumulativeSize = rewriter.create<LLVM::MulOp>(
         op->getLoc(), getIndexType(),
         ArrayRef<Value *>{
             cumulativeSize,
             createIndexConstant(rewriter, op->getLoc(), elementSize)});
 
-    // Insert the `malloc` declaration if it is not already present.
-    Function *mallocFunc =
-        op->getFunction()->getModule()->getNamedFunction("malloc");
-    if (!mallocFunc) {
-      auto mallocType =
-          rewriter.getFunctionType(getIndexType(), getVoidPtrType());
-      mallocFunc = new Function(rewriter.getUnknownLoc(), "malloc", mallocType);
-      op->getFunction()->getModule()->getFunctions().push_back(mallocFunc);
-    }
-
     // Allocate the underlying buffer and store a pointer to it in the MemRef
     // descriptor.
     Value *allocated =
-        rewriter
-            .create<LLVM::CallOp>(op->getLoc(), getVoidPtrType(),
-                                  rewriter.getFunctionAttr(mallocFunc),
-                                  cumulativeSize)
-            .getResult(0);
-    auto structElementType = TypeConverter::convert(elementType, getModule());
-    auto elementPtrType = LLVM::LLVMType::get(
-        op->getContext(), structElementType.cast<LLVM::LLVMType>()
-                              .getUnderlyingType()
-                              ->getPointerTo());
+        createAllocationCall(op, rewriter, cumulativeSize, getAlignment(op));
     allocated = rewriter.create<LLVM::BitcastOp>(op->getLoc(), elementPtrType,
                                                  ArrayRef<Value *>(allocated));
 
@@ -642,11 +853,59 @@ struct AllocOpLowering : public LLVMLegalizationPattern<AllocOp> {
     // Return the final value of the descriptor.
     return {memRefDescriptor};
   }
+
+  // Create a call allocating a buffer of `size` bytes with the given
+  // alignment, and return the resulting i8* pointer.
+  Value *createAllocationCall(Operation *op, FuncBuilder &rewriter,
+                              Value *size, uint64_t alignment) const {
+    auto loc = op->getLoc();
+    auto indexType = getIndexType();
+    if (!clAllocFunction.empty()) {
+      Function *allocFunc = getOrInsertFunction(
+          op, rewriter, clAllocFunction,
+          rewriter.getFunctionType({indexType, indexType}, getVoidPtrType()));
+      Value *alignmentValue = createIndexConstant(rewriter, loc, alignment);
+      return rewriter
+          .create<LLVM::CallOp>(loc, getVoidPtrType(),
+                                rewriter.getFunctionAttr(allocFunc),
+                                ArrayRef<Value *>{size, alignmentValue})
+          .getResult(0);
+    }
+
+    if (alignment == 0) {
+      Function *mallocFunc = getOrInsertFunction(
+          op, rewriter, "malloc",
+          rewriter.getFunctionType(indexType, getVoidPtrType()));
+      return rewriter
+          .create<LLVM::CallOp>(loc, getVoidPtrType(),
+                                rewriter.getFunctionAttr(mallocFunc), size)
+          .getResult(0);
+    }
+
+    // `aligned_alloc` requires the size to be a multiple of the alignment.
+    Value *alignmentValue = createIndexConstant(rewriter, loc, alignment);
+    Value *alignmentMinusOne =
+        createIndexConstant(rewriter, loc, alignment - 1);
+    Value *paddedSize = rewriter.create<LLVM::AddOp>(
+        loc, indexType, ArrayRef<Value *>{size, alignmentMinusOne});
+    Value *numChunks = rewriter.create<LLVM::UDivOp>(
+        loc, indexType, ArrayRef<Value *>{paddedSize, alignmentValue});
+    Value *roundedSize = rewriter.create<LLVM::MulOp>(
+        loc, indexType, ArrayRef<Value *>{numChunks, alignmentValue});
+    Function *alignedAllocFunc = getOrInsertFunction(
+        op, rewriter, "aligned_alloc",
+        rewriter.getFunctionType({indexType, indexType}, getVoidPtrType()));
+    return rewriter
+        .create<LLVM::CallOp>(loc, getVoidPtrType(),
+                              rewriter.getFunctionAttr(alignedAllocFunc),
+                              ArrayRef<Value *>{alignmentValue, roundedSize})
+        .getResult(0);
+  }
 };
 
-// A `dealloc` is converted into a call to `free` on the underlying data buffer.
-// The memref descriptor being an SSA value, there is no need to clean it up
-// in any way.
+// A `dealloc` is converted into a call to `free` on the underlying data buffer,
+// or to the runtime function set with -llvm-dealloc-fn if any.  The memref
+// descriptor being an SSA value, there is no need to clean it up in any way.
 struct DeallocOpLowering : public LLVMLegalizationPattern<DeallocOp> {
   using LLVMLegalizationPattern<DeallocOp>::LLVMLegalizationPattern;
 
@@ -654,14 +913,18 @@ struct DeallocOpLowering : public LLVMLegalizationPattern<DeallocOp> {
                                   FuncBuilder &rewriter) const override {
     assert(operands.size() == 1 && "dealloc takes one operand");
 
+    // Buffers allocated on the stack are released when their function returns.
+    if (auto *definingOp = op->getOperand(0)->getDefiningOp())
+      if (auto allocOp = definingOp->dyn_cast<AllocOp>())
+        if (canPromoteToAlloca(allocOp))
+          return {};
+
     // Insert the `free` declaration if it is not already present.
-    Function *freeFunc =
-        op->getFunction()->getModule()->getNamedFunction("free");
-    if (!freeFunc) {
-      auto freeType = rewriter.getFunctionType(getVoidPtrType(), {});
-      freeFunc = new Function(rewriter.getUnknownLoc(), "free", freeType);
-      op->getFunction()->getModule()->getFunctions().push_back(freeFunc);
-    }
+    StringRef freeName = clDeallocFunction.empty()
+                             ? StringRef("free")
+                             : StringRef(clDeallocFunction);
+    Function *freeFunc = getOrInsertFunction(
+        op, rewriter, freeName, rewriter.getFunctionType(getVoidPtrType(), {}));
 
     auto *type =
         operands[0]->getType().cast<LLVM::LLVMType>().getUnderlyingType();
@@ -759,6 +1022,35 @@ struct MemRefCastOpLowering : public LLVMLegalizationPattern<MemRefCastOp> {
   }
 };
 
+// A `view` is converted to the buffer pointer of its operand: the view is
+// statically shaped, and its strides and offset are folded into the accesses to
+// its elements.
+struct ViewOpLowering : public LLVMLegalizationPattern<ViewOp> {
+  using LLVMLegalizationPattern<ViewOp>::LLVMLegalizationPattern;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!LLVMLegalizationPattern<ViewOp>::match(op))
+      return matchFailure();
+    auto viewOp = op->cast<ViewOp>();
+    MemRefType sourceType = viewOp.getOperand()->getType().cast<MemRefType>();
+    return (isSupportedMemRefType(viewOp.getType()) &&
+            isSupportedMemRefType(sourceType))
+               ? matchSuccess()
+               : matchFailure();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto viewOp = op->cast<ViewOp>();
+    auto sourceType = viewOp.getOperand()->getType().cast<MemRefType>();
+    auto elementTypePtr =
+        TypeConverter::getMemRefElementPtrType(viewOp.getType(), getModule());
+    return {extractMemRefElementPtr(rewriter, op->getLoc(), operands[0],
+                                    elementTypePtr,
+                                    sourceType.hasStaticShape())};
+  }
+};
+
 // A `dim` is converted to a constant for static sizes and to an access to the
 // size stored in the memref descriptor for dynamic sizes.
 struct DimOpLowering : public LLVMLegalizationPattern<DimOp> {
@@ -803,6 +1095,10 @@ struct DimOpLowering : public LLVMLegalizationPattern<DimOp> {
   }
 };
 
+// Name of the attribute marking the memory accesses proven to stay within the
+// bounds of their memref, see createAnnotateMemRefBoundsPass.
+static constexpr const char *kInBoundsAttrName = "in_bounds";
+
 // Common base for load and store operations on MemRefs.  Restricts the match
 // to supported MemRef types.  Provides functionality to emit code accessing a
 // specific element of the underlying data buffer.
@@ -811,6 +1107,22 @@ struct LoadStoreOpLowering : public LLVMLegalizationPattern<Derived> {
   using LLVMLegalizationPattern<Derived>::LLVMLegalizationPattern;
   using Base = LoadStoreOpLowering<Derived>;
 
+  // Return true if `op` is marked as accessing its memref in bounds, in which
+  // case the pointers to the elements it accesses are inbounds GEPs.
+  static bool isInBounds(Operation *op) {
+    auto inBounds = op->getAttrOfType<BoolAttr>(kInBoundsAttrName);
+    return inBounds && inBounds.getValue();
+  }
+
+  // Get the attributes of a GEP computing the address of an element, which is
+  // inbounds if `inBounds` is set.
+  static SmallVector<NamedAttribute, 1> getGEPAttrs(FuncBuilder &rewriter,
+                                                    bool inBounds) {
+    if (!inBounds)
+      return {};
+    return {rewriter.getNamedAttr("inbounds", rewriter.getBoolAttr(true))};
+  }
+
   PatternMatchResult match(Operation *op) const override {
     if (!LLVMLegalizationPattern<Derived>::match(op))
       return this->matchFailure();
@@ -820,100 +1132,189 @@ struct LoadStoreOpLowering : public LLVMLegalizationPattern<Derived> {
                                        : this->matchFailure();
   }
 
-  // Given subscript indices and array sizes in row-major order,
+  // Get the strides of a memref of `type` described by `descriptor`, i.e. the
+  // distance between consecutive elements along each dimension, which is the
+  // product of the sizes of the following dimensions.  The stride of the
+  // innermost dimension, which is 1, is returned as null so that no
+  // multiplication is emitted for it.  The strides depending on dynamic sizes
+  // are computed right after the definition of the descriptor rather than at
+  // each access: they are computed outside of the loops accessing the memref,
+  // and the copies created by each access are merged by -cse.  The strides of
+  // a strided layout are the static strides of the type instead.
+  SmallVector<Value *, 4> getStrides(FuncBuilder &rewriter, Location loc,
+                                     MemRefType type,
+                                     Value *memRefDescriptor) const {
+    if (!type.getAffineMaps().empty()) {
+      SmallVector<int64_t, 4> layoutStrides;
+      int64_t offset;
+      (void)getStridesAndOffset(type, layoutStrides, offset);
+      SmallVector<Value *, 4> strides;
+      for (int64_t stride : layoutStrides)
+        strides.push_back(stride == 1 ? nullptr
+                                      : this->createIndexConstant(rewriter, loc,
+                                                                  stride));
+      return strides;
+    }
+
+    auto shape = type.getShape();
+    FuncBuilder builder(rewriter.getInsertionBlock(),
+                        rewriter.getInsertionPoint());
+    if (!type.hasStaticShape()) {
+      if (auto *def = memRefDescriptor->getDefiningOp())
+        builder.setInsertionPoint(def->getBlock(),
+                                  std::next(Block::iterator(def)));
+      else
+        builder.setInsertionPointToStart(
+            cast<BlockArgument>(memRefDescriptor)->getOwner());
+    }
+
+    // Dynamic sizes are extracted from the descriptor, where they start from
+    // the position 1 (the buffer is at position 0).  The static sizes are
+    // accumulated into a constant factor of the stride.
+    SmallVector<Value *, 4> strides(shape.size(), nullptr);
+    unsigned dynamicSizeIdx = 1 + type.getNumDynamicDims();
+    int64_t staticStride = 1;
+    Value *dynamicStride = nullptr;
+    for (int i = shape.size() - 1; i > 0; --i) {
+      if (shape[i] == -1) {
+        Value *size = builder.create<LLVM::ExtractValueOp>(
+            loc, this->getIndexType(), memRefDescriptor,
+            this->getIntegerArrayAttr(builder, --dynamicSizeIdx));
+        dynamicStride =
+            dynamicStride ? builder.create<LLVM::MulOp>(
+                                loc, this->getIndexType(),
+                                ArrayRef<Value *>{dynamicStride, size})
+                          : size;
+      } else {
+        staticStride *= shape[i];
+      }
+
+      if (!dynamicStride) {
+        if (staticStride != 1)
+          strides[i - 1] =
+              this->createIndexConstant(builder, loc, staticStride);
+      } else if (staticStride == 1) {
+        strides[i - 1] = dynamicStride;
+      } else {
+        strides[i - 1] = builder.create<LLVM::MulOp>(
+            loc, this->getIndexType(),
+            ArrayRef<Value *>{
+                dynamicStride,
+                this->createIndexConstant(builder, loc, staticStride)});
+      }
+    }
+    return strides;
+  }
+
+  // Given subscript indices and strides in row-major order,
   //   i_n, i_{n-1}, ..., i_1
-  //   s_n, s_{n-1}, ..., s_1
+  //   t_n, t_{n-1}, ..., t_1
   // obtain a value that corresponds to the linearized subscript
-  //   \sum_k i_k * \prod_{j=1}^{k-1} s_j
-  // by accumulating the running linearized value.
-  // Note that `indices` and `allocSizes` are passed in the same order as they
-  // appear in load/store operations and memref type declarations.
+  //   \sum_k i_k * t_k
+  // where null strides stand for 1.  Unlike the Horner scheme on the sizes,
+  // the products are independent of each other and only depend on a single
+  // induction variable, which makes them amenable to strength reduction.
   Value *linearizeSubscripts(FuncBuilder &builder, Location loc,
                              ArrayRef<Value *> indices,
-                             ArrayRef<Value *> allocSizes) const {
-    assert(indices.size() == allocSizes.size() &&
-           "mismatching number of indices and allocation sizes");
+                             ArrayRef<Value *> strides) const {
+    assert(indices.size() == strides.size() &&
+           "mismatching number of indices and strides");
     assert(!indices.empty() && "cannot linearize a 0-dimensional access");
 
-    Value *linearized = indices.front();
-    for (int i = 1, nSizes = allocSizes.size(); i < nSizes; ++i) {
-      linearized = builder.create<LLVM::MulOp>(
-          loc, this->getIndexType(),
-          ArrayRef<Value *>{linearized, allocSizes[i]});
-      linearized = builder.create<LLVM::AddOp>(
-          loc, this->getIndexType(), ArrayRef<Value *>{linearized, indices[i]});
+    Value *linearized = nullptr;
+    for (int i = 0, nStrides = strides.size(); i < nStrides; ++i) {
+      Value *term = indices[i];
+      if (strides[i])
+        term = builder.create<LLVM::MulOp>(
+            loc, this->getIndexType(), ArrayRef<Value *>{term, strides[i]});
+      linearized = linearized ? builder.create<LLVM::AddOp>(
+                                    loc, this->getIndexType(),
+                                    ArrayRef<Value *>{linearized, term})
+                              : term;
     }
     return linearized;
   }
 
+  // Add the offset of the layout of `type` to the linearized `subscript`,
+  // which is null for a 0-dimensional access.  Returns null if the subscript
+  // is null and the offset is zero.
+  Value *addLayoutOffset(FuncBuilder &builder, Location loc, MemRefType type,
+                         Value *subscript) const {
+    int64_t offset = getLayoutOffset(type);
+    if (offset == 0)
+      return subscript;
+    Value *offsetValue = this->createIndexConstant(builder, loc, offset);
+    if (!subscript)
+      return offsetValue;
+    return builder.create<LLVM::AddOp>(
+        loc, this->getIndexType(), ArrayRef<Value *>{subscript, offsetValue});
+  }
+
+  // Return true if the consecutive elements along `dim` of a memref of `type`
+  // are adjacent in memory.
+  static bool hasUnitStride(MemRefType type, int dim) {
+    SmallVector<int64_t, 4> strides;
+    int64_t offset;
+    return dim >= 0 && succeeded(getStridesAndOffset(type, strides, offset)) &&
+           strides[dim] == 1;
+  }
+
   // Given the MemRef type, a descriptor and a list of indices, extract the data
   // buffer pointer from the descriptor, convert multi-dimensional subscripts
-  // into a linearized index (using dynamic size data from the descriptor if
-  // necessary) and get the pointer to the buffer element identified by the
-  // indices.
-  Value *getElementPtr(Location loc, Type elementTypePtr,
-                       ArrayRef<int64_t> shape, Value *memRefDescriptor,
-                       ArrayRef<Value *> indices, FuncBuilder &rewriter) const {
-    // Get the list of MemRef sizes.  Static sizes are defined as constants.
-    // Dynamic sizes are extracted from the MemRef descriptor, where they start
-    // from the position 1 (the buffer is at position 0).
-    SmallVector<Value *, 4> sizes;
-    unsigned dynamicSizeIdx = 1;
-    for (int64_t s : shape) {
-      if (s == -1) {
-        Value *size = rewriter.create<LLVM::ExtractValueOp>(
-            loc, this->getIndexType(), memRefDescriptor,
-            this->getIntegerArrayAttr(rewriter, dynamicSizeIdx++));
-        sizes.push_back(size);
-      } else {
-        sizes.push_back(this->createIndexConstant(rewriter, loc, s));
-      }
-    }
-
+  // into a linearized index (using the strides derived from the dynamic sizes
+  // of the descriptor if necessary) and get the pointer to the buffer element
+  // identified by the indices.
+  Value *getElementPtr(Location loc, Type elementTypePtr, MemRefType type,
+                       Value *memRefDescriptor, ArrayRef<Value *> indices,
+                       FuncBuilder &rewriter, bool inBounds) const {
     // The second and subsequent operands are access subscripts.  Obtain the
     // linearized address in the buffer.
-    Value *subscript = linearizeSubscripts(rewriter, loc, indices, sizes);
+    auto strides = getStrides(rewriter, loc, type, memRefDescriptor);
+    Value *subscript = linearizeSubscripts(rewriter, loc, indices, strides);
+    subscript = addLayoutOffset(rewriter, loc, type, subscript);
 
     Value *dataPtr = rewriter.create<LLVM::ExtractValueOp>(
         loc, elementTypePtr, memRefDescriptor,
         this->getIntegerArrayAttr(rewriter, 0));
     return rewriter.create<LLVM::GEPOp>(loc, elementTypePtr,
                                         ArrayRef<Value *>{dataPtr, subscript},
-                                        ArrayRef<NamedAttribute>{});
+                                        getGEPAttrs(rewriter, inBounds));
   }
   // This is a getElementPtr variant, where the value is a direct raw pointer.
   // If a shape is empty, we are dealing with a zero-dimensional memref. Return
-  // the pointer unmodified in this case.  Otherwise, linearize subscripts to
-  // obtain the offset with respect to the base pointer.  Use this offset to
-  // compute and return the element pointer.
-  Value *getRawElementPtr(Location loc, Type elementTypePtr,
-                          ArrayRef<int64_t> shape, Value *rawDataPtr,
-                          ArrayRef<Value *> indices,
-                          FuncBuilder &rewriter) const {
-    if (shape.empty())
-      return rawDataPtr;
-
-    SmallVector<Value *, 4> sizes;
-    for (int64_t s : shape) {
-      sizes.push_back(this->createIndexConstant(rewriter, loc, s));
+  // the pointer unmodified in this case, unless its layout has an offset.
+  // Otherwise, linearize subscripts to obtain the offset with respect to the
+  // base pointer.  Use this offset to compute and return the element pointer.
+  Value *getRawElementPtr(Location loc, Type elementTypePtr, MemRefType type,
+                          Value *rawDataPtr, ArrayRef<Value *> indices,
+                          FuncBuilder &rewriter, bool inBounds) const {
+    Value *subscript = nullptr;
+    if (type.getRank() != 0) {
+      auto strides = getStrides(rewriter, loc, type, rawDataPtr);
+      subscript = linearizeSubscripts(rewriter, loc, indices, strides);
     }
-
-    Value *subscript = linearizeSubscripts(rewriter, loc, indices, sizes);
+    subscript = addLayoutOffset(rewriter, loc, type, subscript);
+    if (!subscript)
+      return rawDataPtr;
     return rewriter.create<LLVM::GEPOp>(
         loc, elementTypePtr, ArrayRef<Value *>{rawDataPtr, subscript},
-        ArrayRef<NamedAttribute>{});
+        getGEPAttrs(rewriter, inBounds));
   }
 
+  // Get the pointer to the element at `indices` in the memref of `type`.  The
+  // GEP is inbounds if `inBounds` is set, i.e. if the element is known to be
+  // within the bounds of the memref.
   Value *getDataPtr(Location loc, MemRefType type, Value *dataPtr,
                     ArrayRef<Value *> indices, FuncBuilder &rewriter,
-                    llvm::Module &module) const {
+                    llvm::Module &module, bool inBounds = false) const {
     auto ptrType = TypeConverter::getMemRefElementPtrType(type, module);
-    auto shape = type.getShape();
     if (type.hasStaticShape()) {
       // NB: If memref was statically-shaped, dataPtr is pointer to raw data.
-      return getRawElementPtr(loc, ptrType, shape, dataPtr, indices, rewriter);
+      return getRawElementPtr(loc, ptrType, type, dataPtr, indices, rewriter,
+                              inBounds);
     } else {
-      return getElementPtr(loc, ptrType, shape, dataPtr, indices, rewriter);
+      return getElementPtr(loc, ptrType, type, dataPtr, indices, rewriter,
+                           inBounds);
     }
   }
 };
@@ -928,8 +1329,9 @@ struct LoadOpLowering : public LoadStoreOpLowering<LoadOp> {
     auto loadOp = op->cast<LoadOp>();
     auto type = loadOp.getMemRefType();
 
-    Value *dataPtr = getDataPtr(op->getLoc(), type, operands.front(),
-                                operands.drop_front(), rewriter, getModule());
+    Value *dataPtr =
+        getDataPtr(op->getLoc(), type, operands.front(), operands.drop_front(),
+                   rewriter, getModule(), isInBounds(op));
     auto elementType =
         TypeConverter::convert(type.getElementType(), getModule());
 
@@ -950,14 +1352,480 @@ struct StoreOpLowering : public LoadStoreOpLowering<StoreOp> {
     auto storeOp = op->cast<StoreOp>();
     auto type = storeOp.getMemRefType();
 
-    Value *dataPtr = getDataPtr(op->getLoc(), type, operands[1],
-                                operands.drop_front(2), rewriter, getModule());
+    Value *dataPtr =
+        getDataPtr(op->getLoc(), type, operands[1], operands.drop_front(2),
+                   rewriter, getModule(), isInBounds(op));
 
     rewriter.create<LLVM::StoreOp>(op->getLoc(), operands[0], dataPtr);
     return {};
   }
 };
 
+// Common base for the lowering of 1-D vector transfers into vector memory
+// accesses, which avoids staging the vector in a temporary buffer.  The vector
+// is transferred along the memref dimension its permutation map selects:
+//   - contiguously along the innermost dimension, with a vector load or store;
+//   - with a stride along an outer dimension, with a gather or scatter;
+//   - broadcast from a scalar load if the map selects no dimension, for reads.
+// The lanes past the end of the transferred dimension are masked out with a
+// masked intrinsic, and reads fill them with the padding value.  A read without
+// a padding value is statically in bounds and isn't masked.  The accesses must
+// be in bounds along the other dimensions and the transfer must not start
+// before the beginning of the memref.
+template <typename Derived>
+struct VectorTransferOpLowering : public LoadStoreOpLowering<Derived> {
+  using LoadStoreOpLowering<Derived>::LoadStoreOpLowering;
+  using Base = VectorTransferOpLowering<Derived>;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!LoadStoreOpLowering<Derived>::match(op))
+      return this->matchFailure();
+    auto transfer = op->cast<Derived>();
+    if (transfer.getVectorType().getRank() != 1 ||
+        transfer.getMemRefType().getRank() == 0)
+      return this->matchFailure();
+    return this->matchSuccess();
+  }
+
+  // Get the memref dimension along which `transfer` accesses the vector, or -1
+  // if it broadcasts a scalar.
+  static int getTransferDim(Derived transfer) {
+    auto expr = transfer.getPermutationMap().getResult(0);
+    if (auto dim = expr.template dyn_cast<AffineDimExpr>())
+      return dim.getPosition();
+    return -1;
+  }
+
+  // Get the MLIR type wrapping the LLVM vector type with `numElements`
+  // elements of `elementType`.
+  LLVM::LLVMType getLLVMVectorType(llvm::Type *elementType,
+                                   unsigned numElements) const {
+    llvm::sys::SmartScopedLock<true> lock(
+        this->dialect.getLLVMContextMutex());
+    return LLVM::LLVMType::get(this->dialect.getContext(),
+                               llvm::VectorType::get(elementType, numElements));
+  }
+
+  // Get the MLIR type wrapping the LLVM vector of `numElements` indices.
+  LLVM::LLVMType getIndexVectorType(unsigned numElements) const {
+    return getLLVMVectorType(this->getIndexType().getUnderlyingType(),
+                             numElements);
+  }
+
+  // Get the size of the dimension `dim` of a memref of `type` described by
+  // `descriptor`.
+  Value *getSize(FuncBuilder &rewriter, Location loc, MemRefType type,
+                 Value *descriptor, unsigned dim) const {
+    auto shape = type.getShape();
+    if (shape[dim] != -1)
+      return this->createIndexConstant(rewriter, loc, shape[dim]);
+    int64_t position = 1;
+    for (unsigned i = 0; i < dim; ++i)
+      if (shape[i] == -1)
+        ++position;
+    return rewriter.create<LLVM::ExtractValueOp>(
+        loc, this->getIndexType(), descriptor,
+        this->getIntegerArrayAttr(rewriter, position));
+  }
+
+  // Get the distance between consecutive elements along `dim`.
+  Value *getStride(FuncBuilder &rewriter, Location loc, MemRefType type,
+                   Value *descriptor, unsigned dim) const {
+    Value *stride = this->getStrides(rewriter, loc, type, descriptor)[dim];
+    return stride ? stride : this->createIndexConstant(rewriter, loc, 1);
+  }
+
+  // Get the vector of index values 0, 1, ..., `numElements` - 1.
+  Value *getLaneIndices(FuncBuilder &rewriter, Location loc,
+                        unsigned numElements) const {
+    auto indexType = rewriter.getIntegerType(
+        this->getModule().getDataLayout().getPointerSizeInBits());
+    SmallVector<Attribute, 8> lanes;
+    lanes.reserve(numElements);
+    for (unsigned i = 0; i < numElements; ++i)
+      lanes.push_back(rewriter.getIntegerAttr(indexType, i));
+    auto attr = rewriter.getDenseElementsAttr(
+        VectorType::get({numElements}, indexType), lanes);
+    return rewriter.create<LLVM::ConstantOp>(
+        loc, getIndexVectorType(numElements), attr);
+  }
+
+  // Get the mask of the lanes `i` such that `index` + `i` < `size`.
+  Value *getMask(FuncBuilder &rewriter, Location loc, Value *index,
+                 Value *size, unsigned numElements) const {
+    auto indexVectorType = getIndexVectorType(numElements);
+    Value *remaining = rewriter.create<LLVM::SubOp>(
+        loc, this->getIndexType(), ArrayRef<Value *>{size, index});
+    auto predicate = rewriter.getNamedAttr(
+        "predicate",
+        rewriter.getI64IntegerAttr(static_cast<int64_t>(CmpIPredicate::SLT)));
+    return rewriter.create<LLVM::ICmpOp>(
+        loc,
+        getLLVMVectorType(llvm::Type::getInt1Ty(this->getContext()),
+                          numElements),
+        ArrayRef<Value *>{
+            getLaneIndices(rewriter, loc, numElements),
+            this->splat(rewriter, loc, remaining, indexVectorType)},
+        predicate);
+  }
+
+  // Get the mask enabling all the `numElements` lanes.
+  Value *getAllOnesMask(FuncBuilder &rewriter, Location loc,
+                        unsigned numElements) const {
+    auto maskType = getLLVMVectorType(
+        llvm::Type::getInt1Ty(this->getContext()), numElements);
+    auto allOnes = rewriter.getSplatElementsAttr(
+        VectorType::get({numElements}, rewriter.getI1Type()),
+        rewriter.getIntegerAttr(rewriter.getI1Type(), 1));
+    return rewriter.create<LLVM::ConstantOp>(loc, maskType, allOnes);
+  }
+
+  // Get the vector of pointers to the elements accessed along `dim` from
+  // `elementPtr`.
+  Value *getElementPtrs(FuncBuilder &rewriter, Location loc, MemRefType type,
+                        Value *descriptor, unsigned dim, Value *elementPtr,
+                        unsigned numElements, bool inBounds) const {
+    auto indexVectorType = getIndexVectorType(numElements);
+    Value *stride = getStride(rewriter, loc, type, descriptor, dim);
+    Value *offsets = rewriter.create<LLVM::MulOp>(
+        loc, indexVectorType,
+        ArrayRef<Value *>{getLaneIndices(rewriter, loc, numElements),
+                          this->splat(rewriter, loc, stride, indexVectorType)});
+    auto ptrType = elementPtr->getType().cast<LLVM::LLVMType>();
+    return rewriter.create<LLVM::GEPOp>(
+        loc, getLLVMVectorType(ptrType.getUnderlyingType(), numElements),
+        ArrayRef<Value *>{elementPtr, offsets},
+        this->getGEPAttrs(rewriter, inBounds));
+  }
+
+  // Get the pointer to the vector starting at `elementPtr`.
+  Value *getVectorPtr(FuncBuilder &rewriter, Location loc, Value *elementPtr,
+                      LLVM::LLVMType vectorType) const {
+    return rewriter.create<LLVM::BitcastOp>(loc,
+                                            this->getPointerType(vectorType),
+                                            ArrayRef<Value *>{elementPtr});
+  }
+
+  // Get the "alignment" attribute of the accesses to the elements of `type`.
+  NamedAttribute getAlignment(FuncBuilder &rewriter, MemRefType type) const {
+    return rewriter.getNamedAttr(
+        "alignment", rewriter.getI32IntegerAttr(getElementSizeInBytes(type)));
+  }
+};
+
+// A vector transfer read is lowered to a vector load, a gather or a scalar load
+// and a splat.  The padded reads are masked, unless they are marked as in
+// bounds.
+struct VectorTransferReadOpLowering
+    : public VectorTransferOpLowering<VectorTransferReadOp> {
+  using Base::Base;
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto transfer = op->cast<VectorTransferReadOp>();
+    auto type = transfer.getMemRefType();
+    auto loc = op->getLoc();
+    unsigned numElements = transfer.getVectorType().getNumElements();
+    auto vectorType =
+        TypeConverter::convert(transfer.getVectorType(), getModule())
+            .cast<LLVM::LLVMType>();
+    auto elementType =
+        TypeConverter::convert(type.getElementType(), getModule());
+    auto indices = operands.slice(1, type.getRank());
+    bool inBounds = isInBounds(op);
+    bool isMasked = transfer.getPaddingValue().hasValue() && !inBounds;
+
+    Value *elementPtr = getDataPtr(loc, type, operands.front(), indices,
+                                   rewriter, getModule(), inBounds);
+    int dim = getTransferDim(transfer);
+    if (dim < 0) {
+      Value *scalar = rewriter.create<LLVM::LoadOp>(
+          loc, elementType, ArrayRef<Value *>{elementPtr});
+      return {splat(rewriter, loc, scalar, vectorType)};
+    }
+
+    auto alignment = getAlignment(rewriter, type);
+    Value *mask = nullptr, *passThru = nullptr;
+    if (isMasked) {
+      mask = getMask(rewriter, loc, indices[dim],
+                     getSize(rewriter, loc, type, operands.front(), dim),
+                     numElements);
+      passThru = splat(rewriter, loc, operands.back(), vectorType);
+    }
+
+    if (hasUnitStride(type, dim)) {
+      Value *vectorPtr = getVectorPtr(rewriter, loc, elementPtr, vectorType);
+      if (!isMasked)
+        return {rewriter.create<LLVM::LoadOp>(
+            loc, vectorType, ArrayRef<Value *>{vectorPtr}, alignment)};
+      return {rewriter.create<LLVM::MaskedLoadOp>(
+          loc, vectorType, ArrayRef<Value *>{vectorPtr, mask, passThru},
+          alignment)};
+    }
+
+    Value *elementPtrs = getElementPtrs(rewriter, loc, type, operands.front(),
+                                        dim, elementPtr, numElements,
+                                        inBounds);
+    if (!isMasked) {
+      mask = getAllOnesMask(rewriter, loc, numElements);
+      passThru =
+          rewriter.create<LLVM::UndefOp>(loc, vectorType, ArrayRef<Value *>{});
+    }
+    return {rewriter.create<LLVM::MaskedGatherOp>(
+        loc, vectorType, ArrayRef<Value *>{elementPtrs, mask, passThru},
+        alignment)};
+  }
+};
+
+// A vector transfer write is lowered to a masked vector store or a scatter.
+// The writes marked as in bounds are not masked.  Broadcasting writes are not
+// supported.
+struct VectorTransferWriteOpLowering
+    : public VectorTransferOpLowering<VectorTransferWriteOp> {
+  using Base::Base;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!Base::match(op) ||
+        getTransferDim(op->cast<VectorTransferWriteOp>()) < 0)
+      return matchFailure();
+    return matchSuccess();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto transfer = op->cast<VectorTransferWriteOp>();
+    auto type = transfer.getMemRefType();
+    auto loc = op->getLoc();
+    unsigned numElements = transfer.getVectorType().getNumElements();
+    auto vectorType = operands[0]->getType().cast<LLVM::LLVMType>();
+    auto indices = operands.drop_front(2);
+    unsigned dim = getTransferDim(transfer);
+
+    bool inBounds = isInBounds(op);
+
+    Value *elementPtr = getDataPtr(loc, type, operands[1], indices, rewriter,
+                                   getModule(), inBounds);
+    auto alignment = getAlignment(rewriter, type);
+    if (inBounds && hasUnitStride(type, dim)) {
+      Value *vectorPtr = getVectorPtr(rewriter, loc, elementPtr, vectorType);
+      rewriter.create<LLVM::StoreOp>(
+          loc, ArrayRef<Value *>{operands[0], vectorPtr}, alignment);
+      return {};
+    }
+    Value *mask =
+        inBounds
+            ? getAllOnesMask(rewriter, loc, numElements)
+            : getMask(rewriter, loc, indices[dim],
+                      getSize(rewriter, loc, type, operands[1], dim),
+                      numElements);
+    if (hasUnitStride(type, dim)) {
+      Value *vectorPtr = getVectorPtr(rewriter, loc, elementPtr, vectorType);
+      rewriter.create<LLVM::MaskedStoreOp>(
+          loc, ArrayRef<Value *>{operands[0], vectorPtr, mask}, alignment);
+      return {};
+    }
+    Value *elementPtrs = getElementPtrs(rewriter, loc, type, operands[1], dim,
+                                        elementPtr, numElements, inBounds);
+    rewriter.create<LLVM::MaskedScatterOp>(
+        loc, ArrayRef<Value *>{operands[0], elementPtrs, mask}, alignment);
+    return {};
+  }
+};
+
+// A 1-D vector extract_element is lowered to an extractelement.  The other
+// aggregates have no vector type in the LLVM IR dialect.
+struct ExtractElementOpLowering
+    : public OneToOneLLVMOpLowering<ExtractElementOp, LLVM::ExtractElementOp> {
+  using Super::Super;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!Super::match(op))
+      return matchFailure();
+    auto vectorType = op->cast<ExtractElementOp>()
+                          .getAggregate()
+                          ->getType()
+                          .dyn_cast<VectorType>();
+    if (!vectorType || vectorType.getRank() != 1)
+      return matchFailure();
+    return matchSuccess();
+  }
+};
+
+// A vector insert_element is lowered to an insertelement, which takes the
+// vector before the inserted value.
+struct VectorInsertElementOpLowering
+    : public LLVMLegalizationPattern<VectorInsertElementOp> {
+  using LLVMLegalizationPattern<
+      VectorInsertElementOp>::LLVMLegalizationPattern;
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    return {rewriter.create<LLVM::InsertElementOp>(
+        op->getLoc(), operands[1]->getType(),
+        ArrayRef<Value *>{operands[1], operands[0], operands[2]})};
+  }
+};
+
+// A vector shuffle is lowered to a shufflevector with the same mask.
+struct VectorShuffleOpLowering
+    : public OneToOneLLVMOpLowering<VectorShuffleOp, LLVM::ShuffleVectorOp> {
+  using Super::Super;
+};
+
+// A vector reduction is lowered to the vector reduction intrinsic of its kind
+// and element type.  The floating-point additions and multiplications start
+// from the identity of the combiner, and are reassociated like the vector
+// reduction.
+struct VectorReduceOpLowering : public LLVMLegalizationPattern<VectorReduceOp> {
+  using LLVMLegalizationPattern<VectorReduceOp>::LLVMLegalizationPattern;
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto reduce = op->cast<VectorReduceOp>();
+    auto kind = reduce.getKind();
+    auto elementType = reduce.getType();
+
+    if (elementType.isa<IntegerType>()) {
+      if (kind == "add")
+        return lower<LLVM::VectorReduceAddOp>(op, operands, rewriter);
+      if (kind == "mul")
+        return lower<LLVM::VectorReduceMulOp>(op, operands, rewriter);
+      if (kind == "min")
+        return lower<LLVM::VectorReduceSMinOp>(op, operands, rewriter);
+      if (kind == "max")
+        return lower<LLVM::VectorReduceSMaxOp>(op, operands, rewriter);
+      if (kind == "and")
+        return lower<LLVM::VectorReduceAndOp>(op, operands, rewriter);
+      if (kind == "or")
+        return lower<LLVM::VectorReduceOrOp>(op, operands, rewriter);
+      assert(kind == "xor" && "unknown integer reduction kind");
+      return lower<LLVM::VectorReduceXOrOp>(op, operands, rewriter);
+    }
+
+    if (kind == "min")
+      return lower<LLVM::VectorReduceFMinOp>(op, operands, rewriter);
+    if (kind == "max")
+      return lower<LLVM::VectorReduceFMaxOp>(op, operands, rewriter);
+    bool isAdd = kind == "add";
+    assert((isAdd || kind == "mul") && "unknown floating-point reduction kind");
+    auto identity = rewriter.getFloatAttr(elementType, isAdd ? -0.0 : 1.0);
+    Value *acc = rewriter.create<LLVM::ConstantOp>(
+        op->getLoc(), TypeConverter::convert(elementType, getModule()),
+        identity);
+    Value *accAndVector[] = {acc, operands.front()};
+    if (isAdd)
+      return lower<LLVM::VectorReduceFAddOp>(op, accAndVector, rewriter);
+    return lower<LLVM::VectorReduceFMulOp>(op, accAndVector, rewriter);
+  }
+
+  // Create a `TargetOp` reducing `operands` into the converted result type of
+  // `op`.
+  template <typename TargetOp>
+  SmallVector<Value *, 4> lower(Operation *op, ArrayRef<Value *> operands,
+                                FuncBuilder &rewriter) const {
+    auto resultType =
+        TypeConverter::convert(op->getResult(0)->getType(), getModule());
+    return {rewriter.create<TargetOp>(op->getLoc(), resultType, operands)};
+  }
+};
+
+// A vector broadcast is lowered to an insertelement into an undefined vector,
+// whose first element is then shuffled to all the others.  Only the broadcasts
+// to 1-D vectors, which have a vector type in the LLVM IR dialect, are
+// supported.
+struct VectorBroadcastOpLowering
+    : public LLVMLegalizationPattern<VectorBroadcastOp> {
+  using LLVMLegalizationPattern<VectorBroadcastOp>::LLVMLegalizationPattern;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!LLVMLegalizationPattern<VectorBroadcastOp>::match(op))
+      return matchFailure();
+    if (op->cast<VectorBroadcastOp>().getVectorType().getRank() != 1)
+      return matchFailure();
+    return matchSuccess();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto vectorType = TypeConverter::convert(op->getResult(0)->getType(),
+                                             getModule())
+                          .cast<LLVM::LLVMType>();
+    return {splat(rewriter, op->getLoc(), operands.front(), vectorType)};
+  }
+};
+
+// A vector shape_cast between 1-D vectors, which have the same number of
+// elements, is a no-op.  The other shape casts would reorganize the arrays of
+// 1-D vectors that the n-D vectors are converted to, and are not supported.
+struct VectorShapeCastOpLowering
+    : public LLVMLegalizationPattern<VectorShapeCastOp> {
+  using LLVMLegalizationPattern<VectorShapeCastOp>::LLVMLegalizationPattern;
+
+  PatternMatchResult match(Operation *op) const override {
+    if (!LLVMLegalizationPattern<VectorShapeCastOp>::match(op))
+      return matchFailure();
+    auto shapeCast = op->cast<VectorShapeCastOp>();
+    if (shapeCast.getSourceVectorType().getRank() != 1 ||
+        shapeCast.getResultVectorType().getRank() != 1)
+      return matchFailure();
+    return matchSuccess();
+  }
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    return {operands.front()};
+  }
+};
+
+// A vector outer product is lowered row by row: the i-th row of the result is
+// the RHS scaled by the i-th element of the LHS, broadcast to a vector, which
+// is fused with the addition of the i-th row of the accumulator if there is
+// one.  The rows are the elements of the LLVM array of 1-D vectors that the
+// 2-D result is converted to.
+struct VectorOuterProductOpLowering
+    : public LLVMLegalizationPattern<VectorOuterProductOp> {
+  using LLVMLegalizationPattern<VectorOuterProductOp>::LLVMLegalizationPattern;
+
+  SmallVector<Value *, 4> rewrite(Operation *op, ArrayRef<Value *> operands,
+                                  FuncBuilder &rewriter) const override {
+    auto outerProduct = op->cast<VectorOuterProductOp>();
+    auto loc = op->getLoc();
+    auto resultType =
+        TypeConverter::convert(outerProduct.getType(), getModule());
+    auto rowType =
+        TypeConverter::convert(outerProduct.getRHSVectorType(), getModule())
+            .cast<LLVM::LLVMType>();
+    auto elementType = TypeConverter::convert(
+        outerProduct.getRHSVectorType().getElementType(), getModule());
+    Value *lhs = operands[0], *rhs = operands[1];
+    Value *accumulator = operands.size() > 2 ? operands[2] : nullptr;
+
+    Value *result = rewriter.create<LLVM::UndefOp>(loc, resultType,
+                                                   ArrayRef<Value *>{});
+    int64_t numRows = outerProduct.getLHSVectorType().getDimSize(0);
+    for (int64_t i = 0; i < numRows; ++i) {
+      Value *position = createIndexConstant(rewriter, loc, i);
+      Value *scalar = rewriter.create<LLVM::ExtractElementOp>(
+          loc, elementType, ArrayRef<Value *>{lhs, position});
+      Value *scale = splat(rewriter, loc, scalar, rowType);
+      auto rowPosition = getIntegerArrayAttr(rewriter, i);
+      Value *row;
+      if (accumulator) {
+        Value *accumulatorRow = rewriter.create<LLVM::ExtractValueOp>(
+            loc, rowType, accumulator, rowPosition);
+        row = rewriter.create<LLVM::FMulAddOp>(
+            loc, rowType, ArrayRef<Value *>{scale, rhs, accumulatorRow});
+      } else {
+        row = rewriter.create<LLVM::FMulOp>(loc, rowType,
+                                            ArrayRef<Value *>{scale, rhs});
+      }
+      result = rewriter.create<LLVM::InsertValueOp>(loc, resultType, result,
+                                                    row, rowPosition);
+    }
+    return {result};
+  }
+};
+
 // Base class for LLVM IR lowering terminator operations with successors.
 template <typename SourceOp, typename TargetOp>
 struct OneToOneLLVMTerminatorLowering
@@ -1080,68 +1948,458 @@ void mlir::LLVM::ensureDistinctSuccessors(Module *m) {
   }
 };
 
-/// A dialect converter from the Standard dialect to the LLVM IR dialect.
-class LLVMLowering : public DialectConversion {
-protected:
-  // Create a set of converters that live in the pass object by passing them a
-  // reference to the LLVM IR dialect.  Store the module associated with the
-  // dialect for further type conversion.
-  llvm::DenseSet<DialectOpConversion *>
-  initConverters(MLIRContext *mlirContext) override {
-    converterStorage.Reset();
-    auto *llvmDialect = static_cast<LLVM::LLVMDialect *>(
-        mlirContext->getRegisteredDialect("llvm"));
-    if (!llvmDialect) {
-      mlirContext->emitError(UnknownLoc::get(mlirContext),
-                             "LLVM IR dialect is not registered");
-      return {};
-    }
+// Name of the function of the parallel runtime executing the iterations of a
+// parallel loop over a thread pool, see mlir/ExecutionEngine/ParallelRuntime.h.
+static constexpr const char *kParallelForFunctionName = "mlir_parallel_for";
+
+// Name of the attribute marking the calls to the outlined bodies of parallel
+// loops, see createOutlineParallelLoopsPass.
+static constexpr const char *kParallelStepAttrName = "parallel.step";
+
+// Get the function with the signature expected by the parallel runtime,
+//   void (index lowerBound, index upperBound, i8 *context),
+// that calls `callee` with its bounds followed by the values packed in the
+// structure of type `contextType` pointed to by `context`.  The function is
+// created the first time it is requested.
+static Function *getOrCreateParallelThunk(Function *callee,
+                                          llvm::StructType *contextType,
+                                          Type indexType, Type voidPtrType) {
+  Module *module = callee->getModule();
+  std::string name = (callee->getName().strref() + "_thunk").str();
+  if (Function *thunk = module->getNamedFunction(name))
+    return thunk;
+
+  MLIRContext *context = callee->getContext();
+  auto loc = callee->getLoc();
+  auto *thunk = new Function(
+      loc, name,
+      FunctionType::get({indexType, indexType, voidPtrType}, {}, context));
+  module->addFunction(thunk);
+  thunk->addEntryBlock();
+  Block *entryBlock = &thunk->front();
+  FuncBuilder builder(entryBlock);
+
+  // Unpack the context and forward it to the callee.
+  Value *contextPtr = builder.create<LLVM::BitcastOp>(
+      loc, LLVM::LLVMType::get(context, contextType->getPointerTo()),
+      ArrayRef<Value *>(entryBlock->getArgument(2)));
+  Value *packed = builder.create<LLVM::LoadOp>(
+      loc, LLVM::LLVMType::get(context, contextType), contextPtr);
+  SmallVector<Value *, 8> arguments = {entryBlock->getArgument(0),
+                                       entryBlock->getArgument(1)};
+  for (unsigned i = 0, e = contextType->getNumElements(); i < e; ++i) {
+    auto position = builder.getArrayAttr(
+        builder.getIntegerAttr(builder.getIndexType(), i));
+    arguments.push_back(builder.create<LLVM::ExtractValueOp>(
+        loc, LLVM::LLVMType::get(context, contextType->getElementType(i)),
+        packed, position));
+  }
+  builder.create<LLVM::CallOp>(loc, ArrayRef<Type>(),
+                               builder.getFunctionAttr(callee), arguments);
+  builder.create<LLVM::ReturnOp>(loc, ArrayRef<Value *>(),
+                                 ArrayRef<Block *>());
+  return thunk;
+}
 
-    module = &llvmDialect->getLLVMModule();
+// Replace the given call to the outlined body of a parallel loop with a call to
+// the parallel runtime.  The call is of the form
+//   llvm.call @body(%lb, %ub, %captured...) {parallel.step: <step>}
+// and the values following the bounds are packed in a structure allocated on
+// the stack, which the runtime passes to a thunk unpacking them for the body.
+static void lowerParallelCall(Operation *op, LLVM::LLVMDialect &dialect) {
+  llvm::sys::SmartScopedLock<true> lock(dialect.getLLVMContextMutex());
+  auto loc = op->getLoc();
+  MLIRContext *context = op->getContext();
+  Module *module = op->getFunction()->getModule();
+  Function *callee = op->getAttrOfType<FunctionAttr>("callee").getValue();
+  int64_t step = op->getAttrOfType<IntegerAttr>(kParallelStepAttrName).getInt();
+
+  auto indexType = op->getOperand(0)->getType().cast<LLVM::LLVMType>();
+  llvm::Type *llvmVoidPtrType =
+      llvm::Type::getInt8PtrTy(dialect.getLLVMContext());
+  Type voidPtrType = LLVM::LLVMType::get(context, llvmVoidPtrType);
+  SmallVector<llvm::Type *, 8> capturedTypes;
+  for (unsigned i = 2, e = op->getNumOperands(); i < e; ++i) {
+    auto type = op->getOperand(i)->getType().cast<LLVM::LLVMType>();
+    capturedTypes.push_back(type.getUnderlyingType());
+  }
+  auto *contextType =
+      llvm::StructType::get(dialect.getLLVMContext(), capturedTypes);
+  Type wrappedContextType = LLVM::LLVMType::get(context, contextType);
+
+  // Allocate the context in the entry block so that it is only allocated once
+  // if the call is in a loop.
+  Block *entryBlock = &op->getFunction()->front();
+  FuncBuilder entryBuilder(entryBlock, entryBlock->begin());
+  Value *one = entryBuilder.create<LLVM::ConstantOp>(
+      loc, indexType,
+      entryBuilder.getIntegerAttr(entryBuilder.getIndexType(), 1));
+  Value *contextPtr = entryBuilder.create<LLVM::AllocaOp>(
+      loc, LLVM::LLVMType::get(context, contextType->getPointerTo()), one);
+
+  // Pack the captured values in the context.
+  FuncBuilder builder(op);
+  Value *packed = builder.create<LLVM::UndefOp>(loc, wrappedContextType,
+                                                ArrayRef<Value *>{});
+  for (unsigned i = 2, e = op->getNumOperands(); i < e; ++i) {
+    auto position = builder.getArrayAttr(
+        builder.getIntegerAttr(builder.getIndexType(), i - 2));
+    packed = builder.create<LLVM::InsertValueOp>(
+        loc, wrappedContextType, packed, op->getOperand(i), position);
+  }
+  builder.create<LLVM::StoreOp>(loc, packed, contextPtr);
+  Value *voidContextPtr = builder.create<LLVM::BitcastOp>(
+      loc, voidPtrType, ArrayRef<Value *>(contextPtr));
+
+  // Call the runtime with a pointer to the thunk.
+  Function *thunk =
+      getOrCreateParallelThunk(callee, contextType, indexType, voidPtrType);
+  llvm::Type *llvmIndexType = indexType.getUnderlyingType();
+  auto *thunkPtrType =
+      llvm::FunctionType::get(llvm::Type::getVoidTy(dialect.getLLVMContext()),
+                              {llvmIndexType, llvmIndexType, llvmVoidPtrType},
+                              /*isVarArg=*/false)
+          ->getPointerTo();
+  Type wrappedThunkPtrType = LLVM::LLVMType::get(context, thunkPtrType);
+  Value *thunkPtr = builder.create<LLVM::ConstantOp>(
+      loc, wrappedThunkPtrType, builder.getFunctionAttr(thunk));
+  Value *stepValue = builder.create<LLVM::ConstantOp>(
+      loc, indexType, builder.getIntegerAttr(builder.getIndexType(), step));
+
+  Function *parallelFor = module->getNamedFunction(kParallelForFunctionName);
+  if (!parallelFor) {
+    parallelFor = new Function(
+        builder.getUnknownLoc(), kParallelForFunctionName,
+        builder.getFunctionType(
+            {wrappedThunkPtrType, indexType, indexType, indexType, voidPtrType},
+            {}));
+    module->addFunction(parallelFor);
+  }
+  builder.create<LLVM::CallOp>(
+      loc, ArrayRef<Type>(), builder.getFunctionAttr(parallelFor),
+      ArrayRef<Value *>{thunkPtr, op->getOperand(0), op->getOperand(1),
+                        stepValue, voidContextPtr});
+  op->erase();
+}
 
-    // FIXME: this should be tablegen'ed
-    return ConversionListBuilder<
-        AddFOpLowering, AddIOpLowering, AllocOpLowering, BranchOpLowering,
-        CallIndirectOpLowering, CallOpLowering, CmpIOpLowering,
-        CondBranchOpLowering, ConstLLVMOpLowering, DeallocOpLowering,
-        DimOpLowering, DivISOpLowering, DivIUOpLowering, DivFOpLowering,
-        LoadOpLowering, MemRefCastOpLowering, MulFOpLowering, MulIOpLowering,
-        RemISOpLowering, RemIUOpLowering, RemFOpLowering, ReturnOpLowering,
-        SelectOpLowering, StoreOpLowering, SubFOpLowering,
-        SubIOpLowering>::build(&converterStorage, *llvmDialect);
+// Lower the calls to the outlined bodies of parallel loops in `m` to calls to
+// the parallel runtime.  This is done once the whole module has been converted,
+// since it creates new functions in the LLVM IR dialect.
+static void lowerParallelCalls(Module *m, LLVM::LLVMDialect &dialect) {
+  SmallVector<Operation *, 8> parallelCalls;
+  for (auto &f : *m) {
+    f.walk([&](Operation *op) {
+      if (op->isa<LLVM::CallOp>() && op->getAttr(kParallelStepAttrName))
+        parallelCalls.push_back(op);
+    });
   }
+  for (Operation *op : parallelCalls)
+    lowerParallelCall(op, dialect);
+}
 
-  // Convert types using the stored LLVM IR module.
-  Type convertType(Type t) override {
-    return TypeConverter::convert(t, *module);
+// Name of the function of the GPU runtime launching a kernel, see
+// mlir/ExecutionEngine/GPURuntime.h.
+static constexpr const char *kGPULaunchFunctionName = "mlir_gpu_launch";
+
+// Names of the attributes marking the calls launching GPU kernels, see
+// createOutlineGPUKernelsPass.
+static constexpr const char *kGPUBlockSizeAttrName = "gpu.block_size";
+static constexpr const char *kGPUStepAttrName = "gpu.step";
+
+// Get the function with the signature expected by the GPU runtime,
+//   void (i8 **params),
+// that calls the kernel `callee` with the values of types `paramTypes` pointed
+// to by the elements of `params`.  This is the layout of the parameters of the
+// kernel launches of the CUDA driver API, and the runtime calls the function to
+// execute the kernel on the host when it doesn't launch it on a GPU.  The
+// function is created the first time it is requested.
+static Function *getOrCreateGPUThunk(Function *callee,
+                                     ArrayRef<LLVM::LLVMType> paramTypes,
+                                     Type indexType, Type voidPtrType,
+                                     Type voidPtrPtrType) {
+  Module *module = callee->getModule();
+  std::string name = (callee->getName().strref() + "_thunk").str();
+  if (Function *thunk = module->getNamedFunction(name))
+    return thunk;
+
+  MLIRContext *context = callee->getContext();
+  auto loc = callee->getLoc();
+  auto *thunk = new Function(loc, name,
+                             FunctionType::get({voidPtrPtrType}, {}, context));
+  module->addFunction(thunk);
+  thunk->addEntryBlock();
+  Block *entryBlock = &thunk->front();
+  FuncBuilder builder(entryBlock);
+
+  // Load each parameter through the pointer to it, and forward them to the
+  // kernel.
+  SmallVector<Value *, 8> arguments;
+  for (auto indexedType : llvm::enumerate(paramTypes)) {
+    Value *position = builder.create<LLVM::ConstantOp>(
+        loc, indexType,
+        builder.getIntegerAttr(builder.getIndexType(), indexedType.index()));
+    Value *paramPtrPtr = builder.create<LLVM::GEPOp>(
+        loc, voidPtrPtrType,
+        ArrayRef<Value *>{entryBlock->getArgument(0), position},
+        ArrayRef<NamedAttribute>{});
+    Value *paramPtr =
+        builder.create<LLVM::LoadOp>(loc, voidPtrType, paramPtrPtr);
+    llvm::Type *paramType = indexedType.value().getUnderlyingType();
+    Value *typedParamPtr = builder.create<LLVM::BitcastOp>(
+        loc, LLVM::LLVMType::get(context, paramType->getPointerTo()),
+        ArrayRef<Value *>(paramPtr));
+    arguments.push_back(builder.create<LLVM::LoadOp>(loc, indexedType.value(),
+                                                     typedParamPtr));
   }
+  builder.create<LLVM::CallOp>(loc, ArrayRef<Type>(),
+                               builder.getFunctionAttr(callee), arguments);
+  builder.create<LLVM::ReturnOp>(loc, ArrayRef<Value *>(),
+                                 ArrayRef<Block *>());
+  return thunk;
+}
 
-  // Convert function signatures using the stored LLVM IR module.
-  FunctionType convertFunctionSignatureType(
-      FunctionType t, ArrayRef<NamedAttributeList> argAttrs,
-      SmallVectorImpl<NamedAttributeList> &convertedArgAttrs) override {
+// Replace the given call launching a GPU kernel with a call to the GPU runtime.
+// The call is of the form
+//   llvm.call @kernel(%lb_x, %ub_x, ..., %captured...)
+//       {gpu.block_size: [<x>, ...], gpu.step: [<x>, ...]}
+// with the bounds of one to three dimensions.  The grid has enough blocks along
+// each dimension to cover its iterations, and the runtime gets the parameters
+// of the kernel as an array of pointers to them, allocated on the stack.
+static void lowerGPULaunch(Operation *op, LLVM::LLVMDialect &dialect) {
+  llvm::sys::SmartScopedLock<true> lock(dialect.getLLVMContextMutex());
+  auto loc = op->getLoc();
+  MLIRContext *context = op->getContext();
+  Module *module = op->getFunction()->getModule();
+  Function *callee = op->getAttrOfType<FunctionAttr>("callee").getValue();
+  auto blockSizes = op->getAttrOfType<ArrayAttr>(kGPUBlockSizeAttrName);
+  auto steps = op->getAttrOfType<ArrayAttr>(kGPUStepAttrName);
+  unsigned numDims = blockSizes.size();
+
+  auto indexType = op->getOperand(0)->getType().cast<LLVM::LLVMType>();
+  llvm::Type *llvmVoidPtrType =
+      llvm::Type::getInt8PtrTy(dialect.getLLVMContext());
+  Type voidPtrType = LLVM::LLVMType::get(context, llvmVoidPtrType);
+  Type voidPtrPtrType =
+      LLVM::LLVMType::get(context, llvmVoidPtrType->getPointerTo());
+
+  // Allocate the parameters and the array of pointers to them in the entry
+  // block, so that they are only allocated once if the launch is in a loop.
+  Block *entryBlock = &op->getFunction()->front();
+  FuncBuilder entryBuilder(entryBlock, entryBlock->begin());
+  auto getIndexConstant = [&](FuncBuilder &builder, int64_t value) -> Value * {
+    return builder.create<LLVM::ConstantOp>(
+        loc, indexType, builder.getIntegerAttr(builder.getIndexType(), value));
+  };
+  Value *one = getIndexConstant(entryBuilder, 1);
+  Value *params = entryBuilder.create<LLVM::AllocaOp>(
+      loc, voidPtrPtrType,
+      getIndexConstant(entryBuilder, op->getNumOperands()));
+  SmallVector<LLVM::LLVMType, 8> paramTypes;
+  SmallVector<Value *, 8> paramSlots;
+  for (Value *operand : op->getOperands()) {
+    auto type = operand->getType().cast<LLVM::LLVMType>();
+    paramTypes.push_back(type);
+    paramSlots.push_back(entryBuilder.create<LLVM::AllocaOp>(
+        loc,
+        LLVM::LLVMType::get(context,
+                            type.getUnderlyingType()->getPointerTo()),
+        one));
+  }
 
-    convertedArgAttrs.reserve(argAttrs.size());
-    for (auto attr : argAttrs)
-      convertedArgAttrs.push_back(attr);
-    return TypeConverter::convertFunctionSignature(t, *module);
+  // Store the parameters and the pointers to them.
+  FuncBuilder builder(op);
+  for (unsigned i = 0, e = op->getNumOperands(); i < e; ++i) {
+    builder.create<LLVM::StoreOp>(loc, op->getOperand(i), paramSlots[i]);
+    Value *paramPtr = builder.create<LLVM::BitcastOp>(
+        loc, voidPtrType, ArrayRef<Value *>(paramSlots[i]));
+    Value *paramPtrPtr = builder.create<LLVM::GEPOp>(
+        loc, voidPtrPtrType,
+        ArrayRef<Value *>{params, getIndexConstant(builder, i)},
+        ArrayRef<NamedAttribute>{});
+    builder.create<LLVM::StoreOp>(loc, paramPtr, paramPtrPtr);
   }
 
-private:
-  // Storage for the conversion patterns.
-  llvm::BumpPtrAllocator converterStorage;
-  // LLVM IR module used to parse/create types.
-  llvm::Module *module;
-};
+  // Compute the number of blocks along each dimension,
+  //   (upperBound - lowerBound + step * blockSize - 1) / (step * blockSize),
+  // which the runtime checks to be positive.
+  SmallVector<Value *, 8> launchOperands;
+  SmallVector<Value *, 3> blockDims;
+  for (unsigned dim = 0; dim < 3; ++dim) {
+    if (dim >= numDims) {
+      launchOperands.push_back(getIndexConstant(builder, 1));
+      blockDims.push_back(getIndexConstant(builder, 1));
+      continue;
+    }
+    int64_t blockSize = blockSizes.getValue()[dim].cast<IntegerAttr>().getInt();
+    int64_t blockSpan =
+        blockSize * steps.getValue()[dim].cast<IntegerAttr>().getInt();
+    Value *span = builder.create<LLVM::SubOp>(
+        loc, indexType,
+        ArrayRef<Value *>{op->getOperand(2 * dim + 1),
+                          op->getOperand(2 * dim)});
+    Value *roundedSpan = builder.create<LLVM::AddOp>(
+        loc, indexType,
+        ArrayRef<Value *>{span, getIndexConstant(builder, blockSpan - 1)});
+    launchOperands.push_back(builder.create<LLVM::SDivOp>(
+        loc, indexType,
+        ArrayRef<Value *>{roundedSpan, getIndexConstant(builder, blockSpan)}));
+    blockDims.push_back(getIndexConstant(builder, blockSize));
+  }
+  launchOperands.append(blockDims.begin(), blockDims.end());
+  launchOperands.push_back(params);
+
+  // Call the runtime with a pointer to the thunk, which also identifies the
+  // kernel.
+  Function *thunk = getOrCreateGPUThunk(callee, paramTypes, indexType,
+                                        voidPtrType, voidPtrPtrType);
+  auto *thunkPtrType =
+      llvm::FunctionType::get(llvm::Type::getVoidTy(dialect.getLLVMContext()),
+                              {llvmVoidPtrType->getPointerTo()},
+                              /*isVarArg=*/false)
+          ->getPointerTo();
+  Type wrappedThunkPtrType = LLVM::LLVMType::get(context, thunkPtrType);
+  launchOperands.insert(launchOperands.begin(),
+                        builder.create<LLVM::ConstantOp>(
+                            loc, wrappedThunkPtrType,
+                            builder.getFunctionAttr(thunk)));
+
+  Function *launch = module->getNamedFunction(kGPULaunchFunctionName);
+  if (!launch) {
+    SmallVector<Type, 8> launchTypes(7, indexType);
+    launchTypes.front() = wrappedThunkPtrType;
+    launchTypes.push_back(voidPtrPtrType);
+    launch = new Function(builder.getUnknownLoc(), kGPULaunchFunctionName,
+                          builder.getFunctionType(launchTypes, {}));
+    module->addFunction(launch);
+  }
+  builder.create<LLVM::CallOp>(loc, ArrayRef<Type>(),
+                               builder.getFunctionAttr(launch),
+                               launchOperands);
+  op->erase();
+}
+
+// Lower the calls launching GPU kernels in `m` to calls to the GPU runtime.
+// Like the calls to the outlined bodies of parallel loops, this is done once
+// the whole module has been converted.
+static void lowerGPULaunches(Module *m, LLVM::LLVMDialect &dialect) {
+  SmallVector<Operation *, 8> launches;
+  for (auto &f : *m) {
+    f.walk([&](Operation *op) {
+      if (op->isa<LLVM::CallOp>() && op->getAttr(kGPUBlockSizeAttrName))
+        launches.push_back(op);
+    });
+  }
+  for (Operation *op : launches)
+    lowerGPULaunch(op, dialect);
+}
+
+// Create a set of converters that live in the converter object by passing
+// them a reference to the LLVM IR dialect.  Store the module associated with
+// the dialect for further type conversion.
+llvm::DenseSet<DialectOpConversion *>
+LLVMLowering::initConverters(MLIRContext *mlirContext) {
+  converterStorage.Reset();
+  auto *llvmDialect = static_cast<LLVM::LLVMDialect *>(
+      mlirContext->getRegisteredDialect("llvm"));
+  if (!llvmDialect) {
+    mlirContext->emitError(UnknownLoc::get(mlirContext),
+                           "LLVM IR dialect is not registered");
+    return {};
+  }
+
+  dialect = llvmDialect;
+  module = &llvmDialect->getLLVMModule();
+
+  // FIXME: this should be tablegen'ed
+  auto converters = ConversionListBuilder<
+      AddFOpLowering, AddIOpLowering, AllocOpLowering, BranchOpLowering,
+      CallIndirectOpLowering, CallOpLowering, CmpIOpLowering,
+      CondBranchOpLowering, ConstLLVMOpLowering, DeallocOpLowering,
+      DimOpLowering, DivISOpLowering, DivIUOpLowering, DivFOpLowering,
+      ExtractElementOpLowering, FmaFOpLowering, LoadOpLowering,
+      MemRefCastOpLowering, MulFOpLowering, MulIOpLowering, RemISOpLowering,
+      RemIUOpLowering, RemFOpLowering, ReturnOpLowering, SelectOpLowering,
+      StoreOpLowering, SubFOpLowering, SubIOpLowering,
+      VectorBroadcastOpLowering, VectorInsertElementOpLowering,
+      VectorOuterProductOpLowering, VectorReduceOpLowering,
+      VectorShapeCastOpLowering, VectorShuffleOpLowering,
+      VectorTransferReadOpLowering, VectorTransferWriteOpLowering,
+      ViewOpLowering>::build(&converterStorage, *llvmDialect);
+  auto additionalConverters = initAdditionalConverters(*llvmDialect);
+  converters.insert(additionalConverters.begin(), additionalConverters.end());
+  return converters;
+}
+
+// Convert types using the stored LLVM IR module.
+Type LLVMLowering::convertType(Type t) {
+  return TypeConverter::convert(t, *module);
+}
+
+// Convert function signatures using the stored LLVM IR module.  Statically
+// shaped memrefs are passed as bare pointers to their data, which are marked
+// as noalias if requested with -llvm-noalias-static-memref-args.
+FunctionType LLVMLowering::convertFunctionSignatureType(
+    FunctionType t, ArrayRef<NamedAttributeList> argAttrs,
+    SmallVectorImpl<NamedAttributeList> &convertedArgAttrs) {
+
+  convertedArgAttrs.reserve(argAttrs.size());
+  for (auto attr : argAttrs)
+    convertedArgAttrs.push_back(attr);
+
+  if (clNoAliasStaticMemRefArgs) {
+    MLIRContext *context = t.getContext();
+    auto noAlias = Identifier::get("llvm.noalias", context);
+    for (auto indexedType : llvm::enumerate(t.getInputs())) {
+      auto memRefType = indexedType.value().dyn_cast<MemRefType>();
+      if (memRefType && memRefType.hasStaticShape() &&
+          !convertedArgAttrs[indexedType.index()].get(noAlias))
+        convertedArgAttrs[indexedType.index()].set(
+            context, noAlias, BoolAttr::get(true, context));
+    }
+  }
+  return TypeConverter::convertFunctionSignature(t, *module);
+}
+
+// The patterns run concurrently on the functions of a module, so the functions
+// they declare are inserted with the thread-safe interface of the module.
+Function *LLVMLowering::getOrInsertFunction(Module *module, StringRef name,
+                                            FunctionType type) {
+  return module->getOrInsertFunction(name, [&] {
+    return new Function(UnknownLoc::get(module->getContext()), name, type);
+  });
+}
+
+LogicalResult mlir::convertToLLVMDialect(Module *m, LLVMLowering &lowering) {
+  LLVM::ensureDistinctSuccessors(m);
+  unsigned numFunctions = m->getFunctions().size();
+  if (failed(lowering.convert(m)))
+    return failure();
+
+  // The functions declared by the patterns were appended in the order in which
+  // the concurrent conversions first requested them: sort them by name.
+  SmallVector<Function *, 8> declared;
+  for (auto &f : llvm::make_range(std::next(m->begin(), numFunctions),
+                                  m->end()))
+    declared.push_back(&f);
+  std::stable_sort(declared.begin(), declared.end(),
+                   [](Function *lhs, Function *rhs) {
+                     return lhs->getName().strref() < rhs->getName().strref();
+                   });
+  auto &functions = m->getFunctions();
+  for (Function *f : declared)
+    functions.splice(functions.end(), functions, f);
+
+  lowerParallelCalls(m, *lowering.getDialect());
+  lowerGPULaunches(m, *lowering.getDialect());
+  return success();
+}
 
 /// A pass converting MLIR Standard operations into the LLVM IR dialect.
 class LLVMLoweringPass : public ModulePass<LLVMLoweringPass> {
 public:
   // Run the dialect converter on the module.
   void runOnModule() override {
-    Module *m = &getModule();
-    LLVM::ensureDistinctSuccessors(m);
-    if (failed(impl.convert(m)))
+    if (failed(convertToLLVMDialect(&getModule(), impl)))
       signalPassFailure();
   }
 
@@ -0,0 +1,520 @@
+//===- LoopStrengthReduce.cpp - Pointer induction variables ---------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass rewriting the element addresses computed in the
+// innermost loops of functions in the LLVM IR dialect into pointers carried by
+// the loops and incremented in every iteration.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/LLVMIR/LLVMDialect.h"
+#include "mlir/LLVMIR/Transforms.h"
+#include "mlir/Pass/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include <type_traits>
+
+#define DEBUG_TYPE "llvm-loop-strength-reduce"
+
+using namespace mlir;
+
+namespace {
+
+/// A term of a linear expression: the product of a constant coefficient, an
+/// optional induction variable and an optional loop invariant factor.
+struct LinearTerm {
+  Value *iv;
+  Value *factor;
+  int64_t coefficient;
+};
+
+/// An integer expression linear in the induction variables of a loop, in
+/// which all values but the induction variables are available in the
+/// preheader of the loop.
+struct LinearExpr {
+  SmallVector<LinearTerm, 4> terms;
+  int64_t constant = 0;
+
+  /// Adds 'coefficient * iv * factor' to this expression.
+  void addTerm(Value *iv, Value *factor, int64_t coefficient) {
+    for (auto it = terms.begin(), e = terms.end(); it != e; ++it) {
+      if (it->iv != iv || it->factor != factor)
+        continue;
+      it->coefficient += coefficient;
+      if (it->coefficient == 0)
+        terms.erase(it);
+      return;
+    }
+    if (coefficient != 0)
+      terms.push_back({iv, factor, coefficient});
+  }
+
+  /// Adds 'scale * other' to this expression.
+  void add(const LinearExpr &other, int64_t scale) {
+    for (const auto &term : other.terms)
+      addTerm(term.iv, term.factor, scale * term.coefficient);
+    constant += scale * other.constant;
+  }
+
+  bool dependsOnIVs() const {
+    return llvm::any_of(terms, [](const LinearTerm &term) { return term.iv; });
+  }
+};
+
+/// An innermost loop of the shape produced by the lowering of affine.for: a
+/// header block whose arguments include the induction variables, branching to
+/// a single body block that branches back to the header, and entered from a
+/// single preheader block ending with an unconditional branch to the header.
+class InnermostLoop {
+public:
+  InnermostLoop(Block *header, Block *body, Block *preheader)
+      : header(header), body(body), preheader(preheader),
+        builder(preheader->getTerminator()) {}
+
+  /// Replaces the pointers to memory elements computed in the loop body with
+  /// pointers carried by the loop, shared by the accesses to the same buffer
+  /// whose addresses are a loop invariant offset apart. Returns the number of
+  /// element pointers replaced.
+  unsigned reduce();
+
+private:
+  /// Returns true if 'value' has the same value in all the iterations.
+  bool isInvariant(Value *value);
+
+  /// Returns a value available in the preheader equal to the loop invariant
+  /// 'value', cloning the operations of the body computing it if needed.
+  Value *hoist(Value *value);
+
+  /// Expresses 'value' as a linear function of the induction variables of the
+  /// loop. Returns false if it isn't one.
+  bool getLinearExpr(Value *value, LinearExpr &expr);
+
+  /// Emits in the preheader the computation of 'expr', whose induction
+  /// variables take their values in the first iteration.
+  Value *materialize(const LinearExpr &expr, Type type);
+
+  /// Returns the expression by which 'expr' is incremented in every iteration.
+  LinearExpr getIncrement(const LinearExpr &expr);
+
+  /// Emits in the preheader the binary operation 'OpTy' or the constant it
+  /// folds to.
+  template <typename OpTy> Value *createBinaryOp(Value *lhs, Value *rhs);
+  Value *createConstant(Type type, int64_t value);
+
+  /// Inserts 'op', which was just created in the preheader, in the list of the
+  /// operations emitted there, or replaces it with an equivalent one.
+  Value *insertOrReuse(Operation *op);
+
+  Block *header, *body, *preheader;
+  FuncBuilder builder;
+
+  /// The step and the entry value of each induction variable.
+  llvm::DenseMap<Value *, Value *> steps;
+  llvm::DenseMap<Value *, Value *> entryValues;
+
+  /// The known invariance of values, and their equivalent in the preheader.
+  llvm::DenseMap<Value *, bool> invariance;
+  llvm::DenseMap<Value *, Value *> hoistedValues;
+
+  /// The operations emitted in the preheader, in order.
+  SmallVector<Operation *, 16> emittedOps;
+};
+
+/// The accesses to the same buffer whose element pointers are rewritten into
+/// offsets from a single loop-carried pointer.
+struct PointerGroup {
+  Value *base;
+  LinearExpr leaderIndex;
+  SmallVector<std::pair<Operation *, LinearExpr>, 4> members;
+};
+
+/// Rewrites the element pointers of innermost loops in the LLVM IR dialect
+/// into loop-carried pointers.
+struct LoopStrengthReduce : public FunctionPass<LoopStrengthReduce> {
+  void runOnFunction() override;
+
+  /// Statistics of this pass.
+  Statistic numReduced = {this, "num-reduced",
+                          "Number of element pointers strength-reduced"};
+};
+
+} // end anonymous namespace
+
+/// Returns the integer value of 'value' if it is defined by an llvm.constant.
+static Optional<int64_t> getConstantValue(Value *value) {
+  auto *op = value->getDefiningOp();
+  if (!op || !op->isa<LLVM::ConstantOp>())
+    return llvm::None;
+  auto attr = op->getAttrOfType<IntegerAttr>("value");
+  if (!attr)
+    return llvm::None;
+  return attr.getInt();
+}
+
+/// Returns true if 'lhs' and 'rhs' compute the same value.
+static bool isEquivalent(Operation *lhs, Operation *rhs) {
+  return lhs->getName() == rhs->getName() &&
+         lhs->getAttrs() == rhs->getAttrs() &&
+         lhs->getNumOperands() == rhs->getNumOperands() &&
+         lhs->getNumResults() == 1 && rhs->getNumResults() == 1 &&
+         lhs->getResult(0)->getType() == rhs->getResult(0)->getType() &&
+         std::equal(lhs->operand_begin(), lhs->operand_end(),
+                    rhs->operand_begin());
+}
+
+/// Replaces the branch 'br' with one passing 'values' to its destination in
+/// addition to its operands.
+static void appendBranchOperands(Operation *br, ArrayRef<Value *> values) {
+  SmallVector<Value *, 8> operands(br->operand_begin(), br->operand_end());
+  operands.append(values.begin(), values.end());
+  Block *dest = br->getSuccessor(0);
+  ArrayRef<Value *> destOperands(operands);
+  FuncBuilder b(br);
+  b.create<LLVM::BrOp>(br->getLoc(), ArrayRef<Value *>(), dest, destOperands,
+                       br->getAttrs());
+  br->erase();
+}
+
+bool InnermostLoop::isInvariant(Value *value) {
+  auto *op = value->getDefiningOp();
+  Block *block = op ? op->getBlock() : cast<BlockArgument>(value)->getOwner();
+  if (block != header && block != body)
+    return true;
+  if (block == header)
+    return false;
+
+  auto it = invariance.find(value);
+  if (it != invariance.end())
+    return it->second;
+  bool result = op->hasNoSideEffect() && op->getNumRegions() == 0 &&
+                op->getNumResults() == 1 &&
+                llvm::all_of(op->getOperands(), [&](Value *operand) {
+                  return isInvariant(operand);
+                });
+  invariance[value] = result;
+  return result;
+}
+
+Value *InnermostLoop::hoist(Value *value) {
+  auto *op = value->getDefiningOp();
+  if (!op || op->getBlock() != body)
+    return value;
+  auto it = hoistedValues.find(value);
+  if (it != hoistedValues.end())
+    return it->second;
+
+  BlockAndValueMapping mapping;
+  for (auto *operand : op->getOperands())
+    mapping.map(operand, hoist(operand));
+  auto *hoisted = insertOrReuse(builder.clone(*op, mapping));
+  hoistedValues[value] = hoisted;
+  return hoisted;
+}
+
+Value *InnermostLoop::insertOrReuse(Operation *op) {
+  for (auto *emitted : emittedOps) {
+    if (isEquivalent(emitted, op)) {
+      op->erase();
+      return emitted->getResult(0);
+    }
+  }
+  emittedOps.push_back(op);
+  return op->getResult(0);
+}
+
+Value *InnermostLoop::createConstant(Type type, int64_t value) {
+  auto attr = builder.getIntegerAttr(builder.getIndexType(), value);
+  auto constantOp =
+      builder.create<LLVM::ConstantOp>(preheader->getTerminator()->getLoc(),
+                                       type, attr);
+  return insertOrReuse(constantOp.getOperation());
+}
+
+template <typename OpTy>
+Value *InnermostLoop::createBinaryOp(Value *lhs, Value *rhs) {
+  auto lhsConstant = getConstantValue(lhs);
+  auto rhsConstant = getConstantValue(rhs);
+  auto type = lhs->getType();
+  if (lhsConstant && rhsConstant) {
+    if (std::is_same<OpTy, LLVM::AddOp>::value)
+      return createConstant(type, *lhsConstant + *rhsConstant);
+    if (std::is_same<OpTy, LLVM::SubOp>::value)
+      return createConstant(type, *lhsConstant - *rhsConstant);
+    return createConstant(type, *lhsConstant * *rhsConstant);
+  }
+  auto isConstant = [](Optional<int64_t> constant, int64_t value) {
+    return constant && *constant == value;
+  };
+  bool isMul = std::is_same<OpTy, LLVM::MulOp>::value;
+  bool isAdd = std::is_same<OpTy, LLVM::AddOp>::value;
+  if (isMul && (isConstant(lhsConstant, 0) || isConstant(rhsConstant, 0)))
+    return createConstant(type, 0);
+  if ((isMul && isConstant(rhsConstant, 1)) ||
+      (!isMul && isConstant(rhsConstant, 0)))
+    return lhs;
+  if ((isMul && isConstant(lhsConstant, 1)) ||
+      (isAdd && isConstant(lhsConstant, 0)))
+    return rhs;
+  auto op = builder.create<OpTy>(preheader->getTerminator()->getLoc(), type,
+                                 ArrayRef<Value *>{lhs, rhs});
+  return insertOrReuse(op.getOperation());
+}
+
+bool InnermostLoop::getLinearExpr(Value *value, LinearExpr &expr) {
+  if (auto constant = getConstantValue(value)) {
+    expr.constant = *constant;
+    return true;
+  }
+  if (steps.count(value)) {
+    expr.addTerm(value, nullptr, 1);
+    return true;
+  }
+  if (isInvariant(value)) {
+    expr.addTerm(nullptr, hoist(value), 1);
+    return true;
+  }
+
+  auto *op = value->getDefiningOp();
+  if (!op || op->getBlock() != body ||
+      !(op->isa<LLVM::AddOp>() || op->isa<LLVM::SubOp>() ||
+        op->isa<LLVM::MulOp>()))
+    return false;
+  LinearExpr lhs, rhs;
+  if (!getLinearExpr(op->getOperand(0), lhs) ||
+      !getLinearExpr(op->getOperand(1), rhs))
+    return false;
+  if (op->isa<LLVM::AddOp>() || op->isa<LLVM::SubOp>()) {
+    expr = lhs;
+    expr.add(rhs, op->isa<LLVM::AddOp>() ? 1 : -1);
+    return true;
+  }
+
+  // A product is linear if one of its factors is loop invariant. That factor is
+  // then emitted in the preheader unless it is a constant.
+  if (lhs.dependsOnIVs())
+    std::swap(lhs, rhs);
+  if (lhs.dependsOnIVs())
+    return false;
+  if (lhs.terms.empty()) {
+    expr.add(rhs, lhs.constant);
+    return true;
+  }
+  Value *factor = materialize(lhs, value->getType());
+  for (const auto &term : rhs.terms) {
+    Value *termFactor =
+        term.factor ? createBinaryOp<LLVM::MulOp>(term.factor, factor) : factor;
+    expr.addTerm(term.iv, termFactor, term.coefficient);
+  }
+  expr.addTerm(nullptr, factor, rhs.constant);
+  return true;
+}
+
+Value *InnermostLoop::materialize(const LinearExpr &expr, Type type) {
+  Value *result = expr.constant != 0 || expr.terms.empty()
+                      ? createConstant(type, expr.constant)
+                      : nullptr;
+  for (const auto &term : expr.terms) {
+    Value *termValue = term.iv ? entryValues[term.iv] : nullptr;
+    if (term.factor && termValue)
+      termValue = createBinaryOp<LLVM::MulOp>(termValue, term.factor);
+    else if (term.factor)
+      termValue = term.factor;
+    if (term.coefficient != 1)
+      termValue = createBinaryOp<LLVM::MulOp>(
+          termValue, createConstant(type, term.coefficient));
+    result =
+        result ? createBinaryOp<LLVM::AddOp>(result, termValue) : termValue;
+  }
+  return result;
+}
+
+LinearExpr InnermostLoop::getIncrement(const LinearExpr &expr) {
+  LinearExpr increment;
+  for (const auto &term : expr.terms) {
+    if (!term.iv)
+      continue;
+    Value *step = steps[term.iv];
+    if (auto constantStep = getConstantValue(step)) {
+      increment.addTerm(nullptr, term.factor,
+                        term.coefficient * constantStep.getValue());
+      continue;
+    }
+    Value *factor =
+        term.factor ? createBinaryOp<LLVM::MulOp>(term.factor, step) : step;
+    increment.addTerm(nullptr, factor, term.coefficient);
+  }
+  // Terms without factor are constants.
+  for (auto it = increment.terms.begin(); it != increment.terms.end();) {
+    if (it->factor) {
+      ++it;
+      continue;
+    }
+    increment.constant += it->coefficient;
+    it = increment.terms.erase(it);
+  }
+  return increment;
+}
+
+unsigned InnermostLoop::reduce() {
+  // The induction variables are the header arguments incremented by a loop
+  // invariant step between two iterations.
+  auto *latch = body->getTerminator();
+  auto *entry = preheader->getTerminator();
+  for (unsigned i = 0, e = header->getNumArguments(); i < e; ++i) {
+    auto *arg = header->getArgument(i);
+    auto *next = latch->getOperand(i)->getDefiningOp();
+    if (!next || !next->isa<LLVM::AddOp>())
+      continue;
+    unsigned stepPos = next->getOperand(0) == arg ? 1 : 0;
+    if (next->getOperand(1 - stepPos) != arg ||
+        !isInvariant(next->getOperand(stepPos)))
+      continue;
+    steps[arg] = hoist(next->getOperand(stepPos));
+    entryValues[arg] = entry->getOperand(i);
+  }
+  if (steps.empty())
+    return 0;
+
+  // Group the element pointers computed in the body from a loop invariant base
+  // pointer and an index linear in the induction variables.
+  std::vector<PointerGroup> groups;
+  for (auto &op : *body) {
+    if (!op.isa<LLVM::GEPOp>() || op.getNumOperands() != 2 ||
+        !isInvariant(op.getOperand(0)))
+      continue;
+    LinearExpr index;
+    if (!getLinearExpr(op.getOperand(1), index) || !index.dependsOnIVs())
+      continue;
+    Value *base = hoist(op.getOperand(0));
+    auto groupIt = llvm::find_if(groups, [&](const PointerGroup &group) {
+      LinearExpr offset = index;
+      offset.add(group.leaderIndex, -1);
+      return group.base == base && !offset.dependsOnIVs();
+    });
+    if (groupIt == groups.end()) {
+      groups.push_back({base, index, {}});
+      groupIt = std::prev(groups.end());
+    }
+    groupIt->members.push_back({&op, index});
+  }
+
+  // Each group gets a pointer carried by the loop, initialized in the
+  // preheader and incremented on the back-edge.
+  SmallVector<Value *, 4> initialPointers, nextPointers;
+  FuncBuilder latchBuilder(latch);
+  unsigned numReduced = 0;
+  for (auto &group : groups) {
+    auto *leaderOp = group.members.front().first;
+    auto ptrType = leaderOp->getResult(0)->getType();
+    auto indexType = leaderOp->getOperand(1)->getType();
+    auto loc = leaderOp->getLoc();
+
+    Value *initialPointer = group.base;
+    Value *initialIndex = materialize(group.leaderIndex, indexType);
+    auto initialConstant = getConstantValue(initialIndex);
+    if (!initialConstant || *initialConstant != 0)
+      initialPointer = builder.create<LLVM::GEPOp>(
+          loc, ptrType, ArrayRef<Value *>{group.base, initialIndex},
+          ArrayRef<NamedAttribute>{});
+    initialPointers.push_back(initialPointer);
+    auto *pointer = header->addArgument(ptrType);
+    Value *increment =
+        materialize(getIncrement(group.leaderIndex), indexType);
+    nextPointers.push_back(latchBuilder.create<LLVM::GEPOp>(
+        loc, ptrType, ArrayRef<Value *>{pointer, increment},
+        ArrayRef<NamedAttribute>{}));
+
+    for (auto &member : group.members) {
+      auto *op = member.first;
+      LinearExpr offset = member.second;
+      offset.add(group.leaderIndex, -1);
+      Value *replacement = pointer;
+      if (!offset.terms.empty() || offset.constant != 0) {
+        FuncBuilder b(op);
+        replacement = b.create<LLVM::GEPOp>(
+            op->getLoc(), ptrType,
+            ArrayRef<Value *>{pointer, materialize(offset, indexType)},
+            ArrayRef<NamedAttribute>{});
+      }
+      op->getResult(0)->replaceAllUsesWith(replacement);
+      op->erase();
+      ++numReduced;
+    }
+  }
+  if (!groups.empty()) {
+    appendBranchOperands(entry, initialPointers);
+    appendBranchOperands(latch, nextPointers);
+  }
+
+  // Erase the index computations left dead in the body, and the operations
+  // emitted in the preheader for the accesses that weren't rewritten.
+  for (auto it = Block::iterator(body->getTerminator()); it != body->begin();) {
+    auto &op = *std::prev(it);
+    if (op.use_empty() && op.hasNoSideEffect())
+      op.erase();
+    else
+      --it;
+  }
+  for (auto *op : llvm::reverse(emittedOps))
+    if (op->use_empty())
+      op->erase();
+  return numReduced;
+}
+
+void LoopStrengthReduce::runOnFunction() {
+  // Collect the loops before rewriting any of them.
+  std::vector<InnermostLoop> loops;
+  for (auto &header : getFunction()) {
+    auto *terminator = header.getTerminator();
+    if (!terminator || !terminator->isa<LLVM::CondBrOp>())
+      continue;
+    auto *body = terminator->getSuccessor(0);
+    auto *latch = body->getTerminator();
+    if (body == &header || !latch || !latch->isa<LLVM::BrOp>() ||
+        latch->getSuccessor(0) != &header)
+      continue;
+    Block *preheader = nullptr;
+    unsigned numPredecessors = 0;
+    for (auto *pred : header.getPredecessors()) {
+      ++numPredecessors;
+      if (pred != body)
+        preheader = pred;
+    }
+    if (numPredecessors != 2 || !preheader ||
+        !preheader->getTerminator()->isa<LLVM::BrOp>())
+      continue;
+    loops.emplace_back(&header, body, preheader);
+  }
+
+  for (auto &loop : loops)
+    numReduced += loop.reduce();
+}
+
+/// Creates a pass rewriting the element pointers of innermost loops in the
+/// LLVM IR dialect into loop-carried pointers.
+FunctionPassBase *mlir::createLLVMLoopStrengthReducePass() {
+  return new LoopStrengthReduce();
+}
+
+static PassRegistration<LoopStrengthReduce>
+    pass("llvm-loop-strength-reduce",
+         "Rewrite the element pointers of innermost loops in the LLVM IR "
+         "dialect into pointers incremented in every iteration");
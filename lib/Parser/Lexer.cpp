@@ -22,7 +22,13 @@
 #include "Lexer.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/MLIRContext.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/SourceMgr.h"
+#include <cstring>
+#ifdef LLVM_ON_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 using namespace mlir;
 
 using llvm::SMLoc;
@@ -34,24 +40,82 @@ static bool isPunct(char c) {
   return c == '$' || c == '.' || c == '_' || c == '-';
 }
 
+#ifdef LLVM_ON_UNIX
+// Returns the address of the page holding 'ptr', rounded up to the next page
+// if 'roundUp' is true.
+static uintptr_t getPageAddress(const char *ptr, bool roundUp) {
+  static const uintptr_t pageSize = ::sysconf(_SC_PAGESIZE);
+  auto address = reinterpret_cast<uintptr_t>(ptr);
+  if (roundUp)
+    address += pageSize - 1;
+  return address & ~(pageSize - 1);
+}
+#endif
+
 Lexer::Lexer(const llvm::SourceMgr &sourceMgr, MLIRContext *context)
     : sourceMgr(sourceMgr), context(context) {
   auto bufferID = sourceMgr.getMainFileID();
-  curBuffer = sourceMgr.getMemoryBuffer(bufferID)->getBuffer();
+  auto *buffer = sourceMgr.getMemoryBuffer(bufferID);
+  curBuffer = buffer->getBuffer();
   curPtr = curBuffer.begin();
+  lastLocPtr = lastLocLineStart = curPtr;
+  lastLocLine = 1;
+  isMappedInput = false;
+  releasedInputEnd = curPtr;
+
+#ifdef LLVM_ON_UNIX
+  // The input is read once from the start to the end, let the OS read ahead.
+  if (buffer->getBufferKind() == llvm::MemoryBuffer::MemoryBuffer_MMap) {
+    isMappedInput = true;
+    auto begin = getPageAddress(curBuffer.begin(), /*roundUp=*/false);
+    ::madvise(reinterpret_cast<void *>(begin),
+              reinterpret_cast<uintptr_t>(curBuffer.end()) - begin,
+              MADV_SEQUENTIAL);
+  }
+#endif
 }
 
 /// Encode the specified source location information into an attribute for
 /// attachment to the IR.
-Location Lexer::getEncodedSourceLocation(llvm::SMLoc loc) {
+Location Lexer::getEncodedSourceLocation(llvm::SMLoc loc,
+                                         bool includeColumn) {
   auto &sourceMgr = getSourceMgr();
   unsigned mainFileID = sourceMgr.getMainFileID();
-  auto lineAndColumn = sourceMgr.getLineAndColumn(loc, mainFileID);
   auto *buffer = sourceMgr.getMemoryBuffer(mainFileID);
   auto filename = UniquedFilename::get(buffer->getBufferIdentifier(), context);
 
-  return FileLineColLoc::get(filename, lineAndColumn.first,
-                             lineAndColumn.second, context);
+  // Locations mostly come in increasing order, count the lines from the last
+  // one.  Otherwise, look the line up in the source manager.
+  const char *ptr = loc.getPointer();
+  if (lastLocPtr && ptr >= lastLocPtr) {
+    for (const char *it = lastLocPtr;
+         (it = static_cast<const char *>(memchr(it, '\n', ptr - it)));) {
+      ++lastLocLine;
+      lastLocLineStart = ++it;
+    }
+  } else {
+    auto lineAndColumn = sourceMgr.getLineAndColumn(loc, mainFileID);
+    lastLocLine = lineAndColumn.first;
+    lastLocLineStart = ptr - (lineAndColumn.second - 1);
+  }
+  lastLocPtr = ptr;
+
+  unsigned column = includeColumn ? ptr - lastLocLineStart + 1 : 0;
+  return FileLineColLoc::get(filename, lastLocLine, column, context);
+}
+
+void Lexer::releaseInputBefore(const char *ptr) {
+#ifdef LLVM_ON_UNIX
+  if (!isMappedInput)
+    return;
+  // Only release the pages holding nothing but text before 'ptr'.
+  auto begin = getPageAddress(releasedInputEnd, /*roundUp=*/true);
+  auto end = getPageAddress(ptr, /*roundUp=*/false);
+  if (end <= begin)
+    return;
+  ::madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+  releasedInputEnd = reinterpret_cast<const char *>(end);
+#endif
 }
 
 /// emitError - Emit an error message and return an Token::error token.
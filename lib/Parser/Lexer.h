@@ -38,12 +38,26 @@ public:
   Token lexToken();
 
   /// Encode the specified source location information into a Location object
-  /// for attachment to the IR or error reporting.
-  Location getEncodedSourceLocation(llvm::SMLoc loc);
+  /// for attachment to the IR or error reporting.  The column is set to 0 if
+  /// 'includeColumn' is false, so that the locations of a line are uniqued
+  /// together.
+  Location getEncodedSourceLocation(llvm::SMLoc loc, bool includeColumn = true);
 
   /// Change the position of the lexer cursor.  The next token we lex will start
   /// at the designated point in the input.
-  void resetPointer(const char *newPointer) { curPtr = newPointer; }
+  void resetPointer(const char *newPointer) {
+    // Jumping ahead, e.g. to a deferred function body, would make the next
+    // location count all the lines skipped over.
+    if (newPointer > curPtr)
+      lastLocPtr = nullptr;
+    curPtr = newPointer;
+  }
+
+  /// Release the memory holding the input before 'ptr', which was entirely
+  /// lexed already.  This is only done when the input is a memory mapped file,
+  /// whose pages are read again from the file if a diagnostic or a later
+  /// location refers to them.
+  void releaseInputBefore(const char *ptr);
 
 private:
   // Helpers.
@@ -67,6 +81,19 @@ private:
   StringRef curBuffer;
   const char *curPtr;
 
+  /// The position of the last location encoded, its line and the start of its
+  /// line.  The line of the next location after it is computed by counting the
+  /// newlines in between, rather than through the line cache of the source
+  /// manager, which is built by scanning the whole input.  Null if unknown.
+  const char *lastLocPtr;
+  unsigned lastLocLine;
+  const char *lastLocLineStart;
+
+  /// True if the input is a memory mapped file, and the end of the part of it
+  /// whose memory was released.
+  bool isMappedInput;
+  const char *releasedInputEnd;
+
   Lexer(const Lexer &) = delete;
   void operator=(const Lexer &) = delete;
 };
@@ -25,26 +25,55 @@
 #include "mlir/IR/AffineMap.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/IntegerSet.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Module.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/IR/StandardTypes.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Support/STLExtras.h"
 #include "mlir/Transforms/Utils.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Threading.h"
 #include <algorithm>
+#include <atomic>
 using namespace mlir;
 using llvm::MemoryBuffer;
 using llvm::SMLoc;
 using llvm::SourceMgr;
 
+static llvm::cl::opt<bool> enableThreads(
+    "experimental-mt-parser",
+    llvm::cl::desc("Enable experimental multithreading in the parser"),
+    llvm::cl::init(false));
+
+namespace {
+/// The source locations the parser attaches to the IR.
+enum class ParsedLocations { All, Lines, None };
+} // end anonymous namespace
+
+static llvm::cl::opt<ParsedLocations> parsedLocations(
+    "mlir-parse-locations",
+    llvm::cl::desc("Source locations attached to the parsed IR, the "
+                   "diagnostics of the parser always have precise locations"),
+    llvm::cl::values(
+        clEnumValN(ParsedLocations::All, "all", "All the locations"),
+        clEnumValN(ParsedLocations::Lines, "lines",
+                   "The file and line of the operations, without column"),
+        clEnumValN(ParsedLocations::None, "none",
+                   "No location, as if -strip-debuginfo ran at parse time")),
+    llvm::cl::init(ParsedLocations::All));
+
 /// Simple enum to make code read better in cases that would otherwise return a
 /// bool value.  Failure is "true" in a boolean context.
 enum ParseResult { ParseSuccess, ParseFailure };
@@ -52,6 +81,21 @@ enum ParseResult { ParseSuccess, ParseFailure };
 namespace {
 class Parser;
 
+/// This is the information about a function body whose parsing was deferred
+/// until all of the module-level entities have been parsed.
+struct DeferredFunctionBody {
+  /// The function to parse the body into.
+  Function *function;
+
+  /// The location of the '{' that starts the body.
+  SMLoc bodyLoc;
+
+  /// The location of the function signature, and the names of the arguments
+  /// defined by the signature.
+  SMLoc signatureLoc;
+  SmallVector<StringRef, 4> argNames;
+};
+
 /// This class refers to all of the state maintained globally by the parser,
 /// such as the current lexer position etc.  The Parser base class provides
 /// methods to access this.
@@ -61,6 +105,19 @@ public:
       : context(module->getContext()), module(module), lex(sourceMgr, context),
         curToken(lex.lexToken()) {}
 
+  /// Create a state sharing the module-level definitions of 'parentState',
+  /// used to parse function bodies on a separate thread.
+  ParserState(const llvm::SourceMgr &sourceMgr, const ParserState &parentState)
+      : affineMapDefinitions(parentState.affineMapDefinitions),
+        integerSetDefinitions(parentState.integerSetDefinitions),
+        typeAliasDefinitions(parentState.typeAliasDefinitions),
+        identifierCache(parentState.identifierCache),
+        operationNameCache(parentState.operationNameCache),
+        customOpCache(parentState.customOpCache),
+        dialectTypeCache(parentState.dialectTypeCache),
+        context(parentState.context), module(parentState.module),
+        lex(sourceMgr, context), curToken(lex.lexToken()) {}
+
   ~ParserState() {
     // Destroy the forward references upon error.
     for (auto forwardRef : functionForwardRefs)
@@ -77,10 +134,30 @@ public:
   // A map from type alias identifier to Type.
   llvm::StringMap<Type> typeAliasDefinitions;
 
+  // Caches of the uniqued objects looked up by their spelling, which avoid the
+  // hashed and lock-protected lookups in the context for the spellings seen
+  // before.  Each thread parsing function bodies has its own copy.
+  llvm::StringMap<const void *> identifierCache;
+  llvm::StringMap<void *> operationNameCache;
+  llvm::StringMap<const AbstractOperation *> customOpCache;
+  llvm::StringMap<Type> dialectTypeCache;
+
   // This keeps track of all forward references to functions along with the
   // temporary function used to represent them.
   llvm::DenseMap<Identifier, Function *> functionForwardRefs;
 
+  // If true, the bodies of functions are skipped over and recorded in
+  // 'deferredFunctionBodies'.  They are then parsed in parallel once all of
+  // the functions in the module are known.
+  bool deferFunctionBodies = false;
+  std::vector<DeferredFunctionBody> deferredFunctionBodies;
+
+  /// Reset the lexer so that the current token is the one starting at 'ptr'.
+  void resetToPointer(const char *ptr) {
+    lex.resetPointer(ptr);
+    curToken = lex.lexToken();
+  }
+
 private:
   ParserState(const ParserState &) = delete;
   void operator=(const ParserState &) = delete;
@@ -122,12 +199,26 @@ public:
   const Token &getToken() const { return state.curToken; }
   StringRef getTokenSpelling() const { return state.curToken.getSpelling(); }
 
+  /// Return the identifier for 'str', or the operation name 'name', looked up
+  /// in the caches of the parser first.
+  Identifier getIdentifier(StringRef str);
+  OperationName getOperationName(StringRef name);
+
   /// Encode the specified source location information into an attribute for
   /// attachment to the IR.
   Location getEncodedSourceLocation(llvm::SMLoc loc) {
     return state.lex.getEncodedSourceLocation(loc);
   }
 
+  /// Return the location of the IR defined at 'loc', as selected by the
+  /// -mlir-parse-locations option.
+  Location getIRLocation(llvm::SMLoc loc) {
+    if (parsedLocations == ParsedLocations::None)
+      return UnknownLoc::get(getContext());
+    return state.lex.getEncodedSourceLocation(
+        loc, /*includeColumn=*/parsedLocations == ParsedLocations::All);
+  }
+
   /// Emit an error and return failure.
   ParseResult emitError(const Twine &message) {
     return emitError(state.curToken.getLoc(), message);
@@ -208,6 +299,7 @@ public:
   ParseResult parseAffineMapOrIntegerSetReference(AffineMap &map,
                                                   IntegerSet &set);
   DenseElementsAttr parseDenseElementsAttr(VectorOrTensorType type);
+  DenseElementsAttr parseDenseElementsString(VectorOrTensorType type);
   DenseElementsAttr parseDenseElementsAttrAsTensor(Type eltType);
   VectorOrTensorType parseVectorOrTensorType();
 
@@ -227,6 +319,8 @@ public:
     llvm::Optional<Location> directLoc;
     if (parseLocation(&directLoc))
       return ParseFailure;
+    if (parsedLocations == ParsedLocations::None)
+      return ParseSuccess;
     owner->setLoc(*directLoc);
     return ParseSuccess;
   }
@@ -248,6 +342,24 @@ private:
 // Helper methods.
 //===----------------------------------------------------------------------===//
 
+Identifier Parser::getIdentifier(StringRef str) {
+  auto it = state.identifierCache.find(str);
+  if (it != state.identifierCache.end())
+    return Identifier::getFromOpaquePointer(it->second);
+  auto identifier = builder.getIdentifier(str);
+  state.identifierCache[str] = identifier.getAsOpaquePointer();
+  return identifier;
+}
+
+OperationName Parser::getOperationName(StringRef name) {
+  auto it = state.operationNameCache.find(name);
+  if (it != state.operationNameCache.end())
+    return OperationName::getFromOpaquePointer(it->second);
+  OperationName opName(name, getContext());
+  state.operationNameCache[name] = opName.getAsOpaquePointer();
+  return opName;
+}
+
 ParseResult Parser::emitError(SMLoc loc, const Twine &message) {
   // If we hit a parse error in response to a lexer error, then the lexer
   // already reported the error.
@@ -490,6 +602,7 @@ Type Parser::parseExtendedType() {
   assert(getToken().is(Token::exclamation_identifier));
 
   // Parse the dialect namespace.
+  const char *typeStart = getTokenSpelling().data();
   StringRef identifier = getTokenSpelling().drop_front();
   consumeToken(Token::exclamation_identifier);
 
@@ -514,21 +627,29 @@ Type Parser::parseExtendedType() {
     return (emitError("expected string literal type data in dialect type"),
             nullptr);
 
-  auto typeData = getToken().getStringValue();
-  auto loc = getEncodedSourceLocation(getToken().getLoc());
-  consumeToken(Token::string);
-
-  Type result;
-
-  // If we found a registered dialect, then ask it to parse the type.
-  if (auto *dialect = state.context->getRegisteredDialect(identifier)) {
-    result = dialect->parseType(typeData, loc);
-    if (!result)
-      return nullptr;
+  // Dialect types are uniqued, so the same spelling always parses to the same
+  // type.
+  StringRef spelling(typeStart, getTokenSpelling().end() - typeStart);
+  Type &result = state.dialectTypeCache[spelling];
+  if (result) {
+    consumeToken(Token::string);
   } else {
-    // Otherwise, form a new opaque type.
-    result = OpaqueType::getChecked(Identifier::get(identifier, state.context),
-                                    typeData, state.context, loc);
+    auto typeData = getToken().getStringValue();
+    auto loc = getEncodedSourceLocation(getToken().getLoc());
+    consumeToken(Token::string);
+
+    // If we found a registered dialect, then ask it to parse the type.
+    if (auto *dialect = state.context->getRegisteredDialect(identifier)) {
+      result = dialect->parseType(typeData, loc);
+      if (!result)
+        return nullptr;
+    } else {
+      // Otherwise, form a new opaque type.
+      result = OpaqueType::getChecked(getIdentifier(identifier), typeData,
+                                      state.context, loc);
+      if (!result)
+        return nullptr;
+    }
   }
 
   // Consume the '>'.
@@ -897,7 +1018,7 @@ TensorLiteralParser::parseList(llvm::SmallVectorImpl<int64_t> &dims) {
 /// failure.
 Function *Parser::resolveFunctionReference(StringRef nameStr, SMLoc nameLoc,
                                            FunctionType type) {
-  Identifier name = builder.getIdentifier(nameStr.drop_front());
+  Identifier name = getIdentifier(nameStr.drop_front());
 
   // See if the function has already been defined in the module.
   Function *function = getModule()->getNamedFunction(name);
@@ -906,7 +1027,7 @@ Function *Parser::resolveFunctionReference(StringRef nameStr, SMLoc nameLoc,
   if (!function) {
     auto &entry = state.functionForwardRefs[name];
     if (!entry)
-      entry = new Function(getEncodedSourceLocation(nameLoc), name, type,
+      entry = new Function(getIRLocation(nameLoc), name, type,
                            /*attrs=*/{});
     function = entry;
   }
@@ -928,6 +1049,9 @@ Function *Parser::resolveFunctionReference(StringRef nameStr, SMLoc nameLoc,
 ///                    | function-id `:` function-type
 ///                    | (`splat` | `dense`) `<` (tensor-type | vector-type) `,`
 ///                      attribute-value `>`
+///                    | `dense` `<` (tensor-type | vector-type) `,`
+///                      (hex-string-literal
+///                        | string-literal `,` integer-literal) `>`
 ///                    | `sparse` `<` (tensor-type | vector-type)`,`
 ///                          attribute-value `,` attribute-value `>`
 ///                    | `opaque` `<` dialect-namespace  `,`
@@ -1164,7 +1288,8 @@ Attribute Parser::parseAttribute(Type type) {
     if (!type)
       return nullptr;
 
-    auto attr = parseDenseElementsAttr(type);
+    auto attr = getToken().is(Token::string) ? parseDenseElementsString(type)
+                                             : parseDenseElementsAttr(type);
     if (!attr)
       return nullptr;
 
@@ -1294,6 +1419,58 @@ DenseElementsAttr Parser::parseDenseElementsAttr(VectorOrTensorType type) {
       .cast<DenseElementsAttr>();
 }
 
+/// Dense elements attribute held in a string.
+///
+///   dense-attr-string ::= hex-string-literal
+///                       | string-literal `,` integer-literal
+///
+/// This method returns a dense elements attribute of type 'type' holding the
+/// raw data encoded in hexadecimal in the string, which is decoded at once
+/// rather than element by element, or the raw data at the given byte offset of
+/// the file named by the string, which is mapped in memory rather than read.
+DenseElementsAttr Parser::parseDenseElementsString(VectorOrTensorType type) {
+  auto loc = getToken().getLoc();
+  auto value = getToken().getStringValue();
+  consumeToken(Token::string);
+
+  // A file name is followed by the offset of the raw data in the file.
+  if (consumeIf(Token::comma)) {
+    auto offset = getToken().getUInt64IntegerValue();
+    if (getToken().isNot(Token::integer) || !offset.hasValue())
+      return (emitError("expected byte offset in the file"), nullptr);
+    consumeToken(Token::integer);
+    return DenseElementsAttr::getFromFile(type, value, offset.getValue(),
+                                          getEncodedSourceLocation(loc));
+  }
+
+  StringRef hex(value);
+  if (!hex.startswith("0x"))
+    return (emitError(loc, "expected hex string starting with '0x'"), nullptr);
+  hex = hex.drop_front(2);
+  if (hex.size() % 2 != 0 || !llvm::all_of(hex, llvm::isHexDigit))
+    return (emitError(loc, "expected an even number of hex digits"), nullptr);
+
+  // The elements are packed to their bitwidth, the BF16 ones being stored as
+  // doubles.
+  auto eltType = type.getElementType();
+  size_t bitWidth = eltType.isBF16() ? 64 : eltType.getIntOrFloatBitWidth();
+  size_t numBits = type.getNumElements() * bitWidth;
+  size_t numBytes = llvm::alignTo(numBits, CHAR_BIT) / CHAR_BIT;
+  if (hex.size() / 2 != numBytes)
+    return (emitError(loc, "expected " + Twine(numBytes) +
+                               " bytes of hex data for the type"),
+            nullptr);
+
+  // Pad the data to whole words and clear the bits following the elements,
+  // like in the attributes constructed from element values, which they are
+  // then uniqued with.
+  std::string data = llvm::fromHex(hex);
+  if (numBits % CHAR_BIT != 0)
+    data.back() &= (1 << (numBits % CHAR_BIT)) - 1;
+  data.resize(llvm::alignTo(numBytes, APInt::APINT_WORD_SIZE), 0);
+  return DenseElementsAttr::get(type, ArrayRef<char>(data.data(), data.size()));
+}
+
 /// Vector or tensor type for elements attribute.
 ///
 ///   vector-or-tensor-type ::= vector-type | tensor-type
@@ -1392,7 +1569,7 @@ ParseResult Parser::parseLocationInstance(llvm::Optional<Location> *loc) {
     }
 
     // Otherwise, this is a NameLoc.
-    *loc = NameLoc::get(Identifier::get(str, ctx), ctx);
+    *loc = NameLoc::get(getIdentifier(str), ctx);
     return ParseSuccess;
   }
 
@@ -1501,7 +1678,7 @@ Parser::parseAttributeDict(SmallVectorImpl<NamedAttribute> &attributes) {
     if (getToken().isNot(Token::bare_identifier, Token::inttype) &&
         !getToken().isKeyword())
       return emitError("expected attribute name");
-    Identifier nameId = builder.getIdentifier(getTokenSpelling());
+    Identifier nameId = getIdentifier(getTokenSpelling());
     consumeToken();
 
     if (parseToken(Token::colon, "expected ':' in attribute list"))
@@ -2295,14 +2472,29 @@ private:
   llvm::StringMap<std::pair<Block *, SMLoc>> blocksByName;
   DenseMap<Block *, SMLoc> forwardRef;
 
+  /// The values of an SSA value name along with the location of their first
+  /// definition or use.  This has one entry per result number.
+  using ValueEntries = SmallVector<std::pair<Value *, SMLoc>, 1>;
+
   /// This keeps track of all of the SSA values we are tracking, indexed by
-  /// their name.  This has one entry per result number.
-  llvm::StringMap<SmallVector<std::pair<Value *, SMLoc>, 1>> values;
+  /// their name.  The values named with a number, like the ones printed for
+  /// the results of operations, are indexed by this number instead, to avoid
+  /// hashing their names.
+  llvm::StringMap<ValueEntries> values;
+  std::vector<ValueEntries> numberedValues;
+
+  /// Return the entries of the SSA value named 'name'.
+  ValueEntries &getValueEntries(StringRef name);
 
   /// These are all of the placeholders we've made along with the location of
   /// their first reference, to allow checking for use of undefined values.
   DenseMap<Value *, SMLoc> forwardReferencePlaceholders;
 
+  /// The placeholders are the arguments of this block, which isn't part of the
+  /// function.  They are only deleted along with the parser, as erasing a
+  /// block argument is linear in the number of arguments.
+  Block placeholderBlock;
+
   Value *createForwardReferencePlaceholder(SMLoc loc, Type type);
 
   /// Return true if this is a forward reference.
@@ -2483,25 +2675,32 @@ ParseResult FunctionParser::parseBlockBody(Block *block) {
 
 /// Create and remember a new placeholder for a forward reference.
 Value *FunctionParser::createForwardReferencePlaceholder(SMLoc loc, Type type) {
-  // Forward references are always created as operations, even in ML
-  // functions, because we just need something with a def/use chain.
-  //
-  // We create these placeholders as having an empty name, which we know
-  // cannot be created through normal user input, allowing us to distinguish
-  // them.
-  auto name = OperationName("placeholder", getContext());
-  auto *op = Operation::create(
-      getEncodedSourceLocation(loc), name, /*operands=*/{}, type,
-      /*attributes=*/llvm::None, /*successors=*/{}, /*numRegions=*/0,
-      /*resizableOperandList=*/false, getContext());
-  forwardReferencePlaceholders[op->getResult(0)] = loc;
-  return op->getResult(0);
+  // Forward references only need something with a def/use chain, which a
+  // block argument provides for much cheaper than an operation.
+  auto *placeholder = placeholderBlock.addArgument(type);
+  forwardReferencePlaceholders[placeholder] = loc;
+  return placeholder;
+}
+
+FunctionParser::ValueEntries &FunctionParser::getValueEntries(StringRef name) {
+  // Only the canonical spelling of a number gets a slot in the table, e.g.
+  // %07 and %7 are different values.  Large numbers are kept in the map, so
+  // that a single one doesn't make the table huge.
+  StringRef digits = name.drop_front();
+  unsigned number;
+  if ((digits.size() == 1 || digits.front() != '0') &&
+      !digits.getAsInteger(10, number) && number < (1u << 20)) {
+    if (numberedValues.size() <= number)
+      numberedValues.resize(number + 1);
+    return numberedValues[number];
+  }
+  return values[name];
 }
 
 /// Given an unbound reference to an SSA value and its type, return the value
 /// it specifies.  This returns null on failure.
 Value *FunctionParser::resolveSSAUse(SSAUseInfo useInfo, Type type) {
-  auto &entries = values[useInfo.name];
+  auto &entries = getValueEntries(useInfo.name);
 
   // If we have already seen a value of this name, return it.
   if (useInfo.number < entries.size() && entries[useInfo.number].first) {
@@ -2558,16 +2757,15 @@ ParseResult FunctionParser::finalizeFunction(SMLoc loc) {
 
 FunctionParser::~FunctionParser() {
   for (auto &fwd : forwardReferencePlaceholders) {
-    // Drop all uses of undefined forward declared reference and destroy
-    // defining operation.
+    // Drop all uses of undefined forward declared reference, the placeholder
+    // itself is deleted along with its block.
     fwd.first->dropAllUses();
-    fwd.first->getDefiningOp()->destroy();
   }
 }
 
 /// Register a definition of a value with the symbol table.
 ParseResult FunctionParser::addDefinition(SSAUseInfo useInfo, Value *value) {
-  auto &entries = values[useInfo.name];
+  auto &entries = getValueEntries(useInfo.name);
 
   // Make sure there is a slot for this value.
   if (entries.size() <= useInfo.number)
@@ -2584,10 +2782,9 @@ ParseResult FunctionParser::addDefinition(SSAUseInfo useInfo, Value *value) {
     }
 
     // If it was a forward reference, update everything that used it to use
-    // the actual definition instead, delete the forward ref, and remove it
-    // from our set of forward references we track.
+    // the actual definition instead, and remove it from our set of forward
+    // references we track.
     existing->replaceAllUsesWith(value);
-    existing->getDefiningOp()->destroy();
     forwardReferencePlaceholders.erase(existing);
   }
 
@@ -2928,7 +3125,7 @@ struct CleanupOpStateRegions {
 
 Operation *FunctionParser::parseGenericOperation() {
   // Get location information for the operation.
-  auto srcLocation = getEncodedSourceLocation(getToken().getLoc());
+  auto srcLocation = getIRLocation(getToken().getLoc());
 
   auto name = getToken().getStringValue();
   if (name.empty())
@@ -2938,7 +3135,8 @@ Operation *FunctionParser::parseGenericOperation() {
 
   consumeToken(Token::string);
 
-  OperationState result(builder.getContext(), srcLocation, name);
+  OperationState result(builder.getContext(), srcLocation,
+                        getOperationName(name));
 
   // Generic operations have a resizable operation list.
   result.setOperandListToResizable();
@@ -3123,7 +3321,7 @@ public:
     if (!result)
       return true;
 
-    attrs.push_back(parser.builder.getNamedAttr(attrName, result));
+    attrs.push_back({parser.getIdentifier(attrName), result});
     return false;
   }
 
@@ -3339,7 +3537,9 @@ Operation *FunctionParser::parseCustomOperation() {
   auto opName = getTokenSpelling();
   CustomOpAsmParser opAsmParser(opLoc, opName, *this);
 
-  auto *opDefinition = AbstractOperation::lookup(opName, getContext());
+  const AbstractOperation *&opDefinition = getState().customOpCache[opName];
+  if (!opDefinition)
+    opDefinition = AbstractOperation::lookup(opName, getContext());
   if (!opDefinition && !opName.contains('.')) {
     // If the operation name has no namespace prefix we treat it as a standard
     // operation and prefix it with "std".
@@ -3363,7 +3563,7 @@ Operation *FunctionParser::parseCustomOperation() {
                                    opNameStr.c_str());
 
   // Get location information for the operation.
-  auto srcLocation = getEncodedSourceLocation(opLoc);
+  auto srcLocation = getIRLocation(opLoc);
 
   // Have the op implementation take a crack and parsing this.
   OperationState opState(builder.getContext(), srcLocation, opDefinition->name);
@@ -3487,9 +3687,28 @@ private:
       StringRef &name, FunctionType &type, SmallVectorImpl<StringRef> &argNames,
       SmallVectorImpl<SmallVector<NamedAttribute, 2>> &argAttrs);
   ParseResult parseFunc();
+  ParseResult skipFunctionBody();
+  ParseResult parseDeferredFunctionBodies();
 };
 } // end anonymous namespace
 
+/// Parse the body of 'function', whose entry block has already been added, into
+/// the given parser state.  'argNames' are the names of the entry block
+/// arguments defined by the function signature at 'loc'.
+static ParseResult parseFunctionBody(ParserState &state, Function *function,
+                                     SMLoc loc, ArrayRef<StringRef> argNames) {
+  // Create the parser.
+  auto parser = FunctionParser(state, function);
+
+  // Add definitions of the function arguments.
+  for (unsigned i = 0, e = argNames.size(); i != e; ++i) {
+    if (parser.addDefinition({argNames[i], 0, loc}, function->getArgument(i)))
+      return ParseFailure;
+  }
+
+  return parser.parseFunctionBody(/*hadNamedArguments=*/!argNames.empty());
+}
+
 /// Parses either an affine map declaration or an integer set declaration.
 ///
 /// Affine map declaration.
@@ -3679,7 +3898,7 @@ ParseResult ModuleParser::parseFunc() {
 
   // Okay, the function signature was parsed correctly, create the function now.
   auto *function =
-      new Function(getEncodedSourceLocation(loc), name, type, attrs);
+      new Function(getIRLocation(loc), name, type, attrs);
   getModule()->getFunctions().push_back(function);
 
   // Verify no name collision / redefinition.
@@ -3699,23 +3918,103 @@ ParseResult ModuleParser::parseFunc() {
   if (getToken().isNot(Token::l_brace))
     return ParseSuccess;
 
-  // Create the parser.
-  auto parser = FunctionParser(getState(), function);
-
-  bool hadNamedArguments = !argNames.empty();
-
   // Add the entry block and argument list.
   function->addEntryBlock();
 
-  // Add definitions of the function arguments.
-  if (hadNamedArguments) {
-    for (unsigned i = 0, e = function->getNumArguments(); i != e; ++i) {
-      if (parser.addDefinition({argNames[i], 0, loc}, function->getArgument(i)))
-        return ParseFailure;
+  // If the body is to be parsed in parallel, record it and skip over it.
+  if (getState().deferFunctionBodies) {
+    getState().deferredFunctionBodies.push_back(
+        {function, getToken().getLoc(), loc, {argNames.begin(), argNames.end()}});
+    return skipFunctionBody();
+  }
+
+  return ::parseFunctionBody(getState(), function, loc, argNames);
+}
+
+/// Skip over the body of a function, starting at the '{', by matching up the
+/// braces within it.
+ParseResult ModuleParser::skipFunctionBody() {
+  consumeToken(Token::l_brace);
+  for (unsigned depth = 1; depth != 0;) {
+    switch (getToken().getKind()) {
+    case Token::l_brace:
+      ++depth;
+      break;
+    case Token::r_brace:
+      --depth;
+      break;
+    case Token::eof:
+      return emitError("expected '}' to end function body");
+    case Token::error:
+      return ParseFailure;
+    default:
+      break;
     }
+    consumeToken();
   }
+  return ParseSuccess;
+}
 
-  return parser.parseFunctionBody(hadNamedArguments);
+/// Parse the function bodies that were skipped over by the module parser.  The
+/// bodies only refer to module-level entities, which are all known by now, so
+/// they are parsed in parallel with a separate parser state per thread.
+ParseResult ModuleParser::parseDeferredFunctionBodies() {
+  auto &bodies = getState().deferredFunctionBodies;
+  if (bodies.empty())
+    return ParseSuccess;
+
+  // The line number cache of the source manager is lazily built and isn't
+  // thread-safe, so make sure that it is populated before spawning threads.
+  (void)getSourceMgr().getLineAndColumn(bodies.front().bodyLoc);
+
+  // Create the parser states for each of the threads.
+  std::vector<std::unique_ptr<ParserState>> threadStates;
+  unsigned numThreads =
+      std::min<size_t>(getContext()->getMaxConcurrency(), bodies.size());
+  for (unsigned i = 0; i != numThreads; ++i)
+    threadStates.emplace_back(new ParserState(getSourceMgr(), getState()));
+
+  // A parallel diagnostic handler that orders diagnostics by the position of
+  // the function within the module.
+  ParallelDiagnosticHandler diagHandler(*getContext());
+
+  // An index for the next body to parse, and an atomic failure flag.  All of
+  // the bodies are parsed even after a failure, so that the set of emitted
+  // diagnostics is deterministic.
+  std::atomic<unsigned> bodyIt(0);
+  std::atomic<bool> parseFailed(false);
+  parallelForEachWorker(getContext(), numThreads, [&](unsigned workerID) {
+    auto &threadState = threadStates[workerID];
+    for (auto e = bodies.size();;) {
+      unsigned nextID = bodyIt++;
+      if (nextID >= e)
+        break;
+      diagHandler.setOrderIDForThread(nextID);
+
+      auto &body = bodies[nextID];
+      threadState->resetToPointer(body.bodyLoc.getPointer());
+      bool bodyFailed = ::parseFunctionBody(
+          *threadState, body.function, body.signatureLoc, body.argNames);
+      if (bodyFailed)
+        parseFailed = true;
+
+      // All of the functions in the module are known, so any remaining
+      // forward reference is to an undefined function.
+      auto &forwardRefs = threadState->functionForwardRefs;
+      if (forwardRefs.empty())
+        continue;
+      if (!bodyFailed) {
+        auto forwardRef = *forwardRefs.begin();
+        forwardRef.second->emitError("reference to undefined function '" +
+                                     forwardRef.first.str() + "'");
+        parseFailed = true;
+      }
+      for (auto forwardRef : forwardRefs)
+        delete forwardRef.second;
+      forwardRefs.clear();
+    }
+  });
+  return parseFailed ? ParseFailure : ParseSuccess;
 }
 
 /// Finish the end of module parsing - when the result is valid, do final
@@ -3765,6 +4064,8 @@ ParseResult ModuleParser::parseModule() {
 
       // If we got to the end of the file, then we're done.
     case Token::eof:
+      if (parseDeferredFunctionBodies())
+        return ParseFailure;
       return finalizeModule();
 
     // If we got an error token, then the lexer already emitted an error, just
@@ -3786,6 +4087,10 @@ ParseResult ModuleParser::parseModule() {
     case Token::kw_func:
       if (parseFunc())
         return ParseFailure;
+      // Unless they are deferred, the functions parsed so far don't need
+      // their text anymore.
+      if (!getState().deferFunctionBodies)
+        getState().lex.releaseInputBefore(getToken().getLoc().getPointer());
       break;
     }
   }
@@ -3803,6 +4108,7 @@ Module *mlir::parseSourceFile(const llvm::SourceMgr &sourceMgr,
   std::unique_ptr<Module> module(new Module(context));
 
   ParserState state(sourceMgr, module.get());
+  state.deferFunctionBodies = enableThreads;
   if (ModuleParser(state).parseModule()) {
     return nullptr;
   }
@@ -3843,3 +4149,51 @@ Module *mlir::parseSourceString(StringRef moduleStr, MLIRContext *context) {
   sourceMgr.AddNewSourceBuffer(std::move(memBuffer), SMLoc());
   return parseSourceFile(sourceMgr, context);
 }
+
+/// Parse a single standalone entity, type or attribute, from `inputStr` using
+/// `parseFn`.  Returns null on failure or if the entity did not consume the
+/// entire string.
+template <typename T>
+static T parseStandaloneEntity(StringRef inputStr, MLIRContext *context,
+                               llvm::function_ref<T(Parser &)> parseFn) {
+  // The lexer expects a null terminated buffer, so always copy the input.
+  SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(MemoryBuffer::getMemBufferCopy(inputStr),
+                               SMLoc());
+
+  // Standalone entities never reference functions, so a scratch module is
+  // enough to hold the parser state.
+  Module scratchModule(context);
+  ParserState state(sourceMgr, &scratchModule);
+  Parser parser(state);
+
+  T entity = parseFn(parser);
+  if (!entity)
+    return T();
+
+  // References to functions can't be resolved without a parent module.
+  if (!state.functionForwardRefs.empty()) {
+    parser.emitError("unexpected function reference");
+    return T();
+  }
+  if (parser.getToken().isNot(Token::eof)) {
+    parser.emitError("unexpected trailing characters");
+    return T();
+  }
+  return entity;
+}
+
+/// This parses a single MLIR type from the given string. If not valid, it emits
+/// diagnostics and returns null.
+Type mlir::parseType(StringRef typeStr, MLIRContext *context) {
+  return parseStandaloneEntity<Type>(
+      typeStr, context, [](Parser &parser) { return parser.parseType(); });
+}
+
+/// This parses a single MLIR attribute from the given string. If not valid, it
+/// emits diagnostics and returns null.
+Attribute mlir::parseAttribute(StringRef attrStr, MLIRContext *context) {
+  return parseStandaloneEntity<Attribute>(
+      attrStr, context,
+      [](Parser &parser) { return parser.parseAttribute(); });
+}
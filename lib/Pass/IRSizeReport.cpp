@@ -0,0 +1,257 @@
+//===- IRSizeReport.cpp ---------------------------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements an instrumentation reporting how the size of the IR, and
+// the storage uniqued in the context, change across each pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/Threading.h"
+
+using namespace mlir;
+using namespace mlir::detail;
+
+constexpr llvm::StringLiteral kIRSizeReportDescription =
+    "... Pass IR size report ...";
+
+namespace {
+/// The number of operations and blocks in a unit of IR.
+struct IRSize {
+  int64_t numOps = 0, numBlocks = 0;
+
+  IRSize &operator+=(const IRSize &other) {
+    numOps += other.numOps;
+    numBlocks += other.numBlocks;
+    return *this;
+  }
+  IRSize operator-(const IRSize &other) const {
+    IRSize result;
+    result.numOps = numOps - other.numOps;
+    result.numBlocks = numBlocks - other.numBlocks;
+    return result;
+  }
+};
+
+/// The change in the storage uniqued in the context across a module pass.
+struct StorageDelta {
+  int64_t numTypes = 0, numAttributes = 0, numAffineMaps = 0;
+  int64_t allocatedBytes = 0;
+
+  StorageDelta() = default;
+  StorageDelta(const MLIRContext::StorageStatistics &before,
+               const MLIRContext::StorageStatistics &after)
+      : numTypes(int64_t(after.numTypes) - int64_t(before.numTypes)),
+        numAttributes(int64_t(after.numAttributes) -
+                      int64_t(before.numAttributes)),
+        numAffineMaps(int64_t(after.numAffineMaps) -
+                      int64_t(before.numAffineMaps)),
+        allocatedBytes(int64_t(after.allocatedBytes) -
+                       int64_t(before.allocatedBytes)) {}
+
+  StorageDelta &operator+=(const StorageDelta &other) {
+    numTypes += other.numTypes;
+    numAttributes += other.numAttributes;
+    numAffineMaps += other.numAffineMaps;
+    allocatedBytes += other.allocatedBytes;
+    return *this;
+  }
+};
+
+/// The IR size record of a pass, accumulated over all of its runs.
+struct PassSizeRecord {
+  /// The size of the IR units the pass ran on, before and after it ran.
+  IRSize before, after;
+
+  /// The change in the storage of the context, only recorded for module
+  /// passes as function passes may run concurrently.
+  llvm::Optional<StorageDelta> storage;
+};
+
+struct IRSizeReport : public PassInstrumentation {
+  ~IRSizeReport() { print(); }
+
+  /// Instrumentation hooks.
+  void runBeforePass(Pass *pass, const llvm::Any &ir) override;
+  void runAfterPass(Pass *pass, const llvm::Any &ir) override;
+  void runAfterPassFailed(Pass *pass, const llvm::Any &ir) override {
+    runAfterPass(pass, ir);
+  }
+
+  /// Print and clear the recorded sizes.
+  void print();
+
+  /// Returns the name to display for the given pass.
+  static StringRef getPassName(Pass *pass) {
+    if (isModuleToFunctionAdaptorPass(pass))
+      return "Function Pipeline";
+    return pass->getName();
+  }
+
+  /// The sizes recorded before the passes still running on each thread,
+  /// innermost last, along with the statistics of the context for module
+  /// passes.
+  struct ActiveRecord {
+    IRSize size;
+    MLIRContext::StorageStatistics storage;
+  };
+  DenseMap<uint64_t, SmallVector<ActiveRecord, 4>> activeRecords;
+
+  /// The records of each pass, keyed by name in the order the passes first
+  /// ran.  The passes of a pipeline sharing a name are merged, as are the
+  /// copies of a function pass running on different threads.
+  llvm::MapVector<StringRef, PassSizeRecord> records;
+
+  /// The statistics of the context after the last module pass.
+  llvm::Optional<MLIRContext::StorageStatistics> finalStorage;
+
+  /// Function passes run concurrently when multi-threading is enabled, so the
+  /// records are guarded by a mutex.
+  llvm::sys::SmartMutex<true> mutex;
+};
+} // end anonymous namespace
+
+/// Return the number of operations and blocks held by 'function', including
+/// those nested in the regions of its operations.
+static IRSize getIRSize(Function *function) {
+  IRSize size;
+  // Don't materialize the functions whose body hasn't been loaded yet, or
+  // the size of a pipeline would depend on the instrumentations added to it.
+  if (function->isMaterializable())
+    return size;
+  size.numBlocks = function->getBlocks().size();
+  function->walk([&](Operation *op) {
+    ++size.numOps;
+    for (auto &region : op->getRegions())
+      size.numBlocks += region.getBlocks().size();
+  });
+  return size;
+}
+
+/// Return the size of the given unit of IR, a function or a module.
+static IRSize getIRSize(const llvm::Any &ir) {
+  if (llvm::any_isa<Function *>(ir))
+    return getIRSize(llvm::any_cast<Function *>(ir));
+  IRSize size;
+  for (auto &function : *llvm::any_cast<Module *>(ir))
+    size += getIRSize(&function);
+  return size;
+}
+
+void IRSizeReport::runBeforePass(Pass *pass, const llvm::Any &ir) {
+  ActiveRecord record;
+  record.size = getIRSize(ir);
+  if (llvm::any_isa<Module *>(ir))
+    record.storage =
+        llvm::any_cast<Module *>(ir)->getContext()->getStorageStatistics();
+
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  activeRecords[llvm::get_threadid()].push_back(record);
+}
+
+void IRSizeReport::runAfterPass(Pass *pass, const llvm::Any &ir) {
+  IRSize size = getIRSize(ir);
+  llvm::Optional<MLIRContext::StorageStatistics> storage;
+  if (llvm::any_isa<Module *>(ir))
+    storage =
+        llvm::any_cast<Module *>(ir)->getContext()->getStorageStatistics();
+
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  auto &activeStack = activeRecords[llvm::get_threadid()];
+  assert(!activeStack.empty() && "expected a size recorded before the pass");
+  auto activeRecord = activeStack.pop_back_val();
+
+  auto &record = records[getPassName(pass)];
+  record.before += activeRecord.size;
+  record.after += size;
+  if (storage) {
+    if (!record.storage)
+      record.storage = StorageDelta();
+    *record.storage += StorageDelta(activeRecord.storage, *storage);
+    finalStorage = storage;
+  }
+}
+
+/// Print a signed change in a column of 'width' characters.
+static void printDelta(raw_ostream &os, int64_t delta, unsigned width) {
+  os << llvm::format_decimal(delta, width - 1);
+  os << (delta > 0 ? "+" : " ");
+}
+
+/// Print the recorded sizes, and the change of the storage of the context.
+void IRSizeReport::print() {
+  // Don't print anything if no pass ran.
+  if (records.empty())
+    return;
+
+  auto os = llvm::CreateInfoOutputFile();
+  *os << "===" << std::string(73, '-') << "===\n";
+  unsigned padding = (80 - kIRSizeReportDescription.size()) / 2;
+  os->indent(padding) << kIRSizeReportDescription << '\n';
+  *os << "===" << std::string(73, '-') << "===\n";
+
+  if (finalStorage) {
+    *os << llvm::format("  Context storage: %zu types, %zu attributes, "
+                        "%zu affine maps, %zu KB\n\n",
+                        finalStorage->numTypes, finalStorage->numAttributes,
+                        finalStorage->numAffineMaps,
+                        finalStorage->allocatedBytes / 1024);
+  }
+
+  // The operation and block columns show the size of the IR after each pass
+  // followed by its change, the storage columns only show the change.
+  *os << llvm::format("%16s%17s%8s%8s%8s%6s  --- Name ---\n", "Ops ",
+                      "Blocks ", "Types ", "Attrs ", "Maps ", "KB ");
+  for (auto &it : records) {
+    auto &record = it.second;
+    IRSize delta = record.after - record.before;
+    *os << llvm::format_decimal(record.after.numOps, 8);
+    printDelta(*os, delta.numOps, 8);
+    *os << llvm::format_decimal(record.after.numBlocks, 9);
+    printDelta(*os, delta.numBlocks, 8);
+    if (record.storage) {
+      printDelta(*os, record.storage->numTypes, 8);
+      printDelta(*os, record.storage->numAttributes, 8);
+      printDelta(*os, record.storage->numAffineMaps, 8);
+      printDelta(*os, record.storage->allocatedBytes / 1024, 6);
+    } else {
+      *os << llvm::format("%8s%8s%8s%6s", "- ", "- ", "- ", "- ");
+    }
+    *os << "  " << it.first << "\n";
+  }
+  os->flush();
+
+  records.clear();
+  activeRecords.clear();
+  finalStorage.reset();
+}
+
+/// Add an instrumentation to report the size of the IR, and of the storage
+/// uniqued in the context, before and after each pass.
+void PassManager::enableIRSizeReport() {
+  // Check if the report is already enabled.
+  if (irSizeReport)
+    return;
+  addInstrumentation(new IRSizeReport());
+  irSizeReport = true;
+}
@@ -21,12 +21,18 @@
 
 #include "mlir/Pass/Pass.h"
 #include "PassDetail.h"
+#include "mlir/Analysis/Dominance.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/Module.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Mutex.h"
-#include "llvm/Support/Parallel.h"
-#include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Threading.h"
 
 using namespace mlir;
@@ -45,11 +51,61 @@ static llvm::cl::opt<bool> enableThreads(
 /// single .o file.
 void Pass::anchor() {}
 
+/// Register the statistics of this pass, which was copy constructed from
+/// 'original'.
+void Pass::cloneStatistics(const Pass &original) {
+  // The pass may have registered its statistics again while being copied, so
+  // start from an empty list.
+  statistics.clear();
+  auto *originalBase = reinterpret_cast<const char *>(&original);
+  auto *base = reinterpret_cast<char *>(this);
+  for (auto *stat : original.statistics) {
+    auto offset = reinterpret_cast<const char *>(stat) - originalBase;
+    statistics.push_back(reinterpret_cast<Statistic *>(base + offset));
+  }
+}
+
+/// Add the values of the statistics of this pass to those of 'other', and
+/// reset the statistics of this pass.
+void Pass::mergeStatisticsInto(Pass &other) {
+  assert(statistics.size() == other.statistics.size() &&
+         "expected a clone of this pass");
+  for (unsigned i = 0, e = statistics.size(); i != e; ++i) {
+    *other.statistics[i] += *statistics[i];
+    *statistics[i] = 0;
+  }
+}
+
+/// Reset the budget state at the start of a run of this pass.
+void Pass::startBudget() {
+  budgetState.consumedWorkUnits = 0;
+  budgetState.exhausted = false;
+  if (budget.milliseconds != 0)
+    budgetState.deadline = std::chrono::steady_clock::now() +
+                           std::chrono::milliseconds(budget.milliseconds);
+}
+
+/// Consume 'workUnits' units of the budget of the current run of this pass.
+/// Returns false once the budget of the run is exhausted.
+bool Pass::consumeBudget(uint64_t workUnits) {
+  if (budgetState.exhausted)
+    return false;
+  budgetState.consumedWorkUnits += workUnits;
+  if (budget.workUnits != 0 &&
+      budgetState.consumedWorkUnits > budget.workUnits)
+    budgetState.exhausted = true;
+  else if (budget.milliseconds != 0 &&
+           std::chrono::steady_clock::now() > budgetState.deadline)
+    budgetState.exhausted = true;
+  return !budgetState.exhausted;
+}
+
 /// Forwarding function to execute this pass.
 LogicalResult FunctionPassBase::run(Function *fn,
                                     FunctionAnalysisManager &fam) {
   // Initialize the pass state.
   passState.emplace(fn, fam);
+  startBudget();
 
   // Instrument before the pass has run.
   auto pi = fam.getPassInstrumentor();
@@ -65,6 +121,8 @@ LogicalResult FunctionPassBase::run(Function *fn,
   // Instrument after the pass has run.
   bool passFailed = passState->irAndPassFailed.getInt();
   if (pi) {
+    if (isBudgetExhausted())
+      pi->runAfterPassBudgetExhausted(this, fn);
     if (passFailed)
       pi->runAfterPassFailed(this, fn);
     else
@@ -79,6 +137,7 @@ LogicalResult FunctionPassBase::run(Function *fn,
 LogicalResult ModulePassBase::run(Module *module, ModuleAnalysisManager &mam) {
   // Initialize the pass state.
   passState.emplace(module, mam);
+  startBudget();
 
   // Instrument before the pass has run.
   auto pi = mam.getPassInstrumentor();
@@ -88,12 +147,19 @@ LogicalResult ModulePassBase::run(Module *module, ModuleAnalysisManager &mam) {
   // Invoke the virtual runOnModule function.
   runOnModule();
 
-  // Invalidate any non preserved analyses.
-  mam.invalidate(passState->preservedAnalyses);
+  // Invalidate any non preserved analyses. The function analyses of adaptor
+  // passes are already invalidated by the held function pipeline after each
+  // of its passes.
+  if (isModuleToFunctionAdaptorPass(this))
+    mam.invalidateModuleAnalyses(passState->preservedAnalyses);
+  else
+    mam.invalidate(passState->preservedAnalyses);
 
   // Instrument after the pass has run.
   bool passFailed = passState->irAndPassFailed.getInt();
   if (pi) {
+    if (isBudgetExhausted())
+      pi->runAfterPassBudgetExhausted(this, module);
     if (passFailed)
       pi->runAfterPassFailed(this, module);
     else
@@ -104,19 +170,62 @@ LogicalResult ModulePassBase::run(Module *module, ModuleAnalysisManager &mam) {
   return failure(passFailed);
 }
 
+/// Forwarding function to execute this pass. Loop nest passes aren't
+/// instrumented, as they run concurrently within the run of their adaptor,
+/// which is instrumented as a whole.
+LogicalResult LoopNestPassBase::run(Function *nest,
+                                    LoopNestAnalysisManager &nam) {
+  // Initialize the pass state.
+  passState.emplace(nest, nam);
+  startBudget();
+
+  // Invoke the virtual runOnLoopNest function.
+  runOnLoopNest();
+
+  // Invalidate any non preserved analyses.
+  nam.invalidate(passState->preservedAnalyses);
+
+  // Return if the pass signaled a failure.
+  return failure(passState->irAndPassFailed.getInt());
+}
+
 //===----------------------------------------------------------------------===//
 // PassExecutor
 //===----------------------------------------------------------------------===//
 
 FunctionPassExecutor::FunctionPassExecutor(const FunctionPassExecutor &rhs)
-    : PassExecutor(Kind::FunctionExecutor) {
+    : PassExecutor(Kind::FunctionExecutor),
+      skipUnchangedFunctions(rhs.skipUnchangedFunctions) {
   for (auto &pass : rhs.passes)
     addPass(pass->clone());
 }
 
+/// Merge the statistics of the passes of this executor into 'other'.
+void detail::FunctionPassExecutor::mergeStatisticsInto(
+    FunctionPassExecutor &other) {
+  assert(size() == other.size() && "expected a clone of this executor");
+  for (unsigned i = 0, e = size(); i != e; ++i) {
+    passes[i]->mergeStatisticsInto(*other.passes[i]);
+    if (auto *adaptor = dyn_cast<FunctionFixedPointAdaptor>(passes[i].get()))
+      adaptor->getFunctionExecutor().mergeStatisticsInto(
+          cast<FunctionFixedPointAdaptor>(*other.passes[i])
+              .getFunctionExecutor());
+    else if (auto *adaptor =
+                 dyn_cast<FunctionToLoopNestPassAdaptor>(passes[i].get()))
+      adaptor->getLoopNestExecutor().mergeStatisticsInto(
+          cast<FunctionToLoopNestPassAdaptor>(*other.passes[i])
+              .getLoopNestExecutor());
+  }
+}
+
 /// Run all of the passes in this manager over the current function.
 LogicalResult detail::FunctionPassExecutor::run(Function *function,
                                                 FunctionAnalysisManager &fam) {
+  if (skipUnchangedFunctions) {
+    ChangeTracker tracker(function);
+    return run(function, fam, tracker);
+  }
+
   // Run each of the held passes.
   for (auto &pass : passes)
     if (failed(pass->run(function, fam)))
@@ -124,6 +233,76 @@ LogicalResult detail::FunctionPassExecutor::run(Function *function,
   return success();
 }
 
+detail::FunctionPassExecutor::ChangeTracker::ChangeTracker(Function *function)
+    : fingerprint(AnalysisCache::computeFingerprint(function)) {}
+
+/// Run all of the passes in this manager over the current function, skipping
+/// the runs of idempotent passes on a function that didn't change since they
+/// last ran on it.
+LogicalResult
+detail::FunctionPassExecutor::run(Function *function,
+                                  FunctionAnalysisManager &fam,
+                                  ChangeTracker &tracker) {
+  // Changes to the function are detected through its fingerprint, which is
+  // recomputed after each pass that didn't preserve all of the analyses. The
+  // last idempotent run of each pass is recorded as the number of changes
+  // seen so far.
+  auto &lastRuns = tracker.lastRuns;
+  for (auto &pass : passes) {
+    auto it = lastRuns.find(pass->getPassID());
+    if (it != lastRuns.end() && it->second == tracker.numChanges)
+      continue;
+
+    if (failed(pass->run(function, fam)))
+      return failure();
+
+    // A pass preserving all of the analyses is considered to have left the
+    // function unchanged.
+    if (!pass->passState->preservedAnalyses.isAll()) {
+      auto newFingerprint = AnalysisCache::computeFingerprint(function);
+      if (newFingerprint != tracker.fingerprint) {
+        tracker.fingerprint = newFingerprint;
+        ++tracker.numChanges;
+      }
+    }
+    // A run cut short by the budget of the pass may not have reached a fixed
+    // point.
+    if (pass->isIdempotent() && !pass->isBudgetExhausted())
+      lastRuns[pass->getPassID()] = tracker.numChanges;
+    else
+      lastRuns.erase(pass->getPassID());
+  }
+  return success();
+}
+
+LoopNestPassExecutor::LoopNestPassExecutor(const LoopNestPassExecutor &rhs)
+    : PassExecutor(Kind::LoopNestExecutor) {
+  for (auto &pass : rhs.passes)
+    addPass(pass->clone());
+}
+
+/// Merge the statistics of the passes of this executor into 'other'.
+void detail::LoopNestPassExecutor::mergeStatisticsInto(
+    LoopNestPassExecutor &other) {
+  assert(size() == other.size() && "expected a clone of this executor");
+  for (unsigned i = 0, e = size(); i != e; ++i)
+    passes[i]->mergeStatisticsInto(*other.passes[i]);
+}
+
+/// Run all of the passes in this manager over the current loop nest.
+LogicalResult detail::LoopNestPassExecutor::run(Function *nest,
+                                                LoopNestAnalysisManager &nam,
+                                                bool &preservedAll) {
+  // Run each of the held passes.
+  for (auto &pass : passes) {
+    if (failed(pass->run(nest, nam)))
+      return failure();
+    if (!pass->passState->preservedAnalyses.isAll())
+      preservedAll = false;
+  }
+  return success();
+}
+
 /// Run all of the passes in this manager over the current module.
 LogicalResult detail::ModulePassExecutor::run(Module *module,
                                               ModuleAnalysisManager &mam) {
@@ -134,6 +313,289 @@ LogicalResult detail::ModulePassExecutor::run(Module *module,
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// FunctionFixedPointAdaptor
+//===----------------------------------------------------------------------===//
+
+/// Run the held function pipeline over the current function until an
+/// iteration leaves it unchanged. The changes are tracked across the
+/// iterations, so the idempotent passes are skipped as long as the function
+/// doesn't change.
+void FunctionFixedPointAdaptor::runOnFunction() {
+  auto &function = getFunction();
+  FunctionPassExecutor::ChangeTracker tracker(&function);
+  converged = false;
+  for (unsigned i = 0; i != maxIterations && !converged; ++i) {
+    ++numIterations;
+    unsigned numChanges = tracker.numChanges;
+    if (failed(fpe.run(&function, getAnalysisManager(), tracker)))
+      return signalPassFailure();
+    converged = tracker.numChanges == numChanges;
+  }
+  if (!converged)
+    ++numNotConverged;
+
+  // The held passes already invalidated the analyses that they didn't
+  // preserve.
+  if (tracker.numChanges == 0)
+    markAllAnalysesPreserved();
+}
+
+//===----------------------------------------------------------------------===//
+// FunctionToLoopNestPassAdaptor
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A loop nest moved to a function of its own for the duration of a loop nest
+/// pipeline, in the same way as the partitions of the parallel greedy pattern
+/// rewrite driver. The nest doesn't use any value defined outside of this
+/// function, so that the passes transforming different nests concurrently
+/// never update the same use list or operation list.
+struct LoopNestPartition {
+  /// Move 'root' into a new function. Constants used by the nest are cloned
+  /// into it, which keeps the nest analyzable.
+  void extract(Operation *root);
+
+  /// Move the transformed nest back in front of 'anchor', or at the end of
+  /// 'block' if there is no anchor. The copies of the constants that are left
+  /// unchanged are replaced by the original constants, and the other constants
+  /// of the partition are moved to the start of 'entryBlock'.
+  void restore(Block *entryBlock);
+
+  /// The position within the original function to restore the nest to.
+  Block *block;
+  Operation *anchor;
+
+  /// The function holding the nest while it is transformed.
+  std::unique_ptr<Function> function;
+
+  /// The values used by the nest that are defined outside of it, one for each
+  /// argument of 'function'.
+  SmallVector<Value *, 8> externalValues;
+
+  /// The copies of the constants used by the nest, and the constants they
+  /// copy.
+  llvm::DenseMap<Operation *, Value *> constants;
+};
+} // end anonymous namespace
+
+/// Returns true if 'op' is a constant, i.e. an operation without operands or
+/// regions that folds to a single attribute.
+static bool isConstantLike(Operation &op) {
+  Attribute value;
+  return op.getNumOperands() == 0 && op.getNumRegions() == 0 &&
+         op.getNumResults() == 1 &&
+         matchPattern(op.getResult(0), m_Constant(&value));
+}
+
+/// Returns true if 'op' is equivalent to the constant defining 'value'.
+static bool isEquivalentConstant(Operation &op, Value *value) {
+  Operation *defOp = value->getDefiningOp();
+  return op.getName() == defOp->getName() && op.getNumOperands() == 0 &&
+         op.getNumRegions() == 0 && op.getNumResults() == 1 &&
+         op.getResult(0)->getType() == value->getType() &&
+         op.getAttrs() == defOp->getAttrs();
+}
+
+void LoopNestPartition::extract(Operation *root) {
+  // Collect the values that are defined within the nest.
+  llvm::DenseSet<Value *> definedValues;
+  root->walk([&](Operation *op) {
+    definedValues.insert(op->result_begin(), op->result_end());
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        definedValues.insert(block.args_begin(), block.args_end());
+  });
+
+  // Collect the values used by the nest that are defined outside of it.
+  llvm::SetVector<Value *> externalConstants, externals;
+  root->walk([&](Operation *op) {
+    for (auto *operand : op->getOperands()) {
+      if (definedValues.count(operand))
+        continue;
+      auto *defOp = operand->getDefiningOp();
+      if (defOp && isConstantLike(*defOp))
+        externalConstants.insert(operand);
+      else
+        externals.insert(operand);
+    }
+  });
+  externalValues.assign(externals.begin(), externals.end());
+
+  // Create the function to hold the nest.
+  SmallVector<Type, 8> argTypes;
+  for (auto *value : externalValues)
+    argTypes.push_back(value->getType());
+  auto *context = root->getContext();
+  function = llvm::make_unique<Function>(
+      root->getLoc(), "loop_nest", FunctionType::get(argTypes, {}, context));
+  function->addEntryBlock();
+
+  BlockAndValueMapping mapper;
+  for (unsigned i = 0, e = externalValues.size(); i != e; ++i)
+    mapper.map(externalValues[i], function->getArgument(i));
+  FuncBuilder builder(function.get());
+  for (auto *value : externalConstants) {
+    auto *copy = builder.clone(*value->getDefiningOp());
+    constants[copy] = value;
+    mapper.map(value, copy->getResult(0));
+  }
+
+  // Remap the external uses, and move the nest into the function.
+  root->walk([&](Operation *op) {
+    for (auto &operand : op->getOpOperands())
+      if (auto *newValue = mapper.lookupOrNull(operand.get()))
+        operand.set(newValue);
+  });
+  auto &entryBlock = function->front();
+  root->moveBefore(&entryBlock, entryBlock.end());
+}
+
+void LoopNestPartition::restore(Block *entryBlock) {
+  assert(function->getBlocks().size() == 1 &&
+         "expected the loop nest to remain in a single block");
+  auto &partitionBlock = function->front();
+  for (unsigned i = 0, e = externalValues.size(); i != e; ++i)
+    function->getArgument(i)->replaceAllUsesWith(externalValues[i]);
+
+  // The passes may have erased some of the copies of the constants, and
+  // created other operations at their addresses. Such an operation is only
+  // replaced if it is equivalent to the constant that was copied.
+  auto insertPt = anchor ? Block::iterator(anchor) : block->end();
+  while (!partitionBlock.empty()) {
+    auto &op = partitionBlock.front();
+    auto constant = constants.find(&op);
+    if (constant != constants.end() &&
+        isEquivalentConstant(op, constant->second)) {
+      op.getResult(0)->replaceAllUsesWith(constant->second);
+      op.erase();
+    } else if (isConstantLike(op)) {
+      op.moveBefore(entryBlock, entryBlock->begin());
+    } else {
+      op.moveBefore(block, insertPt);
+    }
+  }
+  function.reset();
+}
+
+/// Run the held loop nest pipeline over each loop nest of the current
+/// function.
+void FunctionToLoopNestPassAdaptor::runOnFunction() {
+  // Compute where each loop nest is restored to before moving any of them.
+  // Adjacent nests share the same anchor and are restored in order.
+  auto isLoopNest = [](Operation &op) {
+    return op.getNumRegions() != 0 && op.getNumResults() == 0;
+  };
+  auto &function = getFunction();
+  std::vector<LoopNestPartition> nests;
+  SmallVector<Operation *, 8> roots;
+  for (auto &block : function) {
+    for (auto &op : block) {
+      if (!isLoopNest(op))
+        continue;
+      auto anchorIt = std::next(Block::iterator(&op));
+      while (anchorIt != block.end() && isLoopNest(*anchorIt))
+        ++anchorIt;
+      LoopNestPartition nest;
+      nest.block = &block;
+      nest.anchor = anchorIt == block.end() ? nullptr : &*anchorIt;
+      nests.push_back(std::move(nest));
+      roots.push_back(&op);
+    }
+  }
+  if (nests.empty())
+    return markAllAnalysesPreserved();
+
+  // Extract the loop nests, and create an analysis map for each of them.
+  std::vector<AnalysisMap<Function>> nestAnalyses;
+  nestAnalyses.reserve(nests.size());
+  for (unsigned i = 0, e = nests.size(); i != e; ++i) {
+    nests[i].extract(roots[i]);
+    nestAnalyses.emplace_back(nests[i].function.get());
+  }
+  numLoopNests += nests.size();
+
+  // Run the given executor over the loop nest at 'index'.
+  FunctionAnalysisManager &fam = getAnalysisManager();
+  std::atomic<bool> preservedAll(true);
+  auto runOnLoopNest = [&](LoopNestPassExecutor &executor, unsigned index) {
+    LoopNestAnalysisManager nam(fam, nestAnalyses[index]);
+    bool nestPreservedAll = true;
+    auto result =
+        executor.run(nests[index].function.get(), nam, nestPreservedAll);
+    if (!nestPreservedAll)
+      preservedAll = false;
+    return result;
+  };
+
+  std::atomic<bool> passFailed(false);
+  unsigned numThreads = getContext().getMaxConcurrency();
+  if (!runInParallel || numThreads == 1 || nests.size() == 1) {
+    for (unsigned i = 0, e = nests.size(); i != e && !passFailed; ++i)
+      passFailed = failed(runOnLoopNest(lpe, i));
+  } else {
+    // Create the async executors if they haven't been created, or if the main
+    // loop nest pipeline or the concurrency of the context has changed.
+    if (asyncExecutors.size() != numThreads ||
+        asyncExecutors.front().size() != lpe.size())
+      asyncExecutors = {numThreads, lpe};
+
+    // Order the loop nests by decreasing number of operations, as for the
+    // functions of a module, see ModuleToFunctionPassAdaptorParallel.
+    std::vector<std::pair<unsigned, unsigned>> costAndIndex;
+    costAndIndex.reserve(nests.size());
+    for (unsigned i = 0, e = nests.size(); i != e; ++i) {
+      unsigned numOps = 0;
+      nests[i].function->walk([&](Operation *) { ++numOps; });
+      costAndIndex.emplace_back(numOps, i);
+    }
+    std::stable_sort(costAndIndex.begin(), costAndIndex.end(),
+                     [](const std::pair<unsigned, unsigned> &lhs,
+                        const std::pair<unsigned, unsigned> &rhs) {
+                       return lhs.first > rhs.first;
+                     });
+
+    // A parallel diagnostic handler that orders the diagnostics by loop nest.
+    ParallelDiagnosticHandler diagHandler(getContext());
+    std::atomic<unsigned> nestIt(0);
+    unsigned numWorkers = std::min<size_t>(numThreads, nests.size());
+    parallelForEachWorker(&getContext(), numWorkers, [&](unsigned workerID) {
+      auto &executor = asyncExecutors[workerID];
+      for (auto e = nests.size(); !passFailed && nestIt < e;) {
+        unsigned nextIt = nestIt++;
+        if (nextIt >= e)
+          break;
+        unsigned nextID = costAndIndex[nextIt].second;
+        diagHandler.setOrderIDForThread(nextID);
+        if (failed(runOnLoopNest(executor, nextID))) {
+          passFailed = true;
+          break;
+        }
+      }
+    });
+
+    // Merge the statistics of the async executors into the main executor.
+    for (auto &executor : asyncExecutors)
+      executor.mergeStatisticsInto(lpe);
+  }
+
+  // Drop the analyses of the loop nests before moving the nests back into
+  // place, as their functions are destroyed. The nests are restored even after
+  // a failure, so that the function is left in a consistent state.
+  nestAnalyses.clear();
+  for (auto &nest : nests)
+    nest.restore(&function.front());
+
+  if (passFailed)
+    return signalPassFailure();
+
+  // The moves of the loop nests, and the copies of the constants, have no
+  // effect on the function once the nests are restored, unless the passes
+  // created new constants, which don't preserve all the analyses anyway.
+  if (preservedAll)
+    markAllAnalysesPreserved();
+}
+
 //===----------------------------------------------------------------------===//
 // ModuleToFunctionPassAdaptor
 //===----------------------------------------------------------------------===//
@@ -142,15 +604,16 @@ LogicalResult detail::ModulePassExecutor::run(Module *module,
 /// function pass executor.
 static LogicalResult runFunctionPipeline(FunctionPassExecutor &fpe,
                                          Function *func,
-                                         FunctionAnalysisManager &fam) {
+                                         FunctionAnalysisManager &fam,
+                                         bool retainAnalyses) {
   // Run the function pipeline over the provided function.
   auto result = fpe.run(func, fam);
 
-  // Clear out any computed function analyses. These analyses won't be used
-  // any more in this pipeline, and this helps reduce the current working set
-  // of memory. If preserving these analyses becomes important in the future
-  // we can re-evalutate this.
-  fam.clear();
+  // Clear out any computed function analyses, unless they are retained for the
+  // next run of the pass manager. These analyses won't be used any more in
+  // this pipeline, and this helps reduce the current working set of memory.
+  if (!retainAnalyses || failed(result))
+    fam.clear();
   return result;
 }
 
@@ -165,198 +628,104 @@ void ModuleToFunctionPassAdaptor::runOnModule() {
 
     // Run the held function pipeline over the current function.
     auto fam = mam.slice(&func);
-    if (failed(runFunctionPipeline(fpe, &func, fam)))
+    if (failed(runFunctionPipeline(fpe, &func, fam,
+                                   mam.isCachingFunctionAnalyses())))
       return signalPassFailure();
-
-    // Clear out any computed function analyses. These analyses won't be used
-    // any more in this pipeline, and this helps reduce the current working set
-    // of memory. If preserving these analyses becomes important in the future
-    // we can re-evalutate this.
-    fam.clear();
   }
 }
 
-namespace {
-/// A utility class to ensure that diagnostics are emitted in a deterministic
-/// order when executing a pipeline asynchronously with
-/// ModuleToFunctionPassAdaptorParallel.
-struct ParallelDiagnosticHandler {
-  struct ThreadDiagnostic {
-    ThreadDiagnostic(size_t id, Location loc, StringRef msg,
-                     MLIRContext::DiagnosticKind kind)
-        : id(id), loc(loc), msg(msg), kind(kind) {}
-    bool operator<(const ThreadDiagnostic &rhs) const { return id < rhs.id; }
-
-    /// The function id for this diagnostic, this is used for ordering.
-    /// Note: This id corresponds to the ordered position of the current
-    ///       function within its parent module.
-    size_t id;
-
-    /// Information for the diagnostic.
-    Location loc;
-    std::string msg;
-    MLIRContext::DiagnosticKind kind;
-  };
-
-  ParallelDiagnosticHandler(MLIRContext &ctx)
-      : prevHandler(ctx.getDiagnosticHandler()), context(ctx) {
-    ctx.registerDiagnosticHandler([this](Location loc, StringRef message,
-                                         MLIRContext::DiagnosticKind kind) {
-      uint64_t tid = llvm::get_threadid();
-      llvm::sys::SmartScopedLock<true> lock(mutex);
-
-      // Append a new diagnostic.
-      diagnostics.emplace_back(threadToFuncID[tid], loc, message, kind);
-    });
-  }
-
-  ~ParallelDiagnosticHandler() {
-    // Restore the previous diagnostic handler.
-    context.registerDiagnosticHandler(prevHandler);
-
-    // Early exit if there are no diagnostics, this is the common case.
-    if (diagnostics.empty())
-      return;
-
-    // Emit the diagnostics back to the context.
-    emitDiagnostics(
-        [&](Location loc, StringRef message, MLIRContext::DiagnosticKind kind) {
-          return context.emitDiagnostic(loc, message, kind);
-        });
-  }
-
-  /// Utility method to emit any held diagnostics.
-  void emitDiagnostics(
-      std::function<void(Location, StringRef, MLIRContext::DiagnosticKind)>
-          emitFn) {
-    // Stable sort all of the diagnostics that were emitted. This creates a
-    // deterministic ordering for the diagnostics based upon which function they
-    // were emitted for.
-    std::stable_sort(diagnostics.begin(), diagnostics.end());
-
-    // Emit each diagnostic to the context again.
-    for (ThreadDiagnostic &diag : diagnostics)
-      emitFn(diag.loc, diag.msg, diag.kind);
-  }
-
-  /// Set the function id for the current thread.
-  void setFuncIDForThread(size_t funcID) {
-    uint64_t tid = llvm::get_threadid();
-    llvm::sys::SmartScopedLock<true> lock(mutex);
-    threadToFuncID[tid] = funcID;
-  }
-
-  /// The previous context diagnostic handler.
-  MLIRContext::DiagnosticHandlerTy prevHandler;
-
-  /// A smart mutex to lock access to the internal state.
-  llvm::sys::SmartMutex<true> mutex;
-
-  /// A mapping between the thread id and the current function id.
-  DenseMap<uint64_t, size_t> threadToFuncID;
-
-  /// An unordered list of diagnostics that were emitted.
-  std::vector<ThreadDiagnostic> diagnostics;
-
-  /// The context to emit the diagnostics to.
-  MLIRContext &context;
-};
-
-/// A utility stack trace entry that dumps any dangling diagnostics held by a
-/// ParallelDiagnosticHandler in the event of a crash.
-struct PrettyStackTraceParallelDiagnosticEntry
-    : public llvm::PrettyStackTraceEntry {
-  PrettyStackTraceParallelDiagnosticEntry(
-      ParallelDiagnosticHandler &parallelHandler)
-      : parallelHandler(parallelHandler) {}
-
-  void print(raw_ostream &os) const override {
-    // Early exit if there are no diagnostics, this is the common case.
-    if (parallelHandler.diagnostics.empty())
-      return;
-
-    os << "In-Flight Diagnostics:\n";
-    parallelHandler.emitDiagnostics(
-        [&](Location loc, StringRef message, MLIRContext::DiagnosticKind kind) {
-          os.indent(4);
-
-          // Print each diagnostic with the format:
-          //   "<location>: <kind>: <msg>"
-          if (!loc.isa<UnknownLoc>())
-            os << loc << ": ";
-          switch (kind) {
-          case MLIRContext::DiagnosticKind::Error:
-            os << "error: ";
-            break;
-          case MLIRContext::DiagnosticKind::Warning:
-            os << "warning: ";
-            break;
-          case MLIRContext::DiagnosticKind::Note:
-            os << "note: ";
-            break;
-          }
-          os << message << '\n';
-        });
-  }
-
-  // A reference to the parallel handler to dump on the event of a crash.
-  ParallelDiagnosticHandler &parallelHandler;
-};
-} // end anonymous namespace
-
 // Run the held function pipeline synchronously across the functions within
 // the module.
 void ModuleToFunctionPassAdaptorParallel::runOnModule() {
   ModuleAnalysisManager &mam = getAnalysisManager();
 
   // Create the async executors if they haven't been created, or if the main
-  // function pipeline has changed.
-  if (asyncExecutors.empty() || asyncExecutors.front().size() != fpe.size())
-    asyncExecutors = {llvm::hardware_concurrency(), fpe};
+  // function pipeline or the concurrency of the context has changed.
+  unsigned numThreads = getContext().getMaxConcurrency();
+  if (asyncExecutors.size() != numThreads ||
+      asyncExecutors.front().size() != fpe.size() ||
+      asyncExecutors.front().isSkippingUnchangedFunctions() !=
+          fpe.isSkippingUnchangedFunctions())
+    asyncExecutors = {numThreads, fpe};
 
   // Run a prepass over the module to collect the functions to execute a over.
   // This ensures that an analysis manager exists for each function, as well as
-  // providing a queue of functions to execute over.
+  // providing a queue of functions to execute over. Lazily loaded function
+  // bodies are materialized here as function materializers aren't required to
+  // be thread-safe.
   std::vector<std::pair<Function *, FunctionAnalysisManager>> funcAMPairs;
-  for (auto &func : getModule())
-    if (!func.isExternal())
-      funcAMPairs.emplace_back(&func, mam.slice(&func));
+  for (auto &func : getModule()) {
+    if (func.isExternal())
+      continue;
+    if (failed(func.materialize()))
+      return signalPassFailure();
+    funcAMPairs.emplace_back(&func, mam.slice(&func));
+  }
+
+  // Order the functions by decreasing estimated cost, using the number of
+  // operations as the estimate. Dispatching the largest functions first keeps
+  // a single large function at the end of the module from becoming the
+  // critical path while the other threads sit idle. The functions keep their
+  // module index for the diagnostic handler, so the order of diagnostics is
+  // unaffected.
+  std::vector<std::pair<unsigned, unsigned>> costAndIndex;
+  costAndIndex.reserve(funcAMPairs.size());
+  for (unsigned i = 0, e = funcAMPairs.size(); i != e; ++i) {
+    unsigned numOps = 0;
+    funcAMPairs[i].first->walk([&](Operation *) { ++numOps; });
+    costAndIndex.emplace_back(numOps, i);
+  }
+  std::stable_sort(costAndIndex.begin(), costAndIndex.end(),
+                   [](const std::pair<unsigned, unsigned> &lhs,
+                      const std::pair<unsigned, unsigned> &rhs) {
+                     return lhs.first > rhs.first;
+                   });
 
   // A parallel diagnostic handler that provides deterministic diagnostic
-  // ordering.
+  // ordering, and prints any dangling diagnostics in the event of a crash.
   ParallelDiagnosticHandler diagHandler(getContext());
 
-  // A pretty stack entry to print any dangling diagnostics in the event of a
-  // crash.
-  PrettyStackTraceParallelDiagnosticEntry diagCrashEntry(diagHandler);
-
-  // An index for the current function/analysis manager pair.
+  // An index into the cost ordered list of function/analysis manager pairs.
+  // Each executor takes the next most expensive function as soon as it is
+  // done with its current one.
   std::atomic<unsigned> funcIt(0);
 
   // An atomic failure variable for the async executors.
   std::atomic<bool> passFailed(false);
-  llvm::parallel::for_each(
-      llvm::parallel::par, asyncExecutors.begin(),
-      std::next(asyncExecutors.begin(),
-                std::min(asyncExecutors.size(), funcAMPairs.size())),
-      [&](FunctionPassExecutor &executor) {
-        for (auto e = funcAMPairs.size(); !passFailed && funcIt < e;) {
-          // Get the next available function index.
-          unsigned nextID = funcIt++;
-          if (nextID >= e)
-            break;
-
-          // Set the function id for this thread in the diagnostic handler.
-          diagHandler.setFuncIDForThread(nextID);
-
-          // Run the executor over the current function.
-          auto &it = funcAMPairs[nextID];
-          if (failed(runFunctionPipeline(executor, it.first, it.second))) {
-            passFailed = true;
-            break;
-          }
-        }
-      });
+  unsigned numWorkers = std::min<size_t>(numThreads, funcAMPairs.size());
+
+  // The loop nest pipelines only transform their loop nests in parallel if
+  // a single function is transformed at a time, as the parallel diagnostic
+  // handlers of the context can't be nested across threads.
+  for (auto &executor : asyncExecutors)
+    for (auto &pass : executor.getPasses())
+      if (auto *adaptor = dyn_cast<FunctionToLoopNestPassAdaptor>(pass.get()))
+        adaptor->setRunInParallel(numWorkers == 1);
+  parallelForEachWorker(&getContext(), numWorkers, [&](unsigned workerID) {
+    auto &executor = asyncExecutors[workerID];
+    for (auto e = funcAMPairs.size(); !passFailed && funcIt < e;) {
+      // Get the next available function index.
+      unsigned nextIt = funcIt++;
+      if (nextIt >= e)
+        break;
+      unsigned nextID = costAndIndex[nextIt].second;
+
+      // Set the function id for this thread in the diagnostic handler.
+      diagHandler.setOrderIDForThread(nextID);
+
+      // Run the executor over the current function.
+      auto &it = funcAMPairs[nextID];
+      if (failed(runFunctionPipeline(executor, it.first, it.second,
+                                     mam.isCachingFunctionAnalyses()))) {
+        passFailed = true;
+        break;
+      }
+    }
+  });
+
+  // Merge the statistics of the async executors into the main executor.
+  for (auto &executor : asyncExecutors)
+    executor.mergeStatisticsInto(fpe);
 
   // Signal a failure if any of the executors failed.
   if (passFailed)
@@ -370,33 +739,111 @@ void ModuleToFunctionPassAdaptorParallel::runOnModule() {
 namespace {
 /// Pass to verify a function and signal failure if necessary.
 class FunctionVerifier : public FunctionPass<FunctionVerifier> {
+public:
+  explicit FunctionVerifier(VerificationLevel level) : level(level) {}
+
+  /// Verifying an unchanged function again has no effect.
+  bool isIdempotent() const override { return true; }
+
+private:
   void runOnFunction() {
-    if (failed(getFunction().verify()))
+    // Reuse the dominance information of the function if it is still valid,
+    // i.e. if the previous passes preserved it.
+    auto domInfo = getCachedAnalysis<DominanceInfo>();
+    if (failed(getFunction().verify(level,
+                                    domInfo ? &domInfo->get() : nullptr)))
       signalPassFailure();
     markAllAnalysesPreserved();
   }
+
+  VerificationLevel level;
 };
 
 /// Pass to verify a module and signal failure if necessary.
 class ModuleVerifier : public ModulePass<ModuleVerifier> {
+public:
+  explicit ModuleVerifier(VerificationLevel level) : level(level) {}
+
+private:
   void runOnModule() {
-    if (failed(getModule().verify()))
+    if (failed(getModule().verify(level)))
       signalPassFailure();
     markAllAnalysesPreserved();
   }
+
+  VerificationLevel level;
 };
 } // end anonymous namespace
 
 PassManager::PassManager(bool verifyPasses)
     : mpe(new ModulePassExecutor()), verifyPasses(verifyPasses),
-      passTiming(false) {}
+      passTiming(false), irSizeReport(false), budgetReport(false),
+      skipUnchangedFunctions(false),
+      verificationLevel(VerificationLevel::Full) {}
 
 PassManager::~PassManager() {}
 
+/// Set the invariants checked by the verifier runs added after each pass.
+void PassManager::setVerificationLevel(VerificationLevel level) {
+  verificationLevel = level;
+}
+
+/// Skip the runs of idempotent function passes on the functions that didn't
+/// change since the pass last ran on them.
+void PassManager::enableSkippingUnchangedFunctions() {
+  skipUnchangedFunctions = true;
+
+  // Update the function executors already in the pipeline.
+  for (auto &pass : mpe->getPasses()) {
+    if (auto *adaptor = dyn_cast<ModuleToFunctionPassAdaptor>(pass.get()))
+      adaptor->getFunctionExecutor().setSkipUnchangedFunctions(true);
+    else if (auto *adaptor =
+                 dyn_cast<ModuleToFunctionPassAdaptorParallel>(pass.get()))
+      adaptor->getFunctionExecutor().setSkipUnchangedFunctions(true);
+  }
+}
+
+/// Set the budget of 'pass' and of the passes nested in it.
+static void setBudgetOfPasses(Pass *pass, const PassBudget &budget) {
+  pass->setBudget(budget);
+  for (auto *nestedPass : getNestedPasses(pass))
+    setBudgetOfPasses(nestedPass, budget);
+}
+
+/// Set the budget of each run of the passes within this manager, including
+/// the passes added afterwards.
+void PassManager::setPassBudget(const PassBudget &budget) {
+  passBudget.reset(new PassBudget(budget));
+  for (auto &pass : mpe->getPasses())
+    setBudgetOfPasses(pass.get(), budget);
+}
+
 /// Run the passes within this manager on the provided module.
 LogicalResult PassManager::run(Module *module) {
-  ModuleAnalysisManager mam(module, instrumentor.get());
-  return mpe->run(module, mam);
+  ModuleAnalysisManager mam(module, instrumentor.get(), analysisCache.get());
+  if (analysisCache)
+    mam.restoreFromCache();
+  auto result = mpe->run(module, mam);
+
+  // The verifier runs between the passes may only have checked the structure
+  // of the IR, so check the remaining invariants once at the end.
+  if (succeeded(result) && verifyPasses &&
+      verificationLevel != VerificationLevel::Full)
+    result = module->verify();
+
+  // Retain the analyses that are still valid for the next run. Nothing is
+  // known about the state of the IR after a failure, so drop them instead.
+  if (analysisCache) {
+    if (succeeded(result))
+      mam.storeToCache();
+    else
+      analysisCache->clear();
+  }
+
+  // Dump the statistics of the executed passes if requested.
+  if (passStatisticsMode)
+    printStatistics();
+  return result;
 }
 
 /// Add an opaque pass pointer to the current manager. This takes ownership
@@ -409,6 +856,9 @@ void PassManager::addPass(Pass *pass) {
   case Pass::Kind::ModulePass:
     addPass(cast<ModulePassBase>(pass));
     break;
+  case Pass::Kind::LoopNestPass:
+    addPass(cast<LoopNestPassBase>(pass));
+    break;
   }
 }
 
@@ -417,10 +867,12 @@ void PassManager::addPass(Pass *pass) {
 void PassManager::addPass(ModulePassBase *pass) {
   nestedExecutorStack.clear();
   mpe->addPass(pass);
+  if (passBudget)
+    setBudgetOfPasses(pass, *passBudget);
 
   // Add a verifier run if requested.
   if (verifyPasses)
-    mpe->addPass(new ModuleVerifier());
+    mpe->addPass(new ModuleVerifier(verificationLevel));
 }
 
 /// Add a function pass to the current manager. This takes ownership over the
@@ -442,15 +894,64 @@ void PassManager::addPass(FunctionPassBase *pass) {
     }
 
     /// Add the executor to the stack.
+    fpe->setSkipUnchangedFunctions(skipUnchangedFunctions);
     nestedExecutorStack.push_back(fpe);
   } else {
+    // Leave the loop nest pipeline of the previous passes, if any.
+    if (isa<detail::LoopNestPassExecutor>(nestedExecutorStack.back()))
+      nestedExecutorStack.pop_back();
     fpe = cast<detail::FunctionPassExecutor>(nestedExecutorStack.back());
   }
   fpe->addPass(pass);
+  if (passBudget)
+    setBudgetOfPasses(pass, *passBudget);
 
-  // Add a verifier run if requested.
-  if (verifyPasses)
-    fpe->addPass(new FunctionVerifier());
+  // Add a verifier run if requested. The passes of a fixed point pipeline are
+  // already followed by their own verifier runs.
+  if (verifyPasses && !isa<FunctionFixedPointAdaptor>(pass))
+    fpe->addPass(new FunctionVerifier(verificationLevel));
+}
+
+/// Add a loop nest pass to the current manager. This takes ownership over the
+/// provided pass pointer. This will automatically create a loop nest pass
+/// executor, within a function pass executor, if necessary.
+void PassManager::addPass(LoopNestPassBase *pass) {
+  detail::LoopNestPassExecutor *lpe;
+  if (nestedExecutorStack.empty() ||
+      !isa<detail::LoopNestPassExecutor>(nestedExecutorStack.back())) {
+    /// Create an executor adaptor for this pass, whose loop nests are
+    /// transformed in parallel if multi-threading is enabled.
+    auto *adaptor = new FunctionToLoopNestPassAdaptor(
+        enableThreads && llvm::llvm_is_multithreaded());
+    addPass(adaptor);
+    lpe = &adaptor->getLoopNestExecutor();
+
+    /// Add the executor to the stack.
+    nestedExecutorStack.push_back(lpe);
+  } else {
+    lpe = cast<detail::LoopNestPassExecutor>(nestedExecutorStack.back());
+  }
+  lpe->addPass(pass);
+  if (passBudget)
+    pass->setBudget(*passBudget);
+}
+
+/// Add a function pipeline made of 'passes' that is rerun on each function
+/// until the function stops changing, or for at most 'maxIterations'
+/// iterations. This takes ownership over the provided pass pointers.
+void PassManager::addFixedPointPipeline(ArrayRef<FunctionPassBase *> passes,
+                                        unsigned maxIterations) {
+  assert(maxIterations != 0 && "expected at least one iteration");
+  auto *adaptor = new FunctionFixedPointAdaptor(maxIterations);
+  auto &fpe = adaptor->getFunctionExecutor();
+  for (auto *pass : passes) {
+    fpe.addPass(pass);
+
+    // Add a verifier run if requested.
+    if (verifyPasses)
+      fpe.addPass(new FunctionVerifier(verificationLevel));
+  }
+  addPass(adaptor);
 }
 
 /// Add the provided instrumentation to the pass manager. This takes ownership
@@ -479,6 +980,37 @@ FunctionAnalysisManager ModuleAnalysisManager::slice(Function *function) {
   return {this, &it.first->second};
 }
 
+/// Take the cached analyses of each function of the module whose fingerprint
+/// didn't change since it was cached.
+void ModuleAnalysisManager::restoreFromCache() {
+  assert(cache && "expected an analysis cache");
+  for (auto &func : *moduleAnalyses.getIRUnit()) {
+    auto it = cache->entries.find(&func);
+    if (it == cache->entries.end())
+      continue;
+    if (it->second.fingerprint == AnalysisCache::computeFingerprint(&func))
+      functionAnalyses.try_emplace(&func, std::move(it->second.analyses));
+  }
+
+  // The remaining entries are stale, or belong to functions that no longer
+  // exist.
+  cache->clear();
+}
+
+/// Replace the contents of the cache with the current function analyses.
+void ModuleAnalysisManager::storeToCache() {
+  assert(cache && "expected an analysis cache");
+  cache->clear();
+  for (auto &analysisPair : functionAnalyses) {
+    if (analysisPair.second.empty())
+      continue;
+    Function *func = analysisPair.first;
+    cache->entries.try_emplace(func, AnalysisCache::computeFingerprint(func),
+                               std::move(analysisPair.second));
+  }
+  functionAnalyses.clear();
+}
+
 /// Invalidate any non preserved analyses.
 void ModuleAnalysisManager::invalidate(const detail::PreservedAnalyses &pa) {
   // If all analyses were preserved, then there is nothing to do here.
@@ -500,6 +1032,109 @@ void ModuleAnalysisManager::invalidate(const detail::PreservedAnalyses &pa) {
     analysisPair.second.invalidate(pa);
 }
 
+//===----------------------------------------------------------------------===//
+// AnalysisCache
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Computes the fingerprint of a function. The blocks and values are hashed by
+/// their address, as the cached analyses may refer to them, and by the order
+/// in which they are first encountered in the function, so that an address
+/// reused by an entity defined or used elsewhere changes the fingerprint.
+class FingerprintHasher {
+public:
+  llvm::hash_code hashFunction(Function *function) {
+    hash = llvm::hash_combine(function, function->getType(),
+                              function->getName());
+    hashRegion(function->getBody());
+    return hash;
+  }
+
+private:
+  /// Hash the blocks of the given region, and the operations within them.
+  void hashRegion(Region &region) {
+    for (auto &block : region) {
+      hashBlock(&block);
+      for (auto *arg : block.getArguments())
+        hashValue(arg, arg->getType());
+
+      for (auto &op : block) {
+        hash = llvm::hash_combine(hash, &op, op.getName());
+        for (auto &attr : op.getAttrs())
+          hash = llvm::hash_combine(hash, attr.first.getAsOpaquePointer(),
+                                    attr.second);
+        for (auto *operand : op.getOperands())
+          hashValue(operand, Type());
+        for (auto *result : op.getResults())
+          hashValue(result, result->getType());
+        for (unsigned i = 0, e = op.getNumSuccessors(); i != e; ++i)
+          hashBlock(op.getSuccessor(i));
+        for (auto &nestedRegion : op.getRegions())
+          hashRegion(nestedRegion);
+      }
+    }
+  }
+
+  /// Hash a block, along with its position in the function.
+  void hashBlock(Block *block) {
+    auto it = blockIds.try_emplace(block, blockIds.size()).first;
+    hash = llvm::hash_combine(hash, block, it->second);
+  }
+
+  /// Hash a value, along with its position in the function and its type if
+  /// non-null.
+  void hashValue(Value *value, Type type) {
+    auto it = valueIds.try_emplace(value, valueIds.size()).first;
+    hash = llvm::hash_combine(hash, value, it->second, type);
+  }
+
+  llvm::hash_code hash = 0;
+  llvm::DenseMap<Block *, unsigned> blockIds;
+  llvm::DenseMap<Value *, unsigned> valueIds;
+};
+} // end anonymous namespace
+
+/// Compute the fingerprint of the given function.
+llvm::hash_code AnalysisCache::computeFingerprint(Function *function) {
+  return FingerprintHasher().hashFunction(function);
+}
+
+/// Keep the function analyses that are still valid at the end of 'run' in a
+/// cache, and reuse them in the next call to 'run'.
+void PassManager::enableAnalysisCache() {
+  if (!analysisCache)
+    analysisCache = llvm::make_unique<AnalysisCache>();
+}
+
+/// Drop the analyses held by the analysis cache, if enabled.
+void PassManager::clearAnalysisCache() {
+  if (analysisCache)
+    analysisCache->clear();
+}
+
+/// Returns the function executor held by the given adaptor pass.
+static FunctionPassExecutor &getAdaptorExecutor(Pass *pass) {
+  if (auto *adaptor = dyn_cast<ModuleToFunctionPassAdaptor>(pass))
+    return adaptor->getFunctionExecutor();
+  if (auto *adaptor = dyn_cast<FunctionFixedPointAdaptor>(pass))
+    return adaptor->getFunctionExecutor();
+  return cast<ModuleToFunctionPassAdaptorParallel>(pass)->getFunctionExecutor();
+}
+
+/// Returns the passes nested in the given pass, i.e. the passes of the pipeline
+/// executed by an adaptor pass or by a loop nest adaptor.
+SmallVector<Pass *, 8> mlir::detail::getNestedPasses(Pass *pass) {
+  SmallVector<Pass *, 8> nestedPasses;
+  if (isAdaptorPass(pass)) {
+    for (auto &nestedPass : getAdaptorExecutor(pass).getPasses())
+      nestedPasses.push_back(nestedPass.get());
+  } else if (auto *adaptor = dyn_cast<FunctionToLoopNestPassAdaptor>(pass)) {
+    for (auto &nestedPass : adaptor->getLoopNestExecutor().getPasses())
+      nestedPasses.push_back(nestedPass.get());
+  }
+  return nestedPasses;
+}
+
 //===----------------------------------------------------------------------===//
 // PassInstrumentation
 //===----------------------------------------------------------------------===//
@@ -546,6 +1181,14 @@ void PassInstrumentor::runAfterPassFailed(Pass *pass, const llvm::Any &ir) {
     instr->runAfterPassFailed(pass, ir);
 }
 
+/// See PassInstrumentation::runAfterPassBudgetExhausted for details.
+void PassInstrumentor::runAfterPassBudgetExhausted(Pass *pass,
+                                                   const llvm::Any &ir) {
+  llvm::sys::SmartScopedLock<true> instrumentationLock(impl->mutex);
+  for (auto &instr : llvm::reverse(impl->instrumentations))
+    instr->runAfterPassBudgetExhausted(pass, ir);
+}
+
 /// See PassInstrumentation::runBeforeAnalysis for details.
 void PassInstrumentor::runBeforeAnalysis(llvm::StringRef name, AnalysisID *id,
                                          const llvm::Any &ir) {
@@ -0,0 +1,116 @@
+//===- PassBudgetReport.cpp -----------------------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements an instrumentation reporting the runs of the passes
+// that exhausted their compile-time budget.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetail.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Mutex.h"
+
+using namespace mlir;
+using namespace mlir::detail;
+
+constexpr llvm::StringLiteral kPassBudgetReportDescription =
+    "... Pass budget report ...";
+
+namespace {
+struct PassBudgetReport : public PassInstrumentation {
+  ~PassBudgetReport() { print(); }
+
+  /// Instrumentation hooks.
+  void runAfterPassBudgetExhausted(Pass *pass, const llvm::Any &ir) override;
+
+  /// Print and clear the recorded runs.
+  void print();
+
+  /// The budget of the passes whose runs were recorded, by name.
+  llvm::MapVector<StringRef, PassBudget> budgets;
+
+  /// The names of the IR units on which each pass exhausted its budget, keyed
+  /// by pass name in the order the passes first exhausted their budget. The
+  /// copies of a function pass running on different threads are merged.
+  llvm::MapVector<StringRef, std::vector<std::string>> records;
+
+  /// Function passes run concurrently when multi-threading is enabled, so the
+  /// records are guarded by a mutex.
+  llvm::sys::SmartMutex<true> mutex;
+};
+} // end anonymous namespace
+
+void PassBudgetReport::runAfterPassBudgetExhausted(Pass *pass,
+                                                   const llvm::Any &ir) {
+  std::string irName = "<module>";
+  if (llvm::any_isa<Function *>(ir))
+    irName = ("@" + llvm::any_cast<Function *>(ir)->getName().strref()).str();
+
+  llvm::sys::SmartScopedLock<true> lock(mutex);
+  budgets[pass->getName()] = pass->getBudget();
+  records[pass->getName()].push_back(std::move(irName));
+}
+
+/// Print the limits of 'budget', e.g. "100 work units and 10 ms".
+static void printBudget(raw_ostream &os, const PassBudget &budget) {
+  if (budget.workUnits != 0)
+    os << budget.workUnits << " work units";
+  if (budget.workUnits != 0 && budget.milliseconds != 0)
+    os << " and ";
+  if (budget.milliseconds != 0)
+    os << budget.milliseconds << " ms";
+}
+
+/// Print the recorded runs, by pass.
+void PassBudgetReport::print() {
+  // Don't print anything if no pass exhausted its budget.
+  if (records.empty())
+    return;
+
+  auto os = llvm::CreateInfoOutputFile();
+  *os << "===" << std::string(73, '-') << "===\n";
+  unsigned padding = (80 - kPassBudgetReportDescription.size()) / 2;
+  os->indent(padding) << kPassBudgetReportDescription << '\n';
+  *os << "===" << std::string(73, '-') << "===\n";
+
+  for (auto &it : records) {
+    auto &budget = budgets[it.first];
+    *os << "  " << it.first << ": " << it.second.size() << " run"
+        << (it.second.size() == 1 ? "" : "s") << " exhausted a budget of ";
+    printBudget(*os, budget);
+    *os << '\n';
+    for (auto &irName : it.second)
+      *os << "    " << irName << '\n';
+  }
+  os->flush();
+
+  records.clear();
+  budgets.clear();
+}
+
+/// Add an instrumentation to report the runs of the passes that exhausted
+/// their budget.
+void PassManager::enableBudgetReport() {
+  // Check if the report is already enabled.
+  if (budgetReport)
+    return;
+  addInstrumentation(new PassBudgetReport());
+  budgetReport = true;
+}
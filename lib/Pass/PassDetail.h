@@ -29,7 +29,7 @@ namespace detail {
 /// The abstract base pass executor class.
 class PassExecutor {
 public:
-  enum Kind { FunctionExecutor, ModuleExecutor };
+  enum Kind { FunctionExecutor, LoopNestExecutor, ModuleExecutor };
   explicit PassExecutor(Kind kind) : kind(kind) {}
 
   /// Get the kind of this executor.
@@ -47,9 +47,29 @@ public:
   FunctionPassExecutor(FunctionPassExecutor &&) = default;
   FunctionPassExecutor(const FunctionPassExecutor &rhs);
 
+  /// The state used to skip the runs of idempotent passes on a function that
+  /// didn't change since they last ran on it.
+  struct ChangeTracker {
+    explicit ChangeTracker(Function *function);
+
+    /// The fingerprint of the function after the last change.
+    llvm::hash_code fingerprint;
+
+    /// The number of changes to the function seen so far.
+    unsigned numChanges = 0;
+
+    /// The number of changes seen at the last idempotent run of each pass.
+    llvm::SmallDenseMap<const PassID *, unsigned, 4> lastRuns;
+  };
+
   /// Run the executor on the given function.
   LogicalResult run(Function *function, FunctionAnalysisManager &fam);
 
+  /// Run the executor on the given function, skipping the runs of idempotent
+  /// passes on unchanged IR as recorded by 'tracker'.
+  LogicalResult run(Function *function, FunctionAnalysisManager &fam,
+                    ChangeTracker &tracker);
+
   /// Add a pass to the current executor. This takes ownership over the provided
   /// pass pointer.
   void addPass(FunctionPassBase *pass) { passes.emplace_back(pass); }
@@ -57,12 +77,66 @@ public:
   /// Returns the number of passes held by this executor.
   size_t size() const { return passes.size(); }
 
+  /// Returns the passes held by this executor.
+  MutableArrayRef<std::unique_ptr<FunctionPassBase>> getPasses() {
+    return passes;
+  }
+
+  /// Skip the runs of idempotent passes on a function that didn't change since
+  /// the last run of the same pass on it in this pipeline.
+  void setSkipUnchangedFunctions(bool skip) { skipUnchangedFunctions = skip; }
+  bool isSkippingUnchangedFunctions() const { return skipUnchangedFunctions; }
+
+  /// Merge the statistics of the passes of this executor into those of
+  /// 'other', which must be a clone of this executor.
+  void mergeStatisticsInto(FunctionPassExecutor &other);
+
   static bool classof(const PassExecutor *pe) {
     return pe->getKind() == Kind::FunctionExecutor;
   }
 
 private:
   std::vector<std::unique_ptr<FunctionPassBase>> passes;
+
+  /// Flag that specifies if the runs of idempotent passes on unchanged
+  /// functions are skipped.
+  bool skipUnchangedFunctions = false;
+};
+
+/// A pass executor that contains a list of passes over a loop nest.
+class LoopNestPassExecutor : public PassExecutor {
+public:
+  LoopNestPassExecutor() : PassExecutor(Kind::LoopNestExecutor) {}
+  LoopNestPassExecutor(LoopNestPassExecutor &&) = default;
+  LoopNestPassExecutor(const LoopNestPassExecutor &rhs);
+
+  /// Run the executor on the given loop nest. 'preservedAll' is reset if one
+  /// of the passes didn't preserve all of the analyses.
+  LogicalResult run(Function *nest, LoopNestAnalysisManager &nam,
+                    bool &preservedAll);
+
+  /// Add a pass to the current executor. This takes ownership over the provided
+  /// pass pointer.
+  void addPass(LoopNestPassBase *pass) { passes.emplace_back(pass); }
+
+  /// Returns the number of passes held by this executor.
+  size_t size() const { return passes.size(); }
+
+  /// Returns the passes held by this executor.
+  MutableArrayRef<std::unique_ptr<LoopNestPassBase>> getPasses() {
+    return passes;
+  }
+
+  /// Merge the statistics of the passes of this executor into those of
+  /// 'other', which must be a clone of this executor.
+  void mergeStatisticsInto(LoopNestPassExecutor &other);
+
+  static bool classof(const PassExecutor *pe) {
+    return pe->getKind() == Kind::LoopNestExecutor;
+  }
+
+private:
+  std::vector<std::unique_ptr<LoopNestPassBase>> passes;
 };
 
 /// A pass executor that contains a list of passes over a module unit.
@@ -82,6 +156,11 @@ public:
   /// pass pointer.
   void addPass(ModulePassBase *pass) { passes.emplace_back(pass); }
 
+  /// Returns the passes held by this executor.
+  MutableArrayRef<std::unique_ptr<ModulePassBase>> getPasses() {
+    return passes;
+  }
+
   static bool classof(const PassExecutor *pe) {
     return pe->getKind() == Kind::ModuleExecutor;
   }
@@ -91,6 +170,93 @@ private:
   std::vector<std::unique_ptr<ModulePassBase>> passes;
 };
 
+//===----------------------------------------------------------------------===//
+// FunctionFixedPointAdaptor
+//===----------------------------------------------------------------------===//
+
+/// An adaptor function pass used to rerun a function pipeline on a function
+/// until the function stops changing, or for a maximum number of iterations.
+class FunctionFixedPointAdaptor
+    : public FunctionPass<FunctionFixedPointAdaptor> {
+public:
+  explicit FunctionFixedPointAdaptor(unsigned maxIterations)
+      : maxIterations(maxIterations) {}
+
+  /// Run the held function pipeline over the current function until it
+  /// converges.
+  void runOnFunction() override;
+
+  /// Rerunning the pipeline is a no-op once it converged.
+  bool isIdempotent() const override { return converged; }
+
+  /// Returns the name to display for this pass.
+  StringRef getName() override { return "Fixed Point Pipeline"; }
+
+  /// Returns the function pass executor for this adaptor.
+  FunctionPassExecutor &getFunctionExecutor() { return fpe; }
+
+private:
+  FunctionPassExecutor fpe;
+
+  /// The maximum number of iterations of the pipeline on a function.
+  unsigned maxIterations;
+
+  /// Whether the pipeline converged on the last function it ran on.
+  bool converged = false;
+
+  /// Statistics of this pass.
+  Statistic numIterations = {this, "num-iterations",
+                             "Number of iterations of the pipeline"};
+  Statistic numNotConverged = {
+      this, "num-not-converged",
+      "Number of functions that didn't converge within the iteration limit"};
+};
+
+//===----------------------------------------------------------------------===//
+// FunctionToLoopNestPassAdaptor
+//===----------------------------------------------------------------------===//
+
+/// An adaptor function pass used to run loop nest passes over each of the
+/// top-level operations with regions and without results of a function,
+/// asynchronously across multiple threads if enabled. The loop nest passes
+/// aren't instrumented, the adaptor is timed and printed as a single function
+/// pass instead.
+class FunctionToLoopNestPassAdaptor
+    : public FunctionPass<FunctionToLoopNestPassAdaptor> {
+public:
+  explicit FunctionToLoopNestPassAdaptor(bool runInParallel)
+      : runInParallel(runInParallel) {}
+
+  /// Run the held loop nest pipeline over each loop nest of the current
+  /// function.
+  void runOnFunction() override;
+
+  /// Returns the name to display for this pass.
+  StringRef getName() override { return "Loop Nest Pipeline"; }
+
+  /// Returns the loop nest pass executor for this adaptor.
+  LoopNestPassExecutor &getLoopNestExecutor() { return lpe; }
+
+  /// Set whether the loop nests are transformed across multiple threads. This
+  /// is disabled while the adaptor itself runs concurrently with others.
+  void setRunInParallel(bool parallel) { runInParallel = parallel; }
+
+private:
+  // The main loop nest pass executor for this adaptor.
+  LoopNestPassExecutor lpe;
+
+  // A set of executors, cloned from the main executor, that run asynchronously
+  // on different threads.
+  std::vector<LoopNestPassExecutor> asyncExecutors;
+
+  /// Whether the loop nests are transformed across multiple threads.
+  bool runInParallel;
+
+  /// Statistics of this pass.
+  Statistic numLoopNests = {this, "num-loop-nests",
+                            "Number of loop nests transformed"};
+};
+
 //===----------------------------------------------------------------------===//
 // ModuleToFunctionPassAdaptor
 //===----------------------------------------------------------------------===//
@@ -143,9 +309,14 @@ inline bool isModuleToFunctionAdaptorPass(Pass *pass) {
 /// passes are those that internally execute a pipeline, such as the
 /// ModuleToFunctionPassAdaptor.
 inline bool isAdaptorPass(Pass *pass) {
-  return isModuleToFunctionAdaptorPass(pass);
+  return isModuleToFunctionAdaptorPass(pass) ||
+         isa<FunctionFixedPointAdaptor>(pass);
 }
 
+/// Returns the passes nested in the given pass, i.e. the passes of the pipeline
+/// executed by an adaptor pass or by a loop nest adaptor.
+SmallVector<Pass *, 8> getNestedPasses(Pass *pass);
+
 } // end namespace detail
 } // end namespace mlir
 #endif // MLIR_PASS_PASSDETAIL_H_
@@ -46,10 +46,42 @@ struct PassManagerOptions {
   // Pass Timing
   //===--------------------------------------------------------------------===//
   llvm::cl::opt<bool> passTiming;
-  llvm::cl::opt<PassTimingDisplayMode> passTimingDisplayMode;
+  llvm::cl::opt<PassDisplayMode> passTimingDisplayMode;
+  llvm::cl::opt<unsigned> passTimingTopFunctionRuns;
 
   /// Add a pass timing instrumentation if enabled by 'pass-timing' flags.
   void addTimingInstrumentation(PassManager &pm);
+
+  //===--------------------------------------------------------------------===//
+  // Pass Statistics
+  //===--------------------------------------------------------------------===//
+  llvm::cl::opt<bool> passStatistics;
+  llvm::cl::opt<PassDisplayMode> passStatisticsDisplayMode;
+
+  //===--------------------------------------------------------------------===//
+  // IR Size
+  //===--------------------------------------------------------------------===//
+  llvm::cl::opt<bool> passIRSize;
+
+  //===--------------------------------------------------------------------===//
+  // Pass Skipping
+  //===--------------------------------------------------------------------===//
+  llvm::cl::opt<bool> passSkipUnchanged;
+
+  //===--------------------------------------------------------------------===//
+  // Analysis Caching
+  //===--------------------------------------------------------------------===//
+  llvm::cl::opt<bool> passAnalysisCache;
+
+  //===--------------------------------------------------------------------===//
+  // Pass Budget
+  //===--------------------------------------------------------------------===//
+  llvm::cl::opt<uint64_t> passBudgetWorkUnits;
+  llvm::cl::opt<uint64_t> passBudgetMs;
+  llvm::cl::opt<bool> passBudgetReport;
+
+  /// Set the budget of the passes if limited by any 'pass-budget' flags.
+  void addBudget(PassManager &pm);
 };
 } // end anonymous namespace
 
@@ -84,12 +116,77 @@ PassManagerOptions::PassManagerOptions()
       passTimingDisplayMode(
           "pass-timing-display",
           llvm::cl::desc("Display method for pass timing data"),
-          llvm::cl::init(PassTimingDisplayMode::Pipeline),
+          llvm::cl::init(PassDisplayMode::Pipeline),
           llvm::cl::values(
-              clEnumValN(PassTimingDisplayMode::List, "list",
+              clEnumValN(PassDisplayMode::List, "list",
                          "display the results in a list sorted by total time"),
-              clEnumValN(PassTimingDisplayMode::Pipeline, "pipeline",
-                         "display the results with a nested pipeline view"))) {}
+              clEnumValN(PassDisplayMode::Pipeline, "pipeline",
+                         "display the results with a nested pipeline view"),
+              clEnumValN(PassDisplayMode::Trace, "trace",
+                         "write the results as Chrome trace events"))),
+      passTimingTopFunctionRuns(
+          "pass-timing-top-functions",
+          llvm::cl::desc("Also display the N longest runs of a function pass "
+                         "on a single function"),
+          llvm::cl::value_desc("N"), llvm::cl::init(0)),
+
+      //===----------------------------------------------------------------===//
+      // Pass Statistics
+      //===----------------------------------------------------------------===//
+      passStatistics("pass-statistics",
+                     llvm::cl::desc("Display the statistics of each pass")),
+      passStatisticsDisplayMode(
+          "pass-statistics-display",
+          llvm::cl::desc("Display method for pass statistics"),
+          llvm::cl::init(PassDisplayMode::Pipeline),
+          llvm::cl::values(
+              clEnumValN(
+                  PassDisplayMode::List, "list",
+                  "display the results in a merged list sorted by pass name"),
+              clEnumValN(PassDisplayMode::Pipeline, "pipeline",
+                         "display the results with a nested pipeline view"))),
+
+      //===----------------------------------------------------------------===//
+      // IR Size
+      //===----------------------------------------------------------------===//
+      passIRSize("pass-ir-size",
+                 llvm::cl::desc("Display the size of the IR and of the "
+                                "context storage before and after each pass")),
+
+      //===----------------------------------------------------------------===//
+      // Pass Skipping
+      //===----------------------------------------------------------------===//
+      passSkipUnchanged(
+          "pass-skip-unchanged",
+          llvm::cl::desc("Skip the runs of idempotent function passes on the "
+                         "functions that didn't change since they last ran")),
+
+      //===----------------------------------------------------------------===//
+      // Analysis Caching
+      //===----------------------------------------------------------------===//
+      passAnalysisCache(
+          "pass-analysis-cache",
+          llvm::cl::desc("Keep the valid function analyses across the runs of "
+                         "the pass manager, for the functions that didn't "
+                         "change in between")),
+
+      //===----------------------------------------------------------------===//
+      // Pass Budget
+      //===----------------------------------------------------------------===//
+      passBudgetWorkUnits(
+          "pass-budget-work-units",
+          llvm::cl::desc("Maximum number of work units of each run of a pass "
+                         "on a function or module, no limit if 0"),
+          llvm::cl::value_desc("N"), llvm::cl::init(0)),
+      passBudgetMs(
+          "pass-budget-ms",
+          llvm::cl::desc("Maximum time, in milliseconds, of each run of a pass "
+                         "on a function or module, no limit if 0"),
+          llvm::cl::value_desc("N"), llvm::cl::init(0)),
+      passBudgetReport(
+          "pass-budget-report",
+          llvm::cl::desc("Display the runs of the passes that exhausted their "
+                         "budget")) {}
 
 /// Add an IR printing instrumentation if enabled by any 'print-ir' flags.
 void PassManagerOptions::addPrinterInstrumentation(PassManager &pm) {
@@ -133,7 +230,18 @@ void PassManagerOptions::addPrinterInstrumentation(PassManager &pm) {
 /// Add a pass timing instrumentation if enabled by 'pass-timing' flags.
 void PassManagerOptions::addTimingInstrumentation(PassManager &pm) {
   if (passTiming)
-    pm.enableTiming(passTimingDisplayMode);
+    pm.enableTiming(passTimingDisplayMode, passTimingTopFunctionRuns);
+}
+
+/// Set the budget of the passes if limited by any 'pass-budget' flags.
+void PassManagerOptions::addBudget(PassManager &pm) {
+  PassBudget budget;
+  budget.workUnits = passBudgetWorkUnits;
+  budget.milliseconds = passBudgetMs;
+  if (!budget.isUnlimited())
+    pm.setPassBudget(budget);
+  if (passBudgetReport)
+    pm.enableBudgetReport();
 }
 
 void mlir::registerPassManagerCLOptions() {
@@ -143,9 +251,28 @@ void mlir::registerPassManagerCLOptions() {
 }
 
 void mlir::applyPassManagerCLOptions(PassManager &pm) {
+  // Enable statistics dumping.
+  if ((*options)->passStatistics)
+    pm.enableStatistics((*options)->passStatisticsDisplayMode);
+
   // Add the IR printing instrumentation.
   (*options)->addPrinterInstrumentation(pm);
 
+  // Add the IR size instrumentation.
+  if ((*options)->passIRSize)
+    pm.enableIRSizeReport();
+
+  // Skip the runs of idempotent passes on unchanged functions.
+  if ((*options)->passSkipUnchanged)
+    pm.enableSkippingUnchangedFunctions();
+
+  // Reuse the analyses of the unchanged functions across runs.
+  if ((*options)->passAnalysisCache)
+    pm.enableAnalysisCache();
+
+  // Set the budget of the passes, and add the budget report instrumentation.
+  (*options)->addBudget(pm);
+
   // Note: The pass timing instrumentation should be added last to avoid any
   // potential "ghost" timing from other instrumentations being unintentionally
   // included in the timing results.
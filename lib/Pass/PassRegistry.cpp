@@ -83,6 +83,16 @@ const PassInfo *mlir::Pass::lookupPassInfo(const PassID *passID) {
   return &it->getSecond();
 }
 
+const PassRegistryEntry *mlir::lookupPassRegistryEntry(StringRef arg) {
+  for (const auto &kv : *passRegistry)
+    if (kv.second.getPassArgument() == arg)
+      return &kv.second;
+  auto it = passPipelineRegistry->find(arg);
+  if (it == passPipelineRegistry->end())
+    return nullptr;
+  return &it->second;
+}
+
 //===----------------------------------------------------------------------===//
 // PassNameParser
 //===----------------------------------------------------------------------===//
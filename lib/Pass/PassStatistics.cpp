@@ -0,0 +1,177 @@
+//===- PassStatistics.cpp -------------------------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "PassDetail.h"
+#include "mlir/Pass/PassManager.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+
+using namespace mlir;
+using namespace mlir::detail;
+
+constexpr llvm::StringLiteral kPassStatsDescription =
+    "... Pass statistics report ...";
+
+namespace {
+/// Information pertaining to a specific statistic.
+struct Statistic {
+  const char *name, *desc;
+  unsigned value;
+};
+} // end anonymous namespace
+
+/// Utility to print a pass entry in the statistics output.
+static void printPassEntry(raw_ostream &os, unsigned indent, StringRef pass,
+                           MutableArrayRef<Statistic> stats = llvm::None) {
+  os.indent(indent) << pass << "\n";
+  if (stats.empty())
+    return;
+
+  // Make sure to sort the statistics by name.
+  llvm::array_pod_sort(stats.begin(), stats.end(),
+                       [](const Statistic *lhs, const Statistic *rhs) {
+                         return StringRef(lhs->name).compare(rhs->name);
+                       });
+
+  // Collect the largest name and value length from each of the statistics.
+  size_t largestName = 0, largestValue = 0;
+  for (auto &stat : stats) {
+    largestName = std::max(largestName, (size_t)strlen(stat.name));
+    largestValue =
+        std::max(largestValue, (size_t)llvm::utostr(stat.value).size());
+  }
+
+  // Print each of the statistics.
+  for (auto &stat : stats) {
+    os.indent(indent + 2) << llvm::format("(S) %*u %-*s - %s\n", largestValue,
+                                          stat.value, largestName, stat.name,
+                                          stat.desc);
+  }
+}
+
+/// Collect the current values of the statistics of the given pass.
+static std::vector<Statistic> collectStatistics(Pass *pass) {
+  std::vector<Statistic> stats;
+  for (auto *stat : pass->getStatistics())
+    stats.push_back({stat->getName(), stat->getDescription(), *stat});
+  return stats;
+}
+
+/// Print the statistics results in a list form, where each pass is sorted by
+/// name and the statistics of multiple instances of a pass are merged.
+static void printResultsAsList(raw_ostream &os, ModulePassExecutor &mpe) {
+  llvm::StringMap<std::vector<Statistic>> mergedStats;
+  std::function<void(Pass *)> addStats = [&](Pass *pass) {
+    for (auto *nestedPass : getNestedPasses(pass))
+      addStats(nestedPass);
+
+    // The module to function adaptors have no statistics of their own.
+    if (isModuleToFunctionAdaptorPass(pass))
+      return;
+
+    // Passes without statistics aren't interesting for the list view.
+    auto stats = collectStatistics(pass);
+    if (stats.empty())
+      return;
+
+    // If this is the first instance of the pass, take its statistics as is.
+    // Otherwise, merge them with the existing entry: different instances of
+    // the same pass declare the same statistics in the same order.
+    auto &passEntry = mergedStats[pass->getName()];
+    if (passEntry.empty()) {
+      passEntry = std::move(stats);
+      return;
+    }
+    for (unsigned i = 0, e = stats.size(); i != e; ++i)
+      passEntry[i].value += stats[i].value;
+  };
+  for (auto &pass : mpe.getPasses())
+    addStats(pass.get());
+
+  // Sort the passes by name and print them.
+  std::vector<llvm::StringMapEntry<std::vector<Statistic>> *> passes;
+  for (auto &passEntry : mergedStats)
+    passes.push_back(&passEntry);
+  llvm::array_pod_sort(passes.begin(), passes.end(),
+                       [](decltype(passes)::value_type const *lhs,
+                          decltype(passes)::value_type const *rhs) {
+                         return (*lhs)->getKey().compare((*rhs)->getKey());
+                       });
+  for (auto *passEntry : passes)
+    printPassEntry(os, /*indent=*/2, passEntry->getKey(), passEntry->second);
+}
+
+/// Print the statistics results in a pipeline form, mirroring the structure
+/// of the pass manager.
+static void printResultsAsPipeline(raw_ostream &os, ModulePassExecutor &mpe) {
+  std::function<void(unsigned, Pass *)> printPass = [&](unsigned indent,
+                                                        Pass *pass) {
+    if (isModuleToFunctionAdaptorPass(pass)) {
+      printPassEntry(os, indent, "Function Pipeline");
+      for (auto *nestedPass : getNestedPasses(pass))
+        printPass(indent + 2, nestedPass);
+      return;
+    }
+
+    auto stats = collectStatistics(pass);
+    printPassEntry(os, indent, pass->getName(), stats);
+
+    // Print the passes nested in a fixed point or loop nest pipeline.
+    for (auto *nestedPass : getNestedPasses(pass))
+      printPass(indent + 2, nestedPass);
+  };
+  for (auto &pass : mpe.getPasses())
+    printPass(/*indent=*/2, pass.get());
+}
+
+//===----------------------------------------------------------------------===//
+// PassManager
+//===----------------------------------------------------------------------===//
+
+/// Dump the statistics of the passes within this pass manager.
+void PassManager::printStatistics() {
+  assert(passStatisticsMode && "expected pass statistics to be enabled");
+  auto os = llvm::CreateInfoOutputFile();
+
+  // Print the stats header.
+  *os << "===" << std::string(73, '-') << "===\n";
+  // Figure out how many spaces for the description name.
+  unsigned padding = (80 - kPassStatsDescription.size()) / 2;
+  os->indent(padding) << kPassStatsDescription << '\n';
+  *os << "===" << std::string(73, '-') << "===\n";
+
+  // Defer to a specialized printer for each display mode.
+  switch (*passStatisticsMode) {
+  case PassDisplayMode::List:
+    printResultsAsList(*os, *mpe);
+    break;
+  case PassDisplayMode::Pipeline:
+  case PassDisplayMode::Trace:
+    printResultsAsPipeline(*os, *mpe);
+    break;
+  }
+  *os << "\n";
+  os->flush();
+}
+
+/// Prompts the pass manager to print the statistics collected for each of the
+/// held passes after each call to 'run'.
+void PassManager::enableStatistics(PassDisplayMode displayMode) {
+  passStatisticsMode = displayMode;
+}
@@ -16,13 +16,17 @@
 // =============================================================================
 
 #include "PassDetail.h"
+#include "mlir/IR/Function.h"
 #include "mlir/Pass/PassManager.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/Threading.h"
+#include <algorithm>
 #include <chrono>
 
 using namespace mlir;
@@ -149,20 +153,55 @@ struct Timer {
   std::string name;
 };
 
+/// A pass or analysis run recorded in trace mode.
+struct TraceEvent {
+  /// The name of the pass or analysis, and the name of the function it ran on
+  /// if any.
+  std::string name, function;
+  bool isAnalysis;
+
+  /// The thread the event ran on, and its start time and duration.
+  uint64_t tid;
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+  std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+};
+
+/// The run of a function pass on a single function.
+struct FunctionRun {
+  /// The name of the pass and of the function it ran on.
+  StringRef passName;
+  std::string functionName;
+
+  /// The number of operations in the function before the pass ran.
+  size_t numOps = 0;
+
+  /// The time the run started, and its duration.
+  std::chrono::time_point<std::chrono::steady_clock> startTime;
+  std::chrono::nanoseconds duration = std::chrono::nanoseconds(0);
+};
+
 struct PassTiming : public PassInstrumentation {
-  PassTiming(PassTimingDisplayMode displayMode) : displayMode(displayMode) {}
+  PassTiming(PassDisplayMode displayMode, unsigned numTopFunctionRuns)
+      : displayMode(displayMode), numTopFunctionRuns(numTopFunctionRuns),
+        traceStartTime(std::chrono::steady_clock::now()) {}
   ~PassTiming() { print(); }
 
   /// Setup the instrumentation hooks.
-  void runBeforePass(Pass *pass, const llvm::Any &) override {
+  void runBeforePass(Pass *pass, const llvm::Any &ir) override {
+    if (numTopFunctionRuns != 0 && llvm::any_isa<Function *>(ir))
+      startFunctionRun(pass, llvm::any_cast<Function *>(ir));
+    if (displayMode == PassDisplayMode::Trace)
+      return startTraceEvent(getPassName(pass), ir, /*isAnalysis=*/false);
     startPassTimer(pass);
   }
-  void runAfterPass(Pass *pass, const llvm::Any &) override;
+  void runAfterPass(Pass *pass, const llvm::Any &ir) override;
   void runAfterPassFailed(Pass *pass, const llvm::Any &ir) override {
     runAfterPass(pass, ir);
   }
   void runBeforeAnalysis(llvm::StringRef name, AnalysisID *id,
-                         const llvm::Any &) override {
+                         const llvm::Any &ir) override {
+    if (displayMode == PassDisplayMode::Trace)
+      return startTraceEvent(name, ir, /*isAnalysis=*/true);
     startAnalysisTimer(name, id);
   }
   void runAfterAnalysis(llvm::StringRef, AnalysisID *,
@@ -171,6 +210,31 @@ struct PassTiming : public PassInstrumentation {
   /// Print and clear the timing results.
   void print();
 
+  /// Returns the name to display for the given pass.
+  static StringRef getPassName(Pass *pass) {
+    if (isModuleToFunctionAdaptorPass(pass))
+      return "Function Pipeline";
+    return pass->getName();
+  }
+
+  /// Start a new trace event for a pass or analysis run on 'ir'.
+  void startTraceEvent(StringRef name, const llvm::Any &ir, bool isAnalysis);
+
+  /// Stop the last trace event started on the current thread.
+  void stopTraceEvent();
+
+  /// Print the recorded trace events as Chrome trace event JSON.
+  void printResultsAsTrace(raw_ostream &os);
+
+  /// Start recording the run of 'pass' on 'function'.
+  void startFunctionRun(Pass *pass, Function *function);
+
+  /// Stop recording the last function run started on the current thread.
+  void stopFunctionRun();
+
+  /// Print the 'numTopFunctionRuns' longest function runs.
+  void printTopFunctionRuns(raw_ostream &os);
+
   /// Start a new timer for the given pass.
   void startPassTimer(Pass *pass);
 
@@ -218,17 +282,34 @@ struct PassTiming : public PassInstrumentation {
   DenseMap<uint64_t, SmallVector<Timer *, 4>> activeThreadTimers;
 
   /// The display mode to use when printing the timing results.
-  PassTimingDisplayMode displayMode;
+  PassDisplayMode displayMode;
+
+  /// In trace mode, the events still running on each thread, innermost last,
+  /// and the events that completed.  Unlike timers, the events of all the
+  /// threads are updated concurrently, so they are guarded by a mutex.
+  DenseMap<uint64_t, SmallVector<TraceEvent, 4>> activeTraceEvents;
+  std::vector<TraceEvent> traceEvents;
+  llvm::sys::SmartMutex<true> traceMutex;
+
+  /// The number of longest runs of a function pass on a single function to
+  /// report, or 0 if the runs are not recorded.
+  unsigned numTopFunctionRuns;
+
+  /// The function runs still running on each thread, innermost last, and the
+  /// runs that completed.  These are updated concurrently by the threads of
+  /// the pass manager, so they are guarded by a mutex.
+  DenseMap<uint64_t, SmallVector<FunctionRun, 4>> activeFunctionRuns;
+  std::vector<FunctionRun> functionRuns;
+  llvm::sys::SmartMutex<true> functionRunMutex;
+
+  /// The time the trace event timestamps are relative to.
+  std::chrono::time_point<std::chrono::steady_clock> traceStartTime;
 };
 } // end anonymous namespace
 
 /// Start a new timer for the given pass.
 void PassTiming::startPassTimer(Pass *pass) {
-  Timer *timer = getTimer(pass, [pass] {
-    if (isModuleToFunctionAdaptorPass(pass))
-      return StringRef("Function Pipeline");
-    return pass->getName();
-  });
+  Timer *timer = getTimer(pass, [pass] { return getPassName(pass); });
 
   // We don't actually want to time the adaptor passes, they gather their total
   // from their held passes.
@@ -242,8 +323,62 @@ void PassTiming::startAnalysisTimer(llvm::StringRef name, AnalysisID *id) {
   timer->start();
 }
 
+/// Start a new trace event for a pass or analysis run on 'ir'.
+void PassTiming::startTraceEvent(StringRef name, const llvm::Any &ir,
+                                 bool isAnalysis) {
+  TraceEvent event;
+  event.name = name;
+  if (llvm::any_isa<Function *>(ir))
+    event.function = llvm::any_cast<Function *>(ir)->getName().strref();
+  event.isAnalysis = isAnalysis;
+  event.tid = llvm::get_threadid();
+
+  llvm::sys::SmartScopedLock<true> lock(traceMutex);
+  event.startTime = std::chrono::steady_clock::now();
+  activeTraceEvents[event.tid].push_back(std::move(event));
+}
+
+/// Stop the last trace event started on the current thread.
+void PassTiming::stopTraceEvent() {
+  auto endTime = std::chrono::steady_clock::now();
+  llvm::sys::SmartScopedLock<true> lock(traceMutex);
+  auto &activeEvents = activeTraceEvents[llvm::get_threadid()];
+  assert(!activeEvents.empty() && "expected active trace event");
+  TraceEvent event = activeEvents.pop_back_val();
+  event.duration = endTime - event.startTime;
+  traceEvents.push_back(std::move(event));
+}
+
+/// Start recording the run of 'pass' on 'function'.
+void PassTiming::startFunctionRun(Pass *pass, Function *function) {
+  FunctionRun run;
+  run.passName = getPassName(pass);
+  run.functionName = function->getName().str();
+  function->walk([&](Operation *) { ++run.numOps; });
+
+  llvm::sys::SmartScopedLock<true> lock(functionRunMutex);
+  run.startTime = std::chrono::steady_clock::now();
+  activeFunctionRuns[llvm::get_threadid()].push_back(std::move(run));
+}
+
+/// Stop recording the last function run started on the current thread.
+void PassTiming::stopFunctionRun() {
+  auto endTime = std::chrono::steady_clock::now();
+  llvm::sys::SmartScopedLock<true> lock(functionRunMutex);
+  auto &activeRuns = activeFunctionRuns[llvm::get_threadid()];
+  assert(!activeRuns.empty() && "expected active function run");
+  FunctionRun run = activeRuns.pop_back_val();
+  run.duration = endTime - run.startTime;
+  functionRuns.push_back(std::move(run));
+}
+
 /// Stop a pass timer.
-void PassTiming::runAfterPass(Pass *pass, const llvm::Any &) {
+void PassTiming::runAfterPass(Pass *pass, const llvm::Any &ir) {
+  if (numTopFunctionRuns != 0 && llvm::any_isa<Function *>(ir))
+    stopFunctionRun();
+  if (displayMode == PassDisplayMode::Trace)
+    return stopTraceEvent();
+
   auto tid = llvm::get_threadid();
   auto &activeTimers = activeThreadTimers[tid];
   assert(!activeTimers.empty() && "expected active timer");
@@ -280,6 +415,9 @@ void PassTiming::runAfterPass(Pass *pass, const llvm::Any &) {
 /// Stop a timer.
 void PassTiming::runAfterAnalysis(llvm::StringRef, AnalysisID *,
                                   const llvm::Any &) {
+  if (displayMode == PassDisplayMode::Trace)
+    return stopTraceEvent();
+
   auto &activeTimers = activeThreadTimers[llvm::get_threadid()];
   assert(!activeTimers.empty() && "expected active timer");
   Timer *timer = activeTimers.pop_back_val();
@@ -310,6 +448,28 @@ static void printTimeEntry(raw_ostream &os, unsigned indent, StringRef name,
 
 /// Print out the current timing information.
 void PassTiming::print() {
+  // The longest function runs are printed first, so that they don't end up
+  // within the trace events JSON.
+  if (!functionRuns.empty()) {
+    auto os = llvm::CreateInfoOutputFile();
+    printTopFunctionRuns(*os);
+    os->flush();
+    functionRuns.clear();
+    activeFunctionRuns.clear();
+  }
+
+  // The trace events are printed on their own, without any header.
+  if (displayMode == PassDisplayMode::Trace) {
+    if (traceEvents.empty())
+      return;
+    auto os = llvm::CreateInfoOutputFile();
+    printResultsAsTrace(*os);
+    os->flush();
+    traceEvents.clear();
+    activeTraceEvents.clear();
+    return;
+  }
+
   // Don't print anything if there is no timing data.
   if (rootTimers.empty())
     return;
@@ -324,12 +484,14 @@ void PassTiming::print() {
 
   // Defer to a specialized printer for each display mode.
   switch (displayMode) {
-  case PassTimingDisplayMode::List:
+  case PassDisplayMode::List:
     printResultsAsList(*os, rootTimer.get(), totalTime);
     break;
-  case PassTimingDisplayMode::Pipeline:
+  case PassDisplayMode::Pipeline:
     printResultsAsPipeline(*os, rootTimer.get(), totalTime);
     break;
+  case PassDisplayMode::Trace:
+    llvm_unreachable("trace events are printed separately");
   }
   printTimeEntry(*os, 0, "Total", totalTime, totalTime);
   os->flush();
@@ -387,16 +549,72 @@ void PassTiming::printResultsAsPipeline(raw_ostream &os, Timer *root,
     printTimer(0, topLevelTimer.second.get());
 }
 
+/// Print the 'numTopFunctionRuns' longest runs of a function pass on a single
+/// function, longest first.
+void PassTiming::printTopFunctionRuns(raw_ostream &os) {
+  unsigned numRuns = std::min<size_t>(numTopFunctionRuns, functionRuns.size());
+  std::partial_sort(functionRuns.begin(), functionRuns.begin() + numRuns,
+                    functionRuns.end(),
+                    [](const FunctionRun &lhs, const FunctionRun &rhs) {
+                      return lhs.duration > rhs.duration;
+                    });
+
+  constexpr llvm::StringLiteral description =
+      "... Longest function pass runs ...";
+  os << "===" << std::string(73, '-') << "===\n";
+  os.indent((80 - description.size()) / 2) << description << '\n';
+  os << "===" << std::string(73, '-') << "===\n";
+  os << "   ---Wall Time---  ---Ops---  --- Pass : Function ---\n";
+  for (auto &run : llvm::make_range(functionRuns.begin(),
+                                    functionRuns.begin() + numRuns)) {
+    double wall =
+        std::chrono::duration_cast<std::chrono::duration<double>>(run.duration)
+            .count();
+    os << llvm::format("  %16.4f  %9zu  ", wall, run.numOps) << run.passName
+       << " : @" << run.functionName << "\n";
+  }
+}
+
+/// Print the trace events as a Chrome trace event JSON object, with one
+/// complete event per pass or analysis run.  The times are in microseconds,
+/// as expected by the trace viewers.
+void PassTiming::printResultsAsTrace(raw_ostream &os) {
+  using Microseconds = std::chrono::duration<double, std::micro>;
+  auto toMicroseconds = [](std::chrono::nanoseconds time) {
+    return std::chrono::duration_cast<Microseconds>(time).count();
+  };
+
+  llvm::json::Array events;
+  for (auto &event : traceEvents) {
+    llvm::json::Object args;
+    if (!event.function.empty())
+      args["function"] = event.function;
+    events.push_back(llvm::json::Object{
+        {"name", event.name},
+        {"cat", event.isAnalysis ? "analysis" : "pass"},
+        {"ph", "X"},
+        {"pid", 0},
+        {"tid", static_cast<int64_t>(event.tid)},
+        {"ts", toMicroseconds(event.startTime - traceStartTime)},
+        {"dur", toMicroseconds(event.duration)},
+        {"args", std::move(args)}});
+  }
+  os << llvm::json::Value(llvm::json::Object{
+            {"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}})
+     << "\n";
+}
+
 //===----------------------------------------------------------------------===//
 // PassManager
 //===----------------------------------------------------------------------===//
 
 /// Add an instrumentation to time the execution of passes and the computation
 /// of analyses.
-void PassManager::enableTiming(PassTimingDisplayMode displayMode) {
+void PassManager::enableTiming(PassDisplayMode displayMode,
+                               unsigned numTopFunctionRuns) {
   // Check if pass timing is already enabled.
   if (passTiming)
     return;
-  addInstrumentation(new PassTiming(displayMode));
+  addInstrumentation(new PassTiming(displayMode, numTopFunctionRuns));
   passTiming = true;
 }
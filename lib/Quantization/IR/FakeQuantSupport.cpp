@@ -4,17 +4,13 @@
 using namespace mlir;
 using namespace mlir::quant;
 
-UniformQuantizedType mlir::quant::fakeQuantAttrsToType(Location loc,
-                                                       unsigned numBits,
-                                                       double rmin, double rmax,
-                                                       bool narrowRange,
-                                                       Type expressedType) {
-  MLIRContext *ctx = expressedType.getContext();
-  Type storageType;
-  unsigned flags;
-  int64_t qmin;
-  int64_t qmax;
-
+/// Gets the storage type, flags and storage range implied by the given
+/// FakeQuant num_bits and narrow_range attributes. Issues an error and returns
+/// failure if they aren't supported.
+static LogicalResult getStorageParams(Location loc, unsigned numBits,
+                                      bool narrowRange, MLIRContext *ctx,
+                                      Type &storageType, unsigned &flags,
+                                      int64_t &qmin, int64_t &qmax) {
   // Hard-coded type mapping from TFLite.
   if (numBits <= 8) {
     storageType = IntegerType::get(8, ctx);
@@ -29,32 +25,43 @@ UniformQuantizedType mlir::quant::fakeQuantAttrsToType(Location loc,
   } else {
     ctx->emitError(loc,
                    "unsupported FakeQuant number of bits: " + Twine(numBits));
-    return nullptr;
+    return failure();
   }
 
   // Handle narrowRange.
   if (narrowRange) {
     qmin += 1;
   }
+  return success();
+}
 
+/// Computes the scale and the nudged zero point mapping the real range
+/// [rmin, rmax] to the storage range [qmin, qmax]. Issues an error and returns
+/// failure if the real range doesn't straddle zero.
+static LogicalResult getNudgedScaleAndZeroPoint(Location loc, MLIRContext *ctx,
+                                                int64_t qmin, int64_t qmax,
+                                                double rmin, double rmax,
+                                                double &scale,
+                                                int64_t &nudgedZeroPoint) {
   // Range must straddle zero.
   if (rmin > 0.0 || rmax < 0.0) {
-    return (ctx->emitError(loc, "FakeQuant range must straddle zero: [" +
-                                    Twine(std::to_string(rmin)) + "," +
-                                    Twine(std::to_string(rmax)) + "]"),
-            nullptr);
+    ctx->emitError(loc, "FakeQuant range must straddle zero: [" +
+                            Twine(std::to_string(rmin)) + "," +
+                            Twine(std::to_string(rmax)) + "]");
+    return failure();
   }
 
   // Special case where min/max is a point. Must be 0.
   if (rmin == rmax) {
-    return UniformQuantizedType::getChecked(flags, storageType, expressedType,
-                                            0.0, 0, qmin, qmax, loc);
+    scale = 0.0;
+    nudgedZeroPoint = 0;
+    return success();
   }
 
   // Determine the scale.
   const double qminDouble = qmin;
   const double qmaxDouble = qmax;
-  const double scale = (rmax - rmin) / (qmaxDouble - qminDouble);
+  scale = (rmax - rmin) / (qmaxDouble - qminDouble);
 
   // Zero point computation.
   // In float, solve the affine equation for any known pair
@@ -75,7 +82,7 @@ UniformQuantizedType mlir::quant::fakeQuantAttrsToType(Location loc,
                                      : zeroPointFromMax;
 
   // Now nudge the zero point to be an integer.
-  int64_t nudgedZeroPoint = 0;
+  nudgedZeroPoint = 0;
   if (zeroPointDouble < qminDouble) {
     nudgedZeroPoint = qmin;
   } else if (zeroPointDouble > qmaxDouble) {
@@ -87,8 +94,69 @@ UniformQuantizedType mlir::quant::fakeQuantAttrsToType(Location loc,
   // By construction, the nudged zero point should always be in range.
   assert(nudgedZeroPoint >= qmin);
   assert(nudgedZeroPoint <= qmax);
+  return success();
+}
+
+UniformQuantizedType mlir::quant::fakeQuantAttrsToType(Location loc,
+                                                       unsigned numBits,
+                                                       double rmin, double rmax,
+                                                       bool narrowRange,
+                                                       Type expressedType) {
+  MLIRContext *ctx = expressedType.getContext();
+  Type storageType;
+  unsigned flags;
+  int64_t qmin;
+  int64_t qmax;
+  if (failed(getStorageParams(loc, numBits, narrowRange, ctx, storageType,
+                              flags, qmin, qmax))) {
+    return nullptr;
+  }
+
+  double scale;
+  int64_t nudgedZeroPoint;
+  if (failed(getNudgedScaleAndZeroPoint(loc, ctx, qmin, qmax, rmin, rmax, scale,
+                                        nudgedZeroPoint))) {
+    return nullptr;
+  }
 
   return UniformQuantizedType::getChecked(flags, storageType, expressedType,
                                           scale, nudgedZeroPoint, qmin, qmax,
                                           loc);
 }
+
+UniformQuantizedPerAxisType mlir::quant::fakeQuantAttrsToType(
+    Location loc, unsigned numBits, int32_t quantizedDimension,
+    ArrayRef<double> rmins, ArrayRef<double> rmaxs, bool narrowRange,
+    Type expressedType) {
+  MLIRContext *ctx = expressedType.getContext();
+  if (rmins.empty() || rmins.size() != rmaxs.size()) {
+    ctx->emitError(loc, "mismatched FakeQuant min and max counts: " +
+                            Twine(rmins.size()) + ", " + Twine(rmaxs.size()));
+    return nullptr;
+  }
+
+  Type storageType;
+  unsigned flags;
+  int64_t qmin;
+  int64_t qmax;
+  if (failed(getStorageParams(loc, numBits, narrowRange, ctx, storageType,
+                              flags, qmin, qmax))) {
+    return nullptr;
+  }
+
+  // Each slice along the quantized dimension gets the scale and zero point a
+  // per-layer FakeQuant with its range would have.
+  SmallVector<double, 4> scales(rmins.size());
+  SmallVector<int64_t, 4> zeroPoints(rmins.size());
+  for (unsigned i = 0, e = rmins.size(); i < e; ++i) {
+    if (failed(getNudgedScaleAndZeroPoint(loc, ctx, qmin, qmax, rmins[i],
+                                          rmaxs[i], scales[i],
+                                          zeroPoints[i]))) {
+      return nullptr;
+    }
+  }
+
+  return UniformQuantizedPerAxisType::getChecked(
+      flags, storageType, expressedType, scales, zeroPoints, quantizedDimension,
+      qmin, qmax, loc);
+}
@@ -180,6 +180,11 @@ Type QuantizedType::castFromExpressedType(Type candidateType) {
     if (candidateVtType.getElementType() != getExpressedType()) {
       return nullptr;
     }
+    // A per-axis type must match the shape it quantizes.
+    auto perAxisType = dyn_cast<UniformQuantizedPerAxisType>();
+    if (perAxisType && !perAxisType.isCompatibleShape(candidateType)) {
+      return nullptr;
+    }
 
     if (candidateType.isa<RankedTensorType>()) {
       // i.e. tensor<4xf32> -> tensor<4x!quant<"uniform[i8:f32]{1.0}">>
@@ -321,6 +326,16 @@ LogicalResult UniformQuantizedPerAxisType::verifyConstructionInvariants(
     return failure();
   }
 
+  // Verify the quantized dimension. Its range can only be checked against the
+  // shape of the vectors or tensors of this type, see isCompatibleShape.
+  if (quantizedDimension < 0) {
+    if (loc) {
+      context->emitError(*loc, "illegal quantized dimension: " +
+                                   Twine(quantizedDimension));
+    }
+    return failure();
+  }
+
   // Verify scale.
   for (double scale : scales) {
     if (scale <= 0.0 || std::isinf(scale) || std::isnan(scale)) {
@@ -347,11 +362,39 @@ int32_t UniformQuantizedPerAxisType::getQuantizedDimension() const {
   return getImpl()->quantizedDimension;
 }
 
+bool UniformQuantizedPerAxisType::isCompatibleShape(Type candidateType) const {
+  auto vtType = candidateType.dyn_cast<VectorOrTensorType>();
+  if (!vtType || vtType.getRank() < 0) {
+    return true;
+  }
+  int32_t quantizedDimension = getQuantizedDimension();
+  if (quantizedDimension >= vtType.getRank()) {
+    return false;
+  }
+  // Dynamic dimensions are only known to be compatible at runtime.
+  int64_t dimSize = vtType.getDimSize(quantizedDimension);
+  return dimSize < 0 || static_cast<size_t>(dimSize) == getScales().size();
+}
+
+UniformQuantizedType
+UniformQuantizedPerAxisType::getUniformQuantizedType() const {
+  ArrayRef<double> scales = getScales();
+  ArrayRef<int64_t> zeroPoints = getZeroPoints();
+  for (unsigned i = 1, e = scales.size(); i < e; ++i) {
+    if (scales[i] != scales[0] || zeroPoints[i] != zeroPoints[0]) {
+      return nullptr;
+    }
+  }
+  return UniformQuantizedType::get(getFlags(), getStorageType(),
+                                   getExpressedType(), scales[0], zeroPoints[0],
+                                   getStorageTypeMin(), getStorageTypeMax());
+}
+
 #define GET_OP_CLASSES
 #include "mlir/Quantization/QuantOps.cpp.inc"
 
 QuantizationDialect::QuantizationDialect(MLIRContext *context)
-    : Dialect(/*name=*/"quant", context) {
+    : Dialect(getDialectNamespace(), context) {
   addTypes<UniformQuantizedType, UniformQuantizedPerAxisType>();
   addOperations<
 #define GET_OP_LIST
@@ -24,11 +24,24 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/bit.h"
+#include <algorithm>
 
 namespace mlir {
 namespace quant {
 namespace detail {
 
+/// Returns whether the doubles 'lhs' and 'rhs' have the same bit pattern. The
+/// quantization parameters are hashed by bit pattern, so they must also be
+/// compared that way for the hash to be consistent with equality.
+inline bool isBitwiseEqual(double lhs, double rhs) {
+  return llvm::bit_cast<int64_t>(lhs) == llvm::bit_cast<int64_t>(rhs);
+}
+inline bool isBitwiseEqual(ArrayRef<double> lhs, ArrayRef<double> rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                    [](double l, double r) { return isBitwiseEqual(l, r); });
+}
+
 struct QuantizedTypeStorage : public mlir::TypeStorage {
   QuantizedTypeStorage(unsigned flags, Type storageType, Type expressedType,
                        int64_t storageTypeMin, int64_t storageTypeMax)
@@ -77,7 +90,8 @@ struct UniformQuantizedTypeStorage : public QuantizedTypeStorage {
     template <typename T, typename U>
     static bool genericIsEqual(const T &lhs, const U &rhs) {
       return lhs.flags == rhs.flags && lhs.storageType == rhs.storageType &&
-             lhs.expressedType == rhs.expressedType && lhs.scale == rhs.scale &&
+             lhs.expressedType == rhs.expressedType &&
+             isBitwiseEqual(lhs.scale, rhs.scale) &&
              lhs.zeroPoint == rhs.zeroPoint &&
              lhs.storageTypeMin == rhs.storageTypeMin &&
              lhs.storageTypeMax == rhs.storageTypeMax;
@@ -151,7 +165,7 @@ struct UniformQuantizedPerAxisTypeStorage : public QuantizedTypeStorage {
     static bool genericIsEqual(const T &lhs, const U &rhs) {
       return lhs.flags == rhs.flags && lhs.storageType == rhs.storageType &&
              lhs.expressedType == rhs.expressedType &&
-             lhs.getScales() == rhs.getScales() &&
+             isBitwiseEqual(lhs.getScales(), rhs.getScales()) &&
              lhs.getZeroPoints() == rhs.getZeroPoints() &&
              lhs.quantizedDimension == rhs.quantizedDimension &&
              lhs.storageTypeMin == rhs.storageTypeMin &&
@@ -169,7 +183,7 @@ struct UniformQuantizedPerAxisTypeStorage : public QuantizedTypeStorage {
           flags, storageType, expressedType,
           llvm::hash_combine_range(scalesBits.begin(), scalesBits.end()),
           llvm::hash_combine_range(zeroPoints.begin(), zeroPoints.end()),
-          storageTypeMin, storageTypeMax);
+          quantizedDimension, storageTypeMin, storageTypeMax);
     }
   };
 
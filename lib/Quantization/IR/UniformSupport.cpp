@@ -50,7 +50,7 @@ ExpressedToUniformQuantizedConverter::forInputType(Type inputType) {
 }
 
 Type ExpressedToUniformQuantizedConverter::convert(
-    UniformQuantizedType elementalType) const {
+    QuantizedType elementalType) const {
   assert(expressedType && "convert() on unsupported conversion");
 
   switch (inputType.getKind()) {
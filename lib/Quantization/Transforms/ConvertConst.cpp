@@ -38,38 +38,35 @@ public:
 
 class QuantizedConstRewrite : public RewritePattern {
 public:
-  struct State : PatternState {
-    QuantizedType quantizedElementType;
-    Attribute value;
-  };
-
   QuantizedConstRewrite(MLIRContext *context)
       : RewritePattern(QuantizeBarrierOp::getOperationName(), 1, context) {}
 
-  PatternMatchResult match(Operation *op) const override;
-  void rewrite(Operation *op, std::unique_ptr<PatternState> baseState,
-               PatternRewriter &rewriter) const override;
+  PatternMatchResult matchAndRewrite(Operation *op,
+                                     PatternRewriter &rewriter) const override;
 };
 
 } // end anonymous namespace
 
 /// Matches a [constant] -> [qbarrier] where the qbarrier results type is
-/// quantized and the operand type is quantizable.
-PatternMatchResult QuantizedConstRewrite::match(Operation *op) const {
-  State state;
+/// quantized and the operand type is quantizable, and replaces it with a
+/// constant of the quantized storage type.
+PatternMatchResult
+QuantizedConstRewrite::matchAndRewrite(Operation *op,
+                                       PatternRewriter &rewriter) const {
+  Attribute value;
 
   // Is the operand a constant?
   auto qbarrier = op->cast<QuantizeBarrierOp>();
-  if (!matchPattern(qbarrier.arg(), m_Constant(&state.value))) {
+  if (!matchPattern(qbarrier.arg(), m_Constant(&value))) {
     return matchFailure();
   }
   // Does the qbarrier convert to a quantized type. This will not be true
   // if a quantized type has not yet been chosen or if the cast to an equivalent
   // storage type is not supported.
   Type qbarrierResultType = qbarrier.getResult()->getType();
-  state.quantizedElementType =
+  QuantizedType quantizedElementType =
       QuantizedType::getQuantizedElementType(qbarrierResultType);
-  if (!state.quantizedElementType) {
+  if (!quantizedElementType) {
     return matchFailure();
   }
   if (!QuantizedType::castToStorageType(qbarrierResultType)) {
@@ -79,31 +76,31 @@ PatternMatchResult QuantizedConstRewrite::match(Operation *op) const {
   // Is the operand type compatible with the expressed type of the quantized
   // type? This will not be true if the qbarrier is superfluous (converts
   // from and to a quantized type).
-  if (!state.quantizedElementType.isCompatibleExpressedType(
+  if (!quantizedElementType.isCompatibleExpressedType(
           qbarrier.arg()->getType())) {
     return matchFailure();
   }
 
-  // Is the constant value a type expressed in a way that we support?
-  if (!state.value.isa<FloatAttr>() && !state.value.isa<SplatElementsAttr>() &&
-      !state.value.isa<DenseElementsAttr>() &&
-      !state.value.isa<SparseElementsAttr>()) {
+  // Does a per-axis quantized type match the shape of the constant?
+  auto perAxisType =
+      quantizedElementType.dyn_cast<UniformQuantizedPerAxisType>();
+  if (perAxisType &&
+      !perAxisType.isCompatibleShape(qbarrier.arg()->getType())) {
     return matchFailure();
   }
 
-  return matchSuccess(llvm::make_unique<State>(std::move(state)));
-}
-
-void QuantizedConstRewrite::rewrite(Operation *op,
-                                    std::unique_ptr<PatternState> baseState,
-                                    PatternRewriter &rewriter) const {
-  auto state = static_cast<State *>(baseState.get());
+  // Is the constant value a type expressed in a way that we support?
+  if (!value.isa<FloatAttr>() && !value.isa<SplatElementsAttr>() &&
+      !value.isa<DenseElementsAttr>() && !value.isa<SparseElementsAttr>()) {
+    return matchFailure();
+  }
 
+  // Can the value be quantized? The IR is only modified past this point.
   Type newConstValueType;
-  Attribute newConstValue = quantizeAttr(
-      state->value, state->quantizedElementType, newConstValueType);
+  Attribute newConstValue =
+      quantizeAttr(value, quantizedElementType, newConstValueType);
   if (!newConstValue) {
-    return;
+    return matchFailure();
   }
 
   auto *origConstOp = op->getOperand(0);
@@ -116,6 +113,7 @@ void QuantizedConstRewrite::rewrite(Operation *op,
       rewriter.create<ConstantOp>(fusedLoc, newConstValueType, newConstValue);
   rewriter.replaceOpWithNewOp<StorageCastOp>(
       op, {origConstOp}, *op->result_type_begin(), newConstOp);
+  return matchSuccess();
 }
 
 void ConvertConstPass::runOnFunction() {
@@ -37,13 +37,16 @@ public:
 
 } // end anonymous namespace
 
-/// Rewrites ConstFakeQuant into a qbarrier/dbarrier pair.
-class ConstFakeQuantRewrite : public RewritePattern {
+/// Base class rewriting a FakeQuant op into a qbarrier/dbarrier pair. The
+/// ConcreteRewriteClass converts the attributes of the op to a quantized type
+/// in its convertFakeQuantAttrsToType method.
+template <typename ConcreteRewriteClass, typename FakeQuantOp>
+class FakeQuantRewrite : public RewritePattern {
 public:
   bool *hadFailure;
 
-  ConstFakeQuantRewrite(MLIRContext *context, bool *hadFailure)
-      : RewritePattern(ConstFakeQuant::getOperationName(), 1, context),
+  FakeQuantRewrite(MLIRContext *context, bool *hadFailure)
+      : RewritePattern(FakeQuantOp::getOperationName(), 1, context),
         hadFailure(hadFailure) {}
 
   PatternMatchResult matchAndRewrite(Operation *op,
@@ -58,7 +61,7 @@ public:
   }
 
   bool failableRewrite(Operation *op, PatternRewriter &rewriter) const {
-    auto fqOp = op->cast<ConstFakeQuant>();
+    auto fqOp = op->cast<FakeQuantOp>();
 
     auto converter =
         ExpressedToUniformQuantizedConverter::forInputType(fqOp.getType());
@@ -66,17 +69,16 @@ public:
       return (op->emitError("unsupported quantized type conversion"), true);
     }
 
-    UniformQuantizedType uniformElementType = fakeQuantAttrsToType(
-        fqOp.getLoc(), fqOp.num_bits().getSExtValue(),
-        fqOp.min().convertToDouble(), fqOp.max().convertToDouble(),
-        fqOp.narrow_range(), converter.expressedType);
+    QuantizedType elementType =
+        static_cast<const ConcreteRewriteClass *>(this)
+            ->convertFakeQuantAttrsToType(fqOp, converter.expressedType);
 
-    if (!uniformElementType) {
+    if (!elementType) {
       // Note that the fakeQuantAttrsToType will have emitted the error.
       return true;
     }
 
-    Type quantizedType = converter.convert(uniformElementType);
+    Type quantizedType = converter.convert(elementType);
     assert(quantizedType &&
            "Converter accepted a type that it did not convert");
 
@@ -91,6 +93,69 @@ public:
   }
 };
 
+/// Rewrites ConstFakeQuant into a qbarrier/dbarrier pair.
+class ConstFakeQuantRewrite
+    : public FakeQuantRewrite<ConstFakeQuantRewrite, ConstFakeQuant> {
+public:
+  using BaseRewrite = FakeQuantRewrite<ConstFakeQuantRewrite, ConstFakeQuant>;
+
+  ConstFakeQuantRewrite(MLIRContext *context, bool *hadFailure)
+      : BaseRewrite(context, hadFailure) {}
+
+  QuantizedType convertFakeQuantAttrsToType(ConstFakeQuant fqOp,
+                                            Type expressedType) const {
+    return fakeQuantAttrsToType(
+        fqOp.getLoc(), fqOp.num_bits().getSExtValue(),
+        fqOp.min().convertToDouble(), fqOp.max().convertToDouble(),
+        fqOp.narrow_range(), expressedType);
+  }
+};
+
+/// Rewrites ConstFakeQuantPerAxis into a qbarrier/dbarrier pair.
+class ConstFakeQuantPerAxisRewrite
+    : public FakeQuantRewrite<ConstFakeQuantPerAxisRewrite,
+                              ConstFakeQuantPerAxis> {
+public:
+  using BaseRewrite =
+      FakeQuantRewrite<ConstFakeQuantPerAxisRewrite, ConstFakeQuantPerAxis>;
+
+  ConstFakeQuantPerAxisRewrite(MLIRContext *context, bool *hadFailure)
+      : BaseRewrite(context, hadFailure) {}
+
+  QuantizedType convertFakeQuantAttrsToType(ConstFakeQuantPerAxis fqOp,
+                                            Type expressedType) const {
+    SmallVector<double, 4> mins, maxs;
+    if (failed(getRange(fqOp, fqOp.min(), mins)) ||
+        failed(getRange(fqOp, fqOp.max(), maxs))) {
+      return nullptr;
+    }
+    UniformQuantizedPerAxisType perAxisType = fakeQuantAttrsToType(
+        fqOp.getLoc(), fqOp.num_bits().getSExtValue(),
+        fqOp.axis().getSExtValue(), mins, maxs, fqOp.narrow_range(),
+        expressedType);
+    if (perAxisType && !perAxisType.isCompatibleShape(fqOp.getType())) {
+      fqOp.emitError("expected one min and max per slice along the axis");
+      return nullptr;
+    }
+    return perAxisType;
+  }
+
+private:
+  /// Reads the float elements of the min or max array attribute 'range' into
+  /// 'values'.
+  static LogicalResult getRange(ConstFakeQuantPerAxis fqOp, ArrayAttr range,
+                                SmallVectorImpl<double> &values) {
+    for (Attribute attr : range) {
+      auto floatAttr = attr.dyn_cast<FloatAttr>();
+      if (!floatAttr) {
+        return fqOp.emitError("expected the range to hold float attributes");
+      }
+      values.push_back(floatAttr.getValueAsDouble());
+    }
+    return success();
+  }
+};
+
 void ConvertSimulatedQuantPass::runOnFunction() {
   bool hadFailure = false;
   OwningRewritePatternList patterns;
@@ -98,6 +163,8 @@ void ConvertSimulatedQuantPass::runOnFunction() {
   auto *context = &getContext();
   patterns.push_back(
       llvm::make_unique<ConstFakeQuantRewrite>(context, &hadFailure));
+  patterns.push_back(
+      llvm::make_unique<ConstFakeQuantPerAxisRewrite>(context, &hadFailure));
   applyPatternsGreedily(func, std::move(patterns));
   if (hadFailure)
     signalPassFailure();
@@ -0,0 +1,165 @@
+//===- FoldBarriers.cpp - Folds redundant quantization barriers -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Quantization/Passes.h"
+#include "mlir/Quantization/QuantOps.h"
+
+#include <cmath>
+
+using namespace mlir;
+using namespace mlir::quant;
+
+namespace {
+
+class FoldBarriersPass : public FunctionPass<FoldBarriersPass> {
+public:
+  void runOnFunction() override;
+};
+
+} // end anonymous namespace
+
+/// Returns whether converting a value quantized in the element type 'from' to
+/// the element type 'to' (through their common expressed type) is lossless,
+/// i.e. whether all of the values of 'from' are represented exactly in 'to'.
+static bool isLosslessConversion(QuantizedType from, QuantizedType to) {
+  if (from == to) {
+    return true;
+  }
+  if (from.getExpressedType() != to.getExpressedType()) {
+    return false;
+  }
+  auto fromUniform = from.dyn_cast<UniformQuantizedType>();
+  auto toUniform = to.dyn_cast<UniformQuantizedType>();
+  if (!fromUniform || !toUniform) {
+    return false;
+  }
+
+  // Each step of 'from' must be a whole number of steps of 'to'.
+  double ratio = fromUniform.getScale() / toUniform.getScale();
+  double roundedRatio = std::round(ratio);
+  if (roundedRatio < 1.0 || std::abs(ratio - roundedRatio) > 1e-6 * ratio) {
+    return false;
+  }
+
+  // The storage range of 'from' must map into the one of 'to'.
+  auto step = static_cast<int64_t>(roundedRatio);
+  auto convert = [&](int64_t storageValue) {
+    return (storageValue - fromUniform.getZeroPoint()) * step +
+           toUniform.getZeroPoint();
+  };
+  return convert(fromUniform.getStorageTypeMin()) >=
+             toUniform.getStorageTypeMin() &&
+         convert(fromUniform.getStorageTypeMax()) <=
+             toUniform.getStorageTypeMax();
+}
+
+/// Returns the operand of the dbarrier defining 'value', if any, and if that
+/// operand is quantized.
+static Value *getDequantizedValue(Value *value) {
+  auto *defOp = value->getDefiningOp();
+  if (!defOp || !defOp->isa<DequantizeBarrierOp>()) {
+    return nullptr;
+  }
+  Value *quantizedValue = defOp->cast<DequantizeBarrierOp>().arg();
+  if (!QuantizedType::getQuantizedElementType(quantizedValue->getType())) {
+    return nullptr;
+  }
+  return quantizedValue;
+}
+
+namespace {
+
+/// Folds a qbarrier of a dbarrier of a quantized value, i.e. a requantization:
+///   - into the quantized value itself, if the qbarrier quantizes it to the
+///     same type again.
+///   - into the dequantized value, for an identity qbarrier, which doesn't
+///     choose a type for the value already quantized.
+///   - into a single requantization from an earlier type in a chain of
+///     requantizations, when the ones in between are lossless.
+class FoldRequantizeRewrite : public RewritePattern {
+public:
+  FoldRequantizeRewrite(MLIRContext *context)
+      : RewritePattern(QuantizeBarrierOp::getOperationName(), 1, context) {}
+
+  PatternMatchResult matchAndRewrite(Operation *op,
+                                     PatternRewriter &rewriter) const override {
+    auto qbarrier = op->cast<QuantizeBarrierOp>();
+    Value *dequantizedValue = qbarrier.arg();
+    Value *quantizedValue = getDequantizedValue(dequantizedValue);
+    if (!quantizedValue) {
+      return matchFailure();
+    }
+
+    Type resultType = qbarrier.getResult()->getType();
+    if (quantizedValue->getType() == resultType) {
+      rewriter.replaceOp(op, {quantizedValue});
+      return matchSuccess();
+    }
+
+    auto resultElementType =
+        QuantizedType::getQuantizedElementType(resultType);
+    if (!resultElementType) {
+      if (resultType == dequantizedValue->getType()) {
+        rewriter.replaceOp(op, {dequantizedValue});
+        return matchSuccess();
+      }
+      return matchFailure();
+    }
+
+    // Is the quantized value itself a lossless requantization?
+    auto *quantizeOp = quantizedValue->getDefiningOp();
+    if (!quantizeOp || !quantizeOp->isa<QuantizeBarrierOp>()) {
+      return matchFailure();
+    }
+    Value *earlierDequantizedValue =
+        quantizeOp->cast<QuantizeBarrierOp>().arg();
+    Value *earlierQuantizedValue =
+        getDequantizedValue(earlierDequantizedValue);
+    if (!earlierQuantizedValue ||
+        earlierDequantizedValue->getType() != dequantizedValue->getType() ||
+        !isLosslessConversion(QuantizedType::getQuantizedElementType(
+                                  earlierQuantizedValue->getType()),
+                              QuantizedType::getQuantizedElementType(
+                                  quantizedValue->getType()))) {
+      return matchFailure();
+    }
+    rewriter.replaceOpWithNewOp<QuantizeBarrierOp>(op, resultType,
+                                                   earlierDequantizedValue);
+    return matchSuccess();
+  }
+};
+
+} // end anonymous namespace
+
+void FoldBarriersPass::runOnFunction() {
+  OwningRewritePatternList patterns;
+  auto &func = getFunction();
+  auto *context = &getContext();
+  patterns.push_back(llvm::make_unique<FoldRequantizeRewrite>(context));
+  applyPatternsGreedily(func, std::move(patterns));
+}
+
+FunctionPassBase *mlir::quant::createFoldBarriersPass() {
+  return new FoldBarriersPass();
+}
+
+static PassRegistration<FoldBarriersPass>
+    pass("quant-fold-barriers",
+         "Folds redundant qbarrier/dbarrier pairs and requantization chains");
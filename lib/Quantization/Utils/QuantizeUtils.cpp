@@ -18,7 +18,10 @@
 #include "mlir/Quantization/QuantizeUtils.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/StandardTypes.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Quantization/UniformSupport.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Support/MathExtras.h"
 
 namespace mlir {
 namespace quant {
@@ -40,6 +43,81 @@ static Attribute convertPrimitiveValueAttr(
   return nullptr;
 }
 
+/// The number of elements quantized at once by each thread when converting
+/// the elements of a DenseFPElementsAttr in bulk.
+static constexpr size_t kBulkQuantizationChunkSize = 1 << 16;
+
+/// Converts the elements of realFPElementsAttr, stored as values of the C++
+/// floating point type RealT, to storage values of the C++ integer type
+/// StorageT directly from and to raw data, without materializing an APFloat
+/// and an APInt per element. Large attributes are converted in parallel.
+template <typename RealT, typename StorageT>
+static DenseElementsAttr
+quantizeDenseFPElementsAs(DenseFPElementsAttr realFPElementsAttr,
+                          VectorOrTensorType newDenseType,
+                          const UniformQuantizedValueConverter &converter) {
+  const char *rawData = realFPElementsAttr.getRawData().data();
+  size_t numElements = realFPElementsAttr.getNumElements();
+  std::vector<StorageT> quantValues(numElements);
+  if (realFPElementsAttr.isSplat()) {
+    converter.quantizeFloatsToInts<RealT>(rawData, quantValues.data(), 1);
+    std::fill(quantValues.begin(), quantValues.end(), quantValues.front());
+    return DenseElementsAttr::get(newDenseType,
+                                  ArrayRef<StorageT>(quantValues));
+  }
+
+  size_t numChunks = llvm::divideCeil(numElements, kBulkQuantizationChunkSize);
+  auto quantizeChunk = [&](size_t chunk) {
+    size_t begin = chunk * kBulkQuantizationChunkSize;
+    size_t end = std::min(begin + kBulkQuantizationChunkSize, numElements);
+    converter.quantizeFloatsToInts<RealT>(rawData + begin * sizeof(RealT),
+                                          quantValues.data() + begin,
+                                          end - begin);
+  };
+  if (numChunks == 1) {
+    quantizeChunk(0);
+  } else {
+    auto chunks = llvm::seq<size_t>(0, numChunks);
+    parallelForEach(newDenseType.getContext(), chunks.begin(), chunks.end(),
+                    quantizeChunk);
+  }
+  return DenseElementsAttr::get(newDenseType, ArrayRef<StorageT>(quantValues));
+}
+
+/// Converts the elements of realFPElementsAttr in bulk if they are stored as
+/// values of the C++ type RealT and the storage type is an 8, 16 or 32-bit
+/// integer. Returns nullptr otherwise.
+template <typename RealT>
+static DenseElementsAttr
+quantizeDenseFPElementsInBulk(DenseFPElementsAttr realFPElementsAttr,
+                              QuantizedType quantizedElementType,
+                              VectorOrTensorType newDenseType,
+                              const UniformQuantizedValueConverter &converter) {
+  if (!realFPElementsAttr.isStoredAs<RealT>())
+    return nullptr;
+  auto storageType = quantizedElementType.getStorageType().cast<IntegerType>();
+  bool isSigned = quantizedElementType.isSigned();
+  switch (storageType.getWidth()) {
+  case 8:
+    return isSigned ? quantizeDenseFPElementsAs<RealT, int8_t>(
+                          realFPElementsAttr, newDenseType, converter)
+                    : quantizeDenseFPElementsAs<RealT, uint8_t>(
+                          realFPElementsAttr, newDenseType, converter);
+  case 16:
+    return isSigned ? quantizeDenseFPElementsAs<RealT, int16_t>(
+                          realFPElementsAttr, newDenseType, converter)
+                    : quantizeDenseFPElementsAs<RealT, uint16_t>(
+                          realFPElementsAttr, newDenseType, converter);
+  case 32:
+    return isSigned ? quantizeDenseFPElementsAs<RealT, int32_t>(
+                          realFPElementsAttr, newDenseType, converter)
+                    : quantizeDenseFPElementsAs<RealT, uint32_t>(
+                          realFPElementsAttr, newDenseType, converter);
+  default:
+    return nullptr;
+  }
+}
+
 /// Converts a real expressed DenseFPElementsAttr to a corresponding
 /// DenseElementsAttr (typically DenseIntElementsAttr) containing quantized
 /// storage values assuming the given quantizedElementType and converter.
@@ -47,17 +125,6 @@ static DenseElementsAttr
 convertDenseFPElementsAttr(DenseFPElementsAttr realFPElementsAttr,
                            QuantizedType quantizedElementType,
                            const UniformQuantizedValueConverter &converter) {
-  // Read real expressed values.
-  SmallVector<APFloat, 8> realValues;
-  realValues.reserve(realFPElementsAttr.getType().getNumElements());
-  realFPElementsAttr.getValues(realValues);
-
-  // Convert to corresponding quantized value attributes.
-  SmallVector<APInt, 8> quantValues(realValues.size());
-  for (size_t i = 0, e = realValues.size(); i < e; ++i) {
-    quantValues[i] = converter.quantizeFloatToInt(realValues[i]);
-  }
-
   // Cast from an expressed-type-based type to storage-type-based type,
   // preserving the dense shape (i.e. tensor<4xf32> -> tensor<4xi8>).
   VectorOrTensorType newDenseType =
@@ -67,6 +134,23 @@ convertDenseFPElementsAttr(DenseFPElementsAttr realFPElementsAttr,
   if (!newDenseType) {
     return nullptr;
   }
+
+  // Convert the common f32 and f64 values to 8, 16 and 32-bit storage values
+  // in bulk.
+  if (auto quantDenseAttr = quantizeDenseFPElementsInBulk<float>(
+          realFPElementsAttr, quantizedElementType, newDenseType, converter))
+    return quantDenseAttr;
+  if (auto quantDenseAttr = quantizeDenseFPElementsInBulk<double>(
+          realFPElementsAttr, quantizedElementType, newDenseType, converter))
+    return quantDenseAttr;
+
+  // Otherwise, convert the real expressed values, read from the raw data of
+  // the attribute as they are iterated over, to quantized values one by one.
+  std::vector<APInt> quantValues;
+  quantValues.reserve(realFPElementsAttr.getNumElements());
+  for (APFloat realValue : realFPElementsAttr.getFloatValues()) {
+    quantValues.push_back(converter.quantizeFloatToInt(realValue));
+  }
   return DenseIntElementsAttr::get(newDenseType, quantValues);
 }
 
@@ -100,34 +184,94 @@ convertSplatElementsAttr(SplatElementsAttr realSplatAttr,
   return SplatElementsAttr::get(newSplatType, elementAttr);
 }
 
-/// Converts a real expressed SplatElementsAttr to a corresponding
-/// SplatElementsAttr containing quantized storage values assuming the given
-/// quantizedElementType and converter.
-static SparseElementsAttr
-convertSparseElementsAttr(SparseElementsAttr realSparseAttr,
-                          QuantizedType quantizedElementType,
-                          const UniformQuantizedValueConverter &converter) {
-  DenseElementsAttr realDenseAttr = realSparseAttr.getValues();
-  if (!realDenseAttr.isa<DenseFPElementsAttr>()) {
+/// Converts a real expressed SparseElementsAttr to a corresponding attribute of
+/// newType containing quantized storage values. Each element is quantized with
+/// the converter and zero point of the slice it belongs to: the elements are in
+/// runs of runSize cycling through sliceConverters, which holds a single
+/// converter for per-layer quantization.
+/// The result stays sparse, without materializing the implicit elements, when
+/// the real zeros they hold quantize to a storage value of zero in all slices.
+/// Otherwise, e.g. for an affine type whose zero point isn't zero, the implicit
+/// elements have a non-zero storage value and the result is densified.
+static ElementsAttr convertSparseElementsAttr(
+    SparseElementsAttr realSparseAttr, QuantizedType quantizedElementType,
+    VectorOrTensorType newType,
+    ArrayRef<const UniformQuantizedValueConverter *> sliceConverters,
+    ArrayRef<int64_t> zeroPoints, size_t runSize) {
+  auto realValuesAttr =
+      realSparseAttr.getValues().dyn_cast<DenseFPElementsAttr>();
+  if (!realValuesAttr || !newType.hasStaticShape()) {
     return nullptr;
   }
-  DenseElementsAttr quantDenseAttr =
-      convertDenseFPElementsAttr(realDenseAttr.cast<DenseFPElementsAttr>(),
-                                 quantizedElementType, converter);
-  if (!quantDenseAttr) {
-    return nullptr;
+
+  // A real zero quantizes to the zero point of its slice, clamped to the
+  // storage range.
+  size_t numSlices = sliceConverters.size();
+  SmallVector<APInt, 4> quantZeros;
+  bool zerosAreZero = true;
+  for (int64_t zeroPoint : zeroPoints) {
+    int64_t quantZero =
+        std::min(std::max(zeroPoint, quantizedElementType.getStorageTypeMin()),
+                 quantizedElementType.getStorageTypeMax());
+    quantZeros.push_back(
+        APInt(quantizedElementType.getStorageTypeIntegralWidth(), quantZero,
+              quantizedElementType.isSigned()));
+    zerosAreZero &= quantZero == 0;
   }
 
-  // Cast from an expressed-type-based type to storage-type-based type,
-  // preserving the sparse shape (i.e. tensor<4xf32> -> tensor<4xi8>).
-  VectorOrTensorType newSparseType =
-      quantizedElementType.castExpressedToStorageType(realSparseAttr.getType())
-          .dyn_cast_or_null<VectorOrTensorType>();
-  if (!newSparseType) {
-    return nullptr;
+  SmallVector<uint64_t, 8> offsets;
+  realSparseAttr.getLinearIndices(offsets);
+  for (uint64_t offset : offsets) {
+    if (offset >= static_cast<uint64_t>(newType.getNumElements())) {
+      return nullptr;
+    }
+  }
+  auto getSliceConverter =
+      [&](uint64_t offset) -> const UniformQuantizedValueConverter & {
+    return *sliceConverters[(offset / runSize) % numSlices];
+  };
+
+  if (zerosAreZero) {
+    // Only the stored values are quantized, keeping the shape of the values
+    // (i.e. tensor<4xf32> -> tensor<4xi8>) and the indices as they are.
+    VectorOrTensorType realValuesType = realValuesAttr.getType();
+    VectorOrTensorType quantValuesType;
+    if (realValuesType.isa<VectorType>()) {
+      quantValuesType = VectorType::get(realValuesType.getShape(),
+                                        newType.getElementType());
+    } else {
+      quantValuesType = RankedTensorType::get(realValuesType.getShape(),
+                                              newType.getElementType());
+    }
+
+    // The stored values are converted one by one rather than in bulk, as they
+    // are usually few.
+    std::vector<APInt> quantValues;
+    quantValues.reserve(offsets.size());
+    auto offsetIt = offsets.begin();
+    for (APFloat realValue : realValuesAttr.getFloatValues()) {
+      quantValues.push_back(
+          getSliceConverter(*offsetIt++).quantizeFloatToInt(realValue));
+    }
+    return SparseElementsAttr::get(
+        newType, realSparseAttr.getIndices(),
+        DenseIntElementsAttr::get(quantValuesType, quantValues));
+  }
+
+  // Densify: the implicit elements hold the storage value of a real zero in
+  // their slice, and the stored values are quantized in place.
+  std::vector<APInt> quantValues;
+  quantValues.reserve(newType.getNumElements());
+  for (size_t i = 0, e = newType.getNumElements(); i < e; ++i) {
+    quantValues.push_back(quantZeros[(i / runSize) % numSlices]);
   }
-  return SparseElementsAttr::get(newSparseType, realSparseAttr.getIndices(),
-                                 quantDenseAttr);
+  auto offsetIt = offsets.begin();
+  for (APFloat realValue : realValuesAttr.getFloatValues()) {
+    uint64_t offset = *offsetIt++;
+    quantValues[offset] =
+        getSliceConverter(offset).quantizeFloatToInt(realValue);
+  }
+  return DenseIntElementsAttr::get(newType, quantValues);
 }
 
 /// Converts a real expressed Attribute to a corresponding Attribute containing
@@ -142,18 +286,35 @@ Attribute quantizeAttrUniform(Attribute realValue,
     // Splatted tensor or vector constant.
     auto converted = convertSplatElementsAttr(
         realValue.cast<SplatElementsAttr>(), quantizedElementType, converter);
+    if (!converted) {
+      return nullptr;
+    }
     outConvertedType = converted.getType();
     return converted;
   } else if (realValue.isa<DenseFPElementsAttr>()) {
     // Dense tensor or vector constant.
     auto converted = convertDenseFPElementsAttr(
         realValue.cast<DenseFPElementsAttr>(), quantizedElementType, converter);
+    if (!converted) {
+      return nullptr;
+    }
     outConvertedType = converted.getType();
     return converted;
   } else if (realValue.isa<SparseElementsAttr>()) {
-    // Sparse tensor or vector constant.
+    // Sparse tensor or vector constant, which stays sparse unless the zero
+    // point isn't zero.
+    auto newType =
+        quantizedElementType.castExpressedToStorageType(realValue.getType())
+            .dyn_cast_or_null<VectorOrTensorType>();
+    if (!newType) {
+      return nullptr;
+    }
     auto converted = convertSparseElementsAttr(
-        realValue.cast<SparseElementsAttr>(), quantizedElementType, converter);
+        realValue.cast<SparseElementsAttr>(), quantizedElementType, newType,
+        &converter, quantizedElementType.getZeroPoint(), /*runSize=*/1);
+    if (!converted) {
+      return nullptr;
+    }
     outConvertedType = converted.getType();
     return converted;
   } else {
@@ -163,6 +324,78 @@ Attribute quantizeAttrUniform(Attribute realValue,
   }
 }
 
+/// Converts a real expressed DenseFPElementsAttr, SplatElementsAttr or
+/// SparseElementsAttr to a corresponding ElementsAttr containing storage
+/// values, each quantized with the parameters of the slice along the quantized
+/// dimension of quantizedElementType it belongs to. A splat generally becomes
+/// dense since the slices have different parameters, while a sparse attribute
+/// stays sparse if no slice has a non-zero zero point.
+static ElementsAttr convertPerAxisElementsAttr(
+    ElementsAttr realElementsAttr,
+    UniformQuantizedPerAxisType quantizedElementType,
+    const UniformQuantizedPerAxisValueConverter &converter,
+    Type &outConvertedType) {
+  // Cast from an expressed-type-based type to storage-type-based type,
+  // preserving the shape (i.e. tensor<2x4xf32> -> tensor<2x4xi8>). This fails
+  // if the quantized dimension doesn't have one slice per scale.
+  VectorOrTensorType newType =
+      quantizedElementType
+          .castExpressedToStorageType(realElementsAttr.getType())
+          .dyn_cast_or_null<VectorOrTensorType>();
+  if (!newType || !newType.hasStaticShape()) {
+    return nullptr;
+  }
+
+  // The elements of a slice are in runs of the size of the dimensions inner to
+  // the quantized one, which cycle through the slices.
+  ArrayRef<int64_t> shape = newType.getShape();
+  int32_t quantizedDimension = converter.getQuantizedDimension();
+  size_t runSize = 1;
+  for (int64_t dimSize : shape.drop_front(quantizedDimension + 1)) {
+    runSize *= dimSize;
+  }
+  size_t numSlices = converter.getNumSlices();
+
+  if (auto realSparseAttr = realElementsAttr.dyn_cast<SparseElementsAttr>()) {
+    SmallVector<const UniformQuantizedValueConverter *, 4> sliceConverters;
+    for (unsigned i = 0; i < numSlices; ++i) {
+      sliceConverters.push_back(&converter.getSliceConverter(i));
+    }
+    auto converted = convertSparseElementsAttr(
+        realSparseAttr, quantizedElementType, newType, sliceConverters,
+        quantizedElementType.getZeroPoints(), runSize);
+    if (converted) {
+      outConvertedType = newType;
+    }
+    return converted;
+  }
+
+  std::vector<APInt> quantValues;
+  quantValues.reserve(newType.getNumElements());
+  auto quantizeNext = [&](APFloat realValue) {
+    size_t slice = (quantValues.size() / runSize) % numSlices;
+    quantValues.push_back(
+        converter.getSliceConverter(slice).quantizeFloatToInt(realValue));
+  };
+  if (auto realSplatAttr = realElementsAttr.dyn_cast<SplatElementsAttr>()) {
+    auto floatAttr = realSplatAttr.getValue().dyn_cast<FloatAttr>();
+    if (!floatAttr) {
+      return nullptr;
+    }
+    for (unsigned i = 0, e = newType.getNumElements(); i < e; ++i) {
+      quantizeNext(floatAttr.getValue());
+    }
+  } else {
+    for (APFloat realValue :
+         realElementsAttr.cast<DenseFPElementsAttr>().getFloatValues()) {
+      quantizeNext(realValue);
+    }
+  }
+
+  outConvertedType = newType;
+  return DenseIntElementsAttr::get(newType, quantValues);
+}
+
 /// Convert an attribute from a type based on
 /// quantizedElementType.getExpressedType() to one based on
 /// quantizedElementType.getStorageType().
@@ -170,8 +403,20 @@ Attribute quantizeAttrUniform(Attribute realValue,
 /// On success, stores the converted type in outConvertedType.
 Attribute quantizeAttr(Attribute realValue, QuantizedType quantizedElementType,
                        Type &outConvertedType) {
-  // Hard-coded to just support UniformQuantizedType. This will need to
-  // be generalized when there is more than one.
+  // Per-axis quantization is only supported on dense, splat and sparse
+  // constants, whose shape determines the slice each element belongs to.
+  if (auto perAxisType =
+          quantizedElementType.dyn_cast<UniformQuantizedPerAxisType>()) {
+    if (!realValue.isa<DenseFPElementsAttr>() &&
+        !realValue.isa<SplatElementsAttr>() &&
+        !realValue.isa<SparseElementsAttr>()) {
+      return nullptr;
+    }
+    UniformQuantizedPerAxisValueConverter converter(perAxisType);
+    return convertPerAxisElementsAttr(realValue.cast<ElementsAttr>(),
+                                      perAxisType, converter, outConvertedType);
+  }
+
   auto uniformQuantizedType =
       quantizedElementType.dyn_cast<UniformQuantizedType>();
   if (!uniformQuantizedType) {
@@ -57,12 +57,36 @@ void detail::printStandardBinaryOp(Operation *op, OpAsmPrinter *p) {
   *p << " : " << op->getResult(0)->getType();
 }
 
+/// Verify that the "fastmath" attribute of `op`, if any, is an array of the
+/// names of the LLVM IR fast-math flags.
+LogicalResult detail::verifyFastMathAttr(Operation *op) {
+  auto attr = op->getAttr("fastmath");
+  if (!attr)
+    return success();
+  auto flags = attr.dyn_cast<ArrayAttr>();
+  if (!flags)
+    return op->emitOpError("requires 'fastmath' to be an array of strings");
+  for (Attribute flag : flags) {
+    auto name = flag.dyn_cast<StringAttr>();
+    if (!name)
+      return op->emitOpError("requires 'fastmath' to be an array of strings");
+    bool isKnownFlag = llvm::StringSwitch<bool>(name.getValue())
+                           .Cases("nnan", "ninf", "nsz", "arcp", "contract",
+                                  "afn", "reassoc", "fast", true)
+                           .Default(false);
+    if (!isKnownFlag)
+      return op->emitOpError("unknown fast-math flag '" + name.getValue() +
+                             "'");
+  }
+  return success();
+}
+
 StandardOpsDialect::StandardOpsDialect(MLIRContext *context)
-    : Dialect(/*name=*/"std", context) {
+    : Dialect(getDialectNamespace(), context) {
   addOperations<AllocOp, BranchOp, CallOp, CallIndirectOp, CmpIOp, CondBranchOp,
                 ConstantOp, DeallocOp, DimOp, DmaStartOp, DmaWaitOp,
                 ExtractElementOp, LoadOp, MemRefCastOp, ReturnOp, SelectOp,
-                StoreOp, TensorCastOp,
+                StoreOp, TensorCastOp, ViewOp,
 #define GET_OP_LIST
 #include "mlir/StandardOps/Ops.cpp.inc"
                 >();
@@ -375,6 +399,10 @@ void AllocOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
   results.push_back(llvm::make_unique<SimplifyDeadAlloc>(context));
 }
 
+void AllocOp::getEffects(SmallVectorImpl<MemoryEffect> &effects) {
+  effects.emplace_back(MemoryEffect::Allocate, getResult());
+}
+
 //===----------------------------------------------------------------------===//
 // BranchOp
 //===----------------------------------------------------------------------===//
@@ -387,7 +415,8 @@ void BranchOp::build(Builder *builder, OperationState *result, Block *dest,
 bool BranchOp::parse(OpAsmParser *parser, OperationState *result) {
   Block *dest;
   SmallVector<Value *, 4> destOperands;
-  if (parser->parseSuccessorAndUseList(dest, destOperands))
+  if (parser->parseSuccessorAndUseList(dest, destOperands) ||
+      parser->parseOptionalAttributeDict(result->attributes))
     return true;
   result->addSuccessor(dest, destOperands);
   return false;
@@ -396,6 +425,7 @@ bool BranchOp::parse(OpAsmParser *parser, OperationState *result) {
 void BranchOp::print(OpAsmPrinter *p) {
   *p << "br ";
   p->printSuccessorAndUseList(getOperation(), 0);
+  p->printOptionalAttrDict(getAttrs());
 }
 
 Block *BranchOp::getDest() { return getOperation()->getSuccessor(0); }
@@ -1140,6 +1170,10 @@ void DeallocOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
   results.push_back(llvm::make_unique<SimplifyDeadDealloc>(context));
 }
 
+void DeallocOp::getEffects(SmallVectorImpl<MemoryEffect> &effects) {
+  effects.emplace_back(MemoryEffect::Free, getMemRef());
+}
+
 //===----------------------------------------------------------------------===//
 // DimOp
 //===----------------------------------------------------------------------===//
@@ -1214,6 +1248,13 @@ Attribute DimOp::constantFold(ArrayRef<Attribute> operands,
   return nullptr;
 }
 
+void DimOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
+                                        MLIRContext *context) {
+  /// dim(memrefcast) -> dim
+  results.push_back(
+      llvm::make_unique<MemRefCastFolder>(getOperationName(), context));
+}
+
 //===----------------------------------------------------------------------===//
 // DivISOp
 //===----------------------------------------------------------------------===//
@@ -1284,6 +1325,22 @@ void DmaStartOp::build(Builder *builder, OperationState *result,
   }
 }
 
+void DmaStartOp::build(Builder *builder, OperationState *result,
+                       Value *srcMemRef, ArrayRef<Value *> srcIndices,
+                       Value *destMemRef, ArrayRef<Value *> destIndices,
+                       Value *numElements, Value *tagMemRef,
+                       ArrayRef<Value *> tagIndices, ArrayRef<Value *> strides,
+                       ArrayRef<Value *> elementsPerStride) {
+  assert(strides.size() == elementsPerStride.size() &&
+         "expected a number of elements per stride for each stride");
+  build(builder, result, srcMemRef, srcIndices, destMemRef, destIndices,
+        numElements, tagMemRef, tagIndices);
+  for (unsigned i = 0, e = strides.size(); i < e; ++i) {
+    result->addOperands(strides[i]);
+    result->addOperands(elementsPerStride[i]);
+  }
+}
+
 void DmaStartOp::print(OpAsmPrinter *p) {
   *p << "dma_start " << *getSrcMemRef() << '[';
   p->printOperands(getSrcIndices());
@@ -1293,9 +1350,9 @@ void DmaStartOp::print(OpAsmPrinter *p) {
   *p << ", " << *getTagMemRef() << '[';
   p->printOperands(getTagIndices());
   *p << ']';
-  if (isStrided()) {
-    *p << ", " << *getStride();
-    *p << ", " << *getNumElementsPerStride();
+  for (unsigned i = 0, e = getNumStrideLevels(); i < e; ++i) {
+    *p << ", " << *getStride(i);
+    *p << ", " << *getNumElementsPerStride(i);
   }
   p->printOptionalAttrDict(getAttrs());
   *p << " : " << getSrcMemRef()->getType();
@@ -1311,6 +1368,9 @@ void DmaStartOp::print(OpAsmPrinter *p) {
 //                       memref<1024 x f32, 2>,
 //                       memref<1 x i32>
 //
+// Further stride levels are specified as additional pairs of stride and
+// number of elements per stride operands.
+//
 bool DmaStartOp::parse(OpAsmParser *parser, OperationState *result) {
   OpAsmParser::OperandType srcMemRefInfo;
   SmallVector<OpAsmParser::OperandType, 4> srcIndexInfos;
@@ -1319,7 +1379,7 @@ bool DmaStartOp::parse(OpAsmParser *parser, OperationState *result) {
   OpAsmParser::OperandType numElementsInfo;
   OpAsmParser::OperandType tagMemrefInfo;
   SmallVector<OpAsmParser::OperandType, 4> tagIndexInfos;
-  SmallVector<OpAsmParser::OperandType, 2> strideInfo;
+  SmallVector<OpAsmParser::OperandType, 4> strideInfo;
 
   SmallVector<Type, 3> types;
   auto indexType = parser->getBuilder().getIndexType();
@@ -1340,15 +1400,15 @@ bool DmaStartOp::parse(OpAsmParser *parser, OperationState *result) {
                                OpAsmParser::Delimiter::Square))
     return true;
 
-  // Parse optional stride and elements per stride.
+  // Parse optional pairs of stride and elements per stride.
   if (parser->parseTrailingOperandList(strideInfo)) {
     return true;
   }
-  if (!strideInfo.empty() && strideInfo.size() != 2) {
+  if (strideInfo.size() % 2 != 0) {
     return parser->emitError(parser->getNameLoc(),
-                             "expected two stride related operands");
+                             "expected two stride related operands per "
+                             "stride level");
   }
-  bool isStrided = strideInfo.size() == 2;
 
   if (parser->parseColonTypeList(types))
     return true;
@@ -1379,11 +1439,8 @@ bool DmaStartOp::parse(OpAsmParser *parser, OperationState *result) {
     return parser->emitError(parser->getNameLoc(),
                              "expected tag to be of memref type");
 
-  if (isStrided) {
-    if (parser->resolveOperand(strideInfo[0], indexType, result->operands) ||
-        parser->resolveOperand(strideInfo[1], indexType, result->operands))
-      return true;
-  }
+  if (parser->resolveOperands(strideInfo, indexType, result->operands))
+    return true;
 
   // Check that source/destination index list size matches associated rank.
   if (srcIndexInfos.size() != types[0].cast<MemRefType>().getRank() ||
@@ -1404,10 +1461,12 @@ LogicalResult DmaStartOp::verify() {
     return emitOpError("DMA should be between different memory spaces");
   }
 
-  if (getNumOperands() != getTagMemRefRank() + getSrcMemRefRank() +
-                              getDstMemRefRank() + 3 + 1 &&
-      getNumOperands() != getTagMemRefRank() + getSrcMemRefRank() +
-                              getDstMemRefRank() + 3 + 1 + 2) {
+  // Any number of stride levels, each with a pair of operands, may follow the
+  // tag indices.
+  unsigned numNonStrideOperands =
+      getTagMemRefRank() + getSrcMemRefRank() + getDstMemRefRank() + 3 + 1;
+  if (getNumOperands() < numNonStrideOperands ||
+      (getNumOperands() - numNonStrideOperands) % 2 != 0) {
     return emitOpError("incorrect number of operands");
   }
   return success();
@@ -1420,6 +1479,12 @@ void DmaStartOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
       llvm::make_unique<MemRefCastFolder>(getOperationName(), context));
 }
 
+void DmaStartOp::getEffects(SmallVectorImpl<MemoryEffect> &effects) {
+  effects.emplace_back(MemoryEffect::Read, getSrcMemRef());
+  effects.emplace_back(MemoryEffect::Write, getDstMemRef());
+  effects.emplace_back(MemoryEffect::Write, getTagMemRef());
+}
+
 // ---------------------------------------------------------------------------
 // DmaWaitOp
 // ---------------------------------------------------------------------------
@@ -1571,6 +1636,27 @@ Attribute ExtractElementOp::constantFold(ArrayRef<Attribute> operands,
   return Attribute();
 }
 
+//===----------------------------------------------------------------------===//
+// FmaFOp
+//===----------------------------------------------------------------------===//
+
+static bool parseFmaFOp(OpAsmParser *parser, OperationState *result) {
+  SmallVector<OpAsmParser::OperandType, 3> ops;
+  Type type;
+  return parser->parseOperandList(ops, 3) ||
+         parser->parseOptionalAttributeDict(result->attributes) ||
+         parser->parseColonType(type) ||
+         parser->resolveOperands(ops, type, result->operands) ||
+         parser->addTypeToList(type, result->types);
+}
+
+static void printFmaFOp(OpAsmPrinter *p, Operation *op) {
+  *p << "fmaf " << *op->getOperand(0) << ", " << *op->getOperand(1) << ", "
+     << *op->getOperand(2);
+  p->printOptionalAttrDict(op->getAttrs());
+  *p << " : " << op->getResult(0)->getType();
+}
+
 //===----------------------------------------------------------------------===//
 // LoadOp
 //===----------------------------------------------------------------------===//
@@ -1639,6 +1725,10 @@ void LoadOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
       llvm::make_unique<MemRefCastFolder>(getOperationName(), context));
 }
 
+void LoadOp::getEffects(SmallVectorImpl<MemoryEffect> &effects) {
+  effects.emplace_back(MemoryEffect::Read, getMemRef());
+}
+
 //===----------------------------------------------------------------------===//
 // MemRefCastOp
 //===----------------------------------------------------------------------===//
@@ -1959,6 +2049,10 @@ void StoreOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
       llvm::make_unique<MemRefCastFolder>(getOperationName(), context));
 }
 
+void StoreOp::getEffects(SmallVectorImpl<MemoryEffect> &effects) {
+  effects.emplace_back(MemoryEffect::Write, getMemRef());
+}
+
 //===----------------------------------------------------------------------===//
 // SubFOp
 //===----------------------------------------------------------------------===//
@@ -2045,6 +2139,54 @@ LogicalResult TensorCastOp::verify() {
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// ViewOp
+//===----------------------------------------------------------------------===//
+
+void ViewOp::print(OpAsmPrinter *p) {
+  *p << "view " << *getOperand() << " : " << getOperand()->getType() << " to "
+     << getType();
+}
+
+LogicalResult ViewOp::verify() {
+  auto opType = getOperand()->getType().dyn_cast<MemRefType>();
+  auto resType = getType().dyn_cast<MemRefType>();
+  if (!opType || !resType)
+    return emitOpError("requires input and result types to be memrefs");
+
+  if (opType.getElementType() != resType.getElementType())
+    return emitOpError(
+        "requires input and result element types to be the same");
+
+  if (opType.getMemorySpace() != resType.getMemorySpace())
+    return emitOpError(
+        "requires input and result memory spaces to be the same");
+
+  if (!opType.getAffineMaps().empty())
+    return emitOpError("requires the input to have the identity layout");
+
+  if (!resType.hasStaticShape())
+    return emitOpError("requires the result to have a static shape");
+
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(resType, strides, offset)) || offset < 0 ||
+      llvm::any_of(strides, [](int64_t stride) { return stride < 0; }))
+    return emitOpError("requires the result to have a strided layout with "
+                       "static non-negative strides and offset");
+
+  // The last element of the view must be within a statically shaped input.
+  if (opType.hasStaticShape()) {
+    int64_t lastElement = offset;
+    for (unsigned i = 0, e = resType.getRank(); i < e; ++i)
+      lastElement += (resType.getDimSize(i) - 1) * strides[i];
+    if (lastElement >= opType.getNumElements())
+      return emitOpError("requires the view to be within its input");
+  }
+
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // TableGen'd op method definitions
 //===----------------------------------------------------------------------===//
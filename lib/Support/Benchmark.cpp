@@ -0,0 +1,112 @@
+//===- Benchmark.cpp - Support for the benchmark tools --------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the driver of the benchmark tools.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Support/Benchmark.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace mlir;
+
+static llvm::cl::OptionCategory clOptionsCategory("benchmark options");
+
+static llvm::cl::opt<std::string>
+    clFilter("filter",
+             llvm::cl::desc("Only run the benchmarks whose name contains this "
+                            "string"),
+             llvm::cl::init(""), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned>
+    clWarmup("warmup",
+             llvm::cl::desc("Number of untimed runs of each benchmark"),
+             llvm::cl::init(1), llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned>
+    clIterations("iterations",
+                 llvm::cl::desc("Number of timed runs of each benchmark"),
+                 llvm::cl::init(10), llvm::cl::cat(clOptionsCategory));
+
+// Prepare and execute one run of `benchmark`, adding its latency to
+// `latencies` if it is not null.  Return false if the run failed.
+static bool runOnce(const Benchmark &benchmark,
+                    std::vector<double> *latencies) {
+  if (benchmark.setUp && !benchmark.setUp())
+    return false;
+  auto start = BenchmarkClock::now();
+  if (!benchmark.run())
+    return false;
+  if (latencies)
+    latencies->push_back(getElapsedMs(start));
+  return true;
+}
+
+Optional<llvm::json::Object> mlir::runBenchmark(const Benchmark &benchmark,
+                                                unsigned warmup,
+                                                unsigned iterations) {
+  for (unsigned i = 0; i < warmup; ++i)
+    if (!runOnce(benchmark, /*latencies=*/nullptr))
+      return llvm::None;
+
+  std::vector<double> latencies;
+  latencies.reserve(iterations);
+  for (unsigned i = 0; i < iterations; ++i)
+    if (!runOnce(benchmark, &latencies))
+      return llvm::None;
+
+  llvm::json::Object report{{"name", benchmark.name},
+                            {"iterations", int64_t(iterations)}};
+  if (benchmark.numItems)
+    report["items"] = int64_t(benchmark.numItems);
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    double total = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+    report["min_ms"] = latencies.front();
+    report["median_ms"] = latencies[(latencies.size() - 1) / 2];
+    report["mean_ms"] = total / latencies.size();
+    if (benchmark.numItems)
+      report["items_per_second"] =
+          total > 0 ? benchmark.numItems * latencies.size() * 1000.0 / total
+                    : 0.0;
+  }
+  if (benchmark.addToReport)
+    benchmark.addToReport(report);
+  return report;
+}
+
+LogicalResult mlir::runBenchmarks(ArrayRef<Benchmark> benchmarks,
+                                  raw_ostream &os) {
+  llvm::json::Array reports;
+  for (auto &benchmark : benchmarks) {
+    if (!StringRef(benchmark.name).contains(clFilter))
+      continue;
+    auto report = runBenchmark(benchmark, clWarmup, clIterations);
+    if (!report) {
+      llvm::errs() << "benchmark '" << benchmark.name << "' failed\n";
+      return failure();
+    }
+    reports.push_back(std::move(*report));
+  }
+  os << llvm::formatv("{0:2}", llvm::json::Value(std::move(reports))) << '\n';
+  return success();
+}
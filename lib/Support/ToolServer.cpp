@@ -0,0 +1,117 @@
+//===- ToolServer.cpp - Serving the requests of a tool --------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the server mode of the command line tools.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Support/ToolServer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <mutex>
+#include <string>
+
+using namespace mlir;
+
+namespace {
+// A request read by the server.  The arguments refer to the header line.
+struct Request {
+  std::string header;
+  StringRef id;
+  SmallVector<StringRef, 8> args;
+  std::unique_ptr<llvm::MemoryBuffer> input;
+};
+} // end anonymous namespace
+
+// Read a line of `input`, without its newline, into `line`.  Returns false if
+// the end of the input is reached before any character is read.
+static bool readLine(FILE *input, std::string &line) {
+  line.clear();
+  int c;
+  while ((c = fgetc(input)) != EOF && c != '\n')
+    line.push_back(c);
+  return c != EOF || !line.empty();
+}
+
+// Parse the header line of `request`.  Returns failure if it is malformed.
+static LogicalResult parseHeader(Request &request, size_t &inputSize) {
+  SmallVector<StringRef, 8> tokens;
+  StringRef(request.header)
+      .rtrim('\r')
+      .split(tokens, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  unsigned long long size;
+  if (tokens.size() < 2 || tokens[1].getAsInteger(10, size))
+    return failure();
+  request.id = tokens[0];
+  request.args.assign(tokens.begin() + 2, tokens.end());
+  inputSize = size;
+  return success();
+}
+
+LogicalResult mlir::runToolServer(FILE *input, llvm::raw_ostream &output,
+                                  llvm::ThreadPool &threadPool,
+                                  const ToolServerHandler &handler) {
+  // The responses are written whole, in the order the requests complete.
+  std::mutex outputMutex;
+  auto respond = [&](StringRef id, LogicalResult result, StringRef out,
+                     StringRef diagnostics) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    output << id << ' ' << (succeeded(result) ? 0 : 1) << ' ' << out.size()
+           << ' ' << diagnostics.size() << '\n'
+           << out << diagnostics;
+    output.flush();
+  };
+
+  LogicalResult result = success();
+  while (true) {
+    auto request = std::make_shared<Request>();
+    if (!readLine(input, request->header))
+      break;
+    if (StringRef(request->header).trim().empty())
+      continue;
+
+    size_t inputSize;
+    if (failed(parseHeader(*request, inputSize))) {
+      llvm::errs() << "malformed request header '" << request->header
+                   << "', expected '<id> <input size> [<argument>...]'\n";
+      result = failure();
+      break;
+    }
+    auto buffer =
+        llvm::WritableMemoryBuffer::getNewUninitMemBuffer(inputSize, "<stdin>");
+    if (!buffer ||
+        fread(buffer->getBufferStart(), 1, inputSize, input) != inputSize) {
+      llvm::errs() << "truncated input of request '" << request->id << "'\n";
+      result = failure();
+      break;
+    }
+    request->input = std::move(buffer);
+
+    threadPool.async([request, &handler, &respond] {
+      std::string out, diagnostics;
+      llvm::raw_string_ostream os(out), diagOS(diagnostics);
+      LogicalResult requestResult =
+          handler(request->args, std::move(request->input), os, diagOS);
+      respond(request->id, requestResult, os.str(), diagOS.str());
+    });
+  }
+  threadPool.wait();
+  return result;
+}
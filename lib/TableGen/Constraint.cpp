@@ -61,6 +61,11 @@ llvm::StringRef Constraint::getDescription() const {
   return doc;
 }
 
+bool Constraint::isExpensive() const {
+  auto *val = def->getValue("isExpensive");
+  return val && def->getValueAsBit("isExpensive");
+}
+
 AppliedConstraint::AppliedConstraint(Constraint &&c,
                                      std::vector<std::string> &&e)
     : constraint(c), entities(std::move(e)) {}
@@ -0,0 +1,68 @@
+//===- OpInterfaces.cpp - OpInterfaces class ------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// OpInterface wrapper to simplify using TableGen Record defining an MLIR op
+// interface.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/TableGen/OpInterfaces.h"
+#include "llvm/TableGen/Error.h"
+#include "llvm/TableGen/Record.h"
+
+using namespace mlir;
+
+tblgen::InterfaceMethod::InterfaceMethod(const llvm::Record *def) : def(def) {
+  llvm::DagInit *args = def->getValueAsDag("arguments");
+  for (unsigned i = 0, e = args->getNumArgs(); i != e; ++i) {
+    auto *type = dyn_cast<llvm::StringInit>(args->getArg(i));
+    auto *name = args->getArgName(i);
+    if (!type || !name)
+      llvm::PrintFatalError(def->getLoc(),
+                            "expected the arguments of the interface method "
+                            "to be C++ types bound to names, e.g. "
+                            "\"unsigned\":$index");
+    arguments.push_back({type->getValue(), name->getValue()});
+  }
+}
+
+StringRef tblgen::InterfaceMethod::getName() const {
+  return def->getValueAsString("name");
+}
+
+StringRef tblgen::InterfaceMethod::getReturnType() const {
+  return def->getValueAsString("returnType");
+}
+
+StringRef tblgen::InterfaceMethod::getDescription() const {
+  return def->getValueAsString("description");
+}
+
+tblgen::OpInterface::OpInterface(const llvm::Record *def) : def(def) {
+  assert(def->isSubClassOf("OpInterface") &&
+         "must be subclass of TableGen 'OpInterface' class");
+  for (auto *method : def->getValueAsListOfDefs("methods"))
+    methods.emplace_back(method);
+}
+
+StringRef tblgen::OpInterface::getName() const {
+  return def->getValueAsString("cppClassName");
+}
+
+StringRef tblgen::OpInterface::getDescription() const {
+  return def->getValueAsString("description");
+}
@@ -34,6 +34,8 @@ mlir::tblgen::OpTrait mlir::tblgen::OpTrait::create(const llvm::Init *init) {
     return OpTrait(Kind::Pred, def);
   if (def->isSubClassOf("OpGenInternalTrait"))
     return OpTrait(Kind::Internal, def);
+  if (def->isSubClassOf("OpInterface"))
+    return OpTrait(Kind::Interface, def);
   assert(def->isSubClassOf("NativeOpTrait"));
   return OpTrait(Kind::Native, def);
 }
@@ -49,6 +51,10 @@ llvm::StringRef mlir::tblgen::InternalOpTrait::getTrait() const {
   return def->getValueAsString("trait");
 }
 
+std::string mlir::tblgen::InterfaceOpTrait::getTrait() const {
+  return (def->getValueAsString("cppClassName") + "::Trait").str();
+}
+
 std::string mlir::tblgen::PredOpTrait::getPredTemplate() const {
   auto pred = tblgen::Pred(def->getValueInit("pred"));
   return pred.getCondition();
@@ -57,3 +63,7 @@ std::string mlir::tblgen::PredOpTrait::getPredTemplate() const {
 llvm::StringRef mlir::tblgen::PredOpTrait::getDescription() const {
   return def->getValueAsString("desc");
 }
+
+bool mlir::tblgen::PredOpTrait::isExpensive() const {
+  return def->getValueAsBit("isExpensive");
+}
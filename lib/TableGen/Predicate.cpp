@@ -311,6 +311,33 @@ static std::string getCombinedCondition(const PredNode &root) {
   for (const auto &child : root.children)
     childExpressions.push_back(getCombinedCondition(*child));
 
+  // Fold the children that are literally true or false, such as the
+  // predicate of a constraint accepting anything (e.g. AnyType or ArrayAttr)
+  // combined with further constraints, so that the generated checks don't
+  // evaluate them.
+  //   AND(..., true, ...) = AND(..., ...)
+  //   AND(..., false, ...) = false
+  //   OR(..., false, ...) = OR(..., ...)
+  //   OR(..., true, ...) = true
+  if (root.kind == PredCombinerKind::And || root.kind == PredCombinerKind::Or) {
+    bool isAnd = root.kind == PredCombinerKind::And;
+    StringRef neutral = isAnd ? "true" : "false";
+    StringRef absorbing = isAnd ? "false" : "true";
+    auto isLiteral = [](StringRef expr, StringRef literal) {
+      return expr == literal ||
+             (expr.size() == literal.size() + 2 && expr.front() == '(' &&
+              expr.back() == ')' && expr.substr(1, literal.size()) == literal);
+    };
+    llvm::SmallVector<std::string, 4> remaining;
+    for (auto &expr : childExpressions) {
+      if (isLiteral(expr, absorbing))
+        return absorbing;
+      if (!isLiteral(expr, neutral))
+        remaining.push_back(std::move(expr));
+    }
+    childExpressions = std::move(remaining);
+  }
+
   // Combine the expressions based on the predicate node kind.
   if (root.kind == PredCombinerKind::And)
     return combineBinary(childExpressions, "&&", "true");
@@ -0,0 +1,612 @@
+//===- ConvertFromLLVMIR.cpp - LLVM IR to MLIR conversion -------*- C++ -*-===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a translation from LLVM IR to the MLIR LLVM dialect.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/LLVMIR/LLVMDialect.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Support/FileUtilities.h"
+#include "mlir/Target/LLVMIR.h"
+#include "mlir/Translation.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+namespace {
+// Implementation class for the import of an LLVM IR module into the MLIR LLVM
+// IR dialect.  Holds the module being populated and the mappings between the
+// original and the imported functions, blocks and values.  The LLVM IR module
+// must live in the LLVM context of the dialect, so that its types are wrapped
+// as they are.
+class Importer {
+public:
+  Importer(Module &module, Location unknownLoc)
+      : module(module), context(module.getContext()), builder(context),
+        unknownLoc(unknownLoc) {}
+
+  // Declare the function `f` in the imported module.
+  LogicalResult declareFunction(llvm::Function &f);
+  // Import the body of the function `f`, which must have been declared.
+  LogicalResult importFunctionBody(llvm::Function &f);
+
+private:
+  LLVM::LLVMType getType(llvm::Type *type) {
+    return LLVM::LLVMType::get(context, type);
+  }
+  Location getLocation(llvm::Instruction &inst);
+  Type getElementAttrType(llvm::Type *type);
+  Attribute getConstantAttr(llvm::Constant *constant);
+  Value *importConstant(FuncBuilder &b, llvm::Constant *constant,
+                        Location loc);
+  Value *importValue(FuncBuilder &b, llvm::Value *value, Location loc);
+  LogicalResult importOperands(FuncBuilder &b, ArrayRef<llvm::Value *> operands,
+                               Location loc, SmallVectorImpl<Value *> &result);
+  LogicalResult importBranchOperands(FuncBuilder &b, llvm::BasicBlock *source,
+                                     llvm::BasicBlock *target, Location loc,
+                                     SmallVectorImpl<Value *> &result);
+  LogicalResult importInstruction(FuncBuilder &b, llvm::Instruction &inst);
+  LogicalResult emitUnsupported(Location loc, const llvm::Value &value,
+                                StringRef kind);
+
+  Module &module;
+  MLIRContext *context;
+  Builder builder;
+  // Location of the operations without debug information.
+  Location unknownLoc;
+
+  // Mappings between original and imported functions, blocks and values.
+  llvm::DenseMap<llvm::Function *, Function *> functionMapping;
+  llvm::DenseMap<llvm::BasicBlock *, Block *> blockMapping;
+  llvm::DenseMap<llvm::Value *, Value *> valueMapping;
+};
+} // end anonymous namespace
+
+// Get the location of `inst` from its debug information, if any.
+Location Importer::getLocation(llvm::Instruction &inst) {
+  auto *loc = inst.getDebugLoc().get();
+  if (!loc)
+    return unknownLoc;
+  return FileLineColLoc::get(UniquedFilename::get(loc->getFilename(), context),
+                             loc->getLine(), loc->getColumn(), context);
+}
+
+// Report that `value` of the given `kind` cannot be imported.
+LogicalResult Importer::emitUnsupported(Location loc, const llvm::Value &value,
+                                        StringRef kind) {
+  std::string str;
+  llvm::raw_string_ostream os(str);
+  value.print(os);
+  context->emitError(loc, "unsupported " + kind + ": " + os.str());
+  return failure();
+}
+
+// Get the MLIR type of the scalar constants of LLVM IR `type` in attributes,
+// or a null type if they have none.
+Type Importer::getElementAttrType(llvm::Type *type) {
+  if (type->isIntegerTy())
+    return builder.getIntegerType(type->getIntegerBitWidth());
+  if (type->isFloatTy())
+    return builder.getF32Type();
+  if (type->isDoubleTy())
+    return builder.getF64Type();
+  return {};
+}
+
+// Get the attribute holding the value of the scalar or vector `constant`, or a
+// null attribute if it has none.  The undefined elements of vectors are zero.
+Attribute Importer::getConstantAttr(llvm::Constant *constant) {
+  if (auto *c = dyn_cast<llvm::ConstantInt>(constant))
+    return builder.getIntegerAttr(getElementAttrType(c->getType()),
+                                  c->getValue());
+  if (auto *c = dyn_cast<llvm::ConstantFP>(constant)) {
+    auto type = getElementAttrType(c->getType());
+    if (!type)
+      return {};
+    return builder.getFloatAttr(type, c->getValueAPF());
+  }
+  if (auto *f = dyn_cast<llvm::Function>(constant))
+    return builder.getFunctionAttr(functionMapping.lookup(f));
+
+  auto *vectorType = dyn_cast<llvm::VectorType>(constant->getType());
+  if (!vectorType)
+    return {};
+  auto *llvmElementType = vectorType->getElementType();
+  auto elementType = getElementAttrType(llvmElementType);
+  if (!elementType)
+    return {};
+  SmallVector<Attribute, 8> elements;
+  elements.reserve(vectorType->getNumElements());
+  for (unsigned i = 0, e = vectorType->getNumElements(); i < e; ++i) {
+    auto *element = constant->getAggregateElement(i);
+    if (!element)
+      return {};
+    if (isa<llvm::UndefValue>(element))
+      element = llvm::Constant::getNullValue(llvmElementType);
+    auto attr = getConstantAttr(element);
+    if (!attr)
+      return {};
+    elements.push_back(attr);
+  }
+  return builder.getDenseElementsAttr(
+      VectorType::get({vectorType->getNumElements()}, elementType), elements);
+}
+
+// Materialize `constant` with `b` as an llvm.undef or llvm.constant operation.
+Value *Importer::importConstant(FuncBuilder &b, llvm::Constant *constant,
+                                Location loc) {
+  auto type = getType(constant->getType());
+  if (isa<llvm::UndefValue>(constant))
+    return b.create<LLVM::UndefOp>(loc, type, ArrayRef<Value *>{});
+  if (auto attr = getConstantAttr(constant))
+    return b.create<LLVM::ConstantOp>(loc, type, attr);
+  return emitUnsupported(loc, *constant, "constant"), nullptr;
+}
+
+// Get the value that `value` was imported to.  Constants are materialized with
+// `b` where they are used.
+Value *Importer::importValue(FuncBuilder &b, llvm::Value *value,
+                             Location loc) {
+  if (auto *constant = dyn_cast<llvm::Constant>(value))
+    return importConstant(b, constant, loc);
+  if (auto *imported = valueMapping.lookup(value))
+    return imported;
+  return emitUnsupported(loc, *value, "value"), nullptr;
+}
+
+// Import the `operands` of an instruction into `result`.
+LogicalResult Importer::importOperands(FuncBuilder &b,
+                                       ArrayRef<llvm::Value *> operands,
+                                       Location loc,
+                                       SmallVectorImpl<Value *> &result) {
+  result.reserve(operands.size());
+  for (llvm::Value *operand : operands) {
+    Value *imported = importValue(b, operand, loc);
+    if (!imported)
+      return failure();
+    result.push_back(imported);
+  }
+  return success();
+}
+
+// Import into `result` the values that the PHI nodes of `target` take from
+// `source`, which become the operands of the branch to the imported block.
+LogicalResult Importer::importBranchOperands(FuncBuilder &b,
+                                             llvm::BasicBlock *source,
+                                             llvm::BasicBlock *target,
+                                             Location loc,
+                                             SmallVectorImpl<Value *> &result) {
+  for (auto &phi : target->phis()) {
+    Value *imported =
+        importValue(b, phi.getIncomingValueForBlock(source), loc);
+    if (!imported)
+      return failure();
+    result.push_back(imported);
+  }
+  return success();
+}
+
+// Get the comparison predicate of the standard dialect corresponding to the
+// LLVM IR integer comparison predicate `p`.
+static CmpIPredicate getCmpIPredicate(llvm::CmpInst::Predicate p) {
+  switch (p) {
+  case llvm::CmpInst::Predicate::ICMP_EQ:
+    return CmpIPredicate::EQ;
+  case llvm::CmpInst::Predicate::ICMP_NE:
+    return CmpIPredicate::NE;
+  case llvm::CmpInst::Predicate::ICMP_SLT:
+    return CmpIPredicate::SLT;
+  case llvm::CmpInst::Predicate::ICMP_SLE:
+    return CmpIPredicate::SLE;
+  case llvm::CmpInst::Predicate::ICMP_SGT:
+    return CmpIPredicate::SGT;
+  case llvm::CmpInst::Predicate::ICMP_SGE:
+    return CmpIPredicate::SGE;
+  case llvm::CmpInst::Predicate::ICMP_ULT:
+    return CmpIPredicate::ULT;
+  case llvm::CmpInst::Predicate::ICMP_ULE:
+    return CmpIPredicate::ULE;
+  case llvm::CmpInst::Predicate::ICMP_UGT:
+    return CmpIPredicate::UGT;
+  case llvm::CmpInst::Predicate::ICMP_UGE:
+    return CmpIPredicate::UGE;
+  default:
+    llvm_unreachable("incorrect integer comparison predicate");
+  }
+}
+
+// Get the "fastmath" attribute listing the LLVM IR fast-math `flags`.
+static ArrayAttr getFastMathAttr(Builder &builder, llvm::FastMathFlags flags) {
+  SmallVector<Attribute, 4> names;
+  auto addFlag = [&](bool isSet, StringRef name) {
+    if (isSet)
+      names.push_back(builder.getStringAttr(name));
+  };
+  if (flags.isFast()) {
+    addFlag(true, "fast");
+  } else {
+    addFlag(flags.noNaNs(), "nnan");
+    addFlag(flags.noInfs(), "ninf");
+    addFlag(flags.noSignedZeros(), "nsz");
+    addFlag(flags.allowReciprocal(), "arcp");
+    addFlag(flags.allowContract(), "contract");
+    addFlag(flags.approxFunc(), "afn");
+    addFlag(flags.allowReassoc(), "reassoc");
+  }
+  return builder.getArrayAttr(names);
+}
+
+// Get the name of the LLVM IR dialect operation taking the operands of the
+// LLVM IR instructions with `opcode` as they are, or an empty string if there
+// is none.
+static StringRef getOperationName(unsigned opcode) {
+  switch (opcode) {
+  case llvm::Instruction::Add:
+    return LLVM::AddOp::getOperationName();
+  case llvm::Instruction::Sub:
+    return LLVM::SubOp::getOperationName();
+  case llvm::Instruction::Mul:
+    return LLVM::MulOp::getOperationName();
+  case llvm::Instruction::UDiv:
+    return LLVM::UDivOp::getOperationName();
+  case llvm::Instruction::SDiv:
+    return LLVM::SDivOp::getOperationName();
+  case llvm::Instruction::URem:
+    return LLVM::URemOp::getOperationName();
+  case llvm::Instruction::SRem:
+    return LLVM::SRemOp::getOperationName();
+  case llvm::Instruction::And:
+    return LLVM::AndOp::getOperationName();
+  case llvm::Instruction::Or:
+    return LLVM::OrOp::getOperationName();
+  case llvm::Instruction::Xor:
+    return LLVM::XOrOp::getOperationName();
+  case llvm::Instruction::Shl:
+    return LLVM::ShlOp::getOperationName();
+  case llvm::Instruction::LShr:
+    return LLVM::LShrOp::getOperationName();
+  case llvm::Instruction::AShr:
+    return LLVM::AShrOp::getOperationName();
+  case llvm::Instruction::FAdd:
+    return LLVM::FAddOp::getOperationName();
+  case llvm::Instruction::FSub:
+    return LLVM::FSubOp::getOperationName();
+  case llvm::Instruction::FMul:
+    return LLVM::FMulOp::getOperationName();
+  case llvm::Instruction::FDiv:
+    return LLVM::FDivOp::getOperationName();
+  case llvm::Instruction::FRem:
+    return LLVM::FRemOp::getOperationName();
+  case llvm::Instruction::BitCast:
+    return LLVM::BitcastOp::getOperationName();
+  case llvm::Instruction::SExt:
+    return LLVM::SExtOp::getOperationName();
+  case llvm::Instruction::ZExt:
+    return LLVM::ZExtOp::getOperationName();
+  case llvm::Instruction::Trunc:
+    return LLVM::TruncOp::getOperationName();
+  case llvm::Instruction::SIToFP:
+    return LLVM::SIToFPOp::getOperationName();
+  case llvm::Instruction::UIToFP:
+    return LLVM::UIToFPOp::getOperationName();
+  case llvm::Instruction::FPToSI:
+    return LLVM::FPToSIOp::getOperationName();
+  case llvm::Instruction::FPToUI:
+    return LLVM::FPToUIOp::getOperationName();
+  case llvm::Instruction::FPExt:
+    return LLVM::FPExtOp::getOperationName();
+  case llvm::Instruction::FPTrunc:
+    return LLVM::FPTruncOp::getOperationName();
+  case llvm::Instruction::PtrToInt:
+    return LLVM::PtrToIntOp::getOperationName();
+  case llvm::Instruction::IntToPtr:
+    return LLVM::IntToPtrOp::getOperationName();
+  case llvm::Instruction::Alloca:
+    return LLVM::AllocaOp::getOperationName();
+  case llvm::Instruction::GetElementPtr:
+    return LLVM::GEPOp::getOperationName();
+  case llvm::Instruction::Load:
+    return LLVM::LoadOp::getOperationName();
+  case llvm::Instruction::Store:
+    return LLVM::StoreOp::getOperationName();
+  case llvm::Instruction::ExtractElement:
+    return LLVM::ExtractElementOp::getOperationName();
+  case llvm::Instruction::InsertElement:
+    return LLVM::InsertElementOp::getOperationName();
+  case llvm::Instruction::ShuffleVector:
+    return LLVM::ShuffleVectorOp::getOperationName();
+  case llvm::Instruction::ExtractValue:
+    return LLVM::ExtractValueOp::getOperationName();
+  case llvm::Instruction::InsertValue:
+    return LLVM::InsertValueOp::getOperationName();
+  case llvm::Instruction::Select:
+    return LLVM::SelectOp::getOperationName();
+  case llvm::Instruction::ICmp:
+    return LLVM::ICmpOp::getOperationName();
+  case llvm::Instruction::Call:
+    return LLVM::CallOp::getOperationName();
+  default:
+    return "";
+  }
+}
+
+// Get the attribute listing the integer `positions`.
+template <typename T>
+static ArrayAttr getPositionAttr(Builder &builder, ArrayRef<T> positions) {
+  SmallVector<Attribute, 4> attrs;
+  attrs.reserve(positions.size());
+  for (T position : positions)
+    attrs.push_back(builder.getI64IntegerAttr(position));
+  return builder.getArrayAttr(attrs);
+}
+
+// Import the instruction `inst` with `b`.  The PHI nodes were already imported
+// as block arguments, and the debug information intrinsics are dropped.
+LogicalResult Importer::importInstruction(FuncBuilder &b,
+                                          llvm::Instruction &inst) {
+  auto loc = getLocation(inst);
+  if (isa<llvm::PHINode>(inst) || isa<llvm::DbgInfoIntrinsic>(inst))
+    return success();
+
+  // Emit terminators, passing the values of the PHI nodes of the successors
+  // as branch operands.
+  if (auto *br = dyn_cast<llvm::BranchInst>(&inst)) {
+    OperationState state(context, loc,
+                         br->isConditional()
+                             ? LLVM::CondBrOp::getOperationName()
+                             : LLVM::BrOp::getOperationName());
+    if (br->isConditional()) {
+      Value *condition = importValue(b, br->getCondition(), loc);
+      if (!condition)
+        return failure();
+      state.addOperands(condition);
+    }
+    for (llvm::BasicBlock *successor : br->successors()) {
+      SmallVector<Value *, 4> operands;
+      if (failed(importBranchOperands(b, inst.getParent(), successor, loc,
+                                      operands)))
+        return failure();
+      state.addSuccessor(blockMapping[successor], operands);
+    }
+    b.createOperation(state);
+    return success();
+  }
+  if (auto *ret = dyn_cast<llvm::ReturnInst>(&inst)) {
+    SmallVector<Value *, 1> operands;
+    if (auto *value = ret->getReturnValue()) {
+      Value *imported = importValue(b, value, loc);
+      if (!imported)
+        return failure();
+      operands.push_back(imported);
+    }
+    b.create<LLVM::ReturnOp>(loc, operands, ArrayRef<Block *>{},
+                             ArrayRef<ArrayRef<Value *>>{},
+                             ArrayRef<NamedAttribute>{});
+    return success();
+  }
+
+  StringRef name = getOperationName(inst.getOpcode());
+  if (name.empty())
+    return emitUnsupported(loc, inst, "instruction");
+
+  OperationState state(context, loc, name);
+  SmallVector<llvm::Value *, 4> llvmOperands(inst.value_op_begin(),
+                                             inst.value_op_end());
+  if (auto *load = dyn_cast<llvm::LoadInst>(&inst)) {
+    if (load->isVolatile() || load->isAtomic())
+      return emitUnsupported(loc, inst, "instruction");
+    if (load->getAlignment())
+      state.addAttribute("alignment",
+                         builder.getI64IntegerAttr(load->getAlignment()));
+  } else if (auto *store = dyn_cast<llvm::StoreInst>(&inst)) {
+    if (store->isVolatile() || store->isAtomic())
+      return emitUnsupported(loc, inst, "instruction");
+    if (store->getAlignment())
+      state.addAttribute("alignment",
+                         builder.getI64IntegerAttr(store->getAlignment()));
+  } else if (auto *gep = dyn_cast<llvm::GetElementPtrInst>(&inst)) {
+    if (gep->isInBounds())
+      state.addAttribute("inbounds", builder.getBoolAttr(true));
+  } else if (auto *cmp = dyn_cast<llvm::ICmpInst>(&inst)) {
+    auto predicate = getCmpIPredicate(cmp->getPredicate());
+    state.addAttribute("predicate", builder.getI64IntegerAttr(
+                                        static_cast<int64_t>(predicate)));
+  } else if (auto *shuffle = dyn_cast<llvm::ShuffleVectorInst>(&inst)) {
+    // The undefined elements of the mask take the first element.
+    SmallVector<int64_t, 8> mask;
+    for (int position : shuffle->getShuffleMask())
+      mask.push_back(position < 0 ? 0 : position);
+    state.addAttribute("mask", getPositionAttr<int64_t>(builder, mask));
+    llvmOperands.resize(2);
+  } else if (auto *extract = dyn_cast<llvm::ExtractValueInst>(&inst)) {
+    state.addAttribute("position",
+                       getPositionAttr(builder, extract->getIndices()));
+  } else if (auto *insert = dyn_cast<llvm::InsertValueInst>(&inst)) {
+    state.addAttribute("position",
+                       getPositionAttr(builder, insert->getIndices()));
+  } else if (auto *call = dyn_cast<llvm::CallInst>(&inst)) {
+    // Direct calls reference the callee by name; indirect calls take it as
+    // first operand.
+    if (call->isInlineAsm())
+      return emitUnsupported(loc, inst, "instruction");
+    llvmOperands.assign(call->arg_begin(), call->arg_end());
+    if (auto *callee = call->getCalledFunction())
+      state.addAttribute("callee",
+                         builder.getFunctionAttr(functionMapping[callee]));
+    else
+      llvmOperands.insert(llvmOperands.begin(), call->getCalledValue());
+  }
+
+  if (isa<llvm::FPMathOperator>(inst) && inst.getFastMathFlags().any())
+    state.addAttribute("fastmath",
+                       getFastMathAttr(builder, inst.getFastMathFlags()));
+
+  SmallVector<Value *, 4> operands;
+  if (failed(importOperands(b, llvmOperands, loc, operands)))
+    return failure();
+  state.addOperands(operands);
+  if (!inst.getType()->isVoidTy())
+    state.addTypes(getType(inst.getType()));
+  Operation *op = b.createOperation(state);
+  if (op->getNumResults() != 0)
+    valueMapping[&inst] = op->getResult(0);
+  return success();
+}
+
+// Declare the function `f` with the same name and type in the imported module.
+LogicalResult Importer::declareFunction(llvm::Function &f) {
+  auto *functionType = f.getFunctionType();
+  if (functionType->isVarArg()) {
+    context->emitError(unknownLoc,
+                       "unsupported variadic function: " + f.getName());
+    return failure();
+  }
+
+  SmallVector<Type, 8> argTypes;
+  argTypes.reserve(functionType->getNumParams());
+  for (llvm::Type *type : functionType->params())
+    argTypes.push_back(getType(type));
+  SmallVector<Type, 1> resultTypes;
+  if (!functionType->getReturnType()->isVoidTy())
+    resultTypes.push_back(getType(functionType->getReturnType()));
+
+  auto *function = new Function(unknownLoc, f.getName(),
+                                builder.getFunctionType(argTypes, resultTypes));
+  module.getFunctions().push_back(function);
+  functionMapping[&f] = function;
+  return success();
+}
+
+// Import the body of `f`.  The basic blocks are imported in reverse post-order,
+// so that the values are defined before they are used other than by PHI
+// nodes, which become block arguments.  The unreachable blocks are dropped.
+LogicalResult Importer::importFunctionBody(llvm::Function &f) {
+  Function *function = functionMapping[&f];
+  valueMapping.clear();
+  blockMapping.clear();
+
+  function->addEntryBlock();
+  Block *entryBlock = &function->front();
+  for (auto &arg : f.args())
+    valueMapping[&arg] = entryBlock->getArgument(arg.getArgNo());
+
+  llvm::ReversePostOrderTraversal<llvm::Function *> traversal(&f);
+  for (llvm::BasicBlock *bb : traversal) {
+    if (bb == &f.getEntryBlock()) {
+      blockMapping[bb] = entryBlock;
+      continue;
+    }
+    auto *block = new Block();
+    function->push_back(block);
+    blockMapping[bb] = block;
+    for (auto &phi : bb->phis())
+      valueMapping[&phi] = block->addArgument(getType(phi.getType()));
+  }
+
+  for (llvm::BasicBlock *bb : traversal) {
+    FuncBuilder b(blockMapping[bb]);
+    for (auto &inst : *bb)
+      if (failed(importInstruction(b, inst)))
+        return failure();
+  }
+  return success();
+}
+
+std::unique_ptr<Module> mlir::convertLLVMIRToModule(llvm::Module &llvmModule,
+                                                    MLIRContext *context) {
+  auto *dialect = static_cast<LLVM::LLVMDialect *>(
+      context->getRegisteredDialect("llvm"));
+  auto unknownLoc = FileLineColLoc::get(
+      UniquedFilename::get(llvmModule.getModuleIdentifier(), context), 0, 0,
+      context);
+  if (!dialect)
+    return context->emitError(unknownLoc, "LLVM IR dialect is not registered"),
+           nullptr;
+  if (&llvmModule.getContext() != &dialect->getLLVMContext())
+    return context->emitError(unknownLoc, "LLVM IR module must live in the "
+                                          "LLVM context of the dialect"),
+           nullptr;
+  if (!llvmModule.global_empty())
+    return context->emitError(unknownLoc,
+                              "global variables are not supported"),
+           nullptr;
+
+  auto module = llvm::make_unique<Module>(context);
+  Importer importer(*module, unknownLoc);
+  for (auto &f : llvmModule)
+    if (!f.getName().startswith("llvm.dbg.") &&
+        failed(importer.declareFunction(f)))
+      return nullptr;
+  for (auto &f : llvmModule)
+    if (!f.isDeclaration() && failed(importer.importFunctionBody(f)))
+      return nullptr;
+  return module;
+}
+
+std::unique_ptr<Module> mlir::parseLLVMIRToModule(llvm::MemoryBufferRef buffer,
+                                                  MLIRContext *context) {
+  auto *dialect = static_cast<LLVM::LLVMDialect *>(
+      context->getRegisteredDialect("llvm"));
+  auto unknownLoc = FileLineColLoc::get(
+      UniquedFilename::get(buffer.getBufferIdentifier(), context), 0, 0,
+      context);
+  if (!dialect)
+    return context->emitError(unknownLoc, "LLVM IR dialect is not registered"),
+           nullptr;
+
+  // The types of the parsed module are created in the LLVM context of the
+  // dialect, which is shared with the passes and translations running
+  // concurrently.
+  llvm::sys::SmartScopedLock<true> lock(dialect->getLLVMContextMutex());
+  llvm::SMDiagnostic error;
+  auto llvmModule = llvm::parseIR(buffer, error, dialect->getLLVMContext());
+  if (!llvmModule) {
+    auto loc = FileLineColLoc::get(
+        UniquedFilename::get(error.getFilename(), context), error.getLineNo(),
+        error.getColumnNo(), context);
+    return context->emitError(loc, error.getMessage()), nullptr;
+  }
+  return convertLLVMIRToModule(*llvmModule, context);
+}
+
+static TranslateToMLIRRegistration registration(
+    "import-llvm",
+    [](llvm::StringRef inputFilename,
+       MLIRContext *context) -> std::unique_ptr<Module> {
+      auto file = openInputFile(inputFilename);
+      if (!file)
+        return nullptr;
+      return parseLLVMIRToModule(file->getMemBufferRef(), context);
+    });
@@ -20,23 +20,34 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Module.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/LLVMIR/LLVMDialect.h"
 #include "mlir/StandardOps/Ops.h"
 #include "mlir/Support/FileUtilities.h"
 #include "mlir/Support/LLVM.h"
+#include "mlir/Target/LLVMIR.h"
 #include "mlir/Translation.h"
 
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 
+#include <atomic>
+#include <mutex>
+
 using namespace mlir;
 
 namespace {
@@ -49,15 +60,29 @@ class ModuleTranslation {
 public:
   // Translate the given MLIR module expressed in MLIR LLVM IR dialect into an
   // LLVM IR module.  The MLIR LLVM IR dialect holds a pointer to an
-  // LLVMContext, the LLVM IR module will be created in that context.
-  static std::unique_ptr<llvm::Module> translateModule(Module &m);
+  // LLVMContext, the LLVM IR module will be created in that context unless
+  // `llvmContext` is provided, in which case the types of the dialect are
+  // recreated in `llvmContext`.  If `definedFunctions` is not empty, only the
+  // bodies of those functions are translated, and all of the other functions
+  // are only declared.  If `consume` is set, the body of each function is
+  // erased from `m` once it is translated, so that the MLIR and the LLVM IR of
+  // a function are never both held for the whole module.
+  static std::unique_ptr<llvm::Module>
+  translateModule(Module &m, ArrayRef<Function *> definedFunctions = {},
+                  llvm::LLVMContext *llvmContext = nullptr,
+                  bool consume = false);
 
 private:
   explicit ModuleTranslation(Module &module) : mlirModule(module) {}
 
+  llvm::FunctionType *convertFunctionType(FunctionType type, Location loc);
+  llvm::Type *convertType(LLVM::LLVMType type);
+  llvm::Type *remapType(llvm::Type *type);
+
   bool convertFunctions();
   bool convertOneFunction(Function &func);
   void connectPHINodes(Function &func);
+  void emitLoopMetadata(Function &func);
   bool convertBlock(Block &bb, bool ignoreArguments);
   bool convertOperation(Operation &op, llvm::IRBuilder<> &builder);
 
@@ -71,6 +96,16 @@ private:
   Module &mlirModule;
   std::unique_ptr<llvm::Module> llvmModule;
 
+  // If not empty, the only functions whose bodies are translated.
+  ArrayRef<Function *> definedFunctions;
+
+  // Whether the bodies of the functions are erased once translated.
+  bool consume = false;
+
+  // Mapping from the types of the dialect to the types of the LLVM context of
+  // the translated module, when it isn't the context of the dialect.
+  llvm::DenseMap<llvm::Type *, llvm::Type *> typeMapping;
+
   // Mappings between original and translated values, used for lookups.
   llvm::DenseMap<Function *, llvm::Function *> functionMapping;
   llvm::DenseMap<Value *, llvm::Value *> valueMapping;
@@ -78,12 +113,87 @@ private:
 };
 } // end anonymous namespace
 
+// Get the LLVM IR type wrapped by the MLIR LLVM IR dialect type `type` in the
+// context of the translated module.
+llvm::Type *ModuleTranslation::convertType(LLVM::LLVMType type) {
+  llvm::Type *llvmType = type.getUnderlyingType();
+  if (&llvmType->getContext() == &llvmModule->getContext())
+    return llvmType;
+  return remapType(llvmType);
+}
+
+// Recreate the LLVM IR type `type` of the context of the dialect in the context
+// of the translated module.  The types of the dialect are not modified while
+// they are read: this doesn't require holding the mutex of the dialect.
+llvm::Type *ModuleTranslation::remapType(llvm::Type *type) {
+  auto it = typeMapping.find(type);
+  if (it != typeMapping.end())
+    return it->second;
+
+  llvm::LLVMContext &llvmContext = llvmModule->getContext();
+  auto remapTypes = [this](ArrayRef<llvm::Type *> types) {
+    SmallVector<llvm::Type *, 8> remapped;
+    remapped.reserve(types.size());
+    for (llvm::Type *type : types)
+      remapped.push_back(remapType(type));
+    return remapped;
+  };
+
+  llvm::Type *remapped;
+  switch (type->getTypeID()) {
+  case llvm::Type::IntegerTyID:
+    remapped = llvm::IntegerType::get(llvmContext, type->getIntegerBitWidth());
+    break;
+  case llvm::Type::FunctionTyID: {
+    auto *funcType = cast<llvm::FunctionType>(type);
+    remapped = llvm::FunctionType::get(remapType(funcType->getReturnType()),
+                                       remapTypes(funcType->params()),
+                                       funcType->isVarArg());
+    break;
+  }
+  case llvm::Type::StructTyID: {
+    auto *structType = cast<llvm::StructType>(type);
+    if (structType->isLiteral()) {
+      remapped = llvm::StructType::get(
+          llvmContext, remapTypes(structType->elements()),
+          structType->isPacked());
+      break;
+    }
+    // Identified structures may be recursive: map them before their body.
+    auto *identified =
+        llvm::StructType::create(llvmContext, structType->getName());
+    typeMapping[type] = identified;
+    if (!structType->isOpaque())
+      identified->setBody(remapTypes(structType->elements()),
+                          structType->isPacked());
+    return identified;
+  }
+  case llvm::Type::ArrayTyID:
+    remapped = llvm::ArrayType::get(remapType(type->getArrayElementType()),
+                                    type->getArrayNumElements());
+    break;
+  case llvm::Type::VectorTyID:
+    remapped = llvm::VectorType::get(remapType(type->getVectorElementType()),
+                                     type->getVectorNumElements());
+    break;
+  case llvm::Type::PointerTyID:
+    remapped = llvm::PointerType::get(
+        remapType(type->getPointerElementType()),
+        type->getPointerAddressSpace());
+    break;
+  default:
+    remapped = llvm::Type::getPrimitiveType(llvmContext, type->getTypeID());
+    break;
+  }
+  typeMapping[type] = remapped;
+  return remapped;
+}
+
 // Convert an MLIR function type to LLVM IR.  Arguments of the function must of
 // MLIR LLVM IR dialect types.  Use `loc` as a location when reporting errors.
 // Return nullptr on errors.
-static llvm::FunctionType *convertFunctionType(llvm::LLVMContext &llvmContext,
-                                               FunctionType type,
-                                               Location loc) {
+llvm::FunctionType *ModuleTranslation::convertFunctionType(FunctionType type,
+                                                           Location loc) {
   assert(type && "expected non-null type");
 
   auto context = type.getContext();
@@ -99,25 +209,56 @@ static llvm::FunctionType *convertFunctionType(llvm::LLVMContext &llvmContext,
     if (!wrappedLLVMType)
       return context->emitError(loc, "non-LLVM function argument type"),
              nullptr;
-    argTypes.push_back(wrappedLLVMType.getUnderlyingType());
+    argTypes.push_back(convertType(wrappedLLVMType));
   }
 
   if (type.getNumResults() == 0)
-    return llvm::FunctionType::get(llvm::Type::getVoidTy(llvmContext), argTypes,
-                                   /*isVarArg=*/false);
+    return llvm::FunctionType::get(
+        llvm::Type::getVoidTy(llvmModule->getContext()), argTypes,
+        /*isVarArg=*/false);
 
   auto wrappedResultType = type.getResult(0).dyn_cast<LLVM::LLVMType>();
   if (!wrappedResultType)
     return context->emitError(loc, "non-LLVM function result"), nullptr;
 
-  return llvm::FunctionType::get(wrappedResultType.getUnderlyingType(),
-                                 argTypes, /*isVarArg=*/false);
+  return llvm::FunctionType::get(convertType(wrappedResultType), argTypes,
+                                 /*isVarArg=*/false);
+}
+
+// Create an LLVM IR constant data vector holding the raw data of `attr`, whose
+// elements are stored as values of the C++ type `T`.
+template <typename T>
+static llvm::Constant *getConstantDataVector(llvm::LLVMContext &llvmContext,
+                                             DenseElementsAttr attr) {
+  ArrayRef<T> values(reinterpret_cast<const T *>(attr.getRawData().data()),
+                     attr.getNumElements());
+  return llvm::ConstantDataVector::get(llvmContext, values);
+}
+
+// Create an LLVM IR constant data vector holding the raw data of `attr` as is,
+// if its elements are stored as C++ values LLVM IR constant data may hold.
+// Return nullptr otherwise.
+static llvm::Constant *getConstantDataVector(llvm::LLVMContext &llvmContext,
+                                             DenseElementsAttr attr) {
+  if (attr.isStoredAs<uint8_t>())
+    return getConstantDataVector<uint8_t>(llvmContext, attr);
+  if (attr.isStoredAs<uint16_t>())
+    return getConstantDataVector<uint16_t>(llvmContext, attr);
+  if (attr.isStoredAs<uint32_t>())
+    return getConstantDataVector<uint32_t>(llvmContext, attr);
+  if (attr.isStoredAs<uint64_t>())
+    return getConstantDataVector<uint64_t>(llvmContext, attr);
+  if (attr.isStoredAs<float>())
+    return getConstantDataVector<float>(llvmContext, attr);
+  if (attr.isStoredAs<double>())
+    return getConstantDataVector<double>(llvmContext, attr);
+  return nullptr;
 }
 
 // Create an LLVM IR constant of `llvmType` from the MLIR attribute `attr`.
-// This currently supports integer, floating point, splat and dense element
-// attributes and combinations thereof.  In case of error, report it to `loc`
-// and return nullptr.
+// This currently supports integer, floating point, splat, dense and sparse
+// element attributes and combinations thereof.  In case of error, report it to
+// `loc` and return nullptr.
 llvm::Constant *ModuleTranslation::getLLVMConstant(llvm::Type *llvmType,
                                                    Attribute attr,
                                                    Location loc) {
@@ -135,16 +276,58 @@ llvm::Constant *ModuleTranslation::getLLVMConstant(llvm::Type *llvmType,
   }
   if (auto denseAttr = attr.dyn_cast<DenseElementsAttr>()) {
     auto *vectorType = cast<llvm::VectorType>(llvmType);
-    SmallVector<llvm::Constant *, 8> constants;
+    auto *elementType = vectorType->getElementType();
     uint64_t numElements = vectorType->getNumElements();
+    if (denseAttr.isSplat()) {
+      llvm::Constant *child;
+      if (auto intAttr = denseAttr.dyn_cast<DenseIntElementsAttr>())
+        child = llvm::ConstantInt::get(elementType,
+                                       *intAttr.getIntValues().begin());
+      else
+        child = llvm::ConstantFP::get(elementType,
+                                      *denseAttr.getFloatValues().begin());
+      return llvm::ConstantVector::getSplat(numElements, child);
+    }
+
+    // The elements stored as C++ values are copied at once from the raw data,
+    // which may be held in a mapped file, rather than one at a time. BF16
+    // elements are stored as doubles, which isn't their LLVM IR type.
+    auto *dataVector = getConstantDataVector(llvmType->getContext(), denseAttr);
+    if (dataVector && dataVector->getType() == llvmType)
+      return dataVector;
+
+    // Otherwise, read the elements from the raw data rather than materializing
+    // them as attributes uniqued in the context.
+    SmallVector<llvm::Constant *, 8> constants;
     constants.reserve(numElements);
-    SmallVector<Attribute, 8> nested;
-    denseAttr.getValues(nested);
-    for (auto n : nested) {
-      constants.push_back(
-          getLLVMConstant(vectorType->getElementType(), n, loc));
-      if (!constants.back())
-        return nullptr;
+    if (auto intAttr = denseAttr.dyn_cast<DenseIntElementsAttr>()) {
+      for (auto value : intAttr.getIntValues())
+        constants.push_back(llvm::ConstantInt::get(elementType, value));
+    } else {
+      for (auto value : denseAttr.getFloatValues())
+        constants.push_back(llvm::ConstantFP::get(elementType, value));
+    }
+    return llvm::ConstantVector::get(constants);
+  }
+  if (auto sparseAttr = attr.dyn_cast<SparseElementsAttr>()) {
+    // LLVM IR vector constants are dense: start from zeros and place each
+    // stored value at its offset, without materializing the implicit zeros
+    // as attributes through the indices of every element.
+    auto *vectorType = cast<llvm::VectorType>(llvmType);
+    auto *elementType = vectorType->getElementType();
+    SmallVector<llvm::Constant *, 8> constants(
+        vectorType->getNumElements(),
+        llvm::Constant::getNullValue(elementType));
+    SmallVector<uint64_t, 8> offsets;
+    sparseAttr.getLinearIndices(offsets);
+    auto values = sparseAttr.getValues();
+    auto offsetIt = offsets.begin();
+    if (auto intAttr = values.dyn_cast<DenseIntElementsAttr>()) {
+      for (auto value : intAttr.getIntValues())
+        constants[*offsetIt++] = llvm::ConstantInt::get(elementType, value);
+    } else {
+      for (auto value : values.getFloatValues())
+        constants[*offsetIt++] = llvm::ConstantFP::get(elementType, value);
     }
     return llvm::ConstantVector::get(constants);
   }
@@ -191,6 +374,44 @@ SmallVector<llvm::Value *, 8> ModuleTranslation::lookupValues(Range &&values) {
   return remapped;
 }
 
+// Get the fast-math flags listed in the "fastmath" attribute of `op` into
+// `flags`, which are left unset if there is no such attribute.
+static bool getFastMathFlags(Operation &op, llvm::FastMathFlags &flags) {
+  auto attr = op.getAttr("fastmath");
+  if (!attr)
+    return false;
+  auto names = attr.dyn_cast<ArrayAttr>();
+  if (!names) {
+    op.emitError("expected 'fastmath' to be an array of strings");
+    return true;
+  }
+  for (Attribute name : names) {
+    auto flag = name.dyn_cast<StringAttr>();
+    StringRef flagName = flag ? flag.getValue() : "";
+    if (flagName == "nnan")
+      flags.setNoNaNs();
+    else if (flagName == "ninf")
+      flags.setNoInfs();
+    else if (flagName == "nsz")
+      flags.setNoSignedZeros();
+    else if (flagName == "arcp")
+      flags.setAllowReciprocal();
+    else if (flagName == "contract")
+      flags.setAllowContract(true);
+    else if (flagName == "afn")
+      flags.setApproxFunc();
+    else if (flagName == "reassoc")
+      flags.setAllowReassoc();
+    else if (flagName == "fast")
+      flags.setFast();
+    else {
+      op.emitError("unknown fast-math flag in 'fastmath'");
+      return true;
+    }
+  }
+  return false;
+}
+
 // Given a single MLIR operation, create the corresponding LLVM IR operation
 // using the `builder`.  LLVM IR Builder does not have a generic interface so
 // this has to be a long chain of `if`s calling different functions with a
@@ -276,14 +497,20 @@ bool ModuleTranslation::convertBlock(Block &bb, bool ignoreArguments) {
             bb.front().getLoc(), "block argument does not have an LLVM type");
         return true;
       }
-      llvm::Type *type = wrappedType.getUnderlyingType();
+      llvm::Type *type = convertType(wrappedType);
       llvm::PHINode *phi = builder.CreatePHI(type, numPredecessors);
       valueMapping[arg] = phi;
     }
   }
 
-  // Traverse operations.
+  // Traverse operations.  The fast-math flags of an operation apply to the
+  // floating point instructions created for it.
   for (auto &op : bb) {
+    llvm::IRBuilder<>::FastMathFlagGuard fastMathGuard(builder);
+    llvm::FastMathFlags flags;
+    if (getFastMathFlags(op, flags))
+      return true;
+    builder.setFastMathFlags(flags);
     if (convertOperation(op, builder))
       return true;
   }
@@ -336,6 +563,99 @@ void ModuleTranslation::connectPHINodes(Function &func) {
   }
 }
 
+// Collect the blocks of the natural loop formed by the back-edge from `latch`
+// to `header`, that is the header and the blocks that reach the latch without
+// going through the header.
+static llvm::SetVector<Block *> getLoopBlocks(Block *header, Block *latch) {
+  llvm::SetVector<Block *> loopBlocks;
+  loopBlocks.insert(header);
+  SmallVector<Block *, 8> worklist;
+  if (loopBlocks.insert(latch))
+    worklist.push_back(latch);
+  while (!worklist.empty()) {
+    Block *block = worklist.pop_back_val();
+    for (Block *pred : block->getPredecessors())
+      if (loopBlocks.insert(pred))
+        worklist.push_back(pred);
+  }
+  return loopBlocks;
+}
+
+// Translate the loop hint attributes of the LLVM::BrOp back-edges of `func` to
+// "llvm.loop" metadata on the corresponding branch instructions:
+//   - "llvm.loop.parallel: true" creates an access group for the loop and tags
+//     every memory access in the loop with it, so that the loop can be
+//     reported as having "llvm.loop.parallel_accesses";
+//   - "llvm.loop.vectorize.width: N" requests vectorization with width N;
+//   - "llvm.loop.unroll.disable: true" disables unrolling of the loop.
+// The successor of an annotated branch is expected to be the loop header.
+void ModuleTranslation::emitLoopMetadata(Function &func) {
+  llvm::LLVMContext &llvmContext = llvmModule->getContext();
+  auto getProperty = [&](StringRef name, ArrayRef<llvm::Metadata *> operands)
+      -> llvm::MDNode * {
+    SmallVector<llvm::Metadata *, 2> elements;
+    elements.push_back(llvm::MDString::get(llvmContext, name));
+    elements.append(operands.begin(), operands.end());
+    return llvm::MDNode::get(llvmContext, elements);
+  };
+  auto getInt32 = [&](int64_t value) -> llvm::Metadata * {
+    return llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
+        llvm::Type::getInt32Ty(llvmContext), value));
+  };
+
+  // Access groups of each memory access, an access of a loop nest belongs to
+  // the groups of all of the parallel loops around it.
+  llvm::MapVector<llvm::Instruction *, SmallVector<llvm::Metadata *, 2>>
+      accessGroups;
+
+  for (Block &bb : func) {
+    auto brOp = bb.getTerminator()->dyn_cast<LLVM::BrOp>();
+    if (!brOp)
+      continue;
+    SmallVector<llvm::Metadata *, 4> properties;
+    // Reserve the first operand for the self-reference of the loop identifier.
+    properties.push_back(nullptr);
+
+    auto parallel = brOp.getAttrOfType<BoolAttr>("llvm.loop.parallel");
+    if (parallel && parallel.getValue()) {
+      llvm::MDNode *accessGroup = llvm::MDNode::getDistinct(llvmContext, {});
+      for (Block *loopBlock : getLoopBlocks(brOp.getSuccessor(0), &bb))
+        for (llvm::Instruction &inst : *blockMapping.lookup(loopBlock))
+          if (inst.mayReadOrWriteMemory())
+            accessGroups[&inst].push_back(accessGroup);
+      properties.push_back(
+          getProperty("llvm.loop.parallel_accesses", accessGroup));
+    }
+    if (auto width =
+            brOp.getAttrOfType<IntegerAttr>("llvm.loop.vectorize.width")) {
+      properties.push_back(getProperty("llvm.loop.vectorize.width",
+                                       getInt32(width.getInt())));
+      properties.push_back(
+          getProperty("llvm.loop.vectorize.enable",
+                      llvm::ConstantAsMetadata::get(
+                          llvm::ConstantInt::getTrue(llvmContext))));
+    }
+    auto noUnroll = brOp.getAttrOfType<BoolAttr>("llvm.loop.unroll.disable");
+    if (noUnroll && noUnroll.getValue())
+      properties.push_back(getProperty("llvm.loop.unroll.disable", {}));
+
+    if (properties.size() == 1)
+      continue;
+    llvm::MDNode *loopID = llvm::MDNode::getDistinct(llvmContext, properties);
+    loopID->replaceOperandWith(0, loopID);
+    blockMapping.lookup(&bb)->getTerminator()->setMetadata(
+        llvm::LLVMContext::MD_loop, loopID);
+  }
+
+  for (auto &access : accessGroups) {
+    ArrayRef<llvm::Metadata *> groups = access.second;
+    access.first->setMetadata(
+        llvm::LLVMContext::MD_access_group,
+        groups.size() == 1 ? cast<llvm::MDNode>(groups.front())
+                           : llvm::MDNode::get(llvmContext, groups));
+  }
+}
+
 // TODO(mlir-team): implement an iterative version
 static void topologicalSortImpl(llvm::SetVector<Block *> &blocks, Block *b) {
   blocks.insert(b);
@@ -367,23 +687,43 @@ bool ModuleTranslation::convertOneFunction(Function &func) {
   valueMapping.clear();
   llvm::Function *llvmFunc = functionMapping.lookup(&func);
   // Add function arguments to the value remapping table.
-  // If there was noalias info then we decorate each argument accordingly.
+  // If there was noalias, alignment or dereferenceability info then we
+  // decorate each argument accordingly.
   unsigned int argIdx = 0;
   for (const auto &kvp : llvm::zip(func.getArguments(), llvmFunc->args())) {
     llvm::Argument &llvmArg = std::get<1>(kvp);
     BlockArgument *mlirArg = std::get<0>(kvp);
 
+    // NB: Attributes are already verified to be of the right kind, so check if
+    // we can indeed attach them to this argument, based on its type.
+    auto argTy = mlirArg->getType().dyn_cast<LLVM::LLVMType>();
+    auto checkPointerArg = [&](StringRef attrName) {
+      if (argTy.getUnderlyingType()->isPointerTy())
+        return false;
+      return argTy.getContext()->emitError(
+          func.getLoc(),
+          attrName + " attribute attached to LLVM non-pointer argument");
+    };
+
     if (auto attr = func.getArgAttrOfType<BoolAttr>(argIdx, "llvm.noalias")) {
-      // NB: Attribute already verified to be boolean, so check if we can indeed
-      // attach the attribute to this argument, based on its type.
-      auto argTy = mlirArg->getType().dyn_cast<LLVM::LLVMType>();
-      if (!argTy.getUnderlyingType()->isPointerTy())
-        return argTy.getContext()->emitError(
-            func.getLoc(),
-            "llvm.noalias attribute attached to LLVM non-pointer argument");
+      if (checkPointerArg("llvm.noalias"))
+        return true;
       if (attr.getValue())
         llvmArg.addAttr(llvm::Attribute::AttrKind::NoAlias);
     }
+    if (auto attr = func.getArgAttrOfType<IntegerAttr>(argIdx, "llvm.align")) {
+      if (checkPointerArg("llvm.align"))
+        return true;
+      llvmArg.addAttr(llvm::Attribute::getWithAlignment(
+          llvmFunc->getContext(), attr.getInt()));
+    }
+    if (auto attr = func.getArgAttrOfType<IntegerAttr>(
+            argIdx, "llvm.dereferenceable")) {
+      if (checkPointerArg("llvm.dereferenceable"))
+        return true;
+      llvmArg.addAttr(llvm::Attribute::getWithDereferenceableBytes(
+          llvmFunc->getContext(), attr.getInt()));
+    }
     valueMapping[mlirArg] = &llvmArg;
     argIdx++;
   }
@@ -406,8 +746,10 @@ bool ModuleTranslation::convertOneFunction(Function &func) {
   }
 
   // Finally, after all blocks have been traversed and values mapped, connect
-  // the PHI nodes to the results of preceding blocks.
+  // the PHI nodes to the results of preceding blocks, and attach the loop hints
+  // to the back-edges.
   connectPHINodes(func);
+  emitLoopMetadata(func);
   return false;
 }
 
@@ -416,8 +758,8 @@ bool ModuleTranslation::convertFunctions() {
   // call graph with cycles.
   for (Function &function : mlirModule) {
     Function *functionPtr = &function;
-    llvm::FunctionType *functionType = convertFunctionType(
-        llvmModule->getContext(), function.getType(), function.getLoc());
+    llvm::FunctionType *functionType =
+        convertFunctionType(function.getType(), function.getLoc());
     if (!functionType)
       return true;
     llvm::FunctionCallee llvmFuncCst =
@@ -427,31 +769,57 @@ bool ModuleTranslation::convertFunctions() {
         cast<llvm::Function>(llvmFuncCst.getCallee());
   }
 
-  // Convert functions.
+  // Convert functions, ignoring the external ones.
+  if (!definedFunctions.empty()) {
+    for (Function *function : definedFunctions)
+      if (!function->isExternal() && convertOneFunction(*function))
+        return true;
+    return false;
+  }
   for (Function &function : mlirModule) {
-    // Ignore external functions.
     if (function.isExternal())
       continue;
 
     if (convertOneFunction(function))
       return true;
+    if (consume)
+      function.eraseBody();
   }
 
   return false;
 }
 
-std::unique_ptr<llvm::Module> ModuleTranslation::translateModule(Module &m) {
+std::unique_ptr<llvm::Module>
+ModuleTranslation::translateModule(Module &m,
+                                   ArrayRef<Function *> definedFunctions,
+                                   llvm::LLVMContext *llvmContext,
+                                   bool consume) {
 
   Dialect *dialect = m.getContext()->getRegisteredDialect("llvm");
   assert(dialect && "LLVM dialect must be registered");
   auto *llvmDialect = static_cast<LLVM::LLVMDialect *>(dialect);
-
-  auto llvmModule = llvm::CloneModule(llvmDialect->getLLVMModule());
+  llvm::Module &dialectModule = llvmDialect->getLLVMModule();
+
+  // A module created in the LLVM context of the dialect is cloned from the
+  // module of the dialect, and the context may be used concurrently by the
+  // passes running on other modules.  A module created in another context only
+  // inherits the data layout and the target triple of the dialect.
+  std::unique_lock<llvm::sys::SmartMutex<true>> lock(
+      llvmDialect->getLLVMContextMutex(), std::defer_lock);
+  std::unique_ptr<llvm::Module> llvmModule;
+  if (llvmContext) {
+    llvmModule = llvm::make_unique<llvm::Module>(
+        dialectModule.getModuleIdentifier(), *llvmContext);
+    llvmModule->setDataLayout(dialectModule.getDataLayout());
+    llvmModule->setTargetTriple(dialectModule.getTargetTriple());
+  } else {
+    lock.lock();
+    llvmModule = llvm::CloneModule(dialectModule);
+  }
   if (!llvmModule)
     return nullptr;
 
-  llvm::LLVMContext &llvmContext = llvmModule->getContext();
-  llvm::IRBuilder<> builder(llvmContext);
+  llvm::IRBuilder<> builder(llvmModule->getContext());
 
   // Inject declarations for `malloc` and `free` functions that can be used in
   // memref allocation/deallocation coming from standard ops lowering.
@@ -462,6 +830,8 @@ std::unique_ptr<llvm::Module> ModuleTranslation::translateModule(Module &m) {
 
   ModuleTranslation translator(m);
   translator.llvmModule = std::move(llvmModule);
+  translator.definedFunctions = definedFunctions;
+  translator.consume = consume;
   if (translator.convertFunctions())
     return nullptr;
 
@@ -472,12 +842,91 @@ std::unique_ptr<llvm::Module> translateModuleToLLVMIR(Module &m) {
   return ModuleTranslation::translateModule(m);
 }
 
+std::unique_ptr<llvm::Module> translateFunctionToLLVMIR(Function &f) {
+  Function *definedFunction = &f;
+  return ModuleTranslation::translateModule(*f.getModule(), definedFunction);
+}
+
+std::unique_ptr<llvm::Module>
+mlir::translateFunctionsToLLVMIR(Module &m, ArrayRef<Function *> functions,
+                                 llvm::LLVMContext &llvmContext) {
+  return ModuleTranslation::translateModule(m, functions, &llvmContext);
+}
+
+LogicalResult
+mlir::translateModuleToLLVMIRParts(Module &m, unsigned numParts,
+                                   std::vector<LLVMIRModulePart> &parts) {
+  // Distribute the defined functions over the parts, largest first to the part
+  // with the fewest operations so far, using the number of operations as an
+  // estimate of the translation and compilation costs.
+  std::vector<std::pair<unsigned, Function *>> costAndFunction;
+  for (Function &function : m) {
+    if (function.isExternal())
+      continue;
+    unsigned numOps = 0;
+    function.walk([&](Operation *) { ++numOps; });
+    costAndFunction.emplace_back(numOps, &function);
+  }
+  if (numParts == 0 || numParts > costAndFunction.size())
+    numParts = costAndFunction.size();
+  std::stable_sort(costAndFunction.begin(), costAndFunction.end(),
+                   [](const std::pair<unsigned, Function *> &lhs,
+                      const std::pair<unsigned, Function *> &rhs) {
+                     return lhs.first > rhs.first;
+                   });
+  std::vector<SmallVector<Function *, 4>> partFunctions(numParts);
+  std::vector<unsigned> partCosts(numParts, 0);
+  for (auto &entry : costAndFunction) {
+    auto cheapest = std::min_element(partCosts.begin(), partCosts.end());
+    unsigned part = std::distance(partCosts.begin(), cheapest);
+    partFunctions[part].push_back(entry.second);
+    partCosts[part] += entry.first;
+  }
+
+  // Translate each part in its own LLVM context, so that the parts can be
+  // translated and then compiled concurrently.  The diagnostics are kept in
+  // the order of the parts.
+  parts.clear();
+  parts.resize(numParts);
+  MLIRContext *context = m.getContext();
+  ParallelDiagnosticHandler diagHandler(*context);
+  std::atomic<bool> translationFailed(false);
+  auto indices = llvm::seq<unsigned>(0, numParts);
+  parallelForEach(context, indices.begin(), indices.end(), [&](unsigned i) {
+    diagHandler.setOrderIDForThread(i);
+    auto llvmContext = llvm::make_unique<llvm::LLVMContext>();
+    auto llvmModule = ModuleTranslation::translateModule(m, partFunctions[i],
+                                                         llvmContext.get());
+    if (!llvmModule) {
+      translationFailed = true;
+      return;
+    }
+    parts[i].context = std::move(llvmContext);
+    parts[i].module = std::move(llvmModule);
+  });
+  if (translationFailed) {
+    parts.clear();
+    return failure();
+  }
+  return success();
+}
+
+static llvm::cl::opt<bool> clConsumeInput(
+    "llvmir-consume-input",
+    llvm::cl::desc("Erase the body of each function of the input module of "
+                   "-mlir-to-llvmir once it is translated"),
+    llvm::cl::init(false));
+
 static TranslateFromMLIRRegistration registration(
     "mlir-to-llvmir", [](Module *module, llvm::StringRef outputFilename) {
       if (!module)
         return true;
 
-      auto llvmModule = ModuleTranslation::translateModule(*module);
+      // The LLVM IR module is printed straight to the output file, so
+      // consuming the input bounds the memory to about one copy of the IR.
+      auto llvmModule = ModuleTranslation::translateModule(
+          *module, /*definedFunctions=*/{}, /*llvmContext=*/nullptr,
+          clConsumeInput);
       if (!llvmModule)
         return true;
 
@@ -0,0 +1,222 @@
+//===- ConvertToNVPTX.cpp - MLIR GPU kernels to PTX conversion ------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the translation of the GPU kernels of a module in the
+// MLIR LLVM dialect to PTX assembly, through the NVPTX backend of LLVM.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Module.h"
+#include "mlir/Support/FileUtilities.h"
+#include "mlir/Target/LLVMIR.h"
+#include "mlir/Translation.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include <mutex>
+
+using namespace mlir;
+
+// Name of the attribute marking the GPU kernels, see
+// createOutlineGPUKernelsPass.
+static constexpr const char *kGPUKernelAttrName = "gpu.kernel";
+
+#ifdef MLIR_NVPTX_TARGET_ENABLED
+// The target triple of the PTX assembly.
+static constexpr const char *kNVPTXTriple = "nvptx64-nvidia-cuda";
+
+// Return the NVVM intrinsic reading the special register that the GPU runtime
+// function `name` returns on the host, or not_intrinsic if `name` isn't one of
+// the mlir_gpu_* functions returning the thread and block ids.
+static llvm::Intrinsic::ID getIdIntrinsic(StringRef name) {
+  return llvm::StringSwitch<llvm::Intrinsic::ID>(name)
+      .Case("mlir_gpu_thread_id_x", llvm::Intrinsic::nvvm_read_ptx_sreg_tid_x)
+      .Case("mlir_gpu_thread_id_y", llvm::Intrinsic::nvvm_read_ptx_sreg_tid_y)
+      .Case("mlir_gpu_thread_id_z", llvm::Intrinsic::nvvm_read_ptx_sreg_tid_z)
+      .Case("mlir_gpu_block_id_x", llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_x)
+      .Case("mlir_gpu_block_id_y", llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_y)
+      .Case("mlir_gpu_block_id_z", llvm::Intrinsic::nvvm_read_ptx_sreg_ctaid_z)
+      .Case("mlir_gpu_block_dim_x", llvm::Intrinsic::nvvm_read_ptx_sreg_ntid_x)
+      .Case("mlir_gpu_block_dim_y", llvm::Intrinsic::nvvm_read_ptx_sreg_ntid_y)
+      .Case("mlir_gpu_block_dim_z", llvm::Intrinsic::nvvm_read_ptx_sreg_ntid_z)
+      .Default(llvm::Intrinsic::not_intrinsic);
+}
+
+// Replace the calls to the mlir_gpu_* functions returning the thread and block
+// ids in `llvmModule` with reads of the corresponding special registers, and
+// erase the declarations of the functions that are not called.  Return the
+// first function that is still called, if any, which can't be called from the
+// GPU.
+static llvm::Function *lowerIdFunctions(llvm::Module &llvmModule) {
+  llvm::Function *hostFunction = nullptr;
+  for (auto it = llvmModule.begin(), e = llvmModule.end(); it != e;) {
+    llvm::Function &function = *it++;
+    if (!function.isDeclaration() || function.isIntrinsic())
+      continue;
+    llvm::Intrinsic::ID id = getIdIntrinsic(function.getName());
+    if (id != llvm::Intrinsic::not_intrinsic) {
+      llvm::Function *intrinsic =
+          llvm::Intrinsic::getDeclaration(&llvmModule, id);
+      while (!function.use_empty()) {
+        auto *call = llvm::cast<llvm::CallInst>(function.user_back());
+        llvm::IRBuilder<> builder(call);
+        llvm::Value *value = builder.CreateZExtOrTrunc(
+            builder.CreateCall(intrinsic), call->getType());
+        call->replaceAllUsesWith(value);
+        call->eraseFromParent();
+      }
+    }
+    if (function.use_empty())
+      function.eraseFromParent();
+    else if (!hostFunction)
+      hostFunction = &function;
+  }
+  return hostFunction;
+}
+
+// Get the NVPTX target machine for `gpuArch`, initializing the target the first
+// time it is requested.  Return null and set `errorMessage` if the target isn't
+// available.
+static std::unique_ptr<llvm::TargetMachine>
+createNVPTXTargetMachine(StringRef gpuArch, std::string &errorMessage) {
+  static std::once_flag initialized;
+  std::call_once(initialized, [] {
+    LLVMInitializeNVPTXTargetInfo();
+    LLVMInitializeNVPTXTarget();
+    LLVMInitializeNVPTXTargetMC();
+    LLVMInitializeNVPTXAsmPrinter();
+  });
+  const llvm::Target *target =
+      llvm::TargetRegistry::lookupTarget(kNVPTXTriple, errorMessage);
+  if (!target)
+    return nullptr;
+  return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      kNVPTXTriple, gpuArch, /*Features=*/"", llvm::TargetOptions(),
+      /*RM=*/llvm::None, /*CM=*/llvm::None, llvm::CodeGenOpt::Aggressive));
+}
+
+// Translate `kernel` to PTX assembly for `gpuArch`, in its own LLVM context.
+// In case of error, report it to the MLIR context and return failure.
+static LogicalResult translateKernelToPTX(Function &kernel, StringRef gpuArch,
+                                          std::string &ptx) {
+  MLIRContext *context = kernel.getContext();
+  llvm::LLVMContext llvmContext;
+  Function *function = &kernel;
+  auto llvmModule =
+      translateFunctionsToLLVMIR(*kernel.getModule(), function, llvmContext);
+  if (!llvmModule)
+    return failure();
+  if (llvm::Function *hostFunction = lowerIdFunctions(*llvmModule))
+    return context->emitError(kernel.getLoc(),
+                              "GPU kernel calls the host function '" +
+                                  hostFunction->getName() + "'"),
+           failure();
+
+  std::string errorMessage;
+  auto machine = createNVPTXTargetMachine(gpuArch, errorMessage);
+  if (!machine)
+    return context->emitError(kernel.getLoc(), errorMessage), failure();
+  llvmModule->setTargetTriple(kNVPTXTriple);
+  llvmModule->setDataLayout(machine->createDataLayout());
+
+  // Mark the function as a kernel, i.e. as an entry point of the PTX module.
+  llvm::Function *llvmKernel =
+      llvmModule->getFunction(kernel.getName().strref());
+  llvm::Metadata *annotation[] = {
+      llvm::ValueAsMetadata::get(llvmKernel),
+      llvm::MDString::get(llvmContext, "kernel"),
+      llvm::ValueAsMetadata::getConstant(
+          llvm::ConstantInt::get(llvm::Type::getInt32Ty(llvmContext), 1))};
+  llvmModule->getOrInsertNamedMetadata("nvvm.annotations")
+      ->addOperand(llvm::MDNode::get(llvmContext, annotation));
+
+  llvm::SmallString<0> assembly;
+  {
+    llvm::raw_svector_ostream os(assembly);
+    llvm::legacy::PassManager codegenPasses;
+    if (machine->addPassesToEmitFile(codegenPasses, os, nullptr,
+                                     llvm::TargetMachine::CGFT_AssemblyFile))
+      return context->emitError(kernel.getLoc(),
+                                "NVPTX target does not support assembly "
+                                "emission"),
+             failure();
+    codegenPasses.run(*llvmModule);
+  }
+  ptx = assembly.str();
+  return success();
+}
+#endif // MLIR_NVPTX_TARGET_ENABLED
+
+LogicalResult mlir::translateGPUKernelsToPTX(Module &module, StringRef gpuArch,
+                                             std::vector<PTXKernel> &kernels) {
+  kernels.clear();
+  for (Function &function : module) {
+    if (function.isExternal() || !function.getAttr(kGPUKernelAttrName))
+      continue;
+#ifdef MLIR_NVPTX_TARGET_ENABLED
+    PTXKernel kernel;
+    kernel.name = function.getName().strref().str();
+    if (failed(translateKernelToPTX(function, gpuArch, kernel.ptx)))
+      return failure();
+    kernels.push_back(std::move(kernel));
+#else
+    return module.getContext()->emitError(
+               function.getLoc(),
+               "cannot translate GPU kernels: LLVM was built without the "
+               "NVPTX target"),
+           failure();
+#endif // MLIR_NVPTX_TARGET_ENABLED
+  }
+  return success();
+}
+
+static llvm::cl::opt<std::string>
+    clGPUArch("ptx-gpu-arch",
+              llvm::cl::desc("GPU architecture of the PTX assembly of "
+                             "-mlir-to-ptx"),
+              llvm::cl::init("sm_35"));
+
+static TranslateFromMLIRRegistration ptxRegistration(
+    "mlir-to-ptx", [](Module *module, llvm::StringRef outputFilename) {
+      if (!module)
+        return true;
+
+      std::vector<PTXKernel> kernels;
+      if (failed(translateGPUKernelsToPTX(*module, clGPUArch, kernels)))
+        return true;
+
+      auto file = openOutputFile(outputFilename);
+      if (!file)
+        return true;
+
+      for (auto &kernel : kernels)
+        file->os() << "// kernel: " << kernel.name << '\n' << kernel.ptx;
+      file->keep();
+      return false;
+    });
@@ -0,0 +1,158 @@
+//===- AnnotateMemRefBounds.cpp - Mark the accesses proven in bounds ------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that exports the MemRefBoundsAnalysis to the
+// lowering to the LLVM IR dialect.  The loads, stores and vector transfers that
+// the analysis proves to stay within the bounds of their memref are marked
+// with an "in_bounds" attribute, from which the lowering emits inbounds GEPs
+// and unmasked vector accesses.  Optionally, the loads and stores that are not
+// proven are preceded by calls to the bounds check runtime of the
+// ExecutionEngine, which aborts the execution on an out-of-bounds index, and
+// are then marked as in bounds as well.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemRefBoundsAnalysis.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "mlir/VectorOps/VectorOps.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "annotate-memref-bounds"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<bool> clRuntimeChecks(
+    "memref-bounds-runtime-checks",
+    llvm::cl::desc("Check the indices of the accesses that are not proven in "
+                   "bounds at runtime"),
+    llvm::cl::cat(clOptionsCategory));
+
+/// Name of the attribute marking the accesses that are known to be in bounds.
+static constexpr const char *kInBoundsAttrName = "in_bounds";
+
+/// Name of the runtime function checking an index against a dimension size.
+static constexpr const char *kBoundsCheckFnName = "mlir_memref_bounds_check";
+
+namespace {
+struct AnnotateMemRefBounds : public ModulePass<AnnotateMemRefBounds> {
+  explicit AnnotateMemRefBounds(bool insertRuntimeChecks = false)
+      : insertRuntimeChecks(insertRuntimeChecks) {}
+
+  void runOnModule() override;
+
+  /// Check the indices of the load or store `op` at runtime.
+  void insertChecks(Operation *op, Function *checkFn);
+
+  /// Whether the accesses that are not proven in bounds are checked at
+  /// runtime.
+  bool insertRuntimeChecks;
+};
+} // end anonymous namespace
+
+// Return true if `op` is one of the accesses the analysis classifies.
+static bool isMemRefAccess(Operation *op) {
+  return op->isa<LoadOp>() || op->isa<StoreOp>() ||
+         op->isa<VectorTransferReadOp>() || op->isa<VectorTransferWriteOp>();
+}
+
+// Get the memref and the indices of the load or store `op`.
+static std::pair<Value *, Operation::operand_range>
+getMemRefAndIndices(Operation *op) {
+  if (auto loadOp = op->dyn_cast<LoadOp>())
+    return {loadOp.getMemRef(), loadOp.getIndices()};
+  auto storeOp = op->cast<StoreOp>();
+  return {storeOp.getMemRef(), storeOp.getIndices()};
+}
+
+void AnnotateMemRefBounds::insertChecks(Operation *op, Function *checkFn) {
+  FuncBuilder builder(op);
+  auto loc = op->getLoc();
+  auto access = getMemRefAndIndices(op);
+  Value *memRef = access.first;
+  auto shape = memRef->getType().cast<MemRefType>().getShape();
+  unsigned dim = 0;
+  for (Value *index : access.second) {
+    Value *size = shape[dim] < 0
+                      ? builder.create<DimOp>(loc, memRef, dim).getResult()
+                      : builder.create<ConstantIndexOp>(loc, shape[dim])
+                            .getResult();
+    builder.create<CallOp>(loc, checkFn, ArrayRef<Value *>{index, size});
+    ++dim;
+  }
+}
+
+void AnnotateMemRefBounds::runOnModule() {
+  if (clRuntimeChecks.getNumOccurrences() > 0)
+    insertRuntimeChecks = clRuntimeChecks;
+
+  Module &module = getModule();
+  auto *context = &getContext();
+  auto inBounds = BoolAttr::get(true, context);
+
+  // Collect the accesses first, since the runtime function is added to the
+  // module.
+  SmallVector<Operation *, 16> provenAccesses, uncheckedAccesses;
+  for (Function &function : module) {
+    if (function.isExternal())
+      continue;
+    auto &analysis = getAnalysisManager()
+                         .getFunctionAnalysis<MemRefBoundsAnalysis>(&function);
+    function.walk([&](Operation *op) {
+      if (isMemRefAccess(op) && analysis.isInBounds(op))
+        provenAccesses.push_back(op);
+    });
+    if (insertRuntimeChecks) {
+      auto unproven = analysis.getUnprovenAccesses();
+      uncheckedAccesses.append(unproven.begin(), unproven.end());
+    }
+  }
+
+  for (Operation *op : provenAccesses)
+    op->setAttr(kInBoundsAttrName, inBounds);
+  if (uncheckedAccesses.empty())
+    return;
+
+  auto indexType = IndexType::get(context);
+  Function *checkFn = module.getOrInsertFunction(kBoundsCheckFnName, [&] {
+    return new Function(
+        UnknownLoc::get(context), kBoundsCheckFnName,
+        FunctionType::get({indexType, indexType}, {}, context));
+  });
+  for (Operation *op : uncheckedAccesses) {
+    insertChecks(op, checkFn);
+    op->setAttr(kInBoundsAttrName, inBounds);
+  }
+}
+
+/// Creates a pass marking the memref accesses proven in bounds with an
+/// "in_bounds" attribute, and checking the others at runtime if
+/// `insertRuntimeChecks` is set.
+ModulePassBase *
+mlir::createAnnotateMemRefBoundsPass(bool insertRuntimeChecks) {
+  return new AnnotateMemRefBounds(insertRuntimeChecks);
+}
+
+static PassRegistration<AnnotateMemRefBounds>
+    pass("annotate-memref-bounds",
+         "Mark the memref accesses proven to be in bounds, so that they are "
+         "lowered without bounds clipping or masking");
@@ -16,7 +16,8 @@
 // =============================================================================
 //
 // This transformation pass performs a simple common sub-expression elimination
-// algorithm on operations within a function.
+// algorithm on operations within a function. The regions held by sibling
+// operations, which don't dominate each other, are simplified concurrently.
 //
 //===----------------------------------------------------------------------===//
 
@@ -24,40 +25,65 @@
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/Function.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Support/Functional.h"
 #include "mlir/Transforms/Passes.h"
 #include "mlir/Transforms/Utils.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/ScopedHashTable.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/RecyclingAllocator.h"
 #include <deque>
 using namespace mlir;
 
 namespace {
+struct SimplifyState;
+
+/// An operation used as a key of the scoped hash table, along with the state
+/// of the simplification that holds the replacements pending on its operands.
+struct OperationKey {
+  Operation *op;
+  const SimplifyState *state;
+
+  /// Returns the operand at 'index' with any pending replacement applied.
+  Value *getOperand(unsigned index) const;
+};
+
 // TODO(riverriddle) Handle commutative operations.
-struct SimpleOperationInfo : public llvm::DenseMapInfo<Operation *> {
-  static unsigned getHashValue(const Operation *opC) {
-    auto *op = const_cast<Operation *>(opC);
+struct SimpleOperationInfo {
+  static OperationKey getEmptyKey() {
+    return {llvm::DenseMapInfo<Operation *>::getEmptyKey(), nullptr};
+  }
+  static OperationKey getTombstoneKey() {
+    return {llvm::DenseMapInfo<Operation *>::getTombstoneKey(), nullptr};
+  }
+  static bool isEmptyOrTombstone(const OperationKey &key) {
+    return key.op == getEmptyKey().op || key.op == getTombstoneKey().op;
+  }
+
+  static unsigned getHashValue(const OperationKey &key) {
+    auto *op = key.op;
     // Hash the operations based upon their:
     //   - Operation Name
     //   - Attributes
     //   - Result Types
     //   - Operands
-    return hash_combine(
+    llvm::hash_code hash = hash_combine(
         op->getName(), op->getAttrs(),
-        hash_combine_range(op->result_type_begin(), op->result_type_end()),
-        hash_combine_range(op->operand_begin(), op->operand_end()));
+        hash_combine_range(op->result_type_begin(), op->result_type_end()));
+    for (unsigned i = 0, e = op->getNumOperands(); i != e; ++i)
+      hash = hash_combine(hash, key.getOperand(i));
+    return hash;
   }
-  static bool isEqual(const Operation *lhsC, const Operation *rhsC) {
-    auto *lhs = const_cast<Operation *>(lhsC);
-    auto *rhs = const_cast<Operation *>(rhsC);
+  static bool isEqual(const OperationKey &lhsKey, const OperationKey &rhsKey) {
+    auto *lhs = lhsKey.op, *rhs = rhsKey.op;
     if (lhs == rhs)
       return true;
-    if (lhs == getTombstoneKey() || lhs == getEmptyKey() ||
-        rhs == getTombstoneKey() || rhs == getEmptyKey())
+    if (isEmptyOrTombstone(lhsKey) || isEmptyOrTombstone(rhsKey))
       return false;
 
     // Compare the operation name.
@@ -71,29 +97,84 @@ struct SimpleOperationInfo : public llvm::DenseMapInfo<Operation *> {
     if (lhs->getAttrs() != rhs->getAttrs())
       return false;
     // Compare operands.
-    if (!std::equal(lhs->operand_begin(), lhs->operand_end(),
-                    rhs->operand_begin()))
-      return false;
+    for (unsigned i = 0, e = lhs->getNumOperands(); i != e; ++i)
+      if (lhsKey.getOperand(i) != rhsKey.getOperand(i))
+        return false;
     // Compare result types.
     return std::equal(lhs->result_type_begin(), lhs->result_type_end(),
                       rhs->result_type_begin());
   }
 };
+
+/// Shared implementation of operation elimination and scoped map definitions.
+using ScopedMapValTy = llvm::ScopedHashTableVal<OperationKey, Operation *>;
+using AllocatorTy =
+    llvm::RecyclingAllocator<llvm::BumpPtrAllocator, ScopedMapValTy>;
+using ScopedMapTy = llvm::ScopedHashTable<OperationKey, Operation *,
+                                          SimpleOperationInfo, AllocatorTy>;
+
+/// The state of the simplification of a region. The regions held by sibling
+/// operations are simplified concurrently, each with a state of its own that
+/// falls back to the state of the enclosing region for the operations
+/// dominating it. The enclosing state is left untouched in the meantime, and
+/// the uses of redundant operations are only replaced once the whole function
+/// has been simplified, so that no thread modifies the use lists of the values
+/// visible to another one.
+struct SimplifyState {
+  explicit SimplifyState(const SimplifyState *parent = nullptr)
+      : parent(parent) {}
+
+  /// Returns the value replacing 'value' in this state or any of its parents,
+  /// or 'value' itself if it isn't replaced.
+  Value *lookupReplacement(Value *value) const {
+    for (auto *state = this; state; state = state->parent) {
+      auto it = state->replacements.find(value);
+      if (it != state->replacements.end())
+        return it->second;
+    }
+    return value;
+  }
+
+  /// Returns an operation equivalent to 'op' known to this state or any of its
+  /// parents, or null if there is none.
+  Operation *lookupEquivalent(Operation *op) const {
+    OperationKey key = {op, this};
+    for (auto *state = this; state; state = state->parent)
+      if (auto *existing = state->knownValues.lookup(key))
+        return existing;
+    return nullptr;
+  }
+
+  /// The enclosing state, which is not modified while this one is alive.
+  const SimplifyState *parent;
+
+  /// A scoped hash table of the defining operations within the region.
+  ScopedMapTy knownValues;
+
+  /// The results of the redundant operations along with the values they are
+  /// to be replaced with.
+  llvm::DenseMap<Value *, Value *> replacements;
+
+  /// The redundant operations along with the operations they are to be
+  /// replaced with, in the order they were found.
+  std::vector<std::pair<Operation *, Operation *>> replacedOps;
+
+  /// Operations marked as dead and to be erased.
+  std::vector<Operation *> opsToErase;
+};
 } // end anonymous namespace
 
+Value *OperationKey::getOperand(unsigned index) const {
+  Value *operand = op->getOperand(index);
+  return state ? state->lookupReplacement(operand) : operand;
+}
+
 namespace {
 /// Simple common sub-expression elimination.
 struct CSE : public FunctionPass<CSE> {
   CSE() = default;
   CSE(const CSE &) {}
 
-  /// Shared implementation of operation elimination and scoped map definitions.
-  using AllocatorTy = llvm::RecyclingAllocator<
-      llvm::BumpPtrAllocator,
-      llvm::ScopedHashTableVal<Operation *, Operation *>>;
-  using ScopedMapTy = llvm::ScopedHashTable<Operation *, Operation *,
-                                            SimpleOperationInfo, AllocatorTy>;
-
   /// Represents a single entry in the depth first traversal of a CFG.
   struct CFGStackNode {
     CFGStackNode(ScopedMapTy &knownValues, DominanceInfoNode *node)
@@ -112,24 +193,40 @@ struct CSE : public FunctionPass<CSE> {
 
   /// Attempt to eliminate a redundant operation. Returns true if the operation
   /// was marked for removal, false otherwise.
-  bool simplifyOperation(Operation *op);
+  bool simplifyOperation(SimplifyState &state, Operation *op);
+
+  void simplifyBlock(SimplifyState &state, DominanceInfo &domInfo, Block *bb);
+  void simplifyRegion(SimplifyState &state, DominanceInfo &domInfo,
+                      Region &region);
 
-  void simplifyBlock(DominanceInfo &domInfo, Block *bb);
-  void simplifyRegion(DominanceInfo &domInfo, Region &region);
+  /// Simplify regions that don't dominate each other, concurrently when there
+  /// is more than one.
+  void simplifyRegions(SimplifyState &state, DominanceInfo &domInfo,
+                       ArrayRef<Region *> regions);
 
   void runOnFunction() override;
 
-private:
-  /// A scoped hash table of defining operations within a function.
-  ScopedMapTy knownValues;
+  /// Eliminating the redundant operations may leave other operations dead,
+  /// so the pass is only known to be a no-op on its output if it didn't
+  /// change anything.
+  bool isIdempotent() const override { return unchanged; }
 
-  /// Operations marked as dead and to be erased.
-  std::vector<Operation *> opsToErase;
+private:
+  /// Whether the last run left the function unchanged.
+  bool unchanged = false;
+
+  /// Statistics of this pass.
+  Statistic numCSE = {this, "num-cse'd", "Number of operations CSE'd"};
+  Statistic numDCE = {this, "num-dce'd", "Number of operations DCE'd"};
+  Statistic numHits = {this, "num-hits",
+                       "Number of lookups finding an equivalent operation"};
+  Statistic numMisses = {this, "num-misses",
+                         "Number of lookups finding no equivalent operation"};
 };
 } // end anonymous namespace
 
 /// Attempt to eliminate a redundant operation.
-bool CSE::simplifyOperation(Operation *op) {
+bool CSE::simplifyOperation(SimplifyState &state, Operation *op) {
   // Don't simplify operations with nested blocks. We don't currently model
   // equality comparisons correctly among other things. It is also unclear
   // whether we would want to CSE such operations.
@@ -143,54 +240,63 @@ bool CSE::simplifyOperation(Operation *op) {
 
   // If the operation is already trivially dead just add it to the erase list.
   if (op->use_empty()) {
-    opsToErase.push_back(op);
+    state.opsToErase.push_back(op);
+    ++numDCE;
     return true;
   }
 
   // Look for an existing definition for the operation.
-  if (auto *existing = knownValues.lookup(op)) {
-    // If we find one then replace all uses of the current operation with the
-    // existing one and mark it for deletion.
+  if (auto *existing = state.lookupEquivalent(op)) {
+    ++numHits;
+    // If we find one then record that all uses of the current operation are
+    // to be replaced with the existing one and mark it for deletion. Until the
+    // uses are replaced, the operands of the operations are compared through
+    // the recorded replacements.
     for (unsigned i = 0, e = existing->getNumResults(); i != e; ++i)
-      op->getResult(i)->replaceAllUsesWith(existing->getResult(i));
-    opsToErase.push_back(op);
-
-    // If the existing operation has an unknown location and the current
-    // operation doesn't, then set the existing op's location to that of the
-    // current op.
-    if (existing->getLoc().isa<UnknownLoc>() &&
-        !op->getLoc().isa<UnknownLoc>()) {
-      existing->setLoc(op->getLoc());
-    }
+      state.replacements[op->getResult(i)] = existing->getResult(i);
+    state.replacedOps.emplace_back(op, existing);
+    state.opsToErase.push_back(op);
+    ++numCSE;
     return true;
   }
 
   // Otherwise, we add this operation to the known values map.
-  knownValues.insert(op, op);
+  ++numMisses;
+  state.knownValues.insert({op, &state}, op);
   return false;
 }
 
-void CSE::simplifyBlock(DominanceInfo &domInfo, Block *bb) {
+void CSE::simplifyBlock(SimplifyState &state, DominanceInfo &domInfo,
+                        Block *bb) {
+  // The regions held by a run of consecutive operations don't dominate each
+  // other, so they are simplified together once the run ends.
+  SmallVector<Region *, 4> regions;
   for (auto &i : *bb) {
-    // If the operation is simplified, we don't process any held regions.
-    if (simplifyOperation(&i))
+    if (i.getNumRegions() == 0) {
+      simplifyRegions(state, domInfo, regions);
+      regions.clear();
+      simplifyOperation(state, &i);
       continue;
+    }
 
     // Simplify any held blocks.
     for (auto &region : i.getRegions())
-      simplifyRegion(domInfo, region);
+      if (!region.empty())
+        regions.push_back(&region);
   }
+  simplifyRegions(state, domInfo, regions);
 }
 
-void CSE::simplifyRegion(DominanceInfo &domInfo, Region &region) {
+void CSE::simplifyRegion(SimplifyState &state, DominanceInfo &domInfo,
+                         Region &region) {
   // If the region is empty there is nothing to do.
   if (region.empty())
     return;
 
   // If the region only contains one block, then simplify it directly.
   if (std::next(region.begin()) == region.end()) {
-    ScopedMapTy::ScopeTy scope(knownValues);
-    simplifyBlock(domInfo, &region.front());
+    ScopedMapTy::ScopeTy scope(state.knownValues);
+    simplifyBlock(state, domInfo, &region.front());
     return;
   }
 
@@ -204,7 +310,7 @@ void CSE::simplifyRegion(DominanceInfo &domInfo, Region &region) {
 
   // Process the nodes of the dom tree for this region.
   stack.emplace_back(llvm::make_unique<CFGStackNode>(
-      knownValues, domInfo.getRootNode(&region)));
+      state.knownValues, domInfo.getRootNode(&region)));
 
   while (!stack.empty()) {
     auto &currentNode = stack.back();
@@ -212,14 +318,14 @@ void CSE::simplifyRegion(DominanceInfo &domInfo, Region &region) {
     // Check to see if we need to process this node.
     if (!currentNode->processed) {
       currentNode->processed = true;
-      simplifyBlock(domInfo, currentNode->node->getBlock());
+      simplifyBlock(state, domInfo, currentNode->node->getBlock());
     }
 
     // Otherwise, check to see if we need to process a child node.
     if (currentNode->childIterator != currentNode->node->end()) {
       auto *childNode = *(currentNode->childIterator++);
       stack.emplace_back(
-          llvm::make_unique<CFGStackNode>(knownValues, childNode));
+          llvm::make_unique<CFGStackNode>(state.knownValues, childNode));
     } else {
       // Finally, if the node and all of its children have been processed
       // then we delete the node.
@@ -228,19 +334,69 @@ void CSE::simplifyRegion(DominanceInfo &domInfo, Region &region) {
   }
 }
 
+void CSE::simplifyRegions(SimplifyState &state, DominanceInfo &domInfo,
+                          ArrayRef<Region *> regions) {
+  if (regions.size() < 2) {
+    for (auto *region : regions)
+      simplifyRegion(state, domInfo, *region);
+    return;
+  }
+
+  // Simplify each region with a state of its own seeded with the current one,
+  // then merge the results in the order of the regions so that they don't
+  // depend on the scheduling of the threads.
+  std::vector<std::unique_ptr<SimplifyState>> regionStates;
+  regionStates.reserve(regions.size());
+  for (unsigned i = 0, e = regions.size(); i != e; ++i)
+    regionStates.push_back(llvm::make_unique<SimplifyState>(&state));
+
+  auto indices = llvm::seq<unsigned>(0, regions.size());
+  parallelForEach(&getContext(), indices.begin(), indices.end(),
+                  [&](unsigned i) {
+                    simplifyRegion(*regionStates[i], domInfo, *regions[i]);
+                  });
+
+  // The replacements of the values defined within the regions don't need to
+  // be merged, as no operation outside of them can use those values.
+  for (auto &regionState : regionStates) {
+    state.replacedOps.insert(state.replacedOps.end(),
+                             regionState->replacedOps.begin(),
+                             regionState->replacedOps.end());
+    state.opsToErase.insert(state.opsToErase.end(),
+                            regionState->opsToErase.begin(),
+                            regionState->opsToErase.end());
+  }
+}
+
 void CSE::runOnFunction() {
-  simplifyRegion(getAnalysis<DominanceInfo>(), getFunction().getBody());
+  SimplifyState state;
+  simplifyRegion(state, getAnalysis<DominanceInfo>(), getFunction().getBody());
 
   // If no operations were erased, then we mark all analyses as preserved.
-  if (opsToErase.empty()) {
+  unchanged = state.opsToErase.empty();
+  if (unchanged) {
     markAllAnalysesPreserved();
     return;
   }
 
+  // Replace all uses of the redundant operations with the existing ones.
+  for (auto &replacement : state.replacedOps) {
+    Operation *op = replacement.first, *existing = replacement.second;
+    for (unsigned i = 0, e = existing->getNumResults(); i != e; ++i)
+      op->getResult(i)->replaceAllUsesWith(existing->getResult(i));
+
+    // If the existing operation has an unknown location and the current
+    // operation doesn't, then set the existing op's location to that of the
+    // current op.
+    if (existing->getLoc().isa<UnknownLoc>() &&
+        !op->getLoc().isa<UnknownLoc>()) {
+      existing->setLoc(op->getLoc());
+    }
+  }
+
   /// Erase any operations that were marked as dead during simplification.
-  for (auto *op : opsToErase)
+  for (auto *op : state.opsToErase)
     op->erase();
-  opsToErase.clear();
 
   // We currently don't remove region operations, so mark dominance as
   // preserved.
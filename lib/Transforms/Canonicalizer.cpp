@@ -23,6 +23,7 @@
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/Passes.h"
 using namespace mlir;
 
@@ -35,6 +36,12 @@ namespace {
 /// Canonicalize operations in functions.
 struct Canonicalizer : public FunctionPass<Canonicalizer> {
   void runOnFunction() override;
+
+  /// Canonicalizing the function again is a no-op once the rewrites converged.
+  bool isIdempotent() const override { return converged; }
+
+  /// Whether the rewrites converged during the last run.
+  bool converged = false;
 };
 } // end anonymous namespace
 
@@ -49,7 +56,7 @@ void Canonicalizer::runOnFunction() {
   for (auto *op : context->getRegisteredOperations())
     op->getCanonicalizationPatterns(patterns, context);
 
-  applyPatternsGreedily(func, std::move(patterns));
+  converged = applyPatternsGreedily(func, std::move(patterns));
 }
 
 /// Create a Canonicalizer pass.
@@ -59,3 +66,14 @@ FunctionPassBase *mlir::createCanonicalizerPass() {
 
 static PassRegistration<Canonicalizer> pass("canonicalize",
                                             "Canonicalize operations");
+
+/// Alternate canonicalization and CSE until the function stops changing.
+static void addCanonicalizeCSEPipeline(PassManager &pm) {
+  pm.addFixedPointPipeline({createCanonicalizerPass(), createCSEPass()});
+}
+
+static PassPipelineRegistration
+    pipeline("canonicalize-cse",
+             "Alternate canonicalization and common sub-expression "
+             "elimination on each function until it stops changing",
+             addCanonicalizeCSEPipeline);
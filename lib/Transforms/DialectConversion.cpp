@@ -22,110 +22,149 @@
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Module.h"
-#include "mlir/Transforms/Utils.h"
+#include "mlir/IR/Threading.h"
+#include "llvm/ADT/Sequence.h"
+#include <algorithm>
+#include <atomic>
 
 using namespace mlir;
 
 namespace mlir {
 namespace impl {
 // Implementation detail class of the DialectConversion pass.  Performs
-// function-by-function conversions by creating new functions, filling them in
-// with converted blocks, updating the function attributes, and replacing the
-// old functions with the new ones in the module.
+// function-by-function conversions in place: operations matched by a
+// conversion pattern are replaced by the operations the pattern creates, the
+// other operations are left untouched, and block arguments are replaced by
+// arguments of the converted types.
 class FunctionConversion {
 public:
   // Entry point.  Uses hooks defined in `conversion` to obtain the list of
   // conversion patterns and to convert function and block argument types.
-  // Converts the `module` in-place by replacing all existing functions with the
-  // converted ones.
+  // Converts the `module` in-place by converting the signatures of all
+  // functions, then their bodies, concurrently if `conversion` allows it.
   static LogicalResult convert(DialectConversion *conversion, Module *module);
 
 private:
-  // Constructs a FunctionConversion by storing the hooks.
-  explicit FunctionConversion(DialectConversion *conversion)
-      : dialectConversion(conversion) {}
-
-  // Utility that looks up a list of value in the value remapping table. Returns
-  // an empty vector if one of the values is not mapped yet.
+  // Conversion patterns bucketed by the name of their root operation, each
+  // bucket sorted by decreasing benefit.
+  using ConversionMap =
+      llvm::DenseMap<OperationName, SmallVector<DialectOpConversion *, 2>>;
+
+  // Constructs a FunctionConversion by storing the hooks and the patterns.
+  FunctionConversion(DialectConversion *conversion,
+                     const ConversionMap &conversionsByRoot)
+      : dialectConversion(conversion), conversionsByRoot(conversionsByRoot) {}
+
+  // Buckets `conversions` by root operation name, dropping the patterns that
+  // can never match.
+  static ConversionMap
+  bucketConversions(const llvm::DenseSet<DialectOpConversion *> &conversions);
+
+  // Utility that looks up a list of values in the value remapping table.
+  // Values that were not remapped are returned as is.
   SmallVector<Value *, 4> lookupValues(
       const llvm::iterator_range<Operation::operand_iterator> &operands);
 
-  // Converts the given function to the dialect using hooks defined in
-  // `dialectConversion`.  Returns the converted function or `nullptr` on error.
-  Function *convertFunction(Function *f);
+  // Converts the body of the given function, whose signature has already been
+  // converted, using hooks defined in `dialectConversion`.
+  LogicalResult convertFunction(Function *f);
 
   // Converts the given region starting from the entry block and following the
-  // block successors.  Returns the converted region or `nullptr` on error.
-  template <typename RegionParent>
-  std::unique_ptr<Region> convertRegion(MLIRContext *context, Region *region,
-                                        RegionParent *parent);
+  // block successors.
+  LogicalResult convertRegion(MLIRContext *context, Region *region);
 
   // Converts an operation with successors.  Extracts the converted operands
-  // from `valueRemapping` and the converted blocks from `blockRemapping`, and
-  // passes them to `converter->rewriteTerminator` function defined in the
-  // pattern, together with `builder`.
-  LogicalResult convertOpWithSuccessors(DialectOpConversion *converter,
-                                        Operation *op, FuncBuilder &builder);
+  // from `mapping` and passes them to `converter->rewriteTerminator` function
+  // defined in the pattern, together with the original successor blocks and
+  // `builder`.
+  void convertOpWithSuccessors(DialectOpConversion *converter, Operation *op,
+                               FuncBuilder &builder);
 
   // Converts an operation without successors.  Extracts the converted operands
-  // from `valueRemapping` and passes them to the `converter->rewrite` function
+  // from `mapping` and passes them to the `converter->rewrite` function
   // defined in the pattern, together with `builder`.
   LogicalResult convertOp(DialectOpConversion *converter, Operation *op,
                           FuncBuilder &builder);
 
   // Converts a block by traversing its operations sequentially, looking for
-  // the first pattern match and dispatching the operation conversion to
+  // the highest benefit pattern match among the patterns rooted at the
+  // operation, and dispatching the operation conversion to
   // either `convertOp` or `convertOpWithSuccessors` depending on the presence
-  // of successors.  If there is no match, clones the operation.
+  // of successors.  If there is no match, leaves the operation as is and
+  // converts its regions.
   //
   // After converting operations, traverses the successor blocks unless they
   // have been visited already as indicated in `visitedBlocks`.
   LogicalResult convertBlock(Block *block, FuncBuilder &builder,
                              llvm::DenseSet<Block *> &visitedBlocks);
 
-  // Converts the module as follows.
-  // 1. Call `convertFunction` on each function of the module and collect the
-  // mapping between old and new functions.
-  // 2. Remap all function attributes in the new functions to point to the new
-  // functions instead of the old ones.
-  // 3. Replace old functions with the new in the module.
-  LogicalResult run(Module *m);
+  // Replaces the uses of the results of the converted operations and of the
+  // original block arguments with their converted counterparts, then erases
+  // them.  The original operations are kept until then so that the patterns
+  // can inspect their operands with the types they had before the conversion.
+  void finalize();
 
   // Pointer to a specific dialect pass.
   DialectConversion *dialectConversion;
 
-  // Set of known conversion patterns.
-  llvm::DenseSet<DialectOpConversion *> conversions;
+  // Known conversion patterns, indexed by root operation name.
+  const ConversionMap &conversionsByRoot;
 
-  // Mapping between values(blocks) in the original function and in the new
-  // function.
+  // Mapping between the results and block arguments of the function and their
+  // converted counterparts.
   BlockAndValueMapping mapping;
+
+  // Operations replaced by a pattern, to be erased by `finalize`.
+  SmallVector<Operation *, 16> replacedOps;
+
+  // Blocks whose leading arguments are the original ones, to be erased by
+  // `finalize`, along with the number of such arguments.
+  SmallVector<std::pair<Block *, unsigned>, 4> blocksWithReplacedArgs;
 };
 } // end namespace impl
 } // end namespace mlir
 
+static LogicalResult emitConversionError(MLIRContext *context,
+                                         const llvm::Twine &message) {
+  context->emitError(UnknownLoc::get(context), message.str());
+  return failure();
+}
+
+impl::FunctionConversion::ConversionMap
+impl::FunctionConversion::bucketConversions(
+    const llvm::DenseSet<DialectOpConversion *> &conversions) {
+  // Sort the patterns by benefit so that each bucket remains sorted.
+  SmallVector<DialectOpConversion *, 32> sorted(conversions.begin(),
+                                                conversions.end());
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](DialectOpConversion *l, DialectOpConversion *r) {
+                     return r->getBenefit() < l->getBenefit();
+                   });
+
+  ConversionMap conversionsByRoot;
+  for (auto *conversion : sorted)
+    if (!conversion->getBenefit().isImpossibleToMatch())
+      conversionsByRoot[conversion->getRootKind()].push_back(conversion);
+  return conversionsByRoot;
+}
+
 SmallVector<Value *, 4> impl::FunctionConversion::lookupValues(
     const llvm::iterator_range<Operation::operand_iterator> &operands) {
   SmallVector<Value *, 4> remapped;
   remapped.reserve(llvm::size(operands));
-  for (Value *operand : operands) {
-    Value *value = mapping.lookupOrNull(operand);
-    if (!value)
-      return {};
-    remapped.push_back(value);
-  }
+  for (Value *operand : operands)
+    remapped.push_back(mapping.lookupOrDefault(operand));
   return remapped;
 }
 
-LogicalResult impl::FunctionConversion::convertOpWithSuccessors(
+void impl::FunctionConversion::convertOpWithSuccessors(
     DialectOpConversion *converter, Operation *op, FuncBuilder &builder) {
   SmallVector<Block *, 2> destinations;
   destinations.reserve(op->getNumSuccessors());
   SmallVector<Value *, 4> operands = lookupValues(op->getOperands());
-  assert((!operands.empty() || op->getNumOperands() == 0) &&
-         "converting op before ops defining its operands");
 
   SmallVector<ArrayRef<Value *>, 2> operandsPerDestination;
   unsigned numSuccessorOperands = 0;
@@ -134,9 +173,7 @@ LogicalResult impl::FunctionConversion::convertOpWithSuccessors(
   unsigned seen = 0;
   unsigned firstSuccessorOperand = op->getNumOperands() - numSuccessorOperands;
   for (unsigned i = 0, e = op->getNumSuccessors(); i < e; ++i) {
-    Block *successor = mapping.lookupOrNull(op->getSuccessor(i));
-    assert(successor && "block was not remapped");
-    destinations.push_back(successor);
+    destinations.push_back(op->getSuccessor(i));
     unsigned n = op->getNumSuccessorOperands(i);
     operandsPerDestination.push_back(
         llvm::makeArrayRef(operands.data() + firstSuccessorOperand + seen, n));
@@ -147,16 +184,13 @@ LogicalResult impl::FunctionConversion::convertOpWithSuccessors(
       llvm::makeArrayRef(operands.data(),
                          operands.data() + firstSuccessorOperand),
       destinations, operandsPerDestination, builder);
-  return success();
+  replacedOps.push_back(op);
 }
 
 LogicalResult
 impl::FunctionConversion::convertOp(DialectOpConversion *converter,
                                     Operation *op, FuncBuilder &builder) {
   auto operands = lookupValues(op->getOperands());
-  assert((!operands.empty() || op->getNumOperands() == 0) &&
-         "converting op before ops defining its operands");
-
   auto results = converter->rewrite(op, operands, builder);
   if (results.size() != op->getNumResults())
     return (op->emitError("rewriting produced a different number of results"),
@@ -164,6 +198,7 @@ impl::FunctionConversion::convertOp(DialectOpConversion *converter,
 
   for (unsigned i = 0, e = results.size(); i < e; ++i)
     mapping.map(op->getResult(i), results[i]);
+  replacedOps.push_back(op);
   return success();
 }
 
@@ -172,35 +207,37 @@ impl::FunctionConversion::convertBlock(Block *block, FuncBuilder &builder,
                                        llvm::DenseSet<Block *> &visitedBlocks) {
   // First, add the current block to the list of visited blocks.
   visitedBlocks.insert(block);
-  // Setup the builder to the insert to the converted block.
-  builder.setInsertionPointToStart(mapping.lookupOrNull(block));
 
-  // Iterate over ops and convert them.
+  // Iterate over ops and convert them.  The converted operations are inserted
+  // right before the original ones, which are erased at the end.
   for (Operation &op : *block) {
-    // Find the first matching conversion and apply it.
-    bool converted = false;
-    for (auto *conversion : conversions) {
-      if (!conversion->match(&op))
-        continue;
-
-      if (op.getNumSuccessors() != 0) {
-        if (failed(convertOpWithSuccessors(conversion, &op, builder)))
-          return failure();
-      } else if (failed(convertOp(conversion, &op, builder))) {
-        return failure();
+    // Find the highest benefit matching conversion and apply it.  Only the
+    // patterns rooted at this kind of operation are tried, so operations of
+    // other dialects are skipped after a single lookup.
+    DialectOpConversion *converter = nullptr;
+    auto it = conversionsByRoot.find(op.getName());
+    if (it != conversionsByRoot.end()) {
+      for (auto *conversion : it->second) {
+        if (conversion->match(&op)) {
+          converter = conversion;
+          break;
+        }
       }
-      converted = true;
-      break;
     }
-    // If there is no conversion provided for the op, clone the op and convert
-    // its regions, if any.
-    if (!converted) {
-      auto *newOp = builder.cloneWithoutRegions(op, mapping);
-      for (int i = 0, e = op.getNumRegions(); i < e; ++i) {
-        auto newRegion = convertRegion(op.getContext(), &op.getRegion(i), &op);
-        newOp->getRegion(i).takeBody(*newRegion);
-      }
+    // If there is no conversion provided for the op, keep it and convert its
+    // regions, if any.
+    if (!converter) {
+      for (int i = 0, e = op.getNumRegions(); i < e; ++i)
+        if (failed(convertRegion(op.getContext(), &op.getRegion(i))))
+          return failure();
+      continue;
     }
+
+    builder.setInsertionPoint(&op);
+    if (op.getNumSuccessors() != 0)
+      convertOpWithSuccessors(converter, &op, builder);
+    else if (failed(convertOp(converter, &op, builder)))
+      return failure();
   }
 
   // Recurse to children unless they have been already visited.
@@ -213,126 +250,144 @@ impl::FunctionConversion::convertBlock(Block *block, FuncBuilder &builder,
   return success();
 }
 
-template <typename RegionParent>
-std::unique_ptr<Region>
-impl::FunctionConversion::convertRegion(MLIRContext *context, Region *region,
-                                        RegionParent *parent) {
+LogicalResult impl::FunctionConversion::convertRegion(MLIRContext *context,
+                                                      Region *region) {
   assert(region && "expected a region");
-  auto newRegion = llvm::make_unique<Region>(parent);
   if (region->empty())
-    return newRegion;
+    return success();
 
-  auto emitError = [context](llvm::Twine f) -> std::unique_ptr<Region> {
-    context->emitError(UnknownLoc::get(context), f.str());
-    return nullptr;
-  };
-
-  // Create new blocks and convert their arguments.
+  // Convert the block arguments.  Blocks whose argument types all remain the
+  // same keep their arguments, the other ones get new arguments appended
+  // after the original ones.
   for (Block &block : *region) {
-    auto *newBlock = new Block;
-    newRegion->push_back(newBlock);
-    mapping.map(&block, newBlock);
+    SmallVector<Type, 4> convertedTypes;
+    convertedTypes.reserve(block.getNumArguments());
+    bool changed = false;
     for (auto *arg : block.getArguments()) {
       auto convertedType = dialectConversion->convertType(arg->getType());
       if (!convertedType)
-        return emitError("could not convert block argument type");
-      newBlock->addArgument(convertedType);
-      mapping.map(arg, *newBlock->args_rbegin());
+        return emitConversionError(context,
+                                   "could not convert block argument type");
+      convertedTypes.push_back(convertedType);
+      changed |= convertedType != arg->getType();
     }
+    if (!changed)
+      continue;
+    unsigned numArgs = block.getNumArguments();
+    for (unsigned i = 0; i < numArgs; ++i)
+      mapping.map(block.getArgument(i), block.addArgument(convertedTypes[i]));
+    blocksWithReplacedArgs.emplace_back(&block, numArgs);
   }
 
   // Start a DFS-order traversal of the CFG to make sure defs are converted
   // before uses in dominated blocks.
   llvm::DenseSet<Block *> visitedBlocks;
-  FuncBuilder builder(&newRegion->front());
+  FuncBuilder builder(&region->front());
   if (failed(convertBlock(&region->front(), builder, visitedBlocks)))
-    return nullptr;
+    return failure();
 
   // If some blocks are not reachable through successor chains, they should have
   // been removed by the DCE before this.
-
   if (visitedBlocks.size() != std::distance(region->begin(), region->end()))
-    return emitError("unreachable blocks were not converted");
-  return newRegion;
+    return emitConversionError(context,
+                               "unreachable blocks were not converted");
+  return success();
 }
 
-Function *impl::FunctionConversion::convertFunction(Function *f) {
-  assert(f && "expected function");
-  MLIRContext *context = f->getContext();
-  auto emitError = [context](llvm::Twine f) -> Function * {
-    context->emitError(UnknownLoc::get(context), f.str());
-    return nullptr;
-  };
+void impl::FunctionConversion::finalize() {
+  for (auto *op : replacedOps)
+    for (auto *result : op->getResults())
+      result->replaceAllUsesWith(mapping.lookup(result));
+
+  // The predecessors of the blocks already pass values for the converted
+  // arguments only.
+  for (auto &blockAndNumArgs : blocksWithReplacedArgs) {
+    Block *block = blockAndNumArgs.first;
+    for (unsigned i = 0, e = blockAndNumArgs.second; i < e; ++i) {
+      auto *arg = block->getArgument(0);
+      arg->replaceAllUsesWith(mapping.lookup(arg));
+      block->eraseArgument(0, /*updatePredTerms=*/false);
+    }
+  }
 
-  // Create a new function with argument types and result types converted. Wrap
-  // it into a unique_ptr to make sure it is cleaned up in case of error.
-  SmallVector<NamedAttributeList, 4> newFunctionArgAttrs;
-  Type newFunctionType = dialectConversion->convertFunctionSignatureType(
-      f->getType(), f->getAllArgAttrs(), newFunctionArgAttrs);
-  if (!newFunctionType)
-    return emitError("could not convert function type");
-  auto newFunction = llvm::make_unique<Function>(
-      f->getLoc(), f->getName().strref(), newFunctionType.cast<FunctionType>(),
-      f->getAttrs(), newFunctionArgAttrs);
+  for (auto *op : replacedOps)
+    op->erase();
+}
 
+LogicalResult impl::FunctionConversion::convertFunction(Function *f) {
+  assert(f && "expected function");
   // Return early if the function has no blocks.
   if (f->getBlocks().empty())
-    return newFunction.release();
-
-  auto newBody = convertRegion(context, &f->getBody(), f);
-  if (!newBody)
-    return emitError("could not convert function body");
-  newFunction->getBody().takeBody(*newBody);
+    return success();
 
-  return newFunction.release();
+  if (failed(convertRegion(f->getContext(), &f->getBody())))
+    return emitConversionError(f->getContext(),
+                               "could not convert function body");
+  finalize();
+  return success();
 }
 
 LogicalResult impl::FunctionConversion::convert(DialectConversion *conversion,
                                                 Module *module) {
-  return impl::FunctionConversion(conversion).run(module);
-}
-
-LogicalResult impl::FunctionConversion::run(Module *module) {
   if (!module)
     return failure();
 
   MLIRContext *context = module->getContext();
-  conversions = dialectConversion->initConverters(context);
-
-  // Convert the functions but don't add them to the module yet to avoid
-  // converted functions to be converted again.
-  SmallVector<Function *, 0> originalFuncs, convertedFuncs;
-  DenseMap<Attribute, FunctionAttr> functionAttrRemapping;
-  originalFuncs.reserve(module->getFunctions().size());
-  for (auto &func : *module)
-    originalFuncs.push_back(&func);
-  convertedFuncs.reserve(module->getFunctions().size());
-  for (auto *func : originalFuncs) {
-    Function *converted = convertFunction(func);
-    if (!converted)
-      return failure();
-
-    auto origFuncAttr = FunctionAttr::get(func, context);
-    auto convertedFuncAttr = FunctionAttr::get(converted, context);
-    convertedFuncs.push_back(converted);
-    functionAttrRemapping.insert({origFuncAttr, convertedFuncAttr});
+  auto conversionsByRoot =
+      bucketConversions(conversion->initConverters(context));
+
+  // Convert the function signatures first so that the module is left
+  // untouched if one of them can't be converted.  The functions declared by
+  // the patterns while converting the bodies are not converted.
+  SmallVector<Function *, 0> funcs;
+  SmallVector<FunctionType, 0> convertedTypes;
+  SmallVector<SmallVector<NamedAttributeList, 4>, 0> convertedArgAttrs;
+  funcs.reserve(module->getFunctions().size());
+  convertedTypes.reserve(module->getFunctions().size());
+  convertedArgAttrs.reserve(module->getFunctions().size());
+  for (auto &func : *module) {
+    SmallVector<NamedAttributeList, 4> newArgAttrs;
+    FunctionType newType = conversion->convertFunctionSignatureType(
+        func.getType(), func.getAllArgAttrs(), newArgAttrs);
+    if (!newType)
+      return emitConversionError(context, "could not convert function type");
+    funcs.push_back(&func);
+    convertedTypes.push_back(newType);
+    convertedArgAttrs.push_back(std::move(newArgAttrs));
   }
-
-  // Remap function attributes in the converted functions (they are not yet in
-  // the module).  Original functions will disappear anyway so there is no
-  // need to remap attributes in them.
-  for (const auto &funcPair : functionAttrRemapping) {
-    remapFunctionAttrs(*funcPair.getSecond().getValue(), functionAttrRemapping);
+  for (unsigned i = 0, e = funcs.size(); i < e; ++i) {
+    funcs[i]->setType(convertedTypes[i]);
+    auto argAttrs = funcs[i]->getAllArgAttrs();
+    for (unsigned j = 0, numAttrs = std::min(argAttrs.size(),
+                                             convertedArgAttrs[i].size());
+         j < numAttrs; ++j)
+      argAttrs[j] = convertedArgAttrs[i][j];
   }
 
-  // Remove original functions from the module, then insert converted
-  // functions.  The order is important to avoid name collisions.
-  for (auto &func : originalFuncs)
-    func->erase();
-  for (auto *func : convertedFuncs)
-    module->getFunctions().push_back(func);
+  // The function bodies are independent of each other: convert them on the
+  // thread pool of the context if the patterns and type conversion hooks can
+  // run concurrently, using a diagnostic handler that keeps the diagnostics
+  // in the order of the functions.
+  auto convertBody = [&](Function *func) {
+    return FunctionConversion(conversion, conversionsByRoot)
+        .convertFunction(func);
+  };
+  if (!conversion->isThreadSafe() || funcs.size() < 2) {
+    for (auto *func : funcs)
+      if (failed(convertBody(func)))
+        return failure();
+    return success();
+  }
 
-  return success();
+  ParallelDiagnosticHandler diagHandler(*context);
+  std::atomic<bool> conversionFailed(false);
+  auto indices = llvm::seq<unsigned>(0, funcs.size());
+  parallelForEach(context, indices.begin(), indices.end(), [&](unsigned i) {
+    diagHandler.setOrderIDForThread(i);
+    if (failed(convertBody(funcs[i])))
+      conversionFailed = true;
+  });
+  return failure(conversionFailed);
 }
 
 // Create a function type with arguments and results converted, and argument
@@ -22,14 +22,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
 #include "mlir/Analysis/Utils.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/StandardOps/Ops.h"
 #include "mlir/Transforms/Passes.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "mlir/Transforms/Utils.h"
 #include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include <algorithm>
@@ -69,21 +72,31 @@ namespace {
 /// of fast memory space available. The pass traverses through the nesting
 /// structure, recursing to inner levels if necessary to determine at what depth
 /// DMA transfers need to be placed so that the allocated buffers fit within the
-/// memory capacity provided.
-// TODO(bondhugula): We currently can't generate DMAs correctly when stores are
-// strided. Check for strided stores.
+/// memory capacity provided: DMAs for a loop are placed around it if the
+/// buffers for all of the regions it accesses fit, and inside it otherwise.
+/// A memref that is both read and written is copied
+/// in and written back through a single buffer covering all of its accesses; a
+/// written region that the stores may not entirely cover is copied in as well
+/// so that writing it back doesn't clobber the elements left untouched. Each
+/// computation of the regions of a range of operations consumes a unit of the
+/// budget of the pass; once it is exhausted, the remaining accesses are left
+/// to the slow memory space.
 struct DmaGeneration : public FunctionPass<DmaGeneration> {
+  using RegionMap = SmallMapVector<Value *, std::unique_ptr<MemRefRegion>, 4>;
+
   explicit DmaGeneration(
       unsigned slowMemorySpace = 0,
       unsigned fastMemorySpace = clFastMemorySpace,
       int minDmaTransferSize = 1024,
-      uint64_t fastMemCapacityBytes = std::numeric_limits<uint64_t>::max())
+      uint64_t fastMemCapacityBytes =
+          TargetMemoryModel::getDefault().getFastMemoryCapacity())
       : slowMemorySpace(slowMemorySpace), fastMemorySpace(fastMemorySpace),
         minDmaTransferSize(minDmaTransferSize),
         fastMemCapacityBytes(fastMemCapacityBytes) {}
 
   explicit DmaGeneration(const DmaGeneration &other)
-      : slowMemorySpace(other.slowMemorySpace),
+      : FunctionPass<DmaGeneration>(other),
+        slowMemorySpace(other.slowMemorySpace),
         fastMemorySpace(other.fastMemorySpace),
         minDmaTransferSize(other.minDmaTransferSize),
         fastMemCapacityBytes(other.fastMemCapacityBytes) {}
@@ -92,6 +105,11 @@ struct DmaGeneration : public FunctionPass<DmaGeneration> {
   bool runOnBlock(Block *block);
   uint64_t runOnBlock(Block::iterator begin, Block::iterator end);
 
+  LogicalResult computeRegions(Block::iterator begin, Block::iterator end,
+                               RegionMap *readRegions, RegionMap *writeRegions);
+  Optional<uint64_t> getDmaFootprintBytes(Block::iterator begin,
+                                          Block::iterator end);
+
   bool generateDma(const MemRefRegion &region, Block *block,
                    Block::iterator begin, Block::iterator end,
                    uint64_t *sizeInBytes, Block::iterator *nBegin,
@@ -100,8 +118,8 @@ struct DmaGeneration : public FunctionPass<DmaGeneration> {
   // List of memory regions to DMA for. We need a map vector to have a
   // guaranteed iteration order to write test cases. CHECK-DAG doesn't help here
   // since the alloc's for example are identical except for the SSA id.
-  SmallMapVector<Value *, std::unique_ptr<MemRefRegion>, 4> readRegions;
-  SmallMapVector<Value *, std::unique_ptr<MemRefRegion>, 4> writeRegions;
+  RegionMap readRegions;
+  RegionMap writeRegions;
 
   // Map from original memref's to the DMA buffers that their accesses are
   // replaced with.
@@ -118,14 +136,24 @@ struct DmaGeneration : public FunctionPass<DmaGeneration> {
 
   // Constant zero index to avoid too many duplicates.
   Value *zeroIndex = nullptr;
+
+  /// Statistics of this pass.
+  Statistic numBuffers = {this, "num-dma-buffers",
+                          "Number of DMA buffers allocated in fast memory"};
+  Statistic numDmas = {this, "num-dmas", "Number of DMA operations generated"};
+  Statistic footprintKiB = {
+      this, "dma-footprint-kib",
+      "Total size in KiB of the DMA buffers at the chosen depths"};
+  Statistic numDeeperPlacements = {
+      this, "num-deeper-placements",
+      "Number of loops whose footprint exceeds the fast memory capacity"};
 };
 
 } // end anonymous namespace
 
 /// Generates DMAs for memref's living in 'slowMemorySpace' into newly created
 /// buffers in 'fastMemorySpace', and replaces memory operations to the former
-/// by the latter. Only load op's handled for now.
-/// TODO(bondhugula): extend this to store op's.
+/// by the latter.
 FunctionPassBase *mlir::createDmaGenerationPass(unsigned slowMemorySpace,
                                                 unsigned fastMemorySpace,
                                                 int minDmaTransferSize,
@@ -134,28 +162,76 @@ FunctionPassBase *mlir::createDmaGenerationPass(unsigned slowMemorySpace,
                            fastMemCapacityBytes);
 }
 
+FunctionPassBase *
+mlir::createDmaGenerationPass(unsigned slowMemorySpace,
+                              unsigned fastMemorySpace, int minDmaTransferSize,
+                              const TargetMemoryModel &memoryModel) {
+  return new DmaGeneration(slowMemorySpace, fastMemorySpace, minDmaTransferSize,
+                           memoryModel.getFastMemoryCapacity());
+}
+
 // Info comprising stride and number of elements transferred every stride.
 struct StrideInfo {
   int64_t stride;
   int64_t numEltPerStride;
 };
 
+/// Returns true if the layout of 'memRefType' is the identity, or a strided
+/// layout with static strides in which each dimension is nested in the next
+/// major one, as in a view of a tile of a larger row-major memref.  The offset
+/// of the layout may be dynamic.
+static bool hasRowMajorLayout(MemRefType memRefType) {
+  if (memRefType.getAffineMaps().empty())
+    return true;
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memRefType, strides, offset)))
+    return false;
+  if (strides.empty())
+    return true;
+  if (strides.back() != 1)
+    return false;
+  // Check from the innermost dimension, whose stride is known to be positive.
+  for (unsigned d = strides.size() - 1; d >= 1; --d) {
+    int64_t dimSize = memRefType.getDimSize(d);
+    if (strides[d - 1] == MemRefType::kDynamicStrideOrOffset ||
+        strides[d - 1] <= 0 || strides[d - 1] % strides[d] != 0 ||
+        dimSize < 0 || strides[d - 1] / strides[d] < dimSize)
+      return false;
+  }
+  return true;
+}
+
 /// Returns striding information for a copy/transfer of this region with
 /// potentially multiple striding levels from outermost to innermost. For an
 /// n-dimensional region, there can be at most n-1 levels of striding
-/// successively nested.
-//  TODO(bondhugula): make this work with non-identity layout maps.
+/// successively nested.  The layout of the memref is expected to satisfy
+/// 'hasRowMajorLayout': the extent of a strided layout along a dimension is
+/// then the ratio of the strides of the next major dimension and this one.
 static void getMultiLevelStrides(const MemRefRegion &region,
                                  ArrayRef<int64_t> bufferShape,
                                  SmallVectorImpl<StrideInfo> *strideInfos) {
   if (bufferShape.size() <= 1)
     return;
 
+  auto memRefType = region.memref->getType().cast<MemRefType>();
+  SmallVector<int64_t, 4> layoutStrides;
+  int64_t offset;
+  bool isStrided = !memRefType.getAffineMaps().empty() &&
+                   succeeded(getStridesAndOffset(memRefType, layoutStrides,
+                                                 offset));
+
   int64_t numEltPerStride = 1;
   int64_t stride = 1;
   for (int d = bufferShape.size() - 1; d >= 1; d--) {
-    int64_t dimSize = region.memref->getType().cast<MemRefType>().getDimSize(d);
-    stride *= dimSize;
+    int64_t dimSize;
+    if (isStrided) {
+      dimSize = layoutStrides[d - 1] / layoutStrides[d];
+      stride = layoutStrides[d - 1];
+    } else {
+      dimSize = memRefType.getDimSize(d);
+      stride *= dimSize;
+    }
     numEltPerStride *= bufferShape[d];
     // A stride is needed only if the region has a shorter extent than the
     // memref along the dimension *and* has an extent greater than one along the
@@ -164,6 +240,79 @@ static void getMultiLevelStrides(const MemRefRegion &region,
       strideInfos->push_back({stride, numEltPerStride});
     }
   }
+  // The levels were found from the innermost one.
+  std::reverse(strideInfos->begin(), strideInfos->end());
+}
+
+/// Returns true if 'storeOp' is known to write every element of the memory
+/// region it accesses in the loops at depth 'dmaDepth' and deeper, so that the
+/// region need not be copied in before being written back. This is the case
+/// when the store is only nested in these loops, their bounds don't depend on
+/// one another, and each access function is either invariant in them or a unit
+/// coefficient times the IV of a unit step loop that no other one uses.
+static bool isDenseWrite(StoreOp storeOp, unsigned dmaDepth) {
+  Operation *opInst = storeOp.getOperation();
+  SmallVector<AffineForOp, 4> ivs;
+  getLoopIVs(*opInst, &ivs);
+  assert(ivs.size() >= dmaDepth && "the store is nested at 'dmaDepth'");
+  ivs.erase(ivs.begin(), ivs.begin() + dmaDepth);
+
+  // The store shouldn't be guarded by anything but these loops.
+  Operation *parent = opInst->getParentOp();
+  for (auto it = ivs.rbegin(), e = ivs.rend(); it != e; ++it) {
+    if (parent != it->getOperation())
+      return false;
+    parent = parent->getParentOp();
+  }
+
+  SmallVector<Value *, 4> innerIVs;
+  extractForInductionVars(ivs, &innerIVs);
+  // Returns true if 'value' varies with the IVs of the loops in 'ivs'.
+  auto isVariant = [&](Value *value) {
+    if (llvm::is_contained(innerIVs, value))
+      return true;
+    auto *defOp = value->getDefiningOp();
+    return !ivs.empty() && defOp &&
+           ivs.front().getBody()->findAncestorInstInBlock(*defOp);
+  };
+  for (auto forOp : ivs) {
+    if (llvm::any_of(forOp.getLowerBoundOperands(), isVariant) ||
+        llvm::any_of(forOp.getUpperBoundOperands(), isVariant))
+      return false;
+  }
+
+  AffineValueMap accessValueMap;
+  MemRefAccess(opInst).getAccessMap(&accessValueMap);
+  AffineMap accessMap = accessValueMap.getAffineMap();
+  std::vector<SmallVector<int64_t, 8>> flatExprs;
+  if (!getFlattenedAffineExprs(accessMap, &flatExprs))
+    return false;
+
+  SmallVector<bool, 4> isIVUsed(ivs.size(), false);
+  unsigned numOperands = accessValueMap.getNumOperands();
+  for (const auto &flatExpr : flatExprs) {
+    // Semi-affine accesses through div's and mod's introduce local ids.
+    if (flatExpr.size() != numOperands + 1)
+      return false;
+    bool hasIV = false;
+    for (unsigned j = 0; j < numOperands; ++j) {
+      if (flatExpr[j] == 0)
+        continue;
+      auto *operand = accessValueMap.getOperand(j);
+      auto it = llvm::find(innerIVs, operand);
+      if (it == innerIVs.end()) {
+        if (isVariant(operand))
+          return false;
+        continue;
+      }
+      unsigned pos = std::distance(innerIVs.begin(), it);
+      if (hasIV || isIVUsed[pos] || std::abs(flatExpr[j]) != 1 ||
+          ivs[pos].getStep() != 1)
+        return false;
+      hasIV = isIVUsed[pos] = true;
+    }
+  }
+  return true;
 }
 
 /// Construct the memref region to just include the entire memref. Returns false
@@ -256,10 +405,8 @@ bool DmaGeneration::generateDma(const MemRefRegion &region, Block *block,
   auto *memref = region.memref;
   auto memRefType = memref->getType().cast<MemRefType>();
 
-  auto layoutMaps = memRefType.getAffineMaps();
-  if (layoutMaps.size() > 1 ||
-      (layoutMaps.size() == 1 && !layoutMaps[0].isIdentity())) {
-    LLVM_DEBUG(llvm::dbgs() << "Non-identity layout map not yet supported\n");
+  if (!hasRowMajorLayout(memRefType)) {
+    LLVM_DEBUG(llvm::dbgs() << "Non-row-major layout map not yet supported\n");
     return false;
   }
 
@@ -354,6 +501,7 @@ bool DmaGeneration::generateDma(const MemRefRegion &region, Block *block,
     fastMemRef = prologue.create<AllocOp>(loc, fastMemRefType).getResult();
     // Record it.
     fastBufferMap[memref] = fastMemRef;
+    ++numBuffers;
     // fastMemRefType is a constant shaped memref.
     *sizeInBytes = getMemRefSizeInBytes(fastMemRefType).getValue();
     LLVM_DEBUG(std::string ss; llvm::raw_string_ostream oss(ss);
@@ -376,19 +524,13 @@ bool DmaGeneration::generateDma(const MemRefRegion &region, Block *block,
   SmallVector<StrideInfo, 4> strideInfos;
   getMultiLevelStrides(region, fastBufferShape, &strideInfos);
 
-  // TODO(bondhugula): use all stride levels once DmaStartOp is extended for
-  // multi-level strides.
-  if (strideInfos.size() > 1) {
-    LLVM_DEBUG(llvm::dbgs() << "Only up to one level of stride supported\n");
-    return false;
-  }
-
-  Value *stride = nullptr;
-  Value *numEltPerStride = nullptr;
-  if (!strideInfos.empty()) {
-    stride = top.create<ConstantIndexOp>(loc, strideInfos[0].stride);
-    numEltPerStride =
-        top.create<ConstantIndexOp>(loc, strideInfos[0].numEltPerStride);
+  // The DMA uses all stride levels, from the outermost to the innermost.
+  SmallVector<Value *, 4> strides;
+  SmallVector<Value *, 4> numEltPerStride;
+  for (const auto &strideInfo : strideInfos) {
+    strides.push_back(top.create<ConstantIndexOp>(loc, strideInfo.stride));
+    numEltPerStride.push_back(
+        top.create<ConstantIndexOp>(loc, strideInfo.numEltPerStride));
   }
 
   // Record the last operation just before the point where we insert the
@@ -400,18 +542,20 @@ bool DmaGeneration::generateDma(const MemRefRegion &region, Block *block,
   if (!region.isWrite()) {
     // DMA non-blocking read from original buffer to fast buffer.
     b->create<DmaStartOp>(loc, memref, memIndices, fastMemRef, bufIndices,
-                          numElementsSSA, tagMemRef, zeroIndex, stride,
+                          numElementsSSA, tagMemRef, zeroIndex, strides,
                           numEltPerStride);
   } else {
     // DMA non-blocking write from fast buffer to the original memref.
     auto op = b->create<DmaStartOp>(loc, fastMemRef, bufIndices, memref,
                                     memIndices, numElementsSSA, tagMemRef,
-                                    zeroIndex, stride, numEltPerStride);
+                                    zeroIndex, strides, numEltPerStride);
     // Since new ops are being appended (for outgoing DMAs), adjust the end to
     // mark end of range of the original.
     *nEnd = Block::iterator(op.getOperation());
   }
 
+  ++numDmas;
+
   // Matching DMA wait to block on completion; tag always has a 0 index.
   b->create<DmaWaitOp>(loc, tagMemRef, zeroIndex, numElementsSSA);
 
@@ -489,25 +633,39 @@ bool DmaGeneration::runOnBlock(Block *block) {
 
   for (auto it = curBegin; it != block->end(); ++it) {
     if (auto forOp = it->dyn_cast<AffineForOp>()) {
-      // Returns true if the footprint is known to exceed capacity.
-      auto exceedsCapacity = [&](AffineForOp forOp) {
-        Optional<int64_t> footprint =
-            getMemoryFootprintBytes(forOp,
-                                    /*memorySpace=*/0);
-        return (footprint.hasValue() &&
-                static_cast<uint64_t>(footprint.getValue()) >
-                    fastMemCapacityBytes);
+      // Returns true if the footprint is known to exceed capacity. The
+      // footprint is that of the buffers DMA generation would allocate for
+      // the loop, i.e., of the regions of the memref's in the slower memory
+      // space that it accesses.
+      auto exceedsCapacity = [&](Block::iterator forIt) -> bool {
+        // There is no need to recurse once the budget of the pass is
+        // exhausted, as no DMA is generated anymore.
+        if (!consumeBudget())
+          return false;
+        Optional<uint64_t> footprint =
+            getDmaFootprintBytes(forIt, std::next(forIt));
+        LLVM_DEBUG({
+          if (footprint.hasValue())
+            llvm::dbgs() << "Footprint at depth " << getNestingDepth(*forIt)
+                         << ": " << llvm::divideCeil(footprint.getValue(), 1024)
+                         << " KiB\n";
+        });
+        return footprint.hasValue() &&
+               footprint.getValue() > fastMemCapacityBytes;
       };
 
       // If the memory footprint of the 'affine.for' loop is higher than fast
       // memory capacity (when provided), we recurse to DMA at an inner level
-      // until we find a depth at which footprint fits in fast mem capacity. If
-      // the footprint can't be calculated, we assume for now it fits. Recurse
-      // inside if footprint for 'forOp' exceeds capacity, or when
-      // clSkipNonUnitStrideLoop is set and the step size is not one.
+      // until we find a depth at which footprint fits in fast mem capacity,
+      // i.e., the outermost one at which it does. If the footprint can't be
+      // calculated, we assume for now it fits. Recurse inside if footprint for
+      // 'forOp' exceeds capacity, or when clSkipNonUnitStrideLoop is set and
+      // the step size is not one.
       bool recurseInner = clSkipNonUnitStrideLoop ? forOp.getStep() != 1
-                                                  : exceedsCapacity(forOp);
+                                                  : exceedsCapacity(it);
       if (recurseInner) {
+        if (!clSkipNonUnitStrideLoop)
+          ++numDeeperPlacements;
         // We'll recurse and do the DMAs at an inner level for 'forInst'.
         runOnBlock(/*begin=*/curBegin, /*end=*/it);
         // Recurse onto the body of this loop.
@@ -582,35 +740,26 @@ findHighestBlockForPlacement(const MemRefRegion &region, Block &block,
   }
 }
 
-/// Generates DMAs for a contiguous sequence of operations in `block` in the
-/// iterator range [begin, end). Returns the total size of the DMA buffers used.
-//  Since we generate alloc's and dealloc's for all DMA buffers (before and
-//  after the range of operations resp), all of the fast memory capacity is
-//  assumed to be available.
-uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
-  if (begin == end)
-    return 0;
-
-  assert(begin->getBlock() == std::prev(end)->getBlock() &&
-         "Inconsistent args");
-
-  Block *block = begin->getBlock();
-
-  // DMAs will be generated for this depth, i.e., symbolic in all loops
-  // surrounding the region of this block.
+/// Gathers in 'readRegions' and 'writeRegions' the regions of the memref's in
+/// the slower memory space that the operations in the range [begin, end) of a
+/// block read and write respectively, symbolic in the loops surrounding the
+/// range. A memref that is both read and written has the same region in both,
+/// and a written region that may not be entirely written is read as well.
+/// Returns failure if a region could not be computed nor over-approximated.
+LogicalResult DmaGeneration::computeRegions(Block::iterator begin,
+                                            Block::iterator end,
+                                            RegionMap *readRegions,
+                                            RegionMap *writeRegions) {
   unsigned dmaDepth = getNestingDepth(*begin);
 
-  LLVM_DEBUG(llvm::dbgs() << "Generating DMAs at depth " << dmaDepth << "\n");
-
-  readRegions.clear();
-  writeRegions.clear();
-  fastBufferMap.clear();
+  // Memrefs whose written region may not be entirely written by the stores.
+  SmallPtrSet<Value *, 4> partiallyWrittenMemRefs;
 
   // To check for errors when walking the block.
   bool error = false;
 
   // Walk this range of operations  to gather all memory regions.
-  block->walk(begin, end, [&](Operation *opInst) {
+  begin->getBlock()->walk(begin, end, [&](Operation *opInst) {
     // Gather regions to allocate to buffers in faster memory space.
     if (auto loadOp = opInst->dyn_cast<LoadOp>()) {
       if (loadOp.getMemRefType().getMemorySpace() != slowMemorySpace)
@@ -652,8 +801,7 @@ uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
 
     // Attempts to update; returns true if 'region' exists in targetRegions.
     auto updateRegion =
-        [&](const SmallMapVector<Value *, std::unique_ptr<MemRefRegion>, 4>
-                &targetRegions) {
+        [&](const RegionMap &targetRegions) {
           auto it = targetRegions.find(region->memref);
           if (it == targetRegions.end())
             return false;
@@ -676,22 +824,114 @@ uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
           return true;
         };
 
-    bool existsInRead = updateRegion(readRegions);
+    bool existsInRead = updateRegion(*readRegions);
     if (error)
       return;
-    bool existsInWrite = updateRegion(writeRegions);
+    bool existsInWrite = updateRegion(*writeRegions);
     if (error)
       return;
 
-    // Finally add it to the region list.
+    // The union of the regions written by several stores may have holes.
+    if (auto storeOp = opInst->dyn_cast<StoreOp>()) {
+      if (existsInWrite || !isDenseWrite(storeOp, dmaDepth))
+        partiallyWrittenMemRefs.insert(region->memref);
+    }
+
+    // Finally add it to the region list. When the memref already has a region
+    // in the other list, the new region is the bounding box of all accesses
+    // seen so far, which that region now is after the update above.
     if (region->isWrite() && !existsInWrite) {
-      writeRegions[region->memref] = std::move(region);
+      if (existsInRead)
+        region->getConstraints()->clearAndCopyFrom(
+            *(*readRegions)[region->memref]->getConstraints());
+      (*writeRegions)[region->memref] = std::move(region);
     } else if (!region->isWrite() && !existsInRead) {
-      readRegions[region->memref] = std::move(region);
+      if (existsInWrite)
+        region->getConstraints()->clearAndCopyFrom(
+            *(*writeRegions)[region->memref]->getConstraints());
+      (*readRegions)[region->memref] = std::move(region);
     }
   });
 
-  if (error) {
+  if (error)
+    return failure();
+
+  // A written region that isn't read is copied in as well unless the stores
+  // are known to write all of it, since writing it back would otherwise
+  // clobber the elements left untouched with undefined values.
+  for (const auto &regionEntry : *writeRegions) {
+    auto *memref = regionEntry.first;
+    if (readRegions->count(memref) || !partiallyWrittenMemRefs.count(memref))
+      continue;
+    auto readRegion = llvm::make_unique<MemRefRegion>(regionEntry.second->loc);
+    readRegion->memref = memref;
+    readRegion->setWrite(false);
+    readRegion->getConstraints()->clearAndCopyFrom(
+        *regionEntry.second->getConstraints());
+    (*readRegions)[memref] = std::move(readRegion);
+  }
+
+  return success();
+}
+
+/// Returns the total size in bytes of the fast memory buffers that DMA
+/// generation for the range of operations [begin, end) would allocate, or None
+/// if it can't be determined.
+Optional<uint64_t> DmaGeneration::getDmaFootprintBytes(Block::iterator begin,
+                                                      Block::iterator end) {
+  RegionMap footprintReadRegions, footprintWriteRegions;
+  if (failed(computeRegions(begin, end, &footprintReadRegions,
+                            &footprintWriteRegions)))
+    return None;
+
+  // A memref that is both read and written has a single buffer.
+  uint64_t footprintBytes = 0;
+  auto addRegionSizes = [&](const RegionMap &regions, bool skipRead) {
+    for (const auto &regionEntry : regions) {
+      if (skipRead && footprintReadRegions.count(regionEntry.first))
+        continue;
+      Optional<int64_t> size = regionEntry.second->getRegionSize();
+      if (!size.hasValue())
+        return false;
+      footprintBytes += size.getValue();
+    }
+    return true;
+  };
+  if (!addRegionSizes(footprintReadRegions, /*skipRead=*/false) ||
+      !addRegionSizes(footprintWriteRegions, /*skipRead=*/true))
+    return None;
+  return footprintBytes;
+}
+
+/// Generates DMAs for a contiguous sequence of operations in `block` in the
+/// iterator range [begin, end). Returns the total size of the DMA buffers used.
+//  Since we generate alloc's and dealloc's for all DMA buffers (before and
+//  after the range of operations resp), all of the fast memory capacity is
+//  assumed to be available.
+uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
+  if (begin == end)
+    return 0;
+
+  assert(begin->getBlock() == std::prev(end)->getBlock() &&
+         "Inconsistent args");
+
+  Block *block = begin->getBlock();
+
+  // Leave the accesses of the range to the slow memory space once the budget
+  // of the pass is exhausted.
+  if (!consumeBudget())
+    return 0;
+
+  // DMAs will be generated for this depth, i.e., symbolic in all loops
+  // surrounding the region of this block.
+  LLVM_DEBUG(llvm::dbgs() << "Generating DMAs at depth "
+                          << getNestingDepth(*begin) << "\n");
+
+  readRegions.clear();
+  writeRegions.clear();
+  fastBufferMap.clear();
+
+  if (failed(computeRegions(begin, end, &readRegions, &writeRegions))) {
     begin->emitError(
         "DMA generation failed for one or more memref's in this block\n");
     return 0;
@@ -699,35 +939,33 @@ uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
 
   uint64_t totalDmaBuffersSizeInBytes = 0;
   bool ret = true;
-  auto processRegions =
-      [&](const SmallMapVector<Value *, std::unique_ptr<MemRefRegion>, 4>
-              &regions) {
-        for (const auto &regionEntry : regions) {
-          // For each region, hoist DMA transfer past all invariant
-          // 'affine.for's.
-          Block::iterator dmaPlacementReadStart, dmaPlacementWriteStart;
-          Block *dmaPlacementBlock;
-          findHighestBlockForPlacement(
-              *regionEntry.second, *block, begin, end, &dmaPlacementBlock,
-              &dmaPlacementReadStart, &dmaPlacementWriteStart);
-
-          uint64_t sizeInBytes;
-          Block::iterator nBegin, nEnd;
-          bool iRet = generateDma(*regionEntry.second, dmaPlacementBlock,
-                                  dmaPlacementReadStart, dmaPlacementWriteStart,
-                                  &sizeInBytes, &nBegin, &nEnd);
-          if (iRet) {
-            // dmaPlacmentStart/End (or begin/end) may be invalidated; use
-            // nBegin, nEnd to reset.
-            if (dmaPlacementBlock == block) {
-              begin = nBegin;
-              end = nEnd;
-            }
-            totalDmaBuffersSizeInBytes += sizeInBytes;
-          }
-          ret = ret & iRet;
+  auto processRegions = [&](const RegionMap &regions) {
+    for (const auto &regionEntry : regions) {
+      // For each region, hoist DMA transfer past all invariant
+      // 'affine.for's.
+      Block::iterator dmaPlacementReadStart, dmaPlacementWriteStart;
+      Block *dmaPlacementBlock;
+      findHighestBlockForPlacement(
+          *regionEntry.second, *block, begin, end, &dmaPlacementBlock,
+          &dmaPlacementReadStart, &dmaPlacementWriteStart);
+
+      uint64_t sizeInBytes;
+      Block::iterator nBegin, nEnd;
+      bool iRet = generateDma(*regionEntry.second, dmaPlacementBlock,
+                              dmaPlacementReadStart, dmaPlacementWriteStart,
+                              &sizeInBytes, &nBegin, &nEnd);
+      if (iRet) {
+        // dmaPlacmentStart/End (or begin/end) may be invalidated; use
+        // nBegin, nEnd to reset.
+        if (dmaPlacementBlock == block) {
+          begin = nBegin;
+          end = nEnd;
         }
-      };
+        totalDmaBuffersSizeInBytes += sizeInBytes;
+      }
+      ret = ret & iRet;
+    }
+  };
   processRegions(readRegions);
   processRegions(writeRegions);
 
@@ -740,6 +978,7 @@ uint64_t DmaGeneration::runOnBlock(Block::iterator begin, Block::iterator end) {
   // For a range of operations, a note will be emitted at the caller.
   AffineForOp forOp;
   uint64_t sizeInKib = llvm::divideCeil(totalDmaBuffersSizeInBytes, 1024);
+  footprintKiB += sizeInKib;
   if (llvm::DebugFlag && (forOp = begin->dyn_cast<AffineForOp>())) {
     forOp.emitNote(Twine(sizeInKib) +
                    " KiB of DMA buffers in fast memory space for this block\n");
@@ -0,0 +1,143 @@
+//===- FMAFormation.cpp - Contract multiplications and additions ----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass contracting the 'mulf' operations whose only
+// user is an 'addf' operation into an 'fmaf' operation, which the conversion
+// to the LLVM IR dialect lowers to the 'llvm.fmuladd' intrinsic.  Which pairs
+// are contracted is decided by a contraction policy, which the "fp_contract"
+// attribute of a function overrides.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "form-fma"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<FPContractionPolicy> clContractionPolicy(
+    "fma-contract",
+    llvm::cl::desc("Which multiplications and additions may be contracted"),
+    llvm::cl::values(
+        clEnumValN(FPContractionPolicy::Off, "off", "Never contract"),
+        clEnumValN(FPContractionPolicy::On, "on",
+                   "Contract the operations allowing it with their "
+                   "'fastmath' attribute"),
+        clEnumValN(FPContractionPolicy::Fast, "fast", "Always contract")),
+    llvm::cl::init(FPContractionPolicy::On), llvm::cl::cat(clOptionsCategory));
+
+// Return true if the "fastmath" attribute of `op` allows contracting it.
+static bool allowsContraction(Operation *op) {
+  auto flags = op->getAttrOfType<ArrayAttr>("fastmath");
+  if (!flags)
+    return false;
+  for (Attribute flag : flags) {
+    auto name = flag.dyn_cast<StringAttr>();
+    if (name && (name.getValue() == "contract" || name.getValue() == "fast"))
+      return true;
+  }
+  return false;
+}
+
+namespace {
+/// Contract `addf(mulf(a, b), c)` and `addf(c, mulf(a, b))` into
+/// `fmaf(a, b, c)` when the multiplication has no other user, so that it isn't
+/// computed twice.  The multiply-add keeps the attributes of the addition.
+class FMAFormation : public RewritePattern {
+public:
+  FMAFormation(MLIRContext *context, FPContractionPolicy policy)
+      : RewritePattern(AddFOp::getOperationName(), 1, context),
+        policy(policy) {}
+
+  PatternMatchResult matchAndRewrite(Operation *op,
+                                     PatternRewriter &rewriter) const override {
+    FPContractionPolicy functionPolicy = getFunctionPolicy(op);
+    if (functionPolicy == FPContractionPolicy::Off)
+      return matchFailure();
+
+    for (unsigned i = 0; i < 2; ++i) {
+      Operation *mulOp = op->getOperand(i)->getDefiningOp();
+      if (!mulOp || !mulOp->isa<MulFOp>() ||
+          !mulOp->getResult(0)->hasOneUse())
+        continue;
+      if (functionPolicy == FPContractionPolicy::On &&
+          (!allowsContraction(op) || !allowsContraction(mulOp)))
+        continue;
+
+      Value *operands[] = {mulOp->getOperand(0), mulOp->getOperand(1),
+                           op->getOperand(1 - i)};
+      auto fmaOp = rewriter.create<FmaFOp>(
+          op->getLoc(), op->getResult(0)->getType(), operands, op->getAttrs());
+      rewriter.replaceOp(op, fmaOp.getResult());
+      return matchSuccess();
+    }
+    return matchFailure();
+  }
+
+private:
+  /// Return the policy set by the "fp_contract" attribute of the function
+  /// containing `op`, or the one of the pattern if there is none.
+  FPContractionPolicy getFunctionPolicy(Operation *op) const {
+    auto attr = op->getFunction()->getAttrOfType<StringAttr>("fp_contract");
+    if (!attr)
+      return policy;
+    return llvm::StringSwitch<FPContractionPolicy>(attr.getValue())
+        .Case("off", FPContractionPolicy::Off)
+        .Case("on", FPContractionPolicy::On)
+        .Case("fast", FPContractionPolicy::Fast)
+        .Default(policy);
+  }
+
+  FPContractionPolicy policy;
+};
+
+struct FMAFormationPass : public FunctionPass<FMAFormationPass> {
+  explicit FMAFormationPass(FPContractionPolicy policy) : policy(policy) {}
+  FMAFormationPass() : policy(clContractionPolicy) {}
+
+  void runOnFunction() override;
+
+  FPContractionPolicy policy;
+};
+} // end anonymous namespace
+
+void mlir::populateFMAFormationPatterns(OwningRewritePatternList &patterns,
+                                        MLIRContext *context,
+                                        FPContractionPolicy policy) {
+  patterns.push_back(llvm::make_unique<FMAFormation>(context, policy));
+}
+
+void FMAFormationPass::runOnFunction() {
+  OwningRewritePatternList patterns;
+  populateFMAFormationPatterns(patterns, &getContext(), policy);
+  applyPatternsGreedily(getFunction(), std::move(patterns));
+}
+
+FunctionPassBase *mlir::createFMAFormationPass(FPContractionPolicy policy) {
+  return new FMAFormationPass(policy);
+}
+
+static PassRegistration<FMAFormationPass>
+    pass("form-fma", "Contract floating point multiplications and additions "
+                     "into multiply-adds");
@@ -0,0 +1,263 @@
+//===- GVN.cpp - Global Value Numbering -----------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This transformation pass performs a global value numbering of the operations
+// within a function. Compared to CSE, it also merges commutative operations
+// whose operands only differ in their order, affine.apply ops computing the
+// same function of the same values once composed with the affine.apply ops
+// feeding them, and loads of the same memref element that no store in between
+// may write to.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/Dominance.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/ScopedHashTable.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/RecyclingAllocator.h"
+
+#define DEBUG_TYPE "gvn"
+
+using namespace mlir;
+
+namespace {
+/// Hashes and compares operations based upon their name, attributes, result
+/// types and operands, where the operands of commutative operations are
+/// compared regardless of their order.
+struct ValueNumberInfo : public llvm::DenseMapInfo<Operation *> {
+  /// Returns the operands of 'op', sorted if 'op' is commutative.
+  static SmallVector<Value *, 4> getCanonicalOperands(Operation *op) {
+    SmallVector<Value *, 4> operands(op->operand_begin(), op->operand_end());
+    if (op->isCommutative())
+      llvm::array_pod_sort(operands.begin(), operands.end());
+    return operands;
+  }
+
+  static unsigned getHashValue(const Operation *opC) {
+    auto *op = const_cast<Operation *>(opC);
+    auto operands = getCanonicalOperands(op);
+    return hash_combine(
+        op->getName(), op->getAttrs(),
+        hash_combine_range(op->result_type_begin(), op->result_type_end()),
+        hash_combine_range(operands.begin(), operands.end()));
+  }
+  static bool isEqual(const Operation *lhsC, const Operation *rhsC) {
+    auto *lhs = const_cast<Operation *>(lhsC);
+    auto *rhs = const_cast<Operation *>(rhsC);
+    if (lhs == rhs)
+      return true;
+    if (lhs == getTombstoneKey() || lhs == getEmptyKey() ||
+        rhs == getTombstoneKey() || rhs == getEmptyKey())
+      return false;
+
+    if (lhs->getName() != rhs->getName() ||
+        lhs->getNumOperands() != rhs->getNumOperands() ||
+        lhs->getNumResults() != rhs->getNumResults() ||
+        lhs->getAttrs() != rhs->getAttrs())
+      return false;
+    if (getCanonicalOperands(lhs) != getCanonicalOperands(rhs))
+      return false;
+    return std::equal(lhs->result_type_begin(), lhs->result_type_end(),
+                      rhs->result_type_begin());
+  }
+};
+
+/// Global value numbering.
+struct GVN : public FunctionPass<GVN> {
+  GVN() = default;
+  GVN(const GVN &) {}
+
+  using AllocatorTy = llvm::RecyclingAllocator<
+      llvm::BumpPtrAllocator,
+      llvm::ScopedHashTableVal<Operation *, Operation *>>;
+  using ScopedMapTy = llvm::ScopedHashTable<Operation *, Operation *,
+                                            ValueNumberInfo, AllocatorTy>;
+
+  /// Rewrites the affine.apply ops of the function so that their operands are
+  /// not themselves computed by affine.apply ops, and erases those left dead.
+  /// Returns true if the function was modified.
+  bool normalizeAffineApplies(Function &f);
+
+  /// Replaces 'op' with an equivalent operation dominating it, if any.
+  void numberOperation(Operation *op);
+  void numberBlock(Block *block);
+  void numberDomTreeNode(DominanceInfoNode *node);
+  void numberRegion(Region &region);
+
+  void runOnFunction() override;
+
+private:
+  DominanceInfo *domInfo = nullptr;
+
+  /// A scoped hash table of the operations dominating the current one.
+  ScopedMapTy knownValues;
+
+  /// Operations replaced with an equivalent one or trivially dead, to be
+  /// erased.
+  std::vector<Operation *> opsToErase;
+
+  /// Statistics of this pass.
+  Statistic numApplies = {this, "num-applies-normalized",
+                          "Number of affine.apply ops composed"};
+  Statistic numGVN = {this, "num-gvn'd",
+                      "Number of operations replaced with an equivalent one"};
+  Statistic numLoads = {this, "num-loads-gvn'd",
+                        "Number of loads replaced with an equivalent one"};
+};
+} // end anonymous namespace
+
+bool GVN::normalizeAffineApplies(Function &f) {
+  SmallVector<Operation *, 16> applyOps;
+  f.walk([&](AffineApplyOp applyOp) {
+    applyOps.push_back(applyOp.getOperation());
+  });
+
+  bool changed = false;
+  for (auto *op : applyOps) {
+    auto applyOp = op->cast<AffineApplyOp>();
+    AffineMap map = applyOp.getAffineMap();
+    SmallVector<Value *, 4> operands(op->operand_begin(), op->operand_end());
+    fullyComposeAffineMapAndOperands(&map, &operands);
+    canonicalizeMapAndOperands(&map, &operands);
+    if (map == applyOp.getAffineMap() &&
+        operands.size() == op->getNumOperands() &&
+        std::equal(operands.begin(), operands.end(), op->operand_begin()))
+      continue;
+
+    FuncBuilder b(op);
+    auto newApplyOp = b.create<AffineApplyOp>(op->getLoc(), map, operands);
+    op->getResult(0)->replaceAllUsesWith(newApplyOp.getResult());
+    ++numApplies;
+    changed = true;
+  }
+
+  // The affine.apply ops replaced above, and those that only fed them, are now
+  // dead. Erase them, users first.
+  for (auto *op : llvm::reverse(applyOps)) {
+    if (op->use_empty()) {
+      op->erase();
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void GVN::numberOperation(Operation *op) {
+  // Like CSE, don't number operations holding regions, nor operations with
+  // side effects other than loads.
+  if (op->getNumRegions() != 0)
+    return;
+  auto loadOp = op->dyn_cast<LoadOp>();
+  if (!loadOp && !op->hasNoSideEffect())
+    return;
+
+  if (op->use_empty()) {
+    if (!loadOp)
+      opsToErase.push_back(op);
+    return;
+  }
+
+  // Loads are only numbered when no other memref may alias theirs, and an
+  // equivalent load only replaces them if no store in between may write to the
+  // element they read.
+  if (loadOp && !isLocalMemRef(loadOp.getMemRef()))
+    return;
+  auto *existing = knownValues.lookup(op);
+  if (existing && loadOp && isWrittenBetween(existing, op))
+    existing = nullptr;
+
+  // If there is no equivalent operation, this one is inserted in the table in
+  // place of an earlier one that the later operations can't be replaced with.
+  if (!existing) {
+    knownValues.insert(op, op);
+    return;
+  }
+
+  for (unsigned i = 0, e = existing->getNumResults(); i != e; ++i)
+    op->getResult(i)->replaceAllUsesWith(existing->getResult(i));
+  opsToErase.push_back(op);
+  if (loadOp)
+    ++numLoads;
+  else
+    ++numGVN;
+
+  // If the existing operation has an unknown location and the current
+  // operation doesn't, then set the existing op's location to that of the
+  // current op.
+  if (existing->getLoc().isa<UnknownLoc>() && !op->getLoc().isa<UnknownLoc>())
+    existing->setLoc(op->getLoc());
+}
+
+void GVN::numberBlock(Block *block) {
+  for (auto &op : *block) {
+    numberOperation(&op);
+    for (auto &region : op.getRegions())
+      numberRegion(region);
+  }
+}
+
+void GVN::numberDomTreeNode(DominanceInfoNode *node) {
+  ScopedMapTy::ScopeTy scope(knownValues);
+  numberBlock(node->getBlock());
+  for (auto *child : *node)
+    numberDomTreeNode(child);
+}
+
+void GVN::numberRegion(Region &region) {
+  if (region.empty())
+    return;
+  numberDomTreeNode(domInfo->getRootNode(&region));
+}
+
+void GVN::runOnFunction() {
+  Function &f = getFunction();
+  // The affine.apply ops are normalized first, so that equivalent ones end up
+  // with identical maps and operands, and so do the loads using them once
+  // those are numbered.
+  bool changed = normalizeAffineApplies(f);
+
+  domInfo = &getAnalysis<DominanceInfo>();
+  numberRegion(f.getBody());
+
+  changed |= !opsToErase.empty();
+  for (auto *op : opsToErase)
+    op->erase();
+  opsToErase.clear();
+
+  if (!changed) {
+    markAllAnalysesPreserved();
+    return;
+  }
+  // No block or region is created nor erased.
+  markAnalysesPreserved<DominanceInfo, PostDominanceInfo>();
+}
+
+/// Creates a pass to perform global value numbering.
+FunctionPassBase *mlir::createGVNPass() { return new GVN(); }
+
+static PassRegistration<GVN>
+    pass("gvn", "Global value numbering of operations, affine.apply ops whose "
+                "compositions are equal, and loads");
@@ -0,0 +1,222 @@
+//===- Inliner.cpp - Inline direct calls to small functions ---------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that inlines the direct 'call' operations to the
+// functions of the module whose body is smaller than a threshold.  The call
+// graph is traversed bottom-up, so that the callees are simplified by inlining
+// before their own size is considered.  The functions of the same level of the
+// call graph only read the functions of the lower levels, and they are
+// processed in parallel on the thread pool of the context.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Dialect.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/Threading.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "inline"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clInlineThreshold(
+    "inline-threshold",
+    llvm::cl::desc("Inline the functions containing at most this many "
+                   "operations"),
+    llvm::cl::init(32), llvm::cl::cat(clOptionsCategory));
+
+namespace {
+struct Inliner : public ModulePass<Inliner> {
+  explicit Inliner(int threshold = -1)
+      : threshold(threshold < 0 ? clInlineThreshold : threshold) {}
+
+  void runOnModule() override;
+
+  /// Inline the candidate calls of `function`.
+  void inlineCalls(Function *function);
+
+  /// The maximal number of operations of the inlined functions.
+  unsigned threshold;
+
+  /// The level of each function in the call graph, which is strictly greater
+  /// than the one of the callees that may be inlined into it.  This map is
+  /// only read while the functions are processed in parallel.
+  llvm::DenseMap<Function *, unsigned> levels;
+};
+} // end anonymous namespace
+
+// Return the number of operations in the body of `function`, nested ones
+// included.  This is the cost of inlining it, as the whole body is cloned.
+static unsigned getInliningCost(Function *function) {
+  unsigned cost = 0;
+  function->walk([&](Operation *) { ++cost; });
+  return cost;
+}
+
+// Return true if the body of `function` can be cloned anywhere in the regions
+// of another function.  The callees with several blocks can only be inlined in
+// function bodies, as the nested regions may be restricted to a single block.
+// The affine operations require the values that their arguments are mapped to
+// to be valid dimensions or symbols, which is only guaranteed in the body of a
+// function.
+static bool canInlineInNestedRegions(Function *function) {
+  if (function->getBlocks().size() != 1)
+    return false;
+  auto result = function->walk([&](Operation *op) {
+    Dialect *dialect = op->getDialect();
+    if (dialect && dialect->getNamespace() == "affine")
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  });
+  return !result.wasInterrupted();
+}
+
+// Replace `call` with the body of its callee.  The block of the call is split
+// after it, the entry block of the callee is cloned at the end of the first
+// part, and the returns of the callee are turned into branches to the second
+// part, whose arguments replace the results of the call.  Single-block callees
+// are merged into the block of the call instead, so that they can be inlined
+// in regions restricted to a single block.
+static void inlineCall(CallOp call) {
+  Operation *callOp = call.getOperation();
+  Function *callee = call.getCallee();
+  Block *callBlock = callOp->getBlock();
+  Region *region = callBlock->getParent();
+  Block *contBlock = callBlock->splitBlock(std::next(Block::iterator(callOp)));
+
+  // Clone the body of the callee with its arguments mapped to the operands of
+  // the call, and move the blocks before the continuation.
+  BlockAndValueMapping mapper;
+  for (auto pair : llvm::zip(callee->getArguments(), call.getArgOperands()))
+    mapper.map(std::get<0>(pair), std::get<1>(pair));
+  auto &blocks = region->getBlocks();
+  unsigned numBlocksBefore = blocks.size();
+  callee->getBody().cloneInto(region, mapper, callOp->getContext());
+  auto firstCloned = std::next(blocks.begin(), numBlocksBefore);
+  blocks.splice(Region::iterator(contBlock), blocks, firstCloned,
+                blocks.end());
+
+  // The cloned entry block has no argument and no predecessor, so its
+  // operations simply follow the call.
+  Block *entryBlock = mapper.lookupOrNull(&callee->front());
+  callBlock->getOperations().splice(callBlock->end(),
+                                    entryBlock->getOperations());
+  entryBlock->eraseFromFunction();
+
+  if (callee->getBlocks().size() == 1) {
+    Operation *returnOp = &callBlock->back();
+    for (unsigned i = 0, e = callOp->getNumResults(); i < e; ++i)
+      callOp->getResult(i)->replaceAllUsesWith(returnOp->getOperand(i));
+    returnOp->erase();
+    callOp->erase();
+    callBlock->getOperations().splice(callBlock->end(),
+                                      contBlock->getOperations());
+    contBlock->eraseFromFunction();
+    return;
+  }
+
+  for (unsigned i = 0, e = callOp->getNumResults(); i < e; ++i)
+    callOp->getResult(i)->replaceAllUsesWith(
+        contBlock->addArgument(callOp->getResult(i)->getType()));
+  callOp->erase();
+  for (Block &block : llvm::make_range(Region::iterator(callBlock),
+                                       Region::iterator(contBlock))) {
+    Operation *returnOp = &block.back();
+    if (!returnOp->isa<ReturnOp>())
+      continue;
+    FuncBuilder builder(returnOp);
+    SmallVector<Value *, 4> results(returnOp->getOperands());
+    builder.create<BranchOp>(returnOp->getLoc(), contBlock, results);
+    returnOp->erase();
+  }
+}
+
+void Inliner::inlineCalls(Function *function) {
+  SmallVector<CallOp, 8> calls;
+  function->walk([&](CallOp call) {
+    Function *callee = call.getCallee();
+    if (callee->isExternal() ||
+        levels.lookup(callee) >= levels.lookup(function) ||
+        getInliningCost(callee) > threshold)
+      return;
+    if (call.getOperation()->getBlock()->getContainingOp() &&
+        !canInlineInNestedRegions(callee))
+      return;
+    calls.push_back(call);
+  });
+  for (CallOp call : calls)
+    inlineCall(call);
+}
+
+// Compute the level of `function` in the call graph, one more than the highest
+// level of its callees.  The calls to the functions currently being visited,
+// in `visiting`, close a cycle and are ignored: the callee of such a call has a
+// higher level than its caller, so that the call is not inlined.
+static unsigned computeLevel(Function *function,
+                             llvm::DenseMap<Function *, unsigned> &levels,
+                             llvm::SmallPtrSetImpl<Function *> &visiting) {
+  auto it = levels.find(function);
+  if (it != levels.end())
+    return it->second;
+
+  visiting.insert(function);
+  unsigned level = 0;
+  function->walk([&](CallOp call) {
+    Function *callee = call.getCallee();
+    if (callee->isExternal() || visiting.count(callee))
+      return;
+    level = std::max(level, computeLevel(callee, levels, visiting) + 1);
+  });
+  visiting.erase(function);
+  levels[function] = level;
+  return level;
+}
+
+void Inliner::runOnModule() {
+  Module &module = getModule();
+  levels.clear();
+  llvm::SmallPtrSet<Function *, 8> visiting;
+  unsigned maxLevel = 0;
+  for (Function &function : module)
+    maxLevel = std::max(maxLevel, computeLevel(&function, levels, visiting));
+
+  // Group the functions by level, so that all the callees of the functions of
+  // a group have been processed before it.
+  std::vector<SmallVector<Function *, 8>> functionsByLevel(maxLevel + 1);
+  for (Function &function : module)
+    if (!function.isExternal())
+      functionsByLevel[levels[&function]].push_back(&function);
+  for (auto &functions : functionsByLevel)
+    parallelForEach(&getContext(), functions.begin(), functions.end(),
+                    [&](Function *function) { inlineCalls(function); });
+}
+
+ModulePassBase *mlir::createInlinerPass(int threshold) {
+  return new Inliner(threshold);
+}
+
+static PassRegistration<Inliner>
+    pass("inline", "Inline the calls to small functions");
@@ -0,0 +1,188 @@
+//===- InstrumentLoops.cpp - Instrument loops and functions for profiling -===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that instruments the 'affine.for' operations and
+// the bodies of the functions with calls to the profile runtime of the
+// ExecutionEngine.  A timestamp is taken before each region, and a call after
+// it records the time spent in the region and its number of iterations under
+// an identifier derived from the location of the region.  The name of the
+// region is attached to that call as its "profile.region" attribute, from
+// which the ExecutionEngine registers it with the runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/LoopProfile.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace mlir;
+
+static constexpr const char *kProfileRegionAttrName = "profile.region";
+
+namespace {
+struct InstrumentLoops : public ModulePass<InstrumentLoops> {
+  void runOnModule() override;
+
+  void instrumentLoop(AffineForOp forOp);
+  void instrumentFunction(Function &function);
+
+  // Insert a call recording the execution of the region named `name` after
+  // the operations before `insertPoint` in `block`.
+  void buildRecordCall(Block *block, Block::iterator insertPoint, Location loc,
+                       Function *recordFn, StringRef name,
+                       ArrayRef<Value *> operands);
+
+  // The runtime functions called by the instrumentation.
+  Function *timestampFn = nullptr;
+  Function *recordLoopFn = nullptr;
+  Function *recordFunctionFn = nullptr;
+};
+} // end anonymous namespace
+
+// Build the value of the bound of a loop given by `map` applied to `operands`:
+// the maximum of its results for a lower bound, their minimum otherwise.
+static Value *buildLoopBound(FuncBuilder &builder, Location loc, AffineMap map,
+                             ArrayRef<Value *> operands, bool isLowerBound) {
+  auto predicate = isLowerBound ? CmpIPredicate::SGT : CmpIPredicate::SLT;
+  Value *bound = nullptr;
+  for (AffineExpr expr : map.getResults()) {
+    auto exprMap =
+        builder.getAffineMap(map.getNumDims(), map.getNumSymbols(), expr, {});
+    Value *value = builder.create<AffineApplyOp>(loc, exprMap, operands);
+    if (!bound) {
+      bound = value;
+      continue;
+    }
+    auto cmpOp = builder.create<CmpIOp>(loc, predicate, bound, value);
+    bound = builder.create<SelectOp>(loc, cmpOp.getResult(), bound, value);
+  }
+  return bound;
+}
+
+void InstrumentLoops::buildRecordCall(Block *block, Block::iterator insertPoint,
+                                      Location loc, Function *recordFn,
+                                      StringRef name,
+                                      ArrayRef<Value *> operands) {
+  FuncBuilder builder(block, insertPoint);
+  auto region = static_cast<int64_t>(llvm::xxHash64(name));
+  SmallVector<Value *, 8> recordOperands{
+      builder.create<ConstantIntOp>(loc, region, 64)};
+  recordOperands.append(operands.begin(), operands.end());
+  auto call = builder.create<CallOp>(loc, recordFn, recordOperands);
+  call.getOperation()->setAttr(kProfileRegionAttrName,
+                               builder.getStringAttr(name));
+}
+
+// Take a timestamp right before `forOp`, and record the loop and its bounds
+// right after it.  The bounds are computed before the timestamp, so that the
+// time spent in the loop does not include them.
+void InstrumentLoops::instrumentLoop(AffineForOp forOp) {
+  Operation *forInst = forOp.getOperation();
+  auto loc = forOp.getLoc();
+  FuncBuilder builder(forInst);
+  SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
+  SmallVector<Value *, 4> ubOperands(forOp.getUpperBoundOperands());
+  Value *lowerBound = buildLoopBound(builder, loc, forOp.getLowerBoundMap(),
+                                     lbOperands, /*isLowerBound=*/true);
+  Value *upperBound = buildLoopBound(builder, loc, forOp.getUpperBoundMap(),
+                                     ubOperands, /*isLowerBound=*/false);
+  Value *step = builder.create<ConstantIndexOp>(loc, forOp.getStep());
+  Value *start =
+      builder.create<CallOp>(loc, timestampFn, ArrayRef<Value *>())
+          .getOperation()
+          ->getResult(0);
+
+  buildRecordCall(forInst->getBlock(), std::next(Block::iterator(forInst)),
+                  loc, recordLoopFn, getProfileRegionName(forOp),
+                  {start, lowerBound, upperBound, step});
+}
+
+// Take a timestamp at the entry of `function`, and record the call to it
+// before each of its returns.
+void InstrumentLoops::instrumentFunction(Function &function) {
+  auto loc = function.getLoc();
+  FuncBuilder builder(&function);
+  Value *start =
+      builder.create<CallOp>(loc, timestampFn, ArrayRef<Value *>())
+          .getOperation()
+          ->getResult(0);
+
+  auto name = getProfileRegionName(function);
+  for (Block &block : function) {
+    Operation *terminator = block.getTerminator();
+    if (terminator->isa<ReturnOp>())
+      buildRecordCall(&block, Block::iterator(terminator), loc,
+                      recordFunctionFn, name, {start});
+  }
+}
+
+void InstrumentLoops::runOnModule() {
+  Module &module = getModule();
+
+  // Collect the functions and their loops first, since the runtime functions
+  // are added to the module.
+  SmallVector<Function *, 8> functions;
+  SmallVector<AffineForOp, 16> loops;
+  for (Function &function : module) {
+    if (function.isExternal())
+      continue;
+    functions.push_back(&function);
+    function.walk([&](AffineForOp forOp) { loops.push_back(forOp); });
+  }
+  if (functions.empty())
+    return;
+
+  // Declare the runtime functions, in a deterministic order.
+  auto *context = &getContext();
+  auto i64Type = IntegerType::get(64, context);
+  auto indexType = IndexType::get(context);
+  auto getOrInsertDeclaration = [&](StringRef name, FunctionType type) {
+    return module.getOrInsertFunction(name, [&] {
+      return new Function(UnknownLoc::get(context), name, type);
+    });
+  };
+  timestampFn = getOrInsertDeclaration(
+      "mlir_profile_timestamp", FunctionType::get({}, i64Type, context));
+  recordLoopFn = getOrInsertDeclaration(
+      "mlir_profile_record_loop",
+      FunctionType::get({i64Type, i64Type, indexType, indexType, indexType},
+                        {}, context));
+  recordFunctionFn = getOrInsertDeclaration(
+      "mlir_profile_record_function",
+      FunctionType::get({i64Type, i64Type}, {}, context));
+
+  for (AffineForOp forOp : loops)
+    instrumentLoop(forOp);
+  for (Function *function : functions)
+    instrumentFunction(*function);
+}
+
+/// Creates a pass instrumenting the 'affine.for' operations and the functions
+/// with calls to the profile runtime of the ExecutionEngine.
+ModulePassBase *mlir::createInstrumentLoopsPass() {
+  return new InstrumentLoops();
+}
+
+static PassRegistration<InstrumentLoops>
+    pass("instrument-loops",
+         "Instrument the loops and functions with calls to the profile runtime "
+         "counting their iterations and the time spent in them");
@@ -23,6 +23,8 @@
 #include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/LoopProfile.h"
+#include "mlir/Analysis/MemRefDependenceGraph.h"
 #include "mlir/Analysis/Utils.h"
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
@@ -31,20 +33,21 @@
 #include "mlir/StandardOps/Ops.h"
 #include "mlir/Transforms/LoopUtils.h"
 #include "mlir/Transforms/Passes.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "mlir/Transforms/Utils.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
 #define DEBUG_TYPE "loop-fusion"
 
-using llvm::SetVector;
-
 using namespace mlir;
 
 static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
@@ -81,7 +84,9 @@ namespace {
 
 /// Loop fusion pass. This pass currently supports a greedy fusion policy,
 /// which fuses loop nests with single-writer/single-reader memref dependences
-/// with the goal of improving locality.
+/// with the goal of improving locality. Each candidate fusion evaluated
+/// consumes a unit of the budget of the pass, which stops searching once it is
+/// exhausted.
 
 // TODO(andydavis) Support fusion of source loop nests which write to multiple
 // memrefs, where each memref can have multiple users (if profitable).
@@ -90,9 +95,13 @@ namespace {
 
 struct LoopFusion : public FunctionPass<LoopFusion> {
   LoopFusion(unsigned fastMemorySpace = 0, uint64_t localBufSizeThreshold = 0,
-             bool maximalFusion = false)
+             bool maximalFusion = false,
+             std::shared_ptr<const TargetMemoryModel> memoryModel = nullptr)
       : localBufSizeThreshold(localBufSizeThreshold),
-        fastMemorySpace(fastMemorySpace), maximalFusion(maximalFusion) {}
+        fastMemorySpace(fastMemorySpace), maximalFusion(maximalFusion),
+        memoryModel(memoryModel ? std::move(memoryModel)
+                                : std::make_shared<const TargetMemoryModel>(
+                                      TargetMemoryModel::getDefault())) {}
 
   void runOnFunction() override;
 
@@ -103,6 +112,8 @@ struct LoopFusion : public FunctionPass<LoopFusion> {
   // If true, ignore any additional (redundant) computation tolerance threshold
   // that would have prevented fusion.
   bool maximalFusion;
+  // The memory hierarchy whose traffic fusion should not increase.
+  std::shared_ptr<const TargetMemoryModel> memoryModel;
 
   // The amount of additional computation that is tolerated while fusing
   // pair-wise as a fraction of the total computation.
@@ -111,623 +122,11 @@ struct LoopFusion : public FunctionPass<LoopFusion> {
 
 } // end anonymous namespace
 
-FunctionPassBase *mlir::createLoopFusionPass(unsigned fastMemorySpace,
-                                             uint64_t localBufSizeThreshold,
-                                             bool maximalFusion) {
-  return new LoopFusion(fastMemorySpace, localBufSizeThreshold, maximalFusion);
-}
-
-namespace {
-
-// LoopNestStateCollector walks loop nests and collects load and store
-// operations, and whether or not an IfInst was encountered in the loop nest.
-struct LoopNestStateCollector {
-  SmallVector<AffineForOp, 4> forOps;
-  SmallVector<Operation *, 4> loadOpInsts;
-  SmallVector<Operation *, 4> storeOpInsts;
-  bool hasNonForRegion = false;
-
-  void collect(Operation *opToWalk) {
-    opToWalk->walk([&](Operation *op) {
-      if (op->isa<AffineForOp>())
-        forOps.push_back(op->cast<AffineForOp>());
-      else if (op->getNumRegions() != 0)
-        hasNonForRegion = true;
-      else if (op->isa<LoadOp>())
-        loadOpInsts.push_back(op);
-      else if (op->isa<StoreOp>())
-        storeOpInsts.push_back(op);
-    });
-  }
-};
-
-// TODO(b/117228571) Replace when this is modeled through side-effects/op traits
-static bool isMemRefDereferencingOp(Operation &op) {
-  if (op.isa<LoadOp>() || op.isa<StoreOp>() || op.isa<DmaStartOp>() ||
-      op.isa<DmaWaitOp>())
-    return true;
-  return false;
-}
-
-// MemRefDependenceGraph is a graph data structure where graph nodes are
-// top-level operations in a Function which contain load/store ops, and edges
-// are memref dependences between the nodes.
-// TODO(andydavis) Add a more flexible dependece graph representation.
-// TODO(andydavis) Add a depth parameter to dependence graph construction.
-struct MemRefDependenceGraph {
-public:
-  // Node represents a node in the graph. A Node is either an entire loop nest
-  // rooted at the top level which contains loads/stores, or a top level
-  // load/store.
-  struct Node {
-    // The unique identifier of this node in the graph.
-    unsigned id;
-    // The top-level statment which is (or contains) loads/stores.
-    Operation *op;
-    // List of load operations.
-    SmallVector<Operation *, 4> loads;
-    // List of store op insts.
-    SmallVector<Operation *, 4> stores;
-    Node(unsigned id, Operation *op) : id(id), op(op) {}
-
-    // Returns the load op count for 'memref'.
-    unsigned getLoadOpCount(Value *memref) {
-      unsigned loadOpCount = 0;
-      for (auto *loadOpInst : loads) {
-        if (memref == loadOpInst->cast<LoadOp>().getMemRef())
-          ++loadOpCount;
-      }
-      return loadOpCount;
-    }
-
-    // Returns the store op count for 'memref'.
-    unsigned getStoreOpCount(Value *memref) {
-      unsigned storeOpCount = 0;
-      for (auto *storeOpInst : stores) {
-        if (memref == storeOpInst->cast<StoreOp>().getMemRef())
-          ++storeOpCount;
-      }
-      return storeOpCount;
-    }
-
-    // Returns all store ops in 'storeOps' which access 'memref'.
-    void getStoreOpsForMemref(Value *memref,
-                              SmallVectorImpl<Operation *> *storeOps) {
-      for (auto *storeOpInst : stores) {
-        if (memref == storeOpInst->cast<StoreOp>().getMemRef())
-          storeOps->push_back(storeOpInst);
-      }
-    }
-
-    // Returns all load ops in 'loadOps' which access 'memref'.
-    void getLoadOpsForMemref(Value *memref,
-                             SmallVectorImpl<Operation *> *loadOps) {
-      for (auto *loadOpInst : loads) {
-        if (memref == loadOpInst->cast<LoadOp>().getMemRef())
-          loadOps->push_back(loadOpInst);
-      }
-    }
-
-    // Returns all memrefs in 'loadAndStoreMemrefSet' for which this node
-    // has at least one load and store operation.
-    void getLoadAndStoreMemrefSet(DenseSet<Value *> *loadAndStoreMemrefSet) {
-      llvm::SmallDenseSet<Value *, 2> loadMemrefs;
-      for (auto *loadOpInst : loads) {
-        loadMemrefs.insert(loadOpInst->cast<LoadOp>().getMemRef());
-      }
-      for (auto *storeOpInst : stores) {
-        auto *memref = storeOpInst->cast<StoreOp>().getMemRef();
-        if (loadMemrefs.count(memref) > 0)
-          loadAndStoreMemrefSet->insert(memref);
-      }
-    }
-  };
-
-  // Edge represents a data dependece between nodes in the graph.
-  struct Edge {
-    // The id of the node at the other end of the edge.
-    // If this edge is stored in Edge = Node.inEdges[i], then
-    // 'Node.inEdges[i].id' is the identifier of the source node of the edge.
-    // If this edge is stored in Edge = Node.outEdges[i], then
-    // 'Node.outEdges[i].id' is the identifier of the dest node of the edge.
-    unsigned id;
-    // The SSA value on which this edge represents a dependence.
-    // If the value is a memref, then the dependence is between graph nodes
-    // which contain accesses to the same memref 'value'. If the value is a
-    // non-memref value, then the dependence is between a graph node which
-    // defines an SSA value and another graph node which uses the SSA value
-    // (e.g. a constant operation defining a value which is used inside a loop
-    // nest).
-    Value *value;
-  };
-
-  // Map from node id to Node.
-  DenseMap<unsigned, Node> nodes;
-  // Map from node id to list of input edges.
-  DenseMap<unsigned, SmallVector<Edge, 2>> inEdges;
-  // Map from node id to list of output edges.
-  DenseMap<unsigned, SmallVector<Edge, 2>> outEdges;
-  // Map from memref to a count on the dependence edges associated with that
-  // memref.
-  DenseMap<Value *, unsigned> memrefEdgeCount;
-  // The next unique identifier to use for newly created graph nodes.
-  unsigned nextNodeId = 0;
-
-  MemRefDependenceGraph() {}
-
-  // Initializes the dependence graph based on operations in 'f'.
-  // Returns true on success, false otherwise.
-  bool init(Function &f);
-
-  // Returns the graph node for 'id'.
-  Node *getNode(unsigned id) {
-    auto it = nodes.find(id);
-    assert(it != nodes.end());
-    return &it->second;
-  }
-
-  // Returns the graph node for 'forOp'.
-  Node *getForOpNode(AffineForOp forOp) {
-    for (auto &idAndNode : nodes)
-      if (idAndNode.second.op == forOp.getOperation())
-        return &idAndNode.second;
-    return nullptr;
-  }
-
-  // Adds a node with 'op' to the graph and returns its unique identifier.
-  unsigned addNode(Operation *op) {
-    Node node(nextNodeId++, op);
-    nodes.insert({node.id, node});
-    return node.id;
-  }
-
-  // Remove node 'id' (and its associated edges) from graph.
-  void removeNode(unsigned id) {
-    // Remove each edge in 'inEdges[id]'.
-    if (inEdges.count(id) > 0) {
-      SmallVector<Edge, 2> oldInEdges = inEdges[id];
-      for (auto &inEdge : oldInEdges) {
-        removeEdge(inEdge.id, id, inEdge.value);
-      }
-    }
-    // Remove each edge in 'outEdges[id]'.
-    if (outEdges.count(id) > 0) {
-      SmallVector<Edge, 2> oldOutEdges = outEdges[id];
-      for (auto &outEdge : oldOutEdges) {
-        removeEdge(id, outEdge.id, outEdge.value);
-      }
-    }
-    // Erase remaining node state.
-    inEdges.erase(id);
-    outEdges.erase(id);
-    nodes.erase(id);
-  }
-
-  // Returns true if node 'id' writes to any memref which escapes (or is an
-  // argument to) the function/block. Returns false otherwise.
-  bool writesToLiveInOrEscapingMemrefs(unsigned id) {
-    Node *node = getNode(id);
-    for (auto *storeOpInst : node->stores) {
-      auto *memref = storeOpInst->cast<StoreOp>().getMemRef();
-      auto *op = memref->getDefiningOp();
-      // Return true if 'memref' is a block argument.
-      if (!op)
-        return true;
-      // Return true if any use of 'memref' escapes the function.
-      for (auto &use : memref->getUses())
-        if (!isMemRefDereferencingOp(*use.getOwner()))
-          return true;
-    }
-    return false;
-  }
-
-  // Returns true if node 'id' can be removed from the graph. Returns false
-  // otherwise. A node can be removed from the graph iff the following
-  // conditions are met:
-  // *) The node does not write to any memref which escapes (or is a
-  //    function/block argument).
-  // *) The node has no successors in the dependence graph.
-  bool canRemoveNode(unsigned id) {
-    if (writesToLiveInOrEscapingMemrefs(id))
-      return false;
-    Node *node = getNode(id);
-    for (auto *storeOpInst : node->stores) {
-      // Return false if there exist out edges from 'id' on 'memref'.
-      if (getOutEdgeCount(id, storeOpInst->cast<StoreOp>().getMemRef()) > 0)
-        return false;
-    }
-    return true;
-  }
-
-  // Returns true iff there is an edge from node 'srcId' to node 'dstId' which
-  // is for 'value' if non-null, or for any value otherwise. Returns false
-  // otherwise.
-  bool hasEdge(unsigned srcId, unsigned dstId, Value *value = nullptr) {
-    if (outEdges.count(srcId) == 0 || inEdges.count(dstId) == 0) {
-      return false;
-    }
-    bool hasOutEdge = llvm::any_of(outEdges[srcId], [=](Edge &edge) {
-      return edge.id == dstId && (!value || edge.value == value);
-    });
-    bool hasInEdge = llvm::any_of(inEdges[dstId], [=](Edge &edge) {
-      return edge.id == srcId && (!value || edge.value == value);
-    });
-    return hasOutEdge && hasInEdge;
-  }
-
-  // Adds an edge from node 'srcId' to node 'dstId' for 'value'.
-  void addEdge(unsigned srcId, unsigned dstId, Value *value) {
-    if (!hasEdge(srcId, dstId, value)) {
-      outEdges[srcId].push_back({dstId, value});
-      inEdges[dstId].push_back({srcId, value});
-      if (value->getType().isa<MemRefType>())
-        memrefEdgeCount[value]++;
-    }
-  }
-
-  // Removes an edge from node 'srcId' to node 'dstId' for 'value'.
-  void removeEdge(unsigned srcId, unsigned dstId, Value *value) {
-    assert(inEdges.count(dstId) > 0);
-    assert(outEdges.count(srcId) > 0);
-    if (value->getType().isa<MemRefType>()) {
-      assert(memrefEdgeCount.count(value) > 0);
-      memrefEdgeCount[value]--;
-    }
-    // Remove 'srcId' from 'inEdges[dstId]'.
-    for (auto it = inEdges[dstId].begin(); it != inEdges[dstId].end(); ++it) {
-      if ((*it).id == srcId && (*it).value == value) {
-        inEdges[dstId].erase(it);
-        break;
-      }
-    }
-    // Remove 'dstId' from 'outEdges[srcId]'.
-    for (auto it = outEdges[srcId].begin(); it != outEdges[srcId].end(); ++it) {
-      if ((*it).id == dstId && (*it).value == value) {
-        outEdges[srcId].erase(it);
-        break;
-      }
-    }
-  }
-
-  // Returns true if there is a path in the dependence graph from node 'srcId'
-  // to node 'dstId'. Returns false otherwise.
-  bool hasDependencePath(unsigned srcId, unsigned dstId) {
-    // Worklist state is: <node-id, next-output-edge-index-to-visit>
-    SmallVector<std::pair<unsigned, unsigned>, 4> worklist;
-    worklist.push_back({srcId, 0});
-    // Run DFS traversal to see if 'dstId' is reachable from 'srcId'.
-    while (!worklist.empty()) {
-      auto &idAndIndex = worklist.back();
-      // Return true if we have reached 'dstId'.
-      if (idAndIndex.first == dstId)
-        return true;
-      // Pop and continue if node has no out edges, or if all out edges have
-      // already been visited.
-      if (outEdges.count(idAndIndex.first) == 0 ||
-          idAndIndex.second == outEdges[idAndIndex.first].size()) {
-        worklist.pop_back();
-        continue;
-      }
-      // Get graph edge to traverse.
-      Edge edge = outEdges[idAndIndex.first][idAndIndex.second];
-      // Increment next output edge index for 'idAndIndex'.
-      ++idAndIndex.second;
-      // Add node at 'edge.id' to worklist.
-      worklist.push_back({edge.id, 0});
-    }
-    return false;
-  }
-
-  // Returns the input edge count for node 'id' and 'memref' from src nodes
-  // which access 'memref' with a store operation.
-  unsigned getIncomingMemRefAccesses(unsigned id, Value *memref) {
-    unsigned inEdgeCount = 0;
-    if (inEdges.count(id) > 0)
-      for (auto &inEdge : inEdges[id])
-        if (inEdge.value == memref) {
-          Node *srcNode = getNode(inEdge.id);
-          // Only count in edges from 'srcNode' if 'srcNode' accesses 'memref'
-          if (srcNode->getStoreOpCount(memref) > 0)
-            ++inEdgeCount;
-        }
-    return inEdgeCount;
-  }
-
-  // Returns the output edge count for node 'id' and 'memref' (if non-null),
-  // otherwise returns the total output edge count from node 'id'.
-  unsigned getOutEdgeCount(unsigned id, Value *memref = nullptr) {
-    unsigned outEdgeCount = 0;
-    if (outEdges.count(id) > 0)
-      for (auto &outEdge : outEdges[id])
-        if (!memref || outEdge.value == memref)
-          ++outEdgeCount;
-    return outEdgeCount;
-  }
-
-  // Computes and returns an insertion point operation, before which the
-  // the fused <srcId, dstId> loop nest can be inserted while preserving
-  // dependences. Returns nullptr if no such insertion point is found.
-  Operation *getFusedLoopNestInsertionPoint(unsigned srcId, unsigned dstId) {
-    if (outEdges.count(srcId) == 0)
-      return getNode(dstId)->op;
-
-    // Build set of insts in range (srcId, dstId) which depend on 'srcId'.
-    SmallPtrSet<Operation *, 2> srcDepInsts;
-    for (auto &outEdge : outEdges[srcId])
-      if (outEdge.id != dstId)
-        srcDepInsts.insert(getNode(outEdge.id)->op);
-
-    // Build set of insts in range (srcId, dstId) on which 'dstId' depends.
-    SmallPtrSet<Operation *, 2> dstDepInsts;
-    for (auto &inEdge : inEdges[dstId])
-      if (inEdge.id != srcId)
-        dstDepInsts.insert(getNode(inEdge.id)->op);
-
-    Operation *srcNodeInst = getNode(srcId)->op;
-    Operation *dstNodeInst = getNode(dstId)->op;
-
-    // Computing insertion point:
-    // *) Walk all operation positions in Block operation list in the
-    //    range (src, dst). For each operation 'op' visited in this search:
-    //   *) Store in 'firstSrcDepPos' the first position where 'op' has a
-    //      dependence edge from 'srcNode'.
-    //   *) Store in 'lastDstDepPost' the last position where 'op' has a
-    //      dependence edge to 'dstNode'.
-    // *) Compare 'firstSrcDepPos' and 'lastDstDepPost' to determine the
-    //    operation insertion point (or return null pointer if no such
-    //    insertion point exists: 'firstSrcDepPos' <= 'lastDstDepPos').
-    SmallVector<Operation *, 2> depInsts;
-    Optional<unsigned> firstSrcDepPos;
-    Optional<unsigned> lastDstDepPos;
-    unsigned pos = 0;
-    for (Block::iterator it = std::next(Block::iterator(srcNodeInst));
-         it != Block::iterator(dstNodeInst); ++it) {
-      Operation *op = &(*it);
-      if (srcDepInsts.count(op) > 0 && firstSrcDepPos == None)
-        firstSrcDepPos = pos;
-      if (dstDepInsts.count(op) > 0)
-        lastDstDepPos = pos;
-      depInsts.push_back(op);
-      ++pos;
-    }
-
-    if (firstSrcDepPos.hasValue()) {
-      if (lastDstDepPos.hasValue()) {
-        if (firstSrcDepPos.getValue() <= lastDstDepPos.getValue()) {
-          // No valid insertion point exists which preserves dependences.
-          return nullptr;
-        }
-      }
-      // Return the insertion point at 'firstSrcDepPos'.
-      return depInsts[firstSrcDepPos.getValue()];
-    }
-    // No dependence targets in range (or only dst deps in range), return
-    // 'dstNodInst' insertion point.
-    return dstNodeInst;
-  }
-
-  // Updates edge mappings from node 'srcId' to node 'dstId' after 'oldMemRef'
-  // has been replaced in node at 'dstId' by a private memref.
-  void updateEdges(unsigned srcId, unsigned dstId, Value *oldMemRef) {
-    // For each edge in 'inEdges[srcId]': add new edge remaping to 'dstId'.
-    if (inEdges.count(srcId) > 0) {
-      SmallVector<Edge, 2> oldInEdges = inEdges[srcId];
-      for (auto &inEdge : oldInEdges) {
-        // Add edge from 'inEdge.id' to 'dstId' if not for 'oldMemRef'.
-        if (inEdge.value != oldMemRef)
-          addEdge(inEdge.id, dstId, inEdge.value);
-      }
-    }
-    // For each edge in 'outEdges[srcId]': remove edge from 'srcId' to 'dstId'.
-    if (outEdges.count(srcId) > 0) {
-      SmallVector<Edge, 2> oldOutEdges = outEdges[srcId];
-      for (auto &outEdge : oldOutEdges) {
-        // Remove any out edges from 'srcId' to 'dstId' across memrefs.
-        if (outEdge.id == dstId)
-          removeEdge(srcId, outEdge.id, outEdge.value);
-      }
-    }
-    // Remove any edges in 'inEdges[dstId]' on 'oldMemRef' (which is being
-    // replaced by a private memref). These edges could come from nodes
-    // other than 'srcId' which were removed in the previous step.
-    if (inEdges.count(dstId) > 0) {
-      SmallVector<Edge, 2> oldInEdges = inEdges[dstId];
-      for (auto &inEdge : oldInEdges)
-        if (inEdge.value == oldMemRef)
-          removeEdge(inEdge.id, dstId, inEdge.value);
-    }
-  }
-
-  // Update edge mappings for nodes 'sibId' and 'dstId' to reflect fusion
-  // of sibling node 'sidId' into node 'dstId'.
-  void updateEdges(unsigned sibId, unsigned dstId) {
-    // For each edge in 'inEdges[sibId]':
-    // *) Add new edge from source node 'inEdge.id' to 'dstNode'.
-    // *) Remove edge from source node 'inEdge.id' to 'sibNode'.
-    if (inEdges.count(sibId) > 0) {
-      SmallVector<Edge, 2> oldInEdges = inEdges[sibId];
-      for (auto &inEdge : oldInEdges) {
-        addEdge(inEdge.id, dstId, inEdge.value);
-        removeEdge(inEdge.id, sibId, inEdge.value);
-      }
-    }
-
-    // For each edge in 'outEdges[sibId]' to node 'id'
-    // *) Add new edge from 'dstId' to 'outEdge.id'.
-    // *) Remove edge from 'sibId' to 'outEdge.id'.
-    if (outEdges.count(sibId) > 0) {
-      SmallVector<Edge, 2> oldOutEdges = outEdges[sibId];
-      for (auto &outEdge : oldOutEdges) {
-        addEdge(dstId, outEdge.id, outEdge.value);
-        removeEdge(sibId, outEdge.id, outEdge.value);
-      }
-    }
-  }
-
-  // Adds ops in 'loads' and 'stores' to node at 'id'.
-  void addToNode(unsigned id, const SmallVectorImpl<Operation *> &loads,
-                 const SmallVectorImpl<Operation *> &stores) {
-    Node *node = getNode(id);
-    for (auto *loadOpInst : loads)
-      node->loads.push_back(loadOpInst);
-    for (auto *storeOpInst : stores)
-      node->stores.push_back(storeOpInst);
-  }
-
-  void clearNodeLoadAndStores(unsigned id) {
-    Node *node = getNode(id);
-    node->loads.clear();
-    node->stores.clear();
-  }
-
-  // Calls 'callback' for each input edge incident to node 'id' which carries a
-  // memref dependence.
-  void forEachMemRefInputEdge(unsigned id,
-                              const std::function<void(Edge)> &callback) {
-    if (inEdges.count(id) > 0)
-      forEachMemRefEdge(inEdges[id], callback);
-  }
-  // Calls 'callback' for each output edge from node 'id' which carries a
-  // memref dependence.
-  void forEachMemRefOutputEdge(unsigned id,
-                               const std::function<void(Edge)> &callback) {
-    if (outEdges.count(id) > 0)
-      forEachMemRefEdge(outEdges[id], callback);
-  }
-  // Calls 'callback' for each edge in 'edges' which carries a memref
-  // dependence.
-  void forEachMemRefEdge(ArrayRef<Edge> edges,
-                         const std::function<void(Edge)> &callback) {
-    for (auto &edge : edges) {
-      // Skip if 'edge' is not a memref dependence edge.
-      if (!edge.value->getType().isa<MemRefType>())
-        continue;
-      assert(nodes.count(edge.id) > 0);
-      // Skip if 'edge.id' is not a loop nest.
-      if (!getNode(edge.id)->op->isa<AffineForOp>())
-        continue;
-      // Visit current input edge 'edge'.
-      callback(edge);
-    }
-  }
-
-  void print(raw_ostream &os) const {
-    os << "\nMemRefDependenceGraph\n";
-    os << "\nNodes:\n";
-    for (auto &idAndNode : nodes) {
-      os << "Node: " << idAndNode.first << "\n";
-      auto it = inEdges.find(idAndNode.first);
-      if (it != inEdges.end()) {
-        for (const auto &e : it->second)
-          os << "  InEdge: " << e.id << " " << e.value << "\n";
-      }
-      it = outEdges.find(idAndNode.first);
-      if (it != outEdges.end()) {
-        for (const auto &e : it->second)
-          os << "  OutEdge: " << e.id << " " << e.value << "\n";
-      }
-    }
-  }
-  void dump() const { print(llvm::errs()); }
-};
-
-// Intializes the data dependence graph by walking operations in 'f'.
-// Assigns each node in the graph a node id based on program order in 'f'.
-// TODO(andydavis) Add support for taking a Block arg to construct the
-// dependence graph at a different depth.
-bool MemRefDependenceGraph::init(Function &f) {
-  DenseMap<Value *, SetVector<unsigned>> memrefAccesses;
-
-  // TODO: support multi-block functions.
-  if (f.getBlocks().size() != 1)
-    return false;
-
-  DenseMap<Operation *, unsigned> forToNodeMap;
-  for (auto &op : f.front()) {
-    if (auto forOp = op.dyn_cast<AffineForOp>()) {
-      // Create graph node 'id' to represent top-level 'forOp' and record
-      // all loads and store accesses it contains.
-      LoopNestStateCollector collector;
-      collector.collect(&op);
-      // Return false if a non 'affine.for' region was found (not currently
-      // supported).
-      if (collector.hasNonForRegion)
-        return false;
-      Node node(nextNodeId++, &op);
-      for (auto *opInst : collector.loadOpInsts) {
-        node.loads.push_back(opInst);
-        auto *memref = opInst->cast<LoadOp>().getMemRef();
-        memrefAccesses[memref].insert(node.id);
-      }
-      for (auto *opInst : collector.storeOpInsts) {
-        node.stores.push_back(opInst);
-        auto *memref = opInst->cast<StoreOp>().getMemRef();
-        memrefAccesses[memref].insert(node.id);
-      }
-      forToNodeMap[&op] = node.id;
-      nodes.insert({node.id, node});
-    } else if (auto loadOp = op.dyn_cast<LoadOp>()) {
-      // Create graph node for top-level load op.
-      Node node(nextNodeId++, &op);
-      node.loads.push_back(&op);
-      auto *memref = op.cast<LoadOp>().getMemRef();
-      memrefAccesses[memref].insert(node.id);
-      nodes.insert({node.id, node});
-    } else if (auto storeOp = op.dyn_cast<StoreOp>()) {
-      // Create graph node for top-level store op.
-      Node node(nextNodeId++, &op);
-      node.stores.push_back(&op);
-      auto *memref = op.cast<StoreOp>().getMemRef();
-      memrefAccesses[memref].insert(node.id);
-      nodes.insert({node.id, node});
-    } else if (op.getNumRegions() != 0) {
-      // Return false if another region is found (not currently supported).
-      return false;
-    } else if (op.getNumResults() > 0 && !op.use_empty()) {
-      // Create graph node for top-level producer of SSA values, which
-      // could be used by loop nest nodes.
-      Node node(nextNodeId++, &op);
-      nodes.insert({node.id, node});
-    }
-  }
-
-  // Add dependence edges between nodes which produce SSA values and their
-  // users.
-  for (auto &idAndNode : nodes) {
-    const Node &node = idAndNode.second;
-    if (!node.loads.empty() || !node.stores.empty())
-      continue;
-    auto *opInst = node.op;
-    for (auto *value : opInst->getResults()) {
-      for (auto &use : value->getUses()) {
-        SmallVector<AffineForOp, 4> loops;
-        getLoopIVs(*use.getOwner(), &loops);
-        if (loops.empty())
-          continue;
-        assert(forToNodeMap.count(loops[0].getOperation()) > 0);
-        unsigned userLoopNestId = forToNodeMap[loops[0].getOperation()];
-        addEdge(node.id, userLoopNestId, value);
-      }
-    }
-  }
-
-  // Walk memref access lists and add graph edges between dependent nodes.
-  for (auto &memrefAndList : memrefAccesses) {
-    unsigned n = memrefAndList.second.size();
-    for (unsigned i = 0; i < n; ++i) {
-      unsigned srcId = memrefAndList.second[i];
-      bool srcHasStore =
-          getNode(srcId)->getStoreOpCount(memrefAndList.first) > 0;
-      for (unsigned j = i + 1; j < n; ++j) {
-        unsigned dstId = memrefAndList.second[j];
-        bool dstHasStore =
-            getNode(dstId)->getStoreOpCount(memrefAndList.first) > 0;
-        if (srcHasStore || dstHasStore)
-          addEdge(srcId, dstId, memrefAndList.first);
-      }
-    }
-  }
-  return true;
+FunctionPassBase *mlir::createLoopFusionPass(
+    unsigned fastMemorySpace, uint64_t localBufSizeThreshold,
+    bool maximalFusion, std::shared_ptr<const TargetMemoryModel> memoryModel) {
+  return new LoopFusion(fastMemorySpace, localBufSizeThreshold, maximalFusion,
+                        std::move(memoryModel));
 }
 
 namespace {
@@ -752,7 +151,7 @@ struct LoopNestStatsCollector {
   LoopNestStatsCollector(LoopNestStats *stats) : stats(stats) {}
 
   void collect(Operation *op) {
-    op->walk<AffineForOp>([&](AffineForOp forOp) {
+    op->walk([&](AffineForOp forOp) {
       auto *forInst = forOp.getOperation();
       auto *parentInst = forOp.getOperation()->getParentOp();
       if (parentInst != nullptr) {
@@ -769,9 +168,9 @@ struct LoopNestStatsCollector {
           ++count;
       }
       stats->opCountMap[forInst] = count;
-      // Record trip count for 'forOp'. Set flag if trip count is not
-      // constant.
-      Optional<uint64_t> maybeConstTripCount = getConstantTripCount(forOp);
+      // Record trip count for 'forOp', or its estimate from the profile given
+      // with -loop-profile. Set flag if trip count is not known.
+      Optional<uint64_t> maybeConstTripCount = getEstimatedTripCount(forOp);
       if (!maybeConstTripCount.hasValue()) {
         hasLoopWithNonConstTripCount = true;
         return;
@@ -925,7 +324,8 @@ static unsigned getInnermostCommonLoopDepth(ArrayRef<Operation *> ops) {
 // Returns the maximum loop depth at which no dependences between 'loadOpInsts'
 // and 'storeOpInsts' are satisfied.
 static unsigned getMaxLoopDepth(ArrayRef<Operation *> loadOpInsts,
-                                ArrayRef<Operation *> storeOpInsts) {
+                                ArrayRef<Operation *> storeOpInsts,
+                                DependenceAnalysis *dependences) {
   // Merge loads and stores into the same array.
   SmallVector<Operation *, 2> ops(loadOpInsts.begin(), loadOpInsts.end());
   ops.append(storeOpInsts.begin(), storeOpInsts.end());
@@ -941,19 +341,13 @@ static unsigned getMaxLoopDepth(ArrayRef<Operation *> loadOpInsts,
   // loop depth at which a dependence is satisfied.
   for (unsigned i = 0, e = ops.size(); i < e; ++i) {
     auto *srcOpInst = ops[i];
-    MemRefAccess srcAccess(srcOpInst);
     for (unsigned j = 0; j < e; ++j) {
       auto *dstOpInst = ops[j];
-      MemRefAccess dstAccess(dstOpInst);
 
       unsigned numCommonLoops =
           getNumCommonSurroundingLoops(*srcOpInst, *dstOpInst);
       for (unsigned d = 1; d <= numCommonLoops + 1; ++d) {
-        FlatAffineConstraints dependenceConstraints;
-        // TODO(andydavis) Cache dependence analysis results, check cache here.
-        if (checkMemrefAccessDependence(srcAccess, dstAccess, d,
-                                        &dependenceConstraints,
-                                        /*dependenceComponents=*/nullptr)) {
+        if (dependences->checkDependence(srcOpInst, dstOpInst, d)) {
           // Store minimum loop depth and break because we want the min 'd' at
           // which there is a dependence.
           loopDepth = std::min(loopDepth, d - 1);
@@ -966,50 +360,26 @@ static unsigned getMaxLoopDepth(ArrayRef<Operation *> loadOpInsts,
 }
 
 // Compute loop interchange permutation:
-// *) Computes dependence components between all op pairs in 'ops' for loop
-//    depths in range [1, 'maxLoopDepth'].
-// *) Classifies the outermost 'maxLoopDepth' loops surrounding 'ops' as either
-//    parallel or sequential.
+// *) Classifies the loops of the perfect nest 'loops' as either parallel or
+//    sequential, based on the dependences between all op pairs in 'ops'.
 // *) Computes the loop permutation which sinks sequential loops deeper into
 //    the loop nest, while preserving the relative order between other loops.
 // *) Checks each dependence component against the permutation to see if the
 //    desired loop interchange would violated dependences by making the a
 //    dependence componenent lexicographically negative.
-// TODO(andydavis) Move this function to LoopUtils.
 static bool
-computeLoopInterchangePermutation(ArrayRef<Operation *> ops,
-                                  unsigned maxLoopDepth,
-                                  SmallVectorImpl<unsigned> *loopPermMap) {
+computeLoopInterchangePermutation(ArrayRef<AffineForOp> loops,
+                                  ArrayRef<Operation *> ops,
+                                  SmallVectorImpl<unsigned> *loopPermMap,
+                                  DependenceAnalysis *dependences) {
   // Gather dependence components for dependences between all ops in 'ops'
-  // at loop depths in range [1, maxLoopDepth].
-  // TODO(andydavis) Refactor this loop into a LoopUtil utility function:
-  // mlir::getDependenceComponents().
-  // TODO(andydavis) Split this loop into two: first check all dependences,
-  // and construct dep vectors. Then, scan through them to detect the parallel
-  // ones.
+  // at the loop depths of the nest.
   std::vector<llvm::SmallVector<DependenceComponent, 2>> depCompsVec;
-  llvm::SmallVector<bool, 8> isParallelLoop(maxLoopDepth, true);
-  unsigned numOps = ops.size();
-  for (unsigned d = 1; d <= maxLoopDepth; ++d) {
-    for (unsigned i = 0; i < numOps; ++i) {
-      auto *srcOpInst = ops[i];
-      MemRefAccess srcAccess(srcOpInst);
-      for (unsigned j = 0; j < numOps; ++j) {
-        auto *dstOpInst = ops[j];
-        MemRefAccess dstAccess(dstOpInst);
-
-        FlatAffineConstraints dependenceConstraints;
-        llvm::SmallVector<DependenceComponent, 2> depComps;
-        // TODO(andydavis,bondhugula) Explore whether it would be profitable
-        // to pre-compute and store deps instead of repeatidly checking.
-        if (checkMemrefAccessDependence(srcAccess, dstAccess, d,
-                                        &dependenceConstraints, &depComps)) {
-          isParallelLoop[d - 1] = false;
-          depCompsVec.push_back(depComps);
-        }
-      }
-    }
-  }
+  llvm::SmallVector<bool, 8> isParallelLoop;
+  getLoopNestDependenceComponents(loops, ops, &depCompsVec, &isParallelLoop,
+                                  dependences);
+  unsigned maxLoopDepth = loops.size();
+
   // Count the number of parallel loops.
   unsigned numParallelLoops = 0;
   for (unsigned i = 0, e = isParallelLoop.size(); i < e; ++i)
@@ -1018,41 +388,20 @@ computeLoopInterchangePermutation(ArrayRef<Operation *> ops,
 
   // Compute permutation of loops that sinks sequential loops (and thus raises
   // parallel loops) while preserving relative order.
-  llvm::SmallVector<unsigned, 4> loopPermMapInv;
-  loopPermMapInv.resize(maxLoopDepth);
   loopPermMap->resize(maxLoopDepth);
   unsigned nextSequentialLoop = numParallelLoops;
   unsigned nextParallelLoop = 0;
   for (unsigned i = 0; i < maxLoopDepth; ++i) {
-    if (isParallelLoop[i]) {
-      (*loopPermMap)[i] = nextParallelLoop;
-      loopPermMapInv[nextParallelLoop++] = i;
-    } else {
-      (*loopPermMap)[i] = nextSequentialLoop;
-      loopPermMapInv[nextSequentialLoop++] = i;
-    }
+    if (isParallelLoop[i])
+      (*loopPermMap)[i] = nextParallelLoop++;
+    else
+      (*loopPermMap)[i] = nextSequentialLoop++;
   }
 
   // Check each dependence component against the permutation to see if the
   // desired loop interchange permutation would make the dependence vectors
   // lexicographically negative.
-  // Example 1: [-1, 1][0, 0]
-  // Example 2: [0, 0][-1, 1]
-  for (unsigned i = 0, e = depCompsVec.size(); i < e; ++i) {
-    llvm::SmallVector<DependenceComponent, 2> &depComps = depCompsVec[i];
-    assert(depComps.size() >= maxLoopDepth);
-    // Check if the first non-zero dependence component is positive.
-    for (unsigned j = 0; j < maxLoopDepth; ++j) {
-      unsigned permIndex = loopPermMapInv[j];
-      assert(depComps[permIndex].lb.hasValue());
-      int64_t depCompLb = depComps[permIndex].lb.getValue();
-      if (depCompLb > 0)
-        break;
-      if (depCompLb < 0)
-        return false;
-    }
-  }
-  return true;
+  return isValidLoopInterchangePermutation(depCompsVec, *loopPermMap);
 }
 
 // Sinks all sequential loops to the innermost levels (while preserving
@@ -1060,7 +409,9 @@ computeLoopInterchangePermutation(ArrayRef<Operation *> ops,
 // outermost (while again preserving relative order among them).
 // This can increase the loop depth at which we can fuse a slice, since we are
 // pushing loop carried dependence to a greater depth in the loop nest.
-static void sinkSequentialLoops(MemRefDependenceGraph::Node *node) {
+static void sinkSequentialLoops(MemRefDependenceGraph::Node *node,
+                                DependenceAnalysis *dependences,
+                                MemoryFootprintAnalysis *footprints) {
   assert(node->op->isa<AffineForOp>());
   // Get perfectly nested sequence of loops starting at root of loop nest
   // (the first op being another AffineFor, and the second op - a terminator).
@@ -1083,7 +434,8 @@ static void sinkSequentialLoops(MemRefDependenceGraph::Node *node) {
 
   // Compute loop permutation in 'loopPermMap'.
   llvm::SmallVector<unsigned, 4> loopPermMap;
-  if (!computeLoopInterchangePermutation(memOps, loops.size(), &loopPermMap))
+  if (!computeLoopInterchangePermutation(loops, memOps, &loopPermMap,
+                                         dependences))
     return;
 
   int loopNestRootIndex = -1;
@@ -1093,7 +445,11 @@ static void sinkSequentialLoops(MemRefDependenceGraph::Node *node) {
     if (permIndex == 0)
       loopNestRootIndex = i;
     if (permIndex > i) {
-      // Sink loop 'i' by 'permIndex - i' levels deeper into the loop nest.
+      // Sink loop 'i' by 'permIndex - i' levels deeper into the loop nest,
+      // which changes the dependences of the accesses it contains and the
+      // footprints of the loops it crosses.
+      dependences->invalidate(loops[i].getOperation());
+      footprints->invalidate(loops[i].getOperation());
       sinkLoop(loops[i], permIndex - i);
     }
   }
@@ -1314,24 +670,24 @@ static bool canFuseSrcWhichWritesToLiveOut(unsigned srcId, unsigned dstId,
   return true;
 }
 
-// Computes the union of all slice bounds computed between 'srcOpInst'
-// and each load op in 'dstLoadOpInsts' at 'dstLoopDepth', and returns
-// the union in 'sliceState'. Returns true on success, false otherwise.
+// Computes the union of all slice bounds computed between each op in
+// 'srcOpInsts' and each load op in 'dstLoadOpInsts' at 'dstLoopDepth', and
+// returns the union in 'sliceState'. The ops in 'srcOpInsts' are expected to
+// share their 'numSrcLoopIVs' surrounding loops, which the slice is a slice of.
+// Returns true on success, false otherwise.
 // TODO(andydavis) Move this to a loop fusion utility function.
-static bool getSliceUnion(Operation *srcOpInst,
+static bool getSliceUnion(ArrayRef<Operation *> srcOpInsts,
                           ArrayRef<Operation *> dstLoadOpInsts,
                           unsigned numSrcLoopIVs, unsigned dstLoopDepth,
                           ComputationSliceState *sliceState) {
-  MemRefAccess srcAccess(srcOpInst);
-  unsigned numDstLoadOpInsts = dstLoadOpInsts.size();
-  assert(numDstLoadOpInsts > 0);
-  // Compute the slice bounds between 'srcOpInst' and 'dstLoadOpInsts[0]'.
+  assert(!srcOpInsts.empty() && !dstLoadOpInsts.empty());
+  // Compute the slice bounds between 'srcOpInsts[0]' and 'dstLoadOpInsts[0]'.
   if (failed(mlir::getBackwardComputationSliceState(
-          srcAccess, MemRefAccess(dstLoadOpInsts[0]), dstLoopDepth,
-          sliceState)))
+          MemRefAccess(srcOpInsts[0]), MemRefAccess(dstLoadOpInsts[0]),
+          dstLoopDepth, sliceState)))
     return false;
-  // Handle the common case of one dst load without a copy.
-  if (numDstLoadOpInsts == 1)
+  // Handle the common case of one src op and one dst load without a copy.
+  if (srcOpInsts.size() == 1 && dstLoadOpInsts.size() == 1)
     return true;
 
   // Initialize 'sliceUnionCst' with the bounds computed in previous step.
@@ -1341,30 +697,37 @@ static bool getSliceUnion(Operation *srcOpInst,
     return false;
   }
 
-  // Compute the union of slice bounds between 'srcOpInst' and each load
-  // in 'dstLoadOpInsts' in range [1, numDstLoadOpInsts), in 'sliceUnionCst'.
-  for (unsigned i = 1; i < numDstLoadOpInsts; ++i) {
-    MemRefAccess dstAccess(dstLoadOpInsts[i]);
-    // Compute slice bounds for 'srcOpInst' and 'dstLoadOpInsts[i]'.
-    ComputationSliceState tmpSliceState;
-    if (failed(mlir::getBackwardComputationSliceState(
-            srcAccess, dstAccess, dstLoopDepth, &tmpSliceState))) {
-      LLVM_DEBUG(llvm::dbgs() << "Unable to compute slice bounds\n.");
-      return false;
-    }
+  // Compute the union of slice bounds between each op in 'srcOpInsts' and
+  // each load in 'dstLoadOpInsts', other than the pair of the previous step,
+  // in 'sliceUnionCst'.
+  for (auto *srcOpInst : srcOpInsts) {
+    MemRefAccess srcAccess(srcOpInst);
+    for (auto *dstLoadOpInst : dstLoadOpInsts) {
+      if (srcOpInst == srcOpInsts[0] && dstLoadOpInst == dstLoadOpInsts[0])
+        continue;
+      MemRefAccess dstAccess(dstLoadOpInst);
+      // Compute slice bounds for 'srcOpInst' and 'dstLoadOpInst'.
+      ComputationSliceState tmpSliceState;
+      if (failed(mlir::getBackwardComputationSliceState(
+              srcAccess, dstAccess, dstLoopDepth, &tmpSliceState))) {
+        LLVM_DEBUG(llvm::dbgs() << "Unable to compute slice bounds\n.");
+        return false;
+      }
 
-    // Compute constraints for 'tmpSliceState' in 'tmpSliceCst'.
-    FlatAffineConstraints tmpSliceCst;
-    if (failed(tmpSliceState.getAsConstraints(&tmpSliceCst))) {
-      LLVM_DEBUG(llvm::dbgs()
-                 << "Unable to compute slice bound constraints\n.");
-      return false;
-    }
-    // Compute union bounding box of 'sliceUnionCst' and 'tmpSliceCst'.
-    if (failed(sliceUnionCst.unionBoundingBox(tmpSliceCst))) {
-      LLVM_DEBUG(llvm::dbgs()
-                 << "Unable to compute union bounding box of slice bounds.\n.");
-      return false;
+      // Compute constraints for 'tmpSliceState' in 'tmpSliceCst'.
+      FlatAffineConstraints tmpSliceCst;
+      if (failed(tmpSliceState.getAsConstraints(&tmpSliceCst))) {
+        LLVM_DEBUG(llvm::dbgs()
+                   << "Unable to compute slice bound constraints\n.");
+        return false;
+      }
+      // Compute union bounding box of 'sliceUnionCst' and 'tmpSliceCst'.
+      if (failed(sliceUnionCst.unionBoundingBox(tmpSliceCst))) {
+        LLVM_DEBUG(
+            llvm::dbgs()
+            << "Unable to compute union bounding box of slice bounds.\n.");
+        return false;
+      }
     }
   }
 
@@ -1376,7 +739,7 @@ static bool getSliceUnion(Operation *srcOpInst,
   sliceState->ubs.resize(numSrcLoopIVs, AffineMap());
 
   // Get slice bounds from slice union constraints 'sliceUnionCst'.
-  sliceUnionCst.getSliceBounds(numSrcLoopIVs, srcOpInst->getContext(),
+  sliceUnionCst.getSliceBounds(numSrcLoopIVs, srcOpInsts[0]->getContext(),
                                &sliceState->lbs, &sliceState->ubs);
   // Add slice bound operands of union.
   SmallVector<Value *, 4> sliceBoundOperands;
@@ -1390,24 +753,121 @@ static bool getSliceUnion(Operation *srcOpInst,
   return true;
 }
 
+// Estimates the number of bytes moved from the memory by the loop nest rooted
+// at 'forOp'. Data is reused across the iterations of a loop only if the
+// footprint of the loop, which bounds the reuse distance, fits in the cache.
+// Otherwise, each iteration moves the traffic of the inner loops. Returns None
+// if a footprint or a trip count is not constant. The footprints are computed
+// through 'footprints', which caches them across the fusion candidates.
+// TODO(andydavis) Account for the accesses outside of the inner loops in the
+// body of a non-innermost loop.
+static Optional<uint64_t>
+estimateMemoryTraffic(AffineForOp forOp, MemoryFootprintAnalysis *footprints,
+                      const TargetMemoryModel &memoryModel) {
+  Optional<int64_t> footprint = footprints->getFootprintBytes(forOp);
+  if (!footprint.hasValue())
+    return None;
+  SmallVector<AffineForOp, 2> innerLoops;
+  for (auto &op : *forOp.getBody())
+    if (auto innerLoop = op.dyn_cast<AffineForOp>())
+      innerLoops.push_back(innerLoop);
+  if (innerLoops.empty() || memoryModel.fitsInCache(footprint.getValue()))
+    return memoryModel.getStreamTraffic(footprint.getValue());
+
+  Optional<uint64_t> tripCount = getConstantTripCount(forOp);
+  if (!tripCount.hasValue())
+    return None;
+  uint64_t bodyTraffic = 0;
+  for (auto innerLoop : innerLoops) {
+    Optional<uint64_t> innerTraffic =
+        estimateMemoryTraffic(innerLoop, footprints, memoryModel);
+    if (!innerTraffic.hasValue())
+      return None;
+    bodyTraffic += innerTraffic.getValue();
+  }
+  return llvm::SaturatingMultiply(tripCount.getValue(), bodyTraffic);
+}
+
+// Estimates the number of bytes moved from the memory by the dst loop nest
+// 'dstLoopIVs' once a slice of the src loop nest, whose write region has
+// 'sliceWriteRegionSizeBytes' bytes, is inserted at 'dstLoopDepth'. The
+// slice repeats 'sliceRedundancy' times the traffic 'srcTraffic' of the src
+// loop nest. If the slice and an iteration of the dst loop at 'dstLoopDepth'
+// fit together in the cache, the 'intermediateSizeBytes' bytes written by the
+// slice and read by the dst loop nest no longer go through the memory.
+// Otherwise, the slice evicts the data that the dst loop nest reuses across
+// the iterations of its inner loops. Returns None if a footprint or a trip
+// count is not constant.
+static Optional<uint64_t> estimateFusedMemoryTraffic(
+    ArrayRef<AffineForOp> dstLoopIVs, unsigned dstLoopDepth,
+    int64_t sliceWriteRegionSizeBytes, uint64_t srcTraffic,
+    double sliceRedundancy, int64_t intermediateSizeBytes,
+    MemoryFootprintAnalysis *footprints, const TargetMemoryModel &memoryModel) {
+  uint64_t numOuterIterations = 1;
+  for (unsigned d = 0; d < dstLoopDepth; ++d) {
+    Optional<uint64_t> tripCount = getConstantTripCount(dstLoopIVs[d]);
+    if (!tripCount.hasValue())
+      return None;
+    numOuterIterations =
+        llvm::SaturatingMultiply(numOuterIterations, tripCount.getValue());
+  }
+
+  Block *body = dstLoopIVs[dstLoopDepth - 1].getBody();
+  Optional<int64_t> bodyFootprint =
+      footprints->getBodyFootprintBytes(dstLoopIVs[dstLoopDepth - 1]);
+  if (!bodyFootprint.hasValue())
+    return None;
+  bool fits = memoryModel.fitsInCache(bodyFootprint.getValue() +
+                                      sliceWriteRegionSizeBytes);
+
+  // An iteration which fits in the cache moves its footprint once; its lines
+  // are shared with the neighboring iterations, which is why the footprint is
+  // not rounded up to whole lines.
+  uint64_t iterationTraffic = 0;
+  if (fits) {
+    iterationTraffic = bodyFootprint.getValue();
+  } else {
+    for (auto &op : *body) {
+      auto innerLoop = op.dyn_cast<AffineForOp>();
+      if (!innerLoop)
+        continue;
+      Optional<uint64_t> innerTraffic =
+          estimateMemoryTraffic(innerLoop, footprints, memoryModel);
+      if (!innerTraffic.hasValue())
+        return None;
+      iterationTraffic += innerTraffic.getValue();
+    }
+  }
+
+  double fusedTraffic =
+      static_cast<double>(numOuterIterations) * iterationTraffic +
+      sliceRedundancy * srcTraffic;
+  if (fits)
+    fusedTraffic -= 2.0 * intermediateSizeBytes;
+  double maxTraffic = std::numeric_limits<int64_t>::max();
+  return static_cast<uint64_t>(std::min(std::max(fusedTraffic, 0.0),
+                                        maxTraffic));
+}
+
 // Checks the profitability of fusing a backwards slice of the loop nest
-// surrounding 'srcOpInst' into the loop nest surrounding 'dstLoadOpInsts'.
+// surrounding 'srcOpInsts' into the loop nest surrounding 'dstLoadOpInsts'.
 // The argument 'srcStoreOpInst' is used to calculate the storage reduction on
 // the memref being produced and consumed, which is an input to the cost model.
-// For producer-constumer fusion, 'srcStoreOpInst' will be the same as
-// 'srcOpInst', as we are slicing w.r.t to that producer.
-// For input-reuse fusion, 'srcOpInst' will be the src loop nest LoadOp which
-// reads from the same memref as dst loop nest load ops, and 'srcStoreOpInst'
-// will be the unique store op in the src node, which will be used to check
-// that the write region is the same after input-reuse fusion.
+// For producer-constumer fusion, 'srcOpInsts' will be the single op
+// 'srcStoreOpInst', as we are slicing w.r.t to that producer.
+// For input-reuse fusion, 'srcOpInsts' will be the src loop nest LoadOps which
+// read from the same memref as dst loop nest load ops (and share their
+// surrounding loops), and 'srcStoreOpInst' will be the unique store op in the
+// src node, which will be used to check that the write region is the same
+// after input-reuse fusion.
 // Returns true if it is profitable to fuse the candidate loop nests. Returns
 // false otherwise. `dstLoopDepth` is set to the most profitable depth at which
 // to materialize the source loop nest slice.
 // The profitability model executes the following steps:
-// *) Computes the backward computation slice at 'srcOpInst'. This
-//    computation slice of the loop nest surrounding 'srcOpInst' is
+// *) Computes the backward computation slice at 'srcOpInsts'. This
+//    computation slice of the loop nest surrounding 'srcOpInsts' is
 //    represented by modified src loop bounds in 'sliceState', which are
-//    functions of loop IVs in the loop nest surrounding 'srcOpInst'.
+//    functions of loop IVs in the loop nest surrounding 'srcOpInsts'.
 // *) Computes the cost of unfused src/dst loop nests (currently the cost of a
 //    loop nest is the total number of dynamic operation instances in the loop
 //    nest).
@@ -1417,8 +877,9 @@ static bool getSliceUnion(Operation *srcOpInst,
 //    load) to minimize reuse distance and potentially enable subsequent
 //    load/store forwarding.
 //    NOTE: If the dst loop nest includes multiple loads in 'dstLoadOpInsts' for
-//    the same memref as is written by 'srcOpInst', then the union of slice
-//    loop bounds is used to compute the slice and associated slice cost.
+//    the same memref as is accessed by 'srcOpInsts', or if there are several
+//    ops in 'srcOpInsts', then the union of slice loop bounds over all pairs
+//    of ops is used to compute the slice and associated slice cost.
 //    NOTE: 'dstLoopDepth' refers to the loop depth within the destination loop
 //    nest, at which the src computation slice is inserted/fused.
 //    NOTE: We attempt to maximize the dst loop depth, but there are cases
@@ -1428,19 +889,29 @@ static bool getSliceUnion(Operation *srcOpInst,
 // *) Compares the total cost of the unfused loop nests to the min cost fused
 //    loop nest computed in the previous step, and returns true if the latter
 //    is lower.
-static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
+static bool isFusionProfitable(ArrayRef<Operation *> srcOpInsts,
+                               Operation *srcStoreOpInst,
                                ArrayRef<Operation *> dstLoadOpInsts,
                                ArrayRef<Operation *> dstStoreOpInsts,
                                ComputationSliceState *sliceState,
-                               unsigned *dstLoopDepth, bool maximalFusion) {
+                               unsigned *dstLoopDepth, bool maximalFusion,
+                               DependenceAnalysis *dependences,
+                               MemoryFootprintAnalysis *footprints,
+                               const TargetMemoryModel &memoryModel) {
   LLVM_DEBUG({
     llvm::dbgs() << "Checking whether fusion is profitable between:\n";
-    llvm::dbgs() << " " << *srcOpInst << " and \n";
+    for (auto srcOpInst : srcOpInsts) {
+      llvm::dbgs() << " " << *srcOpInst << "\n";
+    };
+    llvm::dbgs() << " and \n";
     for (auto dstOpInst : dstLoadOpInsts) {
       llvm::dbgs() << " " << *dstOpInst << "\n";
     };
   });
 
+  // The src ops share their surrounding loops; 'srcOpInst' stands for them.
+  Operation *srcOpInst = srcOpInsts[0];
+
   // Compute cost of sliced and unsliced src loop nest.
   SmallVector<AffineForOp, 4> srcLoopIVs;
   getLoopIVs(*srcOpInst, &srcLoopIVs);
@@ -1472,7 +943,7 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
   // and still satisfy dest loop nest dependences, for producer-consumer fusion.
   unsigned maxDstLoopDepth =
       (srcOpInst == srcStoreOpInst)
-          ? getMaxLoopDepth(dstLoadOpInsts, dstStoreOpInsts)
+          ? getMaxLoopDepth(dstLoadOpInsts, dstStoreOpInsts, dependences)
           : dstLoopIVs.size();
   if (maxDstLoopDepth == 0) {
     LLVM_DEBUG(llvm::dbgs() << "Can't fuse: maxDstLoopDepth == 0 .\n");
@@ -1481,7 +952,7 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
 
   // Search for min cost value for 'dstLoopDepth'. At each value of
   // 'dstLoopDepth' from 'maxDstLoopDepth' to '1', compute computation slice
-  // bounds between 'srcOpInst' and each op in 'dstOpinsts' (taking the union
+  // bounds between 'srcOpInsts' and each op in 'dstOpinsts' (taking the union
   // of these bounds). Next the union slice bounds are used to calculate
   // the cost of the slice and the cost of the slice inserted into the dst
   // loop nest at 'dstLoopDepth'.
@@ -1520,13 +991,30 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
                      /*tripCountOverrideMap=*/nullptr,
                      /*computeCostMap=*/nullptr);
 
+  // Estimate the memory traffic of the unfused loop nests, which fusion
+  // should not increase. The estimate is only needed when the loop nests do
+  // not fit together in the cache; otherwise, the reduction of their storage
+  // decides alone.
+  Optional<uint64_t> srcTraffic, dstTraffic;
+  if (!maximalFusion) {
+    srcTraffic = estimateMemoryTraffic(srcLoopIVs[0], footprints, memoryModel);
+    dstTraffic = estimateMemoryTraffic(dstLoopIVs[0], footprints, memoryModel);
+  }
+  bool checkMemoryTraffic =
+      srcTraffic.hasValue() && dstTraffic.hasValue() &&
+      !memoryModel.fitsInCache(srcTraffic.getValue() + dstTraffic.getValue());
+  // The intermediate memref only stays in the cache with producer-consumer
+  // fusion.
+  int64_t intermediateSizeBytes =
+      srcOpInst == srcStoreOpInst ? srcWriteRegionSizeBytes : 0;
+
   // Evaluate all depth choices for materializing the slice in the destination
   // loop nest.
   llvm::SmallDenseMap<Operation *, uint64_t, 8> sliceTripCountMap;
   DenseMap<Operation *, int64_t> computeCostMap;
   for (unsigned i = maxDstLoopDepth; i >= 1; --i) {
     // Compute the union of slice bounds of all ops in 'dstLoadOpInsts'.
-    if (!getSliceUnion(srcOpInst, dstLoadOpInsts, numSrcLoopIVs, i,
+    if (!getSliceUnion(srcOpInsts, dstLoadOpInsts, numSrcLoopIVs, i,
                        &sliceStates[i - 1])) {
       LLVM_DEBUG(llvm::dbgs()
                  << "getSliceUnion failed for loopDepth: " << i << "\n");
@@ -1616,6 +1104,30 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
     double storageReduction = static_cast<double>(srcWriteRegionSizeBytes) /
                               static_cast<double>(sliceWriteRegionSizeBytes);
 
+    // Skip this depth if the fused loop nest is estimated to move more data
+    // from the memory than the unfused ones.
+    if (checkMemoryTraffic) {
+      double sliceRedundancy =
+          std::max(0.0, (static_cast<double>(fusedLoopNestComputeCost) -
+                         dstLoopNestCost) /
+                            srcLoopNestCost);
+      Optional<uint64_t> fusedTraffic = estimateFusedMemoryTraffic(
+          dstLoopIVs, i, sliceWriteRegionSizeBytes, srcTraffic.getValue(),
+          sliceRedundancy, intermediateSizeBytes, footprints, memoryModel);
+      uint64_t unfusedTraffic = srcTraffic.getValue() + dstTraffic.getValue();
+      LLVM_DEBUG(llvm::dbgs()
+                 << "   unfused memory cycles: "
+                 << memoryModel.getTransferCycles(unfusedTraffic) << "\n"
+                 << "   fused memory cycles: "
+                 << (fusedTraffic.hasValue()
+                         ? memoryModel.getTransferCycles(
+                               fusedTraffic.getValue())
+                         : -1.0)
+                 << "\n");
+      if (fusedTraffic.hasValue() && fusedTraffic.getValue() > unfusedTraffic)
+        continue;
+    }
+
     LLVM_DEBUG({
       std::stringstream msg;
       msg << "  evaluating fusion profitability at depth : " << i << "\n"
@@ -1677,8 +1189,8 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
                    << "\n  fused loop nest compute cost: "
                    << minFusedLoopNestComputeCost << "\n");
 
-  auto dstMemSize = getMemoryFootprintBytes(dstLoopIVs[0]);
-  auto srcMemSize = getMemoryFootprintBytes(srcLoopIVs[0]);
+  auto dstMemSize = footprints->getFootprintBytes(dstLoopIVs[0]);
+  auto srcMemSize = footprints->getFootprintBytes(srcLoopIVs[0]);
 
   Optional<double> storageReduction = None;
 
@@ -1757,6 +1269,8 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
 // *) For each node id in the worklist:
 //   *) Pop a AffineForOp of the worklist. This 'dstAffineForOp' will be a
 //      candidate destination AffineForOp into which fusion will be attempted.
+//   *) Attempt to fuse, in a single transformation, the producer loop nests
+//      of several memrefs loaded by 'dstAffineForOp' (see fuseProducerFanIn).
 //   *) Add each LoadOp currently in 'dstAffineForOp' into list 'dstLoadOps'.
 //   *) For each LoadOp in 'dstLoadOps' do:
 //      *) Lookup dependent loop nests which have a single store op to the same
@@ -1777,8 +1291,12 @@ static bool isFusionProfitable(Operation *srcOpInst, Operation *srcStoreOpInst,
 // *) For each 'dstNode' in the worklist:
 //   *) Find a candidate sibling node 'sibNode' to fuse with 'dstNode' which
 //      loads from the same memref, but which has no dependence paths to/from.
+//      The loads of 'sibNode' from that memref may be several, as long as
+//      they share their surrounding loops.
 //   *) Get a computation slice of 'sibLoopNest', which adjusts its loop
-//      bounds to be functions of 'dstLoopNest' IVs and symbols.
+//      bounds to be functions of 'dstLoopNest' IVs and symbols. The slice is
+//      the union of the slices computed between each load of 'sibNode' and
+//      each load of 'dstNode' from the shared memref.
 //   *) Fuse the 'sibLoopNest' computation slice into the 'dstLoopNest',
 //      at a loop depth determined by the cost model in 'isFusionProfitable'.
 //      This function also checks that the memref write region of 'sibLoopNest',
@@ -1808,13 +1326,33 @@ public:
   // If true, ignore any additional (redundant) computation tolerance threshold
   // that would have prevented fusion.
   bool maximalFusion;
+  // The cached dependences between the accesses of the function, invalidated
+  // for the loop nests modified by fusion.
+  DependenceAnalysis *dependences;
+  // The cached footprints of the loop nests, invalidated along with the
+  // dependences.
+  MemoryFootprintAnalysis *footprints;
+  // The memory hierarchy used to estimate the memory traffic of fusions.
+  const TargetMemoryModel *memoryModel;
+  // Memrefs whose accesses in some fused loop nest were replaced by those of
+  // a private memref.
+  llvm::SmallSetVector<Value *, 4> privatizedMemRefs;
+  // The pass running the fusion, whose budget is consumed by each candidate
+  // fusion evaluated. The fusions done before the budget is exhausted are
+  // kept.
+  Pass *pass;
 
   using Node = MemRefDependenceGraph::Node;
 
   GreedyFusion(MemRefDependenceGraph *mdg, unsigned localBufSizeThreshold,
-               Optional<unsigned> fastMemorySpace, bool maximalFusion)
+               Optional<unsigned> fastMemorySpace, bool maximalFusion,
+               DependenceAnalysis *dependences,
+               MemoryFootprintAnalysis *footprints,
+               const TargetMemoryModel *memoryModel, Pass *pass)
       : mdg(mdg), localBufSizeThreshold(localBufSizeThreshold),
-        fastMemorySpace(fastMemorySpace), maximalFusion(maximalFusion) {}
+        fastMemorySpace(fastMemorySpace), maximalFusion(maximalFusion),
+        dependences(dependences), footprints(footprints),
+        memoryModel(memoryModel), pass(pass) {}
 
   // Initializes 'worklist' with nodes from 'mdg'
   void init() {
@@ -1840,12 +1378,13 @@ public:
     fuseSiblingNodes();
     fuseProducerConsumerNodes(
         /*maxSrcUserCount=*/std::numeric_limits<unsigned>::max());
+    eraseDeadPrivatizedMemRefs();
     eraseUnusedMemRefAllocations();
   }
 
   void fuseProducerConsumerNodes(unsigned maxSrcUserCount) {
     init();
-    while (!worklist.empty()) {
+    while (!worklist.empty() && !pass->isBudgetExhausted()) {
       unsigned dstId = worklist.back();
       worklist.pop_back();
       worklistSet.erase(dstId);
@@ -1855,14 +1394,21 @@ public:
         continue;
       // Get 'dstNode' into which to attempt fusion.
       auto *dstNode = mdg->getNode(dstId);
-      // Skip if 'dstNode' is not a loop nest.
-      if (!dstNode->op->isa<AffineForOp>())
+      // Skip if 'dstNode' is not a loop nest, or if the profile given with
+      // -loop-profile shows it to be cold.
+      if (!dstNode->op->isa<AffineForOp>() ||
+          isColdLoop(dstNode->op->cast<AffineForOp>()))
         continue;
       // Sink sequential loops in 'dstNode' (and thus raise parallel loops)
       // while preserving relative order. This can increase the maximum loop
       // depth at which we can fuse a slice of a producer loop nest into a
       // consumer loop nest.
-      sinkSequentialLoops(dstNode);
+      sinkSequentialLoops(dstNode, dependences, footprints);
+
+      // Fuse the producers of several memrefs loaded by 'dstNode' at once, if
+      // possible. The remaining producers are considered one at a time below.
+      if (fuseProducerFanIn(dstId, maxSrcUserCount))
+        dstNode = mdg->getNode(dstId);
 
       SmallVector<Operation *, 4> loads = dstNode->loads;
       SmallVector<Operation *, 4> dstLoadOpInsts;
@@ -1928,12 +1474,17 @@ public:
             if (storeOpInst->cast<StoreOp>().getMemRef() == memref)
               dstStoreOpInsts.push_back(storeOpInst);
 
+          // Stop searching once the budget of the pass is exhausted.
+          if (!pass->consumeBudget())
+            return;
+
           unsigned bestDstLoopDepth;
           mlir::ComputationSliceState sliceState;
           // Check if fusion would be profitable.
           if (!isFusionProfitable(srcStoreOpInst, srcStoreOpInst,
                                   dstLoadOpInsts, dstStoreOpInsts, &sliceState,
-                                  &bestDstLoopDepth, maximalFusion))
+                                  &bestDstLoopDepth, maximalFusion,
+                                  dependences, footprints, *memoryModel))
             continue;
 
           // Fuse computation slice of 'srcLoopNest' into 'dstLoopNest'.
@@ -1942,6 +1493,8 @@ public:
           if (sliceLoopNest) {
             LLVM_DEBUG(llvm::dbgs() << "\tslice loop nest:\n"
                                     << *sliceLoopNest.getOperation() << "\n");
+            dependences->invalidate(dstNode->op);
+            footprints->invalidate(dstNode->op);
             // Move 'dstAffineForOp' before 'insertPointInst' if needed.
             auto dstAffineForOp = dstNode->op->cast<AffineForOp>();
             if (insertPointInst != dstAffineForOp.getOperation()) {
@@ -1965,6 +1518,7 @@ public:
                   storesForMemref.push_back(storeOpInst);
               }
               assert(storesForMemref.size() == 1);
+              privatizedMemRefs.insert(memref);
               auto *newMemRef = createPrivateMemRef(
                   dstAffineForOp, storesForMemref[0], bestDstLoopDepth,
                   fastMemorySpace, localBufSizeThreshold);
@@ -1989,9 +1543,8 @@ public:
             }
 
             // Clear and add back loads and stores
-            mdg->clearNodeLoadAndStores(dstNode->id);
-            mdg->addToNode(dstId, dstLoopCollector.loadOpInsts,
-                           dstLoopCollector.storeOpInsts);
+            mdg->updateNodeAccesses(dstId, dstLoopCollector.loadOpInsts,
+                                    dstLoopCollector.storeOpInsts);
             // Remove old src loop nest if it no longer has outgoing dependence
             // edges, and it does not write to a memref which escapes the
             // function. If 'writesToLiveInOrOut' is true, then 'srcNode' has
@@ -1999,8 +1552,11 @@ public:
             // the write region of 'srcNode', and 'srcNode' has no other users
             // so it is safe to remove.
             if (writesToLiveInOrOut || mdg->canRemoveNode(srcNode->id)) {
+              Operation *srcOp = srcNode->op;
               mdg->removeNode(srcNode->id);
-              srcNode->op->erase();
+              dependences->invalidate(srcOp);
+              footprints->invalidate(srcOp);
+              srcOp->erase();
             } else {
               // Add remaining users of 'oldMemRef' back on the worklist (if not
               // already there), as its replacement with a local/private memref
@@ -2024,11 +1580,173 @@ public:
     }
   }
 
+  // Attempts to fuse into node 'dstId', in a single transformation, the
+  // producer loop nests of several of the memrefs that it loads (a fan-in).
+  // A candidate producer is the only node with an edge on its memref to
+  // 'dstId'; it is a loop nest with a single store, to that memref, and it
+  // writes no live in or escaping memref. The slice of each candidate is the
+  // union of the slices for all the loads of its memref in 'dstId', and is
+  // inserted at its own most profitable depth. The fused loop nest is moved
+  // once, to an insertion point which preserves the dependences of all the
+  // candidates. Returns true if at least two producers were fused.
+  bool fuseProducerFanIn(unsigned dstId, unsigned maxSrcUserCount) {
+    // A candidate producer and the slice at which it is fused.
+    struct FanInCandidate {
+      unsigned srcId;
+      Value *memref;
+      SmallVector<Operation *, 2> dstLoadOpInsts;
+      ComputationSliceState sliceState;
+      unsigned dstLoopDepth;
+    };
+    SmallVector<FanInCandidate, 4> candidates;
+    SmallVector<unsigned, 4> srcIds;
+
+    // Visit the memrefs in the order in which they would be fused one at a
+    // time, so that the slices are laid out in the same order.
+    auto *dstNode = mdg->getNode(dstId);
+    DenseSet<Value *> visitedMemrefs;
+    for (auto *loadOpInst : llvm::reverse(dstNode->loads)) {
+      auto *memref = loadOpInst->cast<LoadOp>().getMemRef();
+      if (!visitedMemrefs.insert(memref).second)
+        continue;
+      // Skip 'memref' if 'dstNode' writes to it, or if it has another
+      // incoming edge than the one from its producer.
+      if (dstNode->getStoreOpCount(memref) > 0)
+        continue;
+      SmallVector<unsigned, 2> inNodeIds;
+      mdg->forEachMemRefInputEdge(dstId, [&](MemRefDependenceGraph::Edge edge) {
+        if (edge.value == memref)
+          inNodeIds.push_back(edge.id);
+      });
+      if (inNodeIds.size() != 1)
+        continue;
+      unsigned srcId = inNodeIds[0];
+      auto *srcNode = mdg->getNode(srcId);
+      if (!srcNode->op->isa<AffineForOp>() || srcNode->stores.size() != 1 ||
+          srcNode->getStoreOpCount(memref) != 1 ||
+          srcNode->getLoadOpCount(memref) != 0)
+        continue;
+      if (mdg->writesToLiveInOrEscapingMemrefs(srcId) ||
+          mdg->getOutEdgeCount(srcId, memref) > maxSrcUserCount)
+        continue;
+      // Skip 'srcNode' if it depends on (or is a dependence of) another
+      // candidate, since their slices are fused side by side.
+      if (llvm::any_of(srcIds, [&](unsigned otherId) {
+            return mdg->hasEdge(srcId, otherId) || mdg->hasEdge(otherId, srcId);
+          }))
+        continue;
+
+      // Fuse the candidates found so far once the budget of the pass is
+      // exhausted.
+      if (!pass->consumeBudget())
+        break;
+
+      FanInCandidate candidate;
+      candidate.srcId = srcId;
+      candidate.memref = memref;
+      dstNode->getLoadOpsForMemref(memref, &candidate.dstLoadOpInsts);
+      auto *srcStoreOpInst = srcNode->stores.front();
+      if (!isFusionProfitable(srcStoreOpInst, srcStoreOpInst,
+                              candidate.dstLoadOpInsts,
+                              /*dstStoreOpInsts=*/{}, &candidate.sliceState,
+                              &candidate.dstLoopDepth, maximalFusion,
+                              dependences, footprints, *memoryModel))
+        continue;
+      candidates.push_back(std::move(candidate));
+      srcIds.push_back(srcId);
+    }
+    if (candidates.size() < 2)
+      return false;
+
+    // Compute an operation list insertion point for the fused loop nest which
+    // preserves the dependences of all the candidates.
+    Operation *insertPointInst =
+        mdg->getFusedLoopNestInsertionPoint(srcIds, dstId);
+    if (insertPointInst == nullptr)
+      return false;
+
+    LLVM_DEBUG(llvm::dbgs() << "Fusing " << candidates.size()
+                            << " producers into node " << dstId << "\n");
+    // Fuse the computation slice of each candidate into 'dstAffineForOp'.
+    auto dstAffineForOp = dstNode->op->cast<AffineForOp>();
+    SmallVector<AffineForOp, 4> sliceLoopNests;
+    for (auto &candidate : candidates) {
+      auto *srcStoreOpInst = mdg->getNode(candidate.srcId)->stores.front();
+      sliceLoopNests.push_back(mlir::insertBackwardComputationSlice(
+          srcStoreOpInst, candidate.dstLoadOpInsts[0], candidate.dstLoopDepth,
+          &candidate.sliceState));
+    }
+    dependences->invalidate(dstAffineForOp.getOperation());
+    footprints->invalidate(dstAffineForOp.getOperation());
+    // Move 'dstAffineForOp' before 'insertPointInst' if needed.
+    if (insertPointInst != dstAffineForOp.getOperation())
+      dstAffineForOp.getOperation()->moveBefore(insertPointInst);
+
+    for (unsigned i = 0, e = candidates.size(); i < e; ++i) {
+      auto &candidate = candidates[i];
+      if (!sliceLoopNests[i])
+        continue;
+      // Update edges between the candidate and 'dstNode'.
+      mdg->updateEdges(candidate.srcId, dstId, candidate.memref);
+
+      // Promote single iteration slice loops to single IV value.
+      LoopNestStateCollector sliceCollector;
+      sliceCollector.collect(sliceLoopNests[i].getOperation());
+      for (auto forOp : sliceCollector.forOps)
+        promoteIfSingleIteration(forOp);
+
+      // Create private memref for the memref of the candidate.
+      assert(sliceCollector.storeOpInsts.size() == 1);
+      privatizedMemRefs.insert(
+          sliceCollector.storeOpInsts[0]->cast<StoreOp>().getMemRef());
+      auto *newMemRef = createPrivateMemRef(
+          dstAffineForOp, sliceCollector.storeOpInsts[0],
+          candidate.dstLoopDepth, fastMemorySpace, localBufSizeThreshold);
+      // Create new node in dependence graph for 'newMemRef' alloc op.
+      unsigned newMemRefNodeId = mdg->addNode(newMemRef->getDefiningOp());
+      // Add edge from 'newMemRef' node to dstNode.
+      mdg->addEdge(newMemRefNodeId, dstId, newMemRef);
+    }
+
+    // Clear and add back loads and stores.
+    LoopNestStateCollector dstLoopCollector;
+    dstLoopCollector.collect(dstAffineForOp.getOperation());
+    mdg->updateNodeAccesses(dstId, dstLoopCollector.loadOpInsts,
+                            dstLoopCollector.storeOpInsts);
+
+    // Remove the candidates which no longer have outgoing dependence edges.
+    // Add the remaining users of the memrefs of the others back on the
+    // worklist, as their dependences on these memrefs were reduced.
+    for (unsigned i = 0, e = candidates.size(); i < e; ++i) {
+      auto &candidate = candidates[i];
+      if (!sliceLoopNests[i])
+        continue;
+      if (mdg->canRemoveNode(candidate.srcId)) {
+        Operation *srcOp = mdg->getNode(candidate.srcId)->op;
+        mdg->removeNode(candidate.srcId);
+        dependences->invalidate(srcOp);
+        footprints->invalidate(srcOp);
+        srcOp->erase();
+        continue;
+      }
+      if (mdg->outEdges.count(candidate.srcId) == 0)
+        continue;
+      for (auto &outEdge : mdg->outEdges[candidate.srcId]) {
+        if (outEdge.value == candidate.memref &&
+            worklistSet.count(outEdge.id) == 0) {
+          worklist.push_back(outEdge.id);
+          worklistSet.insert(outEdge.id);
+        }
+      }
+    }
+    return true;
+  }
+
   // Visits each node in the graph, and for each node, attempts to fuse it with
   // its sibling nodes (nodes which share a parent, but no dependence edges).
   void fuseSiblingNodes() {
     init();
-    while (!worklist.empty()) {
+    while (!worklist.empty() && !pass->isBudgetExhausted()) {
       unsigned dstId = worklist.back();
       worklist.pop_back();
       worklistSet.erase(dstId);
@@ -2038,8 +1756,10 @@ public:
         continue;
       // Get 'dstNode' into which to attempt fusion.
       auto *dstNode = mdg->getNode(dstId);
-      // Skip if 'dstNode' is not a loop nest.
-      if (!dstNode->op->isa<AffineForOp>())
+      // Skip if 'dstNode' is not a loop nest, or if the profile given with
+      // -loop-profile shows it to be cold.
+      if (!dstNode->op->isa<AffineForOp>() ||
+          isColdLoop(dstNode->op->cast<AffineForOp>()))
         continue;
       // Attempt to fuse 'dstNode' with its sibling nodes in the graph.
       fuseWithSiblingNodes(dstNode);
@@ -2068,12 +1788,11 @@ public:
 
       // Check if fusion would be profitable and at what depth.
 
-      // Get unique 'sibNode' load op to 'memref'.
+      // Gather 'sibNode' load ops to 'memref', which findSiblingNodeToFuse
+      // checked share their surrounding loops.
       SmallVector<Operation *, 2> sibLoadOpInsts;
       sibNode->getLoadOpsForMemref(memref, &sibLoadOpInsts);
-      // Currently findSiblingNodeToFuse searches for siblings with one load.
-      assert(sibLoadOpInsts.size() == 1);
-      Operation *sibLoadOpInst = sibLoadOpInsts[0];
+      assert(!sibLoadOpInsts.empty());
       assert(!sibNode->stores.empty());
       // TODO(andydavis) Choose the store which postdominates all other stores.
       auto *sibStoreOpInst = sibNode->stores.back();
@@ -2086,18 +1805,23 @@ public:
       SmallVector<Operation *, 2> dstStoreOpInsts;
       dstNode->getStoreOpsForMemref(memref, &dstStoreOpInsts);
 
+      // Stop searching once the budget of the pass is exhausted.
+      if (!pass->consumeBudget())
+        return;
+
       unsigned bestDstLoopDepth;
       mlir::ComputationSliceState sliceState;
 
       // Check if fusion would be profitable.
-      if (!isFusionProfitable(sibLoadOpInst, sibStoreOpInst, dstLoadOpInsts,
+      if (!isFusionProfitable(sibLoadOpInsts, sibStoreOpInst, dstLoadOpInsts,
                               dstStoreOpInsts, &sliceState, &bestDstLoopDepth,
-                              maximalFusion))
+                              maximalFusion, dependences, footprints,
+                              *memoryModel))
         continue;
 
       // Fuse computation slice of 'sibLoopNest' into 'dstLoopNest'.
       auto sliceLoopNest = mlir::insertBackwardComputationSlice(
-          sibLoadOpInst, dstLoadOpInsts[0], bestDstLoopDepth, &sliceState);
+          sibLoadOpInsts[0], dstLoadOpInsts[0], bestDstLoopDepth, &sliceState);
       if (sliceLoopNest != nullptr) {
         auto dstForInst = dstNode->op->cast<AffineForOp>();
         // Update operation position of fused loop nest (if needed).
@@ -2120,10 +1844,17 @@ public:
     // Returns true if 'sibNode' can be fused with 'dstNode' for input reuse
     // on 'memref'.
     auto canFuseWithSibNode = [&](Node *sibNode, Value *memref) {
-      // Skip if 'outEdge' is not a read-after-write dependence.
-      // TODO(andydavis) Remove restrict to single load op restriction.
-      if (sibNode->getLoadOpCount(memref) != 1)
+      // Skip if 'sibNode' has no load op to 'memref', or if its load ops to
+      // 'memref' do not share their surrounding loops, from which the slice
+      // of 'sibNode' is computed.
+      SmallVector<Operation *, 2> sibLoadOpInsts;
+      sibNode->getLoadOpsForMemref(memref, &sibLoadOpInsts);
+      if (sibLoadOpInsts.empty())
         return false;
+      unsigned numCommonLoops = getInnermostCommonLoopDepth(sibLoadOpInsts);
+      for (auto *loadOpInst : sibLoadOpInsts)
+        if (getNestingDepth(*loadOpInst) != numCommonLoops)
+          return false;
       // Skip if there exists a path of dependent edges between
       // 'sibNode' and 'dstNode'.
       if (mdg->hasDependencePath(sibNode->id, dstNode->id) ||
@@ -2231,6 +1962,8 @@ public:
                                      Node *dstNode) {
     // Update 'sibNode' and 'dstNode' input/output edges to reflect fusion.
     mdg->updateEdges(sibNode->id, dstNode->id);
+    dependences->invalidate(dstNode->op);
+    footprints->invalidate(dstNode->op);
 
     // Collect slice loop stats.
     LoopNestStateCollector sliceCollector;
@@ -2245,15 +1978,51 @@ public:
     LoopNestStateCollector dstLoopCollector;
     dstLoopCollector.collect(dstForInst.getOperation());
     // Clear and add back loads and stores
-    mdg->clearNodeLoadAndStores(dstNode->id);
-    mdg->addToNode(dstNode->id, dstLoopCollector.loadOpInsts,
-                   dstLoopCollector.storeOpInsts);
+    mdg->updateNodeAccesses(dstNode->id, dstLoopCollector.loadOpInsts,
+                            dstLoopCollector.storeOpInsts);
     // Remove old sibling loop nest if it no longer has outgoing dependence
     // edges, and it does not write to a memref which escapes the
     // function.
     if (mdg->getOutEdgeCount(sibNode->id) == 0) {
+      Operation *sibOp = sibNode->op;
       mdg->removeNode(sibNode->id);
-      sibNode->op->cast<AffineForOp>().erase();
+      dependences->invalidate(sibOp);
+      footprints->invalidate(sibOp);
+      sibOp->erase();
+    }
+  }
+
+  // Erases the allocs of privatized memrefs that are left with only stores
+  // (and deallocs) on them, since their contents can no longer be read. The
+  // loop nests left empty by the removal of these stores are erased as well.
+  void eraseDeadPrivatizedMemRefs() {
+    for (auto *memref : privatizedMemRefs) {
+      auto *defOp = memref->getDefiningOp();
+      if (!defOp || !defOp->isa<AllocOp>())
+        continue;
+      if (llvm::any_of(memref->getUses(), [&](OpOperand &use) {
+            auto *ownerOp = use.getOwner();
+            if (auto storeOp = ownerOp->dyn_cast<StoreOp>())
+              return storeOp.getValueToStore() == memref;
+            return !ownerOp->isa<DeallocOp>();
+          }))
+        continue;
+
+      for (auto &use : llvm::make_early_inc_range(memref->getUses())) {
+        auto *parentOp = use.getOwner()->getParentOp();
+        use.getOwner()->erase();
+        while (parentOp && parentOp->isa<AffineForOp>()) {
+          // Only the terminator remains in an empty loop body.
+          auto *body = parentOp->cast<AffineForOp>().getBody();
+          if (std::next(body->begin()) != body->end())
+            break;
+          auto *grandParentOp = parentOp->getParentOp();
+          parentOp->erase();
+          parentOp = grandParentOp;
+        }
+      }
+      mdg->memrefEdgeCount.erase(memref);
+      defOp->erase();
     }
   }
 
@@ -2292,7 +2061,10 @@ void LoopFusion::runOnFunction() {
 
   MemRefDependenceGraph g;
   if (g.init(getFunction()))
-    GreedyFusion(&g, localBufSizeThreshold, fastMemorySpace, maximalFusion)
+    GreedyFusion(&g, localBufSizeThreshold, fastMemorySpace, maximalFusion,
+                 &getAnalysis<DependenceAnalysis>(),
+                 &getAnalysis<MemoryFootprintAnalysis>(), memoryModel.get(),
+                 this)
         .run();
 }
 
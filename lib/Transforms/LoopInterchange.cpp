@@ -0,0 +1,215 @@
+//===- LoopInterchange.cpp - Permute the loops of perfect nests -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass permuting the loops of perfect affine.for nests
+// to improve the locality of their memory accesses and their parallelism.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/AffineAnalysis.h"
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/LoopUtils.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Debug.h"
+#include <algorithm>
+#include <tuple>
+
+#define DEBUG_TYPE "affine-loop-interchange"
+
+using namespace mlir;
+
+namespace {
+
+/// Permutes the loops of each maximal perfect affine.for nest. Among the
+/// permutations preserving the dependences between the loads and stores of the
+/// nest, the pass picks the one whose innermost loop gets the best spatial
+/// locality, i.e., along which the most accesses are stride-1 or invariant.
+/// Ties are broken in favor of an outermost loop carrying no dependence, then
+/// of the permutation closest to the original order.
+struct LoopInterchange : public FunctionPass<LoopInterchange> {
+  void runOnFunction() override;
+
+  /// Permutes the perfect nest 'loops' if that is legal and profitable.
+  void permuteBand(MutableArrayRef<AffineForOp> loops);
+
+  DependenceAnalysis *dependences = nullptr;
+
+  /// Statistics of this pass.
+  Statistic numPermuted = {this, "num-permuted",
+                           "Number of loop nests permuted"};
+};
+
+} // end anonymous namespace
+
+/// All n! permutations of a nest deeper than this are not enumerated.
+static constexpr unsigned kMaxPermutedLoops = 6;
+
+/// The benefit of a stride-1 access along the innermost loop, relative to that
+/// of an access invariant along it.
+static constexpr int kContiguousAccessBenefit = 2;
+
+/// Returns the locality of the accesses nested in 'forOp' were it the
+/// innermost loop: stride-1 and invariant accesses are rewarded, while those
+/// striding along another memref dimension are penalized.
+static int getInnermostLocality(AffineForOp forOp) {
+  auto contiguity = getAccessContiguity(forOp);
+  int locality = contiguity.numInvariant;
+  locality -= contiguity.numNonContiguous;
+  for (unsigned d = 0, e = contiguity.numVaryingAlongDim.size(); d < e; ++d) {
+    if (d == 0)
+      locality += kContiguousAccessBenefit * contiguity.numVaryingAlongDim[d];
+    else
+      locality -= contiguity.numVaryingAlongDim[d];
+  }
+  return locality;
+}
+
+/// Returns the number of pairs of loops whose relative order 'loopPermMap'
+/// inverts.
+static unsigned getNumInversions(ArrayRef<unsigned> loopPermMap) {
+  unsigned numInversions = 0;
+  for (unsigned i = 0, e = loopPermMap.size(); i < e; ++i)
+    for (unsigned j = i + 1; j < e; ++j)
+      if (loopPermMap[i] > loopPermMap[j])
+        ++numInversions;
+  return numInversions;
+}
+
+/// Returns true if 'forOp' is perfectly nested in an affine.for, i.e., if it
+/// is the only operation but the terminator in the body of an affine.for.
+static bool isPerfectlyNested(AffineForOp forOp) {
+  auto *forInst = forOp.getOperation();
+  auto *parentInst = forInst->getParentOp();
+  if (!parentInst || !parentInst->isa<AffineForOp>())
+    return false;
+  auto *parentBody = parentInst->cast<AffineForOp>().getBody();
+  return &parentBody->front() == forInst &&
+         std::next(Block::iterator(forInst)) == std::prev(parentBody->end());
+}
+
+void LoopInterchange::permuteBand(MutableArrayRef<AffineForOp> loops) {
+  unsigned numLoops = loops.size();
+  if (numLoops < 2 || numLoops > kMaxPermutedLoops)
+    return;
+
+  // Interchanging the loops by moving them around requires their bounds not to
+  // depend on each other.
+  auto rootForOp = loops.front();
+  for (auto forOp : loops) {
+    for (auto *operand : forOp.getLowerBoundOperands())
+      if (!isDefinedOutsideOfLoop(operand, rootForOp))
+        return;
+    for (auto *operand : forOp.getUpperBoundOperands())
+      if (!isDefinedOutsideOfLoop(operand, rootForOp))
+        return;
+  }
+
+  SmallVector<Operation *, 8> memOps;
+  rootForOp.getOperation()->walk([&](Operation *op) {
+    if (op->isa<LoadOp>() || op->isa<StoreOp>())
+      memOps.push_back(op);
+  });
+  std::vector<SmallVector<DependenceComponent, 2>> depCompsVec;
+  getLoopNestDependenceComponents(loops, memOps, &depCompsVec,
+                                  /*isParallelLoop=*/nullptr, dependences);
+
+  // A loop carries no dependence when moved outermost if all the dependence
+  // components along it are zero.
+  SmallVector<int, 4> locality;
+  SmallVector<bool, 4> isParallelWhenOutermost;
+  for (unsigned i = 0; i < numLoops; ++i) {
+    locality.push_back(getInnermostLocality(loops[i]));
+    isParallelWhenOutermost.push_back(
+        llvm::all_of(depCompsVec, [&](ArrayRef<DependenceComponent> comps) {
+          return comps[i].lb.hasValue() && comps[i].ub.hasValue() &&
+                 comps[i].lb.getValue() == 0 && comps[i].ub.getValue() == 0;
+        }));
+  }
+
+  // Enumerate the permutations through their inverse, i.e., the loops in their
+  // new order, and keep the best valid one, starting with the original order.
+  SmallVector<unsigned, 4> loopPermMapInv(numLoops), loopPermMap(numLoops);
+  for (unsigned i = 0; i < numLoops; ++i)
+    loopPermMapInv[i] = i;
+  SmallVector<unsigned, 4> bestPermMap(loopPermMapInv);
+  auto getCost = [&](ArrayRef<unsigned> permMapInv,
+                     ArrayRef<unsigned> permMap) {
+    return std::make_tuple(locality[permMapInv.back()],
+                           isParallelWhenOutermost[permMapInv.front()],
+                           -static_cast<int>(getNumInversions(permMap)));
+  };
+  auto bestCost = getCost(loopPermMapInv, bestPermMap);
+  while (std::next_permutation(loopPermMapInv.begin(), loopPermMapInv.end())) {
+    for (unsigned pos = 0; pos < numLoops; ++pos)
+      loopPermMap[loopPermMapInv[pos]] = pos;
+    auto cost = getCost(loopPermMapInv, loopPermMap);
+    if (cost <= bestCost ||
+        !isValidLoopInterchangePermutation(depCompsVec, loopPermMap))
+      continue;
+    bestCost = cost;
+    bestPermMap = loopPermMap;
+  }
+  if (getNumInversions(bestPermMap) == 0)
+    return;
+
+  LLVM_DEBUG(llvm::dbgs() << "permuting loop nest of depth " << numLoops
+                          << "\n");
+  dependences->invalidate(rootForOp.getOperation());
+  permuteLoops(loops, bestPermMap);
+  ++numPermuted;
+}
+
+void LoopInterchange::runOnFunction() {
+  dependences = &getAnalysis<DependenceAnalysis>();
+
+  // Collect the maximal perfect nests before permuting any of them.
+  std::vector<SmallVector<AffineForOp, 4>> bands;
+  getFunction().walk([&](AffineForOp forOp) {
+    if (isPerfectlyNested(forOp))
+      return;
+    SmallVector<AffineForOp, 4> band;
+    band.push_back(forOp);
+    auto *body = forOp.getBody();
+    while (body->begin() == std::prev(body->end(), 2)) {
+      auto innerForOp = body->front().dyn_cast<AffineForOp>();
+      if (!innerForOp)
+        break;
+      band.push_back(innerForOp);
+      body = innerForOp.getBody();
+    }
+    bands.push_back(band);
+  });
+
+  for (auto &band : bands)
+    permuteBand(band);
+}
+
+/// Creates a pass permuting the loops of perfect affine.for nests for locality
+/// and parallelism.
+FunctionPassBase *mlir::createLoopInterchangePass() {
+  return new LoopInterchange();
+}
+
+static PassRegistration<LoopInterchange>
+    pass("affine-loop-interchange",
+         "Permute the loops of perfect affine.for nests for locality and "
+         "parallelism");
@@ -0,0 +1,163 @@
+//===- LoopInvariantCodeMotion.cpp - Hoist invariant ops out of loops -----===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass hoisting the operations of affine.for bodies that
+// are invariant along the loop out of the loop.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/MemoryEffects.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+
+#define DEBUG_TYPE "loop-invariant-code-motion"
+
+using namespace mlir;
+
+namespace {
+
+/// Hoists the operations of affine.for bodies whose operands are defined
+/// outside of the loop and that compute the same value in every iteration: the
+/// side-effect free operations, and the loads of memref elements that no
+/// operation in the loop may write to. Loops are processed innermost first, so
+/// that an operation hoisted out of a loop may then be hoisted out of the loops
+/// surrounding it. Operations holding regions, and those nested in an
+/// affine.if, are left in place.
+struct LoopInvariantCodeMotion
+    : public FunctionPass<LoopInvariantCodeMotion> {
+  void runOnFunction() override;
+
+  /// Hoists the invariant operations of the body of 'forOp' right before it.
+  void hoistInvariantOps(AffineForOp forOp);
+
+  /// Statistics of this pass.
+  Statistic numHoisted = {this, "num-hoisted",
+                          "Number of operations hoisted out of a loop"};
+  Statistic numLoadsHoisted = {this, "num-loads-hoisted",
+                               "Number of loads hoisted out of a loop"};
+};
+
+} // end anonymous namespace
+
+/// Returns true if the loads in 'forOp' may be hoisted out of it, i.e., if the
+/// loop runs at least once, so that the hoisted loads don't access memory the
+/// loop wouldn't, and if the memory effects of all the operations in it are
+/// known. Collects the stores of the loop in 'storeOps', and the memrefs that
+/// its other operations may write to in 'writtenMemRefs'.
+static bool mayHoistLoads(AffineForOp forOp,
+                          SmallVectorImpl<Operation *> &storeOps,
+                          SmallVectorImpl<Value *> &writtenMemRefs) {
+  auto tripCount = getConstantTripCount(forOp);
+  if (!tripCount || *tripCount == 0)
+    return false;
+  bool hasUnknownSideEffects = false;
+  SmallVector<MemoryEffect, 4> effects;
+  forOp.getOperation()->walk([&](Operation *op) {
+    if (op->getNumRegions() != 0 || op->isa<AffineTerminatorOp>())
+      return;
+    // Stores are checked element-wise against the loads.
+    if (op->isa<StoreOp>()) {
+      storeOps.push_back(op);
+      return;
+    }
+    effects.clear();
+    if (!getMemoryEffects(op, effects)) {
+      hasUnknownSideEffects = true;
+      return;
+    }
+    for (auto &effect : effects)
+      if (effect.mayWrite())
+        writtenMemRefs.push_back(effect.memref);
+  });
+  return !hasUnknownSideEffects;
+}
+
+/// Returns true if the value read by 'loadOp', whose indices are invariant
+/// along 'forOp', is invariant as well, i.e., if no store in 'forOp' may write
+/// to the element it reads, and no other operation in 'forOp' may write to the
+/// memref it reads.
+static bool isInvariantLoad(LoadOp loadOp, AffineForOp forOp,
+                            ArrayRef<Operation *> storeOps,
+                            ArrayRef<Value *> writtenMemRefs) {
+  Value *memref = loadOp.getMemRef();
+  bool isLocal = isLocalMemRef(memref);
+  // Writes to other memrefs may only be ignored if none of them may alias the
+  // one loaded from.
+  if (llvm::any_of(writtenMemRefs, [&](Value *writtenMemRef) {
+        return writtenMemRef == memref || !isLocal;
+      }))
+    return false;
+  unsigned loopDepth = getNestingDepth(*forOp.getOperation());
+  return llvm::none_of(storeOps, [&](Operation *storeOpInst) {
+    if (storeOpInst->cast<StoreOp>().getMemRef() != memref)
+      return !isLocal;
+    return hasMemRefDependence(storeOpInst, loadOp.getOperation(), loopDepth);
+  });
+}
+
+void LoopInvariantCodeMotion::hoistInvariantOps(AffineForOp forOp) {
+  auto *forInst = forOp.getOperation();
+  SmallVector<Operation *, 8> storeOps;
+  SmallVector<Value *, 4> writtenMemRefs;
+  bool loadsMayBeHoisted = mayHoistLoads(forOp, storeOps, writtenMemRefs);
+
+  auto *body = forOp.getBody();
+  for (auto it = body->begin(), e = std::prev(body->end()); it != e;) {
+    Operation &op = *it++;
+    if (op.getNumRegions() != 0 ||
+        !llvm::all_of(op.getOperands(), [&](Value *operand) {
+          return isDefinedOutsideOfLoop(operand, forOp);
+        }))
+      continue;
+
+    if (op.hasNoSideEffect()) {
+      op.moveBefore(forInst);
+      ++numHoisted;
+      continue;
+    }
+    auto loadOp = op.dyn_cast<LoadOp>();
+    if (loadOp && loadsMayBeHoisted &&
+        isInvariantLoad(loadOp, forOp, storeOps, writtenMemRefs)) {
+      op.moveBefore(forInst);
+      ++numLoadsHoisted;
+    }
+  }
+}
+
+void LoopInvariantCodeMotion::runOnFunction() {
+  // Collect the loops before hoisting anything, outer ones first.
+  SmallVector<AffineForOp, 8> forOps;
+  getFunction().walk([&](AffineForOp forOp) { forOps.push_back(forOp); });
+
+  for (auto forOp : llvm::reverse(forOps))
+    hoistInvariantOps(forOp);
+}
+
+/// Creates a pass hoisting loop invariant operations out of affine.for loops.
+FunctionPassBase *mlir::createLoopInvariantCodeMotionPass() {
+  return new LoopInvariantCodeMotion();
+}
+
+static PassRegistration<LoopInvariantCodeMotion>
+    pass("loop-invariant-code-motion",
+         "Hoist loop invariant operations out of affine.for loops");
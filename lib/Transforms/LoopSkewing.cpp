@@ -0,0 +1,368 @@
+//===- LoopSkewing.cpp - Skew loop nests for wavefront parallelism --------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass skewing perfect affine.for nests whose loops all
+// carry dependences, e.g. stencils iterated over time steps, so that their
+// dependences become non-negative along every loop. The skewed nest is then
+// tiled, and its tiles are enumerated by wavefronts: the outermost loop walks
+// over the sums of the tile indices, and the tiles of a wavefront, which don't
+// depend on each other, are enumerated by parallel loops.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/AffineAnalysis.h"
+#include "mlir/Analysis/AffineStructures.h"
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Support/MathExtras.h"
+#include "mlir/Transforms/LoopUtils.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+
+#define DEBUG_TYPE "affine-loop-skew"
+
+using namespace mlir;
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clSkewTileSize(
+    "skew-tile-size",
+    llvm::cl::desc("Tile size of the skewed loops, 0 to enumerate their "
+                   "iterations by wavefronts without tiling (default 32)"),
+    llvm::cl::init(32), llvm::cl::cat(clOptionsCategory));
+
+namespace {
+
+/// Skews, tiles and enumerates by wavefronts the maximal perfect affine.for
+/// nests none of whose loops is parallel.
+struct LoopSkewing : public FunctionPass<LoopSkewing> {
+  explicit LoopSkewing(Optional<unsigned> tileSize = None)
+      : tileSize(tileSize ? *tileSize : clSkewTileSize) {}
+
+  void runOnFunction() override;
+
+  /// Transforms the perfect nest 'band' if it has no parallel loop and if the
+  /// dependences between its accesses can be made non-negative by skewing.
+  void skewBand(MutableArrayRef<AffineForOp> band);
+
+  unsigned tileSize;
+
+  DependenceAnalysis *dependences = nullptr;
+
+  /// Statistics of this pass.
+  Statistic numSkewed = {this, "num-skewed", "Number of loop nests skewed"};
+};
+
+} // end anonymous namespace
+
+/// Returns true if 'forOp' is perfectly nested in an affine.for, i.e., if it
+/// is the only operation but the terminator in the body of an affine.for.
+static bool isPerfectlyNested(AffineForOp forOp) {
+  auto *forInst = forOp.getOperation();
+  auto *parentInst = forInst->getParentOp();
+  if (!parentInst || !parentInst->isa<AffineForOp>())
+    return false;
+  auto *parentBody = parentInst->cast<AffineForOp>().getBody();
+  return &parentBody->front() == forInst &&
+         std::next(Block::iterator(forInst)) == std::prev(parentBody->end());
+}
+
+/// Computes in 'skewFactors' the factors by which to skew each loop of a
+/// perfect nest with respect to the outermost one, i.e. to replace its
+/// induction variable x_k with y_k = x_k + skewFactors[k] * x_0, so that all
+/// the components of the dependences 'depCompsVec' become non-negative.
+/// Returns false if no such factors exist, e.g. if a component is unbounded
+/// from below or negative in a dependence not carried by the outermost loop.
+static bool getSkewFactors(
+    ArrayRef<SmallVector<DependenceComponent, 2>> depCompsVec,
+    unsigned numLoops, SmallVectorImpl<int64_t> *skewFactors) {
+  skewFactors->assign(numLoops, 0);
+  for (const auto &depComps : depCompsVec) {
+    if (!depComps[0].lb.hasValue() || depComps[0].lb.getValue() < 0)
+      return false;
+    int64_t outerLb = depComps[0].lb.getValue();
+    for (unsigned k = 1; k < numLoops; ++k) {
+      if (!depComps[k].lb.hasValue())
+        return false;
+      int64_t lb = depComps[k].lb.getValue();
+      if (lb >= 0)
+        continue;
+      if (outerLb == 0)
+        return false;
+      (*skewFactors)[k] = std::max((*skewFactors)[k], ceilDiv(-lb, outerLb));
+    }
+  }
+  return true;
+}
+
+/// Computes in 'lbMap' and 'ubMap' the lower and upper bounds of the last
+/// dimensional identifier of 'cst', whose other identifiers are the first
+/// dimensions and the symbols of the maps. The bounds are the max and the min
+/// of the constraints on the identifier, divided by its coefficient in them.
+/// Returns false if it is unbounded.
+static bool getLastDimBounds(const FlatAffineConstraints &cst,
+                             MLIRContext *context, AffineMap *lbMap,
+                             AffineMap *ubMap) {
+  unsigned pos = cst.getNumDimIds() - 1;
+  unsigned numSymbols = cst.getNumSymbolIds();
+  SmallVector<AffineExpr, 4> lbExprs, ubExprs;
+  // Adds the bounds implied by 'row' >= 0 on the identifier.
+  auto addBounds = [&](ArrayRef<int64_t> row, bool isEq) {
+    int64_t coeff = row[pos];
+    if (coeff == 0)
+      return;
+    // The rest of the row without the identifier, i.e. [dims, symbols, const].
+    SmallVector<int64_t, 8> rest(row.begin(), row.begin() + pos);
+    rest.append(row.begin() + pos + 1, row.end());
+    auto expr = toAffineExpr(rest, pos, numSymbols, {}, context);
+    // coeff * id + expr >= 0 is a lower bound of the identifier if coeff is
+    // positive, and an upper one otherwise.
+    if (coeff > 0 || isEq)
+      lbExprs.push_back(coeff > 0 ? (-expr).ceilDiv(coeff)
+                                  : expr.ceilDiv(-coeff));
+    if (coeff < 0 || isEq)
+      ubExprs.push_back(coeff < 0 ? expr.floorDiv(-coeff) + 1
+                                  : (-expr).floorDiv(coeff) + 1);
+  };
+  for (unsigned i = 0, e = cst.getNumInequalities(); i < e; ++i)
+    addBounds(cst.getInequality(i), /*isEq=*/false);
+  for (unsigned i = 0, e = cst.getNumEqualities(); i < e; ++i)
+    addBounds(cst.getEquality(i), /*isEq=*/true);
+  if (lbExprs.empty() || ubExprs.empty())
+    return false;
+  *lbMap = AffineMap::get(pos, numSymbols, lbExprs, {});
+  *ubMap = AffineMap::get(pos, numSymbols, ubExprs, {});
+  return true;
+}
+
+/// Replaces the perfect nest 'band' by a nest of 'numNewLoops' loops
+/// enumerating in lexicographic order the points of 'domain', a system whose
+/// dimensional identifiers are the induction variables of the new loops
+/// followed by those of 'band', and whose symbols are those of the bounds of
+/// 'band'. In the body of the new nest, the induction variables of 'band' are
+/// computed from those of the new loops and the symbols by 'ivExprs'. Returns
+/// failure, leaving the IR untouched, if the new bounds can't be computed.
+static LogicalResult
+generateLoopNest(MutableArrayRef<AffineForOp> band,
+                 FlatAffineConstraints domain, unsigned numNewLoops,
+                 ArrayRef<AffineExpr> ivExprs,
+                 SmallVectorImpl<AffineForOp> *newLoops) {
+  auto rootForOp = band.front();
+  auto *context = rootForOp.getOperation()->getContext();
+  unsigned numSymbols = domain.getNumSymbolIds();
+  SmallVector<Value *, 4> symbols;
+  domain.getIdValues(domain.getNumDimIds(), domain.getNumDimAndSymbolIds(),
+                     &symbols);
+
+  // The bounds of each new loop are those of the domain projected on the loops
+  // surrounding it, found innermost first.
+  domain.projectOut(numNewLoops, band.size());
+  SmallVector<AffineMap, 8> lbMaps(numNewLoops), ubMaps(numNewLoops);
+  for (int l = numNewLoops - 1; l >= 0; --l) {
+    domain.removeTrivialRedundancy();
+    if (domain.getNumLocalIds() != 0 ||
+        !getLastDimBounds(domain, context, &lbMaps[l], &ubMaps[l]))
+      return failure();
+    domain.projectOut(l);
+  }
+
+  FuncBuilder b(rootForOp.getOperation());
+  auto loc = rootForOp.getLoc();
+  SmallVector<Value *, 8> ivs;
+  for (unsigned l = 0; l < numNewLoops; ++l) {
+    SmallVector<Value *, 8> operands(ivs.begin(), ivs.end());
+    operands.append(symbols.begin(), symbols.end());
+    AffineMap lbMap = lbMaps[l], ubMap = ubMaps[l];
+    SmallVector<Value *, 8> lbOperands(operands), ubOperands(operands);
+    canonicalizeMapAndOperands(&lbMap, &lbOperands);
+    canonicalizeMapAndOperands(&ubMap, &ubOperands);
+    auto forOp =
+        b.create<AffineForOp>(loc, lbOperands, lbMap, ubOperands, ubMap);
+    newLoops->push_back(forOp);
+    ivs.push_back(forOp.getInductionVar());
+    b.setInsertionPoint(forOp.getBody(), forOp.getBody()->begin());
+  }
+
+  // Compute the original induction variables at the start of the innermost
+  // loop, and move the original body after them.
+  ivs.append(symbols.begin(), symbols.end());
+  for (unsigned k = 0, e = band.size(); k < e; ++k) {
+    auto ivMap = AffineMap::get(numNewLoops, numSymbols, ivExprs[k], {});
+    auto applyOp = makeComposedAffineApply(&b, loc, ivMap, ivs);
+    band[k].getInductionVar()->replaceAllUsesWith(applyOp.getResult());
+  }
+  auto *srcBody = band.back().getBody();
+  auto *dstBody = newLoops->back().getBody();
+  dstBody->getOperations().splice(std::prev(dstBody->end()),
+                                  srcBody->getOperations(), srcBody->begin(),
+                                  std::prev(srcBody->end()));
+  rootForOp.erase();
+  return success();
+}
+
+void LoopSkewing::skewBand(MutableArrayRef<AffineForOp> band) {
+  unsigned numLoops = band.size();
+  if (numLoops < 2 || llvm::any_of(band, [](AffineForOp forOp) {
+        return forOp.getStep() != 1;
+      }))
+    return;
+
+  // Only transform the nests none of whose loops could be run in parallel as
+  // is, and whose dependences skewing can make non-negative.
+  auto rootForOp = band.front();
+  SmallVector<Operation *, 8> memOps;
+  rootForOp.getOperation()->walk([&](Operation *op) {
+    if (op->isa<LoadOp>() || op->isa<StoreOp>())
+      memOps.push_back(op);
+  });
+  std::vector<SmallVector<DependenceComponent, 2>> depCompsVec;
+  SmallVector<bool, 4> isParallelLoop;
+  getLoopNestDependenceComponents(band, memOps, &depCompsVec, &isParallelLoop,
+                                  dependences);
+  if (llvm::is_contained(isParallelLoop, true))
+    return;
+  SmallVector<int64_t, 4> skewFactors;
+  if (!getSkewFactors(depCompsVec, numLoops, &skewFactors))
+    return;
+
+  // The bounds of the band may only depend on its own induction variables and
+  // on symbols.
+  FlatAffineConstraints domain;
+  if (failed(getIndexSet(band, &domain)) || domain.getNumLocalIds() != 0 ||
+      domain.getNumDimIds() != numLoops)
+    return;
+
+  // The skewed induction variables y_k = x_k + skewFactors[k] * x_0 are
+  // enumerated by wavefronts w = y_0 + ... + y_{n-1} if they are not tiled,
+  // i.e. by the new loops (w, y_1, ..., y_{n-1}), with y_0 = w - y_1 - ... -
+  // y_{n-1}. If they are, their tiles t_k = y_k floordiv tileSize are, i.e.
+  // the new loops are (w, t_1, ..., t_{n-1}, y_0, ..., y_{n-1}), with t_0 = w -
+  // t_1 - ... - t_{n-1}. The outermost loop carries all the dependences
+  // between the tiles, so that the loops enumerating the tiles of a wavefront
+  // are parallel.
+  unsigned numNewLoops = tileSize == 0 ? numLoops : 2 * numLoops;
+  unsigned yPos = tileSize == 0 ? 0 : numLoops;
+  for (unsigned l = 0; l < numNewLoops; ++l)
+    domain.addDimId(l);
+  unsigned xPos = numNewLoops;
+  unsigned numCols = domain.getNumCols();
+
+  // Returns the row of y_k as a function of the new loops and of the x's.
+  auto getYRow = [&](unsigned k) {
+    SmallVector<int64_t, 8> row(numCols, 0);
+    if (tileSize != 0 || k != 0) {
+      row[yPos + k] = 1;
+      return row;
+    }
+    row[0] = 1;
+    for (unsigned m = 1; m < numLoops; ++m)
+      row[yPos + m] = -1;
+    return row;
+  };
+  for (unsigned k = 0; k < numLoops; ++k) {
+    // y_k - x_k - skewFactors[k] * x_0 = 0.
+    auto eq = getYRow(k);
+    eq[xPos + k] -= 1;
+    eq[xPos] -= skewFactors[k];
+    domain.addEquality(eq);
+  }
+  if (tileSize != 0) {
+    int64_t size = tileSize;
+    for (unsigned k = 0; k < numLoops; ++k) {
+      // y_k - tileSize * t_k >= 0 and tileSize * t_k + tileSize - 1 - y_k >=
+      // 0, where t_0 = w - t_1 - ... - t_{n-1}.
+      SmallVector<int64_t, 8> lower(numCols, 0);
+      if (k == 0) {
+        lower[0] = -size;
+        for (unsigned m = 1; m < numLoops; ++m)
+          lower[m] = size;
+      } else {
+        lower[k] = -size;
+      }
+      lower[yPos + k] = 1;
+      SmallVector<int64_t, 8> upper(numCols, 0);
+      for (unsigned c = 0; c < numCols; ++c)
+        upper[c] = -lower[c];
+      upper.back() += size - 1;
+      domain.addInequality(lower);
+      domain.addInequality(upper);
+    }
+  }
+
+  // x_0 = y_0 and x_k = y_k - skewFactors[k] * y_0 in terms of the new loops
+  // and the symbols.
+  SmallVector<AffineExpr, 4> ivExprs;
+  auto getYExpr = [&](unsigned k) {
+    auto row = getYRow(k);
+    row.erase(row.begin() + xPos, row.begin() + xPos + numLoops);
+    return toAffineExpr(row, numNewLoops, domain.getNumSymbolIds(), {},
+                        rootForOp.getOperation()->getContext());
+  };
+  auto y0 = getYExpr(0);
+  ivExprs.push_back(y0);
+  for (unsigned k = 1; k < numLoops; ++k)
+    ivExprs.push_back(getYExpr(k) - y0 * skewFactors[k]);
+
+  dependences->invalidate(rootForOp.getOperation());
+  SmallVector<AffineForOp, 8> newLoops;
+  if (failed(generateLoopNest(band, domain, numNewLoops, ivExprs, &newLoops)))
+    return;
+  LLVM_DEBUG(llvm::dbgs() << "skewed loop nest of depth " << numLoops << "\n");
+  ++numSkewed;
+}
+
+void LoopSkewing::runOnFunction() {
+  dependences = &getAnalysis<DependenceAnalysis>();
+
+  // Collect the maximal perfect nests before transforming any of them.
+  std::vector<SmallVector<AffineForOp, 4>> bands;
+  getFunction().walk([&](AffineForOp forOp) {
+    if (isPerfectlyNested(forOp))
+      return;
+    SmallVector<AffineForOp, 4> band;
+    band.push_back(forOp);
+    auto *body = forOp.getBody();
+    while (body->begin() == std::prev(body->end(), 2)) {
+      auto innerForOp = body->front().dyn_cast<AffineForOp>();
+      if (!innerForOp)
+        break;
+      band.push_back(innerForOp);
+      body = innerForOp.getBody();
+    }
+    bands.push_back(band);
+  });
+
+  for (auto &band : bands)
+    skewBand(band);
+}
+
+/// Creates a pass skewing, tiling, and enumerating by wavefronts the perfect
+/// affine.for nests without parallel loops.
+FunctionPassBase *mlir::createLoopSkewingPass(int tileSize) {
+  return new LoopSkewing(tileSize == -1 ? None
+                                        : Optional<unsigned>(tileSize));
+}
+
+static PassRegistration<LoopSkewing>
+    pass("affine-loop-skew",
+         "Skew and tile perfect affine.for nests without parallel loops to "
+         "enumerate their tiles by parallel wavefronts");
@@ -23,15 +23,21 @@
 #include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/LoopProfile.h"
 #include "mlir/Analysis/Utils.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
 #include "mlir/Transforms/LoopUtils.h"
 #include "mlir/Transforms/Passes.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "mlir/Transforms/Utils.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include <iomanip>
+#include <limits>
 #include <sstream>
 
 using namespace mlir;
@@ -58,24 +64,52 @@ static llvm::cl::list<unsigned> clTileSizes(
         "List of tile sizes for each perfect nest (overridden by -tile-size)"),
     llvm::cl::ZeroOrMore, llvm::cl::cat(clOptionsCategory));
 
+static llvm::cl::opt<unsigned> clTileLevels(
+    "tile-levels", llvm::cl::init(1),
+    llvm::cl::desc("Number of levels of the memory hierarchy to tile for, from "
+                   "the last level cache down to the vector registers"),
+    llvm::cl::cat(clOptionsCategory));
+
+// Positions of the function arguments holding symbolic tile sizes, one for each
+// of the outermost loops of a band (overrides the constant tile sizes).
+static llvm::cl::list<unsigned> clTileSizeArgs(
+    "tile-size-args",
+    llvm::cl::desc("List of positions of the function arguments to use as "
+                   "symbolic tile sizes for the outermost loops of each band"),
+    llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated,
+    llvm::cl::cat(clOptionsCategory));
+
 namespace {
 
 /// A pass to perform loop tiling on all suitable loop nests of a Function.
 struct LoopTiling : public FunctionPass<LoopTiling> {
-  explicit LoopTiling(uint64_t cacheSizeBytes = kDefaultCacheMemCapacity,
+  explicit LoopTiling(const TargetMemoryModel &memoryModel,
+                      bool avoidMaxMinBounds = true);
+  explicit LoopTiling(uint64_t cacheSizeBytes = TargetMemoryModel::getDefault()
+                                                    .getLastLevelCache()
+                                                    .capacityBytes,
                       bool avoidMaxMinBounds = true)
-      : cacheSizeBytes(cacheSizeBytes), avoidMaxMinBounds(avoidMaxMinBounds) {}
+      : LoopTiling(TargetMemoryModel::getDefault(), avoidMaxMinBounds) {
+    levelCapacities.front() = cacheSizeBytes;
+  }
 
   void runOnFunction() override;
   void getTileSizes(ArrayRef<AffineForOp> band,
                     SmallVectorImpl<unsigned> *tileSizes);
+  void getInnerTileSizes(ArrayRef<AffineForOp> band,
+                         ArrayRef<unsigned> tileSizes,
+                         std::vector<SmallVector<unsigned, 6>> *innerTileSizes);
 
   // Default tile size if nothing is provided.
   constexpr static unsigned kDefaultTileSize = 4;
-  constexpr static uint64_t kDefaultCacheMemCapacity = 512 * 1024UL;
 
-  // Capacity of the cache to tile for.
-  uint64_t cacheSizeBytes;
+  // Capacities of the levels of the memory hierarchy to tile for, from the
+  // last level cache (the capacity of the cache to tile for) down to the
+  // vector registers.
+  SmallVector<uint64_t, 4> levelCapacities;
+  // Width of a vector register in bytes, which the innermost tile spans a
+  // multiple of if possible.
+  unsigned vectorWidthBytes;
   // If true, tile sizes are set to avoid max/min in bounds if possible.
   bool avoidMaxMinBounds;
 };
@@ -88,6 +122,21 @@ FunctionPassBase *mlir::createLoopTilingPass(uint64_t cacheSizeBytes) {
   return new LoopTiling(cacheSizeBytes);
 }
 
+FunctionPassBase *
+mlir::createLoopTilingPass(const TargetMemoryModel &memoryModel) {
+  return new LoopTiling(memoryModel);
+}
+
+LoopTiling::LoopTiling(const TargetMemoryModel &memoryModel,
+                       bool avoidMaxMinBounds)
+    : vectorWidthBytes(memoryModel.getVectorWidth()),
+      avoidMaxMinBounds(avoidMaxMinBounds) {
+  auto cacheLevels = memoryModel.getCacheLevels();
+  for (auto it = cacheLevels.rbegin(), e = cacheLevels.rend(); it != e; ++it)
+    levelCapacities.push_back(it->capacityBytes);
+  levelCapacities.push_back(memoryModel.getRegisterFileCapacity());
+}
+
 // Move the loop body of AffineForOp 'src' from 'src' into the specified
 // location in destination's body, ignoring the terminator.
 static inline void moveLoopBody(AffineForOp src, AffineForOp dest,
@@ -103,6 +152,48 @@ static inline void moveLoopBody(AffineForOp src, AffineForOp dest) {
   moveLoopBody(src, dest, dest.getBody()->begin());
 }
 
+/// Returns in 'lb' and 'ub' the bounds of 'forOp', which are expected to have a
+/// single result, and in 'tSize' the symbol for 'tileSize', all expressed on
+/// the 'numDims' dimensions and 'numSymbols' symbols of 'operands'. These are
+/// the dimensional operands of both bounds followed by their symbolic operands
+/// and 'tileSize'.
+static void getBoundExprsWithTileSize(AffineForOp forOp, Value *tileSize,
+                                      SmallVectorImpl<Value *> *operands,
+                                      AffineExpr *lb, AffineExpr *ub,
+                                      AffineExpr *tSize, unsigned *numDims,
+                                      unsigned *numSymbols) {
+  auto lbMap = forOp.getLowerBoundMap();
+  auto ubMap = forOp.getUpperBoundMap();
+  assert(lbMap.getNumResults() == 1 && ubMap.getNumResults() == 1 &&
+         "expected single result bounds");
+  auto *context = forOp.getContext();
+  unsigned lbNumDims = lbMap.getNumDims(), ubNumDims = ubMap.getNumDims();
+  unsigned lbNumSymbols = lbMap.getNumSymbols();
+  unsigned ubNumSymbols = ubMap.getNumSymbols();
+
+  // Shift the dimensions and symbols of the upper bound past the ones of the
+  // lower bound.
+  SmallVector<AffineExpr, 4> dimReplacements, symReplacements;
+  for (unsigned i = 0; i < ubNumDims; i++)
+    dimReplacements.push_back(getAffineDimExpr(lbNumDims + i, context));
+  for (unsigned i = 0; i < ubNumSymbols; i++)
+    symReplacements.push_back(getAffineSymbolExpr(lbNumSymbols + i, context));
+  *lb = lbMap.getResult(0);
+  *ub = ubMap.getResult(0).replaceDimsAndSymbols(dimReplacements,
+                                                  symReplacements);
+  *tSize = getAffineSymbolExpr(lbNumSymbols + ubNumSymbols, context);
+
+  SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
+  SmallVector<Value *, 4> ubOperands(forOp.getUpperBoundOperands());
+  operands->append(lbOperands.begin(), lbOperands.begin() + lbNumDims);
+  operands->append(ubOperands.begin(), ubOperands.begin() + ubNumDims);
+  operands->append(lbOperands.begin() + lbNumDims, lbOperands.end());
+  operands->append(ubOperands.begin() + ubNumDims, ubOperands.end());
+  operands->push_back(tileSize);
+  *numDims = lbNumDims + ubNumDims;
+  *numSymbols = lbNumSymbols + ubNumSymbols + 1;
+}
+
 /// Constructs and sets new loop bounds after tiling for the case of
 /// hyper-rectangular index sets, where the bounds of one dimension do not
 /// depend on other dimensions. Bounds of each dimension can thus be treated
@@ -172,27 +263,71 @@ constructTiledIndexSetHyperRect(MutableArrayRef<AffineForOp> origLoops,
   }
 }
 
-/// Tiles the specified band of perfectly nested loops creating tile-space loops
-/// and intra-tile loops. A band is a contiguous set of loops.
-//  TODO(bondhugula): handle non hyper-rectangular spaces.
-LogicalResult mlir::tileCodeGen(MutableArrayRef<AffineForOp> band,
-                                ArrayRef<unsigned> tileSizes) {
-  assert(!band.empty());
-  assert(band.size() == tileSizes.size() && "Incorrect number of tile sizes");
+/// Constructs and sets new loop bounds after tiling 'origLoops' with the
+/// symbolic tile sizes 'tileSizes', for the case of hyper-rectangular index
+/// sets whose loops have unit steps and single result bounds. The tile-space
+/// loops iterate over the tile indices of the full tiles only, so that the
+/// intra-tile loops have no min bounds. The partial tiles are generated by
+/// separateFullTiles.
+static void
+constructParametricTiledIndexSet(MutableArrayRef<AffineForOp> origLoops,
+                                 MutableArrayRef<AffineForOp> newLoops,
+                                 ArrayRef<Value *> tileSizes) {
+  assert(!origLoops.empty());
+  assert(origLoops.size() == tileSizes.size());
 
-  // Check if the supplied for op's are all successively nested.
-  for (unsigned i = 1, e = band.size(); i < e; i++) {
-    assert(band[i].getOperation()->getParentOp() == band[i - 1].getOperation());
-  }
+  FuncBuilder b(origLoops[0].getOperation());
+  unsigned width = origLoops.size();
 
-  auto origLoops = band;
+  for (unsigned i = 0; i < width; i++) {
+    SmallVector<Value *, 8> operands;
+    AffineExpr lb, ub, tSize;
+    unsigned numDims, numSymbols;
+    getBoundExprsWithTileSize(origLoops[i], tileSizes[i], &operands, &lb, &ub,
+                              &tSize, &numDims, &numSymbols);
+
+    // Tile-space loop t goes from 0 to (ub - lb) floordiv tileSize.
+    auto ubMap =
+        b.getAffineMap(numDims, numSymbols, (ub - lb).floorDiv(tSize), {});
+    canonicalizeMapAndOperands(&ubMap, &operands);
+    newLoops[i].setLowerBound({}, b.getConstantAffineMap(0));
+    newLoops[i].setUpperBound(operands, ubMap);
+
+    // Intra-tile loop ii goes from lb + t * tileSize to lb + (t + 1) *
+    // tileSize. The operands are the original lower bound operands with 't'
+    // appended to the dimensions and 'tileSize' to the symbols.
+    auto origLbMap = origLoops[i].getLowerBoundMap();
+    unsigned lbNumDims = origLbMap.getNumDims();
+    SmallVector<Value *, 4> lbOperands(origLoops[i].getLowerBoundOperands());
+    lbOperands.insert(lbOperands.begin() + lbNumDims,
+                      newLoops[i].getInductionVar());
+    lbOperands.push_back(tileSizes[i]);
+    auto tileStart =
+        origLbMap.getResult(0) +
+        b.getAffineDimExpr(lbNumDims) *
+            b.getAffineSymbolExpr(origLbMap.getNumSymbols());
+    auto tileSizeExpr = b.getAffineSymbolExpr(origLbMap.getNumSymbols());
+    newLoops[width + i].setLowerBound(
+        lbOperands, b.getAffineMap(lbNumDims + 1,
+                                   origLbMap.getNumSymbols() + 1, tileStart,
+                                   {}));
+    newLoops[width + i].setUpperBound(
+        lbOperands, b.getAffineMap(lbNumDims + 1,
+                                   origLbMap.getNumSymbols() + 1,
+                                   tileStart + tileSizeExpr, {}));
+  }
+}
 
-  AffineForOp rootAffineForOp = origLoops[0];
+/// Creates the tile-space and the intra-tile loops in 'newLoops' around the
+/// body of 'band', with bounds to be set by the caller.
+static void createTiledNest(MutableArrayRef<AffineForOp> band,
+                            MutableArrayRef<AffineForOp> newLoops) {
+  AffineForOp rootAffineForOp = band[0];
   auto loc = rootAffineForOp.getLoc();
   // Note that width is at least one since band isn't empty.
   unsigned width = band.size();
+  assert(newLoops.size() == 2 * width && "invalid number of tiled loops");
 
-  SmallVector<AffineForOp, 12> newLoops(2 * width);
   AffineForOp innermostPointLoop;
 
   // The outermost among the loops as we add more..
@@ -225,7 +360,31 @@ LogicalResult mlir::tileCodeGen(MutableArrayRef<AffineForOp> band,
   }
 
   // Move the loop body of the original nest to the new one.
-  moveLoopBody(origLoops[origLoops.size() - 1], innermostPointLoop);
+  moveLoopBody(band[band.size() - 1], innermostPointLoop);
+}
+
+/// Tiles the specified band of perfectly nested loops creating tile-space loops
+/// and intra-tile loops. A band is a contiguous set of loops.
+//  TODO(bondhugula): handle non hyper-rectangular spaces.
+LogicalResult mlir::tileCodeGen(MutableArrayRef<AffineForOp> band,
+                                ArrayRef<unsigned> tileSizes,
+                                SmallVectorImpl<AffineForOp> *tiledNest) {
+  assert(!band.empty());
+  assert(band.size() == tileSizes.size() && "Incorrect number of tile sizes");
+
+  // Check if the supplied for op's are all successively nested.
+  for (unsigned i = 1, e = band.size(); i < e; i++) {
+    assert(band[i].getOperation()->getParentOp() == band[i - 1].getOperation());
+  }
+
+  auto origLoops = band;
+
+  AffineForOp rootAffineForOp = origLoops[0];
+  // Note that width is at least one since band isn't empty.
+  unsigned width = band.size();
+
+  SmallVector<AffineForOp, 12> newLoops(2 * width);
+  createTiledNest(band, newLoops);
 
   SmallVector<Value *, 8> origLoopIVs;
   extractForInductionVars(band, &origLoopIVs);
@@ -248,6 +407,132 @@ LogicalResult mlir::tileCodeGen(MutableArrayRef<AffineForOp> band,
   // Erase the old loop nest.
   rootAffineForOp.erase();
 
+  if (tiledNest)
+    tiledNest->assign(newLoops.begin(), newLoops.end());
+  return success();
+}
+
+/// Generates the partial tiles of the nest 'newLoops' tiled by
+/// constructParametricTiledIndexSet from 'origLoops'. For each tiled dimension
+/// from the innermost one outwards, the body of its tile-space loop is cloned
+/// right after the loop, and the copies of its intra-tile loop in the clone
+/// are set to iterate over the remainder of the dimension that the full tiles
+/// do not cover. This yields a nest for each combination of full and partial
+/// tiles along the dimensions, none of which has min bounds.
+static void separateFullTiles(MutableArrayRef<AffineForOp> origLoops,
+                              MutableArrayRef<AffineForOp> newLoops,
+                              ArrayRef<Value *> tileSizes) {
+  unsigned width = origLoops.size();
+  // The copies of each intra-tile loop, starting with the full tile one.
+  std::vector<SmallVector<AffineForOp, 4>> intraTileCopies(width);
+  for (unsigned i = 0; i < width; i++)
+    intraTileCopies[i].push_back(newLoops[width + i]);
+
+  for (int i = width - 1; i >= 0; i--) {
+    // The remainder of dimension 'i' starts at
+    // max(lb + ((ub - lb) floordiv tileSize) * tileSize, lb), which guards
+    // against empty index sets, and goes up to the original upper bound.
+    SmallVector<Value *, 8> remLbOperands;
+    AffineExpr lb, ub, tSize;
+    unsigned numDims, numSymbols;
+    getBoundExprsWithTileSize(origLoops[i], tileSizes[i], &remLbOperands, &lb,
+                              &ub, &tSize, &numDims, &numSymbols);
+    FuncBuilder b(origLoops[i].getOperation());
+    auto remLbMap = b.getAffineMap(
+        numDims, numSymbols, {lb + (ub - lb).floorDiv(tSize) * tSize, lb}, {});
+    canonicalizeMapAndOperands(&remLbMap, &remLbOperands);
+    SmallVector<Value *, 4> remUbOperands(
+        origLoops[i].getUpperBoundOperands());
+    auto remUbMap = origLoops[i].getUpperBoundMap();
+
+    // Clone the body of the tile-space loop right after it.
+    auto *tileSpaceLoop = newLoops[i].getOperation();
+    FuncBuilder cloneBuilder(tileSpaceLoop->getBlock(),
+                             std::next(Block::iterator(tileSpaceLoop)));
+    BlockAndValueMapping mapper;
+    auto &bodyOps = newLoops[i].getBody()->getOperations();
+    for (auto it = bodyOps.begin(), e = std::prev(bodyOps.end()); it != e;
+         ++it)
+      cloneBuilder.clone(*it, mapper);
+
+    // All the copies of the intra-tile loops made so far are nested under the
+    // tile-space loop and have thus been cloned.
+    for (unsigned j = 0; j < width; j++) {
+      for (unsigned k = 0, e = intraTileCopies[j].size(); k < e; k++) {
+        auto clonedLoop = getForInductionVarOwner(
+            mapper.lookup(intraTileCopies[j][k].getInductionVar()));
+        if (j == static_cast<unsigned>(i)) {
+          clonedLoop.setLowerBound(remLbOperands, remLbMap);
+          clonedLoop.setUpperBound(remUbOperands, remUbMap);
+        }
+        intraTileCopies[j].push_back(clonedLoop);
+      }
+    }
+  }
+}
+
+LogicalResult mlir::tileCodeGen(MutableArrayRef<AffineForOp> band,
+                                ArrayRef<Value *> tileSizes,
+                                SmallVectorImpl<AffineForOp> *tiledNest) {
+  assert(!band.empty());
+  assert(band.size() == tileSizes.size() && "Incorrect number of tile sizes");
+
+  // Check if the supplied for op's are all successively nested.
+  for (unsigned i = 1, e = band.size(); i < e; i++) {
+    assert(band[i].getOperation()->getParentOp() == band[i - 1].getOperation());
+  }
+
+  AffineForOp rootAffineForOp = band[0];
+  unsigned width = band.size();
+
+  for (auto *tSize : tileSizes) {
+    if (!tSize->getType().isIndex() || !isValidSymbol(tSize)) {
+      rootAffineForOp.emitError("expected tile sizes to be index symbols");
+      return failure();
+    }
+  }
+  // The bounds of each loop are expected to be independent of the other loops
+  // of the band, which is checked on their operands since the bounds may
+  // already be semi-affine and not representable as constraints.
+  for (auto forOp : band) {
+    if (forOp.getStep() != 1 || forOp.getLowerBoundMap().getNumResults() != 1 ||
+        forOp.getUpperBoundMap().getNumResults() != 1) {
+      forOp.emitError("parametric tiling unimplemented for loops with "
+                      "non-unit steps or multiple result bounds");
+      return failure();
+    }
+    for (auto *operand : forOp.getOperation()->getOperands()) {
+      auto ownerForOp = getForInductionVarOwner(operand);
+      if (ownerForOp && llvm::any_of(band, [&](AffineForOp bandForOp) {
+            return bandForOp.getOperation() == ownerForOp.getOperation();
+          })) {
+        rootAffineForOp.emitError("tiled code generation unimplemented for "
+                                  "the non-hyperrectangular case");
+        return failure();
+      }
+    }
+  }
+
+  SmallVector<AffineForOp, 12> newLoops(2 * width);
+  createTiledNest(band, newLoops);
+
+  constructParametricTiledIndexSet(band, newLoops, tileSizes);
+  // The point loop IVs just replace the original ones.
+  for (unsigned i = 0; i < width; i++) {
+    band[i].getInductionVar()->replaceAllUsesWith(
+        newLoops[i + width].getInductionVar());
+  }
+  // The original nest, now left without a body, still provides the bounds of
+  // the partial tiles; move it out of the tiled nest before cloning parts of
+  // the latter.
+  rootAffineForOp.getOperation()->moveBefore(newLoops[0].getOperation());
+  separateFullTiles(band, newLoops, tileSizes);
+
+  // Erase the old loop nest.
+  rootAffineForOp.erase();
+
+  if (tiledNest)
+    tiledNest->assign(newLoops.begin(), newLoops.end());
   return success();
 }
 
@@ -275,26 +560,147 @@ static void getTileableBands(Function &f,
 }
 
 // Reduce each tile size to the largest divisor of the corresponding trip count
-// (if the trip count is known).
-static void adjustToDivisorsOfTripCounts(ArrayRef<AffineForOp> band,
-                                         SmallVectorImpl<unsigned> *tileSizes) {
-  assert(band.size() == tileSizes->size() && "invalid tile size count");
-  for (unsigned i = 0, e = band.size(); i < e; i++) {
+// in 'tripCounts' (if the trip count is known). The innermost tile size stays
+// a multiple of 'innermostMultiple' if the trip count allows it.
+static void adjustToDivisors(ArrayRef<Optional<uint64_t>> tripCounts,
+                             unsigned innermostMultiple,
+                             SmallVectorImpl<unsigned> *tileSizes) {
+  assert(tripCounts.size() == tileSizes->size() && "invalid tile size count");
+  for (unsigned i = 0, e = tripCounts.size(); i < e; i++) {
     unsigned &tSizeAdjusted = (*tileSizes)[i];
-    auto mayConst = getConstantTripCount(band[i]);
-    if (!mayConst.hasValue())
+    if (!tripCounts[i].hasValue())
       continue;
     // Adjust the tile size to largest factor of the trip count less than
     // tSize.
-    uint64_t constTripCount = mayConst.getValue();
+    uint64_t constTripCount = tripCounts[i].getValue();
     if (tSizeAdjusted > constTripCount / 2)
-      tSizeAdjusted = constTripCount / 2;
+      tSizeAdjusted = std::max<uint64_t>(1, constTripCount / 2);
+    unsigned multiple = i == e - 1 ? innermostMultiple : 1;
+    if (constTripCount % multiple != 0 || tSizeAdjusted < multiple)
+      multiple = 1;
+    tSizeAdjusted -= tSizeAdjusted % multiple;
     while (constTripCount % tSizeAdjusted != 0)
-      tSizeAdjusted--;
+      tSizeAdjusted -= multiple;
+  }
+}
+
+// Reduce each tile size to the largest divisor of the corresponding trip count
+// of 'band' (if the trip count is known).
+static void adjustToDivisorsOfTripCounts(ArrayRef<AffineForOp> band,
+                                         unsigned innermostMultiple,
+                                         SmallVectorImpl<unsigned> *tileSizes) {
+  SmallVector<Optional<uint64_t>, 6> tripCounts;
+  for (auto forOp : band)
+    tripCounts.push_back(getConstantTripCount(forOp));
+  adjustToDivisors(tripCounts, innermostMultiple, tileSizes);
+}
+
+// Returns the number of elements of the memrefs accessed in 'forOp' which fit
+// in a vector register of 'vectorWidthBytes' bytes, i.e. the granularity of
+// the innermost tile. Returns 1 if the loop nest already accesses vectors.
+static unsigned getNumVectorLanes(AffineForOp forOp,
+                                  unsigned vectorWidthBytes) {
+  unsigned maxEltSizeInBytes = 0;
+  bool accessesVectors = false;
+  forOp.getOperation()->walk([&](Operation *op) {
+    Value *memref;
+    if (auto loadOp = op->dyn_cast<LoadOp>())
+      memref = loadOp.getMemRef();
+    else if (auto storeOp = op->dyn_cast<StoreOp>())
+      memref = storeOp.getMemRef();
+    else
+      return;
+    auto elementType = memref->getType().cast<MemRefType>().getElementType();
+    if (!elementType.isIntOrFloat()) {
+      accessesVectors = true;
+      return;
+    }
+    maxEltSizeInBytes =
+        std::max(maxEltSizeInBytes,
+                 static_cast<unsigned>(llvm::divideCeil(
+                     elementType.getIntOrFloatBitWidth(), 8)));
+  });
+  if (accessesVectors || maxEltSizeInBytes == 0)
+    return 1;
+  return std::max(1U, vectorWidthBytes / maxEltSizeInBytes);
+}
+
+// Returns the memory footprint in bytes of the first tile of 'band' with tile
+// sizes 'tileSizes'. The loops of 'band' are expected to have constant lower
+// bounds.
+static Optional<int64_t> getTileFootprintBytes(ArrayRef<AffineForOp> band,
+                                               ArrayRef<unsigned> tileSizes) {
+  Builder b(band[0].getOperation()->getContext());
+  ComputationSliceState tile;
+  for (unsigned i = 0, e = band.size(); i < e; i++) {
+    int64_t lb = band[i].getConstantLowerBound();
+    tile.ivs.push_back(band[i].getInductionVar());
+    tile.lbs.push_back(b.getConstantAffineMap(lb));
+    tile.ubs.push_back(b.getConstantAffineMap(lb + tileSizes[i]));
   }
+  tile.lbOperands.resize(band.size());
+  tile.ubOperands.resize(band.size());
+  return getMemoryFootprintBytes(band[0], &tile);
 }
 
-// Returns tile sizes to use. Checks CL options; if none are specified, sets it
+// Searches for the tile sizes of 'band' whose tile footprint fits in
+// 'capacityBytes' and which maximize the reuse of the data of a tile. Starting
+// from a tile of one iteration along each loop but the innermost one, which
+// spans 'numLanes' iterations, the tile size along one loop is doubled at a
+// time, picking the loop which maximizes the number of iterations of the tile
+// per byte of its footprint, for as long as the footprint fits. Tile sizes do
+// not exceed 'maxTileSizes'. Returns false if a lower bound of the band is not
+// constant or a footprint is unknown.
+// TODO(mlir-team): account for the conflict misses of the tile.
+static bool searchTileSizes(ArrayRef<AffineForOp> band, uint64_t capacityBytes,
+                            unsigned numLanes, ArrayRef<unsigned> maxTileSizes,
+                            SmallVectorImpl<unsigned> *tileSizes) {
+  assert(band.size() == maxTileSizes.size() && "invalid tile size count");
+  if (llvm::any_of(band, [](AffineForOp forOp) {
+        return !forOp.hasConstantLowerBound();
+      }))
+    return false;
+
+  unsigned width = band.size();
+  tileSizes->assign(width, 1);
+  tileSizes->back() = std::max(1U, std::min(numLanes, maxTileSizes.back()));
+  if (!getTileFootprintBytes(band, *tileSizes).hasValue())
+    return false;
+
+  SmallVector<unsigned, 6> candidate;
+  while (true) {
+    Optional<unsigned> bestLoop;
+    double bestReuse = 0;
+    for (unsigned i = 0; i < width; i++) {
+      if ((*tileSizes)[i] >= maxTileSizes[i])
+        continue;
+      candidate.assign(tileSizes->begin(), tileSizes->end());
+      candidate[i] = std::min(2 * candidate[i], maxTileSizes[i]);
+      Optional<int64_t> footprint = getTileFootprintBytes(band, candidate);
+      if (!footprint.hasValue())
+        return false;
+      if (static_cast<uint64_t>(footprint.getValue()) > capacityBytes)
+        continue;
+      double numIterations = 1;
+      for (unsigned tSize : candidate)
+        numIterations *= tSize;
+      double reuse = numIterations / std::max<int64_t>(1, footprint.getValue());
+      if (!bestLoop.hasValue() || reuse > bestReuse) {
+        bestLoop = i;
+        bestReuse = reuse;
+      }
+    }
+    if (!bestLoop.hasValue())
+      break;
+    unsigned &tSize = (*tileSizes)[bestLoop.getValue()];
+    tSize = std::min(2 * tSize, maxTileSizes[bestLoop.getValue()]);
+  }
+  return true;
+}
+
+// Returns tile sizes to use. Checks CL options; if none are specified, searches
+// for the tile sizes whose tile footprint fits in the cache with the most
+// reuse (see searchTileSizes). If the band has non-constant bounds, sets them
 // based on a simple model that looks at the memory footprint and determines
 // tile sizes assuming identity accesses / 1:1 tile size proportional footprint
 // along each of the dimensions being tiled.
@@ -337,7 +743,7 @@ void LoopTiling::getTileSizes(ArrayRef<AffineForOp> band,
     std::fill(tileSizes->begin(), tileSizes->end(),
               LoopTiling::kDefaultTileSize);
     if (avoidMaxMinBounds)
-      adjustToDivisorsOfTripCounts(band, tileSizes);
+      adjustToDivisorsOfTripCounts(band, /*innermostMultiple=*/1, tileSizes);
     LLVM_DEBUG(
         rootForOp.emitWarning("memory footprint unknown: using default tile "
                               "sizes adjusted to trip count divisors"));
@@ -345,6 +751,7 @@ void LoopTiling::getTileSizes(ArrayRef<AffineForOp> band,
   }
 
   // Check how many times larger the cache size is when compared to footprint.
+  uint64_t cacheSizeBytes = levelCapacities.front();
   uint64_t excessFactor = llvm::divideCeil(fp.getValue(), cacheSizeBytes);
   if (excessFactor <= 1) {
     // No need of any tiling - set tile size to 1.
@@ -352,6 +759,24 @@ void LoopTiling::getTileSizes(ArrayRef<AffineForOp> band,
     return;
   }
 
+  // Search for the tile sizes if the trip counts are known, or estimated from
+  // the profile given with -loop-profile.
+  SmallVector<unsigned, 6> tripCounts;
+  for (auto forOp : band) {
+    auto mayConst = getEstimatedTripCount(forOp);
+    if (!mayConst.hasValue())
+      break;
+    tripCounts.push_back(std::min<uint64_t>(
+        mayConst.getValue(), std::numeric_limits<unsigned>::max()));
+  }
+  unsigned numLanes = getNumVectorLanes(band[0], vectorWidthBytes);
+  if (tripCounts.size() == band.size() &&
+      searchTileSizes(band, cacheSizeBytes, numLanes, tripCounts, tileSizes)) {
+    if (avoidMaxMinBounds)
+      adjustToDivisorsOfTripCounts(band, numLanes, tileSizes);
+    return;
+  }
+
   // Divide all loops equally in an attempt to reduce footprint.
   // TODO(bondhugula): this is approximate. Ideally, obtain reuse factor /
   // profitability along each dimension and weight tile sizes based on that as
@@ -373,38 +798,113 @@ void LoopTiling::getTileSizes(ArrayRef<AffineForOp> band,
     cumulProductOfTileSizes *= (*tileSizes)[i];
   }
   if (avoidMaxMinBounds)
-    adjustToDivisorsOfTripCounts(band, tileSizes);
+    adjustToDivisorsOfTripCounts(band, /*innermostMultiple=*/1, tileSizes);
+}
+
+// Computes in 'innerTileSizes' the tile sizes of the intra-tile loops of 'band'
+// tiled with 'tileSizes', for each of the lower levels of the memory hierarchy
+// to tile for, as long as they split the tiles of the level above. Each inner
+// tile size divides the one of the level above if avoidMaxMinBounds is set.
+void LoopTiling::getInnerTileSizes(
+    ArrayRef<AffineForOp> band, ArrayRef<unsigned> tileSizes,
+    std::vector<SmallVector<unsigned, 6>> *innerTileSizes) {
+  unsigned numLevels = std::min<unsigned>(clTileLevels, levelCapacities.size());
+  unsigned numLanes = getNumVectorLanes(band[0], vectorWidthBytes);
+  SmallVector<unsigned, 6> outerTileSizes(tileSizes.begin(), tileSizes.end());
+  for (unsigned level = 1; level < numLevels; ++level) {
+    SmallVector<unsigned, 6> levelTileSizes;
+    if (!searchTileSizes(band, levelCapacities[level], numLanes,
+                         outerTileSizes, &levelTileSizes))
+      return;
+    if (avoidMaxMinBounds) {
+      SmallVector<Optional<uint64_t>, 6> outerCounts(outerTileSizes.begin(),
+                                                     outerTileSizes.end());
+      adjustToDivisors(outerCounts, numLanes, &levelTileSizes);
+    }
+    // Stop once the tiles are no longer split.
+    if (levelTileSizes == outerTileSizes)
+      return;
+    innerTileSizes->push_back(levelTileSizes);
+    outerTileSizes = levelTileSizes;
+  }
 }
 
 void LoopTiling::runOnFunction() {
   // Override cache size if provided on command line.
   if (clCacheSizeKiB.getNumOccurrences() > 0)
-    cacheSizeBytes = clCacheSizeKiB * 1024;
+    levelCapacities.front() = clCacheSizeKiB * 1024;
 
   // Bands of loops to tile.
   std::vector<SmallVector<AffineForOp, 6>> bands;
   getTileableBands(getFunction(), &bands);
 
+  // Tile with the symbolic tile sizes if provided on command line.
+  if (!clTileSizeArgs.empty()) {
+    Function &f = getFunction();
+    SmallVector<Value *, 6> tileSizes;
+    for (unsigned pos : clTileSizeArgs) {
+      if (pos >= f.getNumArguments()) {
+        f.emitError("tile size argument position out of range");
+        return signalPassFailure();
+      }
+      tileSizes.push_back(f.getArgument(pos));
+    }
+    for (auto &band : bands) {
+      if (isColdLoop(band[0]))
+        continue;
+      unsigned width = std::min<unsigned>(band.size(), tileSizes.size());
+      SmallVector<AffineForOp, 6> outerLoops(band.begin(),
+                                             band.begin() + width);
+      if (failed(tileCodeGen(outerLoops,
+                             ArrayRef<Value *>(tileSizes).take_front(width))))
+        return signalPassFailure();
+    }
+    return;
+  }
+
   for (auto &band : bands) {
+    // Leave the loop nests that the profile given with -loop-profile shows to
+    // be cold alone.
+    if (isColdLoop(band[0]))
+      continue;
     // Set up tile sizes; fill missing tile sizes at the end with default tile
     // size or clTileSize if one was provided.
     SmallVector<unsigned, 6> tileSizes;
     getTileSizes(band, &tileSizes);
+    // Tile sizes for the lower levels of the memory hierarchy, unless the tile
+    // sizes were provided on the command line.
+    std::vector<SmallVector<unsigned, 6>> innerTileSizes;
+    if (clTileSize.getNumOccurrences() == 0 && clTileSizes.empty())
+      getInnerTileSizes(band, tileSizes, &innerTileSizes);
     if (llvm::DebugFlag) {
       std::stringstream msg;
       msg << "using tile sizes [";
       for (auto tSize : tileSizes)
         msg << tSize << " ";
-      msg << "]\n";
+      msg << "]";
+      for (auto &levelTileSizes : innerTileSizes) {
+        msg << " [";
+        for (auto tSize : levelTileSizes)
+          msg << tSize << " ";
+        msg << "]";
+      }
+      msg << "\n";
       auto rootForOp = band[0];
       rootForOp.emitNote(msg.str());
     }
-    if (failed(tileCodeGen(band, tileSizes)))
+    SmallVector<AffineForOp, 12> tiledNest;
+    if (failed(tileCodeGen(band, tileSizes, &tiledNest)))
       return signalPassFailure();
+    // Tile the intra-tile loops of each level for the level below.
+    for (auto &levelTileSizes : innerTileSizes) {
+      SmallVector<AffineForOp, 6> intraTileLoops(
+          tiledNest.begin() + band.size(), tiledNest.end());
+      if (failed(tileCodeGen(intraTileLoops, levelTileSizes, &tiledNest)))
+        return signalPassFailure();
+    }
   }
 }
 
 constexpr unsigned LoopTiling::kDefaultTileSize;
-constexpr uint64_t LoopTiling::kDefaultCacheMemCapacity;
 
 static PassRegistration<LoopTiling> pass("loop-tile", "Tile loop nests");
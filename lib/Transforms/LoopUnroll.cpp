@@ -23,14 +23,17 @@
 
 #include "mlir/AffineOps/AffineOps.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/LoopProfile.h"
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/LoopUtils.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace mlir;
 
@@ -53,40 +56,93 @@ static llvm::cl::opt<unsigned> clUnrollNumRepetitions(
     llvm::cl::desc("Unroll innermost loops repeatedly this many times"),
     llvm::cl::cat(clOptionsCategory));
 
+static llvm::cl::opt<bool> clUnrollVersion(
+    "unroll-version",
+    llvm::cl::desc("Version loops on their trip count being a multiple of the "
+                   "unroll factor instead of generating cleanup loops"),
+    llvm::cl::cat(clOptionsCategory));
+
 static llvm::cl::opt<unsigned> clUnrollFullThreshold(
     "unroll-full-threshold", llvm::cl::Hidden,
     llvm::cl::desc(
         "Unroll all loops with trip count less than or equal to this"),
     llvm::cl::cat(clOptionsCategory));
 
+static llvm::cl::opt<unsigned> clUnrollMaxGrowth(
+    "unroll-max-growth",
+    llvm::cl::desc("Maximum number of operations the unrolling of the loops of "
+                   "a function, or of a loop nest with -loop-nest-unroll, may "
+                   "add to it, no limit if 0"),
+    llvm::cl::init(0), llvm::cl::cat(clOptionsCategory));
+
 namespace {
-/// Loop unrolling pass. Unrolls all innermost loops unless full unrolling and a
-/// full unroll threshold was specified, in which case, fully unrolls all loops
-/// with trip count less than the specified threshold. The latter is for testing
+/// Loop unroller. Unrolls all innermost loops unless full unrolling and a full
+/// unroll threshold was specified, in which case, fully unrolls all loops with
+/// trip count less than the specified threshold. The latter is for testing
 /// purposes, especially for testing outer loop unrolling.
-struct LoopUnroll : public FunctionPass<LoopUnroll> {
+struct LoopUnroller {
   const Optional<unsigned> unrollFactor;
   const Optional<bool> unrollFull;
   // Callback to obtain unroll factors; if this has a callable target, takes
   // precedence over command-line argument or passed argument.
   const std::function<unsigned(AffineForOp)> getUnrollFactor;
 
-  explicit LoopUnroll(
+  explicit LoopUnroller(
       Optional<unsigned> unrollFactor = None, Optional<bool> unrollFull = None,
       const std::function<unsigned(AffineForOp)> &getUnrollFactor = nullptr)
       : unrollFactor(unrollFactor), unrollFull(unrollFull),
         getUnrollFactor(getUnrollFactor) {}
 
-  void runOnFunction() override;
+  /// Unroll the loops of 'func'.
+  void unrollLoops(Function &func);
 
   /// Unroll this for op. Returns failure if nothing was done.
   LogicalResult runOnAffineForOp(AffineForOp forOp);
 
+  /// Unrolls 'forOp' by 'unrollFactor' with 'unroll' if the operations this
+  /// adds to the function fit in the growth budget, which is then decreased
+  /// by their number.  Returns failure if nothing was done.
+  LogicalResult
+  unrollWithinBudget(AffineForOp forOp, uint64_t unrollFactor,
+                     llvm::function_ref<LogicalResult()> unroll);
+
+  /// The number of operations that unrolling may still add to the function,
+  /// if limited by -unroll-max-growth.
+  Optional<uint64_t> growthBudget;
+
   static const unsigned kDefaultUnrollFactor = 4;
 };
+
+/// Loop unrolling pass, unrolling the loops of each function.
+struct LoopUnroll : public FunctionPass<LoopUnroll> {
+  explicit LoopUnroll(
+      Optional<unsigned> unrollFactor = None, Optional<bool> unrollFull = None,
+      const std::function<unsigned(AffineForOp)> &getUnrollFactor = nullptr)
+      : unroller(unrollFactor, unrollFull, getUnrollFactor) {}
+
+  void runOnFunction() override { unroller.unrollLoops(getFunction()); }
+
+  LoopUnroller unroller;
+};
+
+/// Loop unrolling pass, unrolling the loops of each loop nest of a function
+/// concurrently. The growth budget applies to each loop nest.
+struct LoopNestUnroll : public LoopNestPass<LoopNestUnroll> {
+  explicit LoopNestUnroll(Optional<unsigned> unrollFactor = None,
+                          Optional<bool> unrollFull = None)
+      : unroller(unrollFactor, unrollFull) {}
+
+  void runOnLoopNest() override { unroller.unrollLoops(getLoopNest()); }
+
+  LoopUnroller unroller;
+};
 } // end anonymous namespace
 
-void LoopUnroll::runOnFunction() {
+void LoopUnroller::unrollLoops(Function &func) {
+  growthBudget = None;
+  if (clUnrollMaxGrowth != 0)
+    growthBudget = clUnrollMaxGrowth;
+
   // Gathers all innermost loops through a post order pruned walk.
   struct InnermostLoopGatherer {
     // Store innermost loops as we walk.
@@ -128,13 +184,16 @@ void LoopUnroll::runOnFunction() {
     // Gathers all loops with trip count <= minTripCount. Do a post order walk
     // so that loops are gathered from innermost to outermost (or else unrolling
     // an outer one may delete gathered inner ones).
-    getFunction().walkPostOrder<AffineForOp>([&](AffineForOp forOp) {
+    func.walkPostOrder([&](AffineForOp forOp) {
+      if (isColdLoop(forOp))
+        return;
       Optional<uint64_t> tripCount = getConstantTripCount(forOp);
       if (tripCount.hasValue() && tripCount.getValue() <= clUnrollFullThreshold)
         loops.push_back(forOp);
     });
     for (auto forOp : loops)
-      loopUnrollFull(forOp);
+      unrollWithinBudget(forOp, getConstantTripCount(forOp).getValue(),
+                         [&] { return loopUnrollFull(forOp); });
     return;
   }
 
@@ -142,7 +201,6 @@ void LoopUnroll::runOnFunction() {
                                 ? clUnrollNumRepetitions
                                 : 1;
   // If the call back is provided, we will recurse until no loops are found.
-  Function &func = getFunction();
   for (unsigned i = 0; i < numRepetitions || getUnrollFactor; i++) {
     InnermostLoopGatherer ilg;
     ilg.walkPostOrder(&func);
@@ -158,26 +216,66 @@ void LoopUnroll::runOnFunction() {
   }
 }
 
+LogicalResult LoopUnroller::unrollWithinBudget(
+    AffineForOp forOp, uint64_t unrollFactor,
+    llvm::function_ref<LogicalResult()> unroll) {
+  if (!growthBudget || unrollFactor <= 1)
+    return unroll();
+  // Each additional copy of the body adds all its operations but the
+  // terminator.  Neither the loop itself nor its terminator are counted.
+  uint64_t numBodyOps = 0;
+  forOp.getOperation()->walk([&](Operation *op) { ++numBodyOps; });
+  numBodyOps -= 2;
+  if (numBodyOps != 0 && unrollFactor - 1 > *growthBudget / numBodyOps)
+    return failure();
+  if (failed(unroll()))
+    return failure();
+  *growthBudget -= numBodyOps * (unrollFactor - 1);
+  return success();
+}
+
 /// Unrolls a 'affine.for' op. Returns success if the loop was unrolled,
 /// failure otherwise. The default unroll factor is 4.
-LogicalResult LoopUnroll::runOnAffineForOp(AffineForOp forOp) {
+LogicalResult LoopUnroller::runOnAffineForOp(AffineForOp forOp) {
+  auto unrollByFactor = [&](AffineForOp forOp, uint64_t unrollFactor) {
+    return unrollWithinBudget(forOp, unrollFactor, [&] {
+      return clUnrollVersion ? loopUnrollByFactorVersioned(forOp, unrollFactor)
+                             : loopUnrollByFactor(forOp, unrollFactor);
+    });
+  };
   // Use the function callback if one was provided.
   if (getUnrollFactor) {
-    return loopUnrollByFactor(forOp, getUnrollFactor(forOp));
+    return unrollByFactor(forOp, getUnrollFactor(forOp));
   }
+  // Leave the loops that the profile given with -loop-profile shows to be cold
+  // alone.
+  if (isColdLoop(forOp))
+    return failure();
   // Unroll by the factor passed, if any.
   if (unrollFactor.hasValue())
-    return loopUnrollByFactor(forOp, unrollFactor.getValue());
+    return unrollByFactor(forOp, unrollFactor.getValue());
   // Unroll by the command line factor if one was specified.
   if (clUnrollFactor.getNumOccurrences() > 0)
-    return loopUnrollByFactor(forOp, clUnrollFactor);
+    return unrollByFactor(forOp, clUnrollFactor);
   // Unroll completely if full loop unroll was specified.
   if (clUnrollFull.getNumOccurrences() > 0 ||
-      (unrollFull.hasValue() && unrollFull.getValue()))
-    return loopUnrollFull(forOp);
+      (unrollFull.hasValue() && unrollFull.getValue())) {
+    auto tripCount = getConstantTripCount(forOp);
+    if (!tripCount)
+      return failure();
+    return unrollWithinBudget(forOp, *tripCount,
+                              [&] { return loopUnrollFull(forOp); });
+  }
 
-  // Unroll by four otherwise.
-  return loopUnrollByFactor(forOp, kDefaultUnrollFactor);
+  // Unroll by four otherwise, or by the largest power of two not exceeding the
+  // trip count the profile shows for a loop without a constant trip count.
+  uint64_t factor = kDefaultUnrollFactor;
+  if (!getConstantTripCount(forOp))
+    if (auto tripCount = getEstimatedTripCount(forOp))
+      factor = std::min(factor, llvm::PowerOf2Floor(*tripCount));
+  if (factor <= 1)
+    return failure();
+  return unrollByFactor(forOp, factor);
 }
 
 FunctionPassBase *mlir::createLoopUnrollPass(
@@ -188,4 +286,15 @@ FunctionPassBase *mlir::createLoopUnrollPass(
       unrollFull == -1 ? None : Optional<bool>(unrollFull), getUnrollFactor);
 }
 
+LoopNestPassBase *mlir::createLoopNestUnrollPass(int unrollFactor,
+                                                 int unrollFull) {
+  return new LoopNestUnroll(
+      unrollFactor == -1 ? None : Optional<unsigned>(unrollFactor),
+      unrollFull == -1 ? None : Optional<bool>(unrollFull));
+}
+
 static PassRegistration<LoopUnroll> pass("loop-unroll", "Unroll loops");
+
+static PassRegistration<LoopNestUnroll>
+    nestPass("loop-nest-unroll",
+             "Unroll the loops of each loop nest of a function concurrently");
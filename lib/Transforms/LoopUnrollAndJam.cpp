@@ -40,19 +40,33 @@
 //
 // Note: 'if/else' blocks are not jammed. So, if there are loops inside if
 // op's, bodies of those loops will not be jammed.
+//
+// With -unroll-jam-auto, the pass instead picks a factor for every loop that
+// surrounds other loops, innermost first, so as to register-block kernels such
+// as matrix multiplications: the values that the innermost loops access
+// independently of the unroll-jammed loop are reused across its unrolled
+// copies, as long as the copies of those that vary along it still fit in the
+// vector registers of the target.
 //===----------------------------------------------------------------------===//
 #include "mlir/Transforms/Passes.h"
 
 #include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/Utils.h"
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
 #include "mlir/Transforms/LoopUtils.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include <algorithm>
 
 using namespace mlir;
 
@@ -67,27 +81,180 @@ static llvm::cl::opt<unsigned>
                                      " (default 4)"),
                       llvm::cl::cat(clOptionsCategory));
 
+static llvm::cl::opt<bool> clUnrollJamAuto(
+    "unroll-jam-auto", llvm::cl::Hidden,
+    llvm::cl::desc("Unroll jam all the loops surrounding other loops by "
+                   "factors selected for register reuse"),
+    llvm::cl::cat(clOptionsCategory));
+
 namespace {
 /// Loop unroll jam pass. Currently, this just unroll jams the first
-/// outer loop in a Function.
+/// outer loop in a Function, unless factors are selected automatically.
 struct LoopUnrollAndJam : public FunctionPass<LoopUnrollAndJam> {
   Optional<unsigned> unrollJamFactor;
   static const unsigned kDefaultUnrollJamFactor = 4;
-
-  explicit LoopUnrollAndJam(Optional<unsigned> unrollJamFactor = None)
-      : unrollJamFactor(unrollJamFactor) {}
+  /// The largest factor selected automatically.
+  static const unsigned kMaxSelectedUnrollJamFactor = 8;
+
+  /// Whether factors are selected for each loop rather than fixed.
+  bool selectFactors;
+  /// The target whose vector registers hold the values reused across the
+  /// unroll-jammed copies when factors are selected.
+  std::shared_ptr<const TargetMemoryModel> memoryModel;
+
+  explicit LoopUnrollAndJam(
+      Optional<unsigned> unrollJamFactor = None, bool selectFactors = false,
+      std::shared_ptr<const TargetMemoryModel> memoryModel = nullptr)
+      : unrollJamFactor(unrollJamFactor), selectFactors(selectFactors),
+        memoryModel(memoryModel ? std::move(memoryModel)
+                                : std::make_shared<const TargetMemoryModel>(
+                                      TargetMemoryModel::getDefault())) {}
 
   void runOnFunction() override;
   LogicalResult runOnAffineForOp(AffineForOp forOp);
+
+  /// Returns the factor to unroll jam 'forOp' by for register reuse, 1 if it
+  /// shouldn't be unroll-jammed.
+  unsigned getRegisterBlockingFactor(AffineForOp forOp);
+
+  DependenceAnalysis *dependences = nullptr;
+
+  /// Statistics of this pass.
+  Statistic numUnrollJammed = {this, "num-unroll-jammed",
+                               "Number of loops unroll-jammed"};
 };
 } // end anonymous namespace
 
-FunctionPassBase *mlir::createLoopUnrollAndJamPass(int unrollJamFactor) {
+FunctionPassBase *mlir::createLoopUnrollAndJamPass(
+    int unrollJamFactor, bool selectFactors,
+    std::shared_ptr<const TargetMemoryModel> memoryModel) {
   return new LoopUnrollAndJam(
-      unrollJamFactor == -1 ? None : Optional<unsigned>(unrollJamFactor));
+      unrollJamFactor == -1 ? None : Optional<unsigned>(unrollJamFactor),
+      selectFactors, std::move(memoryModel));
+}
+
+/// Returns true if 'value' is computed from 'iv'.
+static bool isVaryingAlong(Value *value, Value *iv) {
+  if (value == iv)
+    return true;
+  auto *op = value->getDefiningOp();
+  return op && llvm::any_of(op->getOperands(), [&](Value *operand) {
+           return isVaryingAlong(operand, iv);
+         });
+}
+
+/// Returns true if 'forOp' doesn't contain any other affine.for op.
+static bool isInnermostLoop(AffineForOp forOp) {
+  return !forOp.getBody()
+              ->walk([](AffineForOp) { return WalkResult::interrupt(); })
+              .wasInterrupted();
+}
+
+unsigned LoopUnrollAndJam::getRegisterBlockingFactor(AffineForOp forOp) {
+  auto *forInst = forOp.getOperation();
+  auto *iv = forOp.getInductionVar();
+
+  // Unroll and jam requires the bounds of the inner loops not to depend on the
+  // loop unroll-jammed.
+  SmallVector<AffineForOp, 4> innermostLoops;
+  bool hasDependentBounds = false;
+  forOp.getBody()->walk([&](AffineForOp innerForOp) {
+    for (auto *operand : innerForOp.getLowerBoundOperands())
+      hasDependentBounds |= !isDefinedOutsideOfLoop(operand, forOp);
+    for (auto *operand : innerForOp.getUpperBoundOperands())
+      hasDependentBounds |= !isDefinedOutsideOfLoop(operand, forOp);
+    if (isInnermostLoop(innerForOp))
+      innermostLoops.push_back(innerForOp);
+  });
+  if (hasDependentBounds || innermostLoops.empty())
+    return 1;
+
+  unsigned numRegisters = memoryModel->getNumVectorRegisters();
+  unsigned maxNumVarying = 0, maxNumInvariant = 0;
+  bool hasReuse = false;
+  for (auto innerForOp : innermostLoops) {
+    // Each distinct element accessed in the body of the innermost loop takes a
+    // register per unrolled copy if it varies along 'forOp', and a single one
+    // reused by all the copies otherwise.
+    SmallVector<Operation *, 8> memOps, distinctOps;
+    innerForOp.getOperation()->walk([&](Operation *op) {
+      if (!op->isa<LoadOp>() && !op->isa<StoreOp>())
+        return;
+      memOps.push_back(op);
+      if (llvm::none_of(distinctOps, [&](Operation *distinctOp) {
+            return haveSameMemRefAccess(distinctOp, op);
+          }))
+        distinctOps.push_back(op);
+    });
+    unsigned numVarying = llvm::count_if(distinctOps, [&](Operation *op) {
+      auto indices = op->isa<LoadOp>() ? op->cast<LoadOp>().getIndices()
+                                       : op->cast<StoreOp>().getIndices();
+      return llvm::any_of(
+          indices, [&](Value *index) { return isVaryingAlong(index, iv); });
+    });
+    unsigned numInvariant = distinctOps.size() - numVarying;
+    hasReuse |= numVarying != 0 && numInvariant != 0;
+    maxNumVarying = std::max(maxNumVarying, numVarying);
+    maxNumInvariant = std::max(maxNumInvariant, numInvariant);
+
+    // Jamming the copies of the innermost loop body is an interchange of
+    // 'forOp' with the loops down to the innermost one, which must preserve
+    // the dependences between its accesses.
+    SmallVector<AffineForOp, 4> loops;
+    for (auto *op = innerForOp.getOperation(); op != forInst;
+         op = op->getParentOp())
+      if (auto loop = op->dyn_cast<AffineForOp>())
+        loops.push_back(loop);
+    loops.push_back(forOp);
+    std::reverse(loops.begin(), loops.end());
+    std::vector<SmallVector<DependenceComponent, 2>> depCompsVec;
+    getLoopNestDependenceComponents(loops, memOps, &depCompsVec,
+                                    /*isParallelLoop=*/nullptr, dependences);
+    SmallVector<unsigned, 4> loopPermMap;
+    loopPermMap.push_back(loops.size() - 1);
+    for (unsigned i = 1, e = loops.size(); i < e; ++i)
+      loopPermMap.push_back(i - 1);
+    if (!isValidLoopInterchangePermutation(depCompsVec, loopPermMap))
+      return 1;
+  }
+  if (!hasReuse)
+    return 1;
+
+  // Pick the largest power of two whose copies of the varying values fit in
+  // the registers along with the reused ones, without exceeding the trip
+  // count.
+  Optional<uint64_t> tripCount = getConstantTripCount(forOp);
+  unsigned factor = 1;
+  while (factor * 2 <= kMaxSelectedUnrollJamFactor &&
+         factor * 2 * maxNumVarying + maxNumInvariant <= numRegisters &&
+         (!tripCount || factor * 2 <= tripCount.getValue()))
+    factor *= 2;
+  return factor;
 }
 
 void LoopUnrollAndJam::runOnFunction() {
+  if (selectFactors || clUnrollJamAuto) {
+    dependences = &getAnalysis<DependenceAnalysis>();
+    // Collect the loops innermost first, so that the accesses of the bodies
+    // already unroll-jammed are accounted for when selecting the factors of
+    // the loops surrounding them.
+    SmallVector<AffineForOp, 8> forOps;
+    getFunction().walkPostOrder(
+        [&](AffineForOp forOp) { forOps.push_back(forOp); });
+    for (auto forOp : forOps) {
+      if (isInnermostLoop(forOp))
+        continue;
+      unsigned factor = getRegisterBlockingFactor(forOp);
+      if (factor == 1)
+        continue;
+      LLVM_DEBUG(llvm::dbgs() << "unroll-jamming loop by " << factor << "\n");
+      dependences->invalidate(forOp.getOperation());
+      if (succeeded(loopUnrollJamByFactor(forOp, factor)))
+        ++numUnrollJammed;
+    }
+    return;
+  }
+
   // Currently, just the outermost loop from the first loop nest is
   // unroll-and-jammed by this pass. However, runOnAffineForOp can be called on
   // any for operation.
@@ -194,6 +361,9 @@ LogicalResult mlir::loopUnrollJamByFactor(AffineForOp forOp,
     SmallVector<Value *, 4> cleanupOperands;
     getCleanupLoopLowerBound(forOp, unrollJamFactor, &cleanupMap,
                              &cleanupOperands, &builder);
+    assert(cleanupMap &&
+           "cleanup loop lower bound map for single result lower bound maps "
+           "can always be determined");
     cleanupAffineForOp.setLowerBound(cleanupOperands, cleanupMap);
 
     // Promote the cleanup loop if it has turned into a single iteration loop.
@@ -21,6 +21,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/Utils.h"
 #include "mlir/IR/AffineExprVisitor.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/IntegerSet.h"
@@ -29,21 +31,100 @@
 #include "mlir/StandardOps/Ops.h"
 #include "mlir/Support/Functional.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
 using namespace mlir;
 
+static llvm::cl::OptionCategory clOptionsCategory("lower-affine options");
+
+static llvm::cl::opt<bool> clMarkParallelLoops(
+    "lower-affine-mark-parallel",
+    llvm::cl::desc("Mark the back-edges of the loops that have no loop-carried "
+                   "dependences with the llvm.loop.parallel attribute"),
+    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<bool> clStrengthReduce(
+    "lower-affine-strength-reduce",
+    llvm::cl::desc("Compute the affine.apply ops of loop bodies that are "
+                   "linear in the induction variable by incrementing them "
+                   "across iterations"),
+    llvm::cl::cat(clOptionsCategory));
+
+// Prefix of the loop hint attributes, such as "llvm.loop.parallel",
+// "llvm.loop.vectorize.width" or "llvm.loop.unroll.disable".  When attached to
+// an "affine.for", they are moved to the back-edge branch of the lowered loop,
+// where the translation to LLVM IR turns them into loop metadata.
+static constexpr const char *kLoopHintPrefix = "llvm.loop.";
+
+// Return true if `value` is known to be non-negative: it is a non-negative
+// constant, the size of a memref dimension, or it belongs to
+// `nonNegativeValues` if provided.
+static bool
+isKnownNonNegative(Value *value,
+                   const llvm::DenseSet<Value *> *nonNegativeValues) {
+  if (nonNegativeValues && nonNegativeValues->count(value))
+    return true;
+  auto *op = value->getDefiningOp();
+  if (!op)
+    return false;
+  if (auto constOp = op->dyn_cast<ConstantIndexOp>())
+    return constOp.getValue() >= 0;
+  return op->isa<DimOp>();
+}
+
+// Return true if `expr` applied to `dimValues` and `symbolValues` is known to
+// be non-negative.  The Euclidean modulo always is, while sums, products and
+// divisions by positive constants are if their operands are.
+static bool
+isKnownNonNegative(AffineExpr expr, ArrayRef<Value *> dimValues,
+                   ArrayRef<Value *> symbolValues,
+                   const llvm::DenseSet<Value *> *nonNegativeValues) {
+  switch (expr.getKind()) {
+  case AffineExprKind::Constant:
+    return expr.cast<AffineConstantExpr>().getValue() >= 0;
+  case AffineExprKind::DimId:
+    return isKnownNonNegative(
+        dimValues[expr.cast<AffineDimExpr>().getPosition()], nonNegativeValues);
+  case AffineExprKind::SymbolId:
+    return isKnownNonNegative(
+        symbolValues[expr.cast<AffineSymbolExpr>().getPosition()],
+        nonNegativeValues);
+  case AffineExprKind::Mod:
+    return true;
+  default: {
+    auto binExpr = expr.cast<AffineBinaryOpExpr>();
+    return isKnownNonNegative(binExpr.getLHS(), dimValues, symbolValues,
+                              nonNegativeValues) &&
+           isKnownNonNegative(binExpr.getRHS(), dimValues, symbolValues,
+                              nonNegativeValues);
+  }
+  }
+}
+
 namespace {
 // Visit affine expressions recursively and build the sequence of operations
 // that correspond to it.  Visitation functions return an Value of the
-// expression subtree they visited or `nullptr` on error.
+// expression subtree they visited or `nullptr` on error.  The divisions and
+// modulos of subexpressions known to be non-negative are lowered to the single
+// unsigned operation, which LLVM turns into a shift or a mask for powers of
+// two, rather than to the sequence handling negative values.
 class AffineApplyExpander
     : public AffineExprVisitor<AffineApplyExpander, Value *> {
 public:
   // This internal class expects arguments to be non-null, checks must be
-  // performed at the call site.
+  // performed at the call site.  `nonNegativeValues`, if provided, holds the
+  // values known to be non-negative in addition to the constants and the
+  // sizes of memref dimensions.
   AffineApplyExpander(FuncBuilder *builder, ArrayRef<Value *> dimValues,
-                      ArrayRef<Value *> symbolValues, Location loc)
+                      ArrayRef<Value *> symbolValues, Location loc,
+                      const llvm::DenseSet<Value *> *nonNegativeValues)
       : builder(*builder), dimValues(dimValues), symbolValues(symbolValues),
-        loc(loc) {}
+        loc(loc), nonNegativeValues(nonNegativeValues) {}
+
+  bool isNonNegative(AffineExpr expr) {
+    return isKnownNonNegative(expr, dimValues, symbolValues, nonNegativeValues);
+  }
 
   template <typename OpTy> Value *buildBinaryExpr(AffineBinaryOpExpr expr) {
     auto lhs = visit(expr.getLHS());
@@ -89,6 +170,9 @@ public:
     auto rhs = visit(expr.getRHS());
     assert(lhs && rhs && "unexpected affine expr lowering failure");
 
+    if (isNonNegative(expr.getLHS()))
+      return builder.create<RemIUOp>(loc, lhs, rhs);
+
     Value *remainder = builder.create<RemISOp>(loc, lhs, rhs);
     Value *zeroCst = builder.create<ConstantIndexOp>(loc, 0);
     Value *isRemainderNegative =
@@ -127,6 +211,9 @@ public:
     auto rhs = visit(expr.getRHS());
     assert(lhs && rhs && "unexpected affine expr lowering failure");
 
+    if (isNonNegative(expr.getLHS()))
+      return builder.create<DivIUOp>(loc, lhs, rhs);
+
     Value *zeroCst = builder.create<ConstantIndexOp>(loc, 0);
     Value *noneCst = builder.create<ConstantIndexOp>(loc, -1);
     Value *negative =
@@ -168,6 +255,14 @@ public:
     auto rhs = visit(expr.getRHS());
     assert(lhs && rhs && "unexpected affine expr lowering failure");
 
+    // A non-negative `a` gives (a + b - 1) / b.
+    if (isNonNegative(expr.getLHS())) {
+      Value *bias = builder.create<ConstantIndexOp>(
+          loc, rhsConst.getValue() - 1);
+      Value *biased = builder.create<AddIOp>(loc, lhs, bias);
+      return builder.create<DivIUOp>(loc, biased, rhs);
+    }
+
     Value *zeroCst = builder.create<ConstantIndexOp>(loc, 0);
     Value *oneCst = builder.create<ConstantIndexOp>(loc, 1);
     Value *nonPositive =
@@ -210,29 +305,34 @@ private:
   ArrayRef<Value *> symbolValues;
 
   Location loc;
+  const llvm::DenseSet<Value *> *nonNegativeValues;
 };
 } // namespace
 
 // Create a sequence of operations that implement the `expr` applied to the
 // given dimension and symbol values.
-static mlir::Value *expandAffineExpr(FuncBuilder *builder, Location loc,
-                                     AffineExpr expr,
-                                     ArrayRef<Value *> dimValues,
-                                     ArrayRef<Value *> symbolValues) {
-  return AffineApplyExpander(builder, dimValues, symbolValues, loc).visit(expr);
+static mlir::Value *
+expandAffineExpr(FuncBuilder *builder, Location loc, AffineExpr expr,
+                 ArrayRef<Value *> dimValues, ArrayRef<Value *> symbolValues,
+                 const llvm::DenseSet<Value *> *nonNegativeValues = nullptr) {
+  return AffineApplyExpander(builder, dimValues, symbolValues, loc,
+                             nonNegativeValues)
+      .visit(expr);
 }
 
 // Create a sequence of operations that implement the `affineMap` applied to
 // the given `operands` (as it it were an AffineApplyOp).
 Optional<SmallVector<Value *, 8>> static expandAffineMap(
     FuncBuilder *builder, Location loc, AffineMap affineMap,
-    ArrayRef<Value *> operands) {
+    ArrayRef<Value *> operands,
+    const llvm::DenseSet<Value *> *nonNegativeValues = nullptr) {
   auto numDims = affineMap.getNumDims();
   auto expanded = functional::map(
-      [numDims, builder, loc, operands](AffineExpr expr) {
+      [numDims, builder, loc, operands, nonNegativeValues](AffineExpr expr) {
         return expandAffineExpr(builder, loc, expr,
                                 operands.take_front(numDims),
-                                operands.drop_front(numDims));
+                                operands.drop_front(numDims),
+                                nonNegativeValues);
       },
       affineMap.getResults());
   if (llvm::all_of(expanded, [](Value *v) { return v; }))
@@ -244,9 +344,21 @@ namespace {
 struct LowerAffinePass : public FunctionPass<LowerAffinePass> {
   void runOnFunction() override;
 
-  bool lowerAffineFor(AffineForOp forOp);
+  bool lowerAffineFor(AffineForOp forOp, bool isParallel);
   bool lowerAffineIf(AffineIfOp ifOp);
   bool lowerAffineApply(AffineApplyOp op);
+
+  // Record the induction variables and the results of affine.apply ops that
+  // are known to be non-negative.
+  void findNonNegativeValues(Operation *op);
+
+  // The values known to be non-negative, kept up to date as the induction
+  // variables and the affine.apply ops are replaced.
+  llvm::DenseSet<Value *> nonNegativeValues;
+
+  // The affine.apply ops erased by the strength reduction of the loop that
+  // contained them, which must not be lowered anymore.
+  llvm::DenseSet<Operation *> reducedApplyOps;
 };
 } // end anonymous namespace
 
@@ -276,6 +388,48 @@ static Value *buildMinMaxReductionSeq(Location loc, CmpIPredicate predicate,
   return value;
 }
 
+// Return the increment of the result of `applyOp`, an operation of the body of
+// `forOp`, from an iteration of `forOp` to the next if it is linear in the
+// induction variable and its other operands are defined outside of the loop.
+// Return None otherwise, or if computing the result is as cheap as
+// incrementing it.
+static Optional<int64_t> getLinearIncrement(AffineApplyOp applyOp,
+                                            AffineForOp forOp) {
+  auto map = applyOp.getAffineMap();
+  auto expr = map.getResult(0);
+  if (expr.isa<AffineDimExpr>() || expr.isa<AffineSymbolExpr>())
+    return None;
+
+  // Compare the result with the one of the next iteration, where the
+  // induction variable is incremented by the step.
+  auto *iv = forOp.getInductionVar();
+  auto *context = forOp.getOperation()->getContext();
+  bool usesIV = false;
+  SmallVector<AffineExpr, 4> dimReplacements, symReplacements;
+  for (unsigned i = 0, e = map.getNumInputs(); i < e; ++i) {
+    Value *operand = applyOp.getOperation()->getOperand(i);
+    bool isDim = i < map.getNumDims();
+    auto input = isDim ? getAffineDimExpr(i, context)
+                       : getAffineSymbolExpr(i - map.getNumDims(), context);
+    if (operand == iv) {
+      usesIV = true;
+      input = input + forOp.getStep();
+    } else if (!isDefinedOutsideOfLoop(operand, forOp)) {
+      return None;
+    }
+    (isDim ? dimReplacements : symReplacements).push_back(input);
+  }
+  if (!usesIV)
+    return None;
+  auto next = expr.replaceDimsAndSymbols(dimReplacements, symReplacements);
+  auto increment =
+      simplifyAffineExpr(next - expr, map.getNumDims(), map.getNumSymbols())
+          .dyn_cast<AffineConstantExpr>();
+  if (!increment || increment.getValue() == 0)
+    return None;
+  return increment.getValue();
+}
+
 // Convert a "affine.for" loop to a flow of blocks.  Return `false` on success.
 //
 // Create an SESE region for the loop (including its body) and append it to the
@@ -287,7 +441,13 @@ static Value *buildMinMaxReductionSeq(Location loc, CmpIPredicate predicate,
 // becomes the new end of the current SESE region.  The body of the loop is
 // constructed recursively after starting a new region (it may be, for example,
 // a nested loop).  Induction variable modification is appended to the body SESE
-// region that always loops back to the condition block.
+// region that always loops back to the condition block.  The loop hint
+// attributes of the "affine.for" are attached to this back-edge branch, along
+// with "llvm.loop.parallel" if `isParallel` is set.
+//
+// With strength reduction, the affine.apply ops of the body that are linear in
+// the induction variable are replaced by additional arguments of the condition
+// block, computed before the loop and incremented on the back-edge.
 //
 //      +---------------------------------+
 //      |   <code before the AffineForOp> |
@@ -319,7 +479,7 @@ static Value *buildMinMaxReductionSeq(Location loc, CmpIPredicate predicate,
 //      |   <code after the AffineForOp> |
 //      +--------------------------------+
 //
-bool LowerAffinePass::lowerAffineFor(AffineForOp forOp) {
+bool LowerAffinePass::lowerAffineFor(AffineForOp forOp, bool isParallel) {
   auto loc = forOp.getLoc();
   auto *forInst = forOp.getOperation();
 
@@ -334,6 +494,25 @@ bool LowerAffinePass::lowerAffineFor(AffineForOp forOp) {
   auto *conditionBlock = new Block();
   conditionBlock->insertBefore(endBlock);
   auto *iv = conditionBlock->addArgument(IndexType::get(forInst->getContext()));
+  if (nonNegativeValues.count(forOp.getInductionVar()))
+    nonNegativeValues.insert(iv);
+
+  // Find the affine.apply ops to strength-reduce, and give each its argument
+  // of the condition block.
+  SmallVector<std::pair<AffineApplyOp, int64_t>, 4> reducedApplies;
+  if (clStrengthReduce)
+    for (auto &op : *forOp.getBody())
+      if (auto applyOp = op.dyn_cast<AffineApplyOp>())
+        if (auto increment = getLinearIncrement(applyOp, forOp))
+          reducedApplies.emplace_back(applyOp, *increment);
+  SmallVector<Value *, 4> reducedValues;
+  for (auto &reduced : reducedApplies) {
+    auto *value =
+        conditionBlock->addArgument(IndexType::get(forInst->getContext()));
+    if (nonNegativeValues.count(reduced.first.getResult()))
+      nonNegativeValues.insert(value);
+    reducedValues.push_back(value);
+  }
 
   // Create the body block, moving the body of the forOp over to it and dropping
   // the affine terminator.
@@ -358,7 +537,21 @@ bool LowerAffinePass::lowerAffineFor(AffineForOp forOp) {
   if (!stepped)
     return true;
   // We know we applied a one-dimensional map.
-  builder.create<BranchOp>(loc, conditionBlock, stepped);
+  SmallVector<Value *, 4> backEdgeOperands(1, stepped);
+  for (unsigned i = 0, e = reducedApplies.size(); i < e; ++i) {
+    Value *increment =
+        builder.create<ConstantIndexOp>(loc, reducedApplies[i].second);
+    backEdgeOperands.push_back(
+        builder.create<AddIOp>(loc, reducedValues[i], increment));
+  }
+  auto backEdge =
+      builder.create<BranchOp>(loc, conditionBlock, backEdgeOperands);
+  for (auto attr : forInst->getAttrs())
+    if (attr.first.strref().startswith(kLoopHintPrefix))
+      backEdge.getOperation()->setAttr(attr.first, attr.second);
+  if (isParallel)
+    backEdge.getOperation()->setAttr("llvm.loop.parallel",
+                                     builder.getBoolAttr(true));
 
   // Now that the body block done, fill in the code to compute the bounds of the
   // induction variable in the init block.
@@ -366,8 +559,9 @@ bool LowerAffinePass::lowerAffineFor(AffineForOp forOp) {
 
   // Compute loop bounds.
   SmallVector<Value *, 8> operands(forOp.getLowerBoundOperands());
-  auto lbValues = expandAffineMap(&builder, forInst->getLoc(),
-                                  forOp.getLowerBoundMap(), operands);
+  auto lbValues =
+      expandAffineMap(&builder, forInst->getLoc(), forOp.getLowerBoundMap(),
+                      operands, &nonNegativeValues);
   if (!lbValues)
     return true;
   Value *lowerBound =
@@ -375,13 +569,32 @@ bool LowerAffinePass::lowerAffineFor(AffineForOp forOp) {
 
   operands.assign(forOp.getUpperBoundOperands().begin(),
                   forOp.getUpperBoundOperands().end());
-  auto ubValues = expandAffineMap(&builder, forInst->getLoc(),
-                                  forOp.getUpperBoundMap(), operands);
+  auto ubValues =
+      expandAffineMap(&builder, forInst->getLoc(), forOp.getUpperBoundMap(),
+                      operands, &nonNegativeValues);
   if (!ubValues)
     return true;
   Value *upperBound =
       buildMinMaxReductionSeq(loc, CmpIPredicate::SLT, *ubValues, builder);
-  builder.create<BranchOp>(loc, conditionBlock, lowerBound);
+
+  // The strength-reduced values start as the affine.apply ops they replace
+  // evaluated at the lower bound.
+  SmallVector<Value *, 4> initOperands(1, lowerBound);
+  for (unsigned i = 0, e = reducedApplies.size(); i < e; ++i) {
+    auto *applyInst = reducedApplies[i].first.getOperation();
+    SmallVector<Value *, 8> applyOperands(applyInst->getOperands());
+    std::replace(applyOperands.begin(), applyOperands.end(), iv, lowerBound);
+    auto initValues =
+        expandAffineMap(&builder, loc, reducedApplies[i].first.getAffineMap(),
+                        applyOperands, &nonNegativeValues);
+    if (!initValues)
+      return true;
+    initOperands.push_back((*initValues)[0]);
+    applyInst->getResult(0)->replaceAllUsesWith(reducedValues[i]);
+    applyInst->erase();
+    reducedApplyOps.insert(applyInst);
+  }
+  builder.create<BranchOp>(loc, conditionBlock, initOperands);
 
   // With the body block done, we can fill in the condition block.
   builder.setInsertionPointToEnd(conditionBlock);
@@ -537,9 +750,9 @@ bool LowerAffinePass::lowerAffineIf(AffineIfOp ifOp) {
     SmallVector<Value *, 8> operands(ifInst->getOperands());
     auto operandsRef = ArrayRef<Value *>(operands);
     auto numDims = integerSet.getNumDims();
-    Value *affResult = expandAffineExpr(&builder, loc, constraintExpr,
-                                        operandsRef.take_front(numDims),
-                                        operandsRef.drop_front(numDims));
+    Value *affResult = expandAffineExpr(
+        &builder, loc, constraintExpr, operandsRef.take_front(numDims),
+        operandsRef.drop_front(numDims), &nonNegativeValues);
     if (!affResult)
       return true;
 
@@ -573,9 +786,9 @@ bool LowerAffinePass::lowerAffineIf(AffineIfOp ifOp) {
 // operations using the StandardOps dialect.  Return true on error.
 bool LowerAffinePass::lowerAffineApply(AffineApplyOp op) {
   FuncBuilder builder(op.getOperation());
-  auto maybeExpandedMap =
-      expandAffineMap(&builder, op.getLoc(), op.getAffineMap(),
-                      llvm::to_vector<8>(op.getOperands()));
+  auto maybeExpandedMap = expandAffineMap(
+      &builder, op.getLoc(), op.getAffineMap(),
+      llvm::to_vector<8>(op.getOperands()), &nonNegativeValues);
   if (!maybeExpandedMap)
     return true;
 
@@ -583,11 +796,39 @@ bool LowerAffinePass::lowerAffineApply(AffineApplyOp op) {
   Value *expanded = (*maybeExpandedMap)[0];
   if (!expanded)
     return true;
+  if (nonNegativeValues.count(original))
+    nonNegativeValues.insert(expanded);
   original->replaceAllUsesWith(expanded);
   op.erase();
   return false;
 }
 
+void LowerAffinePass::findNonNegativeValues(Operation *op) {
+  AffineMap map;
+  SmallVector<Value *, 8> operands;
+  Value *result;
+  if (auto forOp = op->dyn_cast<AffineForOp>()) {
+    // The induction variable is at least as large as each lower bound.
+    map = forOp.getLowerBoundMap();
+    operands.assign(forOp.getLowerBoundOperands().begin(),
+                    forOp.getLowerBoundOperands().end());
+    result = forOp.getInductionVar();
+  } else if (auto applyOp = op->dyn_cast<AffineApplyOp>()) {
+    map = applyOp.getAffineMap();
+    operands.assign(op->operand_begin(), op->operand_end());
+    result = applyOp.getResult();
+  } else {
+    return;
+  }
+  ArrayRef<Value *> operandsRef(operands);
+  if (llvm::any_of(map.getResults(), [&](AffineExpr expr) {
+        return isKnownNonNegative(
+            expr, operandsRef.take_front(map.getNumDims()),
+            operandsRef.drop_front(map.getNumDims()), &nonNegativeValues);
+      }))
+    nonNegativeValues.insert(result);
+}
+
 // Entry point of the function convertor.
 //
 // Conversion is performed by recursively visiting operations of a Function.
@@ -606,25 +847,43 @@ bool LowerAffinePass::lowerAffineApply(AffineApplyOp op) {
 // construction.  When an Value is used, it gets replaced with the
 // corresponding Value that has been defined previously.  The value flow
 // starts with function arguments converted to basic block arguments.
+//
+// The values known to be non-negative are found before the conversion, which
+// loses the loop bounds, so that the divisions and modulos of affine
+// expressions can be lowered to single unsigned operations.
 void LowerAffinePass::runOnFunction() {
   SmallVector<Operation *, 8> instsToRewrite;
+  llvm::DenseSet<Operation *> parallelLoops;
+  nonNegativeValues.clear();
+  reducedApplyOps.clear();
 
   // Collect all the For operations as well as AffineIfOps and AffineApplyOps.
   // We do this as a prepass to avoid invalidating the walker with our rewrite.
+  // The parallel loops are also identified here, since the dependence analysis
+  // needs the enclosing loops to still be around.
+  LoopParallelismAnalysis *parallelism = nullptr;
+  if (clMarkParallelLoops)
+    parallelism = &getAnalysis<LoopParallelismAnalysis>();
   getFunction().walk([&](Operation *op) {
     if (op->isa<AffineApplyOp>() || op->isa<AffineForOp>() ||
         op->isa<AffineIfOp>())
       instsToRewrite.push_back(op);
+    findNonNegativeValues(op);
+    if (auto forOp = op->dyn_cast<AffineForOp>())
+      if (parallelism && parallelism->isParallel(forOp))
+        parallelLoops.insert(op);
   });
 
   // Rewrite all of the ifs and fors.  We walked the operations in preorder,
   // so we know that we will rewrite them in the same order.
   for (auto *op : instsToRewrite) {
+    if (reducedApplyOps.count(op))
+      continue;
     if (auto ifOp = op->dyn_cast<AffineIfOp>()) {
       if (lowerAffineIf(ifOp))
         return signalPassFailure();
     } else if (auto forOp = op->dyn_cast<AffineForOp>()) {
-      if (lowerAffineFor(forOp))
+      if (lowerAffineFor(forOp, parallelLoops.count(op) != 0))
         return signalPassFailure();
     } else if (lowerAffineApply(op->cast<AffineApplyOp>())) {
       return signalPassFailure();
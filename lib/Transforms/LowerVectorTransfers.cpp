@@ -46,7 +46,11 @@
 /// proper abstraction for the hardware.
 ///
 /// For now, we only emit a simple loop nest that performs clipped pointwise
-/// copies from a remote to a locally allocated memory.
+/// copies from a remote to a locally allocated memory. The 1-D transfers along
+/// the innermost memref dimension that are provably in bounds are not
+/// materialized: they are marked as in bounds, and the conversion to the LLVM
+/// dialect lowers them to a single unmasked vector load or store. The copies of
+/// the other transfers that are provably in bounds are not clipped.
 ///
 /// Consider the case:
 ///
@@ -87,6 +91,10 @@ using namespace mlir;
 
 #define DEBUG_TYPE "lower-vector-transfers"
 
+/// Name of the attribute marking the accesses that are known to be in bounds,
+/// see createAnnotateMemRefBoundsPass.
+static constexpr const char *kInBoundsAttrName = "in_bounds";
+
 namespace {
 
 /// Lowers VectorTransferOp into a combination of:
@@ -157,8 +165,51 @@ void coalesceCopy(VectorTransferOpTy transfer,
   }
 }
 
+/// Returns true if `transfer` is a 1-D transfer along the innermost dimension
+/// of its memref that provably stays within the bounds of the memref, which
+/// then doesn't need to be staged in a local buffer.
+template <typename VectorTransferOpTy>
+static bool isDirectTransfer(VectorTransferOpTy transfer) {
+  auto memRefType = transfer.getMemRefType();
+  if (transfer.getVectorType().getRank() != 1 || memRefType.getRank() == 0)
+    return false;
+  auto dim = transfer.getPermutationMap()
+                 .getResult(0)
+                 .template dyn_cast<AffineDimExpr>();
+  return dim && dim.getPosition() == memRefType.getRank() - 1 &&
+         isVectorTransferInBounds(transfer);
+}
+
+/// Returns the index of the vector dimension that `transfer` accesses along
+/// `memRefDim`, or -1 if the vector is broadcast along `memRefDim`.
+template <typename VectorTransferOpTy>
+static int getLoopIndex(VectorTransferOpTy transfer, unsigned memRefDim) {
+  // Linear search on a small number of entries.
+  auto exprs = transfer.getPermutationMap().getResults();
+  for (auto en : llvm::enumerate(exprs)) {
+    auto expr = en.value();
+    auto dim = expr.template dyn_cast<AffineDimExpr>();
+    // Sanity check.
+    assert(dim || expr.template cast<AffineConstantExpr>().getValue() == 0 &&
+                      "Expected dim or 0 in permutationMap");
+    if (dim && memRefDim == dim.getPosition())
+      return en.index();
+  }
+  return -1;
+}
+
+/// Marks the direct transfer `op` as in bounds, so that it is lowered to an
+/// unmasked vector load or store.  Returns false if it is already marked.
+static bool markInBounds(Operation *op, PatternRewriter &rewriter) {
+  if (op->getAttr(kInBoundsAttrName))
+    return false;
+  op->setAttr(kInBoundsAttrName, rewriter.getBoolAttr(true));
+  rewriter.updatedRootInPlace(op);
+  return true;
+}
+
 /// Emits remote memory accesses that are clipped to the boundaries of the
-/// MemRef.
+/// MemRef, unless `transfer` provably stays within these boundaries.
 template <typename VectorTransferOpTy>
 static llvm::SmallVector<edsc::ValueHandle, 8>
 clip(VectorTransferOpTy transfer, edsc::MemRefView &view,
@@ -167,29 +218,29 @@ clip(VectorTransferOpTy transfer, edsc::MemRefView &view,
   using namespace edsc::op;
   using edsc::intrinsics::select;
 
-  IndexHandle zero(index_t(0)), one(index_t(1));
   llvm::SmallVector<edsc::ValueHandle, 8> memRefAccess(transfer.getIndices());
   llvm::SmallVector<edsc::ValueHandle, 8> clippedScalarAccessExprs(
       memRefAccess.size(), edsc::IndexHandle());
 
+  // The accesses of a transfer that is in bounds need no clipping.
+  if (isVectorTransferInBounds(transfer)) {
+    for (unsigned memRefDim = 0; memRefDim < memRefAccess.size();
+         ++memRefDim) {
+      int loopIndex = getLoopIndex(transfer, memRefDim);
+      auto i = memRefAccess[memRefDim];
+      clippedScalarAccessExprs[memRefDim] =
+          loopIndex < 0 ? i : i + ivs[loopIndex];
+    }
+    return clippedScalarAccessExprs;
+  }
+
+  IndexHandle zero(index_t(0)), one(index_t(1));
+
   // Indices accessing to remote memory are clipped and their expressions are
   // returned in clippedScalarAccessExprs.
   for (unsigned memRefDim = 0; memRefDim < clippedScalarAccessExprs.size();
        ++memRefDim) {
-    // Linear search on a small number of entries.
-    int loopIndex = -1;
-    auto exprs = transfer.getPermutationMap().getResults();
-    for (auto en : llvm::enumerate(exprs)) {
-      auto expr = en.value();
-      auto dim = expr.template dyn_cast<AffineDimExpr>();
-      // Sanity check.
-      assert(dim || expr.template cast<AffineConstantExpr>().getValue() == 0 &&
-                        "Expected dim or 0 in permutationMap");
-      if (dim && memRefDim == dim.getPosition()) {
-        loopIndex = en.index();
-        break;
-      }
-    }
+    int loopIndex = getLoopIndex(transfer, memRefDim);
 
     // We cannot distinguish atm between unrolled dimensions that implement
     // the "always full" tile abstraction and need clipping from the other
@@ -265,6 +316,20 @@ VectorTransferRewriter<VectorTransferReadOp>::matchAndRewrite(
   using namespace mlir::edsc::intrinsics;
 
   VectorTransferReadOp transfer = op->cast<VectorTransferReadOp>();
+  if (isDirectTransfer(transfer)) {
+    // The padding value is never used: drop it, and mark the read as in bounds
+    // so that it is lowered to an unmasked vector load.
+    if (transfer.getPaddingValue().hasValue()) {
+      SmallVector<Value *, 8> indices(transfer.getIndices());
+      auto read = rewriter.create<VectorTransferReadOp>(
+          op->getLoc(), transfer.getVectorType(), transfer.getMemRef(),
+          indices, transfer.getPermutationMap());
+      read.setAttr(kInBoundsAttrName, rewriter.getBoolAttr(true));
+      rewriter.replaceOp(op, read.getResult());
+      return matchSuccess();
+    }
+    return markInBounds(op, rewriter) ? matchSuccess() : matchFailure();
+  }
 
   // 1. Setup all the captures.
   ScopedContext scope(FuncBuilder(op), transfer.getLoc());
@@ -324,6 +389,8 @@ VectorTransferRewriter<VectorTransferWriteOp>::matchAndRewrite(
   using namespace mlir::edsc::intrinsics;
 
   VectorTransferWriteOp transfer = op->cast<VectorTransferWriteOp>();
+  if (isDirectTransfer(transfer))
+    return markInBounds(op, rewriter) ? matchSuccess() : matchFailure();
 
   // 1. Setup all the captures.
   ScopedContext scope(FuncBuilder(op), transfer.getLoc());
@@ -40,6 +40,7 @@
 #include "mlir/Support/Functional.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Transforms/Passes.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "mlir/VectorOps/VectorOps.h"
 
 #include "llvm/Support/CommandLine.h"
@@ -153,7 +154,8 @@ using functional::map;
 
 static llvm::cl::list<int>
     clVectorSize("vector-size",
-                 llvm::cl::desc("Specify the HW vector size for vectorization"),
+                 llvm::cl::desc("Specify the HW vector size for vectorization "
+                                "(default: fill a target vector register)"),
                  llvm::cl::ZeroOrMore);
 
 #define DEBUG_TYPE "materialize-vect"
@@ -162,19 +164,19 @@ namespace {
 struct MaterializationState {
   /// In practice, the determination of the HW-specific vector type to use when
   /// lowering a super-vector type must be based on the elemental type. The
-  /// elemental type must be retrieved from the super-vector type. In the future
-  /// information about hardware vector type for a particular elemental type
-  /// will be part of the contract between MLIR and the backend.
+  /// elemental type is retrieved from the super-vector type of each
+  /// terminator. In the future information about hardware vector type for a
+  /// particular elemental type will be part of the contract between MLIR and
+  /// the backend.
   ///
   /// For example, 8xf32 has the same size as 16xf16 but the targeted HW itself
   /// may exhibit the following property:
   /// 1. have a special unit for a 128xf16 datapath;
   /// 2. no F16 FPU support on the regular 8xf32/16xf16 vector datapath.
   ///
-  /// For now, we just assume hwVectorSize has the proper information regardless
-  /// of the type and we assert everything is f32.
-  /// TODO(ntv): relax the assumptions on admissible element type once a
-  /// contract exists.
+  /// For now, a non-empty hwVectorSize is used regardless of the type. An empty
+  /// hwVectorSize selects the 1-D vector that fills a vector register of the
+  /// target (see getHWVectorType).
   MaterializationState(SmallVector<int64_t, 8> sizes) : hwVectorSize(sizes) {}
 
   SmallVector<int64_t, 8> hwVectorSize;
@@ -201,6 +203,19 @@ struct MaterializeVectorsPass : public FunctionPass<MaterializeVectorsPass> {
 
 } // end anonymous namespace
 
+/// Returns the hardware vector type used to materialize super-vectors of
+/// `elementType`. A non-empty `hwVectorSize` is honored as is; otherwise the
+/// vector has as many elements as fit in a vector register of the target.
+static VectorType getHWVectorType(ArrayRef<int64_t> hwVectorSize,
+                                  Type elementType) {
+  if (!hwVectorSize.empty())
+    return VectorType::get(hwVectorSize, elementType);
+  unsigned widthBits = TargetMemoryModel::getDefault().getVectorWidth() * 8;
+  unsigned elementBits = elementType.getIntOrFloatBitWidth();
+  int64_t numElements = std::max(1u, widthBits / elementBits);
+  return VectorType::get({numElements}, elementType);
+}
+
 /// Given a shape with sizes greater than 0 along all dimensions,
 /// returns the distance, in number of elements, between a slice in a dimension
 /// and the next slice in the same dimension.
@@ -250,10 +265,14 @@ static Operation *instantiate(FuncBuilder *b, Operation *opInst,
 /// insertion.
 /// For now, this is limited to ConstantOp because we do not vectorize loop
 /// indices and will need to be extended in the future.
+/// The scalars, e.g. the operand of a vector.broadcast, are the same for all
+/// the hardware vectors and are used as is.
 ///
 /// If substitution fails, returns nullptr.
 static Value *substitute(Value *v, VectorType hwVectorType,
                          DenseMap<Value *, Value *> *substitutionsMap) {
+  if (!v->getType().isa<VectorType>())
+    return v;
   auto it = substitutionsMap->find(v);
   if (it == substitutionsMap->end()) {
     auto *opInst = v->getDefiningOp();
@@ -657,8 +676,7 @@ static bool emitSlice(MaterializationState *state,
 ///   2. collect all the operations that can be reached by transitive use-defs
 ///      chains;
 ///   3. get the superVectorType for this particular terminator and the
-///      corresponding hardware vector type (for now limited to F32)
-///      TODO(ntv): be more general than F32.
+///      corresponding hardware vector type for its elemental type;
 ///   4. emit the transitive useDef set to operate on the finer-grain vector
 ///      types.
 ///
@@ -713,10 +731,7 @@ static bool materialize(Function *f, const SetVector<Operation *> &terminators,
     // Emit the current slice.
     // Set scoped super-vector and corresponding hw vector types.
     state->superVectorType = terminator.getVectorType();
-    assert((state->superVectorType.getElementType() ==
-            FloatType::getF32(term->getContext())) &&
-           "Only f32 supported for now");
-    state->hwVectorType = VectorType::get(
+    state->hwVectorType = getHWVectorType(
         state->hwVectorSize, state->superVectorType.getElementType());
     auto fail = emitSlice(state, &slice);
     if (fail) {
@@ -742,17 +757,19 @@ void MaterializeVectorsPass::runOnFunction() {
   LLVM_DEBUG(f->print(dbgs()));
 
   MaterializationState state(hwVectorSize);
-  // Get the hardware vector type.
-  // TODO(ntv): get elemental type from super-vector type rather than force f32.
-  auto subVectorType =
-      VectorType::get(hwVectorSize, FloatType::getF32(&getContext()));
 
   // Capture terminators; i.e. vector.transfer_write ops involving a strict
-  // super-vector of subVectorType.
-  auto filter = [subVectorType](Operation &op) {
-    if (!op.isa<VectorTransferWriteOp>()) {
+  // super-vector of the hardware vector type for their elemental type. Writes
+  // whose super-vector is not an integer multiple of that type are left as is.
+  auto filter = [this](Operation &op) {
+    auto write = op.dyn_cast<VectorTransferWriteOp>();
+    if (!write)
+      return false;
+    auto superVectorType = write.getVectorType();
+    auto subVectorType =
+        getHWVectorType(hwVectorSize, superVectorType.getElementType());
+    if (!shapeRatio(superVectorType, subVectorType).hasValue())
       return false;
-    }
     return matcher::operatesOnSuperVectorsOf(op, subVectorType);
   };
   auto pat = Op(filter);
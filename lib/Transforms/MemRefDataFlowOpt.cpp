@@ -15,11 +15,12 @@
 // limitations under the License.
 // =============================================================================
 //
-// This file implements a pass to forward memref stores to loads, thereby
-// potentially getting rid of intermediate memref's entirely.
-// TODO(mlir-team): In the future, similar techniques could be used to eliminate
-// dead memref store's and perform more complex forwarding when support for
-// SSA scalars live out of 'affine.for'/'affine.if' statements is available.
+// This file implements a pass to forward memref stores to loads, to eliminate
+// redundant loads and dead stores, thereby potentially getting rid of
+// intermediate memref's entirely.
+// TODO(mlir-team): In the future, similar techniques could be used to perform
+// more complex forwarding when support for SSA scalars live out of
+// 'affine.for'/'affine.if' statements is available.
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/AffineAnalysis.h"
@@ -28,7 +29,6 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/StandardOps/Ops.h"
 #include "mlir/Transforms/Passes.h"
-#include "llvm/ADT/SmallPtrSet.h"
 #include <algorithm>
 
 #define DEBUG_TYPE "memref-dataflow-opt"
@@ -63,21 +63,29 @@ namespace {
 // condition (2) is a sufficient one but not necessary (since it doesn't reason
 // about loops that are guaranteed to execute at least once).
 //
+// Loads that couldn't be forwarded a stored value are then replaced by an
+// earlier load of the same element if that load dominates them and no store in
+// between may write to that element. Finally, a store is erased if a later
+// store in the same block overwrites the same element before anything may read
+// it. These two are only performed on memref's allocated in the function whose
+// only uses are loads, stores, and a dealloc, so that no other memref may alias
+// them.
+//
 // TODO(mlir-team): more forwarding can be done when support for
 // loop/conditional live-out SSA values is available.
-// TODO(mlir-team): do general dead store elimination for memref's. This pass
-// currently only eliminates the stores only if no other loads/uses (other
-// than dealloc) remain.
 //
 struct MemRefDataFlowOpt : public FunctionPass<MemRefDataFlowOpt> {
   void runOnFunction() override;
 
   void forwardStoreToLoad(LoadOp loadOp);
+  void eliminateRedundantLoad(LoadOp loadOp);
+  void eliminateDeadStore(StoreOp storeOp);
 
-  // A list of memref's that are potentially dead / could be eliminated.
-  SmallPtrSet<Value *, 4> memrefsToErase;
-  // Load op's whose results were replaced by those forwarded from stores.
+  // Load op's whose results were replaced by those forwarded from stores or
+  // by those of earlier loads.
   std::vector<Operation *> loadOpsToErase;
+  // Store op's overwritten before being read.
+  std::vector<Operation *> storeOpsToErase;
 
   DominanceInfo *domInfo = nullptr;
   PostDominanceInfo *postDomInfo = nullptr;
@@ -203,12 +211,62 @@ void MemRefDataFlowOpt::forwardStoreToLoad(LoadOp loadOp) {
   // Perform the actual store to load forwarding.
   Value *storeVal = lastWriteStoreOp->cast<StoreOp>().getValueToStore();
   loadOp.getResult()->replaceAllUsesWith(storeVal);
-  // Record the memref for a later sweep to optimize away.
-  memrefsToErase.insert(loadOp.getMemRef());
   // Record this to erase later.
   loadOpsToErase.push_back(loadOpInst);
 }
 
+// Replaces the load with an earlier one from the same memref element that
+// dominates it, provided no store executing in between may write to that
+// element.
+void MemRefDataFlowOpt::eliminateRedundantLoad(LoadOp loadOp) {
+  Operation *loadOpInst = loadOp.getOperation();
+  Value *memref = loadOp.getMemRef();
+  if (!isLocalMemRef(memref))
+    return;
+
+  for (auto &use : memref->getUses()) {
+    auto *srcOpInst = use.getOwner();
+    if (srcOpInst == loadOpInst || !srcOpInst->isa<LoadOp>() ||
+        llvm::is_contained(loadOpsToErase, srcOpInst))
+      continue;
+    if (!domInfo->dominates(srcOpInst, loadOpInst) ||
+        !haveSameMemRefAccess(srcOpInst, loadOpInst) ||
+        isWrittenBetween(srcOpInst, loadOpInst))
+      continue;
+
+    loadOp.getResult()->replaceAllUsesWith(srcOpInst->getResult(0));
+    loadOpsToErase.push_back(loadOpInst);
+    return;
+  }
+}
+
+// Erases the store if a later store in the same block writes to the same
+// memref element before anything may read it.
+void MemRefDataFlowOpt::eliminateDeadStore(StoreOp storeOp) {
+  Operation *storeOpInst = storeOp.getOperation();
+  Value *memref = storeOp.getMemRef();
+  if (!isLocalMemRef(memref))
+    return;
+
+  unsigned storeLoopDepth = getNestingDepth(*storeOpInst);
+  for (auto it = std::next(Block::iterator(storeOpInst)),
+            e = storeOpInst->getBlock()->end();
+       it != e; ++it) {
+    if (it->isa<StoreOp>() && haveSameMemRefAccess(storeOpInst, &*it)) {
+      storeOpsToErase.push_back(storeOpInst);
+      return;
+    }
+    bool isRead = false;
+    it->walk([&](Operation *opInst) {
+      if (!isRead && opInst->isa<LoadOp>() &&
+          opInst->cast<LoadOp>().getMemRef() == memref)
+        isRead = hasMemRefDependence(storeOpInst, opInst, storeLoopDepth);
+    });
+    if (isRead)
+      return;
+  }
+}
+
 void MemRefDataFlowOpt::runOnFunction() {
   // Only supports single block functions at the moment.
   Function &f = getFunction();
@@ -221,35 +279,50 @@ void MemRefDataFlowOpt::runOnFunction() {
   postDomInfo = &getAnalysis<PostDominanceInfo>();
 
   loadOpsToErase.clear();
-  memrefsToErase.clear();
+  storeOpsToErase.clear();
 
   // Walk all load's and perform load/store forwarding.
-  f.walk<LoadOp>([&](LoadOp loadOp) { forwardStoreToLoad(loadOp); });
+  f.walk([&](LoadOp loadOp) { forwardStoreToLoad(loadOp); });
 
   // Erase all load op's whose results were replaced with store fwd'ed ones.
   for (auto *loadOp : loadOpsToErase) {
     loadOp->erase();
   }
+  loadOpsToErase.clear();
 
-  // Check if the store fwd'ed memrefs are now left with only stores and can
-  // thus be completely deleted. Note: the canononicalize pass should be able
-  // to do this as well, but we'll do it here since we collected these anyway.
-  for (auto *memref : memrefsToErase) {
-    // If the memref hasn't been alloc'ed in this function, skip.
-    Operation *defInst = memref->getDefiningOp();
-    if (!defInst || !defInst->isa<AllocOp>())
-      // TODO(mlir-team): if the memref was returned by a 'call' operation, we
-      // could still erase it if the call had no side-effects.
-      continue;
-    if (std::any_of(memref->use_begin(), memref->use_end(),
-                    [&](OpOperand &use) {
-                      auto *ownerInst = use.getOwner();
-                      return (!ownerInst->isa<StoreOp>() &&
-                              !ownerInst->isa<DeallocOp>());
-                    }))
-      continue;
+  // Replace the remaining loads with earlier ones from the same location.
+  f.walk([&](LoadOp loadOp) { eliminateRedundantLoad(loadOp); });
+  for (auto *loadOp : loadOpsToErase) {
+    loadOp->erase();
+  }
+
+  // Erase stores that are overwritten before being read.
+  f.walk([&](StoreOp storeOp) { eliminateDeadStore(storeOp); });
+  for (auto *storeOp : storeOpsToErase) {
+    storeOp->erase();
+  }
+
+  // Check if the memrefs allocated in this function are now left with only
+  // stores and can thus be completely deleted. Note: the canononicalize pass
+  // should be able to do this as well, but we'll do it here since the above
+  // typically leaves such memrefs behind.
+  // TODO(mlir-team): if the memref was returned by a 'call' operation, we
+  // could still erase it if the call had no side-effects.
+  SmallVector<Operation *, 4> deadAllocs;
+  f.walk([&](AllocOp allocOp) {
+    Value *memref = allocOp.getResult();
+    if (llvm::all_of(memref->getUses(), [&](OpOperand &use) {
+          auto *ownerInst = use.getOwner();
+          if (auto storeOp = ownerInst->dyn_cast<StoreOp>())
+            return storeOp.getValueToStore() != memref;
+          return ownerInst->isa<DeallocOp>();
+        }))
+      deadAllocs.push_back(allocOp.getOperation());
+  });
 
+  for (auto *defInst : deadAllocs) {
     // Erase all stores, the dealloc, and the alloc on the memref.
+    Value *memref = defInst->getResult(0);
     for (auto &use : llvm::make_early_inc_range(memref->getUses()))
       use.getOwner()->erase();
     defInst->erase();
@@ -257,4 +330,6 @@ void MemRefDataFlowOpt::runOnFunction() {
 }
 
 static PassRegistration<MemRefDataFlowOpt>
-    pass("memref-dataflow-opt", "Perform store/load forwarding for memrefs");
+    pass("memref-dataflow-opt",
+         "Perform store/load forwarding, redundant load and dead store "
+         "elimination for memrefs");
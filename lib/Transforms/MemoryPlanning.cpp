@@ -0,0 +1,236 @@
+//===- MemoryPlanning.cpp - Static memory planning ------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass placing the statically shaped buffers allocated
+// in a function in arenas, one per element type and memory space, allocated
+// once at the entry of the function.  The buffers that are never live at the
+// same time share the same part of their arena.  Their 'alloc's are replaced
+// by 'view's of the arena with a strided layout whose offset is the position
+// of the buffer in the arena, and their 'dealloc's are dropped.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/MemRefLiveness.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "mlir/VectorOps/VectorOps.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+
+#define DEBUG_TYPE "plan-memory"
+
+using namespace mlir;
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clAlignment(
+    "plan-memory-alignment",
+    llvm::cl::desc("Minimum alignment in bytes of the buffers placed in an "
+                   "arena (default: the alignment of their elements)"),
+    llvm::cl::init(0), llvm::cl::cat(clOptionsCategory));
+
+namespace {
+// A buffer placed in an arena.
+struct Buffer {
+  AllocOp allocOp;
+  // The size of the buffer and the alignment of its offset, in elements.
+  int64_t numElements;
+  int64_t alignment;
+  // The position of the buffer in the arena, in elements.
+  int64_t offset;
+};
+
+struct MemoryPlanning : public FunctionPass<MemoryPlanning> {
+  void runOnFunction() override;
+};
+} // end anonymous namespace
+
+// Return true if the buffer of 'allocOp' can be placed in an arena: it must be
+// statically shaped with the identity layout, have a known live range, and
+// only be accessed by operations that cannot let it escape.
+static bool canPlan(AllocOp allocOp, const MemRefLiveness &liveness) {
+  MemRefType type = allocOp.getType();
+  if (!type.hasStaticShape() || !type.getAffineMaps().empty() ||
+      !getMemRefSizeInBytes(type) || !liveness.getLiveRange(allocOp))
+    return false;
+  if (auto alignment =
+          allocOp.getOperation()->getAttrOfType<IntegerAttr>("alignment"))
+    if (alignment.getInt() <= 0 || !llvm::isPowerOf2_64(alignment.getInt()))
+      return false;
+  // The element types of the memrefs are never memrefs, so the buffer is the
+  // memref accessed by each of these.
+  return llvm::all_of(allocOp.getResult()->getUses(), [](OpOperand &use) {
+    Operation *user = use.getOwner();
+    return user->isa<LoadOp>() || user->isa<StoreOp>() ||
+           user->isa<DimOp>() || user->isa<DeallocOp>() ||
+           user->isa<DmaStartOp>() || user->isa<DmaWaitOp>() ||
+           user->isa<VectorTransferReadOp>() ||
+           user->isa<VectorTransferWriteOp>();
+  });
+}
+
+// Assign to each of 'buffers' the lowest offset at which it doesn't overlap
+// the buffers placed before it that may be live at the same time, placing the
+// largest buffers first.  Returns the size of the arena, in elements.
+static int64_t placeBuffers(MutableArrayRef<Buffer> buffers,
+                            const MemRefLiveness &liveness) {
+  SmallVector<Buffer *, 8> order;
+  for (Buffer &buffer : buffers)
+    order.push_back(&buffer);
+  std::stable_sort(order.begin(), order.end(),
+                   [](const Buffer *lhs, const Buffer *rhs) {
+                     return lhs->numElements > rhs->numElements;
+                   });
+
+  int64_t arenaSize = 0;
+  SmallVector<Buffer *, 8> placed, interfering;
+  for (Buffer *buffer : order) {
+    interfering.clear();
+    for (Buffer *other : placed)
+      if (liveness.mayInterfere(buffer->allocOp, other->allocOp))
+        interfering.push_back(other);
+    std::sort(interfering.begin(), interfering.end(),
+              [](const Buffer *lhs, const Buffer *rhs) {
+                return lhs->offset < rhs->offset;
+              });
+
+    // Find the first gap between the interfering buffers large enough.
+    int64_t offset = 0;
+    for (Buffer *other : interfering) {
+      if (offset + buffer->numElements <= other->offset)
+        break;
+      offset = std::max<int64_t>(
+          offset, llvm::alignTo(other->offset + other->numElements,
+                                buffer->alignment));
+    }
+    buffer->offset = offset;
+    placed.push_back(buffer);
+    arenaSize = std::max(arenaSize, offset + buffer->numElements);
+  }
+  return arenaSize;
+}
+
+// Allocate an arena of 'arenaSize' elements of 'elementType' in 'memorySpace'
+// with 'builder', aligned to 'alignment' bytes if it is not zero, and free it
+// before each return of 'function'.  Replace the buffers by views of the arena
+// at their offsets.
+static void createArena(Function &function, FuncBuilder &builder,
+                        Type elementType, unsigned memorySpace,
+                        int64_t arenaSize, uint64_t alignment,
+                        ArrayRef<Buffer> buffers) {
+  auto arenaType =
+      MemRefType::get({arenaSize}, elementType, /*affineMapComposition=*/{},
+                      memorySpace);
+  auto arena = builder.create<AllocOp>(function.getLoc(), arenaType);
+  if (alignment != 0)
+    arena.getOperation()->setAttr("alignment",
+                                  builder.getI64IntegerAttr(alignment));
+
+  for (Block &block : function.getBody())
+    if (auto returnOp = block.getTerminator()->dyn_cast<ReturnOp>())
+      FuncBuilder(returnOp.getOperation())
+          .create<DeallocOp>(returnOp.getLoc(), arena.getResult());
+
+  for (const Buffer &buffer : buffers) {
+    Operation *allocInst = buffer.allocOp.getOperation();
+    MemRefType type = buffer.allocOp.getType();
+    MemRefType viewType = type;
+    if (buffer.offset != 0) {
+      SmallVector<int64_t, 4> strides;
+      int64_t offset;
+      (void)getStridesAndOffset(type, strides, offset);
+      auto layout = makeStridedLinearLayoutMap(strides, buffer.offset,
+                                               function.getContext());
+      viewType = MemRefType::get(type.getShape(), elementType, layout,
+                                 memorySpace);
+    }
+    LLVM_DEBUG(llvm::dbgs() << "placing " << type << " at offset "
+                            << buffer.offset << " of the arena " << arenaType
+                            << "\n");
+
+    Value *memref = buffer.allocOp.getResult();
+    for (auto &use : llvm::make_early_inc_range(memref->getUses()))
+      if (use.getOwner()->isa<DeallocOp>())
+        use.getOwner()->erase();
+    auto view = FuncBuilder(allocInst).create<ViewOp>(
+        allocInst->getLoc(), arena.getResult(), viewType);
+    memref->replaceAllUsesWith(view.getResult());
+    allocInst->erase();
+  }
+}
+
+void MemoryPlanning::runOnFunction() {
+  Function &function = getFunction();
+  auto &liveness = getAnalysis<MemRefLiveness>();
+
+  // Group the buffers by element type and memory space, along with the largest
+  // alignment in bytes they require.
+  using ArenaKey = std::pair<Type, unsigned>;
+  llvm::MapVector<ArenaKey, SmallVector<Buffer, 8>> arenas;
+  llvm::DenseMap<ArenaKey, uint64_t> arenaAlignments;
+  function.walk([&](AllocOp allocOp) {
+    if (!canPlan(allocOp, liveness))
+      return;
+    MemRefType type = allocOp.getType();
+    uint64_t alignment = clAlignment;
+    if (auto attr =
+            allocOp.getOperation()->getAttrOfType<IntegerAttr>("alignment"))
+      alignment = std::max<uint64_t>(alignment, attr.getInt());
+
+    // The offsets of the buffers are in elements, which the arena is aligned
+    // to anyway: only align them to the remainder of the alignment.
+    uint64_t elementSize =
+        getMemRefSizeInBytes(MemRefType::get({}, type.getElementType()))
+            .getValue();
+    int64_t offsetAlignment =
+        alignment == 0
+            ? 1
+            : alignment / llvm::GreatestCommonDivisor64(alignment, elementSize);
+
+    ArenaKey key(type.getElementType(), type.getMemorySpace());
+    arenas[key].push_back({allocOp, type.getNumElements(), offsetAlignment, 0});
+    arenaAlignments[key] = std::max(arenaAlignments[key], alignment);
+  });
+
+  if (arenas.empty()) {
+    markAllAnalysesPreserved();
+    return;
+  }
+
+  // The arenas are allocated at the entry of the function, in order.
+  Block &entryBlock = function.getBody().front();
+  FuncBuilder builder(&entryBlock, entryBlock.begin());
+  for (auto &arena : arenas) {
+    int64_t arenaSize = placeBuffers(arena.second, liveness);
+    createArena(function, builder, arena.first.first, arena.first.second,
+                arenaSize, arenaAlignments[arena.first], arena.second);
+  }
+}
+
+FunctionPassBase *mlir::createMemoryPlanningPass() {
+  return new MemoryPlanning();
+}
+
+static PassRegistration<MemoryPlanning>
+    pass("plan-memory", "Place the statically shaped buffers of functions in "
+                        "arenas allocated once per function");
@@ -0,0 +1,338 @@
+//===- OutlineGPUKernels.cpp - Outline parallel loops into GPU kernels ----===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that maps the outermost bands of perfectly nested
+// parallel 'affine.for' operations to the grids of GPU kernels.  The innermost
+// loop of a band of up to three loops is mapped to the x dimension of the grid,
+// the next one to y and the outermost one to z.  The body of the band is
+// outlined into a kernel function, marked with the "gpu.kernel" attribute,
+// which executes one iteration of the band per GPU thread: it computes the
+// induction variables from the block and thread ids, which it gets by calling
+// the mlir_gpu_* functions of the GPU runtime, and skips the threads past the
+// upper bounds.
+//
+// The band is replaced by a call to the kernel taking the lower and upper
+// bounds of each dimension, marked with the "gpu.block_size" and "gpu.step"
+// attributes.  The conversion to the LLVM IR dialect turns it into a launch of
+// the kernel over a grid covering the iteration space, through the GPU runtime
+// of the ExecutionEngine.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "outline-gpu-kernels"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clGPUBlockSize(
+    "gpu-block-size",
+    llvm::cl::desc("Number of threads of the blocks of the GPU kernels along "
+                   "their x dimension (default 128)"),
+    llvm::cl::init(128), llvm::cl::cat(clOptionsCategory));
+
+/// The maximal number of loops of a band, one per dimension of a GPU grid.
+static constexpr unsigned kMaxGridDims = 3;
+
+/// The suffixes of the names of the dimensions of the GPU grids.
+static const char *const kDimNames[kMaxGridDims] = {"x", "y", "z"};
+
+namespace {
+struct OutlineGPUKernels : public ModulePass<OutlineGPUKernels> {
+  explicit OutlineGPUKernels(Optional<unsigned> blockSize = None)
+      : blockSize(blockSize ? *blockSize : clGPUBlockSize) {}
+
+  void runOnModule() override;
+
+  unsigned blockSize;
+};
+} // end anonymous namespace
+
+// Return true if `value` is defined inside of the regions of `op`.
+static bool isDefinedInside(Value *value, Operation *op) {
+  Operation *ancestor = value->getDefiningOp();
+  if (!ancestor)
+    ancestor = cast<BlockArgument>(value)->getOwner()->getContainingOp();
+  for (; ancestor; ancestor = ancestor->getParentOp())
+    if (ancestor == op)
+      return true;
+  return false;
+}
+
+// Return true if the iterations of `forOp` can be executed by the threads of a
+// GPU kernel.  The kernels can neither call host functions nor allocate
+// memory, and the bounds must be single-result maps so that the iteration
+// range can be passed to the kernel.
+static bool canMapToGPU(AffineForOp forOp) {
+  if (forOp.getLowerBoundMap().getNumResults() != 1 ||
+      forOp.getUpperBoundMap().getNumResults() != 1)
+    return false;
+  bool hasHostOps = false;
+  forOp.getOperation()->walk([&](Operation *op) {
+    if (op->isa<CallOp>() || op->isa<CallIndirectOp>() || op->isa<AllocOp>() ||
+        op->isa<DeallocOp>())
+      hasHostOps = true;
+  });
+  return !hasHostOps && isLoopParallel(forOp);
+}
+
+// Collect in `band` the loops perfectly nested in `forOp`, starting with it,
+// that can be mapped to the dimensions of a grid, outermost first.  The bounds
+// of the inner loops must not depend on the outer loops of the band, so that
+// the grid is rectangular.
+static void getParallelBand(AffineForOp forOp,
+                            SmallVectorImpl<AffineForOp> &band) {
+  Operation *outermost = forOp.getOperation();
+  band.push_back(forOp);
+  while (band.size() < kMaxGridDims) {
+    Block *body = band.back().getBody();
+    if (std::next(body->begin()) != std::prev(body->end()))
+      return;
+    auto inner = body->front().dyn_cast<AffineForOp>();
+    if (!inner || !canMapToGPU(inner))
+      return;
+    for (Value *operand : inner.getOperation()->getOperands())
+      if (isDefinedInside(operand, outermost))
+        return;
+    band.push_back(inner);
+  }
+}
+
+// Collect the outermost bands of loops that can be mapped to GPU grids in
+// `block`, looking into the regions of the operations that are kept.
+static void collectOutermostParallelBands(
+    Block &block, SmallVectorImpl<SmallVector<AffineForOp, 3>> &bands) {
+  for (Operation &op : block) {
+    if (auto forOp = op.dyn_cast<AffineForOp>()) {
+      if (canMapToGPU(forOp)) {
+        bands.emplace_back();
+        getParallelBand(forOp, bands.back());
+        continue;
+      }
+    }
+    for (unsigned i = 0, e = op.getNumRegions(); i < e; ++i)
+      for (Block &nested : op.getRegion(i))
+        collectOutermostParallelBands(nested, bands);
+  }
+}
+
+// Get the function of the GPU runtime returning the id named `name` along the
+// given dimension, declaring it in `module` the first time it is requested.
+static Function *getOrInsertIdFunction(Module *module, StringRef name,
+                                       unsigned dim) {
+  std::string functionName =
+      ("mlir_gpu_" + name + "_" + kDimNames[dim]).str();
+  if (Function *function = module->getNamedFunction(functionName))
+    return function;
+  MLIRContext *context = module->getContext();
+  auto *function =
+      new Function(UnknownLoc::get(context), functionName,
+                   FunctionType::get({}, IndexType::get(context), context));
+  module->addFunction(function);
+  return function;
+}
+
+// Outline `band` into a kernel function inserted after the function
+// containing it, and replace it with a call launching the kernel with blocks of
+// `blockSize` threads along x.  The kernel takes the lower and upper bounds of
+// the loops of the band, innermost first, followed by the values defined above
+// the band and used inside of it.  Constants are cloned into the kernel
+// instead.
+static void outlineBand(ArrayRef<AffineForOp> band, unsigned blockSize,
+                        unsigned index) {
+  AffineForOp outermost = band.front();
+  Operation *outermostInst = outermost.getOperation();
+  Function *function = outermostInst->getFunction();
+  Module *module = function->getModule();
+  MLIRContext *context = outermostInst->getContext();
+  auto loc = outermost.getLoc();
+  unsigned numDims = band.size();
+
+  // The loops of the band, in the order of the dimensions of the grid.
+  SmallVector<AffineForOp, 3> dims(band.rbegin(), band.rend());
+
+  // Collect the values that the body of the band uses from above.
+  Block *oldBody = band.back().getBody();
+  llvm::SetVector<Value *> captures;
+  for (Operation &bodyOp : *oldBody) {
+    bodyOp.walk([&](Operation *op) {
+      for (Value *operand : op->getOperands())
+        if (!isDefinedInside(operand, outermostInst))
+          captures.insert(operand);
+    });
+  }
+
+  // Create the kernel, with a unique name.
+  auto indexType = IndexType::get(context);
+  SmallVector<Type, 8> argTypes(2 * numDims, indexType);
+  SmallVector<Value *, 8> capturedArgs;
+  SmallVector<Operation *, 4> capturedConstants;
+  for (Value *capture : captures) {
+    Operation *def = capture->getDefiningOp();
+    if (def && def->isa<ConstantOp>()) {
+      capturedConstants.push_back(def);
+      continue;
+    }
+    capturedArgs.push_back(capture);
+    argTypes.push_back(capture->getType());
+  }
+  std::string name;
+  do {
+    name = (function->getName().strref() + "_kernel_" + Twine(index++)).str();
+  } while (module->getNamedFunction(name));
+  auto *kernel =
+      new Function(loc, name, FunctionType::get(argTypes, {}, context));
+  kernel->setAttr("gpu.kernel", BoolAttr::get(true, context));
+  module->getFunctions().insert(std::next(Module::iterator(function)), kernel);
+  kernel->addEntryBlock();
+  Block *entryBlock = &kernel->front();
+  FuncBuilder builder(entryBlock);
+
+  // Map the values used from above to the arguments of the kernel or to the
+  // cloned constants.
+  llvm::DenseMap<Value *, Value *> mapping;
+  for (auto indexedArg : llvm::enumerate(capturedArgs))
+    mapping[indexedArg.value()] =
+        entryBlock->getArgument(2 * numDims + indexedArg.index());
+  for (Operation *constant : capturedConstants)
+    mapping[constant->getResult(0)] = builder.clone(*constant)->getResult(0);
+
+  // Compute the induction variable of each dimension from the global id of
+  // the thread along it:
+  //   iv = (blockId * blockDim + threadId) * step + lowerBound.
+  SmallVector<Value *, 3> ivs, upperBounds;
+  for (unsigned dim = 0; dim < numDims; ++dim) {
+    auto getId = [&](StringRef idName) {
+      Function *idFunction = getOrInsertIdFunction(module, idName, dim);
+      return builder.create<CallOp>(loc, idFunction, ArrayRef<Value *>())
+          .getResult(0);
+    };
+    Value *blockId = getId("block_id");
+    Value *blockDim = getId("block_dim");
+    Value *threadId = getId("thread_id");
+    Value *blockOffset =
+        builder.create<MulIOp>(loc, blockId, blockDim).getResult();
+    Value *globalId =
+        builder.create<AddIOp>(loc, blockOffset, threadId).getResult();
+    auto ivMap = builder.getAffineMap(
+        0, 2,
+        builder.getAffineSymbolExpr(0) * dims[dim].getStep() +
+            builder.getAffineSymbolExpr(1),
+        {});
+    Value *lowerBound = entryBlock->getArgument(2 * dim);
+    ivs.push_back(builder
+                      .create<AffineApplyOp>(
+                          loc, ivMap, ArrayRef<Value *>{globalId, lowerBound})
+                      .getResult());
+    upperBounds.push_back(entryBlock->getArgument(2 * dim + 1));
+    dims[dim].getInductionVar()->replaceAllUsesWith(ivs.back());
+  }
+
+  // Guard the body with the upper bounds, (d_i)[s_i] : (s_i - d_i - 1 >= 0),
+  // since the grid may have more threads than the band has iterations.
+  SmallVector<AffineExpr, 3> constraints;
+  for (unsigned dim = 0; dim < numDims; ++dim)
+    constraints.push_back(builder.getAffineSymbolExpr(dim) -
+                          builder.getAffineDimExpr(dim) - 1);
+  SmallVector<Value *, 6> conditionOperands(ivs.begin(), ivs.end());
+  conditionOperands.append(upperBounds.begin(), upperBounds.end());
+  auto ifOp = builder.create<AffineIfOp>(
+      loc,
+      builder.getIntegerSet(numDims, numDims, constraints,
+                            SmallVector<bool, 3>(numDims, false)),
+      conditionOperands);
+  builder.create<ReturnOp>(loc);
+
+  // Move the body of the band into the guard and remap the values used from
+  // above.
+  Block *thenBlock = &ifOp.getThenBlocks().front();
+  thenBlock->getOperations().splice(std::prev(thenBlock->end()),
+                                    oldBody->getOperations(), oldBody->begin(),
+                                    std::prev(oldBody->end()));
+  ifOp.getOperation()->walk([&](Operation *op) {
+    for (unsigned i = 0, e = op->getNumOperands(); i < e; ++i) {
+      auto it = mapping.find(op->getOperand(i));
+      if (it != mapping.end())
+        op->setOperand(i, it->second);
+    }
+  });
+
+  // Replace the band with a call launching the kernel over its iteration
+  // space.
+  FuncBuilder callBuilder(outermostInst);
+  SmallVector<Value *, 8> callOperands;
+  SmallVector<Attribute, 3> blockSizes, steps;
+  for (unsigned dim = 0; dim < numDims; ++dim) {
+    AffineForOp forOp = dims[dim];
+    SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
+    callOperands.push_back(makeComposedAffineApply(&callBuilder, loc,
+                                                   forOp.getLowerBoundMap(),
+                                                   lbOperands)
+                               .getResult());
+    SmallVector<Value *, 4> ubOperands(forOp.getUpperBoundOperands());
+    callOperands.push_back(makeComposedAffineApply(&callBuilder, loc,
+                                                   forOp.getUpperBoundMap(),
+                                                   ubOperands)
+                               .getResult());
+    blockSizes.push_back(callBuilder.getI64IntegerAttr(dim == 0 ? blockSize
+                                                                : 1));
+    steps.push_back(callBuilder.getI64IntegerAttr(forOp.getStep()));
+  }
+  callOperands.append(capturedArgs.begin(), capturedArgs.end());
+  auto call = callBuilder.create<CallOp>(loc, kernel, callOperands);
+  call.getOperation()->setAttr("gpu.block_size",
+                               callBuilder.getArrayAttr(blockSizes));
+  call.getOperation()->setAttr("gpu.step", callBuilder.getArrayAttr(steps));
+  outermost.erase();
+}
+
+void OutlineGPUKernels::runOnModule() {
+  // Collect the bands first, since outlining adds new functions to the module.
+  llvm::MapVector<Function *, SmallVector<SmallVector<AffineForOp, 3>, 4>>
+      bandsPerFunction;
+  for (Function &function : getModule())
+    for (Block &block : function)
+      collectOutermostParallelBands(block, bandsPerFunction[&function]);
+
+  for (auto &functionBands : bandsPerFunction) {
+    unsigned index = 0;
+    for (auto &band : functionBands.second)
+      outlineBand(band, blockSize, index++);
+  }
+}
+
+/// Creates a pass outlining the outermost bands of parallel loops into GPU
+/// kernels launched over grids covering their iteration spaces.
+ModulePassBase *mlir::createOutlineGPUKernelsPass(int blockSize) {
+  return new OutlineGPUKernels(blockSize == -1 ? None
+                                               : Optional<unsigned>(blockSize));
+}
+
+static PassRegistration<OutlineGPUKernels>
+    pass("outline-gpu-kernels",
+         "Outline the outermost bands of parallel loops into GPU kernels");
@@ -0,0 +1,213 @@
+//===- OutlineParallelLoops.cpp - Outline parallel loops into functions ---===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that outlines the outermost parallel
+// 'affine.for' operations into functions taking the bounds of the iteration
+// range to execute, so that the iterations can be distributed over several
+// threads.  The loop is replaced by a call to the outlined function covering
+// the whole iteration range, marked with the "parallel.step" attribute.  The
+// call is semantically equivalent to the original loop, and it is lowered to a
+// call to the parallel runtime of the ExecutionEngine by the conversion to the
+// LLVM IR dialect.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/Analysis/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+
+using namespace mlir;
+
+namespace {
+struct OutlineParallelLoops : public ModulePass<OutlineParallelLoops> {
+  void runOnModule() override;
+};
+} // end anonymous namespace
+
+// Return true if `value` is defined inside of the regions of `op`.
+static bool isDefinedInside(Value *value, Operation *op) {
+  Operation *ancestor = value->getDefiningOp();
+  if (!ancestor)
+    ancestor = cast<BlockArgument>(value)->getOwner()->getContainingOp();
+  for (; ancestor; ancestor = ancestor->getParentOp())
+    if (ancestor == op)
+      return true;
+  return false;
+}
+
+// Return true if `forOp` can be executed by several threads.  The dependence
+// analysis only reasons about loads and stores, so the loops containing calls
+// are conservatively kept sequential.  The bounds must be single-result maps
+// so that the iteration range can be passed to the outlined function.
+static bool canOutline(AffineForOp forOp) {
+  if (forOp.getLowerBoundMap().getNumResults() != 1 ||
+      forOp.getUpperBoundMap().getNumResults() != 1)
+    return false;
+  bool hasCalls = false;
+  forOp.getOperation()->walk([&](Operation *op) {
+    if (op->isa<CallOp>() || op->isa<CallIndirectOp>())
+      hasCalls = true;
+  });
+  return !hasCalls && isLoopParallel(forOp);
+}
+
+// Collect the outermost loops that can be outlined in `block`, looking into
+// the regions of the operations that are kept.
+static void collectOutermostParallelLoops(Block &block,
+                                          SmallVectorImpl<AffineForOp> &loops) {
+  for (Operation &op : block) {
+    if (auto forOp = op.dyn_cast<AffineForOp>()) {
+      if (canOutline(forOp)) {
+        loops.push_back(forOp);
+        continue;
+      }
+    }
+    for (unsigned i = 0, e = op.getNumRegions(); i < e; ++i)
+      for (Block &nested : op.getRegion(i))
+        collectOutermostParallelLoops(nested, loops);
+  }
+}
+
+// Outline `forOp` into a function inserted after the function containing the
+// loop, and replace the loop with a call to that function.  The outlined
+// function takes the lower and upper bounds of the iteration range, followed by
+// the values defined above the loop and used inside of it.  Constants are
+// cloned into the outlined function instead.
+static void outlineLoop(AffineForOp forOp, unsigned index) {
+  Operation *forInst = forOp.getOperation();
+  Function *function = forInst->getFunction();
+  Module *module = function->getModule();
+  MLIRContext *context = forInst->getContext();
+  auto loc = forOp.getLoc();
+
+  // Collect the values that the body of the loop uses from above.
+  llvm::SetVector<Value *> captures;
+  for (Operation &bodyOp : *forOp.getBody()) {
+    bodyOp.walk([&](Operation *op) {
+      for (Value *operand : op->getOperands())
+        if (!isDefinedInside(operand, forInst))
+          captures.insert(operand);
+    });
+  }
+
+  // Create the outlined function, with a unique name.
+  auto indexType = IndexType::get(context);
+  SmallVector<Type, 8> argTypes(2, indexType);
+  SmallVector<Value *, 8> capturedArgs;
+  SmallVector<Operation *, 4> capturedConstants;
+  for (Value *capture : captures) {
+    Operation *def = capture->getDefiningOp();
+    if (def && def->isa<ConstantOp>()) {
+      capturedConstants.push_back(def);
+      continue;
+    }
+    capturedArgs.push_back(capture);
+    argTypes.push_back(capture->getType());
+  }
+  std::string name;
+  do {
+    name = (function->getName().strref() + "_parallel_" + Twine(index++))
+               .str();
+  } while (module->getNamedFunction(name));
+  auto *outlined =
+      new Function(loc, name, FunctionType::get(argTypes, {}, context));
+  module->getFunctions().insert(std::next(Module::iterator(function)),
+                                outlined);
+  outlined->addEntryBlock();
+  Block *entryBlock = &outlined->front();
+  FuncBuilder builder(entryBlock);
+
+  // Map the values used from above to the arguments of the outlined function
+  // or to the cloned constants.
+  llvm::DenseMap<Value *, Value *> mapping;
+  for (auto indexedArg : llvm::enumerate(capturedArgs))
+    mapping[indexedArg.value()] =
+        entryBlock->getArgument(2 + indexedArg.index());
+  for (Operation *constant : capturedConstants)
+    mapping[constant->getResult(0)] = builder.clone(*constant)->getResult(0);
+
+  // Create a loop over the range passed as arguments, and move the body of the
+  // original loop into it.
+  auto rangeMap = builder.getSymbolIdentityMap();
+  auto newLoop = builder.create<AffineForOp>(
+      loc, entryBlock->getArgument(0), rangeMap, entryBlock->getArgument(1),
+      rangeMap, forOp.getStep());
+  builder.create<ReturnOp>(loc);
+  forOp.getInductionVar()->replaceAllUsesWith(newLoop.getInductionVar());
+  Block *oldBody = forOp.getBody();
+  Block *newBody = newLoop.getBody();
+  newBody->getOperations().splice(std::prev(newBody->end()),
+                                  oldBody->getOperations(), oldBody->begin(),
+                                  std::prev(oldBody->end()));
+  newLoop.getOperation()->walk([&](Operation *op) {
+    for (unsigned i = 0, e = op->getNumOperands(); i < e; ++i) {
+      auto it = mapping.find(op->getOperand(i));
+      if (it != mapping.end())
+        op->setOperand(i, it->second);
+    }
+  });
+
+  // Replace the original loop with a call covering its whole iteration range.
+  FuncBuilder callBuilder(forInst);
+  SmallVector<Value *, 8> callOperands;
+  SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
+  callOperands.push_back(makeComposedAffineApply(&callBuilder, loc,
+                                                 forOp.getLowerBoundMap(),
+                                                 lbOperands)
+                             .getResult());
+  SmallVector<Value *, 4> ubOperands(forOp.getUpperBoundOperands());
+  callOperands.push_back(makeComposedAffineApply(&callBuilder, loc,
+                                                 forOp.getUpperBoundMap(),
+                                                 ubOperands)
+                             .getResult());
+  callOperands.append(capturedArgs.begin(), capturedArgs.end());
+  auto call = callBuilder.create<CallOp>(loc, outlined, callOperands);
+  call.getOperation()->setAttr(
+      "parallel.step", callBuilder.getI64IntegerAttr(forOp.getStep()));
+  forOp.erase();
+}
+
+void OutlineParallelLoops::runOnModule() {
+  // Collect the loops first, since outlining adds new functions to the module.
+  llvm::MapVector<Function *, SmallVector<AffineForOp, 4>> loopsPerFunction;
+  for (Function &function : getModule())
+    for (Block &block : function)
+      collectOutermostParallelLoops(block, loopsPerFunction[&function]);
+
+  for (auto &functionLoops : loopsPerFunction) {
+    unsigned index = 0;
+    for (AffineForOp forOp : functionLoops.second)
+      outlineLoop(forOp, index++);
+  }
+}
+
+/// Creates a pass outlining the outermost parallel loops into functions that
+/// are executed over several threads.
+ModulePassBase *mlir::createOutlineParallelLoopsPass() {
+  return new OutlineParallelLoops();
+}
+
+static PassRegistration<OutlineParallelLoops>
+    pass("outline-parallel-loops",
+         "Outline the outermost parallel loops into functions executed over "
+         "several threads");
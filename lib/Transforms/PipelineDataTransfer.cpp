@@ -23,6 +23,7 @@
 
 #include "mlir/AffineOps/AffineOps.h"
 #include "mlir/Analysis/AffineAnalysis.h"
+#include "mlir/Analysis/AffineStructures.h"
 #include "mlir/Analysis/LoopAnalysis.h"
 #include "mlir/Analysis/Utils.h"
 #include "mlir/IR/Builders.h"
@@ -31,17 +32,36 @@
 #include "mlir/Transforms/LoopUtils.h"
 #include "mlir/Transforms/Utils.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #define DEBUG_TYPE "pipeline-data-transfer"
 
 using namespace mlir;
 
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clNumBuffers(
+    "pipeline-num-buffers",
+    llvm::cl::desc("Number of buffers used for each pipelined data transfer "
+                   "(default: 2, i.e., double buffering)"),
+    llvm::cl::cat(clOptionsCategory));
+
 namespace {
 
 struct PipelineDataTransfer : public FunctionPass<PipelineDataTransfer> {
+  explicit PipelineDataTransfer(Optional<unsigned> numBuffers = None)
+      : numBuffers(numBuffers) {}
+
   void runOnFunction() override;
   void runOnAffineForOp(AffineForOp forOp);
 
+  /// Returns the number of buffers to use for each pipelined transfer.
+  unsigned getNumBuffers() const;
+
+  Optional<unsigned> numBuffers;
+  static const unsigned kDefaultNumBuffers = 2;
+
   std::vector<AffineForOp> forOps;
 };
 
@@ -49,8 +69,17 @@ struct PipelineDataTransfer : public FunctionPass<PipelineDataTransfer> {
 
 /// Creates a pass to pipeline explicit movement of data across levels of the
 /// memory hierarchy.
-FunctionPassBase *mlir::createPipelineDataTransferPass() {
-  return new PipelineDataTransfer();
+FunctionPassBase *mlir::createPipelineDataTransferPass(int numBuffers) {
+  return new PipelineDataTransfer(
+      numBuffers == -1 ? None : Optional<unsigned>(numBuffers));
+}
+
+unsigned PipelineDataTransfer::getNumBuffers() const {
+  if (numBuffers.hasValue())
+    return numBuffers.getValue();
+  if (clNumBuffers.getNumOccurrences() > 0)
+    return clNumBuffers;
+  return kDefaultNumBuffers;
 }
 
 // Returns the position of the tag memref operand given a DMA operation.
@@ -66,33 +95,66 @@ static unsigned getTagMemRefPos(Operation &dmaInst) {
   return 0;
 }
 
-/// Doubles the buffer of the supplied memref on the specified 'affine.for'
-/// operation by adding a leading dimension of size two to the memref.
-/// Replaces all uses of the old memref by the new one while indexing the newly
-/// added dimension by the loop IV of the specified 'affine.for' operation
-/// modulo 2. Returns false if such a replacement cannot be performed.
-static bool doubleBuffer(Value *oldMemRef, AffineForOp forOp) {
+/// Multiplies the buffer of the supplied memref on the specified 'affine.for'
+/// operation by adding a leading dimension of size 'numBuffers' to the memref;
+/// the layout maps of the memref, if any, are extended to map the new
+/// dimension to itself. Replaces all uses of the old memref by the new one
+/// while indexing the newly added dimension by the iteration number of the
+/// specified 'affine.for' operation modulo 'numBuffers'. Returns false if such
+/// a replacement cannot be performed.
+static bool multiBuffer(Value *oldMemRef, AffineForOp forOp,
+                        unsigned numBuffers) {
   auto *forBody = forOp.getBody();
   FuncBuilder bInner(forBody, forBody->begin());
   bInner.setInsertionPoint(forBody, forBody->begin());
 
-  // Doubles the shape with a leading dimension extent of 2.
-  auto doubleShape = [&](MemRefType oldMemRefType) -> MemRefType {
-    // Add the leading dimension in the shape for the double buffer.
+  // Multiplies the shape with a leading dimension extent of 'numBuffers'.
+  auto multiplyShape = [&](MemRefType oldMemRefType) -> MemRefType {
+    // Add the leading dimension in the shape for the multiple buffers.
     ArrayRef<int64_t> oldShape = oldMemRefType.getShape();
     SmallVector<int64_t, 4> newShape(1 + oldMemRefType.getRank());
-    newShape[0] = 2;
+    newShape[0] = numBuffers;
     std::copy(oldShape.begin(), oldShape.end(), newShape.begin() + 1);
+
+    // Shift the dimensions of each layout map to make room for the leading
+    // dimension, which is mapped to itself.
+    SmallVector<AffineMap, 2> newLayout;
+    for (auto map : oldMemRefType.getAffineMaps()) {
+      SmallVector<AffineExpr, 4> dimReplacements;
+      for (unsigned d = 0, e = map.getNumDims(); d < e; ++d)
+        dimReplacements.push_back(bInner.getAffineDimExpr(d + 1));
+      auto shiftedMap = map.replaceDimsAndSymbols(
+          dimReplacements, {}, map.getNumDims() + 1, /*numResultSyms=*/0);
+      SmallVector<AffineExpr, 4> results = {bInner.getAffineDimExpr(0)};
+      results.append(shiftedMap.getResults().begin(),
+                     shiftedMap.getResults().end());
+      SmallVector<AffineExpr, 4> rangeSizes;
+      if (map.isBounded()) {
+        rangeSizes.push_back(bInner.getAffineConstantExpr(numBuffers));
+        rangeSizes.append(map.getRangeSizes().begin(),
+                          map.getRangeSizes().end());
+      }
+      newLayout.push_back(bInner.getAffineMap(
+          map.getNumDims() + 1, /*symbolCount=*/0, results, rangeSizes));
+    }
     auto newMemRefType =
-        bInner.getMemRefType(newShape, oldMemRefType.getElementType(), {},
-                             oldMemRefType.getMemorySpace());
+        bInner.getMemRefType(newShape, oldMemRefType.getElementType(),
+                             newLayout, oldMemRefType.getMemorySpace());
     return newMemRefType;
   };
 
   auto oldMemRefType = oldMemRef->getType().cast<MemRefType>();
-  auto newMemRefType = doubleShape(oldMemRefType);
+  // Layout maps with symbols would need their symbolic operands for the new
+  // alloc.
+  for (auto map : oldMemRefType.getAffineMaps()) {
+    if (map.getNumSymbols() > 0) {
+      LLVM_DEBUG(llvm::dbgs() << "can't multi-buffer: symbolic layout map\n";);
+      return false;
+    }
+  }
+  auto newMemRefType = multiplyShape(oldMemRefType);
 
-  // The double buffer is allocated right before 'forInst'.
+  // The multiple buffer is allocated right before 'forInst'.
   auto *forInst = forOp.getOperation();
   FuncBuilder bOuter(forInst);
   // Put together alloc operands for any dynamic dimensions of the memref.
@@ -108,24 +170,24 @@ static bool doubleBuffer(Value *oldMemRef, AffineForOp forOp) {
   Value *newMemRef =
       bOuter.create<AllocOp>(forInst->getLoc(), newMemRefType, allocOperands);
 
-  // Create 'iv mod 2' value to index the leading dimension.
+  // Create 'iv mod numBuffers' value to index the leading dimension.
   auto d0 = bInner.getAffineDimExpr(0);
   int64_t step = forOp.getStep();
-  auto modTwoMap = bInner.getAffineMap(/*dimCount=*/1, /*symbolCount=*/0,
-                                       {d0.floorDiv(step) % 2}, {});
-  auto ivModTwoOp = bInner.create<AffineApplyOp>(forOp.getLoc(), modTwoMap,
-                                                 forOp.getInductionVar());
+  auto modMap = bInner.getAffineMap(/*dimCount=*/1, /*symbolCount=*/0,
+                                    {d0.floorDiv(step) % numBuffers}, {});
+  auto ivModOp = bInner.create<AffineApplyOp>(forOp.getLoc(), modMap,
+                                              forOp.getInductionVar());
 
   // replaceAllMemRefUsesWith will always succeed unless the forOp body has
   // non-deferencing uses of the memref (dealloc's are fine though).
   if (!replaceAllMemRefUsesWith(oldMemRef, newMemRef,
-                                /*extraIndices=*/{ivModTwoOp},
+                                /*extraIndices=*/{ivModOp},
                                 /*indexRemap=*/AffineMap(),
                                 /*extraOperands=*/{},
                                 /*domInstFilter=*/&*forOp.getBody()->begin())) {
     LLVM_DEBUG(
-        forOp.emitError("memref replacement for double buffering failed"));
-    ivModTwoOp.erase();
+        forOp.emitError("memref replacement for multi-buffering failed"));
+    ivModOp.erase();
     return false;
   }
   // Insert the dealloc op right after the for loop.
@@ -144,7 +206,7 @@ void PipelineDataTransfer::runOnFunction() {
   // gets deleted and replaced by a prologue, a new steady-state loop and an
   // epilogue).
   forOps.clear();
-  getFunction().walkPostOrder<AffineForOp>(
+  getFunction().walkPostOrder(
       [&](AffineForOp forOp) { forOps.push_back(forOp); });
   for (auto forOp : forOps)
     runOnAffineForOp(forOp);
@@ -173,17 +235,224 @@ static bool checkTagMatch(DmaStartOp startOp, DmaWaitOp waitOp) {
   return true;
 }
 
+/// Returns the memref in the slower memory space of 'dmaStartOp', i.e., the
+/// source of an incoming DMA or the destination of an outgoing one.
+static Value *getSlowerMemRef(DmaStartOp dmaStartOp) {
+  return dmaStartOp.isDestMemorySpaceFaster() ? dmaStartOp.getSrcMemRef()
+                                              : dmaStartOp.getDstMemRef();
+}
+
+/// Returns the value of 'value' if it is the result of a constant index
+/// operation.
+static Optional<int64_t> getConstantIndexValue(Value *value) {
+  if (auto *defOp = value->getDefiningOp())
+    if (auto cstOp = defOp->dyn_cast<ConstantIndexOp>())
+      return cstOp.getValue();
+  return None;
+}
+
+/// Computes the range of elements of the slower memory memref that
+/// 'dmaStartOp' may transfer: 'offsetExpr' is set to the flattened linearized
+/// offset of the first element transferred as a function of 'operands', and
+/// 'extent' to an upper bound on the number of elements spanned from there.
+/// Returns failure if the memref doesn't have a static, identity laid out
+/// shape, the number of elements isn't constant, or the offset isn't a pure
+/// affine function of its operands.
+static LogicalResult
+getSlowerMemRefRange(DmaStartOp dmaStartOp,
+                     SmallVectorImpl<int64_t> *offsetExpr,
+                     SmallVectorImpl<Value *> *operands, int64_t *extent) {
+  auto memRefType = getSlowerMemRef(dmaStartOp)->getType().cast<MemRefType>();
+  if (!memRefType.hasStaticShape() || !memRefType.getAffineMaps().empty())
+    return failure();
+
+  auto numElements = getConstantIndexValue(dmaStartOp.getNumElements());
+  if (!numElements.hasValue())
+    return failure();
+  // Each stride level, from the outermost, spans all of its chunks but the
+  // last one; the last chunk is then transferred as per the next level.
+  int64_t chunkSize = numElements.getValue();
+  *extent = 0;
+  for (unsigned i = 0, e = dmaStartOp.getNumStrideLevels(); i < e; ++i) {
+    auto dmaStride = getConstantIndexValue(dmaStartOp.getStride(i));
+    auto perStride =
+        getConstantIndexValue(dmaStartOp.getNumElementsPerStride(i));
+    if (!dmaStride.hasValue() || !perStride.hasValue() ||
+        perStride.getValue() <= 0)
+      return failure();
+    int64_t numStrides =
+        (chunkSize + perStride.getValue() - 1) / perStride.getValue();
+    *extent += (numStrides - 1) * dmaStride.getValue();
+    chunkSize = std::min(chunkSize, perStride.getValue());
+  }
+  *extent += chunkSize;
+
+  // Linearize the indices into the slower memref, and compose the affine
+  // computations feeding them.
+  auto *context = dmaStartOp.getOperation()->getContext();
+  auto indices = dmaStartOp.isDestMemorySpaceFaster()
+                     ? dmaStartOp.getSrcIndices()
+                     : dmaStartOp.getDstIndices();
+  operands->assign(indices.begin(), indices.end());
+  auto shape = memRefType.getShape();
+  auto linearExpr = getAffineConstantExpr(0, context);
+  int64_t stride = 1;
+  for (int d = memRefType.getRank() - 1; d >= 0; --d) {
+    linearExpr = linearExpr + getAffineDimExpr(d, context) * stride;
+    stride *= shape[d];
+  }
+  auto map = AffineMap::get(memRefType.getRank(), /*symbolCount=*/0,
+                            linearExpr, {});
+  fullyComposeAffineMapAndOperands(&map, operands);
+
+  std::vector<SmallVector<int64_t, 8>> flatExprs;
+  FlatAffineConstraints localCst;
+  if (failed(getFlattenedAffineExprs(map, &flatExprs, &localCst)) ||
+      localCst.getNumLocalIds() > 0)
+    return failure();
+  offsetExpr->assign(flatExprs[0].begin(), flatExprs[0].end());
+  return success();
+}
+
+/// Returns true if the DMA 'srcOp' of some iteration of 'forOp' may transfer
+/// an element of the slower memory memref that the DMA 'dstOp' transfers in
+/// the same iteration (when 'srcOp' comes first in the body) or in a later
+/// one. The element ranges of both DMAs are related through the iteration
+/// numbers of 'forOp', all other loop IVs and symbols being shared, and the
+/// dependence exists unless the resulting constraint system is empty.
+static bool mayDependOn(DmaStartOp srcOp, DmaStartOp dstOp,
+                        AffineForOp forOp) {
+  if (getSlowerMemRef(srcOp) != getSlowerMemRef(dstOp))
+    return false;
+
+  SmallVector<int64_t, 8> srcExpr, dstExpr;
+  SmallVector<Value *, 4> srcOperands, dstOperands;
+  int64_t srcExtent, dstExtent;
+  if (failed(getSlowerMemRefRange(srcOp, &srcExpr, &srcOperands,
+                                  &srcExtent)) ||
+      failed(getSlowerMemRefRange(dstOp, &dstExpr, &dstOperands, &dstExtent)))
+    return true;
+
+  // Collect the values shared by both ranges; values defined in the loop may
+  // differ from one iteration to the next.
+  Value *iv = forOp.getInductionVar();
+  SmallVector<Value *, 8> sharedValues;
+  DenseMap<Value *, unsigned> sharedValuePos;
+  for (auto operands : {ArrayRef<Value *>(srcOperands),
+                        ArrayRef<Value *>(dstOperands)}) {
+    for (auto *operand : operands) {
+      if (operand == iv || sharedValuePos.count(operand))
+        continue;
+      auto *defOp = operand->getDefiningOp();
+      if (defOp && forOp.getBody()->findAncestorInstInBlock(*defOp))
+        return true;
+      sharedValuePos[operand] = sharedValues.size();
+      sharedValues.push_back(operand);
+    }
+  }
+
+  // The identifiers are, in order: the iteration of 'srcOp', the iteration of
+  // 'dstOp', the shared values, and the offsets of the element in the ranges
+  // transferred by 'srcOp' and 'dstOp'.
+  unsigned srcIvPos = 0, dstIvPos = 1, sharedPos = 2;
+  unsigned srcOffsetPos = sharedPos + sharedValues.size();
+  unsigned dstOffsetPos = srcOffsetPos + 1;
+  FlatAffineConstraints cst(dstOffsetPos + 1);
+  unsigned constPos = cst.getNumCols() - 1;
+
+  auto getPos = [&](Value *operand, unsigned ivPos) -> unsigned {
+    return operand == iv ? ivPos : sharedPos + sharedValuePos[operand];
+  };
+
+  // srcOffset(srcIv) + srcOffsetPos == dstOffset(dstIv) + dstOffsetPos.
+  SmallVector<int64_t, 8> eq(cst.getNumCols(), 0);
+  for (unsigned i = 0, e = srcOperands.size(); i < e; ++i)
+    eq[getPos(srcOperands[i], srcIvPos)] += srcExpr[i];
+  for (unsigned i = 0, e = dstOperands.size(); i < e; ++i)
+    eq[getPos(dstOperands[i], dstIvPos)] -= dstExpr[i];
+  eq[srcOffsetPos] = 1;
+  eq[dstOffsetPos] = -1;
+  eq[constPos] = srcExpr.back() - dstExpr.back();
+  cst.addEquality(eq);
+
+  cst.addConstantLowerBound(srcOffsetPos, 0);
+  cst.addConstantUpperBound(srcOffsetPos, srcExtent - 1);
+  cst.addConstantLowerBound(dstOffsetPos, 0);
+  cst.addConstantUpperBound(dstOffsetPos, dstExtent - 1);
+
+  // dstIv >= srcIv + step, or dstIv >= srcIv if 'srcOp' comes first.
+  SmallVector<int64_t, 8> ineq(cst.getNumCols(), 0);
+  ineq[dstIvPos] = 1;
+  ineq[srcIvPos] = -1;
+  if (!srcOp.getOperation()->isBeforeInBlock(dstOp.getOperation()))
+    ineq[constPos] = -forOp.getStep();
+  cst.addInequality(ineq);
+
+  if (forOp.hasConstantBounds()) {
+    for (auto pos : {srcIvPos, dstIvPos}) {
+      cst.addConstantLowerBound(pos, forOp.getConstantLowerBound());
+      cst.addConstantUpperBound(pos, forOp.getConstantUpperBound() - 1);
+    }
+  }
+  for (unsigned i = 0, e = sharedValues.size(); i < e; ++i) {
+    auto value = getConstantIndexValue(sharedValues[i]);
+    if (value.hasValue())
+      cst.setIdToConstant(sharedPos + i, value.getValue());
+  }
+
+  return !cst.isEmpty();
+}
+
+/// Returns true if 'dmaStartOp' may be pipelined in 'forOp' as far as
+/// dependences go: the DMAs of later iterations may be started before it
+/// completes if it is incoming, and it may complete after the DMAs of later
+/// iterations are started if it is outgoing. The slower memory memref may thus
+/// only be accessed through DMAs in the loop, none of which may depend on or,
+/// for an outgoing DMA, be depended on by 'dmaStartOp' across iterations.
+static bool isPipelineSafe(DmaStartOp dmaStartOp,
+                           ArrayRef<DmaStartOp> dmaStartOps,
+                           AffineForOp forOp) {
+  auto *slowerMemRef = getSlowerMemRef(dmaStartOp);
+  for (auto &use : slowerMemRef->getUses()) {
+    if (!forOp.getBody()->findAncestorInstInBlock(*use.getOwner()))
+      continue;
+    auto otherOp = use.getOwner()->dyn_cast<DmaStartOp>();
+    if (!otherOp ||
+        (!otherOp.isSrcMemorySpaceFaster() &&
+         !otherOp.isDestMemorySpaceFaster()) ||
+        getSlowerMemRef(otherOp) != slowerMemRef) {
+      LLVM_DEBUG(llvm::dbgs() << "can't pipeline: non-DMA use in loop\n";);
+      return false;
+    }
+  }
+
+  bool isIncoming = dmaStartOp.isDestMemorySpaceFaster();
+  for (auto otherOp : dmaStartOps) {
+    // Only the outgoing DMAs write to the slower memory memref.
+    if (isIncoming && !otherOp.isSrcMemorySpaceFaster())
+      continue;
+    if ((isIncoming && mayDependOn(otherOp, dmaStartOp, forOp)) ||
+        (!isIncoming && mayDependOn(dmaStartOp, otherOp, forOp))) {
+      LLVM_DEBUG(llvm::dbgs() << "can't pipeline: dependent DMAs\n";);
+      return false;
+    }
+  }
+  return true;
+}
+
 // Identify matching DMA start/finish operations to overlap computation with.
+// Both DMAs incoming into higher memory spaces and outgoing from them are
+// identified: the former are started ahead of the computation, and the latter
+// are waited for after the computation of later iterations.
 static void findMatchingStartFinishInsts(
     AffineForOp forOp,
     SmallVectorImpl<std::pair<Operation *, Operation *>> &startWaitPairs) {
 
-  // Collect outgoing DMA operations - needed to check for dependences below.
-  SmallVector<DmaStartOp, 4> outgoingDmaOps;
+  // Collect DMA operations - needed to check for dependences below.
+  SmallVector<DmaStartOp, 4> dmaStartOps;
   for (auto &op : *forOp.getBody()) {
-    auto dmaStartOp = op.dyn_cast<DmaStartOp>();
-    if (dmaStartOp && dmaStartOp.isSrcMemorySpaceFaster())
-      outgoingDmaOps.push_back(dmaStartOp);
+    if (auto dmaStartOp = op.dyn_cast<DmaStartOp>())
+      dmaStartOps.push_back(dmaStartOp);
   }
 
   SmallVector<Operation *, 4> dmaStartInsts, dmaFinishInsts;
@@ -197,27 +466,32 @@ static void findMatchingStartFinishInsts(
     if (!dmaStartOp)
       continue;
 
-    // Only DMAs incoming into higher memory spaces are pipelined for now.
-    // TODO(bondhugula): handle outgoing DMA pipelining.
-    if (!dmaStartOp.isDestMemorySpaceFaster())
+    // DMAs within the same memory space are not pipelined.
+    bool isIncoming = dmaStartOp.isDestMemorySpaceFaster();
+    if (!isIncoming && !dmaStartOp.isSrcMemorySpaceFaster())
       continue;
 
-    // Check for dependence with outgoing DMAs. Doing this conservatively.
-    // TODO(andydavis,bondhugula): use the dependence analysis to check for
-    // dependences between an incoming and outgoing DMA in the same iteration.
-    auto it = outgoingDmaOps.begin();
-    for (; it != outgoingDmaOps.end(); ++it) {
-      if (it->getDstMemRef() == dmaStartOp.getSrcMemRef())
-        break;
-    }
-    if (it != outgoingDmaOps.end())
+    if (!isPipelineSafe(dmaStartOp, dmaStartOps, forOp))
       continue;
 
-    // We only double buffer if the buffer is not live out of loop.
+    // The buffer and the tag of an outgoing DMA are only pipelined when they
+    // are not shared with other DMAs, whose own pipelining would leave fewer
+    // buffers to the outgoing DMA.
     auto *memref = dmaStartOp.getOperand(dmaStartOp.getFasterMemPos());
+    if (!isIncoming) {
+      bool isShared = llvm::any_of(dmaStartOps, [&](DmaStartOp otherOp) {
+        return otherOp.getOperation() != dmaStartOp.getOperation() &&
+               (llvm::is_contained(otherOp.getOperands(), memref) ||
+                otherOp.getTagMemRef() == dmaStartOp.getTagMemRef());
+      });
+      if (isShared)
+        continue;
+    }
+
+    // We only multi-buffer if the buffer is not live out of loop.
     bool escapingUses = false;
     for (const auto &use : memref->getUses()) {
-      // We can double buffer regardless of dealloc's outside the loop.
+      // We can multi-buffer regardless of dealloc's outside the loop.
       if (use.getOwner()->isa<DeallocOp>())
         continue;
       if (!forOp.getBody()->findAncestorInstInBlock(*use.getOwner())) {
@@ -243,9 +517,35 @@ static void findMatchingStartFinishInsts(
   }
 }
 
+/// Sets the shift of 'op' and of the affine.apply operations computing its
+/// operands to 'shift' in 'instShiftMap'. The affine computations are sliced
+/// for 'op' if they are shared with other operations.
+static void setShiftWithAffineSlice(Operation *op, unsigned shift,
+                                    DenseMap<Operation *, unsigned> &shiftMap) {
+  shiftMap[op] = shift;
+  SmallVector<AffineApplyOp, 4> sliceOps;
+  mlir::createAffineComputationSlice(op, &sliceOps);
+  if (!sliceOps.empty()) {
+    for (auto sliceOp : sliceOps) {
+      shiftMap[sliceOp.getOperation()] = shift;
+    }
+  } else {
+    // If a slice wasn't created, the reachable affine.apply op's from its
+    // operands are the ones that go with it.
+    SmallVector<Operation *, 4> affineApplyInsts;
+    SmallVector<Value *, 4> operands(op->getOperands());
+    getReachableAffineApplyOps(operands, affineApplyInsts);
+    for (auto *applyOp : affineApplyInsts) {
+      shiftMap[applyOp] = shift;
+    }
+  }
+}
+
 /// Overlap DMA transfers with computation in this loop. If successful,
 /// 'forOp' is deleted, and a prologue, a new pipelined loop, and epilogue are
-/// inserted right before where it was.
+/// inserted right before where it was. With N buffers, incoming DMAs are
+/// started N - 1 iterations ahead of the computation, and outgoing DMAs are
+/// waited for N - 1 iterations after it.
 void PipelineDataTransfer::runOnAffineForOp(AffineForOp forOp) {
   auto mayBeConstTripCount = getConstantTripCount(forOp);
   if (!mayBeConstTripCount.hasValue()) {
@@ -253,6 +553,12 @@ void PipelineDataTransfer::runOnAffineForOp(AffineForOp forOp) {
     return;
   }
 
+  unsigned numBuffers = getNumBuffers();
+  if (numBuffers < 2) {
+    LLVM_DEBUG(forOp.emitNote("won't pipeline with less than two buffers"));
+    return;
+  }
+
   SmallVector<std::pair<Operation *, Operation *>, 4> startWaitPairs;
   findMatchingStartFinishInsts(forOp, startWaitPairs);
 
@@ -261,30 +567,31 @@ void PipelineDataTransfer::runOnAffineForOp(AffineForOp forOp) {
     return;
   }
 
-  // Double the buffers for the higher memory space memref's.
+  // Multiply the buffers for the higher memory space memref's.
   // Identify memref's to replace by scanning through all DMA start
   // operations. A DMA start operation has two memref's - the one from the
-  // higher level of memory hierarchy is the one to double buffer.
-  // TODO(bondhugula): check whether double-buffering is even necessary.
-  // TODO(bondhugula): make this work with different layouts: assuming here that
-  // the dimension we are adding here for the double buffering is the outermost
-  // dimension.
+  // higher level of memory hierarchy is the one to multi-buffer. A buffer
+  // shared by several DMAs is multiplied once.
+  // TODO(bondhugula): check whether multi-buffering is even necessary.
+  SetVector<Value *> memRefs, tagMemRefs;
   for (auto &pair : startWaitPairs) {
-    auto *dmaStartInst = pair.first;
-    Value *oldMemRef = dmaStartInst->getOperand(
-        dmaStartInst->cast<DmaStartOp>().getFasterMemPos());
-    if (!doubleBuffer(oldMemRef, forOp)) {
-      // Normally, double buffering should not fail because we already checked
+    auto dmaStartOp = pair.first->cast<DmaStartOp>();
+    memRefs.insert(dmaStartOp.getOperand(dmaStartOp.getFasterMemPos()));
+    tagMemRefs.insert(pair.second->getOperand(getTagMemRefPos(*pair.second)));
+  }
+
+  for (auto *oldMemRef : memRefs) {
+    if (!multiBuffer(oldMemRef, forOp, numBuffers)) {
+      // Normally, multi-buffering should not fail because we already checked
       // that there are no uses outside.
-      LLVM_DEBUG(llvm::dbgs() << "double buffering failed for: \n";);
-      LLVM_DEBUG(dmaStartInst->dump());
+      LLVM_DEBUG(llvm::dbgs() << "multi-buffering failed\n";);
       // IR still in a valid state.
       return;
     }
     // If the old memref has no more uses, remove its 'dead' alloc if it was
     // alloc'ed. (note: DMA buffers are rarely function live-in; but a 'dim'
     // operation could have been used on it if it was dynamically shaped in
-    // order to create the double buffer above.)
+    // order to create the multiple buffer above.)
     // '-canonicalize' does this in a more general way, but we'll anyway do the
     // simple/common case so that the output / test cases looks clear.
     if (auto *allocInst = oldMemRef->getDefiningOp()) {
@@ -300,13 +607,10 @@ void PipelineDataTransfer::runOnAffineForOp(AffineForOp forOp) {
     }
   }
 
-  // Double the buffers for tag memrefs.
-  for (auto &pair : startWaitPairs) {
-    auto *dmaFinishInst = pair.second;
-    Value *oldTagMemRef =
-        dmaFinishInst->getOperand(getTagMemRefPos(*dmaFinishInst));
-    if (!doubleBuffer(oldTagMemRef, forOp)) {
-      LLVM_DEBUG(llvm::dbgs() << "tag double buffering failed\n";);
+  // Multiply the buffers for tag memrefs.
+  for (auto *oldTagMemRef : tagMemRefs) {
+    if (!multiBuffer(oldTagMemRef, forOp, numBuffers)) {
+      LLVM_DEBUG(llvm::dbgs() << "tag multi-buffering failed\n";);
       return;
     }
     // If the old tag has no more uses, remove its 'dead' alloc if it was
@@ -316,38 +620,33 @@ void PipelineDataTransfer::runOnAffineForOp(AffineForOp forOp) {
         allocInst->erase();
   }
 
-  // Double buffering would have invalidated all the old DMA start/wait insts.
+  // Multi-buffering would have invalidated all the old DMA start/wait insts.
   startWaitPairs.clear();
   findMatchingStartFinishInsts(forOp, startWaitPairs);
 
+  // The computation is shifted past the incoming DMA starts, if any, and the
+  // outgoing DMA waits are shifted past the computation.
+  unsigned delay = numBuffers - 1;
+  bool hasIncomingDma = llvm::any_of(
+      startWaitPairs, [](const std::pair<Operation *, Operation *> &pair) {
+        return pair.first->cast<DmaStartOp>().isDestMemorySpaceFaster();
+      });
+  unsigned computeShift = hasIncomingDma ? delay : 0;
+
   // Store shift for operation for later lookup for AffineApplyOp's.
   DenseMap<Operation *, unsigned> instShiftMap;
   for (auto &pair : startWaitPairs) {
-    auto *dmaStartInst = pair.first;
-    assert(dmaStartInst->isa<DmaStartOp>());
-    instShiftMap[dmaStartInst] = 0;
-    // Set shifts for DMA start op's affine operand computation slices to 0.
-    SmallVector<AffineApplyOp, 4> sliceOps;
-    mlir::createAffineComputationSlice(dmaStartInst, &sliceOps);
-    if (!sliceOps.empty()) {
-      for (auto sliceOp : sliceOps) {
-        instShiftMap[sliceOp.getOperation()] = 0;
-      }
-    } else {
-      // If a slice wasn't created, the reachable affine.apply op's from its
-      // operands are the ones that go with it.
-      SmallVector<Operation *, 4> affineApplyInsts;
-      SmallVector<Value *, 4> operands(dmaStartInst->getOperands());
-      getReachableAffineApplyOps(operands, affineApplyInsts);
-      for (auto *op : affineApplyInsts) {
-        instShiftMap[op] = 0;
-      }
-    }
+    auto dmaStartOp = pair.first->cast<DmaStartOp>();
+    if (dmaStartOp.isDestMemorySpaceFaster())
+      setShiftWithAffineSlice(pair.first, 0, instShiftMap);
+    else
+      setShiftWithAffineSlice(pair.second, computeShift + delay, instShiftMap);
   }
-  // Everything else (including compute ops and dma finish) are shifted by one.
+  // Everything else (including compute ops, incoming dma finish and outgoing
+  // dma start) is shifted by the compute shift.
   for (auto &op : *forOp.getBody()) {
     if (instShiftMap.find(&op) == instShiftMap.end()) {
-      instShiftMap[&op] = 1;
+      instShiftMap[&op] = computeShift;
     }
   }
 
@@ -20,6 +20,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/AffineStructures.h"
+#include "mlir/IR/AffineMap.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/IntegerSet.h"
 #include "mlir/IR/Operation.h"
@@ -34,65 +35,42 @@ namespace {
 
 /// Simplifies all affine expressions appearing in the operations of
 /// the Function. This is mainly to test the simplifyAffineExpr method.
+/// The simplifications are memoized in the context, so the pass holds no state
+/// and the same uniqued map or set is only simplified once across all the
+/// functions, including those processed by other threads.
 /// TODO(someone): This should just be defined as a canonicalization pattern
 /// on AffineMap and driven from the existing canonicalization pass.
 struct SimplifyAffineStructures
     : public FunctionPass<SimplifyAffineStructures> {
   void runOnFunction() override;
+};
 
-  /// Utility to simplify an affine attribute and update its entry in the parent
-  /// operation if necessary.
-  template <typename AttributeT>
-  void simplifyAndUpdateAttribute(Operation *op, Identifier name,
-                                  AttributeT attr) {
-    auto &simplified = simplifiedAttributes[attr];
-    if (simplified == attr)
-      return;
-
-    // This is a newly encountered attribute.
-    if (!simplified) {
-      // Try to simplify the value of the attribute.
-      auto value = attr.getValue();
-      auto simplifiedValue = simplify(value);
-      if (simplifiedValue == value) {
-        simplified = attr;
-        return;
-      }
-      simplified = AttributeT::get(simplifiedValue);
-    }
-
-    // Simplification was successful, so update the attribute.
-    op->setAttr(name, simplified);
-  }
-
-  /// Performs basic integer set simplifications. Checks if it's empty, and
-  /// replaces it with the canonical empty set if it is.
-  IntegerSet simplify(IntegerSet set) {
-    FlatAffineConstraints fac(set);
-    if (fac.isEmpty())
-      return IntegerSet::getEmptySet(set.getNumDims(), set.getNumSymbols(),
-                                     &getContext());
-    return set;
-  }
+} // end anonymous namespace
 
-  /// Performs basic affine map simplifications.
-  AffineMap simplify(AffineMap map) {
-    MutableAffineMap mMap(map);
-    mMap.simplify();
-    return mMap.getAffineMap();
-  }
+// Performs basic integer set simplifications. Checks if it's empty, and
+// replaces it with the canonical empty set if it is.
+static IntegerSet simplify(IntegerSet set) { return simplifyIntegerSet(set); }
 
-  DenseMap<Attribute, Attribute> simplifiedAttributes;
-};
+// Performs basic affine map simplifications.
+static AffineMap simplify(AffineMap map) { return simplifyAffineMap(map); }
 
-} // end anonymous namespace
+// Simplify the value of the affine attribute 'attr' and update its entry
+// 'name' in 'op' if it changed.
+template <typename AttributeT>
+static void simplifyAndUpdateAttribute(Operation *op, Identifier name,
+                                       AttributeT attr) {
+  auto value = attr.getValue();
+  auto simplifiedValue = simplify(value);
+  if (simplifiedValue == value)
+    return;
+  op->setAttr(name, AttributeT::get(simplifiedValue));
+}
 
 FunctionPassBase *mlir::createSimplifyAffineStructuresPass() {
   return new SimplifyAffineStructures();
 }
 
 void SimplifyAffineStructures::runOnFunction() {
-  simplifiedAttributes.clear();
   getFunction().walk([&](Operation *opInst) {
     for (auto attr : opInst->getAttrs()) {
       if (auto mapAttr = attr.second.dyn_cast<AffineMapAttr>())
@@ -0,0 +1,265 @@
+//===- SpecializeFunctions.cpp - Specialize functions for their call sites ===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements a pass that clones the callees of the direct 'call'
+// operations passing constants, or memrefs of a static shape cast to a dynamic
+// one, and specializes the clones for those arguments.  The constants are
+// materialized in the clone instead of being passed, and the memrefs are passed
+// with their static type.  The clones are then canonicalized, so that the
+// sizes of the memrefs and the trip counts of the loops they bound fold into
+// constants, which enables the full unrolling and vectorization of the loops.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/StandardOps/Ops.h"
+#include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace mlir;
+
+#define DEBUG_TYPE "specialize-functions"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned> clMaxSpecializations(
+    "specialize-max-clones",
+    llvm::cl::desc("Create at most this many specializations of a function"),
+    llvm::cl::init(4), llvm::cl::cat(clOptionsCategory));
+
+namespace {
+/// The arguments of a call site that a function is specialized for: the value
+/// of each constant argument, or the static type of each memref argument, or
+/// null for the arguments that are passed unchanged.
+struct SpecializedArg {
+  Attribute value;
+  Type type;
+
+  bool operator==(const SpecializedArg &other) const {
+    return value == other.value && type == other.type;
+  }
+};
+using SpecializedArgs = SmallVector<SpecializedArg, 4>;
+
+struct Specialization {
+  SpecializedArgs args;
+  Function *function;
+};
+
+struct SpecializeFunctions : public ModulePass<SpecializeFunctions> {
+  explicit SpecializeFunctions(int maxSpecializations = -1)
+      : maxSpecializations(maxSpecializations < 0 ? clMaxSpecializations
+                                                  : maxSpecializations) {}
+
+  void runOnModule() override;
+
+  /// Return the specialization of the callee of `call` for `args`, creating it
+  /// if there are less than `maxSpecializations` ones already, or return null.
+  Function *getOrCreateSpecialization(CallOp call,
+                                      const SpecializedArgs &args);
+
+  /// The maximal number of specializations of a function.
+  unsigned maxSpecializations;
+
+  /// The specializations of each function, in the order of creation.
+  llvm::DenseMap<Function *, SmallVector<Specialization, 4>> specializations;
+};
+} // end anonymous namespace
+
+// Return the constant value of `value`, or null if it isn't a constant.
+static Attribute getConstantValue(Value *value) {
+  Operation *def = value->getDefiningOp();
+  if (!def || !def->isa<ConstantOp>())
+    return {};
+  return def->cast<ConstantOp>().getValue();
+}
+
+// Return the static memref that `value` is a cast of, or null if `value`
+// doesn't hide a static shape.
+static Value *getStaticMemRef(Value *value) {
+  Operation *def = value->getDefiningOp();
+  if (!def || !def->isa<MemRefCastOp>())
+    return nullptr;
+  Value *source = def->cast<MemRefCastOp>().getOperand();
+  auto memrefType = source->getType().cast<MemRefType>();
+  if (!memrefType.hasStaticShape() || source->getType() == value->getType())
+    return nullptr;
+  return source;
+}
+
+// Collect in `args` the arguments of `call` that its callee can be specialized
+// for.  Return false if there are none.
+static bool getSpecializedArgs(CallOp call, SpecializedArgs &args) {
+  bool hasSpecializedArgs = false;
+  for (Value *operand : call.getArgOperands()) {
+    SpecializedArg arg;
+    if ((arg.value = getConstantValue(operand)))
+      arg.type = operand->getType();
+    else if (Value *memref = getStaticMemRef(operand))
+      arg.type = memref->getType();
+    hasSpecializedArgs |= static_cast<bool>(arg.type);
+    args.push_back(arg);
+  }
+  return hasSpecializedArgs;
+}
+
+// Create a clone of `callee` specialized for `args`, right after `insertAfter`
+// in the module, and canonicalize it.
+static Function *createSpecialization(Function *callee,
+                                      const SpecializedArgs &args,
+                                      Function *insertAfter, unsigned index) {
+  Module *module = callee->getModule();
+  MLIRContext *context = callee->getContext();
+
+  // The constant arguments are removed from the signature, and the memref ones
+  // take their static type.
+  SmallVector<Type, 8> argTypes;
+  SmallVector<unsigned, 8> keptArgs;
+  for (unsigned i = 0, e = args.size(); i < e; ++i) {
+    if (args[i].value)
+      continue;
+    keptArgs.push_back(i);
+    argTypes.push_back(args[i].type ? args[i].type
+                                    : callee->getArgument(i)->getType());
+  }
+  std::string name;
+  do {
+    name = (callee->getName().strref() + "_specialized_" + Twine(index++))
+               .str();
+  } while (module->getNamedFunction(name));
+  auto *specialized = new Function(
+      callee->getLoc(), name,
+      FunctionType::get(argTypes, callee->getType().getResults(), context));
+  module->getFunctions().insert(std::next(Module::iterator(insertAfter)),
+                                specialized);
+  for (auto indexedArg : llvm::enumerate(keptArgs))
+    specialized->setArgAttrs(indexedArg.index(),
+                             callee->getArgAttrs(indexedArg.value()));
+  specialized->addEntryBlock();
+  Block *entryBlock = &specialized->front();
+  FuncBuilder builder(entryBlock);
+
+  // Map the arguments of the callee to the constants materialized in the
+  // specialization, or to casts of its static memrefs back to their original
+  // type, which the canonicalization folds into their users.
+  BlockAndValueMapping mapper;
+  for (unsigned i = 0, e = args.size(), argIndex = 0; i < e; ++i) {
+    Value *arg = callee->getArgument(i);
+    auto loc = callee->getLoc();
+    if (args[i].value) {
+      auto constant = builder.create<ConstantOp>(loc, args[i].type,
+                                                 args[i].value);
+      mapper.map(arg, constant.getResult());
+      continue;
+    }
+    Value *newArg = entryBlock->getArgument(argIndex++);
+    if (args[i].type)
+      newArg = builder.create<MemRefCastOp>(loc, newArg, arg->getType())
+                   .getResult();
+    mapper.map(arg, newArg);
+  }
+
+  // Clone the body of the callee, whose entry block has no argument left, and
+  // merge it into the new entry block.
+  callee->cloneInto(specialized, mapper);
+  Block *clonedEntryBlock = mapper.lookupOrNull(&callee->front());
+  entryBlock->getOperations().splice(entryBlock->end(),
+                                     clonedEntryBlock->getOperations());
+  clonedEntryBlock->eraseFromFunction();
+
+  OwningRewritePatternList patterns;
+  for (auto *op : context->getRegisteredOperations())
+    op->getCanonicalizationPatterns(patterns, context);
+  applyPatternsGreedily(*specialized, std::move(patterns));
+  return specialized;
+}
+
+Function *
+SpecializeFunctions::getOrCreateSpecialization(CallOp call,
+                                               const SpecializedArgs &args) {
+  Function *callee = call.getCallee();
+  auto &calleeSpecializations = specializations[callee];
+  for (auto &specialization : calleeSpecializations)
+    if (specialization.args == args)
+      return specialization.function;
+  if (calleeSpecializations.size() >= maxSpecializations)
+    return nullptr;
+  // Keep the specializations in the order of creation after the callee.
+  Function *insertAfter = calleeSpecializations.empty()
+                              ? callee
+                              : calleeSpecializations.back().function;
+  Function *specialized = createSpecialization(
+      callee, args, insertAfter, calleeSpecializations.size());
+  calleeSpecializations.push_back({args, specialized});
+  return specialized;
+}
+
+void SpecializeFunctions::runOnModule() {
+  specializations.clear();
+
+  // Collect the calls first, so that the ones in the specializations are not
+  // specialized again.
+  SmallVector<CallOp, 16> calls;
+  for (Function &function : getModule())
+    function.walk([&](CallOp call) {
+      if (!call.getCallee()->isExternal())
+        calls.push_back(call);
+    });
+
+  for (CallOp call : calls) {
+    SpecializedArgs args;
+    if (!getSpecializedArgs(call, args))
+      continue;
+    Function *specialized = getOrCreateSpecialization(call, args);
+    if (!specialized)
+      continue;
+
+    // Call the specialization with the arguments that are still passed.
+    SmallVector<Value *, 8> operands;
+    for (auto indexedOperand : llvm::enumerate(call.getArgOperands())) {
+      const SpecializedArg &arg = args[indexedOperand.index()];
+      if (arg.value)
+        continue;
+      Value *operand = indexedOperand.value();
+      operands.push_back(arg.type ? getStaticMemRef(operand) : operand);
+    }
+    Operation *callOp = call.getOperation();
+    FuncBuilder builder(callOp);
+    auto newCall =
+        builder.create<CallOp>(callOp->getLoc(), specialized, operands);
+    for (auto attr : callOp->getAttrs())
+      if (attr.first.strref() != "callee")
+        newCall.getOperation()->setAttr(attr.first, attr.second);
+    SmallVector<Value *, 4> results(newCall.getOperation()->getResults());
+    callOp->replaceAllUsesWith(results);
+    callOp->erase();
+  }
+}
+
+ModulePassBase *mlir::createSpecializeFunctionsPass(int maxSpecializations) {
+  return new SpecializeFunctions(maxSpecializations);
+}
+
+static PassRegistration<SpecializeFunctions>
+    pass("specialize-functions",
+         "Clone the callees of the calls passing constants or static memrefs, "
+         "specialized for those arguments");
@@ -19,13 +19,41 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/StandardOps/Ops.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
 using namespace mlir;
 
+#define DEBUG_TYPE "greedy-rewriter"
+
+STATISTIC(NumIterations, "Number of iterations over the worklist");
+STATISTIC(NumNotConverged,
+          "Number of functions that hit the iteration cap while changing");
+STATISTIC(NumPartitions, "Number of partitions simplified in parallel");
+
+static llvm::cl::opt<bool> clParallelRewrite(
+    "experimental-mt-greedy-rewriter",
+    llvm::cl::desc("Simplify the top-level region operations of a function in "
+                   "parallel when applying patterns greedily"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned> clMaxIterations(
+    "greedy-rewriter-max-iterations",
+    llvm::cl::desc("Maximum number of times the greedy rewriter revisits every "
+                   "operation of a function that is still changing"),
+    llvm::cl::init(1));
+
 namespace {
 
 /// This is a worklist-driven driver for the PatternMatcher, which repeatedly
@@ -33,24 +61,28 @@ namespace {
 class GreedyPatternRewriteDriver : public PatternRewriter {
 public:
   explicit GreedyPatternRewriteDriver(Function &fn,
-                                      OwningRewritePatternList &&patterns)
-      : PatternRewriter(fn.getContext()), matcher(std::move(patterns), *this),
-        builder(&fn) {
+                                      const RewritePatternMatcher &matcher)
+      : PatternRewriter(fn.getContext()), matcher(matcher), builder(&fn),
+        function(fn) {
     worklist.reserve(64);
-
-    // Add all operations to the worklist.
-    fn.walk([&](Operation *op) { addToWorklist(op); });
   }
 
-  /// Perform the rewrites.
-  void simplifyFunction();
+  /// Perform the rewrites on the operations in the worklist.  When the
+  /// function changed, every operation is revisited up to 'maxIterations'
+  /// times in total.  Returns true if the function converged.
+  bool simplifyFunction(unsigned maxIterations);
+
+  /// Add all operations of the function to the worklist.
+  void addAllToWorklist() {
+    function.walk([&](Operation *op) { addToWorklist(op); });
+  }
 
   void addToWorklist(Operation *op) {
     // Check to see if the worklist already contains this op.
-    if (worklistMap.count(op))
+    if (op->isInWorklist())
       return;
 
-    worklistMap[op] = worklist.size();
+    op->setWorklistIndex(worklist.size());
     worklist.push_back(op);
   }
 
@@ -58,20 +90,36 @@ public:
     auto *op = worklist.back();
     worklist.pop_back();
 
-    // This operation is no longer in the worklist, keep worklistMap up to date.
+    // This operation is no longer in the worklist, keep its index up to date.
     if (op)
-      worklistMap.erase(op);
+      op->clearWorklistIndex();
+    else
+      --numRemoved;
     return op;
   }
 
   /// If the specified operation is in the worklist, remove it.  If not, this is
   /// a no-op.
   void removeFromWorklist(Operation *op) {
-    auto it = worklistMap.find(op);
-    if (it != worklistMap.end()) {
-      assert(worklist[it->second] == op && "malformed worklist data structure");
-      worklist[it->second] = nullptr;
-    }
+    if (!op->isInWorklist())
+      return;
+    unsigned index = op->getWorklistIndex();
+    assert(worklist[index] == op && "malformed worklist data structure");
+    worklist[index] = nullptr;
+    op->clearWorklistIndex();
+
+    // Compact the worklist once most of it is made up of removed entries.
+    if (++numRemoved > worklist.size() / 2 && worklist.size() > 64)
+      compactWorklist();
+  }
+
+  /// Remove all operations from the worklist.
+  void clearWorklist() {
+    for (auto *op : worklist)
+      if (op)
+        op->clearWorklistIndex();
+    worklist.clear();
+    numRemoved = 0;
   }
 
   // These are hooks implemented for PatternRewriter.
@@ -84,11 +132,12 @@ protected:
     return result;
   }
 
-  // If an operation is about to be removed, make sure it is not in our
-  // worklist anymore because we'd get dangling references to it.
+  // If an operation is about to be removed, make sure it and the operations
+  // nested within it are not in our worklist anymore because we'd get dangling
+  // references to them.
   void notifyOperationRemoved(Operation *op) override {
     addToWorklist(op->getOperands());
-    removeFromWorklist(op);
+    op->walk([this](Operation *nested) { removeFromWorklist(nested); });
   }
 
   // When the root of a pattern is about to be replaced, it can trigger
@@ -121,18 +170,49 @@ private:
     }
   }
 
+  /// Remove the entries of operations that were removed from the worklist,
+  /// preserving the order of the remaining ones.
+  void compactWorklist() {
+    unsigned newSize = 0;
+    for (auto *op : worklist) {
+      if (!op)
+        continue;
+      op->setWorklistIndex(newSize);
+      worklist[newSize++] = op;
+    }
+    worklist.resize(newSize);
+    numRemoved = 0;
+  }
+
+  /// Erase the given operation, which has already been popped from the
+  /// worklist, along with any operations nested within it.
+  void eraseOp(Operation *op) {
+    if (op->getNumRegions() != 0)
+      op->walk([this](Operation *nested) { removeFromWorklist(nested); });
+    op->erase();
+  }
+
+  /// Process the worklist until it is empty.  Returns true if the function
+  /// was changed.
+  bool processWorklist();
+
   /// The low-level pattern matcher.
-  RewritePatternMatcher matcher;
+  const RewritePatternMatcher &matcher;
 
   /// This builder is used to create new operations.
   FuncBuilder builder;
 
+  /// The function being simplified.
+  Function &function;
+
   /// The worklist for this transformation keeps track of the operations that
-  /// need to be revisited, plus their index in the worklist.  This allows us to
-  /// efficiently remove operations from the worklist when they are erased from
-  /// the function, even if they aren't the root of a pattern.
+  /// need to be revisited.  Each operation in the worklist records its index
+  /// within it, which allows us to efficiently remove operations from the
+  /// worklist when they are erased from the function, even if they aren't the
+  /// root of a pattern.  Removed operations leave a null entry behind, and
+  /// 'numRemoved' counts these entries so that they can be compacted.
   std::vector<Operation *> worklist;
-  DenseMap<Operation *, unsigned> worklistMap;
+  unsigned numRemoved = 0;
 
   /// As part of canonicalization, we move constants to the top of the entry
   /// block of the current function and de-duplicate them.  This keeps track of
@@ -142,10 +222,32 @@ private:
 }; // end anonymous namespace
 
 /// Perform the rewrites.
-void GreedyPatternRewriteDriver::simplifyFunction() {
+bool GreedyPatternRewriteDriver::simplifyFunction(unsigned maxIterations) {
+  bool converged = false;
+  for (unsigned i = 0; i != maxIterations; ++i) {
+    ++NumIterations;
+    if (!processWorklist()) {
+      converged = true;
+      break;
+    }
+
+    // The function changed, so revisit everything on the next iteration.
+    if (i + 1 != maxIterations)
+      addAllToWorklist();
+  }
+  clearWorklist();
+  uniquedConstants.clear();
+
+  if (!converged && maxIterations > 1)
+    ++NumNotConverged;
+  return converged;
+}
+
+bool GreedyPatternRewriteDriver::processWorklist() {
   // These are scratch vectors used in the constant folding loop below.
   SmallVector<Attribute, 8> operandConstants, resultConstants;
   SmallVector<Value *, 8> originalOperands, resultValues;
+  bool changed = false;
 
   while (!worklist.empty()) {
     auto *op = popFromWorklist();
@@ -164,6 +266,7 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
         if (it != uniquedConstants.end() && it->second == op)
           uniquedConstants.erase(it);
         constant.erase();
+        changed = true;
         continue;
       }
 
@@ -180,14 +283,16 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
         // function when they are uniqued, so we know they dominate all uses.
         constant.replaceAllUsesWith(entry->getResult(0));
         constant.erase();
+        changed = true;
         continue;
       }
 
       // If we have no entry, then we should unique this constant as the
       // canonical version.  To ensure safe dominance, move the operation to the
-      // top of the function.
+      // top of the function.  This only reorders the constants, so it isn't
+      // considered a change.
       entry = op;
-      auto &entryBB = builder.getInsertionBlock()->getFunction()->front();
+      auto &entryBB = function.front();
       op->moveBefore(&entryBB, entryBB.begin());
       continue;
     }
@@ -195,15 +300,21 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
     // If the operation has no side effects, and no users, then it is trivially
     // dead - remove it.
     if (op->hasNoSideEffect() && op->use_empty()) {
-      op->erase();
+      eraseOp(op);
+      changed = true;
       continue;
     }
 
     // Check to see if any operands to the operation is constant and whether
-    // the operation knows how to constant fold itself.
-    operandConstants.assign(op->getNumOperands(), Attribute());
-    for (unsigned i = 0, e = op->getNumOperands(); i != e; ++i)
-      matchPattern(op->getOperand(i), m_Constant(&operandConstants[i]));
+    // the operation knows how to constant fold itself.  The operations that
+    // can't fold only need them to canonicalize their order when commutative.
+    bool isFoldable = op->isFoldable();
+    operandConstants.clear();
+    if (isFoldable || (op->getNumOperands() == 2 && op->isCommutative())) {
+      operandConstants.assign(op->getNumOperands(), Attribute());
+      for (unsigned i = 0, e = op->getNumOperands(); i != e; ++i)
+        matchPattern(op->getOperand(i), m_Constant(&operandConstants[i]));
+    }
 
     // If this is a commutative binary operation with a constant on the left
     // side move it to the right side.
@@ -211,12 +322,14 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
         !operandConstants[1] && op->isCommutative()) {
       std::swap(op->getOpOperand(0), op->getOpOperand(1));
       std::swap(operandConstants[0], operandConstants[1]);
+      changed = true;
     }
 
     // If constant folding was successful, create the result constants, RAUW the
     // operation and remove it.
     resultConstants.clear();
-    if (succeeded(op->constantFold(operandConstants, resultConstants))) {
+    if (isFoldable &&
+        succeeded(op->constantFold(operandConstants, resultConstants))) {
       builder.setInsertionPoint(op);
 
       // Add the operands to the worklist for visitation.
@@ -248,15 +361,18 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
       }
 
       assert(op->hasNoSideEffect() && "Constant folded op with side effects?");
-      op->erase();
+      eraseOp(op);
+      changed = true;
       continue;
     }
 
     // Otherwise see if we can use the generic folder API to simplify the
     // operation.
-    originalOperands.assign(op->operand_begin(), op->operand_end());
     resultValues.clear();
-    if (succeeded(op->fold(resultValues))) {
+    if (isFoldable)
+      originalOperands.assign(op->operand_begin(), op->operand_end());
+    if (isFoldable && succeeded(op->fold(resultValues))) {
+      changed = true;
       // If the result was an in-place simplification (e.g. max(x,x,y) ->
       // max(x,y)) then add the original operands to the worklist so we can make
       // sure to revisit them.
@@ -290,17 +406,190 @@ void GreedyPatternRewriteDriver::simplifyFunction() {
     // Try to match one of the canonicalization patterns. The rewriter is
     // automatically notified of any necessary changes, so there is nothing else
     // to do here.
-    matcher.matchAndRewrite(op);
+    if (matcher.matchAndRewrite(op, *this))
+      changed = true;
   }
+  return changed;
+}
 
-  uniquedConstants.clear();
+//===----------------------------------------------------------------------===//
+// Parallel simplification
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// A top-level operation with regions, e.g. a loop nest, that is simplified
+/// independently of the rest of its function.  While it is simplified, the
+/// operation lives in a function of its own, whose arguments stand in for the
+/// values it uses that are defined outside of it.  This keeps the use-lists of
+/// values that are shared between partitions from being modified concurrently.
+struct RegionPartition {
+  /// Move 'root' into a new function.  Constants used by the partition are
+  /// cloned into it, forming a constant pool private to the partition.
+  void extract(Operation *root);
+
+  /// Move the simplified operations back in front of 'anchor', or at the end
+  /// of 'block' if there is no anchor.  The constant pool of the partition is
+  /// moved to the start of 'entryBlock', where it is uniqued with the rest of
+  /// the function afterwards.
+  void restore(Block *entryBlock);
+
+  /// The position within the original function to restore the partition to.
+  Block *block;
+  Operation *anchor;
+
+  /// The function holding the partition while it is simplified.
+  std::unique_ptr<Function> function;
+
+  /// The values used by the partition that are defined outside of it, one for
+  /// each argument of 'function'.
+  SmallVector<Value *, 8> externalValues;
+};
+} // end anonymous namespace
+
+void RegionPartition::extract(Operation *root) {
+  // Collect the values that are defined within the partition.
+  llvm::DenseSet<Value *> definedValues;
+  root->walk([&](Operation *op) {
+    definedValues.insert(op->result_begin(), op->result_end());
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        definedValues.insert(block.args_begin(), block.args_end());
+  });
+
+  // Collect the values used by the partition that are defined outside of it.
+  // Constants are cloned into the partition rather than passed in, so that
+  // they remain visible to folding.
+  llvm::SetVector<Value *> externalConstants, externals;
+  root->walk([&](Operation *op) {
+    for (auto *operand : op->getOperands()) {
+      if (definedValues.count(operand))
+        continue;
+      auto *defOp = operand->getDefiningOp();
+      if (defOp && defOp->isa<ConstantOp>())
+        externalConstants.insert(operand);
+      else
+        externals.insert(operand);
+    }
+  });
+  externalValues.assign(externals.begin(), externals.end());
+
+  // Create the function to hold the partition.
+  SmallVector<Type, 8> argTypes;
+  for (auto *value : externalValues)
+    argTypes.push_back(value->getType());
+  auto *context = root->getContext();
+  function = llvm::make_unique<Function>(
+      root->getLoc(), "partition", FunctionType::get(argTypes, {}, context));
+  function->addEntryBlock();
+
+  BlockAndValueMapping mapper;
+  for (unsigned i = 0, e = externalValues.size(); i != e; ++i)
+    mapper.map(externalValues[i], function->getArgument(i));
+  FuncBuilder builder(function.get());
+  for (auto *value : externalConstants)
+    mapper.map(value, builder.clone(*value->getDefiningOp())->getResult(0));
+
+  // Remap the external uses, and move the partition into the function.
+  root->walk([&](Operation *op) {
+    for (auto &operand : op->getOpOperands())
+      if (auto *newValue = mapper.lookupOrNull(operand.get()))
+        operand.set(newValue);
+  });
+  auto &entryBlock = function->front();
+  root->moveBefore(&entryBlock, entryBlock.end());
+}
+
+void RegionPartition::restore(Block *entryBlock) {
+  auto &partitionBlock = function->front();
+  for (unsigned i = 0, e = externalValues.size(); i != e; ++i)
+    function->getArgument(i)->replaceAllUsesWith(externalValues[i]);
+
+  auto insertPt = anchor ? Block::iterator(anchor) : block->end();
+  while (!partitionBlock.empty()) {
+    auto &op = partitionBlock.front();
+    if (op.isa<ConstantOp>())
+      op.moveBefore(entryBlock, entryBlock->begin());
+    else
+      op.moveBefore(block, insertPt);
+  }
+  function.reset();
+}
+
+/// Simplify the top-level operations with regions of 'fn' in parallel, and
+/// then the rest of the function.  Returns false if the function does not have
+/// enough independent operations to be worth partitioning.
+static bool simplifyFunctionInParallel(Function &fn,
+                                       const RewritePatternMatcher &matcher) {
+  // Collect the operations that root a partition.
+  llvm::SmallPtrSet<Operation *, 8> roots;
+  for (auto &block : fn)
+    for (auto &op : block)
+      if (op.getNumRegions() != 0 && op.getNumResults() == 0)
+        roots.insert(&op);
+  if (roots.size() < 2)
+    return false;
+
+  // Compute where each partition is restored to before moving any of them.
+  // Adjacent partitions share the same anchor and are restored in order.
+  std::vector<RegionPartition> partitions;
+  partitions.reserve(roots.size());
+  for (auto &block : fn) {
+    for (auto &op : block) {
+      if (!roots.count(&op))
+        continue;
+      auto anchorIt = std::next(Block::iterator(&op));
+      while (anchorIt != block.end() && roots.count(&*anchorIt))
+        ++anchorIt;
+      RegionPartition partition;
+      partition.block = &block;
+      partition.anchor = anchorIt == block.end() ? nullptr : &*anchorIt;
+      partitions.push_back(std::move(partition));
+    }
+  }
+  unsigned partitionIt = 0;
+  for (auto &block : fn)
+    for (auto &op : llvm::make_early_inc_range(block))
+      if (roots.count(&op))
+        partitions[partitionIt++].extract(&op);
+  NumPartitions += partitions.size();
+
+  // Simplify each of the partitions in parallel.
+  parallelForEach(
+      fn.getContext(), partitions.begin(), partitions.end(),
+      [&](RegionPartition &partition) {
+        GreedyPatternRewriteDriver driver(*partition.function, matcher);
+        driver.addAllToWorklist();
+        driver.simplifyFunction(clMaxIterations);
+      });
+
+  // Restore the partitions, and simplify the rest of the function.  This
+  // includes the constant pools of the partitions, which are merged with the
+  // constants of the function.
+  for (auto &partition : partitions)
+    partition.restore(&fn.front());
+
+  GreedyPatternRewriteDriver driver(fn, matcher);
+  for (auto &block : fn)
+    for (auto &op : block)
+      if (!roots.count(&op))
+        op.walk([&](Operation *nested) { driver.addToWorklist(nested); });
+  driver.simplifyFunction(clMaxIterations);
+  return true;
 }
 
 /// Rewrite the specified function by repeatedly applying the highest benefit
 /// patterns in a greedy work-list driven manner.
 ///
-void mlir::applyPatternsGreedily(Function &fn,
+bool mlir::applyPatternsGreedily(Function &fn,
                                  OwningRewritePatternList &&patterns) {
-  GreedyPatternRewriteDriver driver(fn, std::move(patterns));
-  driver.simplifyFunction();
+  RewritePatternMatcher matcher(std::move(patterns));
+
+  // The operations of the partitions aren't revisited once they are merged
+  // back into the function, so the function isn't known to have converged.
+  if (clParallelRewrite && simplifyFunctionInParallel(fn, matcher))
+    return false;
+
+  GreedyPatternRewriteDriver driver(fn, matcher);
+  driver.addAllToWorklist();
+  return driver.simplifyFunction(clMaxIterations);
 }
@@ -25,10 +25,12 @@
 #include "mlir/Analysis/AffineAnalysis.h"
 #include "mlir/Analysis/AffineStructures.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/Utils.h"
 #include "mlir/IR/AffineExpr.h"
 #include "mlir/IR/AffineMap.h"
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
+#include "mlir/IR/IntegerSet.h"
 #include "mlir/IR/Operation.h"
 #include "mlir/StandardOps/Ops.h"
 #include "llvm/ADT/DenseMap.h"
@@ -68,7 +70,7 @@ void mlir::getCleanupLoopLowerBound(AffineForOp forOp, unsigned unrollFactor,
   unsigned step = forOp.getStep();
 
   SmallVector<Value *, 4> lbOperands(forOp.getLowerBoundOperands());
-  auto lb = b->create<AffineApplyOp>(forOp.getLoc(), lbMap, lbOperands);
+  auto lb = makeComposedAffineApply(b, forOp.getLoc(), lbMap, lbOperands);
 
   // For each upper bound expr, get the range.
   // Eg: affine.for %i = lb to min (ub1, ub2),
@@ -83,8 +85,8 @@ void mlir::getCleanupLoopLowerBound(AffineForOp forOp, unsigned unrollFactor,
     auto bumpMap =
         b->getAffineMap(tripCountMap.getNumDims(), tripCountMap.getNumSymbols(),
                         bumpExprs[i], {});
-    bumpValues[i] =
-        b->create<AffineApplyOp>(forOp.getLoc(), bumpMap, tripCountOperands);
+    bumpValues[i] = makeComposedAffineApply(b, forOp.getLoc(), bumpMap,
+                                            tripCountOperands);
   }
 
   SmallVector<AffineExpr, 4> newUbExprs(tripCountMap.getNumResults());
@@ -139,8 +141,8 @@ LogicalResult mlir::promoteIfSingleIteration(AffineForOp forOp) {
         // No need of generating an affine.apply.
         iv->replaceAllUsesWith(lbOperands[0]);
       } else {
-        auto affineApplyOp = builder.create<AffineApplyOp>(
-            op->getLoc(), lb.getMap(), lbOperands);
+        auto affineApplyOp = makeComposedAffineApply(
+            &builder, op->getLoc(), lb.getMap(), lbOperands);
         iv->replaceAllUsesWith(affineApplyOp);
       }
     }
@@ -159,8 +161,7 @@ LogicalResult mlir::promoteIfSingleIteration(AffineForOp forOp) {
 /// their body into the containing Block.
 void mlir::promoteSingleIterationLoops(Function *f) {
   // Gathers all innermost loops through a post order pruned walk.
-  f->walkPostOrder<AffineForOp>(
-      [](AffineForOp forOp) { promoteIfSingleIteration(forOp); });
+  f->walkPostOrder([](AffineForOp forOp) { promoteIfSingleIteration(forOp); });
 }
 
 /// Generates a 'affine.for' op with the specified lower and upper bounds
@@ -378,10 +379,12 @@ LogicalResult mlir::loopUnrollUpToFactor(AffineForOp forOp,
   return loopUnrollByFactor(forOp, unrollFactor);
 }
 
-/// Unrolls this loop by the specified factor. Returns success if the loop
-/// is successfully unrolled.
-LogicalResult mlir::loopUnrollByFactor(AffineForOp forOp,
-                                       uint64_t unrollFactor) {
+/// Unrolls this loop by the specified factor. If 'isTripCountMultiple' is set,
+/// the trip count is assumed to be a multiple of the unroll factor and no
+/// cleanup loop is generated. Returns success if the loop is successfully
+/// unrolled.
+static LogicalResult unrollByFactor(AffineForOp forOp, uint64_t unrollFactor,
+                                    bool isTripCountMultiple) {
   assert(unrollFactor >= 1 && "unroll factor should be >= 1");
 
   if (unrollFactor == 1)
@@ -408,7 +411,8 @@ LogicalResult mlir::loopUnrollByFactor(AffineForOp forOp,
 
   // Generate the cleanup loop if trip count isn't a multiple of unrollFactor.
   Operation *op = forOp.getOperation();
-  if (getLargestDivisorOfTripCount(forOp) % unrollFactor != 0) {
+  if (!isTripCountMultiple &&
+      getLargestDivisorOfTripCount(forOp) % unrollFactor != 0) {
     FuncBuilder builder(op->getBlock(), ++Block::iterator(op));
     auto cleanupForInst = builder.clone(*op)->cast<AffineForOp>();
     AffineMap cleanupMap;
@@ -440,9 +444,13 @@ LogicalResult mlir::loopUnrollByFactor(AffineForOp forOp,
   Block::iterator srcBlockEnd = std::prev(forOp.getBody()->end(), 2);
 
   // Unroll the contents of 'forOp' (append unrollFactor-1 additional copies).
+  // The mapping is shared by all the copies: cloning an operation remaps its
+  // results, and the body is cloned in order, so the value each operand maps
+  // to is always the one of the current copy.  This avoids reallocating its
+  // storage for each copy.
   auto *forOpIV = forOp.getInductionVar();
+  BlockAndValueMapping operandMap;
   for (unsigned i = 1; i < unrollFactor; i++) {
-    BlockAndValueMapping operandMap;
 
     // If the induction variable is used, create a remapping to the value for
     // this unrolled instance.
@@ -467,6 +475,68 @@ LogicalResult mlir::loopUnrollByFactor(AffineForOp forOp,
   return success();
 }
 
+/// Unrolls this loop by the specified factor. Returns success if the loop
+/// is successfully unrolled.
+LogicalResult mlir::loopUnrollByFactor(AffineForOp forOp,
+                                       uint64_t unrollFactor) {
+  return unrollByFactor(forOp, unrollFactor, /*isTripCountMultiple=*/false);
+}
+
+/// Unrolls this loop by the specified factor after versioning it on its trip
+/// count being a multiple of the factor.
+LogicalResult mlir::loopUnrollByFactorVersioned(AffineForOp forOp,
+                                                uint64_t unrollFactor) {
+  // No need to version if the trip count is constant or known to be a
+  // multiple of the factor.
+  if (unrollFactor == 1 || getConstantTripCount(forOp).hasValue() ||
+      getLargestDivisorOfTripCount(forOp) % unrollFactor == 0 ||
+      failed(versionLoopForTripCountMultiple(forOp, unrollFactor)))
+    return loopUnrollByFactor(forOp, unrollFactor);
+  return unrollByFactor(forOp, unrollFactor, /*isTripCountMultiple=*/true);
+}
+
+/// Versions 'forOp' on 'condition' with an 'affine.if' whose 'then' block holds
+/// 'forOp' and whose 'else' block holds its clone, which is returned.
+AffineForOp mlir::versionLoop(AffineForOp forOp, IntegerSet condition,
+                              ArrayRef<Value *> conditionOperands) {
+  Operation *op = forOp.getOperation();
+  FuncBuilder b(op);
+  auto ifOp = b.create<AffineIfOp>(forOp.getLoc(), condition, conditionOperands,
+                                   /*withElseRegion=*/true);
+  Block *thenBlock = &ifOp.getThenBlocks().front();
+  Block *elseBlock = &ifOp.getElseBlocks().front();
+
+  // Clone the fallback version into the 'else' block and move the original
+  // loop into the 'then' block, before their terminators.
+  FuncBuilder elseBuilder(elseBlock, elseBlock->begin());
+  auto fallbackForOp = elseBuilder.clone(*op)->cast<AffineForOp>();
+  op->moveBefore(&thenBlock->front());
+  return fallbackForOp;
+}
+
+/// Versions 'forOp' on its trip count being a multiple of 'multiple'.
+LogicalResult mlir::versionLoopForTripCountMultiple(
+    AffineForOp forOp, uint64_t multiple, AffineForOp *fallbackForOp) {
+  assert(multiple >= 1 && "multiple should be >= 1");
+  AffineMap tripCountMap;
+  SmallVector<Value *, 4> tripCountOperands;
+  buildTripCountMapAndOperands(forOp, &tripCountMap, &tripCountOperands);
+  // A trip count which is a min of several expressions can't be checked with a
+  // single constraint.
+  if (!tripCountMap || tripCountMap.getNumResults() != 1)
+    return failure();
+
+  // The condition is: tripCount mod multiple == 0.
+  FuncBuilder b(forOp.getOperation());
+  auto condition = b.getIntegerSet(
+      tripCountMap.getNumDims(), tripCountMap.getNumSymbols(),
+      tripCountMap.getResult(0) % multiple, /*isEq=*/true);
+  auto fallback = versionLoop(forOp, condition, tripCountOperands);
+  if (fallbackForOp)
+    *fallbackForOp = fallback;
+  return success();
+}
+
 /// Performs loop interchange on 'forOpA' and 'forOpB', where 'forOpB' is
 /// nested within 'forOpA' as the only non-terminator operation in its block.
 void mlir::interchangeLoops(AffineForOp forOpA, AffineForOp forOpB) {
@@ -501,6 +571,95 @@ void mlir::sinkLoop(AffineForOp forOp, unsigned loopDepth) {
   }
 }
 
+void mlir::getLoopNestDependenceComponents(
+    ArrayRef<AffineForOp> loops, ArrayRef<Operation *> ops,
+    std::vector<SmallVector<DependenceComponent, 2>> *depCompsVec,
+    SmallVectorImpl<bool> *isParallelLoop, DependenceAnalysis *dependences) {
+  unsigned numLoops = loops.size();
+  unsigned outerDepth = getNestingDepth(*loops.front().getOperation());
+  if (isParallelLoop)
+    isParallelLoop->assign(numLoops, true);
+  for (unsigned i = 0; i < numLoops; ++i) {
+    unsigned depth = outerDepth + i + 1;
+    for (auto *srcOpInst : ops) {
+      for (auto *dstOpInst : ops) {
+        SmallVector<DependenceComponent, 2> depComps;
+        bool hasDependence;
+        if (dependences) {
+          hasDependence = dependences->checkDependence(srcOpInst, dstOpInst,
+                                                       depth, &depComps);
+        } else {
+          MemRefAccess srcAccess(srcOpInst);
+          MemRefAccess dstAccess(dstOpInst);
+          FlatAffineConstraints dependenceConstraints;
+          hasDependence = checkMemrefAccessDependence(
+              srcAccess, dstAccess, depth, &dependenceConstraints, &depComps);
+        }
+        if (!hasDependence)
+          continue;
+        if (isParallelLoop)
+          (*isParallelLoop)[i] = false;
+        // Only keep the components along the loops of the nest, the outer ones
+        // being zero.
+        assert(depComps.size() >= outerDepth + numLoops);
+        depCompsVec->emplace_back(depComps.begin() + outerDepth,
+                                  depComps.begin() + outerDepth + numLoops);
+      }
+    }
+  }
+}
+
+bool mlir::isValidLoopInterchangePermutation(
+    ArrayRef<SmallVector<DependenceComponent, 2>> depCompsVec,
+    ArrayRef<unsigned> loopPermMap) {
+  unsigned numLoops = loopPermMap.size();
+  SmallVector<unsigned, 4> loopPermMapInv(numLoops);
+  for (unsigned i = 0; i < numLoops; ++i)
+    loopPermMapInv[loopPermMap[i]] = i;
+
+  // Check if the first non-zero dependence component of each dependence, in
+  // the permuted order, is positive.
+  // Example 1: [-1, 1][0, 0]
+  // Example 2: [0, 0][-1, 1]
+  for (auto &depComps : depCompsVec) {
+    assert(depComps.size() >= numLoops);
+    for (unsigned j = 0; j < numLoops; ++j) {
+      auto depCompLb = depComps[loopPermMapInv[j]].lb;
+      if (!depCompLb.hasValue())
+        return false;
+      if (depCompLb.getValue() > 0)
+        break;
+      if (depCompLb.getValue() < 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+AffineForOp mlir::permuteLoops(ArrayRef<AffineForOp> loops,
+                               ArrayRef<unsigned> loopPermMap) {
+  unsigned numLoops = loops.size();
+  assert(loopPermMap.size() == numLoops && "one position expected per loop");
+  SmallVector<AffineForOp, 4> loopPermMapInv(numLoops);
+  for (unsigned i = 0; i < numLoops; ++i)
+    loopPermMapInv[loopPermMap[i]] = loops[i];
+
+  // Fill in the positions from the outermost one, by raising the loop meant to
+  // be there through interchanges with the loops currently above it.
+  SmallVector<AffineForOp, 4> order(loops.begin(), loops.end());
+  for (unsigned pos = 0; pos < numLoops; ++pos) {
+    auto *target = loopPermMapInv[pos].getOperation();
+    unsigned current = pos;
+    while (order[current].getOperation() != target)
+      ++current;
+    for (; current > pos; --current) {
+      interchangeLoops(order[current - 1], order[current]);
+      std::swap(order[current - 1], order[current]);
+    }
+  }
+  return order.front();
+}
+
 // Factors out common behavior to add a new `iv` (resp. `iv` + `offset`) to the
 // lower (resp. upper) loop bound. When called for both the lower and upper
 // bounds, the resulting IR resembles:
@@ -0,0 +1,117 @@
+//===- TargetMemoryModel.cpp - Memory hierarchy of a target ---------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This file implements the description of the memory hierarchy of a target.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Transforms/TargetMemoryModel.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MathExtras.h"
+#include <limits>
+
+using namespace mlir;
+
+#define DEBUG_TYPE "target-memory-model"
+
+static llvm::cl::OptionCategory clOptionsCategory(DEBUG_TYPE " options");
+
+static llvm::cl::opt<unsigned long long>
+    clL1CacheSizeKiB("target-l1-cache-size", llvm::cl::init(32),
+                     llvm::cl::desc("Size of the L1 cache in KiB"),
+                     llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned long long>
+    clL2CacheSizeKiB("target-l2-cache-size", llvm::cl::init(512),
+                     llvm::cl::desc("Size of the L2 cache in KiB"),
+                     llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned>
+    clCacheLineSize("target-cache-line-size", llvm::cl::init(64),
+                    llvm::cl::desc("Size of a cache line in bytes"),
+                    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<double> clL1Bandwidth(
+    "target-l1-bandwidth", llvm::cl::init(64),
+    llvm::cl::desc("Bandwidth of the L1 cache in bytes per cycle"),
+    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<double> clL2Bandwidth(
+    "target-l2-bandwidth", llvm::cl::init(32),
+    llvm::cl::desc("Bandwidth of the L2 cache in bytes per cycle"),
+    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<double> clMemoryBandwidth(
+    "target-memory-bandwidth", llvm::cl::init(8),
+    llvm::cl::desc("Bandwidth of the memory in bytes per cycle"),
+    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned>
+    clVectorWidth("target-vector-width", llvm::cl::init(32),
+                  llvm::cl::desc("Width of a vector register in bytes"),
+                  llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned>
+    clNumVectorRegisters("target-num-vector-registers", llvm::cl::init(16),
+                         llvm::cl::desc("Number of vector registers"),
+                         llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<unsigned long long> clFastMemoryCapacityKiB(
+    "target-fast-mem-capacity",
+    llvm::cl::desc("Capacity of the fast memory space in KiB (default: "
+                   "unlimited)"),
+    llvm::cl::cat(clOptionsCategory));
+
+TargetMemoryModel::TargetMemoryModel(ArrayRef<CacheLevel> cacheLevels,
+                                     double memoryBandwidthBytesPerCycle,
+                                     uint64_t fastMemCapacityBytes,
+                                     unsigned vectorWidthBytes,
+                                     unsigned numVectorRegisters)
+    : cacheLevels(cacheLevels.begin(), cacheLevels.end()),
+      memoryBandwidthBytesPerCycle(memoryBandwidthBytesPerCycle),
+      fastMemCapacityBytes(fastMemCapacityBytes),
+      vectorWidthBytes(vectorWidthBytes),
+      numVectorRegisters(numVectorRegisters) {
+  assert(!cacheLevels.empty() && "expected at least one cache level");
+  assert(memoryBandwidthBytesPerCycle > 0 && "expected a positive bandwidth");
+  assert(vectorWidthBytes > 0 && "expected a positive vector width");
+}
+
+TargetMemoryModel::~TargetMemoryModel() {}
+
+TargetMemoryModel TargetMemoryModel::getDefault() {
+  CacheLevel l1 = {clL1CacheSizeKiB * 1024, clCacheLineSize, clL1Bandwidth};
+  CacheLevel l2 = {clL2CacheSizeKiB * 1024, clCacheLineSize, clL2Bandwidth};
+  uint64_t fastMemCapacityBytes =
+      clFastMemoryCapacityKiB.getNumOccurrences() > 0
+          ? clFastMemoryCapacityKiB * 1024
+          : std::numeric_limits<uint64_t>::max();
+  return TargetMemoryModel({l1, l2}, clMemoryBandwidth, fastMemCapacityBytes,
+                           clVectorWidth, clNumVectorRegisters);
+}
+
+bool TargetMemoryModel::fitsInCache(uint64_t workingSetBytes) const {
+  return workingSetBytes <= getLastLevelCache().capacityBytes;
+}
+
+uint64_t TargetMemoryModel::getStreamTraffic(uint64_t workingSetBytes) const {
+  return llvm::alignTo(workingSetBytes, getLastLevelCache().lineSizeBytes);
+}
+
+double TargetMemoryModel::getTransferCycles(uint64_t numBytes) const {
+  return numBytes / memoryBandwidthBytesPerCycle;
+}
@@ -22,11 +22,14 @@
 
 #include "mlir/AffineOps/AffineOps.h"
 #include "mlir/Analysis/LoopAnalysis.h"
+#include "mlir/Analysis/LoopProfile.h"
+#include "mlir/Analysis/MemRefAccessInterface.h"
 #include "mlir/Analysis/NestedMatcher.h"
 #include "mlir/Analysis/SliceAnalysis.h"
 #include "mlir/Analysis/Utils.h"
 #include "mlir/Analysis/VectorAnalysis.h"
 #include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/Location.h"
 #include "mlir/IR/Types.h"
@@ -35,6 +38,7 @@
 #include "mlir/Support/Functional.h"
 #include "mlir/Support/LLVM.h"
 #include "mlir/Transforms/Passes.h"
+#include "mlir/Transforms/TargetMemoryModel.h"
 #include "mlir/VectorOps/VectorOps.h"
 
 #include "llvm/ADT/DenseMap.h"
@@ -44,6 +48,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace mlir;
@@ -560,6 +565,24 @@ static llvm::cl::list<int> clFastestVaryingPattern(
         " description and examples. This is used for testing purposes"),
     llvm::cl::ZeroOrMore, llvm::cl::cat(clOptionsCategory));
 
+static llvm::cl::opt<bool> clVectorizeCostModel(
+    "vectorize-cost-model",
+    llvm::cl::desc(
+        "Select the loops to vectorize with a cost model based on access"
+        " contiguity, trip counts and the target vector width instead of"
+        " greedily. The virtual vector size defaults to the number of lanes"
+        " of a target vector register"),
+    llvm::cl::cat(clOptionsCategory));
+
+static llvm::cl::opt<bool> clVectorizeReductions(
+    "vectorize-reductions",
+    llvm::cl::desc(
+        "Vectorize the innermost loops carrying a reduction through memory"
+        " into vector partial accumulators, followed by a final reduction"
+        " of the partial accumulators. Floating-point reductions are"
+        " reassociated"),
+    llvm::cl::cat(clOptionsCategory));
+
 /// Forward declaration.
 static FilterFunctionType
 isVectorizableLoopPtrFactory(const llvm::DenseSet<Operation *> &parallelLoops,
@@ -602,6 +625,7 @@ struct Vectorize : public FunctionPass<Vectorize> {
   Vectorize(ArrayRef<int64_t> virtualVectorSize,
             ArrayRef<int64_t> fastestVaryingPattern);
   void runOnFunction() override;
+  void vectorizeWithCostModel(const llvm::DenseSet<Operation *> &parallelLoops);
 
   // The virtual vector size that we vectorize to.
   SmallVector<int64_t, 4> vectorSizes;
@@ -691,6 +715,98 @@ static LogicalResult analyzeProfitability(ArrayRef<NestedMatch> matches,
   return success();
 }
 
+// Benefit of an access contiguous along the vector dimension of a loop,
+// relative to the one of an access invariant along the loop, which becomes a
+// broadcast.
+static constexpr double kContiguousAccessBenefit = 2.0;
+// Cost of an access varying along another memref dimension than the vector
+// dimension of the loop, which becomes a strided or transposed transfer.
+static constexpr double kNonContiguousAccessCost = 2.0;
+
+/// Returns the number of elements of the widest scalar element type accessed
+/// under 'loop' that fit in a vector register of 'vectorWidthBytes' bytes, or
+/// 1 if 'loop' doesn't access any scalar memref.
+static unsigned getNumTargetVectorLanes(AffineForOp loop,
+                                        unsigned vectorWidthBytes) {
+  unsigned maxEltSizeInBits = 0;
+  loop.getOperation()->walk([&](Operation *op) {
+    auto memoryOp = op->dyn_cast<MemRefAccessOpInterface>();
+    if (!memoryOp)
+      return;
+    auto elementType = memoryOp.getMemRefType().getElementType();
+    if (elementType.isIntOrFloat())
+      maxEltSizeInBits =
+          std::max(maxEltSizeInBits, elementType.getIntOrFloatBitWidth());
+  });
+  if (maxEltSizeInBits == 0)
+    return 1;
+  return std::max(1U, vectorWidthBytes * 8 / maxEltSizeInBits);
+}
+
+/// Returns the fraction of the lanes doing useful work when vectorizing 'loop'
+/// with a virtual vector size of 'vectorSize' on a target with 'numLanes'
+/// lanes: the last vector of a known trip count, or one estimated from the
+/// profile given with -loop-profile, may be partial, and a virtual vector that
+/// isn't a multiple of the target vectors leaves lanes unused.
+static double getLaneUtilization(AffineForOp loop, int64_t vectorSize,
+                                 unsigned numLanes) {
+  assert(vectorSize > 0 && "expected a positive vector size");
+  double utilization = 1.0;
+  auto tripCount = getEstimatedTripCount(loop);
+  if (tripCount.hasValue()) {
+    if (tripCount.getValue() == 0)
+      return 0.0;
+    utilization = static_cast<double>(tripCount.getValue()) /
+                  llvm::alignTo(tripCount.getValue(), vectorSize);
+  }
+  return utilization * vectorSize / llvm::alignTo(vectorSize, numLanes);
+}
+
+/// Returns the estimated benefit of vectorizing the loops of `m`, a match at
+/// `depthInPattern` in a pattern of depth `patternDepth`, along the vector
+/// dimensions that vectorizeLoopIfProfitable assigns them. Each loop gains
+/// from the accesses contiguous along its vector dimension and the invariant
+/// ones, scaled by its lane utilization, and loses from the other ones.
+static double getVectorizationBenefit(NestedMatch m, unsigned depthInPattern,
+                                      unsigned patternDepth,
+                                      ArrayRef<int64_t> vectorSizes,
+                                      unsigned numLanes) {
+  double benefit = 0.0;
+  for (auto child : m.getMatchedChildren())
+    benefit += getVectorizationBenefit(child, depthInPattern + 1, patternDepth,
+                                       vectorSizes, numLanes);
+  if (patternDepth - depthInPattern > vectorSizes.size())
+    return benefit;
+
+  // The vector dimension of the loop, as its rank among the fastest varying
+  // ones, which is the one of the memref dimensions it is contiguous along.
+  unsigned vectorDim = patternDepth - depthInPattern - 1;
+  int64_t vectorSize = vectorSizes[vectorSizes.size() - 1 - vectorDim];
+  auto loop = m.getMatchedOperation()->cast<AffineForOp>();
+  auto contiguity = getAccessContiguity(loop);
+  unsigned numContiguous = 0;
+  unsigned numNonContiguous = contiguity.numNonContiguous;
+  for (unsigned d = 0, e = contiguity.numVaryingAlongDim.size(); d < e; ++d) {
+    if (d == vectorDim)
+      numContiguous += contiguity.numVaryingAlongDim[d];
+    else
+      numNonContiguous += contiguity.numVaryingAlongDim[d];
+  }
+  benefit += getLaneUtilization(loop, vectorSize, numLanes) *
+                 (kContiguousAccessBenefit * numContiguous +
+                  contiguity.numInvariant) -
+             kNonContiguousAccessCost * numNonContiguous;
+  return benefit;
+}
+
+/// Returns true if `a` is `b` or one of its ancestors.
+static bool isAncestorOrSelf(Operation *a, Operation *b) {
+  for (; b; b = b->getParentOp())
+    if (a == b)
+      return true;
+  return false;
+}
+
 ///// end TODO(ntv): Hoist to a VectorizationStrategy.cpp when appropriate /////
 
 namespace {
@@ -946,6 +1062,20 @@ static Value *vectorizeConstant(Operation *op, ConstantOp constant, Type type) {
   return b.createOperation(state)->getResult(0);
 }
 
+/// Returns true if `value` is defined above all the loops vectorized by
+/// `strategy`, i.e. if it doesn't vary along them.
+static bool
+isDefinedAboveVectorizedLoops(Value *value,
+                              const VectorizationStrategy *strategy) {
+  auto *ancestor = value->getDefiningOp();
+  if (!ancestor)
+    ancestor = cast<BlockArgument>(value)->getOwner()->getContainingOp();
+  for (; ancestor; ancestor = ancestor->getParentOp())
+    if (strategy->loopToVectorDim.count(ancestor))
+      return false;
+  return true;
+}
+
 /// Tries to vectorize a given operand `op` of Operation `op` during
 /// def-chain propagation or during terminal vectorization, by applying the
 /// following logic:
@@ -955,8 +1085,10 @@ static Value *vectorizeConstant(Operation *op, ConstantOp constant, Type type) {
 ///    vectorize atm (i.e. broadcasting required), returns nullptr to indicate
 ///    failure;
 /// 3. if the `op` is a constant, returns the vectorized form of the constant;
-/// 4. non-constant scalars are currently non-vectorizable, in particular to
-///    guard against vectorizing an index which may be loop-variant and needs
+/// 4. if the `op` is an integer or floating-point scalar defined above the
+///    vectorized loops, returns a vector.broadcast of the scalar;
+/// 5. other non-constant scalars are currently non-vectorizable, in particular
+///    to guard against vectorizing an index which may be loop-variant and needs
 ///    special handling.
 ///
 /// In particular this logic captures some of the use cases where definitions
@@ -993,12 +1125,26 @@ static Value *vectorizeOperand(Value *operand, Operation *op,
     return nullptr;
   }
   // 3. vectorize constant.
-  if (auto constant = operand->getDefiningOp()->dyn_cast<ConstantOp>()) {
-    return vectorizeConstant(
-        op, constant,
-        VectorType::get(state->strategy->vectorSizes, operand->getType()));
+  auto *definingOp = operand->getDefiningOp();
+  if (definingOp) {
+    if (auto constant = definingOp->dyn_cast<ConstantOp>()) {
+      return vectorizeConstant(
+          op, constant,
+          VectorType::get(state->strategy->vectorSizes, operand->getType()));
+    }
   }
-  // 4. currently non-vectorizable.
+  // 4. broadcast the scalars that are the same in all the vectorized
+  // iterations, instead of going through memory.
+  if (operand->getType().isIntOrFloat() &&
+      isDefinedAboveVectorizedLoops(operand, state->strategy)) {
+    LLVM_DEBUG(dbgs() << "-> broadcast");
+    FuncBuilder b(op);
+    auto vectorType =
+        VectorType::get(state->strategy->vectorSizes, operand->getType());
+    return b.create<VectorBroadcastOp>(op->getLoc(), vectorType, operand)
+        .getResult();
+  }
+  // 5. currently non-vectorizable.
   LLVM_DEBUG(dbgs() << "-> non-vectorizable");
   LLVM_DEBUG(operand->print(dbgs()));
   return nullptr;
@@ -1207,6 +1353,158 @@ static LogicalResult vectorizeRootMatch(NestedMatch m,
 
 /// Applies vectorization to the current Function by searching over a bunch of
 /// predetermined patterns.
+/// Rewrites the reduction carried by 'loop' into 'vectorSize' partial
+/// reductions accumulated in a temporary memref, one per lane of the vector,
+/// and a final reduction of the partial accumulators into the original
+/// location. The lane loop then carries no dependence and is vectorized like
+/// any other parallel loop. For example, with a vector size of 128:
+///
+/// ```mlir
+///    affine.for %i = 0 to 1024 {
+///      %a = load %A[%i] : memref<1024xf32>
+///      %s = load %S[%c0] : memref<1xf32>
+///      %r = addf %s, %a : f32
+///      store %r, %S[%c0] : memref<1xf32>
+///    }
+/// ```
+///
+/// becomes:
+///
+/// ```mlir
+///    %p = alloc() : memref<128xf32>
+///    %zero = constant 0.0 : f32
+///    affine.for %l = 0 to 128 {
+///      store %zero, %p[%l] : memref<128xf32>
+///    }
+///    affine.for %i = 0 to 1024 step 128 {
+///      affine.for %l = 0 to 128 {
+///        %ii = affine.apply (d0, d1) -> (d0 + d1) (%i, %l)
+///        %a = load %A[%ii] : memref<1024xf32>
+///        %s = load %p[%l] : memref<128xf32>
+///        %r = addf %s, %a : f32
+///        store %r, %p[%l] : memref<128xf32>
+///      }
+///    }
+///    affine.for %l = 0 to 128 {
+///      %pl = load %p[%l] : memref<128xf32>
+///      %s = load %S[%c0] : memref<1xf32>
+///      %r = addf %s, %pl : f32
+///      store %r, %S[%c0] : memref<1xf32>
+///    }
+///    dealloc %p : memref<128xf32>
+/// ```
+///
+/// The trip count of 'loop' must be a multiple of 'vectorSize'.
+static void privatizeReduction(AffineForOp loop,
+                               const MemRefReduction &reduction,
+                               int64_t vectorSize) {
+  auto accumulatorLoad = reduction.load->cast<LoadOp>();
+  auto accumulatorStore = reduction.store->cast<StoreOp>();
+  auto *combiner = reduction.combiner;
+  auto *memref = accumulatorStore.getMemRef();
+  SmallVector<Value *, 4> indices(accumulatorStore.getIndices());
+  auto elementType = accumulatorStore.getMemRefType().getElementType();
+  auto *loopOp = loop.getOperation();
+  auto loc = loopOp->getLoc();
+
+  // Initialize the partial accumulators with the identity of the combiner.
+  FuncBuilder b(loopOp);
+  auto partials = b.create<AllocOp>(
+      loc, MemRefType::get({vectorSize}, elementType));
+  bool isMul = combiner->isa<MulFOp>() || combiner->isa<MulIOp>();
+  Attribute identityAttr =
+      elementType.isa<FloatType>()
+          ? b.getFloatAttr(elementType, isMul ? 1.0 : 0.0)
+          : b.getIntegerAttr(elementType, isMul ? 1 : 0);
+  auto identity = b.create<ConstantOp>(loc, elementType, identityAttr);
+  auto initLoop = b.create<AffineForOp>(loc, 0, vectorSize);
+  initLoop.getBodyBuilder().create<StoreOp>(loc, identity, partials,
+                                            initLoop.getInductionVar());
+
+  // Strip-mine 'loop' by 'vectorSize' and move its body into the lane loop.
+  int64_t step = loop.getStep();
+  loop.setStep(step * vectorSize);
+  auto *body = loop.getBody();
+  FuncBuilder bodyBuilder(body, body->begin());
+  auto laneLoop = bodyBuilder.create<AffineForOp>(loc, 0, vectorSize);
+  auto *lane = laneLoop.getInductionVar();
+  auto &laneOps = laneLoop.getBody()->getOperations();
+  laneOps.splice(laneOps.begin(), body->getOperations(),
+                 std::next(body->begin()), std::prev(body->end()));
+
+  // Rewrite the uses of the induction variable of 'loop' in terms of the lane.
+  FuncBuilder laneBuilder(laneLoop.getBody(), laneLoop.getBody()->begin());
+  auto d0 = laneBuilder.getAffineDimExpr(0);
+  auto d1 = laneBuilder.getAffineDimExpr(1);
+  auto *iv = loop.getInductionVar();
+  auto laneIv = laneBuilder.create<AffineApplyOp>(
+      loc, laneBuilder.getAffineMap(2, 0, d0 + d1 * step, {}),
+      ArrayRef<Value *>{iv, lane});
+  SmallVector<OpOperand *, 8> ivUses;
+  for (auto &use : iv->getUses())
+    if (use.getOwner() != laneIv.getOperation())
+      ivUses.push_back(&use);
+  for (auto *use : ivUses)
+    use->set(laneIv.getResult());
+
+  // Accumulate into the partial accumulator of the lane.
+  FuncBuilder accumulatorBuilder(accumulatorLoad.getOperation());
+  auto partialLoad =
+      accumulatorBuilder.create<LoadOp>(loc, partials, ArrayRef<Value *>{lane});
+  accumulatorLoad.getResult()->replaceAllUsesWith(partialLoad.getResult());
+  accumulatorLoad.erase();
+  accumulatorBuilder.setInsertionPoint(accumulatorStore.getOperation());
+  accumulatorBuilder.create<StoreOp>(loc, accumulatorStore.getValueToStore(),
+                                     partials, lane);
+  accumulatorStore.erase();
+
+  // Reduce the partial accumulators into the original location.
+  FuncBuilder afterBuilder(loopOp->getBlock(),
+                           std::next(Block::iterator(loopOp)));
+  auto reduceLoop = afterBuilder.create<AffineForOp>(loc, 0, vectorSize);
+  auto reduceBuilder = reduceLoop.getBodyBuilder();
+  auto partial = reduceBuilder.create<LoadOp>(
+      loc, partials, ArrayRef<Value *>{reduceLoop.getInductionVar()});
+  auto accumulator = reduceBuilder.create<LoadOp>(loc, memref, indices);
+  BlockAndValueMapping operandMap;
+  for (auto *operand : combiner->getOperands())
+    operandMap.map(operand, operand == partialLoad.getResult()
+                                ? accumulator.getResult()
+                                : partial.getResult());
+  auto *combined = reduceBuilder.clone(*combiner, operandMap);
+  reduceBuilder.create<StoreOp>(loc, combined->getResult(0), memref, indices);
+  afterBuilder.create<DeallocOp>(loc, partials);
+}
+
+/// Rewrites the innermost loops of 'f' carrying a reduction through memory with
+/// privatizeReduction, so that the reductions are vectorized to the innermost
+/// virtual vector size, or to the number of lanes of the target without one.
+static void privatizeReductions(Function &f, ArrayRef<int64_t> vectorSizes) {
+  unsigned vectorWidthBytes = TargetMemoryModel::getDefault().getVectorWidth();
+  SmallVector<std::pair<AffineForOp, MemRefReduction>, 4> reductions;
+  f.walkPostOrder([&](Operation *op) {
+    auto loop = op->dyn_cast<AffineForOp>();
+    MemRefReduction reduction;
+    if (loop && isVectorizableLoopBody(loop) &&
+        getMemRefReduction(loop, &reduction))
+      reductions.push_back({loop, reduction});
+  });
+  for (auto &it : reductions) {
+    auto loop = it.first;
+    int64_t vectorSize =
+        vectorSizes.empty()
+            ? getNumTargetVectorLanes(loop, vectorWidthBytes)
+            : vectorSizes.back();
+    if (vectorSize <= 1 || getLargestDivisorOfTripCount(loop) % vectorSize) {
+      LLVM_DEBUG(dbgs() << "\n[early-vect] trip count not a multiple of "
+                        << vectorSize << " for reduction ");
+      LLVM_DEBUG(loop.getOperation()->print(dbgs()));
+      continue;
+    }
+    privatizeReduction(loop, it.second, vectorSize);
+  }
+}
+
 void Vectorize::runOnFunction() {
   Function &f = getFunction();
   if (!fastestVaryingPattern.empty() &&
@@ -1220,15 +1518,23 @@ void Vectorize::runOnFunction() {
   // Thread-safe RAII local context, BumpPtrAllocator freed on exit.
   NestedPatternContext mlContext;
 
+  if (clVectorizeReductions)
+    privatizeReductions(f, vectorSizes);
+
   llvm::DenseSet<Operation *> parallelLoops;
   f.walkPostOrder([&parallelLoops](Operation *op) {
     if (auto loop = op->dyn_cast<AffineForOp>()) {
-      if (isLoopParallel(loop)) {
+      if (isLoopParallel(loop) && !isColdLoop(loop)) {
         parallelLoops.insert(op);
       }
     }
   });
 
+  if (clVectorizeCostModel) {
+    vectorizeWithCostModel(parallelLoops);
+    return;
+  }
+
   for (auto &pat :
        makePatterns(parallelLoops, vectorSizes.size(), fastestVaryingPattern)) {
     LLVM_DEBUG(dbgs() << "\n******************************************");
@@ -1260,6 +1566,84 @@ void Vectorize::runOnFunction() {
   LLVM_DEBUG(dbgs() << "\n");
 }
 
+/// Vectorizes the current Function with the matches of the patterns which the
+/// cost model finds the most beneficial. All the matches are scored first, then
+/// the non-intersecting ones with a positive benefit are vectorized in the
+/// order of decreasing benefit. Without a virtual vector size, each match is
+/// vectorized to the number of lanes of the target for its element type.
+void Vectorize::vectorizeWithCostModel(
+    const llvm::DenseSet<Operation *> &parallelLoops) {
+  Function &f = getFunction();
+  unsigned vectorWidthBytes = TargetMemoryModel::getDefault().getVectorWidth();
+  unsigned vectorRank = vectorSizes.empty() ? 1 : vectorSizes.size();
+
+  struct Candidate {
+    NestedMatch match;
+    unsigned patternDepth;
+    SmallVector<int64_t, 4> vectorSizes;
+    double benefit;
+  };
+  std::vector<Candidate> candidates;
+  // Nothing is vectorized before all the matches are scored, so all the
+  // patterns are matched in a single walk of the function.
+  auto patterns =
+      makePatterns(parallelLoops, vectorRank, fastestVaryingPattern);
+  std::vector<SmallVector<NestedMatch, 8>> patternMatches(patterns.size());
+  SmallVector<SmallVectorImpl<NestedMatch> *, 4> matchLists;
+  for (auto &matches : patternMatches)
+    matchLists.push_back(&matches);
+  NestedPattern::match(&f, patterns, matchLists);
+  for (unsigned i = 0, e = patterns.size(); i != e; ++i) {
+    unsigned patternDepth = patterns[i].getDepth();
+    for (auto m : patternMatches[i]) {
+      auto loop = m.getMatchedOperation()->cast<AffineForOp>();
+      unsigned numLanes = getNumTargetVectorLanes(loop, vectorWidthBytes);
+      SmallVector<int64_t, 4> candidateSizes(vectorSizes.begin(),
+                                             vectorSizes.end());
+      if (candidateSizes.empty())
+        candidateSizes.push_back(numLanes);
+      double benefit = getVectorizationBenefit(m, 0, patternDepth,
+                                               candidateSizes, numLanes);
+      LLVM_DEBUG(dbgs() << "\n[early-vect] benefit " << benefit << " for ");
+      LLVM_DEBUG(loop.getOperation()->print(dbgs()));
+      if (benefit > 0.0)
+        candidates.push_back({m, patternDepth, candidateSizes, benefit});
+    }
+  }
+
+  // Select the non-intersecting candidates greedily by decreasing benefit
+  // before vectorizing any of them, since vectorizing a match invalidates the
+  // ones intersecting it.
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate &a, const Candidate &b) {
+                     return a.benefit > b.benefit;
+                   });
+  std::vector<Candidate *> selected;
+  for (auto &candidate : candidates) {
+    auto *root = candidate.match.getMatchedOperation();
+    if (llvm::any_of(selected, [root](Candidate *other) {
+          auto *otherRoot = other->match.getMatchedOperation();
+          return isAncestorOrSelf(root, otherRoot) ||
+                 isAncestorOrSelf(otherRoot, root);
+        }))
+      continue;
+    selected.push_back(&candidate);
+  }
+
+  for (auto *candidate : selected) {
+    VectorizationStrategy strategy;
+    strategy.vectorSizes.assign(candidate->vectorSizes.begin(),
+                                candidate->vectorSizes.end());
+    if (failed(analyzeProfitability(candidate->match.getMatchedChildren(), 1,
+                                    candidate->patternDepth, &strategy)))
+      continue;
+    vectorizeLoopIfProfitable(candidate->match.getMatchedOperation(), 0,
+                              candidate->patternDepth, &strategy);
+    vectorizeRootMatch(candidate->match, &strategy);
+  }
+  LLVM_DEBUG(dbgs() << "\n");
+}
+
 FunctionPassBase *
 mlir::createVectorizePass(llvm::ArrayRef<int64_t> virtualVectorSize) {
   return new Vectorize(virtualVectorSize);
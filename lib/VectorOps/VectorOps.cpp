@@ -33,9 +33,10 @@ using namespace mlir;
 //===----------------------------------------------------------------------===//
 
 VectorOpsDialect::VectorOpsDialect(MLIRContext *context)
-    : Dialect("vector", context) {
-  addOperations<VectorTransferReadOp, VectorTransferWriteOp,
-                VectorTypeCastOp>();
+    : Dialect(getDialectNamespace(), context) {
+  addOperations<VectorTransferReadOp, VectorTransferWriteOp, VectorTypeCastOp,
+                VectorInsertElementOp, VectorShuffleOp, VectorReduceOp,
+                VectorBroadcastOp, VectorShapeCastOp, VectorOuterProductOp>();
 }
 
 //===----------------------------------------------------------------------===//
@@ -426,3 +427,330 @@ LogicalResult VectorTypeCastOp::verify() {
 
   return success();
 }
+
+//===----------------------------------------------------------------------===//
+// VectorInsertElementOp
+//===----------------------------------------------------------------------===//
+void VectorInsertElementOp::build(Builder *builder, OperationState *result,
+                                  Value *value, Value *vector,
+                                  Value *position) {
+  result->addOperands({value, vector, position});
+  result->addTypes(vector->getType());
+}
+
+bool VectorInsertElementOp::parse(OpAsmParser *parser,
+                                  OperationState *result) {
+  OpAsmParser::OperandType valueInfo, vectorInfo;
+  SmallVector<OpAsmParser::OperandType, 1> positionInfo;
+  VectorType type;
+  auto indexType = parser->getBuilder().getIndexType();
+  return parser->parseOperand(valueInfo) || parser->parseComma() ||
+         parser->parseOperand(vectorInfo) ||
+         parser->parseOperandList(positionInfo, 1,
+                                  OpAsmParser::Delimiter::Square) ||
+         parser->parseOptionalAttributeDict(result->attributes) ||
+         parser->parseColonType(type) ||
+         parser->resolveOperand(valueInfo, type.getElementType(),
+                                result->operands) ||
+         parser->resolveOperand(vectorInfo, type, result->operands) ||
+         parser->resolveOperands(positionInfo, indexType, result->operands) ||
+         parser->addTypeToList(type, result->types);
+}
+
+void VectorInsertElementOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " " << *getValue() << ", " << *getVector()
+     << "[" << *getPosition() << "]";
+  p->printOptionalAttrDict(getAttrs());
+  *p << " : " << getVectorType();
+}
+
+LogicalResult VectorInsertElementOp::verify() {
+  auto vectorType = getVector()->getType().dyn_cast<VectorType>();
+  if (!vectorType || vectorType.getRank() != 1)
+    return emitOpError("expects a 1-D vector operand");
+  if (getValue()->getType() != vectorType.getElementType())
+    return emitOpError(
+        "expects the inserted value to have the element type of the vector");
+  if (!getPosition()->getType().isIndex())
+    return emitOpError("expects a position of 'index' type");
+  if (getType() != vectorType)
+    return emitOpError("expects the result to have the type of the vector");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// VectorShuffleOp
+//===----------------------------------------------------------------------===//
+/// Returns the type of a shuffle of vectors of `vectorType` with `numElements`
+/// mask positions.
+static VectorType getShuffleResultType(VectorType vectorType,
+                                       size_t numElements) {
+  return VectorType::get({static_cast<int64_t>(numElements)},
+                         vectorType.getElementType());
+}
+
+void VectorShuffleOp::build(Builder *builder, OperationState *result,
+                            Value *v1, Value *v2, ArrayRef<int64_t> mask) {
+  auto vectorType = v1->getType().cast<VectorType>();
+  SmallVector<Attribute, 8> maskAttrs;
+  maskAttrs.reserve(mask.size());
+  for (int64_t position : mask)
+    maskAttrs.push_back(builder->getI64IntegerAttr(position));
+  result->addOperands({v1, v2});
+  result->addAttribute(getMaskAttrName(), builder->getArrayAttr(maskAttrs));
+  result->addTypes(getShuffleResultType(vectorType, mask.size()));
+}
+
+bool VectorShuffleOp::parse(OpAsmParser *parser, OperationState *result) {
+  SmallVector<OpAsmParser::OperandType, 2> operandInfo;
+  VectorType type;
+  if (parser->parseOperandList(operandInfo, 2) ||
+      parser->parseOptionalAttributeDict(result->attributes) ||
+      parser->parseColonType(type) ||
+      parser->resolveOperands(operandInfo, type, result->operands))
+    return true;
+
+  ArrayAttr mask;
+  for (auto &attr : result->attributes)
+    if (attr.first == getMaskAttrName())
+      mask = attr.second.dyn_cast<ArrayAttr>();
+  if (!mask)
+    return parser->emitError(parser->getNameLoc(),
+                             "expected an array attribute named 'mask'");
+  return parser->addTypeToList(getShuffleResultType(type, mask.size()),
+                               result->types);
+}
+
+void VectorShuffleOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " " << *getOperand(0) << ", " << *getOperand(1);
+  p->printOptionalAttrDict(getAttrs());
+  *p << " : " << getVectorType();
+}
+
+LogicalResult VectorShuffleOp::verify() {
+  auto vectorType = getOperand(0)->getType().dyn_cast<VectorType>();
+  if (!vectorType || vectorType.getRank() != 1)
+    return emitOpError("expects 1-D vector operands");
+  if (getOperand(1)->getType() != vectorType)
+    return emitOpError("expects operands of the same type");
+  auto mask = getMask();
+  if (!mask)
+    return emitOpError("requires an ArrayAttr named 'mask'");
+  int64_t numSourceElements = 2 * vectorType.getNumElements();
+  for (auto position : mask) {
+    auto positionAttr = position.dyn_cast<IntegerAttr>();
+    if (!positionAttr || positionAttr.getInt() < 0 ||
+        positionAttr.getInt() >= numSourceElements)
+      return emitOpError("expects mask positions in [0, " +
+                         Twine(numSourceElements) + ")");
+  }
+  if (getType() != getShuffleResultType(vectorType, mask.size()))
+    return emitOpError("expects a result vector with one element per mask "
+                       "position");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// VectorReduceOp
+//===----------------------------------------------------------------------===//
+void VectorReduceOp::build(Builder *builder, OperationState *result,
+                           StringRef kind, Value *vector) {
+  result->addOperands(vector);
+  result->addAttribute(getKindAttrName(), builder->getStringAttr(kind));
+  result->addTypes(vector->getType().cast<VectorType>().getElementType());
+}
+
+bool VectorReduceOp::parse(OpAsmParser *parser, OperationState *result) {
+  OpAsmParser::OperandType vectorInfo;
+  Attribute kind;
+  VectorType type;
+  if (parser->parseAttribute(kind, getKindAttrName(), result->attributes) ||
+      parser->parseComma() || parser->parseOperand(vectorInfo) ||
+      parser->parseOptionalAttributeDict(result->attributes) ||
+      parser->parseColonType(type) ||
+      parser->resolveOperand(vectorInfo, type, result->operands))
+    return true;
+  if (!kind.isa<StringAttr>())
+    return parser->emitError(parser->getNameLoc(),
+                             "expected a string reduction kind");
+  return parser->addTypeToList(type.getElementType(), result->types);
+}
+
+void VectorReduceOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " ";
+  p->printAttribute(getAttr(getKindAttrName()));
+  *p << ", " << *getOperand();
+  p->printOptionalAttrDict(getAttrs(), /*elidedAttrs=*/{getKindAttrName()});
+  *p << " : " << getVectorType();
+}
+
+LogicalResult VectorReduceOp::verify() {
+  auto vectorType = getOperand()->getType().dyn_cast<VectorType>();
+  if (!vectorType || vectorType.getRank() != 1)
+    return emitOpError("expects a 1-D vector operand");
+  auto elementType = vectorType.getElementType();
+  if (getType() != elementType)
+    return emitOpError(
+        "expects the result to have the element type of the vector");
+  auto kindAttr = getAttrOfType<StringAttr>(getKindAttrName());
+  if (!kindAttr)
+    return emitOpError("requires a StringAttr named 'kind'");
+  auto kind = kindAttr.getValue();
+  bool isInteger = elementType.isa<IntegerType>();
+  if (!isInteger && !elementType.isa<FloatType>())
+    return emitOpError("expects a vector of integers or floats");
+  if (kind == "add" || kind == "mul" || kind == "min" || kind == "max")
+    return success();
+  if (isInteger && (kind == "and" || kind == "or" || kind == "xor"))
+    return success();
+  return emitOpError("unsupported reduction kind '" + kind + "'");
+}
+
+//===----------------------------------------------------------------------===//
+// VectorBroadcastOp
+//===----------------------------------------------------------------------===//
+void VectorBroadcastOp::build(Builder *builder, OperationState *result,
+                              VectorType vectorType, Value *value) {
+  result->addOperands(value);
+  result->addTypes(vectorType);
+}
+
+bool VectorBroadcastOp::parse(OpAsmParser *parser, OperationState *result) {
+  OpAsmParser::OperandType valueInfo;
+  Type valueType, vectorType;
+  return parser->parseOperand(valueInfo) ||
+         parser->parseOptionalAttributeDict(result->attributes) ||
+         parser->parseColonType(valueType) || parser->parseComma() ||
+         parser->parseType(vectorType) ||
+         parser->resolveOperand(valueInfo, valueType, result->operands) ||
+         parser->addTypeToList(vectorType, result->types);
+}
+
+void VectorBroadcastOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " " << *getOperand();
+  p->printOptionalAttrDict(getAttrs());
+  *p << " : " << getOperand()->getType() << ", " << getType();
+}
+
+LogicalResult VectorBroadcastOp::verify() {
+  auto vectorType = getType().dyn_cast<VectorType>();
+  if (!vectorType)
+    return emitOpError("expects a vector result");
+  if (getOperand()->getType() != vectorType.getElementType())
+    return emitOpError(
+        "expects the broadcast value to have the element type of the result");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// VectorShapeCastOp
+//===----------------------------------------------------------------------===//
+void VectorShapeCastOp::build(Builder *builder, OperationState *result,
+                              Value *vector, VectorType resultType) {
+  result->addOperands(vector);
+  result->addTypes(resultType);
+}
+
+bool VectorShapeCastOp::parse(OpAsmParser *parser, OperationState *result) {
+  OpAsmParser::OperandType vectorInfo;
+  Type sourceType, resultType;
+  return parser->parseOperand(vectorInfo) ||
+         parser->parseOptionalAttributeDict(result->attributes) ||
+         parser->parseColonType(sourceType) || parser->parseComma() ||
+         parser->parseType(resultType) ||
+         parser->resolveOperand(vectorInfo, sourceType, result->operands) ||
+         parser->addTypeToList(resultType, result->types);
+}
+
+void VectorShapeCastOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " " << *getOperand();
+  p->printOptionalAttrDict(getAttrs());
+  *p << " : " << getOperand()->getType() << ", " << getType();
+}
+
+LogicalResult VectorShapeCastOp::verify() {
+  auto sourceType = getOperand()->getType().dyn_cast<VectorType>();
+  auto resultType = getType().dyn_cast<VectorType>();
+  if (!sourceType || !resultType)
+    return emitOpError("expects a vector operand and a vector result");
+  if (sourceType.getElementType() != resultType.getElementType())
+    return emitOpError("expects the operand and the result to have the same "
+                       "element type");
+  if (sourceType.getNumElements() != resultType.getNumElements())
+    return emitOpError("expects the operand and the result to have the same "
+                       "number of elements");
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// VectorOuterProductOp
+//===----------------------------------------------------------------------===//
+/// Returns the type of the outer product of vectors of `lhsType` and
+/// `rhsType`.
+static VectorType getOuterProductResultType(VectorType lhsType,
+                                            VectorType rhsType) {
+  return VectorType::get({lhsType.getDimSize(0), rhsType.getDimSize(0)},
+                         lhsType.getElementType());
+}
+
+void VectorOuterProductOp::build(Builder *builder, OperationState *result,
+                                 Value *lhs, Value *rhs, Value *accumulator) {
+  result->addOperands({lhs, rhs});
+  if (accumulator)
+    result->addOperands(accumulator);
+  result->addTypes(
+      getOuterProductResultType(lhs->getType().cast<VectorType>(),
+                                rhs->getType().cast<VectorType>()));
+}
+
+bool VectorOuterProductOp::parse(OpAsmParser *parser, OperationState *result) {
+  SmallVector<OpAsmParser::OperandType, 3> operandInfo;
+  VectorType lhsType, rhsType;
+  if (parser->parseOperandList(operandInfo) ||
+      parser->parseOptionalAttributeDict(result->attributes) ||
+      parser->parseColonType(lhsType) || parser->parseComma() ||
+      parser->parseType(rhsType))
+    return true;
+  if (operandInfo.size() != 2 && operandInfo.size() != 3)
+    return parser->emitError(parser->getNameLoc(),
+                             "expected two operands and an optional "
+                             "accumulator");
+  if (lhsType.getRank() != 1 || rhsType.getRank() != 1)
+    return parser->emitError(parser->getNameLoc(), "expected 1-D vectors");
+  auto resultType = getOuterProductResultType(lhsType, rhsType);
+  return parser->resolveOperand(operandInfo[0], lhsType, result->operands) ||
+         parser->resolveOperand(operandInfo[1], rhsType, result->operands) ||
+         (operandInfo.size() == 3 &&
+          parser->resolveOperand(operandInfo[2], resultType,
+                                 result->operands)) ||
+         parser->addTypeToList(resultType, result->types);
+}
+
+void VectorOuterProductOp::print(OpAsmPrinter *p) {
+  *p << getOperationName() << " ";
+  p->printOperands(getOperation()->getOperands());
+  p->printOptionalAttrDict(getAttrs());
+  *p << " : " << getLHS()->getType() << ", " << getRHS()->getType();
+}
+
+LogicalResult VectorOuterProductOp::verify() {
+  if (getNumOperands() > 3)
+    return emitOpError("expects two operands and an optional accumulator");
+  auto lhsType = getLHS()->getType().dyn_cast<VectorType>();
+  auto rhsType = getRHS()->getType().dyn_cast<VectorType>();
+  if (!lhsType || !rhsType || lhsType.getRank() != 1 ||
+      rhsType.getRank() != 1)
+    return emitOpError("expects 1-D vector operands");
+  if (lhsType.getElementType() != rhsType.getElementType())
+    return emitOpError("expects operands with the same element type");
+  if (!lhsType.getElementType().isa<FloatType>())
+    return emitOpError("expects vectors of floats");
+  auto resultType = getOuterProductResultType(lhsType, rhsType);
+  if (getType() != resultType)
+    return emitOpError("expects a result with the size of the LHS and of the "
+                       "RHS");
+  if (auto *accumulator = getAccumulator())
+    if (accumulator->getType() != resultType)
+      return emitOpError("expects an accumulator of the result type");
+  return success();
+}
@@ -0,0 +1,76 @@
+// RUN: mlir-opt %s -emit-bytecode | mlir-opt | FileCheck %s
+// Verify that eagerly loaded bodies produce the same result.
+// RUN: mlir-translate %s -mlir-to-bytecode | mlir-translate -bytecode-to-mlir | FileCheck %s
+// RUN: mlir-opt %s -emit-bytecode | mlir-opt -mlir-print-debuginfo | FileCheck %s --check-prefix=LOC
+
+// CHECK: #map0 = (d0) -> (d0 + 1)
+
+// CHECK-LABEL: func @external(i32, f32) -> i1
+func @external(i32, f32) -> i1
+
+// CHECK-LABEL: func @attributes()
+func @attributes() {
+  // CHECK: "foo"() {a: true, b: 42 : i32, c: 2.500000e+00 : f16, d: "str", e: i64, f: [1, 2], g: @external : (i32, f32) -> i1} : () -> ()
+  "foo"() {a: true, b: 42 : i32, c: 2.5 : f16, d: "str", e: i64, f: [1, 2], g: @external : (i32, f32) -> i1} : () -> ()
+  // CHECK: "foo"() {dense: dense<tensor<2xi32>, [1, 2]>, map: #map0, splat: splat<tensor<4xf32>, 1.000000e+00>} : () -> ()
+  "foo"() {dense: dense<tensor<2xi32>, [1, 2]>, map: (d0) -> (d0 + 1), splat: splat<tensor<4xf32>, 1.0>} : () -> ()
+  // Dense elements that are all equal are encoded as a single element.
+  // CHECK: "foo"() {int: dense<tensor<2x2xi4>, {{\[\[}}3, 3], [3, 3]]>, float: dense<vector<3xf32>, [2.500000e+00, 2.500000e+00, 2.500000e+00]>} : () -> ()
+  "foo"() {int: dense<tensor<2x2xi4>, [[3, 3], [3, 3]]>, float: dense<vector<3xf32>, [2.5, 2.5, 2.5]>} : () -> ()
+  return
+}
+
+// CHECK-LABEL: func @funcattr(%arg0: i32 {dialect.arg: 1 : i64}) -> i32
+// CHECK-NEXT: attributes {dialect.a: "a\22quoted\22string"}
+func @funcattr(%arg0: i32 {dialect.arg: 1}) -> i32
+  attributes {dialect.a: "a\"quoted\"string"} {
+  return %arg0 : i32
+}
+
+// CHECK-LABEL: func @forward_refs() -> (i16, i8)
+func @forward_refs() -> (i16, i8) {
+  // CHECK: %0:2 = "foo"() : () -> (i1, i17)
+  %0:2 = "foo"() : () -> (i1, i17)
+  br ^bb2
+
+^bb1:
+  // CHECK: %1:2 = "baz"(%2#1, %2#0, %0#1) : (f32, i11, i17) -> (i16, i8)
+  %1:2 = "baz"(%2#1, %2#0, %0#1) : (f32, i11, i17) -> (i16, i8)
+  return %1#0, %1#1 : i16, i8
+
+^bb2:
+  // CHECK: %2:2 = "bar"(%0#0, %0#1) : (i1, i17) -> (i11, f32)
+  %2:2 = "bar"(%0#0, %0#1) : (i1, i17) -> (i11, f32)
+  br ^bb1
+}
+
+// CHECK-LABEL: func @successor_operands(%arg0: i1)
+func @successor_operands(%cond: i1) -> i32 {
+  %c = constant 1 : i32
+  // CHECK: cond_br %arg0, ^bb1(%c1_i32 : i32), ^bb2
+  cond_br %cond, ^bb1(%c : i32), ^bb2
+^bb1(%x: i32):
+  return %x : i32
+^bb2:
+  return %c : i32
+}
+
+// CHECK-LABEL: func @regions
+func @regions(%n : index) {
+  // CHECK: affine.for %i0 = 0 to %arg0 {
+  affine.for %i = 0 to %n {
+    // CHECK-NEXT: "use"(%i0) : (index) -> ()
+    "use"(%i) : (index) -> ()
+  }
+  return
+}
+
+// LOC-LABEL: func @locations
+func @locations() -> i32 {
+  // LOC: "foo"() : () -> i32 loc("foo")
+  %1 = "foo"() : () -> i32 loc("foo")
+  // LOC: constant 4 : index loc(callsite("foo" at "mysource.cc":10:8))
+  %2 = constant 4 : index loc(callsite("foo" at "mysource.cc":10:8))
+  // LOC: return %0 : i32 loc(fused<"myPass">["foo", "mysource.cc":10:8])
+  return %1 : i32 loc(fused<"myPass">["foo", "mysource.cc":10:8])
+}
@@ -580,6 +580,81 @@ TEST_FUNC(vectorize_2d) {
     f->print(llvm::outs());
 }
 
+TEST_FUNC(vector_ops) {
+  using namespace edsc;
+  using namespace edsc::intrinsics;
+  using namespace edsc::op;
+  auto f32Type = FloatType::getF32(&globalContext());
+  auto memrefType = MemRefType::get({-1, -1}, f32Type, {}, 0);
+  auto f = makeFunction("vector_ops", {}, {memrefType, memrefType, f32Type});
+
+  ScopedContext scope(f.get());
+  auto vectorType = VectorType::get({4}, f32Type);
+  auto flatType = VectorType::get({16}, f32Type);
+  auto *builder = ScopedContext::getBuilder();
+  auto map = AffineMap::get(2, 0, {builder->getAffineDimExpr(1)}, {});
+  ValueHandle zero = constant_index(0);
+  ValueHandle A(f->getArgument(0)), B(f->getArgument(1)),
+      alpha(f->getArgument(2));
+  IndexHandle i, j;
+
+  // clang-format off
+  ValueHandle splat = vector_broadcast(vectorType, alpha);
+  LoopNestBuilder({&i, &j}, {zero, zero}, {index_t(8), index_t(8)}, {1, 4})({
+    vector_transfer_write(
+        vector_transfer_read(vectorType, A, {i, j}, map) * splat,
+        B, {i, j}, map),
+  });
+  ValueHandle a = vector_transfer_read(vectorType, A, {zero, zero}, map);
+  ValueHandle b = vector_transfer_read(vectorType, B, {zero, zero}, map);
+  ValueHandle c = vector_outerproduct(a, b);
+  vector_shape_cast(vector_outerproduct(a, b, c), flatType);
+
+  // CHECK-LABEL: func @vector_ops
+  //       CHECK: [[s:%.*]] = vector.broadcast %arg2 : f32, vector<4xf32>
+  //       CHECK: affine.for %i0 = 0 to 8 {
+  //  CHECK-NEXT:   affine.for %i1 = 0 to 8 step 4 {
+  //  CHECK-NEXT:     [[r:%.*]] = vector.transfer_read %arg0[%i0, %i1] {permutation_map: (d0, d1) -> (d1)} : memref<?x?xf32>, vector<4xf32>
+  //  CHECK-NEXT:     [[m:%.*]] = mulf [[r]], [[s]] : vector<4xf32>
+  //  CHECK-NEXT:     vector.transfer_write [[m]], %arg1[%i0, %i1] {permutation_map: (d0, d1) -> (d1)} : vector<4xf32>, memref<?x?xf32>
+  //       CHECK: [[a:%.*]] = vector.transfer_read %arg0
+  //  CHECK-NEXT: [[b:%.*]] = vector.transfer_read %arg1
+  //  CHECK-NEXT: [[c:%.*]] = vector.outerproduct [[a]], [[b]] : vector<4xf32>, vector<4xf32>
+  //  CHECK-NEXT: [[d:%.*]] = vector.outerproduct [[a]], [[b]], [[c]] : vector<4xf32>, vector<4xf32>
+  //  CHECK-NEXT: {{.*}} = vector.shape_cast [[d]] : vector<4x4xf32>, vector<16xf32>
+  // clang-format on
+  f->print(llvm::outs());
+}
+
+TEST_FUNC(parallel_loop_nest) {
+  using namespace edsc;
+  using namespace edsc::intrinsics;
+  using namespace edsc::op;
+  auto memrefType =
+      MemRefType::get({-1, -1}, FloatType::getF32(&globalContext()), {}, 0);
+  auto f = makeFunction("parallel_loop_nest", {}, {memrefType, memrefType});
+
+  ScopedContext scope(f.get());
+  ValueHandle zero = constant_index(0);
+  MemRefView vA(f->getArgument(0));
+  IndexedValue A(f->getArgument(0)), B(f->getArgument(1));
+  IndexHandle i, j, M(vA.ub(0)), N(vA.ub(1));
+
+  // clang-format off
+  ParallelLoopNestBuilder({&i, &j}, {zero, zero}, {M, N}, {1, 1})({
+    B(i, j) = A(i, j) + A(i, j)
+  });
+
+  // CHECK-LABEL: func @parallel_loop_nest
+  //       CHECK: affine.for %i0 {{.*}} {
+  //  CHECK-NEXT:   affine.for %i1 {{.*}} {
+  //       CHECK:     store
+  //  CHECK-NEXT:   } {llvm.loop.parallel: true}
+  //  CHECK-NEXT: } {llvm.loop.parallel: true}
+  // clang-format on
+  f->print(llvm::outs());
+}
+
 int main() {
   RUN_TESTS();
   return 0;
@@ -0,0 +1,2 @@
+// RUN: linalg1-example | FileCheck %S/../../../examples/Linalg/Linalg1/Example.cpp
+// RUN: linalg1-conversion | FileCheck %S/../../../examples/Linalg/Linalg1/Conversion.cpp
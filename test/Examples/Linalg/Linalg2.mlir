@@ -0,0 +1 @@
+// RUN: linalg2-example | FileCheck %S/../../../examples/Linalg/Linalg2/Example.cpp
@@ -0,0 +1,3 @@
+// RUN: linalg3-example | FileCheck %S/../../../examples/Linalg/Linalg3/Example.cpp
+// RUN: linalg3-conversion | FileCheck %S/../../../examples/Linalg/Linalg3/Conversion.cpp
+// RUN: linalg3-execution | FileCheck %S/../../../examples/Linalg/Linalg3/Execution.cpp
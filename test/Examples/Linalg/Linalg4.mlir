@@ -0,0 +1 @@
+// RUN: linalg4-example | FileCheck %S/../../../examples/Linalg/Linalg4/Example.cpp
@@ -0,0 +1,13 @@
+// RUN: linalg-bench -shapes=16x16x19 -tile-sizes=8,8 -iterations=1 | FileCheck %s
+// RUN: linalg-bench -shapes=16x16x19 -lowering=loops -iterations=1 | FileCheck %s
+
+// The keys of the reports are printed in sorted order.
+
+// CHECK: "correct": true,
+// CHECK: "gflops":
+// CHECK: "max_abs_error":
+// CHECK: "min_ms":
+// CHECK: "reference_gflops":
+// CHECK: "reference_min_ms":
+// CHECK: "shape": "16x16x19",
+// CHECK: "speedup":
@@ -0,0 +1,114 @@
+// RUN: mlir-opt %s -split-input-file -fxpmath-convert-to-llvmir | FileCheck %s --dump-input=fail
+// RUN: mlir-opt %s -split-input-file -fxpmath-convert-to-llvmir -fxpmath-llvm-neon | FileCheck %s --check-prefix=NEON --dump-input=fail
+
+// -----
+// Verify the lowering of convertis to a sign extension or a truncation.
+// CHECK-LABEL: func @convertis
+func @convertis(%arg0: i8, %arg1: vector<4xi32>) -> (i32, vector<4xi8>) {
+  // CHECK: llvm.sext %arg0 : !llvm<"i8"> to !llvm<"i32">
+  // CHECK: llvm.trunc %arg1 : !llvm<"<4 x i32>"> to !llvm<"<4 x i8>">
+  %0 = "fxpmath.convertis"(%arg0) : (i8) -> i32
+  %1 = "fxpmath.convertis"(%arg1) : (vector<4xi32>) -> vector<4xi8>
+  return %0, %1 : i32, vector<4xi8>
+}
+
+// -----
+// Verify the lowering of rounding_divide_by_poti to a rounding shift.
+// CHECK-LABEL: func @rounding_divide_by_poti
+func @rounding_divide_by_poti(%arg0: vector<4xi32>) -> vector<4xi32> {
+  // CHECK-DAG: %[[ZERO:.*]] = llvm.constant(splat<vector<4xi32>, 0>) : !llvm<"<4 x i32>">
+  // CHECK-DAG: %[[ONE:.*]] = llvm.constant(splat<vector<4xi32>, 1>) : !llvm<"<4 x i32>">
+  // CHECK-DAG: %[[MASK:.*]] = llvm.constant(splat<vector<4xi32>, 7>) : !llvm<"<4 x i32>">
+  // CHECK: %[[REM:.*]] = llvm.and %arg0, %[[MASK]] : !llvm<"<4 x i32>">
+  // CHECK: %[[NEG:.*]] = llvm.icmp "slt" %arg0, %[[ZERO]] : !llvm<"<4 x i32>">
+  // CHECK-DAG: %[[THRESHOLD_NEG:.*]] = llvm.constant(splat<vector<4xi32>, 4>) : !llvm<"<4 x i32>">
+  // CHECK-DAG: %[[THRESHOLD_POS:.*]] = llvm.constant(splat<vector<4xi32>, 3>) : !llvm<"<4 x i32>">
+  // CHECK: %[[THRESHOLD:.*]] = llvm.select %[[NEG]], %[[THRESHOLD_NEG]], %[[THRESHOLD_POS]] : !llvm<"<4 x i1>">, !llvm<"<4 x i32>">
+  // CHECK: %[[ABOVE:.*]] = llvm.icmp "sgt" %[[REM]], %[[THRESHOLD]] : !llvm<"<4 x i32>">
+  // CHECK: %[[EXPONENT:.*]] = llvm.constant(splat<vector<4xi32>, 3>) : !llvm<"<4 x i32>">
+  // CHECK: %[[SHIFTED:.*]] = llvm.ashr %arg0, %[[EXPONENT]] : !llvm<"<4 x i32>">
+  // CHECK: %[[ROUND:.*]] = llvm.select %[[ABOVE]], %[[ONE]], %[[ZERO]] : !llvm<"<4 x i1>">, !llvm<"<4 x i32>">
+  // CHECK: %[[RESULT:.*]] = llvm.add %[[SHIFTED]], %[[ROUND]] : !llvm<"<4 x i32>">
+  // CHECK: llvm.return %[[RESULT]] : !llvm<"<4 x i32>">
+  %0 = "fxpmath.rounding_divide_by_poti"(%arg0) {exponent: 3 : i32} : (vector<4xi32>) -> vector<4xi32>
+  return %0 : vector<4xi32>
+}
+
+// -----
+// Verify that a division by 1 is folded.
+// CHECK-LABEL: func @rounding_divide_by_one
+func @rounding_divide_by_one(%arg0: i32) -> i32 {
+  // CHECK-NEXT: llvm.return %arg0 : !llvm<"i32">
+  %0 = "fxpmath.rounding_divide_by_poti"(%arg0) {exponent: 0 : i32} : (i32) -> i32
+  return %0 : i32
+}
+
+// -----
+// Verify the lowering of saturating_addi to a clamped addition of twice the
+// width.
+// CHECK-LABEL: func @saturating_addi
+func @saturating_addi(%arg0: i8, %arg1: i8) -> i8 {
+  // CHECK: %[[LHS:.*]] = llvm.sext %arg0 : !llvm<"i8"> to !llvm<"i16">
+  // CHECK: %[[RHS:.*]] = llvm.sext %arg1 : !llvm<"i8"> to !llvm<"i16">
+  // CHECK: %[[SUM:.*]] = llvm.add %[[LHS]], %[[RHS]] : !llvm<"i16">
+  // CHECK-DAG: %[[MIN:.*]] = llvm.constant(-100 : i16) : !llvm<"i16">
+  // CHECK-DAG: %[[MAX:.*]] = llvm.constant(100 : i16) : !llvm<"i16">
+  // CHECK: %[[BELOW:.*]] = llvm.icmp "slt" %[[SUM]], %[[MIN]] : !llvm<"i16">
+  // CHECK: %[[LOW:.*]] = llvm.select %[[BELOW]], %[[MIN]], %[[SUM]] : !llvm<"i1">, !llvm<"i16">
+  // CHECK: %[[ABOVE:.*]] = llvm.icmp "sgt" %[[LOW]], %[[MAX]] : !llvm<"i16">
+  // CHECK: %[[CLAMPED:.*]] = llvm.select %[[ABOVE]], %[[MAX]], %[[LOW]] : !llvm<"i1">, !llvm<"i16">
+  // CHECK: %[[RESULT:.*]] = llvm.trunc %[[CLAMPED]] : !llvm<"i16"> to !llvm<"i8">
+  // CHECK: llvm.return %[[RESULT]] : !llvm<"i8">
+  %0 = "fxpmath.saturating_addi"(%arg0, %arg1) {clamp_min: -100 : i32, clamp_max: 100 : i32} : (i8, i8) -> i8
+  return %0 : i8
+}
+
+// -----
+// Verify the lowering of saturating_subi.
+// CHECK-LABEL: func @saturating_subi
+func @saturating_subi(%arg0: vector<4xi32>, %arg1: vector<4xi32>) -> vector<4xi32> {
+  // CHECK: llvm.sext %arg0 : !llvm<"<4 x i32>"> to !llvm<"<4 x i64>">
+  // CHECK: llvm.sext %arg1 : !llvm<"<4 x i32>"> to !llvm<"<4 x i64>">
+  // CHECK: llvm.sub {{.*}} : !llvm<"<4 x i64>">
+  // CHECK: llvm.trunc {{.*}} : !llvm<"<4 x i64>"> to !llvm<"<4 x i32>">
+  %0 = "fxpmath.saturating_subi"(%arg0, %arg1) {clamp_min: -2147483648 : i32, clamp_max: 2147483647 : i32} : (vector<4xi32>, vector<4xi32>) -> vector<4xi32>
+  return %0 : vector<4xi32>
+}
+
+// -----
+// Verify the lowering of vs_saturating_rounding_doubling_high_mulis to the
+// 64-bit arithmetic, or to the NEON intrinsic.
+// CHECK-LABEL: func @vs_saturating_rounding_doubling_high_mulis
+// NEON-LABEL: func @vs_saturating_rounding_doubling_high_mulis
+func @vs_saturating_rounding_doubling_high_mulis(%arg0: vector<4xi32>) -> vector<4xi32> {
+  // CHECK: %[[X:.*]] = llvm.sext %arg0 : !llvm<"<4 x i32>"> to !llvm<"<4 x i64>">
+  // CHECK: %[[B:.*]] = llvm.constant(splat<vector<4xi64>, 1073741824>) : !llvm<"<4 x i64>">
+  // CHECK: %[[AB:.*]] = llvm.mul %[[X]], %[[B]] : !llvm<"<4 x i64>">
+  // CHECK: llvm.icmp "sge" %[[AB]], {{.*}} : !llvm<"<4 x i64>">
+  // CHECK: %[[NUDGE:.*]] = llvm.select {{.*}} : !llvm<"<4 x i1>">, !llvm<"<4 x i64>">
+  // CHECK: %[[NUDGED:.*]] = llvm.add %[[AB]], %[[NUDGE]] : !llvm<"<4 x i64>">
+  // CHECK: %[[DIVISOR:.*]] = llvm.constant(splat<vector<4xi64>, 2147483648>) : !llvm<"<4 x i64>">
+  // CHECK: %[[HIGH:.*]] = llvm.sdiv %[[NUDGED]], %[[DIVISOR]] : !llvm<"<4 x i64>">
+  // CHECK: %[[RESULT:.*]] = llvm.trunc %[[HIGH]] : !llvm<"<4 x i64>"> to !llvm<"<4 x i32>">
+  // CHECK-NEXT: llvm.return %[[RESULT]] : !llvm<"<4 x i32>">
+  // NEON: %[[B:.*]] = llvm.constant(splat<vector<4xi32>, 1073741824>) : !llvm<"<4 x i32>">
+  // NEON: %[[RESULT:.*]] = llvm.call @llvm.aarch64.neon.sqrdmulh.v4i32(%arg0, %[[B]]) : (!llvm<"<4 x i32>">, !llvm<"<4 x i32>">) -> !llvm<"<4 x i32>">
+  // NEON-NEXT: llvm.return %[[RESULT]] : !llvm<"<4 x i32>">
+  %0 = "fxpmath.vs_saturating_rounding_doubling_high_mulis"(%arg0) {b: 1073741824 : i32} : (vector<4xi32>) -> vector<4xi32>
+  return %0 : vector<4xi32>
+}
+
+// -----
+// Verify that the only overflowing product of the high multiplication is
+// saturated.
+// CHECK-LABEL: func @vs_saturating_rounding_doubling_high_mulis_min
+func @vs_saturating_rounding_doubling_high_mulis_min(%arg0: i32) -> i32 {
+  // CHECK: %[[HIGH:.*]] = llvm.trunc {{.*}} : !llvm<"i64"> to !llvm<"i32">
+  // CHECK-NEXT: %[[MIN:.*]] = llvm.constant(-2147483648 : i32) : !llvm<"i32">
+  // CHECK-NEXT: %[[OVERFLOWS:.*]] = llvm.icmp "eq" %arg0, %[[MIN]] : !llvm<"i32">
+  // CHECK-NEXT: %[[MAX:.*]] = llvm.constant(2147483647 : i32) : !llvm<"i32">
+  // CHECK-NEXT: %[[RESULT:.*]] = llvm.select %[[OVERFLOWS]], %[[MAX]], %[[HIGH]] : !llvm<"i1">, !llvm<"i32">
+  // CHECK-NEXT: llvm.return %[[RESULT]] : !llvm<"i32">
+  %0 = "fxpmath.vs_saturating_rounding_doubling_high_mulis"(%arg0) {b: -2147483648 : i32} : (i32) -> i32
+  return %0 : i32
+}
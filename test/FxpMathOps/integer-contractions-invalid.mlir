@@ -0,0 +1,29 @@
+// RUN: mlir-opt %s -split-input-file -verify
+
+// -----
+func @matmul_mismatched_shapes(%lhs: memref<2x3xi8>, %rhs: memref<4x4xi8>, %acc: memref<2x4xi32>) {
+  // expected-error@+1 {{expected MxK lhs, KxN rhs and MxN acc shapes}}
+  "fxpmath.matmul_accumulatei"(%lhs, %rhs, %acc) : (memref<2x3xi8>, memref<4x4xi8>, memref<2x4xi32>) -> ()
+  return
+}
+
+// -----
+func @matmul_wide_elements(%lhs: memref<2x3xi16>, %rhs: memref<3x4xi8>, %acc: memref<2x4xi32>) {
+  // expected-error@+1 {{expected lhs elements of at most 8 bits}}
+  "fxpmath.matmul_accumulatei"(%lhs, %rhs, %acc) : (memref<2x3xi16>, memref<3x4xi8>, memref<2x4xi32>) -> ()
+  return
+}
+
+// -----
+func @conv2d_invalid_strides(%input: memref<1x7x7x4xi8>, %filter: memref<3x2x4x8xi8>, %acc: memref<1x2x3x8xi32>) {
+  // expected-error@+1 {{expected positive integer strides}}
+  "fxpmath.conv2d_accumulatei"(%input, %filter, %acc) {strides: [0, 2]} : (memref<1x7x7x4xi8>, memref<3x2x4x8xi8>, memref<1x2x3x8xi32>) -> ()
+  return
+}
+
+// -----
+func @conv2d_mismatched_windows(%input: memref<1x7x7x4xi8>, %filter: memref<3x2x4x8xi8>, %acc: memref<1x2x3x8xi32>) {
+  // expected-error@+1 {{expected 3 output windows along spatial dimension 0, got 2}}
+  "fxpmath.conv2d_accumulatei"(%input, %filter, %acc) {strides: [2, 2]} : (memref<1x7x7x4xi8>, memref<3x2x4x8xi8>, memref<1x2x3x8xi32>) -> ()
+  return
+}
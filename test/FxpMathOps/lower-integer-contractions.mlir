@@ -0,0 +1,94 @@
+// RUN: mlir-opt %s -split-input-file -fxpmath-lower-integer-contractions | FileCheck %s --dump-input=fail
+
+// -----
+// Verify lowering of a matmul without zero points to a single loop nest.
+// CHECK-LABEL: matmul_accumulate
+//      CHECK: affine.for [[M:%i[0-9]+]] = 0 to 2 {
+// CHECK-NEXT:   affine.for [[K:%i[0-9]+]] = 0 to 3 {
+// CHECK-NEXT:     affine.for [[N:%i[0-9]+]] = 0 to 4 {
+// CHECK-NEXT:       [[LHS:%[0-9]+]] = load %arg0{{\[}}[[M]], [[K]]] : memref<2x3xi8>
+// CHECK-NEXT:       [[LHS_I32:%[0-9]+]] = "fxpmath.convertis"([[LHS]]) : (i8) -> i32
+// CHECK-NEXT:       [[RHS:%[0-9]+]] = load %arg1{{\[}}[[K]], [[N]]] : memref<3x4xi8>
+// CHECK-NEXT:       [[RHS_I32:%[0-9]+]] = "fxpmath.convertis"([[RHS]]) : (i8) -> i32
+// CHECK-NEXT:       [[PRODUCT:%[0-9]+]] = muli [[LHS_I32]], [[RHS_I32]] : i32
+// CHECK-NEXT:       [[ACC:%[0-9]+]] = load %arg2{{\[}}[[M]], [[N]]] : memref<2x4xi32>
+// CHECK-NEXT:       [[SUM:%[0-9]+]] = addi [[ACC]], [[PRODUCT]] : i32
+// CHECK-NEXT:       store [[SUM]], %arg2{{\[}}[[M]], [[N]]] : memref<2x4xi32>
+// CHECK-NEXT:     }
+// CHECK-NEXT:   }
+// CHECK-NEXT: }
+// CHECK-NEXT: return
+func @matmul_accumulate(%lhs: memref<2x3xi8>, %rhs: memref<3x4xi8>, %acc: memref<2x4xi32>) {
+  "fxpmath.matmul_accumulatei"(%lhs, %rhs, %acc) : (memref<2x3xi8>, memref<3x4xi8>, memref<2x4xi32>) -> ()
+  return
+}
+
+// -----
+// Verify the zero point correction of a matmul:
+//   acc[m, n] += K * zl * zr - zr * sum_k lhs[m, k] - zl * sum_k rhs[k, n]
+// CHECK-LABEL: matmul_accumulate_zero_points
+//      CHECK: muli
+//      CHECK: [[LHS_SUMS:%[0-9]+]] = alloc() : memref<2xi32>
+//      CHECK: affine.for {{%i[0-9]+}} = 0 to 2 {
+//      CHECK:   affine.for {{%i[0-9]+}} = 0 to 3 {
+//      CHECK:     load %arg0
+//      CHECK: [[RHS_SUMS:%[0-9]+]] = alloc() : memref<4xi32>
+//      CHECK: affine.for {{%i[0-9]+}} = 0 to 4 {
+//      CHECK:   affine.for {{%i[0-9]+}} = 0 to 3 {
+//      CHECK:     load %arg1
+//  CHECK-DAG: [[CONSTANT_TERM:%.+]] = constant 6 : i32
+//  CHECK-DAG: [[NEG_LHS_ZP:%.+]] = constant -1 : i32
+//  CHECK-DAG: [[NEG_RHS_ZP:%.+]] = constant -2 : i32
+//      CHECK: affine.for [[M:%i[0-9]+]] = 0 to 2 {
+// CHECK-NEXT:   affine.for [[N:%i[0-9]+]] = 0 to 4 {
+// CHECK-NEXT:     [[LHS_SUM:%[0-9]+]] = load [[LHS_SUMS]]{{\[}}[[M]]] : memref<2xi32>
+// CHECK-NEXT:     [[LHS_TERM:%[0-9]+]] = muli [[NEG_RHS_ZP]], [[LHS_SUM]] : i32
+// CHECK-NEXT:     [[PARTIAL:%[0-9]+]] = addi [[CONSTANT_TERM]], [[LHS_TERM]] : i32
+// CHECK-NEXT:     [[RHS_SUM:%[0-9]+]] = load [[RHS_SUMS]]{{\[}}[[N]]] : memref<4xi32>
+// CHECK-NEXT:     [[RHS_TERM:%[0-9]+]] = muli [[NEG_LHS_ZP]], [[RHS_SUM]] : i32
+// CHECK-NEXT:     [[CORRECTION:%[0-9]+]] = addi [[PARTIAL]], [[RHS_TERM]] : i32
+// CHECK-NEXT:     [[ACC:%[0-9]+]] = load %arg2{{\[}}[[M]], [[N]]] : memref<2x4xi32>
+// CHECK-NEXT:     [[SUM:%[0-9]+]] = addi [[ACC]], [[CORRECTION]] : i32
+// CHECK-NEXT:     store [[SUM]], %arg2{{\[}}[[M]], [[N]]] : memref<2x4xi32>
+//      CHECK: dealloc [[LHS_SUMS]] : memref<2xi32>
+// CHECK-NEXT: dealloc [[RHS_SUMS]] : memref<4xi32>
+func @matmul_accumulate_zero_points(%lhs: memref<2x3xi8>, %rhs: memref<3x4xi8>, %acc: memref<2x4xi32>) {
+  "fxpmath.matmul_accumulatei"(%lhs, %rhs, %acc) {lhs_zero_point: 1 : i32, rhs_zero_point: 2 : i32} : (memref<2x3xi8>, memref<3x4xi8>, memref<2x4xi32>) -> ()
+  return
+}
+
+// -----
+// Verify lowering of a strided conv, the filter channels innermost.
+// CHECK-LABEL: conv2d_accumulate
+//      CHECK: affine.for [[N:%i[0-9]+]] = 0 to 1 {
+// CHECK-NEXT:   affine.for [[OH:%i[0-9]+]] = 0 to 2 {
+// CHECK-NEXT:     affine.for [[OW:%i[0-9]+]] = 0 to 3 {
+// CHECK-NEXT:       affine.for [[KH:%i[0-9]+]] = 0 to 3 {
+// CHECK-NEXT:         affine.for [[KW:%i[0-9]+]] = 0 to 2 {
+// CHECK-NEXT:           affine.for [[C:%i[0-9]+]] = 0 to 4 {
+// CHECK-NEXT:             affine.for [[F:%i[0-9]+]] = 0 to 8 {
+// CHECK-NEXT:               [[H:%[0-9]+]] = affine.apply #map{{[0-9]+}}([[OH]], [[KH]])
+// CHECK-NEXT:               [[W:%[0-9]+]] = affine.apply #map{{[0-9]+}}([[OW]], [[KW]])
+// CHECK-NEXT:               load %arg0{{\[}}[[N]], [[H]], [[W]], [[C]]] : memref<1x5x7x4xi8>
+//      CHECK:               load %arg1{{\[}}[[KH]], [[KW]], [[C]], [[F]]] : memref<3x2x4x8xi8>
+//      CHECK:               muli
+//      CHECK:               store {{%[0-9]+}}, %arg2{{\[}}[[N]], [[OH]], [[OW]], [[F]]] : memref<1x2x3x8xi32>
+//  CHECK-NOT: alloc
+//      CHECK: return
+func @conv2d_accumulate(%input: memref<1x5x7x4xi8>, %filter: memref<3x2x4x8xi8>, %acc: memref<1x2x3x8xi32>) {
+  "fxpmath.conv2d_accumulatei"(%input, %filter, %acc) {strides: [2, 2]} : (memref<1x5x7x4xi8>, memref<3x2x4x8xi8>, memref<1x2x3x8xi32>) -> ()
+  return
+}
+
+// -----
+// Verify that only the sums of the input windows are needed for a filter zero
+// point.
+// CHECK-LABEL: conv2d_accumulate_filter_zero_point
+//      CHECK: alloc() : memref<1x2x3xi32>
+//  CHECK-NOT: alloc
+//      CHECK: dealloc
+// CHECK-NEXT: return
+func @conv2d_accumulate_filter_zero_point(%input: memref<1x5x7x4xi8>, %filter: memref<3x2x4x8xi8>, %acc: memref<1x2x3x8xi32>) {
+  "fxpmath.conv2d_accumulatei"(%input, %filter, %acc) {strides: [2, 2], filter_zero_point: 3 : i32} : (memref<1x5x7x4xi8>, memref<3x2x4x8xi8>, memref<1x2x3x8xi32>) -> ()
+  return
+}
@@ -104,3 +104,31 @@ func @real_addew_unquantized_result(%arg0 : !type_lhs, %arg1: !type_rhs) -> !typ
   %0 = "fxpmath.real_add_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
   return %0 : !type_result
 }
+
+// -----
+// Verify lowering when the lhs is per-axis with the same parameters for all of
+// its slices, like its per-layer equivalent.
+// CHECK-LABEL: real_addew_fixedpoint_uniform_per_axis
+//      CHECK: %0 = "quant.scast"(%arg0) : (tensor<2x2x!quant<"uniform[i8:f32:1]{6.250000e-02,6.250000e-02}">>) -> tensor<2x2xi8>
+// CHECK-NEXT: %1 = "quant.scast"(%arg1) : (tensor<2x2x!quant<"uniform[i8:f32]{6.250000e-02}">>) -> tensor<2x2xi8>
+// CHECK-NEXT: %2 = "fxpmath.saturating_addi"(%0, %1) {clamp_max: 127 : i32, clamp_min: -128 : i32} : (tensor<2x2xi8>, tensor<2x2xi8>) -> tensor<2x2xi8>
+// CHECK-NEXT: %3 = "quant.scast"(%2) : (tensor<2x2xi8>) -> tensor<2x2x!quant<"uniform[i8:f32]{6.250000e-02}">>
+!type_lhs = type tensor<2x2x!quant<"uniform[i8:f32:1]{6.25e-2,6.25e-2}">>
+!type_rhs = type tensor<2x2x!quant<"uniform[i8:f32]{6.25e-2}">>
+!type_result = type tensor<2x2x!quant<"uniform[i8:f32]{6.25e-2}">>
+func @real_addew_fixedpoint_uniform_per_axis(%arg0 : !type_lhs, %arg1: !type_rhs) -> !type_result {
+  %0 = "fxpmath.real_add_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
+  return %0 : !type_result
+}
+
+// -----
+// CHECK-LABEL: real_addew_per_axis_lhs
+// Verifies that leaves as-is for a per-axis lhs with different scales.
+!type_lhs = type tensor<2x2x!quant<"uniform[i8:f32:1]{6.25e-2,7.8125e-03}">>
+!type_rhs = type tensor<2x2x!quant<"uniform[i8:f32]{6.25e-2}">>
+!type_result = type tensor<2x2x!quant<"uniform[i8:f32]{6.25e-2}">>
+func @real_addew_per_axis_lhs(%arg0 : !type_lhs, %arg1: !type_rhs) -> !type_result {
+  // CHECK: %0 = "fxpmath.real_add_ew"(%arg0, %arg1)
+  %0 = "fxpmath.real_add_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
+  return %0 : !type_result
+}
@@ -0,0 +1,63 @@
+// RUN: mlir-opt %s -split-input-file -fxpmath-lower-uniform-real-math | FileCheck %s --dump-input=fail
+
+// -----
+// Verify lowering of a division of narrow operands to a lookup table, indexed
+// by the bits of the lhs followed by those of the rhs. Divisions by zero
+// saturate, and 0 / 0 gives zero.
+// CHECK-LABEL: real_divew_lookup_table
+//      CHECK: [[TABLE:%.+]] = constant dense<tensor<16xi4>, [0, 0, 0, 0, 7, 2, -1, -2, -8, -4, 2, 4, -8, -2, 1, 2]> : tensor<16xi4>
+// CHECK-NEXT: [[LHS:%.+]] = "quant.scast"(%arg0) : (tensor<4x!quant<"uniform[i2:f32]{1.000000e+00}">>) -> tensor<4xi2>
+// CHECK-NEXT: [[RHS:%.+]] = "quant.scast"(%arg1) : (tensor<4x!quant<"uniform[i2:f32]{1.000000e+00}">>) -> tensor<4xi2>
+// CHECK-NEXT: [[RESULT:%.+]] = "fxpmath.lookup_table2i"([[LHS]], [[RHS]], [[TABLE]]) : (tensor<4xi2>, tensor<4xi2>, tensor<16xi4>) -> tensor<4xi4>
+// CHECK-NEXT: [[CAST:%.+]] = "quant.scast"([[RESULT]]) : (tensor<4xi4>) -> tensor<4x!quant<"uniform[i4:f32]{5.000000e-01}">>
+// CHECK-NEXT: return [[CAST]] : tensor<4x!quant<"uniform[i4:f32]{5.000000e-01}">>
+!type_lhs = type tensor<4x!quant<"uniform[i2:f32]{1.0}">>
+!type_rhs = type tensor<4x!quant<"uniform[i2:f32]{1.0}">>
+!type_result = type tensor<4x!quant<"uniform[i4:f32]{0.5}">>
+func @real_divew_lookup_table(%arg0 : !type_lhs, %arg1: !type_rhs) -> !type_result {
+  %0 = "fxpmath.real_div_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
+  return %0 : !type_result
+}
+
+// -----
+// Verify lowering of an element-wise unary function to a lookup table, the
+// negation of -8 saturating to 7.
+// CHECK-LABEL: real_unaryew_neg
+//      CHECK: [[TABLE:%.+]] = constant dense<tensor<16xi4>, [0, -1, -2, -3, -4, -5, -6, -7, 7, 7, 6, 5, 4, 3, 2, 1]> : tensor<16xi4>
+// CHECK-NEXT: [[OPERAND:%.+]] = "quant.scast"(%arg0) : (tensor<4x!quant<"uniform[i4:f32]{1.000000e+00}">>) -> tensor<4xi4>
+// CHECK-NEXT: [[RESULT:%.+]] = "fxpmath.lookup_tablei"([[OPERAND]], [[TABLE]]) : (tensor<4xi4>, tensor<16xi4>) -> tensor<4xi4>
+// CHECK-NEXT: [[CAST:%.+]] = "quant.scast"([[RESULT]]) : (tensor<4xi4>) -> tensor<4x!quant<"uniform[i4:f32]{1.000000e+00}">>
+// CHECK-NEXT: return [[CAST]] : tensor<4x!quant<"uniform[i4:f32]{1.000000e+00}">>
+!type_operand = type tensor<4x!quant<"uniform[i4:f32]{1.0}">>
+!type_result = type tensor<4x!quant<"uniform[i4:f32]{1.0}">>
+func @real_unaryew_neg(%arg0 : !type_operand) -> !type_result {
+  %0 = "fxpmath.real_unary_ew"(%arg0) {fn: "NEG"} : (!type_operand) -> (!type_result)
+  return %0 : !type_result
+}
+
+// -----
+// Verify that the lookups of the same function of 8-bit values share a single
+// table of 256 entries.
+// CHECK-LABEL: real_unaryew_tanh_shared_table
+//      CHECK: [[TABLE:%.+]] = constant dense<tensor<256xi8>,
+//  CHECK-NOT: constant
+//      CHECK: "fxpmath.lookup_tablei"({{.*}}, [[TABLE]]) : (tensor<4xi8>, tensor<256xi8>) -> tensor<4xi8>
+//      CHECK: "fxpmath.lookup_tablei"({{.*}}, [[TABLE]]) : (tensor<4xi8>, tensor<256xi8>) -> tensor<4xi8>
+!type_operand = type tensor<4x!quant<"uniform[i8:f32]{3.125e-02}">>
+!type_result = type tensor<4x!quant<"uniform[i8:f32]{7.8125e-03}">>
+func @real_unaryew_tanh_shared_table(%arg0 : !type_operand, %arg1 : !type_operand) -> (!type_result, !type_result) {
+  %0 = "fxpmath.real_unary_ew"(%arg0) {fn: "TANH"} : (!type_operand) -> (!type_result)
+  %1 = "fxpmath.real_unary_ew"(%arg1) {fn: "TANH"} : (!type_operand) -> (!type_result)
+  return %0, %1 : !type_result, !type_result
+}
+
+// -----
+// CHECK-LABEL: real_unaryew_unknown_fn
+// Verifies that leaves as-is for an unknown function.
+!type_operand = type tensor<4x!quant<"uniform[i4:f32]{1.0}">>
+!type_result = type tensor<4x!quant<"uniform[i4:f32]{1.0}">>
+func @real_unaryew_unknown_fn(%arg0 : !type_operand) -> !type_result {
+  // CHECK: %0 = "fxpmath.real_unary_ew"(%arg0)
+  %0 = "fxpmath.real_unary_ew"(%arg0) {fn: "UNKNOWN"} : (!type_operand) -> (!type_result)
+  return %0 : !type_result
+}
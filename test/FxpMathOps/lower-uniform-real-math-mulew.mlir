@@ -0,0 +1,39 @@
+// RUN: mlir-opt %s -split-input-file -fxpmath-lower-uniform-real-math | FileCheck %s --dump-input=fail
+
+// -----
+// Verify lowering of an affine multiplication to 32-bit integer arithmetic:
+// the real multiplier 0.5 * 0.25 / 1.0 is 2^30 * 2^-31 * 2^-2.
+// CHECK-LABEL: real_mulew_affine
+//  CHECK-DAG: [[LHS_ZP:%.+]] = constant splat<tensor<4xi32>, -3> : tensor<4xi32>
+//  CHECK-DAG: [[RESULT_ZP:%.+]] = constant splat<tensor<4xi32>, -1> : tensor<4xi32>
+//      CHECK: [[LHS:%.+]] = "quant.scast"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{5.000000e-01:3}">>) -> tensor<4xi8>
+// CHECK-NEXT: [[LHS_I32:%.+]] = "fxpmath.convertis"([[LHS]]) : (tensor<4xi8>) -> tensor<4xi32>
+// CHECK-NEXT: [[LHS_OFFSET:%.+]] = addi [[LHS_I32]], [[LHS_ZP]] : tensor<4xi32>
+// CHECK-NEXT: [[RHS:%.+]] = "quant.scast"(%arg1) : (tensor<4x!quant<"uniform[i8:f32]{2.500000e-01}">>) -> tensor<4xi8>
+// CHECK-NEXT: [[RHS_I32:%.+]] = "fxpmath.convertis"([[RHS]]) : (tensor<4xi8>) -> tensor<4xi32>
+// CHECK-NEXT: [[PRODUCT:%.+]] = muli [[LHS_OFFSET]], [[RHS_I32]] : tensor<4xi32>
+// CHECK-NEXT: [[HIGH:%.+]] = "fxpmath.vs_saturating_rounding_doubling_high_mulis"([[PRODUCT]]) {b: 1073741824 : i32} : (tensor<4xi32>) -> tensor<4xi32>
+// CHECK-NEXT: [[SHIFTED:%.+]] = "fxpmath.rounding_divide_by_poti"([[HIGH]]) {exponent: 2 : i32} : (tensor<4xi32>) -> tensor<4xi32>
+// CHECK-NEXT: [[SUM:%.+]] = "fxpmath.saturating_addi"([[SHIFTED]], [[RESULT_ZP]]) {clamp_max: 127 : i32, clamp_min: -128 : i32} : (tensor<4xi32>, tensor<4xi32>) -> tensor<4xi32>
+// CHECK-NEXT: [[RESULT:%.+]] = "fxpmath.convertis"([[SUM]]) : (tensor<4xi32>) -> tensor<4xi8>
+// CHECK-NEXT: [[CAST:%.+]] = "quant.scast"([[RESULT]]) : (tensor<4xi8>) -> tensor<4x!quant<"uniform[i8:f32]{1.000000e+00:-1}">>
+// CHECK-NEXT: return [[CAST]] : tensor<4x!quant<"uniform[i8:f32]{1.000000e+00:-1}">>
+!type_lhs = type tensor<4x!quant<"uniform[i8:f32]{0.5:3}">>
+!type_rhs = type tensor<4x!quant<"uniform[i8:f32]{0.25}">>
+!type_result = type tensor<4x!quant<"uniform[i8:f32]{1.0:-1}">>
+func @real_mulew_affine(%arg0 : !type_lhs, %arg1: !type_rhs) -> !type_result {
+  %0 = "fxpmath.real_mul_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
+  return %0 : !type_result
+}
+
+// -----
+// CHECK-LABEL: real_mulew_unsigned_wide
+// Verifies that leaves as-is for unsigned storage, too wide for a lookup table.
+!type_lhs = type tensor<4x!quant<"uniform[u16:f32]{0.5:3}">>
+!type_rhs = type tensor<4x!quant<"uniform[u16:f32]{0.25}">>
+!type_result = type tensor<4x!quant<"uniform[u16:f32]{1.0}">>
+func @real_mulew_unsigned_wide(%arg0 : !type_lhs, %arg1: !type_rhs) -> !type_result {
+  // CHECK: %0 = "fxpmath.real_mul_ew"(%arg0, %arg1)
+  %0 = "fxpmath.real_mul_ew"(%arg0, %arg1) : (!type_lhs, !type_rhs) -> (!type_result)
+  return %0 : !type_result
+}
@@ -10,6 +10,7 @@
 // CHECK-DAG: #[[map_proj_d0d1_d0:map[0-9]+]] = (d0, d1) -> (d0)
 // CHECK-DAG: #[[map_proj_d0d1_d1:map[0-9]+]] = (d0, d1) -> (d1)
 // CHECK-DAG: #[[map_proj_d0d1_d1d0:map[0-9]+]] = (d0, d1) -> (d1, d0)
+// CHECK-DAG: #[[map_view:map[0-9]+]] = (d0, d1) -> (d0 * 4 + d1 + 64)
 
 // CHECK-LABEL: func @func_with_ops(%arg0: f32) {
 func @func_with_ops(f32) {
@@ -42,6 +43,15 @@ func @standard_instrs(tensor<4x4x?xf32>, f32, i32, index) {
   // CHECK: %3 = addf %2, %2 : f32
   %f3 = addf %f2, %f2 : f32
 
+  // CHECK: %{{[0-9]+}} = mulf %3, %3 {fastmath: ["reassoc", "contract"]} : f32
+  %f_fast = mulf %f3, %f3 {fastmath: ["reassoc", "contract"]} : f32
+
+  // CHECK: %{{[0-9]+}} = fmaf %2, %3, %2 : f32
+  %f_fma = fmaf %f2, %f3, %f2 : f32
+
+  // CHECK: %{{[0-9]+}} = fmaf %3, %3, %2 {fastmath: ["contract"]} : f32
+  %f_fma_contract = "std.fmaf"(%f3, %f3, %f2) {fastmath: ["contract"]} : (f32, f32, f32) -> f32
+
   // CHECK: %4 = addi %arg2, %arg2 : i32
   %i2 = "std.addi"(%i, %i) : (i32,i32) -> i32
 
@@ -320,6 +330,16 @@ func @memref_cast(%arg0: memref<4xf32>, %arg1 : memref<?xf32>) {
   return
 }
 
+// CHECK-LABEL: func @view(%arg0
+func @view(%arg0: memref<256xf32>, %arg1 : memref<?xf32, 2>) {
+  // CHECK: %0 = view %arg0 : memref<256xf32> to memref<8x4xf32, #[[map_view]]>
+  %0 = view %arg0 : memref<256xf32> to memref<8x4xf32, (d0, d1) -> (d0 * 4 + d1 + 64)>
+
+  // CHECK: %1 = view %arg1 : memref<?xf32, 2> to memref<16xf32, 2>
+  %1 = view %arg1 : memref<?xf32, 2> to memref<16xf32, 2>
+  return
+}
+
 // CHECK-LABEL: func @test_dimop(%arg0
 func @test_dimop(%arg0: tensor<4x4x?xf32>) {
   // CHECK: %0 = dim %arg0, 2 : tensor<4x4x?xf32>
@@ -349,3 +369,24 @@ func @test_vector.transfer_ops(%arg0: memref<?x?xf32>) {
   vector.transfer_write %1, %arg0[%c3, %c3] {permutation_map: (d0, d1)->(d1, d0)} : vector<3x7xf32>, memref<?x?xf32>
   return
 }
+
+// CHECK-LABEL: func @test_vector.element_ops(%arg0: vector<4xf32>, %arg1: vector<4xf32>, %arg2: vector<8xi32>, %arg3: f32, %arg4: index)
+func @test_vector.element_ops(%v : vector<4xf32>, %w : vector<4xf32>, %iv : vector<8xi32>, %f : f32, %i : index) {
+  // CHECK: %0 = vector.insert_element %arg3, %arg0[%arg4] : vector<4xf32>
+  %0 = vector.insert_element %f, %v[%i] : vector<4xf32>
+  // CHECK: %1 = vector.shuffle %0, %arg1 {mask: [0, 4, 1, 5, 2, 6]} : vector<4xf32>
+  %1 = vector.shuffle %0, %w {mask: [0, 4, 1, 5, 2, 6]} : vector<4xf32>
+  // CHECK: %2 = vector.reduce "add", %1 : vector<6xf32>
+  %2 = vector.reduce "add", %1 : vector<6xf32>
+  // CHECK: %3 = vector.reduce "xor", %arg2 : vector<8xi32>
+  %3 = vector.reduce "xor", %iv : vector<8xi32>
+  // CHECK: %4 = vector.broadcast %arg3 : f32, vector<2x3xf32>
+  %4 = vector.broadcast %f : f32, vector<2x3xf32>
+  // CHECK: %5 = vector.shape_cast %4 : vector<2x3xf32>, vector<6xf32>
+  %5 = vector.shape_cast %4 : vector<2x3xf32>, vector<6xf32>
+  // CHECK: %6 = vector.outerproduct %arg0, %arg1 : vector<4xf32>, vector<4xf32>
+  %6 = vector.outerproduct %v, %w : vector<4xf32>, vector<4xf32>
+  // CHECK: %7 = vector.outerproduct %arg0, %arg1, %6 : vector<4xf32>, vector<4xf32>
+  %7 = vector.outerproduct %v, %w, %6 : vector<4xf32>, vector<4xf32>
+  return
+}
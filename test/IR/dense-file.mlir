@@ -0,0 +1,21 @@
+// RUN: cd %S && mlir-opt %s | FileCheck %s
+
+// Inputs/dense-blob.bin holds the 32-bit integers 1, 2, 3 and 4.
+
+// CHECK-LABEL: func @dense_file
+func @dense_file() {
+  // CHECK: "foo"() {bar: dense<tensor<4xi32>, "Inputs/dense-blob.bin", 0>} : () -> ()
+  "foo"() {bar: dense<tensor<4xi32>, "Inputs/dense-blob.bin", 0>} : () -> ()
+  // CHECK: "foo"() {bar: dense<vector<1xi32>, "Inputs/dense-blob.bin", 8>} : () -> ()
+  "foo"() {bar: dense<vector<1xi32>, "Inputs/dense-blob.bin", 8>} : () -> ()
+  return
+}
+
+// The data that isn't 64-bit aligned in the file is copied into the context.
+
+// CHECK-LABEL: func @dense_file_misaligned
+func @dense_file_misaligned() {
+  // CHECK: "foo"() {bar: dense<tensor<3xi32>, [2, 3, 4]>} : () -> ()
+  "foo"() {bar: dense<tensor<3xi32>, "Inputs/dense-blob.bin", 4>} : () -> ()
+  return
+}
@@ -0,0 +1,24 @@
+// RUN: mlir-opt %s | FileCheck %s
+// RUN: mlir-opt %s -mlir-print-elementsattrs-with-hex-if-larger=2 | FileCheck %s --check-prefix=HEX
+
+// CHECK-LABEL: func @dense_hex
+// HEX-LABEL: func @dense_hex
+func @dense_hex() {
+  // CHECK: "foo"() {bar: dense<tensor<3xi32>, [1, 171, 3]>} : () -> ()
+  // HEX: "foo"() {bar: dense<tensor<3xi32>, "0x01000000AB00000003000000">} : () -> ()
+  "foo"() {bar: dense<tensor<3xi32>, "0x01000000ab00000003000000">} : () -> ()
+
+  // Sub-byte elements are packed, the first one in the low bits.
+  // CHECK: "foo"() {bar: dense<tensor<2x2xi4>, {{\[\[}}1, 2], [3, 4]]>} : () -> ()
+  // HEX: "foo"() {bar: dense<tensor<2x2xi4>, "0x2143">} : () -> ()
+  "foo"() {bar: dense<tensor<2x2xi4>, "0x2143">} : () -> ()
+
+  // Small attributes and splats are printed element by element.
+  // CHECK: "foo"() {bar: dense<vector<2xi8>, [-1, 1]>} : () -> ()
+  // HEX: "foo"() {bar: dense<vector<2xi8>, [-1, 1]>} : () -> ()
+  "foo"() {bar: dense<vector<2xi8>, "0xFF01">} : () -> ()
+  // CHECK: "foo"() {bar: dense<tensor<4xf32>, [1.000000e+00, 1.000000e+00, 1.000000e+00, 1.000000e+00]>} : () -> ()
+  // HEX: "foo"() {bar: dense<tensor<4xf32>, [1.000000e+00, 1.000000e+00, 1.000000e+00, 1.000000e+00]>} : () -> ()
+  "foo"() {bar: dense<tensor<4xf32>, "0x0000803F0000803F0000803F0000803F">} : () -> ()
+  return
+}
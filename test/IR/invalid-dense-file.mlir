@@ -0,0 +1,20 @@
+// RUN: cd %S && mlir-opt %s -split-input-file -verify
+
+func @dense_file_missing() {
+  "foo"() {bar: dense<tensor<4xi32>, "Inputs/missing.bin", 0>} : () -> () // expected-error {{cannot open file 'Inputs/missing.bin'}}
+  return
+}
+
+// -----
+
+func @dense_file_too_short() {
+  "foo"() {bar: dense<tensor<4xi32>, "Inputs/dense-blob.bin", 8>} : () -> () // expected-error {{file 'Inputs/dense-blob.bin' holds fewer than 16 bytes at offset 8}}
+  return
+}
+
+// -----
+
+func @dense_file_no_offset() {
+  "foo"() {bar: dense<tensor<4xi32>, "Inputs/dense-blob.bin">} : () -> () // expected-error {{expected ','}}
+  return
+}
@@ -518,6 +518,16 @@ func @dma_no_tag_memref(%tag : f32, %c0 : index) {
 
 // -----
 
+func @dma_odd_stride_operands(%c0 : index) {
+  %mref = alloc() : memref<8 x f32>
+  %mref_fast = alloc() : memref<8 x f32, 1>
+  %tag = alloc() : memref<1 x i32>
+  // expected-error@+1 {{expected two stride related operands per stride level}}
+  dma_start %mref[%c0], %mref_fast[%c0], %c0, %tag[%c0], %c0, %c0, %c0 : memref<8 x f32>, memref<8 x f32, 1>, memref<1 x i32>
+}
+
+// -----
+
 func @dma_wait_no_tag_memref(%tag : f32, %c0 : index) {
   // expected-error@+1 {{expected tag to be of memref type}}
   dma_wait %tag[%c0], %arg0 : f32
@@ -528,3 +538,101 @@ func @dma_wait_no_tag_memref(%tag : f32, %c0 : index) {
 func @invalid_cmp_attr(%idx : i32) {
   // expected-error@+1 {{expected string comparison predicate attribute}}
   %cmp = cmpi i1, %idx, %idx : i32
+
+// -----
+
+func @vector_insert_element_type(%v : vector<4xf32>, %i : index, %x : i32) {
+  // expected-error@+1 {{use of value '%x' expects different type than prior uses}}
+  %0 = vector.insert_element %x, %v[%i] : vector<4xf32>
+}
+
+// -----
+
+func @vector_insert_element_rank(%v : vector<4x4xf32>, %i : index, %f : f32) {
+  // expected-error@+1 {{expects a 1-D vector operand}}
+  %0 = vector.insert_element %f, %v[%i] : vector<4x4xf32>
+}
+
+// -----
+
+func @vector_shuffle_mask(%v : vector<4xf32>) {
+  // expected-error@+1 {{expects mask positions in [0, 8)}}
+  %0 = vector.shuffle %v, %v {mask: [0, 8]} : vector<4xf32>
+}
+
+// -----
+
+func @vector_reduce_kind(%v : vector<4xf32>) {
+  // expected-error@+1 {{unsupported reduction kind 'xor'}}
+  %0 = vector.reduce "xor", %v : vector<4xf32>
+}
+
+// -----
+
+func @vector_broadcast_type(%i : i32) {
+  // expected-error@+1 {{expects the broadcast value to have the element type of the result}}
+  %0 = vector.broadcast %i : i32, vector<4xf32>
+}
+
+// -----
+
+func @vector_shape_cast_num_elements(%v : vector<2x3xf32>) {
+  // expected-error@+1 {{expects the operand and the result to have the same number of elements}}
+  %0 = vector.shape_cast %v : vector<2x3xf32>, vector<4xf32>
+}
+
+// -----
+
+func @vector_outerproduct_integers(%v : vector<4xi32>) {
+  // expected-error@+1 {{expects vectors of floats}}
+  %0 = vector.outerproduct %v, %v : vector<4xi32>, vector<4xi32>
+}
+
+// -----
+
+func @vector_outerproduct_accumulator(%v : vector<4xf32>, %w : vector<2xf32>, %acc : vector<4x4xf32>) {
+  // expected-error@+1 {{use of value '%acc' expects different type than prior uses}}
+  %0 = vector.outerproduct %v, %w, %acc : vector<4xf32>, vector<2xf32>
+}
+
+// -----
+
+func @fastmath_flag(%f : f32) {
+  // expected-error@+1 {{unknown fast-math flag 'fastest'}}
+  %0 = addf %f, %f {fastmath: ["fastest"]} : f32
+}
+
+// -----
+
+func @fastmath_not_array(%f : f32) {
+  // expected-error@+1 {{requires 'fastmath' to be an array of strings}}
+  %0 = addf %f, %f {fastmath: "fast"} : f32
+}
+
+// -----
+
+func @view_element_type(%arg0 : memref<256xf32>) {
+  // expected-error@+1 {{requires input and result element types to be the same}}
+  %0 = view %arg0 : memref<256xf32> to memref<16xi32>
+}
+
+// -----
+
+func @view_dynamic_shape(%arg0 : memref<256xf32>) {
+  // expected-error@+1 {{requires the result to have a static shape}}
+  %0 = view %arg0 : memref<256xf32> to memref<?xf32>
+}
+
+// -----
+
+func @view_dynamic_offset(%arg0 : memref<256xf32>) {
+  // expected-error@+1 {{requires the result to have a strided layout with static non-negative strides and offset}}
+  %0 = view %arg0 : memref<256xf32> to memref<16xf32, (d0)[s0] -> (d0 + s0)>
+}
+
+// -----
+
+func @view_out_of_bounds(%arg0 : memref<256xf32>) {
+  // expected-error@+1 {{requires the view to be within its input}}
+  %0 = view %arg0 : memref<256xf32> to memref<8x4xf32, (d0, d1) -> (d0 * 4 + d1 + 225)>
+}
@@ -0,0 +1,21 @@
+// RUN: mlir-opt %s -experimental-mt-parser -split-input-file -verify
+
+func @undefined_function() {
+  // expected-error@+1 {{reference to undefined function 'missing'}}
+  "foo"() {fn: @missing : () -> ()} : () -> ()
+  return
+}
+
+// -----
+
+func @first() {
+  // expected-error@+1 {{use of undeclared SSA value name}}
+  "use"(%undefined) : (i32) -> ()
+  return
+}
+
+func @second() {
+  // expected-error@+1 {{use of undeclared SSA value name}}
+  "use"(%undefined) : (i32) -> ()
+  return
+}
@@ -439,6 +439,22 @@ func @undef() {
 
 // -----
 
+func @undef_leading_zero() {
+  %7 = "xxx"() : () -> i32
+  %x = "xxx"(%07) : (i32)->i32   // expected-error {{use of undeclared SSA value name}}
+  return
+}
+
+// -----
+
+func @redef_numbered() {
+  %0 = "xxx"() : () -> i32 // expected-error {{previously defined here}}
+  %0 = "xxx"() : () -> i32 // expected-error {{redefinition of SSA value '%0'}}
+  return
+}
+
+// -----
+
 func @duplicate_induction_var() {
   affine.for %i = 1 to 10 {   // expected-error {{previously defined here}}
     affine.for %i = 1 to 10 { // expected-error {{redefinition of SSA value '%i'}}
@@ -1074,3 +1090,21 @@ func @bad_complex(complex memref<2x4xi8>>)
 
 // expected-error @+1 {{expected '>' in complex type}}
 func @bad_complex(complex<i32)
+
+// -----
+
+func @elementsattr_hex_no_prefix() -> () {
+  "foo"(){bar: dense<tensor<1xi8>, "FF">} : () -> () // expected-error {{expected hex string starting with '0x'}}
+}
+
+// -----
+
+func @elementsattr_hex_odd() -> () {
+  "foo"(){bar: dense<tensor<1xi8>, "0xF">} : () -> () // expected-error {{expected an even number of hex digits}}
+}
+
+// -----
+
+func @elementsattr_hex_size_mismatch() -> () {
+  "foo"(){bar: dense<tensor<3xi32>, "0x0100000002000000">} : () -> () // expected-error {{expected 12 bytes of hex data for the type}}
+}
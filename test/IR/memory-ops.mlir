@@ -67,6 +67,8 @@ func @dma_ops() {
   %c0 = constant 0 : index
   %stride = constant 32 : index
   %elt_per_stride = constant 16 : index
+  %inner_stride = constant 8 : index
+  %inner_elt_per_stride = constant 4 : index
 
   %A = alloc() : memref<256 x f32, (d0) -> (d0), 0>
   %Ah = alloc() : memref<256 x f32, (d0) -> (d0), 1>
@@ -85,5 +87,11 @@ func @dma_ops() {
   // CHECK-NEXT  dma_start %0[%c0], %1[%c0], %c256, %2[%c0], %c32, %c16 : memref<256xf32>, memref<256xf32, 1>, memref<1xf32>
   // CHECK-NEXT  dma_wait %2[%c0], %c256 : memref<1xf32>
 
+  // DMA with two stride levels
+  dma_start %A[%c0], %Ah[%c0], %num_elements, %tag[%c0], %stride, %elt_per_stride, %inner_stride, %inner_elt_per_stride : memref<256 x f32>, memref<256 x f32, 1>, memref<1 x f32>
+  dma_wait %tag[%c0], %num_elements : memref<1 x f32>
+  // CHECK: dma_start %0[%c0], %1[%c0], %c256, %2[%c0], %c32, %c16, %c8, %c4 : memref<256xf32>, memref<256xf32, 1>, memref<1xf32>
+  // CHECK-NEXT:  dma_wait %2[%c0], %c256 : memref<1xf32>
+
   return
 }
@@ -0,0 +1,30 @@
+// RUN: mlir-opt -print-op-stats -print-op-stats-json -print-op-stats-num-constants=2 %s -o=/dev/null 2>&1 | FileCheck %s
+
+func @external(i32)
+
+func @foo(%arg0: i32) -> tensor<4xi32> {
+  %0 = constant dense<tensor<4xi32>, [1, 2, 3, 4]> : tensor<4xi32>
+  %1 = constant 1 : i32
+  %2 = addi %arg0, %1 : i32
+  %3 = "xla.splat"(%2) : (i32) -> tensor<4xi32>
+  %4 = addi %0, %3 : tensor<4xi32>
+  return %4 : tensor<4xi32>
+}
+
+func @bar(%arg0: index) {
+  %0 = constant dense<tensor<2xf32>, [1.0, 2.0]> : tensor<2xf32>
+  affine.for %i0 = 0 to 10 {
+    affine.for %i1 = 0 to 10 {
+      "foo"(%0) {attr: "some string"} : (tensor<2xf32>) -> ()
+    }
+  }
+  return
+}
+
+// The fields of the JSON objects are printed in alphabetical order.
+// CHECK: {"attributes":{"bytes":{{[0-9]+}},"numUnique":{{[0-9]+}}},"averageOperands":{{[0-9.e+-]+}},"averageUses":{{[0-9.e+-]+}},
+// CHECK-SAME: "dialects":{"":1,"affine":4,"std":7,"xla":1},
+// CHECK-SAME: "functions":[{"maxNestingDepth":0,"name":"foo","numBlocks":1,"numOperations":6},{"maxNestingDepth":2,"name":"bar","numBlocks":3,"numOperations":7}],
+// CHECK-SAME: "largestConstants":[{"bytes":16,"function":"foo","operation":"std.constant","type":"tensor<4xi32>"},{"bytes":8,"function":"bar","operation":"std.constant","type":"tensor<2xf32>"}],
+// CHECK-SAME: "nestingDepths":[9,2,2],"numOperations":13,
+// CHECK-SAME: "operations":{"affine.for":2,"affine.terminator":2,"foo":1,"std.addi":2,"std.constant":3,"std.return":2,"xla.splat":1}}
@@ -0,0 +1,30 @@
+// RUN: mlir-opt %s -experimental-mt-parser | FileCheck %s
+
+#map0 = (d0) -> (d0 + 1)
+!alias = type tensor<4xf32>
+
+// CHECK-LABEL: func @caller(%arg0: i32) -> i32
+func @caller(%arg0: i32) -> i32 {
+  // Reference a function that is defined later in the module.
+  // CHECK: %0 = call @callee(%arg0) : (i32) -> i32
+  %0 = call @callee(%arg0) : (i32) -> i32
+  // CHECK: "foo"() {fn: @callee : (i32) -> i32, map: #map0} : () -> ()
+  "foo"() {fn: @callee : (i32) -> i32, map: #map0} : () -> ()
+  return %0 : i32
+}
+
+// CHECK-LABEL: func @regions(%arg0: index)
+func @regions(%n: index) {
+  // CHECK: affine.for %i0 = 0 to %arg0 {
+  affine.for %i = 0 to %n {
+    "use"(%i) : (index) -> ()
+  }
+  return
+}
+
+// CHECK-LABEL: func @callee(%arg0: i32) -> i32
+func @callee(%arg0: i32) -> i32 {
+  // CHECK: "bar"() : () -> tensor<4xf32>
+  %0 = "bar"() : () -> !alias
+  return %arg0 : i32
+}
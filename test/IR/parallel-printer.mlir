@@ -0,0 +1,54 @@
+// RUN: mlir-opt %s -o %t.sequential
+// RUN: mlir-opt %s -experimental-mt-printer -o %t.parallel
+// RUN: diff %t.sequential %t.parallel
+// RUN: mlir-opt %s -experimental-mt-printer -mlir-max-threads=2 -o %t.limited
+// RUN: diff %t.sequential %t.limited
+// RUN: mlir-opt %s -experimental-mt-printer | FileCheck %s
+
+// The functions are printed by windows of four per thread, and the output is
+// the same when they are consumed as they are printed.
+// RUN: mlir-opt %s -experimental-mt-printer -mlir-max-threads=1 -o %t.window
+// RUN: diff %t.sequential %t.window
+// RUN: mlir-opt %s -consume-output -o %t.consumed
+// RUN: diff %t.sequential %t.consumed
+// RUN: mlir-opt %s -consume-output -experimental-mt-printer -mlir-max-threads=1 -o %t.consumed-parallel
+// RUN: diff %t.sequential %t.consumed-parallel
+
+// CHECK: #map0 = (d0) -> (d0 + 1)
+#map0 = (d0) -> (d0 + 1)
+
+// CHECK: func @external(memref<4xf32, #map0>)
+func @external(memref<4xf32, #map0>)
+
+// CHECK-LABEL: func @first(%arg0: index) -> index
+func @first(%arg0: index) -> index {
+  // CHECK-NEXT: %0 = affine.apply #map0(%arg0)
+  %0 = affine.apply #map0(%arg0)
+  // CHECK-NEXT: return %0 : index
+  return %0 : index
+}
+
+// CHECK-LABEL: func @second(%arg0: i1) -> i32
+func @second(%cond: i1) -> i32 {
+  %c0 = constant 0 : i32
+  %c1 = constant 1 : i32
+  cond_br %cond, ^bb1, ^bb2
+^bb1:
+  return %c0 : i32
+^bb2:
+  return %c1 : i32
+}
+
+// CHECK-LABEL: func @third(%arg0: index)
+func @third(%n: index) {
+  affine.for %i = 0 to %n {
+    %0 = affine.apply #map0(%i)
+  }
+  return
+}
+
+// CHECK-LABEL: func @fourth(%arg0: index) -> index
+func @fourth(%arg0: index) -> index {
+  %0 = call @first(%arg0) : (index) -> index
+  return %0 : index
+}
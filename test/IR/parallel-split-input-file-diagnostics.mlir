@@ -0,0 +1,23 @@
+// RUN: not mlir-opt %s -split-input-file -parallel-split-input-file 2>&1 | FileCheck %s
+
+// The diagnostics of the chunks of a split input file processed in parallel
+// are emitted in the order of the chunks.
+
+// CHECK: split at line #{{[0-9]+}}:{{[0-9]+}}:{{[0-9]+}}: error: 'std.return' op has 1 operands, but enclosing function returns 0
+func @first(%arg0: i32) {
+  return %arg0 : i32
+}
+
+// -----
+
+// CHECK: split at line #{{[0-9]+}}:{{[0-9]+}}:{{[0-9]+}}: error: 'std.return' op has 2 operands, but enclosing function returns 0
+func @second(%arg0: i32) {
+  return %arg0, %arg0 : i32, i32
+}
+
+// -----
+
+// CHECK: split at line #{{[0-9]+}}:{{[0-9]+}}:{{[0-9]+}}: error: 'std.return' op has 3 operands, but enclosing function returns 0
+func @third(%arg0: i32) {
+  return %arg0, %arg0, %arg0 : i32, i32, i32
+}
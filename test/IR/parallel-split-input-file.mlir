@@ -0,0 +1,24 @@
+// RUN: mlir-opt %s -split-input-file -parallel-split-input-file | FileCheck %s
+// RUN: mlir-opt %s -split-input-file -parallel-split-input-file=false | FileCheck %s
+
+// The chunks of a split input file are processed in parallel, but their output
+// is emitted in the order of the chunks.
+
+// CHECK-LABEL: func @first
+func @first() {
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @second
+func @second(%arg0: i32) -> i32 {
+  return %arg0 : i32
+}
+
+// -----
+
+// CHECK-LABEL: func @third
+func @third() {
+  return
+}
@@ -0,0 +1,36 @@
+// RUN: mlir-opt %s -verify
+
+// The functions of a module are verified in parallel, but only the diagnostics
+// of the first function that fails are reported, as with a sequential
+// verification.
+
+func @valid(%arg0: i32) -> i32 {
+  return %arg0 : i32
+}
+
+func @first_failure() {
+^bb0:
+  "foo"(%x) : (i32) -> ()    // expected-error {{operand #0 does not dominate this use}}
+  br ^bb1
+^bb1:
+  %x = "bar"() : () -> i32    // expected-note {{operand defined here}}
+  return
+}
+
+func @second_failure() {
+^bb0:
+  "foo"(%x) : (i32) -> ()
+  br ^bb1
+^bb1:
+  %x = "bar"() : () -> i32
+  return
+}
+
+func @third_failure() {
+^bb0:
+  "foo"(%x) : (i32) -> ()
+  br ^bb1
+^bb1:
+  %x = "bar"() : () -> i32
+  return
+}
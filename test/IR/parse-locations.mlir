@@ -0,0 +1,19 @@
+// RUN: mlir-opt %s -mlir-parse-locations=lines -mlir-print-debuginfo | FileCheck %s --check-prefix=LINES
+// RUN: mlir-opt %s -mlir-parse-locations=none -mlir-print-debuginfo | FileCheck %s --check-prefix=NONE
+
+// LINES-LABEL: func @locations
+// NONE-LABEL: func @locations
+func @locations() -> i32 {
+  // LINES: constant 4 : index loc("{{.*}}parse-locations.mlir":9:0)
+  // NONE: constant 4 : index loc(unknown)
+  %0 = constant 4 : index
+
+  // Explicit locations are kept, unless all the locations are dropped.
+  // LINES: "foo"() : () -> i32 loc("mysource.cc":10:8)
+  // NONE: "foo"() : () -> i32 loc(unknown)
+  %1 = "foo"() : () -> i32 loc("mysource.cc":10:8)
+
+  // LINES: return %0 : i32 loc("{{.*}}parse-locations.mlir":17:0)
+  // NONE: return %0 : i32 loc(unknown)
+  return %1 : i32
+}
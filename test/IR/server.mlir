@@ -0,0 +1,16 @@
+// RUN: mlir-opt -server -cse < %S/Inputs/server-requests.txt | FileCheck %s
+
+// The server processes the requests concurrently, so their responses may come
+// in any order.  A request with no pass names runs the command line passes.
+
+// CHECK-DAG: fold 0 {{[0-9]+}} 0
+// CHECK-DAG: constant 3 : i32
+
+// CHECK-DAG: default 0 {{[0-9]+}} 0
+// CHECK-DAG: return %c42_i32, %c42_i32 : i32, i32
+
+// CHECK-DAG: unknown 1 0 {{[0-9]+}}
+// CHECK-DAG: unknown pass 'no-such-pass'
+
+// CHECK-DAG: invalid 1 0 {{[0-9]+}}
+// CHECK-DAG: <stdin>:2:{{[0-9]+}}: error: custom op 'undefined_op' is unknown
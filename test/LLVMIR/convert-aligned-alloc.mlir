@@ -0,0 +1,40 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+// RUN: mlir-opt -convert-to-llvmir -llvm-alloc-alignment=64 %s | FileCheck %s --check-prefix=ALIGN
+// RUN: mlir-opt -convert-to-llvmir -llvm-alloc-fn=pool_alloc -llvm-dealloc-fn=pool_free %s | FileCheck %s --check-prefix=POOL
+
+// CHECK-LABEL: func @default_alignment
+// ALIGN-LABEL: func @default_alignment
+// POOL-LABEL: func @default_alignment
+func @default_alignment() {
+// CHECK:      %[[SIZE:.*]] = llvm.mul %{{.*}}, %{{.*}} : !llvm<"i64">
+// CHECK-NEXT: llvm.call @malloc(%[[SIZE]]) : (!llvm<"i64">) -> !llvm<"i8*">
+// ALIGN:      %[[SIZE:.*]] = llvm.mul %{{.*}}, %{{.*}} : !llvm<"i64">
+// ALIGN-NEXT: %[[ALIGN:.*]] = llvm.constant(64 : index) : !llvm<"i64">
+// ALIGN-NEXT: %[[ALIGNM1:.*]] = llvm.constant(63 : index) : !llvm<"i64">
+// ALIGN-NEXT: %[[PADDED:.*]] = llvm.add %[[SIZE]], %[[ALIGNM1]] : !llvm<"i64">
+// ALIGN-NEXT: %[[CHUNKS:.*]] = llvm.udiv %[[PADDED]], %[[ALIGN]] : !llvm<"i64">
+// ALIGN-NEXT: %[[ROUNDED:.*]] = llvm.mul %[[CHUNKS]], %[[ALIGN]] : !llvm<"i64">
+// ALIGN-NEXT: llvm.call @aligned_alloc(%[[ALIGN]], %[[ROUNDED]]) : (!llvm<"i64">, !llvm<"i64">) -> !llvm<"i8*">
+// POOL:      %[[SIZE:.*]] = llvm.mul %{{.*}}, %{{.*}} : !llvm<"i64">
+// POOL-NEXT: %[[ALIGN:.*]] = llvm.constant(0 : index) : !llvm<"i64">
+// POOL-NEXT: llvm.call @pool_alloc(%[[SIZE]], %[[ALIGN]]) : (!llvm<"i64">, !llvm<"i64">) -> !llvm<"i8*">
+  %0 = alloc() : memref<16xf32>
+// CHECK: llvm.call @free
+// ALIGN: llvm.call @free
+// POOL:  llvm.call @pool_free
+  dealloc %0 : memref<16xf32>
+  return
+}
+
+// The alignment attribute takes precedence over the default alignment.
+// CHECK-LABEL: func @alignment_attribute
+// ALIGN-LABEL: func @alignment_attribute
+func @alignment_attribute() {
+// CHECK:      %[[ALIGN:.*]] = llvm.constant(128 : index) : !llvm<"i64">
+// CHECK:      llvm.call @aligned_alloc(%[[ALIGN]], %{{.*}})
+// ALIGN:      %[[ALIGN:.*]] = llvm.constant(128 : index) : !llvm<"i64">
+// ALIGN:      llvm.call @aligned_alloc(%[[ALIGN]], %{{.*}})
+  %0 = alloc() {alignment: 128} : memref<16xf32>
+  dealloc %0 : memref<16xf32>
+  return
+}
@@ -0,0 +1,39 @@
+// RUN: mlir-opt -convert-to-llvmir -llvm-alloca-max-bytes=256 %s | FileCheck %s
+
+// CHECK-LABEL: func @promoted
+func @promoted(%arg0: index) {
+// CHECK-NEXT:  %[[SIZE:.*]] = llvm.constant(16 : index) : !llvm<"i64">
+// CHECK-NEXT:  %[[BUF:.*]] = llvm.alloca %[[SIZE]] x !llvm<"float"> : (!llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.br ^bb1
+// The size of a promoted buffer is not computed where it is allocated.
+// CHECK:       ^bb1:
+// CHECK-NOT:   llvm.constant(16 : index)
+// CHECK-NOT:   llvm.call @malloc
+// CHECK-NOT:   llvm.call @free
+// CHECK:       llvm.return
+  br ^bb1
+^bb1:
+  %0 = alloc() : memref<16xf32>
+  %1 = load %0[%arg0] : memref<16xf32>
+  store %1, %0[%arg0] : memref<16xf32>
+  dealloc %0 : memref<16xf32>
+  return
+}
+
+// Buffers larger than the threshold stay on the heap.
+// CHECK-LABEL: func @too_large
+func @too_large() {
+// CHECK: llvm.call @malloc
+// CHECK: llvm.call @free
+  %0 = alloc() : memref<128xf32>
+  dealloc %0 : memref<128xf32>
+  return
+}
+
+// Buffers that escape their function stay on the heap.
+// CHECK-LABEL: func @escaping
+func @escaping() -> memref<16xf32> {
+// CHECK: llvm.call @malloc
+  %0 = alloc() : memref<16xf32>
+  return %0 : memref<16xf32>
+}
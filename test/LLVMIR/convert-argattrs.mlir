@@ -1,4 +1,5 @@
 // RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+// RUN: mlir-opt -convert-to-llvmir -llvm-noalias-static-memref-args %s | FileCheck %s --check-prefix=NOALIAS
 
 
 // CHECK-LABEL: func @check_attributes(%arg0: !llvm<"float*"> {dialect.a: true, dialect.b: 4}) {
@@ -6,3 +7,8 @@ func @check_attributes(%static: memref<10x20xf32> {dialect.a: true, dialect.b: 4
   return
 }
 
+// CHECK-LABEL: func @check_noalias(%arg0: !llvm<"float*">, %arg1: !llvm<"{ float*, i64 }">, %arg2: !llvm<"float*"> {llvm.noalias: false}) {
+// NOALIAS-LABEL: func @check_noalias(%arg0: !llvm<"float*"> {llvm.noalias: true}, %arg1: !llvm<"{ float*, i64 }">, %arg2: !llvm<"float*"> {llvm.noalias: false}) {
+func @check_noalias(%static: memref<10xf32>, %dynamic: memref<?xf32>, %explicit: memref<10xf32> {llvm.noalias: false}) {
+  return
+}
@@ -0,0 +1,31 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+// The functions are converted concurrently: the functions declared by the
+// patterns are sorted by name after the converted ones, whichever conversion
+// declared them first.
+
+// CHECK-LABEL: func @dealloc_only
+func @dealloc_only(%arg0: memref<?xf32>) {
+// CHECK: llvm.call @free
+  dealloc %arg0 : memref<?xf32>
+  return
+}
+
+// CHECK-LABEL: func @alloc_only
+func @alloc_only() -> memref<16xf32> {
+// CHECK: llvm.call @malloc
+  %0 = alloc() : memref<16xf32>
+  return %0 : memref<16xf32>
+}
+
+// CHECK-LABEL: func @alloc_dealloc
+func @alloc_dealloc() {
+// CHECK: llvm.call @malloc
+// CHECK: llvm.call @free
+  %0 = alloc() : memref<4xi32>
+  dealloc %0 : memref<4xi32>
+  return
+}
+
+// CHECK: func @free(!llvm<"i8*">)
+// CHECK-NEXT: func @malloc(!llvm<"i64">) -> !llvm<"i8*">
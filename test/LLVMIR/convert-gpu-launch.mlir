@@ -0,0 +1,49 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+func @kernel(index, index, memref<64xf32>) attributes {gpu.kernel: true}
+
+// The calls marked with "gpu.block_size" go through the GPU runtime, with the
+// parameters passed as an array of pointers to them, allocated on the stack.
+// CHECK-LABEL: func @launch(%arg0: !llvm<"float*">) {
+// CHECK-NEXT:   %[[ONE:.*]] = llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[NUM:.*]] = llvm.constant(3 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[PARAMS:.*]] = llvm.alloca %[[NUM]] x !llvm<"i8*"> : (!llvm<"i64">) -> !llvm<"i8**">
+// CHECK-NEXT:   %[[SLOT0:.*]] = llvm.alloca %[[ONE]] x !llvm<"i64"> : (!llvm<"i64">) -> !llvm<"i64*">
+// CHECK-NEXT:   %[[SLOT1:.*]] = llvm.alloca %[[ONE]] x !llvm<"i64"> : (!llvm<"i64">) -> !llvm<"i64*">
+// CHECK-NEXT:   %[[SLOT2:.*]] = llvm.alloca %[[ONE]] x !llvm<"float*"> : (!llvm<"i64">) -> !llvm<"float**">
+// CHECK:        llvm.store %{{.*}}, %[[SLOT0]] : !llvm<"i64*">
+// CHECK-NEXT:   %[[PTR0:.*]] = llvm.bitcast %[[SLOT0]] : !llvm<"i64*"> to !llvm<"i8*">
+// CHECK-NEXT:   %[[POS0:.*]] = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[ELT0:.*]] = llvm.getelementptr %[[PARAMS]][%[[POS0]]] : (!llvm<"i8**">, !llvm<"i64">) -> !llvm<"i8**">
+// CHECK-NEXT:   llvm.store %[[PTR0]], %[[ELT0]] : !llvm<"i8**">
+// CHECK:        llvm.store %arg0, %[[SLOT2]] : !llvm<"float**">
+// The grid covers the 64 iterations with blocks of 32 threads, each executing
+// 2 iterations.
+// CHECK:        %[[SPAN:.*]] = llvm.sub %{{.*}}, %{{.*}} : !llvm<"i64">
+// CHECK-NEXT:   %[[ROUND:.*]] = llvm.constant(63 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[ROUNDED:.*]] = llvm.add %[[SPAN]], %[[ROUND]] : !llvm<"i64">
+// CHECK-NEXT:   %[[BLOCKSPAN:.*]] = llvm.constant(64 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[GRIDX:.*]] = llvm.sdiv %[[ROUNDED]], %[[BLOCKSPAN]] : !llvm<"i64">
+// CHECK-NEXT:   %[[BLOCKX:.*]] = llvm.constant(32 : index) : !llvm<"i64">
+// CHECK:        %[[THUNK:.*]] = llvm.constant(@kernel_thunk) : !llvm<"void (i8**)*">
+// CHECK-NEXT:   llvm.call @mlir_gpu_launch(%[[THUNK]], %[[GRIDX]], %{{.*}}, %{{.*}}, %[[BLOCKX]], %{{.*}}, %{{.*}}, %[[PARAMS]]) : (!llvm<"void (i8**)*">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i8**">) -> ()
+// CHECK-NOT:    llvm.call @kernel(
+func @launch(%A : memref<64xf32>) {
+  %c0 = constant 0 : index
+  %c64 = constant 64 : index
+  call @kernel(%c0, %c64, %A) {gpu.block_size: [32], gpu.step: [2]} : (index, index, memref<64xf32>) -> ()
+  return
+}
+
+// The thunk loads each parameter through its pointer and calls the kernel.
+// CHECK-LABEL: func @kernel_thunk(%arg0: !llvm<"i8**">) {
+// CHECK-NEXT:   %0 = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT:   %1 = llvm.getelementptr %arg0[%0] : (!llvm<"i8**">, !llvm<"i64">) -> !llvm<"i8**">
+// CHECK-NEXT:   %2 = llvm.load %1 : !llvm<"i8**">
+// CHECK-NEXT:   %3 = llvm.bitcast %2 : !llvm<"i8*"> to !llvm<"i64*">
+// CHECK-NEXT:   %4 = llvm.load %3 : !llvm<"i64*">
+// CHECK:        %[[A:.*]] = llvm.load %{{.*}} : !llvm<"float**">
+// CHECK-NEXT:   llvm.call @kernel(%4, %{{.*}}, %[[A]]) : (!llvm<"i64">, !llvm<"i64">, !llvm<"float*">) -> ()
+// CHECK-NEXT:   llvm.return
+
+// CHECK-LABEL: func @mlir_gpu_launch(!llvm<"void (i8**)*">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i8**">)
@@ -112,38 +112,35 @@ func @zero_d_load(%arg0: memref<f32>) -> f32 {
 
 // CHECK-LABEL: func @static_load
 func @static_load(%static : memref<10x42xf32>, %i : index, %j : index) {
-// CHECK-NEXT:  %0 = llvm.constant(10 : index) : !llvm<"i64">
-// CHECK-NEXT:  %1 = llvm.constant(42 : index) : !llvm<"i64">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.getelementptr %arg0[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  %5 = llvm.load %4 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.constant(42 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.getelementptr %arg0[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %4 = llvm.load %3 : !llvm<"float*">
   %0 = load %static[%i, %j] : memref<10x42xf32>
   return
 }
 
 // CHECK-LABEL: func @mixed_load
 func @mixed_load(%mixed : memref<42x?xf32>, %i : index, %j : index) {
-// CHECK-NEXT:  %0 = llvm.constant(42 : index) : !llvm<"i64">
-// CHECK-NEXT:  %1 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64 }">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64 }">
-// CHECK-NEXT:  %5 = llvm.getelementptr %4[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  %6 = llvm.load %5 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:  %4 = llvm.getelementptr %3[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %5 = llvm.load %4 : !llvm<"float*">
   %0 = load %mixed[%i, %j] : memref<42x?xf32>
   return
 }
 
 // CHECK-LABEL: func @dynamic_load
 func @dynamic_load(%dynamic : memref<?x?xf32>, %i : index, %j : index) {
-// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %1 = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %5 = llvm.getelementptr %4[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  %6 = llvm.load %5 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  %4 = llvm.getelementptr %3[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %5 = llvm.load %4 : !llvm<"float*">
   %0 = load %dynamic[%i, %j] : memref<?x?xf32>
   return
 }
@@ -157,42 +154,72 @@ func @zero_d_store(%arg0: memref<f32>, %arg1: f32) {
 
 // CHECK-LABEL: func @static_store
 func @static_store(%static : memref<10x42xf32>, %i : index, %j : index, %val : f32) {
-// CHECK-NEXT:  %0 = llvm.constant(10 : index) : !llvm<"i64">
-// CHECK-NEXT:  %1 = llvm.constant(42 : index) : !llvm<"i64">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.getelementptr %arg0[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  llvm.store %arg3, %4 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.constant(42 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.getelementptr %arg0[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.store %arg3, %3 : !llvm<"float*">
   store %val, %static[%i, %j] : memref<10x42xf32>
   return
 }
 
+// The accesses marked as in bounds address their element with an inbounds GEP.
+// CHECK-LABEL: func @in_bounds_load_store
+func @in_bounds_load_store(%static : memref<10x42xf32>, %i : index, %j : index) {
+// CHECK:       %[[LPTR:[0-9]+]] = llvm.getelementptr %arg0[%{{[0-9]+}}] {inbounds: true} : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %[[VAL:[0-9]+]] = llvm.load %[[LPTR]] : !llvm<"float*">
+  %0 = load %static[%i, %j] {in_bounds: true} : memref<10x42xf32>
+// CHECK:       %[[SPTR:[0-9]+]] = llvm.getelementptr %arg0[%{{[0-9]+}}] {inbounds: true} : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.store %[[VAL]], %[[SPTR]] : !llvm<"float*">
+  store %0, %static[%i, %j] {in_bounds: true} : memref<10x42xf32>
+  return
+}
+
 // CHECK-LABEL: func @dynamic_store
 func @dynamic_store(%dynamic : memref<?x?xf32>, %i : index, %j : index, %val : f32) {
-// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %1 = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64, i64 }">
-// CHECK-NEXT:  %5 = llvm.getelementptr %4[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  llvm.store %arg3, %5 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  %4 = llvm.getelementptr %3[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.store %arg3, %4 : !llvm<"float*">
   store %val, %dynamic[%i, %j] : memref<?x?xf32>
   return
 }
 
 // CHECK-LABEL: func @mixed_store
 func @mixed_store(%mixed : memref<42x?xf32>, %i : index, %j : index, %val : f32) {
-// CHECK-NEXT:  %0 = llvm.constant(42 : index) : !llvm<"i64">
-// CHECK-NEXT:  %1 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64 }">
-// CHECK-NEXT:  %2 = llvm.mul %arg1, %1 : !llvm<"i64">
-// CHECK-NEXT:  %3 = llvm.add %2, %arg2 : !llvm<"i64">
-// CHECK-NEXT:  %4 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64 }">
-// CHECK-NEXT:  %5 = llvm.getelementptr %4[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
-// CHECK-NEXT:  llvm.store %arg3, %5 : !llvm<"float*">
+// CHECK-NEXT:  %0 = llvm.extractvalue %arg0[1] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:  %4 = llvm.getelementptr %3[%2] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.store %arg3, %4 : !llvm<"float*">
   store %val, %mixed[%i, %j] : memref<42x?xf32>
   return
 }
 
+// The strides are computed once, where the descriptor is defined, and the
+// accesses only multiply the indices by them.
+// CHECK-LABEL: func @strides_in_loop
+func @strides_in_loop(%dynamic : memref<?x4x?xf32>, %i : index, %j : index, %k : index) {
+// CHECK-NEXT:  %[[S2:[0-9]+]] = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  %[[C4:[0-9]+]] = llvm.constant(4 : index) : !llvm<"i64">
+// CHECK-NEXT:  %[[S0:[0-9]+]] = llvm.mul %[[S2]], %[[C4]] : !llvm<"i64">
+// CHECK:       llvm.br ^bb1
+  br ^bb1
+// CHECK:     ^bb1:
+// CHECK-NEXT:  %[[M0:[0-9]+]] = llvm.mul %arg1, %[[S0]] : !llvm<"i64">
+// CHECK-NEXT:  %[[M1:[0-9]+]] = llvm.mul %arg2, %[[S2]] : !llvm<"i64">
+// CHECK-NEXT:  %[[A0:[0-9]+]] = llvm.add %[[M0]], %[[M1]] : !llvm<"i64">
+// CHECK-NEXT:  %[[A1:[0-9]+]] = llvm.add %[[A0]], %arg3 : !llvm<"i64">
+// CHECK-NEXT:  %[[PTR:[0-9]+]] = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT:  {{.*}} = llvm.getelementptr %[[PTR]][%[[A1]]] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+^bb1:
+  %0 = load %dynamic[%i, %j, %k] : memref<?x4x?xf32>
+  return
+}
+
 // CHECK-LABEL: func @memref_cast_static_to_dynamic
 func @memref_cast_static_to_dynamic(%static : memref<10x42xf32>) {
 // CHECK-NEXT:  %0 = llvm.undef : !llvm<"{ float*, i64, i64 }">
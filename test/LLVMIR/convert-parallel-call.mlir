@@ -0,0 +1,34 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+func @body(index, index, memref<64xf32>, index)
+
+// The calls marked with "parallel.step" go through the parallel runtime, with
+// the values following the bounds packed in a context on the stack.
+// CHECK-LABEL: func @parallel_call(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">) {
+// CHECK-NEXT:   %[[ONE:.*]] = llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT:   %[[CTX:.*]] = llvm.alloca %[[ONE]] x !llvm<"{ float*, i64 }"> : (!llvm<"i64">) -> !llvm<"{ float*, i64 }*">
+// CHECK:        %[[UNDEF:.*]] = llvm.undef : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:   %[[PACK0:.*]] = llvm.insertvalue %arg0, %[[UNDEF]][0] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:   %[[PACK1:.*]] = llvm.insertvalue %arg1, %[[PACK0]][1] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:   llvm.store %[[PACK1]], %[[CTX]] : !llvm<"{ float*, i64 }*">
+// CHECK-NEXT:   %[[VOIDCTX:.*]] = llvm.bitcast %[[CTX]] : !llvm<"{ float*, i64 }*"> to !llvm<"i8*">
+// CHECK-NEXT:   %[[THUNK:.*]] = llvm.constant(@body_thunk{{.*}}) : !llvm<"void (i64, i64, i8*)*">
+// CHECK-NEXT:   %[[STEP:.*]] = llvm.constant(4 : index) : !llvm<"i64">
+// CHECK-NEXT:   llvm.call @mlir_parallel_for(%[[THUNK]], %{{.*}}, %{{.*}}, %[[STEP]], %[[VOIDCTX]]) : (!llvm<"void (i64, i64, i8*)*">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i8*">) -> ()
+// CHECK-NOT:    llvm.call @body
+func @parallel_call(%A : memref<64xf32>, %n : index) {
+  %c0 = constant 0 : index
+  %c64 = constant 64 : index
+  call @body(%c0, %c64, %A, %n) {parallel.step: 4} : (index, index, memref<64xf32>, index) -> ()
+  return
+}
+
+// CHECK-LABEL: func @body_thunk(%arg0: !llvm<"i64">, %arg1: !llvm<"i64">, %arg2: !llvm<"i8*">) {
+// CHECK-NEXT:   %0 = llvm.bitcast %arg2 : !llvm<"i8*"> to !llvm<"{ float*, i64 }*">
+// CHECK-NEXT:   %1 = llvm.load %0 : !llvm<"{ float*, i64 }*">
+// CHECK-NEXT:   %2 = llvm.extractvalue %1[0] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:   %3 = llvm.extractvalue %1[1] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:   llvm.call @body(%arg0, %arg1, %2, %3) : (!llvm<"i64">, !llvm<"i64">, !llvm<"float*">, !llvm<"i64">) -> ()
+// CHECK-NEXT:   llvm.return
+
+// CHECK-LABEL: func @mlir_parallel_for(!llvm<"void (i64, i64, i8*)*">, !llvm<"i64">, !llvm<"i64">, !llvm<"i64">, !llvm<"i8*">)
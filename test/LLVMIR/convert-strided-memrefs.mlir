@@ -0,0 +1,76 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+// The static strides and offset of a strided layout are folded into the
+// address computations, and the descriptor is the same as for the identity
+// layout.
+
+// CHECK-LABEL: func @strided_alloc() -> !llvm<"float*"> {
+func @strided_alloc() -> memref<4x8xf32, (d0, d1) -> (d0 * 16 + d1 + 5)> {
+// CHECK-NEXT:  %0 = llvm.constant(4 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.constant(8 : index) : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.constant(6 : index) : !llvm<"i64">
+// CHECK-NEXT:  %4 = llvm.sub %0, %2 : !llvm<"i64">
+// CHECK-NEXT:  %5 = llvm.constant(16 : index) : !llvm<"i64">
+// CHECK-NEXT:  %6 = llvm.mul %4, %5 : !llvm<"i64">
+// CHECK-NEXT:  %7 = llvm.add %3, %6 : !llvm<"i64">
+// CHECK-NEXT:  %8 = llvm.sub %1, %2 : !llvm<"i64">
+// CHECK-NEXT:  %9 = llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT:  %10 = llvm.mul %8, %9 : !llvm<"i64">
+// CHECK-NEXT:  %11 = llvm.add %7, %10 : !llvm<"i64">
+// CHECK-NEXT:  %12 = llvm.constant(4 : index) : !llvm<"i64">
+// CHECK-NEXT:  %13 = llvm.mul %11, %12 : !llvm<"i64">
+// CHECK-NEXT:  %14 = llvm.call @malloc(%13) : (!llvm<"i64">) -> !llvm<"i8*">
+// CHECK-NEXT:  %15 = llvm.bitcast %14 : !llvm<"i8*"> to !llvm<"float*">
+  %0 = alloc() : memref<4x8xf32, (d0, d1) -> (d0 * 16 + d1 + 5)>
+  return %0 : memref<4x8xf32, (d0, d1) -> (d0 * 16 + d1 + 5)>
+}
+
+// CHECK-LABEL: func @strided_load
+func @strided_load(%arg0 : memref<4x8xf32, (d0, d1) -> (d0 * 16 + d1 + 5)>, %i : index, %j : index) {
+// CHECK-NEXT:  %0 = llvm.constant(16 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.add %1, %arg2 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.constant(5 : index) : !llvm<"i64">
+// CHECK-NEXT:  %4 = llvm.add %2, %3 : !llvm<"i64">
+// CHECK-NEXT:  %5 = llvm.getelementptr %arg0[%4] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %6 = llvm.load %5 : !llvm<"float*">
+  %0 = load %arg0[%i, %j] : memref<4x8xf32, (d0, d1) -> (d0 * 16 + d1 + 5)>
+  return
+}
+
+// The sizes of a dynamically shaped memref are still in the descriptor.
+// CHECK-LABEL: func @dynamic_strided_store
+func @dynamic_strided_store(%arg0 : memref<?x8xf32, (d0, d1) -> (d0 * 32 + d1 * 2)>, %i : index, %j : index, %val : f32) {
+// CHECK-NEXT:  %0 = llvm.constant(32 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.constant(2 : index) : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.mul %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %3 = llvm.mul %arg2, %1 : !llvm<"i64">
+// CHECK-NEXT:  %4 = llvm.add %2, %3 : !llvm<"i64">
+// CHECK-NEXT:  %5 = llvm.extractvalue %arg0[0] : !llvm<"{ float*, i64 }">
+// CHECK-NEXT:  %6 = llvm.getelementptr %5[%4] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  llvm.store %arg3, %6 : !llvm<"float*">
+  store %val, %arg0[%i, %j] : memref<?x8xf32, (d0, d1) -> (d0 * 32 + d1 * 2)>
+  return
+}
+
+// CHECK-LABEL: func @zero_d_strided_load
+func @zero_d_strided_load(%arg0 : memref<f32, () -> (3)>) -> f32 {
+// CHECK-NEXT:  %0 = llvm.constant(3 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.getelementptr %arg0[%0] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %2 = llvm.load %1 : !llvm<"float*">
+  %0 = load %arg0[] : memref<f32, () -> (3)>
+  return %0 : f32
+}
+
+// A view is its operand, and its offset is added to the accesses to it.
+// CHECK-LABEL: func @view_load(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">)
+func @view_load(%arg0 : memref<256xf32>, %i : index) -> f32 {
+// CHECK-NEXT:  %0 = llvm.constant(64 : index) : !llvm<"i64">
+// CHECK-NEXT:  %1 = llvm.add %arg1, %0 : !llvm<"i64">
+// CHECK-NEXT:  %2 = llvm.getelementptr %arg0[%1] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT:  %3 = llvm.load %2 : !llvm<"float*">
+  %0 = view %arg0 : memref<256xf32> to memref<16xf32, (d0) -> (d0 + 64)>
+  %1 = load %0[%i] : memref<16xf32, (d0) -> (d0 + 64)>
+  return %1 : f32
+}
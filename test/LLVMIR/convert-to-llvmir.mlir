@@ -439,3 +439,22 @@ func @cond_br_same_target(%arg0: i1, %arg1: i32, %arg2 : i32) -> (i32) {
 // CHECK:      ^[[dummyBlock]]:
 // CHECK-NEXT:  llvm.br ^[[origBlock]](%arg2 : !llvm<"i32">)
 }
+
+// The fast-math flags of the floating point operations are preserved.
+// CHECK-LABEL: func @fastmath(%arg0: !llvm<"float">) -> !llvm<"float"> {
+func @fastmath(%arg0: f32) -> f32 {
+// CHECK-NEXT:  %0 = llvm.fmul %arg0, %arg0 {fastmath: ["fast"]} : !llvm<"float">
+  %0 = mulf %arg0, %arg0 {fastmath: ["fast"]} : f32
+// CHECK-NEXT:  %1 = llvm.fadd %0, %arg0 {fastmath: ["reassoc", "nsz"]} : !llvm<"float">
+  %1 = addf %0, %arg0 {fastmath: ["reassoc", "nsz"]} : f32
+  return %1 : f32
+}
+
+// CHECK-LABEL: func @fmaf(%arg0: !llvm<"float">, %arg1: !llvm<"<4 x float>">) -> !llvm<"<4 x float>"> {
+func @fmaf(%arg0: f32, %arg1: vector<4xf32>) -> vector<4xf32> {
+// CHECK-NEXT:  %0 = "llvm.intr.fmuladd"(%arg0, %arg0, %arg0) {fastmath: ["contract"]} : (!llvm<"float">, !llvm<"float">, !llvm<"float">) -> !llvm<"float">
+  %0 = fmaf %arg0, %arg0, %arg0 {fastmath: ["contract"]} : f32
+// CHECK-NEXT:  %1 = "llvm.intr.fmuladd"(%arg1, %arg1, %arg1) : (!llvm<"<4 x float>">, !llvm<"<4 x float>">, !llvm<"<4 x float>">) -> !llvm<"<4 x float>">
+  %1 = fmaf %arg1, %arg1, %arg1 : vector<4xf32>
+  return %1 : vector<4xf32>
+}
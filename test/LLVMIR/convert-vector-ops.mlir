@@ -0,0 +1,89 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+// CHECK-LABEL: func @extract_insert_element
+func @extract_insert_element(%v : vector<4xf32>, %i : index, %j : index) -> vector<4xf32> {
+// CHECK-NEXT: %0 = "llvm.extractelement"(%arg0, %arg1) : (!llvm<"<4 x float>">, !llvm<"i64">) -> !llvm<"float">
+  %f = extract_element %v[%i] : vector<4xf32>
+// CHECK-NEXT: %1 = "llvm.insertelement"(%arg0, %0, %arg2) : (!llvm<"<4 x float>">, !llvm<"float">, !llvm<"i64">) -> !llvm<"<4 x float>">
+  %w = vector.insert_element %f, %v[%j] : vector<4xf32>
+  return %w : vector<4xf32>
+}
+
+// CHECK-LABEL: func @shuffle
+func @shuffle(%v : vector<4xf32>, %w : vector<4xf32>) -> vector<2xf32> {
+// CHECK-NEXT: %0 = "llvm.shufflevector"(%arg0, %arg1) {mask: [3, 4]} : (!llvm<"<4 x float>">, !llvm<"<4 x float>">) -> !llvm<"<2 x float>">
+  %0 = vector.shuffle %v, %w {mask: [3, 4]} : vector<4xf32>
+  return %0 : vector<2xf32>
+}
+
+// Floating-point additions and multiplications start from the identity.
+// CHECK-LABEL: func @float_reductions
+func @float_reductions(%v : vector<8xf32>) -> (f32, f32, f32) {
+// CHECK-NEXT: %0 = llvm.constant(-0.000000e+00 : f32) : !llvm<"float">
+// CHECK-NEXT: %1 = "llvm.intr.vector.reduce.fadd"(%0, %arg0) : (!llvm<"float">, !llvm<"<8 x float>">) -> !llvm<"float">
+  %0 = vector.reduce "add", %v : vector<8xf32>
+// CHECK-NEXT: %2 = llvm.constant(1.000000e+00 : f32) : !llvm<"float">
+// CHECK-NEXT: %3 = "llvm.intr.vector.reduce.fmul"(%2, %arg0) : (!llvm<"float">, !llvm<"<8 x float>">) -> !llvm<"float">
+  %1 = vector.reduce "mul", %v : vector<8xf32>
+// CHECK-NEXT: %4 = "llvm.intr.vector.reduce.fmax"(%arg0) : (!llvm<"<8 x float>">) -> !llvm<"float">
+  %2 = vector.reduce "max", %v : vector<8xf32>
+  return %0, %1, %2 : f32, f32, f32
+}
+
+// Integers are compared as signed values.
+// CHECK-LABEL: func @int_reductions
+func @int_reductions(%v : vector<4xi32>) -> (i32, i32, i32) {
+// CHECK-NEXT: %0 = "llvm.intr.vector.reduce.add"(%arg0) : (!llvm<"<4 x i32>">) -> !llvm<"i32">
+  %0 = vector.reduce "add", %v : vector<4xi32>
+// CHECK-NEXT: %1 = "llvm.intr.vector.reduce.smin"(%arg0) : (!llvm<"<4 x i32>">) -> !llvm<"i32">
+  %1 = vector.reduce "min", %v : vector<4xi32>
+// CHECK-NEXT: %2 = "llvm.intr.vector.reduce.and"(%arg0) : (!llvm<"<4 x i32>">) -> !llvm<"i32">
+  %2 = vector.reduce "and", %v : vector<4xi32>
+  return %0, %1, %2 : i32, i32, i32
+}
+
+// CHECK-LABEL: func @broadcast
+func @broadcast(%f : f32) -> vector<4xf32> {
+// CHECK-NEXT: %0 = llvm.undef : !llvm<"<4 x float>">
+// CHECK-NEXT: %1 = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT: %2 = "llvm.insertelement"(%0, %arg0, %1) : (!llvm<"<4 x float>">, !llvm<"float">, !llvm<"i64">) -> !llvm<"<4 x float>">
+// CHECK-NEXT: %3 = "llvm.shufflevector"(%2, %0) {mask: [0, 0, 0, 0]} : (!llvm<"<4 x float>">, !llvm<"<4 x float>">) -> !llvm<"<4 x float>">
+  %0 = vector.broadcast %f : f32, vector<4xf32>
+// CHECK-NEXT: llvm.return %3 : !llvm<"<4 x float>">
+  %1 = vector.shape_cast %0 : vector<4xf32>, vector<4xf32>
+  return %1 : vector<4xf32>
+}
+
+// The 2-D vectors are arrays of 1-D vectors, each row of an outer product is a
+// fused multiply-add with a broadcast element of the LHS.
+// CHECK-LABEL: func @outerproduct
+func @outerproduct(%a : vector<2xf32>, %b : vector<3xf32>, %c : vector<2x3xf32>) -> vector<2x3xf32> {
+// CHECK-NEXT: %0 = llvm.undef : !llvm<"[2 x <3 x float>]">
+// CHECK-NEXT: %1 = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT: %2 = "llvm.extractelement"(%arg0, %1) : (!llvm<"<2 x float>">, !llvm<"i64">) -> !llvm<"float">
+// CHECK-NEXT: %3 = llvm.undef : !llvm<"<3 x float>">
+// CHECK-NEXT: %4 = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT: %5 = "llvm.insertelement"(%3, %2, %4) : (!llvm<"<3 x float>">, !llvm<"float">, !llvm<"i64">) -> !llvm<"<3 x float>">
+// CHECK-NEXT: %6 = "llvm.shufflevector"(%5, %3) {mask: [0, 0, 0]} : (!llvm<"<3 x float>">, !llvm<"<3 x float>">) -> !llvm<"<3 x float>">
+// CHECK-NEXT: %7 = llvm.extractvalue %arg2[0] : !llvm<"[2 x <3 x float>]">
+// CHECK-NEXT: %8 = "llvm.intr.fmuladd"(%6, %arg1, %7) : (!llvm<"<3 x float>">, !llvm<"<3 x float>">, !llvm<"<3 x float>">) -> !llvm<"<3 x float>">
+// CHECK-NEXT: %9 = llvm.insertvalue %8, %0[0] : !llvm<"[2 x <3 x float>]">
+// CHECK-NEXT: %10 = llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT: %11 = "llvm.extractelement"(%arg0, %10) : (!llvm<"<2 x float>">, !llvm<"i64">) -> !llvm<"float">
+// CHECK:      %16 = llvm.extractvalue %arg2[1] : !llvm<"[2 x <3 x float>]">
+// CHECK-NEXT: %17 = "llvm.intr.fmuladd"(%15, %arg1, %16)
+// CHECK-NEXT: %18 = llvm.insertvalue %17, %9[1] : !llvm<"[2 x <3 x float>]">
+  %0 = vector.outerproduct %a, %b, %c : vector<2xf32>, vector<3xf32>
+// CHECK-NEXT: llvm.return %18 : !llvm<"[2 x <3 x float>]">
+  return %0 : vector<2x3xf32>
+}
+
+// Without an accumulator, the rows are products.
+// CHECK-LABEL: func @outerproduct_no_accumulator
+func @outerproduct_no_accumulator(%a : vector<2xf32>, %b : vector<3xf32>) -> vector<2x3xf32> {
+// CHECK: %[[SCALE:[0-9]+]] = "llvm.shufflevector"
+// CHECK-NEXT: %[[ROW:[0-9]+]] = llvm.fmul %[[SCALE]], %arg1 : !llvm<"<3 x float>">
+// CHECK-NEXT: {{.*}} = llvm.insertvalue %[[ROW]], %0[0] : !llvm<"[2 x <3 x float>]">
+  %0 = vector.outerproduct %a, %b : vector<2xf32>, vector<3xf32>
+  return %0 : vector<2x3xf32>
+}
@@ -0,0 +1,81 @@
+// RUN: mlir-opt -convert-to-llvmir %s | FileCheck %s
+
+// An unpadded read along the innermost dimension is a plain vector load.
+// CHECK-LABEL: func @transfer_read_contiguous
+func @transfer_read_contiguous(%A : memref<?x?xf32>, %i : index, %j : index) -> vector<8xf32> {
+// CHECK:      %[[PTR:[0-9]+]] = llvm.getelementptr
+// CHECK-NEXT: %[[VPTR:[0-9]+]] = llvm.bitcast %[[PTR]] : !llvm<"float*"> to !llvm<"<8 x float>*">
+// CHECK-NEXT: {{.*}} = llvm.load %[[VPTR]] {alignment: 4 : i32} : !llvm<"<8 x float>*">
+  %v = vector.transfer_read %A[%i, %j] {permutation_map: (d0, d1) -> (d1)} : memref<?x?xf32>, vector<8xf32>
+  return %v : vector<8xf32>
+}
+
+// A padded read masks out the lanes past the end of the innermost dimension.
+// CHECK-LABEL: func @transfer_read_masked
+func @transfer_read_masked(%A : memref<?x?xf32>, %i : index, %j : index, %pad : f32) -> vector<8xf32> {
+// CHECK:      %[[PTR:[0-9]+]] = llvm.getelementptr
+// CHECK:      %[[SIZE:[0-9]+]] = llvm.extractvalue %arg0[2] : !llvm<"{ float*, i64, i64 }">
+// CHECK-NEXT: %[[REM:[0-9]+]] = llvm.sub %[[SIZE]], %arg2 : !llvm<"i64">
+// CHECK-NEXT: %[[LANES:[0-9]+]] = llvm.constant(dense<vector<8xi64>, [0, 1, 2, 3, 4, 5, 6, 7]>) : !llvm<"<8 x i64>">
+// CHECK:      %[[SPLAT:[0-9]+]] = "llvm.shufflevector"
+// CHECK-NEXT: %[[MASK:[0-9]+]] = llvm.icmp "slt" %[[LANES]], %[[SPLAT]] : !llvm<"<8 x i64>">
+// CHECK:      %[[PAD:[0-9]+]] = "llvm.shufflevector"
+// CHECK-NEXT: %[[VPTR:[0-9]+]] = llvm.bitcast %[[PTR]] : !llvm<"float*"> to !llvm<"<8 x float>*">
+// CHECK-NEXT: {{.*}} = "llvm.intr.masked.load"(%[[VPTR]], %[[MASK]], %[[PAD]]) {alignment: 4 : i32}
+  %v = vector.transfer_read %A[%i, %j], (%pad) {permutation_map: (d0, d1) -> (d1)} : memref<?x?xf32>, vector<8xf32>
+  return %v : vector<8xf32>
+}
+
+// A read along an outer dimension gathers elements a row apart.
+// CHECK-LABEL: func @transfer_read_strided
+func @transfer_read_strided(%A : memref<?x?xf32>, %i : index, %j : index, %pad : f32) -> vector<8xf32> {
+// CHECK:      %[[PTR:[0-9]+]] = llvm.getelementptr
+// CHECK:      %[[OFFSETS:[0-9]+]] = llvm.mul {{.*}} : !llvm<"<8 x i64>">
+// CHECK-NEXT: %[[PTRS:[0-9]+]] = llvm.getelementptr %[[PTR]][%[[OFFSETS]]] : (!llvm<"float*">, !llvm<"<8 x i64>">) -> !llvm<"<8 x float*>">
+// CHECK-NEXT: {{.*}} = "llvm.intr.masked.gather"(%[[PTRS]], {{.*}}) {alignment: 4 : i32}
+  %v = vector.transfer_read %A[%i, %j], (%pad) {permutation_map: (d0, d1) -> (d0)} : memref<?x?xf32>, vector<8xf32>
+  return %v : vector<8xf32>
+}
+
+// A read selecting no dimension broadcasts a scalar load.
+// CHECK-LABEL: func @transfer_read_broadcast
+func @transfer_read_broadcast(%A : memref<16x32xf32>, %i : index, %j : index) -> vector<8xf32> {
+// CHECK:      %[[PTR:[0-9]+]] = llvm.getelementptr
+// CHECK-NEXT: %[[S:[0-9]+]] = llvm.load %[[PTR]] : !llvm<"float*">
+// CHECK-NEXT: %[[UNDEF:[0-9]+]] = llvm.undef : !llvm<"<8 x float>">
+// CHECK-NEXT: %[[ZERO:[0-9]+]] = llvm.constant(0 : index) : !llvm<"i64">
+// CHECK-NEXT: %[[INS:[0-9]+]] = "llvm.insertelement"(%[[UNDEF]], %[[S]], %[[ZERO]])
+// CHECK-NEXT: {{.*}} = "llvm.shufflevector"(%[[INS]], %[[UNDEF]]) {mask: [0, 0, 0, 0, 0, 0, 0, 0]}
+  %v = vector.transfer_read %A[%i, %j] {permutation_map: (d0, d1) -> (0)} : memref<16x32xf32>, vector<8xf32>
+  return %v : vector<8xf32>
+}
+
+// Writes are masked, with a store along the innermost dimension and a scatter
+// along the outer ones.
+// CHECK-LABEL: func @transfer_write
+func @transfer_write(%A : memref<16x30xf32>, %v : vector<8xf32>, %i : index, %j : index) {
+// CHECK:      "llvm.intr.masked.store"(%arg1, {{.*}}) {alignment: 4 : i32}
+  vector.transfer_write %v, %A[%i, %j] {permutation_map: (d0, d1) -> (d1)} : vector<8xf32>, memref<16x30xf32>
+// CHECK:      "llvm.intr.masked.scatter"(%arg1, {{.*}}) {alignment: 4 : i32}
+  vector.transfer_write %v, %A[%i, %j] {permutation_map: (d0, d1) -> (d0)} : vector<8xf32>, memref<16x30xf32>
+  return
+}
+
+// The transfers marked as in bounds are not masked, and address their elements
+// with inbounds GEPs.
+// CHECK-LABEL: func @transfer_in_bounds
+func @transfer_in_bounds(%A : memref<16x32xf32>, %i : index, %j : index, %pad : f32) {
+// CHECK:      %[[RPTR:[0-9]+]] = llvm.getelementptr %{{.*}}[%{{.*}}] {inbounds: true}
+// CHECK-NEXT: %[[RVPTR:[0-9]+]] = llvm.bitcast %[[RPTR]] : !llvm<"float*"> to !llvm<"<8 x float>*">
+// CHECK-NEXT: %[[V:[0-9]+]] = llvm.load %[[RVPTR]] {alignment: 4 : i32} : !llvm<"<8 x float>*">
+  %v = vector.transfer_read %A[%i, %j], (%pad) {permutation_map: (d0, d1) -> (d1), in_bounds: true} : memref<16x32xf32>, vector<8xf32>
+// CHECK:      %[[WPTR:[0-9]+]] = llvm.getelementptr %{{.*}}[%{{.*}}] {inbounds: true}
+// CHECK-NEXT: %[[WVPTR:[0-9]+]] = llvm.bitcast %[[WPTR]] : !llvm<"float*"> to !llvm<"<8 x float>*">
+// CHECK-NEXT: llvm.store %[[V]], %[[WVPTR]] {alignment: 4 : i32} : !llvm<"<8 x float>*">
+  vector.transfer_write %v, %A[%i, %j] {permutation_map: (d0, d1) -> (d1), in_bounds: true} : vector<8xf32>, memref<16x32xf32>
+// CHECK:      %[[PTRS:[0-9]+]] = llvm.getelementptr %{{.*}}[%{{.*}}] {inbounds: true} : (!llvm<"float*">, !llvm<"<8 x i64>">) -> !llvm<"<8 x float*>">
+// CHECK-NEXT: %[[ONES:[0-9]+]] = llvm.constant(splat<vector<8xi1>, {{.*}}>) : !llvm<"<8 x i1>">
+// CHECK-NEXT: "llvm.intr.masked.scatter"(%[[V]], %[[PTRS]], %[[ONES]]) {alignment: 4 : i32}
+  vector.transfer_write %v, %A[%i, %j] {permutation_map: (d0, d1) -> (d0), in_bounds: true} : vector<8xf32>, memref<16x32xf32>
+  return
+}
@@ -5,6 +5,20 @@ func @invalid_noalias(%arg0: !llvm<"i32"> {llvm.noalias: 3}) {
   "llvm.return"() : () -> ()
 }
 
+// -----
+
+// expected-error@+1{{llvm.align argument attribute must be a power of two integer}}
+func @invalid_align(%arg0: !llvm<"float*"> {llvm.align: 3}) {
+  "llvm.return"() : () -> ()
+}
+
+// -----
+
+// expected-error@+1{{llvm.dereferenceable argument attribute must be a positive integer}}
+func @invalid_dereferenceable(%arg0: !llvm<"float*"> {llvm.dereferenceable: true}) {
+  "llvm.return"() : () -> ()
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Check that parser errors are properly produced and do not crash the compiler.
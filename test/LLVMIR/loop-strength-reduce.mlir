@@ -0,0 +1,76 @@
+// RUN: mlir-opt -llvm-loop-strength-reduce %s | FileCheck %s
+
+// The accesses to consecutive rows of a 16x32 buffer share a pointer advanced
+// by a row in every iteration.
+// CHECK-LABEL: func @column_walk
+func @column_walk(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">) {
+// CHECK:      %[[STRIDE:[0-9]+]] = llvm.constant(32 : index) : !llvm<"i64">
+// CHECK-NEXT: %[[INIT:[0-9]+]] = llvm.getelementptr %arg0[%arg1] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: llvm.br ^bb1(%{{[0-9]+}}, %[[INIT]] : !llvm<"i64">, !llvm<"float*">)
+// CHECK-NEXT: ^bb1(%[[IV:[0-9]+]]: !llvm<"i64">, %[[PTR:[0-9]+]]: !llvm<"float*">):
+// CHECK:      ^bb2:
+// CHECK-NEXT: %[[V:[0-9]+]] = llvm.load %[[PTR]] : !llvm<"float*">
+// CHECK-NEXT: %[[ROW:[0-9]+]] = llvm.getelementptr %[[PTR]][%[[STRIDE]]] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: llvm.store %[[V]], %[[ROW]] : !llvm<"float*">
+// CHECK-NEXT: llvm.constant(1 : index) : !llvm<"i64">
+// CHECK-NEXT: %[[NEXTIV:[0-9]+]] = llvm.add %[[IV]], %{{[0-9]+}} : !llvm<"i64">
+// CHECK-NEXT: %[[NEXTPTR:[0-9]+]] = llvm.getelementptr %[[PTR]][%[[STRIDE]]] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: llvm.br ^bb1(%[[NEXTIV]], %[[NEXTPTR]] : !llvm<"i64">, !llvm<"float*">)
+  %0 = llvm.constant(0 : index) : !llvm<"i64">
+  %1 = llvm.constant(16 : index) : !llvm<"i64">
+  llvm.br ^bb1(%0 : !llvm<"i64">)
+^bb1(%2: !llvm<"i64">):
+  %3 = llvm.icmp "slt" %2, %1 : !llvm<"i64">
+  llvm.cond_br %3, ^bb2, ^bb3
+^bb2:
+  %4 = llvm.constant(32 : index) : !llvm<"i64">
+  %5 = llvm.mul %2, %4 : !llvm<"i64">
+  %6 = llvm.add %5, %arg1 : !llvm<"i64">
+  %7 = llvm.getelementptr %arg0[%6] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  %8 = llvm.load %7 : !llvm<"float*">
+  %9 = llvm.constant(1 : index) : !llvm<"i64">
+  %10 = llvm.add %2, %9 : !llvm<"i64">
+  %11 = llvm.constant(32 : index) : !llvm<"i64">
+  %12 = llvm.mul %10, %11 : !llvm<"i64">
+  %13 = llvm.add %12, %arg1 : !llvm<"i64">
+  %14 = llvm.getelementptr %arg0[%13] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  llvm.store %8, %14 : !llvm<"float*">
+  %15 = llvm.constant(1 : index) : !llvm<"i64">
+  %16 = llvm.add %2, %15 : !llvm<"i64">
+  llvm.br ^bb1(%16 : !llvm<"i64">)
+^bb3:
+  llvm.return
+}
+
+// A loop invariant stride is added to the pointer as is, and an access whose
+// index isn't linear in the induction variable is left alone.
+// CHECK-LABEL: func @dynamic_stride
+func @dynamic_stride(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">, %arg2: !llvm<"i64*">) {
+// CHECK:      llvm.br ^bb1(%{{[0-9]+}}, %arg0 : !llvm<"i64">, !llvm<"float*">)
+// CHECK-NEXT: ^bb1(%[[IV:[0-9]+]]: !llvm<"i64">, %[[PTR:[0-9]+]]: !llvm<"float*">):
+// CHECK:      ^bb2:
+// CHECK-NEXT: %[[V:[0-9]+]] = llvm.load %[[PTR]] : !llvm<"float*">
+// CHECK-NEXT: %[[IDX:[0-9]+]] = llvm.load %arg2 : !llvm<"i64*">
+// CHECK-NEXT: %[[GATHER:[0-9]+]] = llvm.getelementptr %arg0[%[[IDX]]] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: llvm.store %[[V]], %[[GATHER]] : !llvm<"float*">
+// CHECK:      %[[NEXTPTR:[0-9]+]] = llvm.getelementptr %[[PTR]][%arg1] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: llvm.br ^bb1(%{{[0-9]+}}, %[[NEXTPTR]] : !llvm<"i64">, !llvm<"float*">)
+  %0 = llvm.constant(0 : index) : !llvm<"i64">
+  %1 = llvm.constant(64 : index) : !llvm<"i64">
+  llvm.br ^bb1(%0 : !llvm<"i64">)
+^bb1(%2: !llvm<"i64">):
+  %3 = llvm.icmp "slt" %2, %1 : !llvm<"i64">
+  llvm.cond_br %3, ^bb2, ^bb3
+^bb2:
+  %4 = llvm.mul %2, %arg1 : !llvm<"i64">
+  %5 = llvm.getelementptr %arg0[%4] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  %6 = llvm.load %5 : !llvm<"float*">
+  %7 = llvm.load %arg2 : !llvm<"i64*">
+  %8 = llvm.getelementptr %arg0[%7] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  llvm.store %6, %8 : !llvm<"float*">
+  %9 = llvm.constant(1 : index) : !llvm<"i64">
+  %10 = llvm.add %2, %9 : !llvm<"i64">
+  llvm.br ^bb1(%10 : !llvm<"i64">)
+^bb3:
+  llvm.return
+}
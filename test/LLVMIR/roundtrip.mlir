@@ -141,3 +141,48 @@ func @foo(%arg0: !llvm<"i32">) -> !llvm<"{ i32, double, i32 }"> {
   %22 = llvm.insertvalue %5, %21[2] : !llvm<"{ i32, double, i32 }">
   llvm.return %22 : !llvm<"{ i32, double, i32 }">
 }
+
+// CHECK-LABEL: func @bitwise_and_cast_ops(%arg0: !llvm<"i32">, %arg1: !llvm<"<4 x i32>">)
+func @bitwise_and_cast_ops(%arg0: !llvm<"i32">, %arg1: !llvm<"<4 x i32>">) {
+// CHECK-NEXT:  %0 = llvm.and %arg0, %arg0 : !llvm<"i32">
+// CHECK-NEXT:  %1 = llvm.or %arg0, %arg0 : !llvm<"i32">
+// CHECK-NEXT:  %2 = llvm.xor %arg0, %arg0 : !llvm<"i32">
+// CHECK-NEXT:  %3 = llvm.shl %arg0, %arg0 : !llvm<"i32">
+// CHECK-NEXT:  %4 = llvm.lshr %arg0, %arg0 : !llvm<"i32">
+// CHECK-NEXT:  %5 = llvm.ashr %arg1, %arg1 : !llvm<"<4 x i32>">
+  %0 = llvm.and %arg0, %arg0 : !llvm<"i32">
+  %1 = llvm.or %arg0, %arg0 : !llvm<"i32">
+  %2 = llvm.xor %arg0, %arg0 : !llvm<"i32">
+  %3 = llvm.shl %arg0, %arg0 : !llvm<"i32">
+  %4 = llvm.lshr %arg0, %arg0 : !llvm<"i32">
+  %5 = llvm.ashr %arg1, %arg1 : !llvm<"<4 x i32>">
+
+// CHECK-NEXT:  %6 = llvm.sext %arg0 : !llvm<"i32"> to !llvm<"i64">
+// CHECK-NEXT:  %7 = llvm.zext %arg0 : !llvm<"i32"> to !llvm<"i64">
+// CHECK-NEXT:  %8 = llvm.trunc %6 : !llvm<"i64"> to !llvm<"i8">
+// CHECK-NEXT:  %9 = llvm.sext %arg1 : !llvm<"<4 x i32>"> to !llvm<"<4 x i64>">
+  %6 = llvm.sext %arg0 : !llvm<"i32"> to !llvm<"i64">
+  %7 = llvm.zext %arg0 : !llvm<"i32"> to !llvm<"i64">
+  %8 = llvm.trunc %6 : !llvm<"i64"> to !llvm<"i8">
+  %9 = llvm.sext %arg1 : !llvm<"<4 x i32>"> to !llvm<"<4 x i64>">
+
+// CHECK-NEXT:  %10 = llvm.sitofp %arg0 : !llvm<"i32"> to !llvm<"float">
+// CHECK-NEXT:  %11 = llvm.uitofp %arg0 : !llvm<"i32"> to !llvm<"float">
+// CHECK-NEXT:  %12 = llvm.fptosi %10 : !llvm<"float"> to !llvm<"i32">
+// CHECK-NEXT:  %13 = llvm.fptoui %10 : !llvm<"float"> to !llvm<"i32">
+// CHECK-NEXT:  %14 = llvm.fpext %10 : !llvm<"float"> to !llvm<"double">
+// CHECK-NEXT:  %15 = llvm.fptrunc %14 : !llvm<"double"> to !llvm<"float">
+// CHECK-NEXT:  %16 = llvm.inttoptr %6 : !llvm<"i64"> to !llvm<"float*">
+// CHECK-NEXT:  %17 = llvm.ptrtoint %16 : !llvm<"float*"> to !llvm<"i64">
+  %10 = llvm.sitofp %arg0 : !llvm<"i32"> to !llvm<"float">
+  %11 = llvm.uitofp %arg0 : !llvm<"i32"> to !llvm<"float">
+  %12 = llvm.fptosi %10 : !llvm<"float"> to !llvm<"i32">
+  %13 = llvm.fptoui %10 : !llvm<"float"> to !llvm<"i32">
+  %14 = llvm.fpext %10 : !llvm<"float"> to !llvm<"double">
+  %15 = llvm.fptrunc %14 : !llvm<"double"> to !llvm<"float">
+  %16 = llvm.inttoptr %6 : !llvm<"i64"> to !llvm<"float*">
+  %17 = llvm.ptrtoint %16 : !llvm<"float*"> to !llvm<"i64">
+
+// CHECK-NEXT:  llvm.return
+  llvm.return
+}
@@ -0,0 +1,23 @@
+// RUN: mlir-opt %s -canonicalize-cse | FileCheck %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -canonicalize-cse | FileCheck %s
+// RUN: mlir-opt %s -canonicalize-cse -pass-statistics -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+
+// CSE exposes a canonicalization, which a single run of the canonicalizer
+// followed by CSE misses.
+
+// CHECK-LABEL: func @foo
+func @foo(%arg0: i32, %arg1: i32) -> i32 {
+  // CHECK-NEXT: %[[C:.*]] = constant 0 : i32
+  // CHECK-NEXT: return %[[C]] : i32
+  %0 = addi %arg0, %arg1 : i32
+  %1 = addi %arg0, %arg1 : i32
+  %2 = subi %0, %1 : i32
+  return %2 : i32
+}
+
+// The third iteration detects the convergence, and skips all of the passes.
+// STATS: Fixed Point Pipeline
+// STATS-NEXT: (S) 3 num-iterations
+// STATS-NEXT: (S) 0 num-not-converged
+// STATS-NEXT: Canonicalizer
+// STATS: CSE
@@ -0,0 +1,23 @@
+// RUN: mlir-opt %s -memref-dependence-check -pass-budget-work-units=3 -verify
+// RUN: mlir-opt %s -memref-dependence-check -pass-budget-work-units=3 -pass-budget-report -o /dev/null 2>&1 | FileCheck %s --check-prefix=REPORT
+// RUN: mlir-opt %s -memref-dependence-check -pass-budget-work-units=4 -pass-budget-report -o /dev/null 2>&1 | FileCheck %s --check-prefix=NO-REPORT
+
+// Each dependence check consumes a work unit of the budget of the pass, the
+// fourth one exceeds it and is skipped.
+
+func @budget(%A: memref<10xf32>) {
+  %c0 = constant 0 : index
+  %cf7 = constant 7.0 : f32
+  store %cf7, %A[%c0] : memref<10xf32>
+  // expected-note@-1 {{dependence from 0 to 0 at depth 1 = false}}
+  // expected-note@-2 {{dependence from 0 to 1 at depth 1 = true}}
+  %v = load %A[%c0] : memref<10xf32>
+  // expected-note@-1 {{dependence from 1 to 0 at depth 1 = false}}
+  return
+}
+
+// REPORT: ... Pass budget report ...
+// REPORT: MemRefDependenceCheck: 1 run exhausted a budget of 3 work units
+// REPORT-NEXT: @budget
+
+// NO-REPORT-NOT: Pass budget report
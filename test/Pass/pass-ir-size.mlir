@@ -0,0 +1,28 @@
+// RUN: mlir-opt %s -verify-each=true -cse -canonicalize -cse -pass-ir-size 2>&1 | FileCheck %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-ir-size 2>&1 | FileCheck %s
+
+// The CSE runs are merged: the first one takes the 8 operations down to 4, and
+// the second one leaves them as is.
+
+// CHECK: Pass IR size report
+// CHECK: Context storage: {{[0-9]+}} types, {{[0-9]+}} attributes
+// CHECK: Ops{{ +}}Blocks{{ +}}Types{{ +}}Attrs{{ +}}Maps{{ +}}KB  --- Name ---
+// CHECK-DAG: {{^ +}}8{{ +}}-4 {{ +}}4{{ +}}0 {{ +}}- {{.*}}  CSE
+// CHECK-DAG: {{^ +}}4{{ +}}0 {{ +}}2{{ +}}0 {{ +}}- {{.*}}  Canonicalizer
+// CHECK-DAG: {{^ +}}12{{ +}}0 {{ +}}6{{ +}}0 {{ +}}- {{.*}}  FunctionVerifier
+// CHECK-DAG: {{^ +}}4{{ +}}-4 {{ +}}2{{ +}}0 {{ +}}{{-?[0-9]+}}{{.*}}  Function Pipeline
+// CHECK-DAG: {{^ +}}4{{ +}}0 {{ +}}2{{ +}}0 {{ +}}{{-?[0-9]+}}{{.*}}  ModuleVerifier
+
+func @foo() -> (i32, i32) {
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  %2 = constant 2 : i32
+  return %0, %1 : i32, i32
+}
+
+func @bar() -> (i32, i32) {
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  %2 = constant 2 : i32
+  return %0, %1 : i32, i32
+}
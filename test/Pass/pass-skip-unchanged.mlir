@@ -0,0 +1,36 @@
+// RUN: mlir-opt %s -canonicalize -cse -canonicalize -cse -pass-skip-unchanged -print-ir-after-all -o /dev/null 2>&1 | FileCheck %s
+// RUN: mlir-opt %s -canonicalize -cse -canonicalize -cse -pass-skip-unchanged | FileCheck %s --check-prefix=OUTPUT
+
+// Once the canonicalizer converged and CSE found nothing to eliminate, the
+// following runs of these passes and of the verifier are skipped until the
+// function changes.
+
+// CHECK: *** IR Dump After{{.*}}Canonicalizer ***
+// CHECK-NEXT: func @foo()
+// CHECK: *** IR Dump After{{.*}}FunctionVerifier ***
+// CHECK-NEXT: func @foo()
+// CHECK: *** IR Dump After{{.*}}CSE ***
+// CHECK-NEXT: func @foo()
+// CHECK-NOT: *** IR Dump After
+// CHECK: *** IR Dump After{{.*}}Canonicalizer ***
+// CHECK-NEXT: func @bar(
+// CHECK: *** IR Dump After{{.*}}FunctionVerifier ***
+// CHECK-NEXT: func @bar(
+// CHECK: *** IR Dump After{{.*}}CSE ***
+// CHECK-NEXT: func @bar(
+// CHECK-NOT: *** IR Dump After
+
+// OUTPUT-LABEL: func @foo
+func @foo() -> (i32, i32) {
+  // OUTPUT-NEXT: %[[C:.*]] = constant 1 : i32
+  // OUTPUT-NEXT: return %[[C]], %[[C]] : i32, i32
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  return %0, %1 : i32, i32
+}
+
+// OUTPUT-LABEL: func @bar
+func @bar(%arg0: i32) -> i32 {
+  // OUTPUT-NEXT: return %arg0 : i32
+  return %arg0 : i32
+}
@@ -0,0 +1,45 @@
+// RUN: mlir-opt %s -verify-each=true -cse -canonicalize -cse -pass-statistics -pass-statistics-display=list 2>&1 | FileCheck -check-prefix=LIST %s
+// RUN: mlir-opt %s -verify-each=true -cse -canonicalize -cse -pass-statistics -pass-statistics-display=pipeline 2>&1 | FileCheck -check-prefix=PIPELINE %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-statistics -pass-statistics-display=list 2>&1 | FileCheck -check-prefix=LIST %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-statistics -pass-statistics-display=pipeline 2>&1 | FileCheck -check-prefix=PIPELINE %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -mlir-max-threads=1 -verify-each=true -cse -canonicalize -cse -pass-statistics -pass-statistics-display=list 2>&1 | FileCheck -check-prefix=LIST %s
+
+// LIST: Pass statistics report
+// LIST: CSE
+// LIST-NEXT: (S) 2 num-cse'd - Number of operations CSE'd
+// LIST-NEXT: (S) 2 num-dce'd - Number of operations DCE'd
+// LIST-NEXT: (S) 2 num-hits - Number of lookups finding an equivalent operation
+// LIST-NEXT: (S) 4 num-misses - Number of lookups finding no equivalent operation
+// LIST-NOT: CSE
+
+// PIPELINE: Pass statistics report
+// PIPELINE-NEXT: Function Pipeline
+// PIPELINE-NEXT:   CSE
+// PIPELINE-NEXT:     (S) 2 num-cse'd - Number of operations CSE'd
+// PIPELINE-NEXT:     (S) 2 num-dce'd - Number of operations DCE'd
+// PIPELINE-NEXT:     (S) 2 num-hits - Number of lookups finding an equivalent operation
+// PIPELINE-NEXT:     (S) 2 num-misses - Number of lookups finding no equivalent operation
+// PIPELINE-NEXT:   FunctionVerifier
+// PIPELINE-NEXT:   Canonicalizer
+// PIPELINE-NEXT:   FunctionVerifier
+// PIPELINE-NEXT:   CSE
+// PIPELINE-NEXT:     (S) 0 num-cse'd - Number of operations CSE'd
+// PIPELINE-NEXT:     (S) 0 num-dce'd - Number of operations DCE'd
+// PIPELINE-NEXT:     (S) 0 num-hits - Number of lookups finding an equivalent operation
+// PIPELINE-NEXT:     (S) 2 num-misses - Number of lookups finding no equivalent operation
+// PIPELINE-NEXT:   FunctionVerifier
+// PIPELINE-NEXT: ModuleVerifier
+
+func @foo() -> (i32, i32) {
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  %2 = constant 2 : i32
+  return %0, %1 : i32, i32
+}
+
+func @bar() -> (i32, i32) {
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  %2 = constant 2 : i32
+  return %0, %1 : i32, i32
+}
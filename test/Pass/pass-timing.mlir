@@ -2,6 +2,8 @@
 // RUN: mlir-opt %s -verify-each=true -cse -canonicalize -cse -pass-timing -pass-timing-display=pipeline 2>&1 | FileCheck -check-prefix=PIPELINE %s
 // RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-timing -pass-timing-display=list 2>&1 | FileCheck -check-prefix=MT_LIST %s
 // RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-timing -pass-timing-display=pipeline 2>&1 | FileCheck -check-prefix=MT_PIPELINE %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-timing -pass-timing-display=trace 2>&1 | FileCheck -check-prefix=TRACE %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each=true -cse -canonicalize -cse -pass-timing -pass-timing-display=list -pass-timing-top-functions=3 2>&1 | FileCheck -check-prefix=TOP %s
 
 // LIST: Pass execution timing report
 // LIST: Total Execution Time:
@@ -53,6 +55,23 @@
 // MT_PIPELINE-NEXT: ModuleVerifier
 // MT_PIPELINE-NEXT: Total
 
+// TRACE: "traceEvents":[
+// TRACE-DAG: "args":{"function":"foo"},"cat":"pass"
+// TRACE-DAG: "args":{"function":"foobar"},"cat":"analysis"
+// TRACE-DAG: "name":"Canonicalizer"
+// TRACE-DAG: "name":"DominanceInfo"
+// TRACE-DAG: "name":"Function Pipeline"
+// TRACE-DAG: "name":"ModuleVerifier"
+
+// TOP: Longest function pass runs
+// TOP-NEXT: ===
+// TOP-NEXT: ---Wall Time---  ---Ops---  --- Pass : Function ---
+// TOP-NEXT: {{[0-9]+\.[0-9]+}}{{ +}}1  {{.+}} : @{{foo|bar|baz|foobar}}
+// TOP-NEXT: {{[0-9]+\.[0-9]+}}{{ +}}1  {{.+}} : @{{foo|bar|baz|foobar}}
+// TOP-NEXT: {{[0-9]+\.[0-9]+}}{{ +}}1  {{.+}} : @{{foo|bar|baz|foobar}}
+// TOP-NEXT: ===
+// TOP: Pass execution timing report
+
 func @foo() {
   return
 }
@@ -0,0 +1,20 @@
+// RUN: mlir-opt %s -verify-each-structural -cse -canonicalize -cse | FileCheck %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -verify-each-structural -cse -canonicalize -cse | FileCheck %s
+
+// The verifier runs between the passes only check the structure of the IR, the
+// module is fully verified once after the last pass.
+
+// CHECK-LABEL: func @foo
+func @foo() -> (i32, i32) {
+  // CHECK-NEXT: %[[C:.*]] = constant 1 : i32
+  // CHECK-NEXT: return %[[C]], %[[C]] : i32, i32
+  %0 = constant 1 : i32
+  %1 = constant 1 : i32
+  return %0, %1 : i32, i32
+}
+
+// CHECK-LABEL: func @bar
+func @bar(%arg0: i32) -> i32 {
+  // CHECK-NEXT: return %arg0 : i32
+  return %arg0 : i32
+}
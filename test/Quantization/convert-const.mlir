@@ -126,6 +126,18 @@ func @const_dense_tensor_i4_fixedpoint() -> tensor<7xf32> {
   return %2 : tensor<7xf32>
 }
 
+// -----
+// Verifies u8 affine quantization on a dense tensor, rounding half to even
+// (1.5 -> 2, 2.5 -> 2, -1.5 -> -2) and clamping to the storage range.
+// CHECK-LABEL: const_dense_tensor_u8_affine_round_half_even
+func @const_dense_tensor_u8_affine_round_half_even() -> tensor<5xf32> {
+  // CHECK: %cst = constant dense<tensor<5xi8>, [0, -126, -126, 126, -1]> : tensor<5xi8>
+  %cst = constant dense<tensor<5xf32>, [-1.0, 0.01171875, 0.01953125, -0.01171875, 2.0]> : tensor<5xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<5xf32>) -> tensor<5x!quant<"uniform[u8:f32]{7.812500e-03:128}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<5x!quant<"uniform[u8:f32]{7.812500e-03:128}">>) -> (tensor<5xf32>)
+  return %2 : tensor<5xf32>
+}
+
 // -----
 // Verifies i8 fixedpoint quantization on a dense tensor, sweeping values, and
 // custom storage range. (the -128 should be clamped to -100, and the 127 should
@@ -138,3 +150,65 @@ func @const_custom_storage_range_i8_fixedpoint() -> tensor<7xf32> {
   %2 = "quant.dbarrier"(%1) : (tensor<7x!quant<"uniform[i8(-100:100):f32]{7.812500e-03}">>) -> (tensor<7xf32>)
   return %2 : tensor<7xf32>
 }
+
+// -----
+// Verifies i8 fixedpoint per-axis quantization on a dense tensor, with a
+// scale per slice along the first dimension.
+// CHECK-LABEL: const_dense_tensor_i8_fixedpoint_per_axis
+func @const_dense_tensor_i8_fixedpoint_per_axis() -> tensor<2x3xf32> {
+  // CHECK: %cst = constant dense<tensor<2x3xi8>, {{\[\[}}-128, 0, 64], [-32, 0, 16]]> : tensor<2x3xi8>
+  // CHECK-NEXT: %0 = "quant.scast"(%cst) : (tensor<2x3xi8>) -> tensor<2x3x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>
+  %cst = constant dense<tensor<2x3xf32>, [[-2.0, 0.0, 0.5], [-1.0, 0.0, 0.5]]> : tensor<2x3xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<2x3xf32>) -> tensor<2x3x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<2x3x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>) -> (tensor<2x3xf32>)
+  return %2 : tensor<2x3xf32>
+}
+
+// -----
+// Verifies u8 affine per-axis quantization of a splat along the inner
+// dimension, which becomes dense.
+// CHECK-LABEL: const_splat_tensor_u8_affine_per_axis
+func @const_splat_tensor_u8_affine_per_axis() -> tensor<2x2xf32> {
+  // CHECK: %cst = constant dense<tensor<2x2xi8>, {{\[\[}}-64, 16], [-64, 16]]> : tensor<2x2xi8>
+  %cst = constant splat<tensor<2x2xf32>, 0.5> : tensor<2x2xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<2x2xf32>) -> tensor<2x2x!quant<"uniform[u8:f32:1]{7.812500e-03:128,3.125000e-02}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<2x2x!quant<"uniform[u8:f32:1]{7.812500e-03:128,3.125000e-02}">>) -> (tensor<2x2xf32>)
+  return %2 : tensor<2x2xf32>
+}
+
+// -----
+// Verifies that a per-axis type whose quantized dimension doesn't have one
+// slice per scale is not converted.
+// CHECK-LABEL: const_dense_tensor_per_axis_mismatched_shape
+func @const_dense_tensor_per_axis_mismatched_shape() -> tensor<3x2xf32> {
+  // CHECK: %cst = constant dense<tensor<3x2xf32>
+  // CHECK-NEXT: %0 = "quant.qbarrier"(%cst)
+  %cst = constant dense<tensor<3x2xf32>, [[-2.0, 0.0], [0.5, -1.0], [0.0, 0.5]]> : tensor<3x2xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<3x2xf32>) -> tensor<3x2x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<3x2x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>) -> (tensor<3x2xf32>)
+  return %2 : tensor<3x2xf32>
+}
+
+// -----
+// Verifies u8 affine quantization on a sparse tensor, which becomes dense
+// since the implicit zeros quantize to the zero point.
+// CHECK-LABEL: const_sparse_tensor_u8_affine
+func @const_sparse_tensor_u8_affine() -> tensor<2x2xf32> {
+  // CHECK: %cst = constant dense<tensor<2x2xi8>, {{\[\[}}-128, -64], [0, -128]]> : tensor<2x2xi8>
+  %cst = constant sparse<tensor<2x2xf32>, [[0, 1], [1, 0]], [0.5, -1.0]> : tensor<2x2xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<2x2xf32>) -> tensor<2x2x!quant<"uniform[u8:f32]{7.812500e-03:128}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<2x2x!quant<"uniform[u8:f32]{7.812500e-03:128}">>) -> (tensor<2x2xf32>)
+  return %2 : tensor<2x2xf32>
+}
+
+// -----
+// Verifies i8 fixedpoint per-axis quantization on a sparse tensor, which stays
+// sparse with each stored value quantized with the scale of its slice.
+// CHECK-LABEL: const_sparse_tensor_i8_fixedpoint_per_axis
+func @const_sparse_tensor_i8_fixedpoint_per_axis() -> tensor<2x3xf32> {
+  // CHECK: %cst = constant sparse<tensor<2x3xi8>, {{\[\[}}0, 2], [1, 1]], [64, -32]> : tensor<2x3xi8>
+  %cst = constant sparse<tensor<2x3xf32>, [[0, 2], [1, 1]], [0.5, -1.0]> : tensor<2x3xf32>
+  %1 = "quant.qbarrier"(%cst) : (tensor<2x3xf32>) -> tensor<2x3x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<2x3x!quant<"uniform[i8:f32:0]{7.812500e-03,3.125000e-02}">>) -> (tensor<2x3xf32>)
+  return %2 : tensor<2x3xf32>
+}
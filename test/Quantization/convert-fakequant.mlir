@@ -75,3 +75,20 @@ func @fakeQuantArgs_UnrankedTensor(tensor<f32>) -> tensor<f32> {
   } : (tensor<f32>) -> tensor<f32>
   return %0 : tensor<f32>
 }
+
+// -----
+// Verifies a per-axis quint8 range, with an asymmetric 0..1 range for the
+// first slice along the last dimension and a symmetric range of -1..127/128 for
+// the second.
+// CHECK-LABEL: fakeQuantPerAxis_Quint8
+func @fakeQuantPerAxis_Quint8(tensor<8x4x2xf32>) -> tensor<8x4x2xf32> {
+^bb0(%arg0: tensor<8x4x2xf32>):
+  // CHECK: %0 = "quant.qbarrier"(%arg0) : (tensor<8x4x2xf32>)
+  // CHECK-SAME: -> tensor<8x4x2x!quant<"uniform[u8:f32:2]{0.0039215686274509803,7.812500e-03:128}">>
+  // CHECK-NEXT: %1 = "quant.dbarrier"(%0) : (tensor<8x4x2x!quant<"uniform[u8:f32:2]{0.0039215686274509803,7.812500e-03:128}">>)
+  // CHECK-SAME: -> tensor<8x4x2xf32>
+  %0 = "quant.const_fake_quant_per_axis"(%arg0) {
+    min: [0.0, -1.0], max: [1.0, 0.9921875], axis: 2, num_bits: 8
+  } : (tensor<8x4x2xf32>) -> tensor<8x4x2xf32>
+  return %0 : tensor<8x4x2xf32>
+}
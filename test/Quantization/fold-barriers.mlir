@@ -0,0 +1,77 @@
+// RUN: mlir-opt %s -split-input-file -quant-fold-barriers | FileCheck %s --dump-input=fail
+
+// -----
+// A requantization to the same type is removed.
+// CHECK-LABEL: fold_requantize_same_type
+func @fold_requantize_same_type(%arg0: tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>) -> tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">> {
+  // CHECK-NEXT: return %arg0
+  %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>) -> tensor<4xf32>
+  %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>
+  return %1 : tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>
+}
+
+// -----
+// An identity qbarrier of a dequantized value is removed.
+// CHECK-LABEL: fold_identity_qbarrier
+func @fold_identity_qbarrier(%arg0: tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>) -> tensor<4xf32> {
+  // CHECK-NEXT: %0 = "quant.dbarrier"(%arg0)
+  // CHECK-NEXT: return %0
+  %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>) -> tensor<4xf32>
+  %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4xf32>
+  return %1 : tensor<4xf32>
+}
+
+// -----
+// A chain of requantizations whose first step is lossless, from i8 to i16
+// with a scale 4 times smaller, is folded into a single requantization.
+// CHECK-LABEL: fold_requantize_chain
+func @fold_requantize_chain(%arg0: tensor<4x!quant<"uniform[i8:f32]{1.0:1}">>) -> tensor<4x!quant<"uniform[u8:f32]{0.5:128}">> {
+  // CHECK-NEXT: %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{1.000000e+00:1}">>) -> tensor<4xf32>
+  // CHECK-NEXT: %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[u8:f32]{5.000000e-01:128}">>
+  // CHECK-NEXT: return %1
+  %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{1.0:1}">>) -> tensor<4xf32>
+  %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i16:f32]{0.25:-3}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<4x!quant<"uniform[i16:f32]{0.25:-3}">>) -> tensor<4xf32>
+  %3 = "quant.qbarrier"(%2) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[u8:f32]{0.5:128}">>
+  return %3 : tensor<4x!quant<"uniform[u8:f32]{0.5:128}">>
+}
+
+// -----
+// A chain of requantizations back to the original type through a lossless
+// step is removed altogether.
+// CHECK-LABEL: fold_requantize_chain_roundtrip
+func @fold_requantize_chain_roundtrip(%arg0: tensor<4x!quant<"uniform[i8:f32]{1.0}">>) -> tensor<4x!quant<"uniform[i8:f32]{1.0}">> {
+  // CHECK-NEXT: return %arg0
+  %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{1.0}">>) -> tensor<4xf32>
+  %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i16:f32]{0.5}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<4x!quant<"uniform[i16:f32]{0.5}">>) -> tensor<4xf32>
+  %3 = "quant.qbarrier"(%2) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i8:f32]{1.0}">>
+  return %3 : tensor<4x!quant<"uniform[i8:f32]{1.0}">>
+}
+
+// -----
+// A chain of requantizations through a lossy step, which rounds to a coarser
+// scale, is left as-is.
+// CHECK-LABEL: no_fold_lossy_requantize_chain
+func @no_fold_lossy_requantize_chain(%arg0: tensor<4x!quant<"uniform[i8:f32]{0.5}">>) -> tensor<4x!quant<"uniform[i8:f32]{0.25}">> {
+  // CHECK-NEXT: %0 = "quant.dbarrier"(%arg0)
+  // CHECK-NEXT: %1 = "quant.qbarrier"(%0)
+  // CHECK-NEXT: %2 = "quant.dbarrier"(%1)
+  // CHECK-NEXT: %3 = "quant.qbarrier"(%2)
+  %0 = "quant.dbarrier"(%arg0) : (tensor<4x!quant<"uniform[i8:f32]{0.5}">>) -> tensor<4xf32>
+  %1 = "quant.qbarrier"(%0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i8:f32]{1.0}">>
+  %2 = "quant.dbarrier"(%1) : (tensor<4x!quant<"uniform[i8:f32]{1.0}">>) -> tensor<4xf32>
+  %3 = "quant.qbarrier"(%2) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i8:f32]{0.25}">>
+  return %3 : tensor<4x!quant<"uniform[i8:f32]{0.25}">>
+}
+
+// -----
+// The simulated quantization of an expressed value is left as-is.
+// CHECK-LABEL: no_fold_quantize_dequantize
+func @no_fold_quantize_dequantize(%arg0: tensor<4xf32>) -> tensor<4xf32> {
+  // CHECK-NEXT: %0 = "quant.qbarrier"(%arg0)
+  // CHECK-NEXT: %1 = "quant.dbarrier"(%0)
+  %0 = "quant.qbarrier"(%arg0) : (tensor<4xf32>) -> tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>
+  %1 = "quant.dbarrier"(%0) : (tensor<4x!quant<"uniform[i8:f32]{6.25e-2}">>) -> tensor<4xf32>
+  return %1 : tensor<4xf32>
+}
@@ -135,3 +135,8 @@
 // provided.
 // expected-error@+1 {{multiple scales/zeroPoints provided, but quantizedDimension wasn't specified}}
 !qalias = type !quant<"uniform[i8(-4:3):f32]{2.000000e+02,-19.987200e-01:1}">
+
+// -----
+// Illegal uniform params: negative quantized dimension
+// expected-error@+1 {{illegal quantized dimension: -1}}
+!qalias = type !quant<"uniform[i8:f32:-1]{2.000000e+02,9.987200e-01}">
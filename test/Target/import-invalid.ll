@@ -0,0 +1,7 @@
+; RUN: not mlir-translate -import-llvm %s 2>&1 | FileCheck %s
+
+; CHECK: unsupported instruction:   %cmp = fcmp olt float %a, %b
+define i1 @fcmp(float %a, float %b) {
+  %cmp = fcmp olt float %a, %b
+  ret i1 %cmp
+}
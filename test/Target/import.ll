@@ -0,0 +1,71 @@
+; RUN: mlir-translate -import-llvm %s | FileCheck %s
+
+; CHECK: func @callee(!llvm<"float">) -> !llvm<"float">
+declare float @callee(float)
+
+; CHECK-LABEL: func @scalar_loop(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">) -> !llvm<"float"> {
+define float @scalar_loop(float* %p, i64 %n) {
+entry:
+; CHECK:      %[[ZERO:[0-9]+]] = llvm.constant(0 : i64) : !llvm<"i64">
+; CHECK-NEXT: %[[FZERO:[0-9]+]] = llvm.constant(0.000000e+00 : f32) : !llvm<"float">
+; CHECK-NEXT: llvm.br ^bb1(%[[ZERO]], %[[FZERO]] : !llvm<"i64">, !llvm<"float">)
+  br label %loop
+
+; CHECK:      ^bb1(%[[I:[0-9]+]]: !llvm<"i64">, %[[ACC:[0-9]+]]: !llvm<"float">):
+; CHECK-NEXT: %[[PTR:[0-9]+]] = llvm.getelementptr %arg0[%[[I]]] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+; CHECK-NEXT: %[[VAL:[0-9]+]] = llvm.load %[[PTR]] {alignment: 4} : !llvm<"float*">
+; CHECK-NEXT: %[[SUM:[0-9]+]] = llvm.fadd %[[ACC]], %[[VAL]] : !llvm<"float">
+; CHECK-NEXT: %[[ONE:[0-9]+]] = llvm.constant(1 : i64) : !llvm<"i64">
+; CHECK-NEXT: %[[NEXT:[0-9]+]] = llvm.add %[[I]], %[[ONE]] : !llvm<"i64">
+; CHECK-NEXT: %[[CMP:[0-9]+]] = llvm.icmp "slt" %[[NEXT]], %arg1 : !llvm<"i64">
+; CHECK-NEXT: llvm.cond_br %[[CMP]], ^bb1(%[[NEXT]], %[[SUM]] : !llvm<"i64">, !llvm<"float">), ^bb2
+loop:
+  %i = phi i64 [ 0, %entry ], [ %next, %loop ]
+  %acc = phi float [ 0.0, %entry ], [ %sum, %loop ]
+  %ptr = getelementptr float, float* %p, i64 %i
+  %val = load float, float* %ptr, align 4
+  %sum = fadd float %acc, %val
+  %next = add i64 %i, 1
+  %cmp = icmp slt i64 %next, %n
+  br i1 %cmp, label %loop, label %exit
+
+; CHECK:      ^bb2:
+; CHECK-NEXT: %[[RES:[0-9]+]] = llvm.call @callee(%[[SUM]]) : (!llvm<"float">) -> !llvm<"float">
+; CHECK-NEXT: llvm.return %[[RES]] : !llvm<"float">
+exit:
+  %res = call float @callee(float %sum)
+  ret float %res
+}
+
+; CHECK-LABEL: func @vector_ops(%arg0: !llvm<"<4 x float>">, %arg1: !llvm<"i32">) -> !llvm<"<4 x i32>"> {
+define <4 x i32> @vector_ops(<4 x float> %v, i32 %x) {
+; CHECK-NEXT: %0 = llvm.constant(dense<vector<4xf32>, [1.000000e+00, 2.000000e+00, 0.000000e+00, 0.000000e+00]>) : !llvm<"<4 x float>">
+; CHECK-NEXT: %1 = llvm.fmul %arg0, %0 : !llvm<"<4 x float>">
+; CHECK-NEXT: %2 = llvm.fptosi %1 : !llvm<"<4 x float>"> to !llvm<"<4 x i32>">
+; CHECK-NEXT: %3 = llvm.constant(0 : i32) : !llvm<"i32">
+; CHECK-NEXT: %4 = "llvm.insertelement"(%2, %arg1, %3) : (!llvm<"<4 x i32>">, !llvm<"i32">, !llvm<"i32">) -> !llvm<"<4 x i32>">
+; CHECK-NEXT: %5 = llvm.undef : !llvm<"<4 x i32>">
+; CHECK-NEXT: %6 = "llvm.shufflevector"(%4, %5) {mask: [0, 0, 0, 0]} : (!llvm<"<4 x i32>">, !llvm<"<4 x i32>">) -> !llvm<"<4 x i32>">
+; CHECK-NEXT: llvm.return %6 : !llvm<"<4 x i32>">
+  %m = fmul <4 x float> %v, <float 1.0, float 2.0, float undef, float 0.0>
+  %c = fptosi <4 x float> %m to <4 x i32>
+  %e = insertelement <4 x i32> %c, i32 %x, i32 0
+  %s = shufflevector <4 x i32> %e, <4 x i32> undef, <4 x i32> zeroinitializer
+  ret <4 x i32> %s
+}
+
+; CHECK-LABEL: func @fastmath(%arg0: !llvm<"float">) -> !llvm<"float"> {
+define float @fastmath(float %x) {
+; CHECK-NEXT: %0 = llvm.fmul %arg0, %arg0 {fastmath: ["fast"]} : !llvm<"float">
+; CHECK-NEXT: %1 = llvm.fadd %0, %arg0 {fastmath: ["nsz", "reassoc"]} : !llvm<"float">
+  %m = fmul fast float %x, %x
+  %a = fadd reassoc nsz float %m, %x
+  ret float %a
+}
+
+; CHECK-LABEL: func @inbounds_gep(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">) -> !llvm<"float*"> {
+; CHECK-NEXT: %0 = llvm.getelementptr %arg0[%arg1] {inbounds: true} : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+define float* @inbounds_gep(float* %p, i64 %i) {
+  %ptr = getelementptr inbounds float, float* %p, i64 %i
+  ret float* %ptr
+}
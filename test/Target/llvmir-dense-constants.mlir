@@ -0,0 +1,29 @@
+// RUN: cd %S && mlir-translate -mlir-to-llvmir %s | FileCheck %s
+
+// CHECK-LABEL: define <4 x i32> @dense_file()
+func @dense_file() -> !llvm<"<4 x i32>"> {
+  // CHECK: ret <4 x i32> <i32 1, i32 2, i32 3, i32 4>
+  %0 = llvm.constant(dense<vector<4xi32>, "../IR/Inputs/dense-blob.bin", 0>) : !llvm<"<4 x i32>">
+  llvm.return %0 : !llvm<"<4 x i32>">
+}
+
+// CHECK-LABEL: define <3 x float> @dense_splat()
+func @dense_splat() -> !llvm<"<3 x float>"> {
+  // CHECK: ret <3 x float> <float 2.500000e+00, float 2.500000e+00, float 2.500000e+00>
+  %0 = llvm.constant(dense<vector<3xf32>, [2.5, 2.5, 2.5]>) : !llvm<"<3 x float>">
+  llvm.return %0 : !llvm<"<3 x float>">
+}
+
+// CHECK-LABEL: define <4 x i32> @sparse_int()
+func @sparse_int() -> !llvm<"<4 x i32>"> {
+  // CHECK: ret <4 x i32> <i32 0, i32 5, i32 0, i32 7>
+  %0 = llvm.constant(sparse<vector<4xi32>, [[1], [3]], [5, 7]>) : !llvm<"<4 x i32>">
+  llvm.return %0 : !llvm<"<4 x i32>">
+}
+
+// CHECK-LABEL: define <3 x float> @sparse_float()
+func @sparse_float() -> !llvm<"<3 x float>"> {
+  // CHECK: ret <3 x float> <float 0.000000e+00, float 0.000000e+00, float 1.500000e+00>
+  %0 = llvm.constant(sparse<vector<3xf32>, [[2]], [1.5]>) : !llvm<"<3 x float>">
+  llvm.return %0 : !llvm<"<3 x float>">
+}
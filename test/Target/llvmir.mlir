@@ -1,4 +1,5 @@
 // RUN: mlir-translate -mlir-to-llvmir %s | FileCheck %s
+// RUN: mlir-translate -mlir-to-llvmir -llvmir-consume-input %s | FileCheck %s
 
 //
 // Declarations of the allocation functions to be linked against.
@@ -789,7 +790,119 @@ func @cond_br_arguments(%arg0: !llvm<"i1">, %arg1: !llvm<"i1">) {
   llvm.br ^bb1(%arg1 : !llvm<"i1">)
 }
 
+// CHECK-LABEL: define void @loop_metadata(float*)
+func @loop_metadata(%arg0: !llvm<"float*">) {
+  %0 = llvm.constant(0 : index) : !llvm<"i64">
+  %1 = llvm.constant(64 : index) : !llvm<"i64">
+  %2 = llvm.constant(1 : index) : !llvm<"i64">
+  llvm.br ^bb1(%0 : !llvm<"i64">)
+^bb1(%3: !llvm<"i64">):
+  %4 = llvm.icmp "slt" %3, %1 : !llvm<"i64">
+  llvm.cond_br %4, ^bb2, ^bb3
+^bb2:
+// CHECK: load float, float* %{{.*}}, !llvm.access.group ![[GROUP:[0-9]+]]
+// CHECK: store float %{{.*}}, float* %{{.*}}, !llvm.access.group ![[GROUP]]
+// CHECK: br label %{{.*}}, !llvm.loop ![[LOOP:[0-9]+]]
+  %5 = llvm.getelementptr %arg0[%3] : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  %6 = llvm.load %5 : !llvm<"float*">
+  llvm.store %6, %5 : !llvm<"float*">
+  %7 = llvm.add %3, %2 : !llvm<"i64">
+  llvm.br ^bb1(%7 : !llvm<"i64">) {llvm.loop.parallel: true, llvm.loop.unroll.disable: true, llvm.loop.vectorize.width: 4}
+^bb3:
+  llvm.return
+}
 // CHECK-LABEL: define void @llvm_noalias(float* noalias) {
 func @llvm_noalias(%arg0: !llvm<"float*"> {llvm.noalias: true}) {
   llvm.return
 }
+
+// CHECK-LABEL: define void @llvm_align_dereferenceable(float* align 32 dereferenceable(128))
+func @llvm_align_dereferenceable(%arg0: !llvm<"float*"> {llvm.align: 32, llvm.dereferenceable: 128}) {
+  llvm.return
+}
+
+// CHECK-LABEL: define void @aligned_load_store(float*)
+func @aligned_load_store(%arg0: !llvm<"float*">) {
+// CHECK-NEXT: %2 = load float, float* %0, align 16
+  %0 = llvm.load %arg0 {alignment: 16} : !llvm<"float*">
+// CHECK-NEXT: store float %2, float* %0, align 16
+  llvm.store %0, %arg0 {alignment: 16} : !llvm<"float*">
+  llvm.return
+}
+
+// CHECK-LABEL: define <4 x float> @masked_vector_ops(<4 x float>*, <4 x float*>, <4 x i1>, <4 x float>)
+func @masked_vector_ops(%ptr: !llvm<"<4 x float>*">, %ptrs: !llvm<"<4 x float*>">, %mask: !llvm<"<4 x i1>">, %pass: !llvm<"<4 x float>">) -> !llvm<"<4 x float>"> {
+// CHECK-NEXT: %5 = call <4 x float> @llvm.masked.load.v4f32.p0v4f32(<4 x float>* %0, i32 4, <4 x i1> %2, <4 x float> %3)
+  %0 = "llvm.intr.masked.load"(%ptr, %mask, %pass) {alignment: 4 : i32} : (!llvm<"<4 x float>*">, !llvm<"<4 x i1>">, !llvm<"<4 x float>">) -> !llvm<"<4 x float>">
+// CHECK-NEXT: call void @llvm.masked.store.v4f32.p0v4f32(<4 x float> %5, <4 x float>* %0, i32 4, <4 x i1> %2)
+  "llvm.intr.masked.store"(%0, %ptr, %mask) {alignment: 4 : i32} : (!llvm<"<4 x float>">, !llvm<"<4 x float>*">, !llvm<"<4 x i1>">) -> ()
+// CHECK-NEXT: %6 = call <4 x float> @llvm.masked.gather.v4f32.v4p0f32(<4 x float*> %1, i32 4, <4 x i1> %2, <4 x float> %3)
+  %1 = "llvm.intr.masked.gather"(%ptrs, %mask, %pass) {alignment: 4 : i32} : (!llvm<"<4 x float*>">, !llvm<"<4 x i1>">, !llvm<"<4 x float>">) -> !llvm<"<4 x float>">
+// CHECK-NEXT: call void @llvm.masked.scatter.v4f32.v4p0f32(<4 x float> %6, <4 x float*> %1, i32 4, <4 x i1> %2)
+  "llvm.intr.masked.scatter"(%1, %ptrs, %mask) {alignment: 4 : i32} : (!llvm<"<4 x float>">, !llvm<"<4 x float*>">, !llvm<"<4 x i1>">) -> ()
+  llvm.return %1 : !llvm<"<4 x float>">
+}
+
+// CHECK-LABEL: define float @vector_element_ops(<4 x float>, i64)
+func @vector_element_ops(%v: !llvm<"<4 x float>">, %i: !llvm<"i64">) -> !llvm<"float"> {
+// CHECK-NEXT: %3 = extractelement <4 x float> %0, i64 %1
+  %0 = "llvm.extractelement"(%v, %i) : (!llvm<"<4 x float>">, !llvm<"i64">) -> !llvm<"float">
+// CHECK-NEXT: %4 = insertelement <4 x float> %0, float %3, i64 %1
+  %1 = "llvm.insertelement"(%v, %0, %i) : (!llvm<"<4 x float>">, !llvm<"float">, !llvm<"i64">) -> !llvm<"<4 x float>">
+// CHECK-NEXT: %5 = shufflevector <4 x float> %4, <4 x float> %0, <2 x i32> <i32 0, i32 5>
+  %2 = "llvm.shufflevector"(%1, %v) {mask: [0, 5]} : (!llvm<"<4 x float>">, !llvm<"<4 x float>">) -> !llvm<"<2 x float>">
+// CHECK-NEXT: %6 = call reassoc float @llvm.experimental.vector.reduce.{{.*}}fadd.{{.*}}v2f32(float -0.000000e+00, <2 x float> %5)
+  %3 = llvm.constant(-0.0 : f32) : !llvm<"float">
+  %4 = "llvm.intr.vector.reduce.fadd"(%3, %2) : (!llvm<"float">, !llvm<"<2 x float>">) -> !llvm<"float">
+  llvm.return %4 : !llvm<"float">
+}
+
+// CHECK-LABEL: define i32 @vector_int_reductions(<8 x i32>)
+func @vector_int_reductions(%v: !llvm<"<8 x i32>">) -> !llvm<"i32"> {
+// CHECK-NEXT: %2 = call i32 @llvm.experimental.vector.reduce.add.{{.*}}v8i32(<8 x i32> %0)
+  %0 = "llvm.intr.vector.reduce.add"(%v) : (!llvm<"<8 x i32>">) -> !llvm<"i32">
+// CHECK-NEXT: %3 = call i32 @llvm.experimental.vector.reduce.smax.{{.*}}v8i32(<8 x i32> %0)
+  %1 = "llvm.intr.vector.reduce.smax"(%v) : (!llvm<"<8 x i32>">) -> !llvm<"i32">
+  %2 = llvm.add %0, %1 : !llvm<"i32">
+  llvm.return %2 : !llvm<"i32">
+}
+
+// The metadata is printed after all of the functions.
+// CHECK-DAG: ![[GROUP]] = distinct !{}
+// CHECK-DAG: ![[LOOP]] = distinct !{![[LOOP]], ![[PARALLEL:[0-9]+]], ![[WIDTH:[0-9]+]], ![[ENABLE:[0-9]+]], ![[UNROLL:[0-9]+]]}
+// CHECK-DAG: ![[PARALLEL]] = !{!"llvm.loop.parallel_accesses", ![[GROUP]]}
+// CHECK-DAG: ![[WIDTH]] = !{!"llvm.loop.vectorize.width", i32 4}
+// CHECK-DAG: ![[ENABLE]] = !{!"llvm.loop.vectorize.enable", i1 true}
+// CHECK-DAG: ![[UNROLL]] = !{!"llvm.loop.unroll.disable"}
+
+// CHECK-LABEL: define float @inbounds_gep(float*, i64) {
+func @inbounds_gep(%arg0: !llvm<"float*">, %arg1: !llvm<"i64">) -> !llvm<"float"> {
+// CHECK-NEXT: %3 = getelementptr inbounds float, float* %0, i64 %1
+  %0 = llvm.getelementptr %arg0[%arg1] {inbounds: true} : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+// CHECK-NEXT: %4 = getelementptr float, float* %0, i64 %1
+  %1 = llvm.getelementptr %arg0[%arg1] {inbounds: false} : (!llvm<"float*">, !llvm<"i64">) -> !llvm<"float*">
+  %2 = llvm.load %0 : !llvm<"float*">
+  %3 = llvm.load %1 : !llvm<"float*">
+  %4 = llvm.fadd %2, %3 : !llvm<"float">
+  llvm.return %4 : !llvm<"float">
+}
+
+// CHECK-LABEL: define float @fastmath(float) {
+func @fastmath(%arg0: !llvm<"float">) -> !llvm<"float"> {
+// CHECK-NEXT: %2 = fmul fast float %0, %0
+  %0 = llvm.fmul %arg0, %arg0 {fastmath: ["fast"]} : !llvm<"float">
+// CHECK-NEXT: %3 = fadd reassoc nsz float %2, %0
+  %1 = llvm.fadd %0, %arg0 {fastmath: ["reassoc", "nsz"]} : !llvm<"float">
+// CHECK-NEXT: %4 = fsub float %3, %0
+  %2 = llvm.fsub %1, %arg0 : !llvm<"float">
+  llvm.return %2 : !llvm<"float">
+}
+
+// CHECK-LABEL: define <4 x float> @fmuladd(float, <4 x float>) {
+func @fmuladd(%arg0: !llvm<"float">, %arg1: !llvm<"<4 x float>">) -> !llvm<"<4 x float>"> {
+// CHECK-NEXT: %3 = call contract float @llvm.fmuladd.f32(float %0, float %0, float %0)
+  %0 = "llvm.intr.fmuladd"(%arg0, %arg0, %arg0) {fastmath: ["contract"]} : (!llvm<"float">, !llvm<"float">, !llvm<"float">) -> !llvm<"float">
+// CHECK-NEXT: %4 = call <4 x float> @llvm.fmuladd.v4f32(<4 x float> %1, <4 x float> %1, <4 x float> %1)
+  %1 = "llvm.intr.fmuladd"(%arg1, %arg1, %arg1) : (!llvm<"<4 x float>">, !llvm<"<4 x float>">, !llvm<"<4 x float>">) -> !llvm<"<4 x float>">
+  llvm.return %1 : !llvm<"<4 x float>">
+}
@@ -202,3 +202,46 @@ func @materialize_write(%M: index, %N: index, %O: index, %P: index) {
   }
   return
 }
+
+// The 1-D transfers along the innermost dimension that stay in bounds are not
+// staged in a local buffer: they are marked as in bounds, and reads lose their
+// unused padding value.
+// CHECK-LABEL: func @direct_transfers
+func @direct_transfers(%A : memref<16x128xf32>, %f0 : f32) {
+  // CHECK-NOT: alloc
+  affine.for %i0 = 0 to 16 {
+    affine.for %i1 = 0 to 128 step 8 {
+      // CHECK: %[[V:.*]] = vector.transfer_read %arg0[%i0, %i1] {permutation_map: #{{.*}}, in_bounds: true} : memref<16x128xf32>, vector<8xf32>
+      %v = vector.transfer_read %A[%i0, %i1], (%f0) {permutation_map: (d0, d1) -> (d1)} : memref<16x128xf32>, vector<8xf32>
+      // CHECK-NEXT: vector.transfer_write %[[V]], %arg0[%i0, %i1] {permutation_map: #{{.*}}, in_bounds: true} : vector<8xf32>, memref<16x128xf32>
+      vector.transfer_write %v, %A[%i0, %i1] {permutation_map: (d0, d1) -> (d1)} : vector<8xf32>, memref<16x128xf32>
+    }
+  }
+  return
+}
+
+// The other transfers that stay in bounds are staged without clipping.
+// CHECK-LABEL: func @unclipped_transfer
+func @unclipped_transfer(%A : memref<16x128xf32>, %f0 : f32) {
+  affine.for %i0 = 0 to 16 step 4 {
+    affine.for %i1 = 0 to 128 {
+      // CHECK: alloc() : memref<4xf32>
+      // CHECK-NOT: select
+      // CHECK: dealloc
+      %v = vector.transfer_read %A[%i0, %i1], (%f0) {permutation_map: (d0, d1) -> (d0)} : memref<16x128xf32>, vector<4xf32>
+    }
+  }
+  return
+}
+
+// A transfer that may cross the end of the memref is still staged.
+// CHECK-LABEL: func @partial_transfer
+func @partial_transfer(%A : memref<16x100xf32>, %f0 : f32) {
+  affine.for %i0 = 0 to 16 {
+    affine.for %i1 = 0 to 100 step 8 {
+      // CHECK: alloc() : memref<8xf32>
+      %v = vector.transfer_read %A[%i0, %i1], (%f0) {permutation_map: (d0, d1) -> (d1)} : memref<16x100xf32>, vector<8xf32>
+    }
+  }
+  return
+}
@@ -0,0 +1,53 @@
+// RUN: mlir-opt %s -materialize-vectors -target-vector-width=32 | FileCheck %s
+// RUN: mlir-opt %s -materialize-vectors -target-vector-width=16 | FileCheck %s --check-prefix=WIDTH16
+
+// Without an explicit -vector-size, the hardware vector fills a vector
+// register of the target for the elemental type of each super-vector.
+
+// CHECK-LABEL: func @materialize_i8
+// WIDTH16-LABEL: func @materialize_i8
+func @materialize_i8(%A : memref<?xi8>, %B : memref<?xi8>, %N : index) {
+  // vector<64xi8> -> 2 x vector<32xi8> (4 x vector<16xi8> for 16 bytes).
+  // CHECK: affine.for %i0 = 0 to %arg2 step 64 {
+  // CHECK: vector.transfer_read {{.*}} : memref<?xi8>, vector<32xi8>
+  // CHECK: vector.transfer_read {{.*}} : memref<?xi8>, vector<32xi8>
+  // CHECK: addi {{.*}} : vector<32xi8>
+  // CHECK: addi {{.*}} : vector<32xi8>
+  // CHECK: vector.transfer_write {{.*}} : vector<32xi8>, memref<?xi8>
+  // CHECK: vector.transfer_write {{.*}} : vector<32xi8>, memref<?xi8>
+  // CHECK-NOT: vector<64xi8>
+  // WIDTH16: vector.transfer_read {{.*}} : memref<?xi8>, vector<16xi8>
+  // WIDTH16: vector.transfer_read {{.*}} : memref<?xi8>, vector<16xi8>
+  // WIDTH16: vector.transfer_read {{.*}} : memref<?xi8>, vector<16xi8>
+  // WIDTH16: vector.transfer_read {{.*}} : memref<?xi8>, vector<16xi8>
+  affine.for %i = 0 to %N step 64 {
+    %a = vector.transfer_read %A[%i] {permutation_map: (d0) -> (d0)} : memref<?xi8>, vector<64xi8>
+    %b = addi %a, %a : vector<64xi8>
+    vector.transfer_write %b, %B[%i] {permutation_map: (d0) -> (d0)} : vector<64xi8>, memref<?xi8>
+  }
+  return
+}
+
+// CHECK-LABEL: func @materialize_f64
+func @materialize_f64(%A : memref<?xf64>, %N : index) {
+  // vector<8xf64> -> 2 x vector<4xf64>.
+  // CHECK: vector.transfer_write {{.*}} : vector<4xf64>, memref<?xf64>
+  // CHECK: vector.transfer_write {{.*}} : vector<4xf64>, memref<?xf64>
+  // CHECK-NOT: vector<8xf64>
+  %cst = constant splat<vector<8xf64>, 1.000000e+00> : vector<8xf64>
+  affine.for %i = 0 to %N step 8 {
+    vector.transfer_write %cst, %A[%i] {permutation_map: (d0) -> (d0)} : vector<8xf64>, memref<?xf64>
+  }
+  return
+}
+
+// A super-vector that is not a multiple of the hardware vector is left as is.
+// CHECK-LABEL: func @no_materialize_i16
+func @no_materialize_i16(%A : memref<?xi16>, %N : index) {
+  // CHECK: vector.transfer_write {{.*}} : vector<8xi16>, memref<?xi16>
+  %cst = constant splat<vector<8xi16>, 1> : vector<8xi16>
+  affine.for %i = 0 to %N step 8 {
+    vector.transfer_write %cst, %A[%i] {permutation_map: (d0) -> (d0)} : vector<8xi16>, memref<?xi16>
+  }
+  return
+}
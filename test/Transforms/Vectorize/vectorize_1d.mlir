@@ -129,6 +129,22 @@ func @vector_add_2d(%M : index, %N : index) -> f32 {
   return %res : f32
 }
 
+// The scalars defined above the vectorized loop are broadcast.
+// CHECK-LABEL: func @vec_broadcast_scalar
+func @vec_broadcast_scalar(%A : memref<?xf32>, %f : f32) {
+  %N = dim %A, 0 : memref<?xf32>
+  affine.for %i = 0 to %N {
+    // CHECK: [[A:%.*]] = vector.transfer_read %arg0[{{.*}}] {permutation_map: {{.*}}} : memref<?xf32>, vector<128xf32>
+    // CHECK-NEXT: [[F:%.*]] = vector.broadcast %arg1 : f32, vector<128xf32>
+    // CHECK-NEXT: [[S:%.*]] = mulf [[A]], [[F]] : vector<128xf32>
+    // CHECK-NEXT: vector.transfer_write [[S]], %arg0[{{.*}}] {permutation_map: {{.*}}} : vector<128xf32>, memref<?xf32>
+    %a = load %A[%i] : memref<?xf32>
+    %s = mulf %a, %f : f32
+    store %s, %A[%i] : memref<?xf32>
+  }
+  return
+}
+
 // CHECK-LABEL: func @vec_rejected_1
 func @vec_rejected_1(%A : memref<?x?xf32>, %B : memref<?x?x?xf32>) {
 // CHECK-DAG: [[C0:%[a-z0-9_]+]] = constant 0 : index
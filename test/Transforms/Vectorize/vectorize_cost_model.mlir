@@ -0,0 +1,40 @@
+// RUN: mlir-opt %s -vectorize -vectorize-cost-model | FileCheck %s
+// RUN: mlir-opt %s -vectorize -vectorize-cost-model -virtual-vector-size 128 | FileCheck %s --check-prefix=VECT128
+
+// Permutation maps used in vectorization.
+// CHECK: #[[map_proj_d0d1_d1:map[0-9]+]] = (d0, d1) -> (d1)
+
+// The accesses are contiguous along the outer loop, which is vectorized rather
+// than the inner one. Without a virtual vector size, the vector holds as many
+// f32 elements as a 32 byte vector register.
+// CHECK-LABEL: func @vec_contiguous_outer_loop
+func @vec_contiguous_outer_loop(%A : memref<256x512xf32>) {
+  // CHECK: affine.for %i0 = 0 to 512 step 8 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 256 {
+  // CHECK-NEXT:     {{.*}} = vector.transfer_read %arg0[%i1, %i0] {permutation_map: #[[map_proj_d0d1_d1]]} : memref<256x512xf32>, vector<8xf32>
+  affine.for %i = 0 to 512 {
+    affine.for %j = 0 to 256 {
+      %a = load %A[%j, %i] : memref<256x512xf32>
+    }
+  }
+  return
+}
+
+// The accesses are contiguous along the inner loop, which is vectorized. An
+// explicit virtual vector size is honored.
+// CHECK-LABEL: func @vec_contiguous_inner_loop
+func @vec_contiguous_inner_loop(%A : memref<256x512xf32>) {
+  // CHECK: affine.for %i0 = 0 to 256 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 512 step 8 {
+  // CHECK-NEXT:     {{.*}} = vector.transfer_read %arg0[%i0, %i1] {permutation_map: #[[map_proj_d0d1_d1]]} : memref<256x512xf32>, vector<8xf32>
+  affine.for %i = 0 to 256 {
+    affine.for %j = 0 to 512 {
+      %a = load %A[%i, %j] : memref<256x512xf32>
+    }
+  }
+  return
+}
+
+// VECT128-LABEL: func @vec_contiguous_inner_loop
+// VECT128: affine.for %i0 = 0 to 256 {
+// VECT128-NEXT:   affine.for %i1 = 0 to 512 step 128 {
@@ -0,0 +1,69 @@
+// RUN: mlir-opt %s -vectorize -virtual-vector-size 128 -vectorize-reductions | FileCheck %s
+
+// CHECK-LABEL: func @vec_sum
+func @vec_sum(%A : memref<1024xf32>, %S : memref<1xf32>) {
+  %c0 = constant 0 : index
+  // The partial accumulators are initialized to the identity of addf.
+  // CHECK:      [[P:%[0-9]+]] = alloc() : memref<128xf32>
+  // CHECK:      affine.for %i0 = 0 to 128 step 128 {
+  // CHECK-NEXT:   {{.*}} = constant splat<vector<128xf32>, 0.000000e+00> : vector<128xf32>
+  // CHECK-NEXT:   vector.transfer_write {{.*}}, [[P]][%i0] {{.*}} : vector<128xf32>, memref<128xf32>
+  // CHECK-NEXT: }
+  // Each lane accumulates into its own partial accumulator.
+  // CHECK-NEXT: affine.for %i1 = 0 to 1024 step 128 {
+  // CHECK-NEXT:   affine.for %i2 = 0 to 128 step 128 {
+  // CHECK:          [[A:%.*]] = vector.transfer_read %arg0[{{.*}}] {{.*}} : memref<1024xf32>, vector<128xf32>
+  // CHECK-NEXT:     [[ACC:%.*]] = vector.transfer_read [[P]][%i2] {{.*}} : memref<128xf32>, vector<128xf32>
+  // CHECK-NEXT:     [[SUM:%.*]] = addf [[ACC]], [[A]] : vector<128xf32>
+  // CHECK-NEXT:     vector.transfer_write [[SUM]], [[P]][%i2] {{.*}} : vector<128xf32>, memref<128xf32>
+  // CHECK:        }
+  // CHECK-NEXT: }
+  // The partial accumulators are then reduced into the original location.
+  // CHECK-NEXT: affine.for %i3 = 0 to 128 {
+  // CHECK-NEXT:   [[PL:%.*]] = load [[P]][%i3] : memref<128xf32>
+  // CHECK-NEXT:   [[S:%.*]] = load %arg1[%c0] : memref<1xf32>
+  // CHECK-NEXT:   [[R:%.*]] = addf [[S]], [[PL]] : f32
+  // CHECK-NEXT:   store [[R]], %arg1[%c0] : memref<1xf32>
+  // CHECK-NEXT: }
+  // CHECK-NEXT: dealloc [[P]] : memref<128xf32>
+  affine.for %i = 0 to 1024 {
+    %a = load %A[%i] : memref<1024xf32>
+    %s = load %S[%c0] : memref<1xf32>
+    %r = addf %s, %a : f32
+    store %r, %S[%c0] : memref<1xf32>
+  }
+  return
+}
+
+// A trip count that is not a multiple of the vector size leaves the reduction
+// untouched.
+// CHECK-LABEL: func @no_vec_sum_remainder
+func @no_vec_sum_remainder(%A : memref<1000xf32>, %S : memref<1xf32>) {
+  %c0 = constant 0 : index
+  // CHECK-NOT: alloc
+  // CHECK:      affine.for %i0 = 0 to 1000 {
+  // CHECK-NEXT:   {{.*}} = load %arg0[%i0] : memref<1000xf32>
+  affine.for %i = 0 to 1000 {
+    %a = load %A[%i] : memref<1000xf32>
+    %s = load %S[%c0] : memref<1xf32>
+    %r = addf %s, %a : f32
+    store %r, %S[%c0] : memref<1xf32>
+  }
+  return
+}
+
+// A loop storing to another memref than the accumulator is not a reduction.
+// CHECK-LABEL: func @no_vec_sum_other_store
+func @no_vec_sum_other_store(%A : memref<1024xf32>, %S : memref<1xf32>) {
+  %c0 = constant 0 : index
+  // CHECK-NOT: alloc
+  // CHECK: affine.for %i0 = 0 to 1024 {
+  affine.for %i = 0 to 1024 {
+    %a = load %A[%i] : memref<1024xf32>
+    %s = load %S[%c0] : memref<1xf32>
+    %r = addf %s, %a : f32
+    store %r, %S[%c0] : memref<1xf32>
+    store %r, %A[%i] : memref<1024xf32>
+  }
+  return
+}
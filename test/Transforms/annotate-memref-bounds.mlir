@@ -0,0 +1,53 @@
+// RUN: mlir-opt %s -annotate-memref-bounds | FileCheck %s
+// RUN: mlir-opt %s -annotate-memref-bounds -memref-bounds-runtime-checks | FileCheck %s --check-prefix=RUNTIME
+
+// CHECK-LABEL: func @static_bounds
+func @static_bounds(%A : memref<64xf32>, %B : memref<64x32xf32>) {
+  affine.for %i = 0 to 64 {
+    // CHECK: load %arg0[%i0] {in_bounds: true} : memref<64xf32>
+    %0 = load %A[%i] : memref<64xf32>
+    affine.for %j = 0 to 32 step 8 {
+      // CHECK: store %{{.*}}, %arg1[%i0, %i1] {in_bounds: true} : memref<64x32xf32>
+      store %0, %B[%i, %j] : memref<64x32xf32>
+      // CHECK: vector.transfer_read %arg1[%i0, %i1] {permutation_map: #{{.*}}, in_bounds: true} : memref<64x32xf32>, vector<8xf32>
+      %v = vector.transfer_read %B[%i, %j] {permutation_map: (d0, d1) -> (d1)} : memref<64x32xf32>, vector<8xf32>
+    }
+  }
+  return
+}
+
+// The indices bounded by the size of a dynamic dimension are in bounds.
+// CHECK-LABEL: func @dynamic_bounds
+func @dynamic_bounds(%A : memref<?xf32>) {
+  %c0 = constant 0 : index
+  %n = dim %A, 0 : memref<?xf32>
+  affine.for %i = 0 to %n {
+    // CHECK: load %arg0[%i0] {in_bounds: true} : memref<?xf32>
+    %0 = load %A[%i] : memref<?xf32>
+  }
+  return
+}
+
+// The other accesses are left unmarked, or checked at runtime.
+// CHECK-LABEL: func @unproven
+// RUNTIME-LABEL: func @unproven
+func @unproven(%A : memref<64xf32>, %B : memref<?xf32>, %k : index) {
+  affine.for %i = 0 to 65 {
+    // CHECK: load %arg0[%i0] : memref<64xf32>
+    // RUNTIME:      %[[SIZE:.*]] = constant 64 : index
+    // RUNTIME-NEXT: call @mlir_memref_bounds_check(%i0, %[[SIZE]]) : (index, index) -> ()
+    // RUNTIME-NEXT: load %arg0[%i0] {in_bounds: true} : memref<64xf32>
+    %0 = load %A[%i] : memref<64xf32>
+  }
+  // CHECK: store %{{.*}}, %arg1[%arg2] : memref<?xf32>
+  // RUNTIME:      %[[DIM:.*]] = dim %arg1, 0 : memref<?xf32>
+  // RUNTIME-NEXT: call @mlir_memref_bounds_check(%arg2, %[[DIM]]) : (index, index) -> ()
+  // RUNTIME-NEXT: store %{{.*}}, %arg1[%arg2] {in_bounds: true} : memref<?xf32>
+  %cst = constant 0.0 : f32
+  store %cst, %B[%k] : memref<?xf32>
+  return
+}
+
+// The runtime function is only declared when checks are inserted.
+// CHECK-NOT: func @mlir_memref_bounds_check
+// RUNTIME: func @mlir_memref_bounds_check(index, index)
@@ -0,0 +1,37 @@
+// RUN: mlir-opt %s -canonicalize | FileCheck %s
+// RUN: mlir-opt %s -canonicalize -experimental-mt-greedy-rewriter | FileCheck %s
+// RUN: mlir-opt %s -canonicalize -experimental-mt-greedy-rewriter -greedy-rewriter-max-iterations=4 | FileCheck %s
+
+// Independent loop nests are simplified in parallel, and their constant pools
+// are merged into the entry block of the function.
+
+// CHECK-LABEL: func @independent_nests
+func @independent_nests(%arg0: memref<8xi32>, %arg1: i32) {
+  // CHECK-NEXT: %c3_i32 = constant 3 : i32
+  %c1 = constant 1 : i32
+
+  // CHECK-NEXT: affine.for %i0 = 0 to 8 {
+  affine.for %i0 = 0 to 8 {
+    %c2 = constant 2 : i32
+    // CHECK-NEXT: %0 = addi %arg1, %c3_i32 : i32
+    %0 = addi %c1, %c2 : i32
+    %1 = addi %0, %arg1 : i32
+    // CHECK-NEXT: store %0, %arg0[%i0] : memref<8xi32>
+    store %1, %arg0[%i0] : memref<8xi32>
+    %dead = muli %arg1, %arg1 : i32
+  }
+  // CHECK-NEXT: }
+
+  // CHECK-NEXT: affine.for %i1 = 0 to 8 {
+  affine.for %i1 = 0 to 8 {
+    %c3 = constant 3 : i32
+    // CHECK-NEXT: %1 = addi %arg1, %c3_i32 : i32
+    %2 = addi %c3, %arg1 : i32
+    // CHECK-NEXT: store %1, %arg0[%i1] : memref<8xi32>
+    store %2, %arg0[%i1] : memref<8xi32>
+  }
+  // CHECK-NEXT: }
+
+  // CHECK-NEXT: return
+  return
+}
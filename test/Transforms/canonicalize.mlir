@@ -141,6 +141,18 @@ func @memref_cast_folding(%arg0: memref<4 x f32>, %arg1: f32) -> f32 {
   return %0 : f32
 }
 
+// CHECK-LABEL: func @dim_memref_cast_folding
+func @dim_memref_cast_folding(%arg0: memref<4x?xf32>) -> (index, index) {
+  %0 = memref_cast %arg0 : memref<4x?xf32> to memref<?x?xf32>
+  %1 = dim %0, 0 : memref<?x?xf32>
+  %2 = dim %0, 1 : memref<?x?xf32>
+
+  // CHECK-NEXT: %c4 = constant 4 : index
+  // CHECK-NEXT: %0 = dim %arg0, 1 : memref<4x?xf32>
+  // CHECK-NEXT: return %c4, %0 : index, index
+  return %1, %2 : index, index
+}
+
 // CHECK-LABEL: func @alloc_const_fold
 func @alloc_const_fold() -> memref<?xf32> {
   // CHECK-NEXT: %0 = alloc() : memref<4xf32>
@@ -220,3 +220,34 @@ func @up_propagate_region() -> i32 {
   }
   return %0 : i32
 }
+
+/// Check that the bodies of sibling loops are simplified against the
+/// operations dominating them, but not against each other.
+// CHECK-LABEL: func @sibling_loops
+func @sibling_loops() {
+  // CHECK-NEXT: %c1_i32 = constant 1 : i32
+  // CHECK-NEXT: %0 = addi %c1_i32, %c1_i32 : i32
+  %0 = constant 1 : i32
+  %1 = addi %0, %0 : i32
+
+  // CHECK-NEXT: affine.for %i0 = 0 to 4 {
+  affine.for %i = 0 to 4 {
+    // CHECK-NEXT: %c2_i32 = constant 2 : i32
+    // CHECK-NEXT: "foo"(%0, %c2_i32, %c2_i32) : (i32, i32, i32) -> ()
+    %2 = constant 1 : i32
+    %3 = addi %2, %2 : i32
+    %4 = constant 2 : i32
+    %5 = constant 2 : i32
+    "foo"(%3, %4, %5) : (i32, i32, i32) -> ()
+  }
+  // CHECK: affine.for %i1 = 0 to 4 {
+  affine.for %i = 0 to 4 {
+    // CHECK-NEXT: %c2_i32_0 = constant 2 : i32
+    // CHECK-NEXT: "foo"(%0, %c2_i32_0) : (i32, i32) -> ()
+    %6 = constant 1 : i32
+    %7 = addi %6, %6 : i32
+    %8 = constant 2 : i32
+    "foo"(%7, %8) : (i32, i32) -> ()
+  }
+  return
+}
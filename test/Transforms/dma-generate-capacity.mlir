@@ -0,0 +1,46 @@
+// RUN: mlir-opt %s -dma-generate -dma-fast-mem-capacity=4 | FileCheck %s
+// RUN: mlir-opt %s -dma-generate -dma-fast-mem-capacity=4 -pass-statistics -pass-statistics-display=list -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+
+// The whole of %A doesn't fit in 4 KiB of fast memory, but a row of it does:
+// the DMA is placed under %i. The accesses to %F, which already lives in the
+// fast memory space, don't count towards the footprint.
+// CHECK-LABEL: func @row_fits
+func @row_fits(%A: memref<256x1024xf32>, %F: memref<1024xf32, 2>) {
+  affine.for %i = 0 to 256 {
+    affine.for %j = 0 to 1024 {
+      %v = load %A[%i, %j] : memref<256x1024xf32>
+      %w = load %F[%j] : memref<1024xf32, 2>
+    }
+  }
+  return
+}
+// CHECK:      affine.for %i0 = 0 to 256 {
+// CHECK-NEXT:   [[IDX:%[0-9]+]] = affine.apply #map{{[0-9]+}}(%i0)
+// CHECK-NEXT:   [[BUF:%[0-9]+]] = alloc() : memref<1x1024xf32, 2>
+// CHECK-NEXT:   [[TAG:%[0-9]+]] = alloc() : memref<1xi32>
+// CHECK-NEXT:   dma_start %arg0{{\[}}[[IDX]], %c0], [[BUF]][%c0, %c0], %c1024, [[TAG]][%c0] : memref<256x1024xf32>, memref<1x1024xf32, 2>, memref<1xi32>
+// CHECK-NEXT:   dma_wait [[TAG]][%c0], %c1024 : memref<1xi32>
+// CHECK-NEXT:   affine.for %i1 = 0 to 1024 {
+// CHECK:          load [[BUF]][{{.*}}] : memref<1x1024xf32, 2>
+// CHECK-NEXT:     load %arg1[%i1] : memref<1024xf32, 2>
+// CHECK-NEXT:   }
+
+// The whole of %B fits: the DMA is placed at the outermost depth.
+// CHECK-LABEL: func @all_fits
+func @all_fits(%B: memref<512xf32>) {
+  affine.for %i = 0 to 512 {
+    %v = load %B[%i] : memref<512xf32>
+  }
+  return
+}
+// CHECK:      [[BUF:%[0-9]+]] = alloc() : memref<512xf32, 2>
+// CHECK-NEXT: [[TAG:%[0-9]+]] = alloc() : memref<1xi32>
+// CHECK-NEXT: dma_start %arg0[%c0], [[BUF]][%c0], %c512, [[TAG]][%c0] : memref<512xf32>, memref<512xf32, 2>, memref<1xi32>
+// CHECK-NEXT: dma_wait [[TAG]][%c0], %c512 : memref<1xi32>
+// CHECK-NEXT: affine.for %i0 = 0 to 512 {
+
+// STATS: DmaGeneration
+// STATS-NEXT: (S) 6 dma-footprint-kib - Total size in KiB of the DMA buffers at the chosen depths
+// STATS-NEXT: (S) 1 num-deeper-placements - Number of loops whose footprint exceeds the fast memory capacity
+// STATS-NEXT: (S) 2 num-dma-buffers - Number of DMA buffers allocated in fast memory
+// STATS-NEXT: (S) 2 num-dmas - Number of DMA operations generated
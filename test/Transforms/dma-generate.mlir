@@ -300,16 +300,19 @@ func @dma_memref_3d(%arg0: memref<1024x1024x1024xf32>) {
         %idx = affine.apply (d0) -> (d0 mod 128)(%i)
         %idy = affine.apply (d0) -> (d0 mod 128)(%j)
         %idz = affine.apply (d0) -> (d0 mod 128)(%k)
-        // DMA with nested striding (or emulating with loop around strided DMA)
-        // not yet implemented.
-        // CHECK: %5 = load %arg0[%2, %3, %4] : memref<1024x1024x1024xf32>
         %v = load %arg0[%idx, %idy, %idz] : memref<1024 x 1024 x 1024 x f32>
-        // expected-error@-10 {{DMA generation failed for one or more memref's in this block}}
       }
     }
   }
   return
 }
+// DMA with nested striding: 128 x 128 planes every 1024 x 1024 elements, each
+// made of 128 element rows every 1024 elements.
+// CHECK:       %0 = alloc() : memref<128x128x128xf32, 2>
+// CHECK-NEXT:  %1 = alloc() : memref<1xi32>
+// CHECK-NEXT:  dma_start %arg0[%c0, %c0, %c0], %0[%c0, %c0, %c0], %c2097152, %1[%c0], %c1048576, %c16384, %c1024, %c128 : memref<1024x1024x1024xf32>, memref<128x128x128xf32, 2>, memref<1xi32>
+// CHECK-NEXT:  dma_wait %1[%c0], %c2097152 : memref<1xi32>
+// CHECK:       load %0[{{.*}}] : memref<128x128x128xf32, 2>
 
 // -----
 
@@ -414,7 +417,7 @@ func @dma_loop_straightline_interspersed() {
 // CHECK-NEXT:  dealloc %1 : memref<1xf32, 2>
 // CHECK-NEXT:  %4 = alloc() : memref<254xf32, 2>
 // CHECK-NEXT:  %5 = alloc() : memref<1xi32>
-// CHECK-NEXT:  dma_start %0[%c1_0], %4[%c0], %c254, %5[%c0] : memref<256xf32>, memref<254xf32, 2>, memref<1xi32>
+// CHECK-NEXT:  dma_start %0[%c1], %4[%c0], %c254, %5[%c0] : memref<256xf32>, memref<254xf32, 2>, memref<1xi32>
 // CHECK-NEXT:  dma_wait %5[%c0], %c254 : memref<1xi32>
 // CHECK-NEXT:  affine.for %i0 = 1 to 255 {
 // CHECK-NEXT:    %6 = affine.apply [[MAP_MINUS_ONE]](%i0)
@@ -424,13 +427,15 @@ func @dma_loop_straightline_interspersed() {
 // CHECK-NEXT:  dealloc %4 : memref<254xf32, 2>
 // CHECK-NEXT:  %8 = alloc() : memref<256xf32, 2>
 // CHECK-NEXT:  %9 = alloc() : memref<1xi32>
-// CHECK-NEXT:  dma_start %0[%c0], %8[%c0], %c256, %9[%c0] : memref<256xf32>, memref<256xf32, 2>, memref<1xi32>
-// CHECK-NEXT:  dma_wait %9[%c0], %c256 : memref<1xi32>
+// CHECK-NEXT:  dma_start %0[%c0], %8[%c0], %c256_0, %9[%c0] : memref<256xf32>, memref<256xf32, 2>, memref<1xi32>
+// CHECK-NEXT:  dma_wait %9[%c0], %c256_0 : memref<1xi32>
 // CHECK-NEXT:  %10 = alloc() : memref<1xi32>
 // CHECK-NEXT:  %11 = load %8[%c255] : memref<256xf32, 2>
 // CHECK-NEXT:  store %11, %8[%c0_2] : memref<256xf32, 2>
-// CHECK-NEXT:  dma_start %8[%c0], %0[%c0], %c1, %10[%c0] : memref<256xf32, 2>, memref<256xf32>, memref<1xi32>
-// CHECK-NEXT:  dma_wait %10[%c0], %c1 : memref<1xi32>
+// The buffer is written back as a whole, its elements being relative to the
+// union of the regions read and written.
+// CHECK-NEXT:  dma_start %8[%c0], %0[%c0], %c256, %10[%c0] : memref<256xf32, 2>, memref<256xf32>, memref<1xi32>
+// CHECK-NEXT:  dma_wait %10[%c0], %c256 : memref<1xi32>
 // CHECK-NEXT:  dealloc %10 : memref<1xi32>
 // CHECK-NEXT:  dealloc %9 : memref<1xi32>
 // CHECK-NEXT:  dealloc %8 : memref<256xf32, 2>
@@ -438,6 +443,55 @@ func @dma_loop_straightline_interspersed() {
 
 // -----
 
+// The regions read and written differ; both DMAs use the bounding box of their
+// union, i.e., [0, 320).
+// CHECK-LABEL: func @load_store_distinct_regions() {
+func @load_store_distinct_regions() {
+  %A = alloc() : memref<512 x f32>
+  affine.for %i = 0 to 256 {
+    %idx = affine.apply (d0) -> (d0 + 64)(%i)
+    %v = load %A[%i] : memref<512 x f32>
+    store %v, %A[%idx] : memref<512 x f32>
+  }
+  return
+}
+// CHECK:       %0 = alloc() : memref<512xf32>
+// CHECK-NEXT:  %1 = alloc() : memref<320xf32, 2>
+// CHECK-NEXT:  %2 = alloc() : memref<1xi32>
+// CHECK-NEXT:  dma_start %0[%c0], %1[%c0], %c320_0, %2[%c0] : memref<512xf32>, memref<320xf32, 2>, memref<1xi32>
+// CHECK-NEXT:  dma_wait %2[%c0], %c320_0 : memref<1xi32>
+// CHECK-NEXT:  %3 = alloc() : memref<1xi32>
+// CHECK-NEXT:  affine.for %i0 = 0 to 256 {
+// CHECK:         store {{.*}}, %1[{{.*}}] : memref<320xf32, 2>
+// CHECK-NEXT:  }
+// CHECK-NEXT:  dma_start %1[%c0], %0[%c0], %c320, %3[%c0] : memref<320xf32, 2>, memref<512xf32>, memref<1xi32>
+// CHECK-NEXT:  dma_wait %3[%c0], %c320 : memref<1xi32>
+
+// -----
+
+// A strided store leaves holes in the region written, which is thus copied in
+// before being written back. A unit stride store writes all of it.
+// CHECK-LABEL: func @strided_store() {
+func @strided_store() {
+  %A = alloc() : memref<256 x f32>
+  %B = alloc() : memref<256 x f32>
+  %cf0 = constant 0.0 : f32
+  affine.for %i = 0 to 128 {
+    %idx = affine.apply (d0) -> (2 * d0)(%i)
+    store %cf0, %A[%idx] : memref<256 x f32>
+    store %cf0, %B[%i] : memref<256 x f32>
+  }
+  return
+}
+// CHECK:       dma_start %0[%c0], [[BUFA:%[0-9]+]][%c0], {{.*}} : memref<256xf32>, memref<255xf32, 2>, memref<1xi32>
+// CHECK-NEXT:  dma_wait
+// CHECK-NOT:   dma_start %1
+// CHECK:       affine.for %i0 = 0 to 128 {
+// CHECK:       dma_start {{.*}}, %1[%c0], {{.*}} : memref<128xf32, 2>, memref<256xf32>, memref<1xi32>
+// CHECK:       dma_start [[BUFA]][%c0], %0[%c0], {{.*}} : memref<255xf32, 2>, memref<256xf32>, memref<1xi32>
+
+// -----
+
 // CHECK-LABEL: func @dma_mixed_loop_blocks() {
 func @dma_mixed_loop_blocks() {
   %c0 = constant 0 : index
@@ -474,7 +528,12 @@ func @relative_loop_bounds(%arg0: memref<1027xf32>) {
   }
   return
 }
+// The inner loop bounds depend on the outer IV; the written region is thus not
+// known to be entirely written and is copied in before being written back.
 // CHECK:      [[BUF:%[0-9]+]] = alloc() : memref<1027xf32, 2>
+// CHECK-NEXT: [[TAG:%[0-9]+]] = alloc() : memref<1xi32>
+// CHECK-NEXT: dma_start %arg0[%c0], [[BUF]][%c0], %c1027_0, [[TAG]][%c0] : memref<1027xf32>, memref<1027xf32, 2>, memref<1xi32>
+// CHECK-NEXT: dma_wait [[TAG]][%c0], %c1027_0 : memref<1xi32>
 // CHECK-NEXT: [[MEM:%[0-9]+]] = alloc() : memref<1xi32>
 // CHECK-NEXT: affine.for %i0 = 0 to 1024 {
 // CHECK-NEXT:    affine.for %i1 = {{#map[0-9]+}}(%i0) to {{#map[0-9]+}}(%i0) {
@@ -598,3 +657,36 @@ func @simple_matmul(%arg0: memref<8x8xvector<64xf32>>, %arg1: memref<8x8xvector<
 // FAST-MEM-16KB:     }
 // FAST-MEM-16KB:     dma_start %2[%c0, %c0], %arg2
 // FAST-MEM-16KB:     dma_wait
+
+// -----
+
+// The region of a view of a tile of a row-major memref is copied with the
+// strides of its layout.
+// CHECK-LABEL: func @dma_strided_layout
+func @dma_strided_layout(%A : memref<64x64xf32, (d0, d1) -> (d0 * 1024 + d1 + 2048)>) {
+  affine.for %i = 0 to 64 {
+    affine.for %j = 0 to 64 {
+      %v = load %A[%i, %j] : memref<64x64xf32, (d0, d1) -> (d0 * 1024 + d1 + 2048)>
+    }
+  }
+  return
+}
+// CHECK:      %0 = alloc() : memref<64x64xf32, 2>
+// CHECK-NEXT: %1 = alloc() : memref<1xi32>
+// CHECK-NEXT: dma_start %arg0[%c0, %c0], %0[%c0, %c0], %c4096, %1[%c0], %c1024, %c64 : memref<64x64xf32, #map{{[0-9]+}}>, memref<64x64xf32, 2>, memref<1xi32>
+// CHECK-NEXT: dma_wait %1[%c0], %c4096 : memref<1xi32>
+
+// -----
+
+// The layouts whose dimensions are not nested in the next major ones are not
+// supported.
+// CHECK-LABEL: func @dma_column_major_layout
+func @dma_column_major_layout(%A : memref<64x64xf32, (d0, d1) -> (d1 * 64 + d0)>) {
+  affine.for %i = 0 to 64 {
+    affine.for %j = 0 to 64 {
+      %v = load %A[%i, %j] : memref<64x64xf32, (d0, d1) -> (d1 * 64 + d0)>
+    }
+  }
+  return
+}
+// CHECK-NOT: dma_start
@@ -0,0 +1,58 @@
+// RUN: mlir-opt -form-fma %s | FileCheck %s
+// RUN: mlir-opt -form-fma -fma-contract=fast %s | FileCheck %s --check-prefix=FAST
+// RUN: mlir-opt -form-fma -fma-contract=off %s | FileCheck %s --check-prefix=OFF
+
+// By default, only the operations allowing it are contracted.
+// CHECK-LABEL: func @contract(%arg0: f32, %arg1: f32, %arg2: f32) -> (f32, f32) {
+// CHECK-NEXT:   %0 = fmaf %arg0, %arg1, %arg2 {fastmath: ["contract"]} : f32
+// CHECK-NEXT:   %1 = mulf %arg0, %arg1 : f32
+// CHECK-NEXT:   %2 = addf %arg2, %1 {fastmath: ["contract"]} : f32
+// CHECK-NEXT:   return %0, %2 : f32, f32
+// FAST-LABEL: func @contract(%arg0: f32, %arg1: f32, %arg2: f32) -> (f32, f32) {
+// FAST-NEXT:   %0 = fmaf %arg0, %arg1, %arg2 {fastmath: ["contract"]} : f32
+// FAST-NEXT:   %1 = fmaf %arg0, %arg1, %arg2 {fastmath: ["contract"]} : f32
+// FAST-NEXT:   return %0, %1 : f32, f32
+// OFF-LABEL: func @contract(%arg0: f32, %arg1: f32, %arg2: f32) -> (f32, f32) {
+// OFF-NEXT:   %0 = mulf %arg0, %arg1 {fastmath: ["fast"]} : f32
+// OFF-NEXT:   %1 = addf %0, %arg2 {fastmath: ["contract"]} : f32
+func @contract(%a : f32, %b : f32, %c : f32) -> (f32, f32) {
+  %0 = mulf %a, %b {fastmath: ["fast"]} : f32
+  %1 = addf %0, %c {fastmath: ["contract"]} : f32
+  %2 = mulf %a, %b : f32
+  %3 = addf %c, %2 {fastmath: ["contract"]} : f32
+  return %1, %3 : f32, f32
+}
+
+// The multiplications with other users are not contracted.
+// FAST-LABEL: func @multiple_uses(%arg0: vector<4xf32>, %arg1: vector<4xf32>) -> vector<4xf32> {
+// FAST-NEXT:   %0 = mulf %arg0, %arg1 : vector<4xf32>
+// FAST-NEXT:   %1 = addf %0, %arg0 : vector<4xf32>
+// FAST-NEXT:   %2 = addf %0, %1 : vector<4xf32>
+func @multiple_uses(%a : vector<4xf32>, %b : vector<4xf32>) -> vector<4xf32> {
+  %0 = mulf %a, %b : vector<4xf32>
+  %1 = addf %0, %a : vector<4xf32>
+  %2 = addf %0, %1 : vector<4xf32>
+  return %2 : vector<4xf32>
+}
+
+// The "fp_contract" attribute of a function overrides the policy of the pass.
+// CHECK-LABEL: func @function_policy(%arg0: f32, %arg1: f32, %arg2: f32) -> f32
+// CHECK-NEXT:   %0 = fmaf %arg0, %arg1, %arg2 : f32
+// OFF-LABEL: func @function_policy(%arg0: f32, %arg1: f32, %arg2: f32) -> f32
+// OFF-NEXT:   %0 = fmaf %arg0, %arg1, %arg2 : f32
+func @function_policy(%a : f32, %b : f32, %c : f32) -> f32
+    attributes {fp_contract: "fast"} {
+  %0 = mulf %a, %b : f32
+  %1 = addf %0, %c : f32
+  return %1 : f32
+}
+
+// FAST-LABEL: func @function_off(%arg0: f32, %arg1: f32, %arg2: f32) -> f32
+// FAST-NEXT:   %0 = mulf %arg0, %arg1 : f32
+// FAST-NEXT:   %1 = addf %0, %arg2 : f32
+func @function_off(%a : f32, %b : f32, %c : f32) -> f32
+    attributes {fp_contract: "off"} {
+  %0 = mulf %a, %b : f32
+  %1 = addf %0, %c : f32
+  return %1 : f32
+}
@@ -0,0 +1,74 @@
+// RUN: mlir-opt %s -gvn | FileCheck %s
+
+// CHECK-DAG: [[MAP:#map[0-9]+]] = (d0) -> (d0 + 1)
+
+// CHECK-LABEL: func @commutative
+func @commutative(%a : i32, %b : i32) -> (i32, i32) {
+  // CHECK-NEXT: %0 = addi %arg0, %arg1 : i32
+  // CHECK-NEXT: return %0, %0 : i32, i32
+  %0 = addi %a, %b : i32
+  %1 = addi %b, %a : i32
+  return %0, %1 : i32, i32
+}
+
+// Operations that are not commutative still need their operands in order.
+// CHECK-LABEL: func @non_commutative
+func @non_commutative(%a : i32, %b : i32) -> (i32, i32) {
+  // CHECK-NEXT: %0 = subi %arg0, %arg1 : i32
+  // CHECK-NEXT: %1 = subi %arg1, %arg0 : i32
+  // CHECK-NEXT: return %0, %1 : i32, i32
+  %0 = subi %a, %b : i32
+  %1 = subi %b, %a : i32
+  return %0, %1 : i32, i32
+}
+
+// CHECK-LABEL: func @composed_affine_apply
+func @composed_affine_apply(%A : memref<16xf32>) {
+  // CHECK:      affine.for %i0 = 0 to 15 {
+  // CHECK-NEXT:   %0 = affine.apply [[MAP]](%i0)
+  // CHECK-NEXT:   "foo"(%0, %0) : (index, index) -> ()
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 15 {
+    %0 = affine.apply (d0) -> (d0 + 1)(%i)
+    %1 = affine.apply (d0) -> (d0)(%i)
+    %2 = affine.apply (d0) -> (d0 + 1)(%1)
+    "foo"(%0, %2) : (index, index) -> ()
+  }
+  return
+}
+
+// CHECK-LABEL: func @redundant_load
+func @redundant_load() {
+  %m = alloc() : memref<16xf32>
+  // CHECK:      affine.for %i0 = 0 to 15 {
+  // CHECK-NEXT:   %1 = affine.apply [[MAP]](%i0)
+  // CHECK-NEXT:   %2 = load %0[%1] : memref<16xf32>
+  // CHECK-NEXT:   "foo"(%2, %2) : (f32, f32) -> ()
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 15 {
+    %0 = affine.apply (d0) -> (d0 + 1)(%i)
+    %1 = load %m[%0] : memref<16xf32>
+    %2 = affine.apply (d0) -> (1 + d0)(%i)
+    %3 = load %m[%2] : memref<16xf32>
+    "foo"(%1, %3) : (f32, f32) -> ()
+  }
+  return
+}
+
+// A load isn't replaced if a store in between may write to the element read.
+// CHECK-LABEL: func @load_intervening_store
+func @load_intervening_store(%v : f32) {
+  %c0 = constant 0 : index
+  %m = alloc() : memref<16xf32>
+  // CHECK:      affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   %1 = load %0[%c0] : memref<16xf32>
+  // CHECK-NEXT:   store %arg0, %0[%i0] : memref<16xf32>
+  // CHECK-NEXT:   %2 = load %0[%c0] : memref<16xf32>
+  affine.for %i = 0 to 16 {
+    %0 = load %m[%c0] : memref<16xf32>
+    store %v, %m[%i] : memref<16xf32>
+    %1 = load %m[%c0] : memref<16xf32>
+    "foo"(%0, %1) : (f32, f32) -> ()
+  }
+  return
+}
@@ -0,0 +1,130 @@
+// RUN: mlir-opt -inline %s | FileCheck %s
+// RUN: mlir-opt -inline -inline-threshold=1 %s | FileCheck %s --check-prefix=THRESHOLD
+
+// CHECK-LABEL: func @add(%arg0: i32, %arg1: i32) -> i32 {
+func @add(%a : i32, %b : i32) -> i32 {
+  %0 = addi %a, %b : i32
+  return %0 : i32
+}
+
+// The callee is cloned with its arguments replaced by the call operands.
+// CHECK-LABEL: func @call_add(%arg0: i32) -> i32 {
+// CHECK-NEXT:   %0 = addi %arg0, %arg0 : i32
+// CHECK-NEXT:   return %0 : i32
+// THRESHOLD-LABEL: func @call_add(%arg0: i32) -> i32 {
+// THRESHOLD-NEXT:   %0 = call @add(%arg0, %arg0) : (i32, i32) -> i32
+func @call_add(%x : i32) -> i32 {
+  %0 = call @add(%x, %x) : (i32, i32) -> i32
+  return %0 : i32
+}
+
+// The callees are inlined first, so that the size of @add_twice is the one
+// after inlining.
+// CHECK-LABEL: func @call_add_twice(%arg0: i32) -> i32 {
+// CHECK-NEXT:   %0 = addi %arg0, %arg0 : i32
+// CHECK-NEXT:   %1 = addi %0, %0 : i32
+// CHECK-NEXT:   return %1 : i32
+func @call_add_twice(%x : i32) -> i32 {
+  %0 = call @add_twice(%x) : (i32) -> i32
+  return %0 : i32
+}
+
+// CHECK-LABEL: func @add_twice(%arg0: i32) -> i32 {
+// CHECK-NEXT:   %0 = addi %arg0, %arg0 : i32
+// CHECK-NEXT:   %1 = addi %0, %0 : i32
+// CHECK-NEXT:   return %1 : i32
+func @add_twice(%x : i32) -> i32 {
+  %0 = call @add(%x, %x) : (i32, i32) -> i32
+  %1 = call @add(%0, %0) : (i32, i32) -> i32
+  return %1 : i32
+}
+
+// CHECK-LABEL: func @select(%arg0: i1, %arg1: i32, %arg2: i32) -> i32 {
+func @select(%c : i1, %a : i32, %b : i32) -> i32 {
+  cond_br %c, ^bb1, ^bb2
+^bb1:
+  return %a : i32
+^bb2:
+  return %b : i32
+}
+
+// The returns of a callee with several blocks branch to the continuation of
+// the call, whose argument replaces the result of the call.
+// CHECK-LABEL: func @call_select(%arg0: i1, %arg1: i32, %arg2: i32) -> i32 {
+// CHECK-NEXT:   cond_br %arg0, ^bb1, ^bb2
+// CHECK-NEXT: ^bb1:
+// CHECK-NEXT:   br ^bb3(%arg1 : i32)
+// CHECK-NEXT: ^bb2:
+// CHECK-NEXT:   br ^bb3(%arg2 : i32)
+// CHECK-NEXT: ^bb3(%0: i32):
+// CHECK-NEXT:   %1 = addi %0, %0 : i32
+// CHECK-NEXT:   return %1 : i32
+func @call_select(%c : i1, %a : i32, %b : i32) -> i32 {
+  %0 = call @select(%c, %a, %b) : (i1, i32, i32) -> i32
+  %1 = addi %0, %0 : i32
+  return %1 : i32
+}
+
+func @next(%i : index) -> index {
+  %0 = affine.apply (d0) -> (d0 + 1)(%i)
+  return %0 : index
+}
+
+// Only the callees with a single block and no affine operations are inlined in
+// the regions of operations.
+// CHECK-LABEL: func @call_in_loop(%arg0: index, %arg1: memref<8xindex>) {
+// CHECK-NEXT:   %0 = affine.apply #{{.*}}(%arg0)
+// CHECK-NEXT:   affine.for %i0 = 0 to 8 {
+// CHECK-NEXT:     %1 = call @next(%i0) : (index) -> index
+// CHECK-NEXT:     %2 = call @select_index(%i0, %0) : (index, index) -> index
+// CHECK-NEXT:     %3 = addi %2, %1 : index
+// CHECK-NEXT:     store %3, %arg1[%i0] : memref<8xindex>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+func @call_in_loop(%n : index, %A : memref<8xindex>) {
+  %0 = call @next(%n) : (index) -> index
+  affine.for %i = 0 to 8 {
+    %1 = call @next(%i) : (index) -> index
+    %2 = call @select_index(%i, %0) : (index, index) -> index
+    %3 = call @add_index(%2, %1) : (index, index) -> index
+    store %3, %A[%i] : memref<8xindex>
+  }
+  return
+}
+
+func @add_index(%a : index, %b : index) -> index {
+  %0 = addi %a, %b : index
+  return %0 : index
+}
+
+func @select_index(%a : index, %b : index) -> index {
+  %0 = cmpi "slt", %a, %b : index
+  cond_br %0, ^bb1, ^bb2
+^bb1:
+  return %a : index
+^bb2:
+  return %b : index
+}
+
+// The calls closing a cycle of the call graph are not inlined, and neither are
+// the calls to external functions.
+// CHECK-LABEL: func @even(%arg0: i32) -> i32 {
+// CHECK-NEXT:   %0 = call @external(%arg0) : (i32) -> i32
+// CHECK-NEXT:   %1 = call @even(%0) : (i32) -> i32
+// CHECK-NEXT:   return %1 : i32
+func @even(%n : i32) -> i32 {
+  %0 = call @odd(%n) : (i32) -> i32
+  return %0 : i32
+}
+
+// CHECK-LABEL: func @odd(%arg0: i32) -> i32 {
+// CHECK-NEXT:   %0 = call @external(%arg0) : (i32) -> i32
+// CHECK-NEXT:   %1 = call @even(%0) : (i32) -> i32
+// CHECK-NEXT:   return %1 : i32
+func @odd(%n : i32) -> i32 {
+  %0 = call @external(%n) : (i32) -> i32
+  %1 = call @even(%0) : (i32) -> i32
+  return %1 : i32
+}
+
+func @external(i32) -> i32
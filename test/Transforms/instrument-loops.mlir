@@ -0,0 +1,67 @@
+// RUN: mlir-opt -instrument-loops %s | FileCheck %s
+
+// The function is timed from its entry to its return, and each loop around its
+// execution. The bounds of a loop are computed before it is timed.
+// CHECK-LABEL: func @loops(%arg0: memref<?xf32>, %arg1: index) {
+// CHECK-NEXT:   %[[FUNC_START:.*]] = call @mlir_profile_timestamp() : () -> i64
+// CHECK-NEXT:   %[[LB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   %[[UB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   %[[STEP:.*]] = constant 2 : index
+// CHECK-NEXT:   %[[START:.*]] = call @mlir_profile_timestamp() : () -> i64
+// CHECK-NEXT:   affine.for %i0 = 0 to 10 step 2 {
+// The minimum of the results of a multi-result upper bound is recorded.
+// CHECK-NEXT:     %[[INNER_LB:.*]] = affine.apply #{{.*}}(%i0)
+// CHECK-NEXT:     %[[UB0:.*]] = affine.apply #{{.*}}(%i0)[%arg1]
+// CHECK-NEXT:     %[[UB1:.*]] = affine.apply #{{.*}}(%i0)[%arg1]
+// CHECK-NEXT:     %[[CMP:.*]] = cmpi "slt", %[[UB0]], %[[UB1]] : index
+// CHECK-NEXT:     %[[INNER_UB:.*]] = select %[[CMP]], %[[UB0]], %[[UB1]] : index
+// CHECK-NEXT:     %[[INNER_STEP:.*]] = constant 1 : index
+// CHECK-NEXT:     %[[INNER_START:.*]] = call @mlir_profile_timestamp() : () -> i64
+// CHECK-NEXT:     affine.for %i1 = {{.*}} {
+// CHECK-NEXT:       load
+// CHECK-NEXT:     }
+// CHECK-NEXT:     %[[INNER_ID:.*]] = constant {{-?[0-9]+}} : i64
+// CHECK-NEXT:     call @mlir_profile_record_loop(%[[INNER_ID]], %[[INNER_START]], %[[INNER_LB]], %[[INNER_UB]], %[[INNER_STEP]]) {profile.region: "affine.for @loops {{.*}}instrument-loops.mlir:{{[0-9]+}}:5"} : (i64, i64, index, index, index) -> ()
+// CHECK-NEXT:   }
+// CHECK-NEXT:   %[[ID:.*]] = constant {{-?[0-9]+}} : i64
+// CHECK-NEXT:   call @mlir_profile_record_loop(%[[ID]], %[[START]], %[[LB]], %[[UB]], %[[STEP]]) {profile.region: "affine.for @loops {{.*}}instrument-loops.mlir:{{[0-9]+}}:3"} : (i64, i64, index, index, index) -> ()
+// CHECK-NEXT:   %[[FUNC_ID:.*]] = constant {{-?[0-9]+}} : i64
+// CHECK-NEXT:   call @mlir_profile_record_function(%[[FUNC_ID]], %[[FUNC_START]]) {profile.region: "func @loops {{.*}}instrument-loops.mlir:{{[0-9]+}}:6"} : (i64, i64) -> ()
+// CHECK-NEXT:   return
+func @loops(%A : memref<?xf32>, %N : index) {
+  affine.for %i = 0 to 10 step 2 {
+    affine.for %j = (d0) -> (d0)(%i) to min (d0)[s0] -> (s0, d0 + 4)(%i)[%N] {
+      %0 = load %A[%j] : memref<?xf32>
+    }
+  }
+  return
+}
+
+// Each return of a function records the call.
+// CHECK-LABEL: func @returns(%arg0: i1) {
+// CHECK-NEXT:   %[[START:.*]] = call @mlir_profile_timestamp() : () -> i64
+// CHECK-NEXT:   cond_br %arg0, ^bb1, ^bb2
+// CHECK-NEXT: ^bb1:
+// CHECK-NEXT:   %[[ID:.*]] = constant [[RETURNS_ID:-?[0-9]+]] : i64
+// CHECK-NEXT:   call @mlir_profile_record_function(%[[ID]], %[[START]]) {profile.region: "func @returns {{.*}}"}
+// CHECK-NEXT:   return
+// CHECK-NEXT: ^bb2:
+// CHECK-NEXT:   %[[ID2:.*]] = constant [[RETURNS_ID]] : i64
+// CHECK-NEXT:   call @mlir_profile_record_function(%[[ID2]], %[[START]]) {profile.region: "func @returns {{.*}}"}
+// CHECK-NEXT:   return
+func @returns(%cond : i1) {
+  cond_br %cond, ^bb1, ^bb2
+^bb1:
+  return
+^bb2:
+  return
+}
+
+// The declarations are not instrumented.
+// CHECK-LABEL: func @external()
+// CHECK-NOT: call
+func @external()
+
+// CHECK: func @mlir_profile_timestamp() -> i64
+// CHECK-NEXT: func @mlir_profile_record_loop(i64, i64, index, index, index)
+// CHECK-NEXT: func @mlir_profile_record_function(i64, i64)
@@ -0,0 +1,45 @@
+// RUN: mlir-opt %s -test-integer-ranges -split-input-file -verify
+
+func @constant_bounds() {
+  affine.for %i = 0 to 10 {
+  // expected-note@-1 {{range [0, 9]}}
+    %0 = affine.apply (d0) -> (d0 * 4 + 3)(%i)
+    // expected-note@-1 {{range [3, 39]}}
+    %1 = affine.apply (d0) -> (d0 floordiv 4)(%i)
+    // expected-note@-1 {{range [0, 2]}}
+    %2 = affine.apply (d0) -> (d0 mod 4)(%i)
+    // expected-note@-1 {{range [0, 3]}}
+    %3 = affine.apply (d0) -> (-d0 + 9)(%i)
+    // expected-note@-1 {{range [0, 9]}}
+    %4 = muli %i, %i : index
+    // expected-note@-1 {{range [0, 81]}}
+  }
+  return
+}
+
+// -----
+
+// The values derived from a symbolic loop bound are bounded in terms of it.
+func @symbolic_bounds(%N : index, %A : memref<4x?xf32>) {
+  affine.for %i = 0 to %N {
+  // expected-note@-1 {{range [0, ?] symbolic [?, arg0 - 1]}}
+    %0 = affine.apply (d0) -> (d0 + 2)(%i)
+    // expected-note@-1 {{range [2, ?] symbolic [?, arg0 + 1]}}
+    affine.for %j = 0 to (d0) -> (d0)(%i) {
+    // expected-note@-1 {{range [0, ?] symbolic [?, arg0 - 2]}}
+    }
+  }
+  %c3 = constant 3 : index
+  %1 = addi %N, %c3 : index
+  // expected-note@-1 {{range [?, ?] symbolic [arg0 + 3, arg0 + 3]}}
+  %2 = subi %N, %c3 : index
+  // expected-note@-1 {{range [?, ?] symbolic [arg0 - 3, arg0 - 3]}}
+  %3 = dim %A, 0 : memref<4x?xf32>
+  // expected-note@-1 {{range [4, 4]}}
+  %4 = dim %A, 1 : memref<4x?xf32>
+  // expected-note@-1 {{range [0, ?]}}
+  affine.for %k = 0 to %4 {
+  // expected-note@-1 {{range [0, ?] symbolic [?, std.dim - 1]}}
+  }
+  return
+}
@@ -0,0 +1,42 @@
+// RUN: mlir-opt %s -loop-fusion | FileCheck %s --check-prefix=UNLIMITED
+// RUN: mlir-opt %s -loop-fusion -pass-budget-work-units=2 | FileCheck %s --check-prefix=BUDGET
+// RUN: mlir-opt %s -loop-fusion -pass-budget-work-units=2 -pass-budget-report -o /dev/null 2>&1 | FileCheck %s --check-prefix=REPORT
+
+// Both producer-consumer pairs are fused without a budget. With a budget of two
+// candidate fusions, the first pair visited is fused and the search stops
+// before the second one, which is left as is.
+
+// UNLIMITED-LABEL: func @two_producer_consumer_pairs
+// UNLIMITED: affine.for
+// UNLIMITED: affine.for
+// UNLIMITED-NOT: affine.for
+// UNLIMITED: return
+
+// BUDGET-LABEL: func @two_producer_consumer_pairs
+// BUDGET: affine.for
+// BUDGET: affine.for
+// BUDGET: affine.for
+// BUDGET-NOT: affine.for
+// BUDGET: return
+func @two_producer_consumer_pairs() {
+  %a = alloc() : memref<10xf32>
+  %b = alloc() : memref<10xf32>
+  %cf7 = constant 7.0 : f32
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %a[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %v0 = load %a[%i1] : memref<10xf32>
+  }
+  affine.for %i2 = 0 to 10 {
+    store %cf7, %b[%i2] : memref<10xf32>
+  }
+  affine.for %i3 = 0 to 10 {
+    %v1 = load %b[%i3] : memref<10xf32>
+  }
+  return
+}
+
+// REPORT: ... Pass budget report ...
+// REPORT: LoopFusion: 1 run exhausted a budget of 2 work units
+// REPORT-NEXT: @two_producer_consumer_pairs
@@ -0,0 +1,46 @@
+// RUN: mlir-opt %s -loop-fusion | FileCheck %s --check-prefix=DEFAULT
+// RUN: mlir-opt %s -loop-fusion -target-l2-cache-size=1 -target-cache-line-size=16 | FileCheck %s --check-prefix=SMALL
+
+// The producer is fused in the innermost loop of the consumer, which recomputes
+// each element of %m once per iteration of %i1, at a cost within the compute
+// tolerance. With the default model, all of the accessed data fits in the
+// cache and the nests are fused.
+
+// DEFAULT-LABEL: func @recompute_slice_per_row
+// DEFAULT:       affine.for %{{.*}} = 0 to 64 {
+// DEFAULT-NEXT:    affine.for %{{.*}} = 0 to 64 {
+// DEFAULT-NOT:   affine.for
+// DEFAULT:       return
+
+// With a 1 KiB cache, the rows of %in and %out are reused from the cache by
+// the unfused consumer, while the recomputed slice reads the whole of %a again
+// for each row of the fused nest. Fusing would increase the memory traffic,
+// so the nests are left unfused.
+
+// SMALL-LABEL: func @recompute_slice_per_row
+// SMALL:       affine.for %[[J:.*]] = 0 to 64 {
+// SMALL-NEXT:    %{{.*}} = load %arg0[%[[J]]] : memref<64xf32>
+// SMALL-NEXT:    store %{{.*}}, %{{.*}}[%[[J]]] : memref<64xf32>
+// SMALL-NEXT:  }
+// SMALL-NEXT:  affine.for %{{.*}} = 0 to 64 {
+// SMALL-NEXT:    affine.for %{{.*}} = 0 to 64 {
+// SMALL:       return
+func @recompute_slice_per_row(%a: memref<64xf32>, %in: memref<64x64xf32>,
+                              %out: memref<64x64xf32>) {
+  %m = alloc() : memref<64xf32>
+  affine.for %j = 0 to 64 {
+    %v = load %a[%j] : memref<64xf32>
+    store %v, %m[%j] : memref<64xf32>
+  }
+  affine.for %i = 0 to 64 {
+    affine.for %k = 0 to 64 {
+      %x = load %m[%k] : memref<64xf32>
+      %y = load %in[%i, %k] : memref<64x64xf32>
+      %s = addf %x, %y : f32
+      %p = mulf %s, %s : f32
+      %q = addf %p, %x : f32
+      store %q, %out[%i, %k] : memref<64x64xf32>
+    }
+  }
+  return
+}
@@ -359,19 +359,15 @@ func @should_fuse_producer_consumer() {
     %v1 = load %m[%i2] : memref<10xf32>
   }
   // Fusing loop %i0 to %i2 would violate the WAW dependence between %i0 and
-  // %i1, but OK to fuse %i1 into %i2.
-  // TODO(andydavis) When the fusion pass is run to a fixed-point, it should
-  // fuse all three of these loop nests.
+  // %i1, but OK to fuse %i1 into %i2. The original memref is then only
+  // written to by %i0, and is erased along with that loop nest.
   // CHECK:      %0 = alloc() : memref<1xf32>
-  // CHECK:      %1 = alloc() : memref<10xf32>
+  // CHECK-NOT:  alloc()
   // CHECK:      affine.for %i0 = 0 to 10 {
-  // CHECK-NEXT:   store %cst, %1[%i0] : memref<10xf32>
-  // CHECK-NEXT: }
-  // CHECK-NEXT: affine.for %i1 = 0 to 10 {
-  // CHECK-NEXT:   %2 = affine.apply [[MAP0]](%i1, %i1)
-  // CHECK-NEXT:   store %cst, %0[%2] : memref<1xf32>
-  // CHECK-NEXT:   %3 = affine.apply [[MAP0]](%i1, %i1)
-  // CHECK-NEXT:   %4 = load %0[%3] : memref<1xf32>
+  // CHECK-NEXT:   %1 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   store %cst, %0[%1] : memref<1xf32>
+  // CHECK-NEXT:   %2 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   %3 = load %0[%2] : memref<1xf32>
   // CHECK-NEXT: }
   // CHECK-NEXT: return
   return
@@ -2489,3 +2485,119 @@ func @affine_2_dependent_mm_fused(%arg0: memref<1024x1024xf32>, %arg1: memref<10
   // CHECK-NEXT:   }
   return
 }
+
+// -----
+
+// CHECK-LABEL: func @should_fuse_sibling_with_multiple_loads
+func @should_fuse_sibling_with_multiple_loads(%arg0: memref<10xf32>, %arg1: memref<10xf32>, %arg2: memref<10xf32>) {
+  affine.for %i0 = 0 to 10 {
+    %v0 = load %arg0[%i0] : memref<10xf32>
+    %v1 = load %arg0[%i0] : memref<10xf32>
+    %v2 = addf %v0, %v1 : f32
+    store %v2, %arg1[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %v3 = load %arg0[%i1] : memref<10xf32>
+    store %v3, %arg2[%i1] : memref<10xf32>
+  }
+  // The first loop nest loads '%arg0' twice under the same loops, so it is
+  // fused into the second one with the union of the slices of both loads.
+  // CHECK:      affine.for %i0 = 0 to 10 {
+  // CHECK-NEXT:   %0 = load %arg0[%i0] : memref<10xf32>
+  // CHECK-NEXT:   %1 = load %arg0[%i0] : memref<10xf32>
+  // CHECK-NEXT:   %2 = addf %0, %1 : f32
+  // CHECK-NEXT:   store %2, %arg1[%i0] : memref<10xf32>
+  // CHECK-NEXT:   %3 = load %arg0[%i0] : memref<10xf32>
+  // CHECK-NEXT:   store %3, %arg2[%i0] : memref<10xf32>
+  // CHECK-NEXT: }
+  // CHECK-NEXT: return
+  return
+}
+
+// -----
+
+// CHECK: [[MAP0:#map[0-9]+]] = (d0, d1) -> (-d0 + d1)
+
+// CHECK-LABEL: func @should_fuse_producer_fan_in() {
+func @should_fuse_producer_fan_in() {
+  %a = alloc() : memref<10xf32>
+  %b = alloc() : memref<10xf32>
+  %c = alloc() : memref<10xf32>
+  %cf7 = constant 7.0 : f32
+
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %a[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    store %cf7, %b[%i1] : memref<10xf32>
+  }
+  affine.for %i2 = 0 to 10 {
+    store %cf7, %c[%i2] : memref<10xf32>
+  }
+  affine.for %i3 = 0 to 10 {
+    %v0 = load %a[%i3] : memref<10xf32>
+    %v1 = load %b[%i3] : memref<10xf32>
+    %v2 = load %c[%i3] : memref<10xf32>
+    %v3 = addf %v0, %v1 : f32
+    %v4 = addf %v3, %v2 : f32
+  }
+
+  // Should fuse the three producers into the last loop nest at once, with a
+  // private memref for each of '%a', '%b' and '%c'.
+  // CHECK-DAG: [[NEWA:%[0-9]+]] = alloc() : memref<1xf32>
+  // CHECK-DAG: [[NEWB:%[0-9]+]] = alloc() : memref<1xf32>
+  // CHECK-DAG: [[NEWC:%[0-9]+]] = alloc() : memref<1xf32>
+  // CHECK:      affine.for %i0 = 0 to 10 {
+  // CHECK-NEXT:   %3 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   store %cst, [[NEWA]][%3] : memref<1xf32>
+  // CHECK-NEXT:   %4 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   store %cst, [[NEWB]][%4] : memref<1xf32>
+  // CHECK-NEXT:   %5 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   store %cst, [[NEWC]][%5] : memref<1xf32>
+  // CHECK-NEXT:   %6 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   %7 = load [[NEWA]][%6] : memref<1xf32>
+  // CHECK-NEXT:   %8 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   %9 = load [[NEWB]][%8] : memref<1xf32>
+  // CHECK-NEXT:   %10 = affine.apply [[MAP0]](%i0, %i0)
+  // CHECK-NEXT:   %11 = load [[NEWC]][%10] : memref<1xf32>
+  // CHECK-NEXT:   %12 = addf %7, %9 : f32
+  // CHECK-NEXT:   %13 = addf %12, %11 : f32
+  // CHECK-NEXT: }
+  // CHECK-NEXT: return
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @should_fuse_chain_after_private_memref_creation() {
+func @should_fuse_chain_after_private_memref_creation() {
+  %a = alloc() : memref<10xf32>
+  %b = alloc() : memref<10xf32>
+  %cf7 = constant 7.0 : f32
+
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %a[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %v0 = load %a[%i1] : memref<10xf32>
+    %v1 = addf %v0, %v0 : f32
+    store %v1, %b[%i1] : memref<10xf32>
+  }
+  affine.for %i2 = 0 to 10 {
+    %v2 = load %b[%i2] : memref<10xf32>
+  }
+
+  // The first loop nest is fused into the second one, which replaces its load
+  // of '%a' by a load of a private memref. The second loop nest, with the
+  // accesses updated after this replacement, is then fused into the third one
+  // with a private memref for '%b'.
+  // CHECK:      affine.for %i0 = 0 to 10 {
+  // CHECK:        store %cst, [[NEWA:%[0-9]+]][{{%[0-9]+}}] : memref<1xf32>
+  // CHECK:        [[V0:%[0-9]+]] = load [[NEWA]][{{%[0-9]+}}] : memref<1xf32>
+  // CHECK-NEXT:   [[V1:%[0-9]+]] = addf [[V0]], [[V0]] : f32
+  // CHECK:        store [[V1]], [[NEWB:%[0-9]+]][{{%[0-9]+}}] : memref<1xf32>
+  // CHECK:        load [[NEWB]][{{%[0-9]+}}] : memref<1xf32>
+  // CHECK-NEXT: }
+  // CHECK-NEXT: return
+  return
+}
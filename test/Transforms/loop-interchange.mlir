@@ -0,0 +1,50 @@
+// RUN: mlir-opt %s -affine-loop-interchange | FileCheck %s
+
+// A column-major traversal of a row-major memref is interchanged so that the
+// innermost loop walks along the rows.
+// CHECK-LABEL: func @interchange_for_locality
+func @interchange_for_locality(%A : memref<64x128xf32>) {
+  // CHECK-NEXT: affine.for %i0 = 0 to 64 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 128 {
+  // CHECK-NEXT:     %0 = load %arg0[%i0, %i1] : memref<64x128xf32>
+  // CHECK-NEXT:     %1 = addf %0, %0 : f32
+  // CHECK-NEXT:     store %1, %arg0[%i0, %i1] : memref<64x128xf32>
+  affine.for %i = 0 to 128 {
+    affine.for %j = 0 to 64 {
+      %v = load %A[%j, %i] : memref<64x128xf32>
+      %r = addf %v, %v : f32
+      store %r, %A[%j, %i] : memref<64x128xf32>
+    }
+  }
+  return
+}
+
+// The dependence of distance (1, -1) would become lexicographically negative.
+// CHECK-LABEL: func @no_interchange_dependence
+func @no_interchange_dependence(%A : memref<65x65xf32>) {
+  // CHECK-NEXT: affine.for %i0 = 1 to 65 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 64 {
+  affine.for %i = 1 to 65 {
+    affine.for %j = 0 to 64 {
+      %idx0 = affine.apply (d0) -> (d0 + 1)(%j)
+      %idx1 = affine.apply (d0) -> (d0 - 1)(%i)
+      %v = load %A[%idx0, %idx1] : memref<65x65xf32>
+      store %v, %A[%j, %i] : memref<65x65xf32>
+    }
+  }
+  return
+}
+
+// Loops whose bounds depend on each other are not interchanged.
+// CHECK-LABEL: func @no_interchange_triangular
+func @no_interchange_triangular(%A : memref<64x64xf32>) {
+  // CHECK-NEXT: affine.for %i0 = 0 to 64 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to {{.*}}%i0{{.*}} {
+  affine.for %i = 0 to 64 {
+    affine.for %j = 0 to (d0) -> (d0)(%i) {
+      %v = load %A[%j, %i] : memref<64x64xf32>
+      store %v, %A[%j, %i] : memref<64x64xf32>
+    }
+  }
+  return
+}
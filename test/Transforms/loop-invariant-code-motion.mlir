@@ -0,0 +1,115 @@
+// RUN: mlir-opt %s -loop-invariant-code-motion | FileCheck %s
+
+// CHECK-DAG: [[MAP:#map[0-9]+]] = (d0) -> (d0 * 2)
+
+// Invariant computations are hoisted out of every loop they don't depend on.
+// CHECK-LABEL: func @invariant_ops
+func @invariant_ops(%A : memref<16x16xf32>) {
+  // CHECK-NEXT: %cst = constant 1.000000e+00 : f32
+  // CHECK-NEXT: affine.for %i0 = 0 to 8 {
+  // CHECK-NEXT:   %0 = affine.apply [[MAP]](%i0)
+  // CHECK-NEXT:   affine.for %i1 = 0 to 16 {
+  // CHECK-NEXT:     %1 = load %arg0[%0, %i1] : memref<16x16xf32>
+  // CHECK-NEXT:     %2 = addf %1, %cst : f32
+  // CHECK-NEXT:     store %2, %arg0[%0, %i1] : memref<16x16xf32>
+  // CHECK-NEXT:   }
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 8 {
+    affine.for %j = 0 to 16 {
+      %cst = constant 1.0 : f32
+      %idx = affine.apply (d0) -> (d0 * 2)(%i)
+      %v = load %A[%idx, %j] : memref<16x16xf32>
+      %r = addf %v, %cst : f32
+      store %r, %A[%idx, %j] : memref<16x16xf32>
+    }
+  }
+  return
+}
+
+// A load of an element that no store in the loop writes to is hoisted.
+// CHECK-LABEL: func @invariant_load
+func @invariant_load(%v : f32) {
+  %c0 = constant 0 : index
+  %m = alloc() : memref<17xf32>
+  %n = alloc() : memref<16xf32>
+  // CHECK:      %2 = load %0[%c0] : memref<17xf32>
+  // CHECK-NEXT: affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   %3 = affine.apply #map{{[0-9]+}}(%i0)
+  // CHECK-NEXT:   store %arg0, %0[%3] : memref<17xf32>
+  // CHECK-NEXT:   store %2, %1[%i0] : memref<16xf32>
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 16 {
+    %0 = affine.apply (d0) -> (d0 + 1)(%i)
+    store %v, %m[%0] : memref<17xf32>
+    %1 = load %m[%c0] : memref<17xf32>
+    store %1, %n[%i] : memref<16xf32>
+  }
+  return
+}
+
+// A load of an element written in the loop stays in it.
+// CHECK-LABEL: func @variant_load
+func @variant_load(%v : f32) {
+  %c0 = constant 0 : index
+  %m = alloc() : memref<16xf32>
+  %n = alloc() : memref<16xf32>
+  // CHECK:      affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   store %arg0, %0[%i0] : memref<16xf32>
+  // CHECK-NEXT:   %2 = load %0[%c0] : memref<16xf32>
+  affine.for %i = 0 to 16 {
+    store %v, %m[%i] : memref<16xf32>
+    %0 = load %m[%c0] : memref<16xf32>
+    store %0, %n[%i] : memref<16xf32>
+  }
+  return
+}
+
+// The allocation and deallocation of another local buffer in the loop don't
+// write to the memref loaded from.
+// CHECK-LABEL: func @load_past_alloc
+func @load_past_alloc() {
+  %c0 = constant 0 : index
+  %m = alloc() : memref<16xf32>
+  // CHECK:      %1 = load %0[%c0] : memref<16xf32>
+  // CHECK-NEXT: affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   %2 = alloc() : memref<16xf32>
+  // CHECK-NEXT:   store %1, %2[%i0] : memref<16xf32>
+  // CHECK-NEXT:   dealloc %2 : memref<16xf32>
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 16 {
+    %t = alloc() : memref<16xf32>
+    %0 = load %m[%c0] : memref<16xf32>
+    store %0, %t[%i] : memref<16xf32>
+    dealloc %t : memref<16xf32>
+  }
+  return
+}
+
+// A deallocation may free a buffer aliasing a memref that isn't local.
+// CHECK-LABEL: func @load_past_dealloc
+func @load_past_dealloc(%A : memref<16xf32>) {
+  %c0 = constant 0 : index
+  // CHECK:      affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   %0 = alloc() : memref<16xf32>
+  // CHECK-NEXT:   %1 = load %arg0[%c0] : memref<16xf32>
+  affine.for %i = 0 to 16 {
+    %t = alloc() : memref<16xf32>
+    %0 = load %A[%c0] : memref<16xf32>
+    store %0, %t[%i] : memref<16xf32>
+    dealloc %t : memref<16xf32>
+  }
+  return
+}
+
+// Loads aren't hoisted out of loops that may not run.
+// CHECK-LABEL: func @load_unknown_trip_count
+func @load_unknown_trip_count(%A : memref<16xf32>, %N : index) {
+  %c0 = constant 0 : index
+  // CHECK:      affine.for %i0 = 0 to %arg1 {
+  // CHECK-NEXT:   %0 = load %arg0[%c0] : memref<16xf32>
+  affine.for %i = 0 to %N {
+    %0 = load %A[%c0] : memref<16xf32>
+    %1 = addf %0, %0 : f32
+  }
+  return
+}
@@ -0,0 +1,72 @@
+// RUN: mlir-opt %s -loop-nest-unroll -unroll-factor=2 | FileCheck %s
+// RUN: mlir-opt %s -experimental-mt-pm=true -loop-nest-unroll -unroll-factor=2 | FileCheck %s
+// RUN: mlir-opt %s -loop-nest-unroll -unroll-full -unroll-max-growth=5 | FileCheck %s --check-prefix GROWTH
+// RUN: mlir-opt %s -loop-nest-unroll -unroll-factor=2 -pass-statistics -o /dev/null 2>&1 | FileCheck %s --check-prefix STATS
+
+// CHECK-DAG: [[MAP_PLUS_1:#map[0-9]+]] = (d0) -> (d0 + 1)
+
+// The nests are moved back into place, and use the values defined outside of
+// them again, including the original constants.
+
+// CHECK-LABEL: func @independent_nests(%arg0: memref<8xf32>, %arg1: index) {
+func @independent_nests(%A: memref<8xf32>, %N: index) {
+  // CHECK-NEXT: %c0 = constant 0 : index
+  // CHECK-NEXT: %cst = constant 1.000000e+00 : f32
+  %c0 = constant 0 : index
+  %cst = constant 1.0 : f32
+  // CHECK-NEXT: affine.for %i0 = 0 to 8 step 2 {
+  // CHECK-NEXT:   store %cst, %arg0[%i0] : memref<8xf32>
+  // CHECK-NEXT:   %0 = affine.apply [[MAP_PLUS_1]](%i0)
+  // CHECK-NEXT:   store %cst, %arg0[%0] : memref<8xf32>
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 8 {
+    store %cst, %A[%i] : memref<8xf32>
+  }
+  // CHECK-NEXT: "foo"() : () -> ()
+  "foo"() : () -> ()
+  // CHECK-NEXT: affine.for %i1 = 0 to 8 step 2 {
+  // CHECK-NEXT:   %1 = load %arg0[%c0] : memref<8xf32>
+  // CHECK-NEXT:   "bar"(%1, %i1, %arg1) : (f32, index, index) -> ()
+  // CHECK-NEXT:   %2 = affine.apply [[MAP_PLUS_1]](%i1)
+  // CHECK-NEXT:   %3 = load %arg0[%c0] : memref<8xf32>
+  // CHECK-NEXT:   "bar"(%3, %2, %arg1) : (f32, index, index) -> ()
+  // CHECK-NEXT: }
+  affine.for %j = 0 to 8 {
+    %v = load %A[%c0] : memref<8xf32>
+    "bar"(%v, %j, %N) : (f32, index, index) -> ()
+  }
+  // CHECK-NEXT: return
+  return
+}
+
+// Each loop nest has a growth budget of its own, so that both loops are fully
+// unrolled, unlike with -loop-unroll. The constants created for the induction
+// variables are moved to the entry block.
+
+// GROWTH-LABEL: func @growth_budget_per_nest
+func @growth_budget_per_nest() {
+  // GROWTH-NEXT: %[[C0_BAR:.*]] = constant 0 : index
+  // GROWTH-NEXT: %[[C0_FOO:.*]] = constant 0 : index
+  // GROWTH-NEXT: "foo"(%[[C0_FOO]]) : (index) -> ()
+  // GROWTH-NEXT: %{{.*}} = affine.apply
+  // GROWTH-NEXT: "foo"(%{{.*}}) : (index) -> ()
+  // GROWTH-NEXT: %{{.*}} = affine.apply
+  // GROWTH-NEXT: "foo"(%{{.*}}) : (index) -> ()
+  // GROWTH-NEXT: %{{.*}} = affine.apply
+  // GROWTH-NEXT: "foo"(%{{.*}}) : (index) -> ()
+  affine.for %i = 0 to 4 {
+    "foo"(%i) : (index) -> ()
+  }
+  // GROWTH-NEXT: "bar"(%[[C0_BAR]]) : (index) -> ()
+  // GROWTH-NOT: affine.for
+  // GROWTH: return
+  affine.for %j = 0 to 4 {
+    "bar"(%j) : (index) -> ()
+  }
+  return
+}
+
+// STATS: Function Pipeline
+// STATS-NEXT: Loop Nest Pipeline
+// STATS-NEXT: (S) 4 num-loop-nests
+// STATS-NEXT: LoopNestUnroll
@@ -0,0 +1,59 @@
+// RUN: printf '1 1 1000 func @hot %s:13:6\n1 16 900 affine.for @hot %s:14:3\n1 1 1000 func @cold %s:28:6\n1 16 5 affine.for @cold %s:29:3\n1 1 100 func @estimated %s:42:6\n10 30 50 affine.for @estimated %s:43:3\n' > %t
+// RUN: mlir-opt %s -loop-unroll -loop-profile=%t | FileCheck %s --check-prefix UNROLL
+// RUN: mlir-opt %s -loop-tile -tile-size=4 -loop-profile=%t | FileCheck %s --check-prefix TILE
+
+// The names of the regions in the profile above refer to the lines of this
+// file, as the -instrument-loops pass records them.
+
+// A loop taking most of the time of the profile is transformed.
+// UNROLL-LABEL: func @hot
+// UNROLL-NEXT:    affine.for %i0 = 0 to 16 step 4 {
+// TILE-LABEL: func @hot
+// TILE-NEXT:    affine.for %i0 = 0 to 16 step 4 {
+func @hot(%A : memref<16xf32>) {
+  affine.for %i = 0 to 16 {
+    %v = load %A[%i] : memref<16xf32>
+  }
+  return
+}
+
+// The loops taking less than 1% of the time of the most expensive region, and
+// those of a profiled function that never ran, are left alone.
+// UNROLL-LABEL: func @cold
+// UNROLL-NEXT:    affine.for %i0 = 0 to 16 {
+// UNROLL:         affine.for %i1 = 0 to 16 {
+// TILE-LABEL: func @cold
+// TILE-NEXT:    affine.for %i0 = 0 to 16 {
+// TILE:         affine.for %i1 = 0 to 16 {
+func @cold(%A : memref<16xf32>) {
+  affine.for %i = 0 to 16 {
+    %v = load %A[%i] : memref<16xf32>
+  }
+  affine.for %j = 0 to 16 {
+    %v = load %A[%j] : memref<16xf32>
+  }
+  return
+}
+
+// A loop with a symbolic trip count is unrolled by the largest power of two not
+// exceeding its average trip count in the profile, three.
+// UNROLL-LABEL: func @estimated
+// UNROLL:         affine.for %i0 = 0 to #map{{[0-9]+}}()[%arg1] step 2 {
+func @estimated(%A : memref<?xf32>, %n : index) {
+  affine.for %i = 0 to %n {
+    %v = load %A[%i] : memref<?xf32>
+  }
+  return
+}
+
+// The functions missing from the profile are transformed as usual.
+// UNROLL-LABEL: func @unprofiled
+// UNROLL-NEXT:    affine.for %i0 = 0 to 16 step 4 {
+// TILE-LABEL: func @unprofiled
+// TILE-NEXT:    affine.for %i0 = 0 to 16 step 4 {
+func @unprofiled(%A : memref<16xf32>) {
+  affine.for %i = 0 to 16 {
+    %v = load %A[%i] : memref<16xf32>
+  }
+  return
+}
@@ -0,0 +1,59 @@
+// RUN: mlir-opt %s -affine-loop-skew -skew-tile-size=4 | FileCheck %s
+// RUN: mlir-opt %s -affine-loop-skew -skew-tile-size=0 | FileCheck %s --check-prefix=NOTILE
+
+// The dependences (1, -1), (1, 0) and (1, 1) of this stencil become
+// non-negative once the space loop is skewed by the time loop. The tiles of the
+// skewed nest are enumerated by wavefronts.
+// CHECK-LABEL: func @jacobi_1d
+// NOTILE-LABEL: func @jacobi_1d
+func @jacobi_1d(%A: memref<17x66xf32>) {
+  // CHECK:      affine.for %i0 = {{.*}} {
+  // CHECK-NEXT:   affine.for %i1 = {{.*}} {
+  // CHECK-NEXT:     affine.for %i2 = {{.*}} {
+  // CHECK-NEXT:       affine.for %i3 = {{.*}} {
+  // CHECK-NEXT:         [[T:%[0-9]+]] = affine.apply {{.*}}(%i2)
+  // CHECK-NEXT:         [[X:%[0-9]+]] = affine.apply {{.*}}(%i2, %i3)
+  // CHECK:              load %arg0{{\[}}[[T]], {{.*}}] : memref<17x66xf32>
+  // CHECK:              store {{.*}}, %arg0[{{.*}}] : memref<17x66xf32>
+  // CHECK-NEXT:       }
+  // CHECK-NEXT:     }
+  // CHECK-NEXT:   }
+  // CHECK-NEXT: }
+  // NOTILE:      affine.for %i0 = {{.*}} {
+  // NOTILE-NEXT:   affine.for %i1 = {{.*}} {
+  // NOTILE-NEXT:     [[T:%[0-9]+]] = affine.apply {{.*}}(%i0, %i1)
+  // NOTILE-NEXT:     [[X:%[0-9]+]] = affine.apply {{.*}}(%i0, %i1)
+  // NOTILE:          load %arg0{{\[}}[[T]], {{.*}}] : memref<17x66xf32>
+  // NOTILE:          store {{.*}}, %arg0[{{.*}}] : memref<17x66xf32>
+  // NOTILE-NEXT:   }
+  // NOTILE-NEXT: }
+  affine.for %t = 0 to 16 {
+    affine.for %i = 1 to 65 {
+      %im1 = affine.apply (d0) -> (d0 - 1)(%i)
+      %ip1 = affine.apply (d0) -> (d0 + 1)(%i)
+      %tp1 = affine.apply (d0) -> (d0 + 1)(%t)
+      %l = load %A[%t, %im1] : memref<17x66xf32>
+      %c = load %A[%t, %i] : memref<17x66xf32>
+      %r = load %A[%t, %ip1] : memref<17x66xf32>
+      %s0 = addf %l, %c : f32
+      %s1 = addf %s0, %r : f32
+      store %s1, %A[%tp1, %i] : memref<17x66xf32>
+    }
+  }
+  return
+}
+
+// A nest with a parallel loop is left untouched.
+// CHECK-LABEL: func @parallel_inner_loop
+func @parallel_inner_loop(%A: memref<17x64xf32>) {
+  // CHECK:      affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 64 {
+  affine.for %t = 0 to 16 {
+    affine.for %i = 0 to 64 {
+      %tp1 = affine.apply (d0) -> (d0 + 1)(%t)
+      %c = load %A[%t, %i] : memref<17x64xf32>
+      store %c, %A[%tp1, %i] : memref<17x64xf32>
+    }
+  }
+  return
+}
@@ -0,0 +1,48 @@
+// RUN: mlir-opt %s -loop-tile -tile-size-args=1,2 | FileCheck %s
+
+// CHECK-DAG: [[NUM_TILES0:#map[0-9]+]] = ()[s0, s1] -> (s0 floordiv s1)
+// CHECK-DAG: [[NUM_TILES1:#map[0-9]+]] = ()[s0] -> (128 floordiv s0)
+// CHECK-DAG: [[TILE_LB:#map[0-9]+]] = (d0)[s0] -> (d0 * s0)
+// CHECK-DAG: [[TILE_UB:#map[0-9]+]] = (d0)[s0] -> (d0 * s0 + s0)
+// CHECK-DAG: [[REM_LB0:#map[0-9]+]] = ()[s0, s1] -> ((s0 floordiv s1) * s1, 0)
+// CHECK-DAG: [[REM_LB1:#map[0-9]+]] = ()[s0] -> ((128 floordiv s0) * s0, 0)
+
+// The full tiles have no min bounds; the remainder of each dimension is
+// handled by a copy of the nest following its tile-space loop.
+
+// CHECK-LABEL: func @parametric_tiling(%arg0: index, %arg1: index, %arg2: index) {
+func @parametric_tiling(%N : index, %T : index, %U : index) {
+  affine.for %i = 0 to %N {
+    affine.for %j = 0 to 128 {
+      "foo"(%i, %j) : (index, index) -> ()
+    }
+  }
+  return
+}
+// CHECK-NEXT:  affine.for [[T0:%i[0-9]+]] = 0 to [[NUM_TILES0]]()[%arg0, %arg1] {
+// CHECK-NEXT:    affine.for [[T1:%i[0-9]+]] = 0 to [[NUM_TILES1]]()[%arg2] {
+// CHECK-NEXT:      affine.for [[P0:%i[0-9]+]] = [[TILE_LB]]([[T0]])[%arg1] to [[TILE_UB]]([[T0]])[%arg1] {
+// CHECK-NEXT:        affine.for [[P1:%i[0-9]+]] = [[TILE_LB]]([[T1]])[%arg2] to [[TILE_UB]]([[T1]])[%arg2] {
+// CHECK-NEXT:          "foo"([[P0]], [[P1]]) : (index, index) -> ()
+// CHECK-NEXT:        }
+// CHECK-NEXT:      }
+// CHECK-NEXT:    }
+// CHECK-NEXT:    affine.for [[P0:%i[0-9]+]] = [[TILE_LB]]([[T0]])[%arg1] to [[TILE_UB]]([[T0]])[%arg1] {
+// CHECK-NEXT:      affine.for [[P1:%i[0-9]+]] = max [[REM_LB1]]()[%arg2] to 128 {
+// CHECK-NEXT:        "foo"([[P0]], [[P1]]) : (index, index) -> ()
+// CHECK-NEXT:      }
+// CHECK-NEXT:    }
+// CHECK-NEXT:  }
+// CHECK-NEXT:  affine.for [[T1:%i[0-9]+]] = 0 to [[NUM_TILES1]]()[%arg2] {
+// CHECK-NEXT:    affine.for [[P0:%i[0-9]+]] = max [[REM_LB0]]()[%arg0, %arg1] to %arg0 {
+// CHECK-NEXT:      affine.for [[P1:%i[0-9]+]] = [[TILE_LB]]([[T1]])[%arg2] to [[TILE_UB]]([[T1]])[%arg2] {
+// CHECK-NEXT:        "foo"([[P0]], [[P1]]) : (index, index) -> ()
+// CHECK-NEXT:      }
+// CHECK-NEXT:    }
+// CHECK-NEXT:  }
+// CHECK-NEXT:  affine.for [[P0:%i[0-9]+]] = max [[REM_LB0]]()[%arg0, %arg1] to %arg0 {
+// CHECK-NEXT:    affine.for [[P1:%i[0-9]+]] = max [[REM_LB1]]()[%arg2] to 128 {
+// CHECK-NEXT:      "foo"([[P0]], [[P1]]) : (index, index) -> ()
+// CHECK-NEXT:    }
+// CHECK-NEXT:  }
+// CHECK-NEXT:  return
@@ -1,5 +1,6 @@
 // RUN: mlir-opt %s -loop-tile -tile-size=32 | FileCheck %s
 // RUN: mlir-opt %s -split-input-file -loop-tile -tile-cache-size=512 | FileCheck %s --check-prefix=MODEL
+// RUN: mlir-opt %s -split-input-file -loop-tile -tile-cache-size=512 -tile-levels=2 -target-l1-cache-size=32 | FileCheck %s --check-prefix=LEVELS
 
 // CHECK-DAG: [[MAP0:#map[0-9]+]] = (d0) -> (d0 + 32)
 // CHECK-DAG: [[MAP1:#map[0-9]+]] = (d0) -> (d0 + 32, 50)
@@ -73,10 +74,13 @@ func @loop_max_min_bound(%A : memref<? x i32>, %L : index, %U : index) {
 // -----
 
 // Cache size is set to 512 KiB. This loop nest accesses about 49 MiB, and the
-// tile sizes chosen would be 6 x 6 x 6. However, to avoid min/max, which is
-// possible here, they are adjusted to 4 x 4 x 5.
+// largest tile whose footprint fits in the cache is 32 x 32 x 16. However, to
+// avoid min/max, which is possible here, it is adjusted to 32 x 32 x 10. With
+// two levels, each tile is split for the 32 KiB L1 cache into 8 x 8 x 4 tiles,
+// adjusted to 8 x 8 x 2 to divide the outer tile.
 
 // MODEL-LABEL: func @simple_matmul
+// LEVELS-LABEL: func @simple_matmul
 func @simple_matmul(%arg0: memref<8x8xvector<64xf32>>, %arg1: memref<8x8xvector<64xf32>>, %arg2: memref<8x8xvector<64xf32>>) -> memref<8x8xvector<64xf32>> {
   affine.for %i = 0 to 256 {
     affine.for %j = 0 to 256 {
@@ -92,6 +96,13 @@ func @simple_matmul(%arg0: memref<8x8xvector<64xf32>>, %arg1: memref<8x8xvector<
   }
   return %arg2 : memref<8x8xvector<64xf32>>
 }
-// MODEL:       affine.for %i0 = 0 to 256 step 4 {
-// MODEL-NEXT:    affine.for %i1 = 0 to 256 step 4 {
-// MODEL-NEXT:      affine.for %i2 = 0 to 250 step 5 {
+// MODEL:       affine.for %i0 = 0 to 256 step 32 {
+// MODEL-NEXT:    affine.for %i1 = 0 to 256 step 32 {
+// MODEL-NEXT:      affine.for %i2 = 0 to 250 step 10 {
+
+// LEVELS:       affine.for %i0 = 0 to 256 step 32 {
+// LEVELS-NEXT:    affine.for %i1 = 0 to 256 step 32 {
+// LEVELS-NEXT:      affine.for %i2 = 0 to 250 step 10 {
+// LEVELS-NEXT:        affine.for %i3 = #map{{[0-9]+}}(%i0) to #map{{[0-9]+}}(%i0) step 8 {
+// LEVELS-NEXT:          affine.for %i4 = #map{{[0-9]+}}(%i1) to #map{{[0-9]+}}(%i1) step 8 {
+// LEVELS-NEXT:            affine.for %i5 = #map{{[0-9]+}}(%i2) to #map{{[0-9]+}}(%i2) step 2 {
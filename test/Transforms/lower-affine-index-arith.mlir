@@ -0,0 +1,58 @@
+// RUN: mlir-opt -lower-affine %s | FileCheck %s
+// RUN: mlir-opt -lower-affine -lower-affine-strength-reduce %s | FileCheck %s -check-prefix=REDUCE
+
+// The divisions and modulos of values known to be non-negative, like the
+// induction variables of loops with non-negative lower bounds, are lowered to
+// single unsigned operations.
+// CHECK-LABEL: func @nonneg_div_mod
+// CHECK:      ^bb1(%[[IV:[0-9]+]]: index):
+// CHECK:      diviu %[[IV]], %c8{{.*}} : index
+// CHECK:      %[[BIAS:[0-9]+]] = addi %[[IV]], %c7{{.*}} : index
+// CHECK-NEXT: diviu %[[BIAS]], %c8{{.*}} : index
+// CHECK:      remiu %[[IV]], %c8{{.*}} : index
+// CHECK-NOT:  select
+// CHECK:      return
+func @nonneg_div_mod() {
+  affine.for %i = 0 to 64 {
+    %0 = affine.apply (d0) -> (d0 floordiv 8)(%i)
+    %1 = affine.apply (d0) -> (d0 ceildiv 8)(%i)
+    %2 = affine.apply (d0) -> (d0 mod 8)(%i)
+    "use"(%0, %1, %2) : (index, index, index) -> ()
+  }
+  return
+}
+
+// A loop starting at a negative value keeps the signed lowering.
+// CHECK-LABEL: func @signed_div
+// CHECK:      ^bb2:
+// CHECK:      select
+// CHECK:      divis
+// CHECK-NOT:  diviu
+// CHECK:      return
+func @signed_div() {
+  affine.for %i = -8 to 8 {
+    %0 = affine.apply (d0) -> (d0 floordiv 8)(%i)
+    "use"(%0) : (index) -> ()
+  }
+  return
+}
+
+// With strength reduction, the index linear in the induction variable is
+// carried by the loop and incremented on the back-edge.
+// CHECK-LABEL: func @strength_reduce
+// CHECK:      muli
+// REDUCE-LABEL: func @strength_reduce
+// REDUCE:      br ^bb1(%c0, %[[INIT:[0-9]+]] : index, index)
+// REDUCE-NEXT: ^bb1(%[[IV:[0-9]+]]: index, %[[IDX:[0-9]+]]: index):
+// REDUCE-NOT:  muli
+// REDUCE:      load %arg0[%[[IDX]]] : memref<?xf32>
+// REDUCE:      %[[NEXT:[0-9]+]] = addi %[[IDX]], %c4{{.*}} : index
+// REDUCE-NEXT: br ^bb1(%{{[0-9]+}}, %[[NEXT]] : index, index)
+func @strength_reduce(%A : memref<?xf32>, %N : index) {
+  affine.for %i = 0 to %N {
+    %0 = affine.apply (d0)[s0] -> (d0 * 4 + s0)(%i)[%N]
+    %1 = load %A[%0] : memref<?xf32>
+    "use"(%1) : (f32) -> ()
+  }
+  return
+}
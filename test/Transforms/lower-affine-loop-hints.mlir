@@ -0,0 +1,32 @@
+// RUN: mlir-opt -lower-affine %s | FileCheck %s
+// RUN: mlir-opt -lower-affine -lower-affine-mark-parallel %s | FileCheck %s -check-prefix=PARALLEL
+
+// The loop hints of "affine.for" are moved to the back-edge of the loop.
+// CHECK-LABEL: func @loop_hints
+// CHECK:   br ^bb1(%{{.*}} : index) {llvm.loop.vectorize.width: 8}
+// CHECK-NOT: llvm.loop.parallel
+func @loop_hints(%A : memref<64xf32>) {
+  affine.for %i = 0 to 64 {
+    %0 = load %A[%i] : memref<64xf32>
+    store %0, %A[%i] : memref<64xf32>
+  } {llvm.loop.vectorize.width: 8}
+  return
+}
+
+// Only the loops without loop-carried dependences are marked as parallel.
+// PARALLEL-LABEL: func @parallel_loops
+// PARALLEL:   br ^bb1(%{{.*}} : index) {llvm.loop.parallel: true}
+// PARALLEL-NOT: llvm.loop.parallel
+// PARALLEL:   return
+func @parallel_loops(%A : memref<64xf32>, %B : memref<64xf32>) {
+  affine.for %i = 0 to 64 {
+    %0 = load %A[%i] : memref<64xf32>
+    store %0, %B[%i] : memref<64xf32>
+  }
+  %c0 = constant 0 : index
+  affine.for %j = 0 to 64 {
+    %1 = load %A[%j] : memref<64xf32>
+    store %1, %B[%c0] : memref<64xf32>
+  }
+  return
+}
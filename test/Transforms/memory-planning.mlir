@@ -0,0 +1,104 @@
+// RUN: mlir-opt %s -split-input-file -plan-memory | FileCheck %s
+
+// CHECK-DAG: [[MAP_PLUS_64:#map[0-9]+]] = (d0) -> (d0 + 64)
+
+// The buffers that are never live at the same time share their memory.
+// CHECK-LABEL: func @sequential_buffers
+func @sequential_buffers(%arg0 : memref<64xf32>) {
+  // CHECK-NEXT: %0 = alloc() : memref<96xf32>
+  // CHECK-NEXT: %1 = view %0 : memref<96xf32> to memref<64xf32>
+  %a = alloc() : memref<64xf32>
+  affine.for %i = 0 to 64 {
+    %v = load %arg0[%i] : memref<64xf32>
+    store %v, %a[%i] : memref<64xf32>
+  }
+  // CHECK: %2 = view %0 : memref<96xf32> to memref<32xf32, [[MAP_PLUS_64]]>
+  %b = alloc() : memref<32xf32>
+  affine.for %i = 0 to 32 {
+    %v = load %a[%i] : memref<64xf32>
+    store %v, %b[%i] : memref<32xf32>
+  }
+  dealloc %a : memref<64xf32>
+  // CHECK-NOT: dealloc
+  // CHECK: %3 = view %0 : memref<96xf32> to memref<64xf32>
+  %c = alloc() : memref<64xf32>
+  affine.for %i = 0 to 32 {
+    %v = load %b[%i] : memref<32xf32>
+    store %v, %c[%i] : memref<64xf32>
+  }
+  dealloc %b : memref<32xf32>
+  affine.for %i = 0 to 64 {
+    %v = load %c[%i] : memref<64xf32>
+    store %v, %arg0[%i] : memref<64xf32>
+  }
+  dealloc %c : memref<64xf32>
+  // CHECK-NOT: dealloc
+  // CHECK: dealloc %0 : memref<96xf32>
+  // CHECK-NEXT: return
+  return
+}
+
+// -----
+
+// CHECK-DAG: [[MAP_PLUS_16:#map[0-9]+]] = (d0) -> (d0 + 16)
+
+// A buffer used in a loop is live during all of its iterations, whereas the
+// buffer allocated in the body of the loop is only live during an iteration.
+// The buffers of different types get different arenas.
+// CHECK-LABEL: func @loop_buffers
+func @loop_buffers(%arg0 : memref<16x16xf32>) {
+  // CHECK-NEXT: %0 = alloc() : memref<32xf32>
+  // CHECK-NEXT: %1 = alloc() : memref<4xi32>
+  // CHECK-NEXT: %2 = view %0 : memref<32xf32> to memref<16xf32>
+  %acc = alloc() : memref<16xf32>
+  affine.for %i = 0 to 16 {
+    // CHECK: view %0 : memref<32xf32> to memref<16xf32, [[MAP_PLUS_16]]>
+    // CHECK: view %1 : memref<4xi32> to memref<4xi32>
+    %tmp = alloc() : memref<16xf32>
+    %idx = alloc() : memref<4xi32>
+    affine.for %j = 0 to 16 {
+      %v = load %arg0[%i, %j] : memref<16x16xf32>
+      store %v, %tmp[%j] : memref<16xf32>
+    }
+    affine.for %j = 0 to 16 {
+      %v = load %tmp[%j] : memref<16xf32>
+      store %v, %acc[%j] : memref<16xf32>
+    }
+    dealloc %idx : memref<4xi32>
+    dealloc %tmp : memref<16xf32>
+  }
+  dealloc %acc : memref<16xf32>
+  // CHECK: dealloc %0 : memref<32xf32>
+  // CHECK-NEXT: dealloc %1 : memref<4xi32>
+  // CHECK: return
+  return
+}
+
+// -----
+
+// CHECK-DAG: [[MAP_PLUS_16:#map[0-9]+]] = (d0) -> (d0 + 16)
+
+// The buffers keep their alignment in the arena.
+// CHECK-LABEL: func @aligned_buffers
+func @aligned_buffers(%arg0 : f32) {
+  // CHECK-NEXT: %0 = alloc() {alignment: 64{{.*}}} : memref<19xf32>
+  // CHECK: view %0 : memref<19xf32> to memref<3xf32, [[MAP_PLUS_16]]>
+  // CHECK: view %0 : memref<19xf32> to memref<5xf32>
+  %a = alloc() {alignment: 64} : memref<3xf32>
+  %b = alloc() {alignment: 64} : memref<5xf32>
+  %c0 = constant 0 : index
+  store %arg0, %a[%c0] : memref<3xf32>
+  store %arg0, %b[%c0] : memref<5xf32>
+  return
+}
+
+// -----
+
+// The buffers that escape their function are left alone.
+// CHECK-LABEL: func @escaping_buffer
+func @escaping_buffer() -> memref<8xf32> {
+  // CHECK-NEXT: %0 = alloc() : memref<8xf32>
+  // CHECK-NEXT: return %0 : memref<8xf32>
+  %a = alloc() : memref<8xf32>
+  return %a : memref<8xf32>
+}
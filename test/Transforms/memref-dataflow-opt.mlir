@@ -247,3 +247,114 @@ func @store_load_store_nested_fwd(%N : index) -> f32 {
 // CHECK-NEXT:  %3 = load %0[%c1] : memref<10xf32>
 // CHECK-NEXT:  return %3 : f32
 }
+
+// The second load is replaced by the first one since nothing is stored in
+// between.
+// CHECK-LABEL: func @redundant_load
+func @redundant_load() {
+  %cf7 = constant 7.0 : f32
+  %m = alloc() : memref<10xf32>
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %m[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %v0 = load %m[%i1] : memref<10xf32>
+    %v1 = load %m[%i1] : memref<10xf32>
+    %v2 = addf %v0, %v1 : f32
+  }
+  return
+// CHECK:       affine.for %i1 = 0 to 10 {
+// CHECK-NEXT:    %1 = load %0[%i1] : memref<10xf32>
+// CHECK-NEXT:    %2 = addf %1, %1 : f32
+// CHECK-NEXT:  }
+}
+
+// The loop in between may overwrite the element being loaded.
+// CHECK-LABEL: func @redundant_load_intervening_store
+func @redundant_load_intervening_store() {
+  %cf7 = constant 7.0 : f32
+  %cf8 = constant 8.0 : f32
+  %m = alloc() : memref<10xf32>
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %m[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %v0 = load %m[%i1] : memref<10xf32>
+    affine.for %i2 = 0 to 10 {
+      store %cf8, %m[%i2] : memref<10xf32>
+    }
+    %v1 = load %m[%i1] : memref<10xf32>
+    %v2 = addf %v0, %v1 : f32
+  }
+  return
+// CHECK:       affine.for %i1 = 0 to 10 {
+// CHECK-NEXT:    %1 = load %0[%i1] : memref<10xf32>
+// CHECK-NEXT:    affine.for %i2 = 0 to 10 {
+// CHECK-NEXT:      store %cst_0, %0[%i2] : memref<10xf32>
+// CHECK-NEXT:    }
+// CHECK-NEXT:    %2 = load %0[%i1] : memref<10xf32>
+// CHECK-NEXT:    %3 = addf %1, %2 : f32
+// CHECK-NEXT:  }
+}
+
+// The first store is overwritten before being read.
+// CHECK-LABEL: func @dead_store
+func @dead_store() -> f32 {
+  %cf7 = constant 7.0 : f32
+  %cf8 = constant 8.0 : f32
+  %c1 = constant 1 : index
+  %m = alloc() : memref<10xf32>
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %m[%i0] : memref<10xf32>
+    store %cf8, %m[%i0] : memref<10xf32>
+  }
+  %v = load %m[%c1] : memref<10xf32>
+  return %v : f32
+// CHECK:       affine.for %i0 = 0 to 10 {
+// CHECK-NEXT:    store %cst_0, %0[%i0] : memref<10xf32>
+// CHECK-NEXT:  }
+// CHECK-NEXT:  %1 = load %0[%c1] : memref<10xf32>
+}
+
+// The first store may be read by the inner loop.
+// CHECK-LABEL: func @dead_store_intervening_load
+func @dead_store_intervening_load(%N : index) -> f32 {
+  %cf7 = constant 7.0 : f32
+  %cf8 = constant 8.0 : f32
+  %c1 = constant 1 : index
+  %m = alloc() : memref<10xf32>
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %m[%i0] : memref<10xf32>
+    affine.for %i1 = 0 to %N {
+      %v0 = load %m[%i1] : memref<10xf32>
+      %v1 = addf %v0, %v0 : f32
+    }
+    store %cf8, %m[%i0] : memref<10xf32>
+  }
+  %v = load %m[%c1] : memref<10xf32>
+  return %v : f32
+// CHECK:       affine.for %i0 = 0 to 10 {
+// CHECK-NEXT:    store %cst, %0[%i0] : memref<10xf32>
+// CHECK-NEXT:    affine.for %i1 = 0 to %arg0 {
+// CHECK-NEXT:      %1 = load %0[%i1] : memref<10xf32>
+// CHECK-NEXT:      %2 = addf %1, %1 : f32
+// CHECK-NEXT:    }
+// CHECK-NEXT:    store %cst_0, %0[%i0] : memref<10xf32>
+// CHECK-NEXT:  }
+}
+
+// A memref that is never read is erased along with its stores.
+// CHECK-LABEL: func @dead_alloc
+func @dead_alloc() {
+  %cf7 = constant 7.0 : f32
+  %m = alloc() : memref<10xf32>
+  affine.for %i0 = 0 to 10 {
+    store %cf7, %m[%i0] : memref<10xf32>
+  }
+  dealloc %m : memref<10xf32>
+  return
+// CHECK:       %cst = constant 7.000000e+00 : f32
+// CHECK-NEXT:  affine.for %i0 = 0 to 10 {
+// CHECK-NEXT:  }
+// CHECK-NEXT:  return
+}
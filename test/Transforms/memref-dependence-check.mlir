@@ -392,6 +392,49 @@ func @load_minus_2() {
   return
 }
 
+// -----
+// CHECK-LABEL: func @store_even_load_odd() {
+func @store_even_load_odd() {
+  %m = alloc() : memref<100xf32>
+  %c7 = constant 7.0 : f32
+  affine.for %i0 = 0 to 50 {
+    %a0 = affine.apply (d0) -> (d0 * 2) (%i0)
+    store %c7, %m[%a0] : memref<100xf32>
+    // expected-note@-1 {{dependence from 0 to 0 at depth 1 = false}}
+    // expected-note@-2 {{dependence from 0 to 0 at depth 2 = false}}
+    // expected-note@-3 {{dependence from 0 to 1 at depth 1 = false}}
+    // expected-note@-4 {{dependence from 0 to 1 at depth 2 = false}}
+    %a1 = affine.apply (d0) -> (d0 * 2 + 1) (%i0)
+    %v0 = load %m[%a1] : memref<100xf32>
+    // expected-note@-1 {{dependence from 1 to 0 at depth 1 = false}}
+    // expected-note@-2 {{dependence from 1 to 0 at depth 2 = false}}
+    // expected-note@-3 {{dependence from 1 to 1 at depth 1 = false}}
+    // expected-note@-4 {{dependence from 1 to 1 at depth 2 = false}}
+  }
+  return
+}
+
+// -----
+// CHECK-LABEL: func @store_load_disjoint_ranges() {
+func @store_load_disjoint_ranges() {
+  %m = alloc() : memref<100xf32>
+  %c7 = constant 7.0 : f32
+  affine.for %i0 = 0 to 10 {
+    store %c7, %m[%i0] : memref<100xf32>
+    // expected-note@-1 {{dependence from 0 to 0 at depth 1 = false}}
+    // expected-note@-2 {{dependence from 0 to 0 at depth 2 = false}}
+    // expected-note@-3 {{dependence from 0 to 1 at depth 1 = false}}
+    // expected-note@-4 {{dependence from 0 to 1 at depth 2 = false}}
+    %a0 = affine.apply (d0) -> (d0 + 10) (%i0)
+    %v0 = load %m[%a0] : memref<100xf32>
+    // expected-note@-1 {{dependence from 1 to 0 at depth 1 = false}}
+    // expected-note@-2 {{dependence from 1 to 0 at depth 2 = false}}
+    // expected-note@-3 {{dependence from 1 to 1 at depth 1 = false}}
+    // expected-note@-4 {{dependence from 1 to 1 at depth 2 = false}}
+  }
+  return
+}
+
 // -----
 // CHECK-LABEL: func @perfectly_nested_loops_loop_independent() {
 func @perfectly_nested_loops_loop_independent() {
@@ -0,0 +1,107 @@
+// RUN: mlir-opt -outline-gpu-kernels %s | FileCheck %s
+// RUN: mlir-opt -outline-gpu-kernels -gpu-block-size=32 %s | FileCheck %s --check-prefix=BLOCK32
+
+// CHECK-DAG: #[[IV1:map[0-9]+]] = ()[s0, s1] -> (s0 + s1)
+// CHECK-DAG: #[[IV2:map[0-9]+]] = ()[s0, s1] -> (s0 * 2 + s1)
+// CHECK-DAG: #[[GUARD1:set[0-9]+]] = (d0)[s0] : (-d0 + s0 - 1 >= 0)
+// CHECK-DAG: #[[GUARD2:set[0-9]+]] = (d0, d1)[s0, s1] : (-d0 + s0 - 1 >= 0, -d1 + s1 - 1 >= 0)
+
+// CHECK-LABEL: func @vector_add(%arg0: memref<1000xf32>, %arg1: memref<1000xf32>) {
+// CHECK-NEXT:   %[[LB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   %[[UB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   call @vector_add_kernel_0(%[[LB]], %[[UB]], %arg0, %arg1) {gpu.block_size: [128], gpu.step: [1]} : (index, index, memref<1000xf32>, memref<1000xf32>) -> ()
+// CHECK-NEXT:   return
+// BLOCK32-LABEL: func @vector_add
+// BLOCK32:         call @vector_add_kernel_0({{.*}}) {gpu.block_size: [32], gpu.step: [1]}
+func @vector_add(%A : memref<1000xf32>, %B : memref<1000xf32>) {
+  %cst = constant 1.0 : f32
+  affine.for %i = 0 to 1000 {
+    %0 = load %A[%i] : memref<1000xf32>
+    %1 = addf %0, %cst : f32
+    store %1, %B[%i] : memref<1000xf32>
+  }
+  return
+}
+// Each thread executes one iteration, and the threads past the upper bound do
+// nothing.  The constants are cloned into the kernel.
+// CHECK-LABEL: func @vector_add_kernel_0(%arg0: index, %arg1: index, %arg2: memref<1000xf32>, %arg3: memref<1000xf32>)
+// CHECK-NEXT:   attributes {gpu.kernel: true} {
+// CHECK-NEXT:   %cst = constant 1.000000e+00 : f32
+// CHECK-NEXT:   %0 = call @mlir_gpu_block_id_x() : () -> index
+// CHECK-NEXT:   %1 = call @mlir_gpu_block_dim_x() : () -> index
+// CHECK-NEXT:   %2 = call @mlir_gpu_thread_id_x() : () -> index
+// CHECK-NEXT:   %3 = muli %0, %1 : index
+// CHECK-NEXT:   %4 = addi %3, %2 : index
+// CHECK-NEXT:   %5 = affine.apply #[[IV1]]()[%4, %arg0]
+// CHECK-NEXT:   affine.if #[[GUARD1]](%5)[%arg1] {
+// CHECK-NEXT:     %6 = load %arg2[%5] : memref<1000xf32>
+// CHECK-NEXT:     %7 = addf %6, %cst : f32
+// CHECK-NEXT:     store %7, %arg3[%5] : memref<1000xf32>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+
+// A band of two loops is mapped to a two-dimensional grid, the innermost loop
+// to x.
+// CHECK-LABEL: func @matrix_square(%arg0: memref<?x?xf32>, %arg1: index, %arg2: index) {
+// CHECK:        call @matrix_square_kernel_0(%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}, %arg0) {gpu.block_size: [128, 1], gpu.step: [2, 1]} : (index, index, index, index, memref<?x?xf32>) -> ()
+// CHECK-NEXT:   return
+func @matrix_square(%A : memref<?x?xf32>, %n : index, %m : index) {
+  affine.for %i = 0 to %n {
+    affine.for %j = 0 to %m step 2 {
+      %0 = load %A[%i, %j] : memref<?x?xf32>
+      %1 = mulf %0, %0 : f32
+      store %1, %A[%i, %j] : memref<?x?xf32>
+    }
+  }
+  return
+}
+// CHECK-LABEL: func @matrix_square_kernel_0(%arg0: index, %arg1: index, %arg2: index, %arg3: index, %arg4: memref<?x?xf32>)
+// CHECK-NEXT:   attributes {gpu.kernel: true} {
+// CHECK:        %[[X:.*]] = affine.apply #[[IV2]]()[%{{.*}}, %arg0]
+// CHECK:        call @mlir_gpu_block_id_y() : () -> index
+// CHECK:        %[[Y:.*]] = affine.apply #[[IV1]]()[%{{.*}}, %arg2]
+// CHECK-NEXT:   affine.if #[[GUARD2]](%[[X]], %[[Y]])[%arg1, %arg3] {
+// CHECK-NEXT:     %{{.*}} = load %arg4[%[[Y]], %[[X]]] : memref<?x?xf32>
+
+// The inner loops whose bounds depend on the band are kept in the kernel.
+// CHECK-LABEL: func @triangle(%arg0: memref<64x64xf32>) {
+// CHECK:        call @triangle_kernel_0({{.*}}) {gpu.block_size: [128], gpu.step: [1]}
+func @triangle(%A : memref<64x64xf32>) {
+  %cst = constant 0.0 : f32
+  affine.for %i = 0 to 64 {
+    affine.for %j = 0 to (d0) -> (d0)(%i) {
+      store %cst, %A[%i, %j] : memref<64x64xf32>
+    }
+  }
+  return
+}
+// CHECK-LABEL: func @triangle_kernel_0(%arg0: index, %arg1: index, %arg2: memref<64x64xf32>)
+// CHECK:        affine.if
+// CHECK-NEXT:     affine.for %i0 = 0 to #{{.*}}(%{{.*}}) {
+
+// Loops with loop-carried dependences, calls or allocations are not outlined.
+// CHECK-LABEL: func @sequential_loops
+// CHECK-NOT: call @sequential_loops_kernel
+// CHECK:         return
+func @sequential_loops(%A : memref<64xf32>) {
+  affine.for %i = 1 to 64 {
+    %i1 = affine.apply (d0) -> (d0 - 1) (%i)
+    %0 = load %A[%i1] : memref<64xf32>
+    store %0, %A[%i] : memref<64xf32>
+  }
+  affine.for %i = 0 to 64 {
+    call @sequential_loops(%A) : (memref<64xf32>) -> ()
+  }
+  affine.for %i = 0 to 64 {
+    %0 = alloc() : memref<1xf32>
+    dealloc %0 : memref<1xf32>
+  }
+  return
+}
+
+// The functions of the GPU runtime returning the ids are declared once.
+// CHECK: func @mlir_gpu_block_id_x() -> index
+// CHECK: func @mlir_gpu_block_dim_x() -> index
+// CHECK: func @mlir_gpu_thread_id_x() -> index
+// CHECK: func @mlir_gpu_block_id_y() -> index
+// CHECK-NOT: func @mlir_gpu_block_id_x
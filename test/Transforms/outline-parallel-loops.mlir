@@ -0,0 +1,61 @@
+// RUN: mlir-opt -outline-parallel-loops %s | FileCheck %s
+
+// CHECK-LABEL: func @parallel_loop(%arg0: memref<64xf32>, %arg1: memref<64xf32>) {
+// CHECK-NEXT:   %[[LB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   %[[UB:.*]] = affine.apply #{{.*}}()
+// CHECK-NEXT:   call @parallel_loop_parallel_0(%[[LB]], %[[UB]], %arg0, %arg1) {parallel.step: 2} : (index, index, memref<64xf32>, memref<64xf32>) -> ()
+// CHECK-NEXT:   return
+func @parallel_loop(%A : memref<64xf32>, %B : memref<64xf32>) {
+  %cst = constant 1.0 : f32
+  affine.for %i = 0 to 64 step 2 {
+    %0 = load %A[%i] : memref<64xf32>
+    %1 = addf %0, %cst : f32
+    store %1, %B[%i] : memref<64xf32>
+  }
+  return
+}
+// The constants are cloned into the outlined function.
+// CHECK-LABEL: func @parallel_loop_parallel_0(%arg0: index, %arg1: index, %arg2: memref<64xf32>, %arg3: memref<64xf32>) {
+// CHECK-NEXT:   %cst = constant 1.000000e+00 : f32
+// CHECK-NEXT:   affine.for %i0 = %arg0 to %arg1 step 2 {
+// CHECK-NEXT:     %0 = load %arg2[%i0] : memref<64xf32>
+// CHECK-NEXT:     %1 = addf %0, %cst : f32
+// CHECK-NEXT:     store %1, %arg3[%i0] : memref<64xf32>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+
+// Only the outermost parallel loop of a nest is outlined, and the sequential
+// loops around it are kept.
+// CHECK-LABEL: func @nested_loops(%arg0: memref<64x64xf32>) {
+// CHECK-NEXT:   affine.for %i0 = 0 to 64 {
+// CHECK:          call @nested_loops_parallel_0(%{{.*}}, %{{.*}}, %arg0, %i0) {parallel.step: 1}
+// CHECK-NEXT:   }
+func @nested_loops(%A : memref<64x64xf32>) {
+  affine.for %i = 0 to 64 {
+    affine.for %j = 0 to 64 {
+      %0 = load %A[%i, %j] : memref<64x64xf32>
+      %i1 = affine.apply (d0) -> (d0 + 1) (%i)
+      store %0, %A[%i1, %j] : memref<64x64xf32>
+    }
+  }
+  return
+}
+// CHECK-LABEL: func @nested_loops_parallel_0(%arg0: index, %arg1: index, %arg2: memref<64x64xf32>, %arg3: index) {
+// CHECK-NEXT:   affine.for %i0 = %arg0 to %arg1 {
+
+// Loops with loop-carried dependences or calls are not outlined.
+// CHECK-LABEL: func @sequential_loops
+// CHECK-NOT: call @sequential_loops_parallel
+// CHECK:         return
+func @sequential_loops(%A : memref<64xf32>, %B : memref<1xf32>) {
+  %c0 = constant 0 : index
+  affine.for %i = 0 to 64 {
+    %0 = load %A[%i] : memref<64xf32>
+    store %0, %B[%c0] : memref<1xf32>
+  }
+  affine.for %i = 0 to 64 {
+    call @body(%i) : (index) -> ()
+  }
+  return
+}
+func @body(index)
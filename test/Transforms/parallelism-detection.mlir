@@ -21,3 +21,54 @@ func @loop_nest_3d_outer_two_parallel(%N : index) {
   }
   return
 }
+
+// -----
+
+// The outer loop carries the dependence, the inner one is parallel.
+// CHECK-LABEL: func @outer_loop_carried
+func @outer_loop_carried() {
+  %0 = alloc() : memref<101 x 100 x f32>
+  affine.for %i = 0 to 100 {
+    affine.for %j = 0 to 100 {
+    // expected-note@-1 {{parallel loop}}
+      %v = load %0[%i, %j] : memref<101x100xf32>
+      %i1 = affine.apply (d0) -> (d0 + 1) (%i)
+      store %v, %0[%i1, %j] : memref<101x100xf32>
+    }
+  }
+  return
+}
+
+// -----
+
+// The inner loop carries the dependence, the outer one is parallel.
+// CHECK-LABEL: func @inner_loop_carried
+func @inner_loop_carried() {
+  %0 = alloc() : memref<100 x 101 x f32>
+  affine.for %i = 0 to 100 {
+  // expected-note@-1 {{parallel loop}}
+    affine.for %j = 0 to 100 {
+      %v = load %0[%i, %j] : memref<100x101xf32>
+      %j1 = affine.apply (d0) -> (d0 + 1) (%j)
+      store %v, %0[%i, %j1] : memref<100x101xf32>
+    }
+  }
+  return
+}
+
+// -----
+
+// The store to the same element in every iteration of the inner loop makes it
+// carry an output dependence, the outer loop carries the flow dependence.
+// CHECK-LABEL: func @both_loops_carried
+func @both_loops_carried() {
+  %0 = alloc() : memref<101 x f32>
+  affine.for %i = 0 to 100 {
+    affine.for %j = 0 to 100 {
+      %v = load %0[%i] : memref<101xf32>
+      %i1 = affine.apply (d0) -> (d0 + 1) (%i)
+      store %v, %0[%i1] : memref<101xf32>
+    }
+  }
+  return
+}
@@ -0,0 +1,67 @@
+// RUN: mlir-opt %s -pipeline-data-transfer -pipeline-num-buffers=3 | FileCheck %s
+
+// CHECK-DAG: [[MOD_3:#map[0-9]+]] = (d0) -> (d0 mod 3)
+
+// With triple buffering, the incoming DMAs are started two iterations ahead
+// of the computation.
+// CHECK-LABEL: func @loop_dma_triple_buffering
+func @loop_dma_triple_buffering(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 256 : index
+  %c0 = constant 0 : index
+  %buf = alloc() : memref<8x32xf32, 2>
+  %tag = alloc() : memref<1xi32>
+  // CHECK-DAG: [[BUF:%[0-9]+]] = alloc() : memref<3x8x32xf32, 2>
+  // CHECK-DAG: [[TAG:%[0-9]+]] = alloc() : memref<3x1xi32>
+  // CHECK:     affine.for %i0 = 0 to 2 {
+  // CHECK:       dma_start %arg0[{{.*}}], [[BUF]][
+  // CHECK-NEXT: }
+  // CHECK-NEXT: affine.for %i1 = 2 to 16 {
+  // CHECK:       affine.apply [[MOD_3]](%i1)
+  // CHECK:       dma_start %arg0[{{.*}}], [[BUF]][
+  // CHECK:       dma_wait [[TAG]][
+  // CHECK:       "compute"
+  // CHECK-NEXT: }
+  // CHECK-NEXT: affine.for %i2 = 16 to 18 {
+  // CHECK:       dma_wait [[TAG]][
+  // CHECK:       "compute"
+  // CHECK-NEXT: }
+  // CHECK-DAG: dealloc [[TAG]] : memref<3x1xi32>
+  // CHECK-DAG: dealloc [[BUF]] : memref<3x8x32xf32, 2>
+  affine.for %i0 = 0 to 16 {
+    %idx = affine.apply (d0) -> (d0 * 8)(%i0)
+    dma_start %arg0[%idx, %c0], %buf[%c0, %c0], %num_elts, %tag[%c0] : memref<512x32xf32>, memref<8x32xf32, 2>, memref<1xi32>
+    dma_wait %tag[%c0], %num_elts : memref<1xi32>
+    %v = load %buf[%c0, %c0] : memref<8x32xf32, 2>
+    "compute"(%v) : (f32) -> ()
+  }
+  return
+}
+
+// The outgoing DMAs are waited for two iterations after the computation.
+// CHECK-LABEL: func @loop_dma_outgoing_triple_buffering
+func @loop_dma_outgoing_triple_buffering(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 256 : index
+  %c0 = constant 0 : index
+  %cf = constant 1.0 : f32
+  %buf = alloc() : memref<8x32xf32, 2>
+  %tag = alloc() : memref<1xi32>
+  // CHECK:     affine.for %i0 = 0 to 2 {
+  // CHECK:       store %cst, [[BUF:%[0-9]+]][
+  // CHECK-NEXT:  dma_start [[BUF]][{{.*}}], %arg0[
+  // CHECK-NEXT: }
+  // CHECK-NEXT: affine.for %i1 = 2 to 16 {
+  // CHECK:       store %cst, [[BUF]][
+  // CHECK-NEXT:  dma_start [[BUF]][{{.*}}], %arg0[
+  // CHECK:       dma_wait
+  // CHECK-NEXT: }
+  // CHECK-NEXT: affine.for %i2 = 16 to 18 {
+  // CHECK:       dma_wait
+  // CHECK-NEXT: }
+  affine.for %i0 = 0 to 16 {
+    %idx = affine.apply (d0) -> (d0 * 8)(%i0)
+    store %cf, %buf[%c0, %c0] : memref<8x32xf32, 2>
+    dma_start %buf[%c0, %c0], %arg0[%idx, %c0], %num_elts, %tag[%c0] : memref<8x32xf32, 2>, memref<512x32xf32>, memref<1xi32>
+    dma_wait %tag[%c0], %num_elts : memref<1xi32>
+  }
+  return
+}
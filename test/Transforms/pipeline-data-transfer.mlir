@@ -4,6 +4,7 @@
 // CHECK-DAG: [[FLOOR_MOD_2:#map[0-9]+]] = (d0) -> ((d0 floordiv 4) mod 2)
 // CHECK-DAG: [[REMAP_SHIFT_MINUS_4:#map[0-9]+]] = (d0) -> (d0 - 4)
 // CHECK-DAG: [[MAP_MINUS_1:#map[0-9]+]] = (d0) -> (d0 - 1)
+// CHECK-DAG: [[TRANSPOSE_3D:#map[0-9]+]] = (d0, d1, d2) -> (d0, d2, d1)
 
 // CHECK-LABEL: func @loop_nest_dma() {
 func @loop_nest_dma() {
@@ -188,7 +189,7 @@ func @loop_dma_nested(%arg0: memref<512x32xvector<8xf32>, #map0>, %arg1: memref<
 // CHECK:     return
 }
 
-// CHECK: func @loop_dma_dependent
+// CHECK-LABEL: func @loop_dma_dependent
 func @loop_dma_dependent(%arg2: memref<512x32xvector<8xf32>>) {
   %num_elts = constant 256 : index
   %c0 = constant 0 : index
@@ -200,9 +201,14 @@ func @loop_dma_dependent(%arg2: memref<512x32xvector<8xf32>>) {
   %5 = alloc() : memref<2xi32>
 
   // The two DMAs below are dependent (incoming and outgoing on the same
-  // memref) in the same iteration; so no pipelining here.
-  // CHECK-NOT: dma_start
-  // CHECK: affine.for %i0 = 0 to 8 {
+  // memref) in the same iteration, but the dependence analysis shows that the
+  // tile written back by an iteration is never read by a later one; so the
+  // incoming DMA is pipelined. The outgoing DMA shares its buffer with the
+  // incoming one and is left in place.
+  // CHECK-DAG: [[BUF:%[0-9]+]] = alloc() : memref<2x64x4xvector<8xf32>, 2>
+  // CHECK-DAG: [[TAG:%[0-9]+]] = alloc() : memref<2x2xi32>
+  // CHECK:     dma_start %arg2[{{.*}}], [[BUF]][
+  // CHECK:     affine.for %i0 = 1 to 8 {
   affine.for %i0 = 0 to 8 {
     %6 = affine.apply #map2(%i0)
     dma_start %arg2[%6, %c0], %2[%c0, %c0], %num_elts, %5[%c0] : memref<512x32xvector<8xf32>>, memref<64x4xvector<8xf32>, 2>, memref<2xi32>
@@ -210,8 +216,132 @@ func @loop_dma_dependent(%arg2: memref<512x32xvector<8xf32>>) {
 
     dma_start %2[%c0, %c0], %arg2[%6, %c0], %num_elts, %5[%c0] : memref<64x4xvector<8xf32>, 2>, memref<512x32xvector<8xf32>>, memref<2xi32>
     dma_wait %5[%c0], %num_elts : memref<2xi32>
-  } // CHECK: }
-  return // CHECK: return
+  }
+  // CHECK:       dma_start %arg2[{{.*}}], [[BUF]][
+  // CHECK:       dma_wait [[TAG]]
+  // CHECK:       dma_start [[BUF]][{{.*}}], %arg2[
+  // CHECK:       dma_wait [[TAG]]
+  // CHECK-NEXT: }
+  // CHECK:     dma_wait [[TAG]]
+  // CHECK:     dma_start [[BUF]][{{.*}}], %arg2[
+  // CHECK:     dma_wait [[TAG]]
+  return
+  // CHECK:     return
+}
+
+// CHECK-LABEL: func @loop_dma_carried_dependence
+func @loop_dma_carried_dependence(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 256 : index
+  %c0 = constant 0 : index
+  %0 = alloc() : memref<8x32xf32, 2>
+  %1 = alloc() : memref<8x32xf32, 2>
+  %2 = alloc() : memref<2xi32>
+  %3 = alloc() : memref<2xi32>
+  // Each iteration writes back the tile read by the next one; neither DMA can
+  // be pipelined.
+  // CHECK-NOT: dma_start
+  // CHECK:     affine.for %i0 = 0 to 8 {
+  affine.for %i0 = 0 to 8 {
+    %4 = affine.apply (d0) -> (d0 * 8)(%i0)
+    %5 = affine.apply (d0) -> (d0 * 8 + 8)(%i0)
+    dma_start %arg0[%4, %c0], %0[%c0, %c0], %num_elts, %2[%c0] : memref<512x32xf32>, memref<8x32xf32, 2>, memref<2xi32>
+    dma_wait %2[%c0], %num_elts : memref<2xi32>
+    dma_start %1[%c0, %c0], %arg0[%5, %c0], %num_elts, %3[%c0] : memref<8x32xf32, 2>, memref<512x32xf32>, memref<2xi32>
+    dma_wait %3[%c0], %num_elts : memref<2xi32>
+  }
+  // CHECK-NOT: memref<2x8x32xf32, 2>
+  return
+}
+
+// CHECK-LABEL: func @loop_dma_outgoing
+func @loop_dma_outgoing(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 256 : index
+  %c0 = constant 0 : index
+  %cf = constant 1.0 : f32
+  %buf = alloc() : memref<8x32xf32, 2>
+  %tag = alloc() : memref<1xi32>
+  // Results are written back while the next iteration computes: the wait of
+  // the outgoing DMA of an iteration is delayed to the next one.
+  // CHECK-DAG: [[BUF:%[0-9]+]] = alloc() : memref<2x8x32xf32, 2>
+  // CHECK-DAG: [[TAG:%[0-9]+]] = alloc() : memref<2x1xi32>
+  // CHECK:     store %cst, [[BUF]][
+  // CHECK:     dma_start [[BUF]][{{.*}}], %arg0[{{.*}}], %c256, [[TAG]][
+  // CHECK-NOT: dma_wait
+  // CHECK:     affine.for %i0 = 1 to 8 {
+  affine.for %i0 = 0 to 8 {
+    %idx = affine.apply (d0) -> (d0 * 8)(%i0)
+    store %cf, %buf[%c0, %c0] : memref<8x32xf32, 2>
+    dma_start %buf[%c0, %c0], %arg0[%idx, %c0], %num_elts, %tag[%c0] : memref<8x32xf32, 2>, memref<512x32xf32>, memref<1xi32>
+    dma_wait %tag[%c0], %num_elts : memref<1xi32>
+  }
+  // CHECK:       store %cst, [[BUF]][
+  // CHECK:       dma_start [[BUF]][{{.*}}], %arg0[{{.*}}], %c256, [[TAG]][
+  // CHECK:       dma_wait [[TAG]][
+  // CHECK-NEXT: }
+  // CHECK:     dma_wait [[TAG]][
+  // CHECK-DAG: dealloc [[TAG]] : memref<2x1xi32>
+  // CHECK-DAG: dealloc [[BUF]] : memref<2x8x32xf32, 2>
+  return
+  // CHECK:     return
+}
+
+// CHECK-LABEL: func @loop_dma_in_place
+func @loop_dma_in_place(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 256 : index
+  %c0 = constant 0 : index
+  %0 = alloc() : memref<8x32xf32, 2>
+  %1 = alloc() : memref<8x32xf32, 2>
+  %2 = alloc() : memref<2xi32>
+  %3 = alloc() : memref<2xi32>
+  // Each tile is read, and written back in place from another buffer: the
+  // tiles of the other iterations are disjoint, so the incoming DMAs are
+  // started one iteration ahead of the computation, and the outgoing DMAs are
+  // waited for one iteration after it.
+  // CHECK-DAG: alloc() : memref<2x8x32xf32, 2>
+  // CHECK-DAG: alloc() : memref<2x8x32xf32, 2>
+  // CHECK:     dma_start %arg0[{{.*}}], [[IN_BUF:%[0-9]+]][{{.*}}], %c256, [[IN_TAG:%[0-9]+]][
+  // CHECK:     dma_start %arg0[{{.*}}], [[IN_BUF]][
+  // CHECK:     dma_wait [[IN_TAG]][
+  // CHECK:     dma_start [[OUT_BUF:%[0-9]+]][{{.*}}], %arg0[{{.*}}], %c256, [[OUT_TAG:%[0-9]+]][
+  // CHECK-NOT: dma_wait
+  // CHECK:     affine.for %i0 = 2 to 8 {
+  // CHECK:       dma_start %arg0[{{.*}}], [[IN_BUF]][
+  // CHECK:       dma_wait [[IN_TAG]][
+  // CHECK:       dma_start [[OUT_BUF]][{{.*}}], %arg0[
+  // CHECK:       dma_wait [[OUT_TAG]][
+  // CHECK-NEXT: }
+  // CHECK:     dma_wait [[IN_TAG]][
+  // CHECK:     dma_start [[OUT_BUF]][{{.*}}], %arg0[
+  // CHECK:     dma_wait [[OUT_TAG]][
+  // CHECK:     dma_wait [[OUT_TAG]][
+  affine.for %i0 = 0 to 8 {
+    %4 = affine.apply (d0) -> (d0 * 8)(%i0)
+    dma_start %arg0[%4, %c0], %0[%c0, %c0], %num_elts, %2[%c0] : memref<512x32xf32>, memref<8x32xf32, 2>, memref<2xi32>
+    dma_wait %2[%c0], %num_elts : memref<2xi32>
+    %v = load %0[%c0, %c0] : memref<8x32xf32, 2>
+    store %v, %1[%c0, %c0] : memref<8x32xf32, 2>
+    dma_start %1[%c0, %c0], %arg0[%4, %c0], %num_elts, %3[%c0] : memref<8x32xf32, 2>, memref<512x32xf32>, memref<2xi32>
+    dma_wait %3[%c0], %num_elts : memref<2xi32>
+  }
+  return
+}
+
+// CHECK-LABEL: func @loop_dma_layout
+func @loop_dma_layout(%arg0: memref<512x32xf32>) {
+  %num_elts = constant 1024 : index
+  %c0 = constant 0 : index
+  %buf = alloc() : memref<32x32xf32, (d0, d1) -> (d1, d0), 2>
+  %tag = alloc() : memref<1xi32>
+  // The layout of the buffer is preserved by the new leading dimension.
+  // CHECK: alloc() : memref<2x32x32xf32, [[TRANSPOSE_3D]], 2>
+  affine.for %i0 = 0 to 16 {
+    %idx = affine.apply (d0) -> (d0 * 32)(%i0)
+    dma_start %arg0[%idx, %c0], %buf[%c0, %c0], %num_elts, %tag[%c0] : memref<512x32xf32>, memref<32x32xf32, (d0, d1) -> (d1, d0), 2>, memref<1xi32>
+    dma_wait %tag[%c0], %num_elts : memref<1xi32>
+    %v = load %buf[%c0, %i0] : memref<32x32xf32, (d0, d1) -> (d1, d0), 2>
+    "compute"(%v) : (f32) -> ()
+  }
+  return
 }
 
 // CHECK-LABEL: func @escaping_use
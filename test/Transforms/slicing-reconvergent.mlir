@@ -0,0 +1,91 @@
+// RUN: mlir-opt %s -vectorizer-test -slicing=true 2>&1 | FileCheck %s
+
+// Each value is used twice by the next operation, so that the number of
+// use-def paths doubles at each step.  Slicing must visit each operation
+// once rather than once per path, which would not terminate here.
+func @reconvergent_chain() {
+  // CHECK: matched: %0 {{.*}} static slice:
+  // CHECK-NEXT: %0 = "slicing-test-op"() : () -> i32
+  // CHECK-NEXT: %1 = "slicing-test-op"(%0, %0) : (i32, i32) -> i32
+  // CHECK-NEXT: %2 = "slicing-test-op"(%1, %1) : (i32, i32) -> i32
+  // CHECK-NEXT: %3 = "slicing-test-op"(%2, %2) : (i32, i32) -> i32
+  // CHECK-NEXT: %4 = "slicing-test-op"(%3, %3) : (i32, i32) -> i32
+  // CHECK-NEXT: %5 = "slicing-test-op"(%4, %4) : (i32, i32) -> i32
+  // CHECK-NEXT: %6 = "slicing-test-op"(%5, %5) : (i32, i32) -> i32
+  // CHECK-NEXT: %7 = "slicing-test-op"(%6, %6) : (i32, i32) -> i32
+  // CHECK-NEXT: %8 = "slicing-test-op"(%7, %7) : (i32, i32) -> i32
+  // CHECK-NEXT: %9 = "slicing-test-op"(%8, %8) : (i32, i32) -> i32
+  // CHECK-NEXT: %10 = "slicing-test-op"(%9, %9) : (i32, i32) -> i32
+  // CHECK-NEXT: %11 = "slicing-test-op"(%10, %10) : (i32, i32) -> i32
+  // CHECK-NEXT: %12 = "slicing-test-op"(%11, %11) : (i32, i32) -> i32
+  // CHECK-NEXT: %13 = "slicing-test-op"(%12, %12) : (i32, i32) -> i32
+  // CHECK-NEXT: %14 = "slicing-test-op"(%13, %13) : (i32, i32) -> i32
+  // CHECK-NEXT: %15 = "slicing-test-op"(%14, %14) : (i32, i32) -> i32
+  // CHECK-NEXT: %16 = "slicing-test-op"(%15, %15) : (i32, i32) -> i32
+  // CHECK-NEXT: %17 = "slicing-test-op"(%16, %16) : (i32, i32) -> i32
+  // CHECK-NEXT: %18 = "slicing-test-op"(%17, %17) : (i32, i32) -> i32
+  // CHECK-NEXT: %19 = "slicing-test-op"(%18, %18) : (i32, i32) -> i32
+  // CHECK-NEXT: %20 = "slicing-test-op"(%19, %19) : (i32, i32) -> i32
+  // CHECK-NEXT: %21 = "slicing-test-op"(%20, %20) : (i32, i32) -> i32
+  // CHECK-NEXT: %22 = "slicing-test-op"(%21, %21) : (i32, i32) -> i32
+  // CHECK-NEXT: %23 = "slicing-test-op"(%22, %22) : (i32, i32) -> i32
+  // CHECK-NEXT: %24 = "slicing-test-op"(%23, %23) : (i32, i32) -> i32
+  // CHECK-NEXT: %25 = "slicing-test-op"(%24, %24) : (i32, i32) -> i32
+  // CHECK-NEXT: %26 = "slicing-test-op"(%25, %25) : (i32, i32) -> i32
+  // CHECK-NEXT: %27 = "slicing-test-op"(%26, %26) : (i32, i32) -> i32
+  // CHECK-NEXT: %28 = "slicing-test-op"(%27, %27) : (i32, i32) -> i32
+  // CHECK-NEXT: %29 = "slicing-test-op"(%28, %28) : (i32, i32) -> i32
+  // CHECK-NEXT: %30 = "slicing-test-op"(%29, %29) : (i32, i32) -> i32
+  // CHECK-NEXT: %31 = "slicing-test-op"(%30, %30) : (i32, i32) -> i32
+  // CHECK-NEXT: %32 = "slicing-test-op"(%31, %31) : (i32, i32) -> i32
+  // CHECK-NEXT: %33 = "slicing-test-op"(%32, %32) : (i32, i32) -> i32
+  // CHECK-NEXT: %34 = "slicing-test-op"(%33, %33) : (i32, i32) -> i32
+  // CHECK-NEXT: %35 = "slicing-test-op"(%34, %34) : (i32, i32) -> i32
+  // CHECK-NEXT: %36 = "slicing-test-op"(%35, %35) : (i32, i32) -> i32
+  // CHECK-NEXT: %37 = "slicing-test-op"(%36, %36) : (i32, i32) -> i32
+  // CHECK-NEXT: %38 = "slicing-test-op"(%37, %37) : (i32, i32) -> i32
+  // CHECK-NEXT: %39 = "slicing-test-op"(%38, %38) : (i32, i32) -> i32
+  // CHECK-NEXT: %40 = "slicing-test-op"(%39, %39) : (i32, i32) -> i32
+  %0 = "slicing-test-op" () : () -> i32
+  %1 = "slicing-test-op" (%0, %0) : (i32, i32) -> i32
+  %2 = "slicing-test-op" (%1, %1) : (i32, i32) -> i32
+  %3 = "slicing-test-op" (%2, %2) : (i32, i32) -> i32
+  %4 = "slicing-test-op" (%3, %3) : (i32, i32) -> i32
+  %5 = "slicing-test-op" (%4, %4) : (i32, i32) -> i32
+  %6 = "slicing-test-op" (%5, %5) : (i32, i32) -> i32
+  %7 = "slicing-test-op" (%6, %6) : (i32, i32) -> i32
+  %8 = "slicing-test-op" (%7, %7) : (i32, i32) -> i32
+  %9 = "slicing-test-op" (%8, %8) : (i32, i32) -> i32
+  %10 = "slicing-test-op" (%9, %9) : (i32, i32) -> i32
+  %11 = "slicing-test-op" (%10, %10) : (i32, i32) -> i32
+  %12 = "slicing-test-op" (%11, %11) : (i32, i32) -> i32
+  %13 = "slicing-test-op" (%12, %12) : (i32, i32) -> i32
+  %14 = "slicing-test-op" (%13, %13) : (i32, i32) -> i32
+  %15 = "slicing-test-op" (%14, %14) : (i32, i32) -> i32
+  %16 = "slicing-test-op" (%15, %15) : (i32, i32) -> i32
+  %17 = "slicing-test-op" (%16, %16) : (i32, i32) -> i32
+  %18 = "slicing-test-op" (%17, %17) : (i32, i32) -> i32
+  %19 = "slicing-test-op" (%18, %18) : (i32, i32) -> i32
+  %20 = "slicing-test-op" (%19, %19) : (i32, i32) -> i32
+  %21 = "slicing-test-op" (%20, %20) : (i32, i32) -> i32
+  %22 = "slicing-test-op" (%21, %21) : (i32, i32) -> i32
+  %23 = "slicing-test-op" (%22, %22) : (i32, i32) -> i32
+  %24 = "slicing-test-op" (%23, %23) : (i32, i32) -> i32
+  %25 = "slicing-test-op" (%24, %24) : (i32, i32) -> i32
+  %26 = "slicing-test-op" (%25, %25) : (i32, i32) -> i32
+  %27 = "slicing-test-op" (%26, %26) : (i32, i32) -> i32
+  %28 = "slicing-test-op" (%27, %27) : (i32, i32) -> i32
+  %29 = "slicing-test-op" (%28, %28) : (i32, i32) -> i32
+  %30 = "slicing-test-op" (%29, %29) : (i32, i32) -> i32
+  %31 = "slicing-test-op" (%30, %30) : (i32, i32) -> i32
+  %32 = "slicing-test-op" (%31, %31) : (i32, i32) -> i32
+  %33 = "slicing-test-op" (%32, %32) : (i32, i32) -> i32
+  %34 = "slicing-test-op" (%33, %33) : (i32, i32) -> i32
+  %35 = "slicing-test-op" (%34, %34) : (i32, i32) -> i32
+  %36 = "slicing-test-op" (%35, %35) : (i32, i32) -> i32
+  %37 = "slicing-test-op" (%36, %36) : (i32, i32) -> i32
+  %38 = "slicing-test-op" (%37, %37) : (i32, i32) -> i32
+  %39 = "slicing-test-op" (%38, %38) : (i32, i32) -> i32
+  %40 = "slicing-test-op" (%39, %39) : (i32, i32) -> i32
+  return
+}
@@ -0,0 +1,84 @@
+// RUN: mlir-opt -specialize-functions %s | FileCheck %s
+// RUN: mlir-opt -specialize-functions -specialize-max-clones=1 %s | FileCheck %s --check-prefix=BOUNDED
+
+// CHECK-LABEL: func @fill(%arg0: memref<?xf32>, %arg1: index, %arg2: f32) {
+func @fill(%A : memref<?xf32>, %n : index, %v : f32) {
+  affine.for %i = 0 to %n {
+    store %v, %A[%i] : memref<?xf32>
+  }
+  return
+}
+
+// The constants are removed from the signature of the specializations, and the
+// memrefs take their static type.
+// CHECK-LABEL: func @fill_specialized_0(%arg0: memref<16xf32>, %arg1: f32) {
+// CHECK-NEXT:   affine.for %i0 = 0 to 16 {
+// CHECK-NEXT:     store %arg1, %arg0[%i0] : memref<16xf32>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+
+// CHECK-LABEL: func @fill_specialized_1(%arg0: memref<16xf32>, %arg1: f32) {
+// CHECK-NEXT:   affine.for %i0 = 0 to 8 {
+// CHECK-NEXT:     store %arg1, %arg0[%i0] : memref<16xf32>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+
+// CHECK-LABEL: func @fill_specialized_2(%arg0: memref<16xf32>, %arg1: index, %arg2: f32) {
+// CHECK-NEXT:   affine.for %i0 = 0 to %arg1 {
+// CHECK-NEXT:     store %arg2, %arg0[%i0] : memref<16xf32>
+// CHECK-NEXT:   }
+// CHECK-NEXT:   return
+
+// The calls with the same specialized arguments share the same clone.
+// CHECK-LABEL: func @call_fill(%arg0: f32, %arg1: index) {
+// CHECK:        call @fill_specialized_0(%0, %arg0) : (memref<16xf32>, f32) -> ()
+// CHECK-NEXT:   call @fill_specialized_0(%0, %arg0) : (memref<16xf32>, f32) -> ()
+// CHECK-NEXT:   call @fill_specialized_1(%0, %arg0) : (memref<16xf32>, f32) -> ()
+// CHECK-NEXT:   call @fill_specialized_2(%0, %arg1, %arg0) : (memref<16xf32>, index, f32) -> ()
+// BOUNDED-LABEL: func @call_fill(%arg0: f32, %arg1: index) {
+// BOUNDED:        call @fill_specialized_0(%0, %arg0) : (memref<16xf32>, f32) -> ()
+// BOUNDED-NEXT:   call @fill_specialized_0(%0, %arg0) : (memref<16xf32>, f32) -> ()
+// BOUNDED-NEXT:   call @fill(%1, %c8, %arg0) : (memref<?xf32>, index, f32) -> ()
+// BOUNDED-NEXT:   call @fill(%1, %arg1, %arg0) : (memref<?xf32>, index, f32) -> ()
+func @call_fill(%v : f32, %n : index) {
+  %A = alloc() : memref<16xf32>
+  %0 = memref_cast %A : memref<16xf32> to memref<?xf32>
+  %c16 = constant 16 : index
+  %c8 = constant 8 : index
+  call @fill(%0, %c16, %v) : (memref<?xf32>, index, f32) -> ()
+  call @fill(%0, %c16, %v) : (memref<?xf32>, index, f32) -> ()
+  call @fill(%0, %c8, %v) : (memref<?xf32>, index, f32) -> ()
+  call @fill(%0, %n, %v) : (memref<?xf32>, index, f32) -> ()
+  return
+}
+
+func @sum(%A : memref<?xf32>) -> f32 {
+  %c0 = constant 0 : index
+  %cst = constant 0.0 : f32
+  %n = dim %A, 0 : memref<?xf32>
+  %sum = alloc() : memref<f32>
+  store %cst, %sum[] : memref<f32>
+  affine.for %i = 0 to %n {
+    %0 = load %A[%i] : memref<?xf32>
+    %1 = load %sum[] : memref<f32>
+    %2 = addf %0, %1 : f32
+    store %2, %sum[] : memref<f32>
+  }
+  %3 = load %sum[] : memref<f32>
+  return %3 : f32
+}
+
+// The sizes of the static memrefs fold into the trip counts of the loops.
+// CHECK-LABEL: func @sum_specialized_0(%arg0: memref<4xf32>) -> f32 {
+// CHECK:        affine.for %i0 = 0 to 4 {
+// CHECK-NEXT:     %{{.*}} = load %arg0[%i0] : memref<4xf32>
+
+// CHECK-LABEL: func @call_sum(%arg0: memref<4xf32>) -> f32 {
+// CHECK-NEXT:   %0 = memref_cast %arg0 : memref<4xf32> to memref<?xf32>
+// CHECK-NEXT:   %1 = call @sum_specialized_0(%arg0) : (memref<4xf32>) -> f32
+// CHECK-NEXT:   return %1 : f32
+func @call_sum(%A : memref<4xf32>) -> f32 {
+  %0 = memref_cast %A : memref<4xf32> to memref<?xf32>
+  %1 = call @sum(%0) : (memref<?xf32>) -> f32
+  return %1 : f32
+}
@@ -0,0 +1,96 @@
+// RUN: mlir-opt %s -loop-unroll-jam -unroll-jam-auto | FileCheck %s
+
+// The j loop is unroll-jammed by 4 to reuse A[i, k] across 4 columns of B and
+// C (2 * 4 + 1 registers), and the i loop by 2 to reuse the 4 elements of B
+// across 2 rows of A and C (5 * 2 + 4 registers).
+// CHECK-LABEL: func @matmul
+func @matmul(%A: memref<16x16xf32>, %B: memref<16x16xf32>, %C: memref<16x16xf32>) {
+  // CHECK:      affine.for %i0 = 0 to 16 step 2 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 16 step 4 {
+  // CHECK-NEXT:     affine.for %i2 = 0 to 16 {
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK:            store {{.*}}, %arg2[{{.*}}] : memref<16x16xf32>
+  // CHECK-NOT:        store
+  // CHECK:          }
+  // CHECK-NEXT:   }
+  // CHECK-NEXT: }
+  affine.for %i = 0 to 16 {
+    affine.for %j = 0 to 16 {
+      affine.for %k = 0 to 16 {
+        %a = load %A[%i, %k] : memref<16x16xf32>
+        %b = load %B[%k, %j] : memref<16x16xf32>
+        %c = load %C[%i, %j] : memref<16x16xf32>
+        %p = mulf %a, %b : f32
+        %s = addf %c, %p : f32
+        store %s, %C[%i, %j] : memref<16x16xf32>
+      }
+    }
+  }
+  return
+}
+
+// A trip count that isn't a multiple of the factor leaves a cleanup loop.
+// CHECK-LABEL: func @matvec_cleanup
+func @matvec_cleanup(%A: memref<10x16xf32>, %x: memref<16xf32>, %y: memref<10xf32>) {
+  // CHECK:      affine.for %i0 = 0 to 8 step 4 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 16 {
+  // CHECK:          store {{.*}}, %arg2[{{.*}}] : memref<10xf32>
+  // CHECK:          store {{.*}}, %arg2[{{.*}}] : memref<10xf32>
+  // CHECK:          store {{.*}}, %arg2[{{.*}}] : memref<10xf32>
+  // CHECK:          store {{.*}}, %arg2[{{.*}}] : memref<10xf32>
+  // CHECK-NOT:      store
+  // CHECK:        }
+  // CHECK-NEXT: }
+  // CHECK-NEXT: affine.for %i2 = 8 to 10 {
+  // CHECK-NEXT:   affine.for %i3 = 0 to 16 {
+  affine.for %i = 0 to 10 {
+    affine.for %j = 0 to 16 {
+      %a = load %A[%i, %j] : memref<10x16xf32>
+      %v = load %x[%j] : memref<16xf32>
+      %w = load %y[%i] : memref<10xf32>
+      %p = mulf %a, %v : f32
+      %s = addf %w, %p : f32
+      store %s, %y[%i] : memref<10xf32>
+    }
+  }
+  return
+}
+
+// Without any value reused across the copies, nothing is unroll-jammed.
+// CHECK-LABEL: func @no_reuse
+func @no_reuse(%A: memref<16x16xf32>, %B: memref<16x16xf32>) {
+  // CHECK:      affine.for %i0 = 0 to 16 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 16 {
+  affine.for %i = 0 to 16 {
+    affine.for %j = 0 to 16 {
+      %a = load %A[%i, %j] : memref<16x16xf32>
+      store %a, %B[%i, %j] : memref<16x16xf32>
+    }
+  }
+  return
+}
+
+// Jamming the copies of the i loop would reverse the dependence of distance
+// (1, -1) on A.
+// CHECK-LABEL: func @no_unroll_jam_dependence
+func @no_unroll_jam_dependence(%A: memref<17x17xf32>, %x: memref<16xf32>) {
+  // CHECK:      affine.for %i0 = 1 to 16 {
+  // CHECK-NEXT:   affine.for %i1 = 0 to 16 {
+  affine.for %i = 1 to 16 {
+    affine.for %j = 0 to 16 {
+      %im1 = affine.apply (d0) -> (d0 - 1)(%i)
+      %jp1 = affine.apply (d0) -> (d0 + 1)(%j)
+      %a = load %A[%im1, %jp1] : memref<17x17xf32>
+      %v = load %x[%j] : memref<16xf32>
+      %s = addf %a, %v : f32
+      store %s, %A[%i, %j] : memref<17x17xf32>
+    }
+  }
+  return
+}
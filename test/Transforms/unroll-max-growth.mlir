@@ -0,0 +1,27 @@
+// RUN: mlir-opt %s -loop-unroll -unroll-full -unroll-max-growth=5 | FileCheck %s
+
+// The full unrolling of the first loop adds three copies of its body to the
+// function, the one of the second loop would exceed the remaining budget.
+
+// CHECK-LABEL: func @growth_budget
+func @growth_budget() {
+  // CHECK-NEXT: %c0 = constant 0 : index
+  // CHECK-NEXT: "foo"(%c0) : (index) -> ()
+  // CHECK-NEXT: %0 = affine.apply
+  // CHECK-NEXT: "foo"(%0) : (index) -> ()
+  // CHECK-NEXT: %1 = affine.apply
+  // CHECK-NEXT: "foo"(%1) : (index) -> ()
+  // CHECK-NEXT: %2 = affine.apply
+  // CHECK-NEXT: "foo"(%2) : (index) -> ()
+  affine.for %i = 0 to 4 {
+    "foo"(%i) : (index) -> ()
+  }
+  // CHECK-NEXT: affine.for %i0 = 0 to 4 {
+  // CHECK-NEXT:   "bar"(%i0) : (index) -> ()
+  // CHECK-NEXT: }
+  affine.for %j = 0 to 4 {
+    "bar"(%j) : (index) -> ()
+  }
+  // CHECK-NEXT: return
+  return
+}
@@ -2,6 +2,7 @@
 // RUN: mlir-opt %s -loop-unroll -unroll-full -unroll-full-threshold=2 | FileCheck %s --check-prefix SHORT
 // RUN: mlir-opt %s -loop-unroll -unroll-factor=4 | FileCheck %s --check-prefix UNROLL-BY-4
 // RUN: mlir-opt %s -loop-unroll -unroll-factor=1 | FileCheck %s --check-prefix UNROLL-BY-1
+// RUN: mlir-opt %s -loop-unroll -unroll-factor=4 -unroll-version | FileCheck %s --check-prefix UNROLL-VERSION
 
 // UNROLL-FULL-DAG: [[MAP0:#map[0-9]+]] = (d0) -> (d0 + 1)
 // UNROLL-FULL-DAG: [[MAP1:#map[0-9]+]] = (d0) -> (d0 + 2)
@@ -10,6 +11,7 @@
 // UNROLL-FULL-DAG: [[MAP4:#map[0-9]+]] = (d0, d1) -> (d0 + 1)
 // UNROLL-FULL-DAG: [[MAP5:#map[0-9]+]] = (d0, d1) -> (d0 + 3)
 // UNROLL-FULL-DAG: [[MAP6:#map[0-9]+]] = (d0)[s0] -> (d0 + s0 + 1)
+// UNROLL-FULL-DAG: [[MAP_TIMES_2_PLUS_2:#map[0-9]+]] = (d0) -> (d0 * 2 + 2)
 
 // SHORT-DAG: [[MAP0:#map[0-9]+]] = (d0) -> (d0 + 1)
 
@@ -21,6 +23,8 @@
 // UNROLL-BY-4-DAG: [[MAP5:#map[0-9]+]] = (d0)[s0] -> (d0 + s0 + 1)
 // UNROLL-BY-4-DAG: [[MAP6:#map[0-9]+]] = (d0, d1) -> (d0 * 16 + d1)
 // UNROLL-BY-4-DAG: [[MAP11:#map[0-9]+]] = (d0) -> (d0)
+// UNROLL-VERSION-DAG: [[SET_MULTIPLE_FOUR:#set[0-9]+]] = ()[s0] : (s0 mod 4 == 0)
+
 // UNROLL-BY-4-DAG: [[MAP_TRIP_COUNT_MULTIPLE_FOUR:#map[0-9]+]] = ()[s0, s1, s2] -> (s0 + ((-s0 + s1) floordiv 4) * 4, s0 + ((-s0 + s2) floordiv 4) * 4, s0 + ((-s0 + 1024) floordiv 4) * 4)
 
 // UNROLL-FULL-LABEL: func @loop_nest_simplest() {
@@ -568,3 +572,45 @@ func @unroll_by_one_should_promote_single_iteration_loop() {
 // UNROLL-BY-1-NEXT: %0 = "foo"(%c0) : (index) -> i32
 // UNROLL-BY-1-NEXT: return
 }
+
+// The fast version has no cleanup loop; the fallback is left as is.
+// UNROLL-VERSION-LABEL: func @unroll_version_symbolic_bound(%arg0: index) {
+func @unroll_version_symbolic_bound(%N : index) {
+  affine.for %i = 0 to %N {
+    %x = "foo"(%i) : (index) -> i32
+  }
+  return
+// UNROLL-VERSION-NEXT:  affine.if [[SET_MULTIPLE_FOUR]]()[%arg0] {
+// UNROLL-VERSION-NEXT:    affine.for %i0 = 0 to %arg0 step 4 {
+// UNROLL-VERSION-NEXT:      "foo"(%i0) : (index) -> i32
+// UNROLL-VERSION-NEXT:      affine.apply
+// UNROLL-VERSION-NEXT:      "foo"
+// UNROLL-VERSION-NEXT:      affine.apply
+// UNROLL-VERSION-NEXT:      "foo"
+// UNROLL-VERSION-NEXT:      affine.apply
+// UNROLL-VERSION-NEXT:      "foo"
+// UNROLL-VERSION-NEXT:    }
+// UNROLL-VERSION-NEXT:  } else {
+// UNROLL-VERSION-NEXT:    affine.for %i1 = 0 to %arg0 {
+// UNROLL-VERSION-NEXT:      "foo"(%i1) : (index) -> i32
+// UNROLL-VERSION-NEXT:    }
+// UNROLL-VERSION-NEXT:  }
+// UNROLL-VERSION-NEXT:  return
+}
+
+// The lower bound of a promoted loop is composed with the affine.apply
+// supplying its operand.
+// UNROLL-FULL-LABEL: func @promote_composed_lower_bound() {
+func @promote_composed_lower_bound() {
+  // UNROLL-FULL: affine.for %i0 = 0 to 8 {
+  affine.for %i = 0 to 8 {
+    // UNROLL-FULL-NEXT: %0 = affine.apply [[MAP0]](%i0)
+    %x = affine.apply (d0) -> (d0 + 1)(%i)
+    // UNROLL-FULL-NEXT: %1 = affine.apply [[MAP_TIMES_2_PLUS_2]](%i0)
+    // UNROLL-FULL-NEXT: "foo"(%1) : (index) -> ()
+    affine.for %j = (d0) -> (d0 * 2)(%x) to (d0) -> (d0 * 2 + 1)(%x) {
+      "foo"(%j) : (index) -> ()
+    }
+  }
+  return
+}
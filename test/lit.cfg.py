@@ -21,7 +21,7 @@ config.name = 'MLIR'
 config.test_format = lit.formats.ShTest(not llvm_config.use_lit_shell)
 
 # suffixes: A list of file extensions to treat as test files.
-config.suffixes = ['.td', '.mlir', '.toy']
+config.suffixes = ['.td', '.mlir', '.toy', '.ll']
 
 # test_source_root: The root path where tests are located.
 config.test_source_root = os.path.dirname(__file__)
@@ -52,14 +52,25 @@ llvm_config.with_environment('PATH', config.llvm_tools_dir, append_path=True)
 
 tool_dirs = [config.mlir_tools_dir, config.llvm_tools_dir]
 tools = [
-    'mlir-opt', 'mlir-tblgen', 'mlir-translate',
+    'mlir-affine-bench', 'mlir-ir-bench', 'mlir-opt', 'mlir-quant-bench',
+    'mlir-tblgen', 'mlir-translate',
 ]
 
 # The following tools are optional
 tools.extend([
+    ToolSubst('linalg-bench', unresolved='ignore'),
+    ToolSubst('linalg1-conversion', unresolved='ignore'),
+    ToolSubst('linalg1-example', unresolved='ignore'),
+    ToolSubst('linalg2-example', unresolved='ignore'),
+    ToolSubst('linalg3-conversion', unresolved='ignore'),
+    ToolSubst('linalg3-example', unresolved='ignore'),
+    ToolSubst('linalg3-execution', unresolved='ignore'),
+    ToolSubst('linalg4-example', unresolved='ignore'),
     ToolSubst('toy-ch1', unresolved='ignore'),
     ToolSubst('toy-ch2', unresolved='ignore'),
     ToolSubst('toy-ch3', unresolved='ignore'),
+    ToolSubst('toy-ch4', unresolved='ignore'),
+    ToolSubst('toy-ch5', unresolved='ignore'),
 ])
 
 llvm_config.add_tool_substitutions(tools, tool_dirs)
@@ -0,0 +1,42 @@
+// A direct 3x3 convolution in the NCHW layout, whose input accesses combine
+// the output and the filter indices.
+#add = (d0, d1) -> (d0 + d1)
+
+func @conv2d(%input: memref<1x32x58x58xf32>, %filter: memref<64x32x3x3xf32>,
+             %output: memref<1x64x56x56xf32>) {
+  %zero = constant 0.0 : f32
+  affine.for %n0 = 0 to 1 {
+    affine.for %oc0 = 0 to 64 {
+      affine.for %oh0 = 0 to 56 {
+        affine.for %ow0 = 0 to 56 {
+          store %zero, %output[%n0, %oc0, %oh0, %ow0]
+              : memref<1x64x56x56xf32>
+        }
+      }
+    }
+  }
+  affine.for %n = 0 to 1 {
+    affine.for %oc = 0 to 64 {
+      affine.for %oh = 0 to 56 {
+        affine.for %ow = 0 to 56 {
+          affine.for %ic = 0 to 32 {
+            affine.for %kh = 0 to 3 {
+              affine.for %kw = 0 to 3 {
+                %h = affine.apply #add(%oh, %kh)
+                %w = affine.apply #add(%ow, %kw)
+                %x = load %input[%n, %ic, %h, %w] : memref<1x32x58x58xf32>
+                %f = load %filter[%oc, %ic, %kh, %kw] : memref<64x32x3x3xf32>
+                %acc = load %output[%n, %oc, %oh, %ow]
+                    : memref<1x64x56x56xf32>
+                %p = mulf %x, %f : f32
+                %s = addf %acc, %p : f32
+                store %s, %output[%n, %oc, %oh, %ow] : memref<1x64x56x56xf32>
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return
+}
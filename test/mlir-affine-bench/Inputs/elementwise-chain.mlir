@@ -0,0 +1,54 @@
+// A chain of elementwise operations through temporary buffers, each produced
+// by one nest and consumed by the next ones, as left by the lowering of a
+// sequence of tensor operations.
+func @elementwise_chain(%A: memref<128x1024xf32>, %B: memref<128x1024xf32>,
+                        %out: memref<128x1024xf32>) {
+  %t0 = alloc() : memref<128x1024xf32>
+  %t1 = alloc() : memref<128x1024xf32>
+  %t2 = alloc() : memref<128x1024xf32>
+  %t3 = alloc() : memref<128x1024xf32>
+  affine.for %i0 = 0 to 128 {
+    affine.for %j0 = 0 to 1024 {
+      %a0 = load %A[%i0, %j0] : memref<128x1024xf32>
+      %b0 = load %B[%i0, %j0] : memref<128x1024xf32>
+      %r0 = addf %a0, %b0 : f32
+      store %r0, %t0[%i0, %j0] : memref<128x1024xf32>
+    }
+  }
+  affine.for %i1 = 0 to 128 {
+    affine.for %j1 = 0 to 1024 {
+      %a1 = load %A[%i1, %j1] : memref<128x1024xf32>
+      %v1 = load %t0[%i1, %j1] : memref<128x1024xf32>
+      %r1 = mulf %v1, %a1 : f32
+      store %r1, %t1[%i1, %j1] : memref<128x1024xf32>
+    }
+  }
+  affine.for %i2 = 0 to 128 {
+    affine.for %j2 = 0 to 1024 {
+      %b2 = load %B[%i2, %j2] : memref<128x1024xf32>
+      %v2 = load %t1[%i2, %j2] : memref<128x1024xf32>
+      %r2 = subf %v2, %b2 : f32
+      store %r2, %t2[%i2, %j2] : memref<128x1024xf32>
+    }
+  }
+  affine.for %i3 = 0 to 128 {
+    affine.for %j3 = 0 to 1024 {
+      %v3 = load %t2[%i3, %j3] : memref<128x1024xf32>
+      %r3 = mulf %v3, %v3 : f32
+      store %r3, %t3[%i3, %j3] : memref<128x1024xf32>
+    }
+  }
+  affine.for %i4 = 0 to 128 {
+    affine.for %j4 = 0 to 1024 {
+      %u4 = load %t0[%i4, %j4] : memref<128x1024xf32>
+      %v4 = load %t3[%i4, %j4] : memref<128x1024xf32>
+      %r4 = addf %u4, %v4 : f32
+      store %r4, %out[%i4, %j4] : memref<128x1024xf32>
+    }
+  }
+  dealloc %t3 : memref<128x1024xf32>
+  dealloc %t2 : memref<128x1024xf32>
+  dealloc %t1 : memref<128x1024xf32>
+  dealloc %t0 : memref<128x1024xf32>
+  return
+}
@@ -0,0 +1,18 @@
+// A naive matrix multiplication, a deep reduction nest with a reuse of each
+// operand along one of the loops.
+func @matmul(%A: memref<256x256xf32>, %B: memref<256x256xf32>,
+             %C: memref<256x256xf32>) {
+  affine.for %i = 0 to 256 {
+    affine.for %j = 0 to 256 {
+      affine.for %k = 0 to 256 {
+        %a = load %A[%i, %k] : memref<256x256xf32>
+        %b = load %B[%k, %j] : memref<256x256xf32>
+        %c = load %C[%i, %j] : memref<256x256xf32>
+        %p = mulf %a, %b : f32
+        %s = addf %c, %p : f32
+        store %s, %C[%i, %j] : memref<256x256xf32>
+      }
+    }
+  }
+  return
+}
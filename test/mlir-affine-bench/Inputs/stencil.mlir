@@ -0,0 +1,36 @@
+// Time steps of a 5-point Jacobi stencil, each followed by a copy back of the
+// updated grid, with accesses shifted by one in each direction.
+#minus1 = (d0) -> (d0 - 1)
+#plus1 = (d0) -> (d0 + 1)
+
+func @jacobi_2d(%A: memref<512x512xf32>, %B: memref<512x512xf32>) {
+  %fifth = constant 0.2 : f32
+  affine.for %t = 0 to 8 {
+    affine.for %i = 1 to 511 {
+      affine.for %j = 1 to 511 {
+        %im1 = affine.apply #minus1(%i)
+        %ip1 = affine.apply #plus1(%i)
+        %jm1 = affine.apply #minus1(%j)
+        %jp1 = affine.apply #plus1(%j)
+        %c = load %A[%i, %j] : memref<512x512xf32>
+        %n = load %A[%im1, %j] : memref<512x512xf32>
+        %s = load %A[%ip1, %j] : memref<512x512xf32>
+        %w = load %A[%i, %jm1] : memref<512x512xf32>
+        %e = load %A[%i, %jp1] : memref<512x512xf32>
+        %0 = addf %c, %n : f32
+        %1 = addf %0, %s : f32
+        %2 = addf %1, %w : f32
+        %3 = addf %2, %e : f32
+        %4 = mulf %3, %fifth : f32
+        store %4, %B[%i, %j] : memref<512x512xf32>
+      }
+    }
+    affine.for %ci = 1 to 511 {
+      affine.for %cj = 1 to 511 {
+        %v = load %B[%ci, %cj] : memref<512x512xf32>
+        store %v, %A[%ci, %cj] : memref<512x512xf32>
+      }
+    }
+  }
+  return
+}
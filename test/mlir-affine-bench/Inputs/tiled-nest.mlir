@@ -0,0 +1,34 @@
+// A matrix multiplication tiled twice by hand, with partial tiles bounded by
+// a min, which gives six-deep nests with non-rectangular bounds.
+#id = (d0) -> (d0)
+#tile = (d0) -> (d0 + 64, 250)
+#subtile = (d0) -> (d0 + 8, 250)
+
+func @tiled_matmul(%A: memref<250x250xf32>, %B: memref<250x250xf32>,
+                   %C: memref<250x250xf32>) {
+  affine.for %it = 0 to 250 step 64 {
+    affine.for %jt = 0 to 250 step 64 {
+      affine.for %kt = 0 to 250 step 64 {
+        affine.for %is = #id(%it) to min #tile(%it) step 8 {
+          affine.for %js = #id(%jt) to min #tile(%jt) step 8 {
+            affine.for %ks = #id(%kt) to min #tile(%kt) step 8 {
+              affine.for %i = #id(%is) to min #subtile(%is) {
+                affine.for %j = #id(%js) to min #subtile(%js) {
+                  affine.for %k = #id(%ks) to min #subtile(%ks) {
+                    %a = load %A[%i, %k] : memref<250x250xf32>
+                    %b = load %B[%k, %j] : memref<250x250xf32>
+                    %c = load %C[%i, %j] : memref<250x250xf32>
+                    %p = mulf %a, %b : f32
+                    %s = addf %c, %p : f32
+                    store %s, %C[%i, %j] : memref<250x250xf32>
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return
+}
@@ -0,0 +1,28 @@
+// RUN: mlir-affine-bench %S/Inputs/matmul.mlir %S/Inputs/conv2d.mlir %S/Inputs/stencil.mlir %S/Inputs/tiled-nest.mlir %S/Inputs/elementwise-chain.mlir -warmup=0 -iterations=1 -virtual-vector-size=128 | FileCheck %s
+// RUN: mlir-affine-bench %S/Inputs/matmul.mlir %S/Inputs/stencil.mlir -warmup=0 -iterations=1 -passes=loop-fusion,loop-tile -filter=stencil | FileCheck %s --check-prefix=FILTER
+
+// The keys of the reports are printed in sorted order, so the work done by the
+// FlatAffineConstraints of a benchmark comes before its name.
+
+// CHECK:      "emptiness_checks": {{[1-9][0-9]*}}
+// CHECK:      "input": "matmul"
+// CHECK:      "name": "matmul/memref-dependence-check"
+// CHECK-NEXT: "pass": "memref-dependence-check"
+// CHECK:      "name": "matmul/loop-fusion"
+// CHECK:      "name": "matmul/loop-tile"
+// CHECK:      "name": "matmul/dma-generate"
+// CHECK:      "name": "matmul/vectorize"
+// CHECK:      "name": "conv2d/memref-dependence-check"
+// CHECK:      "name": "conv2d/vectorize"
+// CHECK:      "name": "stencil/memref-dependence-check"
+// CHECK:      "name": "stencil/vectorize"
+// CHECK:      "name": "tiled-nest/memref-dependence-check"
+// CHECK:      "name": "tiled-nest/vectorize"
+// CHECK:      "name": "elementwise-chain/memref-dependence-check"
+// CHECK:      "name": "elementwise-chain/loop-fusion"
+// CHECK:      "name": "elementwise-chain/vectorize"
+
+// FILTER-NOT: "name": "matmul
+// FILTER:     "name": "stencil/loop-fusion"
+// FILTER:     "name": "stencil/loop-tile"
+// FILTER-NOT: "name"
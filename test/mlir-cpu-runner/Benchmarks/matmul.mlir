@@ -0,0 +1,32 @@
+// RUN: mlir-cpu-runner %s -benchmark -benchmark-warmup=0 -benchmark-iterations=1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -mlir-passes=loop-tile -tile-size=32 -O3 -benchmark -benchmark-warmup=0 -benchmark-iterations=1 | FileCheck %s
+
+// The configurations timed by utils/benchmark/run_cpu_runner_benchmarks.py.
+// BENCHMARK: -O3
+// BENCHMARK: -mlir-passes=loop-tile -tile-size=32 -O3
+// BENCHMARK: -mlir-passes=loop-tile -tile-size=32 -O3 -loop-vectorize
+
+// A naive matrix multiplication accumulating into its last argument.
+func @main(%A: memref<256x256xf32>, %B: memref<256x256xf32>,
+           %C: memref<256x256xf32>) {
+  affine.for %i = 0 to 256 {
+    affine.for %j = 0 to 256 {
+      affine.for %k = 0 to 256 {
+        %a = load %A[%i, %k] : memref<256x256xf32>
+        %b = load %B[%k, %j] : memref<256x256xf32>
+        %c = load %C[%i, %j] : memref<256x256xf32>
+        %p = mulf %a, %b : f32
+        %s = addf %c, %p : f32
+        store %s, %C[%i, %j] : memref<256x256xf32>
+      }
+    }
+  }
+  return
+}
+
+// CHECK: "compile": {
+// CHECK: "mlir_passes_ms":
+// CHECK: "parse_ms":
+// CHECK: "execution": {
+// CHECK: "iterations": 1
+// CHECK: "input": "{{.*}}matmul.mlir"
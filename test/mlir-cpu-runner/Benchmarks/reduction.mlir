@@ -0,0 +1,24 @@
+// RUN: mlir-cpu-runner %s -benchmark -benchmark-warmup=0 -benchmark-iterations=1 | FileCheck %s
+
+// The configurations timed by utils/benchmark/run_cpu_runner_benchmarks.py.
+// BENCHMARK: -O3
+// BENCHMARK: -O3 -fast-math -loop-vectorize
+
+// The sum of the elements of a vector, a loop-carried dependence through
+// memory that only vectorizes with reassociation.
+func @main(%a: memref<1048576xf32>, %sum: memref<1xf32>) {
+  %c0 = constant 0 : index
+  %zero = constant 0.0 : f32
+  store %zero, %sum[%c0] : memref<1xf32>
+  affine.for %i = 0 to 1048576 {
+    %0 = load %a[%i] : memref<1048576xf32>
+    %1 = load %sum[%c0] : memref<1xf32>
+    %2 = addf %1, %0 : f32
+    store %2, %sum[%c0] : memref<1xf32>
+  }
+  return
+}
+
+// CHECK: "execution": {
+// CHECK: "iterations": 1
+// CHECK: "input": "{{.*}}reduction.mlir"
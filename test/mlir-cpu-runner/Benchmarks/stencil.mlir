@@ -0,0 +1,38 @@
+// RUN: mlir-cpu-runner %s -benchmark -benchmark-warmup=0 -benchmark-iterations=1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -mlir-passes=outline-parallel-loops -O3 -benchmark -benchmark-warmup=0 -benchmark-iterations=1 | FileCheck %s
+
+// The configurations timed by utils/benchmark/run_cpu_runner_benchmarks.py.
+// BENCHMARK: -O3
+// BENCHMARK: -mlir-passes=outline-parallel-loops -O3
+
+#minus1 = (d0) -> (d0 - 1)
+#plus1 = (d0) -> (d0 + 1)
+
+// A 5-point Jacobi stencil over a 1024x1024 grid.
+func @main(%A: memref<1024x1024xf32>, %B: memref<1024x1024xf32>) {
+  %fifth = constant 0.2 : f32
+  affine.for %i = 1 to 1023 {
+    affine.for %j = 1 to 1023 {
+      %im1 = affine.apply #minus1(%i)
+      %ip1 = affine.apply #plus1(%i)
+      %jm1 = affine.apply #minus1(%j)
+      %jp1 = affine.apply #plus1(%j)
+      %c = load %A[%i, %j] : memref<1024x1024xf32>
+      %n = load %A[%im1, %j] : memref<1024x1024xf32>
+      %s = load %A[%ip1, %j] : memref<1024x1024xf32>
+      %w = load %A[%i, %jm1] : memref<1024x1024xf32>
+      %e = load %A[%i, %jp1] : memref<1024x1024xf32>
+      %0 = addf %c, %n : f32
+      %1 = addf %0, %s : f32
+      %2 = addf %1, %w : f32
+      %3 = addf %2, %e : f32
+      %4 = mulf %3, %fifth : f32
+      store %4, %B[%i, %j] : memref<1024x1024xf32>
+    }
+  }
+  return
+}
+
+// CHECK: "execution": {
+// CHECK: "iterations": 1
+// CHECK: "input": "{{.*}}stencil.mlir"
@@ -0,0 +1,23 @@
+// RUN: mlir-cpu-runner %s -mlir-passes=annotate-memref-bounds -memref-bounds-runtime-checks -init-value 1 | FileCheck %s
+// RUN: not mlir-cpu-runner %s -mlir-passes=annotate-memref-bounds -memref-bounds-runtime-checks -init-value 1 -e overrun 2>&1 | FileCheck %s --check-prefix=OVERRUN
+
+// The accesses proven in bounds run unchecked.
+func @main(%a : memref<16xf32>) {
+  %cst = constant 2.0 : f32
+  affine.for %i = 0 to 16 {
+    store %cst, %a[%i] : memref<16xf32>
+  }
+  return
+}
+// CHECK: {{^(1\.000000e\+00 )+$}}
+// CHECK-NEXT: {{^(2\.000000e\+00 )+$}}
+
+// The checked accesses abort the execution on the first index out of bounds.
+func @overrun(%a : memref<16xf32>) {
+  %cst = constant 2.0 : f32
+  affine.for %i = 0 to 17 {
+    store %cst, %a[%i] : memref<16xf32>
+  }
+  return
+}
+// OVERRUN: memref index 16 is out of bounds for a dimension of size 16
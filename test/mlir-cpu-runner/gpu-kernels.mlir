@@ -0,0 +1,16 @@
+// RUN: mlir-cpu-runner %s -mlir-passes=outline-gpu-kernels -init-value 1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -mlir-passes=outline-gpu-kernels -init-value 1 -O3 | FileCheck %s
+
+// Without -gpu, the kernels are executed on the host, one block per thread of
+// the parallel runtime.  The 4100 iterations leave the last block partial.
+func @main(%a : memref<4100xf32>, %b : memref<4100xf32>) {
+  %cst = constant 2.0 : f32
+  affine.for %i = 0 to 4100 {
+    %0 = load %a[%i] : memref<4100xf32>
+    %1 = mulf %0, %cst : f32
+    store %1, %b[%i] : memref<4100xf32>
+  }
+  return
+}
+// CHECK: {{^(1\.000000e\+00 )+$}}
+// CHECK-NEXT: {{^(2\.000000e\+00 )+$}}
@@ -0,0 +1,67 @@
+// RUN: mlir-cpu-runner %s -init-value 1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -init-value 1 -O3 | FileCheck %s
+
+// The declarations are defined by the math runtime of the ExecutionEngine.
+func @mlir_expf(f32) -> f32
+func @mlir_logf(f32) -> f32
+func @mlir_tanhf(f32) -> f32
+func @mlir_expf8(vector<8xf32>) -> vector<8xf32>
+func @mlir_tanhf8(vector<8xf32>) -> vector<8xf32>
+
+func @main(%a : memref<3xf32>, %s : memref<4xf32>, %v : memref<8xf32>, %t : memref<8xf32>) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %c2 = constant 2 : index
+  %c3 = constant 3 : index
+  %c4 = constant 4 : index
+  %c5 = constant 5 : index
+  %c6 = constant 6 : index
+  %c7 = constant 7 : index
+  %0 = load %a[%c0] : memref<3xf32>
+  %1 = call @mlir_expf(%0) : (f32) -> f32
+  %2 = call @mlir_logf(%0) : (f32) -> f32
+  %3 = call @mlir_tanhf(%0) : (f32) -> f32
+  store %1, %a[%c0] : memref<3xf32>
+  store %2, %a[%c1] : memref<3xf32>
+  store %3, %a[%c2] : memref<3xf32>
+
+  // The special values: NaN, and the bounds of the arguments of exp whose
+  // results are finite, beyond which the arguments are clamped.
+  %zero = constant 0.0 : f32
+  %nan = divf %zero, %zero : f32
+  %max = constant 88.3762 : f32
+  %min = constant -88.3762 : f32
+  %large = constant 100.0 : f32
+  %small = constant -100.0 : f32
+  %one = constant 1.0 : f32
+  %minusOne = constant -1.0 : f32
+
+  %4 = call @mlir_expf(%nan) : (f32) -> f32
+  %5 = call @mlir_expf(%max) : (f32) -> f32
+  %6 = call @mlir_expf(%min) : (f32) -> f32
+  %7 = call @mlir_tanhf(%nan) : (f32) -> f32
+  store %4, %s[%c0] : memref<4xf32>
+  store %5, %s[%c1] : memref<4xf32>
+  store %6, %s[%c2] : memref<4xf32>
+  store %7, %s[%c3] : memref<4xf32>
+
+  // The same values, and a few regular ones, in the lanes of a vector.
+  store %nan, %v[%c0] : memref<8xf32>
+  store %max, %v[%c1] : memref<8xf32>
+  store %min, %v[%c2] : memref<8xf32>
+  store %large, %v[%c3] : memref<8xf32>
+  store %small, %v[%c4] : memref<8xf32>
+  store %one, %v[%c5] : memref<8xf32>
+  store %minusOne, %v[%c6] : memref<8xf32>
+  store %zero, %v[%c7] : memref<8xf32>
+  %8 = vector.transfer_read %v[%c0] {permutation_map: (d0) -> (d0)} : memref<8xf32>, vector<8xf32>
+  %9 = call @mlir_expf8(%8) : (vector<8xf32>) -> vector<8xf32>
+  %10 = call @mlir_tanhf8(%8) : (vector<8xf32>) -> vector<8xf32>
+  vector.transfer_write %9, %v[%c0] {permutation_map: (d0) -> (d0)} : vector<8xf32>, memref<8xf32>
+  vector.transfer_write %10, %t[%c0] {permutation_map: (d0) -> (d0)} : vector<8xf32>, memref<8xf32>
+  return
+}
+// CHECK: 2.71828{{[0-9]}}e+00 {{-?}}0.000000e+00 7.6159{{[0-9]+}}e-01
+// CHECK-NEXT: {{-?}}nan 2.4059{{[0-9]+}}e+38 4.1562{{[0-9]+}}e-39 {{-?}}nan
+// CHECK-NEXT: {{-?}}nan 2.4059{{[0-9]+}}e+38 4.1562{{[0-9]+}}e-39 2.4061{{[0-9]+}}e+38 4.1560{{[0-9]+}}e-39 2.71828{{[0-9]}}e+00 3.67879{{[0-9]}}e-01 1.000000e+00
+// CHECK-NEXT: {{-?}}nan 1.000000e+00 -1.000000e+00 1.000000e+00 -1.000000e+00 7.6159{{[0-9]+}}e-01 -7.6159{{[0-9]+}}e-01 0.000000e+00
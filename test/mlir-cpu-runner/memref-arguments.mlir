@@ -0,0 +1,32 @@
+// RUN: mlir-cpu-runner %s -init-value 3 -dynamic-sizes=2 | FileCheck %s
+// RUN: echo 2 > %t.shape
+// RUN: mlir-cpu-runner %s -init-value 3 -shape-file=%t.shape | FileCheck %s
+// RUN: mlir-cpu-runner %s -init-value 3 -dynamic-sizes=2 -output-prefix=%t.
+// RUN: wc -c < %t.arg0.bin | FileCheck -check-prefix=ARG0 %s
+// RUN: wc -c < %t.arg1.bin | FileCheck -check-prefix=ARG1 %s
+// RUN: mlir-cpu-runner %s -dynamic-sizes=2 -input-files=%t.arg0.bin | FileCheck -check-prefix=INPUT %s
+// RUN: not mlir-cpu-runner %s 2>&1 | FileCheck -check-prefix=NOSIZES %s
+
+func @main(%a : memref<?xi32>, %b : memref<2xf64>) {
+  %c0 = constant 0 : index
+  %c1 = constant 1 : index
+  %0 = load %a[%c0] : memref<?xi32>
+  %1 = addi %0, %0 : i32
+  store %1, %a[%c1] : memref<?xi32>
+  %2 = load %b[%c0] : memref<2xf64>
+  %3 = addf %2, %2 : f64
+  store %3, %b[%c1] : memref<2xf64>
+  return
+}
+// CHECK: 3 6
+// CHECK-NEXT: 3.000000e+00 6.000000e+00
+
+// ARG0: 8
+// ARG1: 16
+
+// The first argument is read from the output of the previous run, the second
+// one is initialized with the default value.
+// INPUT: 3 6
+// INPUT-NEXT: 0.000000e+00 0.000000e+00
+
+// NOSIZES: expected 1 more dynamic memref sizes
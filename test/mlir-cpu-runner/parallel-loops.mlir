@@ -0,0 +1,15 @@
+// RUN: mlir-cpu-runner %s -mlir-passes=outline-parallel-loops -init-value 1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -mlir-passes=outline-parallel-loops -init-value 1 -O3 | FileCheck %s
+
+// The iterations are distributed over the threads of the parallel runtime.
+func @main(%a : memref<4096xf32>, %b : memref<4096xf32>) {
+  %cst = constant 2.0 : f32
+  affine.for %i = 0 to 4096 {
+    %0 = load %a[%i] : memref<4096xf32>
+    %1 = mulf %0, %cst : f32
+    store %1, %b[%i] : memref<4096xf32>
+  }
+  return
+}
+// CHECK: {{^(1\.000000e\+00 )+$}}
+// CHECK-NEXT: {{^(2\.000000e\+00 )+$}}
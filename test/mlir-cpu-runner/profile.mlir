@@ -0,0 +1,23 @@
+// RUN: mlir-cpu-runner %s -mlir-passes=instrument-loops -init-value 1 2>&1 | FileCheck %s
+// RUN: mlir-cpu-runner %s -mlir-passes=instrument-loops -init-value 1 -O3 2>&1 | FileCheck %s
+// RUN: not mlir-cpu-runner %s -mlir-passes=no-such-pass 2>&1 | FileCheck -check-prefix=UNKNOWN %s
+
+// The profile printed at exit counts the entries into each loop and function,
+// and the iterations of the loops.
+func @main(%a : memref<8x4xf32>, %b : memref<8x4xf32>) {
+  %cst = constant 2.0 : f32
+  affine.for %i = 0 to 8 {
+    affine.for %j = 0 to 4 step 3 {
+      %0 = load %a[%i, %j] : memref<8x4xf32>
+      %1 = mulf %0, %cst : f32
+      store %1, %b[%i, %j] : memref<8x4xf32>
+    }
+  }
+  return
+}
+// CHECK: ===- MLIR execution profile -===
+// CHECK-DAG: {{^ *[0-9]+\.[0-9]+ +1 +1  func @main .*profile.mlir:7:6$}}
+// CHECK-DAG: {{^ *[0-9]+\.[0-9]+ +1 +8  affine.for @main .*profile.mlir:9:3$}}
+// CHECK-DAG: {{^ *[0-9]+\.[0-9]+ +8 +16  affine.for @main .*profile.mlir:10:5$}}
+
+// UNKNOWN: unknown MLIR pass 'no-such-pass'
@@ -1,8 +1,29 @@
 // RUN: mlir-cpu-runner %s | FileCheck %s
 // RUN: mlir-cpu-runner -e foo -init-value 1000 %s | FileCheck -check-prefix=NOMAIN %s
 // RUN: mlir-cpu-runner %s -O3 | FileCheck %s
+// RUN: mlir-cpu-runner %s -fast-math | FileCheck %s
 // RUN: mlir-cpu-runner %s -O3 -loop-distribute -loop-vectorize | FileCheck %s
 // RUN: mlir-cpu-runner %s -loop-distribute -loop-vectorize | FileCheck %s
+// RUN: rm -rf %t.cache && mkdir -p %t.cache
+// RUN: mlir-cpu-runner %s -object-cache-dir=%t.cache | FileCheck %s
+// RUN: ls %t.cache | FileCheck -check-prefix=CACHE %s
+// RUN: mlir-cpu-runner %s -object-cache-dir=%t.cache | FileCheck %s
+// RUN: mlir-cpu-runner %s -O3 -object-cache-dir=%t.cache | FileCheck %s
+// RUN: mlir-cpu-runner %s -O3 -emit-object=%t.o
+// RUN: llvm-nm %t.o | FileCheck -check-prefix=OBJECT %s
+// RUN: mlir-cpu-runner %s -compile-threads=2 | FileCheck %s
+// RUN: mlir-cpu-runner %s -O3 -lazy-compile | FileCheck %s
+// RUN: mlir-cpu-runner -e foo -init-value 1000 -lazy-compile %s | FileCheck -check-prefix=NOMAIN %s
+// RUN: mlir-cpu-runner %s -O3 -lazy-translate | FileCheck %s
+// RUN: mlir-cpu-runner -e foo -init-value 1000 -lazy-translate %s | FileCheck -check-prefix=NOMAIN %s
+// RUN: mlir-cpu-runner %s -O3 -mcpu=generic | FileCheck %s
+// RUN: rm -f %t.map
+// RUN: mlir-cpu-runner %s -gdb-listener -perf-map-file=%t.map | FileCheck %s
+// RUN: FileCheck -check-prefix=PERFMAP %s < %t.map
+// RUN: mlir-cpu-runner %s -O3 -benchmark -benchmark-iterations=3 | FileCheck -check-prefix=BENCH %s
+// RUN: mlir-cpu-runner %s -O3 -tiered-compile | FileCheck %s
+// RUN: mlir-cpu-runner -e foo -init-value 1000 -O3 -tiered-compile -lazy-translate %s | FileCheck -check-prefix=NOMAIN %s
+// RUN: mlir-cpu-runner %s -O3 -tiered-compile -benchmark -benchmark-warmup=0 -benchmark-iterations=3 | FileCheck -check-prefix=TIERED %s
 
 func @fabsf(f32) -> f32
 
@@ -21,6 +42,30 @@ func @main(%a : memref<2xf32>, %b : memref<1xf32>) {
 // CHECK: 0.000000e+00 0.000000e+00
 // CHECK-NEXT: 4.200000e+02
 
+// The object cache holds one object per module and pipeline.
+// CACHE: {{^[0-9a-f]+\.o$}}
+
+// The emitted object file defines the packed wrappers.
+// OBJECT-DAG: T _mlir_foo
+// OBJECT-DAG: T _mlir_main
+
+// The perf map file names the JIT-compiled functions and their wrappers.
+// PERFMAP-DAG: {{^[0-9a-f]+ [0-9a-f]+ _?main$}}
+// PERFMAP-DAG: {{^[0-9a-f]+ [0-9a-f]+ _?_mlir_main$}}
+// PERFMAP-DAG: {{^[0-9a-f]+ [0-9a-f]+ _?foo$}}
+
+// The benchmark mode prints a JSON report instead of the results.
+// BENCH-NOT: 4.200000e+02
+// BENCH: "entry": "main"
+// BENCH: "execution": {
+// BENCH: "iterations": 3
+
+// The tiered benchmark mode reports how many executions ran the quick version.
+// TIERED: "entry": "main"
+// TIERED: "tiered": {
+// TIERED: "executions": 3
+// TIERED: "quick_executions": {{[0-3]}}
+
 func @foo(%a : memref<1x1xf32>) -> memref<1x1xf32> {
   %c0 = constant 0 : index
   %0 = constant 1234.0 : f32
@@ -0,0 +1,38 @@
+// RUN: mlir-ir-bench -num-ops=16 -num-contexts=2 -iterations=1 -max-threads=2 | FileCheck %s
+// RUN: mlir-ir-bench -num-ops=16 -num-contexts=2 -iterations=1 -max-threads=2 -filter=uniquing | FileCheck %s --check-prefix=FILTER
+// RUN: mlir-ir-bench -num-ops=16 -num-contexts=2 -iterations=1 -max-threads=2 -filter=parse | FileCheck %s --check-prefix=CONTEXT
+
+// The keys of the reports are printed in sorted order, so the items processed
+// by a benchmark come before its name.
+
+// CHECK: "items": 16
+// CHECK: "name": "op_create_erase"
+// CHECK: "items": 32
+// CHECK: "name": "use_list_rauw"
+// CHECK: "name": "block_insert_order_queries"
+// CHECK: "name": "type_uniquing_1_threads"
+// CHECK: "name": "attribute_uniquing_1_threads"
+// CHECK: "name": "affine_map_uniquing_1_threads"
+// CHECK: "items": 32
+// CHECK: "name": "type_uniquing_2_threads"
+// CHECK: "name": "attribute_uniquing_2_threads"
+// CHECK: "name": "affine_map_uniquing_2_threads"
+// CHECK: "name": "function_walk"
+// CHECK: "name": "function_clone"
+// CHECK: "items": 2,
+// CHECK: "name": "create_context"
+// CHECK: "name": "create_context_all_dialects"
+// CHECK: "name": "parse_in_new_context"
+// CHECK: "name": "parse_in_new_context_all_dialects"
+// CHECK: "name": "parse_in_storage_scope"
+
+// FILTER-NOT: "name": "op_
+// FILTER: "name": "type_uniquing_1_threads"
+// FILTER: "name": "affine_map_uniquing_2_threads"
+// FILTER-NOT: "name"
+
+// CONTEXT-NOT: "name": "create_context
+// CONTEXT: "name": "parse_in_new_context"
+// CONTEXT: "name": "parse_in_new_context_all_dialects"
+// CONTEXT: "name": "parse_in_storage_scope"
+// CONTEXT-NOT: "name"
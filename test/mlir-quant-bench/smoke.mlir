@@ -0,0 +1,22 @@
+// RUN: mlir-quant-bench -num-elements=4096 -num-types=16 -iterations=1 | FileCheck %s
+// RUN: mlir-quant-bench -num-elements=4096 -iterations=1 -filter=sparse | FileCheck %s --check-prefix=FILTER
+
+// CHECK: "name": "quantize_dense_fixedpoint"
+// CHECK: "name": "quantize_dense_affine"
+// CHECK: "name": "quantize_dense_per_axis"
+// CHECK: "name": "quantize_splat_fixedpoint"
+// CHECK: "name": "quantize_splat_per_axis"
+// CHECK: "name": "quantize_sparse_fixedpoint"
+// CHECK: "name": "quantize_sparse_affine"
+// CHECK: "name": "quantize_sparse_per_axis"
+// CHECK: "items": 16
+// CHECK: "name": "fake_quant_to_type"
+// CHECK: "name": "fake_quant_to_per_axis_type"
+// CHECK: "name": "parse_uniform_type"
+// CHECK: "name": "parse_uniform_per_axis_type"
+
+// FILTER-NOT: "name": "quantize_dense
+// FILTER: "name": "quantize_sparse_fixedpoint"
+// FILTER: "name": "quantize_sparse_affine"
+// FILTER: "name": "quantize_sparse_per_axis"
+// FILTER-NOT: "name"
@@ -0,0 +1,160 @@
+//===- mlir-affine-bench.cpp - Affine pass benchmarks ---------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This is a command line utility that times the affine passes, one at a time,
+// on each of its input files, and prints a JSON report of the timings along
+// with the work done by the FlatAffineConstraints of the passes, to track the
+// compile-time regressions of the polyhedral analyses.  The inputs are parsed
+// again before each run, outside of the timed region.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Analysis/AffineStructures.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/Benchmark.h"
+#include "mlir/Support/FileUtilities.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+
+static llvm::cl::list<std::string>
+    inputFilenames(llvm::cl::Positional, llvm::cl::OneOrMore,
+                   llvm::cl::desc("<input files>"));
+
+static llvm::cl::list<std::string> passNames(
+    "passes",
+    llvm::cl::desc("Comma-separated list of the passes to time, each on its "
+                   "own (default: memref-dependence-check, loop-fusion, "
+                   "loop-tile, dma-generate, vectorize)"),
+    llvm::cl::value_desc("<pass,...>"), llvm::cl::CommaSeparated);
+
+/// The passes timed when -passes is not given.
+static const char *const kDefaultPasses[] = {
+    "memref-dependence-check", "loop-fusion", "loop-tile", "dma-generate",
+    "vectorize"};
+
+namespace {
+/// The module of an input parsed in a new context, on which a pass is run.
+struct ParsedInput {
+  MLIRContext context;
+  std::unique_ptr<Module> module;
+  bool hadError = false;
+};
+} // end anonymous namespace
+
+// Add the benchmark named `name` running `pass` on the module of `input`,
+// whose `source` is parsed again before each run, outside of the timed
+// region.  The report of the benchmark includes the work done by the
+// FlatAffineConstraints in its last run.
+static void addPassBenchmark(std::vector<Benchmark> &benchmarks,
+                             StringRef name, StringRef input,
+                             const PassRegistryEntry *pass,
+                             std::shared_ptr<llvm::MemoryBuffer> source) {
+  // The input parsed for the next run, replaced before each run.
+  auto parsed = std::make_shared<std::unique_ptr<ParsedInput>>();
+  std::string inputName = input.str();
+
+  auto setUp = [=]() {
+    // The module is destroyed before the context it uses.
+    parsed->reset(new ParsedInput);
+    ParsedInput *state = parsed->get();
+    state->context.registerDiagnosticHandler(
+        [=](Location location, StringRef message,
+            MLIRContext::DiagnosticKind kind) {
+          // The notes and warnings of the analyses, e.g. the dependences found
+          // by -memref-dependence-check, are not of interest here.
+          if (kind != MLIRContext::DiagnosticKind::Error)
+            return;
+          state->hadError = true;
+          llvm::errs() << inputName << ": error: " << message << '\n';
+        });
+    state->module.reset(
+        parseSourceString(source->getBuffer(), &state->context));
+    resetFlatAffineConstraintsStats();
+    return state->module != nullptr;
+  };
+  auto run = [=]() {
+    ParsedInput *state = parsed->get();
+    PassManager pm(/*verifyPasses=*/false);
+    pass->addToPipeline(pm);
+    return succeeded(pm.run(state->module.get())) && !state->hadError;
+  };
+  auto addToReport = [=](llvm::json::Object &report) {
+    FlatAffineConstraintsStats stats = getFlatAffineConstraintsStats();
+    report["input"] = inputName;
+    report["pass"] = pass->getPassArgument();
+    report["gaussian_eliminations"] = int64_t(stats.numGaussianEliminations);
+    report["fourier_motzkin_eliminations"] =
+        int64_t(stats.numFourierMotzkinEliminations);
+    report["emptiness_checks"] = int64_t(stats.numEmptinessChecks);
+    report["max_constraints"] = int64_t(stats.maxNumConstraints);
+  };
+  benchmarks.push_back(
+      {name.str(), /*numItems=*/0, std::move(run), std::move(setUp),
+       std::move(addToReport)});
+}
+
+int main(int argc, char **argv) {
+  llvm::PrettyStackTraceProgram x(argc, argv);
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "MLIR affine pass benchmarks\n");
+
+  std::vector<const PassRegistryEntry *> passes;
+  std::vector<std::string> names(passNames.begin(), passNames.end());
+  if (names.empty())
+    names.assign(std::begin(kDefaultPasses), std::end(kDefaultPasses));
+  for (auto &name : names) {
+    const auto *entry = lookupPassRegistryEntry(name);
+    if (!entry) {
+      llvm::errs() << "unknown pass '" << name << "'\n";
+      return 1;
+    }
+    passes.push_back(entry);
+  }
+
+  std::vector<Benchmark> benchmarks;
+  for (auto &filename : inputFilenames) {
+    std::string errorMessage;
+    std::shared_ptr<llvm::MemoryBuffer> source =
+        openInputFile(filename, &errorMessage);
+    if (!source) {
+      llvm::errs() << errorMessage << '\n';
+      return 1;
+    }
+    StringRef input = llvm::sys::path::stem(filename);
+    for (const auto *pass : passes)
+      addPassBenchmark(
+          benchmarks,
+          llvm::formatv("{0}/{1}", input, pass->getPassArgument()).str(),
+          input, pass, source);
+  }
+
+  return failed(runBenchmarks(benchmarks, llvm::outs()));
+}
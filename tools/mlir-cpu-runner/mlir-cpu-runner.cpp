@@ -27,20 +27,33 @@
 #include "mlir/IR/Module.h"
 #include "mlir/IR/StandardTypes.h"
 #include "mlir/Parser.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/Benchmark.h"
 #include "mlir/Support/FileUtilities.h"
 
+#include "llvm/ADT/APFloat.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassNameParser.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <numeric>
 
 using namespace mlir;
@@ -57,6 +70,134 @@ static llvm::cl::opt<std::string>
                  llvm::cl::value_desc("<function name>"),
                  llvm::cl::init("main"));
 
+static llvm::cl::opt<std::string> dynamicSizes(
+    "dynamic-sizes",
+    llvm::cl::desc("Comma-separated sizes of the dynamic dimensions of the "
+                   "memref arguments, in order"),
+    llvm::cl::value_desc("<size,...>"), llvm::cl::init(""));
+static llvm::cl::opt<std::string> shapeFile(
+    "shape-file",
+    llvm::cl::desc("File holding the sizes of the dynamic dimensions of the "
+                   "memref arguments, separated by commas or whitespace"),
+    llvm::cl::value_desc("<filename>"), llvm::cl::init(""));
+static llvm::cl::opt<std::string> inputFiles(
+    "input-files",
+    llvm::cl::desc("Comma-separated list of files mapped in memory as the raw "
+                   "contents of the memref arguments, in order; arguments "
+                   "without a file are initialized with -init-value"),
+    llvm::cl::value_desc("<filename,...>"), llvm::cl::init(""));
+static llvm::cl::opt<std::string> outputPrefix(
+    "output-prefix",
+    llvm::cl::desc("Write the raw contents of the memref arguments and "
+                   "results to <prefix>arg<N>.bin and <prefix>result<N>.bin "
+                   "instead of printing them"),
+    llvm::cl::value_desc("<prefix>"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> objectCacheDir(
+    "object-cache-dir",
+    llvm::cl::desc("Directory used to cache the compiled object files"),
+    llvm::cl::value_desc("<directory>"), llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned> compileThreads(
+    "compile-threads",
+    llvm::cl::desc("Split the module and compile it on this many threads"),
+    llvm::cl::init(1));
+
+static llvm::cl::opt<bool> lazyCompile(
+    "lazy-compile",
+    llvm::cl::desc("Only compile the functions that are executed"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> lazyTranslate(
+    "lazy-translate",
+    llvm::cl::desc("Only translate to LLVM IR and compile the functions that "
+                   "are executed"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> tieredCompile(
+    "tiered-compile",
+    llvm::cl::desc("Start executing a version of the module compiled without "
+                   "the MLIR and LLVM passes, while the optimized version is "
+                   "compiled in the background"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> fastMath(
+    "fast-math",
+    llvm::cl::desc("Compile all the floating point operations with all the "
+                   "fast-math flags"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> gpu(
+    "gpu",
+    llvm::cl::desc("Translate the GPU kernels to PTX and launch them on the "
+                   "GPU when the runtime supports it"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string>
+    gpuArch("gpu-arch",
+            llvm::cl::desc("GPU architecture of the kernels, with -gpu"),
+            llvm::cl::value_desc("<sm_xy>"), llvm::cl::init("sm_35"));
+
+static llvm::cl::opt<std::string> targetCPU(
+    "mcpu",
+    llvm::cl::desc("Target a specific CPU type instead of the host CPU"),
+    llvm::cl::value_desc("<cpu name>"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> targetFeatures(
+    "mattr",
+    llvm::cl::desc("Comma-separated list of target features to enable "
+                   "(+feature) or disable (-feature)"),
+    llvm::cl::value_desc("<a1,+a2,-a3,...>"), llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> objectFilename(
+    "emit-object",
+    llvm::cl::desc("Write the compiled module to the given object file "
+                   "instead of executing it"),
+    llvm::cl::value_desc("<filename>"), llvm::cl::init(""));
+
+static llvm::cl::OptionCategory profilingFlags("debugging and profiling flags");
+
+static llvm::cl::opt<bool> gdbListener(
+    "gdb-listener",
+    llvm::cl::desc("Register the JIT-compiled code with GDB"),
+    llvm::cl::init(false), llvm::cl::cat(profilingFlags));
+
+static llvm::cl::opt<bool> perfListener(
+    "perf-listener",
+    llvm::cl::desc("Write jitdump files of the JIT-compiled code for perf, if "
+                   "LLVM supports it"),
+    llvm::cl::init(false), llvm::cl::cat(profilingFlags));
+
+static llvm::cl::opt<bool> perfMap(
+    "perf-map",
+    llvm::cl::desc("Append the JIT-compiled functions to the perf map file "
+                   "/tmp/perf-<pid>.map"),
+    llvm::cl::init(false), llvm::cl::cat(profilingFlags));
+
+static llvm::cl::opt<std::string> perfMapFile(
+    "perf-map-file",
+    llvm::cl::desc("Append the JIT-compiled functions to this perf map file "
+                   "instead"),
+    llvm::cl::value_desc("<filename>"), llvm::cl::init(""),
+    llvm::cl::cat(profilingFlags));
+
+static llvm::cl::OptionCategory benchmarkFlags("benchmark flags");
+
+static llvm::cl::opt<bool> benchmark(
+    "benchmark",
+    llvm::cl::desc("Time the compilation and repeated executions of the entry "
+                   "function, and print a JSON report instead of the results"),
+    llvm::cl::init(false), llvm::cl::cat(benchmarkFlags));
+
+static llvm::cl::opt<unsigned> benchmarkWarmup(
+    "benchmark-warmup",
+    llvm::cl::desc("Number of untimed executions before the timed ones"),
+    llvm::cl::init(1), llvm::cl::cat(benchmarkFlags));
+
+static llvm::cl::opt<unsigned> benchmarkIterations(
+    "benchmark-iterations", llvm::cl::desc("Number of timed executions"),
+    llvm::cl::init(10), llvm::cl::cat(benchmarkFlags));
+
 static llvm::cl::OptionCategory optFlags("opt-like flags");
 
 // CLI list of pass information
@@ -74,6 +215,15 @@ static llvm::cl::opt<bool> optO2("O2", llvm::cl::desc("Run opt O2 passes"),
 static llvm::cl::opt<bool> optO3("O3", llvm::cl::desc("Run opt O3 passes"),
                                  llvm::cl::cat(optFlags));
 
+// The MLIR passes are named rather than given as flags of their own, as some
+// of their names are also those of LLVM passes.
+static llvm::cl::list<std::string> mlirPasses(
+    "mlir-passes",
+    llvm::cl::desc("Comma-separated list of MLIR passes to run on the module "
+                   "before lowering it to the LLVM IR dialect"),
+    llvm::cl::value_desc("<pass,...>"), llvm::cl::CommaSeparated,
+    llvm::cl::cat(optFlags));
+
 static std::unique_ptr<Module> parseMLIRInput(StringRef inputFilename,
                                               MLIRContext *context) {
   // Set up the input file.
@@ -100,73 +250,476 @@ static inline Error make_string_error(const llvm::Twine &message) {
                                              llvm::inconvertibleErrorCode());
 }
 
-static void printOneMemRef(Type t, void *val) {
-  auto memRefType = t.cast<MemRefType>();
-  auto shape = memRefType.getShape();
-  int64_t size = std::accumulate(shape.begin(), shape.end(), 1,
-                                 std::multiplies<int64_t>());
-  for (int64_t i = 0; i < size; ++i) {
-    llvm::outs() << reinterpret_cast<StaticFloatMemRef *>(val)->data[i] << ' ';
+// Parse a list of sizes separated by commas or whitespace.
+static Error parseSizes(StringRef str, SmallVectorImpl<int64_t> &sizes) {
+  while (true) {
+    StringRef token;
+    std::tie(token, str) = llvm::getToken(str, " \t\n\r,");
+    if (token.empty())
+      return Error::success();
+    int64_t size;
+    if (token.getAsInteger(10, size))
+      return make_string_error("invalid memref size '" + token + "'");
+    sizes.push_back(size);
+  }
+}
+
+// Collect the sizes of the dynamic dimensions of the memref arguments from the
+// command line or from the shape file.
+static Error getDynamicSizes(SmallVectorImpl<int64_t> &sizes) {
+  if (shapeFile.empty())
+    return parseSizes(dynamicSizes, sizes);
+  auto file = llvm::MemoryBuffer::getFile(shapeFile);
+  if (!file)
+    return make_string_error("could not open shape file '" + shapeFile +
+                             "': " + file.getError().message());
+  return parseSizes((*file)->getBuffer(), sizes);
+}
+
+static int64_t getNumElements(ArrayRef<int64_t> shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t(1),
+                         std::multiplies<int64_t>());
+}
+
+// Convert between floats and the bits of a half-precision float.
+static uint16_t floatToHalfBits(float value) {
+  bool losesInfo;
+  llvm::APFloat half(value);
+  half.convert(llvm::APFloat::IEEEhalf(), llvm::APFloat::rmNearestTiesToEven,
+               &losesInfo);
+  return half.bitcastToAPInt().getZExtValue();
+}
+static float halfBitsToFloat(uint16_t bits) {
+  bool losesInfo;
+  llvm::APFloat value(llvm::APFloat::IEEEhalf(), llvm::APInt(16, bits));
+  value.convert(llvm::APFloat::IEEEsingle(),
+                llvm::APFloat::rmNearestTiesToEven, &losesInfo);
+  return value.convertToFloat();
+}
+
+// Convert between floats and the bits of a bfloat16, which are the upper bits
+// of a single-precision float.
+static uint16_t floatToBF16Bits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits >> 16;
+}
+static float bf16BitsToFloat(uint16_t bits) {
+  uint32_t floatBits = uint32_t(bits) << 16;
+  float value;
+  memcpy(&value, &floatBits, sizeof(value));
+  return value;
+}
+
+// Store `element` in each of the `numElements` positions of `data`.
+template <typename T>
+static void fill(char *data, int64_t numElements, T element) {
+  for (int64_t i = 0; i < numElements; ++i)
+    memcpy(data + i * sizeof(T), &element, sizeof(T));
+}
+
+// Load an element of type `T` from `data`.
+template <typename T> static T load(const char *data) {
+  T element;
+  memcpy(&element, data, sizeof(T));
+  return element;
+}
+
+// Set the `numElements` elements of type `type` stored at `data` to `value`.
+static void fillBuffer(Type type, char *data, int64_t numElements,
+                       double value) {
+  if (type.isF32())
+    return fill(data, numElements, float(value));
+  if (type.isF64())
+    return fill(data, numElements, double(value));
+  if (type.isF16())
+    return fill(data, numElements, floatToHalfBits(value));
+  if (type.isBF16())
+    return fill(data, numElements, floatToBF16Bits(value));
+  switch ((type.getIntOrFloatBitWidth() + 7) / 8) {
+  case 1:
+    return fill(data, numElements, int8_t(value));
+  case 2:
+    return fill(data, numElements, int16_t(value));
+  case 4:
+    return fill(data, numElements, int32_t(value));
+  default:
+    return fill(data, numElements, int64_t(value));
+  }
+}
+
+// Print the element of type `type` stored at `data`.
+static void printElement(Type type, const char *data) {
+  if (type.isF32()) {
+    llvm::outs() << load<float>(data);
+  } else if (type.isF64()) {
+    llvm::outs() << load<double>(data);
+  } else if (type.isF16()) {
+    llvm::outs() << halfBitsToFloat(load<uint16_t>(data));
+  } else if (type.isBF16()) {
+    llvm::outs() << bf16BitsToFloat(load<uint16_t>(data));
+  } else {
+    unsigned width = type.getIntOrFloatBitWidth();
+    uint64_t bits = 0;
+    memcpy(&bits, data, (width + 7) / 8);
+    llvm::outs() << llvm::APInt(width, bits).getSExtValue();
+  }
+}
+
+// A memref argument or result of the entry function, with its resolved shape.
+struct MemRefValue {
+  MemRefType type;
+  SmallVector<int64_t, 4> shape;
+  char *data;
+};
+
+// Print all of the elements of the given memref on one line.
+static void printOneMemRef(const MemRefValue &value) {
+  auto elementType = value.type.getElementType();
+  size_t elementSize = getMemRefElementSize(value.type);
+  for (int64_t i = 0, e = getNumElements(value.shape); i < e; ++i) {
+    printElement(elementType, value.data + i * elementSize);
+    llvm::outs() << ' ';
   }
   llvm::outs() << '\n';
 }
 
-static void printMemRefArguments(ArrayRef<Type> argTypes,
-                                 ArrayRef<Type> resTypes,
-                                 ArrayRef<void *> args) {
-  auto properArgs = args.take_front(argTypes.size());
-  for (const auto &kvp : llvm::zip(argTypes, properArgs)) {
-    auto type = std::get<0>(kvp);
-    auto val = std::get<1>(kvp);
-    printOneMemRef(type, val);
+// Write the raw contents of the given memref to the file `filename`.
+static Error writeOneMemRef(const MemRefValue &value, StringRef filename) {
+  std::error_code error;
+  llvm::raw_fd_ostream os(filename, error, llvm::sys::fs::F_None);
+  if (error)
+    return llvm::errorCodeToError(error);
+  os.write(value.data,
+           getNumElements(value.shape) * getMemRefElementSize(value.type));
+  return Error::success();
+}
+
+// Print the memref arguments and results of the entry function, or write them
+// to binary files if an output prefix is provided.
+static Error outputMemRefs(ArrayRef<MemRefValue> arguments,
+                           ArrayRef<MemRefValue> results) {
+  if (outputPrefix.empty()) {
+    for (auto &value : arguments)
+      printOneMemRef(value);
+    for (auto &value : results)
+      printOneMemRef(value);
+    return Error::success();
+  }
+
+  for (auto &indexedValue : llvm::enumerate(arguments))
+    if (auto err = writeOneMemRef(indexedValue.value(),
+                                  outputPrefix + "arg" +
+                                      std::to_string(indexedValue.index()) +
+                                      ".bin"))
+      return err;
+  for (auto &indexedValue : llvm::enumerate(results))
+    if (auto err = writeOneMemRef(indexedValue.value(),
+                                  outputPrefix + "result" +
+                                      std::to_string(indexedValue.index()) +
+                                      ".bin"))
+      return err;
+  return Error::success();
+}
+
+using BufferList = std::vector<std::unique_ptr<llvm::WritableMemoryBuffer>>;
+
+// Allocate the buffers of the memref arguments of `func` and bind them to the
+// packed arguments.  The buffers of the arguments with an input file map the
+// contents of that file, the others are initialized with `initValue`.
+static Error allocateArguments(Function *func, MemRefArgumentPack &pack,
+                               BufferList &buffers,
+                               SmallVectorImpl<MemRefValue> &arguments) {
+  SmallVector<int64_t, 8> sizes;
+  if (auto err = getDynamicSizes(sizes))
+    return err;
+  ArrayRef<int64_t> remainingSizes = sizes;
+
+  SmallVector<StringRef, 8> inputs;
+  StringRef(inputFiles).split(inputs, ',');
+  double init = std::stod(initValue.getValue());
+
+  for (auto &indexedType : llvm::enumerate(func->getType().getInputs())) {
+    unsigned index = indexedType.index();
+    auto type = indexedType.value().cast<MemRefType>();
+    ArrayRef<int64_t> argSizes = remainingSizes;
+    auto shape = resolveMemRefShape(type, remainingSizes);
+    if (!shape)
+      return shape.takeError();
+    size_t byteSize = getNumElements(*shape) * getMemRefElementSize(type);
+
+    std::unique_ptr<llvm::WritableMemoryBuffer> buffer;
+    StringRef input = index < inputs.size() ? inputs[index] : StringRef();
+    if (!input.empty()) {
+      auto file = llvm::WritableMemoryBuffer::getFile(input);
+      if (!file)
+        return make_string_error("could not open input file '" + input +
+                                 "': " + file.getError().message());
+      if ((*file)->getBufferSize() != byteSize)
+        return make_string_error("input file '" + input + "' holds " +
+                                 llvm::Twine((*file)->getBufferSize()) +
+                                 " bytes, expected " + llvm::Twine(byteSize));
+      buffer = std::move(*file);
+    } else {
+      buffer = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(byteSize);
+      if (!buffer)
+        return make_string_error("could not allocate a memref argument");
+      fillBuffer(type.getElementType(), buffer->getBufferStart(),
+                 getNumElements(*shape), init);
+    }
+
+    auto dynamicArgSizes =
+        argSizes.take_front(argSizes.size() - remainingSizes.size());
+    void *data = buffer->getBufferStart();
+    if (auto err = pack.setArgument(index, data, dynamicArgSizes))
+      return err;
+    arguments.push_back({type, std::move(*shape), buffer->getBufferStart()});
+    buffers.push_back(std::move(buffer));
+  }
+  if (!remainingSizes.empty())
+    return make_string_error("too many dynamic memref sizes");
+  return Error::success();
+}
+
+// Collect the memref results of the last invocation of the entry function.
+static Error collectResults(ArrayRef<Type> resTypes, MemRefArgumentPack &pack,
+                            SmallVectorImpl<MemRefValue> &results) {
+  for (auto &indexedType : llvm::enumerate(resTypes)) {
+    auto type = indexedType.value().cast<MemRefType>();
+    auto packedSizes = pack.getResultDynamicSizes(indexedType.index());
+    SmallVector<int64_t, 4> sizes(packedSizes.begin(), packedSizes.end());
+    ArrayRef<int64_t> remainingSizes = sizes;
+    auto shape = resolveMemRefShape(type, remainingSizes);
+    if (!shape)
+      return shape.takeError();
+    char *data = pack.getResultData<char>(indexedType.index());
+    results.push_back({type, std::move(*shape), data});
+  }
+  return Error::success();
+}
+
+namespace {
+// The times spent in the stages of the compilation, in milliseconds.
+struct CompileTimes {
+  double parseMs = 0;
+  double mlirPassesMs = 0;
+  double loweringMs = 0;
+  double optimizationMs = 0;
+  double codegenMs = 0;
+};
+} // end anonymous namespace
+
+// Run `fptr` for the configured number of warm-up and timed iterations, and
+// print a JSON report of the compilation and execution times.
+static void runBenchmark(void (*fptr)(void **), MutableArrayRef<void *> args,
+                         StringRef entryPoint, const CompileTimes &times) {
+  for (unsigned i = 0; i < benchmarkWarmup; ++i)
+    (*fptr)(args.data());
+
+  std::vector<double> latencies;
+  latencies.reserve(benchmarkIterations);
+  for (unsigned i = 0; i < benchmarkIterations; ++i) {
+    auto start = BenchmarkClock::now();
+    (*fptr)(args.data());
+    latencies.push_back(getElapsedMs(start));
   }
 
-  auto results = args.drop_front(argTypes.size());
-  for (const auto &kvp : llvm::zip(resTypes, results)) {
-    auto type = std::get<0>(kvp);
-    auto val = std::get<1>(kvp);
-    printOneMemRef(type, val);
+  llvm::json::Object execution{{"warmup", int64_t(benchmarkWarmup)},
+                               {"iterations", int64_t(benchmarkIterations)}};
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+      size_t rank = std::ceil(p * latencies.size());
+      return latencies[std::max<size_t>(rank, 1) - 1];
+    };
+    double total = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+    execution["min_ms"] = latencies.front();
+    execution["median_ms"] = percentile(0.5);
+    execution["p99_ms"] = percentile(0.99);
+    execution["mean_ms"] = total / latencies.size();
+    execution["iterations_per_second"] =
+        total > 0 ? latencies.size() * 1000.0 / total : 0.0;
   }
+
+  llvm::json::Object report{
+      {"input", inputFilename.getValue()},
+      {"entry", entryPoint},
+      {"compile",
+       llvm::json::Object{{"parse_ms", times.parseMs},
+                          {"mlir_passes_ms", times.mlirPassesMs},
+                          {"lowering_ms", times.loweringMs},
+                          {"llvm_optimization_ms", times.optimizationMs},
+                          {"codegen_ms", times.codegenMs}}},
+      {"execution", std::move(execution)}};
+  llvm::outs() << llvm::formatv("{0:2}",
+                                llvm::json::Value(std::move(report)))
+               << '\n';
 }
 
+// Execute the entry point of an engine compiled in tiers, and wait for its
+// optimized version to report the errors of its compilation.  With -benchmark,
+// the entry point is executed as many times as the warm-up and timed
+// executions, and the number of them that started before the optimized
+// version was swapped in is reported instead of the timings.
+static Error executeTiered(ExecutionEngine &engine, StringRef entryPoint,
+                           MemRefArgumentPack &pack, ArrayRef<Type> resTypes,
+                           ArrayRef<MemRefValue> arguments) {
+  auto function = engine.getTieredFunction(entryPoint);
+  if (!function)
+    return function.takeError();
+  auto args = pack.getPackedArguments().data();
+  if (!benchmark) {
+    (*function)(args);
+    if (auto err = engine.waitForOptimization())
+      return err;
+    SmallVector<MemRefValue, 1> results;
+    if (auto err = collectResults(resTypes, pack, results))
+      return err;
+    return outputMemRefs(arguments, results);
+  }
+
+  unsigned numQuickExecutions = 0;
+  for (unsigned i = 0, e = benchmarkWarmup + benchmarkIterations; i < e; ++i) {
+    if (!engine.isOptimized())
+      ++numQuickExecutions;
+    (*function)(args);
+  }
+  if (auto err = engine.waitForOptimization())
+    return err;
+  llvm::json::Object report{
+      {"entry", entryPoint},
+      {"tiered",
+       llvm::json::Object{
+           {"executions", int64_t(benchmarkWarmup + benchmarkIterations)},
+           {"quick_executions", int64_t(numQuickExecutions)}}}};
+  llvm::outs() << llvm::formatv("{0:2}",
+                                llvm::json::Value(std::move(report)))
+               << '\n';
+  return Error::success();
+}
+
+// Compile `module` and execute its entry point.  If `quickModule` is
+// provided, the execution starts with its quickly-compiled version while
+// `module` is compiled in the background.
 static Error
-compileAndExecute(Module *module, StringRef entryPoint,
-                  std::function<llvm::Error(llvm::Module *)> transformer) {
+compileAndExecute(Module *module, Module *quickModule, StringRef entryPoint,
+                  std::function<llvm::Error(llvm::Module *)> transformer,
+                  StringRef transformerKey, CompileTimes times) {
   Function *mainFunction = module->getNamedFunction(entryPoint);
   if (!mainFunction || mainFunction->getBlocks().empty()) {
     return make_string_error("entry point not found");
   }
 
-  // Store argument and result types of the original function necessary to
-  // pretty print the results, because the function itself will be rewritten
-  // to use the LLVM dialect.
-  SmallVector<Type, 8> argTypes =
-      llvm::to_vector<8>(mainFunction->getType().getInputs());
+  // Store the result types of the original function necessary to print the
+  // results, because the function itself will be rewritten to use the LLVM
+  // dialect.
   SmallVector<Type, 8> resTypes =
       llvm::to_vector<8>(mainFunction->getType().getResults());
 
-  float init = std::stof(initValue.getValue());
+  auto pack = MemRefArgumentPack::create(mainFunction);
+  if (!pack)
+    return pack.takeError();
+  BufferList buffers;
+  SmallVector<MemRefValue, 8> arguments;
+  if (auto err = allocateArguments(mainFunction, *pack, buffers, arguments))
+    return err;
 
-  auto expectedArguments = allocateMemRefArguments(mainFunction, init);
-  if (!expectedArguments)
-    return expectedArguments.takeError();
+  ExecutionEngineOptions options;
+  options.targetCPU = targetCPU;
+  options.targetFeatures = targetFeatures;
+  options.objectCacheDir = objectCacheDir;
+  options.transformerKey = transformerKey;
+  options.numCompileThreads = compileThreads;
+  options.lazyCompilation = lazyCompile;
+  options.lazyTranslation = lazyTranslate;
+  options.enableFastMath = fastMath;
+  options.enableGPU = gpu;
+  options.gpuArch = gpuArch;
+  options.enableGDBNotificationListener = gdbListener;
+  options.enablePerfNotificationListener = perfListener;
+  options.enablePerfMap = perfMap || !perfMapFile.empty();
+  options.perfMapFile = perfMapFile;
 
-  auto expectedEngine = mlir::ExecutionEngine::create(module, transformer);
+  // Measure the time spent in the LLVM transformer separately from the rest
+  // of the JIT compilation.  The transformer may be called concurrently on
+  // the parts of a split module, in which case this adds up their times.
+  std::atomic<int64_t> optimizationNs(0);
+  auto timedTransformer = [&](llvm::Module *llvmModule) -> Error {
+    auto start = BenchmarkClock::now();
+    Error error = transformer ? transformer(llvmModule) : Error::success();
+    optimizationNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          BenchmarkClock::now() - start)
+                          .count();
+    return error;
+  };
+
+  auto loweringStart = BenchmarkClock::now();
+  auto expectedEngine =
+      quickModule
+          ? mlir::ExecutionEngine::createTiered(
+                quickModule, module, makeOptimizingTransformer(0, 0),
+                timedTransformer, options)
+          : mlir::ExecutionEngine::create(module, timedTransformer, options);
   if (!expectedEngine)
     return expectedEngine.takeError();
+  double createMs = getElapsedMs(loweringStart);
+  double createOptimizationMs = optimizationNs / 1e6;
 
+  // The module is compiled when the entry point is first looked up, unless
+  // it was compiled eagerly or loaded from the object cache.
   auto engine = std::move(*expectedEngine);
+  if (quickModule)
+    return executeTiered(*engine, entryPoint, *pack, resTypes, arguments);
+  auto codegenStart = BenchmarkClock::now();
   auto expectedFPtr = engine->lookup(entryPoint);
   if (!expectedFPtr)
     return expectedFPtr.takeError();
+  double compileMs = getElapsedMs(codegenStart);
   void (*fptr)(void **) = *expectedFPtr;
-  (*fptr)(expectedArguments->data());
-  printMemRefArguments(argTypes, resTypes, *expectedArguments);
-  freeMemRefArguments(*expectedArguments);
 
+  if (benchmark) {
+    // Attribute the optimization time to the phase it was spent in.
+    double optimizationMs = optimizationNs / 1e6;
+    double lookupOptimizationMs = optimizationMs - createOptimizationMs;
+    times.loweringMs = std::max(createMs - createOptimizationMs, 0.0);
+    times.optimizationMs = optimizationMs;
+    times.codegenMs = std::max(compileMs - lookupOptimizationMs, 0.0);
+    runBenchmark(fptr, pack->getPackedArguments(), entryPoint, times);
+    return Error::success();
+  }
+
+  (*fptr)(pack->getPackedArguments().data());
+  SmallVector<MemRefValue, 1> results;
+  if (auto err = collectResults(resTypes, *pack, results))
+    return err;
+  return outputMemRefs(arguments, results);
+}
+
+// Run the MLIR passes given with -mlir-passes on `module`.
+static Error runMLIRPasses(Module *module) {
+  PassManager manager;
+  for (auto &name : mlirPasses) {
+    const auto *entry = lookupPassRegistryEntry(name);
+    if (!entry)
+      return make_string_error("unknown MLIR pass '" + name + "'");
+    entry->addToPipeline(manager);
+  }
+  if (failed(manager.run(module)))
+    return make_string_error("the MLIR passes failed");
   return Error::success();
 }
 
+static Error
+emitObjectFile(Module *module, StringRef filename,
+               std::function<llvm::Error(llvm::Module *)> transformer) {
+  ExecutionEngineOptions options;
+  options.targetCPU = targetCPU;
+  options.targetFeatures = targetFeatures;
+  options.enableFastMath = fastMath;
+  return ExecutionEngine::emitObjectFile(module, filename, transformer,
+                                         options);
+}
+
 int main(int argc, char **argv) {
   llvm::PrettyStackTraceProgram x(argc, argv);
   llvm::InitLLVM y(argc, argv);
@@ -204,15 +757,58 @@ int main(int argc, char **argv) {
   }
 
   MLIRContext context;
+  CompileTimes times;
+  auto parseStart = BenchmarkClock::now();
   auto m = parseMLIRInput(inputFilename, &context);
   if (!m) {
     llvm::errs() << "could not parse the input IR\n";
     return 1;
   }
+  times.parseMs = getElapsedMs(parseStart);
+  // The quick version of a tiered compilation is compiled from a second copy
+  // of the module, on which the MLIR passes don't run.
+  std::unique_ptr<Module> quickModule;
+  if (tieredCompile && objectFilename.empty())
+    quickModule = parseMLIRInput(inputFilename, &context);
+
+  // Tune the LLVM passes for the target the code is generated for.
+  auto machineBuilder =
+      mlir::createHostTargetMachineBuilder(targetCPU, targetFeatures);
+  if (!machineBuilder) {
+    llvm::errs() << "could not detect the host target: "
+                 << llvm::toString(machineBuilder.takeError()) << "\n";
+    return 1;
+  }
+  auto targetMachine = machineBuilder->createTargetMachine();
+  if (!targetMachine) {
+    llvm::errs() << "could not create the target machine: "
+                 << llvm::toString(targetMachine.takeError()) << "\n";
+    return 1;
+  }
+
+  auto transformer = mlir::makeLLVMPassesTransformer(
+      passes, optLevel, optPosition, targetMachine->get());
+
+  // Describe the LLVM pipeline for the object cache.
+  std::string transformerKey;
+  llvm::raw_string_ostream keyOS(transformerKey);
+  for (unsigned i = 0, e = passes.size(); i <= e; ++i) {
+    if (optLevel && i == optPosition)
+      keyOS << "-O" << *optLevel << ' ';
+    if (i != e)
+      keyOS << '-' << passes[i]->getPassArgument() << ' ';
+  }
+  keyOS.flush();
 
-  auto transformer =
-      mlir::makeLLVMPassesTransformer(passes, optLevel, optPosition);
-  auto error = compileAndExecute(m.get(), mainFuncName.getValue(), transformer);
+  auto passesStart = BenchmarkClock::now();
+  Error error = runMLIRPasses(m.get());
+  times.mlirPassesMs = getElapsedMs(passesStart);
+  if (!error)
+    error = objectFilename.empty()
+                ? compileAndExecute(m.get(), quickModule.get(),
+                                    mainFuncName.getValue(), transformer,
+                                    transformerKey, times)
+                : emitObjectFile(m.get(), objectFilename, transformer);
   int exitCode = EXIT_SUCCESS;
   llvm::handleAllErrors(std::move(error),
                         [&exitCode](const llvm::ErrorInfoBase &info) {
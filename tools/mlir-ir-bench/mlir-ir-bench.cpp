@@ -0,0 +1,328 @@
+//===- mlir-ir-bench.cpp - Core IR benchmarks -----------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This is a command line utility that times the core operations of the IR:
+// the creation and erasure of operations, the replacement of the uses of a
+// value, the insertion of operations in a block queried for their order, the
+// uniquing of types, attributes and affine maps from several threads, the
+// walk and cloning of a function, and the creation of short-lived contexts,
+// which construct the registered dialects on the first use of their
+// namespace, against contexts constructing all of them upfront and against a
+// single context reused within storage scopes.  It prints a JSON report of the
+// timings to track their regressions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Block.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Dialect.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Parser.h"
+#include "mlir/Support/Benchmark.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <functional>
+
+using namespace mlir;
+
+static llvm::cl::opt<unsigned>
+    numOps("num-ops",
+           llvm::cl::desc("Number of operations, uses or uniqued instances "
+                          "processed by each run, per thread"),
+           llvm::cl::init(10000));
+
+static llvm::cl::opt<unsigned>
+    maxThreads("max-threads",
+               llvm::cl::desc("Largest number of threads uniquing instances "
+                              "concurrently, timed from one thread up by "
+                              "powers of two"),
+               llvm::cl::init(4));
+
+static llvm::cl::opt<unsigned>
+    numContexts("num-contexts",
+                llvm::cl::desc("Number of contexts created by each run of the "
+                               "context benchmarks"),
+                llvm::cl::init(100));
+
+/// The number of distinct instances uniqued by the uniquing benchmarks.  The
+/// warm-up runs create them, so that the timed runs measure the lookups of
+/// existing instances, which dominate in practice.
+static constexpr unsigned kNumUniquedKeys = 1024;
+
+//===----------------------------------------------------------------------===//
+// Operations and blocks
+//===----------------------------------------------------------------------===//
+
+// Create an unregistered operation using `operands`.
+static Operation *createOp(MLIRContext *context, ArrayRef<Value *> operands) {
+  return Operation::create(UnknownLoc::get(context),
+                           OperationName("bench.op", context), operands,
+                           llvm::None, llvm::None, llvm::None, 0,
+                           /*resizableOperandList=*/false, context);
+}
+
+// Add the benchmarks creating and erasing operations, replacing the uses of a
+// value and inserting operations in a block queried for their order.
+static void addOperationBenchmarks(std::vector<Benchmark> &benchmarks) {
+  auto context = std::make_shared<MLIRContext>();
+
+  // Create operations at the end of a block and erase them from its front.
+  benchmarks.push_back({"op_create_erase", numOps, [=]() {
+                          Block block;
+                          for (unsigned i = 0; i < numOps; ++i)
+                            block.push_back(createOp(context.get(), {}));
+                          while (!block.empty())
+                            block.front().erase();
+                          return true;
+                        }});
+
+  // Move the uses of a block argument to another argument and back.  The
+  // block is destroyed before the context it uses.
+  struct UseList {
+    MLIRContext context;
+    Block block;
+  };
+  auto useList = std::make_shared<UseList>();
+  Type indexType = IndexType::get(&useList->context);
+  Value *from = useList->block.addArgument(indexType);
+  Value *to = useList->block.addArgument(indexType);
+  for (unsigned i = 0; i < numOps; ++i)
+    useList->block.push_back(createOp(&useList->context, from));
+  benchmarks.push_back({"use_list_rauw", 2 * size_t(numOps), [=]() {
+                          (void)useList;
+                          from->replaceAllUsesWith(to);
+                          to->replaceAllUsesWith(from);
+                          return to->use_empty();
+                        }});
+
+  // Insert operations repeatedly at the same position, which exhausts the
+  // room between the order indices of the neighbours, querying the order of
+  // the operations after each insertion.
+  benchmarks.push_back(
+      {"block_insert_order_queries", numOps, [=]() {
+         Block block;
+         for (unsigned i = 0; i < 4; ++i)
+           block.push_back(createOp(context.get(), {}));
+         Operation *anchor = &block.back();
+         for (unsigned i = 0; i < numOps; ++i) {
+           block.getOperations().insert(Block::iterator(anchor),
+                                        createOp(context.get(), {}));
+           if (!anchor->getPrevNode()->isBeforeInBlock(anchor) ||
+               !block.front().isBeforeInBlock(anchor->getPrevNode()))
+             return false;
+         }
+         return true;
+       }});
+}
+
+//===----------------------------------------------------------------------===//
+// Uniquing
+//===----------------------------------------------------------------------===//
+
+// Add a benchmark named `name` calling `getInstance` on the keys 0 to numOps
+// from each thread of a pool of `numThreads` threads sharing a context.
+static void
+addUniquingBenchmark(std::vector<Benchmark> &benchmarks, StringRef name,
+                     unsigned numThreads,
+                     std::function<void(MLIRContext *, unsigned)> getInstance) {
+  auto context = std::make_shared<MLIRContext>();
+  auto pool = std::make_shared<llvm::ThreadPool>(numThreads);
+  benchmarks.push_back(
+      {llvm::formatv("{0}_{1}_threads", name, numThreads).str(),
+       size_t(numOps) * numThreads, [=]() {
+         for (unsigned t = 0; t < numThreads; ++t)
+           pool->async([=] {
+             for (unsigned i = 0; i < numOps; ++i)
+               getInstance(context.get(), i % kNumUniquedKeys);
+           });
+         pool->wait();
+         return true;
+       }});
+}
+
+// Add the benchmarks uniquing memref types, integer attributes and affine
+// maps from one thread up to the configured number of threads.
+static void addUniquingBenchmarks(std::vector<Benchmark> &benchmarks) {
+  unsigned numThreadsLimit = std::max(1u, unsigned(maxThreads));
+  for (unsigned numThreads = 1; numThreads <= numThreadsLimit;
+       numThreads *= 2) {
+    addUniquingBenchmark(benchmarks, "type_uniquing", numThreads,
+                         [](MLIRContext *context, unsigned key) {
+                           MemRefType::get({int64_t(key) + 1},
+                                           FloatType::getF32(context));
+                         });
+    addUniquingBenchmark(benchmarks, "attribute_uniquing", numThreads,
+                         [](MLIRContext *context, unsigned key) {
+                           IntegerAttr::get(IntegerType::get(64, context),
+                                            int64_t(key));
+                         });
+    addUniquingBenchmark(benchmarks, "affine_map_uniquing", numThreads,
+                         [](MLIRContext *context, unsigned key) {
+                           auto d0 = getAffineDimExpr(0, context);
+                           auto d1 = getAffineDimExpr(1, context);
+                           AffineMap::get(2, 0, {d0 * key + d1}, {});
+                         });
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Functions
+//===----------------------------------------------------------------------===//
+
+// Return the source of a function made of loops loading, adding and storing
+// an element, with about `numOps` operations in total.
+static std::string getFunctionSource(unsigned numOps) {
+  std::string source = "func @body(%arg0: memref<?xf32>) {\n";
+  for (unsigned i = 0, e = std::max(1u, numOps / 5); i < e; ++i)
+    source += llvm::formatv("  affine.for %i{0} = 0 to 10 {{\n"
+                            "    %v{0} = load %arg0[%i{0}] : memref<?xf32>\n"
+                            "    %s{0} = addf %v{0}, %v{0} : f32\n"
+                            "    store %s{0}, %arg0[%i{0}] : memref<?xf32>\n"
+                            "  }\n",
+                            i)
+                  .str();
+  source += "  return\n}\n";
+  return source;
+}
+
+// Add the benchmarks walking and cloning a function.  Return false if the
+// function could not be parsed.
+static bool addFunctionBenchmarks(std::vector<Benchmark> &benchmarks) {
+  // The module is destroyed before the context it uses.
+  struct ParsedModule {
+    MLIRContext context;
+    std::unique_ptr<Module> module;
+  };
+  auto parsed = std::make_shared<ParsedModule>();
+  parsed->module.reset(
+      parseSourceString(getFunctionSource(numOps), &parsed->context));
+  if (!parsed->module)
+    return false;
+  Function *function = parsed->module->getNamedFunction("body");
+  size_t numFunctionOps = 0;
+  function->walk([&](Operation *) { ++numFunctionOps; });
+
+  benchmarks.push_back({"function_walk", numFunctionOps, [=]() {
+                          (void)parsed;
+                          size_t count = 0;
+                          function->walk([&](Operation *) { ++count; });
+                          return count == numFunctionOps;
+                        }});
+  benchmarks.push_back({"function_clone", numFunctionOps, [=]() {
+                          (void)parsed;
+                          BlockAndValueMapping mapper;
+                          std::unique_ptr<Function> clone(
+                              function->clone(mapper));
+                          return mapper.contains(function->getArgument(0));
+                        }});
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Contexts
+//===----------------------------------------------------------------------===//
+
+/// A small function only using the standard dialect, typical of the jobs
+/// processed in short-lived contexts.
+static constexpr const char *kStandardModule = R"mlir(
+func @add(%arg0: f32, %arg1: f32) -> f32 {
+  %0 = addf %arg0, %arg1 : f32
+  return %0 : f32
+}
+)mlir";
+
+// Create and destroy `numContexts` contexts. Construct all the registered
+// dialects in each upfront if `allDialects` is set, and parse a small module
+// in each if `parse` is set. Return false if the parsing failed.
+static bool createContexts(bool allDialects, bool parse) {
+  for (unsigned i = 0; i < numContexts; ++i) {
+    MLIRContext context;
+    if (allDialects)
+      registerAllDialects(&context);
+    if (!parse)
+      continue;
+    std::unique_ptr<Module> module(
+        parseSourceString(kStandardModule, &context));
+    if (!module)
+      return false;
+  }
+  return true;
+}
+
+// Parse a small module `numContexts` times in `context`, each time within a
+// storage scope releasing what the parsing uniqued, as a context reused across
+// requests does. Return false if the parsing failed.
+static bool parseInStorageScopes(MLIRContext &context) {
+  for (unsigned i = 0; i < numContexts; ++i) {
+    StorageScope scope(&context);
+    std::unique_ptr<Module> module(
+        parseSourceString(kStandardModule, &context));
+    if (!module)
+      return false;
+  }
+  return true;
+}
+
+// Add the benchmarks creating contexts, with the dialects constructed on first
+// use or all upfront, and the benchmark reusing a single context instead.
+static void addContextBenchmarks(std::vector<Benchmark> &benchmarks) {
+  auto addBenchmark = [&](StringRef name, bool allDialects, bool parse) {
+    benchmarks.push_back({name.str(), numContexts, [=]() {
+                            return createContexts(allDialects, parse);
+                          }});
+  };
+  addBenchmark("create_context", /*allDialects=*/false, /*parse=*/false);
+  addBenchmark("create_context_all_dialects", /*allDialects=*/true,
+               /*parse=*/false);
+  addBenchmark("parse_in_new_context", /*allDialects=*/false, /*parse=*/true);
+  addBenchmark("parse_in_new_context_all_dialects", /*allDialects=*/true,
+               /*parse=*/true);
+
+  auto context = std::make_shared<MLIRContext>();
+  benchmarks.push_back({"parse_in_storage_scope", numContexts,
+                        [=]() { return parseInStorageScopes(*context); }});
+}
+
+int main(int argc, char **argv) {
+  llvm::PrettyStackTraceProgram x(argc, argv);
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "MLIR core IR benchmarks\n");
+
+  std::vector<Benchmark> benchmarks;
+  addOperationBenchmarks(benchmarks);
+  addUniquingBenchmarks(benchmarks);
+  if (!addFunctionBenchmarks(benchmarks)) {
+    llvm::errs() << "failed to parse the benchmarked function\n";
+    return 1;
+  }
+  addContextBenchmarks(benchmarks);
+
+  return failed(runBenchmarks(benchmarks, llvm::outs()));
+}
@@ -22,6 +22,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "mlir/Analysis/Passes.h"
+#include "mlir/Bytecode/Bytecode.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Function.h"
 #include "mlir/IR/Location.h"
@@ -31,13 +32,17 @@
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/FileUtilities.h"
+#include "mlir/Support/ToolServer.h"
 #include "mlir/Transforms/Passes.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 using namespace mlir;
@@ -57,77 +62,134 @@ static cl::opt<bool>
                             "chunk independently"),
                    cl::init(false));
 
+static cl::opt<bool> parallelSplitInputFile(
+    "parallel-split-input-file",
+    cl::desc("Process the chunks of a split input file in parallel, emitting "
+             "their output and diagnostics in the order of the chunks"),
+    cl::init(true));
+
 static cl::opt<bool>
     verifyDiagnostics("verify",
                       cl::desc("Check that emitted diagnostics match "
                                "expected-* lines on the corresponding line"),
                       cl::init(false));
 
+static cl::opt<bool>
+    emitBytecode("emit-bytecode",
+                 cl::desc("Emit the output module in the bytecode format"),
+                 cl::init(false));
+
+static cl::opt<bool> consumeOutput(
+    "consume-output",
+    cl::desc("Erase the body of each function of the output module once it is "
+             "printed, which bounds the memory held while printing large "
+             "modules in the textual format"),
+    cl::init(false));
+
 static cl::opt<bool>
     verifyPasses("verify-each",
                  cl::desc("Run the verifier after each transformation pass"),
                  cl::init(true));
 
-static std::vector<const mlir::PassRegistryEntry *> *passList;
+static cl::opt<bool> verifyEachStructural(
+    "verify-each-structural",
+    cl::desc("Only check the structure of the IR, and not dominance, in the "
+             "verifier runs after each pass, and fully verify it once after "
+             "the last pass"),
+    cl::init(false));
 
-enum OptResult { OptSuccess, OptFailure };
+static cl::opt<bool> serverMode(
+    "server",
+    cl::desc("Process the requests read from the standard input concurrently, "
+             "each one holding an input file and, optionally, the names of "
+             "the passes to run on it instead of the command line ones"),
+    cl::init(false));
 
-/// Given a MemoryBuffer along with a line and column within it, return the
-/// location being referenced.
-static SMLoc getLocFromLineAndCol(MemoryBuffer &membuf, unsigned lineNo,
-                                  unsigned columnNo) {
-  // TODO: This should really be upstreamed to be a method on llvm::SourceMgr.
-  // Doing so would allow it to use the offset cache that is already maintained
-  // by SrcBuffer, making this more efficient.
-
-  // Scan for the correct line number.
-  const char *position = membuf.getBufferStart();
-  const char *end = membuf.getBufferEnd();
+static std::vector<const mlir::PassRegistryEntry *> *passList;
 
-  // We start counting line and column numbers from 1.
-  --lineNo;
-  --columnNo;
+enum OptResult { OptSuccess, OptFailure };
 
-  while (position < end && lineNo) {
+namespace {
+/// An index of the start of each line of a MemoryBuffer, built in a single
+/// scan of the buffer, to map the line and column numbers of the diagnostics to
+/// locations in constant time.
+class LineIndex {
+public:
+  explicit LineIndex(MemoryBuffer &membuf);
+
+  /// Given a line and column within the buffer, return the location being
+  /// referenced.
+  SMLoc getLoc(unsigned lineNo, unsigned columnNo) const;
+
+private:
+  const char *bufferStart, *bufferEnd;
+
+  /// The position of the first character of each line.
+  std::vector<const char *> lineStarts;
+};
+} // end anonymous namespace
+
+LineIndex::LineIndex(MemoryBuffer &membuf)
+    : bufferStart(membuf.getBufferStart()), bufferEnd(membuf.getBufferEnd()) {
+  const char *position = bufferStart;
+  lineStarts.push_back(position);
+  while (position < bufferEnd) {
     auto curChar = *position++;
 
     // Scan for newlines.  If this isn't one, ignore it.
     if (curChar != '\r' && curChar != '\n')
       continue;
 
-    // We saw a line break, decrement our counter.
-    --lineNo;
-
     // Check for \r\n and \n\r and treat it as a single escape.  We know that
     // looking past one character is safe because MemoryBuffer's are always nul
     // terminated.
     if (*position != curChar && (*position == '\r' || *position == '\n'))
       ++position;
+    lineStarts.push_back(position);
   }
+}
 
-  // If the line/column counter was invalid, return a pointer to the start of
-  // the buffer.
-  if (lineNo || position + columnNo > end)
-    return SMLoc::getFromPointer(membuf.getBufferStart());
+SMLoc LineIndex::getLoc(unsigned lineNo, unsigned columnNo) const {
+  // We start counting line and column numbers from 1.  If the line/column
+  // counter was invalid, return a pointer to the start of the buffer.
+  if (lineNo == 0 || columnNo == 0 || lineNo > lineStarts.size())
+    return SMLoc::getFromPointer(bufferStart);
+  const char *lineStart = lineStarts[lineNo - 1];
+  if (columnNo - 1 > size_t(bufferEnd - lineStart))
+    return SMLoc::getFromPointer(bufferStart);
 
   // Otherwise return the right pointer.
-  return SMLoc::getFromPointer(position + columnNo);
+  return SMLoc::getFromPointer(lineStart + columnNo - 1);
 }
 
 /// Perform the actions on the input file indicated by the command line flags
 /// within the specified context.
 ///
 /// This typically parses the main source file, runs zero or more optimization
-/// passes, then prints the output.
+/// passes, then prints the output to 'os', or to the output file if 'os' is
+/// null.
 ///
-static OptResult performActions(SourceMgr &sourceMgr, MLIRContext *context) {
-  std::unique_ptr<Module> module(parseSourceFile(sourceMgr, context));
+static OptResult performActions(SourceMgr &sourceMgr, MLIRContext *context,
+                                ArrayRef<const PassRegistryEntry *> passes,
+                                raw_ostream *os) {
+  // Inputs in the bytecode format are detected by their magic number.  The
+  // function bodies of such inputs are loaded lazily out of the source buffer,
+  // which outlives the module.
+  std::unique_ptr<Module> module;
+  auto *mainBuffer = sourceMgr.getMemoryBuffer(sourceMgr.getMainFileID());
+  if (isBytecodeFile(mainBuffer->getMemBufferRef()))
+    module.reset(readBytecodeFile(mainBuffer->getMemBufferRef(), context,
+                                  /*lazyLoadBodies=*/true));
+  else
+    module.reset(parseSourceFile(sourceMgr, context));
   if (!module)
     return OptFailure;
 
   // Run each of the passes that were selected.
   PassManager pm(verifyPasses);
-  for (const auto *passEntry : *passList)
+  if (verifyEachStructural)
+    pm.setVerificationLevel(VerificationLevel::Structural);
+  for (const auto *passEntry : passes)
     passEntry->addToPipeline(pm);
 
   // Apply any pass manager command line options.
@@ -137,15 +199,27 @@ static OptResult performActions(SourceMgr &sourceMgr, MLIRContext *context) {
   if (failed(pm.run(module.get())))
     return OptFailure;
 
+  // Print the output.
+  auto print = [&](raw_ostream &os) {
+    if (emitBytecode)
+      writeBytecodeFile(module.get(), os);
+    else if (consumeOutput)
+      module->printAndConsume(os);
+    else
+      module->print(os);
+  };
+  if (os) {
+    print(*os);
+    return OptSuccess;
+  }
+
   std::string errorMessage;
   auto output = openOutputFile(outputFilename, &errorMessage);
   if (!output) {
     llvm::errs() << errorMessage << "\n";
     exit(1);
   }
-
-  // Print the output.
-  module->print(output->os());
+  print(output->os());
   output->keep();
   return OptSuccess;
 }
@@ -174,16 +248,23 @@ static llvm::SourceMgr::DiagKind getDiagKind(MLIRContext::DiagnosticKind kind) {
   }
 }
 
-/// Parses the memory buffer.  If successfully, run a series of passes against
-/// it and print the result.
-static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
+/// Parses the memory buffer.  If successfully, run 'passes' against it and
+/// print the result to 'os', or to the output file if 'os' is null.  The
+/// diagnostics are printed to 'diagOS'.
+static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer,
+                             raw_ostream *os, raw_ostream &diagOS,
+                             ArrayRef<const PassRegistryEntry *> passes,
+                             llvm::ThreadPool *threadPool = nullptr) {
   // Tell sourceMgr about this buffer, which is what the parser will pick up.
   SourceMgr sourceMgr;
   auto &buffer = *ownedBuffer;
+  LineIndex lineIndex(buffer);
   sourceMgr.AddNewSourceBuffer(std::move(ownedBuffer), SMLoc());
 
   // Parse the input file.
   MLIRContext context;
+  if (threadPool)
+    context.setThreadPool(*threadPool, llvm::hardware_concurrency());
 
   // If we are in verify mode then we have a lot of work to do, otherwise just
   // perform the actions without worrying about it.
@@ -197,14 +278,14 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
       if (auto fileLoc = location.dyn_cast<FileLineColLoc>()) {
         line = fileLoc->getLine();
         column = fileLoc->getColumn();
-        loc = getLocFromLineAndCol(buffer, line, column);
+        loc = lineIndex.getLoc(line, column);
       }
 
-      sourceMgr.PrintMessage(loc, getDiagKind(kind), message);
+      sourceMgr.PrintMessage(diagOS, loc, getDiagKind(kind), message);
     });
 
     // Run the test actions.
-    return performActions(sourceMgr, &context);
+    return performActions(sourceMgr, &context, passes, os);
   }
 
   // Keep track of the result of this file processing.  If there are no issues,
@@ -222,6 +303,9 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
   };
   SmallVector<ExpectedDiag, 2> expectedDiags;
 
+  // The indices of the expected diagnostics of each line.
+  DenseMap<unsigned, SmallVector<unsigned, 1>> expectedDiagsByLine;
+
   // Error checker that verifies reported error was expected.
   auto checker = [&](Location location, StringRef message,
                      MLIRContext::DiagnosticKind kind) {
@@ -235,8 +319,9 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
     ExpectedDiag *nearMiss = nullptr;
 
     // If this was an expected error, remember that we saw it and return.
-    for (auto &e : expectedDiags) {
-      if (line == e.lineNo && message.contains(e.substring)) {
+    for (unsigned index : expectedDiagsByLine.lookup(line)) {
+      auto &e = expectedDiags[index];
+      if (message.contains(e.substring)) {
         if (e.kind == kind) {
           e.matched = true;
           return;
@@ -250,7 +335,7 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
 
     // If there was a near miss, emit a specific diagnostic.
     if (nearMiss) {
-      sourceMgr.PrintMessage(nearMiss->fileLoc, SourceMgr::DK_Error,
+      sourceMgr.PrintMessage(diagOS, nearMiss->fileLoc, SourceMgr::DK_Error,
                              "'" + getDiagnosticKindString(kind) +
                                  "' diagnostic emitted when expecting a '" +
                                  getDiagnosticKindString(nearMiss->kind) + "'");
@@ -260,8 +345,8 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
 
     // If this error wasn't expected, produce an error out of mlir-opt saying
     // so.
-    auto unexpectedLoc = getLocFromLineAndCol(buffer, line, column);
-    sourceMgr.PrintMessage(unexpectedLoc, SourceMgr::DK_Error,
+    auto unexpectedLoc = lineIndex.getLoc(line, column);
+    sourceMgr.PrintMessage(diagOS, unexpectedLoc, SourceMgr::DK_Error,
                            "unexpected error: " + Twine(message));
     result = OptFailure;
   };
@@ -301,6 +386,7 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
             record.lineNo -= offset;
         }
       }
+      expectedDiagsByLine[record.lineNo].push_back(expectedDiags.size());
       expectedDiags.push_back(record);
     }
   }
@@ -311,7 +397,7 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
   // Do any processing requested by command line flags.  We don't care whether
   // these actions succeed or fail, we only care what diagnostics they produce
   // and whether they match our expectations.
-  performActions(sourceMgr, &context);
+  performActions(sourceMgr, &context, passes, os);
 
   // Verify that all expected errors were seen.
   for (auto &err : expectedDiags) {
@@ -320,7 +406,7 @@ static OptResult processFile(std::unique_ptr<MemoryBuffer> ownedBuffer) {
                     SMLoc::getFromPointer(err.fileLoc.getPointer() +
                                           err.substring.size()));
       auto kind = getDiagnosticKindString(err.kind);
-      sourceMgr.PrintMessage(err.fileLoc, SourceMgr::DK_Error,
+      sourceMgr.PrintMessage(diagOS, err.fileLoc, SourceMgr::DK_Error,
                              "expected " + kind + " \"" + err.substring +
                                  "\" was not produced",
                              range);
@@ -346,23 +432,106 @@ splitAndProcessFile(std::unique_ptr<MemoryBuffer> originalBuffer) {
   SourceMgr fileSourceMgr;
   fileSourceMgr.AddNewSourceBuffer(std::move(originalBuffer), SMLoc());
 
-  bool hadUnexpectedResult = false;
-
-  // Process each chunk in turn.  If any fails, then return a failure of the
-  // tool.
+  std::vector<std::unique_ptr<MemoryBuffer>> chunkBuffers;
   for (auto &subBuffer : sourceBuffers) {
     auto splitLoc = SMLoc::getFromPointer(subBuffer.data());
     unsigned splitLine = fileSourceMgr.getLineAndColumn(splitLoc).first;
-    auto subMemBuffer = MemoryBuffer::getMemBufferCopy(
+    chunkBuffers.push_back(MemoryBuffer::getMemBufferCopy(
         subBuffer, origMemBuffer->getBufferIdentifier() +
-                       Twine(" split at line #") + Twine(splitLine));
-    if (processFile(std::move(subMemBuffer)))
+                       Twine(" split at line #") + Twine(splitLine)));
+  }
+
+  bool hadUnexpectedResult = false;
+
+  // Process each chunk in turn.  If any fails, then return a failure of the
+  // tool.
+  if (!parallelSplitInputFile || !llvm::llvm_is_multithreaded() ||
+      chunkBuffers.size() < 2) {
+    for (auto &chunkBuffer : chunkBuffers)
+      if (processFile(std::move(chunkBuffer), /*os=*/nullptr, llvm::errs(),
+                      *passList))
+        hadUnexpectedResult = true;
+    return hadUnexpectedResult ? OptFailure : OptSuccess;
+  }
+
+  // Otherwise, process the chunks in parallel, each within its own context.
+  // The contexts share a thread pool, and the output and diagnostics of each
+  // chunk are buffered so that they are emitted in the order of the chunks.
+  struct ChunkResult {
+    std::string output, diagnostics;
+    OptResult result = OptSuccess;
+  };
+  std::vector<ChunkResult> chunkResults(chunkBuffers.size());
+  {
+    llvm::ThreadPool threadPool;
+    for (unsigned i = 0, e = chunkBuffers.size(); i != e; ++i) {
+      threadPool.async([&, i] {
+        auto &chunkResult = chunkResults[i];
+        llvm::raw_string_ostream os(chunkResult.output);
+        llvm::raw_string_ostream diagOS(chunkResult.diagnostics);
+        chunkResult.result = processFile(std::move(chunkBuffers[i]), &os,
+                                         diagOS, *passList, &threadPool);
+      });
+    }
+    threadPool.wait();
+  }
+
+  // The output file is only opened if a chunk produced some output, as in the
+  // sequential mode.
+  std::unique_ptr<ToolOutputFile> output;
+  for (auto &chunkResult : chunkResults) {
+    llvm::errs() << chunkResult.diagnostics;
+    if (chunkResult.result == OptFailure)
       hadUnexpectedResult = true;
+    if (chunkResult.output.empty())
+      continue;
+    if (!output) {
+      std::string errorMessage;
+      output = openOutputFile(outputFilename, &errorMessage);
+      if (!output) {
+        llvm::errs() << errorMessage << "\n";
+        exit(1);
+      }
+    }
+    output->os() << chunkResult.output;
   }
+  if (output)
+    output->keep();
 
   return hadUnexpectedResult ? OptFailure : OptSuccess;
 }
 
+/// Serve the requests read from the standard input, see ToolServer.h.  The
+/// arguments of a request are the names of the passes to run, with or without
+/// a leading dash, and default to the passes of the command line.  The other
+/// options of the command line apply to all of the requests, which are
+/// processed in contexts of their own sharing a thread pool.
+static OptResult serveRequests() {
+  llvm::ThreadPool threadPool;
+  auto handler = [&](ArrayRef<StringRef> args,
+                     std::unique_ptr<MemoryBuffer> input, raw_ostream &os,
+                     raw_ostream &diagOS) -> LogicalResult {
+    std::vector<const PassRegistryEntry *> passes;
+    for (StringRef arg : args) {
+      StringRef name = arg.ltrim('-');
+      const auto *entry = lookupPassRegistryEntry(name);
+      if (!entry) {
+        diagOS << "unknown pass '" << name << "'\n";
+        return failure();
+      }
+      passes.push_back(entry);
+    }
+    if (args.empty())
+      passes = *passList;
+    return processFile(std::move(input), &os, diagOS, passes, &threadPool)
+               ? failure()
+               : success();
+  };
+  return failed(runToolServer(stdin, llvm::outs(), threadPool, handler))
+             ? OptFailure
+             : OptSuccess;
+}
+
 int main(int argc, char **argv) {
   llvm::PrettyStackTraceProgram x(argc, argv);
   InitLLVM y(argc, argv);
@@ -376,6 +545,9 @@ int main(int argc, char **argv) {
   ::passList = &passList;
   cl::ParseCommandLineOptions(argc, argv, "MLIR modular optimizer driver\n");
 
+  if (serverMode)
+    return serveRequests();
+
   // Set up the input file.
   std::string errorMessage;
   auto file = openInputFile(inputFilename, &errorMessage);
@@ -389,5 +561,5 @@ int main(int argc, char **argv) {
   if (splitInputFile)
     return splitAndProcessFile(std::move(file));
 
-  return processFile(std::move(file));
+  return processFile(std::move(file), /*os=*/nullptr, llvm::errs(), *passList);
 }
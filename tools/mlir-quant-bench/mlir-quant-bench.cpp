@@ -0,0 +1,238 @@
+//===- mlir-quant-bench.cpp - Quantization utilities benchmarks -----------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// This is a command line utility that times the quantization utilities on
+// constants of realistic sizes, the derivation of quantized types from
+// FakeQuant attributes and the parsing of quantized types, and prints a JSON
+// report of the timings to track their regressions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Parser.h"
+#include "mlir/Quantization/FakeQuantSupport.h"
+#include "mlir/Quantization/QuantOps.h"
+#include "mlir/Quantization/QuantizeUtils.h"
+#include "mlir/Support/Benchmark.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace mlir;
+using namespace mlir::quant;
+
+static llvm::cl::opt<unsigned> numElements(
+    "num-elements",
+    llvm::cl::desc("Number of elements of the quantized constants"),
+    llvm::cl::init(1 << 20));
+
+static llvm::cl::opt<double>
+    sparsity("sparsity",
+             llvm::cl::desc("Fraction of implicit zeros of the sparse "
+                            "constants"),
+             llvm::cl::init(0.9));
+
+static llvm::cl::opt<unsigned> numTypes(
+    "num-types",
+    llvm::cl::desc("Number of types derived or parsed by each run of the type "
+                   "benchmarks"),
+    llvm::cl::init(1000));
+
+/// The number of slices along the quantized dimension of per-axis types.
+static constexpr unsigned kNumChannels = 64;
+
+// Return `count` deterministic real values spread over [-1, 1].
+static std::vector<float> getRealValues(size_t count) {
+  std::vector<float> values(count);
+  for (size_t i = 0; i < count; ++i)
+    values[i] = float(int64_t((i * 7919) % 2001) - 1000) / 1000.0f;
+  return values;
+}
+
+// Add the benchmarks of `quantizeAttr` converting `realValue` to the storage
+// values of `type`.
+static void addQuantizeBenchmark(std::vector<Benchmark> &benchmarks,
+                                 StringRef name, Attribute realValue,
+                                 QuantizedType type) {
+  size_t numItems = realValue.cast<ElementsAttr>().getType().getNumElements();
+  benchmarks.push_back({name.str(), numItems, [=]() {
+                          Type convertedType;
+                          return bool(
+                              quantizeAttr(realValue, type, convertedType));
+                        }});
+}
+
+// Add the benchmarks of the quantization of dense, splat and sparse constants.
+static void addQuantizeBenchmarks(MLIRContext *context,
+                                  std::vector<Benchmark> &benchmarks) {
+  auto f32 = FloatType::getF32(context);
+  auto i8 = IntegerType::get(8, context);
+  auto i64 = IntegerType::get(64, context);
+  int64_t numRows = kNumChannels;
+  int64_t numColumns = std::max<int64_t>(numElements / kNumChannels, 1);
+  auto realType = RankedTensorType::get({numRows, numColumns}, f32);
+
+  // A signed fixed point type, an unsigned affine one, and a per-axis one with
+  // a scale per row.
+  auto fixedPointType = UniformQuantizedType::get(
+      QuantizationFlags::Signed, i8, f32, /*scale=*/1.0 / 128,
+      /*zeroPoint=*/0, /*storageTypeMin=*/-128, /*storageTypeMax=*/127);
+  auto affineType = UniformQuantizedType::get(
+      /*flags=*/0, i8, f32, /*scale=*/1.0 / 128, /*zeroPoint=*/128,
+      /*storageTypeMin=*/0, /*storageTypeMax=*/255);
+  std::vector<double> scales(kNumChannels);
+  for (unsigned i = 0; i < kNumChannels; ++i)
+    scales[i] = (i + 1) / 1024.0;
+  std::vector<int64_t> zeroPoints(kNumChannels, 0);
+  auto perAxisType = UniformQuantizedPerAxisType::get(
+      QuantizationFlags::Signed, i8, f32, scales, zeroPoints,
+      /*quantizedDimension=*/0, /*storageTypeMin=*/-128,
+      /*storageTypeMax=*/127);
+
+  std::vector<float> realValues = getRealValues(realType.getNumElements());
+  auto denseAttr =
+      DenseElementsAttr::get(realType, ArrayRef<float>(realValues));
+  auto splatAttr =
+      SplatElementsAttr::get(realType, FloatAttr::get(f32, 0.5));
+
+  // The stored elements of the sparse constant are evenly spread.
+  size_t numStored = std::max<size_t>(
+      std::llround(realType.getNumElements() * (1.0 - sparsity)), 1);
+  size_t stride = std::max<size_t>(realType.getNumElements() / numStored, 1);
+  numStored = std::min<size_t>(numStored, realType.getNumElements() / stride);
+  std::vector<int64_t> indices;
+  indices.reserve(numStored * 2);
+  for (size_t i = 0; i < numStored; ++i) {
+    indices.push_back((i * stride) / numColumns);
+    indices.push_back((i * stride) % numColumns);
+  }
+  auto indicesAttr = DenseElementsAttr::get(
+      RankedTensorType::get({int64_t(numStored), 2}, i64),
+      ArrayRef<int64_t>(indices));
+  auto valuesAttr = DenseElementsAttr::get(
+      RankedTensorType::get({int64_t(numStored)}, f32),
+      ArrayRef<float>(realValues).take_front(numStored));
+  auto sparseAttr = SparseElementsAttr::get(
+      realType, indicesAttr.cast<DenseIntElementsAttr>(), valuesAttr);
+
+  addQuantizeBenchmark(benchmarks, "quantize_dense_fixedpoint", denseAttr,
+                       fixedPointType);
+  addQuantizeBenchmark(benchmarks, "quantize_dense_affine", denseAttr,
+                       affineType);
+  addQuantizeBenchmark(benchmarks, "quantize_dense_per_axis", denseAttr,
+                       perAxisType);
+  addQuantizeBenchmark(benchmarks, "quantize_splat_fixedpoint", splatAttr,
+                       fixedPointType);
+  addQuantizeBenchmark(benchmarks, "quantize_splat_per_axis", splatAttr,
+                       perAxisType);
+  addQuantizeBenchmark(benchmarks, "quantize_sparse_fixedpoint", sparseAttr,
+                       fixedPointType);
+  addQuantizeBenchmark(benchmarks, "quantize_sparse_affine", sparseAttr,
+                       affineType);
+  addQuantizeBenchmark(benchmarks, "quantize_sparse_per_axis", sparseAttr,
+                       perAxisType);
+}
+
+// Add the benchmarks of the derivation of per-layer and per-axis types from
+// FakeQuant attributes, with distinct ranges for each type.
+static void addFakeQuantBenchmarks(MLIRContext *context,
+                                   std::vector<Benchmark> &benchmarks) {
+  auto f32 = FloatType::getF32(context);
+  auto loc = UnknownLoc::get(context);
+  benchmarks.push_back({"fake_quant_to_type", numTypes, [=]() {
+                          for (unsigned i = 0; i < numTypes; ++i) {
+                            double delta = i / 1024.0;
+                            if (!fakeQuantAttrsToType(loc, /*numBits=*/8,
+                                                      -1.0 - delta, 1.0 + delta,
+                                                      /*narrowRange=*/false,
+                                                      f32))
+                              return false;
+                          }
+                          return true;
+                        }});
+  benchmarks.push_back(
+      {"fake_quant_to_per_axis_type", numTypes, [=]() {
+         std::vector<double> rmins(kNumChannels), rmaxs(kNumChannels);
+         for (unsigned i = 0; i < numTypes; ++i) {
+           for (unsigned c = 0; c < kNumChannels; ++c) {
+             double delta = (i + c) / 1024.0;
+             rmins[c] = -1.0 - delta;
+             rmaxs[c] = 1.0 + delta;
+           }
+           if (!fakeQuantAttrsToType(loc, /*numBits=*/8,
+                                     /*quantizedDimension=*/0, rmins, rmaxs,
+                                     /*narrowRange=*/true, f32))
+             return false;
+         }
+         return true;
+       }});
+}
+
+// Add the benchmarks of the parsing of per-layer and per-axis quantized types,
+// each of a distinct spelling.
+static void addParseBenchmarks(MLIRContext *context,
+                               std::vector<Benchmark> &benchmarks) {
+  std::vector<std::string> perLayerTypes, perAxisTypes;
+  for (unsigned i = 0; i < numTypes; ++i) {
+    double scale = (i + 1) / 4096.0;
+    perLayerTypes.push_back(
+        llvm::formatv("!quant<\"uniform[u8:f32]{{{0:e}:{1}}\">", scale,
+                      i % 256)
+            .str());
+    std::string scales;
+    for (unsigned c = 0; c < 16; ++c)
+      scales +=
+          llvm::formatv("{0}{1:e}", c ? "," : "", scale * (c + 1)).str();
+    perAxisTypes.push_back(
+        llvm::formatv("!quant<\"uniform[i8:f32:1]{{{0}}\">", scales).str());
+  }
+
+  auto addParseBenchmark = [&](StringRef name,
+                               const std::vector<std::string> &types) {
+    benchmarks.push_back({name.str(), types.size(), [=]() {
+                            for (auto &type : types)
+                              if (!parseType(type, context))
+                                return false;
+                            return true;
+                          }});
+  };
+  addParseBenchmark("parse_uniform_type", perLayerTypes);
+  addParseBenchmark("parse_uniform_per_axis_type", perAxisTypes);
+}
+
+int main(int argc, char **argv) {
+  llvm::PrettyStackTraceProgram x(argc, argv);
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "MLIR quantization benchmarks\n");
+
+  MLIRContext context;
+  std::vector<Benchmark> benchmarks;
+  addQuantizeBenchmarks(&context, benchmarks);
+  addFakeQuantBenchmarks(&context, benchmarks);
+  addParseBenchmarks(&context, benchmarks);
+
+  return failed(runBenchmarks(benchmarks, llvm::outs()));
+}
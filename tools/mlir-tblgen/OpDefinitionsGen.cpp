@@ -22,6 +22,7 @@
 
 #include "mlir/Support/STLExtras.h"
 #include "mlir/TableGen/GenInfo.h"
+#include "mlir/TableGen/OpInterfaces.h"
 #include "mlir/TableGen/OpTrait.h"
 #include "mlir/TableGen/Operator.h"
 #include "llvm/ADT/StringExtras.h"
@@ -195,6 +196,9 @@ public:
   // Adds an op trait.
   void addTrait(Twine trait);
 
+  // Adds the trait of an op interface.
+  void addInterfaceTrait(Twine trait);
+
   // Creates a new method in this op's class.
   OpMethod &newMethod(StringRef retType, StringRef name, StringRef params = "",
                       OpMethod::Property = OpMethod::MP_None,
@@ -304,6 +308,10 @@ void OpClass::addTrait(Twine trait) {
   traits.push_back(("OpTrait::" + trait).str());
 }
 
+// Adds the given trait of an op interface, which is qualified by the class of
+// the interface, to this op.
+void OpClass::addInterfaceTrait(Twine trait) { traits.push_back(trait.str()); }
+
 OpMethod &OpClass::newMethod(StringRef retType, StringRef name,
                              StringRef params, OpMethod::Property property,
                              bool declOnly) {
@@ -366,6 +374,10 @@ private:
   // Generates the folder declaration for the operation.
   void genFolderDecls();
 
+  // Generates the declarations of the methods of the op interfaces
+  // implemented by the operation.
+  void genInterfaceMethodDecls();
+
   // Generates the parser for the operation.
   void genParser();
 
@@ -413,6 +425,7 @@ OpEmitter::OpEmitter(const Record &def)
   genVerifier();
   genCanonicalizerDecls();
   genFolderDecls();
+  genInterfaceMethodDecls();
 }
 
 void OpEmitter::emitDecl(const Record &def, raw_ostream &os) {
@@ -730,6 +743,8 @@ void OpEmitter::genCanonicalizerDecls() {
 }
 
 void OpEmitter::genFolderDecls() {
+  // The declarations match the fallback implementations of FoldingHook, which
+  // they hide: this is also what gives the op the Foldable property.
   bool hasSingleResult = op.getNumResults() == 1;
 
   if (def.getValueAsBit("hasConstantFolder")) {
@@ -752,13 +767,33 @@ void OpEmitter::genFolderDecls() {
       opClass.newMethod("Value *", "fold", /*params=*/"", OpMethod::MP_None,
                         /*declOnly=*/true);
     } else {
-      opClass.newMethod("bool", "fold", "SmallVectorImpl<Value *> &results",
-                        OpMethod::MP_None,
+      opClass.newMethod("LogicalResult", "fold",
+                        "SmallVectorImpl<Value *> &results", OpMethod::MP_None,
                         /*declOnly=*/true);
     }
   }
 }
 
+void OpEmitter::genInterfaceMethodDecls() {
+  for (const auto &trait : op.getTraits()) {
+    auto opTrait = dyn_cast<tblgen::InterfaceOpTrait>(&trait);
+    if (!opTrait)
+      continue;
+    tblgen::OpInterface opInterface(&opTrait->getDef());
+    for (const auto &method : opInterface.getMethods()) {
+      std::string params;
+      interleave(
+          method.getArguments(),
+          [&](const tblgen::InterfaceMethod::Argument &arg) {
+            params += (arg.type + " " + arg.name).str();
+          },
+          [&] { params += ", "; });
+      opClass.newMethod(method.getReturnType(), method.getName(), params,
+                        OpMethod::MP_None, /*declOnly=*/true);
+    }
+  }
+}
+
 void OpEmitter::genParser() {
   if (!hasStringAttribute(def, "parser"))
     return;
@@ -781,6 +816,19 @@ void OpEmitter::genPrinter() {
   method.body() << "  " << printer;
 }
 
+// Returns true if `condition` is the literal `true`, possibly parenthesized.
+static bool isTriviallyTrue(StringRef condition) {
+  return condition == "true" || condition == "(true)";
+}
+
+// Returns `str` with all the occurrences of `from` replaced by `to`.
+static std::string replaceAll(std::string str, StringRef from, StringRef to) {
+  for (auto pos = str.find(from); pos != std::string::npos;
+       pos = str.find(from, pos + to.size()))
+    str.replace(pos, from.size(), to);
+  return str;
+}
+
 void OpEmitter::genVerifier() {
   auto valueInit = def.getValueInit("verifier");
   CodeInit *codeInit = dyn_cast<CodeInit>(valueInit);
@@ -791,6 +839,27 @@ void OpEmitter::genVerifier() {
   auto &method = opClass.newMethod("LogicalResult", "verify", /*params=*/"");
   auto &body = method.body();
 
+  // The expensive constraints are skipped when fast verification is enabled.
+  // Query it once if any such constraint is checked.
+  bool hasExpensiveConstraint = false;
+  for (const auto &namedAttr : op.getAttributes())
+    hasExpensiveConstraint |=
+        !namedAttr.attr.isDerivedAttr() && namedAttr.attr.isExpensive();
+  for (unsigned i = 0, e = op.getNumOperands(); i < e; ++i)
+    hasExpensiveConstraint |= op.getOperand(i).constraint.isExpensive();
+  for (unsigned i = 0, e = op.getNumResults(); i < e; ++i)
+    hasExpensiveConstraint |= op.getResult(i).constraint.isExpensive();
+  for (auto &trait : op.getTraits())
+    if (auto t = dyn_cast<tblgen::PredOpTrait>(&trait))
+      hasExpensiveConstraint |= t->isExpensive();
+  if (hasExpensiveConstraint)
+    body << "  bool tblgen_fastVerify = "
+            "this->getContext()->isFastVerifierEnabled(); "
+            "(void)tblgen_fastVerify;\n";
+  auto getSkipCondition = [](bool isExpensive) -> StringRef {
+    return isExpensive ? "!tblgen_fastVerify && " : "";
+  };
+
   // Verify the attributes have the correct type.
   for (const auto &namedAttr : op.getAttributes()) {
     const auto &attr = namedAttr.attr;
@@ -807,25 +876,31 @@ void OpEmitter::genVerifier() {
       continue;
     }
 
+    // Look the attribute up once for all the checks below.
+    std::string varName = ("tblgen_" + name).str();
+    body << formatv("  auto {0} = this->getAttr(\"{1}\");\n", varName, name);
+
     bool allowMissingAttr = attr.hasDefaultValue() || attr.isOptional();
     if (allowMissingAttr) {
       // If the attribute has a default value, then only verify the predicate if
       // set. This does effectively assume that the default value is valid.
       // TODO: verify the debug value is valid (perhaps in debug mode only).
-      body << "  if (this->getAttr(\"" << name << "\")) {\n";
+      body << "  if (" << varName << ") {\n";
     }
 
-    body << "    if (!this->getAttr(\"" << name << "\").dyn_cast_or_null<"
+    body << "    if (!" << varName << ".dyn_cast_or_null<"
          << attr.getStorageType() << ">()) return emitOpError(\"requires "
          << attr.getDescription() << " attribute '" << name << "'\");\n";
 
     auto attrPred = attr.getPredicate();
     if (!attrPred.isNull()) {
-      body << formatv("    if (!({0})) return emitOpError(\"attribute '{1}' "
-                      "failed to satisfy {2} attribute constraints\");\n",
-                      formatv(attrPred.getCondition(),
-                              formatv("this->getAttr(\"{0}\")", name)),
-                      name, attr.getDescription());
+      std::string condition = formatv(attrPred.getCondition().c_str(), varName);
+      if (!isTriviallyTrue(condition))
+        body << formatv("    if ({0}!({1})) return emitOpError(\"attribute "
+                        "'{2}' failed to satisfy {3} attribute "
+                        "constraints\");\n",
+                        getSkipCondition(attr.isExpensive()), condition, name,
+                        attr.getDescription());
     }
 
     if (allowMissingAttr)
@@ -842,13 +917,16 @@ void OpEmitter::genVerifier() {
     // TODO: Commonality between matchers could be extracted to have a more
     // concise code.
     if (value.hasPredicate()) {
+      std::string condition =
+          formatv(value.constraint.getConditionTemplate().c_str(),
+                  "this->getOperation()->get" +
+                      Twine(isOperand ? "Operand" : "Result") + "(" +
+                      Twine(index) + ")->getType()");
+      if (isTriviallyTrue(condition))
+        return;
       auto description = value.constraint.getDescription();
-      body << "  if (!("
-           << formatv(value.constraint.getConditionTemplate(),
-                      "this->getOperation()->get" +
-                          Twine(isOperand ? "Operand" : "Result") + "(" +
-                          Twine(index) + ")->getType()")
-           << "))\n";
+      body << "  if (" << getSkipCondition(value.constraint.isExpensive())
+           << "!(" << condition << "))\n";
       body << "    return emitOpError(\"" << (isOperand ? "operand" : "result")
            << " #" << index
            << (description.empty() ? " type precondition failed"
@@ -867,9 +945,22 @@ void OpEmitter::genVerifier() {
 
   for (auto &trait : op.getTraits()) {
     if (auto t = dyn_cast<tblgen::PredOpTrait>(&trait)) {
-      body << "  if (!("
-           << formatv(t->getPredTemplate().c_str(), "(*this->getOperation())")
-           << "))\n";
+      std::string condition =
+          formatv(t->getPredTemplate().c_str(), "(*this->getOperation())");
+      // The traits verifying the number of operands and results run before
+      // this verifier, so fixed numbers can be folded by the C++ compiler.
+      if (!op.hasVariadicOperand())
+        condition = replaceAll(condition,
+                               "(*this->getOperation()).getNumOperands()",
+                               Twine(op.getNumOperands()).str());
+      if (!op.hasVariadicResult())
+        condition = replaceAll(condition,
+                               "(*this->getOperation()).getNumResults()",
+                               Twine(op.getNumResults()).str());
+      if (isTriviallyTrue(condition))
+        continue;
+      body << "  if (" << getSkipCondition(t->isExpensive()) << "!("
+           << condition << "))\n";
       body << "    return emitOpError(\"failed to verify that "
            << t->getDescription() << "\");\n";
     }
@@ -908,6 +999,8 @@ void OpEmitter::genTraits() {
   for (const auto &trait : op.getTraits()) {
     if (auto opTrait = dyn_cast<tblgen::NativeOpTrait>(&trait))
       opClass.addTrait(opTrait->getTrait());
+    else if (auto opTrait = dyn_cast<tblgen::InterfaceOpTrait>(&trait))
+      opClass.addInterfaceTrait(opTrait->getTrait());
   }
 
   // Add variadic size trait and normal op traits.
@@ -0,0 +1,169 @@
+//===- OpInterfacesGen.cpp - MLIR op interface generator ------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+//
+// OpInterfacesGen generates the C++ classes of the op interfaces defined in
+// TableGen, see OpInterface in OpDefinition.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mlir/Support/STLExtras.h"
+#include "mlir/TableGen/GenInfo.h"
+#include "mlir/TableGen/OpInterfaces.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/TableGen/Error.h"
+#include "llvm/TableGen/Record.h"
+#include "llvm/TableGen/TableGenBackend.h"
+
+using namespace llvm;
+using namespace mlir;
+
+using mlir::tblgen::InterfaceMethod;
+using mlir::tblgen::OpInterface;
+
+// Emits the C++ type `type` followed by a space, unless it is a pointer or a
+// reference type.
+static void emitType(StringRef type, raw_ostream &os) {
+  os << type;
+  if (!type.endswith("*") && !type.endswith("&"))
+    os << " ";
+}
+
+// Emits the parameters of `method`, preceded by the operation if
+// `withOperation` is true.
+static void emitParams(const InterfaceMethod &method, bool withOperation,
+                       raw_ostream &os) {
+  if (withOperation) {
+    os << "Operation *tblgen_op";
+    if (!method.getArguments().empty())
+      os << ", ";
+  }
+  interleave(
+      method.getArguments(),
+      [&](const InterfaceMethod::Argument &arg) {
+        emitType(arg.type, os);
+        os << arg.name;
+      },
+      [&] { os << ", "; });
+}
+
+// Emits the arguments of a call to `method`, preceded by `op` if not empty.
+static void emitArgs(const InterfaceMethod &method, StringRef op,
+                     raw_ostream &os) {
+  os << op;
+  if (!op.empty() && !method.getArguments().empty())
+    os << ", ";
+  interleave(
+      method.getArguments(),
+      [&](const InterfaceMethod::Argument &arg) { os << arg.name; },
+      [&] { os << ", "; });
+}
+
+// Emits `description` as a doc comment indented by `indent` spaces.
+static void emitDocComment(StringRef description, unsigned indent,
+                           raw_ostream &os) {
+  SmallVector<StringRef, 8> lines;
+  description.trim().split(lines, '\n');
+  for (auto line : lines)
+    if (!line.trim().empty())
+      os.indent(indent) << "/// " << line.trim() << "\n";
+}
+
+// Emits the struct gathering the Concept and the Model of `opInterface`.  The
+// Concept is the table of the methods of the interface for an op, which take
+// the operation as first argument, and Model<ConcreteOp> builds the table that
+// calls the methods of ConcreteOp.
+static void emitInterfaceTraits(const OpInterface &opInterface,
+                                raw_ostream &os) {
+  auto methods = opInterface.getMethods();
+  os << "namespace detail {\n";
+  os << "struct " << opInterface.getName() << "Traits {\n";
+
+  os << "  struct Concept {\n";
+  for (const auto &method : methods) {
+    os << "    ";
+    emitType(method.getReturnType(), os);
+    os << "(*" << method.getName() << ")(";
+    emitParams(method, /*withOperation=*/true, os);
+    os << ");\n";
+  }
+  os << "  };\n";
+
+  os << "  template <typename ConcreteOp> struct Model {\n";
+  for (const auto &method : methods) {
+    os << "    static ";
+    emitType(method.getReturnType(), os);
+    os << method.getName() << "(";
+    emitParams(method, /*withOperation=*/true, os);
+    os << ") {\n      return tblgen_op->cast<ConcreteOp>()."
+       << method.getName() << "(";
+    emitArgs(method, "", os);
+    os << ");\n    }\n";
+  }
+  os << "    static Concept *getConcept() {\n"
+     << "      static Concept instance = {";
+  interleave(
+      methods, [&](const InterfaceMethod &method) { os << method.getName(); },
+      [&] { os << ", "; });
+  os << "};\n      return &instance;\n    }\n  };\n";
+
+  os << "};\n} // end namespace detail\n\n";
+}
+
+// Emits the class of `opInterface`, whose methods call through the Concept of
+// the op.
+static void emitInterfaceClass(const OpInterface &opInterface,
+                               raw_ostream &os) {
+  auto name = opInterface.getName();
+  std::string base =
+      formatv("OpInterface<{0}, detail::{0}Traits>", name).str();
+  emitDocComment(opInterface.getDescription(), 0, os);
+  os << "class " << name << " : public " << base << " {\n"
+     << "public:\n"
+     << "  using " << base << "::OpInterface;\n";
+  for (const auto &method : opInterface.getMethods()) {
+    os << "\n";
+    emitDocComment(method.getDescription(), 2, os);
+    os << "  ";
+    emitType(method.getReturnType(), os);
+    os << method.getName() << "(";
+    emitParams(method, /*withOperation=*/false, os);
+    os << ") {\n    return getImpl()->" << method.getName() << "(";
+    emitArgs(method, "getOperation()", os);
+    os << ");\n  }\n";
+  }
+  os << "};\n\n";
+}
+
+static bool emitInterfaceDecls(const RecordKeeper &recordKeeper,
+                               raw_ostream &os) {
+  emitSourceFileHeader("Op Interface Declarations", os);
+
+  for (auto *def : recordKeeper.getAllDerivedDefinitions("OpInterface")) {
+    OpInterface opInterface(def);
+    emitInterfaceTraits(opInterface, os);
+    emitInterfaceClass(opInterface, os);
+  }
+  return false;
+}
+
+static mlir::GenRegistration
+    genInterfaceDecls("gen-op-interface-decls",
+                      "Generate op interface declarations",
+                      [](const RecordKeeper &records, raw_ostream &os) {
+                        return emitInterfaceDecls(records, os);
+                      });
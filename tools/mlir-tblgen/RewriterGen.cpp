@@ -26,6 +26,9 @@
 #include "mlir/TableGen/Pattern.h"
 #include "mlir/TableGen/Predicate.h"
 #include "mlir/TableGen/Type.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CommandLine.h"
@@ -41,6 +44,13 @@ using namespace llvm;
 using namespace mlir;
 using namespace mlir::tblgen;
 
+static llvm::cl::opt<bool> mergePatterns(
+    "merge-patterns",
+    llvm::cl::desc("Generate a single pattern per root op, dispatching to the "
+                   "patterns rooted at it after sharing the checks of the ops "
+                   "defining the root operands"),
+    llvm::cl::init(false));
+
 namespace {
 class PatternEmitter {
 public:
@@ -53,11 +63,17 @@ private:
   // Emits the mlir::RewritePattern struct named `rewriteName`.
   void emit(StringRef rewriteName);
 
-  // Emits the match() method.
-  void emitMatchMethod(DagNode tree);
+  // Emits the matchAndRewrite() method, which holds the values bound by the
+  // match on the stack.
+  void emitMatchAndRewriteMethod(DagNode tree);
+
+  // Emits C++ statements returning a match failure unless the source pattern
+  // rooted at `tree` matches.
+  void emitMatchLogic(DagNode tree);
 
-  // Emits the rewrite() method.
-  void emitRewriteMethod();
+  // Emits C++ statements building the result patterns and replacing the root
+  // op with them.
+  void emitRewriteLogic();
 
   // Emits C++ statements for matching the op constrained by the given DAG
   // `tree`.
@@ -142,15 +158,10 @@ std::string PatternEmitter::handleConstantAttr(Attribute attr,
 
 static Twine resultName(const StringRef &name) { return Twine("res_") + name; }
 
-static Twine boundArgNameInMatch(const StringRef &name) {
-  // Bound value in the source pattern are grouped into a transient struct. That
-  // struct is hold in a local variable named as "state" in the match() method.
-  return Twine("state->") + name;
-}
-
-static Twine boundArgNameInRewrite(const StringRef &name) {
+static Twine boundArgName(const StringRef &name) {
   // Bound value in the source pattern are grouped into a transient struct. That
-  // struct is passed into the rewrite() method as a parameter with name `s`.
+  // struct is hold in a local variable named as "s" in the matchAndRewrite()
+  // method.
   return Twine("s.") + name;
 }
 
@@ -232,7 +243,7 @@ void PatternEmitter::emitOperandMatch(DagNode tree, int index, int depth,
   // Capture the value
   auto name = tree.getArgName(index);
   if (!name.empty()) {
-    os.indent(indent) << "state->" << name << " = op" << depth
+    os.indent(indent) << "s." << name << " = op" << depth
                       << "->getOperand(" << index << ");\n";
   }
 }
@@ -262,20 +273,25 @@ void PatternEmitter::emitAttributeMatch(DagNode tree, int index, int depth,
   // Capture the value
   auto name = tree.getArgName(index);
   if (!name.empty()) {
-    os.indent(indent) << "state->" << name << " = op" << depth
+    os.indent(indent) << "s." << name << " = op" << depth
                       << "->getAttrOfType<" << namedAttr->attr.getStorageType()
                       << ">(\"" << namedAttr->getName() << "\");\n";
   }
 }
 
-void PatternEmitter::emitMatchMethod(DagNode tree) {
-  // Emit the heading.
+void PatternEmitter::emitMatchAndRewriteMethod(DagNode tree) {
   os << R"(
-  PatternMatchResult match(Operation *op0) const override {
+  PatternMatchResult matchAndRewrite(Operation *op0,
+                                     PatternRewriter &rewriter) const override {
     auto ctx = op0->getContext(); (void)ctx;
-    auto state = llvm::make_unique<MatchedState>();)"
-     << "\n";
+    MatchedState s; (void)s;
+)";
+  emitMatchLogic(tree);
+  emitRewriteLogic();
+  os.indent(4) << "return matchSuccess();\n  }\n";
+}
 
+void PatternEmitter::emitMatchLogic(DagNode tree) {
   // The rewrite pattern may specify that certain outputs should be unused in
   // the source IR. Check it here.
   for (int i = 0, e = pattern.getNumResults(); i < e; ++i) {
@@ -293,7 +309,7 @@ void PatternEmitter::emitMatchMethod(DagNode tree) {
 
   auto deduceName = [&](const std::string &name) -> std::string {
     if (pattern.isArgBoundInSourcePattern(name)) {
-      return boundArgNameInMatch(name).str();
+      return boundArgName(name).str();
     }
     if (pattern.isResultBoundInSourcePattern(name)) {
       return resultName(name).str();
@@ -333,7 +349,6 @@ void PatternEmitter::emitMatchMethod(DagNode tree) {
     }
   }
 
-  os.indent(4) << "return matchSuccess(std::move(state));\n  }\n";
 }
 
 void PatternEmitter::emit(StringRef rewriteName) {
@@ -354,7 +369,7 @@ void PatternEmitter::emit(StringRef rewriteName) {
      << "\n";
 
   // Emit matched state.
-  os << "  struct MatchedState : public PatternState {\n";
+  os << "  struct MatchedState {\n";
   for (const auto &arg : pattern.getSourcePatternBoundArgs()) {
     auto fieldName = arg.first();
     if (auto namedAttr = arg.second.dyn_cast<NamedAttribute *>()) {
@@ -366,13 +381,12 @@ void PatternEmitter::emit(StringRef rewriteName) {
   }
   os << "  };\n";
 
-  emitMatchMethod(tree);
-  emitRewriteMethod();
+  emitMatchAndRewriteMethod(tree);
 
   os << "};\n";
 }
 
-void PatternEmitter::emitRewriteMethod() {
+void PatternEmitter::emitRewriteLogic() {
   const Operator &rootOp = pattern.getSourceRootOp();
   int numExpectedResults = rootOp.getNumResults();
   unsigned numProvidedResults = pattern.getNumResults();
@@ -381,12 +395,7 @@ void PatternEmitter::emitRewriteMethod() {
     PrintFatalError(
         loc, "no enough result patterns to replace root op in source pattern");
 
-  os << R"(
-  void rewrite(Operation *op, std::unique_ptr<PatternState> state,
-               PatternRewriter &rewriter) const override {
-    auto& s = *static_cast<MatchedState *>(state.get());
-    auto loc = op->getLoc(); (void)loc;
-)";
+  os.indent(4) << "auto loc = op0->getLoc(); (void)loc;\n";
 
   // Collect the replacement value for each result
   llvm::SmallVector<std::string, 2> resultValues;
@@ -396,12 +405,12 @@ void PatternEmitter::emitRewriteMethod() {
   }
 
   // Emit the final replaceOp() statement
-  os.indent(4) << "rewriter.replaceOp(op, {";
+  os.indent(4) << "rewriter.replaceOp(op0, {";
   interleave(
       // We only use the last numExpectedResults ones to replace the root op.
       ArrayRef<std::string>(resultValues).take_back(numExpectedResults),
       [&](const std::string &name) { os << name; }, [&]() { os << ", "; });
-  os << "});\n  }\n";
+  os << "});\n";
 }
 
 std::string PatternEmitter::getUniqueValueName(const Operator *op) {
@@ -421,7 +430,7 @@ std::string PatternEmitter::handleRewritePattern(DagNode resultTree,
                            "verify top-level result");
     }
     // The C++ statements to check that this result value is unused are already
-    // emitted in the match() method. So returning a nullptr here directly
+    // emitted by the match logic. So returning a nullptr here directly
     // should be safe because the C++ RewritePattern harness will use it to
     // replace nothing.
     return "nullptr";
@@ -444,7 +453,7 @@ std::string PatternEmitter::handleReplaceWithValue(DagNode tree) {
   auto name = tree.getArgName(0);
   pattern.ensureArgBoundInSourcePattern(name);
 
-  return boundArgNameInRewrite(name).str();
+  return boundArgName(name).str();
 }
 
 void PatternEmitter::handleVerifyUnusedValue(DagNode tree, int index) {
@@ -466,7 +475,7 @@ std::string PatternEmitter::handleOpArgument(DagLeaf leaf,
     return handleConstantAttr(enumCase, enumCase.getSymbol());
   }
   pattern.ensureArgBoundInSourcePattern(argName);
-  std::string result = boundArgNameInRewrite(argName).str();
+  std::string result = boundArgName(argName).str();
   if (leaf.isUnspecified() || leaf.isOperandMatcher()) {
     return result;
   }
@@ -546,7 +555,7 @@ std::string PatternEmitter::emitOpCreate(DagNode tree, int resultIndex,
     auto name = tree.getArgName(index);
     if (this->pattern.isArgBoundInSourcePattern(name)) {
       // Bound in source pattern, explicitly named
-      return boundArgNameInRewrite(name).str();
+      return boundArgName(name).str();
     }
 
     // Bound in result pattern, explicitly named
@@ -567,7 +576,7 @@ std::string PatternEmitter::emitOpCreate(DagNode tree, int resultIndex,
     os.indent(4) << formatv("auto {0} = rewriter.create<{1}>(loc", resultValue,
                             resultOp.getQualCppClassName());
   } else {
-    std::string resultType = formatv("op->getResult({0})", resultIndex).str();
+    std::string resultType = formatv("op0->getResult({0})", resultIndex).str();
 
     os.indent(4) << formatv(
         "auto {0} = rewriter.create<{1}>(loc, {2}->getType()", resultValue,
@@ -625,7 +634,7 @@ std::string PatternEmitter::emitReplaceWithNativeBuilder(DagNode resultTree) {
   std::string value = formatv("v{0}", nextValueId++).str();
 
   os.indent(4) << "auto " << value << " = " << resultTree.getNativeCodeBuilder()
-               << "(op, {";
+               << "(op0, {";
   const auto &boundedValues = pattern.getSourcePatternBoundArgs();
   bool first = true;
   bool printingAttr = false;
@@ -640,7 +649,7 @@ std::string PatternEmitter::emitReplaceWithNativeBuilder(DagNode resultTree) {
     }
     if (!first)
       os << ",";
-    os << boundArgNameInRewrite(name);
+    os << boundArgName(name);
     first = false;
   }
   if (!printingAttr)
@@ -655,6 +664,104 @@ void PatternEmitter::emit(StringRef rewriteName, Record *p,
   PatternEmitter(p, mapper, os).emit(rewriteName);
 }
 
+namespace {
+// A generated pattern, as seen by the merged pattern of its root op.
+struct MergeCandidate {
+  std::string rewriteName;
+  int benefit;
+  // The checks on the ops defining the operands of the root op done by the
+  // pattern, as pairs of an operand index and the C++ class of the op.
+  SmallVector<std::pair<unsigned, std::string>, 2> operandChecks;
+};
+} // end namespace
+
+// Returns the checks on the ops defining the root operands in `pattern`.
+static SmallVector<std::pair<unsigned, std::string>, 2>
+getOperandChecks(Pattern &pattern, RecordOperatorMap *mapper) {
+  SmallVector<std::pair<unsigned, std::string>, 2> checks;
+  DagNode tree = pattern.getSourcePattern();
+  const Operator &rootOp = pattern.getSourceRootOp();
+  for (int i = 0, e = std::min<int>(tree.getNumArgs(),
+                                    rootOp.getNumOperands());
+       i != e; ++i)
+    if (DagNode argTree = tree.getArgAsNestedDag(i))
+      checks.emplace_back(i,
+                          argTree.getDialectOp(mapper).getQualCppClassName());
+  return checks;
+}
+
+// Emits the mlir::RewritePattern struct named `mergedName` matching the
+// `members` rooted at op `rootName`, sorted by decreasing benefit.  The ops
+// defining the root operands are looked up and checked once, and the members
+// whose checks fail are skipped without calling their matchAndRewrite()
+// method; the consecutive members doing the same checks share them.
+static void emitMergedPattern(StringRef mergedName, StringRef rootName,
+                              ArrayRef<MergeCandidate> members,
+                              raw_ostream &os) {
+  os << formatv("struct {0} : public RewritePattern {{\n", mergedName);
+  os.indent(2) << formatv("{0}(MLIRContext *context)\n", mergedName);
+  os.indent(6) << formatv(": RewritePattern(\"{0}\", {1}, context)", rootName,
+                          members.front().benefit);
+  for (unsigned i = 0, e = members.size(); i != e; ++i)
+    os << formatv(", pattern{0}(context)", i);
+  os << " {}\n";
+  os << R"(
+  PatternMatchResult matchAndRewrite(Operation *op0,
+                                     PatternRewriter &rewriter) const override {
+)";
+
+  // Number the distinct checks, and look up the defining ops they need.
+  SmallVector<std::pair<unsigned, std::string>, 4> checks;
+  SmallVector<SmallVector<unsigned, 2>, 4> memberChecks;
+  llvm::SmallSet<unsigned, 4> definedOperands;
+  for (const auto &member : members) {
+    memberChecks.emplace_back();
+    for (const auto &check : member.operandChecks) {
+      auto it = llvm::find(checks, check);
+      memberChecks.back().push_back(it - checks.begin());
+      if (it != checks.end())
+        continue;
+      checks.push_back(check);
+      if (definedOperands.insert(check.first).second)
+        os.indent(4) << formatv(
+            "auto *def{0} = op0->getOperand({0})->getDefiningOp();\n",
+            check.first);
+    }
+  }
+  for (unsigned i = 0, e = checks.size(); i != e; ++i)
+    os.indent(4) << formatv("bool check{0} = def{1} && def{1}->isa<{2}>();\n",
+                            i, checks[i].first, checks[i].second);
+
+  for (unsigned i = 0, e = members.size(); i != e;) {
+    // Collect the run of members doing the same checks.
+    unsigned end = i + 1;
+    while (end != e && memberChecks[end] == memberChecks[i])
+      ++end;
+    int indent = 4;
+    if (!memberChecks[i].empty()) {
+      os.indent(4) << "if (";
+      interleave(
+          memberChecks[i], [&](unsigned check) { os << "check" << check; },
+          [&]() { os << " && "; });
+      os << ") {\n";
+      indent = 6;
+    }
+    for (; i != end; ++i) {
+      os.indent(indent) << formatv(
+          "if (pattern{0}.matchAndRewrite(op0, rewriter))\n", i);
+      os.indent(indent + 2) << "return matchSuccess();\n";
+    }
+    if (indent != 4)
+      os.indent(4) << "}\n";
+  }
+  os.indent(4) << "return matchFailure();\n  }\n";
+
+  os << "\n";
+  for (unsigned i = 0, e = members.size(); i != e; ++i)
+    os.indent(2) << members[i].rewriteName << " pattern" << i << ";\n";
+  os << "};\n";
+}
+
 static void emitRewriters(const RecordKeeper &recordKeeper, raw_ostream &os) {
   emitSourceFileHeader("Rewriters", os);
   const auto &patterns = recordKeeper.getAllDerivedDefinitions("Pattern");
@@ -665,17 +772,49 @@ static void emitRewriters(const RecordKeeper &recordKeeper, raw_ostream &os) {
   // Ensure unique patterns simply by appending unique suffix.
   std::string baseRewriteName = "GeneratedConvert";
   int rewritePatternCount = 0;
+  // The names of the patterns to register, and when merging, the patterns by
+  // root op in the order of their first definition.
+  SmallVector<std::string, 8> registeredNames;
+  llvm::MapVector<StringRef, std::vector<MergeCandidate>> patternsByRoot;
   for (Record *p : patterns) {
-    PatternEmitter::emit(baseRewriteName + llvm::utostr(rewritePatternCount++),
-                         p, &recordOpMap, os);
+    std::string rewriteName =
+        baseRewriteName + llvm::utostr(rewritePatternCount++);
+    PatternEmitter::emit(rewriteName, p, &recordOpMap, os);
+
+    if (!mergePatterns) {
+      registeredNames.push_back(rewriteName);
+      continue;
+    }
+    Pattern pattern(p, &recordOpMap);
+    patternsByRoot[pattern.getSourceRootOp().getOperationName()].push_back(
+        {rewriteName, pattern.getBenefit(),
+         getOperandChecks(pattern, &recordOpMap)});
+  }
+
+  // Emit the merged patterns of the root ops with several patterns.
+  int mergedPatternCount = 0;
+  for (auto &root : patternsByRoot) {
+    auto &members = root.second;
+    if (members.size() == 1) {
+      registeredNames.push_back(members.front().rewriteName);
+      continue;
+    }
+    std::stable_sort(members.begin(), members.end(),
+                     [](const MergeCandidate &l, const MergeCandidate &r) {
+                       return l.benefit > r.benefit;
+                     });
+    std::string mergedName =
+        "GeneratedMerged" + llvm::utostr(mergedPatternCount++);
+    emitMergedPattern(mergedName, root.first, members, os);
+    registeredNames.push_back(mergedName);
   }
 
   // Emit function to add the generated matchers to the pattern list.
   os << "void populateWithGenerated(MLIRContext *context, "
      << "OwningRewritePatternList *patterns) {\n";
-  for (unsigned i = 0; i != rewritePatternCount; ++i) {
-    os.indent(2) << "patterns->push_back(llvm::make_unique<" << baseRewriteName
-                 << i << ">(context));\n";
+  for (const auto &name : registeredNames) {
+    os.indent(2) << "patterns->push_back(llvm::make_unique<" << name
+                 << ">(context));\n";
   }
   os << "}\n";
 }
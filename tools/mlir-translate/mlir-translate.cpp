@@ -20,17 +20,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "mlir/IR/Location.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Module.h"
 #include "mlir/Parser.h"
 #include "mlir/Support/FileUtilities.h"
+#include "mlir/Support/ToolServer.h"
 #include "mlir/Translation.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 
 using namespace mlir;
@@ -43,6 +48,12 @@ static llvm::cl::opt<std::string>
     outputFilename("o", llvm::cl::desc("Output filename"),
                    llvm::cl::value_desc("filename"), llvm::cl::init("-"));
 
+static llvm::cl::opt<bool> serverMode(
+    "server",
+    llvm::cl::desc("Process the requests read from the standard input "
+                   "concurrently, each one holding an input file to translate"),
+    llvm::cl::init(false));
+
 static Module *parseMLIRInput(StringRef inputFilename, MLIRContext *context) {
   // Set up the input file.
   std::string errorMessage;
@@ -57,13 +68,22 @@ static Module *parseMLIRInput(StringRef inputFilename, MLIRContext *context) {
   return parseSourceFile(sourceMgr, context);
 }
 
+static llvm::cl::opt<bool> consumeOutput(
+    "consume-output",
+    llvm::cl::desc("Erase the body of each function of the output module once "
+                   "it is printed, for the translations to MLIR"),
+    llvm::cl::init(false));
+
 static bool printMLIROutput(Module &module, llvm::StringRef outputFilename) {
   if (failed(module.verify()))
     return true;
   auto file = openOutputFile(outputFilename);
   if (!file)
     return true;
-  module.print(file->os());
+  if (consumeOutput)
+    module.printAndConsume(file->os());
+  else
+    module.print(file->os());
   file->keep();
   return false;
 }
@@ -125,6 +145,73 @@ struct TranslationParser : public llvm::cl::parser<const TranslateFunction *> {
   }
 };
 
+// Serve the requests read from the standard input with `translate`, see
+// ToolServer.h.  The requests take no arguments.  Each one is translated in a
+// context of its own, and as the translations read and write files, their
+// inputs and outputs go through temporary files.
+static int serveRequests(const TranslateFunction &translate) {
+  auto handler = [&](ArrayRef<StringRef> args,
+                     std::unique_ptr<llvm::MemoryBuffer> input,
+                     llvm::raw_ostream &os,
+                     llvm::raw_ostream &diagOS) -> LogicalResult {
+    if (!args.empty()) {
+      diagOS << "unexpected request arguments\n";
+      return failure();
+    }
+
+    llvm::SmallString<128> inputPath, outputPath;
+    int inputFD;
+    if (auto error = llvm::sys::fs::createTemporaryFile(
+            "mlir-translate", "input", inputFD, inputPath)) {
+      diagOS << "cannot create a temporary file: " << error.message() << '\n';
+      return failure();
+    }
+    llvm::FileRemover inputRemover(inputPath);
+    {
+      llvm::raw_fd_ostream inputOS(inputFD, /*shouldClose=*/true);
+      inputOS << input->getBuffer();
+    }
+    if (auto error = llvm::sys::fs::createTemporaryFile(
+            "mlir-translate", "output", outputPath)) {
+      diagOS << "cannot create a temporary file: " << error.message() << '\n';
+      return failure();
+    }
+    llvm::FileRemover outputRemover(outputPath);
+
+    MLIRContext context;
+    context.registerDiagnosticHandler([&](Location location, StringRef message,
+                                          MLIRContext::DiagnosticKind kind) {
+      location.print(diagOS);
+      switch (kind) {
+      case MLIRContext::DiagnosticKind::Note:
+        diagOS << ": note: ";
+        break;
+      case MLIRContext::DiagnosticKind::Warning:
+        diagOS << ": warning: ";
+        break;
+      case MLIRContext::DiagnosticKind::Error:
+        diagOS << ": error: ";
+        break;
+      }
+      diagOS << message << '\n';
+    });
+    if (translate(inputPath, outputPath, &context))
+      return failure();
+
+    auto output = llvm::MemoryBuffer::getFile(outputPath);
+    if (!output) {
+      diagOS << "cannot read the translation output: "
+             << output.getError().message() << '\n';
+      return failure();
+    }
+    os << (*output)->getBuffer();
+    return success();
+  };
+
+  llvm::ThreadPool threadPool;
+  return failed(runToolServer(stdin, llvm::outs(), threadPool, handler));
+}
+
 int main(int argc, char **argv) {
   llvm::PrettyStackTraceProgram x(argc, argv);
   llvm::InitLLVM y(argc, argv);
@@ -135,6 +222,9 @@ int main(int argc, char **argv) {
                            llvm::cl::Required);
   llvm::cl::ParseCommandLineOptions(argc, argv, "MLIR translation driver\n");
 
+  if (serverMode)
+    return serveRequests(*translationRequested);
+
   MLIRContext context;
   return (*translationRequested)(inputFilename, outputFilename, &context);
 }
@@ -0,0 +1,112 @@
+//===- AffineStructuresTest.cpp - FlatAffineConstraints unit tests --------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Analysis/AffineStructures.h"
+#include "mlir/IR/IntegerSet.h"
+#include "mlir/IR/MLIRContext.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+TEST(FlatAffineConstraintsTest, AddIdKeepsCoefficients) {
+  // d0 - d1 >= 0, d1 == 3.
+  FlatAffineConstraints cst(/*numDims=*/2);
+  cst.addInequality({1, -1, 0});
+  cst.addEquality({0, 1, -3});
+
+  // Insert identifiers one at a time, which grows the reserved columns.
+  for (unsigned i = 0; i < 5; ++i)
+    cst.addDimId(1);
+  ASSERT_EQ(cst.getNumCols(), 8u);
+  EXPECT_EQ(cst.atIneq(0, 0), 1);
+  for (unsigned i = 1; i < 6; ++i) {
+    EXPECT_EQ(cst.atIneq(0, i), 0);
+    EXPECT_EQ(cst.atEq(0, i), 0);
+  }
+  EXPECT_EQ(cst.atIneq(0, 6), -1);
+  EXPECT_EQ(cst.atIneq(0, 7), 0);
+  EXPECT_EQ(cst.atEq(0, 6), 1);
+  EXPECT_EQ(cst.atEq(0, 7), -3);
+}
+
+TEST(FlatAffineConstraintsTest, FourierMotzkinOverflow) {
+  // (2^31 + 1) * d0 + 2^40 * d1 >= 0, -(2^31 - 1) * d0 + 2^40 * d1 >= 0,
+  // 0 <= d1 <= 10. Combining the first two bounds of d0 overflows, so that
+  // combination is dropped when projecting out d0.
+  int64_t a = (int64_t(1) << 31) + 1, b = (int64_t(1) << 31) - 1;
+  int64_t c = int64_t(1) << 40;
+  FlatAffineConstraints cst(/*numDims=*/2);
+  cst.addInequality({a, c, 0});
+  cst.addInequality({-b, c, 0});
+  cst.addInequality({0, 1, 0});
+  cst.addInequality({0, -1, 10});
+  cst.projectOut(0, 1);
+  ASSERT_EQ(cst.getNumIds(), 1u);
+  EXPECT_EQ(cst.getNumInequalities(), 2u);
+  EXPECT_EQ(cst.getConstantLowerBound(0), Optional<int64_t>(0));
+  EXPECT_EQ(cst.getConstantUpperBound(0), Optional<int64_t>(10));
+}
+
+TEST(FlatAffineConstraintsTest, Stats) {
+  // 0 <= d0 <= 10, d1 == d0, d1 <= d2 <= 20.
+  FlatAffineConstraints cst(/*numDims=*/3);
+  cst.addInequality({1, 0, 0, 0});
+  cst.addInequality({-1, 0, 0, 10});
+  cst.addEquality({-1, 1, 0, 0});
+  cst.addInequality({0, -1, 1, 0});
+  cst.addInequality({0, 0, -1, 20});
+
+  // Projecting out d0 substitutes it through the equality, projecting out d1
+  // then combines its bounds.
+  resetFlatAffineConstraintsStats();
+  cst.projectOut(0, 2);
+  FlatAffineConstraintsStats stats = getFlatAffineConstraintsStats();
+  EXPECT_EQ(stats.numGaussianEliminations, 1u);
+  EXPECT_EQ(stats.numFourierMotzkinEliminations, 1u);
+  EXPECT_EQ(stats.numEmptinessChecks, 0u);
+  EXPECT_EQ(stats.maxNumConstraints, 4u);
+
+  EXPECT_FALSE(cst.isEmpty());
+  EXPECT_EQ(getFlatAffineConstraintsStats().numEmptinessChecks, 1u);
+
+  resetFlatAffineConstraintsStats();
+  stats = getFlatAffineConstraintsStats();
+  EXPECT_EQ(stats.numGaussianEliminations, 0u);
+  EXPECT_EQ(stats.maxNumConstraints, 0u);
+}
+
+TEST(FlatAffineConstraintsTest, SimplifyIntegerSetIsMemoized) {
+  MLIRContext context;
+  auto d0 = getAffineDimExpr(0, &context);
+
+  // d0 >= 0, -d0 - 1 >= 0 has no integer points.
+  auto emptySet = IntegerSet::get(1, 0, {d0, -d0 - 1}, {false, false});
+  resetFlatAffineConstraintsStats();
+  EXPECT_TRUE(simplifyIntegerSet(emptySet).isEmptyIntegerSet());
+  uint64_t numChecks = getFlatAffineConstraintsStats().numEmptinessChecks;
+  EXPECT_GE(numChecks, 1u);
+  EXPECT_EQ(simplifyIntegerSet(emptySet),
+            IntegerSet::getEmptySet(1, 0, &context));
+  EXPECT_EQ(getFlatAffineConstraintsStats().numEmptinessChecks, numChecks);
+
+  // d0 >= 0 is kept as is, and only analyzed once as well.
+  auto set = IntegerSet::get(1, 0, d0, false);
+  EXPECT_EQ(simplifyIntegerSet(set), set);
+  numChecks = getFlatAffineConstraintsStats().numEmptinessChecks;
+  EXPECT_EQ(simplifyIntegerSet(set), set);
+  EXPECT_EQ(getFlatAffineConstraintsStats().numEmptinessChecks, numChecks);
+}
@@ -0,0 +1,115 @@
+//===- DependenceAnalysisTest.cpp - DependenceAnalysis unit tests ---------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Analysis/AffineAnalysis.h"
+#include "mlir/AffineOps/AffineOps.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Parser.h"
+#include "mlir/StandardOps/Ops.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+const char kModule[] = R"mlir(
+func @f(%m: memref<10xf32>, %n: memref<10xf32>) {
+  %cf = constant 1.0 : f32
+  affine.for %i0 = 0 to 10 {
+    store %cf, %m[%i0] : memref<10xf32>
+    %v = load %m[%i0] : memref<10xf32>
+  }
+  affine.for %i1 = 0 to 10 {
+    %w = load %n[%i1] : memref<10xf32>
+  }
+  return
+}
+)mlir";
+
+class DependenceAnalysisTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    module.reset(parseSourceString(kModule, &context));
+    ASSERT_TRUE(module);
+    function = module->getNamedFunction("f");
+    ASSERT_TRUE(function);
+    function->walk([&](Operation *op) {
+      if (op->isa<AffineForOp>())
+        loops.push_back(op);
+      else if (op->isa<StoreOp>() || op->isa<LoadOp>())
+        accesses.push_back(op);
+    });
+    ASSERT_EQ(loops.size(), 2u);
+    ASSERT_EQ(accesses.size(), 3u);
+    store = accesses[0];
+    load = accesses[1];
+  }
+
+  // Stores to %n instead of %m, which removes the dependence from the store to
+  // the load in the first loop.
+  void redirectStore() { store->setOperand(1, function->getArgument(1)); }
+
+  MLIRContext context;
+  std::unique_ptr<Module> module;
+  Function *function = nullptr;
+  SmallVector<Operation *, 2> loops;
+  SmallVector<Operation *, 3> accesses;
+  Operation *store = nullptr;
+  Operation *load = nullptr;
+};
+
+TEST_F(DependenceAnalysisTest, CachedUntilInvalidated) {
+  DependenceAnalysis dependences(function);
+  // The loop independent dependence is checked at depth 2.
+  EXPECT_TRUE(dependences.checkDependence(store, load, /*loopDepth=*/2));
+
+  // The cached result is returned as long as the loop is not invalidated, and
+  // it is kept when an unrelated loop is.
+  redirectStore();
+  EXPECT_TRUE(dependences.checkDependence(store, load, /*loopDepth=*/2));
+  dependences.invalidate(loops[1]);
+  EXPECT_TRUE(dependences.checkDependence(store, load, /*loopDepth=*/2));
+
+  dependences.invalidate(loops[0]);
+  EXPECT_FALSE(dependences.checkDependence(store, load, /*loopDepth=*/2));
+}
+
+TEST_F(DependenceAnalysisTest, CachedComponents) {
+  DependenceAnalysis dependences(function);
+  // A query without components is answered from the cache once they have been
+  // computed.
+  SmallVector<DependenceComponent, 2> components;
+  EXPECT_TRUE(
+      dependences.checkDependence(store, load, /*loopDepth=*/2, &components));
+  ASSERT_EQ(components.size(), 1u);
+  EXPECT_EQ(components[0].lb.getValue(), 0);
+  EXPECT_EQ(components[0].ub.getValue(), 0);
+
+  redirectStore();
+  EXPECT_TRUE(dependences.checkDependence(store, load, /*loopDepth=*/2));
+  components.clear();
+  EXPECT_TRUE(
+      dependences.checkDependence(store, load, /*loopDepth=*/2, &components));
+  EXPECT_EQ(components.size(), 1u);
+
+  dependences.clear();
+  EXPECT_FALSE(
+      dependences.checkDependence(store, load, /*loopDepth=*/2, &components));
+}
+
+} // end anonymous namespace
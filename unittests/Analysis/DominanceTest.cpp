@@ -0,0 +1,105 @@
+//===- DominanceTest.cpp - Dominance unit tests ---------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Analysis/Dominance.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+/// Replace the terminator of 'block', if any, with one branching to
+/// 'successors'.
+void setTerminator(MLIRContext *context, Block *block,
+                   ArrayRef<Block *> successors) {
+  if (!block->empty())
+    block->back().erase();
+  block->push_back(Operation::create(
+      UnknownLoc::get(context), OperationName("test.br", context),
+      /*operands=*/llvm::None, /*resultTypes=*/llvm::None,
+      ArrayRef<NamedAttribute>(), successors, /*numRegions=*/0,
+      /*resizableOperandList=*/false, context));
+}
+
+/// Check that the dominance and postdominance relations of 'domInfo' and
+/// 'postDomInfo' match those computed from scratch for 'function'.
+void checkMatchesRecalculation(Function *function, DominanceInfo &domInfo,
+                               PostDominanceInfo &postDomInfo) {
+  DominanceInfo freshDomInfo(function);
+  PostDominanceInfo freshPostDomInfo(function);
+  for (auto &a : *function) {
+    for (auto &b : *function) {
+      EXPECT_EQ(domInfo.dominates(&a, &b), freshDomInfo.dominates(&a, &b));
+      EXPECT_EQ(postDomInfo.postDominates(&a, &b),
+                freshPostDomInfo.postDominates(&a, &b));
+    }
+  }
+}
+
+TEST(DominanceTest, IncrementalUpdates) {
+  MLIRContext context;
+  Builder builder(&context);
+  std::unique_ptr<Function> function(
+      new Function(builder.getUnknownLoc(), "foo",
+                   builder.getFunctionType(llvm::None, llvm::None)));
+
+  // Build a diamond: entry -> {left, right} -> exit.
+  auto *entry = new Block(), *left = new Block(), *right = new Block(),
+       *exit = new Block();
+  for (auto *block : {entry, left, right, exit})
+    function->push_back(block);
+  setTerminator(&context, entry, {left, right});
+  setTerminator(&context, left, exit);
+  setTerminator(&context, right, exit);
+  setTerminator(&context, exit, {});
+
+  DominanceInfo domInfo(function.get());
+  PostDominanceInfo postDomInfo(function.get());
+  EXPECT_FALSE(domInfo.dominates(left, exit));
+
+  // Remove the edge to 'right', 'left' now dominates 'exit'.
+  setTerminator(&context, entry, left);
+  domInfo.deleteEdge(entry, right);
+  postDomInfo.deleteEdge(entry, right);
+  EXPECT_TRUE(domInfo.dominates(left, exit));
+  checkMatchesRecalculation(function.get(), domInfo, postDomInfo);
+
+  // Split 'left' by inserting a new block between it and 'exit'.
+  auto *split = new Block();
+  split->insertBefore(exit);
+  setTerminator(&context, left, split);
+  setTerminator(&context, split, exit);
+  using UpdateKind = DominanceInfo::UpdateKind;
+  DominanceInfo::UpdateType updates[] = {
+      {UpdateKind::Insert, left, split},
+      {UpdateKind::Insert, split, exit},
+      {UpdateKind::Delete, left, exit}};
+  domInfo.applyUpdates(updates);
+  postDomInfo.applyUpdates(updates);
+  EXPECT_TRUE(domInfo.properlyDominates(split, exit));
+  EXPECT_TRUE(postDomInfo.properlyPostDominates(split, left));
+  checkMatchesRecalculation(function.get(), domInfo, postDomInfo);
+
+  // Restore the edge to 'right'.
+  setTerminator(&context, entry, {left, right});
+  domInfo.insertEdge(entry, right);
+  postDomInfo.insertEdge(entry, right);
+  EXPECT_FALSE(domInfo.dominates(left, exit));
+  checkMatchesRecalculation(function.get(), domInfo, postDomInfo);
+}
+} // end anonymous namespace
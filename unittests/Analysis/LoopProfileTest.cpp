@@ -0,0 +1,71 @@
+//===- LoopProfileTest.cpp - Loop profile unit tests ----------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Analysis/LoopProfile.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+TEST(LoopProfileTest, Parse) {
+  std::string errorMessage;
+  auto profile = LoopProfile::parse("# <entries> <iterations> <nanoseconds> "
+                                    "<name>\n"
+                                    "1 1 5000 func @f f.mlir:1:6\n"
+                                    "\n"
+                                    "2 200 4000 affine.for @f f.mlir:2:3\n",
+                                    &errorMessage);
+  ASSERT_TRUE(profile) << errorMessage;
+
+  const ProfileCounters *function = profile->lookup("func @f f.mlir:1:6");
+  ASSERT_TRUE(function);
+  EXPECT_EQ(function->entries, 1u);
+  EXPECT_EQ(function->nanoseconds, 5000);
+
+  const ProfileCounters *loop = profile->lookup("affine.for @f f.mlir:2:3");
+  ASSERT_TRUE(loop);
+  EXPECT_EQ(loop->entries, 2u);
+  EXPECT_EQ(loop->iterations, 200u);
+  EXPECT_EQ(loop->nanoseconds, 4000);
+
+  EXPECT_FALSE(profile->lookup("affine.for @f f.mlir:3:5"));
+}
+
+TEST(LoopProfileTest, SumDuplicates) {
+  std::string errorMessage;
+  auto profile = LoopProfile::parse("1 10 100 affine.for @f f.mlir:2:3\n"
+                                    "3 30 200 affine.for @f f.mlir:2:3\n",
+                                    &errorMessage);
+  ASSERT_TRUE(profile) << errorMessage;
+  const ProfileCounters *loop = profile->lookup("affine.for @f f.mlir:2:3");
+  ASSERT_TRUE(loop);
+  EXPECT_EQ(loop->entries, 4u);
+  EXPECT_EQ(loop->iterations, 40u);
+  EXPECT_EQ(loop->nanoseconds, 300);
+}
+
+TEST(LoopProfileTest, ParseError) {
+  std::string errorMessage;
+  EXPECT_FALSE(LoopProfile::parse("1 1 100 func @f f.mlir:1:6\n"
+                                  "1 x 100 affine.for @f f.mlir:2:3\n",
+                                  &errorMessage));
+  EXPECT_EQ(errorMessage,
+            "line 2: expected '<entries> <iterations> <nanoseconds> <name>'");
+
+  EXPECT_FALSE(LoopProfile::parse("1 1 100\n", &errorMessage));
+  EXPECT_EQ(errorMessage,
+            "line 1: expected '<entries> <iterations> <nanoseconds> <name>'");
+}
@@ -0,0 +1,150 @@
+//===- SimplexTest.cpp - Simplex unit tests -------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Analysis/Simplex.h"
+#include "mlir/Analysis/AffineStructures.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+TEST(SimplexTest, RationallyEmpty) {
+  // x >= 1, x <= 0.
+  Simplex simplex(1);
+  simplex.addInequality({1, -1});
+  EXPECT_FALSE(simplex.isEmpty());
+  simplex.addInequality({-1, 0});
+  EXPECT_TRUE(simplex.isEmpty());
+  EXPECT_FALSE(simplex.hasOverflowed());
+}
+
+TEST(SimplexTest, IntegerEmpty) {
+  // 2x == 1 has the rational solution x = 1/2, but no integer solution.
+  Simplex simplex(1);
+  simplex.addEquality({2, -1});
+  EXPECT_FALSE(simplex.isEmpty());
+  Fraction sample = simplex.getSampleValue(0);
+  EXPECT_EQ(sample.num, 1);
+  EXPECT_EQ(sample.den, 2);
+  EXPECT_EQ(simplex.isIntegerEmpty(/*maxNodes=*/8), Optional<bool>(true));
+}
+
+TEST(SimplexTest, IntegerNonEmpty) {
+  // 2 <= 3x <= 4 contains x = 1.
+  Simplex simplex(1);
+  simplex.addInequality({3, -2});
+  simplex.addInequality({-3, 4});
+  EXPECT_EQ(simplex.isIntegerEmpty(/*maxNodes=*/8), Optional<bool>(false));
+}
+
+TEST(SimplexTest, Optimum) {
+  // 0 <= x <= 10, 0 <= y <= 10, x + y <= 15.
+  Simplex simplex(2);
+  simplex.addInequality({1, 0, 0});
+  simplex.addInequality({-1, 0, 10});
+  simplex.addInequality({0, 1, 0});
+  simplex.addInequality({0, -1, 10});
+  simplex.addInequality({-1, -1, 15});
+
+  auto max = simplex.computeOptimum(Simplex::Direction::Up, {1, 1, 0});
+  ASSERT_TRUE(max.hasValue());
+  EXPECT_EQ(max->num, 15);
+  EXPECT_EQ(max->den, 1);
+
+  auto min = simplex.computeOptimum(Simplex::Direction::Down, {1, -1, 2});
+  ASSERT_TRUE(min.hasValue());
+  EXPECT_EQ(min->num, -8);
+  EXPECT_EQ(min->den, 1);
+
+  // The queries do not modify the tableau.
+  EXPECT_FALSE(simplex.isEmpty());
+  max = simplex.computeOptimum(Simplex::Direction::Up, {2, 1, 0});
+  ASSERT_TRUE(max.hasValue());
+  EXPECT_EQ(max->num, 25);
+}
+
+TEST(SimplexTest, RationalOptimum) {
+  // 2x <= 3.
+  Simplex simplex(1);
+  simplex.addInequality({-2, 3});
+  auto max = simplex.computeOptimum(Simplex::Direction::Up, {1, 0});
+  ASSERT_TRUE(max.hasValue());
+  EXPECT_EQ(max->num, 3);
+  EXPECT_EQ(max->den, 2);
+  EXPECT_EQ(max->floor(), 1);
+}
+
+TEST(SimplexTest, Unbounded) {
+  // x >= 0.
+  Simplex simplex(1);
+  simplex.addInequality({1, 0});
+  EXPECT_FALSE(
+      simplex.computeOptimum(Simplex::Direction::Up, {1, 0}).hasValue());
+  auto min = simplex.computeOptimum(Simplex::Direction::Down, {1, 0});
+  ASSERT_TRUE(min.hasValue());
+  EXPECT_EQ(min->num, 0);
+}
+
+TEST(SimplexTest, LexMin) {
+  // x + y >= 3, x >= 1, y >= 0: the lexicographic minimum is (1, 2).
+  Simplex simplex(2);
+  simplex.addInequality({1, 1, -3});
+  simplex.addInequality({1, 0, -1});
+  simplex.addInequality({0, 1, 0});
+  auto lexMin = simplex.computeRationalLexOptimum(Simplex::Direction::Down);
+  ASSERT_TRUE(lexMin.hasValue());
+  ASSERT_EQ(lexMin->size(), 2u);
+  EXPECT_EQ((*lexMin)[0].num, 1);
+  EXPECT_EQ((*lexMin)[1].num, 2);
+
+  // The lexicographic maximum is unbounded.
+  EXPECT_FALSE(
+      simplex.computeRationalLexOptimum(Simplex::Direction::Up).hasValue());
+}
+
+TEST(SimplexTest, FlatAffineConstraintsIsEmpty) {
+  // 1 <= 3 * d0 <= 2 has no integer solution, which Fourier-Motzkin
+  // elimination alone does not detect.
+  FlatAffineConstraints cst(/*numDims=*/1);
+  cst.addInequality({3, -1});
+  cst.addInequality({-3, 2});
+  EXPECT_TRUE(cst.isEmpty());
+
+  cst.addInequality({-3, 5});
+  cst.removeInequality(1);
+  EXPECT_FALSE(cst.isEmpty());
+}
+
+TEST(SimplexTest, FlatAffineConstraintsBounds) {
+  // d0 == d1, 0 <= d1 <= 7.
+  FlatAffineConstraints cst(/*numDims=*/2);
+  cst.addEquality({1, -1, 0});
+  cst.addInequality({0, 1, 0});
+  cst.addInequality({0, -1, 7});
+
+  EXPECT_EQ(cst.getConstantLowerBound(0), Optional<int64_t>(0));
+  EXPECT_EQ(cst.getConstantUpperBound(0), Optional<int64_t>(7));
+
+  SmallVector<int64_t, 4> lb, ub;
+  int64_t lbFloorDivisor;
+  EXPECT_EQ(cst.getConstantBoundOnDimSize(0, &lb, &lbFloorDivisor, &ub),
+            Optional<int64_t>(8));
+  EXPECT_EQ(lbFloorDivisor, 1);
+  ASSERT_EQ(lb.size(), 1u);
+  EXPECT_EQ(lb[0], 0);
+  ASSERT_EQ(ub.size(), 1u);
+  EXPECT_EQ(ub[0], 7);
+}
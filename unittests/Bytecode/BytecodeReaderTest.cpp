@@ -0,0 +1,114 @@
+//===- BytecodeReaderTest.cpp - Bytecode reader unit tests ----------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/Bytecode/Bytecode.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+/// The header of a bytecode file: the magic number and version 1.
+const char kHeader[] = {'M', 'L', '\xEF', 'R', 1};
+
+/// The varint encoding of 2^32 - 1.
+const char kHugeCount[] = {'\xFF', '\xFF', '\xFF', '\xFF', '\x0F'};
+
+/// Return a bytecode file holding a single function `@f() -> ()` whose body is
+/// the given bytes.
+std::string getSingleFunctionFile(StringRef body) {
+  std::string file(kHeader, sizeof(kHeader));
+  // Strings "f" and "() -> ()", the type "() -> ()", the symbol @f, no
+  // attributes and an unknown location.
+  file += std::string("\x02\x01"
+                      "f"
+                      "\x08"
+                      "() -> ()"
+                      "\x01\x01"
+                      "\x01\x00\x00"
+                      "\x00"
+                      "\x01\x00",
+                      20);
+  // The location and attributes of @f, and the range of its body.
+  file += std::string("\x00\x00\x00", 3);
+  file += char(body.size());
+  file += char(body.size());
+  file += body;
+  return file;
+}
+
+/// Read the given bytecode, returning the module and recording the error
+/// message emitted on failure.
+std::unique_ptr<Module> read(StringRef file, MLIRContext &context,
+                             std::string &error) {
+  context.registerDiagnosticHandler(
+      [&](Location, StringRef message, MLIRContext::DiagnosticKind) {
+        error = message;
+      });
+  llvm::MemoryBufferRef buffer(file, "bytecode");
+  return std::unique_ptr<Module>(readBytecodeFile(buffer, &context));
+}
+
+TEST(BytecodeReaderTest, ValidSingleFunctionFile) {
+  MLIRContext context;
+  std::string error;
+  // No values and no blocks.
+  auto module =
+      read(getSingleFunctionFile(StringRef("\x00\x00", 2)), context, error);
+  ASSERT_TRUE(module) << error;
+  ASSERT_TRUE(module->getNamedFunction("f"));
+  EXPECT_TRUE(module->getNamedFunction("f")->isExternal());
+}
+
+TEST(BytecodeReaderTest, RejectsOversizedStringCount) {
+  MLIRContext context;
+  std::string error;
+  std::string file(kHeader, sizeof(kHeader));
+  file.append(kHugeCount, sizeof(kHugeCount));
+  EXPECT_FALSE(read(file, context, error));
+  EXPECT_EQ(error, "malformed bytecode: entry count 4294967295 exceeds the 0 "
+                   "remaining bytes");
+}
+
+TEST(BytecodeReaderTest, RejectsOversizedValueCount) {
+  MLIRContext context;
+  std::string error;
+  auto file =
+      getSingleFunctionFile(StringRef(kHugeCount, sizeof(kHugeCount)));
+  EXPECT_FALSE(read(file, context, error));
+  EXPECT_EQ(error, "malformed bytecode: entry count 4294967295 exceeds the 0 "
+                   "remaining bytes");
+}
+
+TEST(BytecodeReaderTest, RejectsTruncatedCount) {
+  MLIRContext context;
+  std::string error;
+  // A string count that exceeds the remaining strings by one.
+  std::string file(kHeader, sizeof(kHeader));
+  file += std::string("\x03\x01"
+                      "a",
+                      3);
+  EXPECT_FALSE(read(file, context, error));
+  EXPECT_EQ(error,
+            "malformed bytecode: entry count 3 exceeds the 2 remaining bytes");
+}
+
+} // end anonymous namespace
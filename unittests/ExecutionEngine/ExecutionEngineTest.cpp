@@ -0,0 +1,108 @@
+//===- ExecutionEngineTest.cpp - ExecutionEngine unit tests ---------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Parser.h"
+#include "llvm/Support/TargetSelect.h"
+#include "gtest/gtest.h"
+#include <array>
+
+using namespace mlir;
+
+namespace {
+
+const char kModule[] = R"mlir(
+func @add(%a: f32, %b: f32) -> f32 {
+  %0 = addf %a, %b : f32
+  return %0 : f32
+}
+)mlir";
+
+class ExecutionEngineTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    module.reset(parseSourceString(kModule, &context));
+    ASSERT_TRUE(module);
+    auto expectedEngine = ExecutionEngine::create(module.get());
+    ASSERT_TRUE(!!expectedEngine)
+        << llvm::toString(expectedEngine.takeError());
+    engine = std::move(*expectedEngine);
+  }
+
+  MLIRContext context;
+  std::unique_ptr<Module> module;
+  std::unique_ptr<ExecutionEngine> engine;
+};
+
+TEST_F(ExecutionEngineTest, CachedHandle) {
+  auto expectedFunction = engine->getFunction("add");
+  ASSERT_TRUE(!!expectedFunction)
+      << llvm::toString(expectedFunction.takeError());
+  JITFunction add = *expectedFunction;
+  ASSERT_TRUE(static_cast<bool>(add));
+
+  // The handle may be called repeatedly, both with the packed arguments and
+  // with the arguments themselves.
+  float a = 1.0f, b = 2.0f, result = 0.0f;
+  add(a, b, result);
+  EXPECT_EQ(result, 3.0f);
+  a = 4.0f;
+  void *args[] = {&a, &b, &result};
+  add(args);
+  EXPECT_EQ(result, 6.0f);
+}
+
+TEST_F(ExecutionEngineTest, InvokeMany) {
+  constexpr unsigned kNumPacks = 16;
+  std::array<float, kNumPacks> lhs, rhs, results;
+  std::array<std::array<void *, 3>, kNumPacks> packs;
+  std::array<void **, kNumPacks> argumentPacks;
+  for (unsigned i = 0; i != kNumPacks; ++i) {
+    lhs[i] = i;
+    rhs[i] = 0.5f * i;
+    results[i] = -1.0f;
+    packs[i] = {{&lhs[i], &rhs[i], &results[i]}};
+    argumentPacks[i] = packs[i].data();
+  }
+
+  llvm::Error error = engine->invokeMany("add", argumentPacks, &context);
+  ASSERT_FALSE(static_cast<bool>(error)) << llvm::toString(std::move(error));
+  for (unsigned i = 0; i != kNumPacks; ++i)
+    EXPECT_EQ(results[i], 1.5f * i) << "pack " << i;
+}
+
+TEST_F(ExecutionEngineTest, UnknownFunction) {
+  auto expectedFunction = engine->getFunction("missing");
+  ASSERT_FALSE(!!expectedFunction);
+  std::string message = llvm::toString(expectedFunction.takeError());
+  EXPECT_NE(message.find("_mlir_missing"), std::string::npos) << message;
+
+  // The invocations are not attempted if the function can't be found.
+  float a = 1.0f, b = 2.0f, result = 0.0f;
+  void *args[] = {&a, &b, &result};
+  llvm::Error error = engine->invokeMany("missing", {args, args}, &context);
+  ASSERT_TRUE(static_cast<bool>(error));
+  message = llvm::toString(std::move(error));
+  EXPECT_NE(message.find("_mlir_missing"), std::string::npos) << message;
+  EXPECT_EQ(result, 0.0f);
+}
+
+} // end anonymous namespace
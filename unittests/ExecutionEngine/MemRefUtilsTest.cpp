@@ -0,0 +1,141 @@
+//===- MemRefUtilsTest.cpp - MemRef argument pack unit tests --------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/ExecutionEngine/MemRefUtils.h"
+#include "mlir/ExecutionEngine/ExecutionEngine.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Parser.h"
+#include "llvm/Support/TargetSelect.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+const char kModule[] = R"mlir(
+func @double_first(%a: memref<4xf32>) {
+  %c0 = constant 0 : index
+  %0 = load %a[%c0] : memref<4xf32>
+  %1 = addf %0, %0 : f32
+  store %1, %a[%c0] : memref<4xf32>
+  return
+}
+
+func @mark_last(%a: memref<?x3xi32>) -> memref<?x3xi32> {
+  %c1 = constant 1 : index
+  %c2 = constant 2 : index
+  %c7 = constant 7 : i32
+  %n = dim %a, 0 : memref<?x3xi32>
+  %last = subi %n, %c1 : index
+  store %c7, %a[%last, %c2] : memref<?x3xi32>
+  return %a : memref<?x3xi32>
+}
+)mlir";
+
+class MemRefUtilsTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    module.reset(parseSourceString(kModule, &context));
+    ASSERT_TRUE(module);
+  }
+
+  // Creates the pack of the function `name`, before the lowering of the
+  // module by the creation of the engine.
+  llvm::Expected<MemRefArgumentPack> createPack(StringRef name) {
+    return MemRefArgumentPack::create(module->getNamedFunction(name));
+  }
+
+  void createEngine() {
+    auto expectedEngine = ExecutionEngine::create(module.get());
+    ASSERT_TRUE(!!expectedEngine)
+        << llvm::toString(expectedEngine.takeError());
+    engine = std::move(*expectedEngine);
+  }
+
+  MLIRContext context;
+  std::unique_ptr<Module> module;
+  std::unique_ptr<ExecutionEngine> engine;
+};
+
+TEST_F(MemRefUtilsTest, StaticShape) {
+  auto expectedPack = createPack("double_first");
+  ASSERT_TRUE(!!expectedPack) << llvm::toString(expectedPack.takeError());
+  MemRefArgumentPack pack = std::move(*expectedPack);
+  EXPECT_EQ(pack.getNumArguments(), 1u);
+  EXPECT_EQ(pack.getNumResults(), 0u);
+  ASSERT_NO_FATAL_FAILURE(createEngine());
+
+  // The pack is rebound to another buffer between the invocations.
+  float first[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+  float second[4] = {5.0f, 6.0f, 7.0f, 8.0f};
+  for (float *buffer : {first, second, first}) {
+    llvm::Error error = pack.setArgument(0, buffer);
+    ASSERT_FALSE(static_cast<bool>(error)) << llvm::toString(std::move(error));
+    error = engine->invoke("double_first", pack.getPackedArguments());
+    ASSERT_FALSE(static_cast<bool>(error)) << llvm::toString(std::move(error));
+  }
+  EXPECT_EQ(first[0], 4.0f);
+  EXPECT_EQ(first[1], 2.0f);
+  EXPECT_EQ(second[0], 10.0f);
+  EXPECT_EQ(second[3], 8.0f);
+}
+
+TEST_F(MemRefUtilsTest, DynamicShapeAndResult) {
+  auto expectedPack = createPack("mark_last");
+  ASSERT_TRUE(!!expectedPack) << llvm::toString(expectedPack.takeError());
+  MemRefArgumentPack pack = std::move(*expectedPack);
+  EXPECT_EQ(pack.getNumArguments(), 1u);
+  EXPECT_EQ(pack.getNumResults(), 1u);
+  ASSERT_NO_FATAL_FAILURE(createEngine());
+
+  int32_t data[4][3] = {};
+  for (int64_t rows : {2, 4}) {
+    llvm::Error error = pack.setArgument(0, &data[0][0], {rows});
+    ASSERT_FALSE(static_cast<bool>(error)) << llvm::toString(std::move(error));
+    error = engine->invoke("mark_last", pack.getPackedArguments());
+    ASSERT_FALSE(static_cast<bool>(error)) << llvm::toString(std::move(error));
+
+    // The result is the argument, with the same dynamic size.
+    EXPECT_EQ(pack.getResultData<int32_t>(0), &data[0][0]);
+    ArrayRef<intptr_t> sizes = pack.getResultDynamicSizes(0);
+    ASSERT_EQ(sizes.size(), 1u);
+    EXPECT_EQ(sizes[0], rows);
+    EXPECT_EQ(data[rows - 1][2], 7);
+  }
+  EXPECT_EQ(data[0][2], 0);
+  EXPECT_EQ(data[2][2], 0);
+}
+
+TEST_F(MemRefUtilsTest, BindingErrors) {
+  auto expectedPack = createPack("mark_last");
+  ASSERT_TRUE(!!expectedPack) << llvm::toString(expectedPack.takeError());
+  MemRefArgumentPack pack = std::move(*expectedPack);
+
+  int32_t data[3] = {};
+  double doubles[3] = {};
+  EXPECT_EQ(llvm::toString(pack.setArgument(0, data)),
+            "expected 1 dynamic sizes");
+  EXPECT_EQ(llvm::toString(pack.setArgument(0, doubles, {1})),
+            "buffer element size does not match the memref element type");
+  EXPECT_EQ(llvm::toString(pack.setArgument(1, data, {1})),
+            "argument index out of range");
+}
+
+} // end anonymous namespace
@@ -0,0 +1,162 @@
+//===- AttributeTest.cpp - Attribute unit tests ---------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/StandardTypes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+TEST(DenseElementsAttrTest, IntegerValues) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({3}, builder.getIntegerType(32));
+
+  SmallVector<int32_t, 3> values = {1, -2, 3};
+  auto attr = DenseElementsAttr::get(type, ArrayRef<int32_t>(values));
+
+  // The values are stored as is, with the same padding as the elements of the
+  // attributes constructed otherwise.
+  EXPECT_EQ(attr, DenseIntElementsAttr::get(type, ArrayRef<int64_t>{1, -2, 3}));
+  EXPECT_TRUE(attr.isStoredAs<int32_t>());
+  EXPECT_TRUE(attr.isStoredAs<uint32_t>());
+  EXPECT_FALSE(attr.isStoredAs<int64_t>());
+  EXPECT_FALSE(attr.isStoredAs<float>());
+
+  auto typedValues = attr.getValues<int32_t>();
+  EXPECT_EQ(std::distance(typedValues.begin(), typedValues.end()), 3);
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), typedValues.begin()));
+  EXPECT_EQ(typedValues.begin()[1], -2);
+
+  SmallVector<APInt, 3> intValues(attr.getIntValues().begin(),
+                                  attr.getIntValues().end());
+  ASSERT_EQ(intValues.size(), 3u);
+  EXPECT_EQ(intValues[1].getBitWidth(), 32u);
+  EXPECT_EQ(intValues[1].getSExtValue(), -2);
+}
+
+TEST(DenseElementsAttrTest, FloatValues) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({2, 2}, builder.getF32Type());
+
+  SmallVector<float, 4> values = {0.5f, -1.0f, 2.25f, 8.0f};
+  auto attr = DenseElementsAttr::get(type, ArrayRef<float>(values));
+
+  SmallVector<APFloat, 4> apFloatValues;
+  for (float value : values)
+    apFloatValues.push_back(APFloat(value));
+  EXPECT_EQ(attr, DenseFPElementsAttr::get(type, apFloatValues));
+  EXPECT_TRUE(attr.isStoredAs<float>());
+  EXPECT_FALSE(attr.isStoredAs<double>());
+  EXPECT_FALSE(attr.isStoredAs<int32_t>());
+
+  auto typedValues = attr.getValues<float>();
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), typedValues.begin()));
+
+  unsigned index = 0;
+  for (APFloat value : attr.getFloatValues())
+    EXPECT_EQ(value.convertToFloat(), values[index++]);
+  EXPECT_EQ(index, 4u);
+}
+
+TEST(DenseElementsAttrTest, BoolIsNotStoredAsBool) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({1}, builder.getIntegerType(1));
+  auto attr = DenseIntElementsAttr::get(type, ArrayRef<int64_t>{1});
+
+  EXPECT_FALSE(attr.isStoredAs<bool>());
+  EXPECT_EQ((*attr.getIntValues().begin()).getZExtValue(), 1u);
+}
+
+TEST(DenseElementsAttrTest, SplatKeepsFirstElement) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({2, 2}, builder.getIntegerType(32));
+
+  auto attr = DenseIntElementsAttr::get(type, ArrayRef<int64_t>{5, 5, 5, 5});
+  EXPECT_TRUE(attr.isSplat());
+  EXPECT_EQ(attr.getRawData().size(), sizeof(uint64_t));
+  EXPECT_EQ(attr, DenseElementsAttr::get(type, ArrayRef<int32_t>{5, 5, 5, 5}));
+  int32_t element = 5;
+  EXPECT_EQ(attr, DenseElementsAttr::getSplat(
+                      type, ArrayRef<char>(reinterpret_cast<char *>(&element),
+                                           sizeof(element))));
+
+  // All of the elements read as the first one.
+  auto typedValues = attr.getValues<int32_t>();
+  EXPECT_EQ(std::distance(typedValues.begin(), typedValues.end()), 4);
+  EXPECT_TRUE(llvm::all_of(typedValues, [](int32_t v) { return v == 5; }));
+  EXPECT_EQ(attr.getValue({1, 1}).cast<IntegerAttr>().getInt(), 5);
+  SmallVector<APInt, 4> intValues;
+  attr.cast<DenseIntElementsAttr>().getValues(intValues);
+  ASSERT_EQ(intValues.size(), 4u);
+  EXPECT_EQ(intValues[3].getSExtValue(), 5);
+
+  EXPECT_FALSE(
+      DenseIntElementsAttr::get(type, ArrayRef<int64_t>{5, 5, 5, 6}).isSplat());
+}
+
+TEST(DenseElementsAttrTest, SubByteSplat) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({10}, builder.getIntegerType(1));
+
+  auto attr = DenseIntElementsAttr::get(type, SmallVector<int64_t, 10>(10, 1));
+  EXPECT_TRUE(attr.isSplat());
+  unsigned numElements = 0;
+  for (APInt value : attr.getIntValues()) {
+    EXPECT_TRUE(value.isOneValue());
+    ++numElements;
+  }
+  EXPECT_EQ(numElements, 10u);
+
+  SmallVector<int64_t, 10> values(10, 1);
+  values[9] = 0;
+  EXPECT_FALSE(DenseIntElementsAttr::get(type, values).isSplat());
+}
+
+TEST(DenseElementsAttrTest, ExternalData) {
+  // The data must outlive the context.
+  alignas(uint64_t) int32_t buffer[4] = {1, 2, 3, 4};
+  ArrayRef<char> data(reinterpret_cast<const char *>(buffer), sizeof(buffer));
+
+  MLIRContext context;
+  Builder builder(&context);
+  auto type = builder.getTensorType({4}, builder.getIntegerType(32));
+
+  auto attr = DenseElementsAttr::getExternal(type, data);
+  EXPECT_TRUE(attr.isExternal());
+  EXPECT_FALSE(attr.isSplat());
+  EXPECT_EQ(attr.getRawData().data(), data.data());
+  EXPECT_EQ(attr, DenseElementsAttr::getExternal(type, data));
+
+  // The external attributes are uniqued on the address of their data.
+  auto internalAttr = DenseElementsAttr::get(type, ArrayRef<int32_t>(buffer));
+  EXPECT_FALSE(internalAttr.isExternal());
+  EXPECT_NE(attr, internalAttr);
+
+  auto typedValues = attr.getValues<int32_t>();
+  EXPECT_TRUE(std::equal(typedValues.begin(), typedValues.end(), buffer));
+}
+
+} // end anonymous namespace
@@ -16,6 +16,8 @@
 // =============================================================================
 
 #include "mlir/IR/Dialect.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/OperationSupport.h"
 #include "gtest/gtest.h"
 
 using namespace mlir;
@@ -35,4 +37,39 @@ TEST(DialectDeathTest, MultipleDialectsWithSameNamespace) {
   ASSERT_DEATH(new TestDialect(&context), "");
 }
 
+/// A dialect counting its constructions.
+struct LazyTestDialect : public Dialect {
+  LazyTestDialect(MLIRContext *context)
+      : Dialect(getDialectNamespace(), context) {
+    ++numConstructed;
+  }
+  static StringRef getDialectNamespace() { return "lazy_test"; }
+  static unsigned numConstructed;
+};
+unsigned LazyTestDialect::numConstructed = 0;
+
+TEST(DialectTest, ConstructedOnFirstUse) {
+  registerDialect<LazyTestDialect>();
+  MLIRContext context;
+
+  // The dialect is only constructed when its namespace is looked up, be it
+  // directly or through the name of one of its operations, and only once.
+  EXPECT_EQ(LazyTestDialect::numConstructed, 0u);
+  EXPECT_EQ(AbstractOperation::lookup("lazy_test.op", &context), nullptr);
+  EXPECT_EQ(LazyTestDialect::numConstructed, 1u);
+  Dialect *dialect = context.getRegisteredDialect("lazy_test");
+  ASSERT_NE(dialect, nullptr);
+  EXPECT_EQ(dialect->getNamespace(), "lazy_test");
+  EXPECT_EQ(LazyTestDialect::numConstructed, 1u);
+  auto loaded = context.getLoadedDialects();
+  EXPECT_NE(llvm::find(loaded, dialect), loaded.end());
+
+  // Each context constructs its own instance.
+  MLIRContext otherContext;
+  EXPECT_EQ(LazyTestDialect::numConstructed, 1u);
+  EXPECT_NE(otherContext.getRegisteredDialect("lazy_test"), dialect);
+  EXPECT_EQ(LazyTestDialect::numConstructed, 2u);
+  EXPECT_EQ(otherContext.getRegisteredDialect("lazy_test_unknown"), nullptr);
+}
+
 } // end namespace
@@ -0,0 +1,94 @@
+//===- MLIRContextTest.cpp - MLIRContext unit tests -----------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Location.h"
+#include "mlir/IR/StandardTypes.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+/// Uniques a few instances of each kind that a request typically creates, and
+/// returns one of them built on top of all the others.
+Attribute createRequestStorage(Builder &builder, int64_t value) {
+  auto type = builder.getVectorType({4}, builder.getIntegerType(17));
+  auto map = builder.getAffineMap(
+      4, 0, {builder.getAffineDimExpr(3) + value}, llvm::None);
+  auto loc = builder.getFileLineColLoc(
+      builder.getUniquedFilename("request.mlir"), 4, value);
+  builder.getFusedLoc({loc, builder.getUnknownLoc()});
+  return builder.getArrayAttr(
+      {builder.getTypeAttr(type), builder.getAffineMapAttr(map),
+       builder.getStringAttr("request"), builder.getBoolAttr(false),
+       builder.getIntegerAttr(builder.getIntegerType(32), value)});
+}
+
+/// Returns the numbers of uniqued instances of each kind in 'context'.
+std::vector<size_t> getNumInstances(MLIRContext &context) {
+  auto stats = context.getStorageStatistics();
+  return {stats.numTypes, stats.numAttributes, stats.numAffineMaps,
+          stats.numAffineExprs, stats.numLocations};
+}
+
+TEST(MLIRContextTest, StorageScopeReleasesItsInstances) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto i32 = builder.getIntegerType(32);
+  auto trueAttr = builder.getBoolAttr(true);
+  auto baseline = getNumInstances(context);
+
+  {
+    StorageScope scope(&context);
+    createRequestStorage(builder, 5);
+    EXPECT_NE(getNumInstances(context), baseline);
+  }
+  EXPECT_EQ(getNumInstances(context), baseline);
+
+  // The instances uniqued before the scope are still the uniqued ones, and the
+  // released instances can be uniqued again.
+  EXPECT_EQ(builder.getIntegerType(32), i32);
+  EXPECT_EQ(builder.getBoolAttr(true), trueAttr);
+  StorageScope scope(&context);
+  EXPECT_EQ(createRequestStorage(builder, 5), createRequestStorage(builder, 5));
+}
+
+TEST(MLIRContextTest, NestedStorageScopes) {
+  MLIRContext context;
+  Builder builder(&context);
+  auto baseline = getNumInstances(context);
+
+  context.pushStorageScope();
+  auto outer = createRequestStorage(builder, 1);
+  auto afterOuter = getNumInstances(context);
+
+  // Popping the inner scope keeps the instances of the outer one.
+  context.pushStorageScope();
+  createRequestStorage(builder, 2);
+  EXPECT_EQ(createRequestStorage(builder, 1), outer);
+  context.popStorageScope();
+  EXPECT_EQ(getNumInstances(context), afterOuter);
+  EXPECT_EQ(createRequestStorage(builder, 1), outer);
+
+  context.popStorageScope();
+  EXPECT_EQ(getNumInstances(context), baseline);
+}
+
+} // end anonymous namespace
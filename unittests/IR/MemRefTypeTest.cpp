@@ -0,0 +1,100 @@
+//===- MemRefTypeTest.cpp - MemRefType unit tests -------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/AffineExpr.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/StandardTypes.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+const int64_t kDynamic = MemRefType::kDynamicStrideOrOffset;
+
+TEST(MemRefTypeTest, IdentityLayoutStrides) {
+  MLIRContext context;
+  Builder builder(&context);
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+
+  auto type = builder.getMemRefType({4, 8, 16}, builder.getF32Type());
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_EQ(strides, (SmallVector<int64_t, 4>{128, 16, 1}));
+  EXPECT_EQ(offset, 0);
+
+  // The strides of the dimensions major to a dynamic one are dynamic.
+  type = builder.getMemRefType({4, -1, 16}, builder.getF32Type());
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_EQ(strides, (SmallVector<int64_t, 4>{kDynamic, 16, 1}));
+  EXPECT_EQ(offset, 0);
+
+  type = builder.getMemRefType({}, builder.getF32Type());
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_TRUE(strides.empty());
+  EXPECT_EQ(offset, 0);
+}
+
+TEST(MemRefTypeTest, StridedLayoutStrides) {
+  MLIRContext context;
+  Builder builder(&context);
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+  AffineExpr d0 = builder.getAffineDimExpr(0);
+  AffineExpr d1 = builder.getAffineDimExpr(1);
+  AffineExpr s0 = builder.getAffineSymbolExpr(0);
+  AffineExpr s1 = builder.getAffineSymbolExpr(1);
+
+  auto map = builder.getAffineMap(2, 0, {d0 * 1024 + d1 * 2 + 7}, {});
+  auto type = builder.getMemRefType({4, 8}, builder.getF32Type(), map);
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_EQ(strides, (SmallVector<int64_t, 4>{1024, 2}));
+  EXPECT_EQ(offset, 7);
+
+  // Strides and offsets that are symbols are dynamic.
+  map = builder.getAffineMap(2, 2, {d0 * s0 + d1 + s1}, {});
+  type = builder.getMemRefType({4, 8}, builder.getF32Type(), map);
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_EQ(strides, (SmallVector<int64_t, 4>{kDynamic, 1}));
+  EXPECT_EQ(offset, kDynamic);
+
+  map = builder.getAffineMap(2, 0, {d0 * 8 + d1 % 4}, {});
+  type = builder.getMemRefType({4, 8}, builder.getF32Type(), map);
+  EXPECT_TRUE(failed(getStridesAndOffset(type, strides, offset)));
+
+  map = builder.getAffineMap(2, 0, {d0, d1 * 4}, {});
+  type = builder.getMemRefType({4, 8}, builder.getF32Type(), map);
+  EXPECT_TRUE(failed(getStridesAndOffset(type, strides, offset)));
+}
+
+TEST(MemRefTypeTest, MakeStridedLinearLayoutMap) {
+  MLIRContext context;
+  Builder builder(&context);
+  SmallVector<int64_t, 4> strides;
+  int64_t offset;
+
+  auto map = makeStridedLinearLayoutMap({kDynamic, 4, 1}, 3, &context);
+  EXPECT_EQ(map.getNumDims(), 3u);
+  EXPECT_EQ(map.getNumSymbols(), 1u);
+  auto type = builder.getMemRefType({2, 4, 4}, builder.getF32Type(), map);
+  ASSERT_TRUE(succeeded(getStridesAndOffset(type, strides, offset)));
+  EXPECT_EQ(strides, (SmallVector<int64_t, 4>{kDynamic, 4, 1}));
+  EXPECT_EQ(offset, 3);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,86 @@
+//===- ModuleTest.cpp - Module unit tests ---------------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Module.h"
+#include "mlir/IR/Builders.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <thread>
+
+using namespace mlir;
+
+namespace {
+TEST(ModuleTest, ConcurrentFunctionInsertion) {
+  MLIRContext context;
+  Module module(&context);
+  Builder builder(&context);
+  auto type = builder.getFunctionType(llvm::None, llvm::None);
+  auto createFunction = [&](StringRef name) {
+    return new Function(builder.getUnknownLoc(), name, type);
+  };
+
+  // Each thread adds functions under the same name, and declares the same
+  // function, while looking up the functions.
+  enum { kNumThreads = 4, kNumFunctionsPerThread = 100 };
+  std::vector<Function *> declarations(kNumThreads);
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i != kNumThreads; ++i) {
+    threads.emplace_back([&, i] {
+      for (unsigned j = 0; j != kNumFunctionsPerThread; ++j) {
+        module.addFunction(createFunction("outlined"));
+        EXPECT_NE(module.getNamedFunction("outlined"), nullptr);
+      }
+      declarations[i] = module.getOrInsertFunction(
+          "declaration", [&] { return createFunction("declaration"); });
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  // All the functions have a distinct name, and all the threads got the same
+  // declaration.
+  llvm::StringSet<> names;
+  for (auto &function : module)
+    EXPECT_TRUE(names.insert(function.getName().strref()).second);
+  EXPECT_EQ(names.size(), kNumThreads * kNumFunctionsPerThread + 1u);
+  for (auto *declaration : declarations)
+    EXPECT_EQ(declaration, module.getNamedFunction("declaration"));
+}
+
+TEST(ModuleTest, PrintAndConsume) {
+  MLIRContext context;
+  Module module(&context);
+  Builder builder(&context);
+  auto type = builder.getFunctionType(builder.getIndexType(), llvm::None);
+  for (StringRef name : {"first", "second"}) {
+    auto *function = new Function(builder.getUnknownLoc(), name, type);
+    function->addEntryBlock();
+    module.getFunctions().push_back(function);
+  }
+
+  // The output is the same as the one of a regular print, after which the
+  // functions are left without a body.
+  std::string printed, consumed;
+  llvm::raw_string_ostream printedOS(printed), consumedOS(consumed);
+  module.print(printedOS);
+  module.printAndConsume(consumedOS);
+  EXPECT_EQ(printedOS.str(), consumedOS.str());
+  for (auto &function : module)
+    EXPECT_TRUE(function.isExternal());
+}
+} // end anonymous namespace
@@ -114,4 +114,100 @@ TEST(OperandStorageTest, Resizable) {
   useOp->destroy();
 }
 
+TEST(OperandStorageTest, ReservedOperands) {
+  MLIRContext context;
+  Builder builder(&context);
+
+  Operation *useOp =
+      createOp(&context, /*resizableOperands=*/false, /*operands=*/llvm::None,
+               builder.getIntegerType(16));
+  Value *operand = useOp->getResult(0);
+
+  // Create a resizable operation with one operand and room for four.
+  OperationState state(&context, UnknownLoc::get(&context), "foo.bar");
+  state.addOperands(operand);
+  state.setOperandListToResizable();
+  state.reserveOperands(4);
+  Operation *user = Operation::create(state);
+  EXPECT_EQ(user->getNumOperands(), 1);
+
+  // Growing up to the reserved number of operands keeps them inline, right
+  // after the storage.
+  OpOperand *inlineOperands = user->getOpOperands().begin();
+  user->setOperands({operand, operand, operand, operand});
+  EXPECT_EQ(user->getNumOperands(), 4);
+  EXPECT_EQ(user->getOpOperands().begin(), inlineOperands);
+
+  // Growing past them moves the operands out of line.
+  user->setOperands({operand, operand, operand, operand, operand});
+  EXPECT_EQ(user->getNumOperands(), 5);
+  EXPECT_NE(user->getOpOperands().begin(), inlineOperands);
+
+  // Clones keep room for as many operands.
+  Operation *clone = user->clone(&context);
+  OpOperand *cloneOperands = clone->getOpOperands().begin();
+  clone->setOperands({operand, operand, operand, operand, operand, operand});
+  EXPECT_EQ(clone->getOpOperands().begin(), cloneOperands);
+
+  // Destroy the operations.
+  clone->destroy();
+  user->destroy();
+  useOp->destroy();
+}
+
+TEST(UseListTest, ReplaceAllUsesWith) {
+  MLIRContext context;
+  Builder builder(&context);
+  Type i16 = builder.getIntegerType(16);
+
+  Operation *oldDef =
+      createOp(&context, /*resizableOperands=*/false, llvm::None, {i16, i16});
+  Operation *newDef =
+      createOp(&context, /*resizableOperands=*/false, llvm::None, i16);
+  Value *oldValue = oldDef->getResult(0), *newValue = newDef->getResult(0);
+
+  // Both values have uses, some of them in the same operation.
+  Operation *user =
+      createOp(&context, /*resizableOperands=*/false,
+               {oldValue, newValue, oldValue, oldDef->getResult(1)});
+  Operation *otherUser =
+      createOp(&context, /*resizableOperands=*/false, {newValue, oldValue});
+
+  auto getUses = [](Value *value) {
+    SmallVector<OpOperand *, 8> uses;
+    for (auto &use : value->getUses())
+      uses.push_back(&use);
+    return uses;
+  };
+  auto expectedUses = getUses(newValue);
+
+  // The use-list of each old value is spliced in front of the uses of the new
+  // value, in order: the uses of the second result end up first.
+  SmallVector<OpOperand *, 8> splicedUses = getUses(oldDef->getResult(1));
+  auto firstResultUses = getUses(oldValue);
+  splicedUses.append(firstResultUses.begin(), firstResultUses.end());
+  expectedUses.insert(expectedUses.begin(), splicedUses.begin(),
+                      splicedUses.end());
+
+  oldDef->replaceAllUsesWith({newValue, newValue});
+  EXPECT_TRUE(oldDef->use_empty());
+  for (auto *operand : user->getOperands())
+    EXPECT_EQ(operand, newValue);
+  for (auto *operand : otherUser->getOperands())
+    EXPECT_EQ(operand, newValue);
+  EXPECT_EQ(getUses(newValue), expectedUses);
+  EXPECT_EQ(expectedUses.size(), 6u);
+
+  // Dropping the uses leaves the operands null, and the use-list consistent
+  // for the operations to be destroyed.
+  newValue->dropAllUses();
+  EXPECT_TRUE(newValue->use_empty());
+  EXPECT_EQ(user->getOperand(1), nullptr);
+
+  otherUser->destroy();
+  user->destroy();
+  newDef->destroy();
+  oldDef->destroy();
+}
+
 } // end namespace
@@ -0,0 +1,125 @@
+//===- OperationTest.cpp - Operation unit tests ---------------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Operation.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+Operation *createOp(MLIRContext *context) {
+  return Operation::create(UnknownLoc::get(context),
+                           OperationName("foo.bar", context), llvm::None,
+                           llvm::None, llvm::None, llvm::None, 0,
+                           /*resizableOperandList=*/false, context);
+}
+
+/// Checks that 'isBeforeInBlock' agrees with the order of the operations in
+/// 'block' for every pair of them.
+void expectConsistentOrder(Block &block) {
+  std::vector<Operation *> ops;
+  for (auto &op : block)
+    ops.push_back(&op);
+  for (unsigned i = 0, e = ops.size(); i != e; ++i) {
+    for (unsigned j = 0; j != e; ++j) {
+      if (i != j)
+        EXPECT_EQ(ops[i]->isBeforeInBlock(ops[j]), i < j);
+    }
+  }
+}
+
+TEST(OperationOrderTest, InsertionsBetweenQueries) {
+  MLIRContext context;
+  Block block;
+  for (unsigned i = 0; i != 4; ++i)
+    block.push_back(createOp(&context));
+  expectConsistentOrder(block);
+
+  // Insert repeatedly at the same position, which exhausts the room between
+  // the neighbours, and at both ends of the block, querying in between.
+  Operation *anchor = &*std::next(block.begin());
+  for (unsigned i = 0; i != 40; ++i) {
+    block.getOperations().insert(Block::iterator(anchor), createOp(&context));
+    EXPECT_TRUE(anchor->getPrevNode()->isBeforeInBlock(anchor));
+    EXPECT_TRUE(block.front().isBeforeInBlock(anchor));
+  }
+  for (unsigned i = 0; i != 20; ++i) {
+    block.push_front(createOp(&context));
+    EXPECT_TRUE(block.front().isBeforeInBlock(block.front().getNextNode()));
+    block.push_back(createOp(&context));
+    EXPECT_TRUE(anchor->isBeforeInBlock(&block.back()));
+  }
+  expectConsistentOrder(block);
+}
+
+TEST(OperationOrderTest, InsertionsWithoutQueries) {
+  MLIRContext context;
+  Block block;
+  for (unsigned i = 0; i != 4; ++i)
+    block.push_back(createOp(&context));
+  expectConsistentOrder(block);
+
+  // A run of operations inserted without queries in between is numbered at
+  // once.
+  Operation *anchor = &block.back();
+  for (unsigned i = 0; i != 50; ++i)
+    block.getOperations().insert(Block::iterator(anchor), createOp(&context));
+  expectConsistentOrder(block);
+}
+
+TEST(OperationOrderTest, MovedOperations) {
+  MLIRContext context;
+  Block block, otherBlock;
+  for (unsigned i = 0; i != 16; ++i)
+    block.push_back(createOp(&context));
+  for (unsigned i = 0; i != 4; ++i)
+    otherBlock.push_back(createOp(&context));
+  expectConsistentOrder(block);
+
+  // Move operations within the block, and from another one.
+  block.back().moveBefore(&block.front());
+  (*std::next(block.begin(), 3)).moveBefore(&*std::next(block.begin(), 10));
+  otherBlock.front().moveBefore(&*std::next(block.begin(), 5));
+  expectConsistentOrder(block);
+  expectConsistentOrder(otherBlock);
+}
+
+TEST(OperationPoolTest, ReusesDestroyedOperations) {
+  MLIRContext context;
+  EXPECT_FALSE(context.isOperationPoolingEnabled());
+  context.setOperationPoolingEnabled(true);
+
+  // The memory of a destroyed operation is reused by the next one of the same
+  // size, while live operations never share memory.
+  Operation *op = createOp(&context);
+  Operation *otherOp = createOp(&context);
+  EXPECT_NE(op, otherOp);
+  op->destroy();
+  Operation *newOp = createOp(&context);
+  EXPECT_EQ(newOp, op);
+
+  // Operations created before pooling is disabled are still returned to the
+  // pool, and those created after it are not taken from it.
+  context.setOperationPoolingEnabled(false);
+  newOp->destroy();
+  Operation *mallocOp = createOp(&context);
+  otherOp->destroy();
+  mallocOp->destroy();
+}
+
+} // end anonymous namespace
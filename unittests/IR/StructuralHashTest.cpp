@@ -0,0 +1,172 @@
+//===- StructuralHashTest.cpp - Structural fingerprint unit tests ---------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/StructuralHash.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/Function.h"
+#include "mlir/IR/StandardTypes.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+
+/// The aspects of the function built by 'buildFunction' that may be varied.
+enum class Variation {
+  None,
+  OpName,
+  Attribute,
+  ResultType,
+  OperandOrder,
+  BlockArgument,
+  NestedRegion,
+  Location,
+};
+
+/// Builds the function
+///
+///   func @f(%a: i32, %b: i32) {
+///     %0 = "t.add"(%a, %b) {value: 1 : i32} : (i32, i32) -> i32
+///     "t.region"() ({
+///     ^bb0(%x: i32):
+///       "t.use"(%0, %x) : (i32, i32) -> ()
+///     }) : () -> ()
+///     "t.return"() : () -> ()
+///   }
+///
+/// with one of its aspects changed according to 'variation'.
+std::unique_ptr<Function> buildFunction(MLIRContext *context,
+                                        Variation variation = Variation::None) {
+  Builder builder(context);
+  Type i32 = builder.getIntegerType(32), i64 = builder.getIntegerType(64);
+  Location loc =
+      variation == Variation::Location
+          ? builder.getFileLineColLoc(builder.getUniquedFilename("file"), 1, 2)
+          : builder.getUnknownLoc();
+  auto type = builder.getFunctionType({i32, i32}, {});
+  std::unique_ptr<Function> function(new Function(loc, "f", type));
+  function->addEntryBlock();
+  FuncBuilder funcBuilder(function.get());
+  Value *a = function->getArgument(0), *b = function->getArgument(1);
+
+  OperationState addState(context, loc,
+                          variation == Variation::OpName ? "t.sub" : "t.add");
+  if (variation == Variation::OperandOrder)
+    addState.addOperands({b, a});
+  else
+    addState.addOperands({a, b});
+  addState.addTypes(variation == Variation::ResultType ? i64 : i32);
+  addState.addAttribute(
+      "value",
+      builder.getI32IntegerAttr(variation == Variation::Attribute ? 2 : 1));
+  Value *sum = funcBuilder.createOperation(addState)->getResult(0);
+
+  OperationState regionState(context, loc, "t.region");
+  regionState.addRegion();
+  Operation *regionOp = funcBuilder.createOperation(regionState);
+  auto *nestedBlock = new Block();
+  regionOp->getRegion(0).push_back(nestedBlock);
+  Value *x =
+      nestedBlock->addArgument(variation == Variation::BlockArgument ? i64 : i32);
+  OperationState useState(
+      context, loc, variation == Variation::NestedRegion ? "t.other" : "t.use");
+  useState.addOperands({sum, x});
+  FuncBuilder(nestedBlock).createOperation(useState);
+
+  funcBuilder.createOperation(OperationState(context, loc, "t.return"));
+  return function;
+}
+
+TEST(StructuralHashTest, IdenticalFunctionsHaveEqualFingerprints) {
+  MLIRContext context;
+  auto first = buildFunction(&context), second = buildFunction(&context);
+  EXPECT_EQ(computeFingerprint(first.get()), computeFingerprint(second.get()));
+  EXPECT_EQ(computeFingerprint(first.get()).str(),
+            computeFingerprint(second.get()).str());
+  EXPECT_EQ(computeFingerprint(first.get()).str().size(), 32u);
+}
+
+TEST(StructuralHashTest, IgnoresLocations) {
+  MLIRContext context;
+  auto function = buildFunction(&context);
+  auto located = buildFunction(&context, Variation::Location);
+  EXPECT_EQ(computeFingerprint(function.get()),
+            computeFingerprint(located.get()));
+}
+
+TEST(StructuralHashTest, IgnoresValueIdentity) {
+  MLIRContext context;
+  Builder builder(&context);
+  Type i32 = builder.getIntegerType(32);
+  auto createOp = [&](StringRef name, ArrayRef<Value *> operands,
+                      ArrayRef<Type> resultTypes) {
+    return Operation::create(builder.getUnknownLoc(),
+                             OperationName(name, &context), operands,
+                             resultTypes, llvm::None, llvm::None,
+                             /*numRegions=*/0, /*resizableOperandList=*/false,
+                             &context);
+  };
+
+  // Two operations using distinct values defined above them, in the same
+  // pattern, have the same fingerprint.
+  Operation *firstDef = createOp("t.def", llvm::None, {i32, i32});
+  Operation *secondDef = createOp("t.def", llvm::None, {i32, i32});
+  Value *x1 = firstDef->getResult(0), *y1 = firstDef->getResult(1);
+  Value *x2 = secondDef->getResult(1), *y2 = secondDef->getResult(0);
+  Operation *firstUser = createOp("t.use", {x1, y1, x1}, llvm::None);
+  Operation *secondUser = createOp("t.use", {x2, y2, x2}, llvm::None);
+  EXPECT_EQ(computeFingerprint(firstUser), computeFingerprint(secondUser));
+
+  // A different use pattern of the same number of values does not.
+  Operation *otherUser = createOp("t.use", {x1, y1, y1}, llvm::None);
+  EXPECT_NE(computeFingerprint(firstUser), computeFingerprint(otherUser));
+
+  otherUser->destroy();
+  secondUser->destroy();
+  firstUser->destroy();
+  secondDef->destroy();
+  firstDef->destroy();
+}
+
+TEST(StructuralHashTest, SensitiveToStructure) {
+  MLIRContext context;
+  auto fingerprint = computeFingerprint(buildFunction(&context).get());
+  for (auto variation :
+       {Variation::OpName, Variation::Attribute, Variation::ResultType,
+        Variation::OperandOrder, Variation::BlockArgument,
+        Variation::NestedRegion}) {
+    EXPECT_NE(fingerprint,
+              computeFingerprint(buildFunction(&context, variation).get()))
+        << "variation " << static_cast<int>(variation);
+  }
+}
+
+TEST(StructuralHashTest, SensitiveToNestedRegionContents) {
+  MLIRContext context;
+  auto function = buildFunction(&context);
+  auto fingerprint = computeFingerprint(function.get());
+
+  // Moving the nested operation out of its region changes the fingerprint,
+  // although the same operations remain in the function.
+  Operation &regionOp = *std::next(function->front().begin());
+  Operation &useOp = regionOp.getRegion(0).front().front();
+  useOp.moveBefore(&regionOp);
+  useOp.setOperand(1, function->getArgument(1));
+  EXPECT_NE(fingerprint, computeFingerprint(function.get()));
+}
+
+} // end anonymous namespace
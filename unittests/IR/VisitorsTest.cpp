@@ -0,0 +1,123 @@
+//===- VisitorsTest.cpp - Operation walker unit tests ---------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Block.h"
+#include "mlir/IR/Operation.h"
+#include "gtest/gtest.h"
+
+using namespace mlir;
+
+namespace {
+/// Creates an unregistered operation named 'name' with 'numRegions' regions
+/// of one empty block each.
+Operation *createOp(MLIRContext *context, StringRef name,
+                    unsigned numRegions = 0) {
+  auto *op = Operation::create(UnknownLoc::get(context),
+                               OperationName(name, context), llvm::None,
+                               llvm::None, llvm::None, llvm::None, numRegions,
+                               /*resizableOperandList=*/false, context);
+  for (auto &region : op->getRegions())
+    region.push_back(new Block);
+  return op;
+}
+
+/// Creates the nest:
+///   root {
+///     a {
+///       b
+///     }
+///     c
+///   }
+Operation *createNest(MLIRContext *context) {
+  auto *root = createOp(context, "t.root", 1);
+  auto *a = createOp(context, "t.a", 1);
+  a->getRegion(0).front().push_back(createOp(context, "t.b"));
+  root->getRegion(0).front().push_back(a);
+  root->getRegion(0).front().push_back(createOp(context, "t.c"));
+  return root;
+}
+
+/// Returns the names of the operations in 'ops', separated with spaces.
+std::string getNames(ArrayRef<Operation *> ops) {
+  std::string names;
+  for (auto *op : ops)
+    names += (names.empty() ? "" : " ") + op->getName().getStringRef().str();
+  return names;
+}
+
+TEST(VisitorsTest, PreAndPostOrder) {
+  MLIRContext context;
+  Operation *root = createNest(&context);
+
+  SmallVector<Operation *, 4> visited;
+  root->walk([&](Operation *op) { visited.push_back(op); });
+  EXPECT_EQ(getNames(visited), "t.root t.a t.b t.c");
+
+  visited.clear();
+  root->walkPostOrder([&](Operation *op) { visited.push_back(op); });
+  EXPECT_EQ(getNames(visited), "t.b t.a t.c t.root");
+  root->destroy();
+}
+
+TEST(VisitorsTest, InterruptAndSkip) {
+  MLIRContext context;
+  Operation *root = createNest(&context);
+
+  // An interrupted walk stops right away and reports it.
+  SmallVector<Operation *, 4> visited;
+  auto result = root->walk([&](Operation *op) {
+    visited.push_back(op);
+    return op->getName().getStringRef() == "t.a" ? WalkResult::interrupt()
+                                                 : WalkResult::advance();
+  });
+  EXPECT_TRUE(result.wasInterrupted());
+  EXPECT_EQ(getNames(visited), "t.root t.a");
+
+  // Skipping an operation steps over the operations nested in it only.
+  visited.clear();
+  result = root->walk([&](Operation *op) {
+    visited.push_back(op);
+    return op->getName().getStringRef() == "t.a" ? WalkResult::skip()
+                                                 : WalkResult::advance();
+  });
+  EXPECT_FALSE(result.wasInterrupted());
+  EXPECT_EQ(getNames(visited), "t.root t.a t.c");
+  root->destroy();
+}
+
+TEST(VisitorsTest, DeepNestDoesNotRecurse) {
+  MLIRContext context;
+  SmallVector<Operation *, 8> nest(1, createOp(&context, "t.root", 1));
+  for (unsigned i = 0; i != 100000; ++i) {
+    auto *op = createOp(&context, "t.nest", 1);
+    nest.back()->getRegion(0).front().push_back(op);
+    nest.push_back(op);
+  }
+
+  unsigned numVisited = 0;
+  nest.front()->walk([&](Operation *) { ++numVisited; });
+  nest.front()->walkPostOrder([&](Operation *) { ++numVisited; });
+  EXPECT_EQ(numVisited, 2 * nest.size());
+
+  // Destroying the root would recurse just as deep, tear the nest down from
+  // the innermost operation instead.
+  for (auto *op : llvm::reverse(ArrayRef<Operation *>(nest).drop_front()))
+    op->erase();
+  nest.front()->destroy();
+}
+
+} // end anonymous namespace
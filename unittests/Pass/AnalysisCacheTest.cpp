@@ -0,0 +1,106 @@
+//===- AnalysisCacheTest.cpp - Analysis cache unit tests ------------------===//
+//
+// Copyright 2019 The MLIR Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/IR/Module.h"
+#include "mlir/Parser.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassManager.h"
+#include "mlir/StandardOps/Ops.h"
+#include "gtest/gtest.h"
+#include <atomic>
+
+using namespace mlir;
+
+namespace {
+
+const char kModule[] = R"mlir(
+func @f(%a: index) -> index {
+  return %a : index
+}
+func @g(%a: index) -> index {
+  return %a : index
+}
+)mlir";
+
+/// An analysis counting the number of times that it is computed.
+struct CountedAnalysis {
+  CountedAnalysis(Function *) { ++numComputations; }
+  static std::atomic<unsigned> numComputations;
+};
+std::atomic<unsigned> CountedAnalysis::numComputations;
+
+/// A pass querying the analysis, and preserving it.
+struct QueryAnalysisPass : public FunctionPass<QueryAnalysisPass> {
+  void runOnFunction() override {
+    getAnalysis<CountedAnalysis>();
+    markAllAnalysesPreserved();
+  }
+};
+
+class AnalysisCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    CountedAnalysis::numComputations = 0;
+    module.reset(parseSourceString(kModule, &context));
+    ASSERT_TRUE(module);
+    pm.addPass(new QueryAnalysisPass());
+    pm.enableAnalysisCache();
+  }
+
+  // Runs the pass manager, and returns the number of analyses computed.
+  unsigned run() {
+    unsigned numComputations = CountedAnalysis::numComputations;
+    EXPECT_TRUE(succeeded(pm.run(module.get())));
+    return CountedAnalysis::numComputations - numComputations;
+  }
+
+  MLIRContext context;
+  std::unique_ptr<Module> module;
+  PassManager pm;
+};
+
+TEST_F(AnalysisCacheTest, ReuseUnchangedFunctions) {
+  EXPECT_EQ(run(), 2u);
+  EXPECT_EQ(run(), 0u);
+  EXPECT_EQ(run(), 0u);
+
+  pm.clearAnalysisCache();
+  EXPECT_EQ(run(), 2u);
+}
+
+TEST_F(AnalysisCacheTest, RecomputeEditedFunction) {
+  EXPECT_EQ(run(), 2u);
+
+  // Add an operation to @f: only its analysis is recomputed.
+  Function *f = module->getNamedFunction("f");
+  ASSERT_TRUE(f);
+  FuncBuilder builder(&f->front(), f->front().begin());
+  auto constant = builder.create<ConstantIndexOp>(builder.getUnknownLoc(), 0);
+  EXPECT_EQ(run(), 1u);
+  EXPECT_EQ(run(), 0u);
+
+  // Return the constant instead of the argument, which only changes an
+  // operand.
+  auto *returnOp = f->front().getTerminator();
+  returnOp->setOperand(0, constant.getResult());
+  EXPECT_EQ(run(), 1u);
+  EXPECT_EQ(run(), 0u);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+# Copyright 2019 The MLIR Authors.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Runs the benchmarks of the kernels executed by mlir-cpu-runner.
+
+Each kernel is a .mlir file with one BENCHMARK line per configuration to time,
+giving the options of mlir-cpu-runner, e.g. the MLIR passes and the LLVM
+optimization level to compile the kernel with:
+
+  // BENCHMARK: -mlir-passes=loop-tile -tile-size=32 -O3
+
+For each configuration, the kernel is run in the benchmark mode of
+mlir-cpu-runner, which reports the time spent in each stage of the compilation
+and the latencies of the executions of the entry function.  The reports of all
+the kernels are written as a JSON array:
+
+  [{"kernel": "matmul", "options": "-O3", "report": {...}}, ...]
+
+The directories given as inputs are searched for .mlir files, not recursively.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+
+BENCHMARK_RE = re.compile(r'^\s*//\s*BENCHMARK:(.*)$')
+
+
+def find_kernels(inputs):
+  """Returns the .mlir files given or found in the directories given."""
+  kernels = []
+  for path in inputs:
+    if os.path.isdir(path):
+      kernels.extend(
+          os.path.join(path, name)
+          for name in sorted(os.listdir(path))
+          if name.endswith('.mlir'))
+    else:
+      kernels.append(path)
+  return kernels
+
+
+def read_configurations(kernel):
+  """Returns the options of the BENCHMARK lines of `kernel`."""
+  with open(kernel) as f:
+    return [
+        match.group(1).strip()
+        for match in (BENCHMARK_RE.match(line) for line in f)
+        if match
+    ]
+
+
+def run_benchmark(args, kernel, options):
+  """Runs `kernel` with `options` and returns the report of the runner."""
+  command = [args.runner, kernel] + shlex.split(options) + [
+      '-benchmark',
+      '-benchmark-warmup=%d' % args.warmup,
+      '-benchmark-iterations=%d' % args.iterations,
+  ]
+  if args.entry:
+    command.append('-e=' + args.entry)
+  process = subprocess.Popen(
+      command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  stdout, stderr = process.communicate()
+  if process.returncode != 0:
+    raise RuntimeError('%s failed with status %d:\n%s' %
+                       (' '.join(command), process.returncode,
+                        stderr.decode('utf-8', 'replace')))
+  return json.loads(stdout.decode('utf-8'))
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+  parser.add_argument(
+      'inputs', nargs='+', help='The kernels, or directories of kernels')
+  parser.add_argument(
+      '--runner', default='mlir-cpu-runner', help='The mlir-cpu-runner to use')
+  parser.add_argument(
+      '-o', '--output', help='The file to write the reports to, or stdout')
+  parser.add_argument(
+      '--filter',
+      default='',
+      help='Only run the kernels whose name contains this string')
+  parser.add_argument(
+      '--warmup',
+      type=int,
+      default=1,
+      help='Number of untimed executions of each kernel')
+  parser.add_argument(
+      '--iterations',
+      type=int,
+      default=10,
+      help='Number of timed executions of each kernel')
+  parser.add_argument(
+      '-e', '--entry', help='The entry function, main unless specified')
+  args = parser.parse_args()
+
+  reports = []
+  failed = False
+  for kernel in find_kernels(args.inputs):
+    name = os.path.splitext(os.path.basename(kernel))[0]
+    if args.filter not in name:
+      continue
+    for options in read_configurations(kernel):
+      try:
+        report = run_benchmark(args, kernel, options)
+      except (OSError, RuntimeError, ValueError) as e:
+        print('error: benchmark %s %s: %s' % (name, options, e),
+              file=sys.stderr)
+        failed = True
+        continue
+      reports.append({'kernel': name, 'options': options, 'report': report})
+
+  output = json.dumps(reports, indent=2, sort_keys=True)
+  if args.output:
+    with open(args.output, 'w') as f:
+      f.write(output + '\n')
+  else:
+    print(output)
+  return 1 if failed else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())